@@ -0,0 +1,207 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_FLATHASHMAP_HPP__
+#define __STOUT_FLATHASHMAP_HPP__
+
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include "flathashtable.hpp"
+#include "foreach.hpp"
+#include "hashset.hpp"
+#include "none.hpp"
+#include "option.hpp"
+
+
+// Returns the key of an element of a 'flathashmap'.
+template <typename Key, typename Value>
+struct FlatHashMapKeyOf
+{
+  static const Key& get(const std::pair<Key, Value>& pair)
+  {
+    return pair.first;
+  }
+};
+
+
+// Provides a hash map with the API of 'hashmap', based on an open
+// addressing hash table (see 'FlatHashTable') rather than on
+// 'std::unordered_map'. This avoids an allocation per element and
+// keeps the elements next to each other.
+//
+// NOTE: Inserting into the map may move its elements when it grows,
+// which invalidates all iterators, pointers and references (unlike
+// for 'hashmap'). Erasing only invalidates the ones to the erased
+// element, so erasing while iterating is fine.
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class flathashmap
+  : public FlatHashTable<std::pair<Key, Value>,
+                         std::pair<const Key, Value>,
+                         Key,
+                         FlatHashMapKeyOf<Key, Value>,
+                         Hash,
+                         Equal>
+{
+  typedef FlatHashTable<std::pair<Key, Value>,
+                        std::pair<const Key, Value>,
+                        Key,
+                        FlatHashMapKeyOf<Key, Value>,
+                        Hash,
+                        Equal> Table;
+
+public:
+  typedef Value mapped_type;
+
+  // An explicit default constructor is needed so
+  // 'const flathashmap<T> map;' is not an error.
+  flathashmap() {}
+
+  // An implicit constructor for converting from a std::map.
+  flathashmap(const std::map<Key, Value>& map)
+  {
+    Table::reserve(map.size());
+    Table::insert(map.begin(), map.end());
+  }
+
+  // Allow simple construction via initializer list.
+  flathashmap(std::initializer_list<std::pair<Key, Value>> list)
+  {
+    Table::reserve(list.size());
+    Table::insert(list.begin(), list.end());
+  }
+
+  Value& operator[](const Key& key)
+  {
+    typename Table::iterator it = Table::find(key);
+    if (it == Table::end()) {
+      it = Table::emplace(key, Value()).first;
+    }
+    return it->second;
+  }
+
+  Value& at(const Key& key)
+  {
+    typename Table::iterator it = Table::find(key);
+    if (it == Table::end()) {
+      throw std::out_of_range("flathashmap::at");
+    }
+    return it->second;
+  }
+
+  const Value& at(const Key& key) const
+  {
+    typename Table::const_iterator it = Table::find(key);
+    if (it == Table::end()) {
+      throw std::out_of_range("flathashmap::at");
+    }
+    return it->second;
+  }
+
+  // Checks whether this map contains a binding for a key.
+  bool contains(const Key& key) const
+  {
+    return Table::count(key) > 0;
+  }
+
+  // Checks whether there exists a bound value in this map.
+  bool containsValue(const Value& v) const
+  {
+    foreachvalue (const Value& value, *this) {
+      if (value == v) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Inserts a key, value pair into the map replacing an old value
+  // if the key is already present.
+  void put(const Key& key, const Value& value)
+  {
+    typename Table::iterator it = Table::find(key);
+    if (it == Table::end()) {
+      Table::emplace(key, value);
+    } else {
+      it->second = value;
+    }
+  }
+
+  // Returns an Option for the binding to the key.
+  Option<Value> get(const Key& key) const
+  {
+    typename Table::const_iterator it = Table::find(key);
+    if (it == Table::end()) {
+      return None();
+    }
+    return it->second;
+  }
+
+  // Returns the set of keys in this map.
+  hashset<Key> keys() const
+  {
+    hashset<Key> result;
+    result.reserve(Table::size());
+    foreachkey (const Key& key, *this) {
+      result.insert(key);
+    }
+    return result;
+  }
+
+  // Returns the list of values in this map.
+  std::list<Value> values() const
+  {
+    std::list<Value> result;
+    foreachvalue (const Value& value, *this) {
+      result.push_back(value);
+    }
+    return result;
+  }
+};
+
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+bool operator==(
+    const flathashmap<Key, Value, Hash, Equal>& left,
+    const flathashmap<Key, Value, Hash, Equal>& right)
+{
+  if (left.size() != right.size()) {
+    return false;
+  }
+
+  foreachpair (const Key& key, const Value& value, left) {
+    auto it = right.find(key);
+    if (it == right.end() || !(it->second == value)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+bool operator!=(
+    const flathashmap<Key, Value, Hash, Equal>& left,
+    const flathashmap<Key, Value, Hash, Equal>& right)
+{
+  return !(left == right);
+}
+
+#endif // __STOUT_FLATHASHMAP_HPP__
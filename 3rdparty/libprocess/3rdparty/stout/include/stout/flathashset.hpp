@@ -0,0 +1,129 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_FLATHASHSET_HPP__
+#define __STOUT_FLATHASHSET_HPP__
+
+#include <functional>
+#include <initializer_list>
+#include <set>
+#include <utility>
+
+#include "flathashtable.hpp"
+#include "foreach.hpp"
+
+
+// Returns the key of an element of a 'flathashset'.
+template <typename Elem>
+struct FlatHashSetKeyOf
+{
+  static const Elem& get(const Elem& elem)
+  {
+    return elem;
+  }
+};
+
+
+// Provides a hash set with the API of 'hashset', based on an open
+// addressing hash table (see 'FlatHashTable') rather than on
+// 'std::unordered_set'. This avoids an allocation per element and
+// keeps the elements next to each other.
+//
+// NOTE: Inserting into the set may move its elements when it grows,
+// which invalidates all iterators, pointers and references (unlike
+// for 'hashset'). Erasing only invalidates the ones to the erased
+// element, so erasing while iterating is fine.
+template <typename Elem,
+          typename Hash = std::hash<Elem>,
+          typename Equal = std::equal_to<Elem>>
+class flathashset
+  : public FlatHashTable<Elem,
+                         const Elem,
+                         Elem,
+                         FlatHashSetKeyOf<Elem>,
+                         Hash,
+                         Equal>
+{
+  typedef FlatHashTable<Elem,
+                        const Elem,
+                        Elem,
+                        FlatHashSetKeyOf<Elem>,
+                        Hash,
+                        Equal> Table;
+
+public:
+  // An explicit default constructor is needed so
+  // 'const flathashset<T> set;' is not an error.
+  flathashset() {}
+
+  // An implicit constructor for converting from a std::set.
+  flathashset(const std::set<Elem>& set)
+  {
+    Table::reserve(set.size());
+    Table::insert(set.begin(), set.end());
+  }
+
+  // Allow simple construction via initializer list.
+  flathashset(std::initializer_list<Elem> list)
+  {
+    Table::reserve(list.size());
+    Table::insert(list.begin(), list.end());
+  }
+
+  // Checks whether this set contains an element.
+  bool contains(const Elem& elem) const
+  {
+    return Table::count(elem) > 0;
+  }
+};
+
+
+template <typename Elem, typename Hash, typename Equal>
+bool operator==(
+    const flathashset<Elem, Hash, Equal>& left,
+    const flathashset<Elem, Hash, Equal>& right)
+{
+  if (left.size() != right.size()) {
+    return false;
+  }
+
+  foreach (const Elem& elem, left) {
+    if (!right.contains(elem)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+template <typename Elem, typename Hash, typename Equal>
+bool operator!=(
+    const flathashset<Elem, Hash, Equal>& left,
+    const flathashset<Elem, Hash, Equal>& right)
+{
+  return !(left == right);
+}
+
+
+// Union operator.
+template <typename Elem, typename Hash, typename Equal>
+flathashset<Elem, Hash, Equal> operator|(
+    const flathashset<Elem, Hash, Equal>& left,
+    const flathashset<Elem, Hash, Equal>& right)
+{
+  flathashset<Elem, Hash, Equal> result = left;
+  result.insert(right.begin(), right.end());
+  return result;
+}
+
+#endif // __STOUT_FLATHASHSET_HPP__
@@ -0,0 +1,455 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_FLATHASHTABLE_HPP__
+#define __STOUT_FLATHASHTABLE_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+// The open addressing hash table behind 'flathashmap' and
+// 'flathashset'. The elements are stored in a single array of slots,
+// rather than in a node per element like 'std::unordered_map', and
+// are found by linear probing. Every slot has a control byte which is
+// either EMPTY, DELETED (a tombstone left behind by 'erase') or 7
+// bits of the hash of the element, so that most of the mismatching
+// slots are skipped without comparing the keys.
+//
+// 'Stored' is the type of the slots and 'Exposed' the type that the
+// iterators refer to, e.g., 'std::pair<Key, Value>' and
+// 'std::pair<const Key, Value>', which allows moving the keys when
+// the table grows. 'KeyOf::get' returns the key of a slot.
+//
+// NOTE: Unlike for 'std::unordered_map', inserting into the table may
+// move the elements (when it grows), which invalidates all iterators,
+// pointers and references. Erasing only invalidates the iterators,
+// pointers and references to the erased element.
+template <typename Stored,
+          typename Exposed,
+          typename Key,
+          typename KeyOf,
+          typename Hash,
+          typename Equal>
+class FlatHashTable
+{
+  static_assert(
+      sizeof(Stored) == sizeof(Exposed) &&
+        alignof(Stored) == alignof(Exposed),
+      "Expected the stored and the exposed types to share their layout");
+
+public:
+  typedef Key key_type;
+  typedef Exposed value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef Hash hasher;
+  typedef Equal key_equal;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+
+  template <bool Const>
+  class Iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef FlatHashTable::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef typename std::conditional<
+        Const, const value_type*, value_type*>::type pointer;
+    typedef typename std::conditional<
+        Const, const value_type&, value_type&>::type reference;
+
+    Iterator() : table(NULL), index(0) {}
+
+    // A mutable iterator converts to a constant one.
+    Iterator(const Iterator<false>& that)
+      : table(that.table), index(that.index) {}
+
+    reference operator*() const { return table->at(index); }
+    pointer operator->() const { return &table->at(index); }
+
+    Iterator& operator++()
+    {
+      index = table->next(index + 1);
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(const Iterator& that) const
+    {
+      return index == that.index && table == that.table;
+    }
+
+    bool operator!=(const Iterator& that) const
+    {
+      return !(*this == that);
+    }
+
+  private:
+    friend class FlatHashTable;
+    friend class Iterator<!Const>;
+
+    Iterator(const FlatHashTable* _table, size_t _index)
+      : table(const_cast<FlatHashTable*>(_table)), index(_index) {}
+
+    FlatHashTable* table;
+    size_t index;
+  };
+
+  typedef Iterator<false> iterator;
+  typedef Iterator<true> const_iterator;
+
+  FlatHashTable()
+    : control(NULL), slots(NULL), capacity(0), size_(0), deleted(0) {}
+
+  FlatHashTable(const FlatHashTable& that)
+    : control(NULL),
+      slots(NULL),
+      capacity(0),
+      size_(0),
+      deleted(0),
+      hash(that.hash),
+      equal(that.equal)
+  {
+    reserve(that.size_);
+
+    for (size_t i = 0; i < that.capacity; i++) {
+      if (full(that.control[i])) {
+        emplace(that.slots[i]);
+      }
+    }
+  }
+
+  FlatHashTable(FlatHashTable&& that)
+    : control(NULL), slots(NULL), capacity(0), size_(0), deleted(0)
+  {
+    swap(that);
+  }
+
+  ~FlatHashTable()
+  {
+    destroy();
+  }
+
+  FlatHashTable& operator=(const FlatHashTable& that)
+  {
+    if (this != &that) {
+      FlatHashTable copy(that);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  FlatHashTable& operator=(FlatHashTable&& that)
+  {
+    if (this != &that) {
+      destroy();
+      swap(that);
+    }
+    return *this;
+  }
+
+  void swap(FlatHashTable& that)
+  {
+    std::swap(control, that.control);
+    std::swap(slots, that.slots);
+    std::swap(capacity, that.capacity);
+    std::swap(size_, that.size_);
+    std::swap(deleted, that.deleted);
+    std::swap(hash, that.hash);
+    std::swap(equal, that.equal);
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  iterator begin() { return iterator(this, next(0)); }
+  iterator end() { return iterator(this, capacity); }
+  const_iterator begin() const { return const_iterator(this, next(0)); }
+  const_iterator end() const { return const_iterator(this, capacity); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  iterator find(const Key& key)
+  {
+    return iterator(this, lookup(key));
+  }
+
+  const_iterator find(const Key& key) const
+  {
+    return const_iterator(this, lookup(key));
+  }
+
+  size_t count(const Key& key) const
+  {
+    return lookup(key) == capacity ? 0 : 1;
+  }
+
+  std::pair<iterator, bool> insert(const Stored& value)
+  {
+    return emplace(value);
+  }
+
+  std::pair<iterator, bool> insert(Stored&& value)
+  {
+    return emplace(std::move(value));
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    for (; first != last; ++first) {
+      emplace(*first);
+    }
+  }
+
+  // Inserts the element constructed from 'args', unless there is
+  // already an element with the same key.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    Stored value(std::forward<Args>(args)...);
+
+    const Key& key = KeyOf::get(value);
+    const size_t hashed = mix(key);
+
+    size_t index = lookup(key, hashed);
+    if (index != capacity) {
+      return std::make_pair(iterator(this, index), false);
+    }
+
+    index = claim(hashed);
+    new (&slots[index]) Stored(std::move(value));
+
+    return std::make_pair(iterator(this, index), true);
+  }
+
+  size_t erase(const Key& key)
+  {
+    const size_t index = lookup(key);
+    if (index == capacity) {
+      return 0;
+    }
+
+    remove(index);
+    return 1;
+  }
+
+  iterator erase(const_iterator position)
+  {
+    remove(position.index);
+    return iterator(this, next(position.index + 1));
+  }
+
+  void clear()
+  {
+    for (size_t i = 0; i < capacity; i++) {
+      if (full(control[i])) {
+        slots[i].~Stored();
+      }
+    }
+
+    if (capacity > 0) {
+      memset(control, EMPTY, capacity);
+    }
+
+    size_ = 0;
+    deleted = 0;
+  }
+
+  // Makes room for (at least) 'count' elements, so that inserting
+  // them does not move the elements.
+  void reserve(size_t count)
+  {
+    size_t target = 8;
+    while (target * 7 / 8 < count) {
+      target *= 2;
+    }
+
+    if (target > capacity) {
+      rehash(target);
+    }
+  }
+
+  size_t bucket_count() const { return capacity; }
+
+  float load_factor() const
+  {
+    return capacity == 0 ? 0 : static_cast<float>(size_) / capacity;
+  }
+
+protected:
+  Exposed& at(size_t index) const
+  {
+    return *reinterpret_cast<Exposed*>(&slots[index]);
+  }
+
+private:
+  static const uint8_t EMPTY = 0x80;
+  static const uint8_t DELETED = 0xFE;
+
+  static bool full(uint8_t c) { return (c & 0x80) == 0; }
+
+  // Spreads the bits of the hash, since the hash of an integer is
+  // usually the integer itself.
+  size_t mix(const Key& key) const
+  {
+    uint64_t hashed = static_cast<uint64_t>(hash(key));
+    hashed *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(hashed ^ (hashed >> 32));
+  }
+
+  // Returns the index of the next element starting at 'index', or
+  // 'capacity' if there is none.
+  size_t next(size_t index) const
+  {
+    while (index < capacity && !full(control[index])) {
+      index++;
+    }
+    return index;
+  }
+
+  size_t lookup(const Key& key) const
+  {
+    return capacity == 0 ? 0 : lookup(key, mix(key));
+  }
+
+  // Returns the index of the element with 'key', or 'capacity'.
+  size_t lookup(const Key& key, size_t hashed) const
+  {
+    if (capacity == 0) {
+      return 0;
+    }
+
+    const size_t mask = capacity - 1;
+    const uint8_t tag = hashed & 0x7F;
+
+    // There is always an EMPTY slot since the table is never full.
+    for (size_t index = (hashed >> 7) & mask;; index = (index + 1) & mask) {
+      const uint8_t c = control[index];
+      if (c == EMPTY) {
+        return capacity;
+      } else if (c == tag && equal(KeyOf::get(slots[index]), key)) {
+        return index;
+      }
+    }
+  }
+
+  // Returns the index of the slot for a new element (which must not
+  // be in the table yet), growing the table if necessary.
+  size_t claim(size_t hashed)
+  {
+    // Keep at least 1/8 of the slots EMPTY so that the probing remains
+    // short. When most of the used slots are tombstones, the table is
+    // rehashed at the same capacity to get rid of them.
+    if ((size_ + deleted + 1) * 8 > capacity * 7) {
+      rehash(capacity == 0
+               ? 8
+               : (size_ + 1) * 16 > capacity * 7 ? capacity * 2 : capacity);
+    }
+
+    const size_t mask = capacity - 1;
+
+    size_t index = (hashed >> 7) & mask;
+    while (full(control[index])) {
+      index = (index + 1) & mask;
+    }
+
+    if (control[index] == DELETED) {
+      deleted--;
+    }
+
+    control[index] = hashed & 0x7F;
+    size_++;
+
+    return index;
+  }
+
+  void remove(size_t index)
+  {
+    slots[index].~Stored();
+
+    // A slot can only become EMPTY again if it does not break the
+    // probing of the following slot.
+    if (control[(index + 1) & (capacity - 1)] == EMPTY) {
+      control[index] = EMPTY;
+    } else {
+      control[index] = DELETED;
+      deleted++;
+    }
+
+    size_--;
+  }
+
+  void rehash(size_t target)
+  {
+    uint8_t* control_ = control;
+    Stored* slots_ = slots;
+    const size_t capacity_ = capacity;
+
+    control = new uint8_t[target];
+    memset(control, EMPTY, target);
+
+    slots = static_cast<Stored*>(::operator new(target * sizeof(Stored)));
+    capacity = target;
+    size_ = 0;
+    deleted = 0;
+
+    for (size_t i = 0; i < capacity_; i++) {
+      if (full(control_[i])) {
+        const size_t index = claim(mix(KeyOf::get(slots_[i])));
+        new (&slots[index]) Stored(std::move(slots_[i]));
+        slots_[i].~Stored();
+      }
+    }
+
+    delete[] control_;
+    ::operator delete(slots_);
+  }
+
+  void destroy()
+  {
+    clear();
+
+    delete[] control;
+    ::operator delete(slots);
+
+    control = NULL;
+    slots = NULL;
+    capacity = 0;
+  }
+
+  uint8_t* control;
+  Stored* slots;
+  size_t capacity;
+  size_t size_;
+  size_t deleted;
+
+  Hash hash;
+  Equal equal;
+};
+
+#endif // __STOUT_FLATHASHTABLE_HPP__
@@ -71,8 +71,10 @@ inline pid_t clone(const lambda::function<int()>& func, int flags)
   // If CLONE_VM is not set, ::clone would create a process which runs in a
   // separate copy of the memory space of the calling process. So we destroy the
   // stack here to avoid memory leak. If CLONE_VM is set, ::clone would create a
-  // thread which runs in the same memory space with the calling process.
-  if (!(flags & CLONE_VM)) {
+  // thread which runs in the same memory space with the calling process,
+  // unless CLONE_VFORK is set too, in which case the child has exec'ed
+  // (or exited) and no longer uses the stack once ::clone returns.
+  if (!(flags & CLONE_VM) || (flags & CLONE_VFORK)) {
     delete[] stack;
   }
 
@@ -18,12 +18,12 @@
 #include <string>
 
 #include <stout/error.hpp>
+#include <stout/option.hpp>
 #include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 
 // Compression utilities.
-// TODO(bmahler): Provide streaming compression / decompression as well.
 namespace gzip {
 
 // We use a 16KB buffer with zlib compression / decompression.
@@ -144,6 +144,199 @@ inline Try<std::string> decompress(const std::string& compressed)
   return result;
 }
 
+
+// Provides streaming gzip compression, i.e., the data is compressed a
+// chunk at a time. Every chunk is flushed (Z_SYNC_FLUSH) so that the
+// receiver can decompress all of the data it got so far (e.g., the
+// events of a long lived HTTP response), at the cost of a slightly
+// worse compression ratio.
+class Compressor
+{
+public:
+  // NOTE: Initialization errors surface on the first 'compress'.
+  explicit Compressor(int level = Z_DEFAULT_COMPRESSION) : finished(false)
+  {
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    if (!(level == Z_DEFAULT_COMPRESSION ||
+        (level >= Z_NO_COMPRESSION && level <= Z_BEST_COMPRESSION))) {
+      error = Error("Invalid compression level: " + stringify(level));
+      return;
+    }
+
+    int code = deflateInit2(
+        &stream,
+        level,          // Compression level.
+        Z_DEFLATED,     // Compression method.
+        MAX_WBITS + 16, // Zlib magic for gzip compression / decompression.
+        8,              // Default memLevel value.
+        Z_DEFAULT_STRATEGY);
+
+    if (code != Z_OK) {
+      error = Error("Failed to initialize zlib: " + std::string(stream.msg));
+    }
+  }
+
+  ~Compressor()
+  {
+    if (error.isNone()) {
+      deflateEnd(&stream);
+    }
+  }
+
+  // Returns the compressed data for the next chunk of the input.
+  Try<std::string> compress(const std::string& decompressed)
+  {
+    return deflate(decompressed, Z_SYNC_FLUSH);
+  }
+
+  // Returns the remaining compressed data (i.e., the gzip trailer)
+  // after which no more data can be compressed.
+  Try<std::string> finish()
+  {
+    Try<std::string> result = deflate("", Z_FINISH);
+    finished = true;
+    return result;
+  }
+
+private:
+  Compressor(const Compressor&);
+  Compressor& operator=(const Compressor&);
+
+  Try<std::string> deflate(const std::string& decompressed, int flush)
+  {
+    if (error.isSome()) {
+      return error.get();
+    }
+
+    if (finished) {
+      return Error("Compression is finished");
+    }
+
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(decompressed.data()));
+    stream.avail_in = decompressed.length();
+
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result = "";
+    int code;
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      code = ::deflate(&stream, flush);
+
+      // NOTE: Z_BUF_ERROR only means that no progress was possible,
+      // e.g., when flushing twice in a row.
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR) {
+        error = Error(std::string(stream.msg));
+        deflateEnd(&stream);
+        return error.get();
+      }
+
+      // Consume output.
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+    } while (stream.avail_out == 0 ||
+             (flush == Z_FINISH && code != Z_STREAM_END));
+
+    return result;
+  }
+
+  z_stream_s stream;
+  Option<Error> error;
+  bool finished;
+};
+
+
+// Provides streaming gzip decompression, i.e., the data is
+// decompressed as it arrives.
+class Decompressor
+{
+public:
+  // NOTE: Initialization errors surface on the first 'decompress'.
+  Decompressor() : finished_(false)
+  {
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    int code = inflateInit2(
+        &stream,
+        MAX_WBITS + 16); // Zlib magic for gzip compression / decompression.
+
+    if (code != Z_OK) {
+      error = Error("Failed to initialize zlib: " + std::string(stream.msg));
+    }
+  }
+
+  ~Decompressor()
+  {
+    if (error.isNone()) {
+      inflateEnd(&stream);
+    }
+  }
+
+  // Returns the decompressed data for the next chunk of the input,
+  // which might be empty if more input is needed.
+  Try<std::string> decompress(const std::string& compressed)
+  {
+    if (error.isSome()) {
+      return error.get();
+    }
+
+    if (finished_) {
+      return Error("Data after the end of the compressed stream");
+    }
+
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(compressed.data()));
+    stream.avail_in = compressed.length();
+
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result = "";
+    while (stream.avail_in > 0 && !finished_) {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      int code = inflate(&stream, Z_SYNC_FLUSH);
+
+      if (code != Z_OK && code != Z_STREAM_END) {
+        error = Error(
+            stream.msg != NULL ? std::string(stream.msg) : stringify(code));
+        inflateEnd(&stream);
+        return error.get();
+      }
+
+      finished_ = (code == Z_STREAM_END);
+
+      // Consume output.
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+    }
+
+    return result;
+  }
+
+  // Returns true once the end of the compressed stream was reached.
+  bool finished() const
+  {
+    return finished_;
+  }
+
+private:
+  Decompressor(const Decompressor&);
+  Decompressor& operator=(const Decompressor&);
+
+  z_stream_s stream;
+  Option<Error> error;
+  bool finished_;
+};
+
 } // namespace gzip {
 
 #endif // __STOUT_POSIX_GZIP_HPP__
@@ -22,6 +22,7 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -55,51 +56,129 @@ namespace protobuf {
 // currently uses a base-10 newline delimited header for language
 // portability, which makes changing these a bit tricky.
 
-// Write out the given protobuf to the specified file descriptor by
-// first writing out the length of the protobuf followed by the
-// contents.
-// NOTE: On error, this may have written partial data to the file.
-inline Try<Nothing> write(int fd, const google::protobuf::Message& message)
+// The size of the buffers of 'Reader' and 'Writer' below.
+const size_t BUFFER_SIZE = 1024 * 1024;
+
+
+namespace internal {
+
+// Appends the length of the protobuf followed by its contents.
+inline Try<Nothing> serialize(
+    const google::protobuf::Message& message,
+    std::string* bytes)
 {
   if (!message.IsInitialized()) {
     return Error(message.InitializationErrorString() +
                  " is required but not initialized");
   }
 
-  // First write the size of the protobuf.
-  uint32_t size = message.ByteSize();
-  std::string bytes((char*) &size, sizeof(size));
+  const uint32_t size = message.ByteSize();
 
-  Try<Nothing> result = os::write(fd, bytes);
-  if (result.isError()) {
-    return Error("Failed to write size: " + result.error());
+  const size_t offset = bytes->size();
+  bytes->resize(offset + sizeof(size) + size);
+
+  char* data = &(*bytes)[offset];
+  memcpy(data, (const void*) &size, sizeof(size));
+
+  // The size computed just above is cached by the message.
+  message.SerializeWithCachedSizesToArray(
+      reinterpret_cast<google::protobuf::uint8*>(data + sizeof(size)));
+
+  return Nothing();
+}
+
+} // namespace internal {
+
+
+// Write out the given protobuf to the specified file descriptor by
+// first writing out the length of the protobuf followed by the
+// contents. Both are written at once, so that a message takes a
+// single system call (unless the write is short).
+// NOTE: On error, this may have written partial data to the file.
+inline Try<Nothing> write(int fd, const google::protobuf::Message& message)
+{
+  std::string bytes;
+
+  Try<Nothing> serialize = internal::serialize(message, &bytes);
+  if (serialize.isError()) {
+    return Error(serialize.error());
   }
 
-  if (!message.SerializeToFileDescriptor(fd)) {
-    return Error("Failed to write/serialize message");
+  Try<Nothing> result = os::write(fd, bytes);
+  if (result.isError()) {
+    return Error("Failed to write message: " + result.error());
   }
 
   return Nothing();
 }
 
 
+// Writes out protobuf messages to a file descriptor in the format of
+// 'write' above, buffering them so that many messages take a single
+// system call. The buffered messages must be written out with
+// 'flush' (they are dropped otherwise).
+// NOTE: On error, this may have written partial data to the file.
+class Writer
+{
+public:
+  explicit Writer(int _fd, size_t _size = BUFFER_SIZE)
+    : fd(_fd), size(_size) {}
+
+  Try<Nothing> write(const google::protobuf::Message& message)
+  {
+    Try<Nothing> serialize = internal::serialize(message, &buffer);
+    if (serialize.isError()) {
+      return Error(serialize.error());
+    }
+
+    if (buffer.size() >= size) {
+      return flush();
+    }
+
+    return Nothing();
+  }
+
+  Try<Nothing> flush()
+  {
+    if (buffer.empty()) {
+      return Nothing();
+    }
+
+    Try<Nothing> result = os::write(fd, buffer);
+    buffer.clear();
+
+    if (result.isError()) {
+      return Error("Failed to write messages: " + result.error());
+    }
+
+    return Nothing();
+  }
+
+private:
+  const int fd;
+  const size_t size;
+  std::string buffer;
+};
+
+
 // Write out the given sequence of protobuf messages to the
-// specified file descriptor by repeatedly invoking write
-// on each of the messages.
+// specified file descriptor by buffering each of the messages.
 // NOTE: On error, this may have written partial data to the file.
 template <typename T>
 Try<Nothing> write(
     int fd,
     const google::protobuf::RepeatedPtrField<T>& messages)
 {
+  Writer writer(fd);
+
   foreach (const T& message, messages) {
-    Try<Nothing> result = write(fd, message);
+    Try<Nothing> result = writer.write(message);
     if (result.isError()) {
       return Error(result.error());
     }
   }
 
-  return Nothing();
+  return writer.flush();
 }
 
 
@@ -313,6 +392,155 @@ Result<T> read(const std::string& path)
 }
 
 
+// Reads the protobuf messages written by 'write' above one after the
+// other from a file descriptor, like repeatedly calling 'read' with
+// 'undoFailed', but reading the file in large chunks rather than with
+// two system calls per message.
+//
+// The file offset is ahead of the messages read so far, until 'read'
+// returns None or an error: the file offset is then restored to the
+// end of the last message that was read, e.g., for truncating the
+// file to the valid messages.
+template <typename T>
+class Reader
+{
+public:
+  explicit Reader(int _fd, size_t _size = BUFFER_SIZE)
+    : fd(_fd), size(_size), offset(-1), position(0), eof(false) {}
+
+  // If 'ignorePartial' is true, None() is returned when we unexpectedly
+  // hit EOF while reading the protobuf (e.g., partial write).
+  Result<T> read(bool ignorePartial = false)
+  {
+    if (offset == -1) {
+      offset = lseek(fd, 0, SEEK_CUR);
+      if (offset == -1) {
+        return ErrnoError("Failed to lseek to SEEK_CUR");
+      }
+    }
+
+    uint32_t length;
+
+    Try<bool> available = fill(sizeof(length));
+    if (available.isError()) {
+      return undo(Error("Failed to read size: " + available.error()));
+    } else if (!available.get()) {
+      if (buffer.size() == position) {
+        return undo(None()); // No more protobufs to read.
+      } else if (ignorePartial) {
+        return undo(None());
+      }
+      return undo(Error(
+          "Failed to read size: hit EOF unexpectedly, possible corruption"));
+    }
+
+    memcpy((void*) &length, (void*) (buffer.data() + position), sizeof(length));
+
+    // NOTE: Instead of specifically checking for corruption in 'length',
+    // we simply try to read 'length' bytes. If we hit EOF early, it is
+    // an indication of corruption.
+    available = fill(sizeof(length) + length);
+    if (available.isError()) {
+      return undo(Error("Failed to read message: " + available.error()));
+    } else if (!available.get()) {
+      if (ignorePartial) {
+        return undo(None());
+      }
+      return undo(Error(
+          "Failed to read message of size " + stringify(length) +
+          " bytes: hit EOF unexpectedly, possible corruption"));
+    }
+
+    T message;
+    google::protobuf::io::ArrayInputStream stream(
+        buffer.data() + position + sizeof(length),
+        length);
+
+    if (!message.ParseFromZeroCopyStream(&stream)) {
+      return undo(Error("Failed to deserialize message"));
+    }
+
+    position += sizeof(length) + length;
+    offset += sizeof(length) + length;
+
+    return message;
+  }
+
+  // Returns the file offset of the end of the last message read, i.e.,
+  // of the next message, or -1 before the first 'read'.
+  off_t tell() const
+  {
+    return offset;
+  }
+
+private:
+  // Reads from the file until at least 'length' bytes are buffered
+  // past 'position', returns false if EOF is hit before.
+  Try<bool> fill(size_t length)
+  {
+    while (buffer.size() - position < length) {
+      if (eof) {
+        return false;
+      }
+
+      // Drop the bytes of the messages already read.
+      buffer.erase(0, position);
+      position = 0;
+
+      const size_t capacity = std::max(size, length);
+      const size_t current = buffer.size();
+      buffer.resize(capacity);
+
+      ssize_t n = ::read(fd, &buffer[current], capacity - current);
+
+      if (n < 0) {
+        buffer.resize(current);
+        if (errno == EINTR) {
+          continue;
+        }
+        return ErrnoError();
+      }
+
+      buffer.resize(current + n);
+
+      if (n == 0) {
+        eof = true;
+      }
+    }
+
+    return true;
+  }
+
+  // Restores the file offset to the end of the last message read,
+  // returning 'result' (unless the offset can not be restored).
+  Result<T> undo(const Result<T>& result)
+  {
+    if (lseek(fd, offset, SEEK_SET) == -1) {
+      return ErrnoError("Failed to lseek to the end of the last message");
+    }
+
+    // The next read starts over from the restored offset.
+    buffer.clear();
+    position = 0;
+    eof = false;
+
+    return result;
+  }
+
+  const int fd;
+  const size_t size;
+
+  // The file offset of the end of the last message read.
+  off_t offset;
+
+  // The bytes read from the file, of which the ones before 'position'
+  // belong to the messages already read.
+  std::string buffer;
+  size_t position;
+  bool eof;
+};
+
+
 namespace internal {
 
 // Forward declaration.
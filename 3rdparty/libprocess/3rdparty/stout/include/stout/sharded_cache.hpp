@@ -0,0 +1,272 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_SHARDED_CACHE_HPP__
+#define __STOUT_SHARDED_CACHE_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "duration.hpp"
+#include "foreach.hpp"
+#include "none.hpp"
+#include "option.hpp"
+#include "synchronized.hpp"
+
+
+// Provides a least-recently used (LRU) cache like 'Cache' which can
+// be used by many threads at once. The keys are spread over a number
+// of shards, each with its own lock, LRU list and capacity, so that
+// the threads using different keys rarely contend.
+//
+// The capacity is the total weight of the entries, which is 1 per
+// entry unless a weigher is given (e.g., one returning the size of
+// the value in bytes). An entry may also expire after a time to live
+// (TTL), either the default one of the cache or its own; an expired
+// entry is dropped once it is looked up (or evicted).
+//
+// NOTE: Since the capacity is split among the shards, the least
+// recently used entry of the cache as a whole is not necessarily
+// the one which is evicted.
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class ShardedCache
+{
+public:
+  typedef std::function<size_t(const Key&, const Value&)> Weigher;
+
+  explicit ShardedCache(
+      size_t capacity,
+      size_t shards = 16,
+      const Option<Duration>& _ttl = None(),
+      const Weigher& _weigher = Weigher())
+    : ttl(_ttl),
+      weigher(_weigher),
+      hits_(0),
+      misses_(0),
+      evictions_(0)
+  {
+    shards = std::max<size_t>(1, shards);
+
+    // Every shard can hold at least one entry.
+    const size_t perShard = (capacity + shards - 1) / shards;
+
+    for (size_t i = 0; i < shards; i++) {
+      shards_.emplace_back(new Shard(std::max<size_t>(1, perShard)));
+    }
+  }
+
+  ShardedCache(const ShardedCache&) = delete;
+  ShardedCache& operator=(const ShardedCache&) = delete;
+
+  // Inserts or replaces the value of a key, which expires after the
+  // given TTL (or the default one of the cache, if any).
+  void put(
+      const Key& key,
+      const Value& value,
+      const Option<Duration>& _ttl = None())
+  {
+    const size_t weight = weigher ? weigher(key, value) : 1;
+
+    Option<Duration> expiresIn = _ttl.isSome() ? _ttl : ttl;
+
+    Option<Time> expiry = None();
+    if (expiresIn.isSome()) {
+      expiry = Clock::now() +
+        std::chrono::nanoseconds(expiresIn.get().ns());
+    }
+
+    Shard& shard = lookup(key);
+
+    synchronized (shard.mutex) {
+      typename Map::iterator i = shard.map.find(key);
+      if (i != shard.map.end()) {
+        remove(&shard, i->second);
+      }
+
+      // An entry which would not fit into the shard is not cached.
+      if (weight > shard.capacity) {
+        return;
+      }
+
+      while (shard.weight + weight > shard.capacity) {
+        remove(&shard, shard.entries.begin());
+        evictions_++;
+      }
+
+      shard.entries.emplace_back(key, value, weight, expiry);
+      shard.map.emplace(key, --shard.entries.end());
+      shard.weight += weight;
+    }
+  }
+
+  // Returns the value of a key (which counts as a use) unless it is
+  // not cached or it has expired.
+  Option<Value> get(const Key& key)
+  {
+    Shard& shard = lookup(key);
+
+    synchronized (shard.mutex) {
+      typename Map::iterator i = shard.map.find(key);
+
+      if (i != shard.map.end()) {
+        const typename List::iterator entry = i->second;
+
+        if (entry->expiry.isNone() || Clock::now() < entry->expiry.get()) {
+          shard.entries.splice(shard.entries.end(), shard.entries, entry);
+          hits_++;
+          return entry->value;
+        }
+
+        remove(&shard, entry);
+      }
+    }
+
+    misses_++;
+    return None();
+  }
+
+  Option<Value> erase(const Key& key)
+  {
+    Shard& shard = lookup(key);
+
+    synchronized (shard.mutex) {
+      typename Map::iterator i = shard.map.find(key);
+
+      if (i != shard.map.end()) {
+        Value value = i->second->value;
+        remove(&shard, i->second);
+        return value;
+      }
+    }
+
+    return None();
+  }
+
+  void clear()
+  {
+    foreach (const std::unique_ptr<Shard>& shard, shards_) {
+      synchronized (shard->mutex) {
+        shard->map.clear();
+        shard->entries.clear();
+        shard->weight = 0;
+      }
+    }
+  }
+
+  // Returns the number of entries, including the expired ones which
+  // have not been dropped yet.
+  size_t size() const
+  {
+    size_t result = 0;
+    foreach (const std::unique_ptr<Shard>& shard, shards_) {
+      synchronized (shard->mutex) {
+        result += shard->entries.size();
+      }
+    }
+    return result;
+  }
+
+  // Returns the total weight of the entries.
+  size_t weight() const
+  {
+    size_t result = 0;
+    foreach (const std::unique_ptr<Shard>& shard, shards_) {
+      synchronized (shard->mutex) {
+        result += shard->weight;
+      }
+    }
+    return result;
+  }
+
+  // The number of lookups which found a (live) entry, which did not,
+  // and the number of entries evicted to make room for others.
+  uint64_t hits() const { return hits_.load(); }
+  uint64_t misses() const { return misses_.load(); }
+  uint64_t evictions() const { return evictions_.load(); }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  typedef Clock::time_point Time;
+
+  struct Entry
+  {
+    Entry(const Key& _key,
+          const Value& _value,
+          size_t _weight,
+          const Option<Time>& _expiry)
+      : key(_key), value(_value), weight(_weight), expiry(_expiry) {}
+
+    const Key key;
+    const Value value;
+    const size_t weight;
+    const Option<Time> expiry;
+  };
+
+  // The entries are ordered from least to most-recently used.
+  typedef std::list<Entry> List;
+  typedef std::unordered_map<Key, typename List::iterator, Hash, Equal> Map;
+
+  struct Shard
+  {
+    explicit Shard(size_t _capacity) : capacity(_capacity), weight(0) {}
+
+    mutable std::mutex mutex;
+    const size_t capacity;
+    size_t weight;
+    List entries;
+    Map map;
+  };
+
+  Shard& lookup(const Key& key)
+  {
+    // Spread the bits of the hash, since the hash of an integer is
+    // usually the integer itself (and the shards would otherwise
+    // share the buckets of their maps).
+    uint64_t hashed = static_cast<uint64_t>(Hash()(key));
+    hashed *= 0x9E3779B97F4A7C15ULL;
+
+    return *shards_[(hashed >> 32) % shards_.size()];
+  }
+
+  // NOTE: Expects the lock of the shard to be held.
+  static void remove(Shard* shard, const typename List::iterator& entry)
+  {
+    shard->weight -= entry->weight;
+    shard->map.erase(entry->key);
+    shard->entries.erase(entry);
+  }
+
+  const Option<Duration> ttl;
+  const Weigher weigher;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+  std::atomic<uint64_t> evictions_;
+};
+
+#endif // __STOUT_SHARDED_CACHE_HPP__
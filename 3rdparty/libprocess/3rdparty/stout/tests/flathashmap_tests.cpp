@@ -0,0 +1,229 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <ctype.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/functional/hash.hpp>
+
+#include <stout/flathashmap.hpp>
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/stringify.hpp>
+
+using std::string;
+
+
+TEST(FlatHashMapTest, InitializerList)
+{
+  flathashmap<string, int> map{{"hello", 1}};
+  EXPECT_EQ(1, map.size());
+
+  EXPECT_TRUE((flathashmap<int, int>{}.empty()));
+
+  flathashmap<int, int> map2{{1, 2}, {2, 3}, {3, 4}};
+  EXPECT_EQ(3, map2.size());
+  EXPECT_SOME_EQ(2, map2.get(1));
+  EXPECT_SOME_EQ(3, map2.get(2));
+  EXPECT_SOME_EQ(4, map2.get(3));
+  EXPECT_NONE(map2.get(4));
+}
+
+
+TEST(FlatHashMapTest, FromStdMap)
+{
+  std::map<int, int> map1{{1, 2}, {2, 3}};
+
+  flathashmap<int, int> map2(map1);
+
+  EXPECT_EQ(2, map2.size());
+  EXPECT_SOME_EQ(2, map2.get(1));
+  EXPECT_SOME_EQ(3, map2.get(2));
+}
+
+
+TEST(FlatHashMapTest, Insert)
+{
+  flathashmap<string, int> map;
+  map["abc"] = 1;
+  map.put("def", 2);
+
+  ASSERT_SOME_EQ(1, map.get("abc"));
+  ASSERT_SOME_EQ(2, map.get("def"));
+
+  map.put("def", 4);
+  ASSERT_SOME_EQ(4, map.get("def"));
+  ASSERT_EQ(2, map.size());
+
+  EXPECT_FALSE(map.insert({"abc", 5}).second);
+  EXPECT_SOME_EQ(1, map.get("abc"));
+
+  EXPECT_TRUE(map.emplace("ghi", 6).second);
+  EXPECT_SOME_EQ(6, map.get("ghi"));
+  EXPECT_EQ(6, map.at("ghi"));
+  EXPECT_THROW(map.at("jkl"), std::out_of_range);
+}
+
+
+TEST(FlatHashMapTest, Contains)
+{
+  flathashmap<string, int> map;
+  map["abc"] = 1;
+
+  ASSERT_TRUE(map.contains("abc"));
+  ASSERT_TRUE(map.containsValue(1));
+
+  ASSERT_FALSE(map.contains("def"));
+  ASSERT_FALSE(map.containsValue(2));
+}
+
+
+TEST(FlatHashMapTest, KeysAndValues)
+{
+  flathashmap<int, string> map{{1, "one"}, {2, "two"}};
+
+  hashset<int> keys = map.keys();
+  EXPECT_EQ(2, keys.size());
+  EXPECT_TRUE(keys.contains(1));
+  EXPECT_TRUE(keys.contains(2));
+
+  std::list<string> values = map.values();
+  EXPECT_EQ(2, values.size());
+}
+
+
+// Grows the map past many rehashes while erasing every other key,
+// which leaves tombstones behind, and checks it against a 'hashmap'.
+TEST(FlatHashMapTest, Erase)
+{
+  flathashmap<int, string> map;
+  hashmap<int, string> expected;
+
+  for (int i = 0; i < 10000; i++) {
+    map[i] = stringify(i);
+    expected[i] = stringify(i);
+
+    if (i % 2 == 1) {
+      EXPECT_EQ(1, map.erase(i - 1));
+      expected.erase(i - 1);
+    }
+  }
+
+  EXPECT_EQ(0, map.erase(0));
+  EXPECT_EQ(expected.size(), map.size());
+
+  foreachpair (int key, const string& value, expected) {
+    EXPECT_SOME_EQ(value, map.get(key));
+  }
+
+  size_t count = 0;
+  foreachpair (int key, const string& value, map) {
+    EXPECT_SOME_EQ(value, expected.get(key));
+    count++;
+  }
+
+  EXPECT_EQ(expected.size(), count);
+
+  // Erasing while iterating visits all the elements.
+  for (auto it = map.begin(); it != map.end();) {
+    it = map.erase(it);
+  }
+
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_NONE(map.get(1));
+
+  // The map can still be used after erasing all of its elements.
+  map[1] = "1";
+  EXPECT_SOME_EQ("1", map.get(1));
+}
+
+
+TEST(FlatHashMapTest, CopyAndMove)
+{
+  flathashmap<int, std::shared_ptr<int>> map;
+  for (int i = 0; i < 100; i++) {
+    map[i] = std::make_shared<int>(i);
+  }
+
+  flathashmap<int, std::shared_ptr<int>> copy = map;
+  EXPECT_EQ(100, copy.size());
+  EXPECT_TRUE(copy == map);
+  EXPECT_EQ(2, map[42].use_count());
+
+  flathashmap<int, std::shared_ptr<int>> moved = std::move(copy);
+  EXPECT_EQ(100, moved.size());
+  EXPECT_TRUE(copy.empty());
+  EXPECT_EQ(2, map[42].use_count());
+
+  moved.clear();
+  EXPECT_TRUE(moved.empty());
+  EXPECT_EQ(1, map[42].use_count());
+
+  moved.put(1, map[1]);
+  EXPECT_TRUE(moved != map);
+}
+
+
+TEST(FlatHashMapTest, CustomHashAndEqual)
+{
+  struct CaseInsensitiveHash
+  {
+    size_t operator()(const string& key) const
+    {
+      size_t seed = 0;
+      foreach (const char c, key) {
+        boost::hash_combine(seed, ::tolower(c));
+      }
+      return seed;
+    }
+  };
+
+  struct CaseInsensitiveEqual
+  {
+    bool operator()(const string& left, const string& right) const
+    {
+      if (left.size() != right.size()) {
+        return false;
+      }
+      for (size_t i = 0; i < left.size(); ++i) {
+        if (::tolower(left[i]) != ::tolower(right[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+  };
+
+  flathashmap<string, int, CaseInsensitiveHash, CaseInsensitiveEqual> map;
+
+  map["abc"] = 1;
+  map.put("def", 2);
+  EXPECT_SOME_EQ(1, map.get("Abc"));
+  EXPECT_SOME_EQ(2, map.get("dEf"));
+
+  map.put("Abc", 3);
+  map["DEF"] = 4;
+  EXPECT_SOME_EQ(3, map.get("abc"));
+  EXPECT_SOME_EQ(4, map.get("def"));
+
+  EXPECT_EQ(2, map.size());
+  EXPECT_TRUE(map.contains("abc"));
+  EXPECT_TRUE(map.contains("aBc"));
+}
@@ -0,0 +1,114 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <set>
+#include <string>
+
+#include <stout/flathashset.hpp>
+#include <stout/foreach.hpp>
+
+#include <gtest/gtest.h>
+
+#include <gmock/gmock.h>
+
+using std::string;
+
+
+TEST(FlatHashsetTest, InitializerList)
+{
+  flathashset<string> set{"hello"};
+  EXPECT_EQ(1, set.size());
+
+  EXPECT_TRUE((flathashset<int>{}.empty()));
+
+  flathashset<int> set1{1, 3, 5, 7, 11};
+  EXPECT_EQ(5, set1.size());
+  EXPECT_TRUE(set1.contains(1));
+  EXPECT_TRUE(set1.contains(3));
+  EXPECT_TRUE(set1.contains(5));
+  EXPECT_TRUE(set1.contains(7));
+  EXPECT_TRUE(set1.contains(11));
+
+  EXPECT_FALSE(set1.contains(2));
+}
+
+
+TEST(FlatHashsetTest, FromStdSet)
+{
+  std::set<int> set1{1, 3, 5, 7};
+
+  flathashset<int> set2(set1);
+
+  EXPECT_EQ(4, set2.size());
+
+  foreach (const auto set1_entry, set1) {
+    EXPECT_TRUE(set2.contains(set1_entry));
+  }
+}
+
+
+TEST(FlatHashsetTest, Insert)
+{
+  flathashset<string> hs1;
+  hs1.insert(string("HS1"));
+  hs1.insert(string("HS3"));
+
+  flathashset<string> hs2;
+  hs2.insert(string("HS2"));
+
+  hs1 = hs2;
+  ASSERT_EQ(1u, hs1.size());
+  ASSERT_TRUE(hs1.contains("HS2"));
+  ASSERT_TRUE(hs1 == hs2);
+}
+
+
+TEST(FlatHashsetTest, Erase)
+{
+  flathashset<int> set;
+  for (int i = 0; i < 1000; i++) {
+    set.insert(i);
+  }
+
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_EQ(1, set.erase(i));
+  }
+
+  EXPECT_EQ(500, set.size());
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(i % 2 == 1, set.contains(i));
+  }
+}
+
+
+TEST(FlatHashsetTest, Union)
+{
+  flathashset<int> hs1;
+  hs1.insert(1);
+  hs1.insert(2);
+  hs1.insert(3);
+
+  flathashset<int> hs2;
+  hs2.insert(3);
+  hs2.insert(4);
+  hs2.insert(5);
+
+  flathashset<int> hs3 = hs1 | hs2;
+
+  ASSERT_EQ(5u, hs3.size());
+  ASSERT_TRUE(hs3.contains(1));
+  ASSERT_TRUE(hs3.contains(2));
+  ASSERT_TRUE(hs3.contains(3));
+  ASSERT_TRUE(hs3.contains(4));
+  ASSERT_TRUE(hs3.contains(5));
+}
@@ -18,6 +18,7 @@
 
 #include <stout/gtest.hpp>
 #include <stout/gzip.hpp>
+#include <stout/stringify.hpp>
 
 using std::string;
 
@@ -62,4 +63,53 @@ TEST(GzipTest, CompressDecompressString)
   ASSERT_SOME(decompressed);
   ASSERT_EQ(s, decompressed.get());
 }
+
+
+TEST(GzipTest, StreamingCompressDecompress)
+{
+  gzip::Compressor compressor;
+  gzip::Decompressor decompressor;
+
+  // Every chunk can be decompressed as soon as it was compressed.
+  for (int i = 0; i < 100; i++) {
+    string chunk = "chunk " + stringify(i) + string(i * 100, 'x');
+
+    Try<string> compressed = compressor.compress(chunk);
+    ASSERT_SOME(compressed);
+
+    Try<string> decompressed = decompressor.decompress(compressed.get());
+    ASSERT_SOME(decompressed);
+    ASSERT_EQ(chunk, decompressed.get());
+  }
+
+  EXPECT_FALSE(decompressor.finished());
+
+  Try<string> trailer = compressor.finish();
+  ASSERT_SOME(trailer);
+
+  Try<string> decompressed = decompressor.decompress(trailer.get());
+  ASSERT_SOME(decompressed);
+  EXPECT_TRUE(decompressed.get().empty());
+  EXPECT_TRUE(decompressor.finished());
+
+  EXPECT_ERROR(compressor.compress("more"));
+  EXPECT_ERROR(decompressor.decompress("more"));
+
+  // The streamed data is a regular gzip stream.
+  gzip::Compressor whole;
+  Try<string> head = whole.compress("Lorem ipsum ");
+  ASSERT_SOME(head);
+  Try<string> tail = whole.compress("dolor sit amet");
+  ASSERT_SOME(tail);
+  Try<string> end = whole.finish();
+  ASSERT_SOME(end);
+
+  EXPECT_SOME_EQ(
+      "Lorem ipsum dolor sit amet",
+      gzip::decompress(head.get() + tail.get() + end.get()));
+
+  // Bad compression levels are reported when compressing.
+  gzip::Compressor invalid(Z_BEST_COMPRESSION + 1);
+  EXPECT_ERROR(invalid.compress("data"));
+}
 #endif // HAVE_LIBZ
@@ -25,6 +25,13 @@
 #include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
+#include <stout/os/close.hpp>
+#include <stout/os/ftruncate.hpp>
+#include <stout/os/open.hpp>
+#include <stout/os/stat.hpp>
+
+#include <stout/tests/utils.hpp>
+
 #include "protobuf_tests.pb.h"
 
 using std::string;
@@ -594,3 +601,68 @@ TEST(ProtobufTest, JsonifyLargeIntegers)
   // Check JSON -> String.
   EXPECT_EQ(expected, string(jsonify(message)));
 }
+
+
+class ProtobufFileTest : public TemporaryDirectoryTest {};
+
+
+// Tests that the messages written by the buffered 'Writer' are read
+// back by the buffered 'Reader', which leaves the file offset at the
+// end of the last complete message.
+TEST_F(ProtobufFileTest, ReaderWriter)
+{
+  const string path = "messages";
+
+  Try<int> fd = os::open(
+      path,
+      O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  ASSERT_SOME(fd);
+
+  // A small buffer exercises flushing in between the messages.
+  protobuf::Writer writer(fd.get(), 64);
+
+  for (int i = 0; i < 100; i++) {
+    tests::SimpleMessage message;
+    message.set_id(stringify(i));
+    message.add_numbers(i);
+
+    ASSERT_SOME(writer.write(message));
+  }
+
+  ASSERT_SOME(writer.flush());
+
+  Try<Bytes> size = os::stat::size(path);
+  ASSERT_SOME(size);
+
+  // Append a partially written message.
+  tests::SimpleMessage partial;
+  partial.set_id("partial");
+  ASSERT_SOME(protobuf::write(fd.get(), partial));
+  ASSERT_SOME(os::ftruncate(fd.get(), size.get().bytes() + 6));
+
+  // Read everything back with a buffer smaller than a message, and
+  // with the default one.
+  foreach (size_t buffer, std::vector<size_t>({3, protobuf::BUFFER_SIZE})) {
+    ASSERT_EQ(0, lseek(fd.get(), 0, SEEK_SET));
+
+    protobuf::Reader<tests::SimpleMessage> reader(fd.get(), buffer);
+
+    for (int i = 0; i < 100; i++) {
+      Result<tests::SimpleMessage> message = reader.read(true);
+      ASSERT_SOME(message);
+      EXPECT_EQ(stringify(i), message.get().id());
+    }
+
+    EXPECT_NONE(reader.read(true));
+    EXPECT_EQ(size.get().bytes(), lseek(fd.get(), 0, SEEK_CUR));
+    EXPECT_EQ(size.get().bytes(), reader.tell());
+
+    // Without 'ignorePartial', the partial message is an error.
+    EXPECT_ERROR(reader.read());
+    EXPECT_EQ(size.get().bytes(), lseek(fd.get(), 0, SEEK_CUR));
+  }
+
+  ASSERT_SOME(os::close(fd.get()));
+}
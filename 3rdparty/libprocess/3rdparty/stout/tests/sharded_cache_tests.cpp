@@ -0,0 +1,135 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/os.hpp>
+#include <stout/sharded_cache.hpp>
+#include <stout/stringify.hpp>
+
+using std::string;
+using std::vector;
+
+
+TEST(ShardedCacheTest, Insert)
+{
+  ShardedCache<int, string> cache(1, 1);
+  EXPECT_EQ(0u, cache.size());
+  cache.put(1, "a");
+  EXPECT_SOME_EQ("a", cache.get(1));
+  EXPECT_EQ(1u, cache.size());
+
+  cache.put(1, "b");
+  EXPECT_SOME_EQ("b", cache.get(1));
+  EXPECT_EQ(1u, cache.size());
+
+  EXPECT_SOME_EQ("b", cache.erase(1));
+  EXPECT_NONE(cache.erase(1));
+  EXPECT_EQ(0u, cache.size());
+}
+
+
+TEST(ShardedCacheTest, LRUEviction)
+{
+  ShardedCache<int, string> cache(2, 1);
+  cache.put(1, "a");
+  cache.put(2, "b");
+  cache.put(3, "c");
+
+  EXPECT_NONE(cache.get(1));
+
+  // 'Get' makes '2' the most-recently used (MRU) item.
+  cache.get(2);
+  cache.put(4, "d");
+  EXPECT_NONE(cache.get(3));
+  EXPECT_SOME_EQ("b", cache.get(2));
+  EXPECT_SOME_EQ("d", cache.get(4));
+
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(2u, cache.evictions());
+  EXPECT_EQ(3u, cache.hits());
+  EXPECT_EQ(2u, cache.misses());
+}
+
+
+TEST(ShardedCacheTest, Weight)
+{
+  // The capacity is the total size of the values.
+  ShardedCache<int, string> cache(
+      8,
+      1,
+      None(),
+      [](int, const string& value) { return value.size(); });
+
+  cache.put(1, "aaaa");
+  cache.put(2, "bbb");
+  EXPECT_EQ(7u, cache.weight());
+
+  // Makes room for the new value by evicting the LRU one.
+  cache.put(3, "cc");
+  EXPECT_NONE(cache.get(1));
+  EXPECT_SOME_EQ("bbb", cache.get(2));
+  EXPECT_SOME_EQ("cc", cache.get(3));
+  EXPECT_EQ(5u, cache.weight());
+
+  // A value which is larger than the capacity is not cached.
+  cache.put(4, "ddddddddd");
+  EXPECT_NONE(cache.get(4));
+  EXPECT_EQ(5u, cache.weight());
+}
+
+
+TEST(ShardedCacheTest, TTL)
+{
+  ShardedCache<int, string> cache(8, 1, Milliseconds(10));
+
+  cache.put(1, "a");
+  cache.put(2, "b", Days(1));
+
+  os::sleep(Milliseconds(20));
+
+  EXPECT_NONE(cache.get(1));
+  EXPECT_SOME_EQ("b", cache.get(2));
+  EXPECT_EQ(1u, cache.size());
+}
+
+
+TEST(ShardedCacheTest, Concurrent)
+{
+  ShardedCache<string, int> cache(1024);
+
+  vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&cache, i]() {
+      for (int j = 0; j < 1000; j++) {
+        const string key = stringify(i) + ":" + stringify(j % 100);
+        cache.put(key, j);
+        EXPECT_SOME(cache.get(key));
+      }
+    });
+  }
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(400u, cache.size());
+  EXPECT_EQ(4000u, cache.hits());
+  EXPECT_EQ(0u, cache.misses());
+}
@@ -47,3 +47,23 @@ TEST(UUIDTest, Test)
   EXPECT_EQ(string2, string3);
   EXPECT_EQ(string1, string3);
 }
+
+
+TEST(UUIDTest, Sequential)
+{
+  UUID uuid1 = UUID::sequential();
+  UUID uuid2 = UUID::sequential();
+
+  EXPECT_NE(uuid1, uuid2);
+  EXPECT_LT(uuid1, uuid2);
+
+  // The UUIDs of a thread share their prefix.
+  EXPECT_EQ(uuid1.toBytes().substr(0, 8), uuid2.toBytes().substr(0, 8));
+
+  EXPECT_EQ(boost::uuids::uuid::version_random_number_based,
+            uuid1.version());
+  EXPECT_EQ(boost::uuids::uuid::variant_rfc_4122, uuid1.variant());
+
+  EXPECT_EQ(uuid1, UUID::fromBytes(uuid1.toBytes()));
+  EXPECT_EQ(uuid1, UUID::fromString(uuid1.toString()));
+}
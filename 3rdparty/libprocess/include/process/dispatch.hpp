@@ -14,7 +14,7 @@
 #define __PROCESS_DISPATCH_HPP__
 
 #include <functional>
-#include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
+#include <memory>
 #include <string>
 
 #include <process/process.hpp>
@@ -58,11 +58,11 @@ namespace internal {
 // this routine does not expect anything in particular about the
 // specified function (second argument). The semantics are simple: the
 // function gets applied/invoked with the process as its first
-// argument. Currently we wrap the function in a shared_ptr but this
-// will probably change in the future to unique_ptr (or a variant).
+// argument. The function is moved into the dispatch event, which is
+// allocated from a per thread pool (see DispatchEvent).
 void dispatch(
     const UPID& pid,
-    const std::shared_ptr<std::function<void(ProcessBase*)>>& f,
+    std::function<void(ProcessBase*)>&& f,
     const Option<const std::type_info*>& functionType = None());
 
 } // namespace internal {
@@ -79,16 +79,15 @@ void dispatch(
 template <typename T>
 void dispatch(const PID<T>& pid, void (T::*method)())
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            (t->*method)();
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  internal::dispatch(
+      pid,
+      [=](ProcessBase* process) {
+        assert(process != NULL);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != NULL);
+        (t->*method)();
+      },
+      &typeid(method));
 }
 
 template <typename T>
@@ -115,16 +114,15 @@ void dispatch(const Process<T>* process, void (T::*method)())
       void (T::*method)(ENUM_PARAMS(N, P)),                             \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              (t->*method)(ENUM_PARAMS(N, a));                          \
-            }));                                                        \
-                                                                        \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid,                                                            \
+        [=](ProcessBase* process) {                                     \
+          assert(process != NULL);                                      \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != NULL);                                            \
+          (t->*method)(ENUM_PARAMS(N, a));                              \
+        },                                                              \
+        &typeid(method));                                               \
   }                                                                     \
                                                                         \
   template <typename T,                                                 \
@@ -158,18 +156,17 @@ void dispatch(const Process<T>* process, void (T::*method)())
 template <typename R, typename T>
 Future<R> dispatch(const PID<T>& pid, Future<R> (T::*method)())
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
-
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            promise->associate((t->*method)());
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
+
+  internal::dispatch(
+      pid,
+      [=](ProcessBase* process) {
+        assert(process != NULL);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != NULL);
+        promise->associate((t->*method)());
+      },
+      &typeid(method));
 
   return promise->future();
 }
@@ -196,18 +193,18 @@ Future<R> dispatch(const Process<T>* process, Future<R> (T::*method)())
       Future<R> (T::*method)(ENUM_PARAMS(N, P)),                        \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
+    std::shared_ptr<Promise<R>> promise =                               \
+      std::make_shared<Promise<R>>();                                   \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              promise->associate((t->*method)(ENUM_PARAMS(N, a)));      \
-            }));                                                        \
-                                                                        \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid,                                                            \
+        [=](ProcessBase* process) {                                     \
+          assert(process != NULL);                                      \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != NULL);                                            \
+          promise->associate((t->*method)(ENUM_PARAMS(N, a)));          \
+        },                                                              \
+        &typeid(method));                                               \
                                                                         \
     return promise->future();                                           \
   }                                                                     \
@@ -245,18 +242,17 @@ Future<R> dispatch(const Process<T>* process, Future<R> (T::*method)())
 template <typename R, typename T>
 Future<R> dispatch(const PID<T>& pid, R (T::*method)())
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
-
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            promise->set((t->*method)());
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
+
+  internal::dispatch(
+      pid,
+      [=](ProcessBase* process) {
+        assert(process != NULL);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != NULL);
+        promise->set((t->*method)());
+      },
+      &typeid(method));
 
   return promise->future();
 }
@@ -283,18 +279,18 @@ Future<R> dispatch(const Process<T>* process, R (T::*method)())
       R (T::*method)(ENUM_PARAMS(N, P)),                                \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
-                                                                        \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              promise->set((t->*method)(ENUM_PARAMS(N, a)));            \
-            }));                                                        \
+    std::shared_ptr<Promise<R>> promise =                               \
+      std::make_shared<Promise<R>>();                                   \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid,                                                            \
+        [=](ProcessBase* process) {                                     \
+          assert(process != NULL);                                      \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != NULL);                                            \
+          promise->set((t->*method)(ENUM_PARAMS(N, a)));                \
+        },                                                              \
+        &typeid(method));                                               \
                                                                         \
     return promise->future();                                           \
   }                                                                     \
@@ -329,28 +325,24 @@ Future<R> dispatch(const Process<T>* process, R (T::*method)())
 
 inline void dispatch(const UPID& pid, const std::function<void()>& f)
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            f();
-          }));
-
-  internal::dispatch(pid, f_);
+  internal::dispatch(
+      pid,
+      [=](ProcessBase*) {
+        f();
+      });
 }
 
 
 template <typename R>
 Future<R> dispatch(const UPID& pid, const std::function<Future<R>()>& f)
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            promise->associate(f());
-          }));
-
-  internal::dispatch(pid, f_);
+  internal::dispatch(
+      pid,
+      [=](ProcessBase*) {
+        promise->associate(f());
+      });
 
   return promise->future();
 }
@@ -359,15 +351,13 @@ Future<R> dispatch(const UPID& pid, const std::function<Future<R>()>& f)
 template <typename R>
 Future<R> dispatch(const UPID& pid, const std::function<R()>& f)
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
-
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            promise->set(f());
-          }));
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
 
-  internal::dispatch(pid, f_);
+  internal::dispatch(
+      pid,
+      [=](ProcessBase*) {
+        promise->set(f());
+      });
 
   return promise->future();
 }
@@ -13,6 +13,9 @@
 #ifndef __PROCESS_EVENT_HPP__
 #define __PROCESS_EVENT_HPP__
 
+#include <stdint.h>
+
+#include <atomic>
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
 
 #include <process/future.hpp>
@@ -26,6 +29,7 @@
 namespace process {
 
 // Forward declarations.
+class EventQueue;
 class ProcessBase;
 struct MessageEvent;
 struct DispatchEvent;
@@ -47,6 +51,11 @@ struct EventVisitor
 
 struct Event
 {
+  Event() : next(NULL), enqueued(0) {}
+
+  // NOTE: A copy is never linked into the queue of the original.
+  Event(const Event&) : next(NULL), enqueued(0) {}
+
   virtual ~Event() {}
 
   virtual void visit(EventVisitor* visitor) const = 0;
@@ -81,6 +90,19 @@ struct Event
     }
     return *result;
   }
+
+private:
+  friend class EventQueue;
+  friend class ProcessBase;
+  friend class ProcessManager;
+
+  // Link to the next event while this event is in an 'EventQueue'.
+  std::atomic<Event*> next;
+
+  // When the event was enqueued (on a monotonic clock, in
+  // nanoseconds), only set if the events of the receiving process are
+  // instrumented (see LIBPROCESS_INSTRUMENT_EVENTS).
+  uint64_t enqueued;
 };
 
 
@@ -149,13 +171,19 @@ struct DispatchEvent : Event
 {
   DispatchEvent(
       const UPID& _pid,
-      const std::shared_ptr<lambda::function<void(ProcessBase*)>>& _f,
+      lambda::function<void(ProcessBase*)>&& _f,
       const Option<const std::type_info*>& _functionType)
     : pid(_pid),
-      f(_f),
+      f(std::move(_f)),
       functionType(_functionType)
   {}
 
+  // Dispatch events are recycled through a free list of the thread
+  // deleting them, rather than going through the allocator on every
+  // dispatch (see process.cpp).
+  static void* operator new(size_t size);
+  static void operator delete(void* event, size_t size);
+
   virtual void visit(EventVisitor* visitor) const
   {
     visitor->visit(*this);
@@ -165,7 +193,7 @@ struct DispatchEvent : Event
   const UPID pid;
 
   // Function to get invoked as a result of this dispatch event.
-  const std::shared_ptr<lambda::function<void(ProcessBase*)>> f;
+  const lambda::function<void(ProcessBase*)> f;
 
   const Option<const std::type_info*> functionType;
 
@@ -0,0 +1,220 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_EVENT_QUEUE_HPP__
+#define __PROCESS_EVENT_QUEUE_HPP__
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+#include <process/event.hpp>
+
+#include <stout/synchronized.hpp>
+
+namespace process {
+
+// The queue of events of a process (i.e., its mailbox).
+//
+// Events are enqueued by many producers and dequeued only by the
+// thread that is currently running the process. The common case,
+// appending an event, is lock-free: events are linked together
+// intrusively (via 'Event::next') using the multiple-producer
+// single-consumer algorithm by Dmitry Vyukov. Injected events (which
+// must be dequeued before all others) take a slow path through a
+// separate, mutex protected, queue.
+//
+// Rather than walking the queue, which is not safe to do while the
+// consumer is dequeueing and deleting events, the number of events
+// of each type is kept up to date as they are enqueued and dequeued.
+class EventQueue
+{
+public:
+  EventQueue() : head(&stub), tail(&stub), size_(0), injected(0)
+  {
+    for (size_t i = 0; i < TYPES; i++) {
+      counts[i].store(0);
+    }
+  }
+
+  // Can be called from any thread.
+  void enqueue(Event* event, bool inject = false)
+  {
+    increment(event);
+
+    size_.fetch_add(1);
+
+    if (inject) {
+      synchronized (mutex) {
+        front.push_front(event);
+        injected.fetch_add(1);
+      }
+    } else {
+      push(event);
+    }
+  }
+
+  // Must only be called from the consumer. Returns NULL if the queue
+  // is empty, but also if a producer is in the middle of enqueueing
+  // (in which case 'empty' returns false).
+  Event* dequeue()
+  {
+    Event* event = NULL;
+
+    if (injected.load() > 0) {
+      synchronized (mutex) {
+        event = front.front();
+        front.pop_front();
+        injected.fetch_sub(1);
+      }
+    } else {
+      event = pop();
+    }
+
+    if (event != NULL) {
+      size_.fetch_sub(1);
+      decrement(event);
+    }
+
+    return event;
+  }
+
+  // NOTE: A producer increments the size before the event is linked
+  // into the queue, so the queue might appear non-empty while
+  // 'dequeue' still returns NULL, but never the other way around.
+  bool empty() const
+  {
+    return size_.load() == 0;
+  }
+
+  size_t size() const
+  {
+    return size_.load();
+  }
+
+  // Returns the number of events of the given type in the queue.
+  template <typename T>
+  size_t count() const
+  {
+    return counts[index(static_cast<const T*>(NULL))].load();
+  }
+
+private:
+  // Not copyable, not assignable.
+  EventQueue(const EventQueue&);
+  EventQueue& operator=(const EventQueue&);
+
+  // An event that is never dequeued, used so that 'head' and 'tail'
+  // are never NULL.
+  struct Stub : Event
+  {
+    virtual void visit(EventVisitor* visitor) const {}
+  };
+
+  void push(Event* event)
+  {
+    event->next.store(NULL, std::memory_order_relaxed);
+    Event* previous = head.exchange(event, std::memory_order_acq_rel);
+    previous->next.store(event, std::memory_order_release);
+  }
+
+  Event* pop()
+  {
+    Event* event = tail;
+    Event* next = event->next.load(std::memory_order_acquire);
+
+    if (event == &stub) {
+      if (next == NULL) {
+        return NULL;
+      }
+      tail = next;
+      event = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != NULL) {
+      tail = next;
+      return event;
+    }
+
+    // The last event in the queue can only be removed once another
+    // event has been linked after it, so put the stub back.
+    if (event != head.load(std::memory_order_acquire)) {
+      return NULL; // A producer is in the middle of 'push'.
+    }
+
+    push(&stub);
+
+    next = event->next.load(std::memory_order_acquire);
+
+    if (next != NULL) {
+      tail = next;
+      return event;
+    }
+
+    return NULL;
+  }
+
+  static const size_t TYPES = 5;
+
+  static size_t index(const MessageEvent*) { return 0; }
+  static size_t index(const DispatchEvent*) { return 1; }
+  static size_t index(const HttpEvent*) { return 2; }
+  static size_t index(const ExitedEvent*) { return 3; }
+  static size_t index(const TerminateEvent*) { return 4; }
+
+  struct IndexVisitor : EventVisitor
+  {
+    IndexVisitor() : index(0) {}
+
+    virtual void visit(const MessageEvent& event) { index = 0; }
+    virtual void visit(const DispatchEvent& event) { index = 1; }
+    virtual void visit(const HttpEvent& event) { index = 2; }
+    virtual void visit(const ExitedEvent& event) { index = 3; }
+    virtual void visit(const TerminateEvent& event) { index = 4; }
+
+    size_t index;
+  };
+
+  void increment(const Event* event)
+  {
+    IndexVisitor visitor;
+    event->visit(&visitor);
+    counts[visitor.index].fetch_add(1);
+  }
+
+  void decrement(const Event* event)
+  {
+    IndexVisitor visitor;
+    event->visit(&visitor);
+    counts[visitor.index].fetch_sub(1);
+  }
+
+  Stub stub;
+
+  // Producers append at the 'head', the consumer removes from the
+  // 'tail' (which is therefore not atomic).
+  std::atomic<Event*> head;
+  Event* tail;
+
+  std::atomic_size_t size_;
+  std::atomic_size_t counts[TYPES];
+
+  // Injected events, protected by 'mutex'.
+  std::mutex mutex;
+  std::deque<Event*> front;
+  std::atomic_size_t injected;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_EVENT_QUEUE_HPP__
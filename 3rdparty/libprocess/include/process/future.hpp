@@ -63,6 +63,50 @@ struct wrap;
 template <typename T>
 struct unwrap;
 
+
+// A list of callbacks which stores the first callback inline, since
+// most futures get at most one callback of each kind, and only
+// allocates for the subsequent ones.
+template <typename C>
+class Callbacks
+{
+public:
+  Callbacks() : count(0) {}
+
+  void push_back(C&& callback)
+  {
+    if (count == 0) {
+      first = std::move(callback);
+    } else {
+      rest.push_back(std::move(callback));
+    }
+
+    ++count;
+  }
+
+  size_t size() const { return count; }
+
+  bool empty() const { return count == 0; }
+
+  const C& operator[](size_t i) const
+  {
+    return i == 0 ? first : rest[i - 1];
+  }
+
+  void clear()
+  {
+    // Assigning an empty callback releases whatever it captured.
+    first = C();
+    rest.clear();
+    count = 0;
+  }
+
+private:
+  C first;
+  std::vector<C> rest;
+  size_t count;
+};
+
 } // namespace internal {
 
 
@@ -452,11 +496,11 @@ private:
     //   3. Error, the state is FAILED; 'error()' stores the message.
     Result<T> result;
 
-    std::vector<DiscardCallback> onDiscardCallbacks;
-    std::vector<ReadyCallback> onReadyCallbacks;
-    std::vector<FailedCallback> onFailedCallbacks;
-    std::vector<DiscardedCallback> onDiscardedCallbacks;
-    std::vector<AnyCallback> onAnyCallbacks;
+    internal::Callbacks<DiscardCallback> onDiscardCallbacks;
+    internal::Callbacks<ReadyCallback> onReadyCallbacks;
+    internal::Callbacks<FailedCallback> onFailedCallbacks;
+    internal::Callbacks<DiscardedCallback> onDiscardedCallbacks;
+    internal::Callbacks<AnyCallback> onAnyCallbacks;
   };
 
   // Sets the value for this future, unless the future is already set,
@@ -477,7 +521,7 @@ namespace internal {
 //
 // TODO(*): Invoke callbacks in another execution context.
 template <typename C, typename... Arguments>
-void run(const std::vector<C>& callbacks, Arguments&&... arguments)
+void run(const Callbacks<C>& callbacks, Arguments&&... arguments)
 {
   for (size_t i = 0; i < callbacks.size(); ++i) {
     callbacks[i](std::forward<Arguments>(arguments)...);
@@ -882,12 +926,12 @@ void Future<T>::Data::clearAllCallbacks()
 
 template <typename T>
 Future<T>::Future()
-  : data(new Data()) {}
+  : data(std::make_shared<Data>()) {}
 
 
 template <typename T>
 Future<T>::Future(const T& _t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(_t);
 }
@@ -896,7 +940,7 @@ Future<T>::Future(const T& _t)
 template <typename T>
 template <typename U>
 Future<T>::Future(const U& u)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(u);
 }
@@ -904,7 +948,7 @@ Future<T>::Future(const U& u)
 
 template <typename T>
 Future<T>::Future(const Failure& failure)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   fail(failure.message);
 }
@@ -922,7 +966,7 @@ Future<T>::Future(Future<T>&& that)
 
 template <typename T>
 Future<T>::Future(const Try<T>& t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   if (t.isSome()){
     set(t.get());
@@ -968,12 +1012,12 @@ bool Future<T>::discard()
 {
   bool result = false;
 
-  std::vector<DiscardCallback> callbacks;
+  internal::Callbacks<DiscardCallback> callbacks;
   synchronized (data->lock) {
     if (!data->discard && data->state == PENDING) {
       result = data->discard = true;
 
-      // NOTE: We make a copy of the onDiscard callbacks here
+      // NOTE: We move the onDiscard callbacks out of here
       // because it is possible that another thread completes this
       // future (ready, failed or discarded) when the current thread
       // is out of this critical section but *before* it executed the
@@ -981,7 +1025,7 @@ bool Future<T>::discard()
       // be clearing the onDiscard callbacks (via clearAllCallbacks())
       // while the current thread is executing or clearing the
       // onDiscard callbacks, causing thread safety issue.
-      callbacks = data->onDiscardCallbacks;
+      callbacks = std::move(data->onDiscardCallbacks);
       data->onDiscardCallbacks.clear();
     }
   }
@@ -1124,7 +1168,7 @@ const Future<T>& Future<T>::onDiscard(DiscardCallback&& callback) const
     if (data->discard) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onDiscardCallbacks.emplace_back(std::move(callback));
+      data->onDiscardCallbacks.push_back(std::move(callback));
     }
   }
 
@@ -1146,7 +1190,7 @@ const Future<T>& Future<T>::onReady(ReadyCallback&& callback) const
     if (data->state == READY) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onReadyCallbacks.emplace_back(std::move(callback));
+      data->onReadyCallbacks.push_back(std::move(callback));
     }
   }
 
@@ -1168,7 +1212,7 @@ const Future<T>& Future<T>::onFailed(FailedCallback&& callback) const
     if (data->state == FAILED) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onFailedCallbacks.emplace_back(std::move(callback));
+      data->onFailedCallbacks.push_back(std::move(callback));
     }
   }
 
@@ -1190,7 +1234,7 @@ const Future<T>& Future<T>::onDiscarded(DiscardedCallback&& callback) const
     if (data->state == DISCARDED) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onDiscardedCallbacks.emplace_back(std::move(callback));
+      data->onDiscardedCallbacks.push_back(std::move(callback));
     }
   }
 
@@ -1210,7 +1254,7 @@ const Future<T>& Future<T>::onAny(AnyCallback&& callback) const
 
   synchronized (data->lock) {
     if (data->state == PENDING) {
-      data->onAnyCallbacks.emplace_back(std::move(callback));
+      data->onAnyCallbacks.push_back(std::move(callback));
     } else {
       run = true;
     }
@@ -506,6 +506,12 @@ struct Accepted : Response
 };
 
 
+struct NotModified : Response
+{
+  NotModified() : Response(Status::NOT_MODIFIED) {}
+};
+
+
 struct TemporaryRedirect : Response
 {
   explicit TemporaryRedirect(const std::string& url)
@@ -791,6 +797,13 @@ Future<Connection> connect(const URL& url);
 
 // TODO(joerg84): Make names consistent (see Mesos-3256).
 
+// NOTE: The functions returning responses of type 'BODY' send the
+// request over a keep-alive connection, which is kept idle (for up to
+// 15 seconds, and at most 8 connections per server) once the response
+// is received so that the next request to the same scheme, host and
+// port can reuse it. Idempotent requests which fail on a reused
+// connection are retried once over a new connection.
+
 // Asynchronously sends an HTTP GET request to the specified URL
 // and returns the HTTP response of type 'BODY' once the entire
 // response is received.
@@ -14,6 +14,7 @@
 #define __PROCESS_IO_HPP__
 
 #include <cstring> // For size_t.
+#include <memory>
 #include <string>
 
 #include <process/future.hpp>
@@ -42,6 +43,62 @@ const short WRITE = 0x02;
  */
 const size_t BUFFERED_READ_SIZE = 16*4096;
 
+
+/**
+ * A read-only slice of a reference counted buffer, as read by
+ * io::read(int, size_t). Copies (and slices) share the underlying
+ * buffer rather than copying the data, so a buffer can be handed to
+ * a decoder or written out with io::write without any copying. The
+ * buffers of BUFFERED_READ_SIZE are pooled, i.e., they get reused
+ * once the last slice referring to them is destroyed.
+ */
+class Buffer
+{
+public:
+  Buffer() : data_(NULL), size_(0) {}
+
+  Buffer(
+      const std::shared_ptr<char>& _buffer,
+      const char* _data,
+      size_t _size)
+    : buffer(_buffer), data_(_data), size_(_size) {}
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * Returns the slice of 'length' bytes (or less, if this slice is not
+   * large enough) starting at 'offset', sharing the same buffer.
+   */
+  Buffer slice(size_t offset, size_t length = std::string::npos) const
+  {
+    offset = offset < size_ ? offset : size_;
+    length = length < size_ - offset ? length : size_ - offset;
+    return Buffer(buffer, data_ + offset, length);
+  }
+
+  /**
+   * Returns a copy of the data.
+   */
+  std::string string() const
+  {
+    return size_ == 0 ? std::string() : std::string(data_, size_);
+  }
+
+  /**
+   * Returns a buffer of BUFFERED_READ_SIZE from the pool, allocating
+   * one if none is available.
+   */
+  static std::shared_ptr<char> allocate();
+
+private:
+  std::shared_ptr<char> buffer;
+  const char* data_;
+  size_t size_;
+};
+
+
 /**
  * Returns the events (a subset of the events specified) that can be
  * performed on the specified file descriptor without blocking.
@@ -80,6 +137,20 @@ Future<size_t> read(int fd, void* data, size_t size);
 Future<std::string> read(int fd);
 
 
+/**
+ * Performs a single non-blocking read, like io::read(int, void*,
+ * size_t), into a buffer from the pool rather than a buffer that is
+ * supplied by the caller.
+ *
+ * @param fd file descriptor.
+ * @param size maximum number of bytes to read, which is bounded by
+ *     BUFFERED_READ_SIZE.
+ * @return The bytes read, or an empty buffer on EOF.
+ *     A failure will be returned if an error is detected.
+ */
+Future<Buffer> read(int fd, size_t size);
+
+
 /**
  * Performs a single non-blocking write by polling on the specified
  * file descriptor until data can be be written.
@@ -106,6 +177,19 @@ Future<size_t> write(int fd, const void* data, size_t size);
  */
 Future<Nothing> write(int fd, const std::string& data);
 
+
+/**
+ * Performs a series of asynchronous writes, until all of the buffer
+ * has been written, like io::write(int, const std::string&) but
+ * without copying the data.
+ *
+ * @return Nothing or a failure if an error occured.
+ *     A failure will be returned if the file descriptor is bad, or if the
+ *     file descriptor cannot be duplicated, set to close-on-exec,
+ *     or made non-blocking.
+ */
+Future<Nothing> write(int fd, const Buffer& data);
+
 /**
  * Redirect output from the 'from' file descriptor to the 'to' file
  * descriptor (or /dev/null if 'to' is None).
@@ -13,15 +13,20 @@
 #ifndef __PROCESS_LIMITER_HPP__
 #define __PROCESS_LIMITER_HPP__
 
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
 #include <deque>
 
+#include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
 #include <process/future.hpp>
 #include <process/process.hpp>
-#include <process/timeout.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
@@ -47,7 +52,9 @@ public:
   virtual ~RateLimiter();
 
   // Returns a future that becomes ready when the permit is acquired.
-  // Discarding this future cancels this acquisition.
+  // Discarding this future cancels this acquisition. When a permit
+  // is available and no other acquisition is waiting, the returned
+  // future is already ready (without dispatching to the process).
   virtual Future<Nothing> acquire();
 
 private:
@@ -63,18 +70,24 @@ class RateLimiterProcess : public Process<RateLimiterProcess>
 {
 public:
   RateLimiterProcess(int permits, const Duration& duration)
-    : ProcessBase(ID::generate("__limiter__"))
+    : ProcessBase(ID::generate("__limiter__")),
+      next(0),
+      waiting(0)
   {
     CHECK_GT(permits, 0);
     CHECK_GT(duration.secs(), 0);
     permitsPerSecond = permits / duration.secs();
+    interval = (Seconds(1) / permitsPerSecond).ns();
   }
 
   explicit RateLimiterProcess(double _permitsPerSecond)
     : ProcessBase(ID::generate("__limiter__")),
-      permitsPerSecond(_permitsPerSecond)
+      permitsPerSecond(_permitsPerSecond),
+      next(0),
+      waiting(0)
   {
     CHECK_GT(permitsPerSecond, 0);
+    interval = (Seconds(1) / permitsPerSecond).ns();
   }
 
   virtual void finalize()
@@ -86,28 +99,41 @@ public:
     promises.clear();
   }
 
+  // Takes a permit if one is available and no acquisition is waiting
+  // for one, otherwise the acquisition is counted as waiting and the
+  // caller must 'acquire' through the process, so that the permits
+  // are handed out in order. This is lock free and can be called
+  // from any thread.
+  bool tryAcquire()
+  {
+    if (waiting.load() == 0 && take()) {
+      return true;
+    }
+
+    waiting.fetch_add(1);
+    return false;
+  }
+
+  // Acquires a permit for an acquisition which 'tryAcquire' counted
+  // as waiting.
   Future<Nothing> acquire()
   {
-    if (!promises.empty()) {
-      // Need to wait for others to get permits first.
-      Promise<Nothing>* promise = new Promise<Nothing>();
-      promises.push_back(promise);
-      return promise->future()
-        .onDiscard(defer(self(), &Self::discard, promise->future()));
+    if (promises.empty() && take()) {
+      waiting.fetch_sub(1);
+      return Nothing();
     }
 
-    if (timeout.remaining() > Seconds(0)) {
-      // Need to wait a bit longer, but first one in the queue.
-      Promise<Nothing>* promise = new Promise<Nothing>();
-      promises.push_back(promise);
-      delay(timeout.remaining(), self(), &Self::_acquire);
-      return promise->future()
-        .onDiscard(defer(self(), &Self::discard, promise->future()));
+    // Need to wait, either for a permit or for others to get
+    // permits first.
+    Promise<Nothing>* promise = new Promise<Nothing>();
+    promises.push_back(promise);
+
+    if (promises.size() == 1) {
+      delay(remaining(), self(), &Self::_acquire);
     }
 
-    // No need to wait!
-    timeout = Seconds(1) / permitsPerSecond;
-    return Nothing();
+    return promise->future()
+      .onDiscard(defer(self(), &Self::discard, promise->future()));
   }
 
 private:
@@ -115,28 +141,64 @@ private:
   RateLimiterProcess(const RateLimiterProcess&);
   RateLimiterProcess& operator=(const RateLimiterProcess&);
 
+  // The permits are a token bucket holding (at most) a single token,
+  // i.e., 'next' is the time (in nanoseconds) at which the next permit
+  // becomes available. The global clock is used, rather than the
+  // clock of the calling process, since permits are taken from other
+  // processes.
+  static int64_t now()
+  {
+    return Clock::now(NULL).duration().ns();
+  }
+
+  bool take()
+  {
+    const int64_t now_ = now();
+
+    int64_t next_ = next.load();
+    while (next_ <= now_) {
+      if (next.compare_exchange_weak(next_, now_ + interval)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  Duration remaining() const
+  {
+    return Nanoseconds(std::max<int64_t>(next.load() - now(), 0));
+  }
+
   void _acquire()
   {
     CHECK(!promises.empty());
 
     // Keep removing the top of the queue until we find a promise
-    // whose future is not discarded.
+    // whose future is not discarded, or run out of permits.
     while (!promises.empty()) {
       Promise<Nothing>* promise = promises.front();
-      promises.pop_front();
-      if (!promise->future().isDiscarded()) {
-        promise->set(Nothing());
+      if (promise->future().isDiscarded()) {
+        promises.pop_front();
         delete promise;
-        timeout = Seconds(1) / permitsPerSecond;
+        waiting.fetch_sub(1);
+        continue;
+      }
+
+      if (!take()) {
         break;
-      } else {
-        delete promise;
       }
+
+      promises.pop_front();
+      promise->set(Nothing());
+      delete promise;
+      waiting.fetch_sub(1);
+      break;
     }
 
     // Repeat if necessary.
     if (!promises.empty()) {
-      delay(timeout.remaining(), self(), &Self::_acquire);
+      delay(remaining(), self(), &Self::_acquire);
     }
   }
 
@@ -150,8 +212,12 @@ private:
   }
 
   double permitsPerSecond;
+  int64_t interval;
 
-  Timeout timeout;
+  std::atomic<int64_t> next;
+
+  // The number of acquisitions which have not got a permit yet.
+  std::atomic<size_t> waiting;
 
   std::deque<Promise<Nothing>*> promises;
 };
@@ -181,6 +247,10 @@ inline RateLimiter::~RateLimiter()
 
 inline Future<Nothing> RateLimiter::acquire()
 {
+  if (process->tryAcquire()) {
+    return Nothing();
+  }
+
   return dispatch(process, &RateLimiterProcess::acquire);
 }
 
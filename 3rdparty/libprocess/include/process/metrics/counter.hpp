@@ -18,6 +18,8 @@
 
 #include <process/metrics/metric.hpp>
 
+#include <stout/option.hpp>
+
 namespace process {
 namespace metrics {
 
@@ -43,6 +45,11 @@ public:
     return static_cast<double>(data->value.load());
   }
 
+  virtual Option<double> current() const
+  {
+    return static_cast<double>(data->value.load());
+  }
+
   void reset()
   {
     data->value.store(0);
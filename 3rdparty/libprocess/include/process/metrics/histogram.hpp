@@ -0,0 +1,246 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_METRICS_HISTOGRAM_HPP__
+#define __PROCESS_METRICS_HISTOGRAM_HPP__
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include <process/future.hpp>
+#include <process/statistics.hpp>
+
+#include <process/metrics/metric.hpp>
+
+#include <stout/option.hpp>
+
+namespace process {
+namespace metrics {
+
+// A Metric that represents the distribution of the (non-negative)
+// values recorded into it. Rather than keeping the values, like the
+// window of a Counter or Timer, each value is counted in one of a
+// fixed set of logarithmic buckets: every power of two between
+// 2^MIN_EXPONENT and 2^MAX_EXPONENT is split into SUB_BUCKETS equal
+// buckets, so the percentiles are estimated with a relative error of
+// at most 1 / SUB_BUCKETS. Recording is O(1) and lock free, and the
+// histograms of the same metric can be merged by adding up their
+// buckets. The value of the Histogram is the number of values
+// recorded into it.
+class Histogram : public Metric
+{
+public:
+  static const int MIN_EXPONENT = -20;
+  static const int MAX_EXPONENT = 44;
+  static const int SUB_BUCKETS = 8;
+
+  // The first bucket counts the values that are zero (or less), the
+  // others are the logarithmic buckets.
+  static const size_t BUCKETS =
+    1 + (MAX_EXPONENT - MIN_EXPONENT) * SUB_BUCKETS;
+
+  // 'name' is the unique name for the instance of Histogram being
+  // constructed. It will be the key exposed in the JSON endpoint.
+  explicit Histogram(const std::string& name)
+    : Metric(name, None()),
+      data(new Data()) {}
+
+  virtual ~Histogram() {}
+
+  virtual Future<double> value() const
+  {
+    return static_cast<double>(count());
+  }
+
+  virtual Option<double> current() const
+  {
+    return static_cast<double>(count());
+  }
+
+  // Returns the percentiles estimated from the buckets, or None if
+  // fewer than two values were recorded (like for a TimeSeries).
+  virtual Option<Statistics<double>> statistics() const
+  {
+    const uint64_t count_ = count();
+    if (count_ < 2) {
+      return None();
+    }
+
+    Statistics<double> statistics;
+    statistics.count = count_;
+    statistics.min = data->min.load();
+    statistics.max = data->max.load();
+    statistics.p50 = percentile(0.5);
+    statistics.p90 = percentile(0.90);
+    statistics.p95 = percentile(0.95);
+    statistics.p99 = percentile(0.99);
+    statistics.p999 = percentile(0.999);
+    statistics.p9999 = percentile(0.9999);
+
+    return statistics;
+  }
+
+  void record(double value)
+  {
+    data->buckets[bucket(value)].fetch_add(1);
+
+    add(&data->sum, value);
+    update(&data->min, value, [](double a, double b) { return a < b; });
+    update(&data->max, value, [](double a, double b) { return a > b; });
+  }
+
+  // Adds the values recorded into 'that' to this histogram.
+  void merge(const Histogram& that)
+  {
+    for (size_t i = 0; i < BUCKETS; i++) {
+      data->buckets[i].fetch_add(that.data->buckets[i].load());
+    }
+
+    add(&data->sum, that.data->sum.load());
+
+    if (that.count() > 0) {
+      double min = that.data->min.load();
+      double max = that.data->max.load();
+      update(&data->min, min, [](double a, double b) { return a < b; });
+      update(&data->max, max, [](double a, double b) { return a > b; });
+    }
+  }
+
+  // Returns the number of values counted in the given bucket.
+  uint64_t count(size_t bucket) const
+  {
+    return data->buckets[bucket].load();
+  }
+
+  // Returns the number of values recorded.
+  uint64_t count() const
+  {
+    uint64_t count = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+      count += data->buckets[i].load();
+    }
+    return count;
+  }
+
+  // Returns the sum of the values recorded.
+  double sum() const
+  {
+    return data->sum.load();
+  }
+
+  // Returns the bucket which counts 'value'.
+  static size_t bucket(double value)
+  {
+    if (!(value > 0)) {
+      return 0;
+    }
+
+    // 'value' is 'fraction' * 2^'exponent', 0.5 <= 'fraction' < 1.
+    int exponent;
+    const double fraction = frexp(value, &exponent);
+    exponent -= 1;
+
+    if (exponent < MIN_EXPONENT) {
+      return 1;
+    } else if (exponent >= MAX_EXPONENT) {
+      return BUCKETS - 1;
+    }
+
+    const size_t sub = static_cast<size_t>((fraction * 2 - 1) * SUB_BUCKETS);
+
+    return 1 + (exponent - MIN_EXPONENT) * SUB_BUCKETS +
+           std::min(sub, static_cast<size_t>(SUB_BUCKETS - 1));
+  }
+
+  // Returns the (exclusive) upper bound of the values counted in the
+  // given bucket. The last bucket also counts all the larger values.
+  static double upper(size_t bucket)
+  {
+    if (bucket == 0) {
+      return 0;
+    }
+
+    const int exponent =
+      MIN_EXPONENT + static_cast<int>((bucket - 1) / SUB_BUCKETS);
+    const size_t sub = (bucket - 1) % SUB_BUCKETS;
+
+    return ldexp(1 + static_cast<double>(sub + 1) / SUB_BUCKETS, exponent);
+  }
+
+private:
+  // Returns the estimated 'p'th percentile, i.e., the middle of the
+  // bucket holding it, bounded by the extremes.
+  double percentile(double p) const
+  {
+    const uint64_t count_ = count();
+    const uint64_t rank = static_cast<uint64_t>(ceil(p * count_));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+      seen += data->buckets[i].load();
+      if (seen >= rank && seen > 0) {
+        const double lower = i <= 1 ? 0 : upper(i - 1);
+        const double estimate = (lower + upper(i)) / 2;
+        return std::min(
+            std::max(estimate, data->min.load()),
+            data->max.load());
+      }
+    }
+
+    return data->max.load();
+  }
+
+  static void add(std::atomic<double>* target, double value)
+  {
+    double current = target->load();
+    while (!target->compare_exchange_weak(current, current + value)) {}
+  }
+
+  template <typename F>
+  static void update(std::atomic<double>* target, double value, F&& better)
+  {
+    double current = target->load();
+    while (better(value, current) &&
+           !target->compare_exchange_weak(current, value)) {}
+  }
+
+  struct Data
+  {
+    Data()
+      : sum(0),
+        min(std::numeric_limits<double>::infinity()),
+        max(-std::numeric_limits<double>::infinity())
+    {
+      for (size_t i = 0; i < BUCKETS; i++) {
+        buckets[i].store(0);
+      }
+    }
+
+    std::atomic<uint64_t> buckets[BUCKETS];
+    std::atomic<double> sum;
+    std::atomic<double> min;
+    std::atomic<double> max;
+  };
+
+  std::shared_ptr<Data> data;
+};
+
+} // namespace metrics {
+} // namespace process {
+
+#endif // __PROCESS_METRICS_HISTOGRAM_HPP__
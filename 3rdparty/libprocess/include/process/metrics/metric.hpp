@@ -36,12 +36,20 @@ public:
 
   virtual Future<double> value() const = 0;
 
+  // Returns the value if it can be read directly, i.e., without
+  // dispatching to the owner of the metric (as a Gauge does), or None
+  // if it has to be evaluated with 'value'. This lets a snapshot skip
+  // the futures of the metrics which hold their value.
+  virtual Option<double> current() const { return None(); }
+
   const std::string& name() const
   {
     return data->name;
   }
 
-  Option<Statistics<double>> statistics() const
+  // Returns the statistics of the recent values of the metric, or
+  // None if it keeps no history.
+  virtual Option<Statistics<double>> statistics() const
   {
     Option<Statistics<double>> statistics = None();
 
@@ -14,16 +14,20 @@
 #define __PROCESS_METRICS_METRICS_HPP__
 
 #include <string>
+#include <utility>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/limiter.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/time.hpp>
 
 #include <process/metrics/metric.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 
@@ -41,15 +45,21 @@ public:
 
   Future<Nothing> remove(const std::string& name);
 
+  // Returns the metrics which are currently added, e.g., for pushing
+  // them (see LIBPROCESS_METRICS_STATSD_ADDRESS).
+  hashmap<std::string, Owned<Metric>> registered();
+
 protected:
   virtual void initialize();
 
 private:
   static std::string help();
+  static std::string prometheusHelp();
 
   MetricsProcess()
     : ProcessBase("metrics"),
-      limiter(2, Seconds(1))
+      limiter(2, Seconds(1)),
+      ttl(Duration::zero())
   {}
 
   // Non-copyable, non-assignable.
@@ -57,12 +67,23 @@ private:
   MetricsProcess& operator=(const MetricsProcess&);
 
   Future<http::Response> snapshot(const http::Request& request);
-  Future<http::Response> _snapshot(const http::Request& request);
+  Future<http::Response> prometheus(const http::Request& request);
+
+  // Collects the metrics, and renders them either as a JSON object
+  // or in the Prometheus text exposition format.
+  Future<http::Response> _snapshot(
+      const http::Request& request,
+      bool prometheus);
   static std::list<Future<double> > _snapshotTimeout(
       const std::list<Future<double> >& futures);
-  static Future<http::Response> __snapshot(
+  http::Response __snapshot(
       const http::Request& request,
       const Option<Duration>& timeout,
+      const hashmap<std::string, double>& values,
+      const hashmap<std::string, Future<double> >& metrics,
+      const hashmap<std::string, Option<Statistics<double> > >& statistics);
+  http::Response __prometheus(
+      const hashmap<std::string, double>& values,
       const hashmap<std::string, Future<double> >& metrics,
       const hashmap<std::string, Option<Statistics<double> > >& statistics);
 
@@ -71,6 +92,14 @@ private:
 
   // Used to rate limit the endpoint.
   RateLimiter limiter;
+
+  // For how long a complete snapshot is served to the following
+  // requests, so that scrapers polling at about the same time share
+  // one collection (see LIBPROCESS_METRICS_SNAPSHOT_TTL).
+  Duration ttl;
+
+  // The last complete snapshot and when it was collected.
+  Option<std::pair<Time, JSON::Object>> cache;
 };
 
 }  // namespace internal {
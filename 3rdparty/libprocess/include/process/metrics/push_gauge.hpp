@@ -0,0 +1,75 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_METRICS_PUSH_GAUGE_HPP__
+#define __PROCESS_METRICS_PUSH_GAUGE_HPP__
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <process/metrics/metric.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/option.hpp>
+
+namespace process {
+namespace metrics {
+
+// A Metric that represents an instantaneous value which, unlike a
+// Gauge, is set by its owner whenever it changes rather than
+// evaluated when 'value' is called. When a window is given, the
+// statistics are computed over the values that were set.
+class PushGauge : public Metric
+{
+public:
+  // 'name' is the unique name for the instance of PushGauge being
+  // constructed. It will be the key exposed in the JSON endpoint.
+  // 'window' is the amount of history to keep for this Metric.
+  PushGauge(const std::string& name, const Option<Duration>& window = None())
+    : Metric(name, window),
+      data(new Data()) {}
+
+  virtual ~PushGauge() {}
+
+  virtual Future<double> value() const
+  {
+    return static_cast<double>(data->value.load());
+  }
+
+  virtual Option<double> current() const
+  {
+    return static_cast<double>(data->value.load());
+  }
+
+  PushGauge& operator=(int64_t v)
+  {
+    data->value.store(v);
+    push(v);
+    return *this;
+  }
+
+private:
+  struct Data
+  {
+    explicit Data() : value(0) {}
+
+    std::atomic<int64_t> value;
+  };
+
+  std::shared_ptr<Data> data;
+};
+
+} // namespace metrics {
+} // namespace process {
+
+#endif // __PROCESS_METRICS_PUSH_GAUGE_HPP__
@@ -57,6 +57,17 @@ public:
     return value;
   }
 
+  Option<double> current() const
+  {
+    Option<double> value;
+
+    synchronized (data->lock) {
+      value = data->lastValue;
+    }
+
+    return value;
+  }
+
   // Start the Timer.
   void start()
   {
@@ -15,12 +15,17 @@
 
 #include <atomic>
 #include <memory>
-#include <queue>
+#include <string>
 
+#include <process/clock.hpp>
 #include <process/future.hpp>
-#include <process/owned.hpp>
+#include <process/time.hpp>
+
+#include <process/metrics/histogram.hpp>
+#include <process/metrics/metrics.hpp>
 
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/synchronized.hpp>
 
 namespace process {
@@ -30,53 +35,137 @@ class Mutex
 public:
   Mutex() : data(new Data()) {}
 
+  // Creates a mutex which exposes how contended it is through the
+  // metrics '<name>/wait_time_ms' (how long each waiter waited for
+  // the mutex) and '<name>/queue_depth' (how many waiters were
+  // queued, including the new one, whenever one had to wait).
+  explicit Mutex(const std::string& name) : data(new Data(name)) {}
+
   Future<Nothing> lock()
   {
     Future<Nothing> future = Nothing();
+    Option<size_t> depth;
 
     synchronized (data->lock) {
       if (!data->locked) {
         data->locked = true;
       } else {
-        Owned<Promise<Nothing>> promise(new Promise<Nothing>());
-        data->promises.push(promise);
-        future = promise->future();
+        Waiter* waiter = new Waiter();
+        future = waiter->promise.future();
+
+        if (data->waits.isSome()) {
+          waiter->enqueued = Clock::now();
+        }
+
+        if (data->tail == NULL) {
+          data->head = waiter;
+        } else {
+          data->tail->next = waiter;
+        }
+        data->tail = waiter;
+
+        depth = ++data->depth;
       }
     }
 
+    if (depth.isSome() && data->depths.isSome()) {
+      data->depths->record(depth.get());
+    }
+
     return future;
   }
 
   void unlock()
   {
-    // NOTE: We need to grab the promise 'date->promises.front()' but
-    // set it outside of the critical section because setting it might
-    // trigger callbacks that try to reacquire the lock.
-    Owned<Promise<Nothing>> promise;
+    // NOTE: We need to grab the waiter at the head of the queue but
+    // set its promise outside of the critical section because setting
+    // it might trigger callbacks that try to reacquire the lock. The
+    // waiters whose future has been discarded are skipped, rather than
+    // making them hold the mutex that nobody would ever unlock.
+    Waiter* waiter = NULL;
+    Waiter* discarded = NULL;
 
     synchronized (data->lock) {
-      if (!data->promises.empty()) {
-        // TODO(benh): Skip a future that has been discarded?
-        promise = data->promises.front();
-        data->promises.pop();
-      } else {
+      while (data->head != NULL) {
+        waiter = data->head;
+        data->head = waiter->next;
+        if (data->head == NULL) {
+          data->tail = NULL;
+        }
+        data->depth--;
+
+        if (!waiter->promise.future().hasDiscard()) {
+          break;
+        }
+
+        waiter->next = discarded;
+        discarded = waiter;
+        waiter = NULL;
+      }
+
+      if (waiter == NULL) {
         data->locked = false;
       }
     }
 
-    if (promise.get() != NULL) {
-      promise->set(Nothing());
+    while (discarded != NULL) {
+      Waiter* next = discarded->next;
+      discarded->promise.discard();
+      delete discarded;
+      discarded = next;
+    }
+
+    if (waiter != NULL) {
+      if (waiter->enqueued.isSome() && data->waits.isSome()) {
+        data->waits->record((Clock::now() - waiter->enqueued.get()).ms());
+      }
+
+      waiter->promise.set(Nothing());
+      delete waiter;
     }
   }
 
 private:
+  // A waiter for the mutex, which is queued in an intrusive list so
+  // that waiting only takes a single allocation.
+  struct Waiter
+  {
+    Waiter() : next(NULL) {}
+
+    Promise<Nothing> promise;
+    Option<Time> enqueued;
+    Waiter* next;
+  };
+
   struct Data
   {
-    Data() : locked(false) {}
+    Data() : locked(false), head(NULL), tail(NULL), depth(0) {}
+
+    explicit Data(const std::string& name)
+      : locked(false),
+        head(NULL),
+        tail(NULL),
+        depth(0),
+        waits(metrics::Histogram(name + "/wait_time_ms")),
+        depths(metrics::Histogram(name + "/queue_depth"))
+    {
+      metrics::add(waits.get());
+      metrics::add(depths.get());
+    }
 
     ~Data()
     {
       // TODO(benh): Fail promises?
+      while (head != NULL) {
+        Waiter* next = head->next;
+        delete head;
+        head = next;
+      }
+
+      if (waits.isSome()) {
+        metrics::remove(waits.get());
+        metrics::remove(depths.get());
+      }
     }
 
     // Rather than use a process to serialize access to the mutex's
@@ -87,7 +176,13 @@ private:
     bool locked;
 
     // Represents "waiters" for this lock.
-    std::queue<Owned<Promise<Nothing>>> promises;
+    Waiter* head;
+    Waiter* tail;
+    size_t depth;
+
+    // The contention metrics, if the mutex has a name.
+    Option<metrics::Histogram> waits;
+    Option<metrics::Histogram> depths;
   };
 
   std::shared_ptr<Data> data;
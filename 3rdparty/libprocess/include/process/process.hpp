@@ -22,6 +22,7 @@
 #include <process/address.hpp>
 #include <process/clock.hpp>
 #include <process/event.hpp>
+#include <process/event_queue.hpp>
 #include <process/filter.hpp>
 #include <process/firewall.hpp>
 #include <process/http.hpp>
@@ -38,9 +39,13 @@
 
 namespace process {
 
-// Forward declaration.
+// Forward declarations.
 class Sequence;
 
+namespace metrics {
+class PushGauge;
+} // namespace metrics {
+
 namespace firewall {
 
 /**
@@ -89,6 +94,17 @@ protected:
   virtual void visit(const ExitedEvent& event);
   virtual void visit(const TerminateEvent& event);
 
+  /**
+   * Invoked with a batch of consecutive messages that have the same
+   * name, in the order they were received, for messages that batching
+   * was enabled for.
+   *
+   * The default implementation visits each of the events in turn.
+   *
+   * @see process::ProcessBase::batch
+   */
+  virtual void visit(const std::vector<const MessageEvent*>& events);
+
   /**
    * Invoked when a process gets spawned.
    */
@@ -189,6 +205,20 @@ protected:
     install(name, handler);
   }
 
+  /**
+   * Enables batching of messages with the specified name: rather than
+   * being visited one at a time, up to `size` such messages that are
+   * queued one after another get visited as a batch. This lets a
+   * process amortize work across messages (e.g., persisting the
+   * effect of many messages with a single write).
+   *
+   * The sizes of the batches are exposed as the metric
+   * `<process id>/batch_size/<name>`.
+   *
+   * @see process::ProcessBase::visit(const std::vector<const MessageEvent*>&)
+   */
+  void batch(const std::string& name, size_t size);
+
   /**
    * Delegates incoming messages, with the specified name, to the `UPID`.
    */
@@ -317,13 +347,7 @@ protected:
   template <typename T>
   size_t eventCount()
   {
-    size_t count = 0U;
-
-    synchronized (mutex) {
-      count = std::count_if(events.begin(), events.end(), isEventType<T>);
-    }
-
-    return count;
+    return events.count<T>();
   }
 
 private:
@@ -333,7 +357,7 @@ private:
   friend void* schedule(void*);
 
   // Process states.
-  enum
+  enum ProcessState
   {
     BOTTOM,
     READY,
@@ -341,13 +365,12 @@ private:
     BLOCKED,
     TERMINATING,
     TERMINATED
-  } state;
+  };
 
-  template <typename T>
-  static bool isEventType(const Event* event)
-  {
-    return event->is<T>();
-  }
+  // NOTE: Only a thread running the process transitions the state,
+  // except for producers of events which transition a BLOCKED process
+  // to READY (see 'enqueue').
+  std::atomic<ProcessState> state;
 
   // Mutex protecting internals.
   // TODO(benh): Consider replacing with a spinlock, on multi-core systems.
@@ -359,6 +382,17 @@ private:
   // Delegates for messages.
   std::map<std::string, UPID> delegates;
 
+  // Messages that are visited in batches (see 'batch').
+  struct Batch
+  {
+    size_t size;
+
+    // The sizes of the batches visited.
+    Owned<metrics::PushGauge> sizes;
+  };
+
+  std::map<std::string, Batch> batches;
+
   // Definition of an HTTP endpoint. The endpoint can be
   // associated with an authentication realm, in which case:
   //
@@ -402,12 +436,27 @@ private:
   // Static assets(s) to provide.
   std::map<std::string, Asset> assets;
 
-  // Queue of received events, requires lock()ed access!
-  std::deque<Event*> events;
+  // Queue of received events.
+  EventQueue events;
+
+  // Number of threads currently in 'enqueue', used to make sure no
+  // more events get enqueued once the process is terminating.
+  std::atomic_long enqueuers;
 
   // Active references.
   std::atomic_long refs;
 
+  // Index of the worker thread that last resumed this process, or -1
+  // if it has not run yet. Used by the ProcessManager as an affinity
+  // hint when work stealing is enabled.
+  std::atomic_int worker;
+
+  // Statistics of the events served by the process, only collected
+  // if LIBPROCESS_INSTRUMENT_EVENTS was set when it was created
+  // (defined in process.cpp).
+  struct Instrumentation;
+  Owned<Instrumentation> instrumentation;
+
   // Process PID.
   UPID pid;
 };
@@ -17,14 +17,17 @@
 
 #include <process/future.hpp>
 #include <process/http.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/duration.hpp>
+
 namespace process {
 
 class Profiler : public Process<Profiler>
 {
 public:
-  Profiler() : ProcessBase("profiler"), started(false) {}
+  Profiler() : ProcessBase("profiler"), started(false), sampling(false) {}
 
   virtual ~Profiler() {}
 
@@ -33,11 +36,13 @@ protected:
   {
     route("/start", START_HELP(), &Profiler::start);
     route("/stop", STOP_HELP(), &Profiler::stop);
+    route("/actors", ACTORS_HELP(), &Profiler::actors);
   }
 
 private:
   static const std::string START_HELP();
   static const std::string STOP_HELP();
+  static const std::string ACTORS_HELP();
 
   // HTTP endpoints.
 
@@ -49,7 +54,19 @@ private:
   // in the working directory.
   Future<http::Response> stop(const http::Request& request);
 
+  // Samples which processes are running on SIGPROF for 'duration'
+  // (10 seconds by default) and returns the CPU time attributed to
+  // each of them, along with their number of queued events.
+  Future<http::Response> actors(const http::Request& request);
+
+  void _actors(
+      const Duration& duration,
+      Owned<Promise<http::Response>> promise);
+
   bool started;
+
+  // Whether the processes are being sampled for '/actors'.
+  bool sampling;
 };
 
 } // namespace process {
@@ -18,6 +18,7 @@
 #include <google/protobuf/message.h>
 #include <google/protobuf/repeated_field.h>
 
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -422,6 +423,39 @@ protected:
   using process::Process<T>::install;
 
 private:
+  // Parses a message for a handler. Unless it is large, the message is
+  // parsed into the same object every time, rather than into a new
+  // one, since protobuf keeps the memory of the fields it clears
+  // (e.g., the elements of repeated fields and the capacity of
+  // strings) for reuse. This way handling the messages of a type does
+  // not allocate their fields anew each time. It is safe since the
+  // handlers of a process never run concurrently or nested, and they
+  // copy what they keep of a message.
+  template <typename M>
+  static std::shared_ptr<M> parse(T* t, const std::string& data)
+  {
+    // Large messages (e.g., re-registrations) are rare, but their
+    // memory would be kept for as long as the process lives.
+    const size_t MAX_REUSED_SIZE = 64 * 1024;
+
+    if (data.size() > MAX_REUSED_SIZE) {
+      std::shared_ptr<M> m(new M());
+      m->ParseFromString(data);
+      return m;
+    }
+
+    std::shared_ptr<google::protobuf::Message>& message =
+      static_cast<ProtobufProcess<T>*>(t)->messages[M::descriptor()];
+
+    if (!message) {
+      message.reset(new M());
+    }
+
+    message->ParseFromString(data);
+
+    return std::static_pointer_cast<M>(message);
+  }
+
   // Handlers that take the sender as the first argument.
   template <typename M>
   static void handlerM(
@@ -430,8 +464,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(sender, m);
     } else {
@@ -458,8 +492,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(sender, google::protobuf::convert((&m->*p1)()));
     } else {
@@ -479,8 +513,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -504,8 +538,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -532,8 +566,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -563,8 +597,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -597,8 +631,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -622,8 +656,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(m);
     } else {
@@ -650,8 +684,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()));
     } else {
@@ -671,8 +705,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()));
@@ -695,8 +729,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()),
@@ -722,8 +756,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()),
@@ -752,8 +786,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()),
@@ -785,8 +819,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    std::shared_ptr<M> parsed = parse<M>(t, data);
+    const M& m = *parsed;
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()),
@@ -804,6 +838,10 @@ private:
       void(const process::UPID&, const std::string&)> handler;
   hashmap<std::string, handler> protobufHandlers;
 
+  // The messages reused by 'parse', by type.
+  hashmap<const google::protobuf::Descriptor*,
+          std::shared_ptr<google::protobuf::Message>> messages;
+
   // Sender of "current" message, inaccessible by subclasses.
   // This is only used for reply().
   process::UPID from;
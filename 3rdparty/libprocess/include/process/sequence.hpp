@@ -15,12 +15,20 @@
 
 #include <glog/logging.h>
 
+#include <string>
+
+#include <process/clock.hpp>
+#include <process/defer.hpp>
 #include <process/future.hpp>
-#include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/time.hpp>
+
+#include <process/metrics/histogram.hpp>
+#include <process/metrics/metrics.hpp>
 
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 
 namespace process {
 
@@ -33,6 +41,13 @@ class Sequence
 {
 public:
   Sequence();
+
+  // Creates a sequence which exposes how contended it is through the
+  // metrics '<name>/wait_time_ms' (how long each callback waited for
+  // the previous ones) and '<name>/queue_depth' (how many callbacks
+  // were queued, including the new one, whenever one had to wait).
+  explicit Sequence(const std::string& name);
+
   ~Sequence();
 
   // Registers a callback that will be invoked when all the futures
@@ -62,104 +77,199 @@ private:
 class SequenceProcess : public Process<SequenceProcess>
 {
 public:
-  SequenceProcess() : last(Nothing()) {}
+  SequenceProcess() : current(NULL), head(NULL), tail(NULL), depth(0) {}
+
+  explicit SequenceProcess(const std::string& name)
+    : current(NULL),
+      head(NULL),
+      tail(NULL),
+      depth(0),
+      waits(metrics::Histogram(name + "/wait_time_ms")),
+      depths(metrics::Histogram(name + "/queue_depth")) {}
+
+  virtual ~SequenceProcess()
+  {
+    clear();
+  }
 
   template <typename T>
   Future<T> add(const lambda::function<Future<T>()>& callback)
   {
-    // This is the future that is used to notify the next callback
-    // (denoted by 'N' in the following graph).
-    Owned<Promise<Nothing> > notifier(new Promise<Nothing>());
-
-    // This is the future that will be returned to the user (denoted
-    // by 'F' in the following graph).
-    Owned<Promise<T> > promise(new Promise<T>());
-
-    // We use a graph to show how we hook these futures. Each box in
-    // the graph represents a future. As mentioned above, 'F' denotes
-    // a future that will be returned to the user, and 'N' denotes a
-    // future that is used for notifying the next callback. Each arrow
-    // represents a "notification" relation. We will explain in detail
-    // what "notification" means in the following.
-    //
-    // 'last'                 'last'                            'last'
-    //   |                      |                                 |
-    //   v                      v                                 v
-    // +---+       +---+      +---+       +---+      +---+      +---+
-    // | N |       | N |--+   | N |       | N |--+   | N |--+   | N |
-    // +---+       +---+  |   +---+       +---+  |   +---+  |   +---+
-    //        ==>         |     ^    ==>         |     ^    |     ^
-    //                    |     |                |     |    |     |
-    //                    |   +---+              |   +---+  |   +---+
-    //                    +-->| F |              +-->| F |  +-->| F |
-    //                        +---+                  +---+      +---+
-    //
-    // Initial =>  Added one callback  =>    Added two callbacks.
-
-    // Setup the "notification" from 'F' to 'N' so that when a
-    // callback is done, signal the notifier ('N').
-    promise->future().onAny(lambda::bind(&completed, notifier));
-
-    // Setup the "notification" from previous 'N' to 'F' so that when
-    // a notifier ('N') is set (indicating the previous callback has
-    // completed), invoke the next callback ('F') in the sequence.
-    last.onAny(lambda::bind(&notified<T>, promise, callback));
-
-    // In the following, we setup the hooks so that if this sequence
-    // process is being terminated, all pending callbacks will be
-    // discarded. We use weak futures here to avoid cyclic dependencies.
-
-    // Discard the future associated with this notifier.
-    notifier->future().onDiscard(
-        lambda::bind(
-            &internal::discard<T>,
-            WeakFuture<T>(promise->future())));
-
-    // Discard the notifier associated with the previous future.
-    notifier->future().onDiscard(
-        lambda::bind(
-            &internal::discard<Nothing>,
-            WeakFuture<Nothing>(last)));
-
-    // Update the 'last'.
-    last = notifier->future();
-
-    return promise->future();
+    Callback<T>* node = new Callback<T>(callback);
+    Future<T> future = node->promise.future();
+
+    // The callbacks are queued in an intrusive list, rather than
+    // chaining a future per callback to the previous one, so that
+    // adding a callback only takes a single allocation.
+    if (current != NULL && waits.isSome()) {
+      node->enqueued = Clock::now();
+    }
+
+    if (tail == NULL) {
+      head = node;
+    } else {
+      tail->next = node;
+    }
+    tail = node;
+    depth++;
+
+    if (current == NULL) {
+      next();
+    } else if (depths.isSome()) {
+      depths->record(depth);
+    }
+
+    return future;
   }
 
 protected:
-  virtual void finalize()
+  virtual void initialize()
   {
-    last.discard();
+    if (waits.isSome()) {
+      metrics::add(waits.get());
+      metrics::add(depths.get());
+    }
+  }
 
+  virtual void finalize()
+  {
+    // Discard the callback which is running (which is propagated to
+    // the future it returned) and all the pending callbacks.
     // TODO(jieyu): Do we need to wait for the future of the last
     // callback to be in DISCARDED state?
+    if (current != NULL) {
+      current->discard();
+    }
+
+    for (Node* node = head; node != NULL; node = node->next) {
+      node->discard();
+    }
+
+    clear();
+
+    if (waits.isSome()) {
+      metrics::remove(waits.get());
+      metrics::remove(depths.get());
+    }
   }
 
 private:
-  // Invoked when a callback is done.
-  static void completed(Owned<Promise<Nothing> > notifier)
+  // Not copyable, not assignable.
+  SequenceProcess(const SequenceProcess&);
+  SequenceProcess& operator=(const SequenceProcess&);
+
+  struct Node
   {
-    notifier->set(Nothing());
-  }
+    Node() : next(NULL) {}
+    virtual ~Node() {}
+
+    // Invokes the callback, unless its future has been discarded, in
+    // which case false is returned. Otherwise 'completed' is
+    // dispatched to the given process once the callback is done.
+    virtual bool run(const PID<SequenceProcess>& pid) = 0;
+
+    // Discards the future returned for the callback, which is only
+    // a request to discard it once the callback has been invoked.
+    virtual void discard() = 0;
+
+    Option<Time> enqueued;
+    Node* next;
+  };
 
-  // Invoked when a notifier is set.
   template <typename T>
-  static void notified(
-      Owned<Promise<T> > promise,
-      const lambda::function<Future<T>()>& callback)
+  struct Callback : Node
   {
-    if (promise->future().hasDiscard()) {
-      // The user has shown the intention to discard this callback
-      // (i.e., by calling future.discard()). As a result, we will
-      // just skip this callback.
-      promise->discard();
-    } else {
-      promise->associate(callback());
+    explicit Callback(const lambda::function<Future<T>()>& _callback)
+      : callback(_callback) {}
+
+    virtual bool run(const PID<SequenceProcess>& pid)
+    {
+      if (promise.future().hasDiscard()) {
+        // The user has shown the intention to discard this callback
+        // (i.e., by calling future.discard()). As a result, we will
+        // just skip this callback.
+        promise.discard();
+        return false;
+      }
+
+      Future<T> future = callback();
+      promise.associate(future);
+      future.onAny(defer(pid, &SequenceProcess::completed));
+      return true;
+    }
+
+    virtual void discard()
+    {
+      promise.future().discard();
+      promise.discard();
+    }
+
+    Promise<T> promise;
+    const lambda::function<Future<T>()> callback;
+  };
+
+  // Runs the next callback (if any) which has not been discarded.
+  void next()
+  {
+    while (head != NULL) {
+      Node* node = head;
+      head = node->next;
+      if (head == NULL) {
+        tail = NULL;
+      }
+      depth--;
+
+      if (node->enqueued.isSome() && waits.isSome()) {
+        waits->record((Clock::now() - node->enqueued.get()).ms());
+      }
+
+      if (node->run(self())) {
+        current = node;
+        return;
+      }
+
+      delete node;
+    }
+  }
+
+  // Invoked when the future returned by the running callback is in
+  // non-pending status.
+  void completed()
+  {
+    CHECK_NOTNULL(current);
+
+    delete current;
+    current = NULL;
+
+    next();
+  }
+
+  void clear()
+  {
+    delete current;
+    current = NULL;
+
+    while (head != NULL) {
+      Node* node = head;
+      head = node->next;
+      delete node;
     }
+
+    tail = NULL;
+    depth = 0;
   }
 
-  Future<Nothing> last;
+  // The callback which is running, if any.
+  Node* current;
+
+  // The pending callbacks.
+  Node* head;
+  Node* tail;
+  size_t depth;
+
+  // The contention metrics, if the sequence has a name.
+  Option<metrics::Histogram> waits;
+  Option<metrics::Histogram> depths;
 };
 
 
@@ -170,6 +280,13 @@ inline Sequence::Sequence()
 }
 
 
+inline Sequence::Sequence(const std::string& name)
+{
+  process = new SequenceProcess(name);
+  process::spawn(process);
+}
+
+
 inline Sequence::~Sequence()
 {
   process::terminate(process);
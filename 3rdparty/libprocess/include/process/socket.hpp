@@ -15,10 +15,12 @@
 
 #ifndef __WINDOWS__
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #endif // __WINDOWS__
 
 #include <memory>
+#include <vector>
 
 #include <process/address.hpp>
 #include <process/future.hpp>
@@ -143,6 +145,22 @@ public:
     virtual Future<size_t> send(const char* data, size_t size) = 0;
     virtual Future<size_t> sendfile(int fd, off_t offset, size_t size) = 0;
 
+    /**
+     * An overload of `send`, which sends the data of several buffers
+     * at once (i.e., a "gather" write) without them being copied
+     * into a single buffer first.
+     *
+     * The default implementation sends only the first buffer, which
+     * is correct since callers must be prepared to handle less data
+     * being sent than requested.
+     *
+     * @param buffers The buffers to send, in order.
+     *
+     * @return The number of bytes sent, or an error in case the
+     *     sending fails.
+     */
+    virtual Future<size_t> send(const std::vector<struct iovec>& buffers);
+
     /**
      * An overload of `recv`, which receives data based on the specified
      * 'size' parameter.
@@ -288,6 +306,11 @@ public:
     return impl->sendfile(fd, offset, size);
   }
 
+  Future<size_t> send(const std::vector<struct iovec>& buffers) const
+  {
+    return impl->send(buffers);
+  }
+
   Future<std::string> recv(const Option<ssize_t>& size = None())
   {
     return impl->recv(size);
@@ -235,6 +235,10 @@ private:
  * but before exec'ing. If the return value of 'setup' is non-zero
  * then that gets returned in 'status()' and we will not exec.
  *
+ * Without 'setup' and 'clone', the subprocess is spawned with
+ * 'posix_spawnp' rather than forked when possible, which avoids
+ * copying the page tables of the (possibly large) parent.
+ *
  * @param path Relative or absolute path in the filesytem to the
  *     executable.
  * @param argv Argument vector to pass to exec.
@@ -24,13 +24,13 @@
 #include <process/timeout.hpp>
 
 #include <stout/duration.hpp>
-#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
 
 #include "event_loop.hpp"
+#include "timer_wheel.hpp"
 
 using std::list;
 using std::map;
@@ -39,10 +39,9 @@ using std::set;
 
 namespace process {
 
-// We store the timers in a map of lists indexed by the timeout of the
-// timer so that we can have two timers that have the same timeout. We
-// exploit that the map is SORTED!
-static map<Time, list<Timer>>* timers = new map<Time, list<Timer>>();
+// We store the timers in a timing wheel so that creating and
+// canceling a timer does not depend on the number of pending timers.
+static TimerWheel* timers = new TimerWheel();
 static recursive_mutex* timers_mutex = new recursive_mutex();
 
 
@@ -82,13 +81,10 @@ set<Time>* ticks = new set<Time>();
 // timers are expired. Note that we don't manipulate 'timers' directly
 // so that it's clear from the callsite that the use of 'timers' is
 // within a 'synchronized' block.
-//
-// TODO(benh): Create a generic 'Timers' abstraction which hides this
-// and more away (i.e., all manipulations of 'timers' below).
-Option<Time> next(const map<Time, list<Timer>>& timers)
+Option<Time> next(TimerWheel& timers)
 {
   if (!timers.empty()) {
-    Time first = timers.begin()->first;
+    Time first = timers.next();
 
     // If the clock is paused and no timers are expired, the
     // timers cannot fire until the clock is advanced, so we
@@ -116,7 +112,7 @@ void tick(const Time& time);
 // a 'synchronized' block.
 // TODO(bmahler): Consider taking an optional 'now' to avoid
 // excessive syscalls via Clock::now(NULL).
-void scheduleTick(const map<Time, list<Timer>>& timers, set<Time>* ticks)
+void scheduleTick(TimerWheel& timers, set<Time>* ticks)
 {
   // Determine when the next 'tick' should fire.
   const Option<Time> next = clock::next(timers);
@@ -151,12 +147,10 @@ void tick(const Time& time)
 
     VLOG(3) << "Handling timers up to " << now;
 
-    foreachkey (const Time& timeout, *timers) {
-      if (timeout > now) {
-        break;
-      }
+    timedout = timers->expire(now);
 
-      VLOG(3) << "Have timeout(s) at " << timeout;
+    if (!timedout.empty()) {
+      VLOG(3) << "Have " << timedout.size() << " timeout(s)";
 
       // Need to toggle 'settling' so that we don't prematurely say
       // we're settled until after the timers are executed below,
@@ -164,17 +158,10 @@ void tick(const Time& time)
       if (clock::paused) {
         clock::settling = true;
       }
-
-      foreach (const Timer& timer, (*timers)[timeout]) {
-        timedout.push_back(timer);
-      }
     }
 
-    // Now erase the range of timers that timed out.
-    timers->erase(timers->begin(), timers->upper_bound(now));
-
     // Okay, so the timeout for the next timer should not have fired.
-    CHECK(timers->empty() || (timers->begin()->first > now));
+    CHECK(timers->empty() || (timers->next() > now));
 
     // Remove this tick from the scheduled 'ticks', it may have
     // been removed already if the clock was paused / manipulated
@@ -192,8 +179,7 @@ void tick(const Time& time)
   // executing expired timers.
   synchronized (timers_mutex) {
     if (clock::paused &&
-        (timers->size() == 0 ||
-         timers->begin()->first > *clock::current)) {
+        (timers->empty() || timers->next() > *clock::current)) {
       VLOG(3) << "Clock has settled";
       clock::settling = false;
     }
@@ -221,7 +207,7 @@ void Clock::finalize()
     // This, along with the `timers_mutex`, is all that is required to clean
     // up any pending timers.  Timers are triggered via "ticks".  However,
     // we do not need to clear `ticks` because a "tick" with an empty `timers`
-    // map will effectively be a no-op.
+    // wheel will effectively be a no-op.
     timers->clear();
   }
 }
@@ -281,17 +267,15 @@ Timer Clock::timer(
 
   // Add the timer.
   synchronized (timers_mutex) {
-    if (timers->size() == 0 ||
-        timer.timeout().time() < timers->begin()->first) {
+    if (timers->empty() || timer.timeout().time() < timers->next()) {
       // Need to interrupt the loop to update/set timer repeat.
-      (*timers)[timer.timeout().time()].push_back(timer);
+      timers->insert(timer);
 
       // Schedule another "tick" if necessary.
       clock::scheduleTick(*timers, clock::ticks);
     } else {
       // Timer repeat is adequate, just add the timeout.
-      CHECK(timers->size() >= 1);
-      (*timers)[timer.timeout().time()].push_back(timer);
+      timers->insert(timer);
     }
   }
 
@@ -301,22 +285,12 @@ Timer Clock::timer(
 
 bool Clock::cancel(const Timer& timer)
 {
-  bool canceled = false;
   synchronized (timers_mutex) {
-    // Check if the timeout is still pending, and if so, erase it. In
-    // addition, erase an empty list if we just removed the last
-    // timeout.
-    Time time = timer.timeout().time();
-    if (timers->count(time) > 0) {
-      canceled = true;
-      (*timers)[time].remove(timer);
-      if ((*timers)[time].empty()) {
-        timers->erase(time);
-      }
-    }
+    // Erase the timer if it is still pending.
+    return timers->remove(timer);
   }
 
-  return canceled;
+  UNREACHABLE();
 }
 
 
@@ -460,8 +434,7 @@ bool Clock::settled()
     if (clock::settling) {
       VLOG(3) << "Clock still not settled";
       return false;
-    } else if (timers->size() == 0 ||
-               timers->begin()->first > *clock::current) {
+    } else if (timers->empty() || timers->next() > *clock::current) {
       VLOG(3) << "Clock is settled";
       return true;
     }
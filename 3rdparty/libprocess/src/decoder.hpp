@@ -13,15 +13,20 @@
 #ifndef __DECODER_HPP__
 #define __DECODER_HPP__
 
+#include <arpa/inet.h>
 #include <http_parser.h>
+#include <string.h>
 
 #include <glog/logging.h>
 
 #include <deque>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/http.hpp>
+#include <process/message.hpp>
+#include <process/owned.hpp>
 #include <process/socket.hpp>
 
 #include <stout/foreach.hpp>
@@ -99,8 +104,9 @@ private:
     CHECK(!decoder->failure);
 
     decoder->header = HEADER_FIELD;
-    decoder->field.clear();
-    decoder->value.clear();
+    decoder->arena.clear();
+    decoder->url = Range();
+    decoder->headers.clear();
     decoder->query.clear();
 
     CHECK(decoder->request == NULL);
@@ -145,35 +151,12 @@ private:
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
     CHECK_NOTNULL(decoder->request);
-    int result = 0;
-
-#if (HTTP_PARSER_VERSION_MAJOR >= 2)
-    // Reworked parsing for version >= 2.0.
-    http_parser_url url;
-    result = http_parser_parse_url(data, length, 0, &url);
-
-    if (result == 0) {
-      if (url.field_set & (1 << UF_PATH)) {
-        decoder->request->url.path.append(
-            data + url.field_data[UF_PATH].off,
-            url.field_data[UF_PATH].len);
-      }
-
-      if (url.field_set & (1 << UF_FRAGMENT)) {
-        decoder->request->url.fragment->append(
-            data + url.field_data[UF_FRAGMENT].off,
-            url.field_data[UF_FRAGMENT].len);
-      }
 
-      if (url.field_set & (1 << UF_QUERY)) {
-        decoder->query.append(
-            data + url.field_data[UF_QUERY].off,
-            url.field_data[UF_QUERY].len);
-      }
-    }
-#endif
+    // The URL may be split across several calls, so it only gets
+    // parsed once it is complete (see 'on_headers_complete').
+    decoder->append(&decoder->url, data, length);
 
-    return result;
+    return 0;
   }
 
   static int on_header_field(http_parser* p, const char* data, size_t length)
@@ -181,13 +164,11 @@ private:
     DataDecoder* decoder = (DataDecoder*) p->data;
     CHECK_NOTNULL(decoder->request);
 
-    if (decoder->header != HEADER_FIELD) {
-      decoder->request->headers[decoder->field] = decoder->value;
-      decoder->field.clear();
-      decoder->value.clear();
+    if (decoder->header != HEADER_FIELD || decoder->headers.empty()) {
+      decoder->headers.push_back(std::make_pair(Range(), Range()));
     }
 
-    decoder->field.append(data, length);
+    decoder->append(&decoder->headers.back().first, data, length);
     decoder->header = HEADER_FIELD;
 
     return 0;
@@ -197,7 +178,8 @@ private:
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
     CHECK_NOTNULL(decoder->request);
-    decoder->value.append(data, length);
+    CHECK(!decoder->headers.empty());
+    decoder->append(&decoder->headers.back().second, data, length);
     decoder->header = HEADER_VALUE;
     return 0;
   }
@@ -208,10 +190,46 @@ private:
 
     CHECK_NOTNULL(decoder->request);
 
-    // Add final header.
-    decoder->request->headers[decoder->field] = decoder->value;
-    decoder->field.clear();
-    decoder->value.clear();
+#if (HTTP_PARSER_VERSION_MAJOR >= 2)
+    // Reworked parsing for version >= 2.0.
+    if (decoder->url.length > 0) {
+      const char* data = decoder->arena.data() + decoder->url.offset;
+
+      http_parser_url url;
+      if (http_parser_parse_url(data, decoder->url.length, 0, &url) != 0) {
+        return 1;
+      }
+
+      if (url.field_set & (1 << UF_PATH)) {
+        decoder->request->url.path.assign(
+            data + url.field_data[UF_PATH].off,
+            url.field_data[UF_PATH].len);
+      }
+
+      if (url.field_set & (1 << UF_FRAGMENT)) {
+        decoder->request->url.fragment = std::string(
+            data + url.field_data[UF_FRAGMENT].off,
+            url.field_data[UF_FRAGMENT].len);
+      }
+
+      if (url.field_set & (1 << UF_QUERY)) {
+        decoder->query.assign(
+            data + url.field_data[UF_QUERY].off,
+            url.field_data[UF_QUERY].len);
+      }
+    }
+#endif
+
+    // Materialize the headers, copying each field and value exactly
+    // once out of the arena. Like before, a repeated field overrides
+    // the earlier values.
+    decoder->request->headers.reserve(decoder->headers.size());
+
+    typedef std::pair<Range, Range> Header;
+    foreach (const Header& header, decoder->headers) {
+      decoder->request->headers[decoder->materialize(header.first)] =
+        decoder->materialize(header.second);
+    }
 
     decoder->request->method =
       http_method_str((http_method) decoder->parser.method);
@@ -263,6 +281,36 @@ private:
     return 0;
   }
 
+  // A range of the bytes in the arena.
+  struct Range
+  {
+    Range() : offset(0), length(0) {}
+
+    size_t offset;
+    size_t length;
+  };
+
+  // Appends the data to the arena, extending 'range' which must end
+  // at the end of the arena unless it is still empty. Since the
+  // parser calls back in order, the fragments of a field (or value)
+  // are always appended contiguously.
+  void append(Range* range, const char* data, size_t length)
+  {
+    if (range->length == 0) {
+      range->offset = arena.size();
+    }
+
+    CHECK_EQ(range->offset + range->length, arena.size());
+
+    arena.append(data, length);
+    range->length += length;
+  }
+
+  std::string materialize(const Range& range) const
+  {
+    return std::string(arena.data() + range.offset, range.length);
+  }
+
   const network::Socket s; // The socket this decoder is associated with.
 
   bool failure;
@@ -276,8 +324,14 @@ private:
     HEADER_VALUE
   } header;
 
-  std::string field;
-  std::string value;
+  // The URL and the header bytes of the request being decoded, stored
+  // contiguously. The arena is cleared for every request but keeps
+  // its capacity, so decoding the requests of a connection does not
+  // allocate for every fragment of a header.
+  std::string arena;
+  Range url;
+  std::vector<std::pair<Range, Range>> headers;
+
   std::string query;
 
   http::Request* request;
@@ -658,12 +712,13 @@ private:
       return 1;
     }
 
-    // We cannot provide streaming gzip decompression!
+    // A gzip encoded body gets decompressed as it arrives.
     Option<std::string> encoding =
       decoder->response->headers.get("Content-Encoding");
     if (encoding.isSome() && encoding.get() == "gzip") {
-      decoder->failure = true;
-      return 1;
+      decoder->decompressor.reset(new gzip::Decompressor());
+    } else {
+      decoder->decompressor.reset();
     }
 
     CHECK_NONE(decoder->writer);
@@ -687,7 +742,23 @@ private:
     CHECK_SOME(decoder->writer);
 
     http::Pipe::Writer writer = decoder->writer.get(); // Remove const.
-    writer.write(std::string(data, length));
+
+    if (decoder->decompressor.get() != NULL) {
+      Try<std::string> decompressed =
+        decoder->decompressor->decompress(std::string(data, length));
+
+      if (decompressed.isError()) {
+        decoder->failure = true;
+        return 1;
+      }
+
+      // The decompressor might need more data before it can emit any.
+      if (!decompressed.get().empty()) {
+        writer.write(decompressed.get());
+      }
+    } else {
+      writer.write(std::string(data, length));
+    }
 
     return 0;
   }
@@ -723,9 +794,89 @@ private:
   http::Response* response;
   Option<http::Pipe::Writer> writer;
 
+  // Set while decoding a gzip encoded body.
+  Owned<gzip::Decompressor> decompressor;
+
   std::deque<http::Response*> responses;
 };
 
+
+// Decodes messages sent with the length-prefixed binary framing (see
+// FramedMessageEncoder). Note that the address of the 'to' of the
+// decoded messages is left unset, it's up to the caller to fill it in.
+class FramedMessageDecoder
+{
+public:
+  FramedMessageDecoder() : failure(false) {}
+
+  std::deque<Message*> decode(const char* data, size_t length)
+  {
+    buffer.append(data, length);
+
+    std::deque<Message*> result;
+    size_t offset = 0;
+
+    while (buffer.size() - offset >= HEADER_SIZE) {
+      uint32_t header[4];
+      memcpy(header, buffer.data() + offset, HEADER_SIZE);
+
+      // Use 64 bits so that a malformed header can't overflow the
+      // size of the frame.
+      uint64_t sizes[4];
+      uint64_t size = HEADER_SIZE;
+      for (size_t i = 0; i < 4; i++) {
+        sizes[i] = ntohl(header[i]);
+        size += sizes[i];
+      }
+
+      if (size > MAXIMUM_FRAME_SIZE) {
+        failure = true;
+        break;
+      }
+
+      if (buffer.size() - offset < size) {
+        break; // Need more data.
+      }
+
+      const char* field = buffer.data() + offset + HEADER_SIZE;
+
+      Message* message = new Message();
+      message->from = UPID(std::string(field, sizes[0]));
+      field += sizes[0];
+      message->to.id = std::string(field, sizes[1]);
+      field += sizes[1];
+      message->name = std::string(field, sizes[2]);
+      field += sizes[2];
+      message->body = std::string(field, sizes[3]);
+
+      result.push_back(message);
+
+      offset += size;
+    }
+
+    buffer.erase(0, offset);
+
+    return result;
+  }
+
+  bool failed() const
+  {
+    return failure;
+  }
+
+private:
+  static const size_t HEADER_SIZE = 4 * sizeof(uint32_t);
+
+  // Frames larger than this are considered malformed rather than
+  // buffering an unbounded amount of data.
+  static const uint64_t MAXIMUM_FRAME_SIZE = 1024 * 1024 * 1024;
+
+  bool failure;
+
+  // Data that has been received but not yet decoded.
+  std::string buffer;
+};
+
 }  // namespace process {
 
 #endif // __DECODER_HPP__
@@ -16,23 +16,45 @@
 #include <stdint.h>
 #include <time.h>
 
+#include <arpa/inet.h>
+#include <sys/uio.h>
+
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <vector>
 
+#include <process/check.hpp>
+#include <process/future.hpp>
 #include <process/http.hpp>
 #include <process/process.hpp>
 
+#include <stout/cache.hpp>
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
+#include <stout/synchronized.hpp>
 
 
 namespace process {
 
 const uint32_t GZIP_MINIMUM_BODY_LENGTH = 1024;
 
+// Bodies of at least this length are compressed with the fastest
+// level, which compresses large JSON documents (e.g., '/state') a few
+// times faster than the default level for a slightly larger result.
+const uint32_t GZIP_FAST_BODY_LENGTH = 256 * 1024;
+
+// The number of compressed bodies of responses with an 'ETag' that
+// are kept, so that a response which is requested repeatedly (e.g.,
+// by pollers of '/state') is only compressed once.
+const size_t GZIP_CACHE_CAPACITY = 16;
+
 // Forward declarations.
 class Encoder;
 
@@ -65,11 +87,17 @@ private:
 };
 
 
+// Encodes data that is sent as a sequence of buffers, which can be
+// written with a single 'writev' without first concatenating them
+// (see DataEncoder::next).
 class DataEncoder : public Encoder
 {
 public:
-  DataEncoder(const network::Socket& s, const std::string& _data)
-    : Encoder(s), data(_data), index(0) {}
+  DataEncoder(const network::Socket& s, std::string _data)
+    : Encoder(s), data(std::move(_data)), size(0), index(0)
+  {
+    append(data.data(), data.size());
+  }
 
   virtual ~DataEncoder() {}
 
@@ -78,12 +106,28 @@ public:
     return Encoder::DATA;
   }
 
-  virtual const char* next(size_t* length)
+  // Returns the buffers of data that remain to be sent.
+  virtual std::vector<struct iovec> next()
   {
-    size_t temp = index;
-    index = data.size();
-    *length = data.size() - temp;
-    return data.data() + temp;
+    std::vector<struct iovec> result;
+
+    size_t offset = index;
+    foreach (const struct iovec& buffer, buffers) {
+      if (offset >= buffer.iov_len) {
+        offset -= buffer.iov_len;
+        continue;
+      }
+
+      struct iovec remaining;
+      remaining.iov_base = static_cast<char*>(buffer.iov_base) + offset;
+      remaining.iov_len = buffer.iov_len - offset;
+      result.push_back(remaining);
+
+      offset = 0;
+    }
+
+    index = size;
+    return result;
   }
 
   virtual void backup(size_t length)
@@ -95,11 +139,35 @@ public:
 
   virtual size_t remaining() const
   {
-    return data.size() - index;
+    return size - index;
+  }
+
+protected:
+  // For subclasses which keep the data they send themselves.
+  explicit DataEncoder(const network::Socket& s)
+    : Encoder(s), size(0), index(0) {}
+
+  // Adds a buffer to send after the ones already added. The data must
+  // stay valid for the lifetime of the encoder.
+  void append(const char* data, size_t length)
+  {
+    if (length > 0) {
+      struct iovec buffer;
+      buffer.iov_base = const_cast<char*>(data);
+      buffer.iov_len = length;
+      buffers.push_back(buffer);
+      size += length;
+    }
   }
 
 private:
+  // Not copyable, not assignable (the buffers point into the data).
+  DataEncoder(const DataEncoder&);
+  DataEncoder& operator=(const DataEncoder&);
+
   const std::string data;
+  std::vector<struct iovec> buffers;
+  size_t size;
   size_t index;
 };
 
@@ -158,18 +226,110 @@ private:
 };
 
 
+// Encodes a message as a length-prefixed binary frame rather than as
+// an HTTP request. This framing is only used on connections where the
+// peer has agreed to it (see SocketManager::negotiate). A frame
+// starts with a header of four 32-bit lengths, in network byte order,
+// of the 'from', 'to' id, 'name' and 'body' of the message, followed
+// by each of those fields.
+class FramedMessageEncoder : public DataEncoder
+{
+public:
+  FramedMessageEncoder(const network::Socket& s, Message* _message)
+    : DataEncoder(s, encode(_message)), message(_message) {}
+
+  virtual ~FramedMessageEncoder()
+  {
+    if (message != NULL) {
+      delete message;
+    }
+  }
+
+  static const size_t HEADER_SIZE = 4 * sizeof(uint32_t);
+
+  static std::string encode(Message* message)
+  {
+    std::string data;
+
+    if (message != NULL) {
+      const std::string from = message->from;
+
+      uint32_t header[4];
+      header[0] = htonl(from.size());
+      header[1] = htonl(message->to.id.size());
+      header[2] = htonl(message->name.size());
+      header[3] = htonl(message->body.size());
+
+      data.reserve(
+          HEADER_SIZE +
+          from.size() +
+          message->to.id.size() +
+          message->name.size() +
+          message->body.size());
+
+      data.append(reinterpret_cast<const char*>(header), HEADER_SIZE);
+      data.append(from);
+      data.append(message->to.id);
+      data.append(message->name);
+      data.append(message->body);
+    }
+
+    return data;
+  }
+
+private:
+  Message* message;
+};
+
+
 class HttpResponseEncoder : public DataEncoder
 {
 public:
+  // NOTE: The encoder holds on to the future so that the body of the
+  // response, which can be large, is sent without being copied.
   HttpResponseEncoder(
       const network::Socket& s,
-      const http::Response& response,
+      const Future<http::Response>& _response,
       const http::Request& request)
-    : DataEncoder(s, encode(response, request)) {}
+    : DataEncoder(s), response(_response)
+  {
+    CHECK_READY(response);
+
+    const char* body = NULL;
+    size_t length = 0;
+
+    encode(response.get(), request, &header, &compressed, &body, &length);
+
+    append(header.data(), header.size());
+    append(body, length);
+  }
 
   static std::string encode(
       const http::Response& response,
       const http::Request& request)
+  {
+    std::string header;
+    std::string compressed;
+    const char* body = NULL;
+    size_t length = 0;
+
+    encode(response, request, &header, &compressed, &body, &length);
+
+    return header.append(body, length);
+  }
+
+private:
+  // Encodes the status line and headers of the response into
+  // 'header' and points 'body' at the data that should follow them,
+  // which is either the body of the response or, if the body gets
+  // gzipped, 'compressed'.
+  static void encode(
+      const http::Response& response,
+      const http::Request& request,
+      std::string* header,
+      std::string* compressed,
+      const char** body,
+      size_t* length)
   {
     std::ostringstream out;
 
@@ -196,19 +356,22 @@ public:
 
     headers["Date"] = date;
 
-    // Should we compress this response?
-    std::string body = response.body;
+    *body = response.body.data();
+    *length = response.body.size();
 
+    // Should we compress this response?
     if (response.type == http::Response::BODY &&
         response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
         !headers.contains("Content-Encoding") &&
         request.acceptsEncoding("gzip")) {
-      Try<std::string> compressed = gzip::compress(body);
-      if (compressed.isError()) {
-        LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
+      Try<std::string> gzipped = compress(response.body, headers.get("ETag"));
+      if (gzipped.isError()) {
+        LOG(WARNING) << "Failed to gzip response body: " << gzipped.error();
       } else {
-        body = compressed.get();
-        headers["Content-Length"] = stringify(body.length());
+        *compressed = gzipped.get();
+        *body = compressed->data();
+        *length = compressed->size();
+        headers["Content-Length"] = stringify(*length);
         headers["Content-Encoding"] = "gzip";
       }
     }
@@ -224,26 +387,79 @@ public:
       out << "Content-Length: 0\r\n";
     } else if (response.type == http::Response::BODY &&
                !headers.contains("Content-Length")) {
-      out << "Content-Length: " << body.size() << "\r\n";
+      out << "Content-Length: " << *length << "\r\n";
     }
 
     // Use a CRLF to mark end of headers.
     out << "\r\n";
 
+    *header = out.str();
+
     // Add the body if necessary.
     if (response.type == http::Response::BODY) {
       // If the Content-Length header was supplied, only write as much data
       // as the length specifies.
-      Result<uint32_t> length = numify<uint32_t>(headers.get("Content-Length"));
-      if (length.isSome() && length.get() <= body.length()) {
-        out.write(body.data(), length.get());
-      } else {
-        out.write(body.data(), body.size());
+      Result<uint32_t> contentLength =
+        numify<uint32_t>(headers.get("Content-Length"));
+      if (contentLength.isSome() && contentLength.get() <= *length) {
+        *length = contentLength.get();
       }
+    } else {
+      *length = 0;
     }
+  }
 
-    return out.str();
+  // Returns the gzipped body, which is looked up in (or added to) the
+  // cache of compressed bodies if the response has an 'ETag'. Since
+  // an 'ETag' is only unique for a single endpoint, the hash of the
+  // body is checked as well.
+  static Try<std::string> compress(
+      const std::string& body,
+      const Option<std::string>& etag)
+  {
+    const int level = body.length() >= GZIP_FAST_BODY_LENGTH
+      ? Z_BEST_SPEED
+      : Z_DEFAULT_COMPRESSION;
+
+    if (etag.isNone()) {
+      return gzip::compress(body, level);
+    }
+
+    typedef std::pair<size_t, std::shared_ptr<const std::string>> Entry;
+
+    static std::mutex* mutex = new std::mutex();
+    static Cache<std::string, Entry>* cache =
+      new Cache<std::string, Entry>(GZIP_CACHE_CAPACITY);
+
+    const size_t hash = std::hash<std::string>()(body);
+
+    Option<Entry> entry;
+    synchronized (mutex) {
+      entry = cache->get(etag.get());
+    }
+
+    if (entry.isSome() && entry.get().first == hash) {
+      return *entry.get().second;
+    }
+
+    Try<std::string> gzipped = gzip::compress(body, level);
+    if (gzipped.isError()) {
+      return gzipped;
+    }
+
+    synchronized (mutex) {
+      cache->put(
+          etag.get(),
+          Entry(hash, std::make_shared<const std::string>(gzipped.get())));
+    }
+
+    return gzipped;
   }
+
+  const Future<http::Response> response;
+
+  std::string header;
+  std::string compressed;
 };
 
 
@@ -23,6 +23,7 @@
 #include <ostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <sstream>
@@ -30,6 +31,7 @@
 #include <vector>
 
 #include <process/async.hpp>
+#include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -38,14 +40,18 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/socket.hpp>
+#include <process/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/ip.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/nothing.hpp>
 #include <stout/numify.hpp>
 #include <stout/option.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/try.hpp>
@@ -883,10 +889,7 @@ string encode(const Request& request)
 
   // TODO(bmahler): Use a 'Request' and a 'RequestEncoder' here!
   // Currently this does not handle 'gzip' content encoding,
-  // unless the caller manually compresses the 'body'. For
-  // streaming requests we must wipe 'gzip' as an acceptable
-  // encoding as we don't currently have streaming gzip utilities
-  // to support decoding a streaming gzip response!
+  // unless the caller manually compresses the 'body'.
 
   // Emit the headers.
   foreachpair (const string& key, const string& value, headers) {
@@ -1268,8 +1271,227 @@ Future<Connection> connect(const URL& url)
 
 namespace internal {
 
+// Idle connections are closed after this duration.
+static const Duration IDLE_CONNECTION_TIMEOUT = Seconds(15);
+
+// At most this many idle connections are kept per server.
+static const size_t MAX_IDLE_CONNECTIONS_PER_SERVER = 8;
+
+
+// Keeps the connections which have no more requests in flight, so
+// that the requests to the same server (scheme, host and port) can
+// reuse them rather than connecting again.
+//
+// NOTE: A connection must not be destroyed from the execution context
+// of its 'ConnectionProcess' (see 'request' below), so the pool never
+// drops the last copy of a connection itself: the connections which
+// are closed are handed to 'async' instead.
+class ConnectionPool
+{
+public:
+  // Returns an idle connection to the server, if any.
+  Option<Connection> acquire(const string& server)
+  {
+    Option<Connection> connection;
+    vector<Connection> closed;
+
+    synchronized (mutex) {
+      if (!idle.contains(server)) {
+        return None();
+      }
+
+      deque<Idle>& connections = idle.at(server);
+
+      // The most recently used connection is the most likely one to
+      // not have been closed by the server.
+      while (!connections.empty() && connection.isNone()) {
+        Idle entry = connections.back();
+        connections.pop_back();
+
+        Clock::cancel(entry.timer);
+
+        if (entry.disconnected.isPending()) {
+          connection = entry.connection;
+        } else {
+          closed.push_back(entry.connection);
+        }
+      }
+
+      if (connections.empty()) {
+        idle.erase(server);
+      }
+    }
+
+    close(std::move(closed));
+
+    return connection;
+  }
+
+  // Keeps the connection for reuse until it has been idle for
+  // IDLE_CONNECTION_TIMEOUT, unless the server already has
+  // MAX_IDLE_CONNECTIONS_PER_SERVER idle connections.
+  void release(const string& server, Connection connection)
+  {
+    vector<Connection> closed;
+
+    synchronized (mutex) {
+      deque<Idle>& connections = idle[server];
+
+      if (connections.size() >= MAX_IDLE_CONNECTIONS_PER_SERVER) {
+        closed.push_back(connection);
+      } else {
+        const uint64_t id = ++ids;
+
+        Idle entry = {
+          connection,
+          connection.disconnected(),
+          Clock::timer(IDLE_CONNECTION_TIMEOUT, [=]() {
+            expire(server, id);
+          }),
+          id
+        };
+
+        connections.push_back(entry);
+      }
+    }
+
+    close(std::move(closed));
+  }
+
+private:
+  struct Idle
+  {
+    Connection connection;
+    Future<Nothing> disconnected;
+    Timer timer;
+    uint64_t id;
+  };
+
+  // Closes the given idle connection once its timer fires.
+  void expire(const string& server, uint64_t id)
+  {
+    vector<Connection> closed;
+
+    synchronized (mutex) {
+      if (!idle.contains(server)) {
+        return;
+      }
+
+      deque<Idle>& connections = idle.at(server);
+      for (auto it = connections.begin(); it != connections.end(); ++it) {
+        if (it->id == id) {
+          closed.push_back(it->connection);
+          connections.erase(it);
+          break;
+        }
+      }
+
+      if (connections.empty()) {
+        idle.erase(server);
+      }
+    }
+
+    close(std::move(closed));
+  }
+
+  static void close(vector<Connection>&& connections)
+  {
+    if (connections.empty()) {
+      return;
+    }
+
+    vector<Connection>* copy = new vector<Connection>(std::move(connections));
+    async([copy]() { delete copy; });
+  }
+
+  std::mutex mutex;
+  hashmap<string, deque<Idle>> idle;
+  uint64_t ids = 0;
+};
+
+
+static ConnectionPool* pool = new ConnectionPool();
+
+
+// Returns the server of the URL, which identifies its pooled
+// connections.
+static string server(const URL& url)
+{
+  const string host = url.ip.isSome()
+    ? stringify(url.ip.get())
+    : url.domain.getOrElse("");
+
+  return url.scheme.getOrElse("http") + "://" + host + ":" +
+         stringify(url.port.getOrElse(0));
+}
+
+
+// Whether a request can safely be sent again.
+static bool idempotent(const Request& request)
+{
+  return request.method == "GET" ||
+         request.method == "HEAD" ||
+         request.method == "DELETE";
+}
+
+
+// Sends the request over a connection from the pool (or a new one),
+// which goes back to the pool once the response has been received.
+// Idempotent requests which fail on a reused connection, e.g., since
+// the server closed it in the meantime, are sent again over a new
+// connection.
+Future<Response> pooled(const Request& request, bool reuse)
+{
+  const string key = server(request.url);
+
+  Request request_ = request;
+  request_.keepAlive = true;
+
+  Option<Connection> idle = reuse ? pool->acquire(key) : None();
+  const bool reused = idle.isSome();
+
+  Future<Connection> connection = reused
+    ? Future<Connection>(idle.get())
+    : http::connect(request.url);
+
+  return connection
+    .then([=](Connection connection) {
+      // The response is completed from the execution context of the
+      // 'ConnectionProcess', so our copy of the connection is
+      // destroyed from 'async' to avoid a deadlock (see 'request').
+      // The connection is released before the response is returned,
+      // so that the next request to the server can reuse it.
+      Connection* copy = new Connection(std::move(connection));
+
+      return copy->send(request_, false)
+        .onAny([=](const Future<Response>& response) {
+          if (response.isReady() &&
+              (!response->headers.contains("Connection") ||
+               response->headers.at("Connection") != "close")) {
+            pool->release(key, *copy);
+          }
+
+          async([copy]() { delete copy; });
+        });
+    })
+    .repair([=](const Future<Response>& response) -> Future<Response> {
+      if (reused && idempotent(request)) {
+        return pooled(request, false);
+      }
+
+      return response;
+    });
+}
+
+
 Future<Response> request(const Request& request, bool streamedResponse)
 {
+  // Non-streamed responses are read completely before they are
+  // returned, after which the connection can be reused.
+  if (!streamedResponse) {
+    return pooled(request, true);
+  }
+
   // We rely on the connection closing after the response.
   CHECK(!request.keepAlive);
 
@@ -10,10 +10,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
-
-#include <boost/shared_array.hpp>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/io.hpp>
@@ -23,6 +24,7 @@
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
 #include <stout/os/strerror.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 
 using std::string;
@@ -38,6 +40,32 @@ enum ReadFlags
 };
 
 
+// The maximum number of unused buffers kept in the pool, so that a
+// burst of reads does not pin the memory of its buffers (64 buffers
+// of BUFFERED_READ_SIZE, i.e., 4MB) indefinitely.
+const size_t MAX_POOLED_BUFFERS = 64;
+
+// The buffers of BUFFERED_READ_SIZE which are not in use, as handed
+// out by 'Buffer::allocate' (protected by 'pool_mutex').
+std::vector<char*>* pool = new std::vector<char*>();
+std::mutex* pool_mutex = new std::mutex();
+
+
+// Deleter of the buffers handed out by 'Buffer::allocate', which
+// returns the buffer to the pool (unless the pool is full).
+void release(char* buffer)
+{
+  synchronized (pool_mutex) {
+    if (pool->size() < MAX_POOLED_BUFFERS) {
+      pool->push_back(buffer);
+      return;
+    }
+  }
+
+  delete[] buffer;
+}
+
+
 void read(
     int fd,
     void* data,
@@ -155,6 +183,25 @@ void write(
 } // namespace internal {
 
 
+std::shared_ptr<char> Buffer::allocate()
+{
+  char* buffer = NULL;
+
+  synchronized (internal::pool_mutex) {
+    if (!internal::pool->empty()) {
+      buffer = internal::pool->back();
+      internal::pool->pop_back();
+    }
+  }
+
+  if (buffer == NULL) {
+    buffer = new char[BUFFERED_READ_SIZE];
+  }
+
+  return std::shared_ptr<char>(buffer, &internal::release);
+}
+
+
 Future<size_t> read(int fd, void* data, size_t size)
 {
   process::initialize();
@@ -188,6 +235,17 @@ Future<size_t> read(int fd, void* data, size_t size)
 }
 
 
+Future<Buffer> read(int fd, size_t size)
+{
+  std::shared_ptr<char> buffer = Buffer::allocate();
+
+  return io::read(fd, buffer.get(), std::min(size, BUFFERED_READ_SIZE))
+    .then([=](size_t length) {
+      return Buffer(buffer, buffer.get(), length);
+    });
+}
+
+
 Future<size_t> write(int fd, const void* data, size_t size)
 {
   process::initialize();
@@ -283,7 +341,7 @@ namespace internal {
 Future<string> _read(
     int fd,
     const std::shared_ptr<string>& buffer,
-    const boost::shared_array<char>& data,
+    const std::shared_ptr<char>& data,
     size_t length)
 {
   return io::read(fd, data.get(), length)
@@ -297,17 +355,14 @@ Future<string> _read(
 }
 
 
-Future<Nothing> _write(
-    int fd,
-    Owned<string> data,
-    size_t index)
+Future<Nothing> _write(int fd, const Buffer& data)
 {
-  return io::write(fd, data->data() + index, data->size() - index)
+  return io::write(fd, data.data(), data.size())
     .then([=](size_t length) -> Future<Nothing> {
-      if (index + length == data->size()) {
+      if (length == data.size()) {
         return Nothing();
       }
-      return _write(fd, data, index + length);
+      return _write(fd, data.slice(length));
     });
 }
 
@@ -316,7 +371,7 @@ void _splice(
     int from,
     int to,
     size_t chunk,
-    boost::shared_array<char> data,
+    std::shared_ptr<char> data,
     std::shared_ptr<Promise<Nothing>> promise)
 {
   // Stop splicing if a discard occured on our future.
@@ -348,7 +403,7 @@ void _splice(
         // discard has occured on our future, in order to provide
         // semantics where everything read is written. The promise
         // will eventually be discarded in the next read.
-        io::write(to, string(data.get(), size))
+        io::write(to, Buffer(data, data.get(), size))
           .onReady([=]() { _splice(from, to, chunk, data, promise); })
           .onFailed([=](const string& message) { promise->fail(message); })
           .onDiscarded([=]() { promise->discard(); });
@@ -361,7 +416,10 @@ void _splice(
 
 Future<Nothing> splice(int from, int to, size_t chunk)
 {
-  boost::shared_array<char> data(new char[chunk]);
+  // Use a buffer from the pool unless the chunks are larger.
+  std::shared_ptr<char> data = chunk <= BUFFERED_READ_SIZE
+    ? Buffer::allocate()
+    : std::shared_ptr<char>(new char[chunk], std::default_delete<char[]>());
 
   // Rather than having internal::_splice return a future and
   // implementing internal::_splice as a chain of io::read and
@@ -418,7 +476,7 @@ Future<string> read(int fd)
   // TODO(benh): Wrap up this data as a struct, use 'Owner'.
   // TODO(bmahler): For efficiency, use a rope for the buffer.
   std::shared_ptr<string> buffer(new string());
-  boost::shared_array<char> data(new char[BUFFERED_READ_SIZE]);
+  std::shared_ptr<char> data = Buffer::allocate();
 
   return internal::_read(fd, buffer, data, BUFFERED_READ_SIZE)
     .onAny(lambda::bind(&os::close, fd));
@@ -426,6 +484,18 @@ Future<string> read(int fd)
 
 
 Future<Nothing> write(int fd, const std::string& data)
+{
+  // Keep our own copy of the data, which the buffer refers to (using
+  // the aliasing constructor of 'std::shared_ptr').
+  std::shared_ptr<string> copy(new string(data));
+
+  std::shared_ptr<char> buffer(copy, &(*copy)[0]);
+
+  return write(fd, Buffer(buffer, copy->data(), copy->size()));
+}
+
+
+Future<Nothing> write(int fd, const Buffer& data)
 {
   process::initialize();
 
@@ -461,7 +531,7 @@ Future<Nothing> write(int fd, const std::string& data)
         nonblock.error());
   }
 
-  return internal::_write(fd, Owned<string>(new string(data)), 0)
+  return internal::_write(fd, data)
     .onAny(lambda::bind(&os::close, fd));
 }
 
@@ -548,8 +618,7 @@ Future<string> peek(int fd, size_t limit)
                    stringify(BUFFERED_READ_SIZE));
   }
 
-  // TODO(benh): Wrap up this data as a struct, use 'Owner'.
-  boost::shared_array<char> data(new char[BUFFERED_READ_SIZE]);
+  std::shared_ptr<char> data = Buffer::allocate();
 
   return io::peek(fd, data.get(), BUFFERED_READ_SIZE, limit)
     .then([=](size_t length) -> Future<string> {
@@ -0,0 +1,399 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <queue>
+
+#include <glog/logging.h>
+
+#include <stout/duration.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/thread_local.hpp>
+
+#include <stout/os/strerror.hpp>
+
+#include "event_loop.hpp"
+#include "io_uring.hpp"
+
+namespace process {
+
+// Define the initial values for all of the declarations made in
+// io_uring.hpp (since these need to live in the static data space).
+std::queue<lambda::function<void()>>* functions =
+  new std::queue<lambda::function<void()>>();
+
+std::mutex* functions_mutex = new std::mutex();
+
+THREAD_LOCAL bool* _in_event_loop_ = NULL;
+
+
+namespace {
+
+// The number of entries of the submission queue. The completion
+// queue is twice as large, as for the default io_uring setup.
+const unsigned ENTRIES = 1024;
+
+
+// The rings shared with the kernel, as mapped in 'initialize'.
+struct Ring
+{
+  int fd;
+
+  struct {
+    unsigned* head;
+    unsigned* tail;
+    unsigned mask;
+    unsigned entries;
+    unsigned* array;
+    struct io_uring_sqe* sqes;
+
+    // The tail of the entries which have been prepared, which is
+    // only published to the kernel when submitting.
+    unsigned prepared;
+  } sq;
+
+  struct {
+    unsigned* head;
+    unsigned* tail;
+    unsigned mask;
+    struct io_uring_cqe* cqes;
+  } cq;
+} ring;
+
+
+// An eventfd written to by 'interrupt', which the event loop always
+// has a read pending on.
+int wakeup = -1;
+
+// The buffer of the pending read of 'wakeup'.
+uint64_t wakeups = 0;
+
+std::atomic_bool stopping(false);
+
+
+// A timer, which keeps the timespec alive until it gets submitted.
+struct Delay : Operation
+{
+  Delay(const Duration& duration, const lambda::function<void()>& function)
+    : Operation([=](int) { function(); })
+  {
+    // A negative timeout is treated as zero, so that the function is
+    // still invoked (right away).
+    const int64_t ns = std::max(duration.ns(), (int64_t) 0);
+    timespec.tv_sec = ns / Seconds(1).ns();
+    timespec.tv_nsec = ns % Seconds(1).ns();
+  }
+
+  struct __kernel_timespec timespec;
+};
+
+
+// Submits the prepared entries and, if 'wait' is true, waits until
+// there is at least one completion.
+void submit(bool wait)
+{
+  __atomic_store_n(ring.sq.tail, ring.sq.prepared, __ATOMIC_RELEASE);
+
+  const unsigned pending =
+    ring.sq.prepared - __atomic_load_n(ring.sq.head, __ATOMIC_ACQUIRE);
+
+  if (pending == 0 && !wait) {
+    return;
+  }
+
+  const int result = syscall(
+      __NR_io_uring_enter,
+      ring.fd,
+      pending,
+      wait ? 1 : 0,
+      wait ? IORING_ENTER_GETEVENTS : 0,
+      NULL,
+      0);
+
+  // The entries which have not been consumed because the completion
+  // queue is overflowing (EBUSY) are submitted on the next call,
+  // once the completions have been reaped.
+  if (result < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+    LOG(FATAL) << "Failed to submit to io_uring: " << os::strerror(errno);
+  }
+}
+
+
+// Invokes (and deletes) the operations of all the available
+// completions. The head is advanced before each invocation, so that
+// an operation can safely prepare further operations.
+void reap()
+{
+  unsigned head = *ring.cq.head;
+
+  while (head != __atomic_load_n(ring.cq.tail, __ATOMIC_ACQUIRE)) {
+    const struct io_uring_cqe* cqe = &ring.cq.cqes[head & ring.cq.mask];
+
+    Operation* operation = reinterpret_cast<Operation*>(cqe->user_data);
+    const int result = cqe->res;
+
+    __atomic_store_n(ring.cq.head, ++head, __ATOMIC_RELEASE);
+
+    // Operations which are not interested in their completion (e.g.,
+    // the removal of a poll) are submitted without any user data.
+    if (operation != NULL) {
+      operation->completed(result);
+      delete operation;
+    }
+  }
+}
+
+
+void woken(int result);
+
+
+// Prepares a read of 'wakeup', which completes on 'interrupt'.
+void arm()
+{
+  struct io_uring_sqe* sqe = prepare();
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = wakeup;
+  sqe->addr = reinterpret_cast<uint64_t>(&wakeups);
+  sqe->len = sizeof(wakeups);
+  sqe->user_data = reinterpret_cast<uint64_t>(new Operation(&woken));
+}
+
+
+void woken(int result)
+{
+  if (result < 0 && result != -EINTR && result != -EAGAIN) {
+    LOG(FATAL) << "Failed to read the io_uring wakeup eventfd: "
+               << os::strerror(-result);
+  }
+
+  arm();
+
+  std::queue<lambda::function<void()>> run_functions;
+  synchronized (functions_mutex) {
+    // Swap the functions into a temporary queue so that we can invoke
+    // them outside of the mutex (see the libev event loop for why).
+    std::swap(run_functions, *functions);
+  }
+
+  while (!run_functions.empty()) {
+    (run_functions.front())();
+    run_functions.pop();
+  }
+}
+
+} // namespace {
+
+
+struct io_uring_sqe* prepare()
+{
+  // Make room by submitting the prepared entries if the submission
+  // queue is full, which the kernel consumes synchronously.
+  if (ring.sq.prepared - __atomic_load_n(ring.sq.head, __ATOMIC_ACQUIRE) ==
+      ring.sq.entries) {
+    submit(false);
+  }
+
+  CHECK_LT(
+      ring.sq.prepared - __atomic_load_n(ring.sq.head, __ATOMIC_ACQUIRE),
+      ring.sq.entries)
+    << "The io_uring submission queue is full";
+
+  const unsigned index = ring.sq.prepared & ring.sq.mask;
+
+  struct io_uring_sqe* sqe = &ring.sq.sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+
+  ring.sq.array[index] = index;
+  ring.sq.prepared++;
+
+  return sqe;
+}
+
+
+void flush()
+{
+  submit(false);
+}
+
+
+void interrupt()
+{
+  const uint64_t one = 1;
+  if (write(wakeup, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+    PLOG(FATAL) << "Failed to write the io_uring wakeup eventfd";
+  }
+}
+
+
+void EventLoop::initialize()
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = 2 * ENTRIES;
+
+  ring.fd = syscall(__NR_io_uring_setup, ENTRIES, &params);
+  if (ring.fd < 0) {
+    PLOG(FATAL) << "Failed to set up io_uring";
+  }
+
+  size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  size_t cqSize =
+    params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  // Since Linux 5.4 both rings are mapped at once.
+  const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single) {
+    sqSize = cqSize = std::max(sqSize, cqSize);
+  }
+
+  char* sq = static_cast<char*>(mmap(
+      NULL,
+      sqSize,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      ring.fd,
+      IORING_OFF_SQ_RING));
+
+  if (sq == MAP_FAILED) {
+    PLOG(FATAL) << "Failed to map the io_uring submission queue";
+  }
+
+  char* cq = sq;
+  if (!single) {
+    cq = static_cast<char*>(mmap(
+        NULL,
+        cqSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ring.fd,
+        IORING_OFF_CQ_RING));
+
+    if (cq == MAP_FAILED) {
+      PLOG(FATAL) << "Failed to map the io_uring completion queue";
+    }
+  }
+
+  void* sqes = mmap(
+      NULL,
+      params.sq_entries * sizeof(struct io_uring_sqe),
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      ring.fd,
+      IORING_OFF_SQES);
+
+  if (sqes == MAP_FAILED) {
+    PLOG(FATAL) << "Failed to map the io_uring submission queue entries";
+  }
+
+  ring.sq.head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  ring.sq.tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring.sq.mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring.sq.entries = params.sq_entries;
+  ring.sq.array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  ring.sq.sqes = static_cast<struct io_uring_sqe*>(sqes);
+  ring.sq.prepared = *ring.sq.tail;
+
+  ring.cq.head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring.cq.tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring.cq.mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring.cq.cqes =
+    reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wakeup < 0) {
+    PLOG(FATAL) << "Failed to create the io_uring wakeup eventfd";
+  }
+
+  arm();
+}
+
+
+namespace internal {
+
+Future<Nothing> delay(
+    const Duration& duration,
+    const lambda::function<void()>& function)
+{
+  Delay* timer = new Delay(duration, function);
+
+  // A timeout without a completion count only completes (with
+  // -ETIME) once it expires.
+  struct io_uring_sqe* sqe = prepare();
+  sqe->opcode = IORING_OP_TIMEOUT;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<uint64_t>(&timer->timespec);
+  sqe->len = 1;
+  sqe->user_data = reinterpret_cast<uint64_t>(timer);
+
+  return Nothing();
+}
+
+} // namespace internal {
+
+
+void EventLoop::delay(
+    const Duration& duration,
+    const lambda::function<void()>& function)
+{
+  run_in_event_loop<Nothing>(
+      lambda::bind(&internal::delay, duration, function));
+}
+
+
+double EventLoop::time()
+{
+  // Like 'ev_time', the current (wall clock) time in seconds.
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+void EventLoop::run()
+{
+  __in_event_loop__ = true;
+
+  // All the operations prepared while handling the completions are
+  // submitted with the same system call that waits for the next ones.
+  while (!stopping.load()) {
+    submit(true);
+    reap();
+  }
+
+  __in_event_loop__ = false;
+}
+
+
+void EventLoop::stop()
+{
+  stopping.store(true);
+  interrupt();
+}
+
+} // namespace process {
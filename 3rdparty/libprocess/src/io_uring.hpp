@@ -0,0 +1,113 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __IO_URING_HPP__
+#define __IO_URING_HPP__
+
+#include <linux/io_uring.h>
+
+#include <mutex>
+#include <queue>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+#include <stout/lambda.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/thread_local.hpp>
+
+namespace process {
+
+// An operation submitted to the ring, whose 'completed' is invoked in
+// the event loop with the result of its completion queue entry.
+struct Operation
+{
+  explicit Operation(const lambda::function<void(int)>& _completed)
+    : completed(_completed) {}
+
+  virtual ~Operation() {}
+
+  const lambda::function<void(int)> completed;
+};
+
+
+// Returns a zeroed submission queue entry to be filled in. The
+// entries are only submitted once the event loop waits for the next
+// completions, so that all the operations started while handling the
+// previous completions take a single system call. Must only be called
+// within the event loop.
+struct io_uring_sqe* prepare();
+
+// Submits the prepared entries right away, e.g., when an entry refers
+// to an operation which could otherwise complete (and be deleted)
+// before the entry gets submitted. Must only be called within the
+// event loop.
+void flush();
+
+// Wakes up the event loop, e.g., to run the queued 'functions'.
+void interrupt();
+
+// Queue of functions to be invoked asynchronously within the event
+// loop (protected by 'functions_mutex').
+extern std::queue<lambda::function<void()>>* functions;
+extern std::mutex* functions_mutex;
+
+// Per thread bool pointer. We use a pointer to lazily construct the
+// actual bool.
+extern THREAD_LOCAL bool* _in_event_loop_;
+
+#define __in_event_loop__ *(_in_event_loop_ == NULL ?                \
+  _in_event_loop_ = new bool(false) : _in_event_loop_)
+
+
+// Wrapper around function we want to run in the event loop.
+template <typename T>
+void _run_in_event_loop(
+    const lambda::function<Future<T>()>& f,
+    const Owned<Promise<T>>& promise)
+{
+  // Don't bother running the function if the future has been discarded.
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+  } else {
+    promise->set(f());
+  }
+}
+
+
+// Helper for running a function in the event loop.
+template <typename T>
+Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
+{
+  // If this is already the event loop then just run the function.
+  if (__in_event_loop__) {
+    return f();
+  }
+
+  Owned<Promise<T>> promise(new Promise<T>());
+
+  Future<T> future = promise->future();
+
+  // Enqueue the function.
+  synchronized (functions_mutex) {
+    functions->push(lambda::bind(&_run_in_event_loop<T>, f, promise));
+  }
+
+  // Interrupt the loop.
+  interrupt();
+
+  return future;
+}
+
+} // namespace process {
+
+#endif // __IO_URING_HPP__
@@ -0,0 +1,148 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include <process/future.hpp>
+#include <process/io.hpp>
+#include <process/process.hpp> // For process::initialize.
+
+#include <stout/lambda.hpp>
+
+#include <stout/os/strerror.hpp>
+
+#include "io_uring.hpp"
+
+namespace process {
+
+// Data necessary for polling so we can discard polling and actually
+// stop it in the event loop. Only accessed within the event loop.
+struct Poll
+{
+  explicit Poll(short _events) : events(_events), operation(NULL) {}
+
+  const short events;
+
+  // The pending poll operation, or NULL once it has completed.
+  Operation* operation;
+
+  Promise<short> promise;
+};
+
+
+// Event loop callback when the poll operation completes.
+void polled(const std::shared_ptr<Poll>& poll, int result)
+{
+  poll->operation = NULL;
+
+  if (result == -ECANCELED) {
+    poll->promise.discard();
+    return;
+  } else if (result < 0) {
+    poll->promise.fail("Failed to poll: " + os::strerror(-result));
+    return;
+  }
+
+  // Like libev, report a hang up or an error as the requested
+  // readiness so that the subsequent I/O observes it.
+  short events = 0;
+
+  if ((poll->events & io::READ) && (result & (POLLIN | POLLHUP | POLLERR))) {
+    events |= io::READ;
+  }
+
+  if ((poll->events & io::WRITE) && (result & (POLLOUT | POLLHUP | POLLERR))) {
+    events |= io::WRITE;
+  }
+
+  poll->promise.set(events);
+}
+
+
+// Event loop callback when future associated with polling file
+// descriptor has been discarded.
+void discard_poll(const std::shared_ptr<Poll>& poll)
+{
+  // The poll has already completed, let it "win".
+  if (poll->operation == NULL) {
+    return;
+  }
+
+  // The removal itself completes without an operation, while the
+  // poll completes with -ECANCELED (see 'polled'). The removal is
+  // submitted right away, while the poll operation can not yet have
+  // been deleted (and its address reused by another operation).
+  struct io_uring_sqe* sqe = prepare();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<uint64_t>(poll->operation);
+
+  flush();
+}
+
+
+namespace io {
+namespace internal {
+
+// Helper/continuation of 'poll' on future discard.
+void _poll(const std::shared_ptr<Poll>& poll)
+{
+  run_in_event_loop<Nothing>([=]() {
+    discard_poll(poll);
+    return Nothing();
+  });
+}
+
+
+Future<short> poll(int fd, short events)
+{
+  std::shared_ptr<Poll> poll(new Poll(events));
+
+  // Get a copy of the future to avoid any races with the event loop.
+  Future<short> future = poll->promise.future();
+
+  poll->operation = new Operation(lambda::bind(&polled, poll, lambda::_1));
+
+  struct io_uring_sqe* sqe = prepare();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll_events =
+    ((events & io::READ) ? POLLIN : 0) | ((events & io::WRITE) ? POLLOUT : 0);
+  sqe->user_data = reinterpret_cast<uint64_t>(poll->operation);
+
+  // Make sure we stop polling if a discard occurs on our future.
+  // Note that it's possible that we'll invoke '_poll' when someone
+  // does a discard even after the polling has already completed, in
+  // which case 'discard_poll' does nothing.
+  future.onDiscard(lambda::bind(&_poll, poll));
+
+  return future;
+}
+
+} // namespace internal {
+
+
+Future<short> poll(int fd, short events)
+{
+  process::initialize();
+
+  // TODO(benh): Check if the file descriptor is non-blocking?
+
+  return run_in_event_loop<short>(lambda::bind(&internal::poll, fd, events));
+}
+
+} // namespace io {
+} // namespace process {
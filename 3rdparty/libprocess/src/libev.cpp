@@ -14,59 +14,55 @@
 
 #include <mutex>
 #include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glog/logging.h>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
 #include <stout/thread_local.hpp>
+#include <stout/try.hpp>
 
 #include "event_loop.hpp"
 #include "libev.hpp"
 
-namespace process {
+using std::string;
 
-ev_async async_watcher;
-// We need an asynchronous watcher to receive the request to shutdown.
-ev_async shutdown_watcher;
+namespace process {
 
 // Define the initial values for all of the declarations made in
 // libev.hpp (since these need to live in the static data space).
-struct ev_loop* loop = NULL;
-
-std::queue<ev_io*>* watchers = new std::queue<ev_io*>();
+std::vector<Loop*>* loops = new std::vector<Loop*>();
 
-std::mutex* watchers_mutex = new std::mutex();
+THREAD_LOCAL Loop* _loop_ = NULL;
 
-std::queue<lambda::function<void()>>* functions =
-  new std::queue<lambda::function<void()>>();
 
-THREAD_LOCAL bool* _in_event_loop_ = NULL;
-
-
-void handle_async(struct ev_loop* loop, ev_async* _, int revents)
+void handle_async(struct ev_loop* loop, ev_async* watcher, int revents)
 {
-  std::queue<lambda::function<void()>> run_functions;
-  synchronized (watchers_mutex) {
-    // Start all the new I/O watchers.
-    while (!watchers->empty()) {
-      ev_io* watcher = watchers->front();
-      watchers->pop();
-      ev_io_start(loop, watcher);
-    }
+  Loop* _loop = reinterpret_cast<Loop*>(watcher->data);
 
+  std::queue<lambda::function<void()>> run_functions;
+  synchronized (_loop->mutex) {
     // Swap the functions into a temporary queue so that we can invoke
     // them outside of the mutex.
-    std::swap(run_functions, *functions);
+    std::swap(run_functions, _loop->functions);
   }
 
   // Running the functions outside of the mutex reduces locking
   // contention as these are arbitrary functions that can take a long
   // time to execute. Doing this also avoids a deadlock scenario where
   // (A) mutexes are acquired before calling `run_in_event_loop`,
-  // followed by locking (B) `watchers_mutex`. If we executed the
+  // followed by locking (B) the loop's `mutex`. If we executed the
   // functions inside the mutex, then the locking order violation
-  // would be this function acquiring the (B) `watchers_mutex`
-  // followed by the arbitrary function acquiring the (A) mutexes.
+  // would be this function acquiring the (B) `mutex` followed by the
+  // arbitrary function acquiring the (A) mutexes.
   while (!run_functions.empty()) {
     (run_functions.front())();
     run_functions.pop();
@@ -82,13 +78,40 @@ void handle_shutdown(struct ev_loop* loop, ev_async* _, int revents)
 
 void EventLoop::initialize()
 {
-  loop = ev_default_loop(EVFLAG_AUTO);
+  // Check environment for the number of event loops. Every loop is
+  // run by its own thread, so that the I/O of many sockets is not
+  // bound by a single thread.
+  size_t count = 1;
+
+  Option<string> value = os::getenv("LIBPROCESS_NUM_EVENT_LOOPS");
+  if (value.isSome()) {
+    Try<size_t> number = numify<size_t>(value.get());
+    if (number.isError() || number.get() == 0) {
+      LOG(FATAL) << "LIBPROCESS_NUM_EVENT_LOOPS=" << value.get()
+                 << " is not a valid number of event loops";
+    }
+    count = number.get();
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    Loop* loop = new Loop();
+
+    // Only the default loop handles signals (e.g., for child watchers).
+    loop->loop = i == 0
+      ? ev_default_loop(EVFLAG_AUTO)
+      : ev_loop_new(EVFLAG_AUTO);
 
-  ev_async_init(&async_watcher, handle_async);
-  ev_async_init(&shutdown_watcher, handle_shutdown);
+    ev_async_init(&loop->async_watcher, handle_async);
+    ev_async_init(&loop->shutdown_watcher, handle_shutdown);
 
-  ev_async_start(loop, &async_watcher);
-  ev_async_start(loop, &shutdown_watcher);
+    loop->async_watcher.data = loop;
+    loop->shutdown_watcher.data = loop;
+
+    ev_async_start(loop->loop, &loop->async_watcher);
+    ev_async_start(loop->loop, &loop->shutdown_watcher);
+
+    loops->push_back(loop);
+  }
 }
 
 
@@ -125,7 +148,7 @@ Future<Nothing> delay(
   const double repeat = 0.0;
 
   ev_timer_init(timer, handle_delay, after, repeat);
-  ev_timer_start(loop, timer);
+  ev_timer_start(loops->front()->loop, timer);
 
   return Nothing();
 }
@@ -149,18 +172,38 @@ double EventLoop::time()
 }
 
 
+// Runs the given loop in the current thread until it is stopped.
+static void run_loop(Loop* loop)
+{
+  _loop_ = loop;
+
+  ev_loop(loop->loop, 0);
+
+  _loop_ = NULL;
+}
+
+
 void EventLoop::run()
 {
-  __in_event_loop__ = true;
+  // The additional loops are run by threads of their own, which are
+  // joined once all the loops have been stopped.
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < loops->size(); i++) {
+    threads.emplace_back(&run_loop, (*loops)[i]);
+  }
 
-  ev_loop(loop, 0);
+  run_loop(loops->front());
 
-  __in_event_loop__ = false;
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
 }
 
 void EventLoop::stop()
 {
-  ev_async_send(loop, &shutdown_watcher);
+  foreach (Loop* loop, *loops) {
+    ev_async_send(loop->loop, &loop->shutdown_watcher);
+  }
 }
 
 } // namespace process {
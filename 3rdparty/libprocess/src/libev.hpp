@@ -17,6 +17,7 @@
 
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
@@ -27,30 +28,42 @@
 
 namespace process {
 
-// Event loop.
-extern struct ev_loop* loop;
+// An event loop along with the watchers used to interrupt it. Each
+// loop is run by its own thread (see 'EventLoop::run').
+struct Loop
+{
+  struct ev_loop* loop;
+
+  // Asynchronous watcher for interrupting the loop to specifically
+  // deal with functions (via run_in_event_loop).
+  ev_async async_watcher;
 
-// Asynchronous watcher for interrupting loop to specifically deal
-// with IO watchers and functions (via run_in_event_loop).
-extern ev_async async_watcher;
+  // Asynchronous watcher to receive the request to shutdown.
+  ev_async shutdown_watcher;
 
-// Queue of I/O watchers to be asynchronously added to the event loop
-// (protected by 'watchers' below).
-// TODO(benh): Replace this queue with functions that we put in
-// 'functions' below that perform the ev_io_start themselves.
-extern std::queue<ev_io*>* watchers;
-extern std::mutex* watchers_mutex;
+  // Queue of functions to be invoked asynchronously within the loop
+  // (protected by 'mutex').
+  std::queue<lambda::function<void()>> functions;
+  std::mutex mutex;
+};
 
-// Queue of functions to be invoked asynchronously within the vent
-// loop (protected by 'watchers' above).
-extern std::queue<lambda::function<void()>>* functions;
+// The event loops (see LIBPROCESS_NUM_EVENT_LOOPS). The first one is
+// the default loop, which also runs the timers.
+extern std::vector<Loop*>* loops;
 
-// Per thread bool pointer. We use a pointer to lazily construct the
-// actual bool.
-extern THREAD_LOCAL bool* _in_event_loop_;
+// Per thread pointer to the loop run by the thread, if any.
+extern THREAD_LOCAL Loop* _loop_;
 
-#define __in_event_loop__ *(_in_event_loop_ == NULL ?                \
-  _in_event_loop_ = new bool(false) : _in_event_loop_)
+#define __in_event_loop__ (_loop_ != NULL)
+
+
+// Returns the loop which watches the given file descriptor. All the
+// I/O on a file descriptor is pinned to the same loop, which spreads
+// the sockets (and their callbacks) across the loops.
+inline Loop* pinned(int fd)
+{
+  return (*loops)[static_cast<size_t>(fd) % loops->size()];
+}
 
 
 // Wrapper around function we want to run in the event loop.
@@ -68,12 +81,14 @@ void _run_in_event_loop(
 }
 
 
-// Helper for running a function in the event loop.
+// Helper for running a function in the given event loop.
 template <typename T>
-Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
+Future<T> run_in_event_loop(
+    Loop* loop,
+    const lambda::function<Future<T>()>& f)
 {
   // If this is already the event loop then just run the function.
-  if (__in_event_loop__) {
+  if (_loop_ == loop) {
     return f();
   }
 
@@ -82,16 +97,24 @@ Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
   Future<T> future = promise->future();
 
   // Enqueue the function.
-  synchronized (watchers_mutex) {
-    functions->push(lambda::bind(&_run_in_event_loop<T>, f, promise));
+  synchronized (loop->mutex) {
+    loop->functions.push(lambda::bind(&_run_in_event_loop<T>, f, promise));
   }
 
   // Interrupt the loop.
-  ev_async_send(loop, &async_watcher);
+  ev_async_send(loop->loop, &loop->async_watcher);
 
   return future;
 }
 
+
+// Helper for running a function in the default event loop.
+template <typename T>
+Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
+{
+  return run_in_event_loop<T>(loops->front(), f);
+}
+
 } // namespace process {
 
 #endif // __LIBEV_HPP__
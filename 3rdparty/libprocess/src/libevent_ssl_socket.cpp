@@ -23,7 +23,12 @@
 #include <process/queue.hpp>
 #include <process/socket.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/histogram.hpp>
+#include <process/metrics/metrics.hpp>
+
 #include <stout/net.hpp>
+#include <stout/stringify.hpp>
 #include <stout/synchronized.hpp>
 
 #include "libevent.hpp"
@@ -76,6 +81,48 @@ static Synchronized<bufferevent> synchronize(bufferevent* bev)
 namespace process {
 namespace network {
 
+// Metrics of the SSL handshakes, of both the accepted and the
+// connected sockets.
+struct HandshakeMetrics
+{
+  HandshakeMetrics()
+    : handshakes("libprocess/ssl/handshakes"),
+      resumed_handshakes("libprocess/ssl/resumed_handshakes"),
+      failed_handshakes("libprocess/ssl/failed_handshakes"),
+      handshake_duration_ms("libprocess/ssl/handshake_duration_ms")
+  {
+    process::metrics::add(handshakes);
+    process::metrics::add(resumed_handshakes);
+    process::metrics::add(failed_handshakes);
+    process::metrics::add(handshake_duration_ms);
+  }
+
+  // Records a successful handshake.
+  void succeeded(SSL* ssl, const Duration& duration)
+  {
+    ++handshakes;
+
+    if (SSL_session_reused(ssl)) {
+      ++resumed_handshakes;
+    }
+
+    handshake_duration_ms.record(duration.ms());
+  }
+
+  process::metrics::Counter handshakes;
+  process::metrics::Counter resumed_handshakes;
+  process::metrics::Counter failed_handshakes;
+  process::metrics::Histogram handshake_duration_ms;
+};
+
+
+static HandshakeMetrics* metrics()
+{
+  static HandshakeMetrics* metrics = new HandshakeMetrics();
+  return metrics;
+}
+
+
 Try<std::shared_ptr<Socket::Impl>> LibeventSSLSocketImpl::create(int s)
 {
   openssl::initialize();
@@ -375,6 +422,8 @@ void LibeventSSLSocketImpl::event_callback(short events)
     }
 
     if (current_connect_request.get() != NULL) {
+      ++metrics()->failed_handshakes;
+
       SSL* ssl = bufferevent_openssl_get_ssl(CHECK_NOTNULL(bev));
       SSL_free(ssl);
       bufferevent_free(CHECK_NOTNULL(bev));
@@ -399,6 +448,7 @@ void LibeventSSLSocketImpl::event_callback(short events)
     Try<Nothing> verify = openssl::verify(ssl, peer_hostname);
     if (verify.isError()) {
       VLOG(1) << "Failed connect, verification error: " << verify.error();
+      ++metrics()->failed_handshakes;
       SSL_free(ssl);
       bufferevent_free(bev);
       bev = NULL;
@@ -406,6 +456,11 @@ void LibeventSSLSocketImpl::event_callback(short events)
       return;
     }
 
+    metrics()->succeeded(ssl, current_connect_request->handshake.elapsed());
+
+    // Keep the session so that reconnections to the peer resume it.
+    openssl::store(ssl, current_connect_request->peer);
+
     current_connect_request->promise.set(Nothing());
   } else if (events & BEV_EVENT_ERROR) {
     CHECK(EVUTIL_SOCKET_ERROR() != 0);
@@ -428,6 +483,8 @@ void LibeventSSLSocketImpl::event_callback(short events)
     }
 
     if (current_connect_request.get() != NULL) {
+      ++metrics()->failed_handshakes;
+
       SSL* ssl = bufferevent_openssl_get_ssl(CHECK_NOTNULL(bev));
       SSL_free(ssl);
       bufferevent_free(CHECK_NOTNULL(bev));
@@ -483,6 +540,10 @@ Future<Nothing> LibeventSSLSocketImpl::connect(const Address& address)
     return Failure("Failed to connect: SSL_new");
   }
 
+  // Resume the session last established with the peer, if any.
+  const string peer = stringify(address);
+  openssl::resume(ssl, peer);
+
   ssl_connect_fd = ::dup(get());
   if (ssl_connect_fd < 0) {
     return Failure("Failed to 'dup' socket for new openssl socket handle");
@@ -526,9 +587,11 @@ Future<Nothing> LibeventSSLSocketImpl::connect(const Address& address)
   }
 
   // Optimistically construct a 'ConnectRequest' and future.
-  Owned<ConnectRequest> request(new ConnectRequest());
+  Owned<ConnectRequest> request(new ConnectRequest(peer));
   Future<Nothing> future = request->promise.future();
 
+  request->handshake.start();
+
   // Assign 'connect_request' under lock, fail on error.
   synchronized (lock) {
     if (connect_request.get() != NULL) {
@@ -947,6 +1010,8 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
 {
   CHECK(__in_event_loop__);
 
+  request->handshake.start();
+
   // Set up SSL object.
   SSL* ssl = SSL_new(openssl::context());
   if (ssl == NULL) {
@@ -990,6 +1055,7 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
           reinterpret_cast<AcceptRequest*>(CHECK_NOTNULL(arg));
 
         if (events & BEV_EVENT_EOF) {
+          ++metrics()->failed_handshakes;
           request->promise.fail("Failed accept: connection closed");
         } else if (events & BEV_EVENT_CONNECTED) {
           // We will receive a 'CONNECTED' state on an accepting socket
@@ -1014,6 +1080,7 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
           Try<Nothing> verify = openssl::verify(ssl, peer_hostname);
           if (verify.isError()) {
             VLOG(1) << "Failed accept, verification error: " << verify.error();
+            ++metrics()->failed_handshakes;
             request->promise.fail(verify.error());
             SSL_free(ssl);
             bufferevent_free(bev);
@@ -1030,6 +1097,8 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
             return;
           }
 
+          metrics()->succeeded(ssl, request->handshake.elapsed());
+
           auto impl = std::shared_ptr<LibeventSSLSocketImpl>(
               new LibeventSSLSocketImpl(
                   request->socket,
@@ -1067,6 +1136,8 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
           // Fail the accept request and log the error.
           VLOG(1) << "Socket error: " << stream.str();
 
+          ++metrics()->failed_handshakes;
+
           SSL* ssl = bufferevent_openssl_get_ssl(CHECK_NOTNULL(bev));
           SSL_free(ssl);
           bufferevent_free(bev);
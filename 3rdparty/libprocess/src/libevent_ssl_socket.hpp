@@ -25,6 +25,8 @@
 #include <process/queue.hpp>
 #include <process/socket.hpp>
 
+#include <stout/stopwatch.hpp>
+
 namespace process {
 namespace network {
 
@@ -78,6 +80,9 @@ private:
     evconnlistener* listener;
     int socket;
     Option<net::IP> ip;
+
+    // Measures the handshake, see 'accept_SSL_callback'.
+    Stopwatch handshake;
   };
 
   struct RecvRequest
@@ -99,7 +104,15 @@ private:
 
   struct ConnectRequest
   {
+    explicit ConnectRequest(const std::string& _peer)
+      : peer(_peer) {}
     Promise<Nothing> promise;
+
+    // The peer whose session is resumed (see 'openssl::resume').
+    std::string peer;
+
+    // Measures the connection, including the handshake.
+    Stopwatch handshake;
   };
 
   // This is a private constructor used by the accept helper
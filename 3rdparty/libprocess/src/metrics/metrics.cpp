@@ -12,22 +12,39 @@
 
 #include <glog/logging.h>
 
+#include <cmath>
+#include <iomanip>
+#include <limits>
 #include <list>
+#include <map>
+#include <sstream>
 #include <string>
+#include <vector>
 
+#include <process/address.hpp>
 #include <process/collect.hpp>
 #include <process/dispatch.hpp>
 #include <process/help.hpp>
 #include <process/once.hpp>
 #include <process/process.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/histogram.hpp>
 #include <process/metrics/metrics.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/ip.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/strings.hpp>
+
+#include "statsd.hpp"
 
 using std::list;
+using std::map;
 using std::string;
+using std::vector;
 
 namespace process {
 namespace metrics {
@@ -58,7 +75,69 @@ MetricsProcess* MetricsProcess::instance()
 
 void MetricsProcess::initialize()
 {
+  // Check environment for how long to serve a complete snapshot.
+  Option<string> value = os::getenv("LIBPROCESS_METRICS_SNAPSHOT_TTL");
+  if (value.isSome()) {
+    Try<Duration> duration = Duration::parse(value.get());
+    if (duration.isError()) {
+      LOG(WARNING) << "Ignoring invalid LIBPROCESS_METRICS_SNAPSHOT_TTL '"
+                   << value.get() << "': " << duration.error();
+    } else {
+      ttl = duration.get();
+    }
+  }
+
   route("/snapshot", help(), &MetricsProcess::snapshot);
+  route("/prometheus", prometheusHelp(), &MetricsProcess::prometheus);
+
+  // Check environment for where to push the metrics to.
+  value = os::getenv("LIBPROCESS_METRICS_STATSD_ADDRESS");
+  if (value.isSome()) {
+    vector<string> tokens = strings::split(value.get(), ":");
+
+    Try<net::IP> ip = tokens.size() == 2
+      ? net::IP::parse(tokens[0], AF_INET)
+      : Try<net::IP>(Error("Expected <ip>:<port>"));
+
+    Try<uint16_t> port = tokens.size() == 2
+      ? numify<uint16_t>(tokens[1])
+      : Try<uint16_t>(Error("Expected <ip>:<port>"));
+
+    Duration interval = Seconds(10);
+
+    Option<string> interval_ =
+      os::getenv("LIBPROCESS_METRICS_STATSD_INTERVAL");
+    if (interval_.isSome()) {
+      Try<Duration> duration = Duration::parse(interval_.get());
+      if (duration.isError() || duration.get() <= Duration::zero()) {
+        LOG(WARNING) << "Ignoring invalid LIBPROCESS_METRICS_STATSD_INTERVAL '"
+                     << interval_.get() << "'";
+      } else {
+        interval = duration.get();
+      }
+    }
+
+    // The metric name prefixes to push, e.g., 'master/,allocator/'.
+    vector<string> prefixes;
+
+    Option<string> prefixes_ = os::getenv("LIBPROCESS_METRICS_STATSD_PREFIXES");
+    if (prefixes_.isSome()) {
+      prefixes = strings::tokenize(prefixes_.get(), ",");
+    }
+
+    if (ip.isError() || port.isError()) {
+      LOG(WARNING) << "Ignoring invalid LIBPROCESS_METRICS_STATSD_ADDRESS '"
+                   << value.get() << "': "
+                   << (ip.isError() ? ip.error() : port.error());
+    } else {
+      spawn(new StatsdProcess(
+                self(),
+                network::Address(ip.get(), port.get()),
+                interval,
+                prefixes),
+            true);
+    }
+  }
 }
 
 
@@ -78,6 +157,25 @@ string MetricsProcess::help()
 }
 
 
+string MetricsProcess::prometheusHelp()
+{
+  return HELP(
+      TLDR("Provides the current metrics in the Prometheus text format."),
+      DESCRIPTION(
+          "This endpoint provides the same metrics as the snapshot, in the ",
+          "Prometheus text exposition format (version 0.0.4).",
+          "",
+          "The characters of the metric names which are not allowed by ",
+          "Prometheus (e.g., '/') are replaced by '_'. Counters are exposed ",
+          "as counters, histograms as histograms and the other metrics as ",
+          "gauges.",
+          "",
+          "The optional query parameter 'timeout' determines the maximum ",
+          "amount of time the endpoint will take to respond. If the timeout ",
+          "is exceeded, some metrics may not be included in the response."));
+}
+
+
 Future<Nothing> MetricsProcess::add(Owned<Metric> metric)
 {
   if (metrics.contains(metric->name())) {
@@ -85,6 +183,8 @@ Future<Nothing> MetricsProcess::add(Owned<Metric> metric)
   }
 
   metrics[metric->name()] = metric;
+  cache = None();
+
   return Nothing();
 }
 
@@ -96,19 +196,40 @@ Future<Nothing> MetricsProcess::remove(const std::string& name)
   }
 
   metrics.erase(name);
+  cache = None();
 
   return Nothing();
 }
 
 
+hashmap<string, Owned<Metric>> MetricsProcess::registered()
+{
+  return metrics;
+}
+
+
 Future<http::Response> MetricsProcess::snapshot(const http::Request& request)
+{
+  // A recent complete snapshot is served without being rate limited.
+  if (cache.isSome() && Clock::now() - cache.get().first < ttl) {
+    return http::OK(cache.get().second, request.url.query.get("jsonp"));
+  }
+
+  return limiter.acquire()
+    .then(defer(self(), &Self::_snapshot, request, false));
+}
+
+
+Future<http::Response> MetricsProcess::prometheus(const http::Request& request)
 {
   return limiter.acquire()
-    .then(defer(self(), &Self::_snapshot, request));
+    .then(defer(self(), &Self::_snapshot, request, true));
 }
 
 
-Future<http::Response> MetricsProcess::_snapshot(const http::Request& request)
+Future<http::Response> MetricsProcess::_snapshot(
+    const http::Request& request,
+    bool prometheus)
 {
   // Parse the 'timeout' parameter.
   Option<Duration> timeout;
@@ -126,23 +247,44 @@ Future<http::Response> MetricsProcess::_snapshot(const http::Request& request)
     timeout = duration.get();
   }
 
+  // The metrics which hold their value (e.g., counters) are read
+  // directly, only the others (e.g., gauges) are waited for.
+  hashmap<string, double> values;
   hashmap<string, Future<double> > futures;
   hashmap<string, Option<Statistics<double> > > statistics;
 
-  foreachkey (const string& metric, metrics) {
-    CHECK_NOTNULL(metrics[metric].get());
-    futures[metric] = metrics[metric]->value();
+  foreachpair (const string& key, const Owned<Metric>& metric, metrics) {
+    CHECK_NOTNULL(metric.get());
+
+    Option<double> value = metric->current();
+    if (value.isSome()) {
+      values[key] = value.get();
+    } else {
+      futures[key] = metric->value();
+    }
+
     // TODO(dhamon): It would be nice to compute these asynchronously.
-    statistics[metric] = metrics[metric]->statistics();
+    statistics[key] = metric->statistics();
+  }
+
+  auto render = [=]() {
+    if (prometheus) {
+      return __prometheus(values, futures, statistics);
+    }
+    return __snapshot(request, timeout, values, futures, statistics);
+  };
+
+  if (futures.empty()) {
+    return render();
   }
 
   if (timeout.isSome()) {
     return await(futures.values())
       .after(timeout.get(), lambda::bind(_snapshotTimeout, futures.values()))
-      .then(lambda::bind(__snapshot, request, timeout, futures, statistics));
+      .then(defer(self(), render));
   } else {
     return await(futures.values())
-      .then(lambda::bind(__snapshot, request, timeout, futures, statistics));
+      .then(defer(self(), render));
   }
 }
 
@@ -156,14 +298,22 @@ list<Future<double> > MetricsProcess::_snapshotTimeout(
 }
 
 
-Future<http::Response> MetricsProcess::__snapshot(
+http::Response MetricsProcess::__snapshot(
     const http::Request& request,
     const Option<Duration>& timeout,
+    const hashmap<string, double>& values,
     const hashmap<string, Future<double> >& metrics,
     const hashmap<string, Option<Statistics<double> > >& statistics)
 {
   JSON::Object object;
 
+  // Whether all the metrics made it into the snapshot.
+  bool complete = true;
+
+  foreachpair (const string& key, double value, values) {
+    object.values[key] = value;
+  }
+
   foreachpair (const string& key, const Future<double>& value, metrics) {
     // TODO(dhamon): Maybe add the failure message for this metric to the
     // response if value.isFailed().
@@ -171,12 +321,15 @@ Future<http::Response> MetricsProcess::__snapshot(
       CHECK_SOME(timeout);
       VLOG(1) << "Exceeded timeout of " << timeout.get() << " when attempting "
               << "to get metric '" << key << "'";
+      complete = false;
     } else if (value.isReady()) {
       object.values[key] = value.get();
     }
+  }
 
-    Option<Statistics<double> > statistics_ = statistics.get(key).get();
-
+  foreachpair (const string& key,
+               const Option<Statistics<double> >& statistics_,
+               statistics) {
     if (statistics_.isSome()) {
       object.values[key + "/count"] = statistics_.get().count;
       object.values[key + "/min"] = statistics_.get().min;
@@ -190,9 +343,137 @@ Future<http::Response> MetricsProcess::__snapshot(
     }
   }
 
+  if (complete && ttl > Duration::zero()) {
+    cache = std::make_pair(Clock::now(), object);
+  }
+
   return http::OK(object, request.url.query.get("jsonp"));
 }
 
+
+// Returns 'name' with the characters which are not allowed in the
+// Prometheus metric names replaced by '_'.
+static string sanitize(const string& name)
+{
+  string result = name;
+
+  for (size_t i = 0; i < result.size(); i++) {
+    const char c = result[i];
+    if (!isalnum(c) && c != '_' && c != ':') {
+      result[i] = '_';
+    }
+  }
+
+  if (result.empty() || isdigit(result[0])) {
+    result = "_" + result;
+  }
+
+  return result;
+}
+
+
+// Returns 'value' as a Prometheus sample value.
+static string format(double value)
+{
+  if (std::isnan(value)) {
+    return "NaN";
+  } else if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+
+  std::ostringstream out;
+  out << std::setprecision(std::numeric_limits<double>::digits10) << value;
+  return out.str();
+}
+
+
+http::Response MetricsProcess::__prometheus(
+    const hashmap<string, double>& values,
+    const hashmap<string, Future<double> >& futures,
+    const hashmap<string, Option<Statistics<double> > >& statistics)
+{
+  // Sort the samples by name, so that the output is stable.
+  map<string, double> samples;
+
+  foreachpair (const string& key, double value, values) {
+    samples[key] = value;
+  }
+
+  foreachpair (const string& key, const Future<double>& value, futures) {
+    if (value.isReady()) {
+      samples[key] = value.get();
+    }
+  }
+
+  std::ostringstream out;
+
+  foreachpair (const string& key, double value, samples) {
+    const string name = sanitize(key);
+
+    // The metric may have been removed since it was collected.
+    const Metric* metric =
+      metrics.contains(key) ? metrics.at(key).get() : NULL;
+
+    const Histogram* histogram = dynamic_cast<const Histogram*>(metric);
+    if (histogram != NULL) {
+      out << "# TYPE " << name << " histogram\n";
+
+      // Only the buckets which have counted values are exposed, the
+      // counts being cumulative as Prometheus expects.
+      uint64_t count = 0;
+      for (size_t i = 0; i + 1 < Histogram::BUCKETS; i++) {
+        const uint64_t bucket = histogram->count(i);
+        if (bucket > 0) {
+          count += bucket;
+          out << name << "_bucket{le=\"" << format(Histogram::upper(i))
+              << "\"} " << count << "\n";
+        }
+      }
+
+      count += histogram->count(Histogram::BUCKETS - 1);
+
+      out << name << "_bucket{le=\"+Inf\"} " << count << "\n"
+          << name << "_sum " << format(histogram->sum()) << "\n"
+          << name << "_count " << count << "\n";
+
+      continue;
+    }
+
+    const char* type =
+      dynamic_cast<const Counter*>(metric) != NULL ? "counter" : "gauge";
+
+    out << "# TYPE " << name << " " << type << "\n"
+        << name << " " << format(value) << "\n";
+
+    // The statistics of the window of the metric are exposed as gauges.
+    if (statistics.contains(key) && statistics.at(key).isSome()) {
+      const Statistics<double>& statistics_ = statistics.at(key).get();
+
+      const std::pair<const char*, double> gauges[] = {
+        {"count", static_cast<double>(statistics_.count)},
+        {"min", statistics_.min},
+        {"max", statistics_.max},
+        {"p50", statistics_.p50},
+        {"p90", statistics_.p90},
+        {"p95", statistics_.p95},
+        {"p99", statistics_.p99},
+        {"p999", statistics_.p999},
+        {"p9999", statistics_.p9999}
+      };
+
+      foreach (const auto& gauge, gauges) {
+        out << "# TYPE " << name << "_" << gauge.first << " gauge\n"
+            << name << "_" << gauge.first << " " << format(gauge.second)
+            << "\n";
+      }
+    }
+  }
+
+  http::OK response(out.str());
+  response.headers["Content-Type"] = "text/plain; version=0.0.4";
+  return response;
+}
+
 }  // namespace internal {
 }  // namespace metrics {
 }  // namespace process {
@@ -0,0 +1,335 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <errno.h>
+
+#include <sys/socket.h>
+
+#include <glog/logging.h>
+
+#include <iomanip>
+#include <limits>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/network.hpp>
+
+#include <process/metrics/counter.hpp>
+#include <process/metrics/histogram.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/strings.hpp>
+
+#include "statsd.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace process {
+namespace metrics {
+namespace internal {
+
+// Returns 'name' as a StatsD metric name, i.e., with '/' replaced by
+// '.' and the characters which are part of the StatsD syntax (or
+// whitespace) replaced by '_'.
+static string sanitize(const string& name)
+{
+  string result = name;
+
+  for (size_t i = 0; i < result.size(); i++) {
+    const char c = result[i];
+    if (c == '/') {
+      result[i] = '.';
+    } else if (c == ':' || c == '|' || c == '@' || isspace(c)) {
+      result[i] = '_';
+    }
+  }
+
+  return result;
+}
+
+
+// Returns 'value' without losing precision (unlike 'stringify').
+static string format(double value)
+{
+  std::ostringstream out;
+  out << std::setprecision(std::numeric_limits<double>::digits10) << value;
+  return out.str();
+}
+
+
+StatsdProcess::StatsdProcess(
+    const PID<MetricsProcess>& _metrics,
+    const network::Address& _address,
+    const Duration& _interval,
+    const vector<string>& _prefixes)
+  : ProcessBase(process::ID::generate("__statsd__")),
+    metrics(_metrics),
+    address(_address),
+    interval(_interval),
+    prefixes(_prefixes),
+    s(-1) {}
+
+
+void StatsdProcess::initialize()
+{
+  s = ::socket(address.family(), SOCK_DGRAM, 0);
+  if (s < 0) {
+    PLOG(WARNING) << "Failed to create a socket for pushing metrics to "
+                  << "StatsD, not pushing any metrics";
+    return;
+  }
+
+  // A datagram which can not be sent right away is dropped rather
+  // than ever blocking the process.
+  Try<Nothing> nonblock = os::nonblock(s);
+  if (nonblock.isError()) {
+    LOG(WARNING) << "Failed to make the StatsD socket non-blocking, "
+                 << "not pushing any metrics: " << nonblock.error();
+    os::close(s);
+    s = -1;
+    return;
+  }
+
+  Try<Nothing> cloexec = os::cloexec(s);
+  if (cloexec.isError()) {
+    LOG(WARNING) << "Failed to set close-on-exec on the StatsD socket: "
+                 << cloexec.error();
+  }
+
+  // Connect the socket so that the datagrams can just be sent.
+  Try<int> connect = network::connect(s, address);
+  if (connect.isError()) {
+    LOG(WARNING) << "Failed to connect the StatsD socket, "
+                 << "not pushing any metrics: " << connect.error();
+    os::close(s);
+    s = -1;
+    return;
+  }
+
+  VLOG(1) << "Pushing metrics to StatsD at " << address
+          << " every " << interval;
+
+  delay(interval, self(), &Self::push);
+}
+
+
+void StatsdProcess::finalize()
+{
+  if (s >= 0) {
+    os::close(s);
+  }
+}
+
+
+void StatsdProcess::push()
+{
+  // Pushing at a fixed rate, even if a gauge took long to collect.
+  delay(interval, self(), &Self::push);
+
+  dispatch(metrics, &MetricsProcess::registered)
+    .onReady(defer(self(), &Self::_push, lambda::_1));
+}
+
+
+void StatsdProcess::_push(const hashmap<string, Owned<Metric>>& metrics)
+{
+  hashmap<string, Future<double>> futures;
+
+  foreachpair (const string& key, const Owned<Metric>& metric, metrics) {
+    if (!exported(key)) {
+      continue;
+    }
+
+    Option<double> value = metric->current();
+    if (value.isSome()) {
+      futures[key] = value.get();
+    } else {
+      futures[key] = metric->value();
+    }
+  }
+
+  // Give up on the metrics which can not be collected before the
+  // next push, they are just left out of this one.
+  await(futures.values())
+    .after(interval, [](const Future<list<Future<double>>>&) {
+      return list<Future<double>>();
+    })
+    .onAny(defer(self(), &Self::__push, metrics, futures));
+}
+
+
+void StatsdProcess::__push(
+    const hashmap<string, Owned<Metric>>& metrics,
+    const hashmap<string, Future<double>>& futures)
+{
+  hashmap<string, double> values;
+
+  foreachpair (const string& key, const Future<double>& value, futures) {
+    if (value.isReady()) {
+      values[key] = value.get();
+    }
+  }
+
+  send(lines(metrics, values));
+}
+
+
+vector<string> StatsdProcess::lines(
+    const hashmap<string, Owned<Metric>>& metrics,
+    const hashmap<string, double>& values)
+{
+  vector<string> result;
+
+  foreachpair (const string& key, double value, values) {
+    if (!metrics.contains(key)) {
+      continue;
+    }
+
+    const string name = sanitize(key);
+    const Metric* metric = metrics.at(key).get();
+
+    const Histogram* histogram = dynamic_cast<const Histogram*>(metric);
+    if (histogram != NULL) {
+      vector<uint64_t>& previous = histograms[key];
+      previous.resize(Histogram::BUCKETS, 0);
+
+      for (size_t i = 0; i < Histogram::BUCKETS; i++) {
+        // A bucket which went down belongs to a histogram which has
+        // been replaced, like for counters below.
+        const uint64_t count = histogram->count(i);
+        const uint64_t delta =
+          count >= previous[i] ? count - previous[i] : count;
+        previous[i] = count;
+
+        if (delta == 0) {
+          continue;
+        }
+
+        // The value counted 'delta' times, as a sample rate. The
+        // last bucket also counts all the larger values, it has no
+        // (finite) middle.
+        const double lower = i <= 1 ? 0 : Histogram::upper(i - 1);
+        const double middle = i + 1 == Histogram::BUCKETS
+          ? lower
+          : (lower + Histogram::upper(i)) / 2;
+
+        string line = name + ":" + format(middle) + "|ms";
+        if (delta > 1) {
+          line += "|@" + format(1.0 / delta);
+        }
+
+        result.push_back(line);
+      }
+
+      continue;
+    }
+
+    if (dynamic_cast<const Counter*>(metric) != NULL) {
+      // A counter which went down has been replaced (e.g., removed and
+      // added again), its whole value is a delta.
+      const double previous = counters.get(key).getOrElse(0);
+      const double delta = value >= previous ? value - previous : value;
+      counters[key] = value;
+
+      if (delta != 0) {
+        result.push_back(name + ":" + format(delta) + "|c");
+      }
+
+      continue;
+    }
+
+    // A gauge with a sign is a relative change for StatsD, so that a
+    // negative gauge must first be reset to zero.
+    if (value < 0) {
+      result.push_back(name + ":0|g");
+    }
+
+    result.push_back(name + ":" + format(value) + "|g");
+  }
+
+  // Forget the deltas of the metrics which have been removed.
+  foreach (const string& key, counters.keys()) {
+    if (!metrics.contains(key)) {
+      counters.erase(key);
+    }
+  }
+
+  foreach (const string& key, histograms.keys()) {
+    if (!metrics.contains(key)) {
+      histograms.erase(key);
+    }
+  }
+
+  return result;
+}
+
+
+void StatsdProcess::send(const vector<string>& lines)
+{
+  if (s < 0) {
+    return;
+  }
+
+  string datagram;
+
+  foreach (const string& line, lines) {
+    if (!datagram.empty() &&
+        datagram.size() + 1 + line.size() > MAX_DATAGRAM_SIZE) {
+      if (::send(s, datagram.data(), datagram.size(), 0) < 0) {
+        VLOG(1) << "Failed to push metrics to StatsD: "
+                << os::strerror(errno);
+      }
+      datagram.clear();
+    }
+
+    if (!datagram.empty()) {
+      datagram += '\n';
+    }
+
+    datagram += line;
+  }
+
+  if (!datagram.empty() &&
+      ::send(s, datagram.data(), datagram.size(), 0) < 0) {
+    VLOG(1) << "Failed to push metrics to StatsD: " << os::strerror(errno);
+  }
+}
+
+
+bool StatsdProcess::exported(const string& name) const
+{
+  if (prefixes.empty()) {
+    return true;
+  }
+
+  foreach (const string& prefix, prefixes) {
+    if (strings::startsWith(name, prefix)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace internal {
+} // namespace metrics {
+} // namespace process {
@@ -0,0 +1,107 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __METRICS_STATSD_HPP__
+#define __METRICS_STATSD_HPP__
+
+#include <stdint.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <process/address.hpp>
+#include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+#include <process/process.hpp>
+
+#include <process/metrics/metric.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
+
+namespace process {
+namespace metrics {
+namespace internal {
+
+// Periodically pushes the metrics of the MetricsProcess to a StatsD
+// server over UDP, so that they don't need to be scraped from
+// '/metrics/snapshot' (see LIBPROCESS_METRICS_STATSD_ADDRESS):
+//
+//   * Counters are pushed as StatsD counters, i.e., as the delta
+//     since the previous push (only if they changed).
+//   * Histograms are pushed as StatsD timers, i.e., the values
+//     counted in each bucket since the previous push are sent as the
+//     middle of the bucket with the corresponding sample rate.
+//   * The other metrics are pushed as StatsD gauges.
+//
+// The '/' of the metric names are replaced by '.', as StatsD expects.
+// Only the metrics whose name starts with one of 'prefixes' (if any)
+// are pushed.
+class StatsdProcess : public Process<StatsdProcess>
+{
+public:
+  // The maximum size of a datagram, so that it fits in the MTU of
+  // most networks.
+  static const size_t MAX_DATAGRAM_SIZE = 1432;
+
+  StatsdProcess(
+      const PID<MetricsProcess>& metrics,
+      const network::Address& address,
+      const Duration& interval,
+      const std::vector<std::string>& prefixes);
+
+  virtual ~StatsdProcess() {}
+
+protected:
+  virtual void initialize();
+  virtual void finalize();
+
+private:
+  void push();
+  void _push(const hashmap<std::string, Owned<Metric>>& metrics);
+  void __push(
+      const hashmap<std::string, Owned<Metric>>& metrics,
+      const hashmap<std::string, Future<double>>& futures);
+
+  // Returns the StatsD lines for the given metrics, updating the
+  // values remembered for computing the deltas.
+  std::vector<std::string> lines(
+      const hashmap<std::string, Owned<Metric>>& metrics,
+      const hashmap<std::string, double>& values);
+
+  // Sends the lines, batched into as few datagrams as possible.
+  void send(const std::vector<std::string>& lines);
+
+  bool exported(const std::string& name) const;
+
+  const PID<MetricsProcess> metrics;
+  const network::Address address;
+  const Duration interval;
+  const std::vector<std::string> prefixes;
+
+  // The (connected) UDP socket, or -1 if it could not be created.
+  int s;
+
+  // The values of the counters and the bucket counts of the
+  // histograms as of the previous push.
+  hashmap<std::string, double> counters;
+  hashmap<std::string, std::vector<uint64_t>> histograms;
+};
+
+} // namespace internal {
+} // namespace metrics {
+} // namespace process {
+
+#endif // __METRICS_STATSD_HPP__
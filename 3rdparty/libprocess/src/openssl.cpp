@@ -26,6 +26,9 @@
 #include <process/once.hpp>
 
 #include <stout/flags.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/synchronized.hpp>
 
 using std::ostringstream;
 using std::string;
@@ -46,6 +49,13 @@ namespace openssl {
 // _Global_ OpenSSL context, initialized via 'initialize'.
 static SSL_CTX* ctx = NULL;
 
+// The sessions established as a client, keyed by peer (see 'resume'
+// and 'store'), protected by 'sessions_mutex'.
+static hashmap<string, SSL_SESSION*>* sessions =
+  new hashmap<string, SSL_SESSION*>();
+
+static std::mutex* sessions_mutex = new std::mutex();
+
 
 Flags::Flags()
 {
@@ -127,6 +137,21 @@ Flags::Flags()
       "enable_tls_v1_2",
       "Enable SSLV1.2.",
       true);
+
+  add(&Flags::session_cache_size,
+      "session_cache_size",
+      "Maximum number of sessions which are cached, both by the accepting "
+      "sockets for the clients and by the connecting sockets for the "
+      "servers, so that reconnections can resume them with an abbreviated "
+      "handshake. Session tickets are used as well unless this is 0, which "
+      "disables session resumption.",
+      20480);
+
+  add(&Flags::session_timeout,
+      "session_timeout",
+      "Duration after which a cached session (or a session ticket) can no "
+      "longer be resumed.",
+      Minutes(5));
 }
 
 
@@ -339,12 +364,30 @@ void reinitialize()
   CHECK(ctx) << "Failed to create SSL context: "
              << ERR_error_string(ERR_get_error(), NULL);
 
-  // Disable SSL session caching.
-  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  // The sessions of the previous context can not be resumed.
+  synchronized (sessions_mutex) {
+    foreachvalue (SSL_SESSION* session, *sessions) {
+      SSL_SESSION_free(session);
+    }
+    sessions->clear();
+  }
+
+  // Cache the sessions of the accepted connections, and let OpenSSL
+  // issue session tickets, so that reconnecting clients (e.g., many
+  // agents after a master failover) can resume their sessions rather
+  // than each doing a full handshake. The sessions of the connecting
+  // sockets are cached by 'store', since OpenSSL's client cache does
+  // not look sessions up by peer.
+  if (ssl_flags->session_cache_size > 0) {
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, ssl_flags->session_cache_size);
+    SSL_CTX_set_timeout(ctx, ssl_flags->session_timeout.secs());
+  } else {
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  }
 
-  // Set a session id to avoid connection termination upon
-  // re-connect. We can use something more relevant when we care
-  // about session caching.
+  // Set a session id context, which the sessions cached by the
+  // accepting sockets are bound to.
   const uint64_t session_ctx = 7;
 
   const unsigned char* session_id =
@@ -492,11 +535,17 @@ void reinitialize()
       SSL_OP_NO_SSLv3 |
       SSL_OP_NO_TLSv1 |
       SSL_OP_NO_TLSv1_1 |
-      SSL_OP_NO_TLSv1_2);
+      SSL_OP_NO_TLSv1_2 |
+      SSL_OP_NO_TICKET);
 
   // Use server preference for cipher.
   long ssl_options = SSL_OP_CIPHER_SERVER_PREFERENCE;
 
+  // Session tickets are a means of resumption as well.
+  if (ssl_flags->session_cache_size == 0) {
+    ssl_options |= SSL_OP_NO_TICKET;
+  }
+
   // Always disable SSLv2. We do this because most systems have
   // disabled SSLv2 at compilation due to having so many security
   // vulnerabilities.
@@ -538,6 +587,43 @@ SSL_CTX* context()
 }
 
 
+void resume(SSL* ssl, const string& peer)
+{
+  synchronized (sessions_mutex) {
+    if (sessions->contains(peer)) {
+      // NOTE: 'SSL_set_session' takes its own reference.
+      SSL_set_session(ssl, sessions->at(peer));
+    }
+  }
+}
+
+
+void store(SSL* ssl, const string& peer)
+{
+  if (ssl_flags->session_cache_size == 0) {
+    return;
+  }
+
+  SSL_SESSION* session = SSL_get1_session(ssl);
+  if (session == NULL) {
+    return;
+  }
+
+  synchronized (sessions_mutex) {
+    if (sessions->contains(peer)) {
+      SSL_SESSION_free(sessions->at(peer));
+      sessions->erase(peer);
+    } else if (sessions->size() >= ssl_flags->session_cache_size) {
+      // Evict an arbitrary session to bound the cache.
+      SSL_SESSION_free(sessions->begin()->second);
+      sessions->erase(sessions->begin());
+    }
+
+    sessions->put(peer, session);
+  }
+}
+
+
 Try<Nothing> verify(const SSL* const ssl, const Option<string>& hostname)
 {
   // Return early if we don't need to verify.
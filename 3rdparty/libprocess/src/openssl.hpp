@@ -17,6 +17,7 @@
 
 #include <string>
 
+#include <stout/duration.hpp>
 #include <stout/flags.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
@@ -47,6 +48,8 @@ public:
   bool enable_tls_v1_0;
   bool enable_tls_v1_1;
   bool enable_tls_v1_2;
+  size_t session_cache_size;
+  Duration session_timeout;
 };
 
 const Flags& flags();
@@ -69,6 +72,8 @@ const Flags& flags();
 //    SSL_ENABLE_TLS_V1_0=(false|0,true|1)
 //    SSL_ENABLE_TLS_V1_1=(false|0,true|1)
 //    SSL_ENABLE_TLS_V1_2=(false|0,true|1)
+//    SSL_SESSION_CACHE_SIZE=(20480)
+//    SSL_SESSION_TIMEOUT=(5mins)
 //
 // TODO(benh): When/If we need to support multiple contexts in the
 // same process, for example for Server Name Indication (SNI), then
@@ -80,6 +85,15 @@ void initialize();
 // Returns the _global_ OpenSSL context.
 SSL_CTX* context();
 
+// Sets the session last established with the peer (if any) on the
+// connecting SSL connection, so that the handshake resumes it rather
+// than doing a full handshake with the peer again.
+void resume(SSL* ssl, const std::string& peer);
+
+// Keeps the session of the established (connected) SSL connection,
+// so that the subsequent connections to the peer can resume it.
+void store(SSL* ssl, const std::string& peer);
+
 // Verify that the hostname is properly associated with the peer
 // certificate associated with the specified SSL connection.
 Try<Nothing> verify(const SSL* const ssl, const Option<std::string>& hostname);
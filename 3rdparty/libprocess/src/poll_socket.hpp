@@ -11,6 +11,7 @@
 // limitations under the License
 
 #include <memory>
+#include <vector>
 
 #include <process/socket.hpp>
 
@@ -35,6 +36,7 @@ public:
   virtual Future<size_t> recv(char* data, size_t size);
   virtual Future<size_t> send(const char* data, size_t size);
   virtual Future<size_t> sendfile(int fd, off_t offset, size_t size);
+  virtual Future<size_t> send(const std::vector<struct iovec>& buffers);
 
   virtual Socket::Kind kind() const { return Socket::POLL; }
 };
@@ -23,6 +23,8 @@
 
 #include <arpa/inet.h>
 
+#include <cxxabi.h>
+
 #include <glog/logging.h>
 
 #include <netinet/in.h>
@@ -80,9 +82,12 @@
 #include <process/timer.hpp>
 
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/gzip.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
@@ -105,6 +110,7 @@
 #include "openssl.hpp"
 #endif
 #include "process_reference.hpp"
+#include "processes.hpp"
 
 namespace firewall = process::firewall;
 namespace metrics = process::metrics;
@@ -228,6 +234,9 @@ private:
 
   Option<http::Pipe::Reader> pipe; // Current pipe, if streaming.
 
+  // Compresses the current pipe, if the client accepts gzip.
+  Owned<gzip::Compressor> compressor;
+
   // We sequence the authentication results exposed to the caller
   // in order to satisfy HTTP pipelining.
   //
@@ -304,7 +313,7 @@ public:
   PID<HttpProxy> proxy(const Socket& socket);
 
   void send(Encoder* encoder, bool persist);
-  void send(const Response& response,
+  void send(const Future<Response>& response,
             const Request& request,
             const Socket& socket);
   void send(Message* message,
@@ -312,6 +321,20 @@ public:
 
   Encoder* next(int s);
 
+  // Whether the connection of a peer listening on the address can be
+  // used to send messages to it. The socket is the accepted one on
+  // which the peer negotiated the framing.
+  bool shareable(const Socket& socket, const Address& address);
+
+  // Uses the connection of the peer as the persistent socket for the
+  // messages to it, as if we were linking to it, unless it's no
+  // longer 'shareable'.
+  void share(const Socket& socket, const Address& address);
+
+  // Invoked once the peer responded to the framing negotiation on
+  // the socket (see 'negotiate').
+  void negotiated(const Socket& socket, bool binary);
+
   void close(int s);
 
   void exited(const Address& address);
@@ -350,6 +373,23 @@ private:
       Socket* socket,
       Message* message);
 
+  // Asks the peer of a newly connected socket whether it supports the
+  // binary framing of messages (see FramedMessageEncoder). Messages
+  // are held back in 'negotiating' until the peer has responded.
+  void negotiate(Socket* socket);
+
+  // Returns an encoder for the message using the framing that was
+  // negotiated for the socket.
+  Encoder* encode(const Socket& socket, Message* message);
+
+  // Whether to negotiate the binary framing on the sockets we
+  // connect (see LIBPROCESS_ENABLE_BINARY_FRAMING).
+  bool framing;
+
+  // Whether to offer and accept sharing the connections of links
+  // (see LIBPROCESS_ENABLE_SHARED_CONNECTIONS).
+  bool sharing;
+
   // Collection of all actice sockets.
   map<int, Socket*> sockets;
 
@@ -375,6 +415,13 @@ private:
   // Map from socket to outgoing queue.
   map<int, queue<Encoder*>> outgoing;
 
+  // Map from socket to the messages waiting for the framing
+  // negotiation on that socket to complete.
+  map<int, deque<Message*>> negotiating;
+
+  // Sockets on which messages are sent using the binary framing.
+  set<int> framed;
+
   // HTTP proxies.
   map<int, HttpProxy*> proxies;
 
@@ -412,6 +459,15 @@ public:
   UPID spawn(ProcessBase* process, bool manage);
   void resume(ProcessBase* process);
   void cleanup(ProcessBase* process);
+
+  // Records the time 'event' (or the batch of messages it is the
+  // first of) waited in the queue of the process and took to serve.
+  void record(
+      ProcessBase* process,
+      const Event& event,
+      const vector<const MessageEvent*>& batch,
+      uint64_t started,
+      uint64_t stopped);
   void link(ProcessBase* process, const UPID& to);
   void terminate(const UPID& pid, bool inject, ProcessBase* sender = NULL);
   bool wait(const UPID& pid);
@@ -424,9 +480,17 @@ public:
 
   void settle();
 
+  // Returns true if the processing threads keep their own run queues
+  // and steal work from each other (see LIBPROCESS_WORK_STEALING).
+  bool stealing() const { return !runqs.empty(); }
+
   // The /__processes__ route.
   Future<Response> __processes__(const Request&);
 
+  // Returns the processes which are currently spawned (see
+  // internal::processes).
+  hashmap<const ProcessBase*, internal::Spawned> spawned();
+
 private:
   // Delegate process name to receive root HTTP requests.
   const string delegate;
@@ -442,6 +506,26 @@ private:
   list<ProcessBase*> runq;
   std::recursive_mutex runq_mutex;
 
+  // Per processing thread queue of runnable processes. Only used when
+  // work stealing is enabled, in which case 'runq' is always empty.
+  // A thread pops from the front of its own queue and, when that is
+  // empty, steals from the back of the queues of the other threads.
+  struct RunQueue
+  {
+    std::deque<ProcessBase*> processes;
+    std::mutex mutex;
+  };
+
+  vector<RunQueue*> runqs;
+
+  // Used to spread processes without any affinity across 'runqs'.
+  std::atomic_ulong next;
+
+  // Helpers for the work stealing scheduler mode. Both must be called
+  // with the corresponding 'RunQueue::mutex' held.
+  bool remove(RunQueue* runq, ProcessBase* process);
+  ProcessBase* pop(RunQueue* runq, bool steal);
+
   // Number of running processes, to support Clock::settle operation.
   std::atomic_long running;
 
@@ -496,9 +580,84 @@ PID<Help> help;
 // Per thread process pointer.
 THREAD_LOCAL ProcessBase* __process__ = NULL;
 
+// Per thread index of the processing thread, or -1 if this thread is
+// not one of the processing threads of the ProcessManager.
+static THREAD_LOCAL int __worker__ = -1;
+
 // Per thread executor pointer.
 THREAD_LOCAL Executor* _executor_ = NULL;
 
+// Whether the events of the processes are instrumented (see
+// LIBPROCESS_INSTRUMENT_EVENTS).
+static std::atomic_bool instrument(false);
+
+
+// Returns the time on a monotonic clock, in nanoseconds, for timing
+// the events when they are instrumented.
+static uint64_t monotonic()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+// Returns the (demangled, if possible) name of a type.
+static string demangle(const std::type_info* type)
+{
+  int status;
+  char* name = abi::__cxa_demangle(type->name(), NULL, NULL, &status);
+  if (name == NULL) {
+    return type->name();
+  }
+
+  string result(name);
+  free(name);
+  return result;
+}
+
+
+// Statistics of the events served by a process, keyed by the name of
+// the message, the type of the dispatched method, or the HTTP path.
+struct ProcessBase::Instrumentation
+{
+  struct Handler
+  {
+    Handler()
+      : count(0),
+        latency(0),
+        maxLatency(0),
+        duration(0),
+        maxDuration(0) {}
+
+    void record(uint64_t _latency, uint64_t _duration)
+    {
+      count++;
+      latency += _latency;
+      maxLatency = std::max(maxLatency, _latency);
+      duration += _duration;
+      maxDuration = std::max(maxDuration, _duration);
+    }
+
+    uint64_t count;
+
+    // The time the events waited in the queue, in nanoseconds.
+    uint64_t latency;
+    uint64_t maxLatency;
+
+    // The time spent serving the events, in nanoseconds.
+    uint64_t duration;
+    uint64_t maxDuration;
+  };
+
+  // Held by the process while it records an event, and by the
+  // /__processes__ route while it reads the statistics.
+  std::mutex mutex;
+
+  hashmap<string, Handler> events;
+  hashmap<const std::type_info*, Handler> dispatches;
+};
+
 
 namespace http {
 namespace authentication {
@@ -625,8 +784,122 @@ static Message* parse(Request* request)
 }
 
 
+// Path and header of the request sent to negotiate the binary framing
+// of messages on a new connection (see SocketManager::negotiate).
+// Peers that don't know about it respond with '404 Not Found', in
+// which case we continue to send messages as HTTP requests.
+static const char FRAMING_PATH[] = "/__framing__";
+static const char FRAMING_HEADER[] = "Libprocess-Framing";
+
+
+// Returns true if the request asks to switch the rest of the
+// connection to the binary framing.
+static bool negotiation(const Request& request)
+{
+  return request.method == "GET" &&
+    request.url.path == FRAMING_PATH &&
+    request.headers.get(FRAMING_HEADER).getOrElse("") == "binary";
+}
+
+
+// Header of the negotiation request with which a linking peer offers
+// to share its connection, i.e., to receive the messages we send to it
+// on the same connection rather than on one we would open to it. The
+// value is the address the peer is listening on. Our response carries
+// the header with the value 'shared' if we accept.
+static const char CHANNEL_HEADER[] = "Libprocess-Channel";
+
+
+// Returns the address the sender of a negotiation request is
+// listening on, if it offers to share its connection.
+static Option<Address> channel(const Request& request)
+{
+  Option<string> value = request.headers.get(CHANNEL_HEADER);
+  if (value.isNone()) {
+    return None();
+  }
+
+  vector<string> tokens = strings::split(value.get(), ":");
+  if (tokens.size() != 2) {
+    return None();
+  }
+
+  Try<net::IP> ip = net::IP::parse(tokens[0], AF_INET);
+  Try<uint16_t> port = numify<uint16_t>(tokens[1]);
+  if (ip.isError() || port.isError()) {
+    return None();
+  }
+
+  return Address(ip.get(), port.get());
+}
+
+
 namespace internal {
 
+// Decodes and delivers the framed messages in the data, returns false
+// if the decoder failed.
+bool deliver_framed(
+    FramedMessageDecoder* decoder,
+    const char* data,
+    size_t length)
+{
+  const deque<Message*> messages = decoder->decode(data, length);
+
+  foreach (Message* message, messages) {
+    message->to = UPID(message->to.id, __address__);
+
+    VLOG(2) << "Decoded message '" << message->name
+            << "' for " << message->to << " from " << message->from;
+
+    process_manager->deliver(message->to, new MessageEvent(message));
+  }
+
+  return !decoder->failed();
+}
+
+
+void decode_framed_recv(
+    const Future<size_t>& length,
+    char* data,
+    size_t size,
+    Socket* socket,
+    FramedMessageDecoder* decoder)
+{
+  if (length.isDiscarded() || length.isFailed()) {
+    if (length.isFailed()) {
+      VLOG(1) << "Decode failure: " << length.failure();
+    }
+
+    socket_manager->close(*socket);
+    delete[] data;
+    delete decoder;
+    delete socket;
+    return;
+  }
+
+  if (length.get() == 0) {
+    socket_manager->close(*socket);
+    delete[] data;
+    delete decoder;
+    delete socket;
+    return;
+  }
+
+  if (!deliver_framed(decoder, data, length.get())) {
+     VLOG(1) << "Decoder error while receiving framed messages";
+     socket_manager->close(*socket);
+     delete[] data;
+     delete decoder;
+     delete socket;
+     return;
+  }
+
+  socket->recv(data, size)
+    .onAny(lambda::bind(
+        &decode_framed_recv, lambda::_1, data, size, socket, decoder));
+}
+
+
 void decode_recv(
     const Future<size_t>& length,
     char* data,
@@ -680,10 +953,61 @@ void decode_recv(
       return;
     }
 
+    bool framed = false;
+
     foreach (Request* request, requests) {
+      // A peer asking for the binary framing doesn't send anything
+      // else until it gets our response, so we can switch decoders
+      // once we've responded.
+      if (negotiation(*request)) {
+        VLOG(2) << "Switching to binary framing for messages from "
+                << address.get();
+
+        // Only a peer at the IP the connection comes from can share
+        // it, its port is the one it listens on rather than the one
+        // it connects from.
+        Option<Address> peer = channel(*request);
+        bool shared = peer.isSome() &&
+          peer.get().ip == address.get().ip &&
+          socket_manager->shareable(decoder->socket(), peer.get());
+
+        socket_manager->send(
+            new DataEncoder(
+                decoder->socket(),
+                string("HTTP/1.1 200 OK\r\n") +
+                FRAMING_HEADER + ": binary\r\n" +
+                (shared ? string(CHANNEL_HEADER) + ": shared\r\n" : "") +
+                "Content-Length: 0\r\n\r\n"),
+            true);
+
+        // Messages to the peer may only go out after the response,
+        // which is already queued (or sent) on the socket now.
+        if (shared) {
+          socket_manager->share(decoder->socket(), peer.get());
+        }
+
+        framed = true;
+        delete request;
+        continue;
+      }
+
       request->client = address.get();
       process_manager->handle(decoder->socket(), request);
     }
+
+    if (framed) {
+      delete decoder;
+
+      socket->recv(data, size)
+        .onAny(lambda::bind(
+            &decode_framed_recv,
+            lambda::_1,
+            data,
+            size,
+            socket,
+            new FramedMessageDecoder()));
+      return;
+    }
   }
 
   socket->recv(data, size)
@@ -838,6 +1162,14 @@ void initialize(const string& delegate)
   }
 #endif
 
+  // Check environment for whether to instrument the events of the
+  // processes, which costs a few clock reads per event.
+  Option<string> instrumentation = os::getenv("LIBPROCESS_INSTRUMENT_EVENTS");
+  if (instrumentation.isSome() &&
+      (instrumentation.get() == "1" || instrumentation.get() == "true")) {
+    instrument.store(true);
+  }
+
   // Create a new ProcessManager and SocketManager.
   process_manager = new ProcessManager(delegate);
   socket_manager = new SocketManager();
@@ -1141,10 +1473,10 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
     return true; // All done, can process next response.
   }
 
-  Response response = future.get();
-
   // If the response specifies a path, try and perform a sendfile.
-  if (response.type == Response::PATH) {
+  if (future.get().type == Response::PATH) {
+    Response response = future.get();
+
     // Make sure no body is sent (this is really an error and
     // should be reported and no response sent.
     response.body.clear();
@@ -1195,7 +1527,9 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
             request.keepAlive);
       }
     }
-  } else if (response.type == Response::PIPE) {
+  } else if (future.get().type == Response::PIPE) {
+    Response response = future.get();
+
     // Make sure no body is sent (this is really an error and
     // should be reported and no response sent.
     response.body.clear();
@@ -1204,6 +1538,14 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
     // header, we fill in (or overwrite) 'Transfer-Encoding' header.
     response.headers["Transfer-Encoding"] = "chunked";
 
+    // Like bodies (see HttpResponseEncoder), streams are compressed
+    // if the client accepts it, but a chunk at a time (see 'stream').
+    if (!response.headers.contains("Content-Encoding") &&
+        request.acceptsEncoding("gzip")) {
+      response.headers["Content-Encoding"] = "gzip";
+      compressor.reset(new gzip::Compressor());
+    }
+
     VLOG(3) << "Starting \"chunked\" streaming";
 
     socket_manager->send(
@@ -1220,7 +1562,9 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
 
     return false; // Streaming, don't process next response (yet)!
   } else {
-    socket_manager->send(response, request, socket);
+    // Send the response straight from the future so that its body,
+    // which can be large, isn't copied (see HttpResponseEncoder).
+    socket_manager->send(future, request, socket);
   }
 
   return true; // All done, can process next response.
@@ -1237,18 +1581,34 @@ void HttpProxy::stream(
 
   bool finished = false; // Whether we're done streaming.
 
-  if (chunk.isReady()) {
+  // The end of a compressed stream also needs to end the
+  // compression (i.e., write the gzip trailer).
+  Try<string> data = chunk.isReady() ? chunk.get() : "";
+  if (chunk.isReady() && compressor.get() != NULL) {
+    data = chunk.get().empty()
+      ? compressor->finish()
+      : compressor->compress(chunk.get());
+  }
+
+  if (chunk.isReady() && data.isError()) {
+    VLOG(1) << "Failed to compress stream: " << data.error();
+    // TODO(bmahler): Have to close connection if headers were sent!
+    socket_manager->send(InternalServerError(), request, socket);
+    finished = true;
+  } else if (chunk.isReady()) {
     std::ostringstream out;
 
+    if (!data.get().empty()) {
+      out << std::hex << data.get().size() << "\r\n";
+      out << data.get();
+      out << "\r\n";
+    }
+
     if (chunk.get().empty()) {
       // Finished reading.
       out << "0\r\n" << "\r\n";
       finished = true;
     } else {
-      out << std::hex << chunk.get().size() << "\r\n";
-      out << chunk.get();
-      out << "\r\n";
-
       // Keep reading.
       reader.read()
         .onAny(defer(self(), &Self::stream, request, lambda::_1));
@@ -1273,12 +1633,28 @@ void HttpProxy::stream(
   if (finished) {
     reader.close();
     pipe = None();
+    compressor.reset();
     next();
   }
 }
 
 
-SocketManager::SocketManager() {}
+SocketManager::SocketManager() : framing(false), sharing(false)
+{
+  // Check environment for whether to negotiate the binary framing of
+  // messages with our peers.
+  Option<string> value = os::getenv("LIBPROCESS_ENABLE_BINARY_FRAMING");
+  if (value.isSome() && (value.get() == "1" || value.get() == "true")) {
+    framing = true;
+  }
+
+  // Check environment for whether to share the connections of links
+  // with our peers (see CHANNEL_HEADER).
+  value = os::getenv("LIBPROCESS_ENABLE_SHARED_CONNECTIONS");
+  if (value.isSome() && (value.get() == "1" || value.get() == "true")) {
+    sharing = true;
+  }
+}
 
 
 SocketManager::~SocketManager() {}
@@ -1319,6 +1695,99 @@ void ignore_recv_data(
 }
 
 
+void negotiate_recv(
+    const Future<size_t>& length,
+    Socket* socket,
+    char* data,
+    size_t size,
+    ResponseDecoder* decoder,
+    string* received)
+{
+  if (length.isDiscarded() || length.isFailed() || length.get() == 0) {
+    socket_manager->close(*socket);
+    delete[] data;
+    delete decoder;
+    delete received;
+    delete socket;
+    return;
+  }
+
+  received->append(data, length.get());
+
+  deque<Response*> responses = decoder->decode(data, length.get());
+
+  if (responses.empty()) {
+    if (decoder->failed()) {
+      VLOG(1) << "Decoder error while negotiating framing";
+      socket_manager->close(*socket);
+      delete[] data;
+      delete decoder;
+      delete received;
+      delete socket;
+      return;
+    }
+
+    socket->recv(data, size)
+      .onAny(lambda::bind(
+          &negotiate_recv, lambda::_1, socket, data, size, decoder, received));
+    return;
+  }
+
+  // Peers that don't support the binary framing treat the
+  // negotiation as any other HTTP request (e.g., '404 Not Found').
+  const Response* response = responses.front();
+
+  bool binary = response->code == http::Status::OK &&
+    response->headers.get(FRAMING_HEADER).getOrElse("") == "binary";
+
+  bool shared = binary &&
+    response->headers.get(CHANNEL_HEADER).getOrElse("") == "shared";
+
+  foreach (Response* response, responses) {
+    delete response;
+  }
+
+  delete decoder;
+
+  socket_manager->negotiated(*socket, binary);
+
+  if (shared) {
+    VLOG(1) << "Receiving messages from the peer on the shared connection";
+
+    // The peer may send framed messages right after its response,
+    // which has no body, so we decode whatever was received after it.
+    const size_t end = received->find("\r\n\r\n");
+    CHECK_NE(string::npos, end);
+
+    const string rest = received->substr(end + 4);
+    delete received;
+
+    FramedMessageDecoder* framed = new FramedMessageDecoder();
+
+    if (!deliver_framed(framed, rest.data(), rest.size())) {
+      VLOG(1) << "Decoder error while receiving framed messages";
+      socket_manager->close(*socket);
+      delete[] data;
+      delete framed;
+      delete socket;
+      return;
+    }
+
+    socket->recv(data, size)
+      .onAny(lambda::bind(
+          &decode_framed_recv, lambda::_1, data, size, socket, framed));
+    return;
+  }
+
+  delete received;
+
+  // Any other data received on this socket is ignored just like on
+  // sockets where no framing was negotiated.
+  socket->recv(data, size)
+    .onAny(lambda::bind(&ignore_recv_data, lambda::_1, socket, data, size));
+}
+
+
 // Forward declaration.
 void send(Encoder* encoder, Socket* socket);
 
@@ -1391,6 +1860,17 @@ void SocketManager::link_connect(
     return;
   }
 
+  bool pending = false;
+
+  synchronized (mutex) {
+    pending = negotiating.count(*socket) > 0;
+  }
+
+  if (pending) {
+    negotiate(socket);
+    return;
+  }
+
   size_t size = 80 * 1024;
   char* data = new char[size];
 
@@ -1466,6 +1946,10 @@ void SocketManager::link(
       // connected.
       outgoing[s];
 
+      if (framing) {
+        negotiating[s];
+      }
+
       connect = true;
     }
 
@@ -1534,9 +2018,10 @@ void send(Encoder* encoder, Socket* socket)
 {
   switch (encoder->kind()) {
     case Encoder::DATA: {
-      size_t size;
-      const char* data = reinterpret_cast<DataEncoder*>(encoder)->next(&size);
-      socket->send(data, size)
+      size_t size = encoder->remaining();
+      const vector<struct iovec> buffers =
+        reinterpret_cast<DataEncoder*>(encoder)->next();
+      socket->send(buffers)
         .onAny(lambda::bind(
             &internal::_send,
             lambda::_1,
@@ -1630,7 +2115,7 @@ void SocketManager::send(Encoder* encoder, bool persist)
 
 
 void SocketManager::send(
-    const Response& response,
+    const Future<Response>& response,
     const Request& request,
     const Socket& socket)
 {
@@ -1638,8 +2123,8 @@ void SocketManager::send(
 
   // Don't persist the connection if the headers include
   // 'Connection: close'.
-  if (response.headers.contains("Connection")) {
-    if (response.headers.get("Connection").get() == "close") {
+  if (response.get().headers.contains("Connection")) {
+    if (response.get().headers.get("Connection").get() == "close") {
       persist = false;
     }
   }
@@ -1716,6 +2201,22 @@ void SocketManager::send_connect(
     return;
   }
 
+  bool pending = false;
+
+  synchronized (mutex) {
+    if (negotiating.count(*socket) > 0) {
+      // This message was sent before any that got queued while we
+      // were connecting so it must go first.
+      negotiating[*socket].push_front(message);
+      pending = true;
+    }
+  }
+
+  if (pending) {
+    negotiate(socket);
+    return;
+  }
+
   Encoder* encoder = new MessageEncoder(*socket, message);
 
   // Receive and ignore data from this socket. Note that we don't
@@ -1743,6 +2244,7 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
   const Address& address = message->to.address;
 
   Option<Socket> socket = None();
+  Encoder* encoder = NULL;
   bool connect = false;
 
   synchronized (mutex) {
@@ -1760,12 +2262,16 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
         dispose.insert(socket.get());
       }
 
-      if (outgoing.count(socket.get()) > 0) {
-        outgoing[socket.get()].push(new MessageEncoder(socket.get(), message));
+      if (negotiating.count(socket.get()) > 0) {
+        negotiating[socket.get()].push_back(message);
+        return;
+      } else if (outgoing.count(socket.get()) > 0) {
+        outgoing[socket.get()].push(encode(socket.get(), message));
         return;
       } else {
         // Initialize the outgoing queue.
         outgoing[socket.get()];
+        encoder = encode(socket.get(), message);
       }
 
     } else {
@@ -1792,6 +2298,10 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
       // Initialize the outgoing queue.
       outgoing[s];
 
+      if (framing) {
+        negotiating[s];
+      }
+
       connect = true;
     }
   }
@@ -1808,45 +2318,179 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
   } else {
     // If we're not connecting and we haven't added the encoder to
     // the 'outgoing' queue then schedule it to be sent.
-    internal::send(
-        new MessageEncoder(socket.get(), message),
-        new Socket(socket.get()));
+    internal::send(encoder, new Socket(socket.get()));
   }
 }
 
 
-Encoder* SocketManager::next(int s)
+Encoder* SocketManager::encode(const Socket& socket, Message* message)
 {
-  HttpProxy* proxy = NULL; // Non-null if needs to be terminated.
-
   synchronized (mutex) {
-    // We cannot assume 'sockets.count(s) > 0' here because it's
-    // possible that 's' has been removed with a call to
-    // SocketManager::close. For example, it could be the case that a
-    // socket has gone to CLOSE_WAIT and the call to read in
-    // io::read returned 0 causing SocketManager::close to get
-    // invoked. Later a call to 'send' or 'sendfile' (e.g., in
-    // send_data or send_file) can "succeed" (because the socket is
-    // not "closed" yet because there are still some Socket
-    // references, namely the reference being used in send_data or
-    // send_file!). However, when SocketManger::next is actually
-    // invoked we find out there there is no more data and thus stop
-    // sending.
-    // TODO(benh): Should we actually finish sending the data!?
-    if (sockets.count(s) > 0) {
-      CHECK(outgoing.count(s) > 0);
+    if (framed.count(socket) > 0) {
+      return new FramedMessageEncoder(socket, message);
+    }
+  }
 
-      if (!outgoing[s].empty()) {
-        // More messages!
-        Encoder* encoder = outgoing[s].front();
-        outgoing[s].pop();
-        return encoder;
-      } else {
-        // No more messages ... erase the outgoing queue.
-        outgoing.erase(s);
+  return new MessageEncoder(socket, message);
+}
 
-        if (dispose.count(s) > 0) {
-          // This is either a temporary socket we created or it's a
+
+void SocketManager::negotiate(Socket* socket)
+{
+  // Offer to share the connection if it's the one we link with.
+  bool share = false;
+
+  synchronized (mutex) {
+    if (sharing && addresses.count(*socket) > 0) {
+      const Address& address = addresses[*socket];
+      share = persists.count(address) > 0 && persists[address] == *socket;
+    }
+  }
+
+  // NOTE: We are the only sender on this socket until the response
+  // arrives, see 'next'.
+  internal::send(
+      new DataEncoder(
+          *socket,
+          string("GET ") + FRAMING_PATH + " HTTP/1.1\r\n" +
+          "Host: \r\n" +
+          FRAMING_HEADER + ": binary\r\n" +
+          (share
+           ? string(CHANNEL_HEADER) + ": " + stringify(__address__) + "\r\n"
+           : "") +
+          "\r\n"),
+      new Socket(*socket));
+
+  size_t size = 80 * 1024;
+  char* data = new char[size];
+
+  socket->recv(data, size)
+    .onAny(lambda::bind(
+        &internal::negotiate_recv,
+        lambda::_1,
+        socket,
+        data,
+        size,
+        new ResponseDecoder(),
+        new string()));
+}
+
+
+bool SocketManager::shareable(const Socket& socket, const Address& address)
+{
+  synchronized (mutex) {
+    // We don't share a connection that is going to be closed once
+    // we're done sending on it, and we keep using the connection we
+    // might already have to the peer.
+    return sharing &&
+      sockets.count(socket) > 0 &&
+      dispose.count(socket) == 0 &&
+      addresses.count(socket) == 0 &&
+      persists.count(address) == 0 &&
+      temps.count(address) == 0;
+  }
+}
+
+
+void SocketManager::share(const Socket& socket, const Address& address)
+{
+  synchronized (mutex) {
+    // The connection might have been closed, or one to the peer might
+    // have been created since we checked. The peer then still
+    // receives on its connection, but nothing gets sent on it.
+    if (!shareable(socket, address)) {
+      return;
+    }
+
+    VLOG(1) << "Sharing the connection from " << address
+            << " for messages to it";
+
+    addresses[socket] = address;
+    persists[address] = socket;
+
+    // The peer decodes framed messages on the connection.
+    framed.insert(socket);
+  }
+}
+
+
+void SocketManager::negotiated(const Socket& socket, bool binary)
+{
+  Encoder* encoder = NULL;
+
+  synchronized (mutex) {
+    if (sockets.count(socket) == 0 || negotiating.count(socket) == 0) {
+      return; // The socket has since been closed.
+    }
+
+    VLOG(1) << "Using " << (binary ? "binary" : "HTTP")
+            << " framing for messages to " << addresses[socket];
+
+    if (binary) {
+      framed.insert(socket);
+    }
+
+    // Initialize the outgoing queue unless the negotiation request
+    // is still being sent, in which case 'next' will pick up the
+    // encoders queued here.
+    bool sending = outgoing.count(socket) > 0;
+
+    foreach (Message* message, negotiating[socket]) {
+      outgoing[socket].push(encode(socket, message));
+    }
+
+    negotiating.erase(socket);
+
+    if (!sending) {
+      encoder = next(socket);
+    }
+  }
+
+  if (encoder != NULL) {
+    internal::send(encoder, new Socket(socket));
+  }
+}
+
+
+Encoder* SocketManager::next(int s)
+{
+  HttpProxy* proxy = NULL; // Non-null if needs to be terminated.
+
+  synchronized (mutex) {
+    // We cannot assume 'sockets.count(s) > 0' here because it's
+    // possible that 's' has been removed with a call to
+    // SocketManager::close. For example, it could be the case that a
+    // socket has gone to CLOSE_WAIT and the call to read in
+    // io::read returned 0 causing SocketManager::close to get
+    // invoked. Later a call to 'send' or 'sendfile' (e.g., in
+    // send_data or send_file) can "succeed" (because the socket is
+    // not "closed" yet because there are still some Socket
+    // references, namely the reference being used in send_data or
+    // send_file!). However, when SocketManger::next is actually
+    // invoked we find out there there is no more data and thus stop
+    // sending.
+    // TODO(benh): Should we actually finish sending the data!?
+    if (sockets.count(s) > 0) {
+      CHECK(outgoing.count(s) > 0);
+
+      // Stop sending until the framing has been negotiated, at which
+      // point the negotiated messages get queued (see 'negotiated').
+      if (negotiating.count(s) > 0 && outgoing[s].empty()) {
+        outgoing.erase(s);
+        return NULL;
+      }
+
+      if (!outgoing[s].empty()) {
+        // More messages!
+        Encoder* encoder = outgoing[s].front();
+        outgoing[s].pop();
+        return encoder;
+      } else {
+        // No more messages ... erase the outgoing queue.
+        outgoing.erase(s);
+
+        if (dispose.count(s) > 0) {
+          // This is either a temporary socket we created or it's a
           // socket that we were receiving data from and possibly
           // sending HTTP responses back on. Clean up either way.
           if (addresses.count(s) > 0) {
@@ -1862,6 +2506,7 @@ Encoder* SocketManager::next(int s)
           }
 
           dispose.erase(s);
+          framed.erase(s);
 
           auto iterator = sockets.find(s);
 
@@ -1921,6 +2566,17 @@ void SocketManager::close(int s)
         outgoing.erase(s);
       }
 
+      // Clean up any messages waiting for the framing negotiation.
+      if (negotiating.count(s) > 0) {
+        foreach (Message* message, negotiating[s]) {
+          delete message;
+        }
+
+        negotiating.erase(s);
+      }
+
+      framed.erase(s);
+
       // Clean up after sockets used for remote communication.
       if (addresses.count(s) > 0) {
         const Address& address = addresses[s];
@@ -2137,6 +2793,12 @@ void SocketManager::swap_implementing_socket(const Socket& from, Socket* to)
     outgoing[to_fd] = std::move(outgoing[from_fd]);
     outgoing.erase(from_fd);
 
+    // Move any messages waiting for the framing negotiation.
+    if (negotiating.count(from_fd) > 0) {
+      negotiating[to_fd] = std::move(negotiating[from_fd]);
+      negotiating.erase(from_fd);
+    }
+
     // Update the fd any proxies are associated with.
     if (proxies.count(from_fd) > 0) {
       proxies[to_fd] = proxies[from_fd];
@@ -2150,6 +2812,7 @@ ProcessManager::ProcessManager(const string& _delegate)
   : delegate(_delegate)
 {
   running.store(0);
+  next.store(0);
 }
 
 
@@ -2182,6 +2845,10 @@ ProcessManager::~ProcessManager()
     thread->join();
     delete thread;
   }
+
+  foreach (RunQueue* runq, runqs) {
+    delete runq;
+  }
 }
 
 
@@ -2201,13 +2868,29 @@ long ProcessManager::init_threads()
   long cpus = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
   threads.reserve(cpus+1);
 
+  // Check environment for the scheduler mode. When work stealing is
+  // enabled each processing thread gets its own run queue, which
+  // avoids having every thread contend on 'runq_mutex'.
+  Option<string> value = os::getenv("LIBPROCESS_WORK_STEALING");
+  if (value.isSome() && (value.get() == "1" || value.get() == "true")) {
+    for (long i = 0; i < cpus; i++) {
+      runqs.push_back(new RunQueue());
+    }
+
+    VLOG(1) << "Using work stealing scheduler with " << cpus
+            << " run queues";
+  }
+
   // Create processing threads.
   for (long i = 0; i < cpus; i++) {
     // Retain the thread handles so that we can join when shutting down.
     threads.emplace_back(
         // We pass a constant reference to `joining` to make it clear that this
         // value is only being tested (read), and not manipulated.
-        new std::thread(std::bind([](const std::atomic_bool& joining) {
+        new std::thread(std::bind([](int worker,
+                                     const std::atomic_bool& joining) {
+          __worker__ = worker;
+
           do {
             ProcessBase* process = process_manager->dequeue();
             if (process == NULL) {
@@ -2226,6 +2909,7 @@ long ProcessManager::init_threads()
             process_manager->resume(process);
           } while (true);
         },
+        static_cast<int>(i),
         std::cref(joining_threads))));
   }
 
@@ -2495,6 +3179,50 @@ UPID ProcessManager::spawn(ProcessBase* process, bool manage)
 }
 
 
+// Returns true if the event should be dropped rather than serviced,
+// as decided by the installed filter (if any).
+static bool filter(Event* event)
+{
+  synchronized (filterer_mutex) {
+    if (filterer != NULL) {
+      bool filter = false;
+      struct FilterVisitor : EventVisitor
+      {
+        explicit FilterVisitor(bool* _filter) : filter(_filter) {}
+
+        virtual void visit(const MessageEvent& event)
+        {
+          *filter = filterer->filter(event);
+        }
+
+        virtual void visit(const DispatchEvent& event)
+        {
+          *filter = filterer->filter(event);
+        }
+
+        virtual void visit(const HttpEvent& event)
+        {
+          *filter = filterer->filter(event);
+        }
+
+        virtual void visit(const ExitedEvent& event)
+        {
+          *filter = filterer->filter(event);
+        }
+
+        bool* filter;
+      } visitor(&filter);
+
+      event->visit(&visitor);
+
+      return filter;
+    }
+  }
+
+  return false;
+}
+
+
 void ProcessManager::resume(ProcessBase* process)
 {
   __process__ = process;
@@ -2507,92 +3235,136 @@ void ProcessManager::resume(ProcessBase* process)
   CHECK(process->state == ProcessBase::BOTTOM ||
         process->state == ProcessBase::READY);
 
+  // Remember where we ran so that the next time this process becomes
+  // runnable it gets enqueued on this thread's run queue (only used
+  // when work stealing is enabled).
+  if (__worker__ >= 0) {
+    process->worker.store(__worker__);
+  }
+
   if (process->state == ProcessBase::BOTTOM) {
     process->state = ProcessBase::RUNNING;
     try { process->initialize(); }
     catch (...) { terminate = true; }
+  } else {
+    process->state = ProcessBase::RUNNING;
   }
 
+  // An event that was dequeued while collecting a batch of messages
+  // but didn't belong in it, which must be serviced next.
+  Event* next = NULL;
+
   while (!terminate && !blocked) {
-    Event* event = NULL;
+    Event* event = next;
+    next = NULL;
 
-    synchronized (process->mutex) {
-      if (process->events.size() > 0) {
-        event = process->events.front();
-        process->events.pop_front();
-        process->state = ProcessBase::RUNNING;
-      } else {
-        process->state = ProcessBase::BLOCKED;
+    if (event == NULL) {
+      event = process->events.dequeue();
+    }
+
+    if (event == NULL) {
+      // Before we block we need to check again whether or not an
+      // event was enqueued after we tried to dequeue but before
+      // producers could observe that we're BLOCKED. If so, either we
+      // transition back to RUNNING or a producer already transitioned
+      // us to READY (and put us on the run queue), in which case we
+      // must not touch the process anymore. We hold a reference while
+      // checking since as soon as we're BLOCKED another thread might
+      // resume (and even clean up) the process.
+      ProcessReference reference(process);
+
+      process->state = ProcessBase::BLOCKED;
+
+      ProcessBase::ProcessState expected = ProcessBase::BLOCKED;
+      if (process->events.empty() ||
+          !process->state.compare_exchange_strong(
+              expected, ProcessBase::RUNNING)) {
         blocked = true;
       }
-    }
 
-    if (!blocked) {
-      CHECK(event != NULL);
+      continue;
+    }
 
-      // Determine if we should filter this event.
-      synchronized (filterer_mutex) {
-        if (filterer != NULL) {
-          bool filter = false;
-          struct FilterVisitor : EventVisitor
-          {
-            explicit FilterVisitor(bool* _filter) : filter(_filter) {}
+    // Determine if we should filter this event.
+    if (filter(event)) {
+      delete event;
+      continue; // Try and execute the next event.
+    }
 
-            virtual void visit(const MessageEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+    // Determine if we should terminate.
+    terminate = event->is<TerminateEvent>();
 
-            virtual void visit(const DispatchEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+    // Collect any messages that should be visited along with this
+    // one (see ProcessBase::batch).
+    vector<const MessageEvent*> batch;
 
-            virtual void visit(const HttpEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+    if (!process->batches.empty() && event->is<MessageEvent>()) {
+      const MessageEvent* message = &event->as<MessageEvent>();
+      const string& name = message->message->name;
 
-            virtual void visit(const ExitedEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+      if (process->batches.count(name) > 0) {
+        const size_t size = process->batches[name].size;
 
-            bool* filter;
-          } visitor(&filter);
+        batch.push_back(message);
 
-          event->visit(&visitor);
+        while (batch.size() < size) {
+          next = process->events.dequeue();
 
-          if (filter) {
-            delete event;
-            continue; // Try and execute the next event.
+          if (next == NULL) {
+            break;
+          } else if (filter(next)) {
+            delete next;
+            next = NULL;
+          } else if (next->is<MessageEvent>() &&
+                     next->as<MessageEvent>().message->name == name) {
+            batch.push_back(&next->as<MessageEvent>());
+            next = NULL;
+          } else {
+            break;
           }
         }
+
+        *process->batches[name].sizes = batch.size();
       }
+    }
 
-      // Determine if we should terminate.
-      terminate = event->is<TerminateEvent>();
+    const uint64_t started =
+      process->instrumentation.get() != NULL ? monotonic() : 0;
 
-      // Now service the event.
-      try {
+    // Now service the event(s).
+    try {
+      if (batch.empty()) {
         process->serve(*event);
-      } catch (const std::exception& e) {
-        std::cerr << "libprocess: " << process->pid
-                  << " terminating due to "
-                  << e.what() << std::endl;
-        terminate = true;
-      } catch (...) {
-        std::cerr << "libprocess: " << process->pid
-                  << " terminating due to unknown exception" << std::endl;
-        terminate = true;
+      } else {
+        process->visit(batch);
       }
+    } catch (const std::exception& e) {
+      std::cerr << "libprocess: " << process->pid
+                << " terminating due to "
+                << e.what() << std::endl;
+      terminate = true;
+    } catch (...) {
+      std::cerr << "libprocess: " << process->pid
+                << " terminating due to unknown exception" << std::endl;
+      terminate = true;
+    }
 
-      delete event;
+    if (process->instrumentation.get() != NULL) {
+      record(process, *event, batch, started, monotonic());
+    }
 
-      if (terminate) {
-        cleanup(process);
+    if (batch.empty()) {
+      delete event;
+    } else {
+      foreach (const MessageEvent* message, batch) {
+        delete message;
       }
     }
+
+    if (terminate) {
+      delete next;
+      cleanup(process);
+    }
   }
 
   __process__ = NULL;
@@ -2602,6 +3374,83 @@ void ProcessManager::resume(ProcessBase* process)
 }
 
 
+void ProcessManager::record(
+    ProcessBase* process,
+    const Event& event,
+    const vector<const MessageEvent*>& batch,
+    uint64_t started,
+    uint64_t stopped)
+{
+  typedef ProcessBase::Instrumentation::Handler Handler;
+
+  ProcessBase::Instrumentation* instrumentation =
+    process->instrumentation.get();
+
+  const uint64_t duration = stopped - started;
+
+  auto latency = [=](const Event& event) -> uint64_t {
+    return event.enqueued != 0 && started > event.enqueued
+      ? started - event.enqueued
+      : 0;
+  };
+
+  synchronized (instrumentation->mutex) {
+    if (!batch.empty()) {
+      // The messages of a batch are served at once, they are each
+      // attributed an equal share of the duration.
+      Handler& handler =
+        instrumentation->events["MESSAGE " + batch.front()->message->name];
+
+      foreach (const MessageEvent* message, batch) {
+        handler.record(latency(*message), duration / batch.size());
+      }
+
+      return;
+    }
+
+    struct Visitor : EventVisitor
+    {
+      explicit Visitor(ProcessBase::Instrumentation* _instrumentation)
+        : instrumentation(_instrumentation), handler(NULL) {}
+
+      virtual void visit(const MessageEvent& event)
+      {
+        handler = &instrumentation->events["MESSAGE " + event.message->name];
+      }
+
+      virtual void visit(const DispatchEvent& event)
+      {
+        handler = event.functionType.isSome()
+          ? &instrumentation->dispatches[event.functionType.get()]
+          : &instrumentation->events["DISPATCH"];
+      }
+
+      virtual void visit(const HttpEvent& event)
+      {
+        handler = &instrumentation->events["HTTP " + event.request->url.path];
+      }
+
+      virtual void visit(const ExitedEvent& event)
+      {
+        handler = &instrumentation->events["EXITED"];
+      }
+
+      virtual void visit(const TerminateEvent& event)
+      {
+        handler = &instrumentation->events["TERMINATE"];
+      }
+
+      ProcessBase::Instrumentation* instrumentation;
+      Handler* handler;
+    } visitor(instrumentation);
+
+    event.visit(&visitor);
+
+    CHECK_NOTNULL(visitor.handler)->record(latency(event), duration);
+  }
+}
+
+
 void ProcessManager::cleanup(ProcessBase* process)
 {
   VLOG(2) << "Cleaning up " << process->pid;
@@ -2616,19 +3465,22 @@ void ProcessManager::cleanup(ProcessBase* process)
   // the process we are cleaning up will get dropped (since it's
   // terminating) and eliminates the potential of enqueueing them on
   // another process that gets spawned with the same PID.
-  deque<Event*> events;
+  process->state = ProcessBase::TERMINATING;
 
-  synchronized (process->mutex) {
-    process->state = ProcessBase::TERMINATING;
-    events = process->events;
-    process->events.clear();
+  // Wait for any threads that are in the middle of enqueueing an
+  // event, after which no more events will get enqueued.
+  while (process->enqueuers.load() > 0) {
+#if defined(__i386__) || defined(__x86_64__)
+    asm ("pause");
+#endif
   }
 
   // Delete pending events.
-  while (!events.empty()) {
-    Event* event = events.front();
-    events.pop_front();
-    delete event;
+  while (!process->events.empty()) {
+    Event* event = process->events.dequeue();
+    if (event != NULL) {
+      delete event;
+    }
   }
 
   // Possible gate non-libprocess threads are waiting at.
@@ -2645,6 +3497,7 @@ void ProcessManager::cleanup(ProcessBase* process)
 
     synchronized (process->mutex) {
       CHECK(process->events.empty());
+      CHECK_EQ(0, process->enqueuers.load());
 
       processes.erase(process->pid.id);
 
@@ -2771,23 +3624,49 @@ bool ProcessManager::wait(const UPID& pid)
       // Check if it is runnable in order to donate this thread.
       if (process->state == ProcessBase::BOTTOM ||
           process->state == ProcessBase::READY) {
-        synchronized (runq_mutex) {
-          list<ProcessBase*>::iterator it =
-            find(runq.begin(), runq.end(), process);
-          if (it != runq.end()) {
-            // Found it! Remove it from the run queue since we'll be
-            // donating our thread and also increment 'running' before
-            // leaving this 'runq' protected critical section so that
-            // everyone that is waiting for the processes to settle
-            // continue to wait (otherwise they could see nothing in
-            // 'runq' and 'running' equal to 0 between when we exit
-            // this critical section and increment 'running').
-            runq.erase(it);
-            running.fetch_add(1);
-          } else {
-            // Another thread has resumed the process ...
+        if (stealing()) {
+          bool found = false;
+
+          // A process is on at most one run queue and it only leaves
+          // that queue when it gets resumed, so if we don't find it
+          // another thread has resumed the process.
+          foreach (RunQueue* runq, runqs) {
+            synchronized (runq->mutex) {
+              if (remove(runq, process)) {
+                // See comment below on why this must be done while
+                // holding the lock.
+                running.fetch_add(1);
+                found = true;
+              }
+            }
+
+            if (found) {
+              break;
+            }
+          }
+
+          if (!found) {
             process = NULL;
           }
+        } else {
+          synchronized (runq_mutex) {
+            list<ProcessBase*>::iterator it =
+              find(runq.begin(), runq.end(), process);
+            if (it != runq.end()) {
+              // Found it! Remove it from the run queue since we'll be
+              // donating our thread and also increment 'running' before
+              // leaving this 'runq' protected critical section so that
+              // everyone that is waiting for the processes to settle
+              // continue to wait (otherwise they could see nothing in
+              // 'runq' and 'running' equal to 0 between when we exit
+              // this critical section and increment 'running').
+              runq.erase(it);
+              running.fetch_add(1);
+            } else {
+              // Another thread has resumed the process ...
+              process = NULL;
+            }
+          }
         }
       } else {
         // Process is not runnable, so no need to donate ...
@@ -2876,12 +3755,32 @@ void ProcessManager::enqueue(ProcessBase* process)
 
   // TODO(benh): Check and see if this process has it's own thread. If
   // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  // it's not running.
+
+  if (stealing()) {
+    // Put the process on the run queue of the thread it was last
+    // running on, otherwise on the run queue of the current thread
+    // (if it's a processing thread), otherwise round-robin.
+    int worker = process->worker.load();
+    if (worker < 0) {
+      worker = __worker__;
+    }
+    if (worker < 0) {
+      worker = static_cast<int>(next.fetch_add(1) % runqs.size());
+    }
 
-  synchronized (runq_mutex) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
+    RunQueue* runq = runqs[worker];
+
+    synchronized (runq->mutex) {
+      CHECK(find(runq->processes.begin(), runq->processes.end(), process) ==
+            runq->processes.end());
+      runq->processes.push_back(process);
+    }
+  } else {
+    synchronized (runq_mutex) {
+      CHECK(find(runq.begin(), runq.end(), process) == runq.end());
+      runq.push_back(process);
+    }
   }
 
   // Wake up the processing thread if necessary.
@@ -2891,12 +3790,27 @@ void ProcessManager::enqueue(ProcessBase* process)
 
 ProcessBase* ProcessManager::dequeue()
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
-
   ProcessBase* process = NULL;
 
+  if (stealing()) {
+    // Remove a process from this thread's runq. If there are no
+    // processes to run then steal one from another threads runq.
+    // Threads that are not processing threads (e.g., a thread that
+    // got donated in 'wait') always steal.
+    const size_t size = runqs.size();
+    const size_t self = __worker__ >= 0 ? __worker__ : 0;
+
+    for (size_t i = 0; i < size && process == NULL; i++) {
+      RunQueue* runq = runqs[(self + i) % size];
+
+      synchronized (runq->mutex) {
+        process = pop(runq, i > 0 || __worker__ < 0);
+      }
+    }
+
+    return process;
+  }
+
   synchronized (runq_mutex) {
     if (!runq.empty()) {
       process = runq.front();
@@ -2932,6 +3846,24 @@ void ProcessManager::settle()
 
     done = true; // Assume to start that we are settled.
 
+    // When work stealing is enabled we need to hold all of the run
+    // queue locks at the same time, otherwise a running process could
+    // enqueue another process on a run queue we already checked and
+    // then finish before we check 'running'. NOTE: the locks are
+    // always acquired in the same order, and no other code path holds
+    // more than one of them at a time.
+    vector<std::unique_lock<std::mutex>> locks;
+    bool empty = true;
+    foreach (RunQueue* runq, runqs) {
+      locks.emplace_back(runq->mutex);
+      empty = empty && runq->processes.empty();
+    }
+
+    if (!empty) {
+      done = false;
+      continue;
+    }
+
     synchronized (runq_mutex) {
       if (!runq.empty()) {
         done = false;
@@ -2952,80 +3884,116 @@ void ProcessManager::settle()
 }
 
 
-Future<Response> ProcessManager::__processes__(const Request&)
+bool ProcessManager::remove(RunQueue* runq, ProcessBase* process)
 {
-  JSON::Array array;
+  std::deque<ProcessBase*>::iterator it =
+    find(runq->processes.begin(), runq->processes.end(), process);
 
-  synchronized (processes_mutex) {
-    foreachvalue (ProcessBase* process, process_manager->processes) {
-      JSON::Object object;
-      object.values["id"] = process->pid.id;
+  if (it == runq->processes.end()) {
+    return false;
+  }
 
-      JSON::Array events;
+  runq->processes.erase(it);
+  return true;
+}
 
-      struct JSONVisitor : EventVisitor
-      {
-        explicit JSONVisitor(JSON::Array* _events) : events(_events) {}
 
-        virtual void visit(const MessageEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "MESSAGE";
+ProcessBase* ProcessManager::pop(RunQueue* runq, bool steal)
+{
+  if (runq->processes.empty()) {
+    return NULL;
+  }
 
-          const Message& message = *event.message;
+  ProcessBase* process = NULL;
 
-          object.values["name"] = message.name;
-          object.values["from"] = string(message.from);
-          object.values["to"] = string(message.to);
-          object.values["body"] = message.body;
+  // Threads take work from the front of their own run queue but
+  // steal from the back of others, so that the owner is more likely
+  // to run the processes that are still warm in its cache.
+  if (steal) {
+    process = runq->processes.back();
+    runq->processes.pop_back();
+  } else {
+    process = runq->processes.front();
+    runq->processes.pop_front();
+  }
 
-          events->values.push_back(object);
-        }
+  // Increment the running count of processes in order to support
+  // the Clock::settle() operation (this must be done atomically with
+  // removing the process from the run queue).
+  running.fetch_add(1);
 
-        virtual void visit(const HttpEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "HTTP";
+  return process;
+}
 
-          const Request& request = *event.request;
 
-          object.values["method"] = request.method;
-          object.values["url"] = stringify(request.url);
+Future<Response> ProcessManager::__processes__(const Request&)
+{
+  JSON::Array array;
 
-          events->values.push_back(object);
-        }
+  synchronized (processes_mutex) {
+    foreachvalue (ProcessBase* process, process_manager->processes) {
+      JSON::Object object;
+      object.values["id"] = process->pid.id;
 
-        virtual void visit(const DispatchEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "DISPATCH";
-          events->values.push_back(object);
-        }
+      // NOTE: The events of a process can not be inspected while it
+      // might be running (see EventQueue), so we only expose how many
+      // events of each type are queued.
+      JSON::Array events;
 
-        virtual void visit(const ExitedEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "EXITED";
-          events->values.push_back(object);
+      typedef std::pair<string, size_t> Count;
+
+      const vector<Count> counts = {
+        Count("MESSAGE", process->events.count<MessageEvent>()),
+        Count("DISPATCH", process->events.count<DispatchEvent>()),
+        Count("HTTP", process->events.count<HttpEvent>()),
+        Count("EXITED", process->events.count<ExitedEvent>()),
+        Count("TERMINATE", process->events.count<TerminateEvent>())
+      };
+
+      foreach (const Count& count, counts) {
+        if (count.second > 0) {
+          JSON::Object event;
+          event.values["type"] = count.first;
+          event.values["count"] = count.second;
+          events.values.push_back(event);
         }
+      }
 
-        virtual void visit(const TerminateEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "TERMINATE";
-          events->values.push_back(object);
-        }
+      object.values["events"] = events;
+
+      if (process->instrumentation.get() != NULL) {
+        typedef ProcessBase::Instrumentation::Handler Handler;
 
-        JSON::Array* events;
-      } visitor(&events);
+        auto model = [](const string& event, const Handler& handler) {
+          JSON::Object object;
+          object.values["event"] = event;
+          object.values["count"] = handler.count;
+          object.values["latency_ns"] = handler.latency;
+          object.values["max_latency_ns"] = handler.maxLatency;
+          object.values["duration_ns"] = handler.duration;
+          object.values["max_duration_ns"] = handler.maxDuration;
+          return object;
+        };
+
+        JSON::Array handlers;
+
+        synchronized (process->instrumentation->mutex) {
+          foreachpair (const string& event,
+                       const Handler& handler,
+                       process->instrumentation->events) {
+            handlers.values.push_back(model(event, handler));
+          }
 
-      synchronized (process->mutex) {
-        foreach (Event* event, process->events) {
-          event->visit(&visitor);
+          foreachpair (const std::type_info* type,
+                       const Handler& handler,
+                       process->instrumentation->dispatches) {
+            handlers.values.push_back(
+                model("DISPATCH " + demangle(type), handler));
+          }
         }
-      }
 
-      object.values["events"] = events;
+        object.values["handlers"] = handlers;
+      }
       array.values.push_back(object);
     }
   }
@@ -3034,6 +4002,29 @@ Future<Response> ProcessManager::__processes__(const Request&)
 }
 
 
+hashmap<const ProcessBase*, internal::Spawned> ProcessManager::spawned()
+{
+  hashmap<const ProcessBase*, internal::Spawned> result;
+
+  synchronized (processes_mutex) {
+    foreachvalue (ProcessBase* process, processes) {
+      internal::Spawned spawned;
+      spawned.pid = process->pid;
+      spawned.queued =
+        process->events.count<MessageEvent>() +
+        process->events.count<DispatchEvent>() +
+        process->events.count<HttpEvent>() +
+        process->events.count<ExitedEvent>() +
+        process->events.count<TerminateEvent>();
+
+      result[process] = spawned;
+    }
+  }
+
+  return result;
+}
+
+
 ProcessBase::ProcessBase(const string& id)
 {
   process::initialize();
@@ -3042,6 +4033,14 @@ ProcessBase::ProcessBase(const string& id)
 
   refs = 0;
 
+  enqueuers = 0;
+
+  worker = -1;
+
+  if (instrument.load()) {
+    instrumentation.reset(new Instrumentation());
+  }
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -3054,33 +4053,43 @@ ProcessBase::ProcessBase(const string& id)
 }
 
 
-ProcessBase::~ProcessBase() {}
+ProcessBase::~ProcessBase()
+{
+  foreachvalue (const Batch& batch, batches) {
+    metrics::remove(*batch.sizes);
+  }
+}
 
 
 void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != NULL);
 
-  synchronized (mutex) {
-    if (state != TERMINATING && state != TERMINATED) {
-      if (!inject) {
-        events.push_back(event);
-      } else {
-        events.push_front(event);
-      }
+  // NOTE: ProcessManager::cleanup first transitions to TERMINATING
+  // and then waits for all 'enqueuers' before deleting any remaining
+  // events, so an event is either deleted here or by cleanup.
+  enqueuers.fetch_add(1);
 
-      if (state == BLOCKED) {
-        state = READY;
-        process_manager->enqueue(this);
-      }
+  if (state == TERMINATING || state == TERMINATED) {
+    enqueuers.fetch_sub(1);
+    delete event;
+    return;
+  }
 
-      CHECK(state == BOTTOM ||
-            state == READY ||
-            state == RUNNING);
-    } else {
-      delete event;
-    }
+  if (instrumentation.get() != NULL) {
+    event->enqueued = monotonic();
+  }
+
+  events.enqueue(event, inject);
+
+  // Only one thread can transition a process out of BLOCKED, so
+  // the process can not end up on the run queue more than once.
+  ProcessState expected = BLOCKED;
+  if (state.compare_exchange_strong(expected, READY)) {
+    process_manager->enqueue(this);
   }
+
+  enqueuers.fetch_sub(1);
 }
 
 
@@ -3130,9 +4139,17 @@ void ProcessBase::visit(const MessageEvent& event)
 }
 
 
+void ProcessBase::visit(const vector<const MessageEvent*>& events)
+{
+  foreach (const MessageEvent* event, events) {
+    visit(*event);
+  }
+}
+
+
 void ProcessBase::visit(const DispatchEvent& event)
 {
-  (*event.f)(this);
+  event.f(this);
 }
 
 
@@ -3297,6 +4314,22 @@ UPID ProcessBase::link(const UPID& to)
 }
 
 
+void ProcessBase::batch(const string& name, size_t size)
+{
+  CHECK_GT(size, 0u);
+
+  if (batches.count(name) == 0) {
+    batches[name].sizes.reset(new metrics::PushGauge(
+        pid.id + "/batch_size/" + name,
+        TIME_SERIES_WINDOW));
+
+    metrics::add(*batches[name].sizes);
+  }
+
+  batches[name].size = size;
+}
+
+
 void ProcessBase::route(
     const string& name,
     const Option<string>& help_,
@@ -3478,18 +4511,70 @@ bool exited(const UPID& from, const UPID& to)
 } // namespace inject {
 
 
+// Free list of the memory of the dispatch events deleted by this
+// thread, linked through the first bytes of each block. Since events
+// are mostly created and deleted by the worker threads, the blocks
+// circulate between their lists. The memory kept by a thread which
+// exits is not reclaimed, which the bound below keeps small.
+static THREAD_LOCAL void* __dispatch_events__ = NULL;
+static THREAD_LOCAL size_t __dispatch_events_size__ = 0;
+
+// Maximum number of blocks kept in a thread's free list.
+static const size_t DISPATCH_EVENTS_MAX = 1024;
+
+
+void* DispatchEvent::operator new(size_t size)
+{
+  CHECK_EQ(sizeof(DispatchEvent), size);
+
+  if (__dispatch_events__ != NULL) {
+    void* event = __dispatch_events__;
+    __dispatch_events__ = *static_cast<void**>(event);
+    --__dispatch_events_size__;
+    return event;
+  }
+
+  return ::operator new(size);
+}
+
+
+void DispatchEvent::operator delete(void* event, size_t size)
+{
+  if (event == NULL) {
+    return;
+  }
+
+  if (__dispatch_events_size__ < DISPATCH_EVENTS_MAX) {
+    *static_cast<void**>(event) = __dispatch_events__;
+    __dispatch_events__ = event;
+    ++__dispatch_events_size__;
+    return;
+  }
+
+  ::operator delete(event);
+}
+
+
 namespace internal {
 
 void dispatch(
     const UPID& pid,
-    const std::shared_ptr<lambda::function<void(ProcessBase*)>>& f,
+    lambda::function<void(ProcessBase*)>&& f,
     const Option<const std::type_info*>& functionType)
 {
   process::initialize();
 
-  DispatchEvent* event = new DispatchEvent(pid, f, functionType);
+  DispatchEvent* event = new DispatchEvent(pid, std::move(f), functionType);
   process_manager->deliver(pid, event, __process__);
 }
 
+
+hashmap<const ProcessBase*, Spawned> processes()
+{
+  process::initialize();
+
+  return process_manager->spawned();
+}
+
 } // namespace internal {
 } // namespace process {
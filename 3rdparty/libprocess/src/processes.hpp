@@ -0,0 +1,45 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESSES_HPP__
+#define __PROCESSES_HPP__
+
+#include <stddef.h>
+
+#include <process/pid.hpp>
+#include <process/process.hpp>
+
+#include <stout/hashmap.hpp>
+
+namespace process {
+namespace internal {
+
+// A process which is spawned, as returned by 'processes'.
+struct Spawned
+{
+  UPID pid;
+
+  // The number of events queued for the process.
+  size_t queued;
+};
+
+
+// Returns the processes which are currently spawned, keyed by their
+// address. The addresses must not be dereferenced, since a process
+// may be cleaned up as soon as this returns, but they can be used to
+// identify a process observed through '__process__'.
+hashmap<const ProcessBase*, Spawned> processes();
+
+} // namespace internal {
+} // namespace process {
+
+#endif // __PROCESSES_HPP__
@@ -10,7 +10,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <signal.h>
+#include <string.h>
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -18,15 +27,23 @@
 #include <gperftools/profiler.h>
 #endif
 
+#include "process/delay.hpp"
 #include "process/future.hpp"
 #include "process/help.hpp"
 #include "process/http.hpp"
 #include "process/profiler.hpp"
 
+#include "stout/error.hpp"
+#include "stout/foreach.hpp"
 #include "stout/format.hpp"
+#include "stout/hashmap.hpp"
+#include "stout/json.hpp"
 #include "stout/option.hpp"
 #include "stout/os.hpp"
 #include "stout/os/strerror.hpp"
+#include "stout/stringify.hpp"
+
+#include "processes.hpp"
 
 namespace process {
 
@@ -34,6 +51,32 @@ namespace {
 
 const char PROFILE_FILE[] = "perftools.out";
 
+// The CPU time (of all the threads) between two samples of '/actors'.
+const Duration SAMPLE_INTERVAL = Milliseconds(10);
+
+// The samples, i.e., the process which was running on the thread that
+// got the SIGPROF (or NULL), are kept in a ring buffer shared by all
+// the threads. At the sampling rate the contention on 'sampled' is
+// negligible, and when the ring wraps around the latest samples are
+// the ones kept.
+const size_t SAMPLES = 1 << 16;
+
+std::atomic<const ProcessBase*> ring[SAMPLES];
+std::atomic<size_t> sampled(0);
+std::atomic_bool enabled(false);
+
+
+// The SIGPROF handler, hence it must be async signal safe. Reading
+// '__process__' is, as long as libprocess is not loaded with dlopen
+// (in which case the thread locals might be allocated lazily).
+void sample(int signal)
+{
+  if (enabled.load(std::memory_order_relaxed)) {
+    const size_t index = sampled.fetch_add(1, std::memory_order_relaxed);
+    ring[index % SAMPLES].store(__process__, std::memory_order_relaxed);
+  }
+}
+
 }  // namespace {
 
 const std::string Profiler::START_HELP()
@@ -56,6 +99,25 @@ const std::string Profiler::STOP_HELP()
 }
 
 
+const std::string Profiler::ACTORS_HELP()
+{
+  return HELP(
+    TLDR(
+        "Samples the CPU time used by each process."),
+    DESCRIPTION(
+        "Samples which process is running every",
+        stringify(SAMPLE_INTERVAL) + " of CPU time, for 'duration' (10secs",
+        "by default), and returns the",
+        "CPU time attributed to each process along with the number of",
+        "events queued for it. This is always available and only costs",
+        "while sampling, so it can be used on a production system.",
+        "",
+        "Query parameters:",
+        "",
+        ">        duration=VALUE       How long to sample (e.g., 1mins)."));
+}
+
+
 Future<http::Response> Profiler::start(const http::Request& request)
 {
 #ifdef HAS_GPERFTOOLS
@@ -126,4 +188,153 @@ Future<http::Response> Profiler::stop(const http::Request& request)
 #endif
 }
 
+
+Future<http::Response> Profiler::actors(const http::Request& request)
+{
+  // Both perftools and the sampling use SIGPROF.
+  if (started) {
+    return http::BadRequest("Perftools profiler is running.\n");
+  }
+
+  if (sampling) {
+    return http::BadRequest("Profiler already sampling.\n");
+  }
+
+  Duration duration = Seconds(10);
+
+  Option<std::string> parameter = request.url.query.get("duration");
+  if (parameter.isSome()) {
+    Try<Duration> parse = Duration::parse(parameter.get());
+    if (parse.isError()) {
+      return http::BadRequest(
+          "Invalid duration '" + parameter.get() + "': " + parse.error() +
+          ".\n");
+    }
+
+    duration = parse.get();
+  }
+
+  // The handler is (re)installed every time since perftools might
+  // have replaced it. It is never uninstalled, so that a SIGPROF
+  // which is still pending once the sampling stopped is ignored.
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = sample;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+
+  if (sigaction(SIGPROF, &action, NULL) < 0) {
+    const std::string error = ErrnoError("Failed to install handler").message;
+    LOG(ERROR) << error;
+    return http::InternalServerError(error + ".\n");
+  }
+
+  sampled.store(0);
+  enabled.store(true);
+
+  struct itimerval timer;
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = static_cast<long>(SAMPLE_INTERVAL.us());
+  timer.it_value = timer.it_interval;
+
+  if (setitimer(ITIMER_PROF, &timer, NULL) < 0) {
+    enabled.store(false);
+
+    const std::string error = ErrnoError("Failed to start the timer").message;
+    LOG(ERROR) << error;
+    return http::InternalServerError(error + ".\n");
+  }
+
+  LOG(INFO) << "Sampling the processes for " << duration;
+
+  sampling = true;
+
+  Owned<Promise<http::Response>> promise(new Promise<http::Response>());
+  delay(duration, self(), &Self::_actors, duration, promise);
+
+  return promise->future();
+}
+
+
+void Profiler::_actors(
+    const Duration& duration,
+    Owned<Promise<http::Response>> promise)
+{
+  struct itimerval timer;
+  memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, NULL);
+
+  enabled.store(false);
+  sampling = false;
+
+  const size_t total = sampled.load();
+  const size_t count = std::min(total, SAMPLES);
+
+  hashmap<const ProcessBase*, size_t> counts;
+  for (size_t i = 0; i < count; i++) {
+    counts[ring[i].load()]++;
+  }
+
+  // Each of the samples kept stands for the same share of the CPU
+  // time that was sampled.
+  const double secs =
+    count > 0 ? SAMPLE_INTERVAL.secs() * total / count : 0;
+
+  // Only now are the sampled processes looked up, so the samples of
+  // the processes which have since terminated are not attributed.
+  const hashmap<const ProcessBase*, internal::Spawned> spawned =
+    internal::processes();
+
+  // The processes which were sampled or have queued events, the ones
+  // sampled the most first.
+  std::vector<std::pair<size_t, const internal::Spawned*>> processes;
+
+  size_t unattributed = 0;
+
+  foreachpair (const ProcessBase* process, size_t samples, counts) {
+    if (!spawned.contains(process)) {
+      unattributed += samples;
+    }
+  }
+
+  foreachpair (const ProcessBase* process,
+               const internal::Spawned& spawned_,
+               spawned) {
+    const size_t samples = counts.get(process).getOrElse(0);
+    if (samples > 0 || spawned_.queued > 0) {
+      processes.push_back(std::make_pair(samples, &spawned_));
+    }
+  }
+
+  std::sort(
+      processes.begin(),
+      processes.end(),
+      [](const std::pair<size_t, const internal::Spawned*>& left,
+         const std::pair<size_t, const internal::Spawned*>& right) {
+        if (left.first != right.first) {
+          return left.first > right.first;
+        }
+        return left.second->pid.id < right.second->pid.id;
+      });
+
+  JSON::Array actors;
+
+  foreach (const auto& process, processes) {
+    JSON::Object actor;
+    actor.values["id"] = process.second->pid.id;
+    actor.values["samples"] = process.first;
+    actor.values["cpu_time_secs"] = secs * process.first;
+    actor.values["queued_events"] = process.second->queued;
+    actors.values.push_back(actor);
+  }
+
+  JSON::Object object;
+  object.values["duration_secs"] = duration.secs();
+  object.values["samples"] = total;
+  object.values["unattributed_samples"] = unattributed;
+  object.values["actors"] = actors;
+
+  promise->set(http::OK(object));
+}
+
 } // namespace process {
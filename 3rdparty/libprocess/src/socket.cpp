@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/shared_array.hpp>
 
@@ -28,6 +29,7 @@
 #include "poll_socket.hpp"
 
 using std::string;
+using std::vector;
 
 namespace process {
 namespace network {
@@ -244,5 +246,14 @@ Future<Nothing> Socket::Impl::send(const std::string& _data)
 }
 
 
+Future<size_t> Socket::Impl::send(const vector<struct iovec>& buffers)
+{
+  CHECK(!buffers.empty());
+
+  return send(static_cast<const char*>(buffers[0].iov_base),
+              buffers[0].iov_len);
+}
+
+
 } // namespace network {
 } // namespace process {
@@ -18,30 +18,47 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/subprocess.hpp>
+#include <process/timer.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
+#include <stout/flathashmap.hpp>
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
 #include <stout/stopwatch.hpp>
 
 namespace http = process::http;
 
+using process::Clock;
 using process::Future;
 using process::Owned;
+using process::PID;
 using process::Process;
 using process::ProcessBase;
 using process::Promise;
+using process::Subprocess;
+using process::Timer;
 using process::UPID;
 
 using std::cout;
@@ -219,12 +236,13 @@ private:
   hashset<UPID> links;
 };
 
-// TODO(bmahler): Since there is no forking here, libprocess
-// avoids going through sockets for local messages. Either fork
-// or have the ability to disable local messages in libprocess.
-
 // Launches many clients against a central server and measures
-// client throughput.
+// client throughput. Since libprocess avoids going through sockets
+// for local messages, the clients address the server through the
+// loopback interface so that the pings get encoded, sent over a
+// socket and decoded again. Run this with and without
+// LIBPROCESS_ENABLE_BINARY_FRAMING to compare the HTTP and binary
+// framing of messages.
 TEST(ProcessTest, Process_BENCHMARK_ClientServer)
 {
   const size_t numRequests = 10000;
@@ -233,7 +251,24 @@ TEST(ProcessTest, Process_BENCHMARK_ClientServer)
   const Bytes messageSize = Bytes(3);
 
   ServerProcess server;
-  const UPID serverPid = spawn(&server);
+  UPID serverPid = spawn(&server);
+
+  Try<net::IP> loopback = net::IP::parse("127.0.0.1", AF_INET);
+  ASSERT_SOME(loopback);
+
+  if (serverPid.address.ip == loopback.get()) {
+    cout << "Messages are delivered locally as libprocess is bound to "
+         << "the loopback interface" << endl;
+  }
+
+  serverPid.address.ip = loopback.get();
+
+  const string framing =
+    os::getenv("LIBPROCESS_ENABLE_BINARY_FRAMING").getOrElse("false");
+
+  cout << "Using "
+       << (framing == "1" || framing == "true" ? "binary" : "HTTP")
+       << " framing" << endl;
 
   // Launch the clients.
   vector<Owned<ClientProcess>> clients;
@@ -374,3 +409,287 @@ TEST(ProcessTest, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+// A process that counts the number of times it was dispatched to and
+// satisfies a future once it has seen the expected number.
+class CounterProcess : public Process<CounterProcess>
+{
+public:
+  explicit CounterProcess(size_t _expected)
+    : expected(_expected), count(0) {}
+
+  void increment()
+  {
+    if (++count == expected) {
+      promise.set(Nothing());
+    }
+  }
+
+  Future<Nothing> done() { return promise.future(); }
+
+private:
+  const size_t expected;
+  size_t count;
+  Promise<Nothing> promise;
+};
+
+
+// Measures the throughput of dispatches as the number of threads that
+// concurrently dispatch increases. Each thread dispatches to its own
+// process so that the only shared state is within libprocess (i.e.,
+// the run queue(s)). Run with LIBPROCESS_WORK_STEALING=1 to compare
+// the work stealing scheduler with the default one.
+TEST(ProcessTest, Process_BENCHMARK_DispatchThroughput)
+{
+  const size_t dispatches = 100000;
+  const size_t maxThreads =
+    2 * std::max(8u, std::thread::hardware_concurrency());
+
+  Option<string> stealing = os::getenv("LIBPROCESS_WORK_STEALING");
+  cout << "Work stealing: "
+       << (stealing.isSome() ? stealing.get() : "false") << endl;
+
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    vector<Owned<CounterProcess>> processes;
+    list<Future<Nothing>> futures;
+
+    for (size_t i = 0; i < threads; i++) {
+      processes.push_back(Owned<CounterProcess>(
+          new CounterProcess(dispatches)));
+      futures.push_back(processes.back()->done());
+      spawn(processes.back().get());
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    vector<std::thread> dispatchers;
+    foreach (const Owned<CounterProcess>& process, processes) {
+      const PID<CounterProcess> pid = process->self();
+      dispatchers.emplace_back([pid, dispatches]() {
+        for (size_t i = 0; i < dispatches; i++) {
+          dispatch(pid, &CounterProcess::increment);
+        }
+      });
+    }
+
+    foreach (std::thread& dispatcher, dispatchers) {
+      dispatcher.join();
+    }
+
+    AWAIT_READY_FOR(collect(futures), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << threads << " threads: "
+         << (dispatches * threads) / elapsed.secs()
+         << " dispatches / sec" << endl;
+
+    foreach (const Owned<CounterProcess>& process, processes) {
+      terminate(*process);
+      wait(*process);
+    }
+  }
+}
+
+
+// Measures creating, canceling and expiring a large number of
+// outstanding timers, as the master and agent do for offer and ping
+// timeouts.
+TEST(ProcessTest, Process_BENCHMARK_Timers)
+{
+  const size_t timers = 1000000;
+
+  Clock::pause();
+
+  std::atomic<size_t> fired(0);
+
+  vector<Timer> created;
+  created.reserve(timers);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < timers; i++) {
+    created.push_back(
+        Clock::timer(Milliseconds(1 + i % 100000), [&fired]() { fired++; }));
+  }
+
+  cout << "Created " << timers << " timers in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  // Cancel half of the timers.
+  for (size_t i = 0; i < timers; i += 2) {
+    Clock::cancel(created[i]);
+  }
+
+  cout << "Canceled " << timers / 2 << " timers in "
+       << watch.elapsed() << endl;
+
+  watch.start();
+
+  // Expire the remaining timers in steps of one second.
+  for (int i = 0; i < 100; i++) {
+    Clock::advance(Seconds(1));
+    Clock::settle();
+  }
+
+  cout << "Expired " << fired.load() << " timers in "
+       << watch.elapsed() << endl;
+
+  EXPECT_EQ(timers / 2, fired.load());
+
+  Clock::resume();
+}
+
+
+// Measures setting a promise with a single continuation, the common
+// case for the futures returned by `dispatch` and `then`.
+TEST(FutureTest, Future_BENCHMARK_Then)
+{
+  const size_t promises = 1000000;
+
+  Stopwatch watch;
+  watch.start();
+
+  size_t sum = 0;
+
+  for (size_t i = 0; i < promises; i++) {
+    Promise<size_t> promise;
+
+    Future<size_t> future = promise.future()
+      .then([](size_t value) { return value + 1; });
+
+    promise.set(i);
+
+    sum += future.get();
+  }
+
+  cout << "Set " << promises << " promises with a continuation in "
+       << watch.elapsed() << endl;
+
+  EXPECT_EQ(promises * (promises + 1) / 2, sum);
+}
+
+
+// Measures launching subprocesses, forked (i.e., with a 'setup'
+// function) and spawned, as the resident memory of the parent grows.
+TEST(SubprocessTest, Subprocess_BENCHMARK_Launch)
+{
+  const size_t launches = 100;
+
+  const vector<Bytes> sizes = {Bytes(0), Megabytes(256), Gigabytes(1)};
+  const vector<bool> forks = {true, false};
+
+  foreach (const Bytes& size, sizes) {
+    // Touch the memory so that it is resident.
+    vector<char> memory(size.bytes(), 1);
+
+    foreach (bool fork, forks) {
+      Option<lambda::function<int()>> setup = None();
+      if (fork) {
+        setup = []() { return 0; };
+      }
+
+      list<Future<Option<int>>> statuses;
+
+      Stopwatch watch;
+      watch.start();
+
+      for (size_t i = 0; i < launches; i++) {
+        Try<Subprocess> s = process::subprocess(
+            "true",
+            Subprocess::FD(STDIN_FILENO),
+            Subprocess::FD(STDOUT_FILENO),
+            Subprocess::FD(STDERR_FILENO),
+            None(),
+            setup);
+
+        ASSERT_SOME(s);
+        statuses.push_back(s.get().status());
+      }
+
+      cout << (fork ? "Forked " : "Spawned ") << launches
+           << " subprocesses with " << size << " resident in "
+           << watch.elapsed() << endl;
+
+      AWAIT_READY(collect(statuses));
+    }
+  }
+}
+
+
+// Inserts, looks up (each key 10 times) and erases the given keys,
+// returning the time each of these took.
+template <typename Map>
+static vector<Duration> mapOperations(const vector<string>& keys)
+{
+  vector<Duration> durations;
+  Map map;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    map[keys[i]] = i;
+  }
+
+  durations.push_back(watch.elapsed());
+  watch.start();
+
+  size_t sum = 0;
+  for (size_t repeat = 0; repeat < 10; repeat++) {
+    foreach (const string& key, keys) {
+      sum += map.find(key)->second;
+    }
+  }
+
+  durations.push_back(watch.elapsed());
+  watch.start();
+
+  foreach (const string& key, keys) {
+    map.erase(key);
+  }
+
+  durations.push_back(watch.elapsed());
+
+  EXPECT_EQ(10 * keys.size() * (keys.size() - 1) / 2, sum);
+  EXPECT_TRUE(map.empty());
+
+  return durations;
+}
+
+
+// Compares 'hashmap' and 'flathashmap' with keys like the IDs of
+// the master (e.g., of the offers).
+TEST(FlatHashMapTest, FlatHashMap_BENCHMARK_Operations)
+{
+  const vector<size_t> sizes = {1000, 100000, 1000000};
+
+  foreach (size_t size, sizes) {
+    vector<string> keys;
+    keys.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+      keys.push_back("a2b9036d-1b34-4de3-9536-ab1a7b6e6c0d-O" + stringify(i));
+    }
+
+    // Look the keys up in another order than they have been inserted.
+    std::random_shuffle(keys.begin(), keys.end());
+
+    const vector<Duration> hashed =
+      mapOperations<hashmap<string, size_t>>(keys);
+
+    const vector<Duration> flat =
+      mapOperations<flathashmap<string, size_t>>(keys);
+
+    cout << "hashmap with " << size << " keys: inserted in " << hashed[0]
+         << ", looked up in " << hashed[1] << ", erased in " << hashed[2]
+         << endl;
+
+    cout << "flathashmap with " << size << " keys: inserted in " << flat[0]
+         << ", looked up in " << flat[1] << ", erased in " << flat[2]
+         << endl;
+  }
+}
@@ -20,13 +20,18 @@
 #include <stout/gtest.hpp>
 
 #include "decoder.hpp"
+#include "encoder.hpp"
 
 namespace http = process::http;
 
 using process::DataDecoder;
+using process::FramedMessageDecoder;
+using process::FramedMessageEncoder;
 using process::Future;
+using process::Message;
 using process::ResponseDecoder;
 using process::StreamingResponseDecoder;
+using process::UPID;
 
 using process::network::Socket;
 
@@ -122,6 +127,58 @@ TEST(DecoderTest, RequestHeaderCaseInsensitive)
 }
 
 
+// Tests that requests are decoded when the URL and the headers are
+// split across many calls, including pipelined requests which reuse
+// the buffers of the decoder.
+TEST(DecoderTest, RequestFragmented)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder = DataDecoder(socket.get());
+
+  const string data =
+    "GET /path/file.json?key=value#fragment HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Accept-Encoding: compress, gzip\r\n"
+    "\r\n"
+    "GET /other HTTP/1.1\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+  deque<http::Request*> requests;
+  for (size_t i = 0; i < data.length(); i++) {
+    deque<http::Request*> decoded = decoder.decode(data.data() + i, 1);
+    ASSERT_FALSE(decoder.failed());
+    requests.insert(requests.end(), decoded.begin(), decoded.end());
+  }
+
+  ASSERT_EQ(2u, requests.size());
+
+  http::Request* request = requests[0];
+  EXPECT_EQ("/path/file.json", request->url.path);
+  EXPECT_SOME_EQ("fragment", request->url.fragment);
+  EXPECT_SOME_EQ("value", request->url.query.get("key"));
+  EXPECT_TRUE(request->keepAlive);
+
+  EXPECT_EQ(2u, request->headers.size());
+  EXPECT_SOME_EQ("localhost", request->headers.get("Host"));
+  EXPECT_SOME_EQ("compress, gzip", request->headers.get("Accept-Encoding"));
+
+  delete request;
+
+  request = requests[1];
+  EXPECT_EQ("/other", request->url.path);
+  EXPECT_NONE(request->url.fragment);
+  EXPECT_TRUE(request->url.query.empty());
+  EXPECT_FALSE(request->keepAlive);
+
+  EXPECT_EQ(1u, request->headers.size());
+  EXPECT_SOME_EQ("close", request->headers.get("Connection"));
+
+  delete request;
+}
+
+
 TEST(DecoderTest, Response)
 {
   ResponseDecoder decoder;
@@ -253,3 +310,47 @@ TEST(DecoderTest, StreamingResponseFailure)
   EXPECT_TRUE(read.isFailed());
   EXPECT_EQ("failed to decode body", read.failure());
 }
+
+
+TEST(DecoderTest, FramedMessage)
+{
+  Message* message = new Message();
+  message->name = "ping";
+  message->from = UPID("client@127.0.0.1:5050");
+  message->to = UPID("server@127.0.0.1:5051");
+  message->body = string("body\0with\0nulls", 15);
+
+  const string data = FramedMessageEncoder::encode(message);
+
+  FramedMessageDecoder decoder;
+
+  // Feed the frame one byte at a time, a message should only come
+  // out once the whole frame has been received.
+  for (size_t i = 0; i < data.size() - 1; i++) {
+    EXPECT_TRUE(decoder.decode(data.data() + i, 1).empty());
+    EXPECT_FALSE(decoder.failed());
+  }
+
+  deque<Message*> messages =
+    decoder.decode(data.data() + data.size() - 1, 1);
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1u, messages.size());
+
+  EXPECT_EQ(message->name, messages[0]->name);
+  EXPECT_EQ(message->from, messages[0]->from);
+  EXPECT_EQ(message->to.id, messages[0]->to.id);
+  EXPECT_EQ(message->body, messages[0]->body);
+
+  delete messages[0];
+
+  // Two frames received at once are both decoded.
+  messages = decoder.decode((data + data).data(), data.size() * 2);
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(2u, messages.size());
+
+  delete messages[0];
+  delete messages[1];
+  delete message;
+}
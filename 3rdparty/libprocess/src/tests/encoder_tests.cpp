@@ -26,9 +26,12 @@
 
 namespace http = process::http;
 
+using process::Future;
 using process::HttpResponseEncoder;
 using process::ResponseDecoder;
 
+using process::network::Socket;
+
 using std::deque;
 using std::string;
 using std::vector;
@@ -63,6 +66,74 @@ TEST(EncoderTest, Response)
 }
 
 
+// Tests that the body of a response is sent as a separate buffer
+// without being copied.
+TEST(EncoderTest, ResponseBuffers)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  http::Request request;
+  const Future<http::Response> response = http::OK(string(4096, '1'));
+
+  HttpResponseEncoder encoder(socket.get(), response, request);
+
+  vector<struct iovec> buffers = encoder.next();
+  ASSERT_EQ(2u, buffers.size());
+  EXPECT_EQ(0u, encoder.remaining());
+
+  const string header(
+      static_cast<const char*>(buffers[0].iov_base), buffers[0].iov_len);
+
+  EXPECT_EQ(0u, header.find("HTTP/1.1 200 OK\r\n"));
+  EXPECT_NE(string::npos, header.find("Content-Length: 4096\r\n"));
+
+  EXPECT_EQ(response.get().body.data(), buffers[1].iov_base);
+  EXPECT_EQ(response.get().body.size(), buffers[1].iov_len);
+
+  // Backing up resumes from the middle of the body.
+  encoder.backup(100);
+  EXPECT_EQ(100u, encoder.remaining());
+
+  buffers = encoder.next();
+  ASSERT_EQ(1u, buffers.size());
+  EXPECT_EQ(response.get().body.data() + 3996, buffers[0].iov_base);
+  EXPECT_EQ(100u, buffers[0].iov_len);
+}
+
+
+// Tests that the compressed body of a response with an 'ETag' is
+// reused for the same body, but not for a different body that is
+// sent with the same 'ETag' (e.g., by another endpoint).
+TEST(EncoderTest, GzipETag)
+{
+  http::Request request;
+  request.headers["Accept-Encoding"] = "gzip";
+
+  http::OK first(string(4096, '1'));
+  first.headers["ETag"] = "\"tag\"";
+
+  http::OK second(string(4096, '2'));
+  second.headers["ETag"] = "\"tag\"";
+
+  foreach (const http::OK& response, vector<http::OK>{first, first, second}) {
+    const string encoded = HttpResponseEncoder::encode(response, request);
+
+    ResponseDecoder decoder;
+    deque<http::Response*> responses =
+      decoder.decode(encoded.data(), encoded.length());
+
+    ASSERT_FALSE(decoder.failed());
+    ASSERT_EQ(1u, responses.size());
+
+    EXPECT_SOME_EQ("gzip", responses[0]->headers.get("Content-Encoding"));
+    EXPECT_EQ(response.body, responses[0]->body);
+
+    delete responses[0];
+  }
+}
+
+
 TEST(EncoderTest, AcceptableEncodings)
 {
   // Create requests that do not accept gzip encoding.
@@ -487,6 +487,49 @@ TEST(HTTPTest, StreamingGetComplete)
 }
 
 
+// Tests that streamed responses are compressed a chunk at a time
+// when the client accepts gzip.
+TEST(HTTPTest, StreamingGetCompressed)
+{
+  Http http;
+
+  http::Pipe pipe;
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.reader = pipe.reader();
+
+  EXPECT_CALL(*http.process, pipe(_))
+    .WillOnce(Return(ok));
+
+  http::Headers headers;
+  headers["Accept-Encoding"] = "gzip";
+
+  Future<http::Response> response =
+    http::streaming::get(http.process->self(), "pipe", None(), headers);
+
+  AWAIT_READY(response);
+
+  EXPECT_SOME_EQ("chunked", response.get().headers.get("Transfer-Encoding"));
+  EXPECT_SOME_EQ("gzip", response.get().headers.get("Content-Encoding"));
+  ASSERT_EQ(http::Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  http::Pipe::Reader reader = response.get().reader.get();
+
+  // Every chunk can be read (decompressed) as soon as it is written.
+  http::Pipe::Writer writer = pipe.writer();
+  EXPECT_TRUE(writer.write("hello"));
+  AWAIT_EQ("hello", reader.read());
+
+  EXPECT_TRUE(writer.write("goodbye"));
+  AWAIT_EQ("goodbye", reader.read());
+
+  // Complete the response.
+  EXPECT_TRUE(writer.close());
+  AWAIT_EQ("", reader.read()); // EOF.
+}
+
+
 TEST(HTTPTest, StreamingGetFailure)
 {
   Http http;
@@ -628,6 +671,32 @@ TEST(HTTPTest, Delete)
 }
 
 
+// Sequential requests to the same server should reuse the pooled
+// connection, i.e., come from the same client address.
+TEST(HTTPTest, ConnectionReuse)
+{
+  Http http;
+
+  Future<http::Request> request1;
+  Future<http::Request> request2;
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(DoAll(FutureArg<0>(&request1), Return(http::OK())))
+    .WillOnce(DoAll(FutureArg<0>(&request2), Return(http::OK())));
+
+  Future<http::Response> response = http::get(http.process->self(), "get");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  response = http::get(http.process->self(), "get");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  AWAIT_READY(request1);
+  AWAIT_READY(request2);
+
+  EXPECT_TRUE(request1->keepAlive);
+  EXPECT_EQ(request1->client, request2->client);
+}
+
 TEST(HTTPConnectionTest, Serial)
 {
   Http http;
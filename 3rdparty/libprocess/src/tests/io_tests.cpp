@@ -215,6 +215,50 @@ TEST(IOTest, Write)
 }
 
 
+TEST(IOTest, Buffer)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  int pipes[2];
+
+  // Create a nonblocking pipe.
+  ASSERT_NE(-1, ::pipe(pipes));
+  ASSERT_SOME(os::nonblock(pipes[0]));
+  ASSERT_SOME(os::nonblock(pipes[1]));
+
+  // The read only completes once there is some data.
+  Future<io::Buffer> buffer = io::read(pipes[0], io::BUFFERED_READ_SIZE);
+  EXPECT_TRUE(buffer.isPending());
+
+  ASSERT_SOME(os::write(pipes[1], "hello world"));
+
+  AWAIT_READY(buffer);
+  EXPECT_EQ("hello world", buffer.get().string());
+
+  // A slice shares the data of the buffer.
+  io::Buffer slice = buffer.get().slice(6);
+  EXPECT_EQ("world", slice.string());
+  EXPECT_EQ(buffer.get().data() + 6, slice.data());
+  EXPECT_TRUE(buffer.get().slice(20).empty());
+
+  // Write out the slice without copying it, and read it back.
+  AWAIT_READY(io::write(pipes[1], slice));
+
+  char data[5];
+  AWAIT_EXPECT_EQ(5u, io::read(pipes[0], data, 5));
+  EXPECT_EQ("world", string(data, 5));
+
+  // Test reading EOF.
+  ASSERT_SOME(os::close(pipes[1]));
+
+  buffer = io::read(pipes[0], io::BUFFERED_READ_SIZE);
+  AWAIT_READY(buffer);
+  EXPECT_TRUE(buffer.get().empty());
+
+  ASSERT_SOME(os::close(pipes[0]));
+}
+
+
 TEST(IOTest, DISABLED_BlockingWrite)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
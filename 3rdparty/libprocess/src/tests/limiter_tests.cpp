@@ -121,3 +121,43 @@ TEST(LimiterTest, DiscardLast)
   Clock::advance(interval);
   AWAIT_READY(acquire3);
 }
+
+
+// Tests that a permit which is available is acquired right away, but
+// only when there are no earlier acquisitions waiting for a permit.
+TEST(LimiterTest, AcquireAvailable)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  int permits = 2;
+  Duration duration = Milliseconds(5);
+
+  RateLimiter limiter(permits, duration);
+  Milliseconds interval = duration / permits;
+
+  Clock::pause();
+
+  Future<Nothing> acquire1 = limiter.acquire();
+  EXPECT_TRUE(acquire1.isReady());
+
+  Future<Nothing> acquire2 = limiter.acquire();
+  EXPECT_TRUE(acquire2.isPending());
+
+  // The permit becomes available, but 'acquire2' is waiting already.
+  Clock::advance(interval);
+  Future<Nothing> acquire3 = limiter.acquire();
+
+  AWAIT_READY(acquire2);
+  EXPECT_TRUE(acquire3.isPending());
+
+  Clock::advance(interval);
+  AWAIT_READY(acquire3);
+
+  // Once nobody is waiting, available permits are acquired right
+  // away again.
+  Clock::advance(interval);
+  Clock::settle();
+
+  Future<Nothing> acquire4 = limiter.acquire();
+  EXPECT_TRUE(acquire4.isReady());
+}
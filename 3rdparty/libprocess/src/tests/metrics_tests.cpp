@@ -10,27 +10,41 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <sys/socket.h>
+#include <sys/time.h>
+
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
+#include <stout/ip.hpp>
+#include <stout/os.hpp>
+#include <stout/strings.hpp>
 
+#include <process/address.hpp>
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
+#include <process/network.hpp>
 #include <process/process.hpp>
 #include <process/statistics.hpp>
 #include <process/time.hpp>
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/histogram.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 #include <process/metrics/timer.hpp>
 
+#include "metrics/statsd.hpp"
+
 namespace http = process::http;
 namespace metrics = process::metrics;
 
@@ -40,8 +54,13 @@ using http::Response;
 
 using metrics::Counter;
 using metrics::Gauge;
+using metrics::Histogram;
+using metrics::PushGauge;
 using metrics::Timer;
 
+using metrics::internal::MetricsProcess;
+using metrics::internal::StatsdProcess;
+
 using process::Clock;
 using process::Failure;
 using process::Future;
@@ -50,8 +69,11 @@ using process::Process;
 using process::Statistics;
 using process::UPID;
 
+using process::network::Address;
+
 using std::map;
 using std::string;
+using std::vector;
 
 class GaugeProcess : public Process<GaugeProcess>
 {
@@ -93,6 +115,9 @@ TEST(MetricsTest, Counter)
   counter += 42;
   AWAIT_EXPECT_EQ(42.0, counter.value());
 
+  // The value of a counter can be read without waiting on a future.
+  EXPECT_SOME_EQ(42.0, counter.current());
+
   EXPECT_NONE(counter.statistics());
 
   AWAIT_READY(metrics::remove(counter));
@@ -130,6 +155,35 @@ TEST(MetricsTest, Gauge)
 }
 
 
+TEST(MetricsTest, PushGauge)
+{
+  PushGauge gauge("test/push_gauge", process::TIME_SERIES_WINDOW);
+
+  AWAIT_READY(metrics::add(gauge));
+
+  AWAIT_EXPECT_EQ(0.0, gauge.value());
+
+  // There are no statistics until a value gets pushed.
+  EXPECT_NONE(gauge.statistics());
+
+  gauge = 42;
+  AWAIT_EXPECT_EQ(42.0, gauge.value());
+
+  gauge = 1;
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+  EXPECT_SOME_EQ(1.0, gauge.current());
+
+  Option<Statistics<double>> statistics = gauge.statistics();
+  ASSERT_SOME(statistics);
+
+  EXPECT_EQ(2u, statistics.get().count);
+  EXPECT_FLOAT_EQ(1.0, statistics.get().min);
+  EXPECT_FLOAT_EQ(42.0, statistics.get().max);
+
+  AWAIT_READY(metrics::remove(gauge));
+}
+
+
 TEST(MetricsTest, Statistics)
 {
   Counter counter("test/counter", process::TIME_SERIES_WINDOW);
@@ -164,6 +218,63 @@ TEST(MetricsTest, Statistics)
 }
 
 
+TEST(MetricsTest, Histogram)
+{
+  Histogram histogram("test/histogram");
+
+  AWAIT_READY(metrics::add(histogram));
+
+  EXPECT_SOME_EQ(0.0, histogram.current());
+  EXPECT_NONE(histogram.statistics());
+
+  for (int i = 1; i <= 100; i++) {
+    histogram.record(i);
+  }
+
+  EXPECT_EQ(100u, histogram.count());
+  EXPECT_FLOAT_EQ(5050.0, histogram.sum());
+
+  AWAIT_EXPECT_EQ(100.0, histogram.value());
+
+  // The values are counted in buckets of 1/8 of a power of two.
+  EXPECT_EQ(Histogram::bucket(1.0), Histogram::bucket(1.1));
+  EXPECT_NE(Histogram::bucket(1.0), Histogram::bucket(1.2));
+  EXPECT_FLOAT_EQ(1.125, Histogram::upper(Histogram::bucket(1.0)));
+  EXPECT_EQ(0u, Histogram::bucket(0.0));
+
+  Option<Statistics<double>> statistics = histogram.statistics();
+  ASSERT_SOME(statistics);
+
+  EXPECT_EQ(100u, statistics.get().count);
+  EXPECT_FLOAT_EQ(1.0, statistics.get().min);
+  EXPECT_FLOAT_EQ(100.0, statistics.get().max);
+
+  // The percentiles are estimated within a bucket.
+  EXPECT_NEAR(50.0, statistics.get().p50, 50.0 / 8);
+  EXPECT_NEAR(90.0, statistics.get().p90, 90.0 / 8);
+  EXPECT_NEAR(99.0, statistics.get().p99, 99.0 / 8);
+  EXPECT_FLOAT_EQ(100.0, statistics.get().p9999);
+
+  // Merging adds up the buckets.
+  Histogram other("test/other");
+  other.record(1000);
+  other.record(0.5);
+
+  histogram.merge(other);
+
+  EXPECT_EQ(102u, histogram.count());
+  EXPECT_FLOAT_EQ(6050.5, histogram.sum());
+
+  statistics = histogram.statistics();
+  ASSERT_SOME(statistics);
+
+  EXPECT_FLOAT_EQ(0.5, statistics.get().min);
+  EXPECT_FLOAT_EQ(1000.0, statistics.get().max);
+
+  AWAIT_READY(metrics::remove(histogram));
+}
+
+
 TEST(MetricsTest, Snapshot)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -236,6 +347,71 @@ TEST(MetricsTest, Snapshot)
 }
 
 
+TEST(MetricsTest, Prometheus)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  UPID upid("metrics", process::address());
+
+  Clock::pause();
+
+  GaugeProcess process;
+  PID<GaugeProcess> pid = spawn(&process);
+  ASSERT_TRUE(pid);
+
+  Gauge gauge("test/gauge", defer(pid, &GaugeProcess::get));
+  Counter counter("test/counter");
+  Histogram histogram("test/histogram");
+
+  AWAIT_READY(metrics::add(gauge));
+  AWAIT_READY(metrics::add(counter));
+  AWAIT_READY(metrics::add(histogram));
+
+  counter += 3;
+
+  histogram.record(1.0);
+  histogram.record(1.0);
+  histogram.record(3.0);
+
+  // Advance the clock to avoid rate limit.
+  Clock::advance(Seconds(1));
+
+  Future<Response> response = http::get(upid, "prometheus");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      "text/plain; version=0.0.4",
+      "Content-Type",
+      response);
+
+  const string& body = response.get().body;
+
+  EXPECT_TRUE(strings::contains(body, "# TYPE test_gauge gauge\n"));
+  EXPECT_TRUE(strings::contains(body, "\ntest_gauge 42\n"));
+
+  EXPECT_TRUE(strings::contains(body, "# TYPE test_counter counter\n"));
+  EXPECT_TRUE(strings::contains(body, "\ntest_counter 3\n"));
+
+  // The bucket counts are cumulative.
+  EXPECT_TRUE(strings::contains(body, "# TYPE test_histogram histogram\n"));
+  EXPECT_TRUE(
+      strings::contains(body, "\ntest_histogram_bucket{le=\"1.125\"} 2\n"));
+  EXPECT_TRUE(
+      strings::contains(body, "\ntest_histogram_bucket{le=\"3.25\"} 3\n"));
+  EXPECT_TRUE(
+      strings::contains(body, "\ntest_histogram_bucket{le=\"+Inf\"} 3\n"));
+  EXPECT_TRUE(strings::contains(body, "\ntest_histogram_sum 5\n"));
+  EXPECT_TRUE(strings::contains(body, "\ntest_histogram_count 3\n"));
+
+  AWAIT_READY(metrics::remove(gauge));
+  AWAIT_READY(metrics::remove(counter));
+  AWAIT_READY(metrics::remove(histogram));
+
+  terminate(process);
+  wait(process);
+}
+
+
 TEST(MetricsTest, SnapshotTimeout)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -411,6 +587,9 @@ TEST(MetricsTest, Timer)
 
   AWAIT_READY(metrics::add(timer));
 
+  // There is no value until the timer has been stopped.
+  EXPECT_NONE(timer.current());
+
   // It is not an error to stop a timer that hasn't been started.
   timer.stop();
 
@@ -423,6 +602,7 @@ TEST(MetricsTest, Timer)
   Future<double> value = timer.value();
   AWAIT_READY(value);
   EXPECT_FLOAT_EQ(value.get(), Microseconds(1).ns());
+  EXPECT_SOME_EQ(value.get(), timer.current());
 
   // It is not an error to stop a timer that has already been stopped.
   timer.stop();
@@ -462,3 +642,113 @@ TEST(MetricsTest, AsyncTimer)
 
   AWAIT_READY(metrics::remove(t));
 }
+
+
+// Receives a datagram of StatsD lines on the socket (or none).
+static vector<string> receive(int s)
+{
+  char data[StatsdProcess::MAX_DATAGRAM_SIZE];
+
+  ssize_t length = ::recv(s, data, sizeof(data), 0);
+  if (length <= 0) {
+    return vector<string>();
+  }
+
+  return strings::split(string(data, length), "\n");
+}
+
+
+TEST(MetricsTest, Statsd)
+{
+  // A UDP socket to receive the pushed metrics.
+  int s = ::socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_NE(-1, s);
+
+  Try<net::IP> ip = net::IP::parse("127.0.0.1", AF_INET);
+  ASSERT_SOME(ip);
+  ASSERT_SOME(process::network::bind(s, Address(ip.get(), 0)));
+
+  Try<Address> address = process::network::address(s);
+  ASSERT_SOME(address);
+
+  // Don't wait forever for a push which never comes.
+  struct timeval timeout = {5, 0};
+  ASSERT_EQ(
+      0,
+      setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+
+  Counter counter("test/statsd/counter");
+  Histogram histogram("test/statsd/histogram");
+  PushGauge gauge("test/statsd/gauge");
+  Counter other("test/other");
+
+  AWAIT_READY(metrics::add(counter));
+  AWAIT_READY(metrics::add(histogram));
+  AWAIT_READY(metrics::add(gauge));
+  AWAIT_READY(metrics::add(other));
+
+  counter += 3;
+  histogram.record(1);
+  histogram.record(1);
+  gauge = -2;
+  ++other;
+
+  const Duration interval = Seconds(10);
+
+  Clock::pause();
+
+  StatsdProcess statsd(
+      MetricsProcess::instance()->self(),
+      address.get(),
+      interval,
+      {"test/statsd/"});
+
+  process::spawn(statsd);
+
+  Clock::settle();
+  Clock::advance(interval);
+
+  // The first push has the whole value of the counter, the values of
+  // the histogram (as the middle of their bucket) and the gauge,
+  // which first gets reset because it is negative.
+  vector<string> lines = receive(s);
+
+  ASSERT_EQ(4u, lines.size());
+  EXPECT_NE(lines.end(),
+            std::find(lines.begin(), lines.end(), "test.statsd.counter:3|c"));
+  EXPECT_NE(lines.end(),
+            std::find(lines.begin(),
+                      lines.end(),
+                      "test.statsd.histogram:1.0625|ms|@0.5"));
+
+  vector<string>::iterator reset =
+    std::find(lines.begin(), lines.end(), "test.statsd.gauge:0|g");
+  ASSERT_NE(lines.end(), reset);
+  EXPECT_EQ("test.statsd.gauge:-2|g", *(reset + 1));
+
+  // The next push only has the deltas.
+  ++counter;
+  gauge = 5;
+
+  Clock::advance(interval);
+
+  lines = receive(s);
+
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_NE(lines.end(),
+            std::find(lines.begin(), lines.end(), "test.statsd.counter:1|c"));
+  EXPECT_NE(lines.end(),
+            std::find(lines.begin(), lines.end(), "test.statsd.gauge:5|g"));
+
+  process::terminate(statsd);
+  process::wait(statsd);
+
+  Clock::resume();
+
+  AWAIT_READY(metrics::remove(counter));
+  AWAIT_READY(metrics::remove(histogram));
+  AWAIT_READY(metrics::remove(gauge));
+  AWAIT_READY(metrics::remove(other));
+
+  ASSERT_SOME(os::close(s));
+}
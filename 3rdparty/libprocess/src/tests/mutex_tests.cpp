@@ -10,13 +10,31 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <string>
+
 #include <gmock/gmock.h>
 
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
+#include <process/gtest.hpp>
 #include <process/mutex.hpp>
+#include <process/owned.hpp>
+
+#include <process/metrics/metric.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 
 using process::Future;
 using process::Mutex;
+using process::Owned;
+
+using process::metrics::Metric;
+
+using process::metrics::internal::MetricsProcess;
+
+using std::string;
 
 TEST(MutexTest, Lock)
 {
@@ -76,3 +94,60 @@ TEST(MutexTest, Queue)
 
   EXPECT_TRUE(locked2.isReady());
 }
+
+
+// Tests that a waiter whose future has been discarded does not get
+// the mutex.
+TEST(MutexTest, Discard)
+{
+  Mutex mutex;
+
+  EXPECT_TRUE(mutex.lock().isReady());
+
+  Future<Nothing> locked1 = mutex.lock();
+  Future<Nothing> locked2 = mutex.lock();
+
+  locked1.discard();
+
+  // After we release the mutex the discarded waiter is skipped.
+  mutex.unlock();
+
+  EXPECT_TRUE(locked1.isDiscarded());
+  EXPECT_TRUE(locked2.isReady());
+
+  // Once the second waiter releases the mutex, it is available.
+  mutex.unlock();
+
+  EXPECT_TRUE(mutex.lock().isReady());
+}
+
+
+TEST(MutexTest, Metrics)
+{
+  Mutex mutex("mutex_test");
+
+  EXPECT_TRUE(mutex.lock().isReady());
+
+  Future<Nothing> locked1 = mutex.lock();
+  Future<Nothing> locked2 = mutex.lock();
+
+  mutex.unlock();
+  mutex.unlock();
+  mutex.unlock();
+
+  EXPECT_TRUE(locked1.isReady());
+  EXPECT_TRUE(locked2.isReady());
+
+  Future<hashmap<string, Owned<Metric>>> metrics =
+    dispatch(MetricsProcess::instance(), &MetricsProcess::registered);
+
+  AWAIT_READY(metrics);
+
+  // Both waiters waited, one with a queue depth of 1 and the other
+  // with a queue depth of 2.
+  ASSERT_TRUE(metrics.get().contains("mutex_test/wait_time_ms"));
+  EXPECT_SOME_EQ(2.0, metrics.get().at("mutex_test/wait_time_ms")->current());
+
+  ASSERT_TRUE(metrics.get().contains("mutex_test/queue_depth"));
+  EXPECT_SOME_EQ(2.0, metrics.get().at("mutex_test/queue_depth")->current());
+}
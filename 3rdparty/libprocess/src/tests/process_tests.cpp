@@ -22,6 +22,7 @@
 #include <atomic>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -1153,6 +1154,168 @@ TEST(ProcessTest, InjectExited)
 }
 
 
+class EventCountProcess : public Process<EventCountProcess>
+{
+public:
+  EventCountProcess() : noops(0) {}
+
+  void block(const Future<Nothing>& future)
+  {
+    blocked.set(Nothing());
+    future.await();
+  }
+
+  void noop()
+  {
+    noops++;
+  }
+
+  size_t dispatches()
+  {
+    return eventCount<process::DispatchEvent>();
+  }
+
+  size_t terminates()
+  {
+    return eventCount<TerminateEvent>();
+  }
+
+  Promise<Nothing> blocked;
+  std::atomic_size_t noops;
+};
+
+
+// Checks that events enqueued concurrently from many threads are
+// counted, and that injected events are dequeued before all others.
+TEST(ProcessTest, EventCount)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  EventCountProcess process;
+  PID<EventCountProcess> pid = spawn(process);
+
+  Promise<Nothing> promise;
+  dispatch(pid, &EventCountProcess::block, promise.future());
+
+  AWAIT_READY(process.blocked.future());
+
+  const size_t threads = 4;
+  const size_t dispatches = 1000;
+
+  vector<std::thread> dispatchers;
+  for (size_t i = 0; i < threads; i++) {
+    dispatchers.emplace_back([pid, dispatches]() {
+      for (size_t j = 0; j < dispatches; j++) {
+        dispatch(pid, &EventCountProcess::noop);
+      }
+    });
+  }
+
+  foreach (std::thread& dispatcher, dispatchers) {
+    dispatcher.join();
+  }
+
+  EXPECT_EQ(threads * dispatches, process.dispatches());
+  EXPECT_EQ(0u, process.terminates());
+
+  // Inject a terminate so that none of the queued dispatches run.
+  terminate(pid, true);
+
+  EXPECT_EQ(1u, process.terminates());
+
+  promise.set(Nothing());
+
+  wait(pid);
+
+  EXPECT_EQ(0u, process.noops.load());
+}
+
+
+class BatchProcess : public Process<BatchProcess>
+{
+public:
+  BatchProcess() : pings(0) {}
+
+  virtual void initialize()
+  {
+    install("ping", &BatchProcess::ping);
+    install("pong", &BatchProcess::pong);
+
+    batch("ping", 4);
+  }
+
+  void block(const Future<Nothing>& future)
+  {
+    blocked.set(Nothing());
+    future.await();
+  }
+
+  vector<size_t> sizes()
+  {
+    return batches;
+  }
+
+  Promise<Nothing> blocked;
+  size_t pings;
+
+protected:
+  virtual void visit(const vector<const MessageEvent*>& events)
+  {
+    batches.push_back(events.size());
+    ProcessBase::visit(events);
+  }
+
+private:
+  void ping(const UPID& from, const string& body)
+  {
+    pings++;
+  }
+
+  void pong(const UPID& from, const string& body)
+  {
+    batches.push_back(0);
+  }
+
+  // The sizes of the batches of pings, with a zero for each pong.
+  vector<size_t> batches;
+};
+
+
+// Checks that consecutive messages that batching is enabled for are
+// visited together, without reordering them with other messages.
+TEST(ProcessTest, Batch)
+{
+  BatchProcess process;
+  PID<BatchProcess> pid = spawn(process);
+
+  Promise<Nothing> promise;
+  dispatch(pid, &BatchProcess::block, promise.future());
+
+  AWAIT_READY(process.blocked.future());
+
+  for (size_t i = 0; i < 10; i++) {
+    post(pid, "ping");
+  }
+
+  post(pid, "pong");
+
+  for (size_t i = 0; i < 5; i++) {
+    post(pid, "ping");
+  }
+
+  promise.set(Nothing());
+
+  Future<vector<size_t>> sizes = dispatch(pid, &BatchProcess::sizes);
+  AWAIT_READY(sizes);
+
+  EXPECT_EQ(vector<size_t>({4, 4, 2, 0, 4, 1}), sizes.get());
+  EXPECT_EQ(15u, process.pings);
+
+  terminate(pid);
+  wait(pid);
+}
+
+
 TEST(ProcessTest, Select)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -2002,3 +2165,61 @@ TEST(ProcessTest, FirewallUninstall)
   terminate(process);
   wait(process);
 }
+
+
+class SpinProcess : public Process<SpinProcess>
+{
+public:
+  void spin(const Duration& duration)
+  {
+    Stopwatch stopwatch;
+    stopwatch.start();
+
+    while (stopwatch.elapsed() < duration) {}
+  }
+};
+
+
+// Ensures that the CPU time sampled by '/profiler/actors' is
+// attributed to the process which used it.
+TEST(ProcessTest, ProfilerActors)
+{
+  UPID profiler("profiler", process::address());
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::BadRequest().status,
+      http::get(profiler, "actors", "duration=foobar"));
+
+  SpinProcess process;
+  PID<SpinProcess> pid = spawn(process);
+
+  Future<http::Response> response =
+    http::get(profiler, "actors", "duration=500ms");
+
+  dispatch(pid, &SpinProcess::spin, Milliseconds(300));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(object);
+
+  Result<JSON::Array> actors = object->find<JSON::Array>("actors");
+  ASSERT_SOME(actors);
+
+  Option<JSON::Object> actor;
+  foreach (const JSON::Value& value, actors->values) {
+    Result<JSON::String> id = value.as<JSON::Object>().find<JSON::String>("id");
+    if (id.isSome() && id->value == pid.id) {
+      actor = value.as<JSON::Object>();
+    }
+  }
+
+  ASSERT_SOME(actor);
+
+  Result<JSON::Number> samples = actor->find<JSON::Number>("samples");
+  ASSERT_SOME(samples);
+  EXPECT_LT(0u, samples->as<size_t>());
+
+  terminate(process);
+  wait(process);
+}
@@ -12,6 +12,8 @@
 
 #include <stdlib.h>
 
+#include <string>
+
 #include <gmock/gmock.h>
 
 #include <process/defer.hpp>
@@ -19,17 +21,30 @@
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/gmock.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/sequence.hpp>
 
+#include <process/metrics/metric.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 
 using process::Clock;
 using process::Future;
+using process::Owned;
 using process::Process;
 using process::Promise;
 using process::Sequence;
 
+using process::metrics::Metric;
+
+using process::metrics::internal::MetricsProcess;
+
+using std::string;
+
 using testing::_;
 using testing::Return;
 
@@ -271,3 +286,58 @@ TEST(SequenceTest, Random)
   terminate(process);
   wait(process);
 }
+
+
+// The test verifies that a named sequence exposes how long the
+// callbacks waited for the previous ones, and how many were queued.
+TEST(SequenceTest, Metrics)
+{
+  DiscardProcess process;
+  spawn(process);
+
+  Sequence sequence("sequence_test");
+
+  lambda::function<Future<Nothing>()> f;
+
+  f = defer(process, &DiscardProcess::func0);
+  Future<Nothing> f0 = sequence.add(f);
+
+  f = defer(process, &DiscardProcess::func1);
+  Future<Nothing> f1 = sequence.add(f);
+
+  f = defer(process, &DiscardProcess::func2);
+  Future<Nothing> f2 = sequence.add(f);
+
+  EXPECT_CALL(process, func1())
+    .WillOnce(Return(Nothing()));
+
+  EXPECT_CALL(process, func2())
+    .WillOnce(Return(Nothing()));
+
+  // Flush the event queue to make sure that all callbacks have been
+  // added to the sequence.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  process.promise.set(Nothing());
+
+  AWAIT_READY(f2);
+
+  Future<hashmap<string, Owned<Metric>>> metrics =
+    dispatch(MetricsProcess::instance(), &MetricsProcess::registered);
+
+  AWAIT_READY(metrics);
+
+  // The first callback did not have to wait, the others did.
+  ASSERT_TRUE(metrics.get().contains("sequence_test/wait_time_ms"));
+  EXPECT_SOME_EQ(
+      2.0, metrics.get().at("sequence_test/wait_time_ms")->current());
+
+  ASSERT_TRUE(metrics.get().contains("sequence_test/queue_depth"));
+  EXPECT_SOME_EQ(
+      2.0, metrics.get().at("sequence_test/queue_depth")->current());
+
+  terminate(process);
+  wait(process);
+}
@@ -0,0 +1,359 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __TIMER_WHEEL_HPP__
+#define __TIMER_WHEEL_HPP__
+
+#include <stdint.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+
+#include <process/time.hpp>
+#include <process/timer.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+
+namespace process {
+
+// A hierarchical timing wheel holding the pending timers of the
+// clock. Inserting and canceling a timer takes constant time,
+// independent of the number of outstanding timers.
+//
+// Timeouts are kept at nanosecond precision and split into 8 digits
+// of 8 bits each, one digit per level of the wheel. A timer is kept
+// at the level of the most significant digit in which its timeout
+// differs from the time the wheel was last advanced to ('base'), in
+// the slot given by that digit. Timers whose timeout is not after
+// 'base' are kept aside as overdue. Advancing the wheel expires the
+// slots that were passed over and cascades the timers of the slot it
+// lands in down to lower levels, so each timer is moved at most once
+// per level over its lifetime.
+//
+// NOTE: This is not thread-safe, the clock synchronizes all access.
+class TimerWheel
+{
+public:
+  TimerWheel() : base(0), count(0)
+  {
+    std::fill_n(counts, LEVELS, 0);
+  }
+
+  bool empty() const
+  {
+    return count == 0;
+  }
+
+  size_t size() const
+  {
+    return count;
+  }
+
+  void insert(const Timer& timer)
+  {
+    const uint64_t ticks = TimerWheel::ticks(timer.timeout().time());
+
+    if (count == 0) {
+      earliest = timer.timeout().time();
+    } else if (earliest.isSome() && timer.timeout().time() < earliest.get()) {
+      earliest = timer.timeout().time();
+    }
+
+    Location location = locate(ticks);
+
+    std::list<Timer>& bucket = this->bucket(location);
+    location.iterator = bucket.insert(bucket.end(), timer);
+
+    index[timer.id] = location;
+
+    if (location.level >= 0) {
+      counts[location.level]++;
+    }
+    count++;
+  }
+
+  // Returns true if the timer was pending and is now removed.
+  bool remove(const Timer& timer)
+  {
+    if (!index.contains(timer.id)) {
+      return false;
+    }
+
+    const Location& location = index[timer.id];
+
+    if (location.level >= 0) {
+      counts[location.level]--;
+    }
+    count--;
+
+    bucket(location).erase(location.iterator);
+    index.erase(timer.id);
+
+    if (earliest.isSome() && earliest.get() == timer.timeout().time()) {
+      earliest = None();
+    }
+
+    return true;
+  }
+
+  // Returns the timeout of the earliest pending timer. The wheel
+  // must not be empty.
+  Time next()
+  {
+    CHECK(!empty());
+
+    if (earliest.isSome()) {
+      return earliest.get();
+    }
+
+    // Overdue timers are earlier than any timer in the wheel. In the
+    // wheel, timers at a lower level are earlier than the ones at a
+    // higher level, and within a level, a lower slot holds earlier
+    // timers.
+    if (!overdue.empty()) {
+      earliest = first(overdue);
+    } else {
+      for (int level = 0; level < LEVELS && earliest.isNone(); level++) {
+        if (counts[level] == 0) {
+          continue;
+        }
+
+        for (size_t slot = digit(base, level) + 1; slot < SLOTS; slot++) {
+          if (!wheel[level][slot].empty()) {
+            earliest = first(wheel[level][slot]);
+            break;
+          }
+        }
+      }
+    }
+
+    CHECK(earliest.isSome());
+    return earliest.get();
+  }
+
+  // Removes and returns all timers whose timeout is at or before
+  // 'time', in the order of their timeouts. Timers with the same
+  // timeout are returned in the order they were inserted.
+  std::list<Timer> expire(const Time& time)
+  {
+    const uint64_t ticks = TimerWheel::ticks(time);
+
+    std::list<Timer> expired;
+
+    // Overdue timers are at or before 'base'. If the wheel does not
+    // move forward, these are the only timers that can expire.
+    for (auto it = overdue.begin(); it != overdue.end();) {
+      auto next = std::next(it);
+      if (TimerWheel::ticks(it->timeout().time()) <= ticks) {
+        take(overdue, it, &expired);
+      }
+      it = next;
+    }
+
+    if (ticks > base) {
+      const int top = level(base, ticks);
+
+      // All timers below the level at which the wheel moves are
+      // before 'time', since they share the digits of 'base' above.
+      for (int level = 0; level < top; level++) {
+        for (size_t slot = 0; slot < SLOTS && counts[level] > 0; slot++) {
+          take(level, slot, &expired);
+        }
+      }
+
+      // The same holds for the slots passed over at the top level.
+      const size_t from = digit(base, top);
+      const size_t to = digit(ticks, top);
+
+      for (size_t slot = from + 1; slot < to; slot++) {
+        take(top, slot, &expired);
+      }
+
+      base = ticks;
+
+      // Timers in the slot the wheel moves into are expired or
+      // cascaded down to the level where they now belong.
+      std::list<Timer>& cascading = wheel[top][to];
+      for (auto it = cascading.begin(); it != cascading.end();) {
+        auto next = std::next(it);
+        counts[top]--;
+        count--;
+
+        if (TimerWheel::ticks(it->timeout().time()) <= ticks) {
+          index.erase(it->id);
+          expired.splice(expired.end(), cascading, it);
+        } else {
+          Location& location = index[it->id];
+          location = locate(TimerWheel::ticks(it->timeout().time()));
+          location.iterator = it;
+
+          std::list<Timer>& bucket = this->bucket(location);
+          bucket.splice(bucket.end(), cascading, it);
+
+          counts[location.level]++;
+          count++;
+        }
+
+        it = next;
+      }
+    }
+
+    if (!expired.empty()) {
+      earliest = None();
+
+      expired.sort([](const Timer& left, const Timer& right) {
+        if (left.timeout().time() == right.timeout().time()) {
+          return left.id < right.id;
+        }
+        return left.timeout().time() < right.timeout().time();
+      });
+    }
+
+    return expired;
+  }
+
+  void clear()
+  {
+    for (int level = 0; level < LEVELS; level++) {
+      for (size_t slot = 0; slot < SLOTS; slot++) {
+        wheel[level][slot].clear();
+      }
+      counts[level] = 0;
+    }
+
+    overdue.clear();
+    index.clear();
+    earliest = None();
+    count = 0;
+  }
+
+private:
+  static const int LEVELS = 8;
+  static const int BITS = 8;
+  static const size_t SLOTS = 1 << BITS;
+
+  // Where a timer is kept, a level of -1 means overdue.
+  struct Location
+  {
+    int level;
+    size_t slot;
+    std::list<Timer>::iterator iterator;
+  };
+
+  static uint64_t ticks(const Time& time)
+  {
+    return static_cast<uint64_t>(
+        std::max<int64_t>(0, time.duration().ns()));
+  }
+
+  static size_t digit(uint64_t ticks, int level)
+  {
+    return (ticks >> (level * BITS)) & (SLOTS - 1);
+  }
+
+  // Returns the most significant level at which 'ticks' differs from
+  // 'base'. They must not be equal.
+  static int level(uint64_t base, uint64_t ticks)
+  {
+    int level = LEVELS - 1;
+    while (digit(base, level) == digit(ticks, level)) {
+      level--;
+    }
+    return level;
+  }
+
+  static Time first(const std::list<Timer>& timers)
+  {
+    Time time = timers.front().timeout().time();
+    for (const Timer& timer : timers) {
+      time = std::min(time, timer.timeout().time());
+    }
+    return time;
+  }
+
+  Location locate(uint64_t ticks) const
+  {
+    Location location;
+
+    if (ticks <= base) {
+      location.level = -1;
+      location.slot = 0;
+    } else {
+      location.level = level(base, ticks);
+      location.slot = digit(ticks, location.level);
+    }
+
+    return location;
+  }
+
+  std::list<Timer>& bucket(const Location& location)
+  {
+    if (location.level < 0) {
+      return overdue;
+    }
+    return wheel[location.level][location.slot];
+  }
+
+  // Moves a single timer out of the wheel into 'expired'.
+  void take(
+      std::list<Timer>& bucket,
+      std::list<Timer>::iterator it,
+      std::list<Timer>* expired)
+  {
+    const Location& location = index[it->id];
+    if (location.level >= 0) {
+      counts[location.level]--;
+    }
+    count--;
+
+    index.erase(it->id);
+    expired->splice(expired->end(), bucket, it);
+  }
+
+  // Moves all timers of a slot out of the wheel into 'expired'.
+  void take(int level, size_t slot, std::list<Timer>* expired)
+  {
+    std::list<Timer>& bucket = wheel[level][slot];
+
+    for (const Timer& timer : bucket) {
+      index.erase(timer.id);
+    }
+
+    counts[level] -= bucket.size();
+    count -= bucket.size();
+
+    expired->splice(expired->end(), bucket);
+  }
+
+  // The time (in nanoseconds) the wheel was last advanced to.
+  uint64_t base;
+
+  std::list<Timer> wheel[LEVELS][SLOTS];
+  size_t counts[LEVELS];
+
+  std::list<Timer> overdue;
+
+  hashmap<uint64_t, Location> index;
+
+  size_t count;
+
+  // The cached timeout of the earliest timer, if known.
+  Option<Time> earliest;
+};
+
+} // namespace process {
+
+#endif // __TIMER_WHEEL_HPP__
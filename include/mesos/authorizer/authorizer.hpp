@@ -18,6 +18,7 @@
 #define __MESOS_AUTHORIZER_AUTHORIZER_HPP__
 
 #include <iosfwd>
+#include <list>
 #include <string>
 
 // ONLY USEFUL AFTER RUNNING PROTOC.
@@ -201,6 +202,24 @@ public:
   virtual process::Future<bool> authorize(
       const ACL::RemoveQuota& request) = 0;
 
+  /**
+   * Authorizes a number of requests at once, e.g., all the operations
+   * of an ACCEPT call, so that they only take a single round trip to
+   * the authorizer.
+   *
+   * The default implementation authorizes every request separately,
+   * an authorizer can override it to decide the whole batch at once.
+   *
+   * @param batch `ACL::Batch` packing the requests, each of which has
+   *     exactly one of its fields set.
+   *
+   * @return whether each of the requests is authorized, in the order
+   *     of the requests. A failed future indicates a problem processing
+   *     (some of) the requests; the batch can be retried.
+   */
+  virtual process::Future<std::list<bool>> authorize(
+      const ACL::Batch& batch);
+
 protected:
   Authorizer() {}
 };
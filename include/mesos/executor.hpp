@@ -19,6 +19,7 @@
 
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
@@ -181,6 +182,11 @@ public:
   // about status update acknowledgements.
   virtual Status sendStatusUpdate(const TaskStatus& status) = 0;
 
+  // Sends multiple status updates to the framework scheduler in a
+  // single message to the slave. Each update is handled as if it was
+  // sent via ExecutorDriver::sendStatusUpdate.
+  virtual Status sendStatusUpdates(const std::vector<TaskStatus>& statuses) = 0;
+
   // Sends a message to the framework scheduler. These messages are
   // best effort; do not expect a framework message to be
   // retransmitted in any reliable fashion.
@@ -228,6 +234,7 @@ public:
   virtual Status join();
   virtual Status run();
   virtual Status sendStatusUpdate(const TaskStatus& status);
+  virtual Status sendStatusUpdates(const std::vector<TaskStatus>& statuses);
   virtual Status sendFrameworkMessage(const std::string& data);
 
 private:
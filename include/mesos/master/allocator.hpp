@@ -32,6 +32,7 @@
 #include <process/future.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
@@ -326,6 +327,31 @@ public:
       const Resources& resources,
       const Option<Filters>& filters) = 0;
 
+  /**
+   * Recovers resources of many frameworks on many agents at once.
+   *
+   * Equivalent to invoking `recoverResources()` without filters for
+   * every agent and framework, which is what the default
+   * implementation does. Used by the master to recover the resources
+   * of many finished tasks with a single call, an implementation may
+   * override it to process them in a single step.
+   *
+   * @param resources The resources to recover per agent and framework.
+   */
+  virtual void batchRecoverResources(
+      const hashmap<SlaveID, hashmap<FrameworkID, Resources>>& resources)
+  {
+    foreachpair (const SlaveID& slaveId,
+                 const auto& frameworks,
+                 resources) {
+      foreachpair (const FrameworkID& frameworkId,
+                   const Resources& recovered,
+                   frameworks) {
+        recoverResources(frameworkId, slaveId, recovered, None());
+      }
+    }
+  }
+
   /**
    * Suppresses offers.
    *
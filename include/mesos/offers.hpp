@@ -0,0 +1,114 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef __OFFERS_HPP__
+#define __OFFERS_HPP__
+
+#include <set>
+#include <string>
+#include <utility>
+
+#include <mesos/attributes.hpp>
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+
+// Indexes the outstanding offers of a framework so that a scheduler
+// can find the offer which best fits a task without checking every
+// offer. The offers are ordered by their available CPUs and indexed
+// by their attributes: a match only checks the offers with at least
+// the requested CPUs (and with the requested attributes), in the
+// order of the placement policy, and stops at the first offer which
+// contains the requested resources.
+//
+// The index keeps the remaining resources of each offer, so several
+// tasks can be packed into one offer (see 'consume') before it is
+// accepted. The index is not thread safe.
+class OfferIndex
+{
+public:
+  enum Policy
+  {
+    // Place tasks on the offers with the fewest CPUs which fit them,
+    // which packs tasks onto as few agents as possible.
+    BIN_PACKING,
+
+    // Place tasks on the offers with the most CPUs, which spreads
+    // tasks across agents.
+    SPREAD
+  };
+
+  explicit OfferIndex(Policy _policy = BIN_PACKING) : policy(_policy) {}
+
+  // Adds an offer, replacing any offer with the same ID.
+  void add(const Offer& offer);
+
+  // Removes an offer (e.g., once it is rescinded, declined or
+  // accepted). Unknown offers are ignored.
+  void remove(const OfferID& offerId);
+
+  // Returns the offer which best fits the given resources, according
+  // to the policy, among the offers which have all the given
+  // attributes. The resources of the returned offer are the ones
+  // which remain in it. Returns none if no offer fits.
+  Option<Offer> match(
+      const Resources& resources,
+      const Attributes& attributes = Attributes()) const;
+
+  // Subtracts the given resources, e.g., of a task placed on the
+  // offer, from the remaining resources of the offer.
+  Try<Nothing> consume(const OfferID& offerId, const Resources& resources);
+
+  size_t size() const { return offers.size(); }
+
+  bool empty() const { return offers.empty(); }
+
+private:
+  // Returns the CPUs by which an offer is ordered.
+  static double cpus(const Offer& offer);
+
+  // Returns whether the offer has the resources and attributes.
+  static bool fits(
+      const Offer& offer,
+      const Resources& resources,
+      const Attributes& attributes);
+
+  void index(const Offer& offer);
+  void unindex(const Offer& offer);
+
+  const Policy policy;
+
+  // The offers, with their remaining resources, keyed by offer ID.
+  hashmap<std::string, Offer> offers;
+
+  // The offer IDs ordered by the available CPUs of the offers.
+  std::set<std::pair<double, std::string>> ordered;
+
+  // The offer IDs keyed by each of their attributes ("name=value").
+  hashmap<std::string, hashset<std::string>> attributed;
+};
+
+} // namespace mesos {
+
+#endif // __OFFERS_HPP__
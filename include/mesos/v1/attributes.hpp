@@ -19,9 +19,11 @@
 
 #include <iterator>
 #include <string>
+#include <vector>
 
 #include <mesos/v1/mesos.hpp>
 
+#include <stout/hashmap.hpp>
 #include <stout/option.hpp>
 
 namespace mesos {
@@ -52,6 +54,7 @@ public:
     if (this != &that) {
       attributes.Clear();
       attributes.MergeFrom(that.attributes);
+      index = None();
     }
 
     return *this;
@@ -80,6 +83,10 @@ public:
   void add(const Attribute& attribute)
   {
     attributes.Add()->MergeFrom(attribute);
+
+    if (index.isSome()) {
+      index.get()[attribute.name()].push_back(attributes.size() - 1);
+    }
   }
 
   const Attribute get(int index) const
@@ -98,8 +105,10 @@ public:
   typedef google::protobuf::RepeatedPtrField<Attribute>::const_iterator
   const_iterator;
 
-  iterator begin() { return attributes.begin(); }
-  iterator end() { return attributes.end(); }
+  // NOTE: The attributes may be modified through these iterators,
+  // hence the index is rebuilt by the next lookup.
+  iterator begin() { index = None(); return attributes.begin(); }
+  iterator end() { index = None(); return attributes.end(); }
 
   const_iterator begin() const { return attributes.begin(); }
   const_iterator end() const { return attributes.end(); }
@@ -110,7 +119,20 @@ public:
   static bool isValid(const Attribute& attribute);
 
 private:
+  // Returns the attribute with the given name and type, if any.
+  const Attribute* find(const std::string& name, Value::Type type) const;
+
   google::protobuf::RepeatedPtrField<Attribute> attributes;
+
+  // Maps the names of the attributes to their positions, so that the
+  // lookups (e.g., by frameworks filtering offers on the attributes of
+  // the agents) do not scan all the attributes. Built by the first
+  // lookup, hence the view of the attributes of an offer is indexed
+  // once no matter how many constraints are checked against it.
+  //
+  // NOTE: Since the first lookup builds the index, concurrent lookups
+  // on the same (constant) object must be synchronized by the caller.
+  mutable Option<hashmap<std::string, std::vector<int>>> index;
 };
 
 } // namespace v1 {
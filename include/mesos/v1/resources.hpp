@@ -361,6 +361,15 @@ private:
   // ensure this is warranted.
   bool _contains(const Resource& that) const;
 
+  // Similar to 'operator+=(const Resource&)' and
+  // 'operator-=(const Resource&)' but skip the validity and emptiness
+  // checks of 'that', which can be assumed when it is taken from
+  // (another) Resources. This avoids validating every Resource object
+  // again on the hot paths of the Resources arithmetic (e.g.,
+  // 'operator+=(const Resources&)' or 'contains(const Resources&)').
+  void _add(const Resource& that);
+  void _subtract(const Resource& that);
+
   // Similar to the public 'find', but only for a single Resource
   // object. The target resource may span multiple roles, so this
   // returns Resources.
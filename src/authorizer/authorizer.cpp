@@ -14,18 +14,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <list>
 #include <ostream>
 
 #include <mesos/authorizer/authorizer.hpp>
 
 #include <mesos/module/authorizer.hpp>
 
+#include <process/collect.hpp>
+
+#include <stout/foreach.hpp>
+
 #include "authorizer/local/authorizer.hpp"
 
 #include "master/constants.hpp"
 
 #include "module/manager.hpp"
 
+using process::Failure;
+using process::Future;
+
+using std::list;
 using std::ostream;
 using std::string;
 
@@ -47,6 +56,38 @@ Try<Authorizer*> Authorizer::create(const string& name)
 }
 
 
+Future<list<bool>> Authorizer::authorize(const ACL::Batch& batch)
+{
+  list<Future<bool>> futures;
+
+  foreach (const ACL::Batch::Request& request, batch.requests()) {
+    if (request.has_register_framework()) {
+      futures.push_back(authorize(request.register_framework()));
+    } else if (request.has_run_task()) {
+      futures.push_back(authorize(request.run_task()));
+    } else if (request.has_shutdown_framework()) {
+      futures.push_back(authorize(request.shutdown_framework()));
+    } else if (request.has_reserve_resources()) {
+      futures.push_back(authorize(request.reserve_resources()));
+    } else if (request.has_unreserve_resources()) {
+      futures.push_back(authorize(request.unreserve_resources()));
+    } else if (request.has_create_volume()) {
+      futures.push_back(authorize(request.create_volume()));
+    } else if (request.has_destroy_volume()) {
+      futures.push_back(authorize(request.destroy_volume()));
+    } else if (request.has_set_quota()) {
+      futures.push_back(authorize(request.set_quota()));
+    } else if (request.has_remove_quota()) {
+      futures.push_back(authorize(request.remove_quota()));
+    } else {
+      return Failure("Unknown authorization request in batch");
+    }
+  }
+
+  return process::collect(futures);
+}
+
+
 ostream& operator<<(ostream& stream, const ACLs& acls)
 {
   return stream << acls.DebugString();
@@ -16,7 +16,9 @@
 
 #include "authorizer/local/authorizer.hpp"
 
+#include <list>
 #include <string>
+#include <vector>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -24,13 +26,18 @@
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/option.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/sharded_cache.hpp>
 #include <stout/try.hpp>
 
 using process::Failure;
 using process::Future;
 using process::dispatch;
 
+using std::list;
 using std::string;
 
 namespace mesos {
@@ -39,161 +46,245 @@ namespace internal {
 class LocalAuthorizerProcess : public ProtobufProcess<LocalAuthorizerProcess>
 {
 public:
-  LocalAuthorizerProcess(const ACLs& _acls)
-    : ProcessBase(process::ID::generate("authorizer")), acls(_acls) {}
-
-  Future<bool> authorize(const ACL::RegisterFramework& request)
+  LocalAuthorizerProcess(const ACLs& acls)
+    : ProcessBase(process::ID::generate("authorizer")),
+      permissive(acls.permissive())
   {
+    // The ACLs never change once the authorizer has been initialized,
+    // so they are compiled (and the decisions cached) once and for all.
     foreach (const ACL::RegisterFramework& acl, acls.register_frameworks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.roles(), acl.roles())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.roles(), acl.roles());
-      }
+      registerFrameworks.rules.push_back(Rule(acl.principals(), acl.roles()));
     }
 
-    return acls.permissive(); // None of the ACLs match.
-  }
-
-  Future<bool> authorize(const ACL::RunTask& request)
-  {
     foreach (const ACL::RunTask& acl, acls.run_tasks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.users(), acl.users())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.users(), acl.users());
-      }
+      runTasks.rules.push_back(Rule(acl.principals(), acl.users()));
     }
 
-    return acls.permissive(); // None of the ACLs match.
-  }
-
-  Future<bool> authorize(const ACL::ShutdownFramework& request)
-  {
     // TODO(gyliu513): Remove this shutdown_frameworks acl logic at the
     // end of the deprecation cycle on 0.27.
     foreach (const ACL::ShutdownFramework& acl, acls.shutdown_frameworks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.framework_principals(),
-                  acl.framework_principals())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.framework_principals(),
-                      acl.framework_principals());
-      }
+      shutdownFrameworks.rules.push_back(
+          Rule(acl.principals(), acl.framework_principals()));
     }
 
     foreach (const ACL::TeardownFramework& acl, acls.teardown_frameworks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.framework_principals(),
-                  acl.framework_principals())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.framework_principals(),
-                      acl.framework_principals());
-      }
+      shutdownFrameworks.rules.push_back(
+          Rule(acl.principals(), acl.framework_principals()));
+    }
+
+    foreach (const ACL::ReserveResources& acl, acls.reserve_resources()) {
+      reserveResources.rules.push_back(
+          Rule(acl.principals(), acl.resources()));
+    }
+
+    foreach (const ACL::UnreserveResources& acl, acls.unreserve_resources()) {
+      unreserveResources.rules.push_back(
+          Rule(acl.principals(), acl.reserver_principals()));
+    }
+
+    foreach (const ACL::CreateVolume& acl, acls.create_volumes()) {
+      createVolumes.rules.push_back(
+          Rule(acl.principals(), acl.volume_types()));
+    }
+
+    foreach (const ACL::DestroyVolume& acl, acls.destroy_volumes()) {
+      destroyVolumes.rules.push_back(
+          Rule(acl.principals(), acl.creator_principals()));
     }
 
-    return acls.permissive(); // None of the ACLs match.
+    foreach (const ACL::SetQuota& acl, acls.set_quotas()) {
+      setQuotas.rules.push_back(Rule(acl.principals(), acl.roles()));
+    }
+
+    foreach (const ACL::RemoveQuota& acl, acls.remove_quotas()) {
+      removeQuotas.rules.push_back(
+          Rule(acl.principals(), acl.quota_principals()));
+    }
   }
 
-  Future<bool> authorize(const ACL::ReserveResources& request)
+  Future<bool> authorize(const ACL::RegisterFramework& request)
   {
-    foreach (const ACL::ReserveResources& acl, acls.reserve_resources()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.resources(), acl.resources())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.resources(), acl.resources());
-      }
-    }
+    return decide(
+        &registerFrameworks, request, request.principals(), request.roles());
+  }
 
-    return acls.permissive(); // None of the ACLs match.
+  Future<bool> authorize(const ACL::RunTask& request)
+  {
+    return decide(&runTasks, request, request.principals(), request.users());
   }
 
-  Future<bool> authorize(const ACL::UnreserveResources& request)
+  Future<bool> authorize(const ACL::ShutdownFramework& request)
   {
-    foreach (const ACL::UnreserveResources& acl, acls.unreserve_resources()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.reserver_principals(), acl.reserver_principals())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.reserver_principals(), acl.reserver_principals());
-      }
-    }
+    return decide(
+        &shutdownFrameworks,
+        request,
+        request.principals(),
+        request.framework_principals());
+  }
 
-    return acls.permissive(); // None of the ACLs match.
+  Future<bool> authorize(const ACL::ReserveResources& request)
+  {
+    return decide(
+        &reserveResources, request, request.principals(), request.resources());
   }
 
-  Future<bool> authorize(const ACL::CreateVolume& request)
+  Future<bool> authorize(const ACL::UnreserveResources& request)
   {
-    foreach (const ACL::CreateVolume& acl, acls.create_volumes()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.volume_types(), acl.volume_types())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.volume_types(), acl.volume_types());
-      }
-    }
+    return decide(
+        &unreserveResources,
+        request,
+        request.principals(),
+        request.reserver_principals());
+  }
 
-    return acls.permissive(); // None of the ACLs match.
+  Future<bool> authorize(const ACL::CreateVolume& request)
+  {
+    return decide(
+        &createVolumes, request, request.principals(), request.volume_types());
   }
 
   Future<bool> authorize(const ACL::DestroyVolume& request)
   {
-    foreach (const ACL::DestroyVolume& acl, acls.destroy_volumes()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.creator_principals(), acl.creator_principals())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.creator_principals(), acl.creator_principals());
+    return decide(
+        &destroyVolumes,
+        request,
+        request.principals(),
+        request.creator_principals());
+  }
+
+  Future<bool> authorize(const ACL::SetQuota& request)
+  {
+    return decide(&setQuotas, request, request.principals(), request.roles());
+  }
+
+  Future<bool> authorize(const ACL::RemoveQuota& request)
+  {
+    return decide(
+        &removeQuotas,
+        request,
+        request.principals(),
+        request.quota_principals());
+  }
+
+  Future<list<bool>> authorize(const ACL::Batch& batch)
+  {
+    list<bool> results;
+
+    foreach (const ACL::Batch::Request& request, batch.requests()) {
+      if (request.has_register_framework()) {
+        results.push_back(authorize(request.register_framework()).get());
+      } else if (request.has_run_task()) {
+        results.push_back(authorize(request.run_task()).get());
+      } else if (request.has_shutdown_framework()) {
+        results.push_back(authorize(request.shutdown_framework()).get());
+      } else if (request.has_reserve_resources()) {
+        results.push_back(authorize(request.reserve_resources()).get());
+      } else if (request.has_unreserve_resources()) {
+        results.push_back(authorize(request.unreserve_resources()).get());
+      } else if (request.has_create_volume()) {
+        results.push_back(authorize(request.create_volume()).get());
+      } else if (request.has_destroy_volume()) {
+        results.push_back(authorize(request.destroy_volume()).get());
+      } else if (request.has_set_quota()) {
+        results.push_back(authorize(request.set_quota()).get());
+      } else if (request.has_remove_quota()) {
+        results.push_back(authorize(request.remove_quota()).get());
+      } else {
+        return Failure("Unknown authorization request in batch");
       }
     }
 
-    return acls.permissive(); // None of the ACLs match.
+    return results;
   }
 
-  Future<bool> authorize(const ACL::SetQuota& request)
+private:
+  // The maximum number of decisions cached per action. The principals
+  // and objects are not bounded (e.g., any user can be asked for), so
+  // the least recently used decisions are evicted once it is full.
+  static const size_t MAX_DECISIONS = 16 * 1024;
+
+  // An `ACL::Entity` whose values are indexed.
+  struct Entity
   {
-    foreach (const ACL::SetQuota& acl, acls.set_quotas()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.roles(), acl.roles())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.roles(), acl.roles());
+    explicit Entity(const ACL::Entity& entity) : type(entity.type())
+    {
+      foreach (const string& value, entity.values()) {
+        values.insert(value);
       }
     }
 
-    return acls.permissive(); // None of the ACLs match.
-  }
+    // Returns whether all the values of the request are in this
+    // (SOME) entity.
+    bool contains(const ACL::Entity& request) const
+    {
+      foreach (const string& value, request.values()) {
+        if (!values.contains(value)) {
+          return false;
+        }
+      }
+      return true;
+    }
 
-  Future<bool> authorize(const ACL::RemoveQuota& request)
+    ACL::Entity::Type type;
+    hashset<string> values;
+  };
+
+  // Every ACL has a subject (the principals) and an object (e.g.,
+  // the users for `ACL::RunTask`).
+  struct Rule
   {
-    foreach (const ACL::RemoveQuota& acl, acls.remove_quotas()) {
+    Rule(const ACL::Entity& _subject, const ACL::Entity& _object)
+      : subject(_subject), object(_object) {}
+
+    Entity subject;
+    Entity object;
+  };
+
+  // The compiled ACLs of an action, in their order, and the decisions
+  // made so far keyed by the (serialized) request, i.e., by both its
+  // principals and its object.
+  //
+  // NOTE: The decisions are only used by this process, hence a single
+  // shard, which keeps the eviction strictly least recently used.
+  struct Action
+  {
+    Action() : decisions(MAX_DECISIONS, 1) {}
+
+    std::vector<Rule> rules;
+    ShardedCache<string, bool> decisions;
+  };
+
+  template <typename Request>
+  bool decide(
+      Action* action,
+      const Request& request,
+      const ACL::Entity& subject,
+      const ACL::Entity& object)
+  {
+    const string key = request.SerializeAsString();
+
+    Option<bool> decision = action->decisions.get(key);
+    if (decision.isSome()) {
+      return decision.get();
+    }
+
+    decision = permissive; // None of the ACLs match.
+
+    foreach (const Rule& rule, action->rules) {
       // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.quota_principals(), acl.quota_principals())) {
+      if (matches(subject, rule.subject) && matches(object, rule.object)) {
         // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.quota_principals(), acl.quota_principals());
+        decision = allows(subject, rule.subject) &&
+                   allows(object, rule.object);
+        break;
       }
     }
 
-    return acls.permissive(); // None of the ACLs match.
+    action->decisions.put(key, decision.get());
+
+    return decision.get();
   }
 
-private:
   // Match matrix:
   //
   //                  -----------ACL----------
@@ -206,40 +297,27 @@ private:
   //  |       -------|-------|-------|-------
   //  |        ANY   |  No   |  Yes  |   Yes
   //          -------|-------|-------|-------
-  bool matches(const ACL::Entity& request, const ACL::Entity& acl)
+  static bool matches(const ACL::Entity& request, const Entity& acl)
   {
     // NONE only matches with NONE.
     if (request.type() == ACL::Entity::NONE) {
-      return acl.type() == ACL::Entity::NONE;
+      return acl.type == ACL::Entity::NONE;
     }
 
     // ANY matches with ANY or NONE.
     if (request.type() == ACL::Entity::ANY) {
-      return acl.type() == ACL::Entity::ANY || acl.type() == ACL::Entity::NONE;
+      return acl.type == ACL::Entity::ANY || acl.type == ACL::Entity::NONE;
     }
 
     if (request.type() == ACL::Entity::SOME) {
       // SOME matches with ANY or NONE.
-      if (acl.type() == ACL::Entity::ANY || acl.type() == ACL::Entity::NONE) {
+      if (acl.type == ACL::Entity::ANY || acl.type == ACL::Entity::NONE) {
         return true;
       }
 
       // SOME is allowed if the request values are a subset of ACL
       // values.
-      foreach (const string& value, request.values()) {
-        bool found = false;
-        foreach (const string& value_, acl.values()) {
-          if (value == value_) {
-            found = true;
-            break;
-          }
-        }
-
-        if (!found) {
-          return false;
-        }
-      }
-      return true;
+      return acl.contains(request);
     }
 
     return false;
@@ -257,51 +335,48 @@ private:
   //  |       -------|-------|-------|-------
   //  |        ANY   |  No   |  No   |   Yes
   //          -------|-------|-------|-------
-  bool allows(const ACL::Entity& request, const ACL::Entity& acl)
+  static bool allows(const ACL::Entity& request, const Entity& acl)
   {
     // NONE is only allowed by NONE.
     if (request.type() == ACL::Entity::NONE) {
-      return acl.type() == ACL::Entity::NONE;
+      return acl.type == ACL::Entity::NONE;
     }
 
     // ANY is only allowed by ANY.
     if (request.type() == ACL::Entity::ANY) {
-      return acl.type() == ACL::Entity::ANY;
+      return acl.type == ACL::Entity::ANY;
     }
 
     if (request.type() == ACL::Entity::SOME) {
       // SOME is allowed by ANY.
-      if (acl.type() == ACL::Entity::ANY) {
+      if (acl.type == ACL::Entity::ANY) {
         return true;
       }
 
       // SOME is not allowed by NONE.
-      if (acl.type() == ACL::Entity::NONE) {
+      if (acl.type == ACL::Entity::NONE) {
         return false;
       }
 
       // SOME is allowed if the request values are a subset of ACL
       // values.
-      foreach (const string& value, request.values()) {
-        bool found = false;
-        foreach (const string& value_, acl.values()) {
-          if (value == value_) {
-            found = true;
-            break;
-          }
-        }
-
-        if (!found) {
-          return false;
-        }
-      }
-      return true;
+      return acl.contains(request);
     }
 
     return false;
   }
 
-  ACLs acls;
+  const bool permissive;
+
+  Action registerFrameworks;
+  Action runTasks;
+  Action shutdownFrameworks;
+  Action reserveResources;
+  Action unreserveResources;
+  Action createVolumes;
+  Action destroyVolumes;
+  Action setQuotas;
+  Action removeQuotas;
 };
 
 
@@ -481,5 +556,18 @@ Future<bool> LocalAuthorizer::authorize(const ACL::RemoveQuota& request)
       process, static_cast<F>(&LocalAuthorizerProcess::authorize), request);
 }
 
+Future<list<bool>> LocalAuthorizer::authorize(const ACL::Batch& batch)
+{
+  if (process == NULL) {
+    return Failure("Authorizer not initialized");
+  }
+
+  // Necessary to disambiguate.
+  typedef Future<list<bool>>(LocalAuthorizerProcess::*F)(const ACL::Batch&);
+
+  return dispatch(
+      process, static_cast<F>(&LocalAuthorizerProcess::authorize), batch);
+}
+
 } // namespace internal {
 } // namespace mesos {
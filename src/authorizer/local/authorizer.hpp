@@ -17,6 +17,8 @@
 #ifndef __AUTHORIZER_AUTHORIZER_HPP__
 #define __AUTHORIZER_AUTHORIZER_HPP__
 
+#include <list>
+
 #include <mesos/authorizer/authorizer.hpp>
 
 #include <process/future.hpp>
@@ -69,6 +71,8 @@ public:
       const ACL::SetQuota& request);
   virtual process::Future<bool> authorize(
       const ACL::RemoveQuota& request);
+  virtual process::Future<std::list<bool>> authorize(
+      const ACL::Batch& batch);
 
 private:
   LocalAuthorizer();
@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include <glog/logging.h>
@@ -56,11 +57,13 @@ bool Attributes::operator==(const Attributes& that) const
   }
 
   foreach (const Attribute& attribute, attributes) {
-    Option<Attribute> maybeAttribute = that.get(attribute);
-    if (maybeAttribute.isNone()) {
+    const Attribute* maybeAttribute =
+      that.find(attribute.name(), attribute.type());
+
+    if (maybeAttribute == NULL) {
         return false;
     }
-    const Attribute& thatAttribute = maybeAttribute.get();
+    const Attribute& thatAttribute = *maybeAttribute;
     switch (attribute.type()) {
     case Value::SCALAR:
       if (!(attribute.scalar() == thatAttribute.scalar())) {
@@ -86,16 +89,42 @@ bool Attributes::operator==(const Attributes& that) const
 }
 
 
-const Option<Attribute> Attributes::get(const Attribute& thatAttribute) const
+const Attribute* Attributes::find(const string& name, Value::Type type) const
 {
-  foreach (const Attribute& attribute, attributes) {
-    if (attribute.name() == thatAttribute.name() &&
-        attribute.type() == thatAttribute.type()) {
-      return attribute;
+  if (index.isNone()) {
+    index = hashmap<string, vector<int>>();
+    index->reserve(attributes.size());
+
+    for (int i = 0; i < attributes.size(); i++) {
+      index.get()[attributes.Get(i).name()].push_back(i);
+    }
+  }
+
+  const auto positions = index->find(name);
+  if (positions == index->end()) {
+    return NULL;
+  }
+
+  foreach (int i, positions->second) {
+    if (attributes.Get(i).type() == type) {
+      return &attributes.Get(i);
     }
   }
 
-  return None();
+  return NULL;
+}
+
+
+const Option<Attribute> Attributes::get(const Attribute& thatAttribute) const
+{
+  const Attribute* attribute =
+    find(thatAttribute.name(), thatAttribute.type());
+
+  if (attribute == NULL) {
+    return None();
+  }
+
+  return *attribute;
 }
 
 
@@ -109,7 +138,7 @@ Attribute Attributes::parse(const string& name, const string& text)
                << " text " << text
                << " error " << result.error();
   } else {
-    Value value = result.get();
+    const Value& value = result.get();
     attribute.set_name(name);
 
     if (value.type() == Value::RANGES) {
@@ -181,14 +210,12 @@ Value::Scalar Attributes::get(
     const string& name,
     const Value::Scalar& scalar) const
 {
-  foreach (const Attribute& attribute, attributes) {
-    if (attribute.name() == name &&
-        attribute.type() == Value::SCALAR) {
-      return attribute.scalar();
-    }
+  const Attribute* attribute = find(name, Value::SCALAR);
+  if (attribute == NULL) {
+    return scalar;
   }
 
-  return scalar;
+  return attribute->scalar();
 }
 
 
@@ -197,14 +224,12 @@ Value::Ranges Attributes::get(
     const string& name,
     const Value::Ranges& ranges) const
 {
-  foreach (const Attribute& attribute, attributes) {
-    if (attribute.name() == name &&
-        attribute.type() == Value::RANGES) {
-      return attribute.ranges();
-    }
+  const Attribute* attribute = find(name, Value::RANGES);
+  if (attribute == NULL) {
+    return ranges;
   }
 
-  return ranges;
+  return attribute->ranges();
 }
 
 
@@ -213,14 +238,12 @@ Value::Text Attributes::get(
     const string& name,
     const Value::Text& text) const
 {
-  foreach (const Attribute& attribute, attributes) {
-    if (attribute.name() == name &&
-        attribute.type() == Value::TEXT) {
-      return attribute.text();
-    }
+  const Attribute* attribute = find(name, Value::TEXT);
+  if (attribute == NULL) {
+    return text;
   }
 
-  return text;
+  return attribute->text();
 }
 
 } // namespace mesos {
@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <functional>
 #include <map>
 #include <ostream>
 #include <set>
@@ -25,15 +26,25 @@
 #include <mesos/http.hpp>
 #include <mesos/resources.hpp>
 
+#include <process/dispatch.hpp>
+
 #include <stout/foreach.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/unreachable.hpp>
 
 #include "common/http.hpp"
 
 #include "messages/messages.hpp"
 
+using process::UPID;
+
+using process::http::NotModified;
+using process::http::OK;
+using process::http::Pipe;
+using process::http::Response;
+
 using std::map;
 using std::ostream;
 using std::set;
@@ -76,6 +87,118 @@ string serialize(
 }
 
 
+// A stream buffer which writes what is put into it to a pipe, in
+// chunks of (up to) the size of its buffer. The writes fail once the
+// read-end of the pipe is closed, e.g., when the client went away.
+class PipeBuffer : public std::streambuf
+{
+public:
+  explicit PipeBuffer(const Pipe::Writer& _writer) : writer(_writer)
+  {
+    setp(buffer, buffer + sizeof(buffer));
+  }
+
+protected:
+  virtual int_type overflow(int_type c)
+  {
+    if (sync() != 0) {
+      return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+  }
+
+  virtual int sync()
+  {
+    const string chunk(pbase(), pptr() - pbase());
+    setp(buffer, buffer + sizeof(buffer));
+
+    return chunk.empty() || writer.write(chunk) ? 0 : -1;
+  }
+
+private:
+  Pipe::Writer writer;
+  char buffer[64 * 1024];
+};
+
+
+Response stream(
+    const UPID& pid,
+    const lambda::function<void(ostream*)>& write,
+    const Option<string>& jsonp)
+{
+  Pipe pipe;
+  OK ok;
+  ok.headers["Content-Type"] =
+    jsonp.isSome() ? "text/javascript" : "application/json";
+
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+
+  Pipe::Writer writer = pipe.writer();
+
+  // The body is written in a separate event so that the response
+  // (and its headers) can be sent before the body is complete.
+  process::dispatch(pid, [writer, write, jsonp]() mutable {
+    PipeBuffer buffer(writer);
+    ostream stream(&buffer);
+
+    if (jsonp.isSome()) {
+      stream << jsonp.get() << "(";
+    }
+
+    write(&stream);
+
+    if (jsonp.isSome()) {
+      stream << ");";
+    }
+
+    stream.flush();
+    writer.close();
+  });
+
+  return ok;
+}
+
+
+Response tagged(
+    const process::http::Request& request,
+    const string& json,
+    const Option<string>& jsonp)
+{
+  const string body = jsonp.isSome() ? jsonp.get() + "(" + json + ");" : json;
+  const string tag = "\"" + stringify(std::hash<string>()(body)) + "\"";
+
+  Option<string> match = request.headers.get("If-None-Match");
+  if (match.isSome()) {
+    foreach (string token, strings::tokenize(match.get(), ",")) {
+      token = strings::trim(token);
+      if (strings::startsWith(token, "W/")) {
+        token = token.substr(2);
+      }
+
+      if (token == tag || token == "*") {
+        NotModified response;
+        response.headers["ETag"] = tag;
+        return response;
+      }
+    }
+  }
+
+  OK response(body);
+  response.headers["Content-Type"] =
+    jsonp.isSome() ? "text/javascript" : "application/json";
+  response.headers["ETag"] = tag;
+
+  return response;
+}
+
+
 // TODO(bmahler): Kill these in favor of automatic Proto->JSON
 // Conversion (when it becomes available).
 
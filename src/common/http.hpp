@@ -17,14 +17,22 @@
 #ifndef __COMMON_HTTP_HPP__
 #define __COMMON_HTTP_HPP__
 
+#include <ostream>
+#include <string>
 #include <vector>
 
 #include <mesos/http.hpp>
 #include <mesos/mesos.hpp>
 
+#include <process/http.hpp>
+#include <process/pid.hpp>
+
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/jsonify.hpp>
+#include <stout/lambda.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 
 namespace mesos {
@@ -73,6 +81,30 @@ Try<Message> deserialize(
 }
 
 
+// Returns an OK response whose body is the JSON written by 'write'
+// (e.g., with 'jsonify'), wrapped into a call to the 'jsonp' function
+// if one is given. Rather than being buffered, the body is written
+// into a pipe by the process 'pid' right after the response has been
+// returned, and is sent with chunked encoding (and compressed a chunk
+// at a time, if the client accepts gzip) while it is being written.
+// 'write' must therefore not refer to state that may be gone by then.
+process::http::Response stream(
+    const process::UPID& pid,
+    const lambda::function<void(std::ostream*)>& write,
+    const Option<std::string>& jsonp = None());
+
+
+// Returns an OK response whose body is the JSON (wrapped into a call
+// to the 'jsonp' function if one is given) along with its entity tag,
+// or a 'Not Modified' response if the request carries that tag in its
+// 'If-None-Match' header. This lets pollers skip downloading a body
+// that has not changed since their previous request.
+process::http::Response tagged(
+    const process::http::Request& request,
+    const std::string& json,
+    const Option<std::string>& jsonp = None());
+
+
 JSON::Object model(const Resources& resources);
 JSON::Object model(const hashmap<std::string, Resources>& roleResources);
 JSON::Object model(const Attributes& attributes);
@@ -95,6 +127,8 @@ void json(JSON::ObjectWriter* writer, const Task& task);
 } // namespace internal {
 
 void json(JSON::ObjectWriter* writer, const Attributes& attributes);
+void json(JSON::ObjectWriter* writer, const CommandInfo& command);
+void json(JSON::ObjectWriter* writer, const ExecutorInfo& executorInfo);
 void json(JSON::ArrayWriter* writer, const Labels& labels);
 void json(JSON::ObjectWriter* writer, const Resources& resources);
 void json(JSON::ObjectWriter* writer, const TaskStatus& status);
@@ -0,0 +1,209 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <set>
+#include <string>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include <mesos/attributes.hpp>
+#include <mesos/offers.hpp>
+#include <mesos/resources.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/stringify.hpp>
+
+using std::make_pair;
+using std::pair;
+using std::string;
+
+namespace mesos {
+
+void OfferIndex::add(const Offer& offer)
+{
+  remove(offer.id());
+
+  offers[offer.id().value()] = offer;
+  index(offer);
+}
+
+
+void OfferIndex::remove(const OfferID& offerId)
+{
+  if (!offers.contains(offerId.value())) {
+    return;
+  }
+
+  unindex(offers.at(offerId.value()));
+  offers.erase(offerId.value());
+}
+
+
+Option<Offer> OfferIndex::match(
+    const Resources& resources,
+    const Attributes& attributes) const
+{
+  const double requested = resources.cpus().getOrElse(0.0);
+
+  if (attributes.size() == 0) {
+    // The offers with fewer CPUs than requested cannot fit, so start
+    // from the first offer with enough CPUs for bin packing, or stop
+    // at it for spreading.
+    if (policy == BIN_PACKING) {
+      auto it = ordered.lower_bound(make_pair(requested, string()));
+      for (; it != ordered.end(); ++it) {
+        const Offer& offer = offers.at(it->second);
+        if (fits(offer, resources, attributes)) {
+          return offer;
+        }
+      }
+    } else {
+      auto it = ordered.rbegin();
+      for (; it != ordered.rend() && it->first >= requested; ++it) {
+        const Offer& offer = offers.at(it->second);
+        if (fits(offer, resources, attributes)) {
+          return offer;
+        }
+      }
+    }
+
+    return None();
+  }
+
+  // Only the offers with the least common of the requested
+  // attributes are candidates.
+  const hashset<string>* candidates = NULL;
+
+  foreach (const Attribute& attribute, attributes) {
+    const string key = stringify(attribute);
+    if (!attributed.contains(key)) {
+      return None();
+    }
+
+    const hashset<string>& ids = attributed.at(key);
+    if (candidates == NULL || ids.size() < candidates->size()) {
+      candidates = &ids;
+    }
+  }
+
+  CHECK_NOTNULL(candidates);
+
+  // Find the best fitting candidate, in the same order as above.
+  Option<pair<double, string>> best;
+
+  foreach (const string& id, *candidates) {
+    const Offer& offer = offers.at(id);
+    const pair<double, string> key = make_pair(cpus(offer), id);
+
+    if (key.first < requested) {
+      continue;
+    }
+
+    if (best.isSome() &&
+        (policy == BIN_PACKING ? best.get() < key : key < best.get())) {
+      continue;
+    }
+
+    if (fits(offer, resources, attributes)) {
+      best = key;
+    }
+  }
+
+  if (best.isNone()) {
+    return None();
+  }
+
+  return offers.at(best.get().second);
+}
+
+
+Try<Nothing> OfferIndex::consume(
+    const OfferID& offerId,
+    const Resources& resources)
+{
+  if (!offers.contains(offerId.value())) {
+    return Error("Unknown offer " + stringify(offerId));
+  }
+
+  Offer& offer = offers.at(offerId.value());
+
+  const Resources remaining = offer.resources();
+  if (!remaining.contains(resources)) {
+    return Error(
+        "Offer " + stringify(offerId) + " with " + stringify(remaining) +
+        " does not contain " + stringify(resources));
+  }
+
+  unindex(offer);
+  offer.mutable_resources()->CopyFrom(remaining - resources);
+  index(offer);
+
+  return Nothing();
+}
+
+
+double OfferIndex::cpus(const Offer& offer)
+{
+  return Resources(offer.resources()).cpus().getOrElse(0.0);
+}
+
+
+bool OfferIndex::fits(
+    const Offer& offer,
+    const Resources& resources,
+    const Attributes& attributes)
+{
+  const Attributes offered = offer.attributes();
+
+  foreach (const Attribute& attribute, attributes) {
+    Option<Attribute> match = offered.get(attribute);
+    if (match.isNone() || stringify(match.get()) != stringify(attribute)) {
+      return false;
+    }
+  }
+
+  return Resources(offer.resources()).contains(resources);
+}
+
+
+void OfferIndex::index(const Offer& offer)
+{
+  ordered.insert(make_pair(cpus(offer), offer.id().value()));
+
+  foreach (const Attribute& attribute, offer.attributes()) {
+    attributed[stringify(attribute)].insert(offer.id().value());
+  }
+}
+
+
+void OfferIndex::unindex(const Offer& offer)
+{
+  ordered.erase(make_pair(cpus(offer), offer.id().value()));
+
+  foreach (const Attribute& attribute, offer.attributes()) {
+    const string key = stringify(attribute);
+    if (attributed.contains(key)) {
+      attributed[key].erase(offer.id().value());
+      if (attributed[key].empty()) {
+        attributed.erase(key);
+      }
+    }
+  }
+}
+
+} // namespace mesos {
@@ -17,9 +17,17 @@
 #ifndef __COMMON_RECORDIO_HPP__
 #define __COMMON_RECORDIO_HPP__
 
+#include <deque>
+#include <functional>
+#include <memory>
 #include <queue>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 
 #include <mesos/mesos.hpp>
 
@@ -29,20 +37,184 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/check.hpp>
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
+#include <stout/numify.hpp>
 #include <stout/recordio.hpp>
 #include <stout/result.hpp>
+#include <stout/try.hpp>
 
 namespace mesos {
 namespace internal {
 namespace recordio {
 
 namespace internal {
+
 template <typename T>
 class ReaderProcess;
+
+
+// Decodes a chunk of data into the records it completes.
+template <typename T>
+using Decode = std::function<Try<std::deque<Try<T>>>(const std::string&)>;
+
+
+template <typename T, typename Decoder>
+Decode<T> decode(Decoder&& decoder)
+{
+  // The decoders are stateful, hence shared rather than copied.
+  std::shared_ptr<Decoder> shared(new Decoder(std::move(decoder)));
+
+  return [shared](const std::string& data) {
+    return shared->decode(data);
+  };
+}
+
 } // namespace internal {
 
 
+/**
+ * Provides decoding from "Record-IO" data into protobuf messages.
+ * Unlike ::recordio::Decoder, this does not copy the records into
+ * strings before deserializing them: a record which is contained
+ * within a chunk of data is parsed directly from the chunk. Only
+ * the parts of a record which spans multiple chunks are retained,
+ * one buffer per chunk, and the record is parsed across the chain
+ * of buffers once it is complete.
+ */
+template <typename T>
+class ProtobufDecoder
+{
+public:
+  ProtobufDecoder() : state(HEADER), length(0), buffered(0) {}
+
+  /**
+   * Decodes another chunk of data from the "Record-IO" stream
+   * and returns the attempted decoding of any additional
+   * complete records.
+   *
+   * Returns an Error if the data contains an invalid length
+   * header, at which point the decoder will return Error for
+   * all subsequent calls.
+   */
+  Try<std::deque<Try<T>>> decode(const std::string& data)
+  {
+    if (state == FAILED) {
+      return Error("Decoder is in a FAILED state");
+    }
+
+    std::deque<Try<T>> records;
+
+    size_t offset = 0;
+    while (offset < data.size()) {
+      if (state == HEADER) {
+        // Keep reading until we have the entire header.
+        size_t newline = data.find('\n', offset);
+        if (newline == std::string::npos) {
+          header.append(data, offset, std::string::npos);
+          break;
+        }
+
+        header.append(data, offset, newline - offset);
+        offset = newline + 1;
+
+        Try<size_t> numify = ::numify<size_t>(header);
+
+        // If we were unable to decode the length header, do not
+        // continue decoding since we cannot determine where to
+        // pick up the next length header!
+        if (numify.isError()) {
+          state = FAILED;
+          return Error("Failed to decode length '" + header + "': " +
+                       numify.error());
+        }
+
+        header.clear();
+        length = numify.get();
+
+        // Note that for 0 length records, we immediately decode.
+        if (length == 0) {
+          records.push_back(parse(data.data(), 0));
+        } else {
+          state = RECORD;
+        }
+
+        continue;
+      }
+
+      CHECK_EQ(RECORD, state);
+      CHECK_LT(buffered, length);
+
+      const size_t remaining = length - buffered;
+      const size_t available = data.size() - offset;
+
+      if (available < remaining) {
+        buffers.push_back(data.substr(offset));
+        buffered += available;
+        break;
+      }
+
+      records.push_back(parse(data.data() + offset, remaining));
+      offset += remaining;
+
+      buffers.clear();
+      buffered = 0;
+      state = HEADER;
+    }
+
+    return records;
+  }
+
+private:
+  // Parses a record from the retained buffers followed by the given
+  // data, without copying them.
+  Try<T> parse(const char* data, size_t size)
+  {
+    using google::protobuf::io::ArrayInputStream;
+    using google::protobuf::io::ConcatenatingInputStream;
+    using google::protobuf::io::ZeroCopyInputStream;
+
+    std::vector<std::unique_ptr<ArrayInputStream>> streams;
+    std::vector<ZeroCopyInputStream*> chain;
+
+    foreach (const std::string& buffer, buffers) {
+      streams.emplace_back(
+          new ArrayInputStream(buffer.data(), buffer.size()));
+      chain.push_back(streams.back().get());
+    }
+
+    streams.emplace_back(new ArrayInputStream(data, size));
+    chain.push_back(streams.back().get());
+
+    ConcatenatingInputStream stream(chain.data(), chain.size());
+
+    T message;
+    if (!message.ParseFromZeroCopyStream(&stream)) {
+      return Error("Failed to parse record into a protobuf object");
+    }
+
+    return message;
+  }
+
+  enum
+  {
+    HEADER,
+    RECORD,
+    FAILED
+  } state;
+
+  std::string header;
+
+  // The length of the current record and the number of its bytes
+  // retained in `buffers` so far.
+  size_t length;
+  size_t buffered;
+
+  std::deque<std::string> buffers;
+};
+
+
 /**
  * Provides RecordIO decoding on top of an http::Pipe::Reader.
  * The caller is responsible for closing the http::Pipe::Reader
@@ -61,7 +233,16 @@ class Reader
 public:
   Reader(::recordio::Decoder<T>&& decoder,
          process::http::Pipe::Reader reader)
-    : process(new internal::ReaderProcess<T>(std::move(decoder), reader))
+    : process(new internal::ReaderProcess<T>(
+          internal::decode<T>(std::move(decoder)), reader))
+  {
+    process::spawn(process.get());
+  }
+
+  Reader(ProtobufDecoder<T>&& decoder,
+         process::http::Pipe::Reader reader)
+    : process(new internal::ReaderProcess<T>(
+          internal::decode<T>(std::move(decoder)), reader))
   {
     process::spawn(process.get());
   }
@@ -95,9 +276,9 @@ class ReaderProcess : public process::Process<ReaderProcess<T>>
 {
 public:
   ReaderProcess(
-      ::recordio::Decoder<T>&& _decoder,
+      const Decode<T>& _decode,
       process::http::Pipe::Reader _reader)
-    : decoder(_decoder),
+    : decode(_decode),
       reader(_reader),
       done(false) {}
 
@@ -178,14 +359,14 @@ private:
       return;
     }
 
-    Try<std::deque<Try<T>>> decode = decoder.decode(read.get());
+    Try<std::deque<Try<T>>> decoded = decode(read.get());
 
-    if (decode.isError()) {
-      fail("Decoder failure: " + decode.error());
+    if (decoded.isError()) {
+      fail("Decoder failure: " + decoded.error());
       return;
     }
 
-    foreach (const Try<T>& record, decode.get()) {
+    foreach (const Try<T>& record, decoded.get()) {
       if (!waiters.empty()) {
         waiters.front()->set(Result<T>(std::move(record)));
         waiters.pop();
@@ -197,7 +378,7 @@ private:
     consume();
   }
 
-  ::recordio::Decoder<T> decoder;
+  const Decode<T> decode;
   process::http::Pipe::Reader reader;
 
   std::queue<process::Owned<process::Promise<Result<T>>>> waiters;
@@ -224,8 +224,10 @@ namespace internal {
 // different name, type or role are not addable.
 static bool addable(const Resource& left, const Resource& right)
 {
-  if (left.name() != right.name() ||
-      left.type() != right.type() ||
+  // NOTE: The type is compared first since it is cheaper to compare
+  // than the strings.
+  if (left.type() != right.type() ||
+      left.name() != right.name() ||
       left.role() != right.role()) {
     return false;
   }
@@ -281,8 +283,10 @@ static bool addable(const Resource& left, const Resource& right)
 // contain "right".
 static bool subtractable(const Resource& left, const Resource& right)
 {
-  if (left.name() != right.name() ||
-      left.type() != right.type() ||
+  // NOTE: The type is compared first since it is cheaper to compare
+  // than the strings.
+  if (left.type() != right.type() ||
+      left.name() != right.name() ||
       left.role() != right.role()) {
     return false;
   }
@@ -812,6 +816,29 @@ Resources::Resources(const RepeatedPtrField<Resource>& _resources)
 
 bool Resources::contains(const Resources& that) const
 {
+  // The Resource objects in 'that' which are not disk resources can
+  // not be combined with each other (otherwise they would have been),
+  // hence each of them can only be contained in a distinct Resource
+  // object of this Resources. In this case we can avoid the copy and
+  // the subtractions below.
+  bool disk = false;
+  foreach (const Resource& resource, that.resources) {
+    if (resource.has_disk()) {
+      disk = true;
+      break;
+    }
+  }
+
+  if (!disk) {
+    foreach (const Resource& resource, that.resources) {
+      if (!_contains(resource)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   Resources remaining = *this;
 
   foreach (const Resource& resource, that.resources) {
@@ -822,7 +849,7 @@ bool Resources::contains(const Resources& that) const
       return false;
     }
 
-    remaining -= resource;
+    remaining._subtract(resource);
   }
 
   return true;
@@ -867,7 +894,11 @@ hashmap<string, Resources> Resources::reserved() const
 
 Resources Resources::reserved(const string& role) const
 {
-  return filter(lambda::bind(isReserved, lambda::_1, role));
+  // NOTE: The role is compared directly rather than bound to
+  // 'isReserved', which would copy it into an 'Option' per resource.
+  return filter([&role](const Resource& resource) {
+    return !isUnreserved(resource) && resource.role() == role;
+  });
 }
 
 
@@ -1269,6 +1300,46 @@ bool Resources::_contains(const Resource& that) const
 }
 
 
+void Resources::_add(const Resource& that)
+{
+  foreach (Resource& resource, resources) {
+    if (internal::addable(resource, that)) {
+      resource += that;
+      return;
+    }
+  }
+
+  // Cannot be combined with any existing Resource object.
+  resources.Add()->CopyFrom(that);
+}
+
+
+void Resources::_subtract(const Resource& that)
+{
+  for (int i = 0; i < resources.size(); i++) {
+    Resource* resource = resources.Mutable(i);
+
+    if (internal::subtractable(*resource, that)) {
+      *resource -= that;
+
+      // Remove the resource if it becomes invalid or zero. We need
+      // to do the validation because we want to strip negative
+      // scalar Resource object. Subtraction only changes the value,
+      // so for scalars checking the value is sufficient.
+      if (resource->type() == Value::SCALAR) {
+        if (resource->scalar().value() <= 0) {
+          resources.DeleteSubrange(i, 1);
+        }
+      } else if (validate(*resource).isSome() || isEmpty(*resource)) {
+        resources.DeleteSubrange(i, 1);
+      }
+
+      break;
+    }
+  }
+}
+
+
 Option<Resources> Resources::find(const Resource& target) const
 {
   Resources found;
@@ -1349,19 +1420,7 @@ Resources Resources::operator+(const Resources& that) const
 Resources& Resources::operator+=(const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    bool found = false;
-    foreach (Resource& resource, resources) {
-      if (internal::addable(resource, that)) {
-        resource += that;
-        found = true;
-        break;
-      }
-    }
-
-    // Cannot be combined with any existing Resource object.
-    if (!found) {
-      resources.Add()->CopyFrom(that);
-    }
+    _add(that);
   }
 
   return *this;
@@ -1370,8 +1429,9 @@ Resources& Resources::operator+=(const Resource& that)
 
 Resources& Resources::operator+=(const Resources& that)
 {
+  // NOTE: The Resource objects in 'that' are valid and not empty.
   foreach (const Resource& resource, that.resources) {
-    *this += resource;
+    _add(resource);
   }
 
   return *this;
@@ -1397,22 +1457,7 @@ Resources Resources::operator-(const Resources& that) const
 Resources& Resources::operator-=(const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    for (int i = 0; i < resources.size(); i++) {
-      Resource* resource = resources.Mutable(i);
-
-      if (internal::subtractable(*resource, that)) {
-        *resource -= that;
-
-        // Remove the resource if it becomes invalid or zero. We need
-        // to do the validation because we want to strip negative
-        // scalar Resource object.
-        if (validate(*resource).isSome() || isEmpty(*resource)) {
-          resources.DeleteSubrange(i, 1);
-        }
-
-        break;
-      }
-    }
+    _subtract(that);
   }
 
   return *this;
@@ -1421,8 +1466,9 @@ Resources& Resources::operator-=(const Resource& that)
 
 Resources& Resources::operator-=(const Resources& that)
 {
+  // NOTE: The Resource objects in 'that' are valid and not empty.
   foreach (const Resource& resource, that.resources) {
-    *this -= resource;
+    _subtract(resource);
   }
 
   return *this;
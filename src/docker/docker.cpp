@@ -14,23 +14,34 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <time.h>
+
+#include <list>
 #include <map>
+#include <mutex>
+#include <set>
 #include <vector>
 
 #include <stout/lambda.hpp>
 #include <stout/os.hpp>
 #include <stout/result.hpp>
 #include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
 
 #include <stout/os/read.hpp>
 
 #include <process/check.hpp>
 #include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
 #include <process/io.hpp>
+#include <process/process.hpp>
 
 #include "common/status_utils.hpp"
 
 #include "docker/docker.hpp"
+#include "docker/engine.hpp"
 
 #ifdef __linux__
 #include "linux/cgroups.hpp"
@@ -47,8 +58,11 @@ using namespace mesos::internal::slave;
 
 using namespace process;
 
+namespace engine = mesos::internal::docker::engine;
+
 using std::list;
 using std::map;
+using std::set;
 using std::string;
 using std::vector;
 
@@ -94,16 +108,314 @@ static Future<Nothing> checkError(const string& cmd, const Subprocess& s)
 }
 
 
+// Returns the path of the unix socket in a 'unix://' address.
+static string socketPath(const string& socket)
+{
+  return strings::remove(socket, "unix://", strings::PREFIX);
+}
+
+
+// Performs 'GET /containers/NAME/json' through the Docker Engine API.
+static Future<Docker::Container> inspectContainer(
+    const string& socket,
+    const string& containerName)
+{
+  const string path = "/containers/" + containerName + "/json";
+
+  return engine::request(socket, "GET", path)
+    .then([=](const engine::Response& response)
+        -> Future<Docker::Container> {
+      if (response.code != 200) {
+        return Failure(
+            "Failed to inspect container '" + containerName + "': " +
+            stringify(response.code) + " " + strings::trim(response.body));
+      }
+
+      // The API returns a single object while 'docker inspect' returns
+      // an array of them.
+      Try<Docker::Container> container =
+        Docker::Container::create("[" + response.body + "]");
+
+      if (container.isError()) {
+        return Failure("Unable to create container: " + container.error());
+      }
+
+      return container.get();
+    });
+}
+
+
+// Inspects the container every 'retryInterval' until it has started.
+static void pollContainer(
+    const string& socket,
+    const string& containerName,
+    const Owned<Promise<Docker::Container>>& promise,
+    const Duration& retryInterval)
+{
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+    return;
+  }
+
+  inspectContainer(socket, containerName)
+    .onAny([=](const Future<Docker::Container>& container) {
+      if (container.isReady() && container.get().started) {
+        promise->set(container.get());
+        return;
+      }
+
+      VLOG(1) << "Retrying inspect of container '" << containerName
+              << "', interval: " << stringify(retryInterval);
+
+      Clock::timer(retryInterval, [=]() {
+        pollContainer(socket, containerName, promise, retryInterval);
+      });
+    });
+}
+
+
+// Dispatches the events of the containers of a Docker daemon to the
+// ones waiting for them, so that the containers of an agent share a
+// single subscription to the '/events' stream of the daemon rather
+// than holding a connection to it each. The subscription is made on
+// the first wait and kept until it breaks, at which point the pending
+// waits fail (and the next wait subscribes again).
+class EventsProcess : public Process<EventsProcess>
+{
+public:
+  explicit EventsProcess(const string& _socket)
+    : ProcessBase(process::ID::generate("docker-events")),
+      socket(_socket),
+      unsupported(false) {}
+
+  virtual ~EventsProcess() {}
+
+  // Returns the next event of the container with one of the statuses.
+  Future<string> wait(const string& containerName, const set<string>& statuses)
+  {
+    if (unsupported) {
+      return Failure("The Docker daemon does not report container names");
+    }
+
+    subscribe();
+
+    Owned<Promise<string>> promise(new Promise<string>());
+
+    Waiter waiter;
+    waiter.statuses = statuses;
+    waiter.promise = promise;
+
+    waiters[containerName].push_back(waiter);
+
+    promise->future()
+      .onDiscard(defer(self(), &Self::discarded, containerName, promise));
+
+    return promise->future();
+  }
+
+private:
+  struct Waiter
+  {
+    set<string> statuses;
+    Owned<Promise<string>> promise;
+  };
+
+  void subscribe()
+  {
+    if (subscription.isSome()) {
+      return;
+    }
+
+    JSON::Array event;
+    event.values.push_back("start");
+    event.values.push_back("die");
+    event.values.push_back("oom");
+
+    JSON::Object filters;
+    filters.values["event"] = event;
+
+    // Events since a second ago are included so that a container event
+    // while subscribing is not missed.
+    hashmap<string, string> query;
+    query["since"] = stringify(::time(NULL) - 1);
+    query["filters"] = stringify(filters);
+
+    Future<Nothing> events = engine::events(
+        socket,
+        query,
+        defer(self(), &Self::event, lambda::_1));
+
+    subscription = events;
+
+    events.onAny(defer(self(), &Self::ended, lambda::_1));
+  }
+
+  void event(const JSON::Object& event)
+  {
+    Result<JSON::String> status = event.find<JSON::String>("status");
+    if (!status.isSome()) {
+      return;
+    }
+
+    // NOTE: The name of the container is only part of the events since
+    // version 1.22 of the API. Without it the events can not be matched
+    // to the containers, so the waits fail (e.g., to fall back to
+    // polling) rather than never being satisfied.
+    Result<JSON::String> name =
+      event.find<JSON::String>("Actor.Attributes.name");
+
+    if (!name.isSome()) {
+      unsupported = true;
+      fail("The Docker daemon does not report container names");
+      subscription->discard();
+      return;
+    }
+
+    if (!waiters.contains(name->value)) {
+      return;
+    }
+
+    list<Waiter>& pending = waiters[name->value];
+
+    for (auto it = pending.begin(); it != pending.end();) {
+      if (it->statuses.count(status->value) > 0) {
+        it->promise->set(status->value);
+        it = pending.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (pending.empty()) {
+      waiters.erase(name->value);
+    }
+  }
+
+  void ended(const Future<Nothing>& future)
+  {
+    subscription = None();
+
+    fail(future.isFailed()
+         ? "The Docker event stream failed: " + future.failure()
+         : "The Docker event stream ended");
+  }
+
+  void discarded(
+      const string& containerName,
+      const Owned<Promise<string>>& promise)
+  {
+    if (waiters.contains(containerName)) {
+      waiters[containerName].remove_if([&](const Waiter& waiter) {
+        return waiter.promise == promise;
+      });
+
+      if (waiters[containerName].empty()) {
+        waiters.erase(containerName);
+      }
+    }
+
+    promise->discard();
+  }
+
+  void fail(const string& message)
+  {
+    foreachvalue (const list<Waiter>& pending, waiters) {
+      foreach (const Waiter& waiter, pending) {
+        waiter.promise->fail(message);
+      }
+    }
+
+    waiters.clear();
+  }
+
+  const string socket;
+  bool unsupported;
+  Option<Future<Nothing>> subscription;
+  hashmap<string, list<Waiter>> waiters;
+};
+
+
+// Returns the process dispatching the events of the Docker daemon
+// listening on the socket, which is shared by all the users of it.
+static PID<EventsProcess> events(const string& socket)
+{
+  static std::mutex* mutex = new std::mutex();
+  static hashmap<string, PID<EventsProcess>>* processes =
+    new hashmap<string, PID<EventsProcess>>();
+
+  synchronized (mutex) {
+    if (!processes->contains(socket)) {
+      processes->put(socket, spawn(new EventsProcess(socket), true));
+    }
+
+    return processes->at(socket);
+  }
+}
+
+
+// Inspects the container whenever the Docker daemon reports that it
+// started, until it has. If the event stream breaks we fall back to
+// polling.
+static void watchContainer(
+    const string& socket,
+    const string& containerName,
+    const Owned<Promise<Docker::Container>>& promise,
+    const Duration& retryInterval)
+{
+  Future<string> started = dispatch(
+      events(socket),
+      &EventsProcess::wait,
+      containerName,
+      set<string>({"start"}));
+
+  // The container may have started before we began waiting.
+  inspectContainer(socket, containerName)
+    .onReady([=](const Docker::Container& container) {
+      if (container.started) {
+        promise->set(container);
+      }
+    });
+
+  promise->future()
+    .onDiscard([=]() { Future<string>(started).discard(); })
+    .onAny([=]() { Future<string>(started).discard(); });
+
+  started
+    .onAny([=](const Future<string>& future) {
+      if (!promise->future().isPending()) {
+        return;
+      }
+
+      if (future.isReady()) {
+        // The container is polled (rather than waited for again) in
+        // the unlikely case that it is not inspected as started yet.
+        pollContainer(socket, containerName, promise, retryInterval);
+        return;
+      }
+
+      if (!promise->future().hasDiscard()) {
+        LOG(WARNING) << "Falling back to polling container '"
+                     << containerName << "' as waiting for it to start "
+                     << "failed: "
+                     << (future.isFailed() ? future.failure() : "discarded");
+      }
+
+      pollContainer(socket, containerName, promise, retryInterval);
+    });
+}
+
+
 Try<Owned<Docker>> Docker::create(
     const string& path,
     const string& socket,
-    bool validate)
+    bool validate,
+    bool api)
 {
   if (!strings::startsWith(socket, "/")) {
     return Error("Invalid Docker socket path: " + socket);
   }
 
-  Owned<Docker> docker(new Docker(path, socket));
+  Owned<Docker> docker(new Docker(path, socket, api));
   if (!validate) {
     return docker;
   }
@@ -138,6 +450,29 @@ void commandDiscarded(const Subprocess& s, const string& cmd)
 
 Future<Version> Docker::version() const
 {
+  if (api) {
+    return engine::request(socketPath(socket), "GET", "/version")
+      .then([](const engine::Response& response) -> Future<Version> {
+        if (response.code != 200) {
+          return Failure(
+              "Failed to get docker version: " + stringify(response.code) +
+              " " + strings::trim(response.body));
+        }
+
+        Try<JSON::Object> json = JSON::parse<JSON::Object>(response.body);
+        if (json.isError()) {
+          return Failure("Failed to parse docker version: " + json.error());
+        }
+
+        Result<JSON::String> version = json.get().find<JSON::String>("Version");
+        if (!version.isSome()) {
+          return Failure("Unable to find docker version in response");
+        }
+
+        return __version(version.get().value);
+      });
+  }
+
   string cmd = path + " -H " + socket + " --version";
 
   Try<Subprocess> s = subprocess(
@@ -669,6 +1004,35 @@ Future<Nothing> Docker::stop(
                    stringify(timeoutSecs));
   }
 
+  if (api) {
+    hashmap<string, string> query;
+    query["t"] = stringify(timeoutSecs);
+
+    const Docker docker = *this;
+
+    return engine::request(
+        socketPath(socket),
+        "POST",
+        "/containers/" + containerName + "/stop",
+        query)
+      .then([=](const engine::Response& response) -> Future<Nothing> {
+        // A 304 means that the container was already stopped.
+        bool stopped = response.code == 204 || response.code == 304;
+
+        if (remove) {
+          return docker.rm(containerName, !stopped);
+        }
+
+        if (!stopped) {
+          return Failure(
+              "Failed to stop container '" + containerName + "': " +
+              stringify(response.code) + " " + strings::trim(response.body));
+        }
+
+        return Nothing();
+      });
+  }
+
   string cmd = path + " -H " + socket + " stop -t " + stringify(timeoutSecs) +
                " " + containerName;
 
@@ -716,6 +1080,29 @@ Future<Nothing> Docker::rm(
     const string& containerName,
     bool force) const
 {
+  if (api) {
+    hashmap<string, string> query;
+    query["v"] = "1";
+    if (force) {
+      query["force"] = "1";
+    }
+
+    return engine::request(
+        socketPath(socket),
+        "DELETE",
+        "/containers/" + containerName,
+        query)
+      .then([=](const engine::Response& response) -> Future<Nothing> {
+        if (response.code != 204) {
+          return Failure(
+              "Failed to remove container '" + containerName + "': " +
+              stringify(response.code) + " " + strings::trim(response.body));
+        }
+
+        return Nothing();
+      });
+  }
+
   // The `-v` flag removes Docker volumes that may be present.
   const string cmd =
     path + " -H " + socket +
@@ -741,8 +1128,19 @@ Future<Docker::Container> Docker::inspect(
     const string& containerName,
     const Option<Duration>& retryInterval) const
 {
+  if (api && retryInterval.isNone()) {
+    return inspectContainer(socketPath(socket), containerName);
+  }
+
   Owned<Promise<Docker::Container>> promise(new Promise<Docker::Container>());
 
+  if (api) {
+    watchContainer(
+        socketPath(socket), containerName, promise, retryInterval.get());
+
+    return promise->future();
+  }
+
   const string cmd =  path + " -H " + socket + " inspect " + containerName;
   _inspect(cmd, promise, retryInterval);
 
@@ -873,10 +1271,89 @@ void Docker::___inspect(
 }
 
 
+Future<string> Docker::event(
+    const string& containerName,
+    const set<string>& statuses) const
+{
+  if (!api) {
+    return Failure("Container events require the Docker Engine API");
+  }
+
+  return dispatch(
+      events(socketPath(socket)),
+      &EventsProcess::wait,
+      containerName,
+      statuses);
+}
+
+
 Future<list<Docker::Container>> Docker::ps(
     bool all,
     const Option<string>& prefix) const
 {
+  if (api) {
+    hashmap<string, string> query;
+    if (all) {
+      query["all"] = "1";
+    }
+
+    const Docker docker = *this;
+
+    return engine::request(
+        socketPath(socket), "GET", "/containers/json", query)
+      .then([=](const engine::Response& response)
+          -> Future<list<Docker::Container>> {
+        if (response.code != 200) {
+          return Failure(
+              "Failed to list containers: " + stringify(response.code) +
+              " " + strings::trim(response.body));
+        }
+
+        Try<JSON::Array> array = JSON::parse<JSON::Array>(response.body);
+        if (array.isError()) {
+          return Failure("Failed to parse containers: " + array.error());
+        }
+
+        // Collect one name per container, in the same format as the
+        // last column of 'docker ps', to inspect them in batches.
+        Owned<vector<string>> lines(new vector<string>());
+
+        foreach (const JSON::Value& value, array.get().values) {
+          if (!value.is<JSON::Object>()) {
+            return Failure("Unexpected container in list: " + stringify(value));
+          }
+
+          Result<JSON::Array> names =
+            value.as<JSON::Object>().find<JSON::Array>("Names");
+
+          if (!names.isSome()) {
+            continue;
+          }
+
+          // The names of links contain more than the leading slash.
+          foreach (const JSON::Value& name, names.get().values) {
+            if (name.is<JSON::String>()) {
+              const string& _name = name.as<JSON::String>().value;
+              if (_name.find('/', 1) == string::npos) {
+                lines->push_back(strings::remove(_name, "/", strings::PREFIX));
+                break;
+              }
+            }
+          }
+        }
+
+        Owned<list<Docker::Container>> containers(
+            new list<Docker::Container>());
+
+        Owned<Promise<list<Docker::Container>>> promise(
+            new Promise<list<Docker::Container>>());
+
+        inspectBatches(containers, lines, promise, docker, prefix);
+
+        return promise->future();
+      });
+  }
+
   string cmd = path + " -H " + socket + (all ? " ps -a" : " ps");
 
   VLOG(1) << "Running " << cmd;
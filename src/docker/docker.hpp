@@ -19,6 +19,7 @@
 
 #include <list>
 #include <map>
+#include <set>
 #include <string>
 
 #include <process/future.hpp>
@@ -39,6 +40,12 @@
 
 // Abstraction for working with Docker (modeled on CLI).
 //
+// If 'api' is set, containers are inspected, listed, stopped and
+// removed through the Docker Engine API on 'socket' rather than by
+// forking the docker CLI, and waiting for a container to start uses
+// the '/events' stream of the daemon rather than polling. Running
+// containers and pulling images always use the CLI.
+//
 // TODO(benh): Make futures returned by functions be discardable.
 class Docker
 {
@@ -47,7 +54,8 @@ public:
   static Try<process::Owned<Docker>> create(
       const std::string& path,
       const std::string& socket,
-      bool validate = true);
+      bool validate = true,
+      bool api = false);
 
   virtual ~Docker() {}
 
@@ -154,6 +162,15 @@ public:
       bool all = false,
       const Option<std::string>& prefix = None()) const;
 
+  // Returns the status of the next event of the container which is
+  // one of 'statuses' (e.g., "die" or "oom"). The events come from a
+  // single '/events' stream per Docker daemon which is shared by all
+  // the containers, hence this is only supported through the Docker
+  // Engine API.
+  virtual process::Future<std::string> event(
+      const std::string& containerName,
+      const std::set<std::string>& statuses) const;
+
   virtual process::Future<Image> pull(
       const std::string& directory,
       const std::string& image,
@@ -170,8 +187,9 @@ public:
 protected:
   // Uses the specified path to the Docker CLI tool.
   Docker(const std::string& _path,
-         const std::string& _socket)
-       : path(_path), socket("unix://" + _socket) {}
+         const std::string& _socket,
+         bool _api = false)
+       : path(_path), socket("unix://" + _socket), api(_api) {}
 
 private:
   static process::Future<Nothing> _run(
@@ -265,6 +283,9 @@ private:
 
   const std::string path;
   const std::string socket;
+
+  // Whether to use the Docker Engine API instead of the CLI.
+  const bool api;
 };
 
 #endif // __DOCKER_HPP__
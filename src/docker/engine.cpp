@@ -0,0 +1,273 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/http.hpp>
+#include <process/io.hpp>
+
+#include <stout/error.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/result.hpp>
+#include <stout/strings.hpp>
+
+#include "docker/engine.hpp"
+
+using namespace process;
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace docker {
+namespace engine {
+
+static Try<int> connect(const string& socket)
+{
+  struct sockaddr_un address;
+
+  if (socket.size() >= sizeof(address.sun_path)) {
+    return Error("Socket path '" + socket + "' is too long");
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return ErrnoError("Failed to create socket");
+  }
+
+  Try<Nothing> cloexec = os::cloexec(fd);
+  if (cloexec.isError()) {
+    os::close(fd);
+    return Error("Failed to set close-on-exec: " + cloexec.error());
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socket.c_str(), sizeof(address.sun_path) - 1);
+
+  // Connecting to a unix socket does not block for long.
+  if (::connect(fd, (struct sockaddr*) &address, sizeof(address)) < 0) {
+    ErrnoError error("Failed to connect to '" + socket + "'");
+    os::close(fd);
+    return error;
+  }
+
+  Try<Nothing> nonblock = os::nonblock(fd);
+  if (nonblock.isError()) {
+    os::close(fd);
+    return Error("Failed to set non-blocking mode: " + nonblock.error());
+  }
+
+  return fd;
+}
+
+
+static string encode(
+    const string& method,
+    const string& path,
+    const hashmap<string, string>& query)
+{
+  string uri = path;
+  if (!query.empty()) {
+    uri += "?" + http::query::encode(query);
+  }
+
+  return method + " " + uri + " HTTP/1.0\r\n" +
+         "Host: docker\r\n" +
+         "Content-Length: 0\r\n" +
+         "\r\n";
+}
+
+
+// Returns the status code of a response and the size of its status
+// line and headers, or None if they have not been received yet.
+static Result<pair<int, size_t>> decode(const string& data)
+{
+  size_t end = data.find("\r\n\r\n");
+  if (end == string::npos) {
+    return None();
+  }
+
+  vector<string> status =
+    strings::tokenize(data.substr(0, data.find("\r\n")), " ");
+
+  if (status.size() < 2 || !strings::startsWith(status[0], "HTTP/")) {
+    return Error("Malformed status line in response");
+  }
+
+  Try<int> code = numify<int>(status[1]);
+  if (code.isError()) {
+    return Error("Malformed status code in response: " + code.error());
+  }
+
+  if (strings::contains(
+          strings::lower(data.substr(0, end)),
+          "transfer-encoding: chunked")) {
+    return Error("Unexpected chunked response");
+  }
+
+  return std::make_pair(code.get(), end + 4);
+}
+
+
+Future<Response> request(
+    const string& socket,
+    const string& method,
+    const string& path,
+    const hashmap<string, string>& query)
+{
+  Try<int> fd = connect(socket);
+  if (fd.isError()) {
+    return Failure(fd.error());
+  }
+
+  VLOG(1) << "Sending '" << method << " " << path << "' to the Docker daemon";
+
+  return io::write(fd.get(), encode(method, path, query))
+    .then([=]() { return io::read(fd.get()); })
+    .then([](const string& data) -> Future<Response> {
+      Result<pair<int, size_t>> response = decode(data);
+      if (response.isError()) {
+        return Failure(response.error());
+      } else if (response.isNone()) {
+        return Failure("Incomplete response from the Docker daemon");
+      }
+
+      return Response{
+          response.get().first,
+          data.substr(response.get().second)};
+    })
+    .onAny([=]() { os::close(fd.get()); });
+}
+
+
+namespace internal {
+
+struct Subscription
+{
+  int fd;
+  lambda::function<void(const JSON::Object&)> callback;
+
+  // Whether the status line and headers have been received.
+  bool subscribed;
+
+  // Data received but not processed yet.
+  string buffer;
+
+  char data[4096];
+};
+
+
+Future<Nothing> read(const std::shared_ptr<Subscription>& subscription)
+{
+  return io::read(
+      subscription->fd,
+      subscription->data,
+      sizeof(subscription->data))
+    .then([subscription](size_t length) -> Future<Nothing> {
+      if (length == 0) {
+        return Nothing(); // EOF.
+      }
+
+      subscription->buffer.append(subscription->data, length);
+
+      if (!subscription->subscribed) {
+        Result<pair<int, size_t>> response = decode(subscription->buffer);
+        if (response.isError()) {
+          return Failure(response.error());
+        } else if (response.isNone()) {
+          return read(subscription);
+        }
+
+        if (response.get().first != 200) {
+          return Failure(
+              "Failed to subscribe to events: " +
+              stringify(response.get().first) + " " +
+              subscription->buffer.substr(response.get().second));
+        }
+
+        subscription->buffer.erase(0, response.get().second);
+        subscription->subscribed = true;
+      }
+
+      // The daemon sends one JSON object per line.
+      size_t newline;
+      while ((newline = subscription->buffer.find('\n')) != string::npos) {
+        const string line =
+          strings::trim(subscription->buffer.substr(0, newline));
+
+        subscription->buffer.erase(0, newline + 1);
+
+        if (line.empty()) {
+          continue;
+        }
+
+        Try<JSON::Object> event = JSON::parse<JSON::Object>(line);
+        if (event.isError()) {
+          LOG(WARNING) << "Failed to parse Docker event '" << line << "': "
+                       << event.error();
+          continue;
+        }
+
+        subscription->callback(event.get());
+      }
+
+      return read(subscription);
+    });
+}
+
+} // namespace internal {
+
+
+Future<Nothing> events(
+    const string& socket,
+    const hashmap<string, string>& query,
+    const lambda::function<void(const JSON::Object&)>& callback)
+{
+  Try<int> fd = connect(socket);
+  if (fd.isError()) {
+    return Failure(fd.error());
+  }
+
+  std::shared_ptr<internal::Subscription> subscription(
+      new internal::Subscription());
+
+  subscription->fd = fd.get();
+  subscription->callback = callback;
+  subscription->subscribed = false;
+
+  return io::write(fd.get(), encode("GET", "/events", query))
+    .then([subscription]() { return internal::read(subscription); })
+    .onAny([=]() { os::close(fd.get()); });
+}
+
+} // namespace engine {
+} // namespace docker {
+} // namespace internal {
+} // namespace mesos {
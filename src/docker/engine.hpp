@@ -0,0 +1,75 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __DOCKER_ENGINE_HPP__
+#define __DOCKER_ENGINE_HPP__
+
+#include <string>
+
+#include <process/future.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+
+namespace mesos {
+namespace internal {
+namespace docker {
+namespace engine {
+
+// A client of the Docker Engine remote API, for the Docker daemon
+// listening on a unix socket. A connection is made per request.
+//
+// NOTE: The libprocess HTTP client only connects over TCP, hence the
+// requests are written to the unix socket directly. They are HTTP/1.0
+// requests so that the daemon closes the connection after the
+// response and does not use chunked transfer encoding.
+
+struct Response
+{
+  // Status code of the response, e.g., 200.
+  int code;
+
+  std::string body;
+};
+
+
+// Sends a request to the Docker daemon listening on 'socket' and
+// returns the response once it has been received completely.
+process::Future<Response> request(
+    const std::string& socket,
+    const std::string& method,
+    const std::string& path,
+    const hashmap<std::string, std::string>& query =
+      hashmap<std::string, std::string>());
+
+
+// Subscribes to the '/events' stream of the Docker daemon listening
+// on 'socket' and calls 'callback' for each event. The returned
+// future is ready when the daemon closes the stream; it should be
+// discarded to unsubscribe.
+process::Future<Nothing> events(
+    const std::string& socket,
+    const hashmap<std::string, std::string>& query,
+    const lambda::function<void(const JSON::Object&)>& callback);
+
+} // namespace engine {
+} // namespace docker {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __DOCKER_ENGINE_HPP__
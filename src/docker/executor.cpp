@@ -574,7 +574,8 @@ int main(int argc, char** argv)
   Try<Owned<Docker>> docker = Docker::create(
       flags.docker.get(),
       flags.docker_socket.get(),
-      false);
+      false,
+      flags.docker_engine_api);
 
   if (docker.isError()) {
     cerr << "Unable to create docker abstraction: " << docker.error() << endl;
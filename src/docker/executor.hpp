@@ -43,6 +43,12 @@ struct Flags : public mesos::internal::logging::Flags
         "The UNIX socket path to be used by docker CLI for accessing docker\n"
         "daemon.\n");
 
+    add(&docker_engine_api,
+        "docker_engine_api",
+        "Whether to use the Docker Engine API on the docker socket rather\n"
+        "than the docker CLI where possible.",
+        false);
+
     add(&sandbox_directory,
         "sandbox_directory",
         "The path to the container sandbox holding stdout and stderr files\n"
@@ -67,6 +73,7 @@ struct Flags : public mesos::internal::logging::Flags
   Option<std::string> container;
   Option<std::string> docker;
   Option<std::string> docker_socket;
+  bool docker_engine_api;
   Option<std::string> sandbox_directory;
   Option<std::string> mapped_directory;
   Option<Duration> stop_timeout;
@@ -22,6 +22,7 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <mesos/executor.hpp>
 #include <mesos/mesos.hpp>
@@ -35,6 +36,7 @@
 #include <process/protobuf.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/linkedhashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/numify.hpp>
@@ -64,6 +66,7 @@ using namespace mesos::internal::slave;
 using namespace process;
 
 using std::string;
+using std::vector;
 
 using process::Latch;
 using process::wait; // Necessary on some OS's to disambiguate.
@@ -492,6 +495,40 @@ protected:
   }
 
   void sendStatusUpdate(const TaskStatus& status)
+  {
+    send(slave, createStatusUpdate(status));
+  }
+
+  void sendStatusUpdates(const vector<TaskStatus>& statuses)
+  {
+    if (statuses.empty()) {
+      return;
+    }
+
+    StatusUpdatesMessage message;
+    foreach (const TaskStatus& status, statuses) {
+      message.add_updates()->CopyFrom(createStatusUpdate(status));
+    }
+
+    send(slave, message);
+  }
+
+  void sendFrameworkMessage(const string& data)
+  {
+    ExecutorToFrameworkMessage message;
+    message.mutable_slave_id()->MergeFrom(slaveId);
+    message.mutable_framework_id()->MergeFrom(frameworkId);
+    message.mutable_executor_id()->MergeFrom(executorId);
+    message.set_data(data);
+    send(slave, message);
+  }
+
+private:
+  friend class mesos::MesosExecutorDriver;
+
+  // Creates the message for a status update and captures the update
+  // so that it can be resent on re-registration until acknowledged.
+  StatusUpdateMessage createStatusUpdate(const TaskStatus& status)
   {
     StatusUpdateMessage message;
     StatusUpdate* update = message.mutable_update();
@@ -506,7 +543,7 @@ protected:
     // We overwrite the UUID for this status update, however with
     // the HTTP API, the executor will have to generate a UUID
     // (which needs to be validated to be RFC-4122 compliant).
-    UUID uuid = UUID::random();
+    UUID uuid = UUID::sequential();
     update->set_uuid(uuid.toBytes());
     update->mutable_status()->set_uuid(uuid.toBytes());
 
@@ -519,22 +556,9 @@ protected:
     // Capture the status update.
     updates[uuid] = *update;
 
-    send(slave, message);
+    return message;
   }
 
-  void sendFrameworkMessage(const string& data)
-  {
-    ExecutorToFrameworkMessage message;
-    message.mutable_slave_id()->MergeFrom(slaveId);
-    message.mutable_framework_id()->MergeFrom(frameworkId);
-    message.mutable_executor_id()->MergeFrom(executorId);
-    message.set_data(data);
-    send(slave, message);
-  }
-
-private:
-  friend class mesos::MesosExecutorDriver;
-
   UPID slave;
   MesosExecutorDriver* driver;
   Executor* executor;
@@ -817,6 +841,23 @@ Status MesosExecutorDriver::sendStatusUpdate(const TaskStatus& taskStatus)
 }
 
 
+Status MesosExecutorDriver::sendStatusUpdates(
+    const vector<TaskStatus>& taskStatuses)
+{
+  synchronized (mutex) {
+    if (status != DRIVER_RUNNING) {
+      return status;
+    }
+
+    CHECK(process != NULL);
+
+    dispatch(process, &ExecutorProcess::sendStatusUpdates, taskStatuses);
+
+    return status;
+  }
+}
+
+
 Status MesosExecutorDriver::sendFrameworkMessage(const string& data)
 {
   synchronized (mutex) {
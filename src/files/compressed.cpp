@@ -0,0 +1,182 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/gzip.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "files/compressed.hpp"
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace files {
+
+Try<Nothing> write(const string& path, const string& data)
+{
+  string compressed;
+  string index;
+
+  for (size_t offset = 0; offset < data.size();
+       offset += FRAME_SIZE.bytes()) {
+    const string frame = data.substr(offset, FRAME_SIZE.bytes());
+
+    // Compressing should not hold up the caller for long (e.g., the
+    // logger reading the output of a container), hence the fastest
+    // compression level.
+    Try<string> result = gzip::compress(frame, Z_BEST_SPEED);
+    if (result.isError()) {
+      return Error("Failed to compress: " + result.error());
+    }
+
+    index += stringify(offset) + " " + stringify(frame.size()) + " " +
+             stringify(compressed.size()) + " " +
+             stringify(result.get().size()) + "\n";
+
+    compressed += result.get();
+  }
+
+  Try<Nothing> write = os::write(path, compressed);
+  if (write.isError()) {
+    return Error("Failed to write '" + path + "': " + write.error());
+  }
+
+  // NOTE: The index is written last, so that a compressed file
+  // without an index is never mistaken for a complete one.
+  write = os::write(path + INDEX_SUFFIX, index);
+  if (write.isError()) {
+    return Error(
+        "Failed to write '" + path + INDEX_SUFFIX + "': " + write.error());
+  }
+
+  return Nothing();
+}
+
+
+Try<vector<Frame>> index(const string& path)
+{
+  Try<string> read = os::read(path + INDEX_SUFFIX);
+  if (read.isError()) {
+    return Error(
+        "Failed to read '" + path + INDEX_SUFFIX + "': " + read.error());
+  }
+
+  vector<Frame> frames;
+
+  foreach (const string& line, strings::tokenize(read.get(), "\n")) {
+    vector<string> tokens = strings::tokenize(line, " ");
+    if (tokens.size() != 4) {
+      return Error("Malformed index line '" + line + "'");
+    }
+
+    vector<size_t> values;
+    foreach (const string& token, tokens) {
+      Try<size_t> value = numify<size_t>(token);
+      if (value.isError()) {
+        return Error("Malformed index line '" + line + "': " + value.error());
+      }
+
+      values.push_back(value.get());
+    }
+
+    frames.push_back(Frame{values[0], values[1], values[2], values[3]});
+  }
+
+  return frames;
+}
+
+
+size_t size(const vector<Frame>& frames)
+{
+  return frames.empty() ? 0 : frames.back().offset + frames.back().length;
+}
+
+
+Try<string> read(
+    const string& path,
+    const vector<Frame>& frames,
+    size_t offset,
+    size_t length)
+{
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  string result;
+
+  foreach (const Frame& frame, frames) {
+    if (result.size() >= length) {
+      break;
+    }
+
+    // Skip the frames before the offset.
+    if (frame.offset + frame.length <= offset) {
+      continue;
+    }
+
+    if (lseek(fd.get(), frame.compressedOffset, SEEK_SET) == -1) {
+      ErrnoError error("Failed to seek '" + path + "'");
+      os::close(fd.get());
+      return error;
+    }
+
+    Result<string> compressed = os::read(fd.get(), frame.compressedLength);
+    if (!compressed.isSome()) {
+      os::close(fd.get());
+      return Error(
+          "Failed to read '" + path + "': " +
+          (compressed.isError() ? compressed.error() : "unexpected EOF"));
+    }
+
+    Try<string> decompressed = gzip::decompress(compressed.get());
+    if (decompressed.isError()) {
+      os::close(fd.get());
+      return Error(
+          "Failed to decompress '" + path + "': " + decompressed.error());
+    }
+
+    // The first frame may start before the offset.
+    const size_t start = offset > frame.offset ? offset - frame.offset : 0;
+
+    result += decompressed.get().substr(
+        std::min(start, decompressed.get().size()),
+        length - result.size());
+  }
+
+  os::close(fd.get());
+
+  return result;
+}
+
+} // namespace files {
+} // namespace internal {
+} // namespace mesos {
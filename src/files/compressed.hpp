@@ -0,0 +1,82 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __FILES_COMPRESSED_HPP__
+#define __FILES_COMPRESSED_HPP__
+
+#include <string>
+#include <vector>
+
+#include <stout/bytes.hpp>
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace files {
+
+// A compressed file is a sequence of independently compressed gzip
+// members ("frames"), each holding at most `FRAME_SIZE` bytes of the
+// uncompressed data, so the file is still a valid gzip file. The
+// frames are listed in an index next to the file, which allows
+// reading at an offset by decompressing only the frames covering it.
+//
+// The index has a line per frame of the form:
+//   <offset> <length> <compressed offset> <compressed length>
+
+const std::string INDEX_SUFFIX = ".index";
+const Bytes FRAME_SIZE = Kilobytes(256);
+
+
+struct Frame
+{
+  // Offset and length of the uncompressed data held by the frame.
+  size_t offset;
+  size_t length;
+
+  // Offset and length of the frame in the compressed file.
+  size_t compressedOffset;
+  size_t compressedLength;
+};
+
+
+// Compresses 'data' into a compressed file at 'path' and writes its
+// index to 'path' + `INDEX_SUFFIX`.
+Try<Nothing> write(const std::string& path, const std::string& data);
+
+
+// Returns the frames of the compressed file at 'path', as listed in
+// its index.
+Try<std::vector<Frame>> index(const std::string& path);
+
+
+// Returns the uncompressed size of the compressed file with 'frames'.
+size_t size(const std::vector<Frame>& frames);
+
+
+// Returns up to 'length' bytes of the uncompressed data starting at
+// 'offset' of the compressed file at 'path' with 'frames'.
+Try<std::string> read(
+    const std::string& path,
+    const std::vector<Frame>& frames,
+    size_t offset,
+    size_t length);
+
+} // namespace files {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __FILES_COMPRESSED_HPP__
@@ -18,6 +18,10 @@
 
 #include <sys/stat.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif // __linux__
+
 #include <algorithm>
 #include <map>
 #include <string>
@@ -25,6 +29,8 @@
 
 #include <boost/shared_array.hpp>
 
+#include <process/clock.hpp>
+#include <process/defer.hpp>
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -32,8 +38,12 @@
 #include <process/http.hpp>
 #include <process/io.hpp>
 #include <process/mime.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/timeout.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
@@ -48,6 +58,7 @@
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
+#include "files/compressed.hpp"
 #include "files/files.hpp"
 
 #include "logging/logging.hpp"
@@ -75,6 +86,15 @@ using std::vector;
 namespace mesos {
 namespace internal {
 
+// Default and maximum durations that a 'follow' read waits for data.
+static const Duration DEFAULT_FOLLOW_TIMEOUT = Seconds(10);
+static const Duration MAX_FOLLOW_TIMEOUT = Minutes(1);
+
+// How often the size of a followed file is checked where it cannot
+// be watched with inotify.
+static const Duration FOLLOW_POLL_INTERVAL = Milliseconds(100);
+
+
 class FilesProcess : public Process<FilesProcess>
 {
 public:
@@ -108,6 +128,15 @@ private:
   // See the jquery pailer for the expected behavior.
   Future<Response> read(const Request& request);
 
+  // Reads the resolved file. If 'follow' is set and there is no data
+  // at the offset, waits up to that long for the file to change.
+  Future<Response> _read(
+      const string& path,
+      off_t offset,
+      ssize_t length,
+      const Option<string>& jsonp,
+      const Option<Duration>& follow);
+
   // Returns the raw file contents for a given path.
   // Requests have the following parameters:
   //   path: The directory to browse. Required.
@@ -254,11 +283,11 @@ Future<Response> FilesProcess::browse(const Request& request)
 
 
 // TODO(benh): Remove 'const &' from size after fixing libprocess.
-Future<Response> _read(int fd,
-                       const size_t& size,
-                       off_t offset,
-                       const boost::shared_array<char>& data,
-                       const Option<string>& jsonp) {
+Future<Response> __read(int fd,
+                        const size_t& size,
+                        off_t offset,
+                        const boost::shared_array<char>& data,
+                        const Option<string>& jsonp) {
   JSON::Object object;
 
   object.values["offset"] = offset;
@@ -268,6 +297,48 @@ Future<Response> _read(int fd,
 }
 
 
+// Reads a compressed file (see "files/compressed.hpp") as if it were
+// uncompressed, decompressing only the frames covering the requested
+// range of the file.
+static Future<Response> readCompressed(
+    const string& path,
+    off_t offset,
+    ssize_t length,
+    const Option<string>& jsonp)
+{
+  Try<vector<files::Frame>> frames = files::index(path);
+  if (frames.isError()) {
+    string error = "Failed to read index of '" + path + "': " + frames.error();
+    LOG(WARNING) << error;
+    return InternalServerError(error + ".\n");
+  }
+
+  const off_t size = files::size(frames.get());
+
+  if (offset == -1 || offset > size) {
+    offset = size;
+  }
+
+  // Cap the read length the same way as for uncompressed files.
+  if (length == -1) {
+    length = std::min<ssize_t>(size - offset, sysconf(_SC_PAGE_SIZE) * 16);
+  } else {
+    length = std::min<ssize_t>(length, sysconf(_SC_PAGE_SIZE) * 256);
+  }
+
+  Try<string> data = files::read(path, frames.get(), offset, length);
+  if (data.isError()) {
+    LOG(WARNING) << data.error();
+    return InternalServerError(data.error() + ".\n");
+  }
+
+  JSON::Object object;
+  object.values["offset"] = offset;
+  object.values["data"] = data.get();
+  return OK(object, jsonp);
+}
+
+
 const string FilesProcess::READ_HELP = HELP(
     TLDR(
         "Reads data from a file."),
@@ -280,7 +351,11 @@ const string FilesProcess::READ_HELP = HELP(
         ">        path=VALUE          The path of directory to browse.",
         ">        offset=VALUE        Value added to base address to obtain "
         "a second address",
-        ">        length=VALUE        Length of file to read."));
+        ">        length=VALUE        Length of file to read.",
+        ">        follow=true         Wait for data if there is none at",
+        ">                            the offset yet.",
+        ">        timeout=VALUE       How long to wait for data when",
+        ">                            following the file, e.g., 10secs."));
 
 
 Future<Response> FilesProcess::read(const Request& request)
@@ -316,6 +391,24 @@ Future<Response> FilesProcess::read(const Request& request)
     length = result.get();
   }
 
+  Option<Duration> follow;
+
+  if (request.url.query.get("follow") == Option<string>("true")) {
+    follow = DEFAULT_FOLLOW_TIMEOUT;
+
+    if (request.url.query.get("timeout").isSome()) {
+      Try<Duration> timeout =
+        Duration::parse(request.url.query.get("timeout").get());
+
+      if (timeout.isError()) {
+        return BadRequest(
+            "Failed to parse timeout: " + timeout.error() + ".\n");
+      }
+
+      follow = std::min(timeout.get(), MAX_FOLLOW_TIMEOUT);
+    }
+  }
+
   Result<string> resolvedPath = resolve(path.get());
 
   if (resolvedPath.isError()) {
@@ -329,13 +422,107 @@ Future<Response> FilesProcess::read(const Request& request)
     return BadRequest("Cannot read a directory.\n");
   }
 
+  // Compressed files (e.g., rotated container logs) are read at their
+  // uncompressed offsets. They are not appended to, hence there is no
+  // need to follow them.
+  if (os::exists(resolvedPath.get() + files::INDEX_SUFFIX)) {
+    return readCompressed(
+        resolvedPath.get(),
+        offset,
+        length,
+        request.url.query.get("jsonp"));
+  }
+
+  return _read(
+      resolvedPath.get(),
+      offset,
+      length,
+      request.url.query.get("jsonp"),
+      follow);
+}
+
+
+// Returns once the size of the file at 'path' differs from 'size',
+// or once 'timeout' has elapsed.
+static Future<Nothing> poll(
+    const string& path,
+    off_t size,
+    const Timeout& timeout)
+{
+  Try<Bytes> current = os::stat::size(path);
+  if (current.isError() ||
+      current.get() != Bytes(size) ||
+      timeout.expired()) {
+    return Nothing();
+  }
+
+  Owned<Promise<Nothing>> promise(new Promise<Nothing>());
+
+  Clock::timer(
+      std::min(FOLLOW_POLL_INTERVAL, timeout.remaining()),
+      [=]() { promise->associate(poll(path, size, timeout)); });
+
+  return promise->future();
+}
+
+
+// Returns once the file at 'path' has been modified, or once
+// 'timeout' has elapsed. An unchanged 'size' of the file is used to
+// detect modifications that happened before the file was watched.
+static Future<Nothing> modified(
+    const string& path,
+    off_t size,
+    const Duration& timeout)
+{
+#ifdef __linux__
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    PLOG(WARNING) << "Failed to initialize inotify";
+    return poll(path, size, Timeout::in(timeout));
+  }
+
+  if (inotify_add_watch(
+          fd,
+          path.c_str(),
+          IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF) < 0) {
+    PLOG(WARNING) << "Failed to watch '" << path << "'";
+    os::close(fd);
+    return poll(path, size, Timeout::in(timeout));
+  }
+
+  Try<Bytes> current = os::stat::size(path);
+  if (current.isError() || current.get() != Bytes(size)) {
+    os::close(fd);
+    return Nothing();
+  }
+
+  return io::poll(fd, io::READ)
+    .after(timeout, [](Future<short> future) -> Future<short> {
+      future.discard();
+      return io::READ;
+    })
+    .then([]() { return Nothing(); })
+    .onAny([fd]() { os::close(fd); });
+#else
+  return poll(path, size, Timeout::in(timeout));
+#endif // __linux__
+}
+
+
+Future<Response> FilesProcess::_read(
+    const string& path,
+    off_t offset,
+    ssize_t length,
+    const Option<string>& jsonp,
+    const Option<Duration>& follow)
+{
   // TODO(benh): Cache file descriptors so we aren't constantly
   // opening them and paging the data in from disk.
-  Try<int> fd = os::open(resolvedPath.get(), O_RDONLY | O_CLOEXEC);
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
 
   if (fd.isError()) {
     string error = strings::format("Failed to open file at '%s': %s",
-        resolvedPath.get(), fd.error()).get();
+        path, fd.error()).get();
     LOG(WARNING) << error;
     return InternalServerError(error + ".\n");
   }
@@ -345,7 +532,7 @@ Future<Response> FilesProcess::read(const Request& request)
   if (size == -1) {
     string error = strings::format(
         "Failed to open file at '%s': %s",
-        resolvedPath.get(),
+        path,
         os::strerror(errno)).get();
 
     LOG(WARNING) << error;
@@ -357,27 +544,41 @@ Future<Response> FilesProcess::read(const Request& request)
     offset = size;
   }
 
+  const ssize_t requestedLength = length;
+
+  // Cap the read length at 16 pages, or at 256 pages if the client
+  // asked for more explicitly, e.g., to stream a file in fewer reads.
   if (length == -1) {
-    length = size - offset;
+    length = std::min<ssize_t>(
+        size - offset,
+        sysconf(_SC_PAGE_SIZE) * 16);
+  } else {
+    length = std::min<ssize_t>(length, sysconf(_SC_PAGE_SIZE) * 256);
   }
 
-  // Cap the read length at 16 pages.
-  length = std::min<ssize_t>(length, sysconf(_SC_PAGE_SIZE) * 16);
-
   if (offset >= size) {
     os::close(fd.get());
 
+    // Wait for the file to change once rather than letting the client
+    // poll, then read whatever is there.
+    if (follow.isSome()) {
+      return modified(path, size, follow.get())
+        .then(defer(self(), [=]() {
+          return _read(path, offset, requestedLength, jsonp, None());
+        }));
+    }
+
     JSON::Object object;
     object.values["offset"] = size;
     object.values["data"] = "";
-    return OK(object, request.url.query.get("jsonp"));
+    return OK(object, jsonp);
   }
 
   // Seek to the offset we want to read from.
   if (lseek(fd.get(), offset, SEEK_SET) == -1) {
     string error = strings::format(
         "Failed to seek file at '%s': %s",
-        resolvedPath.get(),
+        path,
         os::strerror(errno)).get();
 
     LOG(WARNING) << error;
@@ -399,12 +600,12 @@ Future<Response> FilesProcess::read(const Request& request)
 
   return io::read(fd.get(), data.get(), static_cast<size_t>(length))
     .then(lambda::bind(
-        _read,
+        __read,
         fd.get(),
         lambda::_1,
         offset,
         data,
-        request.url.query.get("jsonp")))
+        jsonp))
     .onAny(lambda::bind(&os::close, fd.get()));
 }
 
@@ -35,6 +35,7 @@
 #include <stout/os/shell.hpp>
 
 #include "hdfs/hdfs.hpp"
+#include "hdfs/webhdfs.hpp"
 
 using namespace process;
 
@@ -94,8 +95,28 @@ static Future<CommandResult> result(const Subprocess& s)
 }
 
 
-Try<Owned<HDFS>> HDFS::create(const Option<string>& _hadoop)
+Try<Owned<HDFS>> HDFS::create(
+    const Option<string>& _hadoop,
+    const Option<string>& webhdfs)
 {
+  if (webhdfs.isSome()) {
+    Try<http::URL> namenode = http::URL::parse(webhdfs.get());
+    if (namenode.isError()) {
+      return Error(
+          "Failed to parse the WebHDFS address '" + webhdfs.get() + "': " +
+          namenode.error());
+    }
+
+    const Option<string>& scheme = namenode.get().scheme;
+    if (scheme != string("http") && scheme != string("https")) {
+      return Error(
+          "Unsupported scheme of the WebHDFS address '" + webhdfs.get() + "'");
+    }
+
+    return Owned<HDFS>(
+        new HDFS(namenode.get(), os::getenv("HADOOP_USER_NAME")));
+  }
+
   // Determine the hadoop client to use. If the user has specified
   // it, use it. If not, look for environment variable HADOOP_HOME. If
   // the environment variable is not set, assume it's on the PATH.
@@ -139,6 +160,10 @@ static string normalize(const string& hdfsPath)
 
 Future<bool> HDFS::exists(const string& path)
 {
+  if (namenode.isSome()) {
+    return webhdfs::exists(namenode.get(), user, path);
+  }
+
   Try<Subprocess> s = subprocess(
       hadoop,
       {"hadoop", "fs", "-test", "-e", normalize(path)},
@@ -176,6 +201,10 @@ Future<bool> HDFS::exists(const string& path)
 
 Future<Bytes> HDFS::du(const string& _path)
 {
+  if (namenode.isSome()) {
+    return webhdfs::du(namenode.get(), user, _path);
+  }
+
   const string path = normalize(_path);
 
   Try<Subprocess> s = subprocess(
@@ -231,6 +260,10 @@ Future<Bytes> HDFS::du(const string& _path)
 
 Future<Nothing> HDFS::rm(const string& path)
 {
+  if (namenode.isSome()) {
+    return webhdfs::rm(namenode.get(), user, path);
+  }
+
   Try<Subprocess> s = subprocess(
       hadoop,
       {"hadoop", "fs", "-rm", normalize(path)},
@@ -267,6 +300,10 @@ Future<Nothing> HDFS::copyFromLocal(const string& from, const string& to)
     return Failure("Failed to find '" + from + "'");
   }
 
+  if (namenode.isSome()) {
+    return webhdfs::copyFromLocal(namenode.get(), user, from, to);
+  }
+
   Try<Subprocess> s = subprocess(
       hadoop,
       {"hadoop", "fs", "-copyFromLocal", from, normalize(to)},
@@ -299,6 +336,10 @@ Future<Nothing> HDFS::copyFromLocal(const string& from, const string& to)
 
 Future<Nothing> HDFS::copyToLocal(const string& from, const string& to)
 {
+  if (namenode.isSome()) {
+    return webhdfs::copyToLocal(namenode.get(), user, from, to);
+  }
+
   Try<Subprocess> s = subprocess(
       hadoop,
       {"hadoop", "fs", "-copyToLocal", normalize(from), to},
@@ -20,6 +20,7 @@
 #include <string>
 
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/owned.hpp>
 
 #include <stout/bytes.hpp>
@@ -46,8 +47,14 @@
 class HDFS
 {
 public:
+  // Creates a client which runs the 'hadoop' command, unless the
+  // address of the WebHDFS REST API of the namenode is given (e.g.,
+  // 'http://namenode:50070'), in which case the client talks to the
+  // namenode directly (see hdfs/webhdfs.hpp). Like the 'hadoop'
+  // command, that client uses 'HADOOP_USER_NAME' as the user.
   static Try<process::Owned<HDFS>> create(
-      const Option<std::string>& hadoop = None());
+      const Option<std::string>& hadoop = None(),
+      const Option<std::string>& webhdfs = None());
 
   process::Future<bool> exists(const std::string& path);
   process::Future<Bytes> du(const std::string& path);
@@ -65,7 +72,14 @@ private:
   explicit HDFS(const std::string& _hadoop)
     : hadoop(_hadoop) {}
 
+  HDFS(const process::http::URL& _namenode, const Option<std::string>& _user)
+    : namenode(_namenode), user(_user) {}
+
   const std::string hadoop;
+
+  // Set for a WebHDFS client.
+  const Option<process::http::URL> namenode;
+  const Option<std::string> user;
 };
 
 #endif // __HDFS_HPP__
@@ -0,0 +1,427 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <process/async.hpp>
+#include <process/collect.hpp>
+#include <process/http.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/error.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "hdfs/webhdfs.hpp"
+
+using namespace process;
+
+using process::http::Response;
+using process::http::URL;
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace webhdfs {
+
+// The files are read in ranges of 'RANGE_SIZE' and 'PARALLEL_READS'
+// of them are read at the same time, which bounds the memory used by
+// a copy.
+static const Bytes RANGE_SIZE = Megabytes(16);
+static const size_t PARALLEL_READS = 4;
+
+
+// Returns the path of an HDFS path or URI, i.e., strips the scheme
+// and the authority of 'hdfs://host:port/path'.
+static string pathOf(const string& hdfsPath)
+{
+  const size_t scheme = hdfsPath.find("://");
+  if (scheme == string::npos) {
+    return strings::startsWith(hdfsPath, "/") ? hdfsPath : "/" + hdfsPath;
+  }
+
+  const size_t path = hdfsPath.find('/', scheme + 3);
+  return path == string::npos ? "/" : hdfsPath.substr(path);
+}
+
+
+static URL url(
+    const URL& namenode,
+    const Option<string>& user,
+    const string& path,
+    const string& op,
+    const hashmap<string, string>& parameters = hashmap<string, string>())
+{
+  URL url = namenode;
+  url.path = "/webhdfs/v1" + pathOf(path);
+  url.query = parameters;
+  url.query["op"] = op;
+
+  if (user.isSome()) {
+    url.query["user.name"] = user.get();
+  }
+
+  return url;
+}
+
+
+// Returns a failure for an unexpected response, with the message of
+// the 'RemoteException' that WebHDFS returns if there is one.
+static Failure failure(const string& operation, const Response& response)
+{
+  string message = response.status;
+
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(response.body);
+  if (object.isSome()) {
+    Result<JSON::String> exception =
+      object.get().find<JSON::String>("RemoteException.message");
+
+    if (exception.isSome()) {
+      message += ": " + exception.get().value;
+    }
+  }
+
+  return Failure("Failed to " + operation + ": " + message);
+}
+
+
+// Returns the URL of the datanode that a namenode redirects to.
+static Try<URL> location(const Response& response)
+{
+  Option<string> location = response.headers.get("Location");
+  if (location.isNone()) {
+    return Error("Redirect without a 'Location' header");
+  }
+
+  // NOTE: 'URL::parse' does not parse the query.
+  const vector<string> parts = strings::split(location.get(), "?", 2);
+
+  Try<URL> url = URL::parse(parts[0]);
+  if (url.isError()) {
+    return Error(
+        "Failed to parse location '" + location.get() + "': " + url.error());
+  }
+
+  if (parts.size() == 2) {
+    Try<hashmap<string, string>> query = http::query::decode(parts[1]);
+    if (query.isError()) {
+      return Error(
+          "Failed to parse location '" + location.get() + "': " +
+          query.error());
+    }
+
+    url.get().query = query.get();
+  }
+
+  return url.get();
+}
+
+
+// Sends a GET request to the namenode, and to the datanode it
+// redirects to (for reads).
+static Future<Response> follow(const URL& url)
+{
+  return http::get(url)
+    .then([](const Response& response) -> Future<Response> {
+      if (response.code != http::Status::TEMPORARY_REDIRECT) {
+        return response;
+      }
+
+      Try<URL> datanode = location(response);
+      if (datanode.isError()) {
+        return Failure(datanode.error());
+      }
+
+      return http::get(datanode.get());
+    });
+}
+
+
+// Sends a PUT request, which libprocess only provides through a
+// connection of its own.
+static Future<Response> put(const URL& url, const string& body)
+{
+  http::Request request;
+  request.method = "PUT";
+  request.url = url;
+  request.body = body;
+  request.keepAlive = false;
+  request.headers["Content-Type"] = "application/octet-stream";
+
+  return http::connect(url)
+    .then([request](http::Connection connection) {
+      Future<Response> response = connection.send(request);
+
+      // The connection closes after the response. Keep a copy until
+      // then, which is deleted from 'async' since the disconnection
+      // is completed from the execution context of the connection.
+      http::Connection* copy = new http::Connection(std::move(connection));
+      auto deleter = [copy]() { delete copy; };
+
+      copy->disconnected()
+        .onAny([=]() { async(deleter); });
+
+      return response;
+    });
+}
+
+
+static Future<JSON::Object> status(
+    const URL& namenode,
+    const Option<string>& user,
+    const string& path)
+{
+  return follow(url(namenode, user, path, "GETFILESTATUS"))
+    .then([path](const Response& response) -> Future<JSON::Object> {
+      if (response.code != http::Status::OK) {
+        return failure("get the status of '" + path + "'", response);
+      }
+
+      Try<JSON::Object> object = JSON::parse<JSON::Object>(response.body);
+      if (object.isError()) {
+        return Failure(
+            "Failed to parse the status of '" + path + "': " +
+            object.error());
+      }
+
+      return object.get();
+    });
+}
+
+
+Future<bool> exists(
+    const URL& namenode,
+    const Option<string>& user,
+    const string& path)
+{
+  return follow(url(namenode, user, path, "GETFILESTATUS"))
+    .then([path](const Response& response) -> Future<bool> {
+      if (response.code == http::Status::OK) {
+        return true;
+      } else if (response.code == http::Status::NOT_FOUND) {
+        return false;
+      }
+
+      return failure("check whether '" + path + "' exists", response);
+    });
+}
+
+
+Future<Bytes> du(
+    const URL& namenode,
+    const Option<string>& user,
+    const string& path)
+{
+  return follow(url(namenode, user, path, "GETCONTENTSUMMARY"))
+    .then([path](const Response& response) -> Future<Bytes> {
+      if (response.code != http::Status::OK) {
+        return failure("get the size of '" + path + "'", response);
+      }
+
+      Try<JSON::Object> object = JSON::parse<JSON::Object>(response.body);
+      if (object.isError()) {
+        return Failure(
+            "Failed to parse the content summary of '" + path + "': " +
+            object.error());
+      }
+
+      Result<JSON::Number> length =
+        object.get().find<JSON::Number>("ContentSummary.length");
+
+      if (!length.isSome()) {
+        return Failure(
+            "Unexpected content summary of '" + path + "': " +
+            response.body);
+      }
+
+      return Bytes(length.get().as<uint64_t>());
+    });
+}
+
+
+Future<Nothing> rm(
+    const URL& namenode,
+    const Option<string>& user,
+    const string& path)
+{
+  return http::requestDelete(url(namenode, user, path, "DELETE"))
+    .then([path](const Response& response) -> Future<Nothing> {
+      if (response.code != http::Status::OK) {
+        return failure("remove '" + path + "'", response);
+      }
+
+      Try<JSON::Object> object = JSON::parse<JSON::Object>(response.body);
+      if (object.isError()) {
+        return Failure("Failed to parse the result: " + object.error());
+      }
+
+      Result<JSON::Boolean> deleted =
+        object.get().find<JSON::Boolean>("boolean");
+      if (!deleted.isSome() || !deleted.get().value) {
+        return Failure("Failed to remove '" + path + "'");
+      }
+
+      return Nothing();
+    });
+}
+
+
+Future<Nothing> copyFromLocal(
+    const URL& namenode,
+    const Option<string>& user,
+    const string& from,
+    const string& to)
+{
+  Try<string> data = os::read(from);
+  if (data.isError()) {
+    return Failure("Failed to read '" + from + "': " + data.error());
+  }
+
+  // The namenode redirects the creation of the file to a datanode,
+  // which the data is sent to.
+  return put(url(namenode, user, to, "CREATE", {{"overwrite", "false"}}), "")
+    .then([=](const Response& response) -> Future<Response> {
+      if (response.code != http::Status::TEMPORARY_REDIRECT) {
+        return failure("create '" + to + "'", response);
+      }
+
+      Try<URL> datanode = location(response);
+      if (datanode.isError()) {
+        return Failure(datanode.error());
+      }
+
+      return put(datanode.get(), data.get());
+    })
+    .then([to](const Response& response) -> Future<Nothing> {
+      if (response.code != http::Status::CREATED) {
+        return failure("write '" + to + "'", response);
+      }
+
+      return Nothing();
+    });
+}
+
+
+// Reads the ranges 'index', 'index + PARALLEL_READS', and so on, of
+// the file into 'fd', one after the other.
+static Future<Nothing> copyRanges(
+    const URL& namenode,
+    const Option<string>& user,
+    const string& path,
+    int fd,
+    uint64_t size,
+    uint64_t index)
+{
+  const uint64_t offset = index * RANGE_SIZE.bytes();
+  if (offset >= size) {
+    return Nothing();
+  }
+
+  const uint64_t length = std::min(RANGE_SIZE.bytes(), size - offset);
+
+  hashmap<string, string> range;
+  range["offset"] = stringify(offset);
+  range["length"] = stringify(length);
+
+  return follow(url(namenode, user, path, "OPEN", range))
+    .then([=](const Response& response) -> Future<Nothing> {
+      if (response.code != http::Status::OK) {
+        return failure("read '" + path + "'", response);
+      }
+
+      if (response.body.size() != length) {
+        return Failure(
+            "Failed to read '" + path + "': expected " + stringify(length) +
+            " bytes at offset " + stringify(offset) + " but got " +
+            stringify(response.body.size()));
+      }
+
+      // The ranges are disjoint, so they can be written concurrently.
+      size_t written = 0;
+      while (written < length) {
+        ssize_t n = ::pwrite(
+            fd,
+            response.body.data() + written,
+            length - written,
+            offset + written);
+
+        if (n < 0 && errno == EINTR) {
+          continue;
+        } else if (n < 0) {
+          return Failure(ErrnoError("Failed to write '" + path + "'"));
+        }
+
+        written += n;
+      }
+
+      return copyRanges(
+          namenode, user, path, fd, size, index + PARALLEL_READS);
+    });
+}
+
+
+Future<Nothing> copyToLocal(
+    const URL& namenode,
+    const Option<string>& user,
+    const string& from,
+    const string& to)
+{
+  return status(namenode, user, from)
+    .then([=](const JSON::Object& object) -> Future<Nothing> {
+      Result<JSON::Number> length =
+        object.find<JSON::Number>("FileStatus.length");
+
+      if (!length.isSome()) {
+        return Failure("Unexpected status of '" + from + "'");
+      }
+
+      const uint64_t size = length.get().as<uint64_t>();
+
+      Try<int> fd = os::open(
+          to,
+          O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+      if (fd.isError()) {
+        return Failure("Failed to open '" + to + "': " + fd.error());
+      }
+
+      list<Future<Nothing>> reads;
+      for (size_t i = 0; i < PARALLEL_READS; i++) {
+        reads.push_back(copyRanges(namenode, user, from, fd.get(), size, i));
+      }
+
+      const int _fd = fd.get();
+
+      return collect(reads)
+        .onAny([_fd]() { os::close(_fd); })
+        .then([]() { return Nothing(); });
+    });
+}
+
+} // namespace webhdfs {
@@ -0,0 +1,70 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __HDFS_WEBHDFS_HPP__
+#define __HDFS_WEBHDFS_HPP__
+
+#include <string>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+
+// The operations of the 'HDFS' client implemented with the WebHDFS
+// REST API of the namenode (see hadoop-hdfs/WebHDFS.html in the
+// Hadoop documentation) instead of the 'hadoop' command, which starts
+// a JVM for every operation. The requests are sent over the pooled
+// (persistent) connections of libprocess, and files are read from the
+// datanodes with several range requests in parallel.
+//
+// The paths are either absolute paths or URIs, whose scheme and
+// authority are ignored: the operations go to 'namenode'. If 'user'
+// is set, it is sent as the 'user.name' of the requests.
+namespace webhdfs {
+
+process::Future<bool> exists(
+    const process::http::URL& namenode,
+    const Option<std::string>& user,
+    const std::string& path);
+
+process::Future<Bytes> du(
+    const process::http::URL& namenode,
+    const Option<std::string>& user,
+    const std::string& path);
+
+process::Future<Nothing> rm(
+    const process::http::URL& namenode,
+    const Option<std::string>& user,
+    const std::string& path);
+
+process::Future<Nothing> copyFromLocal(
+    const process::http::URL& namenode,
+    const Option<std::string>& user,
+    const std::string& from,
+    const std::string& to);
+
+process::Future<Nothing> copyToLocal(
+    const process::http::URL& namenode,
+    const Option<std::string>& user,
+    const std::string& from,
+    const std::string& to);
+
+} // namespace webhdfs {
+
+#endif // __HDFS_WEBHDFS_HPP__
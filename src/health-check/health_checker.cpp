@@ -0,0 +1,362 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <signal.h>
+#include <stdlib.h> // For random().
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/process.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/ip.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "common/status_utils.hpp"
+
+#include "health-check/health_checker.hpp"
+
+#include "messages/messages.hpp"
+
+using process::delay;
+using process::dispatch;
+using process::Clock;
+using process::Failure;
+using process::Future;
+using process::Owned;
+using process::Subprocess;
+using process::UPID;
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+
+Try<Owned<HealthChecker>> HealthChecker::create(
+    const HealthCheck& check,
+    const UPID& executor,
+    const TaskID& taskID)
+{
+  if (check.has_http() && check.has_command()) {
+    return Error("Both 'http' and 'command' health check requested");
+  }
+
+  if (!check.has_http() && !check.has_command()) {
+    return Error("Expecting one of 'http' or 'command' health check");
+  }
+
+  Owned<HealthCheckerProcess> process(
+      new HealthCheckerProcess(check, executor, taskID));
+
+  return Owned<HealthChecker>(new HealthChecker(process));
+}
+
+
+HealthChecker::HealthChecker(Owned<HealthCheckerProcess> _process)
+  : process(_process)
+{
+  spawn(CHECK_NOTNULL(process.get()));
+}
+
+
+HealthChecker::~HealthChecker()
+{
+  terminate(process.get());
+  wait(process.get());
+}
+
+
+Future<Nothing> HealthChecker::healthCheck()
+{
+  return dispatch(process.get(), &HealthCheckerProcess::healthCheck);
+}
+
+
+HealthCheckerProcess::HealthCheckerProcess(
+    const HealthCheck& _check,
+    const UPID& _executor,
+    const TaskID& _taskID)
+  : check(_check),
+    initializing(true),
+    executor(_executor),
+    taskID(_taskID),
+    consecutiveFailures(0) {}
+
+
+Future<Nothing> HealthCheckerProcess::healthCheck()
+{
+  // The first check is delayed by up to a tenth of the interval, so
+  // that the checks of the tasks which are launched together (e.g.,
+  // by the same framework) are spread out rather than all done at
+  // the same time.
+  const Duration jitter =
+    Seconds(check.interval_seconds()) * 0.1 * ((double) ::random() / RAND_MAX);
+
+  VLOG(2) << "Health checks starting in "
+          << Seconds(check.delay_seconds()) + jitter << ", grace period "
+          << Seconds(check.grace_period_seconds());
+
+  startTime = Clock::now();
+
+  delay(Seconds(check.delay_seconds()) + jitter, self(), &Self::_healthCheck);
+  return promise.future();
+}
+
+
+void HealthCheckerProcess::failure(const string& message)
+{
+  if (check.grace_period_seconds() > 0 &&
+      (Clock::now() - startTime).secs() <= check.grace_period_seconds()) {
+    LOG(INFO) << "Ignoring failure as health check still in grace period";
+    reschedule();
+    return;
+  }
+
+  consecutiveFailures++;
+  VLOG(1) << "#" << consecutiveFailures << " check failed: " << message;
+
+  bool killTask = consecutiveFailures >= check.consecutive_failures();
+
+  TaskHealthStatus taskHealthStatus;
+  taskHealthStatus.set_healthy(false);
+  taskHealthStatus.set_consecutive_failures(consecutiveFailures);
+  taskHealthStatus.set_kill_task(killTask);
+  taskHealthStatus.mutable_task_id()->CopyFrom(taskID);
+  send(executor, taskHealthStatus);
+
+  if (killTask) {
+    promise.fail(message);
+  } else {
+    reschedule();
+  }
+}
+
+
+void HealthCheckerProcess::success()
+{
+  VLOG(1) << "Check passed";
+
+  // Send a healthy status update on the first success,
+  // and on the first success following failure(s).
+  if (initializing || consecutiveFailures > 0) {
+    TaskHealthStatus taskHealthStatus;
+    taskHealthStatus.set_healthy(true);
+    taskHealthStatus.mutable_task_id()->CopyFrom(taskID);
+    send(executor, taskHealthStatus);
+    initializing = false;
+  }
+  consecutiveFailures = 0;
+  reschedule();
+}
+
+
+void HealthCheckerProcess::_healthCheck()
+{
+  if (check.has_http()) {
+    _httpHealthCheck();
+  } else if (check.has_command()) {
+    _commandHealthCheck();
+  } else {
+    promise.fail("No check found in health check");
+  }
+}
+
+
+void HealthCheckerProcess::_commandHealthCheck()
+{
+  const CommandInfo& command = check.command();
+
+  map<string, string> environment = os::environment();
+
+  foreach (const Environment::Variable& variable,
+           command.environment().variables()) {
+    environment[variable.name()] = variable.value();
+  }
+
+  // Launch the subprocess.
+  Option<Try<Subprocess>> external = None();
+
+  if (command.shell()) {
+    // Use the shell variant.
+    if (!command.has_value()) {
+      promise.fail("Shell command is not specified");
+      return;
+    }
+
+    VLOG(2) << "Launching health command '" << command.value() << "'";
+
+    external = process::subprocess(
+        command.value(),
+        Subprocess::PATH("/dev/null"),
+        Subprocess::FD(STDERR_FILENO),
+        Subprocess::FD(STDERR_FILENO),
+        environment);
+  } else {
+    // Use the exec variant.
+    if (!command.has_value()) {
+      promise.fail("Executable path is not specified");
+      return;
+    }
+
+    vector<string> argv;
+    foreach (const string& arg, command.arguments()) {
+      argv.push_back(arg);
+    }
+
+    VLOG(2) << "Launching health command [" << command.value() << ", "
+            << strings::join(", ", argv) << "]";
+
+    external = process::subprocess(
+        command.value(),
+        argv,
+        Subprocess::PATH("/dev/null"),
+        Subprocess::FD(STDERR_FILENO),
+        Subprocess::FD(STDERR_FILENO),
+        None(),
+        environment);
+  }
+
+  CHECK_SOME(external);
+
+  if (external.get().isError()) {
+    failure("Error creating subprocess for healthcheck: " +
+            external.get().error());
+    return;
+  }
+
+  const Duration timeout = Seconds(check.timeout_seconds());
+
+  // Wait for the command without blocking this process, so that the
+  // checks of other tasks done by the same executor are not held up.
+  external.get().get().status()
+    .after(timeout, [timeout](const Future<Option<int>>&) {
+      return Failure("status still pending after timeout " +
+                     stringify(timeout));
+    })
+    .onAny(defer(self(),
+                 &Self::__commandHealthCheck,
+                 external.get().get().pid(),
+                 lambda::_1));
+}
+
+
+void HealthCheckerProcess::__commandHealthCheck(
+    pid_t pid,
+    const Future<Option<int>>& status)
+{
+  if (!status.isReady() || status.get().isNone()) {
+    string msg = "Command check failed with reason: ";
+    if (status.isFailed()) {
+      msg += "failed with error: " + status.failure();
+    } else if (status.isDiscarded()) {
+      msg += "status future discarded";
+    } else {
+      msg += "unknown exit status";
+    }
+
+    if (pid != -1) {
+      // Cleanup the external command process.
+      os::killtree(pid, SIGKILL);
+      VLOG(1) << "Kill health check command " << pid;
+    }
+
+    failure(msg);
+    return;
+  }
+
+  int statusCode = status.get().get();
+  if (statusCode != 0) {
+    string message = "Health command check " + WSTRINGIFY(statusCode);
+    failure(message);
+  } else {
+    success();
+  }
+}
+
+
+void HealthCheckerProcess::_httpHealthCheck()
+{
+  const HealthCheck::HTTP& http = check.http();
+
+  // NOTE: The task is checked on the loopback interface, i.e., in the
+  // network namespace of the executor, which is the one of the task.
+  Try<net::IP> ip = net::IP::parse("127.0.0.1", AF_INET);
+  CHECK_SOME(ip);
+
+  const process::http::URL url("http", ip.get(), http.port(), http.path());
+
+  VLOG(2) << "Sending health check request to " << url;
+
+  const Duration timeout = Seconds(check.timeout_seconds());
+
+  process::http::get(url)
+    .after(timeout, [timeout](const Future<process::http::Response>&) {
+      return Failure("no response after timeout " + stringify(timeout));
+    })
+    .onAny(defer(self(), &Self::__httpHealthCheck, lambda::_1));
+}
+
+
+void HealthCheckerProcess::__httpHealthCheck(
+    const Future<process::http::Response>& response)
+{
+  if (!response.isReady()) {
+    failure("HTTP check failed with reason: " +
+            (response.isFailed() ? response.failure()
+                                 : "response future discarded"));
+    return;
+  }
+
+  // Any status is acceptable if none are specified.
+  if (check.http().statuses_size() == 0) {
+    success();
+    return;
+  }
+
+  foreach (uint32_t status, check.http().statuses()) {
+    if (status == response.get().code) {
+      success();
+      return;
+    }
+  }
+
+  failure("HTTP check returned unexpected status " + response.get().status);
+}
+
+
+void HealthCheckerProcess::reschedule()
+{
+  VLOG(1) << "Rescheduling health check in "
+          << Seconds(check.interval_seconds());
+
+  delay(Seconds(check.interval_seconds()), self(), &Self::_healthCheck);
+}
+
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,110 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __HEALTH_CHECKER_HPP__
+#define __HEALTH_CHECKER_HPP__
+
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+#include <process/protobuf.hpp>
+#include <process/subprocess.hpp>
+#include <process/time.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+
+// Forward declarations.
+class HealthCheckerProcess;
+
+// Checks the health of a task and sends the results to its executor
+// as 'TaskHealthStatus' messages. Since the checks are done by a
+// libprocess process, they can be done by the executor itself rather
+// than by a 'mesos-health-check' process per task. The HTTP checks
+// are done with (asynchronous) libprocess sockets, the command checks
+// run the command in a subprocess.
+class HealthChecker
+{
+public:
+  static Try<process::Owned<HealthChecker>> create(
+      const HealthCheck& check,
+      const process::UPID& executor,
+      const TaskID& taskID);
+
+  ~HealthChecker();
+
+  // Starts checking the health of the task. The future fails once
+  // the task should be killed (after 'consecutive_failures' failed
+  // checks), or if the task can not be checked.
+  process::Future<Nothing> healthCheck();
+
+private:
+  explicit HealthChecker(process::Owned<HealthCheckerProcess> process);
+
+  process::Owned<HealthCheckerProcess> process;
+};
+
+
+class HealthCheckerProcess : public ProtobufProcess<HealthCheckerProcess>
+{
+public:
+  HealthCheckerProcess(
+      const HealthCheck& _check,
+      const process::UPID& _executor,
+      const TaskID& _taskID);
+
+  virtual ~HealthCheckerProcess() {}
+
+  process::Future<Nothing> healthCheck();
+
+private:
+  void failure(const std::string& message);
+  void success();
+
+  void _healthCheck();
+
+  void _commandHealthCheck();
+  void __commandHealthCheck(
+      pid_t pid,
+      const process::Future<Option<int>>& status);
+
+  void _httpHealthCheck();
+  void __httpHealthCheck(const process::Future<process::http::Response>&);
+
+  void reschedule();
+
+  process::Promise<Nothing> promise;
+  HealthCheck check;
+  bool initializing;
+  process::UPID executor;
+  TaskID taskID;
+  uint32_t consecutiveFailures;
+  process::Time startTime;
+};
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __HEALTH_CHECKER_HPP__
@@ -14,8 +14,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <mesos/hook.hpp>
@@ -33,7 +36,9 @@
 #include "module/manager.hpp"
 
 using std::map;
+using std::pair;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 
 using mesos::modules::ModuleManager;
@@ -41,9 +46,49 @@ using mesos::modules::ModuleManager;
 namespace mesos {
 namespace internal {
 
+// The loaded hooks, in the order in which they were loaded.
+typedef vector<pair<string, Hook*>> Hooks;
+
 static std::mutex mutex;
 static LinkedHashMap<string, Hook*> availableHooks;
 
+// An immutable snapshot of 'availableHooks' (or NULL when no hooks are
+// loaded) which is replaced as a whole whenever a hook is loaded or
+// unloaded, so that the hooks can be run without holding 'mutex'.
+static std::atomic<const Hooks*> snapshot(NULL);
+
+// All the snapshots ever published. They are kept since some hooks
+// might still run on a replaced snapshot, and hooks are only loaded
+// and unloaded on startup (and in tests) anyway.
+static vector<unique_ptr<const Hooks>> snapshots;
+
+
+// Publishes a new snapshot of 'availableHooks'.
+// NOTE: Expects 'mutex' to be held.
+static void publish()
+{
+  if (availableHooks.empty()) {
+    snapshot.store(NULL, std::memory_order_release);
+    return;
+  }
+
+  Hooks* hooks = new Hooks();
+  foreach (const string& name, availableHooks.keys()) {
+    hooks->push_back(std::make_pair(name, availableHooks[name]));
+  }
+
+  snapshots.push_back(unique_ptr<const Hooks>(hooks));
+  snapshot.store(hooks, std::memory_order_release);
+}
+
+
+// Returns the current snapshot of the loaded hooks, or NULL if there
+// are none.
+static const Hooks* loaded()
+{
+  return snapshot.load(std::memory_order_acquire);
+}
+
 
 Try<Nothing> HookManager::initialize(const string& hookList)
 {
@@ -68,6 +113,7 @@ Try<Nothing> HookManager::initialize(const string& hookList)
 
       // Add the hook module to the list of available hooks.
       availableHooks[hook] = module.get();
+      publish();
     }
   }
 
@@ -85,6 +131,7 @@ Try<Nothing> HookManager::unload(const std::string& hookName)
 
     // Now remove the hook from the list of available hooks.
     availableHooks.erase(hookName);
+    publish();
   }
 
   return Nothing();
@@ -93,9 +140,7 @@ Try<Nothing> HookManager::unload(const std::string& hookName)
 
 bool HookManager::hooksAvailable()
 {
-  synchronized (mutex) {
-    return !availableHooks.empty();
-  }
+  return loaded() != NULL;
 }
 
 
@@ -104,39 +149,45 @@ Labels HookManager::masterLaunchTaskLabelDecorator(
     const FrameworkInfo& frameworkInfo,
     const SlaveInfo& slaveInfo)
 {
-  synchronized (mutex) {
-    // We need a mutable copy of the task info and set the new
-    // labels after each hook invocation. Otherwise, the last hook
-    // will be the only effective hook setting the labels.
-    TaskInfo taskInfo_ = taskInfo;
-
-    foreach (const string& name, availableHooks.keys()) {
-      Hook* hook = availableHooks[name];
-      const Result<Labels> result =
-        hook->masterLaunchTaskLabelDecorator(
-            taskInfo_,
-            frameworkInfo,
-            slaveInfo);
-
-      // NOTE: If the hook returns None(), the task labels won't be
-      // changed.
-      if (result.isSome()) {
-        taskInfo_.mutable_labels()->CopyFrom(result.get());
-      } else if (result.isError()) {
-        LOG(WARNING) << "Master label decorator hook failed for module '"
-                    << name << "': " << result.error();
-      }
-    }
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
+    return taskInfo.labels();
+  }
 
-    return taskInfo_.labels();
+  // We need a mutable copy of the task info and set the new
+  // labels after each hook invocation. Otherwise, the last hook
+  // will be the only effective hook setting the labels.
+  TaskInfo taskInfo_ = taskInfo;
+
+  foreachpair (const string& name, Hook* hook, *hooks) {
+    const Result<Labels> result =
+      hook->masterLaunchTaskLabelDecorator(
+          taskInfo_,
+          frameworkInfo,
+          slaveInfo);
+
+    // NOTE: If the hook returns None(), the task labels won't be
+    // changed.
+    if (result.isSome()) {
+      taskInfo_.mutable_labels()->CopyFrom(result.get());
+    } else if (result.isError()) {
+      LOG(WARNING) << "Master label decorator hook failed for module '"
+                  << name << "': " << result.error();
+    }
   }
+
+  return taskInfo_.labels();
 }
 
 
 void HookManager::masterSlaveLostHook(const SlaveInfo& slaveInfo)
 {
-  foreach (const string& name, availableHooks.keys()) {
-    Hook* hook = availableHooks[name];
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
+    return;
+  }
+
+  foreachpair (const string& name, Hook* hook, *hooks) {
     Try<Nothing> result = hook->masterSlaveLostHook(slaveInfo);
     if (result.isError()) {
       LOG(WARNING) << "Master slave-lost hook failed for module '"
@@ -152,51 +203,55 @@ Labels HookManager::slaveRunTaskLabelDecorator(
     const FrameworkInfo& frameworkInfo,
     const SlaveInfo& slaveInfo)
 {
-  synchronized (mutex) {
-    TaskInfo taskInfo_ = taskInfo;
-
-    foreach (const string& name, availableHooks.keys()) {
-      Hook* hook = availableHooks[name];
-      const Result<Labels> result = hook->slaveRunTaskLabelDecorator(
-          taskInfo_, executorInfo, frameworkInfo, slaveInfo);
-
-      // NOTE: If the hook returns None(), the task labels won't be
-      // changed.
-      if (result.isSome()) {
-        taskInfo_.mutable_labels()->CopyFrom(result.get());
-      } else if (result.isError()) {
-        LOG(WARNING) << "Slave label decorator hook failed for module '"
-                    << name << "': " << result.error();
-      }
-    }
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
+    return taskInfo.labels();
+  }
+
+  TaskInfo taskInfo_ = taskInfo;
 
-    return taskInfo_.labels();
+  foreachpair (const string& name, Hook* hook, *hooks) {
+    const Result<Labels> result = hook->slaveRunTaskLabelDecorator(
+        taskInfo_, executorInfo, frameworkInfo, slaveInfo);
+
+    // NOTE: If the hook returns None(), the task labels won't be
+    // changed.
+    if (result.isSome()) {
+      taskInfo_.mutable_labels()->CopyFrom(result.get());
+    } else if (result.isError()) {
+      LOG(WARNING) << "Slave label decorator hook failed for module '"
+                  << name << "': " << result.error();
+    }
   }
+
+  return taskInfo_.labels();
 }
 
 
 Environment HookManager::slaveExecutorEnvironmentDecorator(
     ExecutorInfo executorInfo)
 {
-  synchronized (mutex) {
-    foreach (const string& name, availableHooks.keys()) {
-      Hook* hook = availableHooks[name];
-      const Result<Environment> result =
-        hook->slaveExecutorEnvironmentDecorator(executorInfo);
-
-      // NOTE: If the hook returns None(), the environment won't be
-      // changed.
-      if (result.isSome()) {
-        executorInfo.mutable_command()->mutable_environment()->CopyFrom(
-            result.get());
-      } else if (result.isError()) {
-        LOG(WARNING) << "Slave environment decorator hook failed for module '"
-                    << name << "': " << result.error();
-      }
-    }
-
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
     return executorInfo.command().environment();
   }
+
+  foreachpair (const string& name, Hook* hook, *hooks) {
+    const Result<Environment> result =
+      hook->slaveExecutorEnvironmentDecorator(executorInfo);
+
+    // NOTE: If the hook returns None(), the environment won't be
+    // changed.
+    if (result.isSome()) {
+      executorInfo.mutable_command()->mutable_environment()->CopyFrom(
+          result.get());
+    } else if (result.isError()) {
+      LOG(WARNING) << "Slave environment decorator hook failed for module '"
+                   << name << "': " << result.error();
+    }
+  }
+
+  return executorInfo.command().environment();
 }
 
 
@@ -211,8 +266,14 @@ void HookManager::slavePreLaunchDockerHook(
     const Option<Resources>& resources,
     const Option<map<string, string>>& env)
 {
-  foreach (const string& name, availableHooks.keys()) {
-    Hook* hook = availableHooks[name];
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
+    return;
+  }
+
+  // NOTE: The name of the hook must not shadow the name of the
+  // container, which is the one passed to the hooks.
+  foreachpair (const string& module, Hook* hook, *hooks) {
     Try<Nothing> result =
       hook->slavePreLaunchDockerHook(
           containerInfo,
@@ -226,7 +287,7 @@ void HookManager::slavePreLaunchDockerHook(
           env);
     if (result.isError()) {
       LOG(WARNING) << "Slave pre launch docker hook failed for module '"
-                   << name << "': " << result.error();
+                   << module << "': " << result.error();
     }
   }
 }
@@ -236,8 +297,12 @@ void HookManager::slaveRemoveExecutorHook(
     const FrameworkInfo& frameworkInfo,
     const ExecutorInfo& executorInfo)
 {
-  foreach (const string& name, availableHooks.keys()) {
-    Hook* hook = availableHooks[name];
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
+    return;
+  }
+
+  foreachpair (const string& name, Hook* hook, *hooks) {
     const Try<Nothing> result =
       hook->slaveRemoveExecutorHook(frameworkInfo, executorInfo);
     if (result.isError()) {
@@ -252,87 +317,91 @@ TaskStatus HookManager::slaveTaskStatusDecorator(
     const FrameworkID& frameworkId,
     TaskStatus status)
 {
-  synchronized (mutex) {
-    foreach (const string& name, availableHooks.keys()) {
-      Hook* hook = availableHooks[name];
-      const Result<TaskStatus> result =
-        hook->slaveTaskStatusDecorator(frameworkId, status);
-
-      // NOTE: Labels/ContainerStatus remain unchanged if the hook returns
-      // None().
-      if (result.isSome()) {
-        if (result.get().has_labels()) {
-          status.mutable_labels()->CopyFrom(result.get().labels());
-        }
-
-        if (result.get().has_container_status()) {
-          status.mutable_container_status()->CopyFrom(
-              result.get().container_status());
-        }
-      } else if (result.isError()) {
-        LOG(WARNING) << "Slave TaskStatus decorator hook failed for "
-                     << "module '" << name << "': " << result.error();
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
+    return status;
+  }
+
+  foreachpair (const string& name, Hook* hook, *hooks) {
+    const Result<TaskStatus> result =
+      hook->slaveTaskStatusDecorator(frameworkId, status);
+
+    // NOTE: Labels/ContainerStatus remain unchanged if the hook returns
+    // None().
+    if (result.isSome()) {
+      if (result.get().has_labels()) {
+        status.mutable_labels()->CopyFrom(result.get().labels());
       }
-    }
 
-    return status;
+      if (result.get().has_container_status()) {
+        status.mutable_container_status()->CopyFrom(
+            result.get().container_status());
+      }
+    } else if (result.isError()) {
+      LOG(WARNING) << "Slave TaskStatus decorator hook failed for "
+                   << "module '" << name << "': " << result.error();
+    }
   }
+
+  return status;
 }
 
 Resources HookManager::slaveResourcesDecorator(
     const SlaveInfo& slaveInfo)
 {
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
+    return slaveInfo.resources();
+  }
+
   // We need a mutable copy of the Resources object. Each hook will see the
   // changes made by previous hooks, so the order of execution matters. The
-  // execution order is currently unspecified since availableHooks uses a
-  // hashmap.
+  // hooks are executed in the order in which they were loaded.
   SlaveInfo slaveInfo_ = slaveInfo;
 
-  synchronized (mutex) {
-    foreach (const string& name, availableHooks.keys()) {
-      Hook* hook = availableHooks[name];
-      const Result<Resources> result =
-        hook->slaveResourcesDecorator(slaveInfo_);
-
-      // NOTE: Resources remain unchanged if the hook returns None().
-      if (result.isSome()) {
-        slaveInfo_.mutable_resources()->CopyFrom(result.get());
-      } else if (result.isError()) {
-        LOG(WARNING) << "Slave Resources decorator hook failed for "
-                     << "module '" << name << "': " << result.error();
-      }
-    }
+  foreachpair (const string& name, Hook* hook, *hooks) {
+    const Result<Resources> result =
+      hook->slaveResourcesDecorator(slaveInfo_);
 
-    return slaveInfo_.resources();
+    // NOTE: Resources remain unchanged if the hook returns None().
+    if (result.isSome()) {
+      slaveInfo_.mutable_resources()->CopyFrom(result.get());
+    } else if (result.isError()) {
+      LOG(WARNING) << "Slave Resources decorator hook failed for "
+                   << "module '" << name << "': " << result.error();
+    }
   }
+
+  return slaveInfo_.resources();
 }
 
 Attributes HookManager::slaveAttributesDecorator(
     const SlaveInfo& slaveInfo)
 {
+  const Hooks* hooks = loaded();
+  if (hooks == NULL) {
+    return slaveInfo.attributes();
+  }
+
   // We need a mutable copy of the Attributes object. Each hook will see the
   // changes made by previous hooks, so the order of execution matters. The
-  // execution order is currently unspecified since availableHooks uses a
-  // hashmap.
+  // hooks are executed in the order in which they were loaded.
   SlaveInfo slaveInfo_ = slaveInfo;
 
-  synchronized (mutex) {
-    foreach (const string& name, availableHooks.keys()) {
-      Hook* hook = availableHooks[name];
-      const Result<Attributes> result =
-        hook->slaveAttributesDecorator(slaveInfo_);
-
-      // NOTE: Attributes remain unchanged if the hook returns None().
-      if (result.isSome()) {
-        slaveInfo_.mutable_attributes()->CopyFrom(result.get());
-      } else if (result.isError()) {
-        LOG(WARNING) << "Slave Attributes decorator hook failed for "
-                     << "module '" << name << "': " << result.error();
-      }
-    }
+  foreachpair (const string& name, Hook* hook, *hooks) {
+    const Result<Attributes> result =
+      hook->slaveAttributesDecorator(slaveInfo_);
 
-    return slaveInfo_.attributes();
+    // NOTE: Attributes remain unchanged if the hook returns None().
+    if (result.isSome()) {
+      slaveInfo_.mutable_attributes()->CopyFrom(result.get());
+    } else if (result.isError()) {
+      LOG(WARNING) << "Slave Attributes decorator hook failed for "
+                   << "module '" << name << "': " << result.error();
+    }
   }
+
+  return slaveInfo_.attributes();
 }
 
 } // namespace internal {
@@ -178,6 +178,10 @@ v1::scheduler::Event evolve(const ResourceOffersMessage& message)
   offers->mutable_inverse_offers()->CopyFrom(evolve<v1::InverseOffer>(
       message.inverse_offers()));
 
+  if (message.has_compressed_offers()) {
+    offers->set_compressed_offers(message.compressed_offers());
+  }
+
   return event;
 }
 
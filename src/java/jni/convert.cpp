@@ -104,6 +104,64 @@ jclass FindMesosClass(JNIEnv* env, const char* className)
   return cls;
 }
 
+
+// A class of the Mesos protobufs along with one of its static
+// methods (e.g., 'parseFrom'). These are looked up once per type
+// rather than on every conversion, since FindMesosClass calls into
+// the ClassLoader.
+struct JavaClass
+{
+  jclass clazz;
+  jmethodID method;
+};
+
+
+// Looks up the class of the given name and its static method which
+// takes the given arguments and returns an instance of the class.
+JavaClass lookup(
+    JNIEnv* env,
+    const string& name,
+    const char* method,
+    const string& arguments)
+{
+  const string className = "org/apache/mesos/Protos$" + name;
+  const string signature = "(" + arguments + ")L" + className + ";";
+
+  JavaClass result;
+
+  // The global reference keeps the class from being unloaded, which
+  // keeps the method ID valid.
+  jclass clazz = FindMesosClass(env, className.c_str());
+
+  result.clazz = (jclass) env->NewGlobalRef(clazz);
+  result.method =
+    env->GetStaticMethodID(result.clazz, method, signature.c_str());
+
+  env->DeleteLocalRef(clazz);
+
+  return result;
+}
+
+
+// Converts a protobuf message through the static 'parseFrom' method
+// of the message's Java class.
+template <typename T>
+jobject parse(JNIEnv* env, const JavaClass& clazz, const T& t)
+{
+  string data;
+  t.SerializeToString(&data);
+
+  // byte[] data = ..;
+  jbyteArray jdata = env->NewByteArray(data.size());
+  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
+
+  jobject jt = env->CallStaticObjectMethod(clazz.clazz, clazz.method, jdata);
+
+  env->DeleteLocalRef(jdata);
+
+  return jt;
+}
+
 } // namespace {
 
 
@@ -202,311 +260,141 @@ jobject convert(JNIEnv* env, const string& s)
 template <>
 jobject convert(JNIEnv* env, const FrameworkID& frameworkId)
 {
-  string data;
-  frameworkId.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // FrameworkID frameworkId = FrameworkID.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$FrameworkID");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$FrameworkID;");
+  static const JavaClass clazz = lookup(env, "FrameworkID", "parseFrom", "[B");
 
-  jobject jframeworkId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
-
-  return jframeworkId;
+  return parse(env, clazz, frameworkId);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const FrameworkInfo& frameworkInfo)
 {
-  string data;
-  frameworkInfo.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // FrameworkInfo frameworkInfo = FrameworkInfo.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$FrameworkInfo");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$FrameworkInfo;");
+  static const JavaClass clazz =
+    lookup(env, "FrameworkInfo", "parseFrom", "[B");
 
-  jobject jframeworkInfo = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
-
-  return jframeworkInfo;
+  return parse(env, clazz, frameworkInfo);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const MasterInfo& masterInfo)
 {
-  string data;
-  masterInfo.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // MasterInfo masterInfo = MasterInfo.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$MasterInfo");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$MasterInfo;");
+  static const JavaClass clazz = lookup(env, "MasterInfo", "parseFrom", "[B");
 
-  jobject jmasterInfo = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
-
-  return jmasterInfo;
+  return parse(env, clazz, masterInfo);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const ExecutorID& executorId)
 {
-  string data;
-  executorId.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // ExecutorID executorId = ExecutorID.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$ExecutorID");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$ExecutorID;");
+  static const JavaClass clazz = lookup(env, "ExecutorID", "parseFrom", "[B");
 
-  jobject jexecutorId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
-
-  return jexecutorId;
+  return parse(env, clazz, executorId);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const TaskID& taskId)
 {
-  string data;
-  taskId.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // TaskID taskId = TaskID.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$TaskID");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$TaskID;");
+  static const JavaClass clazz = lookup(env, "TaskID", "parseFrom", "[B");
 
-  jobject jtaskId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
-
-  return jtaskId;
+  return parse(env, clazz, taskId);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const SlaveID& slaveId)
 {
-  string data;
-  slaveId.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // SlaveID slaveId = SlaveID.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$SlaveID");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$SlaveID;");
+  static const JavaClass clazz = lookup(env, "SlaveID", "parseFrom", "[B");
 
-  jobject jslaveId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
-
-  return jslaveId;
+  return parse(env, clazz, slaveId);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const SlaveInfo& slaveInfo)
 {
-  string data;
-  slaveInfo.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // SlaveInfo slaveInfo = SlaveInfo.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$SlaveInfo");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$SlaveInfo;");
+  static const JavaClass clazz = lookup(env, "SlaveInfo", "parseFrom", "[B");
 
-  jobject jslaveInfo = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
-
-  return jslaveInfo;
+  return parse(env, clazz, slaveInfo);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const OfferID& offerId)
 {
-  string data;
-  offerId.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // OfferID offerId = OfferID.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$OfferID");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$OfferID;");
+  static const JavaClass clazz = lookup(env, "OfferID", "parseFrom", "[B");
 
-  jobject jofferId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
-
-  return jofferId;
+  return parse(env, clazz, offerId);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const TaskState& state)
 {
-  jint jvalue = state;
-
   // TaskState state = TaskState.valueOf(value);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$TaskState");
-
-  jmethodID valueOf =
-    env->GetStaticMethodID(clazz, "valueOf",
-                           "(I)Lorg/apache/mesos/Protos$TaskState;");
-
-  jobject jstate = env->CallStaticObjectMethod(clazz, valueOf, jvalue);
+  static const JavaClass clazz = lookup(env, "TaskState", "valueOf", "I");
 
-  return jstate;
+  return env->CallStaticObjectMethod(clazz.clazz, clazz.method, (jint) state);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const TaskInfo& task)
 {
-  string data;
-  task.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // TaskInfo task = TaskInfo.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$TaskInfo");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$TaskInfo;");
-
-  jobject jtask = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  static const JavaClass clazz = lookup(env, "TaskInfo", "parseFrom", "[B");
 
-  return jtask;
+  return parse(env, clazz, task);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const TaskStatus& status)
 {
-  string data;
-  status.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // TaskStatus status = TaskStatus.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$TaskStatus");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$TaskStatus;");
-
-  jobject jstatus = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  static const JavaClass clazz = lookup(env, "TaskStatus", "parseFrom", "[B");
 
-  return jstatus;
+  return parse(env, clazz, status);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const Offer& offer)
 {
-  string data;
-  offer.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // Offer offer = Offer.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$Offer");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$Offer;");
-
-  jobject joffer = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  static const JavaClass clazz = lookup(env, "Offer", "parseFrom", "[B");
 
-  return joffer;
+  return parse(env, clazz, offer);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const ExecutorInfo& executor)
 {
-  string data;
-  executor.SerializeToString(&data);
-
-  // byte[] data = ..;
-  jbyteArray jdata = env->NewByteArray(data.size());
-  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
-
   // ExecutorInfo executor = ExecutorInfo.parseFrom(data);
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$ExecutorInfo");
-
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$ExecutorInfo;");
-
-  jobject jexecutor = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  static const JavaClass clazz = lookup(env, "ExecutorInfo", "parseFrom", "[B");
 
-  return jexecutor;
+  return parse(env, clazz, executor);
 }
 
 
 template <>
 jobject convert(JNIEnv* env, const Status& status)
 {
-  jint jvalue = status;
-
-  jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$Status");
-
-  jmethodID valueOf =
-    env->GetStaticMethodID(clazz, "valueOf",
-                           "(I)Lorg/apache/mesos/Protos$Status;");
-
-  jobject jstate = env->CallStaticObjectMethod(clazz, valueOf, jvalue);
+  // Status status = Status.valueOf(value);
+  static const JavaClass clazz = lookup(env, "Status", "valueOf", "I");
 
-  return jstate;
+  return env->CallStaticObjectMethod(clazz.clazz, clazz.method, (jint) status);
 }
 
 
@@ -18,6 +18,9 @@
 #include <map>
 #include <vector>
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
 #include <mesos/scheduler.hpp>
 
 #include <stout/foreach.hpp>
@@ -44,6 +47,25 @@ public:
     : jvm(NULL), env(_env), jdriver(_jdriver)
   {
     env->GetJavaVM(&jvm);
+
+    // Look up the IDs used by 'resourceOffers' once, since offers are
+    // the most frequent callback. The scheduler is set before the
+    // driver is initialized and never changes.
+    jclass clazz = env->GetObjectClass(jdriver);
+
+    schedulerId =
+      env->GetFieldID(clazz, "scheduler", "Lorg/apache/mesos/Scheduler;");
+    parseOffersId =
+      env->GetStaticMethodID(clazz, "parseOffers", "([B)Ljava/util/List;");
+
+    jobject jscheduler = env->GetObjectField(jdriver, schedulerId);
+
+    clazz = env->GetObjectClass(jscheduler);
+
+    resourceOffersId =
+      env->GetMethodID(clazz, "resourceOffers",
+		       "(Lorg/apache/mesos/SchedulerDriver;"
+		       "Ljava/util/List;)V");
   }
 
   virtual ~JNIScheduler() {}
@@ -71,6 +93,10 @@ public:
   JavaVM* jvm;
   JNIEnv* env;
   jweak jdriver;
+
+  jfieldID schedulerId;
+  jmethodID parseOffersId;
+  jmethodID resourceOffersId;
 };
 
 
@@ -187,36 +213,42 @@ void JNIScheduler::resourceOffers(SchedulerDriver* driver,
 {
   jvm->AttachCurrentThread(JNIENV_CAST(&env), NULL);
 
-  jclass clazz = env->GetObjectClass(jdriver);
+  jobject jscheduler = env->GetObjectField(jdriver, schedulerId);
 
-  jfieldID scheduler = env->GetFieldID(clazz, "scheduler", "Lorg/apache/mesos/Scheduler;");
-  jobject jscheduler = env->GetObjectField(jdriver, scheduler);
+  // Pass all offers as one buffer of length delimited messages,
+  // rather than converting each offer with its own JNI calls.
+  string data;
 
-  clazz = env->GetObjectClass(jscheduler);
+  {
+    google::protobuf::io::StringOutputStream stream(&data);
+    google::protobuf::io::CodedOutputStream output(&stream);
 
-  // scheduler.resourceOffers(driver, offers);
-  jmethodID resourceOffers =
-    env->GetMethodID(clazz, "resourceOffers",
-		     "(Lorg/apache/mesos/SchedulerDriver;"
-		     "Ljava/util/List;)V");
+    foreach (const Offer& offer, offers) {
+      output.WriteVarint32(offer.ByteSize());
+      offer.SerializeWithCachedSizes(&output);
+    }
+  }
 
-  // List offers = new ArrayList();
-  clazz = env->FindClass("java/util/ArrayList");
+  // byte[] data = ..;
+  jbyteArray jdata = env->NewByteArray(data.size());
+  env->SetByteArrayRegion(jdata, 0, data.size(), (jbyte*) data.data());
 
-  jmethodID _init_ = env->GetMethodID(clazz, "<init>", "()V");
-  jobject joffers = env->NewObject(clazz, _init_);
+  env->ExceptionClear();
 
-  jmethodID add = env->GetMethodID(clazz, "add", "(Ljava/lang/Object;)Z");
+  // List offers = MesosSchedulerDriver.parseOffers(data);
+  jobject joffers = env->CallStaticObjectMethod(
+      env->GetObjectClass(jdriver), parseOffersId, jdata);
 
-  // Loop through C++ vector and add each offer to the Java list.
-  foreach (const Offer& offer, offers) {
-    jobject joffer = convert<Offer>(env, offer);
-    env->CallBooleanMethod(joffers, add, joffer);
+  if (env->ExceptionCheck()) {
+    env->ExceptionDescribe();
+    env->ExceptionClear();
+    jvm->DetachCurrentThread();
+    driver->abort();
+    return;
   }
 
-  env->ExceptionClear();
-
-  env->CallVoidMethod(jscheduler, resourceOffers, jdriver, joffers);
+  // scheduler.resourceOffers(driver, offers);
+  env->CallVoidMethod(jscheduler, resourceOffersId, jdriver, joffers);
 
   if (env->ExceptionCheck()) {
     env->ExceptionDescribe();
@@ -20,6 +20,10 @@ package org.apache.mesos;
 
 import org.apache.mesos.Protos.*;
 
+import java.io.ByteArrayInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+
 import java.util.ArrayList;
 import java.util.Collection;
 import java.util.Collections;
@@ -301,6 +305,22 @@ public class MesosSchedulerDriver implements SchedulerDriver {
   protected native void initialize();
   protected native void finalize();
 
+  // Called by the native library to decode the offers of a
+  // 'resourceOffers' callback, which are passed as one buffer of
+  // length delimited messages.
+  private static List<Offer> parseOffers(byte[] data) throws IOException {
+    InputStream stream = new ByteArrayInputStream(data);
+
+    List<Offer> offers = new ArrayList<Offer>();
+
+    Offer offer;
+    while ((offer = Offer.parseDelimitedFrom(stream)) != null) {
+      offers.add(offer);
+    }
+
+    return offers;
+  }
+
   private final Scheduler scheduler;
   private final FrameworkInfo framework;
   private final String master;
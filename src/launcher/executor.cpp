@@ -31,6 +31,7 @@
 #include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/io.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 #include <process/subprocess.hpp>
@@ -39,6 +40,8 @@
 
 #include <stout/duration.hpp>
 #include <stout/flags.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
@@ -49,6 +52,8 @@
 #include "common/http.hpp"
 #include "common/status_utils.hpp"
 
+#include "health-check/health_checker.hpp"
+
 #ifdef __linux__
 #include "linux/fs.hpp"
 #endif
@@ -74,26 +79,28 @@ namespace internal {
 
 using namespace process;
 
+// How long a shared command executor waits for new tasks once all of
+// its tasks have terminated before it exits.
+static const Duration SHARED_EXECUTOR_IDLE_TIMEOUT = Seconds(10);
+
+
 class CommandExecutorProcess : public ProtobufProcess<CommandExecutorProcess>
 {
 public:
   CommandExecutorProcess(
       const Option<char**>& override,
-      const string& _healthCheckDir,
       const Option<string>& _sandboxDirectory,
-      const Option<string>& _user)
+      const Option<string>& _user,
+      bool _shared)
     : state(REGISTERING),
       launched(false),
-      killed(false),
-      killedByHealthCheck(false),
-      pid(-1),
-      healthPid(-1),
+      shuttingDown(false),
       escalationTimeout(slave::EXECUTOR_SIGNAL_ESCALATION_TIMEOUT),
       driver(None()),
-      healthCheckDir(_healthCheckDir),
       override(override),
       sandboxDirectory(_sandboxDirectory),
-      user(_user) {}
+      user(_user),
+      shared(_shared) {}
 
   virtual ~CommandExecutorProcess() {}
 
@@ -126,7 +133,9 @@ public:
   {
     CHECK_EQ(REGISTERED, state);
 
-    if (launched) {
+    // A shared command executor runs all the command tasks of the
+    // framework (and user) that the agent sends to it.
+    if (!shared && launched) {
       TaskStatus status;
       status.mutable_task_id()->MergeFrom(task.task_id());
       status.set_state(TASK_FAILED);
@@ -185,6 +194,10 @@ public:
       abort();
     }
 
+    // A shared command executor which is waiting for new tasks does
+    // not exit now that it got one.
+    Clock::cancel(idleTimer);
+
     Option<string> rootfs;
     if (sandboxDirectory.isSome()) {
       // If 'sandbox_diretory' is specified, that means the user
@@ -264,6 +277,7 @@ public:
         strings::join(", ", task.command().arguments()) + "]";
     }
 
+    pid_t pid;
     if ((pid = fork()) == -1) {
       cerr << "Failed to fork to run " << command << ": "
            << os::strerror(errno) << endl;
@@ -343,6 +357,13 @@ public:
 #endif // __linux__
       }
 
+      // The environment of the task is set here (rather than by the
+      // containerizer for the executor) so that the tasks of a shared
+      // command executor can have different environments.
+      foreach (const Environment::Variable& variable,
+               task.command().environment().variables()) {
+        os::setenv(variable.name(), variable.value());
+      }
 
       cout << command << endl;
 
@@ -383,6 +404,11 @@ public:
 
     cout << "Forked command at " << pid << endl;
 
+    LaunchedTask& launchedTask = tasks[task.task_id()];
+    launchedTask.pid = pid;
+    launchedTask.killed = false;
+    launchedTask.killedByHealthCheck = false;
+
     launchHealthCheck(task);
 
     // Monitor this process.
@@ -404,10 +430,15 @@ public:
 
   void killTask(ExecutorDriver* driver, const TaskID& taskId)
   {
-    shutdown(driver);
-    if (healthPid != -1) {
-      // Cleanup health check process.
-      os::killtree(healthPid, SIGKILL);
+    if (shared) {
+      kill(taskId);
+    } else {
+      shutdown(driver);
+    }
+
+    // Stop checking the health of the task.
+    if (tasks.contains(taskId)) {
+      tasks[taskId].checker = None();
     }
   }
 
@@ -417,33 +448,17 @@ public:
   {
     cout << "Shutting down" << endl;
 
-    if (pid > 0 && !killed) {
-      cout << "Sending SIGTERM to process tree at pid "
-           << pid << endl;
-
-      Try<std::list<os::ProcessTree> > trees =
-        os::killtree(pid, SIGTERM, true, true);
-
-      if (trees.isError()) {
-        cerr << "Failed to kill the process tree rooted at pid "
-             << pid << ": " << trees.error() << endl;
-
-        // Send SIGTERM directly to process 'pid' as it may not have
-        // received signal before os::killtree() failed.
-        ::kill(pid, SIGTERM);
-      } else {
-        cout << "Killing the following process trees:\n"
-             << stringify(trees.get()) << endl;
-      }
+    shuttingDown = true;
 
-      // TODO(nnielsen): Make escalationTimeout configurable through
-      // slave flags and/or per-framework/executor.
-      escalationTimer = delay(
-          escalationTimeout,
-          self(),
-          &Self::escalated);
+    foreachkey (const TaskID& taskId, tasks) {
+      kill(taskId);
+    }
 
-      killed = true;
+    // A shared command executor might not have any task left, e.g.,
+    // while it waits for new tasks.
+    if (shared && tasks.empty()) {
+      Clock::cancel(idleTimer);
+      driver->stop();
     }
   }
 
@@ -478,23 +493,78 @@ protected:
     driver.get()->sendStatusUpdate(status);
 
     if (initiateTaskKill) {
-      killedByHealthCheck = true;
+      if (tasks.contains(taskID)) {
+        tasks[taskID].killedByHealthCheck = true;
+      }
       killTask(driver.get(), taskID);
     }
   }
 
 
 private:
+  struct LaunchedTask
+  {
+    pid_t pid;
+    bool killed;
+    bool killedByHealthCheck;
+    Timer escalationTimer;
+    Option<Owned<HealthChecker>> checker;
+  };
+
+  void kill(const TaskID& taskId)
+  {
+    if (!tasks.contains(taskId)) {
+      return;
+    }
+
+    LaunchedTask& task = tasks[taskId];
+    const pid_t pid = task.pid;
+
+    if (pid > 0 && !task.killed) {
+      cout << "Sending SIGTERM to process tree at pid "
+           << pid << endl;
+
+      Try<std::list<os::ProcessTree> > trees =
+        os::killtree(pid, SIGTERM, true, true);
+
+      if (trees.isError()) {
+        cerr << "Failed to kill the process tree rooted at pid "
+             << pid << ": " << trees.error() << endl;
+
+        // Send SIGTERM directly to process 'pid' as it may not have
+        // received signal before os::killtree() failed.
+        ::kill(pid, SIGTERM);
+      } else {
+        cout << "Killing the following process trees:\n"
+             << stringify(trees.get()) << endl;
+      }
+
+      // TODO(nnielsen): Make escalationTimeout configurable through
+      // slave flags and/or per-framework/executor.
+      task.escalationTimer = delay(
+          escalationTimeout,
+          self(),
+          &Self::escalated,
+          taskId);
+
+      task.killed = true;
+    }
+  }
+
   void reaped(
       ExecutorDriver* driver,
       const TaskID& taskId,
       pid_t pid,
       const Future<Option<int> >& status_)
   {
+    CHECK(tasks.contains(taskId));
+
+    const LaunchedTask task = tasks[taskId];
+
     TaskState taskState;
     string message;
 
-    Clock::cancel(escalationTimer);
+    Clock::cancel(task.escalationTimer);
 
     if (!status_.isReady()) {
       taskState = TASK_FAILED;
@@ -510,7 +580,7 @@ private:
 
       if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
         taskState = TASK_FINISHED;
-      } else if (killed) {
+      } else if (task.killed) {
         // Send TASK_KILLED if the task was killed as a result of
         // killTask() or shutdown().
         taskState = TASK_KILLED;
@@ -527,12 +597,30 @@ private:
     taskStatus.mutable_task_id()->MergeFrom(taskId);
     taskStatus.set_state(taskState);
     taskStatus.set_message(message);
-    if (killed && killedByHealthCheck) {
+    if (task.killed && task.killedByHealthCheck) {
       taskStatus.set_healthy(false);
     }
 
     driver->sendStatusUpdate(taskStatus);
 
+    tasks.erase(taskId);
+
+    if (shared && !tasks.empty()) {
+      return;
+    }
+
+    if (shared && !shuttingDown) {
+      // Wait a bit for new tasks rather than exiting right away, so
+      // that the executor is reused by the tasks that the framework
+      // launches in quick succession.
+      idleTimer = delay(
+          SHARED_EXECUTOR_IDLE_TIMEOUT,
+          self(),
+          &Self::idle,
+          driver);
+      return;
+    }
+
     // This is a hack to ensure the message is sent to the
     // slave before we exit the process. Without this, we
     // may exit before libprocess has sent the data over
@@ -541,8 +629,26 @@ private:
     driver->stop();
   }
 
-  void escalated()
+  void idle(ExecutorDriver* driver)
+  {
+    if (!tasks.empty()) {
+      return;
+    }
+
+    cout << "No tasks were launched in the last "
+         << SHARED_EXECUTOR_IDLE_TIMEOUT << ", shutting down" << endl;
+
+    driver->stop();
+  }
+
+  void escalated(const TaskID& taskId)
   {
+    if (!tasks.contains(taskId)) {
+      return;
+    }
+
+    const pid_t pid = tasks[taskId].pid;
+
     cout << "Process " << pid << " did not terminate after "
          << escalationTimeout << ", sending SIGKILL to "
          << "process tree at " << pid << endl;
@@ -571,38 +677,29 @@ private:
   void launchHealthCheck(const TaskInfo& task)
   {
     if (task.has_health_check()) {
-      JSON::Object json = JSON::protobuf(task.health_check());
-
-      // Launch the subprocess using 'exec' style so that quotes can
-      // be properly handled.
-      vector<string> argv(4);
-      argv[0] = "mesos-health-check";
-      argv[1] = "--executor=" + stringify(self());
-      argv[2] = "--health_check_json=" + stringify(json);
-      argv[3] = "--task_id=" + task.task_id().value();
-
-      cout << "Launching health check process: "
-           << path::join(healthCheckDir, "mesos-health-check")
-           << " " << argv[1] << " " << argv[2] << " " << argv[3] << endl;
-
-      Try<Subprocess> healthProcess =
-        process::subprocess(
-          path::join(healthCheckDir, "mesos-health-check"),
-          argv,
-          // Intentionally not sending STDIN to avoid health check
-          // commands that expect STDIN input to block.
-          Subprocess::PATH("/dev/null"),
-          Subprocess::FD(STDOUT_FILENO),
-          Subprocess::FD(STDERR_FILENO));
-
-      if (healthProcess.isError()) {
-        cerr << "Unable to launch health process: " << healthProcess.error();
-      } else {
-        healthPid = healthProcess.get().pid();
+      // The health of the task is checked by this executor itself
+      // (in a separate libprocess process which sends the results to
+      // this one) rather than by a 'mesos-health-check' process.
+      Try<Owned<HealthChecker>> _checker = HealthChecker::create(
+          task.health_check(),
+          self(),
+          task.task_id());
 
-        cout << "Health check process launched at pid: "
-             << stringify(healthPid) << endl;
+      if (_checker.isError()) {
+        cerr << "Unable to check the health of the task: "
+             << _checker.error() << endl;
+        return;
       }
+
+      Option<Owned<HealthChecker>>& checker = tasks[task.task_id()].checker;
+      checker = _checker.get();
+
+      cout << "Checking the health of task " << task.task_id() << endl;
+
+      checker.get()->healthCheck()
+        .onFailed([](const string& failure) {
+          cerr << "Health check failed: " << failure << endl;
+        });
     }
   }
 
@@ -613,17 +710,15 @@ private:
   } state;
 
   bool launched;
-  bool killed;
-  bool killedByHealthCheck;
-  pid_t pid;
-  pid_t healthPid;
+  bool shuttingDown;
+  hashmap<TaskID, LaunchedTask> tasks;
   Duration escalationTimeout;
-  Timer escalationTimer;
+  Timer idleTimer;
   Option<ExecutorDriver*> driver;
-  string healthCheckDir;
   Option<char**> override;
   Option<string> sandboxDirectory;
   Option<string> user;
+  bool shared;
 };
 
 
@@ -632,12 +727,12 @@ class CommandExecutor: public Executor
 public:
   CommandExecutor(
       const Option<char**>& override,
-      const string& healthCheckDir,
       const Option<string>& sandboxDirectory,
-      const Option<string>& user)
+      const Option<string>& user,
+      bool shared)
   {
     process = new CommandExecutorProcess(
-        override, healthCheckDir, sandboxDirectory, user);
+        override, sandboxDirectory, user, shared);
     spawn(process);
   }
 
@@ -734,6 +829,13 @@ public:
         "user",
         "The user that the task should be running as.");
 
+    add(&shared,
+        "shared",
+        "Whether to run all the tasks that the agent sends to the executor\n"
+        "rather than a single one, see '--shared_command_executor' of the\n"
+        "agent. The executor exits once it did not run any task for a while.",
+        false);
+
     // TODO(nnielsen): Add 'prefix' option to enable replacing
     // 'sh -c' with user specified wrapper.
   }
@@ -741,6 +843,7 @@ public:
   bool override;
   Option<string> sandbox_directory;
   Option<string> user;
+  bool shared;
 };
 
 
@@ -766,6 +869,12 @@ int main(int argc, char** argv)
   // terminator will be preservered in argv and it is therefore
   // possible to pass override and prefix commands which use
   // "--foobar" style flags.
+  if (flags.override && flags.shared) {
+    cerr << flags.usage("Flags '--override' and '--shared' are exclusive")
+         << endl;
+    return EXIT_FAILURE;
+  }
+
   Option<char**> override = None();
   if (flags.override) {
     if (argc > 1) {
@@ -773,12 +882,8 @@ int main(int argc, char** argv)
     }
   }
 
-  const Option<string> envPath = os::getenv("MESOS_LAUNCHER_DIR");
-  string path =
-    envPath.isSome() ? envPath.get()
-                     : os::realpath(Path(argv[0]).dirname()).get();
   mesos::internal::CommandExecutor executor(
-      override, path, flags.sandbox_directory, flags.user);
+      override, flags.sandbox_directory, flags.user, flags.shared);
   mesos::MesosExecutorDriver driver(&executor);
   return driver.run() == mesos::DRIVER_STOPPED ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -14,12 +14,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#endif // __linux__
+
+#include <algorithm>
+#include <random>
 #include <string>
+#include <vector>
 
+#include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/owned.hpp>
+#include <process/subprocess.hpp>
 
 #include <stout/json.hpp>
 #include <stout/net.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
@@ -30,6 +45,8 @@
 
 #include <mesos/fetcher/fetcher.hpp>
 
+#include "common/status_utils.hpp"
+
 #include "hdfs/hdfs.hpp"
 
 #include "logging/flags.hpp"
@@ -39,18 +56,58 @@
 
 #include "slave/containerizer/fetcher.hpp"
 
+#include "uri/fetchers/curl.hpp"
+
 using namespace process;
 
 using namespace mesos;
 using namespace mesos::internal;
 
 using std::string;
+using std::vector;
 
 using mesos::fetcher::FetcherInfo;
 
 using mesos::internal::slave::Fetcher;
 
 
+// The number of peer agents that are tried for a cache file before
+// downloading it from its origin, see '--fetcher_peers'.
+static const size_t MAX_PEER_ATTEMPTS = 3;
+
+
+// Returns whether a program is installed on the agent.
+static bool installed(const string& program)
+{
+  return os::system("command -v " + program + " > /dev/null 2>&1") == 0;
+}
+
+
+// Returns the tar option to decompress the archive at the given path,
+// or None if it is not a tar archive. A parallel decompressor (pigz or
+// pbzip2) is used for large archives if one is installed. The option
+// is always explicit since tar can not detect the compression of an
+// archive that is read from a pipe, see 'downloadAndExtract'.
+static Option<string> decompression(const string& path)
+{
+  if (strings::endsWith(path, ".tar")) {
+    return string();
+  } else if (strings::endsWith(path, ".tgz") ||
+             strings::endsWith(path, ".tar.gz")) {
+    return string(installed("pigz") ? "--use-compress-program=pigz" : "-z");
+  } else if (strings::endsWith(path, ".tbz2") ||
+             strings::endsWith(path, ".tar.bz2")) {
+    return string(
+        installed("pbzip2") ? "--use-compress-program=pbzip2" : "-j");
+  } else if (strings::endsWith(path, ".txz") ||
+             strings::endsWith(path, ".tar.xz")) {
+    return string("-J");
+  }
+
+  return None();
+}
+
+
 // Try to extract sourcePath into directory. If sourcePath is
 // recognized as an archive it will be extracted and true returned;
 // if not recognized then false will be returned. An Error is
@@ -61,14 +118,9 @@ static Try<bool> extract(
 {
   string command;
   // Extract any .tar, .tgz, tar.gz, tar.bz2 or zip files.
-  if (strings::endsWith(sourcePath, ".tar") ||
-      strings::endsWith(sourcePath, ".tgz") ||
-      strings::endsWith(sourcePath, ".tar.gz") ||
-      strings::endsWith(sourcePath, ".tbz2") ||
-      strings::endsWith(sourcePath, ".tar.bz2") ||
-      strings::endsWith(sourcePath, ".txz") ||
-      strings::endsWith(sourcePath, ".tar.xz")) {
-    command = "tar -C '" + destinationDirectory + "' -xf";
+  const Option<string> tar = decompression(sourcePath);
+  if (tar.isSome()) {
+    command = "tar -C '" + destinationDirectory + "' -x " + tar.get() + " -f";
   } else if (strings::endsWith(sourcePath, ".gz")) {
     string pathWithoutExtension = sourcePath.substr(0, sourcePath.length() - 3);
     string filename = Path(pathWithoutExtension).basename();
@@ -101,7 +153,9 @@ static Try<string> downloadWithHadoopClient(
     const string& sourceUri,
     const string& destinationPath)
 {
-  Try<Owned<HDFS>> hdfs = HDFS::create();
+  // The agent passes its '--webhdfs_address', if any.
+  Try<Owned<HDFS>> hdfs =
+    HDFS::create(None(), os::getenv("MESOS_WEBHDFS_ADDRESS"));
   if (hdfs.isError()) {
     return Error("Failed to create HDFS client: " + hdfs.error());
   }
@@ -121,6 +175,48 @@ static Try<string> downloadWithHadoopClient(
 }
 
 
+// Downloads with up to the given number of concurrent range requests
+// using the curl command, see 'uri::download'.
+static Try<int> downloadInParts(
+    const string& sourceUri,
+    const string& destinationPath,
+    size_t parts)
+{
+  Future<int> code = uri::download(
+      sourceUri,
+      destinationPath,
+      http::Headers(),
+      parts);
+
+  code.await();
+
+  if (!code.isReady()) {
+    return Error(code.isFailed() ? code.failure() : "discarded");
+  }
+
+  return code.get();
+}
+
+
+// Checks the status code of a download with libcurl: it is 200 for
+// successful HTTP requests and 226 for successful FTP file transfers.
+static Try<Nothing> validateCode(const string& sourceUri, long code)
+{
+  if (strings::startsWith(sourceUri, "ftp://") ||
+      strings::startsWith(sourceUri, "ftps://")) {
+    if (code != 226) {
+      return Error("Error downloading resource, received FTP return code " +
+                   stringify(code));
+    }
+  } else if (code != 200) {
+    return Error("Error downloading resource, received HTTP return code " +
+                 stringify(code));
+  }
+
+  return Nothing();
+}
+
+
 static Try<string> downloadWithNet(
     const string& sourceUri,
     const string& destinationPath)
@@ -134,30 +230,146 @@ static Try<string> downloadWithNet(
   LOG(INFO) << "Downloading resource from '" << sourceUri
             << "' to '" << destinationPath << "'";
 
-  Try<int> code = net::download(sourceUri, destinationPath);
+  // The agent passes its '--fetcher_download_parts' if more than one
+  // part is requested, HTTP(S) downloads then use concurrent range
+  // requests (if supported by the server) instead of libcurl.
+  Option<size_t> parts = None();
+
+  Option<string> value = os::getenv("MESOS_FETCHER_DOWNLOAD_PARTS");
+  if (value.isSome() && !strings::startsWith(sourceUri, "ftp")) {
+    Try<size_t> number = numify<size_t>(value.get());
+    if (number.isError()) {
+      return Error("Invalid MESOS_FETCHER_DOWNLOAD_PARTS: " + number.error());
+    }
+
+    parts = number.get();
+  }
+
+  Try<int> code = parts.isSome()
+    ? downloadInParts(sourceUri, destinationPath, parts.get())
+    : net::download(sourceUri, destinationPath);
+
   if (code.isError()) {
     return Error("Error downloading resource: " + code.error());
-  } else {
-    // The status code for successful HTTP requests is 200, the status code
-    // for successful FTP file transfers is 226.
-    if (strings::startsWith(sourceUri, "ftp://") ||
-        strings::startsWith(sourceUri, "ftps://")) {
-      if (code.get() != 226) {
-        return Error("Error downloading resource, received FTP return code " +
-                     stringify(code.get()));
-      }
-    } else {
-      if (code.get() != 200) {
-        return Error("Error downloading resource, received HTTP return code " +
-                     stringify(code.get()));
-      }
-    }
+  }
+
+  Try<Nothing> validation = validateCode(sourceUri, code.get());
+  if (validation.isError()) {
+    return Error(validation.error());
   }
 
   return destinationPath;
 }
 
 
+// Downloads a tar archive and extracts it at the same time by piping
+// the download into tar, so the extraction does not wait for the end
+// of the download and the archive is never written to the sandbox.
+static Try<string> downloadAndExtract(
+    const string& sourceUri,
+    const string& decompression,
+    const string& destinationDirectory)
+{
+  Try<Nothing> validation = Fetcher::validateUri(sourceUri);
+  if (validation.isError()) {
+    return Error(validation.error());
+  }
+
+  const string command =
+    "tar -C '" + destinationDirectory + "' -x " + decompression + " -f -";
+
+  LOG(INFO) << "Downloading resource from '" << sourceUri
+            << "' and extracting it with command: " << command;
+
+  Future<Option<int>> status;
+  int fd;
+
+  {
+    Try<Subprocess> tar = subprocess(
+        command,
+        Subprocess::PIPE(),
+        Subprocess::FD(STDOUT_FILENO),
+        Subprocess::FD(STDERR_FILENO));
+
+    if (tar.isError()) {
+      return Error("Failed to run '" + command + "': " + tar.error());
+    }
+
+    status = tar.get().status();
+
+    // The 'Subprocess' closes its end of the pipe once it is
+    // destroyed (at the end of this scope), so the download is
+    // written to a duplicate which is closed at the end of the
+    // archive, i.e., tar then reads EOF.
+    fd = ::dup(tar.get().in().get());
+    if (fd < 0) {
+      return ErrnoError("Failed to duplicate the pipe to tar");
+    }
+  }
+
+  FILE* file = ::fdopen(fd, "w");
+  if (file == NULL) {
+    os::close(fd);
+    return ErrnoError("Failed to open the pipe to tar");
+  }
+
+  net::initialize();
+
+  CURL* curl = curl_easy_init();
+  if (curl == NULL) {
+    ::fclose(file);
+    return Error("Failed to initialize libcurl");
+  }
+
+  curl_easy_setopt(curl, CURLOPT_URL, sourceUri.c_str());
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, file);
+
+  const CURLcode result = curl_easy_perform(curl);
+
+  long code = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+  curl_easy_cleanup(curl);
+
+  ::fclose(file);
+
+  status.await();
+
+  // NOTE: A write error means that tar exited early, which is
+  // reported below with its exit status instead.
+  if (result != CURLE_OK && result != CURLE_WRITE_ERROR) {
+    return Error("Error downloading resource: " +
+                 string(curl_easy_strerror(result)));
+  }
+
+  if (result == CURLE_OK) {
+    Try<Nothing> validated = validateCode(sourceUri, code);
+    if (validated.isError()) {
+      return Error(validated.error());
+    }
+  }
+
+  if (!status.isReady()) {
+    return Error("Failed to reap the extraction command " + command + ": " +
+                 (status.isFailed() ? status.failure() : "discarded"));
+  } else if (status.get().isNone() || status.get().get() != 0) {
+    return Error("Failed to extract: command " + command + " " +
+                 (status.get().isNone()
+                  ? "exited with an unknown status"
+                  : WSTRINGIFY(status.get().get())));
+  } else if (result != CURLE_OK) {
+    return Error("Error downloading resource: " +
+                 string(curl_easy_strerror(result)));
+  }
+
+  LOG(INFO) << "Extracted '" << sourceUri << "' into '"
+            << destinationDirectory << "'";
+
+  return destinationDirectory;
+}
+
+
 static Try<string> copyFile(
     const string& sourcePath,
     const string& destinationPath)
@@ -176,6 +388,82 @@ static Try<string> copyFile(
 }
 
 
+// Verifies the file at the given path against a hex encoded SHA-256
+// digest, see the "checksum" field of CommandInfo.URI.
+static Try<Nothing> verifyChecksum(
+    const string& path,
+    const string& checksum)
+{
+  Try<string> output = os::shell("sha256sum '%s'", path.c_str());
+  if (output.isError()) {
+    return Error("Failed to compute the checksum of '" + path + "': " +
+                 output.error());
+  }
+
+  const vector<string> tokens = strings::tokenize(output.get(), " ");
+  if (tokens.empty() || tokens[0] != strings::lower(checksum)) {
+    return Error("The checksum of '" + path + "' is '" +
+                 (tokens.empty() ? "" : tokens[0]) + "' instead of '" +
+                 checksum + "'");
+  }
+
+  return Nothing();
+}
+
+
+// Clones the source file into the destination path if the file
+// system supports this (i.e., reflinks on btrfs or XFS), so that both
+// share their data blocks until either of them gets modified. Returns
+// false if the file could not be cloned, in which case nothing is
+// left behind at the destination path.
+static bool clone(const string& sourcePath, const string& destinationPath)
+{
+#if defined(__linux__) && defined(_IOW)
+  // Defined in <linux/fs.h> as of Linux 4.5, with the same value as
+  // the older BTRFS_IOC_CLONE.
+  const unsigned long FICLONE = _IOW(0x94, 9, int);
+
+  int source = ::open(sourcePath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (source < 0) {
+    return false;
+  }
+
+  struct stat s;
+  if (::fstat(source, &s) < 0) {
+    ::close(source);
+    return false;
+  }
+
+  int destination = ::open(
+      destinationPath.c_str(),
+      O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+      s.st_mode & 0777);
+
+  if (destination < 0) {
+    ::close(source);
+    return false;
+  }
+
+  int result = ::ioctl(destination, FICLONE, source);
+
+  ::close(source);
+  ::close(destination);
+
+  if (result < 0) {
+    ::unlink(destinationPath.c_str());
+    return false;
+  }
+
+  LOG(INFO) << "Cloned resource '" << sourcePath << "' to '"
+            << destinationPath << "'";
+
+  return true;
+#else
+  return false;
+#endif // __linux__
+}
+
+
 static Try<string> download(
     const string& _sourceUri,
     const string& destinationPath,
@@ -257,11 +545,34 @@ static Try<string> fetchBypassingCache(
 
   string path = path::join(sandboxDirectory, basename.get());
 
+  // A tar archive that is downloaded (in a single part) and is only
+  // needed extracted is extracted while it is being downloaded. The
+  // ones with a checksum are not since it must be verified first.
+  const string sourceUri = strings::trim(uri.value(), strings::PREFIX);
+
+  if (uri.extract() &&
+      !uri.executable() &&
+      !uri.has_checksum() &&
+      Fetcher::isNetUri(sourceUri) &&
+      os::getenv("MESOS_FETCHER_DOWNLOAD_PARTS").isNone()) {
+    const Option<string> tar = decompression(basename.get());
+    if (tar.isSome()) {
+      return downloadAndExtract(sourceUri, tar.get(), sandboxDirectory);
+    }
+  }
+
   Try<string> downloaded = download(uri.value(), path, frameworksHome);
   if (downloaded.isError()) {
     return Error(downloaded.error());
   }
 
+  if (uri.has_checksum()) {
+    Try<Nothing> verified = verifyChecksum(path, uri.checksum());
+    if (verified.isError()) {
+      return Error(verified.error());
+    }
+  }
+
   if (uri.executable()) {
     return chmodExecutable(downloaded.get());
   } else if (uri.extract()) {
@@ -279,12 +590,91 @@ static Try<string> fetchBypassingCache(
 }
 
 
+// A cache file to be hard linked into the sandbox once the sandbox
+// has been chowned, so that the cache file keeps its owner.
+struct Link
+{
+  string sourcePath;
+  string destinationPath;
+  bool executable;
+};
+
+
+// Hard links the cache file into the sandbox, after making it
+// read-only so that it cannot be modified through the sandbox.
+// Copies the cache file instead if it cannot be linked, e.g., because
+// it is on a different file system. Returns the resulting file.
+static Try<string> linkFromCache(const Link& link, const Option<string>& user)
+{
+  Try<mode_t> mode = os::stat::mode(link.sourcePath);
+  if (mode.isError()) {
+    return Error("Failed to stat cache file '" + link.sourcePath + "': " +
+                 mode.error());
+  }
+
+  // Once a cache file has been made executable for one URI it stays
+  // executable, other links to it may depend on this.
+  mode_t readOnly = (mode.get() & 0777 & ~0222) | S_IRUSR | S_IRGRP | S_IROTH;
+  if (link.executable) {
+    readOnly |= S_IXUSR | S_IXGRP | S_IXOTH;
+  }
+
+  Try<Nothing> chmod = os::chmod(link.sourcePath, readOnly);
+  if (chmod.isError()) {
+    return Error("Failed to chmod cache file '" + link.sourcePath + "': " +
+                 chmod.error());
+  }
+
+  if (::link(link.sourcePath.c_str(), link.destinationPath.c_str()) == 0) {
+    LOG(INFO) << "Linked resource '" << link.sourcePath << "' to '"
+              << link.destinationPath << "'";
+
+    return link.destinationPath;
+  }
+
+  LOG(WARNING) << "Copying instead of linking cache file '" << link.sourcePath
+               << "': " << os::strerror(errno);
+
+  Try<string> copied = copyFile(link.sourcePath, link.destinationPath);
+  if (copied.isError()) {
+    return Error(copied.error());
+  }
+
+  // Unlike the cache file, the copy is writable.
+  if (link.executable) {
+    copied = chmodExecutable(copied.get());
+    if (copied.isError()) {
+      return Error(copied.error());
+    }
+  } else {
+    chmod = os::chmod(copied.get(), readOnly | S_IWUSR);
+    if (chmod.isError()) {
+      return Error("Failed to chmod '" + copied.get() + "': " +
+                   chmod.error());
+    }
+  }
+
+  if (user.isSome()) {
+    Try<Nothing> chowned = os::chown(user.get(), copied.get());
+    if (chowned.isError()) {
+      return Error("Failed to chown '" + copied.get() + "': " +
+                   chowned.error());
+    }
+  }
+
+  return copied;
+}
+
+
 // Returns the resulting file or in case of extraction the destination
-// directory (for logging).
+// directory (for logging). Cache files that are neither extracted nor
+// cloned are added to 'links' instead of being copied, unless 'links'
+// is NULL.
 static Try<string> fetchFromCache(
     const FetcherInfo::Item& item,
     const string& cacheDirectory,
-    const string& sandboxDirectory)
+    const string& sandboxDirectory,
+    vector<Link>* links)
 {
   LOG(INFO) << "Fetching from cache";
 
@@ -301,12 +691,19 @@ static Try<string> fetchFromCache(
   string sourcePath = path::join(cacheDirectory, item.cache_filename());
 
   if (item.uri().executable()) {
-    Try<string> copied = copyFile(sourcePath, destinationPath);
-    if (copied.isError()) {
-      return Error(copied.error());
+    if (!clone(sourcePath, destinationPath)) {
+      if (links != NULL) {
+        links->push_back({sourcePath, destinationPath, true});
+        return destinationPath;
+      }
+
+      Try<string> copied = copyFile(sourcePath, destinationPath);
+      if (copied.isError()) {
+        return Error(copied.error());
+      }
     }
 
-    return chmodExecutable(copied.get());
+    return chmodExecutable(destinationPath);
   } else if (item.uri().extract()) {
     Try<bool> extracted = extract(sourcePath, sandboxDirectory);
     if (extracted.isError()) {
@@ -320,18 +717,90 @@ static Try<string> fetchFromCache(
     }
   }
 
+  if (clone(sourcePath, destinationPath)) {
+    return destinationPath;
+  }
+
+  if (links != NULL) {
+    links->push_back({sourcePath, destinationPath, false});
+    return destinationPath;
+  }
+
   return copyFile(sourcePath, destinationPath);
 }
 
 
+// Tries to download the cache file of a URI with a checksum from the
+// fetcher caches of the peer agents that the slave passes from its
+// '--fetcher_peers'. The peers are tried in a random order so that
+// they share the load. Returns whether a verified file was downloaded.
+static bool downloadFromPeers(
+    const FetcherInfo::Item& item,
+    const string& destinationPath)
+{
+  const Option<string> peers = os::getenv("MESOS_FETCHER_PEERS");
+  if (peers.isNone() || !item.uri().has_checksum()) {
+    return false;
+  }
+
+  vector<string> candidates = strings::tokenize(peers.get(), ",");
+
+  std::random_device device;
+  std::shuffle(candidates.begin(), candidates.end(), std::mt19937(device()));
+
+  const string path = path::join(
+      mesos::internal::slave::FETCHER_CACHE_VIRTUAL_PATH,
+      item.cache_filename());
+
+  for (size_t i = 0; i < candidates.size() && i < MAX_PEER_ATTEMPTS; i++) {
+    const string url =
+      "http://" + strings::trim(candidates[i]) +
+      "/files/download?path=" + http::encode(path);
+
+    LOG(INFO) << "Downloading resource from peer '" << url << "'";
+
+    Try<int> code = net::download(url, destinationPath);
+    if (code.isError() || code.get() != 200) {
+      LOG(INFO) << "Failed to download resource from peer '" << url << "': "
+                << (code.isError()
+                      ? code.error()
+                      : "HTTP return code " + stringify(code.get()));
+
+      os::rm(destinationPath);
+      continue;
+    }
+
+    Try<Nothing> verified =
+      verifyChecksum(destinationPath, item.uri().checksum());
+
+    if (verified.isError()) {
+      LOG(WARNING) << "Discarding resource from peer '" << url << "': "
+                   << verified.error();
+
+      os::rm(destinationPath);
+      continue;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+
 // Returns the resulting file or in case of extraction the destination
 // directory (for logging).
 static Try<string> fetchThroughCache(
     const FetcherInfo::Item& item,
-    const Option<string>& cacheDirectory,
+    const Option<string>& _cacheDirectory,
     const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Option<string>& frameworksHome,
+    vector<Link>* links)
 {
+  const Option<string> cacheDirectory = item.has_cache_directory()
+    ? Option<string>(item.cache_directory())
+    : _cacheDirectory;
+
   if (cacheDirectory.isNone() || cacheDirectory.get().empty()) {
     return Error("Cache directory not specified");
   }
@@ -354,17 +823,33 @@ static Try<string> fetchThroughCache(
                    cacheDirectory.get() + "': " + mkdir.error());
     }
 
-    Try<string> downloaded = download(
-        item.uri().value(),
-        path::join(cacheDirectory.get(), item.cache_filename()),
-        frameworksHome);
+    const string cachePath =
+      path::join(cacheDirectory.get(), item.cache_filename());
+
+    // Content with a checksum may come from the cache of a peer agent
+    // rather than from its origin, since it is verified either way.
+    if (!downloadFromPeers(item, cachePath)) {
+      Try<string> downloaded =
+        download(item.uri().value(), cachePath, frameworksHome);
+
+      if (downloaded.isError()) {
+        return Error(downloaded.error());
+      }
+
+      // The slave removes the cache file if the download fails, hence
+      // a cache file with the wrong content is never reused.
+      if (item.uri().has_checksum()) {
+        Try<Nothing> verified =
+          verifyChecksum(downloaded.get(), item.uri().checksum());
 
-    if (downloaded.isError()) {
-      return Error(downloaded.error());
+        if (verified.isError()) {
+          return Error(verified.error());
+        }
+      }
     }
   }
 
-  return fetchFromCache(item, cacheDirectory.get(), sandboxDirectory);
+  return fetchFromCache(item, cacheDirectory.get(), sandboxDirectory, links);
 }
 
 
@@ -374,7 +859,8 @@ static Try<string> fetch(
     const FetcherInfo::Item& item,
     const Option<string>& cacheDirectory,
     const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Option<string>& frameworksHome,
+    vector<Link>* links)
 {
   LOG(INFO) << "Fetching URI '" << item.uri().value() << "'";
 
@@ -389,7 +875,8 @@ static Try<string> fetch(
       item,
       cacheDirectory,
       sandboxDirectory,
-      frameworksHome);
+      frameworksHome,
+      links);
 }
 
 
@@ -445,10 +932,16 @@ int main(int argc, char* argv[])
       Option<string>::some(fetcherInfo.get().frameworks_home()) :
         Option<string>::none();
 
+  vector<Link> links;
+
   // Fetch each URI to a local file, chmod, then chown if a user is provided.
   foreach (const FetcherInfo::Item& item, fetcherInfo.get().items()) {
-    Try<string> fetched =
-      fetch(item, cacheDirectory, sandboxDirectory, frameworksHome);
+    Try<string> fetched = fetch(
+        item,
+        cacheDirectory,
+        sandboxDirectory,
+        frameworksHome,
+        fetcherInfo.get().link_cache_files() ? &links : NULL);
     if (fetched.isError()) {
       EXIT(1) << "Failed to fetch '" << item.uri().value()
               << "': " + fetched.error();
@@ -469,5 +962,19 @@ int main(int argc, char* argv[])
     }
   }
 
+  const Option<string> user = fetcherInfo.get().has_user()
+    ? Option<string>(fetcherInfo.get().user())
+    : None();
+
+  // Link cache files only now so that chowning the sandbox does not
+  // affect them.
+  foreach (const Link& link, links) {
+    Try<string> linked = linkFromCache(link, user);
+    if (linked.isError()) {
+      EXIT(1) << "Failed to fetch '" << link.sourcePath
+              << "' from the cache: " << linked.error();
+    }
+  }
+
   return 0;
 }
@@ -14,11 +14,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <fts.h>
 #include <signal.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <sys/syscall.h>
@@ -27,11 +30,13 @@
 #include <glog/logging.h>
 
 #include <fstream>
+#include <initializer_list>
 #include <list>
 #include <map>
 #include <set>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/collect.hpp>
@@ -47,6 +52,7 @@
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
@@ -66,12 +72,14 @@ using namespace mesos::internal;
 using std::dec;
 using std::getline;
 using std::ifstream;
+using std::initializer_list;
 using std::istringstream;
 using std::list;
 using std::map;
 using std::ofstream;
 using std::ostream;
 using std::ostringstream;
+using std::pair;
 using std::set;
 using std::string;
 using std::vector;
@@ -1862,6 +1870,167 @@ Try<hashmap<string, uint64_t>> stat(
 }
 
 
+Reader::Reader(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control)
+  : file(path::join(hierarchy, cgroup, control)),
+    buffer(4096) {}
+
+
+Reader::~Reader()
+{
+  if (fd.isSome()) {
+    os::close(fd.get());
+  }
+}
+
+
+Try<size_t> Reader::read()
+{
+  if (fd.isNone()) {
+    Try<int> open = os::open(file, O_RDONLY | O_CLOEXEC);
+    if (open.isError()) {
+      return Error("Failed to open '" + file + "': " + open.error());
+    }
+
+    fd = open.get();
+  }
+
+  size_t length = 0;
+
+  while (true) {
+    if (length == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
+
+    ssize_t n = ::pread(
+        fd.get(), buffer.data() + length, buffer.size() - length, length);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      ErrnoError error("Failed to read '" + file + "'");
+
+      // Reopen the control on the next read, e.g., in case the
+      // cgroup was removed and created again.
+      os::close(fd.get());
+      fd = None();
+
+      return error;
+    }
+
+    if (n == 0) {
+      break;
+    }
+
+    length += n;
+  }
+
+  return length;
+}
+
+
+Try<uint64_t> Reader::value()
+{
+  Try<size_t> length = read();
+  if (length.isError()) {
+    return Error(length.error());
+  }
+
+  const char* current = buffer.data();
+  const char* end = buffer.data() + length.get();
+
+  while (current < end && isspace(*current)) {
+    ++current;
+  }
+
+  if (current == end || !isdigit(*current)) {
+    return Error("Unexpected format in '" + file + "'");
+  }
+
+  uint64_t value = 0;
+  while (current < end && isdigit(*current)) {
+    value = value * 10 + (*current++ - '0');
+  }
+
+  while (current < end && isspace(*current)) {
+    ++current;
+  }
+
+  if (current != end) {
+    return Error("Unexpected format in '" + file + "'");
+  }
+
+  return value;
+}
+
+
+Try<Nothing> Reader::stat(
+    initializer_list<pair<const char*, Option<uint64_t>*>> fields)
+{
+  Try<size_t> length = read();
+  if (length.isError()) {
+    return Error(length.error());
+  }
+
+  const char* current = buffer.data();
+  const char* end = buffer.data() + length.get();
+
+  while (current < end) {
+    const char* line = current;
+    const char* eol = static_cast<const char*>(
+        memchr(current, '\n', end - current));
+
+    if (eol == nullptr) {
+      eol = end;
+    }
+
+    current = eol + 1;
+
+    // Skip empty lines.
+    if (line == eol) {
+      continue;
+    }
+
+    // Expected line format: "%s %llu".
+    const char* space = static_cast<const char*>(
+        memchr(line, ' ', eol - line));
+
+    if (space == nullptr || space + 1 == eol || !isdigit(*(space + 1))) {
+      return Error("Unexpected line format in '" + file + "': " +
+                   string(line, eol - line));
+    }
+
+    const size_t size = space - line;
+
+    foreach (const auto& field, fields) {
+      if (strlen(field.first) != size ||
+          memcmp(field.first, line, size) != 0) {
+        continue;
+      }
+
+      uint64_t value = 0;
+      for (const char* digit = space + 1; digit < eol; ++digit) {
+        if (!isdigit(*digit)) {
+          return Error("Unexpected line format in '" + file + "': " +
+                       string(line, eol - line));
+        }
+
+        value = value * 10 + (*digit - '0');
+      }
+
+      *field.second = value;
+      break;
+    }
+  }
+
+  return Nothing();
+}
+
+
 namespace internal {
 
 // Helper for finding the cgroup of the specified pid for the
@@ -1944,6 +2113,20 @@ Try<uint64_t> shares(
 }
 
 
+Try<Duration> cfs_period_us(
+    const string& hierarchy,
+    const string& cgroup)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, "cpu.cfs_period_us");
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return Duration::parse(strings::trim(read.get()) + "us");
+}
+
+
 Try<Nothing> cfs_period_us(
     const string& hierarchy,
     const string& cgroup,
@@ -2418,6 +2601,135 @@ Future<uint64_t> Counter::value() const
 } // namespace memory {
 
 
+namespace cpuset {
+
+Try<string> cpus(const string& hierarchy, const string& cgroup)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, "cpuset.cpus");
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return strings::trim(read.get());
+}
+
+
+Try<Nothing> cpus(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& cpus)
+{
+  return cgroups::write(hierarchy, cgroup, "cpuset.cpus", cpus);
+}
+
+
+Try<string> mems(const string& hierarchy, const string& cgroup)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, "cpuset.mems");
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return strings::trim(read.get());
+}
+
+
+Try<Nothing> mems(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& mems)
+{
+  return cgroups::write(hierarchy, cgroup, "cpuset.mems", mems);
+}
+
+} // namespace cpuset {
+
+
+namespace hugetlb {
+
+// The controls are named after the page size in the kernel's format,
+// e.g., '2MB' or '1GB', which is also how Bytes are formatted.
+static string control(const Bytes& size, const string& name)
+{
+  return "hugetlb." + stringify(size) + "." + name;
+}
+
+
+static Try<Bytes> bytes(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, control);
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return Bytes::parse(strings::trim(read.get()) + "B");
+}
+
+
+Try<Bytes> limit_in_bytes(
+    const string& hierarchy,
+    const string& cgroup,
+    const Bytes& size)
+{
+  return bytes(hierarchy, cgroup, control(size, "limit_in_bytes"));
+}
+
+
+Try<Nothing> limit_in_bytes(
+    const string& hierarchy,
+    const string& cgroup,
+    const Bytes& size,
+    const Bytes& limit)
+{
+  return cgroups::write(
+      hierarchy,
+      cgroup,
+      control(size, "limit_in_bytes"),
+      stringify(limit.bytes()));
+}
+
+
+Try<Bytes> usage_in_bytes(
+    const string& hierarchy,
+    const string& cgroup,
+    const Bytes& size)
+{
+  return bytes(hierarchy, cgroup, control(size, "usage_in_bytes"));
+}
+
+
+Try<Bytes> max_usage_in_bytes(
+    const string& hierarchy,
+    const string& cgroup,
+    const Bytes& size)
+{
+  return bytes(hierarchy, cgroup, control(size, "max_usage_in_bytes"));
+}
+
+
+Try<uint64_t> failcnt(
+    const string& hierarchy,
+    const string& cgroup,
+    const Bytes& size)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, control(size, "failcnt"));
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return numify<uint64_t>(strings::trim(read.get()));
+}
+
+} // namespace hugetlb {
+
+
 namespace freezer {
 
 Future<Nothing> freeze(
@@ -20,8 +20,10 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <initializer_list>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <sys/types.h>
@@ -386,6 +388,44 @@ Try<hashmap<std::string, uint64_t>> stat(
     const std::string& file);
 
 
+// Reads a control file of a cgroup repeatedly, e.g., to collect the
+// statistics of a container on every poll. The file is opened on the
+// first read and kept open; each read starts over from the beginning
+// of the file using 'pread' into a buffer that is reused, and the
+// contents are parsed in place without allocating.
+// NOTE: This is not thread-safe.
+class Reader
+{
+public:
+  Reader(const std::string& hierarchy,
+         const std::string& cgroup,
+         const std::string& control);
+
+  ~Reader();
+
+  // Returns the value of a control that holds a single unsigned
+  // integer (Ex: "memory.usage_in_bytes").
+  Try<uint64_t> value();
+
+  // Parses a control of "<key> <value>" lines (Ex: "memory.stat") and
+  // sets each of the given fields whose key appears in the control.
+  // Keys which are not asked for are skipped.
+  Try<Nothing> stat(
+      std::initializer_list<std::pair<const char*, Option<uint64_t>*>> fields);
+
+private:
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  // Reads the whole control into 'buffer' and returns its length.
+  Try<size_t> read();
+
+  const std::string file;
+  Option<int> fd;
+  std::vector<char> buffer;
+};
+
+
 // Cpu controls.
 namespace cpu {
 
@@ -408,6 +448,12 @@ Try<uint64_t> shares(
     const std::string& cgroup);
 
 
+// Returns the cfs period from cpu.cfs_period_us.
+Try<Duration> cfs_period_us(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
 // Sets the cfs period using cpu.cfs_period_us.
 Try<Nothing> cfs_period_us(
     const std::string& hierarchy,
@@ -622,6 +668,86 @@ private:
 } // namespace memory {
 
 
+// Cpuset controls.
+namespace cpuset {
+
+// Returns the cpus of the cgroup from cpuset.cpus, in the kernel's
+// list format, e.g., "0-3,8-11".
+Try<std::string> cpus(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
+// Sets the cpus of the cgroup using cpuset.cpus.
+Try<Nothing> cpus(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::string& cpus);
+
+
+// Returns the memory nodes of the cgroup from cpuset.mems, in the
+// kernel's list format.
+Try<std::string> mems(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
+// Sets the memory nodes of the cgroup using cpuset.mems.
+Try<Nothing> mems(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::string& mems);
+
+} // namespace cpuset {
+
+
+// Hugetlb controls. The controls exist for each of the hugepage
+// sizes of the host, e.g., hugetlb.2MB.limit_in_bytes.
+namespace hugetlb {
+
+// Returns the limit of the hugepages of the given size from
+// hugetlb.<size>.limit_in_bytes.
+Try<Bytes> limit_in_bytes(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Bytes& size);
+
+
+// Sets the limit of the hugepages of the given size using
+// hugetlb.<size>.limit_in_bytes.
+Try<Nothing> limit_in_bytes(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Bytes& size,
+    const Bytes& limit);
+
+
+// Returns the usage of the hugepages of the given size from
+// hugetlb.<size>.usage_in_bytes.
+Try<Bytes> usage_in_bytes(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Bytes& size);
+
+
+// Returns the maximum usage of the hugepages of the given size
+// from hugetlb.<size>.max_usage_in_bytes.
+Try<Bytes> max_usage_in_bytes(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Bytes& size);
+
+
+// Returns the number of allocations of hugepages of the given size
+// which failed due to the limit, from hugetlb.<size>.failcnt.
+Try<uint64_t> failcnt(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Bytes& size);
+
+} // namespace hugetlb {
+
+
 // Freezer controls.
 // The freezer can be in one of three states:
 // 1. THAWED   : No process in the cgroup is frozen.
@@ -0,0 +1,184 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/syscall.h>
+
+#include <stout/error.hpp>
+#include <stout/os.hpp>
+#include <stout/strings.hpp>
+
+#include "linux/ebpf.hpp"
+
+using process::Owned;
+
+using std::string;
+using std::vector;
+
+namespace ebpf {
+
+static int bpf(enum bpf_cmd cmd, union bpf_attr* attr)
+{
+  return ::syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+
+bool supported()
+{
+  Try<Owned<Map>> map = Map::create(BPF_MAP_TYPE_ARRAY, 4, 4, 1);
+  return map.isSome();
+}
+
+
+Try<Owned<Map>> Map::create(
+    enum bpf_map_type type,
+    uint32_t keySize,
+    uint32_t valueSize,
+    uint32_t maxEntries)
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.map_type = type;
+  attr.key_size = keySize;
+  attr.value_size = valueSize;
+  attr.max_entries = maxEntries;
+
+  int fd = bpf(BPF_MAP_CREATE, &attr);
+  if (fd < 0) {
+    return ErrnoError("Failed to create the BPF map");
+  }
+
+  Try<Nothing> cloexec = os::cloexec(fd);
+  if (cloexec.isError()) {
+    os::close(fd);
+    return Error("Failed to set close-on-exec: " + cloexec.error());
+  }
+
+  return Owned<Map>(new Map(fd));
+}
+
+
+Map::~Map()
+{
+  os::close(fd_);
+}
+
+
+Try<Nothing> Map::update(const void* key, const void* value, uint64_t flags)
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.map_fd = fd_;
+  attr.key = (uint64_t) (uintptr_t) key;
+  attr.value = (uint64_t) (uintptr_t) value;
+  attr.flags = flags;
+
+  if (bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+    return ErrnoError("Failed to update the BPF map");
+  }
+
+  return Nothing();
+}
+
+
+Try<bool> Map::lookup(const void* key, void* value) const
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.map_fd = fd_;
+  attr.key = (uint64_t) (uintptr_t) key;
+  attr.value = (uint64_t) (uintptr_t) value;
+
+  if (bpf(BPF_MAP_LOOKUP_ELEM, &attr) < 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+
+    return ErrnoError("Failed to look up the BPF map");
+  }
+
+  return true;
+}
+
+
+Try<bool> Map::remove(const void* key)
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.map_fd = fd_;
+  attr.key = (uint64_t) (uintptr_t) key;
+
+  if (bpf(BPF_MAP_DELETE_ELEM, &attr) < 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+
+    return ErrnoError("Failed to remove from the BPF map");
+  }
+
+  return true;
+}
+
+
+Try<Owned<Program>> Program::load(
+    enum bpf_prog_type type,
+    const vector<struct bpf_insn>& instructions,
+    const string& license)
+{
+  // The log of the verifier, which explains why a program is
+  // rejected.
+  vector<char> log(64 * 1024, '\0');
+
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.prog_type = type;
+  attr.insns = (uint64_t) (uintptr_t) instructions.data();
+  attr.insn_cnt = instructions.size();
+  attr.license = (uint64_t) (uintptr_t) license.c_str();
+  attr.log_buf = (uint64_t) (uintptr_t) log.data();
+  attr.log_size = log.size();
+  attr.log_level = 1;
+
+  int fd = bpf(BPF_PROG_LOAD, &attr);
+  if (fd < 0) {
+    ErrnoError error("Failed to load the BPF program");
+
+    const string verifier = strings::trim(string(log.data()));
+    if (!verifier.empty()) {
+      return Error(error.message + ": " + verifier);
+    }
+
+    return error;
+  }
+
+  Try<Nothing> cloexec = os::cloexec(fd);
+  if (cloexec.isError()) {
+    os::close(fd);
+    return Error("Failed to set close-on-exec: " + cloexec.error());
+  }
+
+  return Owned<Program>(new Program(fd));
+}
+
+
+Program::~Program()
+{
+  os::close(fd_);
+}
+
+} // namespace ebpf {
@@ -0,0 +1,254 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __LINUX_EBPF_HPP__
+#define __LINUX_EBPF_HPP__
+
+#include <stdint.h>
+
+#include <linux/bpf.h>
+
+#include <string>
+#include <vector>
+
+#include <process/owned.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
+
+// A thin wrapper of the bpf(2) system call, which is used to create
+// eBPF maps and to load eBPF programs (e.g., traffic control
+// classifiers). This requires kernel 4.1 or newer.
+namespace ebpf {
+
+// Returns whether eBPF is supported on this host.
+bool supported();
+
+
+// An eBPF map, which stays alive as long as the map is open or is
+// referenced by a loaded program.
+class Map
+{
+public:
+  static Try<process::Owned<Map>> create(
+      enum bpf_map_type type,
+      uint32_t keySize,
+      uint32_t valueSize,
+      uint32_t maxEntries);
+
+  ~Map();
+
+  int fd() const { return fd_; }
+
+  // Creates or updates the value of the key. The flags are one of
+  // BPF_ANY, BPF_NOEXIST and BPF_EXIST.
+  Try<Nothing> update(
+      const void* key,
+      const void* value,
+      uint64_t flags = BPF_ANY);
+
+  // Returns false if the key does not exist.
+  Try<bool> lookup(const void* key, void* value) const;
+
+  // Returns false if the key does not exist.
+  Try<bool> remove(const void* key);
+
+private:
+  explicit Map(int _fd) : fd_(_fd) {}
+
+  Map(const Map&);
+  Map& operator=(const Map&);
+
+  const int fd_;
+};
+
+
+// An eBPF program which has passed the verifier. The program stays
+// alive as long as it is open or attached (e.g., to a filter).
+class Program
+{
+public:
+  static Try<process::Owned<Program>> load(
+      enum bpf_prog_type type,
+      const std::vector<struct bpf_insn>& instructions,
+      const std::string& license = "GPL");
+
+  ~Program();
+
+  int fd() const { return fd_; }
+
+private:
+  explicit Program(int _fd) : fd_(_fd) {}
+
+  Program(const Program&);
+  Program& operator=(const Program&);
+
+  const int fd_;
+};
+
+
+// Helpers to build eBPF instructions, similar to the macros of
+// 'include/linux/filter.h' in the kernel.
+namespace insn {
+
+inline struct bpf_insn make(
+    uint8_t code,
+    uint8_t dst,
+    uint8_t src,
+    int16_t offset,
+    int32_t imm)
+{
+  struct bpf_insn insn;
+  insn.code = code;
+  insn.dst_reg = dst;
+  insn.src_reg = src;
+  insn.off = offset;
+  insn.imm = imm;
+  return insn;
+}
+
+
+// dst = src (64 bits).
+inline struct bpf_insn mov(uint8_t dst, uint8_t src)
+{
+  return make(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0);
+}
+
+
+// dst = imm (64 bits, 'imm' is sign extended).
+inline struct bpf_insn mov64(uint8_t dst, int32_t imm)
+{
+  return make(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm);
+}
+
+
+// dst = imm (32 bits, the upper half is zeroed).
+inline struct bpf_insn mov32(uint8_t dst, uint32_t imm)
+{
+  return make(BPF_ALU | BPF_MOV | BPF_K, dst, 0, 0, (int32_t) imm);
+}
+
+
+// dst = dst <op> imm (64 bits), e.g., 'op' is BPF_AND.
+inline struct bpf_insn alu(uint8_t op, uint8_t dst, int32_t imm)
+{
+  return make(BPF_ALU64 | op | BPF_K, dst, 0, 0, imm);
+}
+
+
+// r0 = ntoh(*(size*)(skb->data + offset)), e.g., 'size' is BPF_H.
+// NOTE: This requires the context to be in r6. The program exits
+// (returning zero) if the packet is too short.
+inline struct bpf_insn ldAbs(uint8_t size, int32_t offset)
+{
+  return make(BPF_LD | size | BPF_ABS, 0, 0, 0, offset);
+}
+
+
+// r0 = ntoh(*(size*)(skb->data + src + offset)).
+inline struct bpf_insn ldInd(uint8_t size, uint8_t src, int32_t offset)
+{
+  return make(BPF_LD | size | BPF_IND, 0, src, 0, offset);
+}
+
+
+// dst = *(size*)(src + offset).
+inline struct bpf_insn load(
+    uint8_t size,
+    uint8_t dst,
+    uint8_t src,
+    int16_t offset)
+{
+  return make(BPF_LDX | size | BPF_MEM, dst, src, offset, 0);
+}
+
+
+// *(size*)(dst + offset) = src.
+inline struct bpf_insn store(
+    uint8_t size,
+    uint8_t dst,
+    uint8_t src,
+    int16_t offset)
+{
+  return make(BPF_STX | size | BPF_MEM, dst, src, offset, 0);
+}
+
+
+// *(size*)(dst + offset) += src, atomically. 'size' is BPF_W or
+// BPF_DW.
+inline struct bpf_insn add(
+    uint8_t size,
+    uint8_t dst,
+    uint8_t src,
+    int16_t offset)
+{
+  return make(BPF_STX | size | BPF_XADD, dst, src, offset, 0);
+}
+
+
+// Jumps 'offset' instructions ahead if 'dst <op> imm', e.g., 'op' is
+// BPF_JEQ. NOTE: 'imm' is sign extended.
+inline struct bpf_insn jump(
+    uint8_t op,
+    uint8_t dst,
+    int32_t imm,
+    int16_t offset)
+{
+  return make(BPF_JMP | op | BPF_K, dst, 0, offset, imm);
+}
+
+
+// Jumps 'offset' instructions ahead if 'dst <op> src'.
+inline struct bpf_insn jumpX(
+    uint8_t op,
+    uint8_t dst,
+    uint8_t src,
+    int16_t offset)
+{
+  return make(BPF_JMP | op | BPF_X, dst, src, offset, 0);
+}
+
+
+// Calls the helper function, e.g., BPF_FUNC_map_lookup_elem.
+inline struct bpf_insn call(int32_t function)
+{
+  return make(BPF_JMP | BPF_CALL, 0, 0, 0, function);
+}
+
+
+// Returns r0.
+inline struct bpf_insn ret()
+{
+  return make(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+}
+
+
+// dst = map. NOTE: This takes two instructions.
+inline void loadMap(
+    std::vector<struct bpf_insn>* instructions,
+    uint8_t dst,
+    const Map& map)
+{
+  instructions->push_back(
+      make(BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, map.fd()));
+
+  instructions->push_back(make(0, 0, 0, 0, 0));
+}
+
+} // namespace insn {
+} // namespace ebpf {
+
+#endif // __LINUX_EBPF_HPP__
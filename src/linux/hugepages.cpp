@@ -0,0 +1,111 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <list>
+#include <string>
+
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+
+#include "linux/hugepages.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace hugepages {
+
+static const string HUGEPAGES = "/sys/kernel/mm/hugepages";
+
+
+static Try<uint64_t> read(const string& pool, const string& file)
+{
+  Try<string> read = os::read(path::join(HUGEPAGES, pool, file));
+  if (read.isError()) {
+    return Error("Failed to read '" + file + "': " + read.error());
+  }
+
+  Try<uint64_t> value = numify<uint64_t>(strings::trim(read.get()));
+  if (value.isError()) {
+    return Error("Failed to parse '" + file + "': " + value.error());
+  }
+
+  return value.get();
+}
+
+
+Try<vector<Pool>> pools()
+{
+  vector<Pool> pools;
+
+  if (!os::exists(HUGEPAGES)) {
+    return pools;
+  }
+
+  Try<list<string>> entries = os::ls(HUGEPAGES);
+  if (entries.isError()) {
+    return Error("Failed to list '" + HUGEPAGES + "': " + entries.error());
+  }
+
+  // The pools are named after their page size, e.g., 'hugepages-2048kB'.
+  foreach (const string& entry, entries.get()) {
+    if (!strings::startsWith(entry, "hugepages-") ||
+        !strings::endsWith(entry, "kB")) {
+      continue;
+    }
+
+    Try<uint64_t> kilobytes = numify<uint64_t>(
+        strings::remove(
+            strings::remove(entry, "hugepages-", strings::PREFIX),
+            "kB",
+            strings::SUFFIX));
+
+    if (kilobytes.isError()) {
+      return Error(
+          "Failed to parse the page size of '" + entry + "': " +
+          kilobytes.error());
+    }
+
+    Try<uint64_t> total = read(entry, "nr_hugepages");
+    if (total.isError()) {
+      return Error(total.error());
+    }
+
+    Try<uint64_t> free = read(entry, "free_hugepages");
+    if (free.isError()) {
+      return Error(free.error());
+    }
+
+    Pool pool;
+    pool.size = Kilobytes(kilobytes.get());
+    pool.total = total.get();
+    pool.free = free.get();
+
+    pools.push_back(pool);
+  }
+
+  std::sort(pools.begin(), pools.end(), [](const Pool& a, const Pool& b) {
+    return a.size < b.size;
+  });
+
+  return pools;
+}
+
+} // namespace hugepages {
@@ -0,0 +1,50 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __LINUX_HUGEPAGES_HPP__
+#define __LINUX_HUGEPAGES_HPP__
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <stout/bytes.hpp>
+#include <stout/try.hpp>
+
+// Discovery of the hugepage pools of the host through sysfs, see
+// https://www.kernel.org/doc/Documentation/vm/hugetlbpage.txt
+namespace hugepages {
+
+struct Pool
+{
+  // The size of the pages of the pool, e.g., 2MB.
+  Bytes size;
+
+  // The number of persistent hugepages in the pool (nr_hugepages).
+  uint64_t total;
+
+  // The number of hugepages which are not allocated (free_hugepages).
+  uint64_t free;
+};
+
+
+// Returns the hugepage pools of the host, ordered by page size, or
+// none if the kernel does not support hugepages.
+Try<std::vector<Pool>> pools();
+
+} // namespace hugepages {
+
+#endif // __LINUX_HUGEPAGES_HPP__
@@ -0,0 +1,212 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <list>
+
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+
+#include "linux/numa.hpp"
+
+using std::list;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace numa {
+
+static const string NODES = "/sys/devices/system/node";
+
+
+// Returns the total memory of a node from its meminfo, which has
+// lines of the form "Node 0 MemTotal:       16330264 kB".
+static Try<Bytes> memory(const string& node)
+{
+  Try<string> read = os::read(path::join(NODES, node, "meminfo"));
+  if (read.isError()) {
+    return Error("Failed to read meminfo: " + read.error());
+  }
+
+  foreach (const string& line, strings::tokenize(read.get(), "\n")) {
+    vector<string> tokens = strings::tokenize(line, " ");
+    if (tokens.size() == 5 && tokens[2] == "MemTotal:" && tokens[4] == "kB") {
+      Try<uint64_t> kilobytes = numify<uint64_t>(tokens[3]);
+      if (kilobytes.isError()) {
+        return Error("Failed to parse '" + line + "': " + kilobytes.error());
+      }
+
+      return Kilobytes(kilobytes.get());
+    }
+  }
+
+  return Error("Failed to find MemTotal in meminfo");
+}
+
+
+Try<vector<Node>> nodes()
+{
+  vector<Node> nodes;
+
+  if (!os::exists(NODES)) {
+    // The kernel does not support NUMA, fall back to a single node.
+    Try<string> online = os::read("/sys/devices/system/cpu/online");
+    if (online.isError()) {
+      return Error("Failed to read the online CPUs: " + online.error());
+    }
+
+    Try<set<unsigned int>> cpus = parse(online.get());
+    if (cpus.isError()) {
+      return Error("Failed to parse the online CPUs: " + cpus.error());
+    }
+
+    Try<os::Memory> memory = os::memory();
+    if (memory.isError()) {
+      return Error("Failed to get the memory: " + memory.error());
+    }
+
+    Node node;
+    node.id = 0;
+    node.cpus = cpus.get();
+    node.memory = memory.get().total;
+
+    nodes.push_back(node);
+
+    return nodes;
+  }
+
+  Try<list<string>> entries = os::ls(NODES);
+  if (entries.isError()) {
+    return Error("Failed to list '" + NODES + "': " + entries.error());
+  }
+
+  foreach (const string& entry, entries.get()) {
+    if (!strings::startsWith(entry, "node")) {
+      continue;
+    }
+
+    Try<unsigned int> id = numify<unsigned int>(entry.substr(4));
+    if (id.isError()) {
+      continue; // Not a node, e.g., 'node_stat'.
+    }
+
+    Try<string> cpulist = os::read(path::join(NODES, entry, "cpulist"));
+    if (cpulist.isError()) {
+      return Error(
+          "Failed to read the CPUs of node " + stringify(id.get()) + ": " +
+          cpulist.error());
+    }
+
+    Try<set<unsigned int>> cpus = parse(cpulist.get());
+    if (cpus.isError()) {
+      return Error(
+          "Failed to parse the CPUs of node " + stringify(id.get()) + ": " +
+          cpus.error());
+    }
+
+    Try<Bytes> memory = numa::memory(entry);
+    if (memory.isError()) {
+      return Error(
+          "Failed to get the memory of node " + stringify(id.get()) + ": " +
+          memory.error());
+    }
+
+    // Skip the nodes which have been offlined entirely.
+    if (cpus.get().empty() && memory.get() == Bytes(0)) {
+      continue;
+    }
+
+    Node node;
+    node.id = id.get();
+    node.cpus = cpus.get();
+    node.memory = memory.get();
+
+    nodes.push_back(node);
+  }
+
+  if (nodes.empty()) {
+    return Error("No NUMA nodes found in '" + NODES + "'");
+  }
+
+  std::sort(nodes.begin(), nodes.end(), [](const Node& a, const Node& b) {
+    return a.id < b.id;
+  });
+
+  return nodes;
+}
+
+
+Try<set<unsigned int>> parse(const string& list)
+{
+  set<unsigned int> ids;
+
+  foreach (const string& token, strings::tokenize(strings::trim(list), ",")) {
+    vector<string> range = strings::split(token, "-");
+    if (range.size() > 2) {
+      return Error("Invalid range '" + token + "'");
+    }
+
+    Try<unsigned int> first = numify<unsigned int>(range[0]);
+    if (first.isError()) {
+      return Error("Invalid id '" + range[0] + "': " + first.error());
+    }
+
+    Try<unsigned int> last = first;
+    if (range.size() == 2) {
+      last = numify<unsigned int>(range[1]);
+      if (last.isError()) {
+        return Error("Invalid id '" + range[1] + "': " + last.error());
+      } else if (last.get() < first.get()) {
+        return Error("Invalid range '" + token + "'");
+      }
+    }
+
+    for (unsigned int id = first.get(); id <= last.get(); id++) {
+      ids.insert(id);
+    }
+  }
+
+  return ids;
+}
+
+
+string format(const set<unsigned int>& ids)
+{
+  vector<string> ranges;
+
+  set<unsigned int>::const_iterator it = ids.begin();
+  while (it != ids.end()) {
+    const unsigned int first = *it;
+    unsigned int last = first;
+
+    while (++it != ids.end() && *it == last + 1) {
+      last = *it;
+    }
+
+    if (first == last) {
+      ranges.push_back(stringify(first));
+    } else {
+      ranges.push_back(stringify(first) + "-" + stringify(last));
+    }
+  }
+
+  return strings::join(",", ranges);
+}
+
+} // namespace numa {
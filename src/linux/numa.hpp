@@ -0,0 +1,60 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __LINUX_NUMA_HPP__
+#define __LINUX_NUMA_HPP__
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <stout/bytes.hpp>
+#include <stout/try.hpp>
+
+// Discovery of the NUMA topology of the host through sysfs, see
+// https://www.kernel.org/doc/Documentation/ABI/stable/sysfs-devices-node
+namespace numa {
+
+struct Node
+{
+  unsigned int id;
+
+  // The online CPUs of the node.
+  std::set<unsigned int> cpus;
+
+  // The total memory of the node.
+  Bytes memory;
+};
+
+
+// Returns the NUMA nodes with online CPUs or memory, ordered by id.
+// Hosts without NUMA support (e.g., the kernel is built without
+// CONFIG_NUMA) are reported as a single node 0 spanning all online
+// CPUs and memory.
+Try<std::vector<Node>> nodes();
+
+
+// Parses a list in the kernel's list format (e.g., "0-3,8,10-11"),
+// as used by cpulist and cpuset.{cpus,mems}.
+Try<std::set<unsigned int>> parse(const std::string& list);
+
+
+// Formats a set of ids in the kernel's list format.
+std::string format(const std::set<unsigned int>& ids);
+
+} // namespace numa {
+
+#endif // __LINUX_NUMA_HPP__
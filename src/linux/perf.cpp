@@ -14,17 +14,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fcntl.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <linux/perf_event.h>
+
 #include <sys/prctl.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
 #include <list>
 #include <sstream>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <process/clock.hpp>
@@ -50,6 +57,7 @@ using process::await;
 
 using std::list;
 using std::ostringstream;
+using std::pair;
 using std::set;
 using std::string;
 using std::tuple;
@@ -396,6 +404,251 @@ bool valid(const set<string>& events)
 }
 
 
+// Returns the perf_event_attr type and config of an event, given its
+// normalized name, see perf_event_open(2).
+static Try<pair<uint32_t, uint64_t>> attribute(const string& event)
+{
+  static const hashmap<string, pair<uint32_t, uint64_t>> events = {
+    {"cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+    {"stalled_cycles_frontend",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND}},
+    {"stalled_cycles_backend",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND}},
+    {"instructions", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+    {"cache_references",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES}},
+    {"cache_misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}},
+    {"branches", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS}},
+    {"branch_misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}},
+    {"bus_cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES}},
+    {"ref_cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES}},
+    {"cpu_clock", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK}},
+    {"task_clock", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}},
+    {"page_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}},
+    {"minor_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN}},
+    {"major_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ}},
+    {"context_switches",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}},
+    {"cpu_migrations", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS}},
+    {"alignment_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_ALIGNMENT_FAULTS}},
+    {"emulation_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_EMULATION_FAULTS}},
+  };
+
+  if (events.contains(event)) {
+    return events.get(event).get();
+  }
+
+  // Hardware cache events are named '<cache>_<operation>[_misses]'.
+  static const vector<pair<string, uint64_t>> caches = {
+    {"l1_dcache_", PERF_COUNT_HW_CACHE_L1D},
+    {"l1_icache_", PERF_COUNT_HW_CACHE_L1I},
+    {"llc_", PERF_COUNT_HW_CACHE_LL},
+    {"dtlb_", PERF_COUNT_HW_CACHE_DTLB},
+    {"itlb_", PERF_COUNT_HW_CACHE_ITLB},
+    {"branch_", PERF_COUNT_HW_CACHE_BPU},
+    {"node_", PERF_COUNT_HW_CACHE_NODE},
+  };
+
+  static const hashmap<string, pair<uint64_t, uint64_t>> operations = {
+    {"loads", {PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_ACCESS}},
+    {"load_misses",
+     {PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS}},
+    {"stores",
+     {PERF_COUNT_HW_CACHE_OP_WRITE, PERF_COUNT_HW_CACHE_RESULT_ACCESS}},
+    {"store_misses",
+     {PERF_COUNT_HW_CACHE_OP_WRITE, PERF_COUNT_HW_CACHE_RESULT_MISS}},
+    {"prefetches",
+     {PERF_COUNT_HW_CACHE_OP_PREFETCH, PERF_COUNT_HW_CACHE_RESULT_ACCESS}},
+    {"prefetch_misses",
+     {PERF_COUNT_HW_CACHE_OP_PREFETCH, PERF_COUNT_HW_CACHE_RESULT_MISS}},
+  };
+
+  foreach (const auto& cache, caches) {
+    if (!strings::startsWith(event, cache.first)) {
+      continue;
+    }
+
+    const string operation = event.substr(cache.first.size());
+    if (operations.contains(operation)) {
+      return std::make_pair(
+          (uint32_t) PERF_TYPE_HW_CACHE,
+          cache.second |
+          (operations.get(operation)->first << 8) |
+          (operations.get(operation)->second << 16));
+    }
+  }
+
+  return Error("Unsupported event");
+}
+
+
+Try<Owned<Counters>> Counters::create(
+    const set<string>& events,
+    const string& cgroup)
+{
+  vector<string> names;
+  vector<pair<uint32_t, uint64_t>> attributes;
+
+  foreach (const string& event, events) {
+    const string name = internal::normalize(event);
+
+    Try<pair<uint32_t, uint64_t>> attribute = perf::attribute(name);
+    if (attribute.isError()) {
+      return Error("Unsupported perf event '" + event + "'");
+    }
+
+    names.push_back(name);
+    attributes.push_back(attribute.get());
+  }
+
+  if (names.empty()) {
+    return Error("No perf events specified");
+  }
+
+  int fd = ::open(cgroup.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return ErrnoError("Failed to open cgroup '" + cgroup + "'");
+  }
+
+  Owned<Counters> counters(new Counters(names, fd));
+
+  const long cpus = sysconf(_SC_NPROCESSORS_CONF);
+
+  for (int cpu = 0; cpu < cpus; cpu++) {
+    int leader = -1;
+
+    for (size_t i = 0; i < attributes.size(); i++) {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+
+      attr.size = sizeof(attr);
+      attr.type = attributes[i].first;
+      attr.config = attributes[i].second;
+
+      // Read the whole group at once, along with the times needed to
+      // scale the counts in case the counters were multiplexed.
+      attr.read_format =
+        PERF_FORMAT_GROUP |
+        PERF_FORMAT_TOTAL_TIME_ENABLED |
+        PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      // NOTE: Cgroup events are counted per CPU, hence there is a
+      // group of events on every CPU.
+      int event = syscall(
+          __NR_perf_event_open,
+          &attr,
+          counters->cgroup,
+          cpu,
+          leader,
+          PERF_FLAG_PID_CGROUP);
+
+      if (event < 0) {
+        // Skip offline CPUs.
+        if (errno == ENODEV && leader == -1) {
+          break;
+        }
+
+        return ErrnoError(
+            "Failed to open perf event '" + names[i] + "' on CPU " +
+            stringify(cpu));
+      }
+
+      counters->fds.push_back(event);
+
+      Try<Nothing> cloexec = os::cloexec(event);
+      if (cloexec.isError()) {
+        return Error("Failed to set close-on-exec: " + cloexec.error());
+      }
+
+      if (leader == -1) {
+        leader = event;
+        counters->leaders.push_back(event);
+      }
+    }
+  }
+
+  if (counters->leaders.empty()) {
+    return Error("No online CPUs to count perf events on");
+  }
+
+  return counters;
+}
+
+
+Counters::~Counters()
+{
+  foreach (int fd, fds) {
+    os::close(fd);
+  }
+
+  os::close(cgroup);
+}
+
+
+Try<mesos::PerfStatistics> Counters::read() const
+{
+  // See PERF_FORMAT_GROUP in perf_event_open(2), the group is read as:
+  //   { nr, time_enabled, time_running, values[nr] }
+  vector<uint64_t> buffer(3 + events.size());
+  vector<double> counts(events.size(), 0);
+
+  foreach (int leader, leaders) {
+    const size_t size = buffer.size() * sizeof(uint64_t);
+
+    ssize_t length = ::read(leader, buffer.data(), size);
+    if (length < 0) {
+      return ErrnoError("Failed to read perf events");
+    } else if ((size_t) length != size || buffer[0] != events.size()) {
+      return Error("Unexpected size of perf events read");
+    }
+
+    const uint64_t enabled = buffer[1];
+    const uint64_t running = buffer[2];
+
+    // The group was not scheduled yet, e.g., nothing ran in the
+    // cgroup on this CPU.
+    if (running == 0) {
+      continue;
+    }
+
+    for (size_t i = 0; i < events.size(); i++) {
+      counts[i] += buffer[3 + i] * ((double) enabled / running);
+    }
+  }
+
+  mesos::PerfStatistics statistics;
+
+  const google::protobuf::Reflection* reflection =
+    statistics.GetReflection();
+
+  for (size_t i = 0; i < events.size(); i++) {
+    const google::protobuf::FieldDescriptor* field =
+      statistics.GetDescriptor()->FindFieldByName(events[i]);
+
+    if (field == NULL) {
+      return Error("Unexpected event '" + events[i] + "'");
+    }
+
+    switch (field->type()) {
+      case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+        // The clock events count nanoseconds, while `perf stat`
+        // reports them (and the statistics hold them) in milliseconds.
+        reflection->SetDouble(&statistics, field, counts[i] / 1000000);
+        break;
+      case google::protobuf::FieldDescriptor::TYPE_UINT64:
+        reflection->SetUInt64(&statistics, field, (uint64_t) counts[i]);
+        break;
+      default:
+        return Error("Unsupported perf field type of '" + events[i] + "'");
+    }
+  }
+
+  return statistics;
+}
+
+
 struct Sample
 {
   const string value;
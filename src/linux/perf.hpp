@@ -21,11 +21,14 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/try.hpp>
 
 // For PerfStatistics protobuf.
 #include "mesos/mesos.hpp"
@@ -51,6 +54,50 @@ bool valid(const std::set<std::string>& events);
 bool supported();
 
 
+// Counts perf events for the process(es) in a perf_event cgroup using
+// perf_event_open(2) directly, rather than running `perf stat`. The
+// events are opened as a group on every CPU when the counters are
+// created and they keep counting until the counters are destroyed,
+// hence samples can be taken at any time by subtracting two counts.
+// NOTE: The events are named like for `perf stat`, but only the
+// events of the PerfStatistics protobuf are supported.
+class Counters
+{
+public:
+  // NOTE: 'cgroup' is the absolute path of the cgroup, e.g.,
+  // /sys/fs/cgroup/perf_event/mesos/test.
+  static Try<process::Owned<Counters>> create(
+      const std::set<std::string>& events,
+      const std::string& cgroup);
+
+  ~Counters();
+
+  // Returns the counts of all the events since the counters were
+  // created, scaled up if the events were not always counting
+  // because the hardware counters were multiplexed. The timestamp
+  // and duration of the statistics are not set.
+  Try<mesos::PerfStatistics> read() const;
+
+private:
+  Counters(const std::vector<std::string>& _events, int _cgroup)
+    : events(_events), cgroup(_cgroup) {}
+
+  Counters(const Counters&);
+  Counters& operator=(const Counters&);
+
+  // The normalized names of the events, in the order of the group.
+  const std::vector<std::string> events;
+
+  // The file descriptor of the cgroup directory.
+  const int cgroup;
+
+  // The file descriptors of the events, and those of the group
+  // leaders (one per CPU) which are used to read the whole group.
+  std::vector<int> fds;
+  std::vector<int> leaders;
+};
+
+
 // Note: The parse function is exposed to allow testing of the
 // multiple supported perf stat output formats.
 Try<hashmap<std::string, mesos::PerfStatistics>> parse(
@@ -0,0 +1,187 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include <arpa/inet.h>
+
+#include <linux/if_ether.h>
+#include <linux/pkt_cls.h>
+#include <linux/rtnetlink.h>
+
+#include <netlink/attr.h>
+#include <netlink/errno.h>
+#include <netlink/msg.h>
+#include <netlink/netlink.h>
+
+#include <stout/error.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+#include <stout/result.hpp>
+
+#include "linux/routing/internal.hpp"
+
+#include "linux/routing/filter/bpf.hpp"
+
+#include "linux/routing/link/internal.hpp"
+
+using std::string;
+
+namespace routing {
+namespace filter {
+namespace bpf {
+
+// The handle of the filters created by us. A BPF filter is the only
+// one in its priority hence it can always use the same handle.
+static const uint32_t HANDLE = 1;
+
+
+// Sends the request to create or remove the BPF filter and waits for
+// it to be acknowledged. Returns the (negative) libnl error.
+static Try<int> send(
+    int type,
+    int flags,
+    const string& _link,
+    const Handle& parent,
+    const Priority& priority,
+    const Option<int>& fd,
+    const string& name)
+{
+  Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
+  if (link.isError()) {
+    return Error(link.error());
+  } else if (link.isNone()) {
+    return Error("Link '" + _link + "' is not found");
+  }
+
+  Try<Netlink<struct nl_sock>> socket = routing::socket();
+  if (socket.isError()) {
+    return Error(socket.error());
+  }
+
+  struct nl_msg* msg = nlmsg_alloc_simple(type, flags);
+  if (msg == NULL) {
+    return Error("Failed to allocate the netlink message");
+  }
+
+  struct tcmsg tcm;
+  memset(&tcm, 0, sizeof(tcm));
+  tcm.tcm_family = AF_UNSPEC;
+  tcm.tcm_ifindex = rtnl_link_get_ifindex(link.get().get());
+  tcm.tcm_parent = parent.get();
+  tcm.tcm_handle = fd.isSome() ? HANDLE : 0;
+  tcm.tcm_info = TC_H_MAKE(((uint32_t) priority.get()) << 16, htons(ETH_P_ALL));
+
+  int error = nlmsg_append(msg, &tcm, sizeof(tcm), NLMSG_ALIGNTO);
+  if (error == 0) {
+    error = nla_put_string(msg, TCA_KIND, "bpf");
+  }
+
+  if (error == 0 && fd.isSome()) {
+    struct nlattr* options = nla_nest_start(msg, TCA_OPTIONS);
+    if (options == NULL) {
+      error = -NLE_NOMEM;
+    } else {
+      error = nla_put_u32(msg, TCA_BPF_FD, fd.get());
+
+      if (error == 0) {
+        error = nla_put_string(msg, TCA_BPF_NAME, name.c_str());
+      }
+
+      if (error == 0) {
+        error = nla_put_u32(msg, TCA_BPF_FLAGS, TCA_BPF_FLAG_ACT_DIRECT);
+      }
+
+      if (error == 0) {
+        error = nla_nest_end(msg, options);
+      }
+    }
+  }
+
+  if (error != 0) {
+    nlmsg_free(msg);
+    return Error(
+        "Failed to build the netlink message: " +
+        string(nl_geterror(error)));
+  }
+
+  error = nl_send_auto(socket.get().get(), msg);
+  nlmsg_free(msg);
+
+  if (error < 0) {
+    return Error(
+        "Failed to send the netlink message: " +
+        string(nl_geterror(error)));
+  }
+
+  return nl_wait_for_ack(socket.get().get());
+}
+
+
+Try<Nothing> create(
+    const string& link,
+    const Handle& parent,
+    const Priority& priority,
+    int fd,
+    const string& name)
+{
+  Try<int> error = send(
+      RTM_NEWTFILTER,
+      NLM_F_CREATE | NLM_F_REPLACE,
+      link,
+      parent,
+      priority,
+      fd,
+      name);
+
+  if (error.isError()) {
+    return Error(error.error());
+  } else if (error.get() != 0) {
+    return Error(string(nl_geterror(error.get())));
+  }
+
+  return Nothing();
+}
+
+
+Try<bool> remove(
+    const string& link,
+    const Handle& parent,
+    const Priority& priority)
+{
+  Try<int> error = send(
+      RTM_DELTFILTER,
+      0,
+      link,
+      parent,
+      priority,
+      None(),
+      "");
+
+  if (error.isError()) {
+    return Error(error.error());
+  } else if (error.get() == -NLE_OBJ_NOTFOUND) {
+    return false;
+  } else if (error.get() != 0) {
+    return Error(string(nl_geterror(error.get())));
+  }
+
+  return true;
+}
+
+} // namespace bpf {
+} // namespace filter {
+} // namespace routing {
@@ -0,0 +1,61 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __LINUX_ROUTING_FILTER_BPF_HPP__
+#define __LINUX_ROUTING_FILTER_BPF_HPP__
+
+#include <string>
+
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
+
+#include "linux/routing/handle.hpp"
+
+#include "linux/routing/filter/priority.hpp"
+
+namespace routing {
+namespace filter {
+namespace bpf {
+
+// Creates a BPF filter with the given priority attached to the given
+// parent on the link, or replaces the program of the existing one.
+// The filter matches all the packets (of any protocol) and runs the
+// eBPF program in direct-action mode, i.e., the return value of the
+// program is the action: for example, TC_ACT_REDIRECT (using the
+// bpf_redirect helper), or TC_ACT_UNSPEC to let the packet be sent to
+// the next filter. 'fd' is the file descriptor of a loaded program of
+// type BPF_PROG_TYPE_SCHED_CLS. This requires kernel 4.4 or newer.
+Try<Nothing> create(
+    const std::string& link,
+    const Handle& parent,
+    const Priority& priority,
+    int fd,
+    const std::string& name);
+
+
+// Removes the BPF filter with the given priority attached to the
+// given parent from the link. Returns false if the filter is not
+// found.
+Try<bool> remove(
+    const std::string& link,
+    const Handle& parent,
+    const Priority& priority);
+
+} // namespace bpf {
+} // namespace filter {
+} // namespace routing {
+
+#endif // __LINUX_ROUTING_FILTER_BPF_HPP__
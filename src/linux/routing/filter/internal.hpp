@@ -19,8 +19,15 @@
 
 #include <stdint.h>
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <linux/netlink.h>
+
 #include <netlink/cache.h>
 #include <netlink/errno.h>
+#include <netlink/msg.h>
+#include <netlink/netlink.h>
 #include <netlink/object.h>
 #include <netlink/socket.h>
 
@@ -33,6 +40,7 @@
 #include <netlink/route/cls/basic.h>
 #include <netlink/route/cls/u32.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -271,20 +279,23 @@ inline Try<Nothing> attach(
 }
 
 
-// Generates the handle for the given filter on the link. Returns none
-// if we decide to let the kernel choose the handle.
-template <typename Classifier>
-Result<U32Handle> generateU32Handle(
-    const Netlink<struct rtnl_link>& link,
-    const Filter<Classifier>& filter)
+// The handles of the u32 filters attached to a parent on a link.
+struct U32Handles
 {
-  // If the user does not specify a priority, we have no choice but
-  // let the kernel choose the handle because we do not know the
-  // 'htid' that is associated with that priority.
-  if (filter.priority.isNone()) {
-    return None();
-  }
+  // A map from priority to the corresponding 'htid'.
+  hashmap<uint16_t, uint32_t> htids;
 
+  // A map from 'htid' to a set of already used nodes.
+  hashmap<uint32_t, hashset<uint32_t>> nodes;
+};
+
+
+// Returns the handles of the u32 filters attached to the given parent
+// on the link.
+inline Try<U32Handles> getU32Handles(
+    const Netlink<struct rtnl_link>& link,
+    const Handle& parent)
+{
   // Scan all the filters attached to the given parent on the link.
   Try<Netlink<struct nl_sock>> socket = routing::socket();
   if (socket.isError()) {
@@ -297,7 +308,7 @@ Result<U32Handle> generateU32Handle(
   int error = rtnl_cls_alloc_cache(
       socket.get().get(),
       rtnl_link_get_ifindex(link.get()),
-      filter.parent.get(),
+      parent.get(),
       &c);
 
   if (error != 0) {
@@ -308,11 +319,7 @@ Result<U32Handle> generateU32Handle(
 
   Netlink<struct nl_cache> cache(c);
 
-  // A map from priority to the corresponding 'htid'.
-  hashmap<uint16_t, uint32_t> htids;
-
-  // A map from 'htid' to a set of already used nodes.
-  hashmap<uint32_t, hashset<uint32_t>> nodes;
+  U32Handles handles;
 
   for (struct nl_object* o = nl_cache_get_first(cache.get());
        o != NULL; o = nl_cache_get_next(o)) {
@@ -323,15 +330,34 @@ Result<U32Handle> generateU32Handle(
     if (rtnl_tc_get_kind(TC_CAST(cls)) == std::string("u32")) {
       U32Handle handle(rtnl_tc_get_handle(TC_CAST(cls)));
 
-      htids[rtnl_cls_get_prio(cls)] = handle.htid();
-      nodes[handle.htid()].insert(handle.node());
+      handles.htids[rtnl_cls_get_prio(cls)] = handle.htid();
+      handles.nodes[handle.htid()].insert(handle.node());
     }
   }
 
+  return handles;
+}
+
+
+// Generates the handle for the given filter from the handles already
+// used, and marks it as used. Returns none if we decide to let the
+// kernel choose the handle.
+template <typename Classifier>
+Result<U32Handle> generateU32Handle(
+    U32Handles* handles,
+    const Filter<Classifier>& filter)
+{
+  // If the user does not specify a priority, we have no choice but
+  // let the kernel choose the handle because we do not know the
+  // 'htid' that is associated with that priority.
+  if (filter.priority.isNone()) {
+    return None();
+  }
+
   // If this filter has a new priority, we need to let the kernel
   // decide the handle because we don't know which 'htid' this
   // priority will be associated with.
-  if (!htids.contains(filter.priority.get().get())) {
+  if (!handles->htids.contains(filter.priority.get().get())) {
     return None();
   }
 
@@ -339,9 +365,10 @@ Result<U32Handle> generateU32Handle(
   // means all filters will be in hash bucket 0. Also, kernel assigns
   // node id starting from 0x800 by default. Here, we keep the same
   // semantics as kernel.
-  uint32_t htid = htids[filter.priority.get().get()];
+  uint32_t htid = handles->htids[filter.priority.get().get()];
   for (uint32_t node = 0x800; node <= 0xfff; node++) {
-    if (!nodes[htid].contains(node)) {
+    if (!handles->nodes[htid].contains(node)) {
+      handles->nodes[htid].insert(node);
       return U32Handle(htid, 0x0, node);
     }
   }
@@ -350,13 +377,35 @@ Result<U32Handle> generateU32Handle(
 }
 
 
+// Generates the handle for the given filter on the link. Returns none
+// if we decide to let the kernel choose the handle.
+template <typename Classifier>
+Result<U32Handle> generateU32Handle(
+    const Netlink<struct rtnl_link>& link,
+    const Filter<Classifier>& filter)
+{
+  if (filter.priority.isNone()) {
+    return None();
+  }
+
+  Try<U32Handles> handles = getU32Handles(link, filter.parent);
+  if (handles.isError()) {
+    return Error(handles.error());
+  }
+
+  return generateU32Handle(&handles.get(), filter);
+}
+
+
 // Encodes a filter (in our representation) to a libnl filter
 // (rtnl_cls). We use template here so that it works for any type of
-// classifier.
+// classifier. If 'handles' is specified, the handle of a u32 filter
+// is generated from them rather than from the filters on the link.
 template <typename Classifier>
 Try<Netlink<struct rtnl_cls>> encodeFilter(
     const Netlink<struct rtnl_link>& link,
-    const Filter<Classifier>& filter)
+    const Filter<Classifier>& filter,
+    U32Handles* handles = NULL)
 {
   struct rtnl_cls* c = rtnl_cls_alloc();
   if (c == NULL) {
@@ -400,7 +449,10 @@ Try<Netlink<struct rtnl_cls>> encodeFilter(
     // handle of the filter by picking an unused handle.
     // TODO(jieyu): Revisit this once the kernel bug is fixed.
     if (rtnl_tc_get_kind(TC_CAST(cls.get())) == std::string("u32")) {
-      Result<U32Handle> handle = generateU32Handle(link, filter);
+      Result<U32Handle> handle = handles != NULL
+        ? generateU32Handle(handles, filter)
+        : generateU32Handle(link, filter);
+
       if (handle.isError()) {
         return Error("Failed to find an unused u32 handle: " + handle.error());
       }
@@ -557,6 +609,77 @@ Result<Netlink<struct rtnl_cls>> getCls(
   return None();
 }
 
+// The maximum number of netlink requests sent with a single sendmsg
+// call. The kernel acknowledges each request separately, and these
+// acknowledgements need to fit into the receive buffer of the socket.
+constexpr size_t MAX_BATCH_SIZE = 32;
+
+
+// Sends the libnl filter requests to the kernel, batching up to
+// `MAX_BATCH_SIZE` of them in each sendmsg call, and then waits for
+// them to be acknowledged. Returns, for each request, zero if it has
+// been acknowledged, or the (negative) libnl error of the request.
+// NOTE: The requests are freed.
+inline Try<std::vector<int>> send(
+    const Netlink<struct nl_sock>& socket,
+    const std::vector<struct nl_msg*>& requests)
+{
+  std::vector<int> results;
+
+  for (size_t start = 0; start < requests.size(); start += MAX_BATCH_SIZE) {
+    const size_t end = std::min(start + MAX_BATCH_SIZE, requests.size());
+
+    // NOTE: This sets the sequence numbers of the requests and asks
+    // the kernel to acknowledge them, which is checked below.
+    std::vector<struct iovec> iov;
+    for (size_t i = start; i < end; i++) {
+      nl_complete_msg(socket.get(), requests[i]);
+
+      struct nlmsghdr* header = nlmsg_hdr(requests[i]);
+
+      struct iovec vector;
+      vector.iov_base = header;
+      vector.iov_len = header->nlmsg_len;
+      iov.push_back(vector);
+    }
+
+    struct sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_name = &kernel;
+    message.msg_namelen = sizeof(kernel);
+    message.msg_iov = iov.data();
+    message.msg_iovlen = iov.size();
+
+    ssize_t sent = ::sendmsg(nl_socket_get_fd(socket.get()), &message, 0);
+
+    for (size_t i = start; i < end; i++) {
+      nlmsg_free(requests[i]);
+    }
+
+    if (sent < 0) {
+      ErrnoError error("Failed to send the netlink requests");
+
+      for (size_t i = end; i < requests.size(); i++) {
+        nlmsg_free(requests[i]);
+      }
+
+      return error;
+    }
+
+    // The kernel processes the requests in order, and acknowledges
+    // each of them (which libnl checks using the sequence numbers).
+    for (size_t i = start; i < end; i++) {
+      results.push_back(nl_wait_for_ack(socket.get()));
+    }
+  }
+
+  return results;
+}
+
 /////////////////////////////////////////////////
 // Internal filter APIs.
 /////////////////////////////////////////////////
@@ -682,6 +805,246 @@ Try<bool> remove(
 }
 
 
+// Creates new filters on the link, which are all attached to the same
+// parent. This checks which filters exist and generates their handles
+// once, and sends the netlink requests in batches rather than waiting
+// for each of them to be acknowledged. Returns, for each filter, false
+// if a filter attached to the same parent with the same classifier
+// already exists. We use template here so that it works for any type
+// of classifier.
+template <typename Classifier>
+Try<std::vector<bool>> create(
+    const std::string& _link,
+    const std::vector<Filter<Classifier>>& filters)
+{
+  std::vector<bool> results(filters.size(), false);
+
+  if (filters.empty()) {
+    return results;
+  }
+
+  const Handle& parent = filters.front().parent;
+
+  foreach (const Filter<Classifier>& filter, filters) {
+    if (filter.parent != parent) {
+      return Error("The filters are not attached to the same parent");
+    }
+  }
+
+  Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
+  if (link.isError()) {
+    return Error(link.error());
+  } else if (link.isNone()) {
+    return Error("Link '" + _link + "' is not found");
+  }
+
+  Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+    getClses(link.get(), parent);
+
+  if (clses.isError()) {
+    return Error("Check filter existence failed: " + clses.error());
+  }
+
+  std::vector<Classifier> existing;
+  foreach (const Netlink<struct rtnl_cls>& cls, clses.get()) {
+    Result<Filter<Classifier>> filter = decodeFilter<Classifier>(cls);
+    if (filter.isError()) {
+      return Error("Check filter existence failed: " + filter.error());
+    } else if (filter.isSome()) {
+      existing.push_back(filter.get().classifier);
+    }
+  }
+
+  Try<U32Handles> handles = getU32Handles(link.get(), parent);
+  if (handles.isError()) {
+    return Error(handles.error());
+  }
+
+  Try<Netlink<struct nl_sock>> socket = routing::socket();
+  if (socket.isError()) {
+    return Error(socket.error());
+  }
+
+  // The requests to send, and the indices of their filters.
+  std::vector<struct nl_msg*> requests;
+  std::vector<size_t> indices;
+
+  // Sends the pending requests and records their results.
+  auto flush = [&]() -> Try<Nothing> {
+    Try<std::vector<int>> errors = send(socket.get(), requests);
+    requests.clear();
+
+    if (errors.isError()) {
+      return Error(errors.error());
+    }
+
+    for (size_t i = 0; i < errors.get().size(); i++) {
+      if (errors.get()[i] == 0) {
+        results[indices[i]] = true;
+      } else if (errors.get()[i] != -NLE_EXIST) {
+        return Error(std::string(nl_geterror(errors.get()[i])));
+      }
+    }
+
+    indices.clear();
+    return Nothing();
+  };
+
+  for (size_t i = 0; i < filters.size(); i++) {
+    if (std::find(
+            existing.begin(),
+            existing.end(),
+            filters[i].classifier) != existing.end()) {
+      continue;
+    }
+
+    existing.push_back(filters[i].classifier);
+
+    Try<Netlink<struct rtnl_cls>> cls =
+      encodeFilter(link.get(), filters[i], &handles.get());
+
+    if (cls.isError()) {
+      foreach (struct nl_msg* request, requests) {
+        nlmsg_free(request);
+      }
+
+      return Error("Failed to encode the filter: " + cls.error());
+    }
+
+    struct nl_msg* request = NULL;
+    int error = rtnl_cls_build_add_request(
+        cls.get().get(),
+        NLM_F_CREATE | NLM_F_EXCL,
+        &request);
+
+    if (error != 0) {
+      foreach (struct nl_msg* request, requests) {
+        nlmsg_free(request);
+      }
+
+      return Error(std::string(nl_geterror(error)));
+    }
+
+    requests.push_back(request);
+    indices.push_back(i);
+
+    // If the kernel chooses the handle of a u32 filter, we need to
+    // find out the new 'htid' (see MESOS-1617) before generating the
+    // handles of the following filters.
+    if (rtnl_tc_get_kind(TC_CAST(cls.get().get())) == std::string("u32") &&
+        rtnl_tc_get_handle(TC_CAST(cls.get().get())) == 0) {
+      Try<Nothing> flushed = flush();
+      if (flushed.isError()) {
+        return Error(flushed.error());
+      }
+
+      handles = getU32Handles(link.get(), parent);
+      if (handles.isError()) {
+        return Error(handles.error());
+      }
+    }
+  }
+
+  Try<Nothing> flushed = flush();
+  if (flushed.isError()) {
+    return Error(flushed.error());
+  }
+
+  return results;
+}
+
+
+// Removes the filters attached to the given parent that match the
+// specified classifiers from the link. This looks up the filters
+// once, and sends the netlink requests in batches. Returns, for each
+// classifier, false if such a filter is not found. We use template
+// here so that it works for any type of classifier.
+template <typename Classifier>
+Try<std::vector<bool>> remove(
+    const std::string& _link,
+    const Handle& parent,
+    const std::vector<Classifier>& classifiers)
+{
+  std::vector<bool> results(classifiers.size(), false);
+
+  Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
+  if (link.isError()) {
+    return Error(link.error());
+  } else if (link.isNone() || classifiers.empty()) {
+    return results;
+  }
+
+  Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+    getClses(link.get(), parent);
+
+  if (clses.isError()) {
+    return Error(clses.error());
+  }
+
+  // Find the libnl filters that match the classifiers.
+  std::vector<struct nl_msg*> requests;
+  std::vector<size_t> indices;
+
+  foreach (const Netlink<struct rtnl_cls>& cls, clses.get()) {
+    Result<Filter<Classifier>> filter = decodeFilter<Classifier>(cls);
+    if (filter.isError()) {
+      foreach (struct nl_msg* request, requests) {
+        nlmsg_free(request);
+      }
+
+      return Error("Failed to decode: " + filter.error());
+    } else if (filter.isNone()) {
+      continue;
+    }
+
+    for (size_t i = 0; i < classifiers.size(); i++) {
+      if (!(filter.get().classifier == classifiers[i]) ||
+          std::find(indices.begin(), indices.end(), i) != indices.end()) {
+        continue;
+      }
+
+      struct nl_msg* request = NULL;
+      int error = rtnl_cls_build_delete_request(cls.get(), 0, &request);
+      if (error != 0) {
+        foreach (struct nl_msg* request, requests) {
+          nlmsg_free(request);
+        }
+
+        return Error(std::string(nl_geterror(error)));
+      }
+
+      requests.push_back(request);
+      indices.push_back(i);
+      break;
+    }
+  }
+
+  Try<Netlink<struct nl_sock>> socket = routing::socket();
+  if (socket.isError()) {
+    foreach (struct nl_msg* request, requests) {
+      nlmsg_free(request);
+    }
+
+    return Error(socket.error());
+  }
+
+  Try<std::vector<int>> errors = send(socket.get(), requests);
+  if (errors.isError()) {
+    return Error(errors.error());
+  }
+
+  for (size_t i = 0; i < errors.get().size(); i++) {
+    if (errors.get()[i] == 0) {
+      results[indices[i]] = true;
+    } else if (errors.get()[i] != -NLE_OBJ_NOTFOUND) {
+      return Error(std::string(nl_geterror(errors.get()[i])));
+    }
+  }
+
+  return results;
+}
+
+
 // Updates the action of the filter attached to the given parent that
 // matches the specified classifier on the link. Returns false if such
 // a filter is not found. We use template here so that it works for
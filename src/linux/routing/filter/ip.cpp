@@ -23,6 +23,7 @@
 #include <ostream>
 
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 
 #include "linux/routing/handle.hpp"
@@ -545,6 +546,51 @@ Try<bool> create(
           action::Terminal()));
 }
 
+
+Try<vector<bool>> create(
+    const string& link,
+    const Handle& parent,
+    const vector<Classifier>& classifiers,
+    const Option<Priority>& priority,
+    const action::Redirect& redirect)
+{
+  vector<Filter<Classifier>> filters;
+  foreach (const Classifier& classifier, classifiers) {
+    filters.push_back(Filter<Classifier>(
+        parent,
+        classifier,
+        priority,
+        None(),
+        None(),
+        redirect));
+  }
+
+  return internal::create(link, filters);
+}
+
+
+Try<vector<bool>> create(
+    const string& link,
+    const Handle& parent,
+    const vector<Classifier>& classifiers,
+    const Option<Priority>& priority,
+    const Option<Handle>& classid)
+{
+  vector<Filter<Classifier>> filters;
+  foreach (const Classifier& classifier, classifiers) {
+    filters.push_back(Filter<Classifier>(
+        parent,
+        classifier,
+        priority,
+        None(),
+        classid,
+        action::Terminal()));
+  }
+
+  return internal::create(link, filters);
+}
+
+
 Try<bool> remove(
     const string& link,
     const Handle& parent,
@@ -554,6 +600,15 @@ Try<bool> remove(
 }
 
 
+Try<vector<bool>> remove(
+    const string& link,
+    const Handle& parent,
+    const vector<Classifier>& classifiers)
+{
+  return internal::remove(link, parent, classifiers);
+}
+
+
 Result<vector<Filter<Classifier>>> filters(
     const string& link,
     const Handle& parent)
@@ -174,6 +174,34 @@ Try<bool> create(
     const Option<Handle>& classid);
 
 
+// Creates IP packet filters attached to the given parent on the link,
+// one for each of the classifiers, which will redirect the IP packets
+// to the given link. The filters are created in batches, which is
+// much faster than creating them one at a time. Returns, for each
+// classifier, false if an IP packet filter attached to the given
+// parent with the same classifier already exists.
+Try<std::vector<bool>> create(
+    const std::string& link,
+    const Handle& parent,
+    const std::vector<Classifier>& classifiers,
+    const Option<Priority>& priority,
+    const action::Redirect& redirect);
+
+
+// Creates IP packet filters attached to the given parent on the link,
+// one for each of the classifiers, which will set the classid for
+// packets and stop the IP packets from being sent to the next filter.
+// The filters are created in batches. Returns, for each classifier,
+// false if an IP packet filter attached to the given parent with the
+// same classifier already exists.
+Try<std::vector<bool>> create(
+    const std::string& link,
+    const Handle& parent,
+    const std::vector<Classifier>& classifiers,
+    const Option<Priority>& priority,
+    const Option<Handle>& classid);
+
+
 // Removes the IP packet filter attached to the given parent that
 // matches the specified classifier from the link. Returns false if
 // such a filter is not found.
@@ -183,6 +211,16 @@ Try<bool> remove(
     const Classifier& classifier);
 
 
+// Removes the IP packet filters attached to the given parent that
+// match the specified classifiers from the link. The filters are
+// removed in batches. Returns, for each classifier, false if such a
+// filter is not found.
+Try<std::vector<bool>> remove(
+    const std::string& link,
+    const Handle& parent,
+    const std::vector<Classifier>& classifiers);
+
+
 // Returns all the IP packet filters attached to the given parent on
 // the link. Returns none if the link or the parent is not found.
 Result<std::vector<Filter<Classifier>>> filters(
@@ -197,7 +197,9 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
           path::join(flags.work_dir.get(), "replicated_log"),
           set<UPID>(),
           flags.log_auto_initialize);
-      storage = new state::LogStorage(log);
+      storage = new state::LogStorage(
+          log,
+          flags.registry_diffs_between_snapshots);
     } else {
       EXIT(1) << "'" << flags.registry << "' is not a supported"
               << " option for registry persistence";
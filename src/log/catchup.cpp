@@ -16,18 +16,26 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <deque>
 #include <list>
+#include <map>
+#include <set>
+#include <utility>
 
 #include <process/collect.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
+#include <process/protobuf.hpp>
 #include <process/timer.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/stringify.hpp>
 
 #include "log/catchup.hpp"
 #include "log/consensus.hpp"
+#include "log/replica.hpp"
 
 #include "messages/log.hpp"
 
@@ -165,10 +173,25 @@ static Future<uint64_t> catchup(
 }
 
 
-// TODO(jieyu): Our current implementation catches-up each position in
-// the set sequentially. In the future, we may want to parallelize it
-// to improve the performance. Also, we may want to implement rate
-// control here so that we don't saturate the network or disk.
+// The maximum number of positions requested from a replica at once
+// when reading the learned actions in bulk.
+static const uint64_t MAX_READ_POSITIONS = 10000;
+
+
+// Catches-up an interval of log positions in the local replica. Most
+// of the positions are usually already learned by the other replicas
+// (e.g., when the local replica has been offline for a while), so we
+// first read the learned actions in bulk. The interval is split into
+// ranges which are read concurrently, one range at a time from each
+// of the other replicas, and the actions read are then learned by the
+// local replica. The positions that are still missing afterwards are
+// caught-up one by one using Paxos.
+//
+// TODO(jieyu): Our current implementation catches-up the positions
+// left after reading sequentially. In the future, we may want to
+// parallelize it to improve the performance. Also, we may want to
+// implement rate control here so that we don't saturate the network
+// or disk.
 class BulkCatchUpProcess : public Process<BulkCatchUpProcess>
 {
 public:
@@ -198,14 +221,36 @@ protected:
     promise.future().onDiscard(lambda::bind(
         static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
 
-    // Catch-up sequentially.
-    current = positions.lower();
+    if (positions.lower() >= positions.upper()) {
+      // Nothing to catch-up if the input interval is empty.
+      promise.set(Nothing());
+      terminate(self());
+      return;
+    }
 
-    catchup();
+    // Split the interval into the ranges to read.
+    uint64_t from = positions.lower();
+    while (from < positions.upper()) {
+      uint64_t to =
+        from + std::min(MAX_READ_POSITIONS, positions.upper() - from);
+      ranges.push_back(Range(from, to));
+      from = to;
+    }
+
+    members = network->members();
+    members.onAny(defer(self(), &Self::read));
   }
 
   virtual void finalize()
   {
+    members.discard();
+
+    typedef std::pair<Range, Future<ReadResponse>> Reading;
+    foreachvalue (Reading& reading, readings) {
+      reading.second.discard();
+    }
+
+    checking.discard();
     catching.discard();
 
     // TODO(benh): Discard our promise only after 'catching' has
@@ -214,21 +259,154 @@ protected:
   }
 
 private:
-  static void timedout(Future<uint64_t> catching)
+  // The positions [from, to) of a read request.
+  typedef std::pair<uint64_t, uint64_t> Range;
+
+  template <typename T>
+  static void timedout(Future<T> future)
   {
-    catching.discard();
+    future.discard();
+  }
+
+  void read()
+  {
+    // The future 'members' can only be discarded in 'finalize'.
+    CHECK(!members.isDiscarded());
+
+    if (members.isFailed()) {
+      promise.fail("Failed to get the network members: " + members.failure());
+      terminate(self());
+      return;
+    }
+
+    foreach (const UPID& pid, members.get()) {
+      if (pid != replica->pid()) {
+        idle.push_back(pid);
+      }
+    }
+
+    schedule();
+  }
+
+  // Sends the ranges left to read to the idle replicas.
+  void schedule()
+  {
+    while (!ranges.empty() && !idle.empty()) {
+      const Range range = ranges.front();
+      ranges.pop_front();
+
+      const UPID pid = idle.front();
+      idle.pop_front();
+
+      ReadRequest request;
+      request.set_from(range.first);
+      request.set_to(range.second);
+
+      Future<ReadResponse> reading = protocol::read(pid, request);
+      readings[pid] = std::make_pair(range, reading);
+
+      reading.onAny(defer(self(), &Self::_read, pid));
+
+      Clock::timer(
+          timeout,
+          lambda::bind(&Self::timedout<ReadResponse>, reading));
+    }
+
+    if (readings.empty()) {
+      // Either all the ranges have been read or no replica is left
+      // to read the rest from. Catch-up whatever is still missing.
+      check();
+    }
+  }
+
+  void _read(const UPID& pid)
+  {
+    CHECK(readings.count(pid) > 0);
+
+    const Range range = readings[pid].first;
+    const Future<ReadResponse> reading = readings[pid].second;
+    readings.erase(pid);
+
+    if (!reading.isReady() ||
+        !reading.get().okay() ||
+        reading.get().to() <= range.first) {
+      LOG(INFO) << "Unable to read positions [" << range.first << ", "
+                << range.second << ") from " << pid << ": "
+                << (reading.isFailed() ? reading.failure() :
+                    reading.isDiscarded() ? "timed out" : "not in VOTING");
+
+      // Stop reading from this replica. The range is read from one of
+      // the other replicas, if any, or caught-up afterwards.
+      ranges.push_front(range);
+      schedule();
+      return;
+    }
+
+    const ReadResponse& response = reading.get();
+
+    foreach (const Action& action, response.actions()) {
+      if (action.position() < range.first ||
+          action.position() >= range.second ||
+          !action.has_learned() ||
+          !action.learned()) {
+        LOG(WARNING) << "Ignoring an unexpected action at position "
+                     << action.position() << " read from " << pid;
+        continue;
+      }
+
+      // The local replica learns the action just as it learns the
+      // ones broadcasted by a proposer.
+      LearnedMessage message;
+      message.mutable_action()->CopyFrom(action);
+      post(self(), replica->pid(), message);
+    }
+
+    // The response is limited in size. Read the rest later.
+    if (response.to() < range.second) {
+      ranges.push_front(Range(response.to(), range.second));
+    }
+
+    idle.push_back(pid);
+    schedule();
+  }
+
+  void check()
+  {
+    // NOTE: This is dispatched to the local replica after the actions
+    // read have been posted to it, hence they are all persisted by the
+    // time the missing positions are computed.
+    checking = replica->missing(positions.lower(), positions.upper() - 1);
+    checking.onAny(defer(self(), &Self::checked));
+  }
+
+  void checked()
+  {
+    // The future 'checking' can only be discarded in 'finalize'.
+    CHECK(!checking.isDiscarded());
+
+    if (checking.isFailed()) {
+      promise.fail("Failed to get missing positions: " + checking.failure());
+      terminate(self());
+      return;
+    }
+
+    missing = checking.get();
+
+    catchup();
   }
 
   void catchup()
   {
-    if (current >= positions.upper()) {
-      // Stop the process if there is nothing left to catch-up. This
-      // also handles the case where the input interval is empty.
+    if (missing.empty()) {
+      // Stop the process if there is nothing left to catch-up.
       promise.set(Nothing());
       terminate(self());
       return;
     }
 
+    // Catch-up sequentially.
+    current = missing.begin()->lower();
+
     // Store the future so that we can discard it if the user wants to
     // cancel the catch-up operation.
     catching = log::catchup(quorum, replica, network, proposal, current)
@@ -236,10 +414,9 @@ private:
       .onFailed(defer(self(), &Self::failed))
       .onReady(defer(self(), &Self::succeeded));
 
-    Clock::timer(timeout, lambda::bind(&Self::timedout, catching));
+    Clock::timer(timeout, lambda::bind(&Self::timedout<uint64_t>, catching));
   }
 
-
   void discarded()
   {
     LOG(INFO) << "Unable to catch-up position " << current
@@ -259,7 +436,7 @@ private:
 
   void succeeded()
   {
-    ++current;
+    missing -= current;
 
     // The single position catch-up function: 'log::catchup' will
     // return the highest proposal number seen so far. We use this
@@ -280,7 +457,19 @@ private:
   uint64_t proposal;
   uint64_t current;
 
+  // The ranges left to read, and the replicas not being read from.
+  std::deque<Range> ranges;
+  std::deque<UPID> idle;
+
+  // The outstanding read requests to the replicas.
+  std::map<UPID, std::pair<Range, Future<ReadResponse>>> readings;
+
+  // The positions still missing after the reads.
+  IntervalSet<uint64_t> missing;
+
   process::Promise<Nothing> promise;
+  Future<std::set<UPID>> members;
+  Future<IntervalSet<uint64_t>> checking;
   Future<uint64_t> catching;
 };
 
@@ -17,14 +17,17 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 
 #include "log/catchup.hpp"
@@ -35,12 +38,19 @@
 
 using namespace process;
 
+using std::deque;
 using std::string;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// The maximum number of writes (appends and truncates) the
+// coordinator runs concurrently. Further writes are queued until one
+// of the writes in flight finishes.
+static const size_t MAX_WRITES_IN_FLIGHT = 32;
+
+
 class CoordinatorProcess : public Process<CoordinatorProcess>
 {
 public:
@@ -68,7 +78,15 @@ protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    foreach (const Owned<Write>& write, writing) {
+      write->round.discard();
+      write->promise.discard();
+    }
+
+    foreach (const Owned<Write>& write, queued) {
+      write->promise.discard();
+    }
   }
 
 private:
@@ -92,17 +110,30 @@ private:
   // Writing related functions.  //
   /////////////////////////////////
 
+  // A write that has been assigned a log position. The write is
+  // completed through 'promise' once 'round' (the write and learn
+  // phases) is done and all writes at lower positions are completed.
+  struct Write
+  {
+    explicit Write(const Action& _action) : action(_action) {}
+
+    const Action action;
+    Future<Option<uint64_t> > round;
+    process::Promise<Option<uint64_t> > promise;
+  };
+
   Future<Option<uint64_t> > write(const Action& action);
+  void start(const Owned<Write>& write);
   Future<WriteResponse> runWritePhase(const Action& action);
   Future<Option<uint64_t> > checkWritePhase(
       const Action& action,
       const WriteResponse& response);
   Future<Nothing> runLearnPhase(const Action& action);
   Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t> > updateIndexAfterWritten(bool missing);
-  void writingFinished();
-  void writingFailed();
-  void writingAborted();
+  Future<Option<uint64_t> > checkWritten(const Action& action, bool missing);
+  void written();
+  void discard(uint64_t position);
+  void demoted();
 
   const size_t quorum;
   const Shared<Replica> replica;
@@ -115,7 +146,8 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. An elected coordinator is in writing state
+  // while any write is in flight or queued.
   enum
   {
     INITIAL,
@@ -127,11 +159,17 @@ private:
   // The current proposal number used by this coordinator.
   uint64_t proposal;
 
-  // The position to which the next entry will be written.
+  // The position to which the next entry will be written. Positions
+  // are assigned when a write is requested, so this is past the
+  // positions of all writes in flight or queued.
   uint64_t index;
 
   Future<Option<uint64_t> > electing;
-  Future<Option<uint64_t> > writing;
+
+  // The writes in flight, and the writes waiting for one of those to
+  // finish, both ordered by position.
+  deque<Owned<Write> > writing;
+  deque<Owned<Write> > queued;
 };
 
 
@@ -307,12 +345,10 @@ Future<Option<uint64_t> > CoordinatorProcess::append(const string& bytes)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
+  action.set_position(index++);
   action.set_promised(proposal);
   action.set_performed(proposal);
   action.set_type(Action::APPEND);
@@ -327,12 +363,10 @@ Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
+  action.set_position(index++);
   action.set_promised(proposal);
   action.set_performed(proposal);
   action.set_type(Action::TRUNCATE);
@@ -345,21 +379,41 @@ Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
 
 Future<Option<uint64_t> > CoordinatorProcess::write(const Action& action)
 {
-  LOG(INFO) << "Coordinator attempting to write " << action.type()
-            << " action at position " << action.position();
-
-  CHECK_EQ(state, ELECTED);
+  CHECK(state == ELECTED || state == WRITING);
   CHECK(action.has_performed() && action.has_type());
 
   state = WRITING;
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
+  Owned<Write> write(new Write(action));
+
+  write->promise.future()
+    .onDiscard(defer(self(), &Self::discard, action.position()));
+
+  if (writing.size() < MAX_WRITES_IN_FLIGHT) {
+    start(write);
+    writing.push_back(write);
+  } else {
+    queued.push_back(write);
+  }
+
+  return write->promise.future();
+}
+
+
+void CoordinatorProcess::start(const Owned<Write>& write)
+{
+  LOG(INFO) << "Coordinator attempting to write " << write->action.type()
+            << " action at position " << write->action.position();
+
+  write->round = runWritePhase(write->action)
+    .then(defer(self(), &Self::checkWritePhase, write->action, lambda::_1));
+
+  write->round.onAny(defer(self(), &Self::written));
 
-  return writing;
+  // The write might have been discarded while it was queued.
+  if (write->promise.future().hasDiscard()) {
+    write->round.discard();
+  }
 }
 
 
@@ -374,16 +428,17 @@ Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
     const WriteResponse& response)
 {
   if (!response.okay()) {
-    // Received a NACK. Save the proposal number.
-    CHECK_LE(proposal, response.proposal());
-    proposal = response.proposal();
+    // Received a NACK. Save the proposal number. With several writes
+    // in flight, an earlier NACK might already have carried a higher
+    // proposal number than this one.
+    proposal = std::max(proposal, response.proposal());
 
     return None();
   }
 
   return runLearnPhase(action)
     .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+    .then(defer(self(), &Self::checkWritten, action, lambda::_1));
 }
 
 
@@ -402,39 +457,93 @@ Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::updateIndexAfterWritten(
+Future<Option<uint64_t> > CoordinatorProcess::checkWritten(
+    const Action& action,
     bool missing)
 {
   CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+                  << action.position() << " after the writing is done";
 
-  return index++;
+  return action.position();
 }
 
 
-void CoordinatorProcess::writingFinished()
+void CoordinatorProcess::written()
 {
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
+  // Writes are completed in the order of their positions, i.e., a
+  // write that finishes early waits for the writes before it.
+  while (!writing.empty() && !writing.front()->round.isPending()) {
+    Owned<Write> write = writing.front();
+    writing.pop_front();
+
+    const Future<Option<uint64_t> >& round = write->round;
+
+    if (round.isReady() && round.get().isSome()) {
+      write->promise.set(round.get());
+      continue;
+    }
+
+    if (round.isReady()) {
+      write->promise.set(Option<uint64_t>::none());
+    } else if (round.isFailed()) {
+      write->promise.fail(round.failure());
+    } else {
+      // Demote the coordinator if a write operation is discarded
+      // since we don't actually know the write was successful or not
+      // and we really need to "catch-up" that position before we try
+      // and do another write (see MESOS-1038 for more details).
+      write->promise.discard();
+    }
+
+    demoted();
+    return;
+  }
+
+  while (!queued.empty() && writing.size() < MAX_WRITES_IN_FLIGHT) {
+    Owned<Write> write = queued.front();
+    queued.pop_front();
+
+    start(write);
+    writing.push_back(write);
+  }
+
+  if (state == WRITING && writing.empty()) {
+    state = ELECTED;
+  }
 }
 
 
-void CoordinatorProcess::writingFailed()
+void CoordinatorProcess::discard(uint64_t position)
 {
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
+  // A queued write is discarded once it is started.
+  foreach (const Owned<Write>& write, writing) {
+    if (write->action.position() == position) {
+      write->round.discard();
+    }
+  }
 }
 
 
-void CoordinatorProcess::writingAborted()
+void CoordinatorProcess::demoted()
 {
   CHECK_EQ(state, WRITING);
-
-  // Demote the coordinator if a write operation is discarded since we
-  // don't actually know the write was successful or not and we really
-  // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
   state = INITIAL;
+
+  // Once a write did not succeed, the writes after it are reported as
+  // if the coordinator was demoted before they were attempted. Those
+  // in flight might still end up in the log; their positions will be
+  // caught up by the next election like any other unlearned position.
+  foreach (const Owned<Write>& write, writing) {
+    write->round.discard();
+    write->promise.set(Option<uint64_t>::none());
+  }
+
+  foreach (const Owned<Write>& write, queued) {
+    write->promise.set(Option<uint64_t>::none());
+  }
+
+  writing.clear();
+  queued.clear();
 }
 
 
@@ -61,6 +61,12 @@ public:
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
   // if the coordinator was demoted.
+  //
+  // Writes (appends and truncates) may be issued without waiting for
+  // earlier ones to finish. They are assigned consecutive positions
+  // in the order they are issued, a bounded number of them is run
+  // concurrently, and they complete in the order of their positions.
+  // Once a write does not succeed, all writes after it return none.
   process::Future<Option<uint64_t> > append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
@@ -25,6 +25,7 @@
 
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
@@ -33,6 +34,7 @@
 #include "log/leveldb.hpp"
 
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -81,6 +83,11 @@ public:
 // static Varint64Comparator comparator;
 
 
+// The number of positions deleted by truncations after which we
+// compact the deleted range of the db.
+static const uint64_t COMPACTION_THRESHOLD = 1000;
+
+
 // Returns a string representing the specified position. Note that we
 // adjust the actual position by incrementing it by 1 because we
 // reserve 0 for storing the promise record (Record::Promise,
@@ -127,7 +134,7 @@ static string encode(uint64_t position, bool adjust = true)
 
 
 LevelDBStorage::LevelDBStorage()
-  : db(NULL), first(None())
+  : db(NULL), first(None()), uncompacted(0)
 {
   // Nothing to see here.
 }
@@ -173,12 +180,11 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   LOG(INFO) << "Opened db in " << stopwatch.elapsed();
 
-  stopwatch.start(); // Restart the stopwatch.
-
-  // TODO(benh): Conditionally compact to avoid long recovery times?
-  db->CompactRange(NULL, NULL);
-
-  LOG(INFO) << "Compacted db in " << stopwatch.elapsed();
+  // NOTE: We don't compact the whole db here since that takes time
+  // proportional to the size of the db. The positions deleted by
+  // truncations are compacted as we go instead (see 'truncate'), so
+  // the iteration below only has to go over the positions that are
+  // still in the log.
 
   State state;
   state.begin = 0;
@@ -273,6 +279,10 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   delete iterator;
 
+  // Compact whatever truncations left behind before we restarted,
+  // e.g., from the positions deleted since the last compaction.
+  compact();
+
   return state;
 }
 
@@ -309,24 +319,40 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 
 
 Try<Nothing> LevelDBStorage::persist(const Action& action)
+{
+  return persist(vector<Action>(1, action));
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const vector<Action>& actions)
 {
   Stopwatch stopwatch;
   stopwatch.start();
 
-  Record record;
-  record.set_type(Record::ACTION);
-  record.mutable_action()->MergeFrom(action);
+  leveldb::WriteBatch batch;
+  size_t size = 0;
 
-  string value;
+  foreach (const Action& action, actions) {
+    Record record;
+    record.set_type(Record::ACTION);
+    record.mutable_action()->MergeFrom(action);
 
-  if (!record.SerializeToString(&value)) {
-    return Error("Failed to serialize record");
+    string value;
+
+    if (!record.SerializeToString(&value)) {
+      return Error("Failed to serialize record");
+    }
+
+    batch.Put(encode(action.position()), value);
+    size += value.size();
   }
 
+  // All actions are synced to disk at once, which is the main cost
+  // of persisting them.
   leveldb::WriteOptions options;
   options.sync = true;
 
-  leveldb::Status status = db->Put(options, encode(action.position()), value);
+  leveldb::Status status = db->Write(options, &batch);
 
   if (!status.ok()) {
     return Error(status.ToString());
@@ -336,11 +362,23 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
   // of checking 'isNone()' because it's likely that log entries are
   // written out of order during catch-up (e.g. if a random bulk
   // catch-up policy is used).
-  first = min(first, action.position());
+  foreach (const Action& action, actions) {
+    first = min(first, action.position());
+  }
 
-  LOG(INFO) << "Persisting action (" << value.size()
+  LOG(INFO) << "Persisting " << actions.size() << " action(s) (" << size
             << " bytes) to leveldb took " << stopwatch.elapsed();
 
+  foreach (const Action& action, actions) {
+    truncate(action);
+  }
+
+  return Nothing();
+}
+
+
+void LevelDBStorage::truncate(const Action& action)
+{
   // Delete positions if a truncate action has been *learned*. Note
   // that we do this in a best-effort fashion (i.e., we ignore any
   // failures to the database since we can always try again).
@@ -348,7 +386,8 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
       action.has_learned() && action.learned()) {
     CHECK(action.has_truncate());
 
-    stopwatch.start(); // Restart the stopwatch.
+    Stopwatch stopwatch;
+    stopwatch.start();
 
     // To actually perform the truncation in leveldb we need to remove
     // all the keys that represent positions no longer in the log. We
@@ -398,11 +437,42 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
 
         LOG(INFO) << "Deleting ~" << index
                   << " keys from leveldb took " << stopwatch.elapsed();
+
+        // Deleted keys stay around (as tombstones) until leveldb
+        // compacts them, which makes iterating the db (e.g., during
+        // recovery) take time proportional to the history of the log
+        // rather than its size. Compacting is costly (it flushes the
+        // memtable), so we only do it once enough keys were deleted.
+        uncompacted += index;
+
+        if (uncompacted >= COMPACTION_THRESHOLD) {
+          compact();
+        }
       }
     }
   }
+}
 
-  return Nothing();
+
+void LevelDBStorage::compact()
+{
+  CHECK_NOTNULL(db);
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // Note that the metadata is stored before all positions (see
+  // 'encode'), so this also compacts the metadata record.
+  const string end = encode(first.isSome() ? first.get() : 0);
+  const leveldb::Slice slice(end);
+
+  db->CompactRange(NULL, &slice);
+
+  uncompacted = 0;
+
+  LOG(INFO) << "Compacted db up to position "
+            << (first.isSome() ? first.get() : 0)
+            << " in " << stopwatch.elapsed();
 }
 
 
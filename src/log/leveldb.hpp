@@ -39,13 +39,26 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::vector<Action>& actions);
   virtual Try<Action> read(uint64_t position);
 
 private:
+  // Deletes the positions truncated by the action, if it is a
+  // learned truncate action.
+  void truncate(const Action& action);
+
+  // Compacts the range of the db that holds the positions deleted by
+  // truncations, i.e., everything before the first position.
+  void compact();
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
   Option<uint64_t> first;
+
+  // Number of positions deleted by truncations since the deleted
+  // range was last compacted.
+  uint64_t uncompacted;
 };
 
 } // namespace log {
@@ -80,6 +80,9 @@ public:
       size_t size,
       WatchMode mode = NOT_EQUAL_TO) const;
 
+  // Returns the PIDs that are currently part of this network.
+  process::Future<std::set<process::UPID> > members() const;
+
   // Sends a request to each member of the network and returns a set
   // of futures that represent their responses.
   template <typename Req, typename Res>
@@ -197,6 +200,11 @@ public:
     return watch->promise.future();
   }
 
+  std::set<process::UPID> members()
+  {
+    return pids;
+  }
+
   // Sends a request to each of the groups members and returns a set
   // of futures that represent their responses.
   template <typename Req, typename Res>
@@ -348,6 +356,12 @@ inline process::Future<size_t> Network::watch(
 }
 
 
+inline process::Future<std::set<process::UPID> > Network::members() const
+{
+  return process::dispatch(process, &NetworkProcess::members);
+}
+
+
 template <typename Req, typename Res>
 process::Future<std::set<process::Future<Res> > > Network::broadcast(
     const Protocol<Req, Res>& protocol,
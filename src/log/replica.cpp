@@ -17,16 +17,21 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/check.hpp>
 #include <stout/error.hpp>
 #include <stout/exit.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/result.hpp>
@@ -52,10 +57,16 @@ namespace protocol {
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<ReadRequest, ReadResponse> read;
 
 } // namespace protocol {
 
 
+// The maximum size of the actions sent in a single response to a
+// read request.
+static const Bytes MAX_READ_SIZE = Megabytes(4);
+
+
 class ReplicaProcess : public ProtobufProcess<ReplicaProcess>
 {
 public:
@@ -65,6 +76,10 @@ public:
 
   virtual ~ReplicaProcess();
 
+  // NOTE: The methods reading the log below first commit the pending
+  // actions (see 'commit'), so that they reflect all the requests
+  // that were handled before.
+
   // Returns the action associated with this position. A none result
   // means that no action is known for this position. An error result
   // means that there was an error while trying to get this action
@@ -112,12 +127,37 @@ private:
   // Handles a request from a recover process.
   void recover(const UPID& from, const RecoverRequest& request);
 
+  // Handles a request to read the learned actions in a range of
+  // positions (e.g., from a catch-up process).
+  void transfer(const UPID& from, const ReadRequest& request);
+
   // Handles a message notifying of a learned action.
   void learned(const UPID& from, const Action& action);
 
-  // Persists the specified action to storage. Returns true on success
-  // and false otherwise.
-  bool persist(const Action& action);
+  // Returns the action associated with this position, including
+  // actions that are persisted but not yet committed to storage.
+  Result<Action> lookup(uint64_t position);
+
+  // Returns the action associated with this position in storage.
+  Result<Action> fetch(uint64_t position);
+
+  // Persists the specified action to storage. The action is committed
+  // together with the other actions persisted while handling the
+  // requests that are already queued up, see 'commit'.
+  void persist(const Action& action);
+
+  // Sends the message once the pending actions have been committed.
+  // Nothing is sent if committing them fails.
+  void acknowledge(
+      const UPID& to,
+      const google::protobuf::Message& message);
+
+  // Commits all pending actions to storage with a single write, and
+  // then sends out the acknowledgements.
+  void commit();
+
+  // Updates the positions of the log after the action is committed.
+  void _persist(const Action& action);
 
   // Updates the highest promise this replica has given. The update
   // will be persisted to storage. Returns true on success and false
@@ -145,6 +185,18 @@ private:
 
   // Unlearned positions in the log.
   IntervalSet<uint64_t> unlearned;
+
+  // Actions that are persisted but not yet committed to storage, in
+  // the order they were persisted.
+  std::vector<Action> pending;
+
+  // The index of the latest pending action for each position.
+  hashmap<uint64_t, size_t> staged;
+
+  typedef std::pair<UPID, Owned<google::protobuf::Message>> Acknowledgement;
+
+  // Responses to send once the pending actions are committed.
+  std::vector<Acknowledgement> acknowledgements;
 };
 
 
@@ -168,6 +220,9 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<RecoverRequest>(
       &ReplicaProcess::recover);
 
+  install<ReadRequest>(
+      &ReplicaProcess::transfer);
+
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
@@ -181,6 +236,14 @@ ReplicaProcess::~ReplicaProcess()
 
 
 Result<Action> ReplicaProcess::read(uint64_t position)
+{
+  commit();
+
+  return fetch(position);
+}
+
+
+Result<Action> ReplicaProcess::fetch(uint64_t position)
 {
   if (position < begin) {
     return Error("Attempted to read truncated position");
@@ -205,6 +268,8 @@ Result<Action> ReplicaProcess::read(uint64_t position)
 // the future semantics to not include failures.
 Future<list<Action>> ReplicaProcess::read(uint64_t from, uint64_t to)
 {
+  commit();
+
   if (to < from) {
     process::Promise<list<Action>> promise;
     promise.fail("Bad read range (to < from)");
@@ -225,7 +290,7 @@ Future<list<Action>> ReplicaProcess::read(uint64_t from, uint64_t to)
   list<Action> actions;
 
   for (uint64_t position = from; position <= to; position++) {
-    Result<Action> result = read(position);
+    Result<Action> result = fetch(position);
 
     if (result.isError()) {
       process::Promise<list<Action>> promise;
@@ -242,6 +307,8 @@ Future<list<Action>> ReplicaProcess::read(uint64_t from, uint64_t to)
 
 bool ReplicaProcess::missing(uint64_t position)
 {
+  commit();
+
   if (position < begin) {
     return false; // Truncated positions are treated as learned.
   } else if (position > end) {
@@ -255,6 +322,8 @@ bool ReplicaProcess::missing(uint64_t position)
 // TODO(jieyu): Allow this method to take an Interval.
 IntervalSet<uint64_t> ReplicaProcess::missing(uint64_t from, uint64_t to)
 {
+  commit();
+
   if (from > to) {
     // Empty interval.
     return IntervalSet<uint64_t>();
@@ -282,12 +351,16 @@ IntervalSet<uint64_t> ReplicaProcess::missing(uint64_t from, uint64_t to)
 
 uint64_t ReplicaProcess::beginning()
 {
+  commit();
+
   return begin;
 }
 
 
 uint64_t ReplicaProcess::ending()
 {
+  commit();
+
   return end;
 }
 
@@ -306,6 +379,10 @@ uint64_t ReplicaProcess::promised()
 
 bool ReplicaProcess::update(const Metadata::Status& status)
 {
+  // Commit any pending actions first, so that they are not reordered
+  // with the update of the metadata.
+  commit();
+
   Metadata metadata_;
   metadata_.set_status(status);
   metadata_.set_promised(promised());
@@ -328,6 +405,10 @@ bool ReplicaProcess::update(const Metadata::Status& status)
 
 bool ReplicaProcess::updatePromised(uint64_t promised)
 {
+  // Commit any pending actions first, so that the ending position we
+  // return with an implicit promise is persisted.
+  commit();
+
   Metadata metadata_;
   metadata_.set_status(status());
   metadata_.set_promised(promised);
@@ -421,7 +502,7 @@ void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
     }
 
     // Need to get the action for the specified position.
-    Result<Action> result = read(request.position());
+    Result<Action> result = lookup(request.position());
 
     if (result.isError()) {
       LOG(ERROR) << "Error getting log record at " << request.position()
@@ -455,14 +536,14 @@ void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
         action.set_position(request.position());
         action.set_promised(request.proposal());
 
-        if (persist(action)) {
-          PromiseResponse response;
-          response.set_type(PromiseResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        persist(action);
+
+        PromiseResponse response;
+        response.set_type(PromiseResponse::ACCEPT);
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.set_position(request.position());
+        acknowledge(from, response);
       }
     } else {
       CHECK_SOME(result);
@@ -479,14 +560,14 @@ void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
         Action original = action;
         action.set_promised(request.proposal());
 
-        if (persist(action)) {
-          PromiseResponse response;
-          response.set_type(PromiseResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.mutable_action()->MergeFrom(original);
-          reply(response);
-        }
+        persist(action);
+
+        PromiseResponse response;
+        response.set_type(PromiseResponse::ACCEPT);
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.mutable_action()->MergeFrom(original);
+        acknowledge(from, response);
       }
     }
   } else {
@@ -537,7 +618,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
   LOG(INFO) << "Replica received write request for position "
             << request.position() << " from " << from;
 
-  Result<Action> result = read(request.position());
+  Result<Action> result = lookup(request.position());
 
   if (result.isError()) {
     LOG(ERROR) << "Error getting log record at " << request.position()
@@ -575,14 +656,14 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
-        WriteResponse response;
-        response.set_type(WriteResponse::ACCEPT);
-        response.set_okay(true);
-        response.set_proposal(request.proposal());
-        response.set_position(request.position());
-        reply(response);
-      }
+      persist(action);
+
+      WriteResponse response;
+      response.set_type(WriteResponse::ACCEPT);
+      response.set_okay(true);
+      response.set_proposal(request.proposal());
+      response.set_position(request.position());
+      acknowledge(from, response);
     }
   } else if (result.isSome()) {
     Action action = result.get();
@@ -654,14 +735,14 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
-          WriteResponse response;
-          response.set_type(WriteResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        persist(action);
+
+        WriteResponse response;
+        response.set_type(WriteResponse::ACCEPT);
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.set_position(request.position());
+        acknowledge(from, response);
       }
     }
   }
@@ -686,6 +767,67 @@ void ReplicaProcess::recover(const UPID& from, const RecoverRequest& request)
 }
 
 
+void ReplicaProcess::transfer(const UPID& from, const ReadRequest& request)
+{
+  ReadResponse response;
+  response.set_to(request.to());
+
+  // Only a VOTING replica is guaranteed to have caught up with the
+  // actions it has acknowledged, see 'recover'.
+  if (status() != Metadata::VOTING) {
+    LOG(INFO) << "Replica ignoring read request from " << from
+              << " as it is in " << status() << " status";
+
+    response.set_okay(false);
+    reply(response);
+    return;
+  }
+
+  VLOG(2) << "Replica received read request from " << from
+          << " for positions [" << request.from() << ", "
+          << request.to() << ")";
+
+  response.set_okay(true);
+
+  commit();
+
+  // Positions before the beginning have been truncated and are
+  // treated as learned, see 'missing'. Those past the end are
+  // unknown to this replica.
+  uint64_t position = std::max(request.from(), begin);
+  size_t size = 0;
+
+  for (; position < request.to() && position <= end; position++) {
+    if (size >= MAX_READ_SIZE.bytes()) {
+      // Let the requester ask for the rest of the range.
+      response.set_to(position);
+      break;
+    }
+
+    if (holes.contains(position) || unlearned.contains(position)) {
+      continue;
+    }
+
+    Result<Action> result = fetch(position);
+
+    if (result.isError()) {
+      // The request is silently ignored, see the discussion of error
+      // handling above.
+      LOG(ERROR) << "Error getting log record at " << position
+                 << ": " << result.error();
+      return;
+    } else if (result.isSome() &&
+               result.get().has_learned() &&
+               result.get().learned()) {
+      response.add_actions()->CopyFrom(result.get());
+      size += result.get().ByteSize();
+    }
+  }
+
+  reply(response);
+}
+
+
 void ReplicaProcess::learned(const UPID& from, const Action& action)
 {
   LOG(INFO) << "Replica received learned notice for position "
@@ -693,22 +835,75 @@ void ReplicaProcess::learned(const UPID& from, const Action& action)
 
   CHECK(action.learned());
 
-  if (persist(action)) {
-    LOG(INFO) << "Replica learned " << action.type()
-              << " action at position " << action.position();
+  persist(action);
+}
+
+
+Result<Action> ReplicaProcess::lookup(uint64_t position)
+{
+  if (staged.contains(position)) {
+    return pending[staged.at(position)];
+  }
+
+  return fetch(position);
+}
+
+
+void ReplicaProcess::persist(const Action& action)
+{
+  // Commit once the requests that are already queued up have been
+  // handled, so that all the actions they persist are committed to
+  // storage together (i.e., with a single sync).
+  if (pending.empty()) {
+    dispatch(self(), &ReplicaProcess::commit);
   }
+
+  staged[action.position()] = pending.size();
+  pending.push_back(action);
 }
 
 
-bool ReplicaProcess::persist(const Action& action)
+void ReplicaProcess::acknowledge(
+    const UPID& to,
+    const google::protobuf::Message& message)
 {
-  Try<Nothing> persisted = storage->persist(action);
+  Owned<google::protobuf::Message> response(message.New());
+  response->CopyFrom(message);
+
+  acknowledgements.push_back(std::make_pair(to, response));
+}
+
+
+void ReplicaProcess::commit()
+{
+  if (pending.empty()) {
+    return;
+  }
+
+  Try<Nothing> persisted = storage->persist(pending);
 
   if (persisted.isError()) {
+    // The requests are silently ignored, see the discussion of
+    // error handling above.
     LOG(ERROR) << "Error writing to log: " << persisted.error();
-    return false;
+  } else {
+    foreach (const Action& action, pending) {
+      _persist(action);
+    }
+
+    foreach (const Acknowledgement& acknowledgement, acknowledgements) {
+      send(acknowledgement.first, *acknowledgement.second);
+    }
   }
 
+  pending.clear();
+  staged.clear();
+  acknowledgements.clear();
+}
+
+
+void ReplicaProcess::_persist(const Action& action)
+{
   LOG(INFO) << "Persisted action at " << action.position();
 
   // No longer a hole here (if there even was one).
@@ -716,6 +911,9 @@ bool ReplicaProcess::persist(const Action& action)
 
   // Update unlearned positions and deal with truncation actions.
   if (action.has_learned() && action.learned()) {
+    LOG(INFO) << "Replica learned " << action.type()
+              << " action at position " << action.position();
+
     unlearned -= action.position();
 
     if (action.has_type() && action.type() == Action::TRUNCATE) {
@@ -745,8 +943,6 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
-
-  return true;
 }
 
 
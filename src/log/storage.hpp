@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include <stout/interval.hpp>
 #include <stout/nothing.hpp>
@@ -53,6 +54,10 @@ public:
   virtual Try<State> restore(const std::string& path) = 0;
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+
+  // Persists all the actions with a single write to the underlying
+  // storage, either all of them are persisted or none is.
+  virtual Try<Nothing> persist(const std::vector<Action>& actions) = 0;
   virtual Try<Action> read(uint64_t position) = 0;
 };
 
@@ -17,6 +17,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -29,7 +31,9 @@
 #include <stout/bytes.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/json.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/os/read.hpp>
 
@@ -42,6 +46,7 @@
 using namespace process;
 
 using std::cout;
+using std::deque;
 using std::endl;
 using std::ifstream;
 using std::ofstream;
@@ -88,6 +93,26 @@ Benchmark::Flags::Flags()
       "  random: all bits are randomly chosen\n",
       "random");
 
+  add(&Flags::concurrency,
+      "concurrency",
+      "Number of writes to keep in flight, i.e., how many appends\n"
+      "(and truncations) are pipelined by the writer",
+      1);
+
+  add(&Flags::truncate_interval,
+      "truncate_interval",
+      "If set, the log is truncated after every N appends (while the\n"
+      "other writes are in flight), keeping the last N entries. Must\n"
+      "be larger than --concurrency");
+
+  add(&Flags::format,
+      "format",
+      "Format of the output file (text, json)\n"
+      "  text: a line for each write with its latency\n"
+      "  json: the number, the throughput and the latency percentiles\n"
+      "        of the appends and truncations\n",
+      "text");
+
   add(&Flags::initialize,
       "initialize",
       "Whether to initialize the log",
@@ -104,7 +129,9 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
       "replicated log. It takes a trace file of write sizes\n"
       "and replay that trace to measure the latency of each\n"
       "write. The data to be written for each write can be\n"
-      "specified using the --type flag.\n"
+      "specified using the --type flag. Writes can be pipelined\n"
+      "(--concurrency) and mixed with truncations of the log\n"
+      "(--truncate_interval).\n"
       "\n");
 
   // Configure the tool by parsing command line arguments.
@@ -146,6 +173,20 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     return Error(flags.usage("Missing required option --output"));
   }
 
+  if (flags.concurrency == 0) {
+    return Error(flags.usage("Expecting --concurrency to be positive"));
+  }
+
+  if (flags.truncate_interval.isSome() &&
+      flags.truncate_interval.get() <= flags.concurrency) {
+    return Error(flags.usage(
+        "Expecting --truncate_interval to be larger than --concurrency"));
+  }
+
+  if (flags.format != "text" && flags.format != "json") {
+    return Error(flags.usage("Unknown --format '" + flags.format + "'"));
+  }
+
   // Initialize the log.
   if (flags.initialize) {
     Initialize initialize;
@@ -179,12 +220,9 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
                   : "Discarded future"));
   }
 
-  // Statistics to output.
+  // Read sizes from the input trace file.
   vector<Bytes> sizes;
-  vector<Duration> durations;
-  vector<Time> timestamps;
 
-  // Read sizes from the input trace file.
   ifstream input(flags.input.get().c_str());
   if (!input.is_open()) {
     return Error("Failed to open the trace file " + flags.input.get());
@@ -214,32 +252,121 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     }
   }
 
+  // A write in flight, or completed.
+  struct Write
+  {
+    bool truncate;
+    size_t index;  // The index of the append (or the first kept one).
+    Stopwatch stopwatch;
+    Future<Option<Log::Position>> position;
+    Duration duration;
+    Time timestamp;
+  };
+
+  // The positions of the completed appends, which the truncations
+  // truncate the log to.
+  vector<Option<Log::Position>> positions(sizes.size());
+
+  vector<Write> writes;
+  deque<Write> pending;
+
+  size_t appended = 0;
+
   Stopwatch stopwatch;
   stopwatch.start();
 
-  for (size_t i = 0; i < sizes.size(); i++) {
-    Stopwatch stopwatch;
-    stopwatch.start();
+  while (appended < sizes.size() || !pending.empty()) {
+    // Keep '--concurrency' writes in flight. The writer completes
+    // them in the order of their positions.
+    while (appended < sizes.size() && pending.size() < flags.concurrency) {
+      Write write;
+      write.truncate = false;
+      write.index = appended;
+      write.stopwatch.start();
+      write.position = writer.append(data[appended]);
+
+      pending.push_back(write);
+      appended++;
+
+      if (flags.truncate_interval.isSome() &&
+          appended % flags.truncate_interval.get() == 0) {
+        // There are fewer writes in flight than appends in the
+        // interval, so the first append to keep has completed.
+        const size_t index = appended - flags.truncate_interval.get();
+        CHECK_SOME(positions[index]);
+
+        Write truncate;
+        truncate.truncate = true;
+        truncate.index = index;
+        truncate.stopwatch.start();
+        truncate.position = writer.truncate(positions[index].get());
+
+        pending.push_back(truncate);
+      }
+    }
+
+    Write write = pending.front();
+    pending.pop_front();
 
-    position = writer.append(data[i]);
+    const string operation = write.truncate ? "truncate" : "append";
 
-    if (!position.await(Seconds(10))) {
-      return Error("Failed to append: timed out");
-    } else if (!position.isReady()) {
-      return Error("Failed to append: " +
-                   (position.isFailed()
-                    ? position.failure()
+    if (!write.position.await(Seconds(10))) {
+      return Error("Failed to " + operation + ": timed out");
+    } else if (!write.position.isReady()) {
+      return Error("Failed to " + operation + ": " +
+                   (write.position.isFailed()
+                    ? write.position.failure()
                     : "Discarded future"));
-    } else if (position.get().isNone()) {
-      return Error("Failed to append: exclusive write promise lost");
+    } else if (write.position.get().isNone()) {
+      return Error("Failed to " + operation +
+                   ": exclusive write promise lost");
     }
 
-    durations.push_back(stopwatch.elapsed());
-    timestamps.push_back(Clock::now());
+    write.duration = write.stopwatch.elapsed();
+    write.timestamp = Clock::now();
+
+    if (!write.truncate) {
+      positions[write.index] = write.position.get();
+    }
+
+    writes.push_back(write);
+  }
+
+  const Duration elapsed = stopwatch.elapsed();
+
+  vector<Duration> appends;
+  vector<Duration> truncates;
+  Bytes bytes;
+
+  foreach (const Write& write, writes) {
+    if (write.truncate) {
+      truncates.push_back(write.duration);
+    } else {
+      appends.push_back(write.duration);
+      bytes += sizes[write.index];
+    }
   }
 
-  cout << "Total number of appends: " << sizes.size() << endl;
-  cout << "Total time used: " << stopwatch.elapsed() << endl;
+  std::sort(appends.begin(), appends.end());
+  std::sort(truncates.begin(), truncates.end());
+
+  // Returns the latency percentile 'p' of the sorted 'durations'.
+  auto percentile = [](const vector<Duration>& durations, double p) {
+    if (durations.empty()) {
+      return Duration::zero();
+    }
+
+    return durations[std::min(
+        durations.size() - 1,
+        static_cast<size_t>(durations.size() * p))];
+  };
+
+  cout << "Total number of appends: " << appends.size() << endl;
+  cout << "Total number of truncations: " << truncates.size() << endl;
+  cout << "Total time used: " << elapsed << endl;
+  cout << "Append latency: p50 " << percentile(appends, 0.5)
+       << ", p99 " << percentile(appends, 0.99)
+       << ", p999 " << percentile(appends, 0.999) << endl;
 
   // Ouput statistics.
   ofstream output(flags.output.get().c_str());
@@ -247,12 +374,42 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     return Error("Failed to open the output file " + flags.output.get());
   }
 
-  for (size_t i = 0; i < sizes.size(); i++) {
-    output << timestamps[i]
-           << " Appended " << sizes[i].bytes() << " bytes"
-           << " in " << durations[i].ms() << " ms" << endl;
+  if (flags.format == "text") {
+    foreach (const Write& write, writes) {
+      if (write.truncate) {
+        output << write.timestamp
+               << " Truncated before append " << write.index
+               << " in " << write.duration.ms() << " ms" << endl;
+      } else {
+        output << write.timestamp
+               << " Appended " << sizes[write.index].bytes() << " bytes"
+               << " in " << write.duration.ms() << " ms" << endl;
+      }
+    }
+
+    return Nothing();
   }
 
+  auto summary = [&percentile](const vector<Duration>& durations) {
+    JSON::Object object;
+    object.values["count"] = durations.size();
+    object.values["p50_ms"] = percentile(durations, 0.5).ms();
+    object.values["p99_ms"] = percentile(durations, 0.99).ms();
+    object.values["p999_ms"] = percentile(durations, 0.999).ms();
+    object.values["max_ms"] = percentile(durations, 1.0).ms();
+    return object;
+  };
+
+  JSON::Object object;
+  object.values["concurrency"] = flags.concurrency;
+  object.values["elapsed_secs"] = elapsed.secs();
+  object.values["appends"] = summary(appends);
+  object.values["truncates"] = summary(truncates);
+  object.values["appends_per_second"] = appends.size() / elapsed.secs();
+  object.values["bytes_per_second"] = bytes.bytes() / elapsed.secs();
+
+  output << stringify(object) << endl;
+
   return Nothing();
 }
 
@@ -44,6 +44,9 @@ public:
     Option<std::string> input;
     Option<std::string> output;
     std::string type;
+    size_t concurrency;
+    Option<size_t> truncate_interval;
+    std::string format;
     bool initialize;
     bool help;
   };
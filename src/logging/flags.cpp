@@ -46,6 +46,15 @@ mesos::internal::logging::Flags::Flags()
       "By default, logs are flushed immediately.",
       0);
 
+  add(&Flags::async_logging,
+      "async_logging",
+      "Whether the log files in '--log_dir' are written by a background\n"
+      "thread rather than by the threads which log. INFO messages are\n"
+      "dropped (and counted) if the thread falls behind by more than a\n"
+      "few megabytes, the other messages are still written before the\n"
+      "threads which log them continue.",
+      false);
+
   add(&Flags::initialize_driver_logging,
       "initialize_driver_logging",
       "Whether the Master/Agent should initialize Google logging for the\n"
@@ -20,7 +20,10 @@
 #include <glog/logging.h>
 #include <glog/raw_logging.h>
 
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include <process/once.hpp>
 
@@ -100,6 +103,150 @@ inline void handler(int signal, siginfo_t *siginfo, void *context)
 }
 
 
+// The number of bytes of messages that the background thread writing a
+// log file may fall behind by (see 'AsyncLogger').
+constexpr size_t ASYNC_LOGGING_BUFFER_SIZE = 4 * 1024 * 1024;
+
+
+// Writes the messages of a log file from a background thread, so that
+// the threads which log (e.g., the master actor) do not wait for the
+// writes. The messages are appended to a buffer which the thread
+// swaps out and writes in one go. Messages which glog flushes right
+// away (those above '--logbuflevel', i.e., WARNING and up by default)
+// wait until they are written, so that they are not lost on a crash.
+// When the buffer is full, INFO messages are dropped and the other
+// messages wait for room; the number of dropped messages is written
+// to the log file once there is room again.
+//
+// NOTE: glog calls 'Write()' with its log mutex held, hence nothing
+// here may log through glog itself.
+class AsyncLogger : public google::base::Logger
+{
+public:
+  AsyncLogger(google::base::Logger* _logger, size_t _capacity)
+    : logger(_logger),
+      capacity(_capacity),
+      timestamp(0),
+      appended(0),
+      written(0),
+      dropped(0)
+  {
+    // The loggers are never deleted (they are owned by glog), hence
+    // the thread runs until the process exits.
+    std::thread(&AsyncLogger::run, this).detach();
+  }
+
+  virtual void Write(
+      bool force_flush,
+      time_t _timestamp,
+      const char* message,
+      int length)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (buffer.size() + length > capacity) {
+      if (!force_flush && length > 0 && message[0] == 'I') {
+        dropped++;
+        return;
+      }
+
+      while (!buffer.empty() && buffer.size() + length > capacity) {
+        done.wait(lock);
+      }
+    }
+
+    buffer.append(message, length);
+    timestamp = _timestamp;
+    appended += length;
+
+    pending.notify_one();
+
+    if (force_flush) {
+      const uint64_t end = appended;
+      while (written < end) {
+        done.wait(lock);
+      }
+    }
+  }
+
+  virtual void Flush()
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      const uint64_t end = appended;
+      while (written < end) {
+        done.wait(lock);
+      }
+    }
+
+    logger->Flush();
+  }
+
+  virtual google::uint32 LogSize()
+  {
+    return logger->LogSize();
+  }
+
+private:
+  void run()
+  {
+    string data;
+
+    while (true) {
+      time_t _timestamp;
+      uint64_t end;
+      uint64_t _dropped;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (buffer.empty()) {
+          pending.wait(lock);
+        }
+
+        data.swap(buffer);
+        _timestamp = timestamp;
+        end = appended;
+        _dropped = dropped;
+        dropped = 0;
+      }
+
+      logger->Write(true, _timestamp, data.data(), data.size());
+      data.clear();
+
+      if (_dropped > 0) {
+        const string message =
+          "Dropped " + stringify(_dropped) +
+          " INFO messages since the log buffer was full\n";
+
+        logger->Write(true, _timestamp, message.data(), message.size());
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        written = end;
+      }
+
+      done.notify_all();
+    }
+  }
+
+  google::base::Logger* logger;
+  const size_t capacity;
+
+  std::mutex mutex;
+  std::condition_variable pending; // Signaled when messages are appended.
+  std::condition_variable done; // Signaled when messages are written.
+
+  string buffer;
+  time_t timestamp; // Of the last message in the buffer.
+  uint64_t appended; // Total bytes appended.
+  uint64_t written; // Total bytes written.
+  uint64_t dropped; // Messages dropped since the last write.
+};
+
+
 google::LogSeverity getLogSeverity(const string& logging_level)
 {
   if (logging_level == "INFO") {
@@ -190,6 +337,18 @@ void initialize(
       << " level logging started!";
   }
 
+  if (flags.async_logging && flags.log_dir.isSome()) {
+    // Writing to stderr is unaffected, it is done separately by glog.
+    // FATAL messages are left alone since glog aborts right after.
+    for (int severity = google::INFO; severity < google::FATAL; severity++) {
+      google::base::SetLogger(
+          severity,
+          new AsyncLogger(
+              google::base::GetLogger(severity),
+              ASYNC_LOGGING_BUFFER_SIZE));
+    }
+  }
+
   VLOG(1) << "Logging to " <<
     (flags.log_dir.isSome() ? flags.log_dir.get() : "STDERR");
 
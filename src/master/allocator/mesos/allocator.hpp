@@ -136,6 +136,9 @@ public:
       const Resources& resources,
       const Option<Filters>& filters);
 
+  void batchRecoverResources(
+      const hashmap<SlaveID, hashmap<FrameworkID, Resources>>& resources);
+
   void suppressOffers(
       const FrameworkID& frameworkId);
 
@@ -260,6 +263,9 @@ public:
       const Resources& resources,
       const Option<Filters>& filters) = 0;
 
+  virtual void batchRecoverResources(
+      const hashmap<SlaveID, hashmap<FrameworkID, Resources>>& resources) = 0;
+
   virtual void suppressOffers(
       const FrameworkID& frameworkId) = 0;
 
@@ -575,6 +581,17 @@ inline void MesosAllocator<AllocatorProcess>::recoverResources(
 }
 
 
+template <typename AllocatorProcess>
+inline void MesosAllocator<AllocatorProcess>::batchRecoverResources(
+    const hashmap<SlaveID, hashmap<FrameworkID, Resources>>& resources)
+{
+  process::dispatch(
+      process,
+      &MesosAllocatorProcess::batchRecoverResources,
+      resources);
+}
+
+
 template <typename AllocatorProcess>
 inline void MesosAllocator<AllocatorProcess>::suppressOffers(
     const FrameworkID& frameworkId)
@@ -17,13 +17,16 @@
 #include "master/allocator/mesos/hierarchical.hpp"
 
 #include <algorithm>
+#include <thread>
 #include <vector>
 
 #include <mesos/resources.hpp>
 #include <mesos/type_utils.hpp>
 
+#include <process/clock.hpp>
 #include <process/event.hpp>
 #include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/id.hpp>
 #include <process/timeout.hpp>
 
@@ -37,8 +40,10 @@ using std::vector;
 
 using mesos::master::InverseOfferStatus;
 
+using process::Clock;
 using process::Failure;
 using process::Future;
+using process::Time;
 using process::Timeout;
 
 namespace mesos {
@@ -47,23 +52,60 @@ namespace master {
 namespace allocator {
 namespace internal {
 
-// Used to represent "filters" for resources unused in offers.
+// The total quantity of each scalar resource, by name.
+typedef hashmap<string, double> Quantities;
+
+
+static Quantities quantities(const Resources& resources)
+{
+  Quantities result;
+
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      result[resource.name()] += resource.scalar().value();
+    }
+  }
+
+  return result;
+}
+
+
+// Used to represent "filters" for resources unused in offers. The
+// scalar quantities of the resources are passed along so that filters
+// can be evaluated cheaply, without recomputing them per filter.
 class OfferFilter
 {
 public:
   virtual ~OfferFilter() {}
 
-  virtual bool filter(const Resources& resources) = 0;
+  virtual bool filter(
+      const Resources& resources,
+      const Quantities& quantities) = 0;
 };
 
 
 class RefusedOfferFilter : public OfferFilter
 {
 public:
-  RefusedOfferFilter(const Resources& _resources) : resources(_resources) {}
+  RefusedOfferFilter(const Resources& _resources)
+    : resources(_resources),
+      quantities(internal::quantities(_resources)) {}
 
-  virtual bool filter(const Resources& _resources)
+  virtual bool filter(
+      const Resources& _resources,
+      const Quantities& _quantities)
   {
+    // The refused resources can only be a superset if they contain at
+    // least as much of every scalar resource, which is a lot cheaper
+    // to check than `Resources::contains`. Since the quantities are
+    // sums of doubles, the bound allows for rounding errors and only
+    // rules out the filter if the difference is significant.
+    foreachpair (const string& name, double quantity, _quantities) {
+      if (quantity > quantities.get(name).getOrElse(0.0) + 1e-6) {
+        return false;
+      }
+    }
+
     // TODO(jieyu): Consider separating the superset check for regular
     // and revocable resources. For example, frameworks might want
     // more revocable resources only or non-revocable resources only,
@@ -74,6 +116,7 @@ public:
 
 private:
   const Resources resources;
+  const Quantities quantities;
 };
 
 
@@ -320,7 +363,7 @@ void HierarchicalAllocatorProcess::removeFramework(
   // Do not delete the filters contained in this
   // framework's `offerFilters` hashset yet, see comments in
   // HierarchicalAllocatorProcess::reviveOffers and
-  // HierarchicalAllocatorProcess::expire.
+  // HierarchicalAllocatorProcess::expireOfferFilters.
   frameworks.erase(frameworkId);
 
   LOG(INFO) << "Removed framework " << frameworkId;
@@ -364,7 +407,7 @@ void HierarchicalAllocatorProcess::deactivateFramework(
   // Do not delete the filters contained in this
   // framework's `offerFilters` hashset yet, see comments in
   // HierarchicalAllocatorProcess::reviveOffers and
-  // HierarchicalAllocatorProcess::expire.
+  // HierarchicalAllocatorProcess::expireOfferFilters.
   frameworks[frameworkId].offerFilters.clear();
   frameworks[frameworkId].inverseOfferFilters.clear();
 
@@ -396,6 +439,9 @@ void HierarchicalAllocatorProcess::updateFramework(
       frameworks[frameworkId].revocable = true;
     }
   }
+
+  // The framework might now accept resources on any of the slaves.
+  dirty = true;
 }
 
 
@@ -493,11 +539,13 @@ void HierarchicalAllocatorProcess::removeSlave(
       slaveId, slaves[slaveId].total.unreserved().nonRevocable());
 
   slaves.erase(slaveId);
+  dirtySlaves.erase(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
-  // this slave, that will occur when the delayed
-  // HierarchicalAllocatorProcess::expire gets invoked (or the framework
-  // that applied the filters gets removed).
+  // this slave, that will occur when the filters expire (see
+  // HierarchicalAllocatorProcess::expireOfferFilters and
+  // HierarchicalAllocatorProcess::expire) or the framework that
+  // applied the filters gets removed.
 
   LOG(INFO) << "Removed slave " << slaveId;
 }
@@ -573,6 +621,8 @@ void HierarchicalAllocatorProcess::updateWhitelist(
   } else {
     LOG(INFO) << "Advertising offers for all slaves";
   }
+
+  dirty = true;
 }
 
 
@@ -645,6 +695,8 @@ void HierarchicalAllocatorProcess::updateAllocation(
 
   slaves[slaveId].total = updatedTotal.get();
 
+  dirtySlaves.insert(slaveId);
+
   LOG(INFO) << "Updated allocation of framework " << frameworkId
             << " on slave " << slaveId
             << " from " << frameworkAllocation
@@ -689,6 +741,8 @@ Future<Nothing> HierarchicalAllocatorProcess::updateAvailable(
   quotaRoleSorter->update(
       slaveId, slaves[slaveId].total.unreserved().nonRevocable());
 
+  dirtySlaves.insert(slaveId);
+
   return Nothing();
 }
 
@@ -721,7 +775,16 @@ void HierarchicalAllocatorProcess::updateUnavailability(
       typename Slave::Maintenance(unavailability.get());
   }
 
-  allocate(slaveId);
+  // The master updates the unavailability of all the slaves affected
+  // by a maintenance schedule update in a row, so rather than doing
+  // an allocation (which sends the inverse offers) for every slave,
+  // the slaves are allocated together once the queued updates have
+  // been processed.
+  if (unavailabilityUpdated.empty()) {
+    dispatch(self(), &Self::allocateUnavailabilityUpdates);
+  }
+
+  unavailabilityUpdated.insert(slaveId);
 }
 
 
@@ -883,6 +946,8 @@ void HierarchicalAllocatorProcess::recoverResources(
 
     slaves[slaveId].allocated -= resources;
 
+    dirtySlaves.insert(slaveId);
+
     VLOG(1) << "Recovered " << resources
             << " (total: " << slaves[slaveId].total
             << ", allocated: " << slaves[slaveId].allocated
@@ -928,13 +993,6 @@ void HierarchicalAllocatorProcess::recoverResources(
     OfferFilter* offerFilter = new RefusedOfferFilter(resources);
     frameworks[frameworkId].offerFilters[slaveId].insert(offerFilter);
 
-    // We need to disambiguate the function call to pick the correct
-    // expire() overload.
-    void (Self::*expireOffer)(
-              const FrameworkID&,
-              const SlaveID&,
-              OfferFilter*) = &Self::expire;
-
     // Expire the filter after both an `allocationInterval` and the
     // `timeout` have elapsed. This ensures that the filter does not
     // expire before we perform the next allocation for this agent,
@@ -944,12 +1002,47 @@ void HierarchicalAllocatorProcess::recoverResources(
     // (MESOS-3078), we would not need to increase the timeout here.
     timeout = std::max(allocationInterval, timeout.get());
 
-    delay(timeout.get(),
-          self(),
-          expireOffer,
-          frameworkId,
-          slaveId,
-          offerFilter);
+    OfferFilterExpiry expiry;
+    expiry.frameworkId = frameworkId;
+    expiry.slaveId = slaveId;
+    expiry.offerFilter = offerFilter;
+
+    const Time time = Clock::now() + timeout.get();
+
+    offerFilterExpiries.insert(std::make_pair(time, expiry));
+
+    // Only the earliest expiry needs a timer, the rest of the filters
+    // are expired in batches as the timer fires.
+    if (offerFilterTimer.isNone() ||
+        time < offerFilterTimer.get().timeout().time()) {
+      if (offerFilterTimer.isSome()) {
+        Clock::cancel(offerFilterTimer.get());
+      }
+
+      offerFilterTimer =
+        delay(timeout.get(), self(), &Self::expireOfferFilters);
+    }
+  }
+}
+
+
+void HierarchicalAllocatorProcess::batchRecoverResources(
+    const hashmap<SlaveID, hashmap<FrameworkID, Resources>>& resources)
+{
+  CHECK(initialized);
+
+  // NOTE: The sorters account for the allocations per framework and
+  // slave, so the resources are already recovered with a single
+  // update of the sorters per framework and slave. The saving is in
+  // handling all of them in one dispatch rather than one per task.
+  foreachpair (const SlaveID& slaveId,
+               const auto& frameworks,
+               resources) {
+    foreachpair (const FrameworkID& frameworkId,
+                 const Resources& recovered,
+                 frameworks) {
+      recoverResources(frameworkId, slaveId, recovered, None());
+    }
   }
 }
 
@@ -974,11 +1067,11 @@ void HierarchicalAllocatorProcess::reviveOffers(
   frameworks[frameworkId].inverseOfferFilters.clear();
   frameworks[frameworkId].suppressed = false;
 
-  // We delete each actual `OfferFilter` when
-  // `HierarchicalAllocatorProcess::expire` gets invoked. If we delete the
-  // `OfferFilter` here it's possible that the same `OfferFilter` (i.e., same
-  // address) could get reused and `HierarchicalAllocatorProcess::expire`
-  // would expire that filter too soon. Note that this only works
+  // We delete each actual `OfferFilter` when it expires (see
+  // `HierarchicalAllocatorProcess::expireOfferFilters`). If we delete
+  // the `OfferFilter` here it's possible that the same `OfferFilter`
+  // (i.e., same address) could get reused and would be expired too
+  // soon. Note that this only works
   // right now because ALL Filter types "expire".
 
   LOG(INFO) << "Removed offer filters for framework " << frameworkId;
@@ -1063,13 +1156,45 @@ void HierarchicalAllocatorProcess::resume()
     VLOG(1) << "Allocation resumed";
 
     paused = false;
+
+    // Allocations are skipped while paused, hence all slaves need to
+    // be considered again.
+    dirty = true;
   }
 }
 
 
 void HierarchicalAllocatorProcess::batch()
 {
-  allocate();
+  // Without quota, whether resources on a slave get allocated does not
+  // depend on the other slaves. With quota, the resources that can be
+  // allocated during the second stage depend on all of the slaves.
+  if (dirty || !quotas.empty()) {
+    allocate();
+  } else if (paused) {
+    VLOG(1) << "Skipped allocation because the allocator is paused";
+  } else {
+    Stopwatch stopwatch;
+    stopwatch.start();
+
+    hashset<SlaveID> slaveIds = dirtySlaves;
+
+    // Inverse offers are sent as part of the allocation, so slaves
+    // scheduled for maintenance are always considered.
+    foreachpair (const SlaveID& slaveId, const Slave& slave, slaves) {
+      if (slave.maintenance.isSome()) {
+        slaveIds.insert(slaveId);
+      }
+    }
+
+    if (!slaveIds.empty()) {
+      allocate(slaveIds);
+    }
+
+    VLOG(1) << "Performed allocation for " << slaveIds.size() << " slaves in "
+            << stopwatch.elapsed();
+  }
+
   delay(allocationInterval, self(), &Self::batch);
 }
 
@@ -1085,6 +1210,8 @@ void HierarchicalAllocatorProcess::allocate()
   Stopwatch stopwatch;
   stopwatch.start();
 
+  dirty = false;
+
   allocate(slaves.keys());
 
   VLOG(1) << "Performed allocation for " << slaves.size() << " slaves in "
@@ -1112,6 +1239,39 @@ void HierarchicalAllocatorProcess::allocate(
 }
 
 
+void HierarchicalAllocatorProcess::allocateUnavailabilityUpdates()
+{
+  // Slaves might have been removed since their unavailability was
+  // updated.
+  hashset<SlaveID> slaveIds;
+  foreach (const SlaveID& slaveId, unavailabilityUpdated) {
+    if (slaves.contains(slaveId)) {
+      slaveIds.insert(slaveId);
+    }
+  }
+
+  unavailabilityUpdated.clear();
+
+  if (paused) {
+    VLOG(1) << "Skipped allocation because the allocator is paused";
+
+    return;
+  }
+
+  if (slaveIds.empty()) {
+    return;
+  }
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  allocate(slaveIds);
+
+  VLOG(1) << "Performed allocation for " << slaveIds.size()
+          << " slaves with updated unavailability in " << stopwatch.elapsed();
+}
+
+
 // TODO(alexr): Consider factoring out the quota allocation logic.
 void HierarchicalAllocatorProcess::allocate(
     const hashset<SlaveID>& slaveIds_)
@@ -1127,6 +1287,15 @@ void HierarchicalAllocatorProcess::allocate(
   // make sure that we don't assume cluster knowledge when summing resources
   // from that set.
 
+  ++metrics.allocation_runs;
+  metrics.allocation_run.start();
+
+  allocationRunSortTime = Duration::zero();
+
+  foreach (const SlaveID& slaveId, slaveIds_) {
+    dirtySlaves.erase(slaveId);
+  }
+
   vector<SlaveID> slaveIds;
   slaveIds.reserve(slaveIds_.size());
 
@@ -1143,42 +1312,75 @@ void HierarchicalAllocatorProcess::allocate(
   // TODO(vinod): Implement a smarter sorting algorithm.
   std::random_shuffle(slaveIds.begin(), slaveIds.end());
 
+  metrics.slaves_visited += slaveIds.size();
+
   // Quota comes first and fair share second. Here we process only those
   // roles, for which quota is set (quota'ed roles). Such roles form a
   // special allocation group with a dedicated sorter.
-  foreach (const SlaveID& slaveId, slaveIds) {
-    foreach (const string& role, quotaRoleSorter->sort()) {
+  //
+  // NOTE: The available resources of all slaves are computed upfront
+  // (possibly in parallel, see `computeAvailable()`) and are kept up to
+  // date as resources get allocated, so that the (inherently sequential)
+  // loops below do not need to recompute them for every framework.
+  vector<Available> available = computeAvailable(slaveIds);
+
+  metrics.allocation_run_quota.start();
+
+  // The resources consumed by the quota'ed roles whose quota is not
+  // satisfied. If quota for a role is satisfied, we do not need to do
+  // any further allocations for this role, at least at this stage, so
+  // it is removed once its quota gets satisfied. This avoids summing
+  // up the role's allocation for every slave and lets us skip the
+  // stage altogether once all quotas are satisfied.
+  //
+  // NOTE: Roles without active frameworks are skipped too, since we do
+  // not need to do any allocations for them.
+  //
+  // TODO(alexr): Skipping satisfied roles is pessimistic. A better
+  // alternative is a custom sorter that is aware of quotas and sorts
+  // accordingly.
+  hashmap<string, Resources> unsatisfiedQuotaRoles;
+  foreachkey (const string& role, quotas) {
+    if (!activeRoles.contains(role)) {
+      continue;
+    }
+
+    // Summing up resources is fine because quota is only for scalar
+    // resources.
+    //
+    // NOTE: Reserved and revocable resources are excluded in
+    // `quotaRoleSorter`.
+    //
+    // TODO(alexr): Consider including dynamically reserved resources.
+    Resources roleConsumedResources =
+      Resources::sum(quotaRoleSorter->allocation(role));
+
+    if (!roleConsumedResources.contains(quotas[role].info.guarantee())) {
+      unsatisfiedQuotaRoles[role] = roleConsumedResources;
+    }
+  }
+
+  for (size_t i = 0; i < slaveIds.size(); i++) {
+    const SlaveID& slaveId = slaveIds[i];
+
+    if (unsatisfiedQuotaRoles.empty()) {
+      break;
+    }
+
+    foreach (const string& role, sorted(quotaRoleSorter)) {
       CHECK(quotas.contains(role));
 
-      // If there are no active frameworks in this role, we do not
-      // need to do any allocations for this role.
-      if (!activeRoles.contains(role)) {
-        continue;
+      // If the slave has nothing left to allocate, move along.
+      if (!available[i].usable) {
+        break;
       }
 
-      // Summing up resources is fine because quota is only for scalar
-      // resources.
-      //
-      // NOTE: Reserved and revocable resources are excluded in
-      // `quotaRoleSorter`.
-      //
-      // TODO(alexr): Consider including dynamically reserved resources.
-      Resources roleConsumedResources =
-        Resources::sum(quotaRoleSorter->allocation(role));
-
-      // If quota for the role is satisfied, we do not need to do any further
-      // allocations for this role, at least at this stage.
-      //
-      // TODO(alexr): Skipping satisfied roles is pessimistic. Better
-      // alternatives are:
-      //   * A custom sorter that is aware of quotas and sorts accordingly.
-      //   * Removing satisfied roles from the sorter.
-      if (roleConsumedResources.contains(quotas[role].info.guarantee())) {
+      if (!unsatisfiedQuotaRoles.contains(role)) {
         continue;
       }
 
       // Fetch frameworks according to their fair share.
-      foreach (const string& frameworkId_, frameworkSorters[role]->sort()) {
+      foreach (const string& frameworkId_, sorted(frameworkSorters[role])) {
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
@@ -1192,8 +1394,7 @@ void HierarchicalAllocatorProcess::allocate(
         // resources on the agent.
         //
         // TODO(alexr): Consider adding dynamically reserved resources.
-        Resources available = slaves[slaveId].total - slaves[slaveId].allocated;
-        Resources resources = available.unreserved().nonRevocable();
+        Resources resources = available[i].unreserved.nonRevocable();
 
         // NOTE: The resources may not be allocatable here, but they can be
         // accepted by one of the frameworks during the second allocation
@@ -1218,6 +1419,9 @@ void HierarchicalAllocatorProcess::allocate(
         offerable[frameworkId][slaveId] += resources;
         slaves[slaveId].allocated += resources;
 
+        available[i] =
+          Available(slaves[slaveId].total - slaves[slaveId].allocated);
+
         // Resources allocated as part of the quota count towards the
         // role's and the framework's fair share.
         //
@@ -1226,10 +1430,23 @@ void HierarchicalAllocatorProcess::allocate(
         frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
         roleSorter->allocated(role, slaveId, resources);
         quotaRoleSorter->allocated(role, slaveId, resources);
+
+        // NOTE: The role is not skipped for the remaining frameworks on
+        // this slave, but there is nothing left for them to allocate.
+        if (unsatisfiedQuotaRoles.contains(role)) {
+          unsatisfiedQuotaRoles[role] += resources;
+
+          if (unsatisfiedQuotaRoles[role].contains(
+                  quotas[role].info.guarantee())) {
+            unsatisfiedQuotaRoles.erase(role);
+          }
+        }
       }
     }
   }
 
+  metrics.allocation_run_quota.stop();
+
   // Calculate how many resources (including revocable and reserved) are
   // available for allocation in the next round. We need this in order to
   // ensure we do not over-allocate resources during the second stage.
@@ -1276,15 +1493,22 @@ void HierarchicalAllocatorProcess::allocate(
 
   // At this point resources for quotas are allocated or accounted for.
   // Proceed with allocating the remaining free pool.
-  foreach (const SlaveID& slaveId, slaveIds) {
+  for (size_t i = 0; i < slaveIds.size(); i++) {
+    const SlaveID& slaveId = slaveIds[i];
+
     // If there are no resources available for the second stage, stop.
     if (!allocatable(remainingClusterResources - allocatedStage2)) {
       break;
     }
 
-    foreach (const string& role, roleSorter->sort()) {
+    // If the slave has nothing left to allocate, move along.
+    if (!available[i].usable) {
+      continue;
+    }
+
+    foreach (const string& role, sorted(roleSorter)) {
       foreach (const string& frameworkId_,
-               frameworkSorters[role]->sort()) {
+               sorted(frameworkSorters[role])) {
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
@@ -1293,12 +1517,12 @@ void HierarchicalAllocatorProcess::allocate(
           continue;
         }
 
-        // Calculate the currently available resources on the slave.
-        Resources available = slaves[slaveId].total - slaves[slaveId].allocated;
-
-        // NOTE: Currently, frameworks are allowed to have '*' role.
-        // Calling reserved('*') returns an empty Resources object.
-        Resources resources = available.unreserved() + available.reserved(role);
+        // NOTE: Currently, frameworks are allowed to have '*' role,
+        // for which there are no reserved resources.
+        Resources resources = available[i].unreserved;
+        if (available[i].reserved.contains(role)) {
+          resources += available[i].reserved.at(role);
+        }
 
         // Remove revocable resources if the framework has not opted
         // for them.
@@ -1336,6 +1560,9 @@ void HierarchicalAllocatorProcess::allocate(
         allocatedStage2 += resources;
         slaves[slaveId].allocated += resources;
 
+        available[i] =
+          Available(slaves[slaveId].total - slaves[slaveId].allocated);
+
         // Reserved resources are only accounted for in the framework
         // sorter, since the reserved resources are not shared across
         // roles.
@@ -1356,6 +1583,7 @@ void HierarchicalAllocatorProcess::allocate(
   } else {
     // Now offer the resources to each framework.
     foreachkey (const FrameworkID& frameworkId, offerable) {
+      metrics.offers += offerable[frameworkId].size();
       offerCallback(frameworkId, offerable[frameworkId]);
     }
   }
@@ -1364,6 +1592,8 @@ void HierarchicalAllocatorProcess::allocate(
   // allocator. We leverage the existing timer/cycle of offers to also do any
   // "deallocation" (inverse offers) necessary to satisfy maintenance needs.
   deallocate(slaveIds_);
+
+  metrics.allocation_run.stop();
 }
 
 
@@ -1457,26 +1687,54 @@ void HierarchicalAllocatorProcess::deallocate(
 }
 
 
-void HierarchicalAllocatorProcess::expire(
-    const FrameworkID& frameworkId,
-    const SlaveID& slaveId,
-    OfferFilter* offerFilter)
+void HierarchicalAllocatorProcess::expireOfferFilters()
 {
-  // The filter might have already been removed (e.g., if the
-  // framework no longer exists or in
-  // HierarchicalAllocatorProcess::reviveOffers) but not yet deleted (to
-  // keep the address from getting reused possibly causing premature
-  // expiration).
-  if (frameworks.contains(frameworkId) &&
-      frameworks[frameworkId].offerFilters.contains(slaveId) &&
-      frameworks[frameworkId].offerFilters[slaveId].contains(offerFilter)) {
-    frameworks[frameworkId].offerFilters[slaveId].erase(offerFilter);
-    if (frameworks[frameworkId].offerFilters[slaveId].empty()) {
-      frameworks[frameworkId].offerFilters.erase(slaveId);
+  // The timer might not be the one that fired (if it could not be
+  // canceled in time), make sure there is only ever one pending.
+  if (offerFilterTimer.isSome()) {
+    Clock::cancel(offerFilterTimer.get());
+    offerFilterTimer = None();
+  }
+
+  const Time now = Clock::now();
+
+  while (!offerFilterExpiries.empty() &&
+         offerFilterExpiries.begin()->first <= now) {
+    const FrameworkID& frameworkId =
+      offerFilterExpiries.begin()->second.frameworkId;
+    const SlaveID& slaveId = offerFilterExpiries.begin()->second.slaveId;
+    OfferFilter* offerFilter = offerFilterExpiries.begin()->second.offerFilter;
+
+    // The resources that were filtered might get allocated now.
+    if (slaves.contains(slaveId)) {
+      dirtySlaves.insert(slaveId);
+    }
+
+    // The filter might have already been removed (e.g., if the
+    // framework no longer exists or in
+    // HierarchicalAllocatorProcess::reviveOffers) but not yet deleted
+    // (to keep the address from getting reused possibly causing
+    // premature expiration).
+    if (frameworks.contains(frameworkId) &&
+        frameworks[frameworkId].offerFilters.contains(slaveId) &&
+        frameworks[frameworkId].offerFilters[slaveId].contains(offerFilter)) {
+      frameworks[frameworkId].offerFilters[slaveId].erase(offerFilter);
+      if (frameworks[frameworkId].offerFilters[slaveId].empty()) {
+        frameworks[frameworkId].offerFilters.erase(slaveId);
+      }
     }
+
+    delete offerFilter;
+
+    offerFilterExpiries.erase(offerFilterExpiries.begin());
   }
 
-  delete offerFilter;
+  if (!offerFilterExpiries.empty()) {
+    offerFilterTimer = delay(
+        offerFilterExpiries.begin()->first - now,
+        self(),
+        &Self::expireOfferFilters);
+  }
 }
 
 
@@ -1535,9 +1793,13 @@ bool HierarchicalAllocatorProcess::isFiltered(
   CHECK(slaves.contains(slaveId));
 
   if (frameworks[frameworkId].offerFilters.contains(slaveId)) {
+    const Quantities quantities = internal::quantities(resources);
+
     foreach (
       OfferFilter* offerFilter, frameworks[frameworkId].offerFilters[slaveId]) {
-      if (offerFilter->filter(resources)) {
+      if (offerFilter->filter(resources, quantities)) {
+        ++metrics.offers_filtered;
+
         VLOG(1) << "Filtered offer with " << resources
                 << " on slave " << slaveId
                 << " for framework " << frameworkId;
@@ -1575,6 +1837,19 @@ bool HierarchicalAllocatorProcess::isFiltered(
 }
 
 
+const vector<string>& HierarchicalAllocatorProcess::sorted(Sorter* sorter)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  const vector<string>& result = sorter->sorted();
+
+  allocationRunSortTime += stopwatch.elapsed();
+
+  return result;
+}
+
+
 bool HierarchicalAllocatorProcess::allocatable(
     const Resources& resources)
 {
@@ -1585,6 +1860,57 @@ bool HierarchicalAllocatorProcess::allocatable(
          (mem.isSome() && mem.get() >= MIN_MEM);
 }
 
+
+HierarchicalAllocatorProcess::Available::Available(const Resources& resources)
+  : unreserved(resources.unreserved()),
+    reserved(resources.reserved()),
+    usable(allocatable(resources)) {}
+
+
+vector<HierarchicalAllocatorProcess::Available>
+HierarchicalAllocatorProcess::computeAvailable(const vector<SlaveID>& slaveIds)
+{
+  vector<Available> available(slaveIds.size());
+
+  // NOTE: Only `slaves` is read (and written to disjoint elements of
+  // `available`) while the shards are being computed.
+  auto compute = [this, &slaveIds, &available](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const Slave& slave = slaves.at(slaveIds[i]);
+      available[i] = Available(slave.total - slave.allocated);
+    }
+  };
+
+  // Spawning threads is only worthwhile when there are enough slaves
+  // to amortize it, so each shard covers at least this many slaves.
+  const size_t MIN_SLAVES_PER_SHARD = 1000;
+
+  size_t shards = std::min<size_t>(
+      std::max(std::thread::hardware_concurrency(), 1u),
+      slaveIds.size() / MIN_SLAVES_PER_SHARD);
+
+  if (shards <= 1) {
+    compute(0, slaveIds.size());
+    return available;
+  }
+
+  const size_t size = (slaveIds.size() + shards - 1) / shards;
+
+  vector<std::thread> threads;
+  for (size_t begin = size; begin < slaveIds.size(); begin += size) {
+    threads.emplace_back(
+        compute, begin, std::min(begin + size, slaveIds.size()));
+  }
+
+  compute(0, size);
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  return available;
+}
+
 } // namespace internal {
 } // namespace allocator {
 } // namespace master {
@@ -17,16 +17,23 @@
 #ifndef __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
 #include <process/id.hpp>
+#include <process/time.hpp>
+#include <process/timer.hpp>
+#include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/flathashmap.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/option.hpp>
@@ -71,6 +78,7 @@ public:
     : ProcessBase(process::ID::generate("hierarchical-allocator")),
       initialized(false),
       paused(true),
+      dirty(true),
       metrics(*this),
       roleSorter(NULL),
       quotaRoleSorter(NULL),
@@ -174,6 +182,9 @@ public:
       const Resources& resources,
       const Option<Filters>& filters);
 
+  void batchRecoverResources(
+      const hashmap<SlaveID, hashmap<FrameworkID, Resources>>& resources);
+
   void suppressOffers(
       const FrameworkID& frameworkId);
 
@@ -208,14 +219,15 @@ protected:
   // Allocate resources from the specified slaves.
   void allocate(const hashset<SlaveID>& slaveIds);
 
+  // Allocate resources from the slaves in `unavailabilityUpdated`.
+  void allocateUnavailabilityUpdates();
+
   // Send inverse offers from the specified slaves.
   void deallocate(const hashset<SlaveID>& slaveIds);
 
-  // Remove an offer filter for the specified framework.
-  void expire(
-      const FrameworkID& frameworkId,
-      const SlaveID& slaveId,
-      OfferFilter* offerFilter);
+  // Remove the offer filters that have expired, see
+  // `offerFilterExpiries`.
+  void expireOfferFilters();
 
   // Remove an inverse offer filter for the specified framework.
   void expire(
@@ -242,11 +254,45 @@ protected:
       const FrameworkID& frameworkID,
       const SlaveID& slaveID);
 
-  bool allocatable(const Resources& resources);
+  static bool allocatable(const Resources& resources);
+
+  // The resources available on a slave (i.e., not allocated), split up
+  // the way the allocation stages consume them.
+  struct Available
+  {
+    Available() : usable(false) {}
+
+    explicit Available(const Resources& resources);
+
+    Resources unreserved;
+    hashmap<std::string, Resources> reserved;
+
+    // Whether the available resources are allocatable. If they are not,
+    // no subset of them is either.
+    bool usable;
+  };
+
+  // Returns the available resources of each slave, in the same order as
+  // `slaveIds`. For large clusters the slaves are split up into shards
+  // which are computed in parallel.
+  std::vector<Available> computeAvailable(const std::vector<SlaveID>& slaveIds);
 
   bool initialized;
   bool paused;
 
+  // The batch allocation only considers the slaves that might allow
+  // for new allocations since they were last allocated, e.g., because
+  // resources on them were recovered or offer filters for them have
+  // expired. If `dirty` is set (e.g., after the whitelist was updated)
+  // the next batch allocation considers all slaves.
+  bool dirty;
+  hashset<SlaveID> dirtySlaves;
+
+  // The slaves whose unavailability was updated since the last call
+  // to `allocateUnavailabilityUpdates`, which is dispatched by the
+  // first of a series of `updateUnavailability` calls.
+  hashset<SlaveID> unavailabilityUpdated;
+
   // Recovery data.
   Option<int> expectedAgentCount;
 
@@ -265,19 +311,71 @@ protected:
     explicit Metrics(const Self& process)
       : event_queue_dispatches(
             "allocator/event_queue_dispatches",
-            process::defer(process.self(), &Self::_event_queue_dispatches))
+            process::defer(process.self(), &Self::_event_queue_dispatches)),
+        allocation_runs("allocator/mesos/allocation_runs"),
+        allocation_run("allocator/mesos/allocation_run", Hours(1)),
+        allocation_run_quota("allocator/mesos/allocation_run_quota", Hours(1)),
+        allocation_run_sort(
+            "allocator/mesos/allocation_run_sort_ms",
+            process::defer(process.self(), &Self::_allocation_run_sort)),
+        slaves_visited("allocator/mesos/slaves_visited"),
+        offers("allocator/mesos/offers"),
+        offers_filtered("allocator/mesos/offers_filtered")
     {
       process::metrics::add(event_queue_dispatches);
+      process::metrics::add(allocation_runs);
+      process::metrics::add(allocation_run);
+      process::metrics::add(allocation_run_quota);
+      process::metrics::add(allocation_run_sort);
+      process::metrics::add(slaves_visited);
+      process::metrics::add(offers);
+      process::metrics::add(offers_filtered);
     }
 
     ~Metrics()
     {
       process::metrics::remove(event_queue_dispatches);
+      process::metrics::remove(allocation_runs);
+      process::metrics::remove(allocation_run);
+      process::metrics::remove(allocation_run_quota);
+      process::metrics::remove(allocation_run_sort);
+      process::metrics::remove(slaves_visited);
+      process::metrics::remove(offers);
+      process::metrics::remove(offers_filtered);
     }
 
     process::metrics::Gauge event_queue_dispatches;
+
+    // Number of allocation runs and the time they took, in total and
+    // for allocating quota (i.e., the first allocation stage).
+    process::metrics::Counter allocation_runs;
+    process::metrics::Timer<Milliseconds> allocation_run;
+    process::metrics::Timer<Milliseconds> allocation_run_quota;
+
+    // Time spent sorting during the latest allocation run.
+    process::metrics::Gauge allocation_run_sort;
+
+    // Number of slaves considered by allocation runs, number of offers
+    // (i.e., resources of a slave for a framework) made by allocation
+    // runs and the number of offers that were filtered.
+    process::metrics::Counter slaves_visited;
+    process::metrics::Counter offers;
+    process::metrics::Counter offers_filtered;
   } metrics;
 
+  // Time spent sorting during the latest allocation run, see
+  // `sorted()`.
+  Duration allocationRunSortTime;
+
+  double _allocation_run_sort()
+  {
+    return allocationRunSortTime.ms();
+  }
+
+  // Returns the sorted clients of the sorter, accounting for the time
+  // spent sorting in `allocationRunSortTime`.
+  const std::vector<std::string>& sorted(Sorter* sorter);
+
   struct Framework
   {
     std::string role;
@@ -298,7 +396,7 @@ protected:
     return static_cast<double>(eventCount<process::DispatchEvent>());
   }
 
-  hashmap<FrameworkID, Framework> frameworks;
+  flathashmap<FrameworkID, Framework> frameworks;
 
   struct Slave
   {
@@ -362,7 +460,20 @@ protected:
     Option<Maintenance> maintenance;
   };
 
-  hashmap<SlaveID, Slave> slaves;
+  flathashmap<SlaveID, Slave> slaves;
+
+  // Offer filters by the time at which they expire. Rather than
+  // scheduling a timer for each filter, a single timer is kept for the
+  // earliest expiry which removes all filters that are due at once.
+  struct OfferFilterExpiry
+  {
+    FrameworkID frameworkId;
+    SlaveID slaveId;
+    OfferFilter* offerFilter;
+  };
+
+  std::multimap<process::Time, OfferFilterExpiry> offerFilterExpiries;
+  Option<process::Timer> offerFilterTimer;
 
   // Number of registered frameworks for each role. When a role's active
   // count drops to zero, it is removed from this map; the role is also
@@ -0,0 +1,556 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+
+#include <string>
+#include <vector>
+
+#include <process/clock.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/result.hpp>
+
+#include "logging/logging.hpp"
+
+#include "master/allocator/recorder.hpp"
+
+using std::string;
+using std::vector;
+
+using mesos::master::InverseOfferStatus;
+
+using process::Clock;
+using process::Future;
+using process::Owned;
+using process::Process;
+
+using process::delay;
+using process::dispatch;
+using process::spawn;
+using process::terminate;
+using process::wait; // Necessary on some OS's to disambiguate.
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// The interval at which the buffered events are written out, which
+// bounds the events that are lost if the master crashes.
+static const Duration FLUSH_INTERVAL = Seconds(1);
+
+
+class RecorderProcess : public Process<RecorderProcess>
+{
+public:
+  explicit RecorderProcess(int _fd)
+    : ProcessBase(process::ID::generate("allocator-recorder")),
+      fd(_fd),
+      writer(_fd) {}
+
+  virtual ~RecorderProcess() {}
+
+  void record(const AllocatorEvent& event)
+  {
+    Try<Nothing> write = writer.write(event);
+    if (write.isError()) {
+      LOG(WARNING) << "Failed to record allocator event: " << write.error();
+    }
+  }
+
+protected:
+  virtual void initialize()
+  {
+    timeout();
+  }
+
+  virtual void finalize()
+  {
+    flush();
+    os::close(fd);
+  }
+
+private:
+  void timeout()
+  {
+    flush();
+    delay(FLUSH_INTERVAL, self(), &Self::timeout);
+  }
+
+  void flush()
+  {
+    Try<Nothing> flush = writer.flush();
+    if (flush.isError()) {
+      LOG(WARNING) << "Failed to record allocator events: " << flush.error();
+    }
+  }
+
+  const int fd;
+  protobuf::Writer writer;
+};
+
+
+// Adds the resources of a framework on an agent to the event.
+static void allocation(
+    AllocatorEvent* event,
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  AllocatorEvent::Allocation* allocation = event->add_allocations();
+  allocation->mutable_framework_id()->CopyFrom(frameworkId);
+  allocation->mutable_slave_id()->CopyFrom(slaveId);
+  allocation->mutable_resources()->CopyFrom(resources);
+}
+
+
+Try<RecordingAllocator*> RecordingAllocator::create(
+    mesos::master::allocator::Allocator* allocator,
+    const string& path)
+{
+  Try<int> fd = os::open(
+      path,
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  return new RecordingAllocator(allocator, fd.get());
+}
+
+
+Try<vector<AllocatorEvent>> RecordingAllocator::read(const string& path)
+{
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  protobuf::Reader<AllocatorEvent> reader(fd.get());
+
+  vector<AllocatorEvent> events;
+
+  while (true) {
+    // NOTE: The last event may have been partially written if the
+    // master crashed, in which case it is ignored.
+    Result<AllocatorEvent> event = reader.read(true);
+
+    if (event.isError()) {
+      os::close(fd.get());
+      return Error("Failed to read '" + path + "': " + event.error());
+    } else if (event.isNone()) {
+      break;
+    }
+
+    events.push_back(event.get());
+  }
+
+  os::close(fd.get());
+
+  return events;
+}
+
+
+RecordingAllocator::RecordingAllocator(
+    mesos::master::allocator::Allocator* _allocator,
+    int fd)
+  : allocator(_allocator)
+{
+  process = new RecorderProcess(fd);
+  spawn(process);
+}
+
+
+RecordingAllocator::~RecordingAllocator()
+{
+  // Destroy the allocator first, so that it makes no more offers.
+  allocator.reset();
+
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+AllocatorEvent RecordingAllocator::event(AllocatorEvent::Type type)
+{
+  AllocatorEvent event;
+  event.set_type(type);
+  event.set_timestamp(Clock::now().secs());
+  return event;
+}
+
+
+void RecordingAllocator::record(const AllocatorEvent& event)
+{
+  dispatch(process, &RecorderProcess::record, event);
+}
+
+
+void RecordingAllocator::initialize(
+    const Duration& allocationInterval,
+    const lambda::function<
+        void(const FrameworkID&,
+             const hashmap<SlaveID, Resources>&)>& offerCallback,
+    const lambda::function<
+        void(const FrameworkID&,
+             const hashmap<SlaveID, UnavailableResources>&)>&
+      inverseOfferCallback,
+    const hashmap<string, double>& weights)
+{
+  // NOTE: The offers are made by the allocator, i.e., this callback
+  // is not invoked by the master.
+  RecorderProcess* recorder = process;
+
+  auto recordingOfferCallback = [=](
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, Resources>& resources) {
+    AllocatorEvent offer = event(AllocatorEvent::OFFER);
+    offer.mutable_framework_id()->CopyFrom(frameworkId);
+
+    foreachpair (const SlaveID& slaveId,
+                 const Resources& offered,
+                 resources) {
+      allocation(&offer, frameworkId, slaveId, offered);
+    }
+
+    dispatch(recorder, &RecorderProcess::record, offer);
+
+    offerCallback(frameworkId, resources);
+  };
+
+  allocator->initialize(
+      allocationInterval,
+      recordingOfferCallback,
+      inverseOfferCallback,
+      weights);
+}
+
+
+void RecordingAllocator::recover(
+    const int expectedAgentCount,
+    const hashmap<string, Quota>& quotas)
+{
+  foreachpair (const string& role, const Quota& quota, quotas) {
+    AllocatorEvent recovered = event(AllocatorEvent::SET_QUOTA);
+    recovered.set_role(role);
+    recovered.mutable_resources()->CopyFrom(quota.info.guarantee());
+    record(recovered);
+  }
+
+  allocator->recover(expectedAgentCount, quotas);
+}
+
+
+void RecordingAllocator::addFramework(
+    const FrameworkID& frameworkId,
+    const FrameworkInfo& frameworkInfo,
+    const hashmap<SlaveID, Resources>& used)
+{
+  AllocatorEvent added = event(AllocatorEvent::ADD_FRAMEWORK);
+  added.mutable_framework_id()->CopyFrom(frameworkId);
+  added.mutable_framework_info()->CopyFrom(frameworkInfo);
+
+  foreachpair (const SlaveID& slaveId, const Resources& resources, used) {
+    allocation(&added, frameworkId, slaveId, resources);
+  }
+
+  record(added);
+
+  allocator->addFramework(frameworkId, frameworkInfo, used);
+}
+
+
+void RecordingAllocator::removeFramework(
+    const FrameworkID& frameworkId)
+{
+  AllocatorEvent removed = event(AllocatorEvent::REMOVE_FRAMEWORK);
+  removed.mutable_framework_id()->CopyFrom(frameworkId);
+  record(removed);
+
+  allocator->removeFramework(frameworkId);
+}
+
+
+void RecordingAllocator::activateFramework(
+    const FrameworkID& frameworkId)
+{
+  AllocatorEvent activated = event(AllocatorEvent::ACTIVATE_FRAMEWORK);
+  activated.mutable_framework_id()->CopyFrom(frameworkId);
+  record(activated);
+
+  allocator->activateFramework(frameworkId);
+}
+
+
+void RecordingAllocator::deactivateFramework(
+    const FrameworkID& frameworkId)
+{
+  AllocatorEvent deactivated = event(AllocatorEvent::DEACTIVATE_FRAMEWORK);
+  deactivated.mutable_framework_id()->CopyFrom(frameworkId);
+  record(deactivated);
+
+  allocator->deactivateFramework(frameworkId);
+}
+
+
+void RecordingAllocator::updateFramework(
+    const FrameworkID& frameworkId,
+    const FrameworkInfo& frameworkInfo)
+{
+  AllocatorEvent updated = event(AllocatorEvent::UPDATE_FRAMEWORK);
+  updated.mutable_framework_id()->CopyFrom(frameworkId);
+  updated.mutable_framework_info()->CopyFrom(frameworkInfo);
+  record(updated);
+
+  allocator->updateFramework(frameworkId, frameworkInfo);
+}
+
+
+void RecordingAllocator::addSlave(
+    const SlaveID& slaveId,
+    const SlaveInfo& slaveInfo,
+    const Option<Unavailability>& unavailability,
+    const Resources& total,
+    const hashmap<FrameworkID, Resources>& used)
+{
+  AllocatorEvent added = event(AllocatorEvent::ADD_SLAVE);
+  added.mutable_slave_id()->CopyFrom(slaveId);
+  added.mutable_slave_info()->CopyFrom(slaveInfo);
+  added.mutable_resources()->CopyFrom(total);
+
+  foreachpair (const FrameworkID& frameworkId,
+               const Resources& resources,
+               used) {
+    allocation(&added, frameworkId, slaveId, resources);
+  }
+
+  record(added);
+
+  allocator->addSlave(slaveId, slaveInfo, unavailability, total, used);
+}
+
+
+void RecordingAllocator::removeSlave(
+    const SlaveID& slaveId)
+{
+  AllocatorEvent removed = event(AllocatorEvent::REMOVE_SLAVE);
+  removed.mutable_slave_id()->CopyFrom(slaveId);
+  record(removed);
+
+  allocator->removeSlave(slaveId);
+}
+
+
+void RecordingAllocator::updateSlave(
+    const SlaveID& slaveId,
+    const Resources& oversubscribed)
+{
+  AllocatorEvent updated = event(AllocatorEvent::UPDATE_SLAVE);
+  updated.mutable_slave_id()->CopyFrom(slaveId);
+  updated.mutable_resources()->CopyFrom(oversubscribed);
+  record(updated);
+
+  allocator->updateSlave(slaveId, oversubscribed);
+}
+
+
+void RecordingAllocator::activateSlave(
+    const SlaveID& slaveId)
+{
+  AllocatorEvent activated = event(AllocatorEvent::ACTIVATE_SLAVE);
+  activated.mutable_slave_id()->CopyFrom(slaveId);
+  record(activated);
+
+  allocator->activateSlave(slaveId);
+}
+
+
+void RecordingAllocator::deactivateSlave(
+    const SlaveID& slaveId)
+{
+  AllocatorEvent deactivated = event(AllocatorEvent::DEACTIVATE_SLAVE);
+  deactivated.mutable_slave_id()->CopyFrom(slaveId);
+  record(deactivated);
+
+  allocator->deactivateSlave(slaveId);
+}
+
+
+void RecordingAllocator::updateWhitelist(
+    const Option<hashset<string>>& whitelist)
+{
+  allocator->updateWhitelist(whitelist);
+}
+
+
+void RecordingAllocator::requestResources(
+    const FrameworkID& frameworkId,
+    const vector<Request>& requests)
+{
+  allocator->requestResources(frameworkId, requests);
+}
+
+
+void RecordingAllocator::updateAllocation(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const vector<Offer::Operation>& operations)
+{
+  allocator->updateAllocation(frameworkId, slaveId, operations);
+}
+
+
+Future<Nothing> RecordingAllocator::updateAvailable(
+    const SlaveID& slaveId,
+    const vector<Offer::Operation>& operations)
+{
+  return allocator->updateAvailable(slaveId, operations);
+}
+
+
+void RecordingAllocator::updateUnavailability(
+    const SlaveID& slaveId,
+    const Option<Unavailability>& unavailability)
+{
+  allocator->updateUnavailability(slaveId, unavailability);
+}
+
+
+void RecordingAllocator::updateInverseOffer(
+    const SlaveID& slaveId,
+    const FrameworkID& frameworkId,
+    const Option<UnavailableResources>& unavailableResources,
+    const Option<InverseOfferStatus>& status,
+    const Option<Filters>& filters)
+{
+  allocator->updateInverseOffer(
+      slaveId,
+      frameworkId,
+      unavailableResources,
+      status,
+      filters);
+}
+
+
+Future<hashmap<SlaveID, hashmap<FrameworkID, InverseOfferStatus>>>
+RecordingAllocator::getInverseOfferStatuses()
+{
+  return allocator->getInverseOfferStatuses();
+}
+
+
+void RecordingAllocator::recoverResources(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const Resources& resources,
+    const Option<Filters>& filters)
+{
+  AllocatorEvent recovered = event(AllocatorEvent::RECOVER_RESOURCES);
+  allocation(&recovered, frameworkId, slaveId, resources);
+
+  if (filters.isSome()) {
+    recovered.mutable_filters()->CopyFrom(filters.get());
+  }
+
+  record(recovered);
+
+  allocator->recoverResources(frameworkId, slaveId, resources, filters);
+}
+
+
+void RecordingAllocator::batchRecoverResources(
+    const hashmap<SlaveID, hashmap<FrameworkID, Resources>>& resources)
+{
+  AllocatorEvent recovered = event(AllocatorEvent::RECOVER_RESOURCES);
+
+  foreachpair (const SlaveID& slaveId,
+               const auto& frameworks,
+               resources) {
+    foreachpair (const FrameworkID& frameworkId,
+                 const Resources& recovered_,
+                 frameworks) {
+      allocation(&recovered, frameworkId, slaveId, recovered_);
+    }
+  }
+
+  record(recovered);
+
+  allocator->batchRecoverResources(resources);
+}
+
+
+void RecordingAllocator::suppressOffers(
+    const FrameworkID& frameworkId)
+{
+  AllocatorEvent suppressed = event(AllocatorEvent::SUPPRESS_OFFERS);
+  suppressed.mutable_framework_id()->CopyFrom(frameworkId);
+  record(suppressed);
+
+  allocator->suppressOffers(frameworkId);
+}
+
+
+void RecordingAllocator::reviveOffers(
+    const FrameworkID& frameworkId)
+{
+  AllocatorEvent revived = event(AllocatorEvent::REVIVE_OFFERS);
+  revived.mutable_framework_id()->CopyFrom(frameworkId);
+  record(revived);
+
+  allocator->reviveOffers(frameworkId);
+}
+
+
+void RecordingAllocator::setQuota(
+    const string& role,
+    const Quota& quota)
+{
+  AllocatorEvent set = event(AllocatorEvent::SET_QUOTA);
+  set.set_role(role);
+  set.mutable_resources()->CopyFrom(quota.info.guarantee());
+  record(set);
+
+  allocator->setQuota(role, quota);
+}
+
+
+void RecordingAllocator::removeQuota(
+    const string& role)
+{
+  AllocatorEvent removed = event(AllocatorEvent::REMOVE_QUOTA);
+  removed.set_role(role);
+  record(removed);
+
+  allocator->removeQuota(role);
+}
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,199 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_ALLOCATOR_RECORDER_HPP__
+#define __MASTER_ALLOCATOR_RECORDER_HPP__
+
+#include <string>
+#include <vector>
+
+#include <mesos/master/allocator.hpp>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/try.hpp>
+
+#include "messages/messages.hpp"
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// Forward declaration.
+class RecorderProcess;
+
+// An allocator which forwards all calls to another allocator, and
+// records the calls which matter to the allocation (i.e., the agents,
+// the frameworks, the recoveries of resources, which include the
+// declined offers, and the quotas) as well as the offers made by the
+// allocator as 'AllocatorEvent's appended to a file (see
+// --allocator_record_file). The events are written by a process of
+// their own, i.e., neither by the master nor by the allocator.
+//
+// A recording can be replayed against an allocator (e.g., by the
+// 'HierarchicalAllocator_BENCHMARK_Test.Replay' benchmark) in order
+// to measure changes of the allocator or of its options against a
+// real workload.
+//
+// NOTE: The maintenance primitives (unavailabilities and inverse
+// offers), the whitelist, the requests and the offer operations are
+// not recorded.
+class RecordingAllocator : public mesos::master::allocator::Allocator
+{
+public:
+  // Takes ownership of the given allocator, unless an error is
+  // returned. The file is created, or truncated if it exists.
+  static Try<RecordingAllocator*> create(
+      mesos::master::allocator::Allocator* allocator,
+      const std::string& path);
+
+  // Returns the events of a recording, in order.
+  static Try<std::vector<AllocatorEvent>> read(const std::string& path);
+
+  virtual ~RecordingAllocator();
+
+  virtual void initialize(
+      const Duration& allocationInterval,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<SlaveID, Resources>&)>& offerCallback,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<SlaveID, UnavailableResources>&)>&
+        inverseOfferCallback,
+      const hashmap<std::string, double>& weights);
+
+  virtual void recover(
+      const int expectedAgentCount,
+      const hashmap<std::string, Quota>& quotas);
+
+  virtual void addFramework(
+      const FrameworkID& frameworkId,
+      const FrameworkInfo& frameworkInfo,
+      const hashmap<SlaveID, Resources>& used);
+
+  virtual void removeFramework(
+      const FrameworkID& frameworkId);
+
+  virtual void activateFramework(
+      const FrameworkID& frameworkId);
+
+  virtual void deactivateFramework(
+      const FrameworkID& frameworkId);
+
+  virtual void updateFramework(
+      const FrameworkID& frameworkId,
+      const FrameworkInfo& frameworkInfo);
+
+  virtual void addSlave(
+      const SlaveID& slaveId,
+      const SlaveInfo& slaveInfo,
+      const Option<Unavailability>& unavailability,
+      const Resources& total,
+      const hashmap<FrameworkID, Resources>& used);
+
+  virtual void removeSlave(
+      const SlaveID& slaveId);
+
+  virtual void updateSlave(
+      const SlaveID& slave,
+      const Resources& oversubscribed);
+
+  virtual void activateSlave(
+      const SlaveID& slaveId);
+
+  virtual void deactivateSlave(
+      const SlaveID& slaveId);
+
+  virtual void updateWhitelist(
+      const Option<hashset<std::string>>& whitelist);
+
+  virtual void requestResources(
+      const FrameworkID& frameworkId,
+      const std::vector<Request>& requests);
+
+  virtual void updateAllocation(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const std::vector<Offer::Operation>& operations);
+
+  virtual process::Future<Nothing> updateAvailable(
+      const SlaveID& slaveId,
+      const std::vector<Offer::Operation>& operations);
+
+  virtual void updateUnavailability(
+      const SlaveID& slaveId,
+      const Option<Unavailability>& unavailability);
+
+  virtual void updateInverseOffer(
+      const SlaveID& slaveId,
+      const FrameworkID& frameworkId,
+      const Option<UnavailableResources>& unavailableResources,
+      const Option<mesos::master::InverseOfferStatus>& status,
+      const Option<Filters>& filters);
+
+  virtual process::Future<
+      hashmap<SlaveID, hashmap<FrameworkID, mesos::master::InverseOfferStatus>>>
+    getInverseOfferStatuses();
+
+  virtual void recoverResources(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources,
+      const Option<Filters>& filters);
+
+  virtual void batchRecoverResources(
+      const hashmap<SlaveID, hashmap<FrameworkID, Resources>>& resources);
+
+  virtual void suppressOffers(
+      const FrameworkID& frameworkId);
+
+  virtual void reviveOffers(
+      const FrameworkID& frameworkId);
+
+  virtual void setQuota(
+      const std::string& role,
+      const Quota& quota);
+
+  virtual void removeQuota(
+      const std::string& role);
+
+private:
+  RecordingAllocator(
+      mesos::master::allocator::Allocator* allocator,
+      int fd);
+
+  RecordingAllocator(const RecordingAllocator&); // Not copyable.
+  RecordingAllocator& operator=(const RecordingAllocator&); // Not assignable.
+
+  // Returns a new event of the given type, at the current time.
+  static AllocatorEvent event(AllocatorEvent::Type type);
+
+  void record(const AllocatorEvent& event);
+
+  process::Owned<mesos::master::allocator::Allocator> allocator;
+  RecorderProcess* process;
+};
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_ALLOCATOR_RECORDER_HPP__
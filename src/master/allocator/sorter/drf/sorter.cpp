@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+
 #include "logging/logging.hpp"
 
 #include "master/allocator/sorter/drf/sorter.hpp"
@@ -21,6 +23,7 @@
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -42,7 +45,7 @@ bool DRFComparator::operator()(const Client& client1, const Client& client2)
 void DRFSorter::add(const string& name, double weight)
 {
   Client client(name, 0, 0);
-  clients.insert(client);
+  insert(client);
 
   allocations[name] = Allocation();
   weights[name] = weight;
@@ -54,7 +57,7 @@ void DRFSorter::remove(const string& name)
   set<Client, DRFComparator>::iterator it = find(name);
 
   if (it != clients.end()) {
-    clients.erase(it);
+    erase(it);
   }
 
   allocations.erase(name);
@@ -67,7 +70,7 @@ void DRFSorter::activate(const string& name)
   CHECK(allocations.contains(name));
 
   Client client(name, calculateShare(name), 0);
-  clients.insert(client);
+  insert(client);
 }
 
 
@@ -80,7 +83,7 @@ void DRFSorter::deactivate(const string& name)
     // because we lose information such as the number of allocations
     // for this client which means the fairness can be gamed by a
     // framework disconnecting and reconnecting.
-    clients.erase(it);
+    erase(it);
   }
 }
 
@@ -100,12 +103,12 @@ void DRFSorter::allocated(
     client.allocations++;
 
     // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+    erase(it);
+    insert(client);
   }
 
   allocations[name].resources[slaveId] += resources;
-  allocations[name].scalars += resources.scalars();
+  increase(&allocations[name].scalars, resources);
 
   // If the total resources have changed, we're going to
   // recalculate all the shares, so don't bother just
@@ -126,29 +129,38 @@ void DRFSorter::update(
 
   // TODO(bmahler): Check invariants between old and new allocations.
   // Namely, the roles and quantities of resources should be the same!
-  // Otherwise, we need to ensure we re-calculate the shares, as
-  // is being currently done, for safety.
 
   CHECK(total.resources[slaveId].contains(oldAllocation));
-  CHECK(total.scalars.contains(oldAllocation.scalars()));
 
   total.resources[slaveId] -= oldAllocation;
   total.resources[slaveId] += newAllocation;
 
-  total.scalars -= oldAllocation.scalars();
-  total.scalars += newAllocation.scalars();
-
   CHECK(allocations[name].resources[slaveId].contains(oldAllocation));
-  CHECK(allocations[name].scalars.contains(oldAllocation.scalars()));
 
   allocations[name].resources[slaveId] -= oldAllocation;
   allocations[name].resources[slaveId] += newAllocation;
 
-  allocations[name].scalars -= oldAllocation.scalars();
-  allocations[name].scalars += newAllocation.scalars();
+  // The shares only depend on the quantities of the scalars, which
+  // stay the same unless the invariants above are broken. Only in
+  // that case do we need to re-calculate the shares.
+  Quantities oldQuantities;
+  increase(&oldQuantities, oldAllocation);
 
-  // Just assume the total has changed, per the TODO above.
-  dirty = true;
+  Quantities newQuantities;
+  increase(&newQuantities, newAllocation);
+
+  oldQuantities.resize(symbols.size(), 0.0);
+  newQuantities.resize(symbols.size(), 0.0);
+
+  if (oldQuantities != newQuantities) {
+    decrease(&total.scalars, oldAllocation);
+    increase(&total.scalars, newAllocation);
+
+    decrease(&allocations[name].scalars, oldAllocation);
+    increase(&allocations[name].scalars, newAllocation);
+
+    dirty = true;
+  }
 }
 
 
@@ -198,7 +210,7 @@ void DRFSorter::unallocated(
     const Resources& resources)
 {
   allocations[name].resources[slaveId] -= resources;
-  allocations[name].scalars -= resources.scalars();
+  decrease(&allocations[name].scalars, resources);
 
   if (allocations[name].resources[slaveId].empty()) {
     allocations[name].resources.erase(slaveId);
@@ -214,7 +226,7 @@ void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
 {
   if (!resources.empty()) {
     total.resources[slaveId] += resources;
-    total.scalars += resources.scalars();
+    increase(&total.scalars, resources);
 
     // We have to recalculate all shares when the total resources
     // change, but we put it off until sort is called so that if
@@ -231,7 +243,7 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
     CHECK(total.resources.contains(slaveId));
 
     total.resources[slaveId] -= resources;
-    total.scalars -= resources.scalars();
+    decrease(&total.scalars, resources);
 
     if (total.resources[slaveId].empty()) {
       total.resources.erase(slaveId);
@@ -244,10 +256,8 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
 
 void DRFSorter::update(const SlaveID& slaveId, const Resources& resources)
 {
-  CHECK(total.scalars.contains(total.resources[slaveId].scalars()));
-
-  total.scalars -= total.resources[slaveId].scalars();
-  total.scalars += resources.scalars();
+  decrease(&total.scalars, total.resources[slaveId]);
+  increase(&total.scalars, resources);
 
   total.resources[slaveId] = resources;
 
@@ -261,30 +271,56 @@ void DRFSorter::update(const SlaveID& slaveId, const Resources& resources)
 
 list<string> DRFSorter::sort()
 {
-  if (dirty) {
-    set<Client, DRFComparator> temp;
+  const vector<string>& clients = sorted();
+
+  return list<string>(clients.begin(), clients.end());
+}
+
 
-    set<Client, DRFComparator>::iterator it;
-    for (it = clients.begin(); it != clients.end(); it++) {
-      Client client(*it);
+const vector<string>& DRFSorter::sorted()
+{
+  if (dirty) {
+    vector<Client> temp(clients.begin(), clients.end());
 
+    foreach (Client& client, temp) {
       // Update the 'share' to get proper sorting.
       client.share = calculateShare(client.name);
+    }
 
-      temp.insert(client);
+    // A change of the total resources (e.g., the allocator adding the
+    // resources it just allocated to the total of a framework sorter)
+    // does not often change the order of the clients, in which case
+    // they are still sorted and 'order' is left as it is.
+    DRFComparator comparator;
+    if (!std::is_sorted(temp.begin(), temp.end(), comparator)) {
+      std::sort(temp.begin(), temp.end(), comparator);
+      reordered = true;
     }
 
-    clients = temp;
+    // NOTE: The clients are inserted in order, so every insertion
+    // takes constant time, and the keys of 'positions' stay the same.
+    clients.clear();
+
+    foreach (const Client& client, temp) {
+      positions[client.name] = clients.insert(clients.end(), client);
+    }
+
+    dirty = false;
   }
 
-  list<string> result;
+  if (reordered) {
+    // NOTE: Assigning to the existing strings reuses their memory.
+    order.resize(clients.size());
+
+    size_t index = 0;
+    foreach (const Client& client, clients) {
+      order[index++] = client.name;
+    }
 
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    result.push_back((*it).name);
+    reordered = false;
   }
 
-  return result;
+  return order;
 }
 
 
@@ -311,8 +347,8 @@ void DRFSorter::update(const string& name)
     client.share = calculateShare(client.name);
 
     // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+    erase(it);
+    insert(client);
   }
 }
 
@@ -325,45 +361,90 @@ double DRFSorter::calculateShare(const string& name)
   // currently does not take into account resources that are not
   // scalars.
 
-  foreach (const string& scalar, total.scalars.names()) {
-    double _total = 0.0;
+  const Quantities& allocation = allocations[name].scalars;
 
-    // NOTE: Scalar resources may be spread across multiple
-    // 'Resource' objects. E.g. persistent volumes.
-    foreach (const Resource& resource, total.scalars.get(scalar)) {
-      CHECK_EQ(resource.type(), Value::SCALAR);
-      _total += resource.scalar().value();
+  for (size_t i = 0; i < allocation.size() && i < total.scalars.size(); i++) {
+    if (allocation[i] > 0.0 && total.scalars[i] > 0.0) {
+      share = std::max(share, allocation[i] / total.scalars[i]);
     }
+  }
+
+  return share / weights[name];
+}
+
 
-    if (_total > 0.0) {
-      double allocation = 0.0;
+size_t DRFSorter::symbol(const string& name)
+{
+  Option<size_t> symbol = symbols.get(name);
+
+  if (symbol.isNone()) {
+    symbol = symbols.size();
+    symbols[name] = symbol.get();
+  }
+
+  return symbol.get();
+}
+
+
+void DRFSorter::increase(Quantities* quantities, const Resources& resources)
+{
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      const size_t symbol = DRFSorter::symbol(resource.name());
 
-      // NOTE: Scalar resources may be spread across multiple
-      // 'Resource' objects. E.g. persistent volumes.
-      foreach (const Resource& resource,
-               allocations[name].scalars.get(scalar)) {
-        CHECK_EQ(resource.type(), Value::SCALAR);
-        allocation += resource.scalar().value();
+      if (symbol >= quantities->size()) {
+        quantities->resize(symbol + 1, 0.0);
       }
 
-      share = std::max(share, allocation / _total);
+      (*quantities)[symbol] += resource.scalar().value();
     }
   }
+}
 
-  return share / weights[name];
+
+void DRFSorter::decrease(Quantities* quantities, const Resources& resources)
+{
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      const size_t symbol = DRFSorter::symbol(resource.name());
+
+      if (symbol >= quantities->size()) {
+        quantities->resize(symbol + 1, 0.0);
+      }
+
+      double& quantity = (*quantities)[symbol];
+      quantity -= resource.scalar().value();
+
+      if (quantity <= 0.0) {
+        quantity = 0.0;
+      }
+    }
+  }
 }
 
 
 set<Client, DRFComparator>::iterator DRFSorter::find(const string& name)
 {
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    if (name == (*it).name) {
-      break;
-    }
+  if (!positions.contains(name)) {
+    return clients.end();
   }
 
-  return it;
+  return positions.at(name);
+}
+
+
+void DRFSorter::insert(const Client& client)
+{
+  positions[client.name] = clients.insert(client).first;
+  reordered = true;
+}
+
+
+void DRFSorter::erase(set<Client, DRFComparator>::iterator it)
+{
+  positions.erase(it->name);
+  clients.erase(it);
+  reordered = true;
 }
 
 } // namespace allocator {
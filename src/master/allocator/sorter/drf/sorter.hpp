@@ -19,6 +19,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/resources.hpp>
 
@@ -61,6 +62,8 @@ struct DRFComparator
 class DRFSorter : public Sorter
 {
 public:
+  DRFSorter() : dirty(false), reordered(false) {}
+
   virtual ~DRFSorter() {}
 
   virtual void add(const std::string& name, double weight = 1);
@@ -101,6 +104,8 @@ public:
 
   virtual std::list<std::string> sort();
 
+  virtual const std::vector<std::string>& sorted();
+
   virtual bool contains(const std::string& name);
 
   virtual int count();
@@ -117,23 +122,60 @@ private:
   // it exists in this Sorter.
   std::set<Client, DRFComparator>::iterator find(const std::string& name);
 
+  // Inserts the client into (or erases it from) 'clients', keeping
+  // 'positions' up to date.
+  void insert(const Client& client);
+  void erase(std::set<Client, DRFComparator>::iterator it);
+
   // If true, sort() will recalculate all shares.
   bool dirty;
 
+  // If true, 'order' no longer reflects 'clients'.
+  bool reordered;
+
   // A set of Clients (names and shares) sorted by share.
   std::set<Client, DRFComparator> clients;
 
+  // Maps the names of the (active) clients to their position in
+  // 'clients', so that clients can be found without a scan.
+  hashmap<std::string, std::set<Client, DRFComparator>::iterator> positions;
+
+  // The names of the clients in the order of 'clients', which is
+  // only rebuilt by 'sorted' once the clients were reordered.
+  std::vector<std::string> order;
+
   // Maps client names to the weights that should be applied to their shares.
   hashmap<std::string, double> weights;
 
+  // The quantities of scalar resources, indexed by the symbol of
+  // their name (e.g., "cpus"), see 'symbol' below.
+  //
+  // NOTE: Scalars can be safely aggregated across slaves. We keep
+  // their quantities to speed up the calculation of shares, which
+  // then only needs to visit the kinds of resources that a client
+  // was allocated. See MESOS-2891 for the reasons why we want to do
+  // that.
+  typedef std::vector<double> Quantities;
+
+  // Returns the symbol interned for a resource name, i.e., its index
+  // in the 'Quantities' of this sorter. There are only a handful of
+  // distinct resource names, so shares are calculated and quantities
+  // compared without hashing or comparing any names.
+  size_t symbol(const std::string& name);
+
+  // Adds the quantities of the scalar resources to 'quantities'.
+  void increase(Quantities* quantities, const Resources& resources);
+
+  // Subtracts the quantities of the scalar resources from
+  // 'quantities', dropping the resources that are used up.
+  void decrease(Quantities* quantities, const Resources& resources);
+
+  hashmap<std::string, size_t> symbols;
+
   // Total resources.
   struct Total {
     hashmap<SlaveID, Resources> resources;
-
-    // NOTE: Scalars can be safely aggregated across slaves. We keep
-    // that to speed up the calculation of shares. See MESOS-2891 for
-    // the reasons why we want to do that.
-    Resources scalars;
+    Quantities scalars;
   } total;
 
   // Allocation for a client.
@@ -141,7 +183,7 @@ private:
     hashmap<SlaveID, Resources> resources;
 
     // Similarly, we aggregated scalars across slaves. See note above.
-    Resources scalars;
+    Quantities scalars;
   };
 
   // Maps client names to the resources they have been allocated.
@@ -19,6 +19,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include <mesos/resources.hpp>
 #include <mesos/type_utils.hpp>
@@ -102,6 +103,12 @@ public:
   // should be allocated to, according to this Sorter's policy.
   virtual std::list<std::string> sort() = 0;
 
+  // Returns the same order as 'sort', but without copying the clients
+  // into a new list on every call. The result is only valid until the
+  // next call to 'sort' or 'sorted', and changes made to the sorter
+  // while iterating it do not affect it.
+  virtual const std::vector<std::string>& sorted() = 0;
+
   // Returns true if this Sorter contains the specified client,
   // either active or deactivated.
   virtual bool contains(const std::string& client) = 0;
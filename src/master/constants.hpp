@@ -136,6 +136,10 @@ extern const std::string DEFAULT_HTTP_AUTHENTICATOR;
 // Name of the default, "mesos" HTTP authentication realm.
 extern const std::string DEFAULT_HTTP_AUTHENTICATION_REALM;
 
+// The default interval between the exports of the state of the
+// master (see '--state_export_dir').
+extern const Duration DEFAULT_STATE_EXPORT_INTERVAL;
+
 } // namespace master {
 } // namespace internal {
 } // namespace mesos {
@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 
@@ -27,8 +29,11 @@
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 
 #include "common/protobuf_utils.hpp"
 
@@ -182,7 +187,9 @@ private:
       const Group::Membership& membership,
       const Future<Option<string> >& data);
 
-  Owned<Group> group;
+  // Either shared with the others watching the same group in this
+  // process (see 'Group::share') or owned by us.
+  std::shared_ptr<Group> group;
   LeaderDetector detector;
 
   // The leading Master.
@@ -309,20 +316,22 @@ Future<Option<MasterInfo> > StandaloneMasterDetector::detect(
 }
 
 
-// TODO(benh): Get ZooKeeper timeout from configuration.
 ZooKeeperMasterDetectorProcess::ZooKeeperMasterDetectorProcess(
     const zookeeper::URL& url)
-  : ZooKeeperMasterDetectorProcess(Owned<Group>(
-    new Group(url.servers,
-              MASTER_DETECTOR_ZK_SESSION_TIMEOUT,
-              url.path,
-              url.authentication))) {}
+  : ProcessBase(ID::generate("zookeeper-master-detector")),
+    // TODO(benh): Get ZooKeeper timeout from configuration.
+    group(Group::share(url, MASTER_DETECTOR_ZK_SESSION_TIMEOUT)),
+    detector(group.get()),
+    leader(None()) {}
 
 
+// NOTE: The shared pointer holds on to a copy of '_group' so that
+// the group stays alive for as long as either this detector or the
+// caller still needs it.
 ZooKeeperMasterDetectorProcess::ZooKeeperMasterDetectorProcess(
     Owned<Group> _group)
   : ProcessBase(ID::generate("zookeeper-master-detector")),
-    group(_group),
+    group(std::make_shared<Owned<Group> >(_group), _group.get()),
     detector(group.get()),
     leader(None()) {}
 
@@ -483,32 +492,91 @@ void ZooKeeperMasterDetectorProcess::fetched(
 }
 
 
-ZooKeeperMasterDetector::ZooKeeperMasterDetector(const zookeeper::URL& url)
+// Terminates and deletes a detector process once the last detector
+// using it is destroyed.
+static void destroy(ZooKeeperMasterDetectorProcess* process)
 {
-  process = new ZooKeeperMasterDetectorProcess(url);
-  spawn(process);
+  terminate(process);
+  process::wait(process);
+  delete process;
 }
 
 
-ZooKeeperMasterDetector::ZooKeeperMasterDetector(Owned<Group> group)
+// Spawns a detector process which is destroyed along with the last
+// reference to it.
+static std::shared_ptr<ZooKeeperMasterDetectorProcess> spawned(
+    ZooKeeperMasterDetectorProcess* process)
 {
-  process = new ZooKeeperMasterDetectorProcess(group);
   spawn(process);
+  return std::shared_ptr<ZooKeeperMasterDetectorProcess>(process, &destroy);
 }
 
 
+// Returns the detector process used by all the detectors in this
+// process that watch the leading master at 'url', creating it if
+// necessary. Since 'detect' only depends on the leader it has
+// detected (and on the 'previous' leader of each call), the
+// detectors (e.g., of the many drivers of a scheduler multiplexer)
+// can share it: a leader change is then detected, read and parsed
+// once, and delivered to all of them at once.
+static std::shared_ptr<ZooKeeperMasterDetectorProcess> share(
+    const zookeeper::URL& url)
+{
+  // NOTE: These are intentionally leaked, detectors can be destroyed
+  // during static destruction.
+  static std::mutex* mutex = new std::mutex();
+  static hashmap<string, std::weak_ptr<ZooKeeperMasterDetectorProcess>>*
+    processes =
+      new hashmap<string, std::weak_ptr<ZooKeeperMasterDetectorProcess>>();
+
+  const string key = stringify(url);
+
+  synchronized (mutex) {
+    std::shared_ptr<ZooKeeperMasterDetectorProcess> process;
+
+    if (processes->contains(key)) {
+      process = processes->at(key).lock();
+    }
+
+    if (!process) {
+      process = spawned(new ZooKeeperMasterDetectorProcess(url));
+      (*processes)[key] = process;
+    }
+
+    return process;
+  }
+}
+
+
+ZooKeeperMasterDetector::ZooKeeperMasterDetector(const zookeeper::URL& url)
+  : process(share(url)) {}
+
+
+ZooKeeperMasterDetector::ZooKeeperMasterDetector(Owned<Group> group)
+  : process(spawned(new ZooKeeperMasterDetectorProcess(group))) {}
+
+
 ZooKeeperMasterDetector::~ZooKeeperMasterDetector()
 {
-  terminate(process);
-  process::wait(process);
-  delete process;
+  foreach (Future<Option<MasterInfo>> future, detections) {
+    future.discard();
+  }
 }
 
 
 Future<Option<MasterInfo> > ZooKeeperMasterDetector::detect(
     const Option<MasterInfo>& previous)
 {
-  return dispatch(process, &ZooKeeperMasterDetectorProcess::detect, previous);
+  detections.remove_if([](const Future<Option<MasterInfo>>& future) {
+    return !future.isPending();
+  });
+
+  Future<Option<MasterInfo>> future = dispatch(
+      process.get(), &ZooKeeperMasterDetectorProcess::detect, previous);
+
+  detections.push_back(future);
+
+  return future;
 }
 
 } // namespace internal {
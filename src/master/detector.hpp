@@ -17,6 +17,8 @@
 #ifndef __MASTER_DETECTOR_HPP__
 #define __MASTER_DETECTOR_HPP__
 
+#include <list>
+#include <memory>
 #include <string>
 
 #include <process/future.hpp>
@@ -122,7 +124,13 @@ public:
       const Option<MasterInfo>& previous = None());
 
 private:
-  ZooKeeperMasterDetectorProcess* process;
+  // Shared with the other detectors of this process that watch the
+  // same ZooKeeper URL.
+  std::shared_ptr<ZooKeeperMasterDetectorProcess> process;
+
+  // The pending detections of this detector, which are discarded
+  // when it is destroyed (the process might outlive it).
+  std::list<process::Future<Option<MasterInfo>>> detections;
 };
 
 } // namespace internal {
@@ -101,6 +101,43 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(5));
 
+  add(&Flags::registry_batch_delay,
+      "registry_batch_delay",
+      "Duration of time the registrar waits for more operations before\n"
+      "storing the registry, when an operation arrives while no store is\n"
+      "in progress. The registrar keeps waiting in steps of this duration\n"
+      "as long as more operations arrive, up to 'registry_max_batch_delay'\n"
+      "in total, so bursts of operations (e.g., slaves re-registering\n"
+      "after a failover) are stored together. Zero means the registry is\n"
+      "stored right away.",
+      Seconds(0));
+
+  add(&Flags::registry_max_batch_delay,
+      "registry_max_batch_delay",
+      "Maximum duration of time the registrar waits for more operations\n"
+      "before storing the registry. See 'registry_batch_delay'.",
+      Milliseconds(100));
+
+  add(&Flags::registry_diffs_between_snapshots,
+      "registry_diffs_between_snapshots",
+      "Number of updates the replicated log based registry stores as\n"
+      "binary diffs against the previous version of the registry before\n"
+      "storing the whole registry again. Recovery applies these diffs\n"
+      "on top of the last whole registry. Storing diffs avoids writing\n"
+      "the whole registry (which can be several megabytes in large\n"
+      "clusters) for every update. Zero means the whole registry is\n"
+      "stored for every update.",
+      0);
+
+  add(&Flags::registry_standby_interval,
+      "registry_standby_interval",
+      "If set, a master which is not the leading master reads the updates\n"
+      "of the replicated log based registry at this interval (without\n"
+      "becoming a writer of the log), so that it keeps an up to date copy\n"
+      "of the registry in memory. Once elected, the master then only has\n"
+      "to read the updates since the last read to recover the registry,\n"
+      "rather than the whole log, which shortens the failovers.");
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -136,6 +173,39 @@ mesos::internal::master::Flags::Flags()
       "Values: [0%-100%]",
       stringify(RECOVERY_SLAVE_REMOVAL_PERCENT_LIMIT * 100.0) + "%");
 
+  add(&Flags::max_reregistering_slaves,
+      "max_reregistering_slaves",
+      "For failovers, the maximum number of slaves whose re-registration\n"
+      "(i.e., readmission into the registry) can be in progress at once.\n"
+      "The re-registration attempts beyond it are ignored, the slaves\n"
+      "retry them with their (randomized, exponential) registration\n"
+      "backoff. This keeps the master responsive when all the slaves\n"
+      "re-register at about the same time after a failover, while the\n"
+      "readmissions in progress are still stored in batches by the\n"
+      "registrar. By default there is no limit.",
+      [](const Option<size_t>& value) -> Option<Error> {
+        if (value.isSome() && value.get() < 1) {
+          return Error("Expected --max_reregistering_slaves to be at least 1");
+        }
+        return None();
+      });
+
+  add(&Flags::max_concurrent_authentications,
+      "max_concurrent_authentications",
+      "The maximum number of frameworks and slaves whose authentication\n"
+      "can be in progress at once. The authentication attempts beyond it\n"
+      "are ignored, the frameworks and slaves retry them once their\n"
+      "authentication times out. This keeps the master responsive when\n"
+      "all of them re-authenticate at about the same time after a\n"
+      "failover. By default there is no limit.",
+      [](const Option<size_t>& value) -> Option<Error> {
+        if (value.isSome() && value.get() < 1) {
+          return Error(
+              "Expected --max_concurrent_authentications to be at least 1");
+        }
+        return None();
+      });
+
   // TODO(vinod): Add a 'Rate' abstraction in stout and the
   // corresponding parser for flags.
   add(&Flags::slave_removal_rate_limit,
@@ -402,6 +472,15 @@ mesos::internal::master::Flags::Flags()
       "load an alternate allocator module using --modules.",
       DEFAULT_ALLOCATOR);
 
+  add(&Flags::allocator_record_file,
+      "allocator_record_file",
+      "File to record the calls made by the master to the allocator which\n"
+      "matter to the allocation (e.g., agents and frameworks being added,\n"
+      "resources being recovered or declined) and the offers made by the\n"
+      "allocator, so that the allocation can be replayed offline (e.g., by\n"
+      "the 'HierarchicalAllocator_BENCHMARK_Test.Replay' benchmark). The\n"
+      "file is truncated when the master starts.");
+
   add(&Flags::hooks,
       "hooks",
       "A comma-separated list of hook modules to be\n"
@@ -471,4 +550,35 @@ mesos::internal::master::Flags::Flags()
       "max_completed_tasks_per_framework",
       "Maximum number of completed tasks per framework to store in memory.",
       DEFAULT_MAX_COMPLETED_TASKS_PER_FRAMEWORK);
+
+  add(&Flags::max_completed_tasks_bytes_per_framework,
+      "max_completed_tasks_bytes_per_framework",
+      "Maximum amount of memory taken by the completed tasks of a framework\n"
+      "(e.g., 64MB). The oldest completed tasks are evicted beyond it,\n"
+      "like beyond --max_completed_tasks_per_framework.");
+
+  add(&Flags::completed_tasks_dir,
+      "completed_tasks_dir",
+      "Directory to keep the completed tasks which are evicted from memory\n"
+      "in (see --max_completed_tasks_per_framework and\n"
+      "--max_completed_tasks_bytes_per_framework, and the completed tasks\n"
+      "of the completed frameworks which are evicted), so that they can\n"
+      "still be looked up with '/tasks?framework_id=...&task_id=...'.\n"
+      "NOTE: The completed tasks accumulate in the directory since they\n"
+      "are never removed by the master.");
+
+  add(&Flags::state_export_dir,
+      "state_export_dir",
+      "Directory to periodically export the agents, the active tasks\n"
+      "and the allocations of the leading master to, as tab separated\n"
+      "tables (e.g., 'agents.tsv'), for offline analysis without scraping\n"
+      "'/state'. Every table is replaced atomically, 'snapshot.tsv' holds\n"
+      "the version of the format and the time of the last export.\n"
+      "See --state_export_interval.");
+
+  add(&Flags::state_export_interval,
+      "state_export_interval",
+      "Amount of time between the exports of the state of the master\n"
+      "to --state_export_dir (e.g., 30secs, 5mins, etc).",
+      DEFAULT_STATE_EXPORT_INTERVAL);
 }
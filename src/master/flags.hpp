@@ -19,6 +19,7 @@
 
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
@@ -52,9 +53,15 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  Duration registry_batch_delay;
+  Duration registry_max_batch_delay;
+  size_t registry_diffs_between_snapshots;
+  Option<Duration> registry_standby_interval;
   bool log_auto_initialize;
   Duration slave_reregister_timeout;
   std::string recovery_slave_removal_limit;
+  Option<size_t> max_reregistering_slaves;
+  Option<size_t> max_concurrent_authentications;
   Option<std::string> slave_removal_rate_limit;
   std::string webui_dir;
   Option<Path> whitelist;
@@ -75,6 +82,7 @@ public:
   Option<Modules> modules;
   std::string authenticators;
   std::string allocator;
+  Option<std::string> allocator_record_file;
   Option<std::string> hooks;
   Duration slave_ping_timeout;
   size_t max_slave_ping_timeouts;
@@ -82,6 +90,10 @@ public:
   std::string http_authenticators;
   size_t max_completed_frameworks;
   size_t max_completed_tasks_per_framework;
+  Option<Bytes> max_completed_tasks_bytes_per_framework;
+  Option<std::string> completed_tasks_dir;
+  Option<std::string> state_export_dir;
+  Duration state_export_interval;
 
 #ifdef WITH_NETWORK_ISOLATOR
   Option<size_t> max_executors_per_slave;
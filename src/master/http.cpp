@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <deque>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
@@ -54,6 +56,7 @@
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/utils.hpp>
+#include <stout/uuid.hpp>
 
 #include "common/build.hpp"
 #include "common/http.hpp"
@@ -66,6 +69,7 @@
 #include "master/machine.hpp"
 #include "master/maintenance.hpp"
 #include "master/master.hpp"
+#include "master/task_history.hpp"
 #include "master/validation.hpp"
 
 #include "mesos/mesos.hpp"
@@ -77,6 +81,7 @@ using process::Clock;
 using process::DESCRIPTION;
 using process::Future;
 using process::HELP;
+using process::PID;
 using process::TLDR;
 
 using process::http::Accepted;
@@ -123,9 +128,6 @@ void json(JSON::ObjectWriter* writer, const Offer& offer)
 namespace internal {
 namespace master {
 
-// Pull in model overrides from common.
-using mesos::internal::model;
-
 // Pull in definitions from process.
 using process::http::Response;
 using process::http::Request;
@@ -271,8 +273,9 @@ void json(JSON::ObjectWriter* writer, const Full<Framework>& full)
   });
 
   writer->field("completed_tasks", [&framework](JSON::ArrayWriter* writer) {
-    foreach (const std::shared_ptr<Task>& task, framework.completedTasks) {
-      writer->element(*task);
+    foreach (const std::shared_ptr<const CompletedTask>& task,
+             framework.completedTasks) {
+      writer->element(task->task());
     }
   });
 
@@ -303,198 +306,6 @@ void json(JSON::ObjectWriter* writer, const Full<Framework>& full)
 }
 
 
-// TODO(bmahler): Kill these in favor of automatic Proto->JSON Conversion (when
-// it becomes available).
-
-
-// Returns a JSON object modeled on an Offer.
-JSON::Object model(const Offer& offer)
-{
-  JSON::Object object;
-  object.values["id"] = offer.id().value();
-  object.values["framework_id"] = offer.framework_id().value();
-  object.values["slave_id"] = offer.slave_id().value();
-  object.values["resources"] = model(offer.resources());
-  return object;
-}
-
-
-// Returns a JSON object summarizing some important fields in a
-// Framework.
-JSON::Object summarize(const Framework& framework)
-{
-  JSON::Object object;
-  object.values["id"] = framework.id().value();
-  object.values["name"] = framework.info.name();
-
-  // Omit pid for http frameworks.
-  if (framework.pid.isSome()) {
-    object.values["pid"] = string(framework.pid.get());
-  }
-
-  // TODO(bmahler): Use these in the webui.
-  object.values["used_resources"] = model(framework.totalUsedResources);
-  object.values["offered_resources"] = model(framework.totalOfferedResources);
-
-  {
-      JSON::Array array;
-      array.values.reserve(framework.info.capabilities_size());
-      foreach (const FrameworkInfo::Capability& capability,
-               framework.info.capabilities()) {
-        array.values.push_back(
-              FrameworkInfo::Capability::Type_Name(capability.type()));
-      }
-      object.values["capabilities"] = std::move(array);
-  }
-
-  object.values["hostname"] = framework.info.hostname();
-  object.values["webui_url"] = framework.info.webui_url();
-
-  object.values["active"] = framework.active;
-
-  return object;
-}
-
-
-// Returns a JSON object modeled on a Framework.
-JSON::Object model(const Framework& framework)
-{
-  JSON::Object object = summarize(framework);
-
-  // Add additional fields to those generated by 'summarize'.
-  object.values["user"] = framework.info.user();
-  object.values["failover_timeout"] = framework.info.failover_timeout();
-  object.values["checkpoint"] = framework.info.checkpoint();
-  object.values["role"] = framework.info.role();
-  object.values["registered_time"] = framework.registeredTime.secs();
-  object.values["unregistered_time"] = framework.unregisteredTime.secs();
-  object.values["active"] = framework.active;
-
-  if (framework.info.has_principal()) {
-    object.values["principal"] = framework.info.principal();
-  }
-
-  // TODO(bmahler): Consider deprecating this in favor of the split
-  // used and offered resources added in 'summarize'.
-  object.values["resources"] =
-    model(framework.totalUsedResources + framework.totalOfferedResources);
-
-  // TODO(benh): Consider making reregisteredTime an Option.
-  if (framework.registeredTime != framework.reregisteredTime) {
-    object.values["reregistered_time"] = framework.reregisteredTime.secs();
-  }
-
-  // Model all of the tasks associated with a framework.
-  {
-    JSON::Array array;
-    array.values.reserve(
-        framework.pendingTasks.size() + framework.tasks.size()); // MESOS-2353.
-
-    foreachvalue (const TaskInfo& task, framework.pendingTasks) {
-      vector<TaskStatus> statuses;
-      array.values.push_back(
-          model(task, framework.id(), TASK_STAGING, statuses));
-    }
-
-    foreachvalue (Task* task, framework.tasks) {
-      array.values.push_back(model(*task));
-    }
-
-    object.values["tasks"] = std::move(array);
-  }
-
-  // Model all of the completed tasks of a framework.
-  {
-    JSON::Array array;
-    array.values.reserve(framework.completedTasks.size()); // MESOS-2353.
-
-    foreach (const std::shared_ptr<Task>& task, framework.completedTasks) {
-      array.values.push_back(model(*task));
-    }
-
-    object.values["completed_tasks"] = std::move(array);
-  }
-
-  // Model all of the offers associated with a framework.
-  {
-    JSON::Array array;
-    array.values.reserve(framework.offers.size()); // MESOS-2353.
-
-    foreach (Offer* offer, framework.offers) {
-      array.values.push_back(model(*offer));
-    }
-
-    object.values["offers"] = std::move(array);
-  }
-
-  // Model all of the executors of a framework.
-  {
-    JSON::Array executors;
-    int executorSize = 0;
-    foreachvalue (const auto& executorsMap,
-                  framework.executors) {
-      executorSize += executorsMap.size();
-    }
-    executors.values.reserve(executorSize); // MESOS-2353
-    foreachpair (const SlaveID& slaveId,
-                 const auto& executorsMap,
-                 framework.executors) {
-      foreachvalue (const ExecutorInfo& executor, executorsMap) {
-        JSON::Object executorJson = model(executor);
-        executorJson.values["slave_id"] = slaveId.value();
-        executors.values.push_back(executorJson);
-      }
-    }
-
-    object.values["executors"] = std::move(executors);
-  }
-
-  // Model all of the labels associated with a framework.
-  if (framework.info.has_labels()) {
-    object.values["labels"] = model(framework.info.labels());
-  }
-
-  return object;
-}
-
-
-// Returns a JSON object summarizing some important fields in a Slave.
-JSON::Object summarize(const Slave& slave)
-{
-  JSON::Object object;
-  object.values["id"] = slave.id.value();
-  object.values["pid"] = string(slave.pid);
-  object.values["hostname"] = slave.info.hostname();
-  object.values["registered_time"] = slave.registeredTime.secs();
-
-  if (slave.reregisteredTime.isSome()) {
-    object.values["reregistered_time"] = slave.reregisteredTime.get().secs();
-  }
-
-  const Resources& totalResources = slave.totalResources;
-  object.values["resources"] = model(totalResources);
-  object.values["used_resources"] = model(Resources::sum(slave.usedResources));
-  object.values["offered_resources"] = model(slave.offeredResources);
-  object.values["reserved_resources"] = model(totalResources.reserved());
-  object.values["unreserved_resources"] = model(totalResources.unreserved());
-
-  object.values["attributes"] = model(slave.info.attributes());
-  object.values["active"] = slave.active;
-  object.values["version"] = slave.version;
-
-  return object;
-}
-
-
-// Returns a JSON object modeled after a Slave.
-// For now there are no additional fields being added to those
-// generated by 'summarize'.
-JSON::Object model(const Slave& slave)
-{
-  return summarize(slave);
-}
-
-
 void Master::Http::log(const Request& request)
 {
   Option<string> userAgent = request.headers.get("User-Agent");
@@ -684,6 +495,10 @@ Future<Response> Master::Http::scheduler(const Request& request) const
       master->request(framework, call.request());
       return Accepted();
 
+    case scheduler::Call::BATCH:
+      master->batch(framework, call.batch());
+      return Accepted();
+
     default:
       // Should be caught during call validation above.
       LOG(FATAL) << "Unexpected " << call.type() << " call";
@@ -891,54 +706,180 @@ string Master::Http::FRAMEWORKS()
 }
 
 
+Response ReadOnlyHandler::frameworks(
+    const std::shared_ptr<const Snapshot>& snapshot,
+    const Request& request)
+{
+  auto frameworks = [snapshot](JSON::ObjectWriter* writer) {
+    // Model all of the frameworks.
+    writer->field("frameworks", [&snapshot](JSON::ArrayWriter* writer) {
+      foreachvalue (const std::shared_ptr<const Framework>& framework,
+                    snapshot->frameworks) {
+        writer->element(Full<Framework>(*framework));
+      }
+    });
+
+    // Model all of the completed frameworks.
+    writer->field(
+        "completed_frameworks",
+        [&snapshot](JSON::ArrayWriter* writer) {
+          foreach (const std::shared_ptr<const Framework>& framework,
+                   snapshot->completed) {
+            writer->element(Full<Framework>(*framework));
+          }
+        });
+
+    // Model all currently unregistered frameworks.
+    // This could happen when the framework has yet to re-register
+    // after master failover.
+    writer->field(
+        "unregistered_frameworks",
+        [&snapshot](JSON::ArrayWriter* writer) {
+          foreachvalue (const std::shared_ptr<const Slave>& slave,
+                        snapshot->slaves) {
+            foreachkey (const FrameworkID& frameworkId, slave->tasks) {
+              if (!snapshot->frameworks.contains(frameworkId)) {
+                writer->element(frameworkId.value());
+              }
+            }
+          }
+        });
+  };
+
+  return stream(
+      self(),
+      [frameworks](std::ostream* stream) { *stream << jsonify(frameworks); },
+      request.url.query.get("jsonp"));
+}
+
+
 Future<Response> Master::Http::frameworks(const Request& request) const
 {
-  JSON::Object object;
+  return dispatch(
+      master->readOnlyHandler,
+      &ReadOnlyHandler::frameworks,
+      master->snapshot(),
+      request);
+}
 
-  // Model all of the frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.registered.size()); // MESOS-2353.
 
-    foreachvalue (Framework* framework, master->frameworks.registered) {
-      array.values.push_back(model(*framework));
-    }
+string Master::Http::EVENTS_HELP()
+{
+  return HELP(
+    TLDR(
+        "Streams the changes to the state of the master."),
+    DESCRIPTION(
+        "Responds with a stream of 'recordio' encoded JSON events. The",
+        "first event ('SNAPSHOT') holds the state of the slaves and",
+        "frameworks, followed by an event whenever a task is added",
+        "('TASK_ADDED') or updated ('TASK_UPDATED'), a slave is added",
+        "('SLAVE_ADDED') or removed ('SLAVE_REMOVED') and a framework",
+        "is added ('FRAMEWORK_ADDED') or removed ('FRAMEWORK_REMOVED')."));
+}
 
-    object.values["frameworks"] = std::move(array);
-  }
 
-  // Model all of the completed frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.completed.size()); // MESOS-2353.
+// Returns an event of the given 'type' holding 'value' as the field
+// 'key', e.g., '{"type":"TASK_ADDED","task":{...}}'.
+template <typename T>
+static string event(const string& type, const string& key, const T& value)
+{
+  return jsonify([&](JSON::ObjectWriter* writer) {
+    writer->field("type", type);
+    writer->field(key, value);
+  });
+}
 
-    foreach (const std::shared_ptr<Framework>& framework,
-             master->frameworks.completed) {
-      array.values.push_back(model(*framework));
-    }
 
-    object.values["completed_frameworks"] = std::move(array);
+Future<Response> Master::Http::events(const Request& request) const
+{
+  if (request.method != "GET") {
+    return MethodNotAllowed(
+        {"GET"}, "Expecting 'GET', received '" + request.method + "'");
   }
 
-  // Model all currently unregistered frameworks.
-  // This could happen when the framework has yet to re-register
-  // after master failover.
-  {
-    JSON::Array array;
+  auto state = [this](JSON::ObjectWriter* writer) {
+    writer->field("slaves", [this](JSON::ArrayWriter* writer) {
+      foreachvalue (const Slave* slave, master->slaves.registered) {
+        writer->element(Full<Slave>(*slave));
+      }
+    });
 
-    // Find unregistered frameworks.
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-        if (!master->frameworks.registered.contains(frameworkId)) {
-          array.values.push_back(frameworkId.value());
-        }
+    writer->field("frameworks", [this](JSON::ArrayWriter* writer) {
+      foreachvalue (const Framework* framework, master->frameworks.registered) {
+        writer->element(Full<Framework>(*framework));
       }
-    }
+    });
+  };
+
+  Pipe pipe;
+  OK ok;
+  ok.headers["Content-Type"] = APPLICATION_JSON;
+
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+
+  // The snapshot is written before the subscriber is added (both on
+  // the master), so no change is missed or sent twice.
+  StateSubscriber subscriber(pipe.writer());
+  subscriber.send(event("SNAPSHOT", "state", state));
+
+  const UUID id = UUID::random();
+  master->subscribers.put(id, subscriber);
+
+  pipe.writer().readerClosed()
+    .onAny(defer(master->self(), &Master::unsubscribe, id));
+
+  return ok;
+}
+
+
+void Master::Http::taskAdded(const Task& task) const
+{
+  if (!master->subscribers.empty()) {
+    master->publish(event("TASK_ADDED", "task", task));
+  }
+}
+
+
+void Master::Http::taskUpdated(const Task& task) const
+{
+  if (!master->subscribers.empty()) {
+    master->publish(event("TASK_UPDATED", "task", task));
+  }
+}
+
+
+void Master::Http::slaveAdded(const Slave& slave) const
+{
+  if (!master->subscribers.empty()) {
+    master->publish(event("SLAVE_ADDED", "slave", Summary<Slave>(slave)));
+  }
+}
 
-    object.values["unregistered_frameworks"] = std::move(array);
+
+void Master::Http::slaveRemoved(const Slave& slave) const
+{
+  if (!master->subscribers.empty()) {
+    master->publish(event("SLAVE_REMOVED", "slave", Summary<Slave>(slave)));
+  }
+}
+
+
+void Master::Http::frameworkAdded(const Framework& framework) const
+{
+  if (!master->subscribers.empty()) {
+    master->publish(
+        event("FRAMEWORK_ADDED", "framework", Summary<Framework>(framework)));
   }
+}
+
 
-  return OK(object, request.url.query.get("jsonp"));
+void Master::Http::frameworkRemoved(const Framework& framework) const
+{
+  if (!master->subscribers.empty()) {
+    master->publish(
+        event("FRAMEWORK_REMOVED", "framework", Summary<Framework>(framework)));
+  }
 }
 
 
@@ -950,20 +891,18 @@ string Master::Http::FLAGS_HELP()
 
 Future<Response> Master::Http::flags(const Request& request) const
 {
-  JSON::Object object;
-
-  {
-    JSON::Object flags;
-    foreachpair (const string& name, const flags::Flag& flag, master->flags) {
-      Option<string> value = flag.stringify(master->flags);
-      if (value.isSome()) {
-        flags.values[name] = value.get();
+  auto object = [this](JSON::ObjectWriter* writer) {
+    writer->field("flags", [this](JSON::ObjectWriter* writer) {
+      foreachpair (const string& name, const flags::Flag& flag, master->flags) {
+        Option<string> value = flag.stringify(master->flags);
+        if (value.isSome()) {
+          writer->field(name, value.get());
+        }
       }
-    }
-    object.values["flags"] = std::move(flags);
-  }
+    });
+  };
 
-  return OK(object, request.url.query.get("jsonp"));
+  return OK(jsonify(object), request.url.query.get("jsonp"));
 }
 
 
@@ -1229,22 +1168,33 @@ string Master::Http::SLAVES_HELP()
 }
 
 
-Future<Response> Master::Http::slaves(const Request& request) const
+Response ReadOnlyHandler::slaves(
+    const std::shared_ptr<const Snapshot>& snapshot,
+    const Request& request)
 {
-  JSON::Object object;
-
-  {
-    JSON::Array array;
-    array.values.reserve(master->slaves.registered.size()); // MESOS-2353.
+  auto slaves = [snapshot](JSON::ObjectWriter* writer) {
+    writer->field("slaves", [&snapshot](JSON::ArrayWriter* writer) {
+      foreachvalue (const std::shared_ptr<const Slave>& slave,
+                    snapshot->slaves) {
+        writer->element(Full<Slave>(*slave));
+      }
+    });
+  };
 
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      array.values.push_back(model(*slave));
-    }
+  return stream(
+      self(),
+      [slaves](std::ostream* stream) { *stream << jsonify(slaves); },
+      request.url.query.get("jsonp"));
+}
 
-    object.values["slaves"] = std::move(array);
-  }
 
-  return OK(object, request.url.query.get("jsonp"));
+Future<Response> Master::Http::slaves(const Request& request) const
+{
+  return dispatch(
+      master->readOnlyHandler,
+      &ReadOnlyHandler::slaves,
+      master->snapshot(),
+      request);
 }
 
 
@@ -1292,121 +1242,375 @@ string Master::Http::STATE_HELP()
         "Information about state of master."),
     DESCRIPTION(
         "This endpoint shows information about the frameworks, tasks,",
-        "executors and slaves running in the cluster as a JSON object."));
+        "executors and slaves running in the cluster as a JSON object.",
+        "",
+        "The response carries an 'ETag' header. Requests that pass it",
+        "back in an 'If-None-Match' header get a '304 Not Modified'",
+        "response (without a body) as long as the state is unchanged.",
+        "",
+        "Query parameters:",
+        "",
+        ">        slave_id=VALUE       Only includes the given slave.",
+        ">        framework_id=VALUE   Only includes the given framework.",
+        ">        role=VALUE           Only includes the frameworks of the "
+        "given role.",
+        ">        fields=VALUE,...     Only includes the given (top level) "
+        "fields."));
 }
 
 
-Future<Response> Master::Http::state(const Request& request) const
+// Returns the keys of the 'fields' query parameter of the request
+// (e.g., 'fields=id,state'), or none if all fields are requested.
+static Option<hashset<string>> projection(const Request& request)
 {
-  auto state = [this](JSON::ObjectWriter* writer) {
-    writer->field("version", MESOS_VERSION);
+  Option<string> fields = request.url.query.get("fields");
+  if (fields.isNone()) {
+    return None();
+  }
+
+  hashset<string> keys;
+  foreach (const string& key, strings::tokenize(fields.get(), ",")) {
+    keys.insert(strings::trim(key));
+  }
+
+  return keys;
+}
+
+
+// Writes the field unless it is not part of the projection.
+template <typename T>
+static void project(
+    JSON::ObjectWriter* writer,
+    const Option<hashset<string>>& fields,
+    const string& key,
+    const T& value)
+{
+  if (fields.isNone() || fields.get().contains(key)) {
+    writer->field(key, value);
+  }
+}
+
+
+// Writes the fields of the task which are part of the projection, like
+// 'json(JSON::ObjectWriter*, const Task&)' does when there is none.
+static void project(
+    JSON::ObjectWriter* writer,
+    const Option<hashset<string>>& fields,
+    const Task& task)
+{
+  project(writer, fields, "id", task.task_id().value());
+  project(writer, fields, "name", task.name());
+  project(writer, fields, "framework_id", task.framework_id().value());
+  project(writer, fields, "executor_id", task.executor_id().value());
+  project(writer, fields, "slave_id", task.slave_id().value());
+  project(writer, fields, "state", TaskState_Name(task.state()));
+  project(writer, fields, "resources", Resources(task.resources()));
+  project(writer, fields, "statuses", task.statuses());
+
+  if (task.has_labels()) {
+    project(writer, fields, "labels", task.labels());
+  }
+
+  if (task.has_discovery()) {
+    project(writer, fields, "discovery", task.discovery());
+  }
+
+  if (task.has_container()) {
+    project(writer, fields, "container", task.container());
+  }
+}
+
+
+template <typename Key, typename T>
+const string& ReadOnlyHandler::fragment(
+    const Key& key,
+    const T& object,
+    hashmap<Key, Fragment<T>>* fragments)
+{
+  Fragment<T>& fragment = (*fragments)[key];
+
+  if (fragment.object != &object || fragment.revision != object.revision) {
+    fragment.object = &object;
+    fragment.revision = object.revision;
+    fragment.json = jsonify(Full<T>(object));
+  }
+
+  return fragment.json;
+}
+
+
+Response ReadOnlyHandler::state(
+    const std::shared_ptr<const Snapshot>& snapshot,
+    const Request& request)
+{
+  const Option<hashset<string>> fields = projection(request);
+
+  auto included = [&fields](const string& key) {
+    return fields.isNone() || fields.get().contains(key);
+  };
+
+  // The slaves and frameworks (and orphan tasks) can be filtered by
+  // the 'slave_id', 'framework_id' and 'role' query parameters.
+  const Option<string> slaveId = request.url.query.get("slave_id");
+  const Option<string> frameworkId = request.url.query.get("framework_id");
+  const Option<string> role = request.url.query.get("role");
+
+  auto selected = [&](const Framework& framework) {
+    return (frameworkId.isNone() ||
+            framework.id().value() == frameworkId.get()) &&
+           (role.isNone() || framework.info.role() == role.get());
+  };
+
+  double activated = 0.0;
+  double deactivated = 0.0;
+  foreachvalue (const std::shared_ptr<const Slave>& slave, snapshot->slaves) {
+    if (slave->active) {
+      activated++;
+    } else {
+      deactivated++;
+    }
+  }
+
+  auto state = [&](JSON::ObjectWriter* writer) {
+    project(writer, fields, "version", MESOS_VERSION);
 
     if (build::GIT_SHA.isSome()) {
-      writer->field("git_sha", build::GIT_SHA.get());
+      project(writer, fields, "git_sha", build::GIT_SHA.get());
     }
 
     if (build::GIT_BRANCH.isSome()) {
-      writer->field("git_branch", build::GIT_BRANCH.get());
+      project(writer, fields, "git_branch", build::GIT_BRANCH.get());
     }
 
     if (build::GIT_TAG.isSome()) {
-      writer->field("git_tag", build::GIT_TAG.get());
+      project(writer, fields, "git_tag", build::GIT_TAG.get());
     }
 
-    writer->field("build_date", build::DATE);
-    writer->field("build_time", build::TIME);
-    writer->field("build_user", build::USER);
-    writer->field("start_time", master->startTime.secs());
+    project(writer, fields, "build_date", build::DATE);
+    project(writer, fields, "build_time", build::TIME);
+    project(writer, fields, "build_user", build::USER);
+    project(writer, fields, "start_time", snapshot->startTime.secs());
 
-    if (master->electedTime.isSome()) {
-      writer->field("elected_time", master->electedTime.get().secs());
+    if (snapshot->electedTime.isSome()) {
+      project(
+          writer, fields, "elected_time", snapshot->electedTime.get().secs());
     }
 
-    writer->field("id", master->info().id());
-    writer->field("pid", string(master->self()));
-    writer->field("hostname", master->info().hostname());
-    writer->field("activated_slaves", master->_slaves_active());
-    writer->field("deactivated_slaves", master->_slaves_inactive());
+    project(writer, fields, "id", snapshot->info.id());
+    project(writer, fields, "pid", string(snapshot->pid));
+    project(writer, fields, "hostname", snapshot->info.hostname());
+    project(writer, fields, "activated_slaves", activated);
+    project(writer, fields, "deactivated_slaves", deactivated);
 
-    if (master->flags.cluster.isSome()) {
-      writer->field("cluster", master->flags.cluster.get());
+    if (flags.cluster.isSome()) {
+      project(writer, fields, "cluster", flags.cluster.get());
     }
 
-    if (master->leader.isSome()) {
-      writer->field("leader", master->leader.get().pid());
+    if (snapshot->leader.isSome()) {
+      project(writer, fields, "leader", snapshot->leader.get().pid());
     }
 
-    if (master->flags.log_dir.isSome()) {
-      writer->field("log_dir", master->flags.log_dir.get());
+    if (flags.log_dir.isSome()) {
+      project(writer, fields, "log_dir", flags.log_dir.get());
     }
 
-    if (master->flags.external_log_file.isSome()) {
-      writer->field("external_log_file", master->flags.external_log_file.get());
+    if (flags.external_log_file.isSome()) {
+      project(
+          writer, fields, "external_log_file", flags.external_log_file.get());
     }
 
-    writer->field("flags", [this](JSON::ObjectWriter* writer) {
-      foreachpair (const string& name, const flags::Flag& flag, master->flags) {
-        Option<string> value = flag.stringify(master->flags);
+    project(writer, fields, "flags", [this](JSON::ObjectWriter* writer) {
+      foreachpair (const string& name, const flags::Flag& flag, flags) {
+        Option<string> value = flag.stringify(flags);
         if (value.isSome()) {
           writer->field(name, value.get());
         }
       }
     });
+  };
 
-    // Model all of the slaves.
-    writer->field("slaves", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (Slave* slave, master->slaves.registered) {
-        writer->element(Full<Slave>(*slave));
+  // Model all of the orphan tasks.
+  auto orphans = [&](JSON::ArrayWriter* writer) {
+    // Find those orphan tasks.
+    foreachvalue (const std::shared_ptr<const Slave>& slave, snapshot->slaves) {
+      if (slaveId.isSome() && slave->id.value() != slaveId.get()) {
+        continue;
       }
-    });
 
-    // Model all of the frameworks.
-    writer->field("frameworks", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (Framework* framework, master->frameworks.registered) {
-        writer->element(Full<Framework>(*framework));
+      typedef hashmap<TaskID, Task*> TaskMap;
+      foreachpair (const FrameworkID& id, const TaskMap& tasks, slave->tasks) {
+        if (snapshot->frameworks.contains(id) ||
+            (frameworkId.isSome() && id.value() != frameworkId.get())) {
+          continue;
+        }
+
+        foreachvalue (const Task* task, tasks) {
+          CHECK_NOTNULL(task);
+          writer->element(*task);
+        }
       }
-    });
+    }
+  };
 
-    // Model all of the completed frameworks.
-    writer->field("completed_frameworks", [this](JSON::ArrayWriter* writer) {
-      foreach (const std::shared_ptr<Framework>& framework,
-               master->frameworks.completed) {
-        writer->element(Full<Framework>(*framework));
+  // Model all currently unregistered frameworks.
+  // This could happen when the framework has yet to re-register
+  // after master failover.
+  auto unregistered = [&](JSON::ArrayWriter* writer) {
+    // Find unregistered frameworks.
+    foreachvalue (const std::shared_ptr<const Slave>& slave, snapshot->slaves) {
+      if (slaveId.isSome() && slave->id.value() != slaveId.get()) {
+        continue;
       }
-    });
 
-    // Model all of the orphan tasks.
-    writer->field("orphan_tasks", [this](JSON::ArrayWriter* writer) {
-      // Find those orphan tasks.
-      foreachvalue (const Slave* slave, master->slaves.registered) {
-        typedef hashmap<TaskID, Task*> TaskMap;
-        foreachvalue (const TaskMap& tasks, slave->tasks) {
-          foreachvalue (const Task* task, tasks) {
-            CHECK_NOTNULL(task);
-            if (!master->frameworks.registered.contains(task->framework_id())) {
-              writer->element(*task);
-            }
-          }
+      foreachkey (const FrameworkID& id, slave->tasks) {
+        if (!snapshot->frameworks.contains(id) &&
+            (frameworkId.isNone() || id.value() == frameworkId.get())) {
+          writer->element(id.value());
         }
       }
-    });
+    }
+  };
 
-    // Model all currently unregistered frameworks.
-    // This could happen when the framework has yet to re-register
-    // after master failover.
-    writer->field("unregistered_frameworks", [this](JSON::ArrayWriter* writer) {
-      // Find unregistered frameworks.
-      foreachvalue (const Slave* slave, master->slaves.registered) {
-        foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-          if (!master->frameworks.registered.contains(frameworkId)) {
-            writer->element(frameworkId.value());
-          }
-        }
+  // The slaves and frameworks make up most of the state, so rather
+  // than rendering them on every request we splice in the JSON that
+  // is cached for each of them (see 'fragment'). The remaining
+  // fields are cheap to render, so the object written by 'state' is
+  // reopened to append the slaves and frameworks.
+  string json = jsonify(state);
+  CHECK(!json.empty() && json.back() == '}');
+  json.pop_back();
+
+  // Appends the field 'key' with an array of (JSON) 'elements'.
+  auto append = [&json](
+      const string& key,
+      const vector<const string*>& elements) {
+    if (json.size() > 1) {
+      json += ',';
+    }
+
+    json += "\"" + key + "\":[";
+    for (size_t i = 0; i < elements.size(); i++) {
+      if (i > 0) {
+        json += ',';
       }
-    });
+      json += *elements[i];
+    }
+    json += ']';
   };
 
-  return OK(jsonify(state), request.url.query.get("jsonp"));
+  // Model all of the slaves.
+  if (included("slaves")) {
+    vector<const string*> slaves;
+
+    if (slaveId.isSome()) {
+      SlaveID id;
+      id.set_value(slaveId.get());
+
+      if (snapshot->slaves.contains(id)) {
+        const Slave& slave = *snapshot->slaves.at(id);
+        slaves.push_back(&fragment(slave.id, slave, &slaveFragments));
+      }
+    } else {
+      foreachvalue (const std::shared_ptr<const Slave>& slave,
+                    snapshot->slaves) {
+        slaves.push_back(&fragment(slave->id, *slave, &slaveFragments));
+      }
+    }
+
+    append("slaves", slaves);
+  }
+
+  // Model all of the frameworks.
+  if (included("frameworks")) {
+    vector<const string*> frameworks;
+
+    if (frameworkId.isSome()) {
+      FrameworkID id;
+      id.set_value(frameworkId.get());
+
+      if (snapshot->frameworks.contains(id)) {
+        const Framework& framework = *snapshot->frameworks.at(id);
+        if (selected(framework)) {
+          frameworks.push_back(
+              &fragment(id, framework, &frameworkFragments));
+        }
+      }
+    } else {
+      foreachvalue (const std::shared_ptr<const Framework>& framework,
+                    snapshot->frameworks) {
+        if (selected(*framework)) {
+          frameworks.push_back(
+              &fragment(framework->id(), *framework, &frameworkFragments));
+        }
+      }
+    }
+
+    append("frameworks", frameworks);
+  }
+
+  // Model all of the completed frameworks.
+  if (included("completed_frameworks")) {
+    vector<const string*> completed;
+
+    foreach (const std::shared_ptr<const Framework>& framework,
+             snapshot->completed) {
+      if (selected(*framework)) {
+        completed.push_back(
+            &fragment(framework->id(), *framework, &completedFragments));
+      }
+    }
+
+    append("completed_frameworks", completed);
+  }
+
+  if (included("orphan_tasks")) {
+    json += string(json.size() > 1 ? "," : "") + "\"orphan_tasks\":" +
+            string(jsonify(orphans));
+  }
+
+  if (included("unregistered_frameworks")) {
+    json += string(json.size() > 1 ? "," : "") +
+            "\"unregistered_frameworks\":" + string(jsonify(unregistered));
+  }
+
+  json += '}';
+
+  // Drop the fragments of the slaves and frameworks that are gone.
+  foreach (const SlaveID& id, slaveFragments.keys()) {
+    if (!snapshot->slaves.contains(id)) {
+      slaveFragments.erase(id);
+    }
+  }
+
+  foreach (const FrameworkID& id, frameworkFragments.keys()) {
+    if (!snapshot->frameworks.contains(id)) {
+      frameworkFragments.erase(id);
+    }
+  }
+
+  hashset<FrameworkID> completed;
+  foreach (const std::shared_ptr<const Framework>& framework,
+           snapshot->completed) {
+    completed.insert(framework->id());
+  }
+
+  foreach (const FrameworkID& id, completedFragments.keys()) {
+    if (!completed.contains(id)) {
+      completedFragments.erase(id);
+    }
+  }
+
+  return tagged(request, json, request.url.query.get("jsonp"));
+}
+
+
+Future<Response> Master::Http::state(const Request& request) const
+{
+  return dispatch(
+      master->readOnlyHandler,
+      &ReadOnlyHandler::state,
+      master->snapshot(),
+      request);
 }
 
 
@@ -1417,10 +1621,11 @@ Future<Response> Master::Http::state(const Request& request) const
 class SlaveFrameworkMapping
 {
 public:
-  SlaveFrameworkMapping(const hashmap<FrameworkID, Framework*>& frameworks)
+  SlaveFrameworkMapping(
+      const hashmap<FrameworkID, std::shared_ptr<const Framework>>& frameworks)
   {
     foreachpair (const FrameworkID& frameworkId,
-                 const Framework* framework,
+                 const std::shared_ptr<const Framework>& framework,
                  frameworks) {
       foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
         frameworksToSlaves[frameworkId].insert(taskInfo.slave_id());
@@ -1432,7 +1637,8 @@ public:
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
+      foreach (const std::shared_ptr<const CompletedTask>& task,
+               framework->completedTasks) {
         frameworksToSlaves[frameworkId].insert(task->slave_id());
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
@@ -1477,18 +1683,18 @@ struct TaskStateSummary
       lost(0),
       error(0) {}
 
-  // Account for the state of the given task.
-  void count(const Task& task)
+  // Account for the state of the given number of tasks.
+  void count(TaskState state, size_t tasks = 1)
   {
-    switch (task.state()) {
-      case TASK_STAGING: { ++staging; break; }
-      case TASK_STARTING: { ++starting; break; }
-      case TASK_RUNNING: { ++running; break; }
-      case TASK_FINISHED: { ++finished; break; }
-      case TASK_KILLED: { ++killed; break; }
-      case TASK_FAILED: { ++failed; break; }
-      case TASK_LOST: { ++lost; break; }
-      case TASK_ERROR: { ++error; break; }
+    switch (state) {
+      case TASK_STAGING: { staging += tasks; break; }
+      case TASK_STARTING: { starting += tasks; break; }
+      case TASK_RUNNING: { running += tasks; break; }
+      case TASK_FINISHED: { finished += tasks; break; }
+      case TASK_KILLED: { killed += tasks; break; }
+      case TASK_FAILED: { failed += tasks; break; }
+      case TASK_LOST: { lost += tasks; break; }
+      case TASK_ERROR: { error += tasks; break; }
       // No default case allows for a helpful compiler error if we
       // introduce a new state.
     }
@@ -1515,24 +1721,36 @@ const TaskStateSummary TaskStateSummary::EMPTY;
 class TaskStateSummaries
 {
 public:
-  TaskStateSummaries(const hashmap<FrameworkID, Framework*>& frameworks)
+  TaskStateSummaries(
+      const hashmap<FrameworkID, std::shared_ptr<const Framework>>& frameworks)
   {
     foreachpair (const FrameworkID& frameworkId,
-                 const Framework* framework,
+                 const std::shared_ptr<const Framework>& framework,
                  frameworks) {
       foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
         frameworkTaskSummaries[frameworkId].staging++;
         slaveTaskSummaries[taskInfo.slave_id()].staging++;
       }
 
-      foreachvalue (const Task* task, framework->tasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+      // The tasks and the completed tasks are counted per state and
+      // slave by the framework.
+      typedef hashmap<TaskState, size_t> StateMap;
+      foreachpair (const SlaveID& slaveId,
+                   const StateMap& states,
+                   framework->taskStates) {
+        foreachpair (TaskState state, size_t tasks, states) {
+          frameworkTaskSummaries[frameworkId].count(state, tasks);
+          slaveTaskSummaries[slaveId].count(state, tasks);
+        }
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+      foreachpair (const SlaveID& slaveId,
+                   const StateMap& states,
+                   framework->completedTaskStates) {
+        foreachpair (TaskState state, size_t tasks, states) {
+          frameworkTaskSummaries[frameworkId].count(state, tasks);
+          slaveTaskSummaries[slaveId].count(state, tasks);
+        }
       }
     }
   }
@@ -1567,111 +1785,107 @@ string Master::Http::STATESUMMARY_HELP()
 }
 
 
-Future<Response> Master::Http::stateSummary(const Request& request) const
-{
-  JSON::Object object;
-
-  object.values["hostname"] = master->info().hostname();
-
-  if (master->flags.cluster.isSome()) {
-    object.values["cluster"] = master->flags.cluster.get();
-  }
-
-  // We use the tasks in the 'Frameworks' struct to compute summaries
-  // for this endpoint. This is done 1) for consistency between the
-  // 'slaves' and 'frameworks' subsections below 2) because we want to
-  // provide summary information for frameworks that are currently
-  // registered 3) the frameworks keep a circular buffer of completed
-  // tasks that we can use to keep a limited view on the history of
-  // recent completed / failed tasks.
-
-  // Generate mappings from 'slave' to 'framework' and reverse.
-  SlaveFrameworkMapping slaveFrameworkMapping(master->frameworks.registered);
-
-  // Generate 'TaskState' summaries for all framework and slave ids.
-  TaskStateSummaries taskStateSummaries(master->frameworks.registered);
-
-  // Model all of the slaves.
-  {
-    JSON::Array array;
-    array.values.reserve(master->slaves.registered.size()); // MESOS-2353.
-
-    foreachvalue (Slave* slave, master->slaves.registered) {
-      JSON::Object json = summarize(*slave);
-
-      // Add the 'TaskState' summary for this slave.
-      const TaskStateSummary& summary = taskStateSummaries.slave(slave->id);
-
-      json.values["TASK_STAGING"] = summary.staging;
-      json.values["TASK_STARTING"] = summary.starting;
-      json.values["TASK_RUNNING"] = summary.running;
-      json.values["TASK_FINISHED"] = summary.finished;
-      json.values["TASK_KILLED"] = summary.killed;
-      json.values["TASK_FAILED"] = summary.failed;
-      json.values["TASK_LOST"] = summary.lost;
-      json.values["TASK_ERROR"] = summary.error;
+Response ReadOnlyHandler::stateSummary(
+    const std::shared_ptr<const Snapshot>& snapshot,
+    const Request& request)
+{
+  // Writes the 'TaskState' summary of a slave or a framework.
+  auto counts = [](
+      JSON::ObjectWriter* writer,
+      const TaskStateSummary& summary) {
+    writer->field("TASK_STAGING", summary.staging);
+    writer->field("TASK_STARTING", summary.starting);
+    writer->field("TASK_RUNNING", summary.running);
+    writer->field("TASK_FINISHED", summary.finished);
+    writer->field("TASK_KILLED", summary.killed);
+    writer->field("TASK_FAILED", summary.failed);
+    writer->field("TASK_LOST", summary.lost);
+    writer->field("TASK_ERROR", summary.error);
+  };
 
-      // Add the ids of all the frameworks running on this slave.
-      const hashset<FrameworkID>& frameworks =
-        slaveFrameworkMapping.frameworks(slave->id);
+  auto summary = [this, snapshot, counts](JSON::ObjectWriter* writer) {
+    // We use the tasks in the 'Frameworks' struct to compute summaries
+    // for this endpoint. This is done 1) for consistency between the
+    // 'slaves' and 'frameworks' subsections below 2) because we want
+    // to provide summary information for frameworks that are currently
+    // registered 3) the frameworks keep a circular buffer of completed
+    // tasks that we can use to keep a limited view on the history of
+    // recent completed / failed tasks.
 
-      JSON::Array frameworkIdArray;
-      frameworkIdArray.values.reserve(frameworks.size()); // MESOS-2353.
+    // Generate mappings from 'slave' to 'framework' and reverse.
+    SlaveFrameworkMapping slaveFrameworkMapping(snapshot->frameworks);
 
-      foreach (const FrameworkID& frameworkId, frameworks) {
-        frameworkIdArray.values.push_back(frameworkId.value());
-      }
+    // Generate 'TaskState' summaries for all framework and slave ids.
+    TaskStateSummaries taskStateSummaries(snapshot->frameworks);
 
-      json.values["framework_ids"] = std::move(frameworkIdArray);
+    writer->field("hostname", snapshot->info.hostname());
 
-      array.values.push_back(std::move(json));
+    if (flags.cluster.isSome()) {
+      writer->field("cluster", flags.cluster.get());
     }
 
-    object.values["slaves"] = std::move(array);
-  }
-
-  // Model all of the frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.registered.size()); // MESOS-2353.
-
-    foreachpair (const FrameworkID& frameworkId,
-                 Framework* framework,
-                 master->frameworks.registered) {
-      JSON::Object json = summarize(*framework);
-
-      // Add the 'TaskState' summary for this framework.
-      const TaskStateSummary& summary =
-        taskStateSummaries.framework(frameworkId);
-      json.values["TASK_STAGING"] = summary.staging;
-      json.values["TASK_STARTING"] = summary.starting;
-      json.values["TASK_RUNNING"] = summary.running;
-      json.values["TASK_FINISHED"] = summary.finished;
-      json.values["TASK_KILLED"] = summary.killed;
-      json.values["TASK_FAILED"] = summary.failed;
-      json.values["TASK_LOST"] = summary.lost;
-      json.values["TASK_ERROR"] = summary.error;
-
-      // Add the ids of all the slaves running this framework.
-      const hashset<SlaveID>& slaves =
-        slaveFrameworkMapping.slaves(frameworkId);
-
-      JSON::Array slaveIdArray;
-      slaveIdArray.values.reserve(slaves.size()); // MESOS-2353.
-
-      foreach (const SlaveID& slaveId, slaves) {
-        slaveIdArray.values.push_back(slaveId.value());
+    // Model all of the slaves.
+    writer->field("slaves", [&](JSON::ArrayWriter* writer) {
+      foreachvalue (const std::shared_ptr<const Slave>& slave,
+                    snapshot->slaves) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          json(writer, Summary<Slave>(*slave));
+
+          // Add the 'TaskState' summary for this slave.
+          counts(writer, taskStateSummaries.slave(slave->id));
+
+          // Add the ids of all the frameworks running on this slave.
+          const hashset<FrameworkID>& frameworks =
+            slaveFrameworkMapping.frameworks(slave->id);
+
+          writer->field("framework_ids", [&](JSON::ArrayWriter* writer) {
+            foreach (const FrameworkID& frameworkId, frameworks) {
+              writer->element(frameworkId.value());
+            }
+          });
+        });
       }
+    });
 
-      json.values["slave_ids"] = std::move(slaveIdArray);
+    // Model all of the frameworks.
+    writer->field("frameworks", [&](JSON::ArrayWriter* writer) {
+      foreachpair (const FrameworkID& frameworkId,
+                   const std::shared_ptr<const Framework>& framework,
+                   snapshot->frameworks) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          json(writer, Summary<Framework>(*framework));
+
+          // Add the 'TaskState' summary for this framework.
+          counts(writer, taskStateSummaries.framework(frameworkId));
+
+          // Add the ids of all the slaves running this framework.
+          const hashset<SlaveID>& slaves =
+            slaveFrameworkMapping.slaves(frameworkId);
+
+          writer->field("slave_ids", [&](JSON::ArrayWriter* writer) {
+            foreach (const SlaveID& slaveId, slaves) {
+              writer->element(slaveId.value());
+            }
+          });
+        });
+      }
+    });
+  };
 
-      array.values.push_back(std::move(json));
-    }
+  return stream(
+      self(),
+      [summary](std::ostream* stream) { *stream << jsonify(summary); },
+      request.url.query.get("jsonp"));
+}
 
-    object.values["frameworks"] = std::move(array);
-  }
 
-  return OK(object, request.url.query.get("jsonp"));
+Future<Response> Master::Http::stateSummary(const Request& request) const
+{
+  return dispatch(
+      master->readOnlyHandler,
+      &ReadOnlyHandler::stateSummary,
+      master->snapshot(),
+      request);
 }
 
 
@@ -1689,48 +1903,8 @@ string Master::Http::ROLES_HELP()
 }
 
 
-// Returns a JSON object modeled after a role.
-JSON::Object model(
-    const string& name,
-    Option<double> weight,
-    Option<Role*> _role)
-{
-  JSON::Object object;
-  object.values["name"] = name;
-
-  if (weight.isSome()) {
-    object.values["weight"] = weight.get();
-  } else {
-    object.values["weight"] = 1.0; // Default weight.
-  }
-
-  if (_role.isNone()) {
-    object.values["resources"] = model(Resources());
-    object.values["frameworks"] = JSON::Array();
-  } else {
-    Role* role = _role.get();
-
-    object.values["resources"] = model(role->resources());
-
-    {
-      JSON::Array array;
-
-      foreachkey (const FrameworkID& frameworkId, role->frameworks) {
-        array.values.push_back(frameworkId.value());
-      }
-
-      object.values["frameworks"] = std::move(array);
-    }
-  }
-
-  return object;
-}
-
-
 Future<Response> Master::Http::roles(const Request& request) const
 {
-  JSON::Object object;
-
   // Compute the role names to return results for. When an explicit
   // role whitelist has been configured, we use that list of names.
   // When using implicit roles, the right behavior is a bit more
@@ -1758,27 +1932,37 @@ Future<Response> Master::Http::roles(const Request& request) const
         master->quotas.keys().end());
   }
 
-  {
-    JSON::Array array;
+  auto roles = [this, &roleList](JSON::ObjectWriter* writer) {
+    writer->field("roles", [this, &roleList](JSON::ArrayWriter* writer) {
+      foreach (const string& name, roleList) {
+        writer->element([this, &name](JSON::ObjectWriter* writer) {
+          writer->field("name", name);
 
-    foreach (const string& name, roleList) {
-      Option<double> weight = None();
-      if (master->weights.contains(name)) {
-        weight = master->weights[name];
-      }
+          if (master->weights.contains(name)) {
+            writer->field("weight", master->weights.at(name));
+          } else {
+            writer->field("weight", 1.0); // Default weight.
+          }
 
-      Option<Role*> role = None();
-      if (master->activeRoles.contains(name)) {
-        role = master->activeRoles[name];
-      }
+          if (master->activeRoles.contains(name)) {
+            const Role* role = master->activeRoles.at(name);
 
-      array.values.push_back(model(name, weight, role));
-    }
-
-    object.values["roles"] = std::move(array);
-  }
+            writer->field("resources", role->resources());
+            writer->field("frameworks", [role](JSON::ArrayWriter* writer) {
+              foreachkey (const FrameworkID& frameworkId, role->frameworks) {
+                writer->element(frameworkId.value());
+              }
+            });
+          } else {
+            writer->field("resources", Resources());
+            writer->field("frameworks", [](JSON::ArrayWriter* writer) {});
+          }
+        });
+      }
+    });
+  };
 
-  return OK(object, request.url.query.get("jsonp"));
+  return OK(jsonify(roles), request.url.query.get("jsonp"));
 }
 
 
@@ -1887,8 +2071,19 @@ string Master::Http::TASKS_HELP()
       "(default is " + stringify(TASK_LIMIT) + ").",
       ">        offset=VALUE         Starts task list at offset.",
       ">        order=(asc|desc)     Ascending or descending sort order "
-      "(default is descending)."
-      ""));
+      "(default is descending).",
+      ">        framework_id=VALUE   Only lists the tasks of the given "
+      "framework.",
+      ">        slave_id=VALUE       Only lists the tasks on the given slave.",
+      ">        task_id=VALUE        Only lists the tasks with the given ID. "
+      "Along with framework_id, this also finds a completed task which is "
+      "no longer kept in memory (see --completed_tasks_dir).",
+      ">        state=VALUE          Only lists the tasks in the given state "
+      "(e.g., TASK_RUNNING).",
+      ">        role=VALUE           Only lists the tasks of the frameworks "
+      "of the given role.",
+      ">        fields=VALUE,...     Only includes the given fields of each "
+      "task."));
 }
 
 
@@ -1936,7 +2131,10 @@ struct TaskComparator
 };
 
 
-Future<Response> Master::Http::tasks(const Request& request) const
+Response ReadOnlyHandler::tasks(
+    const std::shared_ptr<const Snapshot>& snapshot,
+    const Request& request,
+    const Option<Task>& spilled)
 {
   // Get list options (limit and offset).
   Result<int> result = numify<int>(request.url.query.get("limit"));
@@ -1948,28 +2146,113 @@ Future<Response> Master::Http::tasks(const Request& request) const
   // TODO(nnielsen): Currently, formatting errors in offset and/or limit
   // will silently be ignored. This could be reported to the user instead.
 
-  // Construct framework list with both active and completed frameworks.
-  vector<const Framework*> frameworks;
-  foreachvalue (Framework* framework, master->frameworks.registered) {
-    frameworks.push_back(framework);
+  const Option<string> frameworkId = request.url.query.get("framework_id");
+  const Option<string> slaveId = request.url.query.get("slave_id");
+  const Option<string> taskId = request.url.query.get("task_id");
+  const Option<string> role = request.url.query.get("role");
+
+  Option<TaskState> taskState = None();
+  if (request.url.query.contains("state")) {
+    const string& value = request.url.query.at("state");
+
+    TaskState state;
+    if (!TaskState_Parse(value, &state)) {
+      return BadRequest("Invalid task state '" + value + "'.\n");
+    }
+
+    taskState = state;
   }
-  foreach (const std::shared_ptr<Framework>& framework,
-           master->frameworks.completed) {
-    frameworks.push_back(framework.get());
+
+  // Construct framework list with both active and completed frameworks.
+  vector<std::shared_ptr<const Framework>> frameworks;
+  if (frameworkId.isSome()) {
+    FrameworkID id;
+    id.set_value(frameworkId.get());
+
+    if (snapshot->frameworks.contains(id)) {
+      frameworks.push_back(snapshot->frameworks.at(id));
+    }
+    foreach (const std::shared_ptr<const Framework>& framework,
+             snapshot->completed) {
+      if (framework->id() == id) {
+        frameworks.push_back(framework);
+      }
+    }
+  } else {
+    foreachvalue (const std::shared_ptr<const Framework>& framework,
+                  snapshot->frameworks) {
+      frameworks.push_back(framework);
+    }
+    foreach (const std::shared_ptr<const Framework>& framework,
+             snapshot->completed) {
+      frameworks.push_back(framework);
+    }
   }
 
-  // Construct task list with both running and finished tasks.
+  // Construct task list with both running and finished tasks. Rather
+  // than scanning all of the tasks of a framework we only visit the
+  // (smallest) list of tasks in the index that matches the filters.
+  static const vector<const Task*> none;
+
   vector<const Task*> tasks;
-  foreach (const Framework* framework, frameworks) {
-    foreachvalue (Task* task, framework->tasks) {
-      CHECK_NOTNULL(task);
-      tasks.push_back(task);
+
+  // The completed tasks that the response may refer to.
+  vector<std::shared_ptr<std::deque<Task>>> completed;
+
+  foreach (const std::shared_ptr<const Framework>& framework, frameworks) {
+    if (role.isSome() && framework->info.role() != role.get()) {
+      continue;
     }
-    foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-      tasks.push_back(task.get());
+
+    const TaskIndex& index = this->index(framework);
+    completed.push_back(index.completed);
+
+    const vector<const Task*>* candidates = &index.tasks;
+
+    if (taskState.isSome()) {
+      candidates = index.states.count(taskState.get()) > 0
+        ? &index.states.at(taskState.get())
+        : &none;
     }
+
+    if (slaveId.isSome()) {
+      SlaveID id;
+      id.set_value(slaveId.get());
+
+      const vector<const Task*>* slave = index.slaves.contains(id)
+        ? &index.slaves.at(id)
+        : &none;
+
+      if (slave->size() < candidates->size()) {
+        candidates = slave;
+      }
+    }
+
+    foreach (const Task* task, *candidates) {
+      if ((taskState.isNone() || task->state() == taskState.get()) &&
+          (slaveId.isNone() || task->slave_id().value() == slaveId.get()) &&
+          (taskId.isNone() || task->task_id().value() == taskId.get())) {
+        tasks.push_back(task);
+      }
+    }
+  }
+
+  // The task found in the task history, unless it is still in memory
+  // (see 'Master::Http::tasks').
+  std::shared_ptr<const Task> evicted;
+  if (spilled.isSome() &&
+      tasks.empty() &&
+      (role.isNone() || frameworks.empty() ||
+       frameworks.front()->info.role() == role.get()) &&
+      (taskState.isNone() || spilled.get().state() == taskState.get()) &&
+      (slaveId.isNone() ||
+       spilled.get().slave_id().value() == slaveId.get())) {
+    evicted.reset(new Task(spilled.get()));
+    tasks.push_back(evicted.get());
   }
 
+  const Option<hashset<string>> fields = projection(request);
+
   // Sort tasks by task status timestamp. Default order is descending.
   // The earliest timestamp is chosen for comparison when multiple are present.
   Option<string> order = request.url.query.get("order");
@@ -1979,20 +2262,108 @@ Future<Response> Master::Http::tasks(const Request& request) const
     sort(tasks.begin(), tasks.end(), TaskComparator::descending);
   }
 
-  JSON::Object object;
+  // The tasks are written once this returns (see 'stream'), which the
+  // snapshot and the completed tasks outlive.
+  vector<const Task*> page;
+  for (size_t i = offset; i < std::min(offset + limit, tasks.size()); i++) {
+    page.push_back(tasks[i]);
+  }
 
-  {
-    JSON::Array array;
-    size_t end = std::min(offset + limit, tasks.size());
-    for (size_t i = offset; i < end; i++) {
-      const Task* task = tasks[i];
-      array.values.push_back(model(*task));
+  auto object = [snapshot, completed, evicted, page, fields](
+      JSON::ObjectWriter* writer) {
+    writer->field("tasks", [&page, &fields](JSON::ArrayWriter* writer) {
+      foreach (const Task* task, page) {
+        writer->element([task, &fields](JSON::ObjectWriter* writer) {
+          project(writer, fields, *task);
+        });
+      }
+    });
+  };
+
+  // Drop the indexes of the frameworks that are gone.
+  hashset<FrameworkID> known = snapshot->frameworks.keys();
+  foreach (const std::shared_ptr<const Framework>& framework,
+           snapshot->completed) {
+    known.insert(framework->id());
+  }
+
+  foreach (const FrameworkID& id, indexes.keys()) {
+    if (!known.contains(id)) {
+      indexes.erase(id);
     }
+  }
+
+  return stream(
+      self(),
+      [object](std::ostream* stream) { *stream << jsonify(object); },
+      request.url.query.get("jsonp"));
+}
+
+
+const ReadOnlyHandler::TaskIndex& ReadOnlyHandler::index(
+    const std::shared_ptr<const Framework>& framework)
+{
+  TaskIndex& index = indexes[framework->id()];
+
+  // The index stays valid for as long as the master publishes the
+  // same snapshot of the framework, i.e., until it is changed.
+  if (index.framework != framework) {
+    index = TaskIndex();
+    index.framework = framework;
+
+    auto add = [&index](const Task* task) {
+      index.tasks.push_back(task);
+      index.states[task->state()].push_back(task);
+      index.slaves[task->slave_id()].push_back(task);
+    };
+
+    foreachvalue (const Task* task, framework->tasks) {
+      add(CHECK_NOTNULL(task));
+    }
+    index.completed.reset(new std::deque<Task>());
+    foreach (const std::shared_ptr<const CompletedTask>& task,
+             framework->completedTasks) {
+      index.completed->push_back(task->task());
+      add(&index.completed->back());
+    }
+  }
+
+  return index;
+}
+
+
+Future<Response> Master::Http::tasks(const Request& request) const
+{
+  const Option<string> frameworkId = request.url.query.get("framework_id");
+  const Option<string> taskId = request.url.query.get("task_id");
+
+  // A single task which is no longer kept in memory may be in the
+  // task history, look it up along.
+  Future<Option<Task>> spilled = None();
+  if (master->taskHistory != NULL &&
+      frameworkId.isSome() &&
+      taskId.isSome()) {
+    FrameworkID frameworkId_;
+    frameworkId_.set_value(frameworkId.get());
 
-    object.values["tasks"] = std::move(array);
+    TaskID taskId_;
+    taskId_.set_value(taskId.get());
+
+    spilled = master->taskHistory->get(frameworkId_, taskId_);
   }
 
-  return OK(object, request.url.query.get("jsonp"));
+  const std::shared_ptr<const Snapshot> snapshot = master->snapshot();
+  const PID<ReadOnlyHandler> readOnlyHandler(master->readOnlyHandler);
+
+  return spilled
+    .then([=](const Option<Task>& task) {
+      return dispatch(
+          readOnlyHandler,
+          &ReadOnlyHandler::tasks,
+          snapshot,
+          request,
+          task);
+    });
 }
 
 
@@ -2026,7 +2397,7 @@ Future<Response> Master::Http::maintenanceSchedule(const Request& request) const
         mesos::maintenance::Schedule() :
         master->maintenance.schedules.front();
 
-    return OK(JSON::protobuf(schedule), request.url.query.get("jsonp"));
+    return OK(jsonify(schedule), request.url.query.get("jsonp"));
   }
 
   // Parse the POST body as JSON.
@@ -2078,33 +2449,40 @@ Future<Response> Master::Http::maintenanceSchedule(const Request& request) const
         }
       }
 
-      // NOTE: Copies are needed because `updateUnavailability()` in this loop
-      // modifies the container.
-      foreachkey (const MachineID& id, utils::copy(master->machines)) {
-        // Update the entry for each updated machine.
-        if (updated.contains(id)) {
-          master->updateUnavailability(id, updated[id]);
+      // Transition each removed machine back to the `UP` mode and remove
+      // the unavailability. Machines which are not in the old schedule
+      // either (i.e., `UP` machines without unavailability) are skipped.
+      foreachpair (const MachineID& id,
+                   Machine& machine,
+                   master->machines) {
+        if (updated.contains(id) ||
+            (machine.info.mode() == MachineInfo::UP &&
+             !machine.info.has_unavailability())) {
           continue;
         }
 
-        // Transition each removed machine back to the `UP` mode and remove the
-        // unavailability.
-        master->machines[id].info.set_mode(MachineInfo::UP);
+        machine.info.set_mode(MachineInfo::UP);
         master->updateUnavailability(id, None());
       }
 
-      // Save each new machine, with the unavailability
-      // and starting in `DRAINING` mode.
-      foreach (const mesos::maintenance::Window& window, schedule.windows()) {
-        foreach (const MachineID& id, window.machine_ids()) {
-          MachineInfo info;
-          info.mutable_id()->CopyFrom(id);
-          info.set_mode(MachineInfo::DRAINING);
-
-          master->machines[id].info.CopyFrom(info);
-
-          master->updateUnavailability(id, window.unavailability());
+      // Update the unavailability of each machine in the new schedule.
+      // Each new machine starts in `DRAINING` mode, the ones already
+      // in the old schedule keep their mode. The unavailability of the
+      // slaves on a machine is only updated (and their inverse offers
+      // rescinded) if the unavailability of the machine has changed,
+      // so that an edit of the schedule only affects the machines of
+      // the windows that were added, removed or changed.
+      foreachpair (const MachineID& id,
+                   const Unavailability& unavailability,
+                   updated) {
+        MachineInfo* info = &master->machines[id].info;
+
+        if (!info->has_id() || info->mode() == MachineInfo::UP) {
+          info->mutable_id()->CopyFrom(id);
+          info->set_mode(MachineInfo::DRAINING);
         }
+
+        master->updateUnavailability(id, unavailability);
       }
 
       // Replace the old schedule(s) with the new schedule.
@@ -2393,7 +2771,7 @@ Future<Response> Master::Http::maintenanceStatus(const Request& request) const
       }
     }
 
-    return OK(JSON::protobuf(status), request.url.query.get("jsonp"));
+    return OK(jsonify(status), request.url.query.get("jsonp"));
   }));
 }
 
@@ -61,6 +61,8 @@
 #include "master/registrar.hpp"
 #include "master/repairer.hpp"
 
+#include "master/allocator/recorder.hpp"
+
 #include "master/allocator/mesos/hierarchical.hpp"
 
 #include "module/manager.hpp"
@@ -84,6 +86,8 @@ using mesos::MasterInfo;
 
 using mesos::master::allocator::Allocator;
 
+using mesos::internal::master::allocator::RecordingAllocator;
+
 using mesos::modules::Anonymous;
 using mesos::modules::ModuleManager;
 
@@ -252,6 +256,21 @@ int main(int argc, char** argv)
   CHECK_NOTNULL(allocator.get());
   LOG(INFO) << "Using '" << allocatorName << "' allocator";
 
+  if (flags.allocator_record_file.isSome()) {
+    Try<RecordingAllocator*> recorder = RecordingAllocator::create(
+        allocator.get(), flags.allocator_record_file.get());
+
+    if (recorder.isError()) {
+      EXIT(EXIT_FAILURE)
+        << "Failed to record the allocator: " << recorder.error();
+    }
+
+    LOG(INFO) << "Recording the allocator to '"
+              << flags.allocator_record_file.get() << "'";
+
+    allocator = recorder.get();
+  }
+
   state::Storage* storage = NULL;
   Log* log = NULL;
 
@@ -307,7 +326,16 @@ int main(int argc, char** argv)
           set<UPID>(),
           flags.log_auto_initialize);
     }
-    storage = new state::LogStorage(log);
+    state::LogStorage* logStorage = new state::LogStorage(
+        log,
+        flags.registry_diffs_between_snapshots);
+
+    // Keep up with the registry while this master is a standby.
+    if (flags.registry_standby_interval.isSome()) {
+      logStorage->tail(flags.registry_standby_interval.get());
+    }
+
+    storage = logStorage;
   } else {
     EXIT(EXIT_FAILURE)
       << "'" << flags.registry << "' is not a supported"
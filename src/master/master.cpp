@@ -42,6 +42,7 @@
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/http.hpp>
 #include <process/id.hpp>
 #include <process/limiter.hpp>
@@ -54,6 +55,7 @@
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/gzip.hpp>
 #include <stout/ip.hpp>
 #include <stout/lambda.hpp>
 #include <stout/multihashmap.hpp>
@@ -82,6 +84,8 @@
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
+#include "master/state_exporter.hpp"
+#include "master/task_history.hpp"
 
 #include "module/manager.hpp"
 
@@ -124,95 +128,227 @@ using mesos::master::allocator::Allocator;
 using mesos::http::authentication::BasicAuthenticatorFactory;
 
 
-class SlaveObserver : public ProtobufProcess<SlaveObserver>
+// Health checks all the registered slaves from a single process,
+// rather than from a process per slave: the slaves are spread over
+// the slots of a timer wheel that turns once per 'slavePingTimeout',
+// so that every tick pings a batch of slaves (and counts the missed
+// pongs of their previous pings) and only a single timer is pending.
+//
+// Besides the pongs, any message that the master receives from a
+// slave counts as a pong (see 'Slave::heard'), so that a busy slave
+// is not considered unhealthy if a pong is delayed behind its other
+// messages.
+class SlaveHealthChecker : public ProtobufProcess<SlaveHealthChecker>
 {
 public:
-  SlaveObserver(const UPID& _slave,
-                const SlaveInfo& _slaveInfo,
-                const SlaveID& _slaveId,
-                const PID<Master>& _master,
-                const Option<shared_ptr<RateLimiter>>& _limiter,
-                const shared_ptr<Metrics> _metrics,
-                const Duration& _slavePingTimeout,
-                const size_t _maxSlavePingTimeouts)
-    : ProcessBase(process::ID::generate("slave-observer")),
-      slave(_slave),
-      slaveInfo(_slaveInfo),
-      slaveId(_slaveId),
+  // The number of slots of the wheel, i.e., the number of batches
+  // that the slaves are pinged in.
+  static const size_t SLOTS = 16;
+
+  SlaveHealthChecker(const PID<Master>& _master,
+                     const Option<shared_ptr<RateLimiter>>& _limiter,
+                     const shared_ptr<Metrics> _metrics,
+                     const Duration& _slavePingTimeout,
+                     const size_t _maxSlavePingTimeouts)
+    : ProcessBase(process::ID::generate("slave-health-checker")),
       master(_master),
       limiter(_limiter),
       metrics(_metrics),
       slavePingTimeout(_slavePingTimeout),
       maxSlavePingTimeouts(_maxSlavePingTimeouts),
-      timeouts(0),
-      pinged(false),
-      connected(true)
+      tick(std::max(_slavePingTimeout / SLOTS, Duration(Nanoseconds(1)))),
+      wheel(SLOTS),
+      ticks(0),
+      ticking(false)
   {
-    install<PongSlaveMessage>(&SlaveObserver::pong);
+    install<PongSlaveMessage>(&SlaveHealthChecker::pong);
   }
 
-  void reconnect()
+  // Starts health checking a slave, which is pinged right away and
+  // then once per 'slavePingTimeout'.
+  void add(const SlaveID& slaveId,
+           const UPID& pid,
+           const shared_ptr<std::atomic_bool>& heard)
   {
-    connected = true;
+    CHECK(!slaves.contains(slaveId));
+
+    if (!ticking) {
+      start = Clock::now();
+      ticks = 0;
+      schedule();
+    }
+
+    Observed& slave = slaves[slaveId];
+    slave.pid = pid;
+    slave.heard = heard;
+    slave.slot = ticks % SLOTS;
+
+    // The slot that has just been visited, i.e., the slave is visited
+    // again after a full turn of the wheel.
+    wheel[slave.slot].insert(slaveId);
+    pids[pid] = slaveId;
+
+    ping(slave);
   }
 
-  void disconnect()
+  void remove(const SlaveID& slaveId)
   {
-    connected = false;
+    if (!slaves.contains(slaveId)) {
+      return;
+    }
+
+    const Observed& slave = slaves[slaveId];
+
+    wheel[slave.slot].erase(slaveId);
+    pids.erase(slave.pid);
+    slaves.erase(slaveId);
   }
 
-protected:
-  virtual void initialize()
+  void reconnect(const SlaveID& slaveId, const UPID& pid)
+  {
+    if (!slaves.contains(slaveId)) {
+      return;
+    }
+
+    Observed& slave = slaves[slaveId];
+
+    // The slave may have re-registered from a different pid.
+    pids.erase(slave.pid);
+    pids[pid] = slaveId;
+
+    slave.pid = pid;
+    slave.connected = true;
+  }
+
+  void disconnect(const SlaveID& slaveId)
   {
-    ping();
+    if (slaves.contains(slaveId)) {
+      slaves[slaveId].connected = false;
+    }
   }
 
-  void ping()
+protected:
+  // The state of a slave which is health checked.
+  struct Observed
+  {
+    Observed() : slot(0), timeouts(0), pinged(false), connected(true) {}
+
+    UPID pid;
+
+    // Set by the master whenever it receives a message from the
+    // slave, and reset when the slave is checked.
+    shared_ptr<std::atomic_bool> heard;
+
+    // The slot of the wheel that the slave is in.
+    size_t slot;
+
+    Option<Future<Nothing>> shuttingDown;
+    uint32_t timeouts;
+    bool pinged;
+    bool connected;
+  };
+
+  void ping(Observed& slave)
   {
     PingSlaveMessage message;
-    message.set_connected(connected);
-    send(slave, message);
+    message.set_connected(slave.connected);
+    send(slave.pid, message);
+
+    slave.pinged = true;
+  }
 
-    pinged = true;
-    delay(slavePingTimeout, self(), &SlaveObserver::timeout);
+  void pong(const UPID& from)
+  {
+    Option<SlaveID> slaveId = pids.get(from);
+    if (slaveId.isSome()) {
+      healthy(slaves[slaveId.get()]);
+    }
   }
 
-  void pong()
+  void healthy(Observed& slave)
   {
-    timeouts = 0;
-    pinged = false;
+    slave.timeouts = 0;
+    slave.pinged = false;
 
     // Cancel any pending shutdown.
-    if (shuttingDown.isSome()) {
+    if (slave.shuttingDown.isSome()) {
       // Need a copy for non-const access.
-      Future<Nothing> future = shuttingDown.get();
+      Future<Nothing> future = slave.shuttingDown.get();
       future.discard();
     }
   }
 
+  // Arms the timer for the next tick of the wheel.
+  void schedule()
+  {
+    const Time next = start + Nanoseconds(tick.ns() * (ticks + 1));
+
+    delay(std::max(next - Clock::now(), Duration::zero()),
+          self(),
+          &SlaveHealthChecker::timeout);
+
+    ticking = true;
+  }
+
   void timeout()
   {
-    if (pinged) {
-      timeouts++; // No pong has been received before the timeout.
-      if (timeouts >= maxSlavePingTimeouts) {
-        // No pong has been received for the last
-        // 'maxSlavePingTimeouts' pings.
-        shutdown();
-      }
+    ticking = false;
+
+    // The wheel stops turning when there are no slaves and is
+    // restarted in 'add'.
+    if (slaves.empty()) {
+      return;
+    }
+
+    const uint64_t target = (Clock::now() - start).ns() / tick.ns();
+
+    // Catch up on the ticks missed by a late timer, but visit every
+    // slot at most once.
+    if (target > ticks + SLOTS) {
+      ticks = target - SLOTS;
     }
 
-    // NOTE: We keep pinging even if we schedule a shutdown. This is
-    // because if the slave eventually responds to a ping, we can
-    // cancel the shutdown.
-    ping();
+    while (ticks < target) {
+      ticks++;
+      check(ticks % SLOTS);
+    }
+
+    schedule();
+  }
+
+  // Checks the slaves of a slot, whose previous ping was sent to them
+  // a full turn ago.
+  void check(size_t slot)
+  {
+    foreach (const SlaveID& slaveId, wheel[slot]) {
+      Observed& slave = slaves[slaveId];
+
+      if (slave.heard->exchange(false)) {
+        healthy(slave);
+      }
+
+      if (slave.pinged) {
+        slave.timeouts++; // No pong has been received before the timeout.
+        if (slave.timeouts >= maxSlavePingTimeouts) {
+          // No pong has been received for the last
+          // 'maxSlavePingTimeouts' pings.
+          shutdown(slaveId, slave);
+        }
+      }
+
+      // NOTE: We keep pinging even if we schedule a shutdown. This is
+      // because if the slave eventually responds to a ping, we can
+      // cancel the shutdown.
+      ping(slave);
+    }
   }
 
   // NOTE: The shutdown of the slave is rate limited and can be
   // canceled if a pong was received before the actual shutdown is
   // called.
-  void shutdown()
+  void shutdown(const SlaveID& slaveId, Observed& slave)
   {
-    if (shuttingDown.isSome()) {
+    if (slave.shuttingDown.isSome()) {
       return;  // Shutdown is already in progress.
     }
 
@@ -225,15 +361,23 @@ protected:
       acquire = limiter.get()->acquire();
     }
 
-    shuttingDown = acquire.onAny(defer(self(), &Self::_shutdown));
+    slave.shuttingDown =
+      acquire.onAny(defer(self(), &Self::_shutdown, slaveId));
     ++metrics->slave_shutdowns_scheduled;
   }
 
-  void _shutdown()
+  void _shutdown(const SlaveID& slaveId)
   {
-    CHECK_SOME(shuttingDown);
+    // The slave may have been removed in the meantime.
+    if (!slaves.contains(slaveId)) {
+      return;
+    }
+
+    Observed& slave = slaves[slaveId];
+
+    CHECK_SOME(slave.shuttingDown);
 
-    const Future<Nothing>& future = shuttingDown.get();
+    const Future<Nothing>& future = slave.shuttingDown.get();
 
     CHECK(!future.isFailed());
 
@@ -254,22 +398,30 @@ protected:
       ++metrics->slave_shutdowns_canceled;
     }
 
-    shuttingDown = None();
+    slave.shuttingDown = None();
   }
 
 private:
-  const UPID slave;
-  const SlaveInfo slaveInfo;
-  const SlaveID slaveId;
   const PID<Master> master;
   const Option<shared_ptr<RateLimiter>> limiter;
   shared_ptr<Metrics> metrics;
-  Option<Future<Nothing>> shuttingDown;
   const Duration slavePingTimeout;
   const size_t maxSlavePingTimeouts;
-  uint32_t timeouts;
-  bool pinged;
-  bool connected;
+
+  // The duration of a tick of the wheel.
+  const Duration tick;
+
+  hashmap<SlaveID, Observed> slaves;
+  hashmap<UPID, SlaveID> pids;
+
+  // The slaves in each slot of the wheel.
+  vector<hashset<SlaveID>> wheel;
+
+  // The wheel has been turning since 'start' and has visited all the
+  // slots up to (and including) the one of tick 'ticks'.
+  Time start;
+  uint64_t ticks;
+  bool ticking;
 };
 
 
@@ -357,7 +509,8 @@ struct BoundedRateLimiter
   BoundedRateLimiter(double qps, Option<uint64_t> _capacity)
     : limiter(new process::RateLimiter(qps)),
       capacity(_capacity),
-      messages(0) {}
+      messages(0),
+      pending(0) {}
 
   process::Owned<process::RateLimiter> limiter;
   const Option<uint64_t> capacity;
@@ -366,6 +519,12 @@ struct BoundedRateLimiter
   // NOTE: ExitedEvents are throttled but not counted towards
   // the capacity here.
   uint64_t messages;
+
+  // Number of events (including ExitedEvents) deferred until they
+  // got a permit. An event which gets a permit right away is only
+  // visited right away when there are none, so that the events are
+  // still visited in the order they were received.
+  uint64_t pending;
 };
 
 
@@ -699,6 +858,29 @@ void Master::initialize()
       });
   spawn(whitelistWatcher);
 
+  healthChecker = new SlaveHealthChecker(
+      self(),
+      slaves.limiter,
+      metrics,
+      flags.slave_ping_timeout,
+      flags.max_slave_ping_timeouts);
+  spawn(healthChecker);
+
+  taskHistory = flags.completed_tasks_dir.isSome()
+    ? new TaskHistory(flags.completed_tasks_dir.get())
+    : NULL;
+
+  stateExporter = flags.state_export_dir.isSome()
+    ? new StateExporter(flags.state_export_dir.get())
+    : NULL;
+
+  if (stateExporter != NULL) {
+    delay(flags.state_export_interval, self(), &Master::exportState);
+  }
+
+  readOnlyHandler = new ReadOnlyHandler(flags);
+  spawn(readOnlyHandler);
+
   nextFrameworkId = 0;
   nextSlaveId = 0;
   nextOfferId = 0;
@@ -771,13 +953,7 @@ void Master::initialize()
       &RegisterSlaveMessage::version);
 
   install<ReregisterSlaveMessage>(
-      &Master::reregisterSlave,
-      &ReregisterSlaveMessage::slave,
-      &ReregisterSlaveMessage::checkpointed_resources,
-      &ReregisterSlaveMessage::executor_infos,
-      &ReregisterSlaveMessage::tasks,
-      &ReregisterSlaveMessage::completed_frameworks,
-      &ReregisterSlaveMessage::version);
+      &Master::reregisterSlave);
 
   install<UnregisterSlaveMessage>(
       &Master::unregisterSlave,
@@ -788,6 +964,9 @@ void Master::initialize()
       &StatusUpdateMessage::update,
       &StatusUpdateMessage::pid);
 
+  install<StatusUpdatesMessage>(
+      &Master::statusUpdates);
+
   // Added in 0.24.0 to support HTTP schedulers. Since
   // these do not have a pid, the slave must forward
   // messages through the master.
@@ -842,6 +1021,12 @@ void Master::initialize()
           Http::log(request);
           return http.destroyVolumes(request, principal);
         });
+  route("/events",
+        Http::EVENTS_HELP(),
+        [this](const process::http::Request& request) {
+          Http::log(request);
+          return http.events(request);
+        });
   route("/frameworks",
         Http::FRAMEWORKS(),
         [this](const process::http::Request& request) {
@@ -1064,11 +1249,6 @@ void Master::finalize()
       removeInverseOffer(inverseOffer);
     }
 
-    // Terminate the slave observer.
-    terminate(slave->observer);
-    wait(slave->observer);
-
-    delete slave->observer;
     delete slave;
   }
   slaves.registered.clear();
@@ -1083,6 +1263,7 @@ void Master::finalize()
     // Remove pending tasks from the framework. Don't bother
     // recovering the resources in the allocator.
     framework->pendingTasks.clear();
+    framework->revision++;
 
     // No tasks/executors/offers should remain since the slaves
     // have been removed.
@@ -1129,6 +1310,22 @@ void Master::finalize()
   wait(whitelistWatcher);
   delete whitelistWatcher;
 
+  terminate(healthChecker);
+  wait(healthChecker);
+  delete healthChecker;
+
+  delete taskHistory;
+  delete stateExporter;
+
+  terminate(readOnlyHandler);
+  wait(readOnlyHandler);
+  delete readOnlyHandler;
+
+  foreachvalue (StateSubscriber& subscriber, subscribers) {
+    subscriber.writer.close();
+  }
+  subscribers.clear();
+
   if (authenticator.isSome()) {
     delete authenticator.get();
   }
@@ -1276,6 +1473,15 @@ void Master::visit(const MessageEvent& event)
     ++messages_received;
   }
 
+  // Any message from a registered slave shows that it is alive,
+  // which the health checker counts like a pong.
+  if (!isRegisteredFramework) {
+    Slave* slave = slaves.registered.get(event.message->from);
+    if (slave != NULL) {
+      slave->heard->store(true, std::memory_order_relaxed);
+    }
+  }
+
   // All messages are filtered when non-leading.
   if (!elected()) {
     VLOG(1) << "Dropping '" << event.message->name << "' message since "
@@ -1317,8 +1523,15 @@ void Master::visit(const MessageEvent& event)
     if (limiter->capacity.isNone() ||
         limiter->messages < limiter->capacity.get()) {
       limiter->messages++;
-      limiter->limiter->acquire()
-        .onReady(defer(self(), &Self::throttled, event, principal));
+      limiter->pending++;
+
+      Future<Nothing> acquire = limiter->limiter->acquire();
+      if (acquire.isReady() && limiter->pending == 1) {
+        throttled(event, principal, Clock::now());
+      } else {
+        acquire.onReady(defer(
+            self(), &Self::throttled, event, principal, Clock::now()));
+      }
     } else {
       exceededCapacity(
           event,
@@ -1329,17 +1542,26 @@ void Master::visit(const MessageEvent& event)
               !frameworks.limiters.contains(principal.get())) &&
              isRegisteredFramework &&
              frameworks.defaultLimiter.isSome()) {
-    if (frameworks.defaultLimiter.get()->capacity.isNone() ||
-        frameworks.defaultLimiter.get()->messages <
-          frameworks.defaultLimiter.get()->capacity.get()) {
-      frameworks.defaultLimiter.get()->messages++;
-      frameworks.defaultLimiter.get()->limiter->acquire()
-        .onReady(defer(self(), &Self::throttled, event, None()));
+    const Owned<BoundedRateLimiter>& limiter =
+      frameworks.defaultLimiter.get();
+
+    if (limiter->capacity.isNone() ||
+        limiter->messages < limiter->capacity.get()) {
+      limiter->messages++;
+      limiter->pending++;
+
+      Future<Nothing> acquire = limiter->limiter->acquire();
+      if (acquire.isReady() && limiter->pending == 1) {
+        throttled(event, None(), Clock::now());
+      } else {
+        acquire.onReady(defer(
+            self(), &Self::throttled, event, None(), Clock::now()));
+      }
     } else {
       exceededCapacity(
           event,
           principal,
-          frameworks.defaultLimiter.get()->capacity.get());
+          limiter->capacity.get());
     }
   } else {
     _visit(event);
@@ -1361,37 +1583,85 @@ void Master::visit(const ExitedEvent& event)
     : Option<string>::none();
 
   // Necessary to disambiguate below.
-  typedef void(Self::*F)(const ExitedEvent&);
+  typedef void(Self::*F)(const ExitedEvent&, const Option<string>&);
+
+  Option<Owned<BoundedRateLimiter>> limiter;
+  Option<string> limiterPrincipal;
 
   if (principal.isSome() &&
       frameworks.limiters.contains(principal.get()) &&
       frameworks.limiters[principal.get()].isSome()) {
-    frameworks.limiters[principal.get()].get()->limiter->acquire()
-      .onReady(defer(self(), static_cast<F>(&Self::_visit), event));
+    limiter = frameworks.limiters[principal.get()].get();
+    limiterPrincipal = principal;
   } else if ((principal.isNone() ||
               !frameworks.limiters.contains(principal.get())) &&
              isRegisteredFramework &&
              frameworks.defaultLimiter.isSome()) {
-    frameworks.defaultLimiter.get()->limiter->acquire()
-      .onReady(defer(self(), static_cast<F>(&Self::_visit), event));
-  } else {
+    limiter = frameworks.defaultLimiter.get();
+  }
+
+  if (limiter.isNone()) {
     _visit(event);
+    return;
+  }
+
+  limiter.get()->pending++;
+
+  Future<Nothing> acquire = limiter.get()->limiter->acquire();
+  if (acquire.isReady() && limiter.get()->pending == 1) {
+    throttled(event, limiterPrincipal);
+  } else {
+    acquire.onReady(defer(
+        self(), static_cast<F>(&Self::throttled), event, limiterPrincipal));
   }
 }
 
 
 void Master::throttled(
     const MessageEvent& event,
-    const Option<std::string>& principal)
+    const Option<std::string>& principal,
+    const Time& received)
 {
   // We already know a RateLimiter is used to throttle this event so
   // here we only need to determine which.
   if (principal.isSome()) {
     CHECK_SOME(frameworks.limiters[principal.get()]);
     frameworks.limiters[principal.get()].get()->messages--;
+    frameworks.limiters[principal.get()].get()->pending--;
   } else {
     CHECK_SOME(frameworks.defaultLimiter);
     frameworks.defaultLimiter.get()->messages--;
+    frameworks.defaultLimiter.get()->pending--;
+  }
+
+  // Record how long the message was throttled for under the
+  // principal of its framework, which might not be the principal
+  // of the RateLimiter (i.e., for the default one) and might have
+  // been removed in the meantime.
+  if (frameworks.principals.contains(event.message->from)) {
+    const Option<string>& _principal =
+      frameworks.principals[event.message->from];
+
+    if (_principal.isSome() && metrics->frameworks.contains(_principal.get())) {
+      metrics->frameworks[_principal.get()]->messages_throttled_ms.record(
+          (Clock::now() - received).ms());
+    }
+  }
+
+  _visit(event);
+}
+
+
+void Master::throttled(
+    const ExitedEvent& event,
+    const Option<std::string>& principal)
+{
+  if (principal.isSome()) {
+    CHECK_SOME(frameworks.limiters[principal.get()]);
+    frameworks.limiters[principal.get()].get()->pending--;
+  } else {
+    CHECK_SOME(frameworks.defaultLimiter);
+    frameworks.defaultLimiter.get()->pending--;
   }
 
   _visit(event);
@@ -1559,7 +1829,7 @@ void Master::recoveredSlavesTimeout(const Registry& registry)
   }
 
   // Remove the slaves in a rate limited manner, similar to how the
-  // SlaveObserver removes slaves.
+  // SlaveHealthChecker removes slaves.
   foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
     // The slave is removed from 'recovered' when it re-registers.
     if (!slaves.recovered.contains(slave.info().id())) {
@@ -1898,6 +2168,10 @@ void Master::receive(
       suppress(framework);
       break;
 
+    case scheduler::Call::BATCH:
+      batch(framework, call.batch());
+      break;
+
     default:
       // Should be caught during call validation above.
       LOG(FATAL) << "Unexpected " << call.type() << " call"
@@ -2125,6 +2399,7 @@ void Master::_subscribe(
     allocator->updateFramework(framework->id(), framework->info);
 
     framework->reregisteredTime = Clock::now();
+    framework->revision++;
 
     if (subscribe.force()) {
       LOG(INFO) << "Framework " << *framework << " failed over";
@@ -2142,6 +2417,7 @@ void Master::_subscribe(
       // Reactivate the framework.
       if (!framework->active) {
         framework->active = true;
+        framework->revision++;
         allocator->activateFramework(framework->id());
       }
 
@@ -2416,6 +2692,7 @@ void Master::_subscribe(
     allocator->updateFramework(framework->id(), framework->info);
 
     framework->reregisteredTime = Clock::now();
+    framework->revision++;
 
     if (subscribe.force()) {
       // TODO(vinod): Now that the scheduler pid is unique we don't
@@ -2464,6 +2741,7 @@ void Master::_subscribe(
       // the allocator has the correct view of the framework's share.
       if (!framework->active) {
         framework->active = true;
+        framework->revision++;
         allocator->activateFramework(framework->id());
       }
 
@@ -2599,6 +2877,7 @@ void Master::deactivate(Framework* framework)
 
   // Stop sending offers here for now.
   framework->active = false;
+  framework->revision++;
 
   // Tell the allocator to stop allocating resources to this framework.
   allocator->deactivateFramework(framework->id());
@@ -2632,10 +2911,14 @@ void Master::disconnect(Slave* slave)
 
   LOG(INFO) << "Disconnecting slave " << *slave;
 
+  if (slave->active) {
+    untrackCapacity(slave);
+  }
+
   slave->connected = false;
 
-  // Inform the slave observer.
-  dispatch(slave->observer, &SlaveObserver::disconnect);
+  // Inform the health checker.
+  dispatch(healthChecker, &SlaveHealthChecker::disconnect, slave->id);
 
   // Remove the slave from authenticated. This is safe because
   // a slave will always reauthenticate before (re-)registering.
@@ -2651,7 +2934,12 @@ void Master::deactivate(Slave* slave)
 
   LOG(INFO) << "Deactivating slave " << *slave;
 
+  if (slave->connected && slave->active) {
+    untrackCapacity(slave);
+  }
+
   slave->active = false;
+  slave->revision++;
 
   allocator->deactivateSlave(slave->id);
 
@@ -2678,6 +2966,24 @@ void Master::deactivate(Slave* slave)
 }
 
 
+void Master::trackCapacity(const Slave* slave)
+{
+  // NOTE: Dynamic reservations are not excluded here because they do
+  // not show up in `SlaveInfo` resources. In contrast to static
+  // reservations, dynamic reservations may be unreserved at any time,
+  // hence making resources available for quota'ed frameworks.
+  nonStaticClusterResources +=
+    Resources(slave->info.resources()).unreserved().scalars();
+}
+
+
+void Master::untrackCapacity(const Slave* slave)
+{
+  nonStaticClusterResources -=
+    Resources(slave->info.resources()).unreserved().scalars();
+}
+
+
 void Master::resourceRequest(
     const UPID& from,
     const FrameworkID& frameworkId,
@@ -2736,6 +3042,41 @@ void Master::suppress(Framework* framework)
 }
 
 
+void Master::batch(
+    Framework* framework,
+    const scheduler::Call::Batch& batch)
+{
+  CHECK_NOTNULL(framework);
+
+  LOG(INFO) << "Processing BATCH call with " << batch.calls_size()
+            << " calls for framework " << *framework;
+
+  ++metrics->messages_batch;
+
+  foreach (const scheduler::Call& call, batch.calls()) {
+    switch (call.type()) {
+      case scheduler::Call::ACCEPT:
+        accept(framework, call.accept());
+        break;
+
+      case scheduler::Call::DECLINE:
+        decline(framework, call.decline());
+        break;
+
+      case scheduler::Call::ACKNOWLEDGE:
+        acknowledge(framework, call.acknowledge());
+        break;
+
+      default:
+        // Should be caught during call validation.
+        LOG(FATAL) << "Unexpected " << call.type() << " call in a batch"
+                   << " from framework " << *framework;
+        break;
+    }
+  }
+}
+
+
 bool Master::isWhitelistedRole(const string& name)
 {
   if (roleWhitelist.isNone()) {
@@ -2804,82 +3145,74 @@ void Master::launchTasks(
 }
 
 
-Future<bool> Master::authorizeTask(
-    const TaskInfo& task,
-    Framework* framework)
+// Returns the user which the task runs as.
+static string taskUser(const TaskInfo& task, const FrameworkInfo& framework)
 {
-  if (authorizer.isNone()) {
-    return true; // Authorization is disabled.
-  }
-
-  // Authorize the task.
-  string user = framework->info.user(); // Default user.
   if (task.has_command() && task.command().has_user()) {
-    user = task.command().user();
+    return task.command().user();
   } else if (task.has_executor() && task.executor().command().has_user()) {
-    user = task.executor().command().user();
+    return task.executor().command().user();
   }
 
-  LOG(INFO)
-    << "Authorizing framework principal '" << framework->info.principal()
-    << "' to launch task " << task.task_id() << " as user '" << user << "'";
+  return framework.user(); // Default user.
+}
 
-  mesos::ACL::RunTask request;
-  if (framework->info.has_principal()) {
-    request.mutable_principals()->add_values(framework->info.principal());
+
+static void setPrincipals(
+    const Option<string>& principal,
+    ACL::Entity* principals)
+{
+  if (principal.isSome()) {
+    principals->add_values(principal.get());
   } else {
-    // Framework doesn't have a principal set.
-    request.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    principals->set_type(ACL::Entity::ANY);
   }
-  request.mutable_users()->add_values(user);
+}
 
-  return authorizer.get()->authorize(request);
+
+// The requests for authorizing the tasks and the offer operations,
+// see `Master::authorizeTask()` and friends.
+static ACL::RunTask runTaskRequest(
+    const TaskInfo& task,
+    const FrameworkInfo& framework)
+{
+  ACL::RunTask request;
+
+  // NOTE: A framework which doesn't have a principal set is
+  // authorized as ANY principal.
+  setPrincipals(
+      framework.has_principal()
+        ? framework.principal()
+        : Option<string>::none(),
+      request.mutable_principals());
+
+  request.mutable_users()->add_values(taskUser(task, framework));
+
+  return request;
 }
 
 
-Future<bool> Master::authorizeReserveResources(
+static ACL::ReserveResources reserveResourcesRequest(
     const Offer::Operation::Reserve& reserve,
     const Option<string>& principal)
 {
-  if (authorizer.isNone()) {
-    return true; // Authorization is disabled.
-  }
-
-  mesos::ACL::ReserveResources request;
-
-  if (principal.isSome()) {
-    request.mutable_principals()->add_values(principal.get());
-  } else {
-    request.mutable_principals()->set_type(ACL::Entity::ANY);
-  }
+  ACL::ReserveResources request;
+  setPrincipals(principal, request.mutable_principals());
 
   // TODO(mpark): Determine what kinds of constraints we may want to
   // enforce on resources. Currently, we simply use ANY.
   request.mutable_resources()->set_type(ACL::Entity::ANY);
 
-  LOG(INFO) << "Authorizing principal '"
-            << (principal.isSome() ? principal.get() : "ANY")
-            << "' to reserve resources '" << reserve.resources() << "'";
-
-  return authorizer.get()->authorize(request);
+  return request;
 }
 
 
-Future<bool> Master::authorizeUnreserveResources(
+static ACL::UnreserveResources unreserveResourcesRequest(
     const Offer::Operation::Unreserve& unreserve,
     const Option<string>& principal)
 {
-  if (authorizer.isNone()) {
-    return true; // Authorization is disabled.
-  }
-
-  mesos::ACL::UnreserveResources request;
-
-  if (principal.isSome()) {
-    request.mutable_principals()->add_values(principal.get());
-  } else {
-    request.mutable_principals()->set_type(ACL::Entity::ANY);
-  }
+  ACL::UnreserveResources request;
+  setPrincipals(principal, request.mutable_principals());
 
   foreach (const Resource& resource, unreserve.resources()) {
     // NOTE: Since validation of this operation is performed after
@@ -2892,59 +3225,31 @@ Future<bool> Master::authorizeUnreserveResources(
     }
   }
 
-  LOG(INFO)
-    << "Authorizing principal '"
-    << (principal.isSome() ? principal.get() : "ANY")
-    << "' to unreserve resources '" << unreserve.resources() << "'";
-
-  return authorizer.get()->authorize(request);
+  return request;
 }
 
 
-Future<bool> Master::authorizeCreateVolume(
+static ACL::CreateVolume createVolumeRequest(
     const Offer::Operation::Create& create,
     const Option<string>& principal)
 {
-  if (authorizer.isNone()) {
-    return true; // Authorization is disabled.
-  }
-
-  mesos::ACL::CreateVolume request;
-
-  if (principal.isSome()) {
-    request.mutable_principals()->add_values(principal.get());
-  } else {
-    request.mutable_principals()->set_type(ACL::Entity::ANY);
-  }
+  ACL::CreateVolume request;
+  setPrincipals(principal, request.mutable_principals());
 
   // TODO(greggomann): Determine what `volume_types` we may want to
   // allow/prevent creation of. Currently, we simply use ANY.
   request.mutable_volume_types()->set_type(ACL::Entity::ANY);
 
-  LOG(INFO)
-    << "Authorizing principal '"
-    << (principal.isSome() ? principal.get() : "ANY")
-    << "' to create volumes";
-
-  return authorizer.get()->authorize(request);
+  return request;
 }
 
 
-Future<bool> Master::authorizeDestroyVolume(
+static ACL::DestroyVolume destroyVolumeRequest(
     const Offer::Operation::Destroy& destroy,
     const Option<string>& principal)
 {
-  if (authorizer.isNone()) {
-    return true; // Authorization is disabled.
-  }
-
-  mesos::ACL::DestroyVolume request;
-
-  if (principal.isSome()) {
-    request.mutable_principals()->add_values(principal.get());
-  } else {
-    request.mutable_principals()->set_type(ACL::Entity::ANY);
-  }
+  ACL::DestroyVolume request;
+  setPrincipals(principal, request.mutable_principals());
 
   foreach (const Resource& volume, destroy.volumes()) {
     // NOTE: Since validation of this operation may be performed after
@@ -2956,22 +3261,106 @@ Future<bool> Master::authorizeDestroyVolume(
     }
   }
 
-  LOG(INFO)
-    << "Authorizing principal '"
-    << (principal.isSome() ? principal.get() : "ANY")
-    << "' to destroy volumes '"
-    << stringify(destroy.volumes()) << "'";
-
-  return authorizer.get()->authorize(request);
+  return request;
 }
 
 
-Resources Master::addTask(
+Future<bool> Master::authorizeTask(
     const TaskInfo& task,
-    Framework* framework,
-    Slave* slave)
+    Framework* framework)
 {
-  CHECK_NOTNULL(framework);
+  if (authorizer.isNone()) {
+    return true; // Authorization is disabled.
+  }
+
+  // Authorize the task.
+  const string user = taskUser(task, framework->info);
+
+  LOG(INFO)
+    << "Authorizing framework principal '" << framework->info.principal()
+    << "' to launch task " << task.task_id() << " as user '" << user << "'";
+
+  return authorizer.get()->authorize(runTaskRequest(task, framework->info));
+}
+
+
+Future<bool> Master::authorizeReserveResources(
+    const Offer::Operation::Reserve& reserve,
+    const Option<string>& principal)
+{
+  if (authorizer.isNone()) {
+    return true; // Authorization is disabled.
+  }
+
+  LOG(INFO) << "Authorizing principal '"
+            << (principal.isSome() ? principal.get() : "ANY")
+            << "' to reserve resources '" << reserve.resources() << "'";
+
+  return authorizer.get()->authorize(
+      reserveResourcesRequest(reserve, principal));
+}
+
+
+Future<bool> Master::authorizeUnreserveResources(
+    const Offer::Operation::Unreserve& unreserve,
+    const Option<string>& principal)
+{
+  if (authorizer.isNone()) {
+    return true; // Authorization is disabled.
+  }
+
+  LOG(INFO)
+    << "Authorizing principal '"
+    << (principal.isSome() ? principal.get() : "ANY")
+    << "' to unreserve resources '" << unreserve.resources() << "'";
+
+  return authorizer.get()->authorize(
+      unreserveResourcesRequest(unreserve, principal));
+}
+
+
+Future<bool> Master::authorizeCreateVolume(
+    const Offer::Operation::Create& create,
+    const Option<string>& principal)
+{
+  if (authorizer.isNone()) {
+    return true; // Authorization is disabled.
+  }
+
+  LOG(INFO)
+    << "Authorizing principal '"
+    << (principal.isSome() ? principal.get() : "ANY")
+    << "' to create volumes";
+
+  return authorizer.get()->authorize(createVolumeRequest(create, principal));
+}
+
+
+Future<bool> Master::authorizeDestroyVolume(
+    const Offer::Operation::Destroy& destroy,
+    const Option<string>& principal)
+{
+  if (authorizer.isNone()) {
+    return true; // Authorization is disabled.
+  }
+
+  LOG(INFO)
+    << "Authorizing principal '"
+    << (principal.isSome() ? principal.get() : "ANY")
+    << "' to destroy volumes '"
+    << stringify(destroy.volumes()) << "'";
+
+  return authorizer.get()->authorize(
+      destroyVolumeRequest(destroy, principal));
+}
+
+
+Resources Master::addTask(
+    const TaskInfo& task,
+    Framework* framework,
+    Slave* slave)
+{
+  CHECK_NOTNULL(framework);
   CHECK_NOTNULL(slave);
   CHECK(slave->connected) << "Adding task " << task.task_id()
                           << " to disconnected slave " << *slave;
@@ -3003,6 +3392,8 @@ Resources Master::addTask(
   slave->addTask(t);
   framework->addTask(t);
 
+  http.taskAdded(*t);
+
   return resources;
 }
 
@@ -3136,14 +3527,21 @@ void Master::accept(
   LOG(INFO) << "Processing ACCEPT call for offers: " << accept.offer_ids()
             << " on slave " << *slave << " for framework " << *framework;
 
-  list<Future<bool>> futures;
+  // The operations are authorized in a single batch, see below.
+  ACL::Batch batch;
+
+  Option<string> principal = framework->info.has_principal()
+    ? framework->info.principal()
+    : Option<string>::none();
+
   foreach (const Offer::Operation& operation, accept.operations()) {
     switch (operation.type()) {
       case Offer::Operation::LAUNCH: {
         // Authorize the tasks. A task is in 'framework->pendingTasks'
         // before it is authorized.
         foreach (const TaskInfo& task, operation.launch().task_infos()) {
-          futures.push_back(authorizeTask(task, framework));
+          batch.add_requests()->mutable_run_task()->CopyFrom(
+              runTaskRequest(task, framework->info));
 
           // Add to pending tasks.
           //
@@ -3154,6 +3552,8 @@ void Master::accept(
           // will not be launched.
           if (!framework->pendingTasks.contains(task.task_id())) {
             framework->pendingTasks[task.task_id()] = task;
+            framework->taskChanged(task.task_id());
+            framework->revision++;
           }
         }
         break;
@@ -3167,60 +3567,71 @@ void Master::accept(
 
       // The RESERVE operation allows a principal to reserve resources.
       case Offer::Operation::RESERVE: {
-        Option<string> principal = framework->info.has_principal()
-          ? framework->info.principal()
-          : Option<string>::none();
-
-        futures.push_back(
-            authorizeReserveResources(
-                operation.reserve(), principal));
+        batch.add_requests()->mutable_reserve_resources()->CopyFrom(
+            reserveResourcesRequest(operation.reserve(), principal));
 
         break;
       }
 
       // The UNRESERVE operation allows a principal to unreserve resources.
       case Offer::Operation::UNRESERVE: {
-        Option<string> principal = framework->info.has_principal()
-          ? framework->info.principal()
-          : Option<string>::none();
-
-        futures.push_back(
-            authorizeUnreserveResources(
-                operation.unreserve(), principal));
+        batch.add_requests()->mutable_unreserve_resources()->CopyFrom(
+            unreserveResourcesRequest(operation.unreserve(), principal));
 
         break;
       }
 
       // The CREATE operation allows the creation of a persistent volume.
       case Offer::Operation::CREATE: {
-        Option<string> principal = framework->info.has_principal()
-          ? framework->info.principal()
-          : Option<string>::none();
-
-        futures.push_back(
-            authorizeCreateVolume(
-                operation.create(), principal));
+        batch.add_requests()->mutable_create_volume()->CopyFrom(
+            createVolumeRequest(operation.create(), principal));
 
         break;
       }
 
       // The DESTROY operation allows the destruction of a persistent volume.
       case Offer::Operation::DESTROY: {
-        Option<string> principal = framework->info.has_principal()
-          ? framework->info.principal()
-          : Option<string>::none();
-
-        futures.push_back(
-            authorizeDestroyVolume(
-                operation.destroy(), principal));
+        batch.add_requests()->mutable_destroy_volume()->CopyFrom(
+            destroyVolumeRequest(operation.destroy(), principal));
 
         break;
       }
     }
   }
 
+  const size_t size = batch.requests_size();
+
+  Future<list<Future<bool>>> authorizations;
+
+  if (authorizer.isNone()) {
+    // Authorization is disabled.
+    authorizations = list<Future<bool>>(size, true);
+  } else {
+    LOG(INFO) << "Authorizing " << size << " operations of ACCEPT call"
+              << " for framework " << *framework << " as principal '"
+              << framework->info.principal() << "'";
+
+    // A whole batch is authorized in a single round trip, but
+    // `_accept()` handles each of the operations separately, so the
+    // failure of a batch fails all of its operations.
+    authorizations = authorizer.get()->authorize(batch)
+      .then([size](const list<bool>& authorized) -> list<Future<bool>> {
+        if (authorized.size() != size) {
+          return list<Future<bool>>(
+              size,
+              Failure("Expected " + stringify(size) + " authorizations but"
+                      " got " + stringify(authorized.size())));
+        }
+
+        return list<Future<bool>>(authorized.begin(), authorized.end());
+      })
+      .repair([size](const Future<list<Future<bool>>>& authorized) {
+        return list<Future<bool>>(size, Failure(authorized.failure()));
+      });
+  }
+
   // Wait for all the tasks to be authorized.
-  await(futures)
+  authorizations
     .onAny(defer(self(),
                  &Master::_accept,
                  framework->id(),
@@ -3310,7 +3721,42 @@ void Master::_accept(
   CHECK_READY(_authorizations);
   list<Future<bool>> authorizations = _authorizations.get();
 
+  // The tasks launched on the slave are sent in one 'RunTasksMessage'
+  // (or a 'RunTaskMessage' if there is only one). Since the other
+  // operations may update the checkpointed resources of the slave,
+  // the pending tasks are sent before applying any of them, which
+  // keeps the messages in the order of the operations.
+  RunTasksMessage runTasks;
+  auto sendTasks = [this, framework, slave, &runTasks]() {
+    if (runTasks.tasks().size() == 1) {
+      RunTaskMessage message;
+      message.mutable_framework()->CopyFrom(runTasks.framework());
+      message.set_pid(runTasks.pid());
+      message.mutable_task()->CopyFrom(runTasks.tasks(0));
+
+      send(slave->pid, message);
+    } else if (runTasks.tasks().size() > 1) {
+      LOG(INFO) << "Sending " << runTasks.tasks().size() << " tasks of"
+                << " framework " << *framework << " to slave " << *slave;
+
+      send(slave->pid, runTasks);
+    }
+
+    runTasks.clear_tasks();
+  };
+
+  runTasks.mutable_framework()->MergeFrom(framework->info);
+
+  // TODO(anand): We set 'pid' to UPID() for http frameworks
+  // as 'pid' was made optional in 0.24.0. In 0.25.0, we
+  // no longer have to set pid here for http frameworks.
+  runTasks.set_pid(framework->pid.getOrElse(UPID()));
+
   foreach (const Offer::Operation& operation, accept.operations()) {
+    if (operation.type() != Offer::Operation::LAUNCH) {
+      sendTasks();
+    }
+
     switch (operation.type()) {
       // The RESERVE operation allows a principal to reserve resources.
       case Offer::Operation::RESERVE: {
@@ -3535,6 +3981,8 @@ void Master::_accept(
 
           // Remove from pending tasks.
           framework->pendingTasks.erase(task.task_id());
+          framework->forgetTaskChange(task.task_id());
+          framework->revision++;
 
           CHECK(!authorization.isDiscarded());
 
@@ -3623,25 +4071,17 @@ void Master::_accept(
                       << " with resources " << task_.resources()
                       << " on slave " << *slave;
 
-            RunTaskMessage message;
-            message.mutable_framework()->MergeFrom(framework->info);
-
-            // TODO(anand): We set 'pid' to UPID() for http frameworks
-            // as 'pid' was made optional in 0.24.0. In 0.25.0, we
-            // no longer have to set pid here for http frameworks.
-            message.set_pid(framework->pid.getOrElse(UPID()));
-            message.mutable_task()->MergeFrom(task_);
+            TaskInfo* launched = runTasks.add_tasks();
+            launched->MergeFrom(task_);
 
             if (HookManager::hooksAvailable()) {
               // Set labels retrieved from label-decorator hooks.
-              message.mutable_task()->mutable_labels()->CopyFrom(
+              launched->mutable_labels()->CopyFrom(
                   HookManager::masterLaunchTaskLabelDecorator(
                       task_,
                       framework->info,
                       slave->info));
             }
-
-            send(slave->pid, message);
           }
         }
         break;
@@ -3653,6 +4093,8 @@ void Master::_accept(
     }
   }
 
+  sendTasks();
+
   if (!_offeredResources.empty()) {
     // Tell the allocator about the unused (e.g., refused) resources.
     allocator->recoverResources(
@@ -3801,6 +4243,8 @@ void Master::kill(Framework* framework, const scheduler::Call::Kill& kill)
   if (framework->pendingTasks.contains(taskId)) {
     // Remove from pending tasks.
     framework->pendingTasks.erase(taskId);
+    framework->forgetTaskChange(taskId);
+    framework->revision++;
 
     const StatusUpdate& update = protobuf::createStatusUpdate(
         framework->id(),
@@ -3985,12 +4429,54 @@ void Master::acknowledge(
   message.mutable_task_id()->CopyFrom(taskId);
   message.set_uuid(uuid.toBytes());
 
-  send(slave->pid, message);
+  // The acknowledgement is batched with the ones that are processed
+  // before the dispatch below, so that a slave whose tasks complete
+  // en masse gets a single message rather than one per task.
+  if (pendingAcknowledgements.empty()) {
+    dispatch(self(), &Master::forwardAcknowledgements);
+  }
+
+  pendingAcknowledgements[slaveId].push_back(message);
 
   metrics->valid_status_update_acknowledgements++;
 }
 
 
+void Master::forwardAcknowledgements()
+{
+  foreachpair (const SlaveID& slaveId,
+               const vector<StatusUpdateAcknowledgementMessage>& messages,
+               pendingAcknowledgements) {
+    Slave* slave = slaves.registered.get(slaveId);
+
+    // It is safe to drop the acknowledgements if the slave has been
+    // removed or disconnected since, it will retry the updates.
+    if (slave == NULL || !slave->connected) {
+      LOG(WARNING) << "Dropping " << messages.size() << " status update"
+                   << " acknowledgement(s) for slave " << slaveId
+                   << " because the slave is "
+                   << (slave == NULL ? "not registered" : "disconnected");
+      continue;
+    }
+
+    if (messages.size() == 1) {
+      send(slave->pid, messages.front());
+      continue;
+    }
+
+    StatusUpdateAcknowledgementsMessage message;
+    foreach (const StatusUpdateAcknowledgementMessage& acknowledgement,
+             messages) {
+      message.add_acknowledgements()->CopyFrom(acknowledgement);
+    }
+
+    send(slave->pid, message);
+  }
+
+  pendingAcknowledgements.clear();
+}
+
+
 void Master::schedulerMessage(
     const UPID& from,
     const SlaveID& slaveId,
@@ -4308,12 +4794,7 @@ void Master::_registerSlave(
 
 void Master::reregisterSlave(
     const UPID& from,
-    const SlaveInfo& slaveInfo,
-    const vector<Resource>& checkpointedResources,
-    const vector<ExecutorInfo>& executorInfos,
-    const vector<Task>& tasks,
-    const vector<Archive::Framework>& completedFrameworks,
-    const string& version)
+    const ReregisterSlaveMessage& message)
 {
   ++metrics->messages_reregister_slave;
 
@@ -4322,27 +4803,21 @@ void Master::reregisterSlave(
               << " because authentication is still in progress";
 
     authenticating[from]
-      .onReady(defer(self(),
-                     &Self::reregisterSlave,
-                     from,
-                     slaveInfo,
-                     checkpointedResources,
-                     executorInfos,
-                     tasks,
-                     completedFrameworks,
-                     version));
+      .onReady(defer(self(), &Self::reregisterSlave, from, message));
     return;
   }
 
+  const SlaveInfo& slaveInfo = message.slave();
+
   if (flags.authenticate_slaves && !authenticated.contains(from)) {
     // This could happen if another authentication request came
     // through before we are here or if a slave tried to
     // re-register without authentication.
     LOG(WARNING) << "Refusing re-registration of slave at " << from
                  << " because it is not authenticated";
-    ShutdownMessage message;
-    message.set_message("Slave is not authenticated");
-    send(from, message);
+    ShutdownMessage shutdown;
+    shutdown.set_message("Slave is not authenticated");
+    send(from, shutdown);
     return;
   }
 
@@ -4358,9 +4833,9 @@ void Master::reregisterSlave(
                  << " because the machine '" << machineId << "' that it is "
                  << "running on is `DOWN`";
 
-    ShutdownMessage message;
-    message.set_message("Machine is `DOWN`");
-    send(from, message);
+    ShutdownMessage shutdown;
+    shutdown.set_message("Machine is `DOWN`");
+    send(from, shutdown);
     return;
   }
 
@@ -4374,9 +4849,9 @@ void Master::reregisterSlave(
                  << " (" << slaveInfo.hostname() << ") attempted to "
                  << "re-register after removal; shutting it down";
 
-    ShutdownMessage message;
-    message.set_message("Slave attempted to re-register after removal");
-    send(from, message);
+    ShutdownMessage shutdown;
+    shutdown.set_message("Slave attempted to re-register after removal");
+    send(from, shutdown);
     return;
   }
 
@@ -4384,6 +4859,7 @@ void Master::reregisterSlave(
 
   if (slave != NULL) {
     slave->reregisteredTime = Clock::now();
+    slave->revision++;
 
     // NOTE: This handles the case where a slave tries to
     // re-register with an existing master (e.g. because of a
@@ -4406,11 +4882,11 @@ void Master::reregisterSlave(
                    << slave->pid.address.ip << " (" << slave->info.hostname()
                    << ") shutting it down";
 
-      ShutdownMessage message;
-      message.set_message(
+      ShutdownMessage shutdown;
+      shutdown.set_message(
           "Slave attempted to re-register with different IP / hostname");
 
-      send(from, message);
+      send(from, shutdown);
       return;
     }
 
@@ -4421,12 +4897,21 @@ void Master::reregisterSlave(
     // ignore duplicate exited events for disconnected slaves.
     // See: https://issues.apache.org/jira/browse/MESOS-675
     slave->pid = from;
+    slave->revision++;
+    slave->offerTemplate.reset();
     link(slave->pid);
 
+    // NOTE: The tasks may be abbreviated (see `ReregisterSlaveMessage`),
+    // which is fine for reconciling them with the ones of the master.
+    const vector<Task> tasks = google::protobuf::convert(message.tasks());
+
     // Reconcile tasks between master and the slave.
     // NOTE: This sends the re-registered message, including tasks
     // that need to be reconciled by the slave.
-    reconcile(slave, executorInfos, tasks);
+    reconcile(
+        slave,
+        google::protobuf::convert(message.executor_infos()),
+        tasks);
 
     // If this is a disconnected slave, add it back to the allocator.
     // This is done after reconciliation to ensure the allocator's
@@ -4434,8 +4919,13 @@ void Master::reregisterSlave(
     // slave.
     if (!slave->connected) {
       slave->connected = true;
-      dispatch(slave->observer, &SlaveObserver::reconnect);
+      dispatch(healthChecker,
+               &SlaveHealthChecker::reconnect,
+               slave->id,
+               slave->pid);
       slave->active = true;
+      slave->revision++;
+      trackCapacity(slave);
       allocator->activateSlave(slave->id);
     }
 
@@ -4448,6 +4938,17 @@ void Master::reregisterSlave(
     return;
   }
 
+  // An abbreviated re-registration lacks what is needed to (re)admit
+  // the slave, which this master doesn't know (anymore). The slave
+  // retries with a complete one.
+  if (message.has_master_id()) {
+    LOG(INFO)
+      << "Ignoring abbreviated re-registration of unknown slave "
+      << slaveInfo.id() << " at " << from << " ("
+      << slaveInfo.hostname() << ")";
+    return;
+  }
+
   // Ensure we don't remove the slave for not re-registering after
   // we've recovered it from the registry.
   slaves.recovered.erase(slaveInfo.id());
@@ -4462,6 +4963,22 @@ void Master::reregisterSlave(
     return;
   }
 
+  // Limit the number of readmissions in progress, so that the master
+  // (and the registrar) are not flooded when all the slaves come back
+  // after a failover. The slave is still expected to re-register (it
+  // is no longer in 'slaves.recovered', hence it won't be removed for
+  // not re-registering), it retries with its registration backoff.
+  if (flags.max_reregistering_slaves.isSome() &&
+      slaves.reregistering.size() >= flags.max_reregistering_slaves.get()) {
+    LOG(INFO)
+      << "Deferring re-registration of slave " << slaveInfo.id() << " at "
+      << from << " (" << slaveInfo.hostname() << ") since "
+      << slaves.reregistering.size() << " slaves are already re-registering";
+
+    ++metrics->slave_reregistrations_deferred;
+    return;
+  }
+
   LOG(INFO) << "Re-registering slave " << slaveInfo.id() << " at " << from
             << " (" << slaveInfo.hostname() << ")";
 
@@ -4475,11 +4992,11 @@ void Master::reregisterSlave(
                  &Self::_reregisterSlave,
                  slaveInfo,
                  from,
-                 checkpointedResources,
-                 executorInfos,
-                 tasks,
-                 completedFrameworks,
-                 version,
+                 google::protobuf::convert(message.checkpointed_resources()),
+                 google::protobuf::convert(message.executor_infos()),
+                 google::protobuf::convert(message.tasks()),
+                 google::protobuf::convert(message.completed_frameworks()),
+                 message.version(),
                  lambda::_1));
 }
 
@@ -4529,6 +5046,7 @@ void Master::_reregisterSlave(
         tasks);
 
     slave->reregisteredTime = Clock::now();
+    slave->revision++;
 
     ++metrics->slave_reregistrations;
 
@@ -4644,6 +5162,36 @@ void Master::updateSlave(
   LOG(INFO) << "Received update of slave " << *slave << " with total"
             << " oversubscribed resources " <<  oversubscribedResources;
 
+  // The update is applied once the messages which are already queued
+  // have been processed, so that the updates of a slave which arrive
+  // in a burst (e.g., after a network partition healed) result in a
+  // single rescinding of the revocable offers and update of the
+  // allocator, with the latest estimate.
+  if (!oversubscribedUpdates.contains(slaveId)) {
+    dispatch(self(), &Self::_updateSlave, slaveId);
+  }
+
+  oversubscribedUpdates[slaveId] = oversubscribedResources;
+}
+
+
+void Master::_updateSlave(const SlaveID& slaveId)
+{
+  Option<Resources> oversubscribedResources =
+    oversubscribedUpdates.get(slaveId);
+
+  if (oversubscribedResources.isNone()) {
+    return;
+  }
+
+  oversubscribedUpdates.erase(slaveId);
+
+  // The slave might have been removed in the meantime.
+  Slave* slave = slaves.registered.get(slaveId);
+  if (slave == NULL) {
+    return;
+  }
+
   // First, rescind any outstanding offers with revocable resources.
   // NOTE: Need a copy of offers because the offers are removed inside the loop.
   foreach (Offer* offer, utils::copy(slave->offers)) {
@@ -4663,11 +5211,12 @@ void Master::updateSlave(
   // NOTE: We don't need to rescind inverse offers here as they are unrelated to
   // oversubscription.
 
-  slave->totalResources =
-    slave->totalResources.nonRevocable() + oversubscribedResources.revocable();
+  slave->totalResources = slave->totalResources.nonRevocable() +
+    oversubscribedResources.get().revocable();
+  slave->revision++;
 
   // Now, update the allocator with the new estimate.
-  allocator->updateSlave(slaveId, oversubscribedResources);
+  allocator->updateSlave(slaveId, oversubscribedResources.get());
 }
 
 
@@ -4675,15 +5224,26 @@ void Master::updateUnavailability(
     const MachineID& machineId,
     const Option<Unavailability>& unavailability)
 {
+  MachineInfo* info = &machines[machineId].info;
+
+  // Updating the unavailability rescinds the offers and inverse offers
+  // of the slaves on the machine and has the allocator re-evaluate
+  // them, hence this is only done if the unavailability has actually
+  // changed (e.g., not for the machines of a schedule that were not
+  // touched by an update of the schedule).
+  if (info->has_unavailability() == unavailability.isSome() &&
+      (unavailability.isNone() ||
+       info->unavailability().SerializeAsString() ==
+         unavailability.get().SerializeAsString())) {
+    return;
+  }
+
   if (unavailability.isSome()) {
-    machines[machineId].info.mutable_unavailability()->CopyFrom(
-        unavailability.get());
+    info->mutable_unavailability()->CopyFrom(unavailability.get());
   } else {
-    machines[machineId].info.clear_unavailability();
+    info->clear_unavailability();
   }
 
-  // TODO(jmlvanre): Only update allocator and rescind offers if the
-  // unavailability has actually changed.
   if (machines.contains(machineId)) {
     // For every slave on this machine, update the allocator.
     foreach (const SlaveID& slaveId, machines[machineId].slaves) {
@@ -4821,6 +5381,16 @@ void Master::statusUpdate(StatusUpdate update, const UPID& pid)
 }
 
 
+void Master::statusUpdates(
+    const UPID& from,
+    const StatusUpdatesMessage& message)
+{
+  foreach (const StatusUpdateMessage& update, message.updates()) {
+    statusUpdate(update.update(), update.pid());
+  }
+}
+
+
 void Master::forward(
     const StatusUpdate& update,
     const UPID& acknowledgee,
@@ -4944,7 +5514,7 @@ void Master::shutdown(
 void Master::shutdownSlave(const SlaveID& slaveId, const string& message)
 {
   if (!slaves.registered.contains(slaveId)) {
-    // Possible when the SlaveObserver dispatched to shutdown a slave,
+    // Possible when the SlaveHealthChecker dispatched to shutdown a slave,
     // but exited() was already called for this slave.
     LOG(WARNING) << "Unable to shutdown unknown slave " << slaveId;
     return;
@@ -4983,7 +5553,16 @@ void Master::reconcile(
     statuses.push_back(status);
   }
 
-  _reconcileTasks(framework, statuses);
+  // NOTE: 'since' is validated along with the call.
+  Option<Time> since = None();
+  if (reconcile.has_since()) {
+    Try<Time> time = Time::create(reconcile.since());
+    CHECK_SOME(time);
+
+    since = time.get();
+  }
+
+  _reconcileTasks(framework, statuses, since);
 }
 
 
@@ -5012,7 +5591,8 @@ void Master::reconcileTasks(
 
 void Master::_reconcileTasks(
     Framework* framework,
-    const vector<TaskStatus>& statuses)
+    const vector<TaskStatus>& statuses,
+    const Option<Time>& since)
 {
   CHECK_NOTNULL(framework);
 
@@ -5020,14 +5600,42 @@ void Master::_reconcileTasks(
 
   if (statuses.empty()) {
     // Implicit reconciliation.
-    LOG(INFO) << "Performing implicit task state reconciliation"
-                 " for framework " << *framework;
+    vector<const TaskInfo*> pendingTasks;
+    vector<Task*> tasks;
+
+    if (since.isSome()) {
+      // Only the tasks which changed since the given time, from the
+      // change log of the framework.
+      foreach (const TaskID& taskId, framework->changedTasks(since.get())) {
+        if (framework->pendingTasks.contains(taskId)) {
+          pendingTasks.push_back(&framework->pendingTasks.at(taskId));
+        } else if (framework->getTask(taskId) != NULL) {
+          tasks.push_back(framework->getTask(taskId));
+        }
+      }
 
-    foreachvalue (const TaskInfo& task, framework->pendingTasks) {
+      LOG(INFO) << "Performing implicit task state reconciliation of "
+                << (pendingTasks.size() + tasks.size()) << " tasks changed"
+                << " since " << since.get() << " for framework "
+                << *framework;
+    } else {
+      foreachvalue (const TaskInfo& task, framework->pendingTasks) {
+        pendingTasks.push_back(&task);
+      }
+
+      foreachvalue (Task* task, framework->tasks) {
+        tasks.push_back(task);
+      }
+
+      LOG(INFO) << "Performing implicit task state reconciliation"
+                   " for framework " << *framework;
+    }
+
+    foreach (const TaskInfo* task, pendingTasks) {
       const StatusUpdate& update = protobuf::createStatusUpdate(
           framework->id(),
-          task.slave_id(),
-          task.task_id(),
+          task->slave_id(),
+          task->task_id(),
           TASK_STAGING,
           TaskStatus::SOURCE_MASTER,
           None(),
@@ -5046,7 +5654,7 @@ void Master::_reconcileTasks(
       framework->send(message);
     }
 
-    foreachvalue (Task* task, framework->tasks) {
+    foreach (Task* task, tasks) {
       const TaskState& state = task->has_status_update_state()
           ? task->status_update_state()
           : task->state();
@@ -5224,6 +5832,8 @@ void Master::offer(const FrameworkID& frameworkId,
 
   // Create an offer for each slave and add it to the message.
   ResourceOffersMessage message;
+  message.mutable_offers()->Reserve(resources.size());
+  message.mutable_pids()->Reserve(resources.size());
 
   Framework* framework = CHECK_NOTNULL(frameworks.registered[frameworkId]);
   foreachpair (const SlaveID& slaveId, const Resources& offered, resources) {
@@ -5278,22 +5888,29 @@ void Master::offer(const FrameworkID& frameworkId,
     // separate offers, so that rescinding offers with revocable
     // resources does not affect offers with regular resources.
 
-    // TODO(bmahler): Set "https" if only "https" is supported.
-    mesos::URL url;
-    url.set_scheme("http");
-    url.mutable_address()->set_hostname(slave->info.hostname());
-    url.mutable_address()->set_ip(stringify(slave->pid.address.ip));
-    url.mutable_address()->set_port(slave->pid.address.port);
-    url.set_path("/" + slave->pid.id);
+    if (slave->offerTemplate.get() == NULL) {
+      // TODO(bmahler): Set "https" if only "https" is supported.
+      mesos::URL url;
+      url.set_scheme("http");
+      url.mutable_address()->set_hostname(slave->info.hostname());
+      url.mutable_address()->set_ip(stringify(slave->pid.address.ip));
+      url.mutable_address()->set_port(slave->pid.address.port);
+      url.set_path("/" + slave->pid.id);
+
+      Offer* offerTemplate = new Offer();
+      offerTemplate->mutable_slave_id()->MergeFrom(slave->id);
+      offerTemplate->set_hostname(slave->info.hostname());
+      offerTemplate->mutable_url()->MergeFrom(url);
+      offerTemplate->mutable_attributes()->MergeFrom(
+          slave->info.attributes());
+
+      slave->offerTemplate.reset(offerTemplate);
+    }
 
-    Offer* offer = new Offer();
+    Offer* offer = new Offer(*slave->offerTemplate);
     offer->mutable_id()->MergeFrom(newOfferId());
     offer->mutable_framework_id()->MergeFrom(framework->id());
-    offer->mutable_slave_id()->MergeFrom(slave->id);
-    offer->set_hostname(slave->info.hostname());
-    offer->mutable_url()->MergeFrom(url);
     offer->mutable_resources()->MergeFrom(offered);
-    offer->mutable_attributes()->MergeFrom(slave->info.attributes());
 
     // Add all framework's executors running on this slave.
     if (slave->executors.contains(framework->id())) {
@@ -5319,27 +5936,31 @@ void Master::offer(const FrameworkID& frameworkId,
 
     if (flags.offer_timeout.isSome()) {
       // Rescind the offer after the timeout elapses.
-      offerTimers[offer->id()] =
-        delay(flags.offer_timeout.get(),
-              self(),
-              &Self::offerTimeout,
-              offer->id());
+      offerExpiries.push_back(
+          std::make_pair(Clock::now() + flags.offer_timeout.get(),
+                         offer->id()));
+
+      if (offerTimer.isNone()) {
+        offerTimer = delay(flags.offer_timeout.get(),
+                           self(),
+                           &Self::expireOffers);
+      }
     }
 
+    // Add the offer *AND* the corresponding slave's PID.
+    //
     // TODO(jieyu): For now, we strip 'ephemeral_ports' resource from
     // offers so that frameworks do not see this resource. This is a
     // short term workaround. Revisit this once we resolve MESOS-1654.
-    Offer offer_ = *offer;
-    offer_.clear_resources();
+    Offer* offer_ = message.add_offers();
+    offer_->CopyFrom(*offer);
 
-    foreach (const Resource& resource, offered) {
-      if (resource.name() != "ephemeral_ports") {
-        offer_.add_resources()->CopyFrom(resource);
+    for (int i = offer_->resources_size() - 1; i >= 0; i--) {
+      if (offer_->resources(i).name() == "ephemeral_ports") {
+        offer_->mutable_resources()->DeleteSubrange(i, 1);
       }
     }
 
-    // Add the offer *AND* the corresponding slave's PID.
-    message.add_offers()->MergeFrom(offer_);
     message.add_pids(slave->pid);
   }
 
@@ -5350,6 +5971,33 @@ void Master::offer(const FrameworkID& frameworkId,
   LOG(INFO) << "Sending " << message.offers().size()
             << " offers to framework " << *framework;
 
+  // Compress the offers if the framework asked for it. This is done
+  // once per message, before it is serialized for the (driver or
+  // HTTP) connection of the framework.
+  foreach (const FrameworkInfo::Capability& capability,
+           framework->info.capabilities()) {
+    if (capability.type() != FrameworkInfo::Capability::COMPRESSED_OFFERS) {
+      continue;
+    }
+
+    ResourceOffersMessage offers;
+    offers.mutable_offers()->Swap(message.mutable_offers());
+
+    Try<string> compressed = gzip::compress(
+        offers.SerializeAsString(), Z_BEST_SPEED);
+
+    if (compressed.isError()) {
+      LOG(WARNING) << "Failed to compress offers to framework "
+                   << *framework << ": " << compressed.error();
+
+      message.mutable_offers()->Swap(offers.mutable_offers());
+    } else {
+      message.set_compressed_offers(compressed.get());
+    }
+
+    break;
+  }
+
   framework->send(message);
 }
 
@@ -5518,6 +6166,19 @@ void Master::authenticate(const UPID& from, const UPID& pid)
     return;
   }
 
+  // Limit the number of authentications in progress, so that the
+  // master is not flooded with SASL handshakes when all the frameworks
+  // and slaves come back after a failover. They retry once their
+  // authentication times out.
+  if (flags.max_concurrent_authentications.isSome() &&
+      authenticating.size() >= flags.max_concurrent_authentications.get()) {
+    LOG(INFO) << "Deferring authentication of " << pid << " since "
+              << authenticating.size() << " authentications are in progress";
+
+    ++metrics->authentications_deferred;
+    return;
+  }
+
   LOG(INFO) << "Authenticating " << pid;
 
   // Start authentication.
@@ -5786,6 +6447,12 @@ void Master::addFramework(Framework* framework)
       }
     }
   }
+
+  metrics->framework_tasks.put(
+      framework->id(),
+      Owned<Metrics::Tasks>(new Metrics::Tasks(*this, framework->id())));
+
+  http.frameworkAdded(*framework);
 }
 
 
@@ -5902,6 +6569,7 @@ void Master::_failoverFramework(Framework* framework)
   // the allocator has the correct view of the framework's share.
   if (!framework->active) {
     framework->active = true;
+    framework->revision++;
     allocator->activateFramework(framework->id());
   }
 
@@ -5948,6 +6616,7 @@ void Master::removeFramework(Framework* framework)
 
   // Remove the pending tasks from the framework.
   framework->pendingTasks.clear();
+  framework->revision++;
 
   // Remove pointers to the framework's tasks in slaves.
   foreachvalue (Task* task, utils::copy(framework->tasks)) {
@@ -5987,11 +6656,8 @@ void Master::removeFramework(Framework* framework)
 
   // Remove the framework's offers (if they weren't removed before).
   foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(),
-        offer->slave_id(),
-        offer->resources(),
-        None());
+    recoverResources(
+        offer->framework_id(), offer->slave_id(), offer->resources());
 
     removeOffer(offer);
   }
@@ -6021,6 +6687,10 @@ void Master::removeFramework(Framework* framework)
     }
   }
 
+  // The resources of the framework have to be recovered before the
+  // framework is removed from the allocator below.
+  flushRecoveries();
+
   // TODO(benh): Similar code between removeFramework and
   // failoverFramework needs to be shared!
 
@@ -6029,6 +6699,7 @@ void Master::removeFramework(Framework* framework)
   // TODO(anand): For http frameworks, close the connection.
 
   framework->unregisteredTime = Clock::now();
+  framework->revision++;
 
   const string& role = framework->info.role();
   CHECK(activeRoles.contains(role))
@@ -6060,15 +6731,135 @@ void Master::removeFramework(Framework* framework)
     }
   }
 
+  metrics->framework_tasks.erase(framework->id());
+
   // Remove the framework.
   frameworks.registered.erase(framework->id());
   allocator->removeFramework(framework->id());
 
+  http.frameworkRemoved(*framework);
+
+  // The completed tasks of the completed framework which is evicted
+  // to make room (or of this one, if none are kept) are evicted along.
+  if (frameworks.completed.capacity() == 0) {
+    foreach (const shared_ptr<const CompletedTask>& task,
+             framework->completedTasks) {
+      spill(*task);
+    }
+  } else if (frameworks.completed.full()) {
+    foreach (const shared_ptr<const CompletedTask>& task,
+             frameworks.completed.front()->completedTasks) {
+      spill(*task);
+    }
+  }
+
   // The completedFramework buffer now owns the framework pointer.
   frameworks.completed.push_back(shared_ptr<Framework>(framework));
 }
 
 
+void Master::spill(const CompletedTask& task)
+{
+  if (taskHistory != NULL) {
+    taskHistory->append(task.task());
+  }
+}
+
+
+// Returns the cpus, mem (in MB) and disk (in MB) of the resources, as
+// the columns of an exported table.
+static vector<string> columns(const Resources& resources)
+{
+  return {
+    stringify(resources.cpus().getOrElse(0.0)),
+    stringify(resources.mem().getOrElse(Bytes(0)).megabytes()),
+    stringify(resources.disk().getOrElse(Bytes(0)).megabytes())};
+}
+
+
+void Master::exportState()
+{
+  CHECK_NOTNULL(stateExporter);
+
+  // Only the leading master knows about the agents and the tasks.
+  if (elected()) {
+    hashmap<string, StateExporter::Table> tables;
+
+    StateExporter::Table& agents = tables["agents"];
+    agents.columns = {
+      "agent_id", "hostname", "active", "registered_time",
+      "cpus", "mem", "disk",
+      "used_cpus", "used_mem", "used_disk",
+      "offered_cpus", "offered_mem", "offered_disk"};
+
+    StateExporter::Table& tasks = tables["tasks"];
+    tasks.columns = {
+      "framework_id", "task_id", "name", "agent_id", "state",
+      "cpus", "mem", "disk"};
+
+    StateExporter::Table& allocations = tables["allocations"];
+    allocations.columns = {
+      "framework_id", "agent_id", "role", "cpus", "mem", "disk"};
+
+    foreachvalue (Slave* slave, slaves.registered) {
+      vector<string> agent = {
+        slave->id.value(),
+        slave->info.hostname(),
+        stringify(slave->active),
+        stringify(slave->registeredTime.secs())};
+
+      const vector<Resources> resources = {
+        slave->totalResources,
+        Resources::sum(slave->usedResources),
+        slave->offeredResources};
+
+      foreach (const Resources& _resources, resources) {
+        const vector<string> values = columns(_resources);
+        agent.insert(agent.end(), values.begin(), values.end());
+      }
+
+      agents.rows.push_back(agent);
+
+      foreachpair (const FrameworkID& frameworkId,
+                   const Resources& resources,
+                   slave->usedResources) {
+        Framework* framework = getFramework(frameworkId);
+
+        vector<string> allocation = {
+          frameworkId.value(),
+          slave->id.value(),
+          framework != NULL ? framework->info.role() : ""};
+
+        const vector<string> values = columns(resources);
+        allocation.insert(allocation.end(), values.begin(), values.end());
+
+        allocations.rows.push_back(allocation);
+      }
+
+      foreachvalue (const auto& frameworkTasks, slave->tasks) {
+        foreachvalue (Task* task, frameworkTasks) {
+          vector<string> row = {
+            task->framework_id().value(),
+            task->task_id().value(),
+            task->name(),
+            task->slave_id().value(),
+            TaskState_Name(task->state())};
+
+          const vector<string> values = columns(task->resources());
+          row.insert(row.end(), values.begin(), values.end());
+
+          tasks.rows.push_back(row);
+        }
+      }
+    }
+
+    stateExporter->write(tables);
+  }
+
+  delay(flags.state_export_interval, self(), &Master::exportState);
+}
+
+
 void Master::removeFramework(Slave* slave, Framework* framework)
 {
   CHECK_NOTNULL(slave);
@@ -6124,24 +6915,26 @@ void Master::addSlave(
   slaves.removed.erase(slave->id);
   slaves.registered.put(slave);
 
+  if (slave->connected && slave->active) {
+    trackCapacity(slave);
+  }
+
+  metrics->slave_tasks.put(
+      slave->id,
+      Owned<Metrics::Tasks>(new Metrics::Tasks(*this, slave->id)));
+
   link(slave->pid);
 
   // Map the slave to the machine it is running on.
   CHECK(!machines[slave->machineId].slaves.contains(slave->id));
   machines[slave->machineId].slaves.insert(slave->id);
 
-  // Set up an observer for the slave.
-  slave->observer = new SlaveObserver(
-      slave->pid,
-      slave->info,
-      slave->id,
-      self(),
-      slaves.limiter,
-      metrics,
-      flags.slave_ping_timeout,
-      flags.max_slave_ping_timeouts);
-
-  spawn(slave->observer);
+  // Start health checking the slave.
+  dispatch(healthChecker,
+           &SlaveHealthChecker::add,
+           slave->id,
+           slave->pid,
+           slave->heard);
 
   // Add the slave's executors to the frameworks.
   foreachkey (const FrameworkID& frameworkId, slave->executors) {
@@ -6212,6 +7005,8 @@ void Master::addSlave(
       unavailability,
       slave->totalResources,
       slave->usedResources);
+
+  http.slaveAdded(*slave);
 }
 
 
@@ -6270,13 +7065,16 @@ void Master::removeSlave(
   foreach (Offer* offer, utils::copy(slave->offers)) {
     // TODO(vinod): We don't need to call 'Allocator::recoverResources'
     // once MESOS-621 is fixed.
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
+    recoverResources(offer->framework_id(), slave->id, offer->resources());
 
     // Remove and rescind offers.
     removeOffer(offer, true); // Rescind!
   }
 
+  // Recover the resources of the slave right away, rather than after
+  // a slave with the same ID might have been added again.
+  flushRecoveries();
+
   // Remove inverse offers because sending them for a slave that is
   // gone doesn't make sense.
   foreach (InverseOffer* inverseOffer, utils::copy(slave->inverseOffers)) {
@@ -6286,10 +7084,17 @@ void Master::removeSlave(
     removeInverseOffer(inverseOffer, true); // Rescind!
   }
 
+  http.slaveRemoved(*slave);
+
+  if (slave->connected && slave->active) {
+    untrackCapacity(slave);
+  }
+
   // Mark the slave as being removed.
   slaves.removing.insert(slave->id);
   slaves.registered.remove(slave);
   slaves.removed.put(slave->id, Nothing());
+  metrics->slave_tasks.erase(slave->id);
   authenticated.erase(slave->pid);
 
   // Remove the slave from the `machines` mapping.
@@ -6297,10 +7102,8 @@ void Master::removeSlave(
   CHECK(machines[slave->machineId].slaves.contains(slave->id));
   machines[slave->machineId].slaves.erase(slave->id);
 
-  // Kill the slave observer.
-  terminate(slave->observer);
-  wait(slave->observer);
-  delete slave->observer;
+  // Stop health checking the slave.
+  dispatch(healthChecker, &SlaveHealthChecker::remove, slave->id);
 
   // TODO(benh): unlink(slave->pid);
 
@@ -6395,6 +7198,8 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     latestState = update.latest_state();
   }
 
+  const TaskState previous = task->state();
+
   // Set 'terminated' to true if this is the first time the task
   // transitioned to terminal state. Also set the latest state.
   bool terminated;
@@ -6442,18 +7247,42 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
   // MESOS-1746.
   task->mutable_statuses(task->statuses_size() - 1)->clear_data();
 
+  if (task->state() != previous) {
+    Slave* slave = slaves.registered.get(task->slave_id());
+    if (slave != NULL &&
+        slave->getTask(task->framework_id(), task->task_id()) == task) {
+      slave->taskStateChanged(task, previous);
+    }
+  }
+
+  Framework* framework = getFramework(task->framework_id());
+  if (framework != NULL) {
+    if (task->state() != previous &&
+        framework->getTask(task->task_id()) == task) {
+      framework->taskStateChanged(task, previous);
+    }
+
+    framework->taskChanged(task->task_id());
+    framework->revision++;
+  } else {
+    // The tasks of unknown frameworks are exposed as orphan tasks,
+    // which are part of the snapshot of the slave.
+    Slave* slave = slaves.registered.get(task->slave_id());
+    if (slave != NULL) {
+      slave->revision++;
+    }
+  }
+
   LOG(INFO) << "Updating the state of task " << task->task_id()
             << " of framework " << task->framework_id()
             << " (latest state: " << task->state()
             << ", status update state: " << status.state() << ")";
 
+  http.taskUpdated(*task);
+
   // Once the task becomes terminal, we recover the resources.
   if (terminated) {
-    allocator->recoverResources(
-        task->framework_id(),
-        task->slave_id(),
-        task->resources(),
-        None());
+    recoverResources(task->framework_id(), task->slave_id(), task->resources());
 
     // The slave owns the Task object and cannot be NULL.
     Slave* slave = slaves.registered.get(task->slave_id());
@@ -6461,7 +7290,6 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 
     slave->taskTerminated(task);
 
-    Framework* framework = getFramework(task->framework_id());
     if (framework != NULL) {
       framework->taskTerminated(task);
     }
@@ -6502,11 +7330,7 @@ void Master::removeTask(Task* task)
 
     // If the task is not terminal, then the resources have
     // not yet been recovered.
-    allocator->recoverResources(
-        task->framework_id(),
-        task->slave_id(),
-        task->resources(),
-        None());
+    recoverResources(task->framework_id(), task->slave_id(), task->resources());
   } else {
     LOG(INFO) << "Removing task " << task->task_id()
               << " with resources " << task->resources()
@@ -6541,8 +7365,7 @@ void Master::removeExecutor(
             << "' with resources " << executor.resources()
             << " of framework " << frameworkId << " on slave " << *slave;
 
-  allocator->recoverResources(
-    frameworkId, slave->id, executor.resources(), None());
+  recoverResources(frameworkId, slave->id, executor.resources());
 
   Framework* framework = getFramework(frameworkId);
   if (framework != NULL) { // The framework might not be re-registered yet.
@@ -6553,6 +7376,37 @@ void Master::removeExecutor(
 }
 
 
+void Master::recoverResources(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  if (resources.empty()) {
+    return;
+  }
+
+  if (recoveries.empty()) {
+    dispatch(self(), &Master::flushRecoveries);
+  }
+
+  recoveries[slaveId][frameworkId] += resources;
+}
+
+
+void Master::flushRecoveries()
+{
+  // The recoveries might have been flushed already by the removal of
+  // a framework or a slave.
+  if (recoveries.empty()) {
+    return;
+  }
+
+  allocator->batchRecoverResources(recoveries);
+
+  recoveries.clear();
+}
+
+
 void Master::apply(
     Framework* framework,
     Slave* slave,
@@ -6592,13 +7446,28 @@ void Master::_apply(Slave* slave, const Offer::Operation& operation) {
 }
 
 
-void Master::offerTimeout(const OfferID& offerId)
+void Master::expireOffers()
 {
-  Offer* offer = getOffer(offerId);
-  if (offer != NULL) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
-    removeOffer(offer, true);
+  offerTimer = None();
+
+  const Time now = Clock::now();
+
+  while (!offerExpiries.empty() && offerExpiries.front().first <= now) {
+    const OfferID offerId = offerExpiries.front().second;
+    offerExpiries.pop_front();
+
+    Offer* offer = getOffer(offerId);
+    if (offer != NULL) {
+      allocator->recoverResources(
+          offer->framework_id(), offer->slave_id(), offer->resources(), None());
+      removeOffer(offer, true);
+    }
+  }
+
+  if (!offerExpiries.empty()) {
+    offerTimer = delay(offerExpiries.front().first - now,
+                       self(),
+                       &Self::expireOffers);
   }
 }
 
@@ -6630,13 +7499,6 @@ void Master::removeOffer(Offer* offer, bool rescind)
     framework->send(message);
   }
 
-  // Remove and cancel offer removal timers. Canceling the Timers is
-  // only done to avoid having too many active Timers in libprocess.
-  if (offerTimers.contains(offer->id())) {
-    Clock::cancel(offerTimers[offer->id()]);
-    offerTimers.erase(offer->id());
-  }
-
   // Delete it.
   offers.erase(offer->id());
   delete offer;
@@ -6741,8 +7603,10 @@ FrameworkID Master::newFrameworkId()
 
 OfferID Master::newOfferId()
 {
+  // NOTE: Since every offer needs an ID, it is not stringified with
+  // 'stringify', which goes through a string stream.
   OfferID offerId;
-  offerId.set_value(info_.id() + "-O" + stringify(nextOfferId++));
+  offerId.set_value(info_.id() + "-O" + std::to_string(nextOfferId++));
   return offerId;
 }
 
@@ -6755,6 +7619,91 @@ SlaveID Master::newSlaveId()
 }
 
 
+std::shared_ptr<const Snapshot> Master::snapshot()
+{
+  std::shared_ptr<Snapshot> snapshot(new Snapshot());
+
+  snapshot->info = info_;
+  snapshot->pid = self();
+  snapshot->leader = leader;
+  snapshot->startTime = startTime;
+  snapshot->electedTime = electedTime;
+
+  // Copy the slaves and frameworks that changed since the last
+  // snapshot, all others are shared with the last snapshot.
+  hashmap<FrameworkID, std::shared_ptr<const Framework>> completed;
+
+  if (published) {
+    foreach (const std::shared_ptr<const Framework>& framework,
+             published->completed) {
+      completed[framework->id()] = framework;
+    }
+  }
+
+  foreachvalue (const Slave* slave, slaves.registered) {
+    std::shared_ptr<const Slave> copy;
+    if (published && published->slaves.contains(slave->id)) {
+      copy = published->slaves.at(slave->id);
+    }
+
+    if (!copy || copy->revision != slave->revision) {
+      copy = slave->snapshot();
+    }
+
+    snapshot->slaves[slave->id] = copy;
+  }
+
+  foreachvalue (const Framework* framework, frameworks.registered) {
+    std::shared_ptr<const Framework> copy;
+    if (published && published->frameworks.contains(framework->id())) {
+      copy = published->frameworks.at(framework->id());
+    }
+
+    if (!copy || copy->revision != framework->revision) {
+      copy = framework->snapshot();
+    }
+
+    snapshot->frameworks[framework->id()] = copy;
+  }
+
+  foreach (const std::shared_ptr<Framework>& framework, frameworks.completed) {
+    std::shared_ptr<const Framework> copy;
+    if (completed.contains(framework->id())) {
+      copy = completed.at(framework->id());
+    }
+
+    if (!copy || copy->revision != framework->revision) {
+      copy = framework->snapshot();
+    }
+
+    snapshot->completed.push_back(copy);
+  }
+
+  published = snapshot;
+
+  return published;
+}
+
+
+void Master::publish(const string& event)
+{
+  auto it = subscribers.begin();
+  while (it != subscribers.end()) {
+    if (it->second.send(event)) {
+      ++it;
+    } else {
+      it = subscribers.erase(it);
+    }
+  }
+}
+
+
+void Master::unsubscribe(const UUID& id)
+{
+  subscribers.erase(id);
+}
+
+
 double Master::_slaves_active()
 {
   double count = 0.0;
@@ -6861,14 +7810,7 @@ double Master::_tasks_staging()
   }
 
   foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_STAGING) {
-          count++;
-        }
-      }
-    }
+    count += slave->taskStates.get(TASK_STAGING).getOrElse(0);
   }
 
   return count;
@@ -6880,14 +7822,7 @@ double Master::_tasks_starting()
   double count = 0.0;
 
   foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_STARTING) {
-          count++;
-        }
-      }
-    }
+    count += slave->taskStates.get(TASK_STARTING).getOrElse(0);
   }
 
   return count;
@@ -6899,20 +7834,49 @@ double Master::_tasks_running()
   double count = 0.0;
 
   foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_RUNNING) {
-          count++;
-        }
-      }
-    }
+    count += slave->taskStates.get(TASK_RUNNING).getOrElse(0);
+  }
+
+  return count;
+}
+
+
+double Master::_framework_tasks(
+    const FrameworkID& frameworkId,
+    TaskState state)
+{
+  Framework* framework = getFramework(frameworkId);
+  if (framework == NULL) {
+    return 0;
+  }
+
+  double count = 0.0;
+
+  // Add the tasks pending validation / authorization.
+  if (state == TASK_STAGING) {
+    count += framework->pendingTasks.size();
+  }
+
+  typedef hashmap<TaskState, size_t> StateMap;
+  foreachvalue (const StateMap& states, framework->taskStates) {
+    count += states.get(state).getOrElse(0);
   }
 
   return count;
 }
 
 
+double Master::_slave_tasks(const SlaveID& slaveId, TaskState state)
+{
+  Slave* slave = slaves.registered.get(slaveId);
+  if (slave == NULL) {
+    return 0;
+  }
+
+  return slave->taskStates.get(state).getOrElse(0);
+}
+
+
 double Master::_resources_total(const string& name)
 {
   double total = 0.0;
@@ -19,7 +19,10 @@
 
 #include <stdint.h>
 
+#include <atomic>
+#include <deque>
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -45,17 +48,21 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
+#include <process/time.hpp>
 #include <process/timer.hpp>
 
 #include <process/metrics/counter.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/cache.hpp>
 #include <stout/foreach.hpp>
+#include <stout/flathashmap.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/option.hpp>
 #include <stout/recordio.hpp>
+#include <stout/uuid.hpp>
 
 #include "common/http.hpp"
 #include "common/protobuf_utils.hpp"
@@ -98,7 +105,11 @@ class WhitelistWatcher;
 namespace master {
 
 class Repairer;
-class SlaveObserver;
+class SlaveHealthChecker;
+class StateExporter;
+class TaskHistory;
+
+class CompletedTask;
 
 struct BoundedRateLimiter;
 struct Framework;
@@ -127,7 +138,8 @@ struct Slave
       connected(true),
       active(true),
       checkpointedResources(_checkpointedResources),
-      observer(NULL)
+      heard(new std::atomic_bool(false)),
+      revision(0)
   {
     CHECK(_info.has_id());
 
@@ -145,7 +157,16 @@ struct Slave
     }
 
     foreach (const Task& task, tasks) {
-      addTask(new Task(task));
+      Task* t = new Task(task);
+
+      // Like for the status updates, the master does not keep the
+      // data of the statuses of the re-registered tasks (see
+      // 'Master::updateTask').
+      for (int i = 0; i < t->statuses_size(); i++) {
+        t->mutable_statuses(i)->clear_data();
+      }
+
+      addTask(t);
     }
   }
 
@@ -168,11 +189,14 @@ struct Slave
       << "Duplicate task " << taskId << " of framework " << frameworkId;
 
     tasks[frameworkId][taskId] = task;
+    taskStates[task->state()]++;
 
     if (!protobuf::isTerminalState(task->state())) {
       usedResources[frameworkId] += task->resources();
     }
 
+    revision++;
+
     LOG(INFO) << "Adding task " << taskId
               << " with resources " << task->resources()
               << " on slave " << id << " (" << info.hostname() << ")";
@@ -195,6 +219,26 @@ struct Slave
     if (!tasks.contains(frameworkId) && !executors.contains(frameworkId)) {
       usedResources.erase(frameworkId);
     }
+
+    revision++;
+  }
+
+  // Notification of a change of the state of a task, for the
+  // accounting of the tasks in each state.
+  void taskStateChanged(Task* task, const TaskState& previous)
+  {
+    const TaskID& taskId = task->task_id();
+    const FrameworkID& frameworkId = task->framework_id();
+
+    CHECK(tasks[frameworkId].contains(taskId))
+      << "Unknown task " << taskId << " of framework " << frameworkId;
+
+    CHECK(taskStates.contains(previous));
+    if (--taskStates[previous] == 0) {
+      taskStates.erase(previous);
+    }
+
+    taskStates[task->state()]++;
   }
 
   void removeTask(Task* task)
@@ -205,6 +249,11 @@ struct Slave
     CHECK(tasks[frameworkId].contains(taskId))
       << "Unknown task " << taskId << " of framework " << frameworkId;
 
+    CHECK(taskStates.contains(task->state()));
+    if (--taskStates[task->state()] == 0) {
+      taskStates.erase(task->state());
+    }
+
     if (!protobuf::isTerminalState(task->state())) {
       usedResources[frameworkId] -= task->resources();
       if (!tasks.contains(frameworkId) && !executors.contains(frameworkId)) {
@@ -218,6 +267,8 @@ struct Slave
     }
 
     killedTasks.remove(frameworkId, taskId);
+
+    revision++;
   }
 
   void addOffer(Offer* offer)
@@ -226,6 +277,8 @@ struct Slave
 
     offers.insert(offer);
     offeredResources += offer->resources();
+
+    revision++;
   }
 
   void removeOffer(Offer* offer)
@@ -234,6 +287,8 @@ struct Slave
 
     offeredResources -= offer->resources();
     offers.erase(offer);
+
+    revision++;
   }
 
   void addInverseOffer(InverseOffer* inverseOffer)
@@ -268,6 +323,8 @@ struct Slave
 
     executors[frameworkId][executorInfo.executor_id()] = executorInfo;
     usedResources[frameworkId] += executorInfo.resources();
+
+    revision++;
   }
 
   void removeExecutor(const FrameworkID& frameworkId,
@@ -285,6 +342,8 @@ struct Slave
     if (executors[frameworkId].empty()) {
       executors.erase(frameworkId);
     }
+
+    revision++;
   }
 
   void apply(const Offer::Operation& operation)
@@ -294,6 +353,37 @@ struct Slave
 
     totalResources = resources.get();
     checkpointedResources = totalResources.filter(needCheckpointing);
+
+    revision++;
+  }
+
+  // Returns a copy of this slave, including copies of its tasks, that
+  // can be read by other processes (see 'Snapshot'). Offers are not
+  // part of the copy.
+  std::shared_ptr<const Slave> snapshot() const
+  {
+    typedef hashmap<TaskID, Task*> TaskMap;
+
+    Slave* slave = new Slave(*this);
+
+    slave->heard.reset();
+    slave->offers.clear();
+    slave->inverseOffers.clear();
+
+    foreachpair (const FrameworkID& frameworkId, const TaskMap& map, tasks) {
+      foreachpair (const TaskID& taskId, const Task* task, map) {
+        slave->tasks[frameworkId][taskId] = new Task(*task);
+      }
+    }
+
+    return std::shared_ptr<const Slave>(slave, [](Slave* slave) {
+      foreachvalue (const TaskMap& map, slave->tasks) {
+        foreachvalue (Task* task, map) {
+          delete task;
+        }
+      }
+      delete slave;
+    });
   }
 
   const SlaveID id;
@@ -330,6 +420,11 @@ struct Slave
   // This is used for reconciliation when the slave re-registers.
   multihashmap<FrameworkID, TaskID> killedTasks;
 
+  // The number of tasks present on this slave in each state, so that
+  // counting them (e.g., for the 'master/tasks_running' metric) does
+  // not need to look at all of the tasks.
+  hashmap<TaskState, size_t> taskStates;
+
   // Active offers on this slave.
   hashset<Offer*> offers;
 
@@ -351,10 +446,23 @@ struct Slave
   // includes revocable resources as well.
   Resources totalResources;
 
-  SlaveObserver* observer;
+  // Set whenever the master receives a message from the slave, which
+  // the health checker counts like a pong (see 'SlaveHealthChecker').
+  std::shared_ptr<std::atomic_bool> heard;
+
+  // Incremented whenever the state of this slave that is exposed via
+  // the read-only HTTP endpoints changes, which lets the master reuse
+  // the snapshots of unchanged slaves (see 'Master::snapshot').
+  uint64_t revision;
+
+  // The fields which are the same for all of the offers of this slave
+  // (its id, hostname, URL and attributes), built by 'Master::offer'
+  // on the first offer so they are copied as a whole into the next
+  // ones. Reset whenever the pid of the slave changes.
+  std::shared_ptr<const Offer> offerTemplate;
 
 private:
-  Slave(const Slave&);              // No copying.
+  Slave(const Slave&) = default;    // Only used by 'snapshot'.
   Slave& operator=(const Slave&); // No assigning.
 };
 
@@ -366,6 +474,134 @@ inline std::ostream& operator<<(std::ostream& stream, const Slave& slave)
 }
 
 
+// A consumer of the '/events' endpoint of the master, which is
+// streamed the changes to the state of the master as 'recordio'
+// encoded JSON events (see 'Master::Http::events').
+struct StateSubscriber
+{
+  explicit StateSubscriber(const process::http::Pipe::Writer& _writer)
+    : writer(_writer),
+      encoder([](const std::string& event) { return event; }) {}
+
+  bool send(const std::string& event)
+  {
+    return writer.write(encoder.encode(event));
+  }
+
+  process::http::Pipe::Writer writer;
+  ::recordio::Encoder<std::string> encoder;
+};
+
+
+// An immutable copy of the state of the master that is exposed by the
+// read-only HTTP endpoints. Slaves and frameworks that did not change
+// between two snapshots are shared by them (see 'Master::snapshot').
+struct Snapshot
+{
+  MasterInfo info;
+  process::UPID pid;
+  Option<MasterInfo> leader;
+  process::Time startTime;
+  Option<process::Time> electedTime;
+
+  hashmap<SlaveID, std::shared_ptr<const Slave>> slaves;
+  hashmap<FrameworkID, std::shared_ptr<const Framework>> frameworks;
+  std::vector<std::shared_ptr<const Framework>> completed;
+};
+
+
+// Serves the read-only HTTP endpoints of the master ('/state',
+// '/state-summary', '/frameworks', '/slaves' and '/tasks') from the
+// snapshots handed to it by the master, so that rendering (possibly
+// very large) responses does not hold up the master.
+class ReadOnlyHandler : public process::Process<ReadOnlyHandler>
+{
+public:
+  explicit ReadOnlyHandler(const Flags& _flags)
+    : ProcessBase(process::ID::generate("read-only-handler")),
+      flags(_flags) {}
+
+  virtual ~ReadOnlyHandler() {}
+
+  process::http::Response state(
+      const std::shared_ptr<const Snapshot>& snapshot,
+      const process::http::Request& request);
+
+  process::http::Response stateSummary(
+      const std::shared_ptr<const Snapshot>& snapshot,
+      const process::http::Request& request);
+
+  process::http::Response frameworks(
+      const std::shared_ptr<const Snapshot>& snapshot,
+      const process::http::Request& request);
+
+  process::http::Response slaves(
+      const std::shared_ptr<const Snapshot>& snapshot,
+      const process::http::Request& request);
+
+  // Also lists 'spilled', a task of the task history that was looked
+  // up for the request (see 'Master::Http::tasks').
+  process::http::Response tasks(
+      const std::shared_ptr<const Snapshot>& snapshot,
+      const process::http::Request& request,
+      const Option<Task>& spilled);
+
+private:
+  // The JSON of a slave or framework as last rendered by '/state',
+  // which is reused for as long as its snapshot stays the same.
+  template <typename T>
+  struct Fragment
+  {
+    Fragment() : object(NULL), revision(0) {}
+
+    const T* object;
+    uint64_t revision;
+    std::string json;
+  };
+
+  // Returns the JSON of 'object' for '/state', re-rendering it only
+  // if it changed since the last request. The fragments of removed
+  // objects are dropped by 'state'.
+  template <typename Key, typename T>
+  static const std::string& fragment(
+      const Key& key,
+      const T& object,
+      hashmap<Key, Fragment<T>>* fragments);
+
+  // The tasks (including the completed tasks) of a framework indexed
+  // by state and slave, so that a filtered '/tasks' query only visits
+  // the tasks that it might return.
+  struct TaskIndex
+  {
+    std::shared_ptr<const Framework> framework;
+
+    // The completed tasks of the framework, which are only parsed
+    // when the index is built. They are shared with the responses
+    // which refer to them, since those are written later on (see
+    // 'stream').
+    std::shared_ptr<std::deque<Task>> completed;
+
+    std::vector<const Task*> tasks;
+    std::map<TaskState, std::vector<const Task*>> states;
+    hashmap<SlaveID, std::vector<const Task*>> slaves;
+  };
+
+  // Returns the index of the tasks of 'framework', which is rebuilt
+  // whenever the master publishes a new snapshot of the framework.
+  const TaskIndex& index(const std::shared_ptr<const Framework>& framework);
+
+  const Flags flags;
+
+  // Fragments cached by '/state', see 'state'.
+  hashmap<SlaveID, Fragment<Slave>> slaveFragments;
+  hashmap<FrameworkID, Fragment<Framework>> frameworkFragments;
+  hashmap<FrameworkID, Fragment<Framework>> completedFragments;
+
+  // Task indexes used by '/tasks', see 'index'.
+  hashmap<FrameworkID, TaskIndex> indexes;
+};
+
+
 class Master : public ProtobufProcess<Master>
 {
 public:
@@ -454,12 +690,7 @@ public:
 
   void reregisterSlave(
       const process::UPID& from,
-      const SlaveInfo& slaveInfo,
-      const std::vector<Resource>& checkpointedResources,
-      const std::vector<ExecutorInfo>& executorInfos,
-      const std::vector<Task>& tasks,
-      const std::vector<Archive::Framework>& completedFrameworks,
-      const std::string& version);
+      const ReregisterSlaveMessage& message);
 
   void unregisterSlave(
       const process::UPID& from,
@@ -469,6 +700,10 @@ public:
       StatusUpdate update,
       const process::UPID& pid);
 
+  void statusUpdates(
+      const process::UPID& from,
+      const StatusUpdatesMessage& message);
+
   void reconcileTasks(
       const process::UPID& from,
       const FrameworkID& frameworkId,
@@ -485,6 +720,10 @@ public:
       const SlaveID& slaveId,
       const Resources& oversubscribedResources);
 
+  // Applies the latest of the (coalesced) oversubscribed resources
+  // updates of a slave, see 'updateSlave'.
+  void _updateSlave(const SlaveID& slaveId);
+
   void updateUnavailability(
       const MachineID& machineId,
       const Option<Unavailability>& unavailability);
@@ -561,6 +800,11 @@ protected:
   // 'defaultLimiter'.
   void throttled(
       const process::MessageEvent& event,
+      const Option<std::string>& principal,
+      const process::Time& received);
+
+  void throttled(
+      const process::ExitedEvent& event,
       const Option<std::string>& principal);
 
   // Continuations of visit().
@@ -604,9 +848,13 @@ protected:
 
   // Task reconciliation, split from the message handler
   // to allow re-use.
+  //
+  // If 'since' is set, implicit reconciliation only sends the latest
+  // state of the tasks that changed at or after that time.
   void _reconcileTasks(
       Framework* framework,
-      const std::vector<TaskStatus>& statuses);
+      const std::vector<TaskStatus>& statuses,
+      const Option<process::Time>& since = None());
 
   // Handles a known re-registering slave by reconciling the master's
   // view of the slave's tasks and executors.
@@ -636,6 +884,15 @@ protected:
   // executors and recover the resources.
   void removeFramework(Slave* slave, Framework* framework);
 
+  // Keeps a completed task which is evicted from memory in the task
+  // history, if there is one (see '--completed_tasks_dir').
+  void spill(const CompletedTask& task);
+
+  // Exports the agents, the active tasks and the allocations to the
+  // state exporter (see '--state_export_dir'), then reschedules
+  // itself after '--state_export_interval'.
+  void exportState();
+
   void disconnect(Framework* framework);
   void deactivate(Framework* framework);
 
@@ -786,6 +1043,18 @@ protected:
       const FrameworkID& frameworkId,
       const ExecutorID& executorId);
 
+  // Recovers the resources of a framework on a slave in the allocator.
+  // The resources are added up (see 'recoveries') and recovered with
+  // a single call to the allocator by 'flushRecoveries()', which is
+  // dispatched after the first recovery, so that the resources of
+  // the tasks which complete en masse are recovered together.
+  void recoverResources(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  void flushRecoveries();
+
   // Updates the allocator and updates the slave's resources by
   // applying the given operation. It also sends a
   // 'CheckpointResourcesMessage' to the slave with the updated
@@ -810,8 +1079,12 @@ protected:
       const process::UPID& acknowledgee,
       Framework* framework);
 
-  // Remove an offer after specified timeout
-  void offerTimeout(const OfferID& offerId);
+  // Sends the acknowledgements batched up by 'acknowledge()' to
+  // their slaves, in a single message per slave.
+  void forwardAcknowledgements();
+
+  // Remove the offers whose timeout has elapsed.
+  void expireOffers();
 
   // Remove an offer and optionally rescind the offer as well.
   void removeOffer(Offer* offer, bool rescind = false);
@@ -911,6 +1184,11 @@ private:
 
   void suppress(Framework* framework);
 
+  // Handles the calls of a batch in order.
+  void batch(
+      Framework* framework,
+      const scheduler::Call::Batch& batch);
+
   bool elected() const
   {
     return leader.isSome() && leader.get() == info_;
@@ -1043,6 +1321,10 @@ private:
         const process::http::Request& request,
         const Option<std::string>& principal) const;
 
+    // /master/events
+    process::Future<process::http::Response> events(
+        const process::http::Request& request) const;
+
     // /master/flags
     process::Future<process::http::Response> flags(
         const process::http::Request& request) const;
@@ -1119,7 +1401,17 @@ private:
         const process::http::Request& request,
         const Option<std::string>& principal) const;
 
+    // The events streamed by '/master/events', which the master sends
+    // whenever it changes the corresponding state.
+    void taskAdded(const Task& task) const;
+    void taskUpdated(const Task& task) const;
+    void slaveAdded(const Slave& slave) const;
+    void slaveRemoved(const Slave& slave) const;
+    void frameworkAdded(const Framework& framework) const;
+    void frameworkRemoved(const Framework& framework) const;
+
     static std::string SCHEDULER_HELP();
+    static std::string EVENTS_HELP();
     static std::string FLAGS_HELP();
     static std::string FRAMEWORKS();
     static std::string HEALTH_HELP();
@@ -1199,6 +1491,34 @@ private:
 
   mesos::master::allocator::Allocator* allocator;
   WhitelistWatcher* whitelistWatcher;
+  SlaveHealthChecker* healthChecker;
+
+  // The completed tasks evicted from memory (if any).
+  TaskHistory* taskHistory;
+
+  // Writes the periodic exports of the state (if any).
+  StateExporter* stateExporter;
+
+  // Renders the read-only HTTP endpoints, see 'ReadOnlyHandler'.
+  ReadOnlyHandler* readOnlyHandler;
+
+  // Returns a snapshot of the current state for the read-only HTTP
+  // endpoints. Only the slaves and frameworks that changed since the
+  // last snapshot are copied.
+  std::shared_ptr<const Snapshot> snapshot();
+
+  // The last snapshot returned by 'snapshot'.
+  std::shared_ptr<const Snapshot> published;
+
+  // Sends 'event' to the consumers of the '/events' endpoint, those
+  // that have gone away are dropped.
+  void publish(const std::string& event);
+
+  void unsubscribe(const UUID& id);
+
+  // The consumers of the '/events' endpoint, see 'Http::events'.
+  hashmap<UUID, StateSubscriber> subscribers;
+
   Registrar* registrar;
   Repairer* repairer;
   Files* files;
@@ -1248,7 +1568,7 @@ private:
 
     // Registered slaves are indexed by SlaveID and UPID. Note that
     // iteration is supported but is exposed as iteration over a
-    // hashmap<SlaveID, Slave*> since it is tedious to convert
+    // flathashmap<SlaveID, Slave*> since it is tedious to convert
     // the map's key/value iterator into a value iterator.
     //
     // TODO(bmahler): Consider pulling in boost's multi_index,
@@ -1297,8 +1617,8 @@ private:
 
       size_t size() const { return ids.size(); }
 
-      typedef hashmap<SlaveID, Slave*>::iterator iterator;
-      typedef hashmap<SlaveID, Slave*>::const_iterator const_iterator;
+      typedef flathashmap<SlaveID, Slave*>::iterator iterator;
+      typedef flathashmap<SlaveID, Slave*>::const_iterator const_iterator;
 
       iterator begin() { return ids.begin(); }
       iterator end()   { return ids.end();   }
@@ -1307,8 +1627,8 @@ private:
       const_iterator end()   const { return ids.end();   }
 
     private:
-      hashmap<SlaveID, Slave*> ids;
-      hashmap<process::UPID, Slave*> pids;
+      flathashmap<SlaveID, Slave*> ids;
+      flathashmap<process::UPID, Slave*> pids;
     } registered;
 
     // Slaves that are in the process of being removed from the
@@ -1351,7 +1671,7 @@ private:
     Frameworks(const Flags& masterFlags)
       : completed(masterFlags.max_completed_frameworks) {}
 
-    hashmap<FrameworkID, Framework*> registered;
+    flathashmap<FrameworkID, Framework*> registered;
     boost::circular_buffer<std::shared_ptr<Framework>> completed;
 
     // Principals of frameworks keyed by PID.
@@ -1375,12 +1695,32 @@ private:
     Option<process::Owned<BoundedRateLimiter>> defaultLimiter;
   } frameworks;
 
-  hashmap<OfferID, Offer*> offers;
-  hashmap<OfferID, process::Timer> offerTimers;
+  flathashmap<OfferID, Offer*> offers;
+
+  // Offers pending expiry, in the order they were made. All offers
+  // share the same '--offer_timeout', so this is also the order in
+  // which they expire and a single timer for the earliest expiry is
+  // enough, rather than one timer per offer. Offers removed before
+  // their timeout are left in place and skipped once they expire.
+  std::deque<std::pair<process::Time, OfferID>> offerExpiries;
+  Option<process::Timer> offerTimer;
+
+  // The latest oversubscribed resources of the slaves whose updates
+  // are yet to be applied (see 'updateSlave').
+  hashmap<SlaveID, Resources> oversubscribedUpdates;
 
   hashmap<OfferID, InverseOffer*> inverseOffers;
   hashmap<OfferID, process::Timer> inverseOfferTimers;
 
+  // The resources waiting to be recovered in the allocator per slave
+  // and framework, see 'recoverResources()'.
+  hashmap<SlaveID, hashmap<FrameworkID, Resources>> recoveries;
+
+  // Status update acknowledgements waiting to be forwarded to the
+  // slaves, see 'forwardAcknowledgements()'.
+  hashmap<SlaveID, std::vector<StatusUpdateAcknowledgementMessage>>
+    pendingAcknowledgements;
+
   // Roles with > 0 frameworks currently registered.
   hashmap<std::string, Role*> activeRoles;
 
@@ -1396,6 +1736,19 @@ private:
   // because we set them at the role level.
   hashmap<std::string, Quota> quotas;
 
+  // The sum of the unreserved scalar resources of the connected and
+  // active agents, i.e., the non-static resources that quota can be
+  // satisfied with (see 'QuotaHandler::capacityHeuristic'). This is
+  // maintained as agents are added, removed, (re-)connected and
+  // deactivated. Only scalars are summed, since those are exact under
+  // subtraction and quota guarantees contain only scalars.
+  Resources nonStaticClusterResources;
+
+  // Adds (or removes) the resources of the agent to (or from)
+  // 'nonStaticClusterResources'.
+  void trackCapacity(const Slave* slave);
+  void untrackCapacity(const Slave* slave);
+
   // Authenticator names as supplied via flags.
   std::vector<std::string> authenticatorNames;
 
@@ -1446,6 +1799,18 @@ private:
     return offers.size();
   }
 
+  // The slaves recovered from the registry which have not attempted
+  // to re-register yet, and the ones being readmitted.
+  double _recovery_slaves_pending()
+  {
+    return slaves.recovered.size();
+  }
+
+  double _slaves_reregistering()
+  {
+    return slaves.reregistering.size();
+  }
+
   double _event_queue_messages()
   {
     return static_cast<double>(eventCount<process::MessageEvent>());
@@ -1465,6 +1830,11 @@ private:
   double _tasks_starting();
   double _tasks_running();
 
+  // The number of tasks of a framework or slave in the given
+  // (non-terminal) state.
+  double _framework_tasks(const FrameworkID& frameworkId, TaskState state);
+  double _slave_tasks(const SlaveID& slaveId, TaskState state);
+
   double _resources_total(const std::string& name);
   double _resources_used(const std::string& name);
   double _resources_percent(const std::string& name);
@@ -1672,6 +2042,42 @@ private:
 };
 
 
+// A completed task of a framework. Since the master keeps many more
+// completed tasks than it has tasks, they are kept serialized, which
+// takes a fraction of the memory of the 'Task' message itself and is
+// only parsed when the task is exposed by the HTTP endpoints. The
+// fields that are needed to index the tasks are kept aside.
+class CompletedTask
+{
+public:
+  explicit CompletedTask(const Task& task)
+    : slaveId(task.slave_id()),
+      state_(task.state())
+  {
+    CHECK(task.SerializeToString(&data));
+  }
+
+  const SlaveID& slave_id() const { return slaveId; }
+  TaskState state() const { return state_; }
+
+  // Returns (approximately) the memory taken by the task.
+  size_t bytes() const { return sizeof(*this) + data.size(); }
+
+  // Returns the complete task.
+  Task task() const
+  {
+    Task task;
+    CHECK(task.ParseFromString(data));
+    return task;
+  }
+
+private:
+  SlaveID slaveId;
+  TaskState state_;
+  std::string data;
+};
+
+
 // Information about a connected or completed framework.
 // TODO(bmahler): Keeping the task and executor information in sync
 // across the Slave and Framework structs is error prone!
@@ -1689,7 +2095,12 @@ struct Framework
       active(true),
       registeredTime(time),
       reregisteredTime(time),
-      completedTasks(masterFlags.max_completed_tasks_per_framework) {}
+      completedTasks(masterFlags.max_completed_tasks_per_framework),
+      completedTasksBytes(0),
+      maxCompletedTasksBytes(
+          masterFlags.max_completed_tasks_bytes_per_framework),
+      role(NULL),
+      revision(0) {}
 
   Framework(Master* const _master,
             const Flags& masterFlags,
@@ -1703,7 +2114,12 @@ struct Framework
       active(true),
       registeredTime(time),
       reregisteredTime(time),
-      completedTasks(masterFlags.max_completed_tasks_per_framework) {}
+      completedTasks(masterFlags.max_completed_tasks_per_framework),
+      completedTasksBytes(0),
+      maxCompletedTasksBytes(
+          masterFlags.max_completed_tasks_bytes_per_framework),
+      role(NULL),
+      revision(0) {}
 
   ~Framework()
   {
@@ -1728,11 +2144,16 @@ struct Framework
       << " of framework " << task->framework_id();
 
     tasks[task->task_id()] = task;
+    taskStates[task->slave_id()][task->state()]++;
 
     if (!protobuf::isTerminalState(task->state())) {
-      totalUsedResources += task->resources();
+      addUsedResources(task->resources());
       usedResources[task->slave_id()] += task->resources();
     }
+
+    taskChanged(task->task_id());
+
+    revision++;
   }
 
   // Notification of task termination, for resource accounting.
@@ -1746,11 +2167,31 @@ struct Framework
       << "Unknown task " << task->task_id()
       << " of framework " << task->framework_id();
 
-    totalUsedResources -= task->resources();
+    removeUsedResources(task->resources());
     usedResources[task->slave_id()] -= task->resources();
     if (usedResources[task->slave_id()].empty()) {
       usedResources.erase(task->slave_id());
     }
+
+    revision++;
+  }
+
+  // Notification of a change of the state of a task, for the
+  // accounting of the tasks in each state.
+  void taskStateChanged(Task* task, const TaskState& previous)
+  {
+    CHECK(tasks.contains(task->task_id()))
+      << "Unknown task " << task->task_id()
+      << " of framework " << task->framework_id();
+
+    hashmap<TaskState, size_t>& states = taskStates[task->slave_id()];
+
+    CHECK(states.contains(previous));
+    if (--states[previous] == 0) {
+      states.erase(previous);
+    }
+
+    states[task->state()]++;
   }
 
   // Sends a message to the connected framework.
@@ -1776,7 +2217,50 @@ struct Framework
   void addCompletedTask(const Task& task)
   {
     // TODO(adam-mesos): Check if completed task already exists.
-    completedTasks.push_back(std::shared_ptr<Task>(new Task(task)));
+    std::shared_ptr<const CompletedTask> completed(new CompletedTask(task));
+
+    if (completedTasks.capacity() == 0) {
+      master->spill(*completed);
+      return;
+    }
+
+    if (completedTasks.full()) {
+      evictCompletedTask();
+    }
+
+    completedTasks.push_back(completed);
+    completedTasksBytes += completed->bytes();
+    completedTaskStates[completed->slave_id()][completed->state()]++;
+
+    while (maxCompletedTasksBytes.isSome() &&
+           completedTasksBytes > maxCompletedTasksBytes.get().bytes() &&
+           !completedTasks.empty()) {
+      evictCompletedTask();
+    }
+
+    revision++;
+  }
+
+  // Evicts the oldest completed task from memory.
+  void evictCompletedTask()
+  {
+    const std::shared_ptr<const CompletedTask> task = completedTasks.front();
+    completedTasks.pop_front();
+
+    completedTasksBytes -= task->bytes();
+
+    hashmap<TaskState, size_t>& states = completedTaskStates[task->slave_id()];
+
+    CHECK(states.contains(task->state()));
+    if (--states[task->state()] == 0) {
+      states.erase(task->state());
+    }
+
+    if (states.empty()) {
+      completedTaskStates.erase(task->slave_id());
+    }
+
+    master->spill(*task);
   }
 
   void removeTask(Task* task)
@@ -1785,8 +2269,19 @@ struct Framework
       << "Unknown task " << task->task_id()
       << " of framework " << task->framework_id();
 
+    hashmap<TaskState, size_t>& states = taskStates[task->slave_id()];
+
+    CHECK(states.contains(task->state()));
+    if (--states[task->state()] == 0) {
+      states.erase(task->state());
+    }
+
+    if (states.empty()) {
+      taskStates.erase(task->slave_id());
+    }
+
     if (!protobuf::isTerminalState(task->state())) {
-      totalUsedResources -= task->resources();
+      removeUsedResources(task->resources());
       usedResources[task->slave_id()] -= task->resources();
       if (usedResources[task->slave_id()].empty()) {
         usedResources.erase(task->slave_id());
@@ -1796,14 +2291,66 @@ struct Framework
     addCompletedTask(*task);
 
     tasks.erase(task->task_id());
+
+    forgetTaskChange(task->task_id());
+
+    revision++;
+  }
+
+  // Records a change of a pending or launched task (e.g., a launch
+  // or a state update) in the change log, which lets frameworks
+  // reconcile only the tasks that changed since a given time.
+  void taskChanged(const TaskID& taskId)
+  {
+    forgetTaskChange(taskId);
+
+    const process::Time now = process::Clock::now();
+
+    taskChanges.insert(std::make_pair(now, taskId));
+    taskChangeTimes[taskId] = now;
+  }
+
+  // Removes a task which is no longer known (e.g., once its terminal
+  // update is acknowledged) from the change log.
+  void forgetTaskChange(const TaskID& taskId)
+  {
+    if (!taskChangeTimes.contains(taskId)) {
+      return;
+    }
+
+    auto range = taskChanges.equal_range(taskChangeTimes[taskId]);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == taskId) {
+        taskChanges.erase(it);
+        break;
+      }
+    }
+
+    taskChangeTimes.erase(taskId);
+  }
+
+  // Returns the tasks which changed at or after the given time, in
+  // the order of their changes.
+  std::vector<TaskID> changedTasks(const process::Time& since) const
+  {
+    std::vector<TaskID> result;
+
+    auto it = taskChanges.lower_bound(since);
+    for (; it != taskChanges.end(); ++it) {
+      result.push_back(it->second);
+    }
+
+    return result;
   }
 
   void addOffer(Offer* offer)
   {
     CHECK(!offers.contains(offer)) << "Duplicate offer " << offer->id();
     offers.insert(offer);
-    totalOfferedResources += offer->resources();
+    addOfferedResources(offer->resources());
     offeredResources[offer->slave_id()] += offer->resources();
+
+    revision++;
   }
 
   void removeOffer(Offer* offer)
@@ -1811,13 +2358,15 @@ struct Framework
     CHECK(offers.find(offer) != offers.end())
       << "Unknown offer " << offer->id();
 
-    totalOfferedResources -= offer->resources();
+    removeOfferedResources(offer->resources());
     offeredResources[offer->slave_id()] -= offer->resources();
     if (offeredResources[offer->slave_id()].empty()) {
       offeredResources.erase(offer->slave_id());
     }
 
     offers.erase(offer);
+
+    revision++;
   }
 
   void addInverseOffer(InverseOffer* inverseOffer)
@@ -1850,8 +2399,10 @@ struct Framework
       << "' on slave " << slaveId;
 
     executors[slaveId][executorInfo.executor_id()] = executorInfo;
-    totalUsedResources += executorInfo.resources();
+    addUsedResources(executorInfo.resources());
     usedResources[slaveId] += executorInfo.resources();
+
+    revision++;
   }
 
   void removeExecutor(const SlaveID& slaveId,
@@ -1862,7 +2413,7 @@ struct Framework
       << "' of framework " << id()
       << " of slave " << slaveId;
 
-    totalUsedResources -= executors[slaveId][executorId].resources();
+    removeUsedResources(executors[slaveId][executorId].resources());
     usedResources[slaveId] -= executors[slaveId][executorId].resources();
     if (usedResources[slaveId].empty()) {
       usedResources.erase(slaveId);
@@ -1872,10 +2423,46 @@ struct Framework
     if (executors[slaveId].empty()) {
       executors.erase(slaveId);
     }
+
+    revision++;
   }
 
   const FrameworkID id() const { return info.id(); }
 
+  // Returns a copy of this framework, including copies of its tasks
+  // and offers, that can be read by other processes (see 'Snapshot').
+  // The connection to the framework is not part of the copy.
+  std::shared_ptr<const Framework> snapshot() const
+  {
+    Framework* framework = new Framework(*this);
+
+    framework->http = None();
+    framework->heartbeater = None();
+    framework->role = NULL;
+    framework->inverseOffers.clear();
+
+    foreachpair (const TaskID& taskId, const Task* task, tasks) {
+      framework->tasks[taskId] = new Task(*task);
+    }
+
+    framework->offers.clear();
+    foreach (const Offer* offer, offers) {
+      framework->offers.insert(new Offer(*offer));
+    }
+
+    auto deleter = [](Framework* framework) {
+      foreachvalue (Task* task, framework->tasks) {
+        delete task;
+      }
+      foreach (Offer* offer, framework->offers) {
+        delete offer;
+      }
+      delete framework;
+    };
+
+    return std::shared_ptr<const Framework>(framework, deleter);
+  }
+
   // Update fields in 'info' using those in 'source'. Currently this
   // only updates 'name', 'failover_timeout', 'hostname', 'webui_url',
   // 'capabilities', and 'labels'.
@@ -1941,6 +2528,8 @@ struct Framework
     } else {
       info.clear_labels();
     }
+
+    revision++;
   }
 
   void updateConnection(const process::UPID& newPid)
@@ -1953,6 +2542,8 @@ struct Framework
 
     // TODO(benh): unlink(oldPid);
     pid = newPid;
+
+    revision++;
   }
 
   void updateConnection(const HttpConnection& newHttp)
@@ -1972,6 +2563,8 @@ struct Framework
     CHECK_NONE(http);
 
     http = newHttp;
+
+    revision++;
   }
 
   // Closes the HTTP connection and stops the heartbeat.
@@ -2038,10 +2631,32 @@ struct Framework
 
   hashmap<TaskID, Task*> tasks;
 
-  // NOTE: We use a shared pointer for Task because clang doesn't like
-  // Boost's implementation of circular_buffer with Task (Boost
-  // attempts to do some memset's which are unsafe).
-  boost::circular_buffer<std::shared_ptr<Task>> completedTasks;
+  // The number of tasks of this framework in each state, per slave,
+  // so that summarizing the states of the tasks (see '/state-summary')
+  // does not need to look at all of the tasks.
+  hashmap<SlaveID, hashmap<TaskState, size_t>> taskStates;
+
+  // The change log of the pending and launched tasks: the tasks
+  // ordered by the time of their latest change, and that time for
+  // each task.
+  std::multimap<process::Time, TaskID> taskChanges;
+  hashmap<TaskID, process::Time> taskChangeTimes;
+
+  // NOTE: We use a shared pointer for the completed tasks because
+  // clang doesn't like Boost's implementation of circular_buffer with
+  // Task (Boost attempts to do some memset's which are unsafe), and
+  // so that the snapshots of the framework can share them.
+  boost::circular_buffer<std::shared_ptr<const CompletedTask>>
+    completedTasks;
+
+  // The memory taken by the completed tasks, which is bounded by
+  // '--max_completed_tasks_bytes_per_framework' (if set).
+  size_t completedTasksBytes;
+
+  // The number of completed tasks (in memory) in each state, per
+  // slave, like 'taskStates' for the tasks.
+  hashmap<SlaveID, hashmap<TaskState, size_t>> completedTaskStates;
+  Option<Bytes> maxCompletedTasksBytes;
 
   hashset<Offer*> offers; // Active offers for framework.
 
@@ -2082,8 +2697,26 @@ struct Framework
   // This is only set for HTTP frameworks.
   Option<process::Owned<Heartbeater>> heartbeater;
 
+  // The active role of this framework, which keeps the aggregates of
+  // the totals above (see 'Role::addFramework'). This is not set for
+  // snapshots.
+  Role* role;
+
+  // Incremented whenever the state of this framework that is exposed
+  // via the read-only HTTP endpoints changes (including the state of
+  // its tasks), which lets the master reuse the snapshots of unchanged
+  // frameworks (see 'Master::snapshot').
+  uint64_t revision;
+
 private:
-  Framework(const Framework&);              // No copying.
+  // Update the totals of this framework and the aggregates of its role
+  // (these are defined below, after 'Role').
+  void addUsedResources(const Resources& resources);
+  void removeUsedResources(const Resources& resources);
+  void addOfferedResources(const Resources& resources);
+  void removeOfferedResources(const Resources& resources);
+
+  Framework(const Framework&) = default;    // Only used by 'snapshot'.
   Framework& operator=(const Framework&); // No assigning.
 };
 
@@ -2109,23 +2742,43 @@ struct Role
 {
   void addFramework(Framework* framework)
   {
+    CHECK(framework->role == NULL)
+      << "Framework " << *framework << " already has an active role";
+
     frameworks[framework->id()] = framework;
+    framework->role = this;
+
+    allocated += framework->totalUsedResources;
+    offered += framework->totalOfferedResources;
   }
 
   void removeFramework(Framework* framework)
   {
+    CHECK_EQ(this, framework->role)
+      << "Framework " << *framework << " is not in this role";
+
     frameworks.erase(framework->id());
+    framework->role = NULL;
+
+    // NOTE: Rather than subtracting the totals of the framework, which
+    // can leave behind non-scalar resources that are shared by other
+    // frameworks (see the note about the totals in 'Framework'), the
+    // aggregates are recomputed. This is only done when a framework
+    // leaves the role, not when its tasks or offers change.
+    allocated = Resources();
+    offered = Resources();
+    foreachvalue (Framework* framework_, frameworks) {
+      allocated += framework_->totalUsedResources;
+      offered += framework_->totalOfferedResources;
+    }
   }
 
+  // Returns the resources used and offered by the frameworks of this
+  // role, which is maintained as the totals of the frameworks change
+  // rather than summed up for every request of the '/roles' endpoint.
   Resources resources() const
   {
-    Resources resources;
-    foreachvalue (Framework* framework, frameworks) {
-      resources += framework->totalUsedResources;
-      resources += framework->totalOfferedResources;
-    }
-
-    return resources;
+    return allocated + offered;
   }
 
   // NOTE: The dynamic role/quota relation is stored in and administrated
@@ -2136,8 +2789,49 @@ struct Role
   // quota first is intended to contain.
 
   hashmap<FrameworkID, Framework*> frameworks;
+
+  // The sums of the 'totalUsedResources' and 'totalOfferedResources'
+  // of the frameworks, updated by the frameworks (see below).
+  Resources allocated;
+  Resources offered;
 };
 
+
+inline void Framework::addUsedResources(const Resources& resources)
+{
+  totalUsedResources += resources;
+  if (role != NULL) {
+    role->allocated += resources;
+  }
+}
+
+
+inline void Framework::removeUsedResources(const Resources& resources)
+{
+  totalUsedResources -= resources;
+  if (role != NULL) {
+    role->allocated -= resources;
+  }
+}
+
+
+inline void Framework::addOfferedResources(const Resources& resources)
+{
+  totalOfferedResources += resources;
+  if (role != NULL) {
+    role->offered += resources;
+  }
+}
+
+
+inline void Framework::removeOfferedResources(const Resources& resources)
+{
+  totalOfferedResources -= resources;
+  if (role != NULL) {
+    role->offered -= resources;
+  }
+}
+
 } // namespace master {
 } // namespace internal {
 } // namespace mesos {
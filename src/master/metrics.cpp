@@ -21,6 +21,7 @@
 #include <process/metrics/metrics.hpp>
 
 #include <stout/foreach.hpp>
+#include <stout/stringify.hpp>
 
 #include "master/master.hpp"
 #include "master/metrics.hpp"
@@ -114,6 +115,8 @@ Metrics::Metrics(const Master& master)
         "master/messages_revive_offers"),
     messages_suppress_offers(
         "master/messages_suppress_offers"),
+    messages_batch(
+        "master/messages_batch"),
     messages_reconcile_tasks(
         "master/messages_reconcile_tasks"),
     messages_framework_to_executor(
@@ -152,6 +155,16 @@ Metrics::Metrics(const Master& master)
         "master/invalid_status_update_acknowledgements"),
     recovery_slave_removals(
         "master/recovery_slave_removals"),
+    recovery_slaves_pending(
+        "master/recovery_slaves_pending",
+        defer(master, &Master::_recovery_slaves_pending)),
+    slaves_reregistering(
+        "master/slaves_reregistering",
+        defer(master, &Master::_slaves_reregistering)),
+    slave_reregistrations_deferred(
+        "master/slave_reregistrations_deferred"),
+    authentications_deferred(
+        "master/authentications_deferred"),
     event_queue_messages(
         "master/event_queue_messages",
         defer(master, &Master::_event_queue_messages)),
@@ -219,6 +232,7 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(messages_decline_offers);
   process::metrics::add(messages_revive_offers);
   process::metrics::add(messages_suppress_offers);
+  process::metrics::add(messages_batch);
   process::metrics::add(messages_reconcile_tasks);
   process::metrics::add(messages_framework_to_executor);
   process::metrics::add(messages_executor_to_framework);
@@ -248,6 +262,12 @@ Metrics::Metrics(const Master& master)
 
   process::metrics::add(recovery_slave_removals);
 
+  process::metrics::add(recovery_slaves_pending);
+  process::metrics::add(slaves_reregistering);
+  process::metrics::add(slave_reregistrations_deferred);
+
+  process::metrics::add(authentications_deferred);
+
   process::metrics::add(event_queue_messages);
   process::metrics::add(event_queue_dispatches);
   process::metrics::add(event_queue_http_requests);
@@ -355,6 +375,7 @@ Metrics::~Metrics()
   process::metrics::remove(messages_decline_offers);
   process::metrics::remove(messages_revive_offers);
   process::metrics::remove(messages_suppress_offers);
+  process::metrics::remove(messages_batch);
   process::metrics::remove(messages_reconcile_tasks);
   process::metrics::remove(messages_framework_to_executor);
   process::metrics::remove(messages_executor_to_framework);
@@ -384,6 +405,12 @@ Metrics::~Metrics()
 
   process::metrics::remove(recovery_slave_removals);
 
+  process::metrics::remove(recovery_slaves_pending);
+  process::metrics::remove(slaves_reregistering);
+  process::metrics::remove(slave_reregistrations_deferred);
+
+  process::metrics::remove(authentications_deferred);
+
   process::metrics::remove(event_queue_messages);
   process::metrics::remove(event_queue_dispatches);
   process::metrics::remove(event_queue_http_requests);
@@ -440,6 +467,48 @@ Metrics::~Metrics()
 }
 
 
+Metrics::Tasks::Tasks(const Master& master, const FrameworkID& frameworkId)
+  : tasks_staging(
+        "master/frameworks/" + stringify(frameworkId) + "/tasks_staging",
+        defer(master, &Master::_framework_tasks, frameworkId, TASK_STAGING)),
+    tasks_starting(
+        "master/frameworks/" + stringify(frameworkId) + "/tasks_starting",
+        defer(master, &Master::_framework_tasks, frameworkId, TASK_STARTING)),
+    tasks_running(
+        "master/frameworks/" + stringify(frameworkId) + "/tasks_running",
+        defer(master, &Master::_framework_tasks, frameworkId, TASK_RUNNING))
+{
+  process::metrics::add(tasks_staging);
+  process::metrics::add(tasks_starting);
+  process::metrics::add(tasks_running);
+}
+
+
+Metrics::Tasks::Tasks(const Master& master, const SlaveID& slaveId)
+  : tasks_staging(
+        "master/slaves/" + stringify(slaveId) + "/tasks_staging",
+        defer(master, &Master::_slave_tasks, slaveId, TASK_STAGING)),
+    tasks_starting(
+        "master/slaves/" + stringify(slaveId) + "/tasks_starting",
+        defer(master, &Master::_slave_tasks, slaveId, TASK_STARTING)),
+    tasks_running(
+        "master/slaves/" + stringify(slaveId) + "/tasks_running",
+        defer(master, &Master::_slave_tasks, slaveId, TASK_RUNNING))
+{
+  process::metrics::add(tasks_staging);
+  process::metrics::add(tasks_starting);
+  process::metrics::add(tasks_running);
+}
+
+
+Metrics::Tasks::~Tasks()
+{
+  process::metrics::remove(tasks_staging);
+  process::metrics::remove(tasks_starting);
+  process::metrics::remove(tasks_running);
+}
+
+
 void Metrics::incrementTasksStates(
     const TaskState& state,
     const TaskStatus::Source& source,
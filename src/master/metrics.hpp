@@ -22,6 +22,7 @@
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/histogram.hpp>
 #include <process/metrics/metrics.hpp>
 
 #include <stout/hashmap.hpp>
@@ -98,18 +99,27 @@ struct Metrics
     // requested by this message has finished.
     process::metrics::Counter messages_processed;
 
+    // How long the framework messages which are rate limited have
+    // been throttled for (in milliseconds), including the ones which
+    // got a permit right away.
+    process::metrics::Histogram messages_throttled_ms;
+
     explicit Frameworks(const std::string& principal)
       : messages_received("frameworks/" + principal + "/messages_received"),
-        messages_processed("frameworks/" + principal + "/messages_processed")
+        messages_processed("frameworks/" + principal + "/messages_processed"),
+        messages_throttled_ms(
+            "frameworks/" + principal + "/messages_throttled_ms")
     {
       process::metrics::add(messages_received);
       process::metrics::add(messages_processed);
+      process::metrics::add(messages_throttled_ms);
     }
 
     ~Frameworks()
     {
       process::metrics::remove(messages_received);
       process::metrics::remove(messages_processed);
+      process::metrics::remove(messages_throttled_ms);
     }
   };
 
@@ -117,6 +127,24 @@ struct Metrics
   // principal.
   hashmap<std::string, process::Owned<Frameworks>> frameworks;
 
+  // Metrics of the tasks of a framework or a slave. These metrics
+  // have names prefixed by "master/frameworks/<framework_id>/" and
+  // "master/slaves/<slave_id>/" respectively.
+  struct Tasks
+  {
+    Tasks(const Master& master, const FrameworkID& frameworkId);
+    Tasks(const Master& master, const SlaveID& slaveId);
+
+    ~Tasks();
+
+    process::metrics::Gauge tasks_staging;
+    process::metrics::Gauge tasks_starting;
+    process::metrics::Gauge tasks_running;
+  };
+
+  hashmap<FrameworkID, process::Owned<Tasks>> framework_tasks;
+  hashmap<SlaveID, process::Owned<Tasks>> slave_tasks;
+
   // Messages from schedulers.
   process::metrics::Counter messages_register_framework;
   process::metrics::Counter messages_reregister_framework;
@@ -129,6 +157,7 @@ struct Metrics
   process::metrics::Counter messages_decline_offers;
   process::metrics::Counter messages_revive_offers;
   process::metrics::Counter messages_suppress_offers;
+  process::metrics::Counter messages_batch;
   process::metrics::Counter messages_reconcile_tasks;
   process::metrics::Counter messages_framework_to_executor;
 
@@ -160,6 +189,14 @@ struct Metrics
   // Recovery counters.
   process::metrics::Counter recovery_slave_removals;
 
+  // Re-registration progress after a failover.
+  process::metrics::Gauge recovery_slaves_pending;
+  process::metrics::Gauge slaves_reregistering;
+  process::metrics::Counter slave_reregistrations_deferred;
+
+  // Authentications ignored because too many were in progress.
+  process::metrics::Counter authentications_deferred;
+
   // Process metrics.
   process::metrics::Gauge event_queue_messages;
   process::metrics::Gauge event_queue_dispatches;
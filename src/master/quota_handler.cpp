@@ -101,33 +101,11 @@ Option<Error> Master::QuotaHandler::capacityHeuristic(
   }
 
   // Determine whether the total quota, including the new request, does
-  // not exceed the sum of non-static cluster resources.
-  // NOTE: We do not necessarily calculate the full sum of non-static
-  // cluster resources. We apply the early termination logic as it can
-  // reduce the cost of the function significantly. This early exit does
-  // not influence the declared inequality check.
-  Resources nonStaticClusterResources;
-  foreachvalue (Slave* slave, master->slaves.registered) {
-    // We do not consider disconnected or inactive agents, because they
-    // do not participate in resource allocation.
-    if (!slave->connected || !slave->active) {
-      continue;
-    }
-
-    // NOTE: Dynamic reservations are not excluded here because they do
-    // not show up in `SlaveInfo` resources. In contrast to static
-    // reservations, dynamic reservations may be unreserved at any time,
-    // hence making resources available for quota'ed frameworks.
-    Resources nonStaticAgentResources =
-      Resources(slave->info.resources()).unreserved();
-
-    nonStaticClusterResources += nonStaticAgentResources;
-
-    // If we have found enough resources to satisfy the inequality, then
-    // we can return early.
-    if (nonStaticClusterResources.contains(totalQuota)) {
-      return None();
-    }
+  // not exceed the sum of non-static cluster resources. The master
+  // keeps this sum for the connected and active agents, since those
+  // are the ones participating in resource allocation.
+  if (master->nonStaticClusterResources.contains(totalQuota)) {
+    return None();
   }
 
   // If we reached this point, there are not enough available resources
@@ -19,7 +19,9 @@
 
 #include <mesos/type_utils.hpp>
 
+#include <process/clock.hpp>
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/help.hpp>
@@ -27,7 +29,9 @@
 #include <process/id.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/time.hpp>
 
+#include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
@@ -57,13 +61,16 @@ using process::Failure;
 using process::Future;
 using process::HELP;
 using process::Owned;
+using process::Clock;
 using process::Process;
 using process::Promise;
 using process::TLDR;
+using process::Time;
 using process::USAGE;
 
 using process::http::OK;
 
+using process::metrics::Counter;
 using process::metrics::Gauge;
 using process::metrics::Timer;
 
@@ -84,6 +91,7 @@ public:
     : ProcessBase(process::ID::generate("registrar")),
       metrics(*this),
       updating(false),
+      batching(false),
       flags(_flags),
       state(_state) {}
 
@@ -136,13 +144,20 @@ private:
             "registrar/registry_size_bytes",
             defer(process, &RegistrarProcess::_registry_size_bytes)),
         state_fetch("registrar/state_fetch"),
-        state_store("registrar/state_store", Days(1))
+        state_store("registrar/state_store", Days(1)),
+        batch_delay("registrar/batch_delay", Days(1)),
+        stores("registrar/stores"),
+        stored_operations("registrar/stored_operations")
     {
       process::metrics::add(queued_operations);
       process::metrics::add(registry_size_bytes);
 
       process::metrics::add(state_fetch);
       process::metrics::add(state_store);
+      process::metrics::add(batch_delay);
+
+      process::metrics::add(stores);
+      process::metrics::add(stored_operations);
     }
 
     ~Metrics()
@@ -152,6 +167,10 @@ private:
 
       process::metrics::remove(state_fetch);
       process::metrics::remove(state_store);
+      process::metrics::remove(batch_delay);
+
+      process::metrics::remove(stores);
+      process::metrics::remove(stored_operations);
     }
 
     Gauge queued_operations;
@@ -159,6 +178,14 @@ private:
 
     Timer<Milliseconds> state_fetch;
     Timer<Milliseconds> state_store;
+
+    // Time spent waiting for more operations before a store.
+    Timer<Milliseconds> batch_delay;
+
+    // Number of successful stores and of the operations they
+    // persisted, i.e., their ratio is the average batch size.
+    Counter stores;
+    Counter stored_operations;
   } metrics;
 
   // Gauge handlers.
@@ -183,6 +210,11 @@ private:
   void __recover(const Future<bool>& recover);
   Future<bool> _apply(Owned<Operation> operation);
 
+  // Helpers for waiting for more operations before updating state
+  // while the queue of operations keeps growing.
+  void batch();
+  void _batch(const Time& start, size_t queued);
+
   // Helper for updating state (performing store).
   void update();
   void _update(
@@ -198,6 +230,7 @@ private:
   Option<Variable<Registry> > variable;
   deque<Owned<Operation> > operations;
   bool updating; // Used to signify fetching (recovering) or storing.
+  bool batching; // Used to signify waiting for more operations.
 
   const Flags flags;
   State* state;
@@ -399,13 +432,65 @@ Future<bool> RegistrarProcess::_apply(Owned<Operation> operation)
 
   operations.push_back(operation);
   Future<bool> future = operation->future();
-  if (!updating) {
-    update();
+  if (!updating && !batching) {
+    batch();
   }
   return future;
 }
 
 
+void RegistrarProcess::batch()
+{
+  if (flags.registry_batch_delay == Duration::zero()) {
+    update();
+    return;
+  }
+
+  batching = true;
+
+  metrics.batch_delay.start();
+
+  delay(flags.registry_batch_delay,
+        self(),
+        &Self::_batch,
+        Clock::now(),
+        operations.size());
+}
+
+
+void RegistrarProcess::_batch(const Time& start, size_t queued)
+{
+  CHECK(batching);
+
+  // Nothing to store if we aborted while waiting.
+  if (error.isSome()) {
+    batching = false;
+    return;
+  }
+
+  // Keep waiting while operations keep arriving (e.g., during a burst
+  // of slave re-registrations after a failover), but no longer than
+  // the maximum delay in total. Otherwise a single operation only
+  // waits for one step.
+  if (operations.size() > queued &&
+      (Clock::now() - start) + flags.registry_batch_delay <=
+        flags.registry_max_batch_delay) {
+    delay(flags.registry_batch_delay,
+          self(),
+          &Self::_batch,
+          start,
+          operations.size());
+    return;
+  }
+
+  batching = false;
+
+  metrics.batch_delay.stop();
+
+  update();
+}
+
+
 void RegistrarProcess::update()
 {
   if (operations.empty()) {
@@ -485,6 +570,9 @@ void RegistrarProcess::_update(
 
   variable = store.get().get();
 
+  ++metrics.stores;
+  metrics.stored_operations += applied.size();
+
   // Remove the operations.
   while (!applied.empty()) {
     Owned<Operation> operation = applied.front();
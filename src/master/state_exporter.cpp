@@ -0,0 +1,171 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include <process/clock.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/try.hpp>
+
+#include "logging/logging.hpp"
+
+#include "master/state_exporter.hpp"
+
+using std::string;
+using std::vector;
+
+using process::dispatch;
+using process::spawn;
+using process::terminate;
+using process::wait; // Necessary on some OS's to disambiguate.
+
+using process::Clock;
+using process::Process;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+class StateExporterProcess : public Process<StateExporterProcess>
+{
+public:
+  explicit StateExporterProcess(const string& _directory)
+    : ProcessBase(process::ID::generate("state-exporter")),
+      directory(_directory) {}
+
+  virtual ~StateExporterProcess() {}
+
+  void write(const hashmap<string, StateExporter::Table>& tables)
+  {
+    foreachpair (const string& name,
+                 const StateExporter::Table& table,
+                 tables) {
+      Try<Nothing> write = writeTable(name, table);
+      if (write.isError()) {
+        LOG(WARNING) << "Failed to export table '" << name << "': "
+                     << write.error();
+        return;
+      }
+    }
+
+    StateExporter::Table snapshot;
+    snapshot.columns = {"version", "timestamp"};
+    snapshot.rows.push_back({
+        stringify(StateExporter::FORMAT_VERSION),
+        stringify(Clock::now().secs())});
+
+    Try<Nothing> write = writeTable("snapshot", snapshot);
+    if (write.isError()) {
+      LOG(WARNING) << "Failed to export the state snapshot: " << write.error();
+    }
+  }
+
+protected:
+  virtual void initialize()
+  {
+    Try<Nothing> mkdir = os::mkdir(directory);
+    if (mkdir.isError()) {
+      LOG(WARNING) << "Failed to create state export directory '"
+                   << directory << "': " << mkdir.error();
+    }
+  }
+
+private:
+  Try<Nothing> writeTable(
+      const string& name,
+      const StateExporter::Table& table)
+  {
+    string contents = line(table.columns);
+    foreach (const vector<string>& row, table.rows) {
+      contents += line(row);
+    }
+
+    const string path = path::join(directory, name + ".tsv");
+    const string temporary = path + ".tmp";
+
+    Try<Nothing> write = os::write(temporary, contents);
+    if (write.isError()) {
+      return Error("Failed to write '" + temporary + "': " + write.error());
+    }
+
+    Try<Nothing> rename = os::rename(temporary, path);
+    if (rename.isError()) {
+      return Error("Failed to rename '" + temporary + "': " + rename.error());
+    }
+
+    return Nothing();
+  }
+
+  // Joins the values with tabs, replacing the tabs and the newlines
+  // in the values (e.g., in the names of the tasks) by spaces.
+  static string line(const vector<string>& values)
+  {
+    string result;
+
+    for (size_t i = 0; i < values.size(); i++) {
+      if (i > 0) {
+        result += '\t';
+      }
+
+      foreach (char c, values[i]) {
+        result += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+      }
+    }
+
+    result += '\n';
+    return result;
+  }
+
+  const string directory;
+};
+
+
+const int StateExporter::FORMAT_VERSION;
+
+
+StateExporter::StateExporter(const string& directory)
+{
+  process = new StateExporterProcess(directory);
+  spawn(process);
+}
+
+
+StateExporter::~StateExporter()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+void StateExporter::write(const hashmap<string, Table>& tables)
+{
+  dispatch(process, &StateExporterProcess::write, tables);
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
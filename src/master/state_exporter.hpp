@@ -0,0 +1,71 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_STATE_EXPORTER_HPP__
+#define __MASTER_STATE_EXPORTER_HPP__
+
+#include <string>
+#include <vector>
+
+#include <stout/hashmap.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Forward declaration.
+class StateExporterProcess;
+
+// Writes snapshots of the state of the master to a directory (see
+// '--state_export_dir'), so that offline analytics do not have to
+// scrape and parse '/state'. A snapshot has a file per table (e.g.,
+// 'agents.tsv'), with the names of the columns on the first line and
+// then a line per row, the columns being separated by tabs. Every
+// file is written aside and renamed into place, so that a reader
+// always sees a complete table. The 'snapshot.tsv' file, which is
+// replaced last, holds the version of the format and the time of the
+// snapshot. The files are written by a process of their own, i.e.,
+// not by the master.
+class StateExporter
+{
+public:
+  // The version of the format of the tables, which is bumped whenever
+  // the columns of a table change (other than by adding columns).
+  static const int FORMAT_VERSION = 1;
+
+  struct Table
+  {
+    std::vector<std::string> columns;
+    std::vector<std::vector<std::string>> rows;
+  };
+
+  explicit StateExporter(const std::string& directory);
+  ~StateExporter();
+
+  // Replaces the previous snapshot by the given tables, keyed by
+  // their names. Failures are only logged, since the export is best
+  // effort.
+  void write(const hashmap<std::string, Table>& tables);
+
+private:
+  StateExporterProcess* process;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_STATE_EXPORTER_HPP__
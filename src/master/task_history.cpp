@@ -0,0 +1,263 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <list>
+#include <string>
+
+#include <mesos/type_utils.hpp>
+
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/try.hpp>
+
+#include <stout/os/close.hpp>
+#include <stout/os/ftruncate.hpp>
+#include <stout/os/open.hpp>
+
+#include "logging/logging.hpp"
+
+#include "master/task_history.hpp"
+
+using std::list;
+using std::string;
+
+using process::dispatch;
+using process::spawn;
+using process::terminate;
+using process::wait; // Necessary on some OS's to disambiguate.
+
+using process::Future;
+using process::Process;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+class TaskHistoryProcess : public Process<TaskHistoryProcess>
+{
+public:
+  explicit TaskHistoryProcess(const string& _directory)
+    : ProcessBase(process::ID::generate("task-history")),
+      directory(_directory) {}
+
+  virtual ~TaskHistoryProcess() {}
+
+  void append(const Task& task)
+  {
+    const FrameworkID& frameworkId = task.framework_id();
+    const string path = path::join(directory, frameworkId.value());
+
+    Try<int> fd = os::open(
+        path,
+        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    if (fd.isError()) {
+      LOG(WARNING) << "Failed to open task history file '" << path << "': "
+                   << fd.error();
+      return;
+    }
+
+    // NOTE: The master is the only writer of the file.
+    const off_t offset = lseek(fd.get(), 0, SEEK_END);
+
+    Try<Nothing> write = offset < 0
+      ? ErrnoError("Failed to lseek")
+      : ::protobuf::write(fd.get(), task);
+
+    if (write.isError()) {
+      LOG(WARNING) << "Failed to append task " << task.task_id()
+                   << " to task history file '" << path << "': "
+                   << write.error();
+
+      // Drop what may have been written, so that the next task is
+      // appended right after the last complete one.
+      if (offset >= 0) {
+        os::ftruncate(fd.get(), offset);
+      }
+    } else {
+      offsets[frameworkId][task.task_id()] = offset;
+    }
+
+    os::close(fd.get());
+  }
+
+  Option<Task> get(const FrameworkID& frameworkId, const TaskID& taskId)
+  {
+    if (!offsets.contains(frameworkId) ||
+        !offsets[frameworkId].contains(taskId)) {
+      return None();
+    }
+
+    const string path = path::join(directory, frameworkId.value());
+
+    Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd.isError()) {
+      LOG(WARNING) << "Failed to open task history file '" << path << "': "
+                   << fd.error();
+      return None();
+    }
+
+    Result<Task> task = None();
+
+    if (lseek(fd.get(), offsets[frameworkId][taskId], SEEK_SET) < 0) {
+      task = ErrnoError("Failed to lseek");
+    } else {
+      task = ::protobuf::read<Task>(fd.get());
+    }
+
+    os::close(fd.get());
+
+    if (!task.isSome()) {
+      LOG(WARNING) << "Failed to read task " << taskId
+                   << " from task history file '" << path << "': "
+                   << (task.isError() ? task.error() : "none found");
+      return None();
+    }
+
+    return task.get();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    Try<Nothing> mkdir = os::mkdir(directory);
+    if (mkdir.isError()) {
+      LOG(WARNING) << "Failed to create task history directory '"
+                   << directory << "': " << mkdir.error();
+      return;
+    }
+
+    Try<list<string>> entries = os::ls(directory);
+    if (entries.isError()) {
+      LOG(WARNING) << "Failed to list task history directory '"
+                   << directory << "': " << entries.error();
+      return;
+    }
+
+    foreach (const string& entry, entries.get()) {
+      FrameworkID frameworkId;
+      frameworkId.set_value(entry);
+
+      Try<Nothing> recover = this->recover(frameworkId);
+      if (recover.isError()) {
+        LOG(WARNING) << "Failed to recover the task history of framework "
+                     << frameworkId << ": " << recover.error();
+      }
+    }
+  }
+
+private:
+  // Rebuilds the index of the file of a framework, dropping what may
+  // have been partially written at its end.
+  Try<Nothing> recover(const FrameworkID& frameworkId)
+  {
+    const string path = path::join(directory, frameworkId.value());
+
+    Try<int> fd = os::open(path, O_RDWR | O_CLOEXEC);
+    if (fd.isError()) {
+      return Error("Failed to open '" + path + "': " + fd.error());
+    }
+
+    hashmap<TaskID, off_t>& tasks = offsets[frameworkId];
+
+    ::protobuf::Reader<Task> reader(fd.get());
+
+    // The offset of the end of the last complete task.
+    off_t end = 0;
+
+    Result<Task> task = None();
+    while (true) {
+      task = reader.read(true);
+
+      if (!task.isSome()) {
+        break;
+      }
+
+      tasks[task.get().task_id()] = end;
+      end = reader.tell();
+    }
+
+    if (task.isError()) {
+      LOG(WARNING) << "Failed to read task history file '" << path << "': "
+                   << task.error();
+    }
+
+    Try<Nothing> truncated = os::ftruncate(fd.get(), end);
+
+    os::close(fd.get());
+
+    if (truncated.isError()) {
+      return Error("Failed to truncate '" + path + "': " + truncated.error());
+    }
+
+    VLOG(1) << "Recovered " << tasks.size() << " tasks of framework "
+            << frameworkId << " from the task history";
+
+    return Nothing();
+  }
+
+  const string directory;
+
+  // The offsets of the tasks in the file of each framework.
+  hashmap<FrameworkID, hashmap<TaskID, off_t>> offsets;
+};
+
+
+TaskHistory::TaskHistory(const string& directory)
+{
+  process = new TaskHistoryProcess(directory);
+  spawn(process);
+}
+
+
+TaskHistory::~TaskHistory()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+void TaskHistory::append(const Task& task)
+{
+  dispatch(process, &TaskHistoryProcess::append, task);
+}
+
+
+Future<Option<Task>> TaskHistory::get(
+    const FrameworkID& frameworkId,
+    const TaskID& taskId)
+{
+  return dispatch(process, &TaskHistoryProcess::get, frameworkId, taskId);
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,67 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_TASK_HISTORY_HPP__
+#define __MASTER_TASK_HISTORY_HPP__
+
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+
+#include <stout/option.hpp>
+
+#include "messages/messages.hpp"
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Forward declaration.
+class TaskHistoryProcess;
+
+// An append-only store on disk of the completed tasks that the master
+// no longer keeps in memory (see '--completed_tasks_dir'), so that
+// they can still be looked up by framework and task ID. There is a
+// file per framework in 'directory' which holds its tasks (as written
+// by 'protobuf::write'), and the offsets of the tasks in the files
+// are kept in memory. The index is rebuilt from the files when the
+// store is created, so that the history survives master failovers.
+class TaskHistory
+{
+public:
+  explicit TaskHistory(const std::string& directory);
+  ~TaskHistory();
+
+  // Appends a task to the store. Failures are only logged, since the
+  // store is best effort.
+  void append(const Task& task);
+
+  // Returns the task last appended with the given IDs, if any.
+  process::Future<Option<Task>> get(
+      const FrameworkID& frameworkId,
+      const TaskID& taskId);
+
+private:
+  TaskHistoryProcess* process;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_TASK_HISTORY_HPP__
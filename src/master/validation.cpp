@@ -22,6 +22,8 @@
 
 #include <mesos/type_utils.hpp>
 
+#include <process/time.hpp>
+
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -120,6 +122,20 @@ Option<Error> validate(const mesos::scheduler::Call& call)
       if (!call.has_reconcile()) {
         return Error("Expecting 'reconcile' to be present");
       }
+
+      if (call.reconcile().has_since()) {
+        if (call.reconcile().tasks_size() > 0) {
+          return Error(
+              "Expecting 'reconcile.since' only for implicit reconciliation");
+        }
+
+        Try<process::Time> since =
+          process::Time::create(call.reconcile().since());
+
+        if (since.isError()) {
+          return Error("Invalid 'reconcile.since': " + since.error());
+        }
+      }
       return None();
 
     case mesos::scheduler::Call::MESSAGE:
@@ -134,6 +150,31 @@ Option<Error> validate(const mesos::scheduler::Call& call)
       }
       return None();
 
+    case mesos::scheduler::Call::BATCH:
+      if (!call.has_batch()) {
+        return Error("Expecting 'batch' to be present");
+      }
+
+      foreach (const mesos::scheduler::Call& batched, call.batch().calls()) {
+        if (batched.type() != mesos::scheduler::Call::ACCEPT &&
+            batched.type() != mesos::scheduler::Call::DECLINE &&
+            batched.type() != mesos::scheduler::Call::ACKNOWLEDGE) {
+          return Error(
+              "Unexpected " + stringify(batched.type()) + " call in 'batch'");
+        }
+
+        if (!(batched.framework_id() == call.framework_id())) {
+          return Error(
+              "'framework_id' differs from 'batch.calls.framework_id'");
+        }
+
+        Option<Error> error = validate(batched);
+        if (error.isSome()) {
+          return Error("Invalid call in 'batch': " + error.get().message);
+        }
+      }
+      return None();
+
     default:
       return Error("Unknown call type");
   }
@@ -238,6 +279,71 @@ Option<Error> validateUniquePersistenceID(
 }
 
 
+// Validates that the parent of each of the given persistent volumes
+// (if any) is one of the checkpointed persistent volumes of the same
+// role on the same disk, since the volume is copied from its parent
+// by the slave.
+Option<Error> validatePersistenceParent(
+    const RepeatedPtrField<Resource>& volumes,
+    const Resources& checkpointedResources)
+{
+  foreach (const Resource& volume, volumes) {
+    if (!volume.has_disk() ||
+        !volume.disk().has_persistence() ||
+        !volume.disk().persistence().has_parent()) {
+      continue;
+    }
+
+    const string& id = volume.disk().persistence().id();
+    const string& parent = volume.disk().persistence().parent();
+
+    if (parent == id) {
+      return Error("Persistent volume '" + id + "' can not be its own parent");
+    }
+
+    // A 'MOUNT' disk is used by a single volume, so a volume on it
+    // can not be on the same disk as its parent.
+    if (volume.disk().has_source() &&
+        volume.disk().source().type() != Resource::DiskInfo::Source::PATH) {
+      return Error(
+          "Persistent volume '" + id + "' with a parent must be on the "
+          "root disk or on a 'PATH' disk");
+    }
+
+    bool found = false;
+
+    foreach (const Resource& candidate,
+             checkpointedResources.persistentVolumes()) {
+      if (candidate.role() != volume.role() ||
+          candidate.disk().persistence().id() != parent ||
+          candidate.disk().has_source() != volume.disk().has_source()) {
+        continue;
+      }
+
+      if (volume.disk().has_source() &&
+          (candidate.disk().source().type() !=
+             Resource::DiskInfo::Source::PATH ||
+           candidate.disk().source().path().root() !=
+             volume.disk().source().path().root())) {
+        continue;
+      }
+
+      found = true;
+      break;
+    }
+
+    if (!found) {
+      return Error(
+          "Parent '" + parent + "' of persistent volume '" + id + "' is not "
+          "a persistent volume of role '" + volume.role() + "' on the "
+          "same disk");
+    }
+  }
+
+  return None();
+}
+
+
 // Validates that all the given resources are persistent volumes.
 Option<Error> validatePersistentVolume(
     const RepeatedPtrField<Resource>& volumes)
@@ -377,23 +483,18 @@ Option<Error> validateExecutorInfo(
 // Validates that the task and the executor are using proper amount of
 // resources. For instance, the used resources by a task on a slave
 // should not exceed the total resources offered on that slave.
-Option<Error> validateResourceUsage(
+static Option<Error> validateResourceUsage(
     const TaskInfo& task,
     Framework* framework,
     Slave* slave,
+    const Resources& taskResources,
+    const Resources& executorResources,
     const Resources& offered)
 {
-  Resources taskResources = task.resources();
-
   if (taskResources.empty()) {
     return Error("Task uses no resources");
   }
 
-  Resources executorResources;
-  if (task.has_executor()) {
-    executorResources = task.executor().resources();
-  }
-
   // Validate minimal cpus and memory resources of executor and log
   // warnings if not set.
   if (task.has_executor()) {
@@ -426,30 +527,39 @@ Option<Error> validateResourceUsage(
 
   // Validate if resources needed by the task (and its executor in
   // case the executor is new) are available.
-  Resources total = taskResources;
-  if (!slave->hasExecutor(framework->id(), task.executor().executor_id())) {
-    total += executorResources;
-  }
-
-  if (!offered.contains(total)) {
-    return Error(
-        "Task uses more resources " + stringify(total) +
-        " than available " + stringify(offered));
+  if (slave->hasExecutor(framework->id(), task.executor().executor_id())) {
+    if (!offered.contains(taskResources)) {
+      return Error(
+          "Task uses more resources " + stringify(taskResources) +
+          " than available " + stringify(offered));
+    }
+  } else {
+    const Resources total = taskResources + executorResources;
+    if (!offered.contains(total)) {
+      return Error(
+          "Task uses more resources " + stringify(total) +
+          " than available " + stringify(offered));
+    }
   }
 
   return None();
 }
 
 
-// Validates that the resources specified by the task are valid.
-Option<Error> validateResources(const TaskInfo& task)
+// Validates the resources of the task and executor (if present), and
+// on success returns them in 'taskResources' and 'executorResources',
+// so that they are only converted (and validated) once per task.
+static Option<Error> validateResources(
+    const TaskInfo& task,
+    Resources* taskResources,
+    Resources* executorResources)
 {
   Option<Error> error = resource::validate(task.resources());
   if (error.isSome()) {
     return Error("Task uses invalid resources: " + error.get().message);
   }
 
-  Resources total = task.resources();
+  *taskResources = task.resources();
 
   if (task.has_executor()) {
     error = resource::validate(task.executor().resources());
@@ -457,9 +567,11 @@ Option<Error> validateResources(const TaskInfo& task)
       return Error("Executor uses invalid resources: " + error.get().message);
     }
 
-    total += task.executor().resources();
+    *executorResources = task.executor().resources();
   }
 
+  const Resources total = *taskResources + *executorResources;
+
   // A task and its executor can either use non-revocable resources
   // or revocable resources of a given name but not both.
   foreach (const string& name, total.names()) {
@@ -479,6 +591,15 @@ Option<Error> validateResources(const TaskInfo& task)
   return None();
 }
 
+
+Option<Error> validateResources(const TaskInfo& task)
+{
+  Resources taskResources;
+  Resources executorResources;
+
+  return validateResources(task, &taskResources, &executorResources);
+}
+
 } // namespace internal {
 
 
@@ -495,27 +616,49 @@ Option<Error> validate(
   // executed does matter! For example, 'validateResourceUsage'
   // assumes that ExecutorInfo is valid which is verified by
   // 'validateExecutorInfo'.
-  vector<lambda::function<Option<Error>()>> validators = {
-    lambda::bind(internal::validateTaskID, task),
-    lambda::bind(internal::validateUniqueTaskID, task, framework),
-    lambda::bind(internal::validateSlaveID, task, slave),
-    lambda::bind(internal::validateExecutorInfo, task, framework, slave),
-    lambda::bind(internal::validateResources, task),
-    lambda::bind(
-        internal::validateResourceUsage, task, framework, slave, offered)
-  };
+  //
+  // NOTE: The validators are called directly (rather than bound into
+  // a list of functions) so that the task is not copied for each of
+  // them, as this is done for every task of every ACCEPT call.
+  Option<Error> error = internal::validateTaskID(task);
+  if (error.isSome()) {
+    return error;
+  }
 
-  // TODO(benh): Add a validateHealthCheck function.
+  error = internal::validateUniqueTaskID(task, framework);
+  if (error.isSome()) {
+    return error;
+  }
 
-  // TODO(jieyu): Add a validateCommandInfo function.
+  error = internal::validateSlaveID(task, slave);
+  if (error.isSome()) {
+    return error;
+  }
 
-  foreach (const lambda::function<Option<Error>()>& validator, validators) {
-    Option<Error> error = validator();
-    if (error.isSome()) {
-      return error;
-    }
+  error = internal::validateExecutorInfo(task, framework, slave);
+  if (error.isSome()) {
+    return error;
+  }
+
+  Resources taskResources;
+  Resources executorResources;
+
+  error = internal::validateResources(
+      task, &taskResources, &executorResources);
+  if (error.isSome()) {
+    return error;
+  }
+
+  error = internal::validateResourceUsage(
+      task, framework, slave, taskResources, executorResources, offered);
+  if (error.isSome()) {
+    return error;
   }
 
+  // TODO(benh): Add a validateHealthCheck function.
+
+  // TODO(jieyu): Add a validateCommandInfo function.
+
   return None();
 }
 
@@ -772,6 +915,13 @@ Option<Error> validate(
     return error;
   }
 
+  error = resource::validatePersistenceParent(
+      create.volumes(), checkpointedResources);
+
+  if (error.isSome()) {
+    return error;
+  }
+
   return None();
 }
 
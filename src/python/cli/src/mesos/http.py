@@ -16,6 +16,21 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+# Helper for building the URL of an HTTP request given a PID, a path,
+# and a query dict (see 'get' below).
+def url(pid, path, query=None):
+    import urllib2
+
+    url = 'http://' + pid[(pid.find('@') + 1):] + path
+
+    if query is not None and len(query) > 0:
+        url += '?' + '&'.join(
+            ['%s=%s' % (urllib2.quote(str(key)), urllib2.quote(str(value)))
+             for (key, value) in query.items()])
+
+    return url
+
+
 # Helper for doing an HTTP GET given a PID, a path, and a query dict.
 # For example:
 #
@@ -33,12 +48,31 @@ def get(pid, path, query=None):
 
     from contextlib import closing
 
-    url = 'http://' + pid[(pid.find('@') + 1):] + path
+    with closing(urllib2.urlopen(url(pid, path, query))) as file:
+        return file.read()
 
-    if query is not None and len(query) > 0:
-        url += '?' + '&'.join(
-            ['%s=%s' % (urllib2.quote(str(key)), urllib2.quote(str(value)))
-             for (key, value) in query.items()])
 
-    with closing(urllib2.urlopen(url)) as file:
-        return file.read()
+# Helper for doing an HTTP GET of a streaming endpoint which responds
+# with 'recordio' encoded records (e.g., '/master/events'), given a
+# PID, a path, and a query dict (see 'get' above). This is a generator
+# which yields each record as soon as it has been received, until the
+# stream is closed. A record is encoded as its length followed by a
+# newline and then the record itself.
+def stream(pid, path, query=None):
+    import urllib2
+
+    from contextlib import closing
+
+    with closing(urllib2.urlopen(url(pid, path, query))) as file:
+        while True:
+            header = file.readline()
+            if header == '':
+                return
+
+            length = int(header.strip())
+
+            record = file.read(length)
+            if len(record) < length:
+                return
+
+            yield record
@@ -31,6 +31,8 @@ const Duration REGISTRATION_RETRY_INTERVAL_MAX = Minutes(1);
 
 const std::string DEFAULT_AUTHENTICATEE = "crammd5";
 
+const Duration METRICS_WINDOW = Minutes(5);
+
 } // namespace scheduler {
 } // namespace internal {
 } // namespace mesos {
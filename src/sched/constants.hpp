@@ -34,6 +34,10 @@ extern const Duration REGISTRATION_RETRY_INTERVAL_MAX;
 // Name of the default, CRAM-MD5 authenticatee.
 extern const std::string DEFAULT_AUTHENTICATEE;
 
+// Window of the statistics of the driver's timer metrics (see
+// --driver_metrics).
+extern const Duration METRICS_WINDOW;
+
 } // namespace scheduler {
 } // namespace internal {
 } // namespace mesos {
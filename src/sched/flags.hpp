@@ -99,11 +99,20 @@ public:
         "master. Use the default '" + DEFAULT_AUTHENTICATEE + "', or\n"
         "load an alternate authenticatee module using MESOS_MODULES.",
         DEFAULT_AUTHENTICATEE);
+
+    add(&Flags::driver_metrics,
+        "driver_metrics",
+        "Whether the scheduler driver publishes metrics about offers,\n"
+        "scheduler callbacks and status update acknowledgements under\n"
+        "'scheduler/' in the '/metrics/snapshot' endpoint of the\n"
+        "scheduler's libprocess.",
+        false);
   }
 
   Duration registration_backoff_factor;
   Option<Modules> modules;
   std::string authenticatee;
+  bool driver_metrics;
 };
 
 } // namespace scheduler {
@@ -50,14 +50,17 @@
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/abort.hpp>
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/flags.hpp>
+#include <stout/gzip.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/ip.hpp>
 #include <stout/lambda.hpp>
@@ -99,7 +102,9 @@ using process::DispatchEvent;
 using process::Future;
 using process::Latch;
 using process::MessageEvent;
+using process::Owned;
 using process::Process;
+using process::Promise;
 using process::UPID;
 
 using std::map;
@@ -172,6 +177,10 @@ public:
 protected:
   virtual void initialize()
   {
+    if (flags.driver_metrics) {
+      driverMetrics.reset(new DriverMetrics(*this));
+    }
+
     install<Event>(&SchedulerProcess::receive);
 
     // TODO(benh): Get access to flags so that we can decide whether
@@ -189,7 +198,8 @@ protected:
     install<ResourceOffersMessage>(
         &SchedulerProcess::resourceOffers,
         &ResourceOffersMessage::offers,
-        &ResourceOffersMessage::pids);
+        &ResourceOffersMessage::pids,
+        &ResourceOffersMessage::compressed_offers);
 
     install<RescindResourceOfferMessage>(
         &SchedulerProcess::rescindOffer,
@@ -264,6 +274,9 @@ protected:
 
     connected = false;
 
+    // The master resends the updates which have not been acknowledged.
+    acknowledgements.clear();
+
     if (master.isSome()) {
       LOG(INFO) << "New master detected at " << master.get().pid();
       link(master.get().pid());
@@ -510,7 +523,7 @@ protected:
           pids.push_back(UPID(id, ip.get(), offer.url().address().port()));
         }
 
-        resourceOffers(from, offers, pids);
+        resourceOffers(from, offers, pids, "");
 
         break;
       }
@@ -761,8 +774,9 @@ protected:
 
   void resourceOffers(
       const UPID& from,
-      const vector<Offer>& offers,
-      const vector<string>& pids)
+      const vector<Offer>& _offers,
+      const vector<string>& pids,
+      const string& compressedOffers)
   {
     if (!running.load()) {
       VLOG(1) << "Ignoring resource offers message because "
@@ -785,6 +799,29 @@ protected:
       return;
     }
 
+    vector<Offer> offers = _offers;
+
+    // The master compresses the offers for frameworks with the
+    // COMPRESSED_OFFERS capability.
+    if (!compressedOffers.empty()) {
+      Try<string> decompressed = gzip::decompress(compressedOffers);
+      if (decompressed.isError()) {
+        LOG(WARNING) << "Ignoring resource offers message because the "
+                     << "offers could not be decompressed: "
+                     << decompressed.error();
+        return;
+      }
+
+      ResourceOffersMessage message;
+      if (!message.ParseFromString(decompressed.get())) {
+        LOG(WARNING) << "Ignoring resource offers message because the "
+                     << "decompressed offers could not be parsed";
+        return;
+      }
+
+      offers = google::protobuf::convert(message.offers());
+    }
+
     // We exit early if `offers` is empty since we don't implement inverse
     // offers in the old scheduler API. It could be empty when there are only
     // inverse offers as part of the `ResourceOffersMessage`.
@@ -809,6 +846,11 @@ protected:
       }
     }
 
+    if (driverMetrics.get() != NULL) {
+      driverMetrics->offers_received += offers.size();
+      driverMetrics->resource_offers.start();
+    }
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -817,6 +859,10 @@ protected:
     scheduler->resourceOffers(driver, offers);
 
     VLOG(1) << "Scheduler::resourceOffers took " << stopwatch.elapsed();
+
+    if (driverMetrics.get() != NULL) {
+      driverMetrics->resource_offers.stop();
+    }
   }
 
   void rescindOffer(const UPID& from, const OfferID& offerId)
@@ -846,6 +892,11 @@ protected:
 
     savedOffers.erase(offerId);
 
+    if (driverMetrics.get() != NULL) {
+      ++driverMetrics->offers_rescinded;
+      driverMetrics->offer_rescinded.start();
+    }
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -854,6 +905,10 @@ protected:
     scheduler->offerRescinded(driver, offerId);
 
     VLOG(1) << "Scheduler::offerRescinded took " << stopwatch.elapsed();
+
+    if (driverMetrics.get() != NULL) {
+      driverMetrics->offer_rescinded.stop();
+    }
   }
 
   void statusUpdate(
@@ -917,6 +972,20 @@ protected:
       status.set_uuid(update.uuid());
     }
 
+    if (driverMetrics.get() != NULL) {
+      // Time the explicit acknowledgement of the update, if any,
+      // from the start of the callback.
+      if (!implicitAcknowledgements &&
+          status.has_uuid() &&
+          status.has_slave_id()) {
+        Owned<Promise<Nothing>> promise(new Promise<Nothing>());
+        driverMetrics->acknowledgement.time(promise->future());
+        acknowledgements[status.uuid()] = promise;
+      }
+
+      driverMetrics->status_update.start();
+    }
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -926,6 +995,10 @@ protected:
 
     VLOG(1) << "Scheduler::statusUpdate took " << stopwatch.elapsed();
 
+    if (driverMetrics.get() != NULL) {
+      driverMetrics->status_update.stop();
+    }
+
     if (implicitAcknowledgements) {
       // Note that we need to look at the atomic 'running' here
       // so that we don't acknowledge the update if the driver was
@@ -1053,6 +1126,10 @@ protected:
 
     VLOG(2) << "Received framework message";
 
+    if (driverMetrics.get() != NULL) {
+      driverMetrics->framework_message.start();
+    }
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -1061,6 +1138,10 @@ protected:
     scheduler->frameworkMessage(driver, executorId, slaveId, data);
 
     VLOG(1) << "Scheduler::frameworkMessage took " << stopwatch.elapsed();
+
+    if (driverMetrics.get() != NULL) {
+      driverMetrics->framework_message.stop();
+    }
   }
 
   void error(const string& message)
@@ -1364,6 +1445,11 @@ protected:
     if (status.has_uuid() && status.has_slave_id()) {
       CHECK_SOME(master);
 
+      if (acknowledgements.contains(status.uuid())) {
+        acknowledgements[status.uuid()]->set(Nothing());
+        acknowledgements.erase(status.uuid());
+      }
+
       VLOG(2) << "Sending ACK for status update " << status.uuid()
               << " of task " << status.task_id()
               << " on slave " << status.slave_id()
@@ -1500,11 +1586,95 @@ private:
     process::metrics::Gauge event_queue_dispatches;
   } metrics;
 
+  // Metrics about offers and the scheduler callbacks, published
+  // only with --driver_metrics. With the event queue metrics above,
+  // they tell time spent waiting on the master from time spent in
+  // the scheduler's own callbacks.
+  struct DriverMetrics
+  {
+    explicit DriverMetrics(const SchedulerProcess& schedulerProcess)
+      : offers_received("scheduler/offers_received"),
+        offers_rescinded("scheduler/offers_rescinded"),
+        outstanding_offers(
+            "scheduler/outstanding_offers",
+            defer(schedulerProcess,
+                  &SchedulerProcess::_outstanding_offers)),
+        resource_offers(
+            "scheduler/callbacks/resource_offers",
+            scheduler::METRICS_WINDOW),
+        offer_rescinded(
+            "scheduler/callbacks/offer_rescinded",
+            scheduler::METRICS_WINDOW),
+        status_update(
+            "scheduler/callbacks/status_update",
+            scheduler::METRICS_WINDOW),
+        framework_message(
+            "scheduler/callbacks/framework_message",
+            scheduler::METRICS_WINDOW),
+        acknowledgement(
+            "scheduler/acknowledgement_latency",
+            scheduler::METRICS_WINDOW)
+    {
+      process::metrics::add(offers_received);
+      process::metrics::add(offers_rescinded);
+      process::metrics::add(outstanding_offers);
+
+      process::metrics::add(resource_offers);
+      process::metrics::add(offer_rescinded);
+      process::metrics::add(status_update);
+      process::metrics::add(framework_message);
+
+      process::metrics::add(acknowledgement);
+    }
+
+    ~DriverMetrics()
+    {
+      process::metrics::remove(offers_received);
+      process::metrics::remove(offers_rescinded);
+      process::metrics::remove(outstanding_offers);
+
+      process::metrics::remove(resource_offers);
+      process::metrics::remove(offer_rescinded);
+      process::metrics::remove(status_update);
+      process::metrics::remove(framework_message);
+
+      process::metrics::remove(acknowledgement);
+    }
+
+    process::metrics::Counter offers_received;
+    process::metrics::Counter offers_rescinded;
+
+    // Offers that have been neither used, declined nor rescinded.
+    process::metrics::Gauge outstanding_offers;
+
+    // Time spent in the scheduler callbacks.
+    process::metrics::Timer<Milliseconds> resource_offers;
+    process::metrics::Timer<Milliseconds> offer_rescinded;
+    process::metrics::Timer<Milliseconds> status_update;
+    process::metrics::Timer<Milliseconds> framework_message;
+
+    // Time from the start of the status update callback until the
+    // scheduler acknowledges the update, without implicit
+    // acknowledgements.
+    process::metrics::Timer<Milliseconds> acknowledgement;
+  };
+
+  Owned<DriverMetrics> driverMetrics;
+
+  // Status updates being timed for their (explicit) acknowledgement,
+  // keyed by uuid.
+  hashmap<string, Owned<Promise<Nothing>>> acknowledgements;
+
   double _event_queue_messages()
   {
     return static_cast<double>(eventCount<MessageEvent>());
   }
 
+  double _outstanding_offers()
+  {
+    return static_cast<double>(savedOffers.size());
+  }
+
   double _event_queue_dispatches()
   {
     return static_cast<double>(eventCount<DispatchEvent>());
@@ -0,0 +1,55 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SCHEDULER_FLAGS_HPP__
+#define __SCHEDULER_FLAGS_HPP__
+
+#include <stout/flags.hpp>
+
+#include "local/flags.hpp"
+
+namespace mesos {
+namespace v1 {
+namespace scheduler {
+
+// Flags of the scheduler library, which are loaded from the
+// environment with the MESOS_ prefix. These include the flags of the
+// local cluster, which is launched when the master is 'local'.
+class Flags : public mesos::internal::local::Flags
+{
+public:
+  Flags()
+  {
+    add(&Flags::max_pipelined_calls,
+        "max_pipelined_calls",
+        "Maximum number of calls, other than SUBSCRIBE, sent to the master\n"
+        "without waiting for their responses. The calls are pipelined on a\n"
+        "single connection so the master still handles them in the order\n"
+        "they are sent. A SUBSCRIBE call is only sent once the calls before\n"
+        "it have been responded to, and the calls after it wait for its\n"
+        "response. Use 1 to wait for the response to each call before\n"
+        "sending the next one.",
+        16);
+  }
+
+  size_t max_pipelined_calls;
+};
+
+} // namespace scheduler {
+} // namespace v1 {
+} // namespace mesos {
+
+#endif // __SCHEDULER_FLAGS_HPP__
@@ -46,6 +46,7 @@
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/flags.hpp>
+#include <stout/gzip.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/ip.hpp>
 #include <stout/lambda.hpp>
@@ -71,6 +72,8 @@
 
 #include "messages/messages.hpp"
 
+#include "scheduler/flags.hpp"
+
 using namespace mesos;
 using namespace mesos::internal;
 using namespace mesos::internal::master;
@@ -81,13 +84,13 @@ using std::queue;
 using std::string;
 using std::vector;
 
+using mesos::internal::recordio::ProtobufDecoder;
 using mesos::internal::recordio::Reader;
 
 using process::Owned;
 using process::wait; // Necessary on some OS's to disambiguate.
 
 using process::http::Pipe;
-using process::http::post;
 using process::http::Response;
 
 using ::recordio::Decoder;
@@ -114,23 +117,27 @@ public:
       disconnected(_disconnected),
       received(_received),
       local(false),
-      detector(NULL)
+      detector(NULL),
+      inflight(0),
+      subscribing(false)
   {
     GOOGLE_PROTOBUF_VERIFY_VERSION;
 
-    // Load any flags from the environment (we use local::Flags in the
-    // event we run in 'local' mode, since it inherits
-    // logging::Flags). In the future, just as the TODO in
+    // Load any flags from the environment (our flags include
+    // local::Flags in the event we run in 'local' mode, since it
+    // inherits logging::Flags). In the future, just as the TODO in
     // local/main.cpp discusses, we'll probably want a way to load
     // master::Flags and slave::Flags as well.
-    local::Flags flags;
-
     Try<Nothing> load = flags.load("MESOS_");
 
     if (load.isError()) {
       EXIT(1) << "Failed to load flags: " << load.error();
     }
 
+    if (flags.max_pipelined_calls == 0) {
+      EXIT(1) << "Invalid value '0' for flag 'max_pipelined_calls'";
+    }
+
     // Initialize libprocess (done here since at some point we might
     // want to use flags to initialize libprocess).
     process::initialize();
@@ -188,18 +195,12 @@ public:
 
   void send(const Call& call)
   {
-    // NOTE: We enqueue the calls to guarantee that a call is sent only after
-    // a response has been received for the previous call.
-    // TODO(vinod): Use HTTP pipelining instead.
+    // NOTE: We enqueue the calls to guarantee that they are sent in
+    // order, and at most 'max_pipelined_calls' of them before their
+    // responses are received.
     calls.push(call);
 
-    if (calls.size() > 1) {
-      return;
-    }
-
-    // If this is the first in the queue send the call.
-    _send(call)
-      .onAny(defer(self(), &Self::___send));
+    ___send();
   }
 
 protected:
@@ -222,6 +223,17 @@ protected:
     // Disconnect the reader upon a master detection callback.
     disconnect();
 
+    // The pipelined calls in flight to the previous master (if any)
+    // fail once it is disconnected.
+    if (pipeline.isSome()) {
+      pipeline.get()
+        .onReady([](http::Connection connection) {
+          connection.disconnect();
+        });
+
+      pipeline = None();
+    }
+
     if (future.get().isNone()) {
       master = None();
 
@@ -281,18 +293,19 @@ protected:
     LOG(WARNING) << "Dropping " << call.type() << ": " << message;
   }
 
-  Future<Nothing> _send(const Call& call)
+  // Returns the response to the call, or None if the call is dropped.
+  Option<Future<Response>> _send(const Call& call)
   {
     if (master.isNone()) {
       drop(call, "Disconnected");
-      return Nothing();
+      return None();
     }
 
     Option<Error> error = validation::scheduler::call::validate(devolve(call));
 
     if (error.isSome()) {
       drop(call, error.get().message);
-      return Nothing();
+      return None();
     }
 
     VLOG(1) << "Sending " << call.type() << " call to " << master.get();
@@ -318,23 +331,61 @@ protected:
           body,
           stringify(contentType));
     } else {
-      response = post(
-          master.get(),
-          "api/v1/scheduler",
-          headers,
-          body,
-          stringify(contentType));
+      // The other calls are pipelined on a persistent connection,
+      // which keeps them in order.
+      const http::URL url(
+          "http",
+          master.get().address.ip,
+          master.get().address.port,
+          master.get().id + "/api/v1/scheduler");
+
+      if (pipeline.isNone()) {
+        pipeline = http::connect(url);
+      }
+
+      http::Request request;
+      request.method = "POST";
+      request.url = url;
+      request.headers = headers;
+      request.headers["Content-Type"] = stringify(contentType);
+      request.body = body;
+      request.keepAlive = true;
+
+      response = pipeline.get()
+        .then([request](http::Connection connection) {
+          return connection.send(request);
+        });
     }
 
-    return response
-      .onAny(defer(self(), &Self::__send, call, lambda::_1))
-      .then([]() { return Nothing(); });
+    return response;
   }
 
-  void __send(const Call& call, const Future<Response>& response)
+  void __send(
+      const Call& call,
+      const Future<http::Connection>& pipelined,
+      const Future<Response>& response)
   {
     CHECK(!response.isDiscarded());
 
+    if (call.type() == Call::SUBSCRIBE) {
+      subscribing = false;
+    } else {
+      CHECK_LT(0u, inflight);
+      inflight--;
+
+      // Reconnect for the next calls if the connection has failed,
+      // unless a new one has already been made.
+      if (response.isFailed() &&
+          pipeline.isSome() &&
+          pipeline.get() == pipelined) {
+        pipeline = None();
+      }
+    }
+
+    // Send the calls which were waiting for this one, once this
+    // response has been handled (see below).
+    dispatch(self(), &Self::___send);
+
     // This can happen during a master failover or a network blip
     // causing the socket to timeout. Eventually, the scheduler would
     // detect the disconnection via ZK(disconnect()) or lack of heartbeats.
@@ -352,11 +403,19 @@ protected:
 
       Pipe::Reader reader = response.get().reader.get();
 
-      auto deserializer =
-        lambda::bind(deserialize<Event>, contentType, lambda::_1);
+      Owned<Reader<Event>> decoder;
+
+      // Protobuf events are parsed directly from the received data,
+      // which avoids copying large events (e.g., OFFERS).
+      if (contentType == ContentType::PROTOBUF) {
+        decoder.reset(new Reader<Event>(ProtobufDecoder<Event>(), reader));
+      } else {
+        auto deserializer =
+          lambda::bind(deserialize<Event>, contentType, lambda::_1);
 
-      Owned<Reader<Event>> decoder(
-          new Reader<Event>(Decoder<Event>(deserializer), reader));
+        decoder.reset(
+            new Reader<Event>(Decoder<Event>(deserializer), reader));
+      }
 
       connection = Connection {reader, decoder};
 
@@ -385,15 +444,39 @@ protected:
           response.get().body + ") for " + stringify(call.type()));
   }
 
+  // Sends the queued calls, as long as fewer than
+  // 'max_pipelined_calls' calls are in flight. A SUBSCRIBE call is
+  // not pipelined: it waits for the calls in flight and the next calls
+  // wait for its response, since they depend on the subscription.
   void ___send()
   {
-    CHECK_LT(0u, calls.size());
-    calls.pop();
+    while (!calls.empty() &&
+           !subscribing &&
+           inflight < flags.max_pipelined_calls) {
+      const Call call = calls.front();
+
+      if (call.type() == Call::SUBSCRIBE && inflight > 0) {
+        return;
+      }
+
+      calls.pop();
+
+      Option<Future<Response>> response = _send(call);
+      if (response.isNone()) {
+        continue;
+      }
 
-    // Execute the next event in the queue.
-    if (!calls.empty()) {
-      _send(calls.front())
-        .onAny(defer(self(), &Self::___send));
+      Future<http::Connection> pipelined;
+      if (call.type() == Call::SUBSCRIBE) {
+        subscribing = true;
+      } else {
+        CHECK_SOME(pipeline);
+        pipelined = pipeline.get();
+        inflight++;
+      }
+
+      response.get()
+        .onAny(defer(self(), &Self::__send, call, pipelined, lambda::_1));
     }
   }
 
@@ -436,12 +519,44 @@ protected:
     if (event.get().isError()) {
       error("Failed to de-serialize event: " + event.get().error());
     } else {
-      receive(event.get().get(), false);
+      Try<Event> inflated = inflate(event.get().get());
+      if (inflated.isError()) {
+        error("Failed to decompress event: " + inflated.error());
+      } else {
+        receive(inflated.get(), false);
+      }
     }
 
     read();
   }
 
+  // Decompresses the offers of an OFFERS event, which the master
+  // compresses for frameworks with the COMPRESSED_OFFERS capability.
+  Try<Event> inflate(Event event)
+  {
+    if (event.type() != Event::OFFERS ||
+        !event.offers().has_compressed_offers()) {
+      return event;
+    }
+
+    Try<string> decompressed =
+      gzip::decompress(event.offers().compressed_offers());
+
+    if (decompressed.isError()) {
+      return Error(decompressed.error());
+    }
+
+    Event::Offers offers;
+    if (!offers.ParseFromString(decompressed.get())) {
+      return Error("Failed to parse the decompressed offers");
+    }
+
+    event.mutable_offers()->clear_compressed_offers();
+    event.mutable_offers()->mutable_offers()->Swap(offers.mutable_offers());
+
+    return event;
+  }
+
   void receive(const Event& event, bool isLocallyInjected)
   {
     // Check if we're disconnected but received an event.
@@ -500,12 +615,25 @@ private:
 
   bool local; // Whether or not we launched a local cluster.
 
+  Flags flags;
+
   MasterDetector* detector;
 
   queue<Event> events;
 
+  // The calls which have not been sent yet.
   queue<Call> calls;
 
+  // The persistent connection to the master on which the calls other
+  // than SUBSCRIBE are pipelined.
+  Option<Future<http::Connection>> pipeline;
+
+  // The number of pipelined calls waiting for their responses.
+  size_t inflight;
+
+  // Whether a SUBSCRIBE call is waiting for its response.
+  bool subscribing;
+
   Option<UPID> master;
 };
 
@@ -30,11 +30,16 @@ const Duration EXECUTOR_REREGISTER_TIMEOUT = Seconds(2);
 const Duration EXECUTOR_SIGNAL_ESCALATION_TIMEOUT = Seconds(3);
 const Duration STATUS_UPDATE_RETRY_INTERVAL_MIN = Seconds(10);
 const Duration STATUS_UPDATE_RETRY_INTERVAL_MAX = Minutes(10);
+const size_t STATUS_UPDATE_RETRIES_MAX = 1000;
+const Duration STATUS_UPDATE_RETRIES_INTERVAL = Seconds(1);
+const Bytes STATUS_UPDATE_JOURNAL_MAX_SIZE = Megabytes(4);
+const Bytes STATUS_UPDATE_BATCH_MAX_SIZE = Kilobytes(256);
 const Duration DEFAULT_REGISTRATION_BACKOFF_FACTOR = Seconds(1);
 const Duration REGISTER_RETRY_INTERVAL_MAX = Minutes(1);
 const Duration GC_DELAY = Weeks(1);
 const double GC_DISK_HEADROOM = 0.1;
 const Duration DISK_WATCH_INTERVAL = Minutes(1);
+const Duration MIN_DISK_WATCH_INTERVAL = Seconds(1);
 const Duration RECOVERY_TIMEOUT = Minutes(15);
 const uint32_t MAX_COMPLETED_FRAMEWORKS = 50;
 const uint32_t MAX_COMPLETED_EXECUTORS_PER_FRAMEWORK = 150;
@@ -43,6 +48,7 @@ const double DEFAULT_CPUS = 1;
 const Bytes DEFAULT_MEM = Gigabytes(1);
 const Bytes DEFAULT_DISK = Gigabytes(10);
 const std::string DEFAULT_PORTS = "[31000-32000]";
+const std::string HUGEPAGES_RESOURCE_PREFIX = "hugepages_";
 #ifdef WITH_NETWORK_ISOLATOR
 const uint16_t DEFAULT_EPHEMERAL_PORTS_PER_CONTAINER = 1024;
 #endif
@@ -52,6 +58,8 @@ const Duration DOCKER_INSPECT_DELAY = Seconds(1);
 const Duration DOCKER_VERSION_WAIT_TIMEOUT = Seconds(5);
 const std::string DEFAULT_AUTHENTICATEE = "crammd5";
 const std::string COMMAND_EXECUTOR_ROOTFS_CONTAINER_PATH = ".rootfs";
+const std::string SHARED_COMMAND_EXECUTOR_ID_PREFIX = "command-executor";
+const std::string FETCHER_CACHE_VIRTUAL_PATH = "/fetcher/cache";
 
 Duration DEFAULT_MASTER_PING_TIMEOUT()
 {
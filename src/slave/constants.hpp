@@ -42,9 +42,28 @@ extern const Duration EXECUTOR_SIGNAL_ESCALATION_TIMEOUT;
 extern const Duration RECOVERY_TIMEOUT;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL_MIN;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL_MAX;
+
+// Maximum number of status updates which are resent to the master at
+// once, the others are resent after the retries interval.
+extern const size_t STATUS_UPDATE_RETRIES_MAX;
+extern const Duration STATUS_UPDATE_RETRIES_INTERVAL;
+
+// Size of the status update journal after which its records are
+// moved into the updates files of the tasks.
+extern const Bytes STATUS_UPDATE_JOURNAL_MAX_SIZE;
+
+// Size of the pending status updates after which they are forwarded
+// to the master, without waiting for the batch interval to elapse.
+extern const Bytes STATUS_UPDATE_BATCH_MAX_SIZE;
+
 extern const Duration GC_DELAY;
 extern const Duration DISK_WATCH_INTERVAL;
 
+// The minimum interval between the disk usage checks, which are done
+// more often (than every --disk_watch_interval) as the disk usage
+// gets close to the point where all sandboxes are garbage collected.
+extern const Duration MIN_DISK_WATCH_INTERVAL;
+
 // Default backoff interval used by the slave to wait before registration.
 extern const Duration DEFAULT_REGISTRATION_BACKOFF_FACTOR;
 
@@ -79,6 +98,11 @@ extern const Bytes DEFAULT_DISK;
 // Default ports range offered by the slave.
 extern const std::string DEFAULT_PORTS;
 
+// Prefix of the names of the hugepages resources, which is followed
+// by the page size, e.g., 'hugepages_2MB'. The hugepages resources
+// are counted in pages.
+extern const std::string HUGEPAGES_RESOURCE_PREFIX;
+
 // Default cpu resource given to a command executor.
 const double DEFAULT_EXECUTOR_CPUS = 0.1;
 
@@ -119,6 +143,14 @@ Duration DEFAULT_MASTER_PING_TIMEOUT();
 // Container path that the slave sets to mount the command executor rootfs to.
 extern const std::string COMMAND_EXECUTOR_ROOTFS_CONTAINER_PATH;
 
+// Prefix of the id of the command executor that runs the command
+// tasks of a framework when '--shared_command_executor' is set.
+extern const std::string SHARED_COMMAND_EXECUTOR_ID_PREFIX;
+
+// Virtual path under which the shared fetcher cache files are served
+// to peer agents through '/files' when '--fetcher_peers' is set.
+extern const std::string FETCHER_CACHE_VIRTUAL_PATH;
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
@@ -92,6 +92,9 @@ public:
     mesos::internal::logger::rotate::Flags outFlags;
     outFlags.max_size = flags.max_stdout_size;
     outFlags.logrotate_options = flags.logrotate_stdout_options;
+    outFlags.max_files = flags.max_stdout_files;
+    outFlags.compress = flags.compress_stdout;
+    outFlags.max_rate = flags.max_stdout_rate;
     outFlags.log_filename = path::join(sandboxDirectory, "stdout");
     outFlags.logrotate_path = flags.logrotate_path;
 
@@ -112,6 +115,9 @@ public:
     mesos::internal::logger::rotate::Flags errFlags;
     errFlags.max_size = flags.max_stderr_size;
     errFlags.logrotate_options = flags.logrotate_stderr_options;
+    errFlags.max_files = flags.max_stderr_files;
+    errFlags.compress = flags.compress_stderr;
+    errFlags.max_rate = flags.max_stderr_rate;
     errFlags.log_filename = path::join(sandboxDirectory, "stderr");
     errFlags.logrotate_path = flags.logrotate_path;
 
@@ -212,5 +218,22 @@ org_apache_mesos_LogrotateContainerLogger(
         return NULL;
       }
 
+      if ((flags.max_stdout_files.isSome() &&
+           flags.logrotate_stdout_options.isSome()) ||
+          (flags.max_stderr_files.isSome() &&
+           flags.logrotate_stderr_options.isSome())) {
+        LOG(ERROR) << "Failed to parse parameters: the '--max_*_files' "
+                   << "parameters can not be combined with the "
+                   << "'--logrotate_*_options' parameters";
+        return NULL;
+      }
+
+      if ((flags.compress_stdout && flags.max_stdout_files.isNone()) ||
+          (flags.compress_stderr && flags.max_stderr_files.isNone())) {
+        LOG(ERROR) << "Failed to parse parameters: the '--compress_*' "
+                   << "parameters require the '--max_*_files' parameters";
+        return NULL;
+      }
+
       return new mesos::internal::logger::LogrotateContainerLogger(flags);
     });
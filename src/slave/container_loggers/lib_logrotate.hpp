@@ -78,6 +78,50 @@ struct Flags : public virtual flags::FlagsBase
         "  }\n"
         "NOTE: The 'size' option will be overriden by this module.");
 
+    add(&max_stdout_files,
+        "max_stdout_files",
+        "If specified, stdout is rotated without running 'logrotate',\n"
+        "keeping at most this many stdout log files (including the leading\n"
+        "log file). This avoids forking 'logrotate' each time a log file\n"
+        "fills up.  Must not be combined with 'logrotate_stdout_options'.",
+        &Flags::validateFiles);
+
+    add(&max_stderr_files,
+        "max_stderr_files",
+        "If specified, stderr is rotated without running 'logrotate',\n"
+        "keeping at most this many stderr log files (including the leading\n"
+        "log file). This avoids forking 'logrotate' each time a log file\n"
+        "fills up.  Must not be combined with 'logrotate_stderr_options'.",
+        &Flags::validateFiles);
+
+    add(&compress_stdout,
+        "compress_stdout",
+        "Whether to compress rotated stdout log files, which are named\n"
+        "'stdout.1.gz', etc.  They can still be read at an offset through\n"
+        "the '/files/read' endpoint.  Requires 'max_stdout_files'.",
+        false);
+
+    add(&compress_stderr,
+        "compress_stderr",
+        "Whether to compress rotated stderr log files, which are named\n"
+        "'stderr.1.gz', etc.  They can still be read at an offset through\n"
+        "the '/files/read' endpoint.  Requires 'max_stderr_files'.",
+        false);
+
+    add(&max_stdout_rate,
+        "max_stdout_rate",
+        "If specified, the maximum number of bytes per second of a\n"
+        "container's stdout that are logged.  Output beyond this rate is\n"
+        "dropped (the container is never blocked on writing) and the number\n"
+        "of dropped bytes is noted in the log file.");
+
+    add(&max_stderr_rate,
+        "max_stderr_rate",
+        "If specified, the maximum number of bytes per second of a\n"
+        "container's stderr that are logged.  Output beyond this rate is\n"
+        "dropped (the container is never blocked on writing) and the number\n"
+        "of dropped bytes is noted in the log file.");
+
     add(&launcher_dir,
         "launcher_dir",
         "Directory path of Mesos binaries.  The logrotate container logger\n"
@@ -125,12 +169,31 @@ struct Flags : public virtual flags::FlagsBase
     return None();
   }
 
+  static Option<Error> validateFiles(const Option<size_t>& value)
+  {
+    if (value.isSome() && value.get() == 0) {
+      return Error(
+          "Expected --max_stdout_files and --max_stderr_files of at least 1");
+    }
+
+    return None();
+  }
+
   Bytes max_stdout_size;
   Option<std::string> logrotate_stdout_options;
 
   Bytes max_stderr_size;
   Option<std::string> logrotate_stderr_options;
 
+  Option<size_t> max_stdout_files;
+  Option<size_t> max_stderr_files;
+
+  bool compress_stdout;
+  bool compress_stderr;
+
+  Option<Bytes> max_stdout_rate;
+  Option<Bytes> max_stderr_rate;
+
   std::string launcher_dir;
   std::string logrotate_path;
 };
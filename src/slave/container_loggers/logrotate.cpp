@@ -21,6 +21,7 @@
 #include <functional>
 #include <string>
 
+#include <process/clock.hpp>
 #include <process/dispatch.hpp>
 #include <process/io.hpp>
 #include <process/process.hpp>
@@ -33,9 +34,15 @@
 #include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
+#include <stout/os/exists.hpp>
+#include <stout/os/read.hpp>
+#include <stout/os/rename.hpp>
+#include <stout/os/rm.hpp>
 #include <stout/os/shell.hpp>
 #include <stout/os/write.hpp>
 
+#include "files/compressed.hpp"
+
 #include "slave/container_loggers/logrotate.hpp"
 
 
@@ -49,7 +56,10 @@ public:
   LogrotateLoggerProcess(const Flags& _flags)
     : flags(_flags),
       leading(None()),
-      bytesWritten(0)
+      bytesWritten(0),
+      windowStart(Clock::now()),
+      windowBytes(0),
+      droppedBytes(0)
   {
     // Prepare a buffer for reading from the `incoming` pipe.
     length = sysconf(_SC_PAGE_SIZE);
@@ -71,6 +81,28 @@ public:
   // Prepares and starts the loop which reads from stdin, writes to the
   // leading log file, and manages total log size.
   Future<Nothing> run()
+  {
+    if (flags.max_files.isNone()) {
+      Try<Nothing> result = configure();
+      if (result.isError()) {
+        return Failure(result.error());
+      }
+    }
+
+    // NOTE: This is a prerequisuite for `io::read`.
+    Try<Nothing> nonblock = os::nonblock(STDIN_FILENO);
+    if (nonblock.isError()) {
+      return Failure("Failed to set nonblocking pipe: " + nonblock.error());
+    }
+
+    // NOTE: This does not block.
+    loop();
+
+    return promise.future();
+  }
+
+  // Writes the `logrotate` configuration file used by `rotate()`.
+  Try<Nothing> configure()
   {
     // Populate the `logrotate` configuration file.
     // See `Flags::logrotate_options` for the format.
@@ -88,19 +120,10 @@ public:
         flags.log_filename.get() + CONF_SUFFIX, config);
 
     if (result.isError()) {
-      return Failure("Failed to write configuration file: " + result.error());
-    }
-
-    // NOTE: This is a prerequisuite for `io::read`.
-    Try<Nothing> nonblock = os::nonblock(STDIN_FILENO);
-    if (nonblock.isError()) {
-      return Failure("Failed to set nonblocking pipe: " + nonblock.error());
+      return Error("Failed to write configuration file: " + result.error());
     }
 
-    // NOTE: This does not block.
-    loop();
-
-    return promise.future();
+    return Nothing();
   }
 
   // Reads from stdin and writes to the leading log file.
@@ -116,8 +139,10 @@ public:
         }
 
         // Do log rotation (if necessary) and write the bytes to the
-        // leading log file.
-        Try<Nothing> result = write(readSize);
+        // leading log file, unless they exceed the `--max_rate`.
+        Try<Nothing> result = throttle(readSize)
+          ? Try<Nothing>(Nothing())
+          : write(std::string(buffer, readSize));
         if (result.isError()) {
           promise.fail("Failed to write: " + result.error());
           return Nothing();
@@ -130,14 +155,52 @@ public:
       });
   }
 
-  // Writes the buffer from stdin to the leading log file.
+  // Returns true if `readSize` bytes read from stdin should be dropped
+  // to keep within `--max_rate`. The rate is enforced over windows of
+  // one second; the number of bytes dropped during a window is noted
+  // in the leading log file once the next window starts.
+  bool throttle(size_t readSize)
+  {
+    if (flags.max_rate.isNone()) {
+      return false;
+    }
+
+    const Time now = Clock::now();
+
+    if (now - windowStart >= Seconds(1)) {
+      if (droppedBytes > 0) {
+        Try<Nothing> result = write(
+            "[mesos] Dropped " + stringify(droppedBytes) +
+            " bytes of output exceeding " + stringify(flags.max_rate.get()) +
+            " per second\n");
+
+        if (result.isError()) {
+          std::cerr << "Failed to write: " << result.error() << std::endl;
+        }
+      }
+
+      windowStart = now;
+      windowBytes = 0;
+      droppedBytes = 0;
+    }
+
+    if (windowBytes + readSize > flags.max_rate.get().bytes()) {
+      droppedBytes += readSize;
+      return true;
+    }
+
+    windowBytes += readSize;
+    return false;
+  }
+
+  // Writes the data from stdin to the leading log file.
   // When the number of written bytes exceeds `--max_size`, the leading
   // log file is rotated.  When the number of log files exceed `--max_files`,
   // the oldest log file is deleted.
-  Try<Nothing> write(size_t readSize)
+  Try<Nothing> write(const std::string& data)
   {
     // Rotate the log file if it will grow beyond the `--max_size`.
-    if (bytesWritten + readSize > flags.max_size.bytes()) {
+    if (bytesWritten + data.size() > flags.max_size.bytes()) {
       rotate();
     }
 
@@ -162,19 +225,19 @@ public:
     // NOTE: We do not exit on error here since we are prioritizing
     // clearing the STDIN pipe (which would otherwise potentially block
     // the container on write) over log fidelity.
-    Try<Nothing> result =
-      os::write(leading.get(), std::string(buffer, readSize));
+    Try<Nothing> result = os::write(leading.get(), data);
 
     if (result.isError()) {
       std::cerr << "Failed to write: " << result.error() << std::endl;
     }
 
-    bytesWritten += readSize;
+    bytesWritten += data.size();
 
     return Nothing();
   }
 
-  // Calls `logrotate` on the leading log file and resets the `bytesWritten`.
+  // Calls `logrotate` on the leading log file (or shifts the log files
+  // when `--max_files` is specified) and resets the `bytesWritten`.
   void rotate()
   {
     if (leading.isSome()) {
@@ -182,6 +245,13 @@ public:
       leading = None();
     }
 
+    if (flags.max_files.isSome()) {
+      shift(flags.max_files.get());
+
+      bytesWritten = 0;
+      return;
+    }
+
     // Call `logrotate` to move around the files.
     // NOTE: If `logrotate` fails for whatever reason, we will ignore
     // the error and continue logging.  In case the leading log file
@@ -196,6 +266,91 @@ public:
     bytesWritten = 0;
   }
 
+  // Renames `<log_filename>.i` to `<log_filename>.(i+1)` and the leading
+  // log file to `<log_filename>.1` (compressing it with `--compress`),
+  // deleting the oldest log file so that at most `files` log files
+  // remain. This avoids forking `logrotate` each time the leading log
+  // file fills up.
+  // NOTE: Like with `logrotate`, errors are ignored and we continue
+  // appending to the existing leading log file if it was not renamed.
+  void shift(size_t files)
+  {
+    const std::string& log = flags.log_filename.get();
+
+    if (files == 1) {
+      os::rm(log);
+      return;
+    }
+
+    // Returns the path of the i-th rotated log file.
+    auto rotated = [this, &log](size_t i) {
+      return log + "." + stringify(i) + (flags.compress ? ".gz" : "");
+    };
+
+    remove(rotated(files - 1));
+
+    for (size_t i = files - 2; i > 0; i--) {
+      move(rotated(i), rotated(i + 1));
+    }
+
+    if (!flags.compress) {
+      os::rename(log, rotated(1));
+      return;
+    }
+
+    // NOTE: The leading log file is at most `--max_size` large, which
+    // is compressed in memory.
+    Try<std::string> data = os::read(log);
+    if (data.isError()) {
+      std::cerr << "Failed to read '" << log << "': " << data.error()
+                << std::endl;
+      return;
+    }
+
+    Try<Nothing> write =
+      mesos::internal::files::write(rotated(1), data.get());
+
+    if (write.isError()) {
+      std::cerr << "Failed to compress '" << log << "': " << write.error()
+                << std::endl;
+
+      // Keep the uncompressed log file rather than losing it.
+      remove(rotated(1));
+      os::rename(log, log + ".1");
+      return;
+    }
+
+    os::rm(log);
+  }
+
+  // Removes a rotated log file, along with its index if compressed.
+  void remove(const std::string& path)
+  {
+    const std::string index = path + mesos::internal::files::INDEX_SUFFIX;
+
+    if (os::exists(index)) {
+      os::rm(index);
+    }
+
+    if (os::exists(path)) {
+      os::rm(path);
+    }
+  }
+
+  // Renames a rotated log file, along with its index if compressed.
+  void move(const std::string& from, const std::string& to)
+  {
+    const std::string index = mesos::internal::files::INDEX_SUFFIX;
+
+    if (os::exists(from + index)) {
+      os::rename(from + index, to + index);
+    }
+
+    if (os::exists(from)) {
+      os::rename(from, to);
+    }
+  }
+
 private:
   Flags flags;
 
@@ -207,6 +362,11 @@ private:
   Option<int> leading;
   size_t bytesWritten;
 
+  // For enforcing the `--max_rate`.
+  Time windowStart;
+  size_t windowBytes;
+  size_t droppedBytes;
+
   // Used to capture when log rotation has completed because the
   // underlying process/input has terminated.
   Promise<Nothing> promise;
@@ -224,6 +384,15 @@ int main(int argc, char** argv)
     EXIT(EXIT_FAILURE) << flags.usage(load.error());
   }
 
+  if (flags.max_files.isSome() && flags.logrotate_options.isSome()) {
+    EXIT(EXIT_FAILURE) << flags.usage(
+        "Only one of --max_files and --logrotate_options may be specified");
+  }
+
+  if (flags.compress && flags.max_files.isNone()) {
+    EXIT(EXIT_FAILURE) << flags.usage("--compress requires --max_files");
+  }
+
   // Make sure this process is running in its own session.
   // This ensures that, if the parent process (presumably the Mesos agent)
   // terminates, this logger process will continue to run.
@@ -74,6 +74,37 @@ struct Flags : public virtual flags::FlagsBase
         "  }\n"
         "NOTE: The 'size' option will be overriden by this command.");
 
+    add(&max_files,
+        "max_files",
+        "If specified, this command rotates the logs itself instead of\n"
+        "running 'logrotate', keeping at most this many log files\n"
+        "(including the leading log file).  Rotated log files are named\n"
+        "'<log_filename>.1', '<log_filename>.2', etc., with the lowest\n"
+        "number being the most recent.  '--logrotate_options' must not\n"
+        "be specified with this option.",
+        [](const Option<size_t>& value) -> Option<Error> {
+          if (value.isSome() && value.get() == 0) {
+            return Error("Expected --max_files of at least 1");
+          }
+          return None();
+        });
+
+    add(&compress,
+        "compress",
+        "Whether to compress the rotated log files, which are then named\n"
+        "'<log_filename>.1.gz', etc.  The files are compressed in frames\n"
+        "listed in an index file next to them (with an '.index' suffix),\n"
+        "so that they can be read at an offset without decompressing them\n"
+        "entirely.  Requires '--max_files'.",
+        false);
+
+    add(&max_rate,
+        "max_rate",
+        "If specified, the maximum number of bytes per second written to\n"
+        "the log files.  Output beyond this rate is still read from STDIN\n"
+        "(so the writer is never blocked) but is dropped, and a line noting\n"
+        "the number of dropped bytes is written to the leading log file.");
+
     add(&log_filename,
         "log_filename",
         "Absolute path to the leading log file.\n"
@@ -113,6 +144,9 @@ struct Flags : public virtual flags::FlagsBase
 
   Bytes max_size;
   Option<std::string> logrotate_options;
+  Option<size_t> max_files;
+  bool compress;
+  Option<Bytes> max_rate;
   Option<std::string> log_filename;
   std::string logrotate_path;
 };
@@ -108,6 +108,13 @@ private:
       vector<Containerizer*>::iterator containerizer,
       bool launched);
 
+  // Returns the first containerizer, starting at 'containerizer',
+  // which supports the container of the task or executor (or the end).
+  vector<Containerizer*>::iterator find(
+      vector<Containerizer*>::iterator containerizer,
+      const Option<TaskInfo>& taskInfo,
+      const ExecutorInfo& executorInfo);
+
   vector<Containerizer*> containerizers_;
 
   // The states that the composing containerizer cares about for the
@@ -318,9 +325,14 @@ Future<bool> ComposingContainerizerProcess::launch(
                    "' is already launching");
   }
 
-  // Try each containerizer. If none of them handle the
-  // TaskInfo/ExecutorInfo then return a Failure.
-  vector<Containerizer*>::iterator containerizer = containerizers_.begin();
+  // Try each containerizer which supports the container of the
+  // ExecutorInfo. If none of them handle it then return false.
+  vector<Containerizer*>::iterator containerizer =
+    find(containerizers_.begin(), None(), executorInfo);
+
+  if (containerizer == containerizers_.end()) {
+    return false;
+  }
 
   Container* container = new Container();
   container->state = LAUNCHING;
@@ -379,7 +391,7 @@ Future<bool> ComposingContainerizerProcess::_launch(
   }
 
   // Try the next containerizer.
-  ++containerizer;
+  containerizer = find(++containerizer, taskInfo, executorInfo);
 
   if (containerizer == containerizers_.end()) {
     containers_.erase(containerId);
@@ -439,9 +451,14 @@ Future<bool> ComposingContainerizerProcess::launch(
                    "' is already launching");
   }
 
-  // Try each containerizer. If none of them handle the
-  // TaskInfo/ExecutorInfo then return a Failure.
-  vector<Containerizer*>::iterator containerizer = containerizers_.begin();
+  // Try each containerizer which supports the container of the
+  // TaskInfo/ExecutorInfo. If none of them handle it then return false.
+  vector<Containerizer*>::iterator containerizer =
+    find(containerizers_.begin(), taskInfo, executorInfo);
+
+  if (containerizer == containerizers_.end()) {
+    return false;
+  }
 
   Container* container = new Container();
   container->state = LAUNCHING;
@@ -472,6 +489,29 @@ Future<bool> ComposingContainerizerProcess::launch(
 }
 
 
+vector<Containerizer*>::iterator ComposingContainerizerProcess::find(
+    vector<Containerizer*>::iterator containerizer,
+    const Option<TaskInfo>& taskInfo,
+    const ExecutorInfo& executorInfo)
+{
+  // The container of the task takes precedence over the one of the
+  // executor, as it does for the containerizers.
+  Option<ContainerInfo::Type> type = None();
+  if (taskInfo.isSome() && taskInfo.get().has_container()) {
+    type = taskInfo.get().container().type();
+  } else if (executorInfo.has_container()) {
+    type = executorInfo.container().type();
+  }
+
+  while (containerizer != containerizers_.end() &&
+         !(*containerizer)->supports(type)) {
+    ++containerizer;
+  }
+
+  return containerizer;
+}
+
+
 Future<Nothing> ComposingContainerizerProcess::update(
     const ContainerID& containerId,
     const Resources& resources)
@@ -17,7 +17,9 @@
 #include <map>
 #include <vector>
 
+#include <process/async.hpp>
 #include <process/dispatch.hpp>
+#include <process/future.hpp>
 #include <process/owned.hpp>
 
 #include <stout/fs.hpp>
@@ -29,6 +31,11 @@
 
 #include "hook/manager.hpp"
 
+#ifdef __linux__
+#include "linux/hugepages.hpp"
+#endif // __linux__
+
+#include "slave/constants.hpp"
 #include "slave/flags.hpp"
 #include "slave/slave.hpp"
 
@@ -92,6 +99,32 @@ Try<Resources> Containerizer::resources(const Flags& flags)
         flags.default_role).get();
   }
 
+  // The memory reserved for hugepages, which is offered as hugepages
+  // resources rather than as memory.
+  Bytes reserved;
+
+#ifdef __linux__
+  // Hugepages resources, for each page size.
+  Try<vector<hugepages::Pool>> pools = hugepages::pools();
+  if (pools.isError()) {
+    LOG(WARNING) << "Failed to auto-detect the hugepages: '"
+                 << pools.error() << "'";
+  } else {
+    foreach (const hugepages::Pool& pool, pools.get()) {
+      reserved += pool.size * pool.total;
+
+      const string name = HUGEPAGES_RESOURCE_PREFIX + stringify(pool.size);
+      if (pool.total > 0 &&
+          !strings::contains(flags.resources.getOrElse(""), name)) {
+        resources += Resources::parse(
+            name,
+            stringify(pool.total),
+            flags.default_role).get();
+      }
+    }
+  }
+#endif // __linux__
+
   // Memory resource.
   if (!strings::contains(flags.resources.getOrElse(""), "mem")) {
     // No memory specified so probe OS or resort to DEFAULT_MEM.
@@ -104,6 +137,8 @@ Try<Resources> Containerizer::resources(const Flags& flags)
       mem = DEFAULT_MEM;
     } else {
       Bytes total = mem_.get().total;
+      total = total > reserved ? total - reserved : Bytes(0);
+
       if (total >= Gigabytes(2)) {
         mem = total - Gigabytes(1); // Leave 1GB free.
       } else {
@@ -163,6 +198,54 @@ Try<Resources> Containerizer::resources(const Flags& flags)
 }
 
 
+// Creates the containerizer of a single type, see
+// 'Containerizer::create' below.
+static Try<Containerizer*> create(
+    const string& type,
+    const Flags& flags,
+    bool local,
+    Fetcher* fetcher)
+{
+  if (type == "mesos") {
+    Try<MesosContainerizer*> containerizer =
+      MesosContainerizer::create(flags, local, fetcher);
+    if (containerizer.isError()) {
+      return Error("Could not create MesosContainerizer: " +
+                   containerizer.error());
+    }
+
+    return containerizer.get();
+  } else if (type == "docker") {
+    Try<DockerContainerizer*> containerizer =
+      DockerContainerizer::create(flags, fetcher);
+    if (containerizer.isError()) {
+      return Error("Could not create DockerContainerizer: " +
+                   containerizer.error());
+    }
+
+    return containerizer.get();
+  } else if (type == "external") {
+    if (flags.container_logger.isSome()) {
+      return Error(
+          "The external containerizer does not support custom container "
+          "logger modules.  The '--containerizers=external' flag cannot be "
+          "set along with '--container_logger=...'");
+    }
+
+    Try<ExternalContainerizer*> containerizer =
+      ExternalContainerizer::create(flags);
+    if (containerizer.isError()) {
+      return Error("Could not create ExternalContainerizer: " +
+                   containerizer.error());
+    }
+
+    return containerizer.get();
+  }
+
+  return Error("Unknown or unsupported containerizer: " + type);
+}
+
+
 Try<Containerizer*> Containerizer::create(
     const Flags& flags,
     bool local,
@@ -193,49 +276,52 @@ Try<Containerizer*> Containerizer::create(
   // TODO(benh): We need to store which containerizer or
   // containerizers were being used. See MESOS-1663.
 
-  // Create containerizer(s).
+  const vector<string> types = strings::split(flags.containerizers, ",");
+
+  // Create containerizer(s). Several containerizers are created
+  // concurrently since creating one may block for a while, e.g., on
+  // validating the Docker daemon or on preparing the cgroups
+  // hierarchies, and they do not depend on each other.
+  //
+  // NOTE: The flags are captured by reference since we wait for all
+  // of the containerizers below (even if one of them fails).
+  vector<Future<Try<Containerizer*>>> futures;
+
+  foreach (const string& type, types) {
+    if (types.size() == 1) {
+      futures.push_back(slave::create(type, flags, local, fetcher));
+    } else {
+      futures.push_back(async([type, &flags, local, fetcher]() {
+        return slave::create(type, flags, local, fetcher);
+      }));
+    }
+  }
+
   vector<Containerizer*> containerizers;
+  Option<Error> error = None();
 
-  foreach (const string& type, strings::split(flags.containerizers, ",")) {
-    if (type == "mesos") {
-      Try<MesosContainerizer*> containerizer =
-        MesosContainerizer::create(flags, local, fetcher);
-      if (containerizer.isError()) {
-        return Error("Could not create MesosContainerizer: " +
-                     containerizer.error());
-      } else {
-        containerizers.push_back(containerizer.get());
-      }
-    } else if (type == "docker") {
-      Try<DockerContainerizer*> containerizer =
-        DockerContainerizer::create(flags, fetcher);
-      if (containerizer.isError()) {
-        return Error("Could not create DockerContainerizer: " +
-                     containerizer.error());
-      } else {
-        containerizers.push_back(containerizer.get());
-      }
-    } else if (type == "external") {
-      if (flags.container_logger.isSome()) {
-        return Error(
-            "The external containerizer does not support custom container "
-            "logger modules.  The '--containerizers=external' flag cannot be "
-            "set along with '--container_logger=...'");
-      }
+  foreach (const Future<Try<Containerizer*>>& future, futures) {
+    // NOTE: The future is never failed nor discarded since the
+    // errors are returned in the 'Try'.
+    const Try<Containerizer*>& containerizer = future.get();
 
-      Try<ExternalContainerizer*> containerizer =
-        ExternalContainerizer::create(flags);
-      if (containerizer.isError()) {
-        return Error("Could not create ExternalContainerizer: " +
-                     containerizer.error());
-      } else {
-        containerizers.push_back(containerizer.get());
+    if (containerizer.isError()) {
+      if (error.isNone()) {
+        error = Error(containerizer.error());
       }
     } else {
-      return Error("Unknown or unsupported containerizer: " + type);
+      containerizers.push_back(containerizer.get());
     }
   }
 
+  if (error.isSome()) {
+    foreach (Containerizer* containerizer, containerizers) {
+      delete containerizer;
+    }
+
+    return error.get();
+  }
+
   if (containerizers.size() == 1) {
     return containerizers.front();
   }
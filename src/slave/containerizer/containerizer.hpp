@@ -74,6 +74,16 @@ public:
   virtual process::Future<Nothing> recover(
       const Option<state::SlaveState>& state) = 0;
 
+  // Returns whether this containerizer may launch an executor or task
+  // with a container of the given type, or without a container (None).
+  // The composing containerizer only tries to launch with the
+  // containerizers which return true, rather than asking each one in
+  // turn. Ultimately `launch()` decides, so this may be conservative.
+  virtual bool supports(const Option<ContainerInfo::Type>& type) const
+  {
+    return true;
+  }
+
   // Launch a containerized executor. Returns true if launching this
   // ExecutorInfo is supported and it has been launched, otherwise
   // false or a failure is something went wrong.
@@ -16,6 +16,7 @@
 
 #include <list>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -56,6 +57,7 @@
 
 using std::list;
 using std::map;
+using std::set;
 using std::string;
 using std::vector;
 
@@ -137,7 +139,8 @@ Try<DockerContainerizer*> DockerContainerizer::create(
   Try<Owned<Docker>> create = Docker::create(
       flags.docker,
       flags.docker_socket,
-      true);
+      true,
+      flags.docker_engine_api);
 
   if (create.isError()) {
     return Error("Failed to create docker: " + create.error());
@@ -204,6 +207,7 @@ docker::Flags dockerFlags(
   dockerFlags.mapped_directory = flags.sandbox_directory;
   dockerFlags.stop_timeout = flags.docker_stop_timeout;
   dockerFlags.docker_socket = flags.docker_socket;
+  dockerFlags.docker_engine_api = flags.docker_engine_api;
   dockerFlags.launcher_dir = flags.launcher_dir;
   return dockerFlags;
 }
@@ -424,6 +428,13 @@ Future<Nothing> DockerContainerizer::recover(
 }
 
 
+bool DockerContainerizer::supports(
+    const Option<ContainerInfo::Type>& type) const
+{
+  return type.isSome() && type.get() == ContainerInfo::DOCKER;
+}
+
+
 Future<bool> DockerContainerizer::launch(
     const ContainerID& containerId,
     const ExecutorInfo& executorInfo,
@@ -678,6 +689,8 @@ Future<Nothing> DockerContainerizerProcess::_recover(
       container->status.future().get()
         .onAny(defer(self(), &Self::reaped, containerId));
 
+      watch(containerId);
+
       if (pids.containsValue(pid)) {
         // This should (almost) never occur. There is the
         // possibility that a new executor is launched with the same
@@ -1038,6 +1051,8 @@ Future<bool> DockerContainerizerProcess::reapExecutor(
   container->status.future().get()
     .onAny(defer(self(), &Self::reaped, containerId));
 
+  watch(containerId);
+
   return true;
 }
 
@@ -1271,7 +1286,8 @@ Future<ResourceStatistics> DockerContainerizerProcess::usage(
       return Failure("Container is being removed: " + stringify(containerId));
     }
 
-    const Try<ResourceStatistics> cgroupStats = cgroupsStatistics(pid);
+    const Try<ResourceStatistics> cgroupStats =
+      cgroupsStatistics(container, pid);
     if (cgroupStats.isError()) {
       return Failure("Failed to collect cgroup stats: " + cgroupStats.error());
     }
@@ -1326,68 +1342,101 @@ Future<ResourceStatistics> DockerContainerizerProcess::usage(
 
 
 Try<ResourceStatistics> DockerContainerizerProcess::cgroupsStatistics(
-    pid_t pid) const
+    Container* container,
+    pid_t pid)
 {
 #ifndef __linux__
   return Error("Does not support cgroups on non-linux platform");
 #else
-  const Result<string> cpuHierarchy = cgroups::hierarchy("cpuacct");
-  const Result<string> memHierarchy = cgroups::hierarchy("memory");
+  if (container->cpuacctStat.get() == NULL ||
+      container->memoryStat.get() == NULL) {
+    const Result<string> cpuHierarchy = cgroups::hierarchy("cpuacct");
+    const Result<string> memHierarchy = cgroups::hierarchy("memory");
+
+    if (cpuHierarchy.isError()) {
+      return Error(
+          "Failed to determine the cgroup 'cpu' subsystem hierarchy: " +
+          cpuHierarchy.error());
+    } else if (cpuHierarchy.isNone()) {
+      return Error("Unable to find 'cpu' cgroup subsystem hierarchy");
+    }
 
-  if (cpuHierarchy.isError()) {
-    return Error(
-        "Failed to determine the cgroup 'cpu' subsystem hierarchy: " +
-        cpuHierarchy.error());
-  }
+    if (memHierarchy.isError()) {
+      return Error(
+          "Failed to determine the cgroup 'memory' subsystem hierarchy: " +
+          memHierarchy.error());
+    } else if (memHierarchy.isNone()) {
+      return Error("Unable to find 'memory' cgroup subsystem hierarchy");
+    }
 
-  if (memHierarchy.isError()) {
-    return Error(
-        "Failed to determine the cgroup 'memory' subsystem hierarchy: " +
-        memHierarchy.error());
+    const Result<string> cpuCgroup = cgroups::cpuacct::cgroup(pid);
+    if (cpuCgroup.isError()) {
+      return Error(
+          "Failed to determine cgroup for the 'cpu' subsystem: " +
+          cpuCgroup.error());
+    } else if (cpuCgroup.isNone()) {
+      return Error("Unable to find 'cpu' cgroup subsystem");
+    }
+
+    const Result<string> memCgroup = cgroups::memory::cgroup(pid);
+    if (memCgroup.isError()) {
+      return Error(
+          "Failed to determine cgroup for the 'memory' subsystem: " +
+          memCgroup.error());
+    } else if (memCgroup.isNone()) {
+      return Error("Unable to find 'memory' cgroup subsystem");
+    }
+
+    container->cpuacctStat.reset(new cgroups::Reader(
+        cpuHierarchy.get(), cpuCgroup.get(), "cpuacct.stat"));
+
+    container->memoryStat.reset(new cgroups::Reader(
+        memHierarchy.get(), memCgroup.get(), "memory.stat"));
   }
 
-  const Result<string> cpuCgroup = cgroups::cpuacct::cgroup(pid);
-  if (cpuCgroup.isError()) {
-    return Error(
-        "Failed to determine cgroup for the 'cpu' subsystem: " +
-        cpuCgroup.error());
-  } else if (cpuCgroup.isNone()) {
-    return Error("Unable to find 'cpu' cgroup subsystem");
+  // Get the number of clock ticks, used for cpu accounting.
+  static long ticks = sysconf(_SC_CLK_TCK);
+
+  if (ticks <= 0) {
+    return ErrnoError("Failed to get _SC_CLK_TCK");
   }
 
-  const Result<string> memCgroup = cgroups::memory::cgroup(pid);
-  if (memCgroup.isError()) {
+  Option<uint64_t> user;
+  Option<uint64_t> system;
+
+  Try<Nothing> stat = container->cpuacctStat->stat({
+      {"user", &user},
+      {"system", &system}});
+
+  if (stat.isError() || user.isNone() || system.isNone()) {
+    // Resolve the cgroups again on the next call.
+    container->cpuacctStat.reset();
+
     return Error(
-        "Failed to determine cgroup for the 'memory' subsystem: " +
-        memCgroup.error());
-  } else if (memCgroup.isNone()) {
-    return Error("Unable to find 'memory' cgroup subsystem");
+        "Failed to get cpu.stat: " +
+        (stat.isError() ? stat.error() : "missing user/system value"));
   }
 
-  const Try<cgroups::cpuacct::Stats> cpuAcctStat =
-    cgroups::cpuacct::stat(cpuHierarchy.get(), cpuCgroup.get());
+  Option<uint64_t> rss;
 
-  if (cpuAcctStat.isError()) {
-    return Error("Failed to get cpu.stat: " + cpuAcctStat.error());
-  }
+  stat = container->memoryStat->stat({{"rss", &rss}});
 
-  const Try<hashmap<string, uint64_t>> memStats =
-    cgroups::stat(memHierarchy.get(), memCgroup.get(), "memory.stat");
+  if (stat.isError()) {
+    container->memoryStat.reset();
 
-  if (memStats.isError()) {
     return Error(
         "Error getting memory statistics from cgroups memory subsystem: " +
-        memStats.error());
+        stat.error());
   }
 
-  if (!memStats.get().contains("rss")) {
+  if (rss.isNone()) {
     return Error("cgroups memory stats does not contain 'rss' data");
   }
 
   ResourceStatistics result;
-  result.set_cpus_system_time_secs(cpuAcctStat.get().system.secs());
-  result.set_cpus_user_time_secs(cpuAcctStat.get().user.secs());
-  result.set_mem_rss_bytes(memStats.get().at("rss"));
+  result.set_cpus_system_time_secs((double) system.get() / (double) ticks);
+  result.set_cpus_user_time_secs((double) user.get() / (double) ticks);
+  result.set_mem_rss_bytes(rss.get());
 
   return result;
 #endif // __linux__
@@ -1607,11 +1656,18 @@ void DockerContainerizerProcess::___destroy(
     termination.set_status(status.get().get());
   }
 
-  termination.set_message(
-      killed ? "Container killed" : "Container terminated");
+  if (container->oomKilled) {
+    termination.add_reasons(TaskStatus::REASON_CONTAINER_LIMITATION_MEMORY);
+    termination.set_message("Container ran out of memory");
+  } else {
+    termination.set_message(
+        killed ? "Container killed" : "Container terminated");
+  }
 
   container->termination.set(termination);
 
+  container->event.discard();
+
   containers_.erase(containerId);
 
   delay(
@@ -1644,6 +1700,55 @@ void DockerContainerizerProcess::reaped(const ContainerID& containerId)
 }
 
 
+void DockerContainerizerProcess::watch(const ContainerID& containerId)
+{
+  if (!flags.docker_engine_api) {
+    return;
+  }
+
+  CHECK(containers_.contains(containerId));
+
+  Container* container = containers_[containerId];
+
+  container->event =
+    docker->event(container->name(), set<string>({"oom", "die"}));
+
+  container->event
+    .onReady(defer(self(), &Self::_watch, containerId, lambda::_1));
+}
+
+
+void DockerContainerizerProcess::_watch(
+    const ContainerID& containerId,
+    const string& status)
+{
+  if (!containers_.contains(containerId)) {
+    return;
+  }
+
+  Container* container = containers_[containerId];
+
+  if (status == "oom") {
+    LOG(INFO) << "Container '" << containerId << "' ran out of memory";
+
+    container->oomKilled = true;
+
+    // Keep waiting for it to die.
+    watch(containerId);
+    return;
+  }
+
+  VLOG(1) << "Container '" << containerId << "' has died";
+
+#ifdef __linux__
+  // The cgroups of the container are removed along with it, so the
+  // controls do not need to be kept open any longer.
+  container->cpuacctStat.reset();
+  container->memoryStat.reset();
+#endif // __linux__
+}
+
+
 void DockerContainerizerProcess::remove(
     const string& containerName,
     const Option<string>& executor)
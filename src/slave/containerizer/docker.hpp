@@ -28,6 +28,10 @@
 #include "docker/docker.hpp"
 #include "docker/executor.hpp"
 
+#ifdef __linux__
+#include "linux/cgroups.hpp"
+#endif // __linux__
+
 #include "slave/containerizer/containerizer.hpp"
 
 namespace mesos {
@@ -76,6 +80,8 @@ public:
   virtual process::Future<Nothing> recover(
       const Option<state::SlaveState>& state);
 
+  virtual bool supports(const Option<ContainerInfo::Type>& type) const;
+
   virtual process::Future<bool> launch(
       const ContainerID& containerId,
       const ExecutorInfo& executorInfo,
@@ -223,12 +229,20 @@ private:
       const Resources& resources,
       pid_t pid);
 
-  Try<ResourceStatistics> cgroupsStatistics(pid_t pid) const;
+  struct Container;
+
+  Try<ResourceStatistics> cgroupsStatistics(Container* container, pid_t pid);
 
   // Call back for when the executor exits. This will trigger
   // container destroy.
   void reaped(const ContainerID& containerId);
 
+  // Waits for the 'oom' and 'die' events of the container when the
+  // Docker Engine API is used (see `Docker::event`).
+  void watch(const ContainerID& containerId);
+
+  void _watch(const ContainerID& containerId, const std::string& status);
+
   // Removes the docker container.
   void remove(
       const std::string& containerName,
@@ -262,7 +276,7 @@ private:
     }
 
     Container(const ContainerID& id)
-      : state(FETCHING), id(id) {}
+      : state(FETCHING), id(id), oomKilled(false) {}
 
     Container(const ContainerID& id,
               const Option<TaskInfo>& taskInfo,
@@ -289,7 +303,8 @@ private:
         checkpoint(checkpoint),
         symlinked(symlinked),
         flags(flags),
-        launchesExecutorContainer(launchesExecutorContainer)
+        launchesExecutorContainer(launchesExecutorContainer),
+        oomKilled(false)
     {
       // NOTE: The task's resources are included in the executor's
       // resources in order to make sure when launching the executor
@@ -460,6 +475,24 @@ private:
     // Marks if this container launches an executor in a docker
     // container.
     bool launchesExecutorContainer;
+
+    // The next event of the container waited for by `watch()`, which
+    // is discarded when the container is destroyed.
+    process::Future<std::string> event;
+
+    // Whether the Docker daemon reported that the container ran out
+    // of memory, in which case it is the reason of the termination.
+    bool oomKilled;
+
+#ifdef __linux__
+    // The readers of the 'cpuacct.stat' and 'memory.stat' controls of
+    // the cgroups of the running container. These are created when
+    // the statistics are first collected, so the cgroups of the pid
+    // are only resolved once and the controls are kept open rather
+    // than done again for every `usage()` call.
+    process::Owned<cgroups::Reader> cpuacctStat;
+    process::Owned<cgroups::Reader> memoryStat;
+#endif // __linux__
   };
 
   hashmap<ContainerID, Container*> containers_;
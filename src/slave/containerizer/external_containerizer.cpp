@@ -241,7 +241,13 @@ Future<hashset<ContainerID>> ExternalContainerizer::containers()
 
 
 ExternalContainerizerProcess::ExternalContainerizerProcess(
-    const Flags& _flags) : flags(_flags) {}
+    const Flags& _flags) : flags(_flags), nextCallId(0), writing(Nothing()) {}
+
+
+void ExternalContainerizerProcess::finalize()
+{
+  stop("External containerizer terminated");
+}
 
 
 Future<Nothing> ExternalContainerizerProcess::recover(
@@ -733,6 +739,11 @@ Future<Nothing> ExternalContainerizerProcess::_update(
   update.mutable_container_id()->CopyFrom(containerId);
   update.mutable_resources()->CopyFrom(resources);
 
+  if (flags.containerizer_daemon) {
+    return call("update", update)
+      .then([]() { return Nothing(); });
+  }
+
   Try<Subprocess> invoked = invoke(
       "update",
       update,
@@ -801,6 +812,17 @@ Future<ResourceStatistics> ExternalContainerizerProcess::_usage(
   containerizer::Usage usage;
   usage.mutable_container_id()->CopyFrom(containerId);
 
+  if (flags.containerizer_daemon) {
+    return call("usage", usage)
+      .then([](const string& message) -> Future<ResourceStatistics> {
+        ResourceStatistics statistics;
+        if (!statistics.ParseFromString(message)) {
+          return Failure("Could not parse the result of 'usage'");
+        }
+        return statistics;
+      });
+  }
+
   Try<Subprocess> invoked = invoke(
       "usage",
       usage,
@@ -1072,6 +1094,151 @@ static int setup(const string& directory)
 }
 
 
+Future<string> ExternalContainerizerProcess::call(
+    const string& command,
+    const google::protobuf::Message& message)
+{
+  if (daemon.isNone()) {
+    Try<Subprocess> invoked = invoke("daemon");
+    if (invoked.isError()) {
+      return Failure("Failed to start the resident external containerizer: " +
+                     invoked.error());
+    }
+
+    Try<Nothing> nonblock = os::nonblock(invoked.get().out().get());
+    if (nonblock.isError()) {
+      os::killtree(invoked.get().pid(), SIGKILL);
+      return Failure("Failed to accept nonblock: " + nonblock.error());
+    }
+
+    LOG(INFO) << "Started the resident external containerizer with pid "
+              << invoked.get().pid();
+
+    daemon = invoked.get();
+    writing = Nothing();
+    received.clear();
+
+    receive(daemon.get().pid());
+  }
+
+  containerizer::Call request;
+  request.set_id(nextCallId++);
+  request.set_command(command);
+  request.set_message(message.SerializeAsString());
+
+  Owned<Promise<string>> promise(new Promise<string>());
+  calls[request.id()] = promise;
+
+  // Every call is prefixed by its size, like the messages piped to
+  // the commands (see 'protobuf::write').
+  const string data = request.SerializeAsString();
+  const uint32_t size = data.size();
+
+  const string frame = string((const char*) &size, sizeof(size)) + data;
+
+  const int in = daemon.get().in().get();
+  const pid_t pid = daemon.get().pid();
+
+  writing = writing
+    .then([=]() { return io::write(in, frame); })
+    .onFailed(defer(self(), [=](const string& failure) {
+      if (daemon.isSome() && daemon.get().pid() == pid) {
+        stop("Failed to write to the resident external containerizer: " +
+             failure);
+      }
+    }));
+
+  return promise->future();
+}
+
+
+void ExternalContainerizerProcess::receive(pid_t pid)
+{
+  io::read(daemon.get().out().get(), io::BUFFERED_READ_SIZE)
+    .onAny(defer(self(), &Self::_receive, pid, lambda::_1));
+}
+
+
+void ExternalContainerizerProcess::_receive(
+    pid_t pid,
+    const Future<io::Buffer>& data)
+{
+  // Ignore the output of a resident external containerizer which has
+  // been stopped in the meantime.
+  if (daemon.isNone() || daemon.get().pid() != pid) {
+    return;
+  }
+
+  if (!data.isReady()) {
+    stop("Failed to read from the resident external containerizer: " +
+         (data.isFailed() ? data.failure() : "discarded"));
+    return;
+  }
+
+  if (data.get().size() == 0) {
+    stop("The resident external containerizer exited");
+    return;
+  }
+
+  received += data.get().string();
+
+  uint32_t size;
+  while (received.size() >= sizeof(size)) {
+    memcpy(&size, received.data(), sizeof(size));
+
+    if (received.size() < sizeof(size) + size) {
+      break;
+    }
+
+    containerizer::CallResult result;
+    if (!result.ParseFromArray(received.data() + sizeof(size), size)) {
+      stop("Could not parse a result of the resident external containerizer");
+      return;
+    }
+
+    received.erase(0, sizeof(size) + size);
+
+    if (!calls.contains(result.id())) {
+      LOG(WARNING) << "Ignoring a result of the resident external "
+                   << "containerizer for the unknown call " << result.id();
+      continue;
+    }
+
+    Owned<Promise<string>> promise = calls[result.id()];
+    calls.erase(result.id());
+
+    if (result.has_error()) {
+      promise->fail(result.error());
+    } else {
+      promise->set(result.message());
+    }
+  }
+
+  receive(pid);
+}
+
+
+void ExternalContainerizerProcess::stop(const string& message)
+{
+  if (daemon.isSome()) {
+    LOG(WARNING) << message;
+
+    // Closing the pipes (along with the last copy of the subprocess)
+    // lets the daemon know that it should exit, it is killed in case
+    // it does not.
+    os::killtree(daemon.get().pid(), SIGKILL);
+    daemon = None();
+  }
+
+  foreachvalue (const Owned<Promise<string>>& promise, calls) {
+    promise->fail(message);
+  }
+
+  calls.clear();
+  received.clear();
+}
+
+
 Try<Subprocess> ExternalContainerizerProcess::invoke(
     const string& command,
     const Option<Sandbox>& sandbox,
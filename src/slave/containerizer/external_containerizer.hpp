@@ -21,6 +21,7 @@
 #include <string>
 #include <tuple>
 
+#include <process/io.hpp>
 #include <process/owned.hpp>
 #include <process/subprocess.hpp>
 
@@ -53,6 +54,15 @@ namespace slave {
 // 'wait' on the external containerizer side is expected to block
 // until the task command/executor has terminated.
 //
+// With --containerizer_daemon, the external containerizer program is
+// also invoked once as
+//
+// daemon < containerizer::Call* > containerizer::CallResult*
+//
+// and is expected to keep running, reading the 'usage' and 'update'
+// commands from stdin and writing their results to stdout (in any
+// order, matched by id) rather than being invoked for each of them.
+//
 // Additionally, we have the following environment variable setup
 // for external containerizer programs:
 // MESOS_LIBEXEC_DIRECTORY = path to mesos-executor, mesos-usage, ...
@@ -159,6 +169,9 @@ public:
   // Get all active container-id's.
   process::Future<hashset<ContainerID>> containers();
 
+protected:
+  virtual void finalize();
+
 private:
   // Startup flags.
   const Flags flags;
@@ -273,6 +286,37 @@ private:
   // in the container.
   void cleanup(const ContainerID& containerId);
 
+  // Sends the command to the resident external containerizer (see
+  // --containerizer_daemon), starting it if it is not running, and
+  // returns the serialized result message of the command.
+  process::Future<std::string> call(
+      const std::string& command,
+      const google::protobuf::Message& message);
+
+  // Reads the results from the resident external containerizer.
+  void receive(pid_t pid);
+
+  void _receive(pid_t pid, const process::Future<process::io::Buffer>& data);
+
+  // Fails the pending calls and stops the resident external
+  // containerizer, which is started again by the next call.
+  void stop(const std::string& message);
+
+  // The resident external containerizer, if it is running.
+  Option<process::Subprocess> daemon;
+
+  // The pending calls to the resident external containerizer by id.
+  hashmap<uint64_t, process::Owned<process::Promise<std::string>>> calls;
+
+  uint64_t nextCallId;
+
+  // The writes of the calls are chained so that they do not interleave.
+  process::Future<Nothing> writing;
+
+  // The output of the resident external containerizer that has not
+  // been parsed into results yet.
+  std::string received;
+
   // Invoke the external containerizer with the given command.
   Try<process::Subprocess> invoke(
       const std::string& command,
@@ -14,17 +14,28 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <atomic>
 #include <unordered_map>
 
 #include <process/async.hpp>
 #include <process/check.hpp>
 #include <process/collect.hpp>
+#include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/owned.hpp>
 
+#include <stout/hashset.hpp>
 #include <stout/net.hpp>
 #include <stout/path.hpp>
+#include <stout/strings.hpp>
 
+#include <stout/os/close.hpp>
+#include <stout/os/open.hpp>
 #include <stout/os/read.hpp>
 
 #include "hdfs/hdfs.hpp"
@@ -198,6 +209,16 @@ Result<string> Fetcher::uriToLocalPath(
 }
 
 
+string Fetcher::getSharedCacheDirectory(
+    const SlaveID& slaveId,
+    const Flags& flags)
+{
+  return path::join(
+      paths::getSlavePath(flags.fetcher_cache_dir, slaveId),
+      "shared");
+}
+
+
 bool Fetcher::isNetUri(const std::string& uri)
 {
   return strings::startsWith(uri, "http://")  ||
@@ -247,7 +268,8 @@ FetcherProcess::~FetcherProcess()
 // Find out how large a potential download from the given URI is.
 static Try<Bytes> fetchSize(
     const string& uri,
-    const Option<string>& frameworksHome)
+    const Option<string>& frameworksHome,
+    const Option<string>& webhdfsAddress)
 {
   VLOG(1) << "Fetching size for URI: " << uri;
 
@@ -276,7 +298,7 @@ static Try<Bytes> fetchSize(
     return size.get();
   }
 
-  Try<Owned<HDFS>> hdfs = HDFS::create();
+  Try<Owned<HDFS>> hdfs = HDFS::create(None(), webhdfsAddress);
   if (hdfs.isError()) {
     return Error("Failed to create HDFS client: " + hdfs.error());
   }
@@ -320,6 +342,11 @@ Future<Nothing> FetcherProcess::fetch(
   }
 
   string cacheDirectory = paths::getSlavePath(flags.fetcher_cache_dir, slaveId);
+
+  // Cache files of URIs with a checksum are shared by all users.
+  const string sharedCacheDirectory =
+    Fetcher::getSharedCacheDirectory(slaveId, flags);
+
   if (commandUser.isSome()) {
     // Segregating per-user cache directories.
     cacheDirectory = path::join(cacheDirectory, commandUser.get());
@@ -356,6 +383,11 @@ Future<Nothing> FetcherProcess::fetch(
   // entry.
   hashmap<CommandInfo::URI, Option<Future<shared_ptr<Cache::Entry>>>> entries;
 
+  // Keys of the entries created below. Another URI of this command
+  // with the same checksum must not wait for the completion of such
+  // an entry, as that requires this fetch to complete.
+  hashset<string> created;
+
   foreach (const CommandInfo::URI& uri, commandInfo.uris()) {
     if (!uri.cache()) {
       entries[uri] = None();
@@ -365,9 +397,11 @@ Future<Nothing> FetcherProcess::fetch(
     // Check if this is already in the cache (but not necessarily
     // downloaded).
     const Option<shared_ptr<Cache::Entry>> entry =
-      cache.get(commandUser, uri.value());
+      cache.get(commandUser, uri);
 
-    if (entry.isSome()) {
+    if (entry.isSome() && created.contains(entry.get()->key)) {
+      entries[uri] = None();
+    } else if (entry.isSome()) {
       entry.get()->reference();
 
       // Wait for the URI to be downloaded into the cache (or fail)
@@ -376,14 +410,18 @@ Future<Nothing> FetcherProcess::fetch(
           return Future<shared_ptr<Cache::Entry>>(entry.get());
         }));
     } else {
-      shared_ptr<Cache::Entry> newEntry =
-        cache.create(cacheDirectory, commandUser, uri);
+      shared_ptr<Cache::Entry> newEntry = cache.create(
+          uri.has_checksum() ? sharedCacheDirectory : cacheDirectory,
+          commandUser,
+          uri);
 
       newEntry->reference();
+      created.insert(newEntry->key);
 
       entries[uri] =
         async([=]() {
-          return fetchSize(uri.value(), flags.frameworks_home);
+          return fetchSize(
+              uri.value(), flags.frameworks_home, flags.webhdfs_address);
         })
         .then(defer(self(), [=](const Try<Bytes>& requestedSpace) {
           return reserveCacheSpace(requestedSpace, newEntry);
@@ -499,6 +537,10 @@ Future<Nothing> FetcherProcess::__fetch(
         item->set_action(FetcherInfo::Item::RETRIEVE_FROM_CACHE);
         item->set_cache_filename(entry.get()->filename);
       }
+
+      if (entry.get()->directory != cacheDirectory) {
+        item->set_cache_directory(entry.get()->directory);
+      }
     } else {
       item->set_action(FetcherInfo::Item::BYPASS_CACHE);
     }
@@ -515,6 +557,8 @@ Future<Nothing> FetcherProcess::__fetch(
     info.set_frameworks_home(flags.frameworks_home);
   }
 
+  info.set_link_cache_files(flags.fetcher_cache_hardlinks);
+
   return run(containerId, sandboxDirectory, user, info, flags)
     .repair(defer(self(), [=](const Future<Nothing>& future) {
       LOG(ERROR) << "Failed to run mesos-fetcher: " << future.failure();
@@ -678,6 +722,211 @@ FetcherProcess::reserveCacheSpace(
 }
 
 
+// Returns whether the given file would be extracted by the
+// mesos-fetcher, i.e., whether it looks like an archive.
+static bool isArchive(const string& path)
+{
+  return strings::endsWith(path, ".tar") ||
+         strings::endsWith(path, ".tgz") ||
+         strings::endsWith(path, ".tbz2") ||
+         strings::endsWith(path, ".tar.bz2") ||
+         strings::endsWith(path, ".txz") ||
+         strings::endsWith(path, ".tar.xz") ||
+         strings::endsWith(path, ".gz") ||
+         strings::endsWith(path, ".zip");
+}
+
+
+// Returns whether all items can be fetched without running the
+// mesos-fetcher, i.e., they bypass the cache, refer to a local file
+// or to a URI that can be downloaded with libcurl, and they do not
+// need to be extracted. Everything else, e.g., archives or URIs that
+// need the Hadoop client, is left to the mesos-fetcher.
+static bool fetchableInProcess(const FetcherInfo& info)
+{
+  const Option<string> frameworksHome = info.has_frameworks_home()
+    ? Option<string>(info.frameworks_home())
+    : None();
+
+  foreach (const FetcherInfo::Item& item, info.items()) {
+    // Checksums are verified by the mesos-fetcher.
+    if (item.action() != FetcherInfo::Item::BYPASS_CACHE ||
+        item.uri().has_checksum()) {
+      return false;
+    }
+
+    const string uri = strings::trim(item.uri().value(), strings::PREFIX);
+
+    if (!Fetcher::isNetUri(uri) &&
+        !Fetcher::uriToLocalPath(uri, frameworksHome).isSome()) {
+      return false;
+    }
+
+    if (!item.uri().executable() && item.uri().extract()) {
+      Try<string> basename = Fetcher::basename(uri);
+      if (basename.isError() || isArchive(basename.get())) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+static Try<Nothing> copyFile(
+    const string& sourcePath,
+    const string& destinationPath,
+    const shared_ptr<std::atomic_bool>& killed)
+{
+  Try<int> source = os::open(sourcePath, O_RDONLY | O_CLOEXEC);
+  if (source.isError()) {
+    return Error("Failed to open '" + sourcePath + "': " + source.error());
+  }
+
+  struct stat s;
+  if (::fstat(source.get(), &s) < 0) {
+    ErrnoError error("Failed to stat '" + sourcePath + "'");
+    os::close(source.get());
+    return error;
+  }
+
+  Try<int> destination = os::open(
+      destinationPath,
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      s.st_mode & 0777);
+
+  if (destination.isError()) {
+    os::close(source.get());
+    return Error("Failed to open '" + destinationPath + "': " +
+                 destination.error());
+  }
+
+  Option<Error> error = None();
+  char buffer[64 * 1024];
+
+  while (error.isNone()) {
+    if (killed->load()) {
+      error = Error("Fetch was killed");
+      break;
+    }
+
+    ssize_t length = ::read(source.get(), buffer, sizeof(buffer));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    } else if (length < 0) {
+      error = ErrnoError("Failed to read '" + sourcePath + "'");
+      break;
+    } else if (length == 0) {
+      break;
+    }
+
+    ssize_t offset = 0;
+    while (offset < length) {
+      ssize_t written =
+        ::write(destination.get(), buffer + offset, length - offset);
+
+      if (written < 0 && errno == EINTR) {
+        continue;
+      } else if (written < 0) {
+        error = ErrnoError("Failed to write '" + destinationPath + "'");
+        break;
+      }
+
+      offset += written;
+    }
+  }
+
+  os::close(source.get());
+  os::close(destination.get());
+
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return Nothing();
+}
+
+
+// Fetches the items the way the mesos-fetcher does for items which
+// bypass the cache, see 'fetchableInProcess'. Checks 'killed' before
+// each item and while copying local files.
+static Try<Nothing> fetchInProcess(
+    const FetcherInfo& info,
+    const shared_ptr<std::atomic_bool>& killed)
+{
+  const Option<string> frameworksHome = info.has_frameworks_home()
+    ? Option<string>(info.frameworks_home())
+    : None();
+
+  foreach (const FetcherInfo::Item& item, info.items()) {
+    if (killed->load()) {
+      return Error("Fetch was killed");
+    }
+
+    const string uri = strings::trim(item.uri().value(), strings::PREFIX);
+
+    Try<string> basename = Fetcher::basename(uri);
+    if (basename.isError()) {
+      return Error("Failed to determine the basename of the URI '" +
+                   uri + "' with error: " + basename.error());
+    }
+
+    const string path = path::join(info.sandbox_directory(), basename.get());
+
+    if (Fetcher::isNetUri(uri)) {
+      Try<int> code = net::download(uri, path);
+      if (code.isError()) {
+        return Error("Error downloading '" + uri + "': " + code.error());
+      }
+
+      // The status code for successful HTTP requests is 200, the
+      // status code for successful FTP file transfers is 226.
+      const int expected =
+        strings::startsWith(uri, "ftp") ? 226 : 200;
+
+      if (code.get() != expected) {
+        return Error("Error downloading '" + uri + "', received return "
+                     "code " + stringify(code.get()));
+      }
+    } else {
+      Result<string> source = Fetcher::uriToLocalPath(uri, frameworksHome);
+      if (!source.isSome()) {
+        return Error("Failed to determine the local path of the URI '" +
+                     uri + "'");
+      }
+
+      Try<Nothing> copy = copyFile(source.get(), path, killed);
+      if (copy.isError()) {
+        return Error(copy.error());
+      }
+    }
+
+    if (item.uri().executable()) {
+      Try<Nothing> chmod = os::chmod(
+          path, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
+
+      if (chmod.isError()) {
+        return Error("Failed to chmod executable '" + path + "': " +
+                     chmod.error());
+      }
+    }
+
+    LOG(INFO) << "Fetched '" << uri << "' to '" << path << "'";
+  }
+
+  if (info.has_user()) {
+    Try<Nothing> chown = os::chown(info.user(), info.sandbox_directory());
+    if (chown.isError()) {
+      return Error("Failed to chown '" + info.sandbox_directory() + "': " +
+                   chown.error());
+    }
+  }
+
+  return Nothing();
+}
+
+
 Future<Nothing> FetcherProcess::run(
     const ContainerID& containerId,
     const string& sandboxDirectory,
@@ -728,6 +977,35 @@ Future<Nothing> FetcherProcess::run(
     }
   }
 
+  // Avoid the cost of spawning the mesos-fetcher if the URIs can be
+  // fetched here. The fetch runs outside of this process as it blocks
+  // on the file system and the network.
+  if (fetchableInProcess(info)) {
+    os::close(out.get());
+    os::close(err.get());
+
+    VLOG(1) << "Fetching URIs in-process for container '"
+            << containerId << "'";
+
+    shared_ptr<std::atomic_bool> killed(new std::atomic_bool(false));
+    inProcessFetches[containerId] = killed;
+
+    return async(&fetchInProcess, info, killed)
+      .then(defer(self(), [=](const Try<Nothing>& fetch) -> Future<Nothing> {
+        if (fetch.isError()) {
+          return Failure("Failed to fetch all URIs for container '" +
+                         stringify(containerId) + "': " + fetch.error());
+        }
+
+        return Nothing();
+      }))
+      .onAny(defer(self(), [=](const Future<Nothing>&) {
+        if (inProcessFetches.get(containerId) == killed) {
+          inProcessFetches.erase(containerId);
+        }
+      }));
+  }
+
   string fetcherPath = path::join(flags.launcher_dir, "mesos-fetcher");
   Result<string> realpath = os::realpath(fetcherPath);
 
@@ -758,6 +1036,19 @@ Future<Nothing> FetcherProcess::run(
     environment["HADOOP_HOME"] = flags.hadoop_home;
   }
 
+  if (flags.webhdfs_address.isSome()) {
+    environment["MESOS_WEBHDFS_ADDRESS"] = flags.webhdfs_address.get();
+  }
+
+  if (flags.fetcher_peers.isSome()) {
+    environment["MESOS_FETCHER_PEERS"] = flags.fetcher_peers.get();
+  }
+
+  if (flags.fetcher_download_parts > 1) {
+    environment["MESOS_FETCHER_DOWNLOAD_PARTS"] =
+      stringify(flags.fetcher_download_parts);
+  }
+
   VLOG(1) << "Fetching URIs using command '" << command << "'";
 
   Try<Subprocess> fetcherSubprocess = subprocess(
@@ -815,6 +1106,14 @@ Future<Nothing> FetcherProcess::run(
 
 void FetcherProcess::kill(const ContainerID& containerId)
 {
+  if (inProcessFetches.contains(containerId)) {
+    VLOG(1) << "Killing the fetch for container '" << containerId << "'";
+
+    // The in-process fetch gives up before its next step.
+    inProcessFetches[containerId]->store(true);
+    inProcessFetches.erase(containerId);
+  }
+
   if (subprocessPids.contains(containerId)) {
     VLOG(1) << "Killing the fetcher for container '" << containerId << "'";
     // Best effort kill the entire fetcher tree.
@@ -859,15 +1158,30 @@ string FetcherProcess::Cache::nextFilename(const CommandInfo::URI& uri)
     s = s.substr(0, 10) + "_" + s.substr(s.size() - 10, string::npos);
   }
 
+  // There is only one entry per checksum, which is named after the
+  // checksum instead of a serial number, so that peer agents fetching
+  // the same URI know its name in our cache (see '--fetcher_peers').
+  if (uri.has_checksum()) {
+    return CACHE_FILE_NAME_PREFIX + strings::lower(uri.checksum()) + "-" + s;
+  }
+
   ++filenameSerial;
 
   return CACHE_FILE_NAME_PREFIX + stringify(filenameSerial) + "-" + s;
 }
 
 
-static string cacheKey(const Option<string>& user, const string& uri)
+static string cacheKey(
+    const Option<string>& user,
+    const CommandInfo::URI& uri)
 {
-  return user.isNone() ? uri : user.get() + "@" + uri;
+  // Content with a known checksum can be shared by all users, since
+  // the mesos-fetcher verifies it before it becomes a cache file.
+  if (uri.has_checksum()) {
+    return "sha256:" + strings::lower(uri.checksum());
+  }
+
+  return user.isNone() ? uri.value() : user.get() + "@" + uri.value();
 }
 
 
@@ -876,7 +1190,7 @@ shared_ptr<FetcherProcess::Cache::Entry> FetcherProcess::Cache::create(
     const Option<string>& user,
     const CommandInfo::URI& uri)
 {
-  const string key = cacheKey(user, uri.value());
+  const string key = cacheKey(user, uri);
   const string filename = nextFilename(uri);
 
   auto entry = shared_ptr<Cache::Entry>(
@@ -894,7 +1208,7 @@ shared_ptr<FetcherProcess::Cache::Entry> FetcherProcess::Cache::create(
 Option<shared_ptr<FetcherProcess::Cache::Entry>>
 FetcherProcess::Cache::get(
     const Option<string>& user,
-    const string& uri)
+    const CommandInfo::URI& uri)
 {
   const string key = cacheKey(user, uri);
 
@@ -911,7 +1225,7 @@ FetcherProcess::Cache::get(
 
 bool FetcherProcess::Cache::contains(
     const Option<string>& user,
-    const string& uri)
+    const CommandInfo::URI& uri)
 {
   const string key = cacheKey(user, uri);
   return table.get(key).isSome();
@@ -17,7 +17,9 @@
 #ifndef __SLAVE_CONTAINERIZER_FETCHER_HPP__
 #define __SLAVE_CONTAINERIZER_FETCHER_HPP__
 
+#include <atomic>
 #include <list>
+#include <memory>
 #include <string>
 
 #include <mesos/mesos.hpp>
@@ -89,6 +91,14 @@ public:
   // static one for the slave to call during startup or recovery.
   static Try<Nothing> recover(const SlaveID& slaveId, const Flags& flags);
 
+  // Returns the directory of the cache files of URIs with a checksum,
+  // which are shared by all users, and served to peer agents if
+  // '--fetcher_peers' is set. These cache files are named after the
+  // checksum, so that the peers can find them.
+  static std::string getSharedCacheDirectory(
+      const SlaveID& slaveId,
+      const Flags& flags);
+
   // Download the URIs specified in the command info and place the
   // resulting files into the given sandbox directory. Chmod said files
   // to the user if given. Send stdout and stderr output to files
@@ -127,7 +137,10 @@ public:
       const Flags& flags);
 
   // Runs the mesos-fetcher, creating a "stdout" and "stderr" file
-  // in the given directory, using these for trace output.
+  // in the given directory, using these for trace output. URIs which
+  // bypass the cache and are local files or can be downloaded with
+  // libcurl, and which need no extraction, are instead fetched
+  // in-process, without spawning the mesos-fetcher.
   virtual process::Future<Nothing> run(
       const ContainerID& containerId,
       const std::string& sandboxDirectory,
@@ -136,7 +149,8 @@ public:
       const Flags& flags);
 
   // Best effort attempt to kill the external mesos-fetcher process
-  // running on behalf of the given container ID, if any.
+  // running on behalf of the given container ID, if any. An
+  // in-process fetch is aborted before its next step.
   void kill(const ContainerID& containerId);
 
   // Representation of the fetcher cache and its contents. There is
@@ -184,7 +198,8 @@ public:
       // that the slave flags get injected into the fetcher.
       Path path() { return Path(path::join(directory, filename)); }
 
-      // Uniquely identifies a user/URI combination.
+      // Uniquely identifies a user/URI combination, or the content of
+      // a URI with a checksum regardless of user and URI.
       const std::string key;
 
       // Cache directory where this entry is stored.
@@ -193,7 +208,7 @@ public:
       const std::string directory;
 
       // The unique name of the file held in the cache on behalf of a
-      // URI.
+      // URI, or of all URIs with the same checksum.
       const std::string filename;
 
       // The expected size of the cache file. This field is set before
@@ -234,13 +249,17 @@ public:
         const CommandInfo::URI& uri);
 
     // Retrieves the cache entry indexed by the parameters, without
-    // changing its reference count.
+    // changing its reference count. URIs with a checksum share their
+    // entry with all other URIs with the same checksum, regardless of
+    // the user.
     Option<std::shared_ptr<Entry>> get(
         const Option<std::string>& user,
-        const std::string& uri);
+        const CommandInfo::URI& uri);
 
     // Returns whether an entry for this user and URI is in the cache.
-    bool contains(const Option<std::string>& user, const std::string& uri);
+    bool contains(
+        const Option<std::string>& user,
+        const CommandInfo::URI& uri);
 
     // Returns whether this identical entry is in the cache.
     bool contains(const std::shared_ptr<Cache::Entry>& entry);
@@ -331,6 +350,10 @@ private:
   Cache cache;
 
   hashmap<ContainerID, pid_t> subprocessPids;
+
+  // Set to abort the fetches running in-process on behalf of a
+  // container, see 'run'.
+  hashmap<ContainerID, std::shared_ptr<std::atomic_bool>> inProcessFetches;
 };
 
 } // namespace slave {
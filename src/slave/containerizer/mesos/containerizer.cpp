@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iterator>
+
 #include <mesos/module/isolator.hpp>
 
 #include <mesos/slave/container_logger.hpp>
@@ -55,6 +57,8 @@
 
 #ifdef __linux__
 #include "slave/containerizer/mesos/isolators/cgroups/cpushare.hpp"
+#include "slave/containerizer/mesos/isolators/cgroups/cpuset.hpp"
+#include "slave/containerizer/mesos/isolators/cgroups/hugetlb.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/mem.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/net_cls.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/perf_event.hpp"
@@ -76,6 +80,10 @@
 #include "slave/containerizer/mesos/isolators/network/port_mapping.hpp"
 #endif
 
+#ifdef ENABLE_XFS_DISK_ISOLATOR
+#include "slave/containerizer/mesos/isolators/xfs/disk.hpp"
+#endif
+
 #include "slave/containerizer/mesos/containerizer.hpp"
 #include "slave/containerizer/mesos/launch.hpp"
 #include "slave/containerizer/mesos/provisioner/provisioner.hpp"
@@ -130,6 +138,11 @@ Try<MesosContainerizer*> MesosContainerizer::create(
     flags_.isolation = "cgroups/cpu,cgroups/mem";
   }
 
+  if (flags.max_concurrent_container_destroys.isSome() &&
+      flags.max_concurrent_container_destroys.get() == 0) {
+    return Error("--max_concurrent_container_destroys must be positive");
+  }
+
   // One and only one filesystem isolator is required. The filesystem
   // isolator is responsible for preparing the filesystems for
   // containers (e.g., prepare filesystem roots, volumes, etc.). If
@@ -205,6 +218,8 @@ Try<MesosContainerizer*> MesosContainerizer::create(
     {"posix/disk", &PosixDiskIsolatorProcess::create},
 #ifdef __linux__
     {"cgroups/cpu", &CgroupsCpushareIsolatorProcess::create},
+    {"cgroups/cpuset", &CgroupsCpusetIsolatorProcess::create},
+    {"cgroups/hugetlb", &CgroupsHugetlbIsolatorProcess::create},
     {"cgroups/mem", &CgroupsMemIsolatorProcess::create},
     {"cgroups/net_cls", &CgroupsNetClsIsolatorProcess::create},
     {"cgroups/perf_event", &CgroupsPerfEventIsolatorProcess::create},
@@ -212,6 +227,9 @@ Try<MesosContainerizer*> MesosContainerizer::create(
 #endif
 #ifdef WITH_NETWORK_ISOLATOR
     {"network/port_mapping", &PortMappingIsolatorProcess::create},
+#endif
+#ifdef ENABLE_XFS_DISK_ISOLATOR
+    {"xfs/disk", &XfsDiskIsolatorProcess::create},
 #endif
   };
 
@@ -296,6 +314,14 @@ Future<Nothing> MesosContainerizer::recover(
 }
 
 
+bool MesosContainerizer::supports(const Option<ContainerInfo::Type>& type) const
+{
+  // NOTE: Like `launch()`, this also accepts executors and tasks
+  // without a container.
+  return type.isNone() || type.get() == ContainerInfo::MESOS;
+}
+
+
 Future<bool> MesosContainerizer::launch(
     const ContainerID& containerId,
     const ExecutorInfo& executorInfo,
@@ -471,7 +497,7 @@ Future<Nothing> MesosContainerizerProcess::recover(
   }
 
   // Try to recover the launcher first.
-  return launcher->recover(recoverable)
+  return metrics.recovery_launcher.time(launcher->recover(recoverable))
     .then(defer(self(), &Self::_recover, recoverable, lambda::_1));
 }
 
@@ -500,7 +526,7 @@ Future<list<Nothing>> MesosContainerizerProcess::recoverIsolators(
   }
 
   // If all isolators recover then continue.
-  return collect(futures);
+  return metrics.recovery_isolators.time(collect(futures));
 }
 
 
@@ -508,7 +534,8 @@ Future<Nothing> MesosContainerizerProcess::recoverProvisioner(
     const list<ContainerState>& recoverable,
     const hashset<ContainerID>& orphans)
 {
-  return provisioner->recover(recoverable, orphans);
+  return metrics.recovery_provisioner.time(
+      provisioner->recover(recoverable, orphans));
 }
 
 
@@ -657,6 +684,13 @@ Future<bool> MesosContainerizerProcess::launch(
 
   containers_.put(containerId, Owned<Container>(container));
 
+  // Fetching the executor's URIs does not depend on the provisioning
+  // and preparation of the container, so we start it right away. The
+  // executor is not exec'ed before the fetch completes though, see
+  // '_fetch()'.
+  container->fetching = metrics.launch_fetch.time(
+      fetch(containerId, executorInfo.command(), directory, user, slaveId));
+
   if (!executorInfo.has_container()) {
     return prepare(containerId, taskInfo, executorInfo, directory, user, None())
       .then(defer(self(),
@@ -688,7 +722,8 @@ Future<bool> MesosContainerizerProcess::launch(
 
   const Image& image = executorInfo.container().mesos().image();
 
-  return provisioner->provision(containerId, image)
+  return metrics.launch_provision.time(
+      provisioner->provision(containerId, image))
     .then(defer(PID<MesosContainerizerProcess>(this),
                 &MesosContainerizerProcess::_launch,
                 containerId,
@@ -770,24 +805,42 @@ Future<bool> MesosContainerizerProcess::_launch(
 }
 
 
-static list<Option<ContainerLaunchInfo>> accumulate(
-    list<Option<ContainerLaunchInfo>> l,
-    const Option<ContainerLaunchInfo>& e)
+static Future<list<Option<ContainerLaunchInfo>>> __prepare(
+    const Option<ContainerLaunchInfo>& launchInfo,
+    const list<Future<Option<ContainerLaunchInfo>>>& futures)
 {
-  l.push_back(e);
-  return l;
+  list<Option<ContainerLaunchInfo>> launchInfos;
+  launchInfos.push_back(launchInfo);
+
+  // Propagate any failure.
+  foreach (const Future<Option<ContainerLaunchInfo>>& future, futures) {
+    if (!future.isReady()) {
+      return Failure(future.isFailed() ? future.failure() : "discarded");
+    }
+
+    launchInfos.push_back(future.get());
+  }
+
+  return launchInfos;
 }
 
 
 static Future<list<Option<ContainerLaunchInfo>>> _prepare(
-    const Owned<Isolator>& isolator,
+    const vector<Owned<Isolator>>& isolators,
     const ContainerID& containerId,
     const ContainerConfig& containerConfig,
-    const list<Option<ContainerLaunchInfo>> launchInfos)
+    const Option<ContainerLaunchInfo>& launchInfo)
 {
-  // Propagate any failure.
-  return isolator->prepare(containerId, containerConfig)
-    .then(lambda::bind(&accumulate, launchInfos, lambda::_1));
+  list<Future<Option<ContainerLaunchInfo>>> futures;
+  foreach (const Owned<Isolator>& isolator, isolators) {
+    futures.push_back(isolator->prepare(containerId, containerConfig));
+  }
+
+  // NOTE: We wait for all the isolators, rather than failing as soon
+  // as one of them fails, so that no isolator is cleaned up (by
+  // destroy) while it is still preparing.
+  return await(futures)
+    .then(lambda::bind(&__prepare, launchInfo, lambda::_1));
 }
 
 
@@ -818,24 +871,29 @@ Future<list<Option<ContainerLaunchInfo>>> MesosContainerizerProcess::prepare(
     containerConfig.set_rootfs(provisionInfo.get().rootfs);
   }
 
-  // We prepare the isolators sequentially according to their ordering
-  // to permit basic dependency specification, e.g., preparing a
-  // filesystem isolator before other isolators.
+  // We prepare the first isolator, i.e., the filesystem isolator (see
+  // 'MesosContainerizer::create()'), before the others so that they
+  // have a consistent view on the prepared filesystem. The runtime
+  // isolators do not depend on each other, hence they are prepared
+  // concurrently. The launch infos are in the order of the isolators.
   Future<list<Option<ContainerLaunchInfo>>> f =
     list<Option<ContainerLaunchInfo>>();
 
-  foreach (const Owned<Isolator>& isolator, isolators) {
-    // Chain together preparing each isolator.
-    f = f.then(lambda::bind(&_prepare,
-                            isolator,
-                            containerId,
-                            containerConfig,
-                            lambda::_1));
+  if (!isolators.empty()) {
+    const vector<Owned<Isolator>> runtime(
+        std::next(isolators.begin()), isolators.end());
+
+    f = isolators.front()->prepare(containerId, containerConfig)
+      .then(lambda::bind(&_prepare,
+                         runtime,
+                         containerId,
+                         containerConfig,
+                         lambda::_1));
   }
 
   containers_[containerId]->launchInfos = f;
 
-  return f;
+  return metrics.launch_prepare.time(f);
 }
 
 
@@ -860,6 +918,23 @@ Future<Nothing> MesosContainerizerProcess::fetch(
 }
 
 
+Future<Nothing> MesosContainerizerProcess::_fetch(
+    const ContainerID& containerId)
+{
+  if (!containers_.contains(containerId)) {
+    return Failure("Container is already destroyed");
+  }
+
+  Container* container = containers_[containerId].get();
+
+  if (container->fetching.isPending()) {
+    container->state = FETCHING;
+  }
+
+  return container->fetching;
+}
+
+
 Future<bool> MesosContainerizerProcess::__launch(
     const ContainerID& containerId,
     const ExecutorInfo& executorInfo,
@@ -1021,13 +1096,7 @@ Future<bool> MesosContainerizerProcess::__launch(
     containers_[containerId]->status = status;
 
     return isolate(containerId, pid)
-      .then(defer(self(),
-                  &Self::fetch,
-                  containerId,
-                  executorInfo.command(),
-                  directory,
-                  user,
-                  slaveId))
+      .then(defer(self(), &Self::_fetch, containerId))
       .then(defer(self(), &Self::exec, containerId, pipes[1]))
       .onAny(lambda::bind(&os::close, pipes[0]))
       .onAny(lambda::bind(&os::close, pipes[1]));
@@ -1063,7 +1132,8 @@ Future<bool> MesosContainerizerProcess::isolate(
 
   containers_[containerId]->isolation = future;
 
-  return future.then([]() { return true; });
+  return metrics.launch_isolate.time(future)
+    .then([]() { return true; });
 }
 
 
@@ -1226,6 +1296,13 @@ void MesosContainerizerProcess::destroy(
 
   LOG(INFO) << "Destroying container '" << containerId << "'";
 
+  // NOTE: The fetch starts together with the preparation of the
+  // container, so it might still be running in any of the states
+  // before the container is running.
+  if (container->fetching.isPending()) {
+    fetcher->kill(containerId);
+  }
+
   if (container->state == PREPARING) {
     VLOG(1) << "Waiting for the isolators to complete preparing before "
             << "destroying the container";
@@ -1236,19 +1313,17 @@ void MesosContainerizerProcess::destroy(
     // We need to wait for the isolators to finish preparing to prevent
     // a race that the destroy method calls isolators' cleanup before
     // it starts preparing.
-    container->launchInfos
-      .onAny(defer(
-          self(),
-          &Self::___destroy,
+    lambda::function<void()> f = [=]() {
+      ___destroy(
           containerId,
           status,
-          "Container destroyed while preparing isolators"));
+          "Container destroyed while preparing isolators");
+    };
 
-    return;
-  }
+    container->launchInfos
+      .onAny(defer(self(), &Self::schedule, containerId, f));
 
-  if (container->state == FETCHING) {
-    fetcher->kill(containerId);
+    return;
   }
 
   if (container->state == ISOLATING) {
@@ -1259,14 +1334,57 @@ void MesosContainerizerProcess::destroy(
 
     // Wait for the isolators to finish isolating before we start
     // to destroy the container.
+    lambda::function<void()> f = [=]() { _destroy(containerId); };
+
     container->isolation
-      .onAny(defer(self(), &Self::_destroy, containerId));
+      .onAny(defer(self(), &Self::schedule, containerId, f));
 
     return;
   }
 
   container->state = DESTROYING;
-  _destroy(containerId);
+  schedule(containerId, [=]() { _destroy(containerId); });
+}
+
+
+void MesosContainerizerProcess::schedule(
+    const ContainerID& containerId,
+    const lambda::function<void()>& f)
+{
+  Owned<Promise<Nothing>> promise(new Promise<Nothing>());
+
+  metrics.destroy_queue.time(promise->future())
+    .onReady(defer(self(), [f](const Nothing&) { f(); }));
+
+  if (flags.max_concurrent_container_destroys.isNone() ||
+      activeDestroys.size() < flags.max_concurrent_container_destroys.get()) {
+    activeDestroys.insert(containerId);
+    promise->set(Nothing());
+    return;
+  }
+
+  VLOG(1) << "Delaying the destroy of container '" << containerId
+          << "' as " << activeDestroys.size()
+          << " containers are being destroyed";
+
+  pendingDestroys.push_back(std::make_pair(containerId, promise));
+}
+
+
+void MesosContainerizerProcess::release(const ContainerID& containerId)
+{
+  if (activeDestroys.erase(containerId) == 0) {
+    return;
+  }
+
+  while (!pendingDestroys.empty() &&
+         (flags.max_concurrent_container_destroys.isNone() ||
+          activeDestroys.size() <
+            flags.max_concurrent_container_destroys.get())) {
+    activeDestroys.insert(pendingDestroys.front().first);
+    pendingDestroys.front().second->set(Nothing());
+    pendingDestroys.pop_front();
+  }
 }
 
 
@@ -1274,7 +1392,7 @@ void MesosContainerizerProcess::_destroy(
     const ContainerID& containerId)
 {
   // Kill all processes then continue destruction.
-  launcher->destroy(containerId)
+  metrics.destroy_launcher.time(launcher->destroy(containerId))
     .onAny(defer(self(), &Self::__destroy, containerId, lambda::_1));
 }
 
@@ -1300,6 +1418,8 @@ void MesosContainerizerProcess::__destroy(
 
     ++metrics.container_destroy_errors;
 
+    release(containerId);
+
     return;
   }
 
@@ -1321,7 +1441,7 @@ void MesosContainerizerProcess::___destroy(
     const Future<Option<int>>& status,
     const Option<string>& message)
 {
-  cleanupIsolators(containerId)
+  metrics.destroy_isolators.time(cleanupIsolators(containerId))
     .onAny(defer(self(),
                  &Self::____destroy,
                  containerId,
@@ -1342,6 +1462,8 @@ void MesosContainerizerProcess::____destroy(
   CHECK_READY(cleanups);
   CHECK(containers_.contains(containerId));
 
+  release(containerId);
+
   Container* container = containers_[containerId].get();
 
   // Check cleanup succeeded for all isolators. If not, we'll fail the
@@ -1362,7 +1484,7 @@ void MesosContainerizerProcess::____destroy(
     }
   }
 
-  provisioner->destroy(containerId)
+  metrics.destroy_provisioner.time(provisioner->destroy(containerId))
     .onAny(defer(self(),
                  &Self::_____destroy,
                  containerId,
@@ -1483,15 +1605,59 @@ Future<hashset<ContainerID>> MesosContainerizerProcess::containers()
 
 MesosContainerizerProcess::Metrics::Metrics()
   : container_destroy_errors(
-        "containerizer/mesos/container_destroy_errors")
+        "containerizer/mesos/container_destroy_errors"),
+    recovery_launcher(
+        "containerizer/mesos/recovery_launcher"),
+    recovery_isolators(
+        "containerizer/mesos/recovery_isolators"),
+    recovery_provisioner(
+        "containerizer/mesos/recovery_provisioner"),
+    launch_provision(
+        "containerizer/mesos/launch_provision", Hours(1)),
+    launch_prepare(
+        "containerizer/mesos/launch_prepare", Hours(1)),
+    launch_fetch(
+        "containerizer/mesos/launch_fetch", Hours(1)),
+    launch_isolate(
+        "containerizer/mesos/launch_isolate", Hours(1)),
+    destroy_queue(
+        "containerizer/mesos/destroy_queue", Hours(1)),
+    destroy_launcher(
+        "containerizer/mesos/destroy_launcher", Hours(1)),
+    destroy_isolators(
+        "containerizer/mesos/destroy_isolators", Hours(1)),
+    destroy_provisioner(
+        "containerizer/mesos/destroy_provisioner", Hours(1))
 {
   process::metrics::add(container_destroy_errors);
+  process::metrics::add(recovery_launcher);
+  process::metrics::add(recovery_isolators);
+  process::metrics::add(recovery_provisioner);
+  process::metrics::add(launch_provision);
+  process::metrics::add(launch_prepare);
+  process::metrics::add(launch_fetch);
+  process::metrics::add(launch_isolate);
+  process::metrics::add(destroy_queue);
+  process::metrics::add(destroy_launcher);
+  process::metrics::add(destroy_isolators);
+  process::metrics::add(destroy_provisioner);
 }
 
 
 MesosContainerizerProcess::Metrics::~Metrics()
 {
   process::metrics::remove(container_destroy_errors);
+  process::metrics::remove(recovery_launcher);
+  process::metrics::remove(recovery_isolators);
+  process::metrics::remove(recovery_provisioner);
+  process::metrics::remove(launch_provision);
+  process::metrics::remove(launch_prepare);
+  process::metrics::remove(launch_fetch);
+  process::metrics::remove(launch_isolate);
+  process::metrics::remove(destroy_queue);
+  process::metrics::remove(destroy_launcher);
+  process::metrics::remove(destroy_isolators);
+  process::metrics::remove(destroy_provisioner);
 }
 
 
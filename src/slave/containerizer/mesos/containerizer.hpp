@@ -17,15 +17,20 @@
 #ifndef __MESOS_CONTAINERIZER_HPP__
 #define __MESOS_CONTAINERIZER_HPP__
 
+#include <deque>
 #include <list>
+#include <utility>
 #include <vector>
 
 #include <mesos/slave/container_logger.hpp>
 #include <mesos/slave/isolator.hpp>
 
 #include <process/metrics/counter.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
 #include <stout/multihashmap.hpp>
 
 #include "slave/state.hpp"
@@ -70,6 +75,8 @@ public:
   virtual process::Future<Nothing> recover(
       const Option<state::SlaveState>& state);
 
+  virtual bool supports(const Option<ContainerInfo::Type>& type) const;
+
   virtual process::Future<bool> launch(
       const ContainerID& containerId,
       const ExecutorInfo& executorInfo,
@@ -198,6 +205,9 @@ private:
       const Option<std::string>& user,
       const SlaveID& slaveId);
 
+  // Waits for the fetch started by 'launch()' to complete.
+  process::Future<Nothing> _fetch(const ContainerID& containerId);
+
   process::Future<bool> _launch(
       const ContainerID& containerId,
       const Option<TaskInfo>& taskInfo,
@@ -223,6 +233,20 @@ private:
       const ContainerID& containerId,
       pid_t _pid);
 
+  // Runs 'f', which kills the processes of a container and cleans up
+  // its isolators, once fewer than '--max_concurrent_container_destroys'
+  // containers are being killed and cleaned up (in the order of the
+  // calls).
+  void schedule(
+      const ContainerID& containerId,
+      const lambda::function<void()>& f);
+
+  // Lets the next scheduled destroy run once a container has been
+  // killed and its isolators cleaned up (or failed to). Removing the
+  // provisioned filesystems of the container does not hold up the
+  // other destroys, since it does not free any resources.
+  void release(const ContainerID& containerId);
+
   // Continues 'destroy()' once isolators has completed.
   void _destroy(const ContainerID& containerId);
 
@@ -305,6 +329,11 @@ private:
     // calling cleanup after all isolators has finished isolating.
     process::Future<std::list<Nothing>> isolation;
 
+    // We keep track of the future of fetching the executor's URIs,
+    // which starts along with the provisioning and preparation of
+    // the container, so that destroy can kill the fetcher.
+    process::Future<Nothing> fetching;
+
     // We keep track of any limitations received from each isolator so we can
     // determine the cause of an executor termination.
     std::vector<mesos::slave::ContainerLimitation> limitations;
@@ -321,12 +350,37 @@ private:
 
   hashmap<ContainerID, process::Owned<Container>> containers_;
 
+  // The destroys waiting to be run by 'schedule()', and the containers
+  // being killed and cleaned up.
+  std::deque<std::pair<ContainerID, process::Owned<process::Promise<Nothing>>>>
+    pendingDestroys;
+  hashset<ContainerID> activeDestroys;
+
   struct Metrics
   {
     Metrics();
     ~Metrics();
 
     process::metrics::Counter container_destroy_errors;
+
+    // Time spent recovering the launcher, the isolators and the
+    // provisioner.
+    process::metrics::Timer<Milliseconds> recovery_launcher;
+    process::metrics::Timer<Milliseconds> recovery_isolators;
+    process::metrics::Timer<Milliseconds> recovery_provisioner;
+
+    // Time spent in each stage of launching a container.
+    process::metrics::Timer<Milliseconds> launch_provision;
+    process::metrics::Timer<Milliseconds> launch_prepare;
+    process::metrics::Timer<Milliseconds> launch_fetch;
+    process::metrics::Timer<Milliseconds> launch_isolate;
+
+    // Time spent waiting to be destroyed (see 'schedule()'), and in
+    // each stage of destroying a container.
+    process::metrics::Timer<Milliseconds> destroy_queue;
+    process::metrics::Timer<Milliseconds> destroy_launcher;
+    process::metrics::Timer<Milliseconds> destroy_isolators;
+    process::metrics::Timer<Milliseconds> destroy_provisioner;
   } metrics;
 };
 
@@ -17,6 +17,8 @@
 #ifndef __CGROUPS_ISOLATOR_CONSTANTS_HPP__
 #define __CGROUPS_ISOLATOR_CONSTANTS_HPP__
 
+#include <string>
+
 #include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 
@@ -30,11 +32,33 @@ const uint64_t CPU_SHARES_PER_CPU_REVOCABLE = 10;
 const uint64_t MIN_CPU_SHARES = 2; // Linux constant.
 const Duration CPU_CFS_PERIOD = Milliseconds(100); // Linux default.
 const Duration MIN_CPU_CFS_QUOTA = Milliseconds(1);
+const Duration MIN_CPU_CFS_PERIOD = Milliseconds(1); // Linux constant.
+const Duration MAX_CPU_CFS_PERIOD = Seconds(1); // Linux constant.
+
+// Label of a task overriding the CFS period of its container.
+const std::string CPU_CFS_PERIOD_LABEL = "cfs_period";
+
+// The interval at which the CFS quotas are tuned when bursting is
+// enabled, and the fraction of throttled periods above which a quota
+// is widened.
+const Duration CPU_CFS_TUNE_INTERVAL = Seconds(10);
+const double CPU_CFS_THROTTLED_RATIO = 0.05;
 
 
 // Memory subsystem constants.
 const Bytes MIN_MEMORY = Megabytes(32);
 
+// The interval at which the slave wide memory pressure is checked
+// when reclaim is enabled, the number of intervals without pressure
+// after which the soft limits are restored, and the fraction of its
+// usage reclaimed from a revocable container on critical pressure.
+const Duration MEMORY_RECLAIM_INTERVAL = Seconds(1);
+const size_t MEMORY_RECLAIM_RELEASE_INTERVALS = 30;
+const double MEMORY_RECLAIM_FRACTION = 0.1;
+
+// The amount of history kept for the memory pressure rates.
+const Duration MEMORY_PRESSURE_WINDOW = Minutes(5);
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
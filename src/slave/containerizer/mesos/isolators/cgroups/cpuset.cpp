@@ -0,0 +1,639 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <process/defer.hpp>
+#include <process/future.hpp>
+#include <process/pid.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/try.hpp>
+
+#include "linux/cgroups.hpp"
+#include "linux/numa.hpp"
+
+#include "slave/flags.hpp"
+
+#include "slave/containerizer/mesos/isolators/cgroups/cpuset.hpp"
+
+using std::list;
+using std::set;
+using std::string;
+using std::vector;
+
+using process::Failure;
+using process::Future;
+using process::Owned;
+using process::PID;
+
+using mesos::slave::ContainerConfig;
+using mesos::slave::ContainerLaunchInfo;
+using mesos::slave::ContainerLimitation;
+using mesos::slave::ContainerState;
+using mesos::slave::Isolator;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+CgroupsCpusetIsolatorProcess::CgroupsCpusetIsolatorProcess(
+    const Flags& _flags,
+    const string& _hierarchy,
+    const vector<numa::Node>& _nodes)
+  : flags(_flags),
+    hierarchy(_hierarchy),
+    nodes(_nodes) {}
+
+
+CgroupsCpusetIsolatorProcess::~CgroupsCpusetIsolatorProcess() {}
+
+
+Try<Isolator*> CgroupsCpusetIsolatorProcess::create(const Flags& flags)
+{
+  Try<string> hierarchy = cgroups::prepare(
+      flags.cgroups_hierarchy,
+      "cpuset",
+      flags.cgroups_root);
+
+  if (hierarchy.isError()) {
+    return Error("Failed to create cpuset cgroup: " + hierarchy.error());
+  }
+
+  // The CPUs and memory nodes of a new cpuset cgroup are empty and
+  // tasks can not be attached to it, or to its descendants, until
+  // they are set. Inherit them from the parent cgroups.
+  string parent = "/";
+  foreach (const string& name, strings::tokenize(flags.cgroups_root, "/")) {
+    const string cgroup = path::join(parent, name);
+
+    Try<string> cpus = cgroups::cpuset::cpus(hierarchy.get(), cgroup);
+    if (cpus.isError()) {
+      return Error("Failed to read the cpus of cgroup '" + cgroup + "': " +
+                   cpus.error());
+    }
+
+    if (cpus.get().empty()) {
+      cpus = cgroups::cpuset::cpus(hierarchy.get(), parent);
+      if (cpus.isError()) {
+        return Error("Failed to read the cpus of cgroup '" + parent + "': " +
+                     cpus.error());
+      }
+
+      Try<Nothing> write =
+        cgroups::cpuset::cpus(hierarchy.get(), cgroup, cpus.get());
+
+      if (write.isError()) {
+        return Error("Failed to set the cpus of cgroup '" + cgroup + "': " +
+                     write.error());
+      }
+    }
+
+    Try<string> mems = cgroups::cpuset::mems(hierarchy.get(), cgroup);
+    if (mems.isError()) {
+      return Error("Failed to read the mems of cgroup '" + cgroup + "': " +
+                   mems.error());
+    }
+
+    if (mems.get().empty()) {
+      mems = cgroups::cpuset::mems(hierarchy.get(), parent);
+      if (mems.isError()) {
+        return Error("Failed to read the mems of cgroup '" + parent + "': " +
+                     mems.error());
+      }
+
+      Try<Nothing> write =
+        cgroups::cpuset::mems(hierarchy.get(), cgroup, mems.get());
+
+      if (write.isError()) {
+        return Error("Failed to set the mems of cgroup '" + cgroup + "': " +
+                     write.error());
+      }
+    }
+
+    parent = cgroup;
+  }
+
+  Try<vector<numa::Node>> topology = numa::nodes();
+  if (topology.isError()) {
+    return Error("Failed to get the NUMA topology: " + topology.error());
+  }
+
+  // Restrict the nodes to the CPUs and memory nodes that the root
+  // cgroup is allowed to use, e.g., when the slave itself is run in a
+  // cpuset.
+  Try<string> cpus = cgroups::cpuset::cpus(hierarchy.get(), flags.cgroups_root);
+  if (cpus.isError()) {
+    return Error("Failed to read the cpus of the root cgroup: " +
+                 cpus.error());
+  }
+
+  Try<set<unsigned int>> allowedCpus = numa::parse(cpus.get());
+  if (allowedCpus.isError()) {
+    return Error("Failed to parse the cpus of the root cgroup: " +
+                 allowedCpus.error());
+  }
+
+  Try<string> mems = cgroups::cpuset::mems(hierarchy.get(), flags.cgroups_root);
+  if (mems.isError()) {
+    return Error("Failed to read the mems of the root cgroup: " +
+                 mems.error());
+  }
+
+  Try<set<unsigned int>> allowedMems = numa::parse(mems.get());
+  if (allowedMems.isError()) {
+    return Error("Failed to parse the mems of the root cgroup: " +
+                 allowedMems.error());
+  }
+
+  vector<numa::Node> nodes;
+  foreach (numa::Node node, topology.get()) {
+    if (allowedMems.get().count(node.id) == 0) {
+      continue;
+    }
+
+    set<unsigned int> cpus;
+    std::set_intersection(
+        node.cpus.begin(), node.cpus.end(),
+        allowedCpus.get().begin(), allowedCpus.get().end(),
+        std::inserter(cpus, cpus.begin()));
+
+    // Memory only nodes can not run the containers.
+    if (cpus.empty()) {
+      continue;
+    }
+
+    node.cpus = cpus;
+    nodes.push_back(node);
+  }
+
+  if (nodes.empty()) {
+    return Error("No NUMA node is available to the root cgroup");
+  }
+
+  foreach (const numa::Node& node, nodes) {
+    LOG(INFO) << "NUMA node " << node.id << " has cpus "
+              << numa::format(node.cpus) << " and " << node.memory
+              << " of memory";
+  }
+
+  process::Owned<MesosIsolatorProcess> process(
+      new CgroupsCpusetIsolatorProcess(flags, hierarchy.get(), nodes));
+
+  return new MesosIsolator(process);
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::recover(
+    const list<ContainerState>& states,
+    const hashset<ContainerID>& orphans)
+{
+  foreach (const ContainerState& state, states) {
+    const ContainerID& containerId = state.container_id();
+    const string cgroup = path::join(flags.cgroups_root, containerId.value());
+
+    Try<bool> exists = cgroups::exists(hierarchy, cgroup);
+    if (exists.isError()) {
+      infos.clear();
+      return Failure("Failed to check cgroup for container '" +
+                     stringify(containerId) + "'");
+    }
+
+    if (!exists.get()) {
+      VLOG(1) << "Couldn't find cgroup for container " << containerId;
+      // This may occur if the executor has exited and the isolator
+      // has destroyed the cgroup but the slave dies before noticing
+      // this. This will be detected when the containerizer tries to
+      // monitor the executor's pid.
+      continue;
+    }
+
+    Try<string> mems = cgroups::cpuset::mems(hierarchy, cgroup);
+    if (mems.isError()) {
+      infos.clear();
+      return Failure("Failed to read the mems of container '" +
+                     stringify(containerId) + "': " + mems.error());
+    }
+
+    Try<set<unsigned int>> ids = numa::parse(mems.get());
+    if (ids.isError()) {
+      infos.clear();
+      return Failure("Failed to parse the mems of container '" +
+                     stringify(containerId) + "': " + ids.error());
+    }
+
+    vector<numa::Node> pinned;
+    foreach (const numa::Node& node, nodes) {
+      if (ids.get().count(node.id) > 0) {
+        pinned.push_back(node);
+      }
+    }
+
+    infos.emplace(containerId, Info(cgroup));
+
+    // Account for the recovered containers on the nodes they are
+    // pinned to, the containers will be placed again on update if
+    // these nodes are no longer available.
+    const Resources resources = state.executor_info().resources();
+
+    assign(
+        &infos.at(containerId),
+        containerId,
+        pinned,
+        resources.cpus().getOrElse(0),
+        resources.mem().getOrElse(Bytes(0)));
+  }
+
+  // Remove orphan cgroups.
+  Try<vector<string>> cgroups = cgroups::get(hierarchy, flags.cgroups_root);
+  if (cgroups.isError()) {
+    infos.clear();
+    return Failure(cgroups.error());
+  }
+
+  foreach (const string& cgroup, cgroups.get()) {
+    // Ignore the slave cgroup (see the --slave_subsystems flag).
+    // TODO(idownes): Remove this when the cgroups layout is updated,
+    // see MESOS-1185.
+    if (cgroup == path::join(flags.cgroups_root, "slave")) {
+      continue;
+    }
+
+    ContainerID containerId;
+    containerId.set_value(Path(cgroup).basename());
+
+    if (infos.contains(containerId)) {
+      continue;
+    }
+
+    // Known orphan cgroups will be destroyed by the containerizer
+    // using the normal cleanup path. See MESOS-2367 for details.
+    if (orphans.contains(containerId)) {
+      infos.emplace(containerId, Info(cgroup));
+      continue;
+    }
+
+    LOG(INFO) << "Removing unknown orphaned cgroup '" << cgroup << "'";
+
+    // We don't wait on the destroy as we don't want to block recovery.
+    cgroups::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT);
+  }
+
+  return Nothing();
+}
+
+
+Future<Option<ContainerLaunchInfo>> CgroupsCpusetIsolatorProcess::prepare(
+    const ContainerID& containerId,
+    const ContainerConfig& containerConfig)
+{
+  if (infos.contains(containerId)) {
+    return Failure("Container has already been prepared");
+  }
+
+  // Use this info to create the cgroup, but do not insert it into
+  // infos till the cgroup has been created successfully.
+  Info info(path::join(flags.cgroups_root, containerId.value()));
+
+  // Create a cgroup for this container.
+  Try<bool> exists = cgroups::exists(hierarchy, info.cgroup);
+  if (exists.isError()) {
+    return Failure("Failed to check if the cgroup already exists: " +
+                   exists.error());
+  } else if (exists.get()) {
+    return Failure("The cgroup already exists");
+  }
+
+  Try<Nothing> create = cgroups::create(hierarchy, info.cgroup);
+  if (create.isError()) {
+    return Failure("Failed to create the cgroup: " + create.error());
+  }
+
+  // Move the memory of the container along when it is pinned to
+  // other nodes on update.
+  Try<Nothing> migrate =
+    cgroups::write(hierarchy, info.cgroup, "cpuset.memory_migrate", "1");
+
+  if (migrate.isError()) {
+    return Failure("Failed to enable memory migration: " + migrate.error());
+  }
+
+  // 'chown' the cgroup so the executor can create nested cgroups. Do
+  // not recurse so the control files are still owned by the slave
+  // user and thus cannot be changed by the executor.
+  if (containerConfig.has_user()) {
+    Try<Nothing> chown = os::chown(
+        containerConfig.user(),
+        path::join(hierarchy, info.cgroup),
+        false);
+
+    if (chown.isError()) {
+      return Failure("Failed to change ownership of cgroup hierarchy: " +
+                     chown.error());
+    }
+  }
+
+  infos.emplace(containerId, info);
+
+  return update(containerId, containerConfig.executorinfo().resources())
+    .then([]() -> Future<Option<ContainerLaunchInfo>> {
+      return None();
+    });
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::isolate(
+    const ContainerID& containerId,
+    pid_t pid)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  const Info& info = infos.at(containerId);
+
+  Try<Nothing> assign = cgroups::assign(hierarchy, info.cgroup, pid);
+  if (assign.isError()) {
+    return Failure("Failed to assign container '" +
+                   stringify(containerId) + "' to its own cgroup '" +
+                   path::join(hierarchy, info.cgroup) +
+                   "': " + assign.error());
+  }
+
+  return Nothing();
+}
+
+
+// Pinning does not limit the resources of a container any further
+// than the cpu and mem isolators do.
+Future<ContainerLimitation> CgroupsCpusetIsolatorProcess::watch(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  return Future<ContainerLimitation>();
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::update(
+    const ContainerID& containerId,
+    const Resources& resources)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Option<double> cpus = resources.cpus();
+  if (cpus.isNone()) {
+    return Failure("No cpus resource given");
+  }
+
+  const Bytes mem = resources.mem().getOrElse(Bytes(0));
+
+  Info* info = &infos.at(containerId);
+
+  set<unsigned int> current;
+  foreachkey (unsigned int id, info->cpus) {
+    current.insert(id);
+  }
+
+  const vector<numa::Node> pinned =
+    place(containerId, cpus.get(), mem, current);
+
+  set<unsigned int> ids;
+  set<unsigned int> cpuIds;
+  foreach (const numa::Node& node, pinned) {
+    ids.insert(node.id);
+    cpuIds.insert(node.cpus.begin(), node.cpus.end());
+  }
+
+  if (ids != current) {
+    Try<Nothing> write =
+      cgroups::cpuset::cpus(hierarchy, info->cgroup, numa::format(cpuIds));
+
+    if (write.isError()) {
+      return Failure("Failed to update 'cpuset.cpus': " + write.error());
+    }
+
+    write = cgroups::cpuset::mems(hierarchy, info->cgroup, numa::format(ids));
+    if (write.isError()) {
+      return Failure("Failed to update 'cpuset.mems': " + write.error());
+    }
+
+    LOG(INFO) << "Pinned container " << containerId << " to NUMA node(s) "
+              << numa::format(ids) << " for " << cpus.get() << " cpus and "
+              << mem << " of memory";
+  }
+
+  assign(info, containerId, pinned, cpus.get(), mem);
+
+  return Nothing();
+}
+
+
+// The NUMA nodes of a container are not resources and hence have no
+// notion of usage. We are therefore returning an empty
+// 'ResourceStatistics' object.
+Future<ResourceStatistics> CgroupsCpusetIsolatorProcess::usage(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  return ResourceStatistics();
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::cleanup(
+    const ContainerID& containerId)
+{
+  // Multiple calls may occur during test clean up.
+  if (!infos.contains(containerId)) {
+    VLOG(1) << "Ignoring cleanup request for unknown container: "
+            << containerId;
+    return Nothing();
+  }
+
+  const Info& info = infos.at(containerId);
+
+  return cgroups::destroy(hierarchy, info.cgroup, cgroups::DESTROY_TIMEOUT)
+    .then(defer(PID<CgroupsCpusetIsolatorProcess>(this), [=]() {
+      infos.erase(containerId);
+      return Nothing();
+    }));
+}
+
+
+double CgroupsCpusetIsolatorProcess::freeCpus(
+    const numa::Node& node,
+    const ContainerID& ignore) const
+{
+  double allocated = 0;
+  foreachpair (const ContainerID& containerId, const Info& info, infos) {
+    if (containerId != ignore && info.cpus.contains(node.id)) {
+      allocated += info.cpus.at(node.id);
+    }
+  }
+
+  return std::max(node.cpus.size() - allocated, 0.0);
+}
+
+
+Bytes CgroupsCpusetIsolatorProcess::freeMem(
+    const numa::Node& node,
+    const ContainerID& ignore) const
+{
+  Bytes allocated;
+  foreachpair (const ContainerID& containerId, const Info& info, infos) {
+    if (containerId != ignore && info.mem.contains(node.id)) {
+      allocated += info.mem.at(node.id);
+    }
+  }
+
+  return allocated < node.memory ? node.memory - allocated : Bytes(0);
+}
+
+
+vector<numa::Node> CgroupsCpusetIsolatorProcess::place(
+    const ContainerID& containerId,
+    double cpus,
+    const Bytes& mem,
+    const set<unsigned int>& current) const
+{
+  auto fits = [&](const vector<numa::Node>& candidates) {
+    double availableCpus = 0;
+    Bytes availableMem;
+    foreach (const numa::Node& node, candidates) {
+      availableCpus += freeCpus(node, containerId);
+      availableMem += freeMem(node, containerId);
+    }
+
+    return availableCpus >= cpus && availableMem >= mem;
+  };
+
+  // The nodes to spread over, most free CPUs first.
+  auto spread = [&](vector<numa::Node> candidates) {
+    std::stable_sort(
+        candidates.begin(),
+        candidates.end(),
+        [&](const numa::Node& a, const numa::Node& b) {
+          return freeCpus(a, containerId) > freeCpus(b, containerId);
+        });
+
+    return candidates;
+  };
+
+  vector<numa::Node> pinned;
+  vector<numa::Node> others;
+  foreach (const numa::Node& node, nodes) {
+    if (current.count(node.id) > 0) {
+      pinned.push_back(node);
+    } else {
+      others.push_back(node);
+    }
+  }
+
+  if (!pinned.empty()) {
+    // Narrow down to a single one of the current nodes if possible,
+    // which only migrates the memory on the other current nodes.
+    foreach (const numa::Node& node, spread(pinned)) {
+      if (fits({node})) {
+        return {node};
+      }
+    }
+
+    if (fits(pinned)) {
+      return pinned;
+    }
+  } else {
+    // Best fit, i.e., the node with the fewest free CPUs that fits
+    // the container, so that the larger nodes remain available.
+    Option<numa::Node> best;
+    foreach (const numa::Node& node, nodes) {
+      if (fits({node}) &&
+          (best.isNone() ||
+           freeCpus(node, containerId) < freeCpus(best.get(), containerId))) {
+        best = node;
+      }
+    }
+
+    if (best.isSome()) {
+      return {best.get()};
+    }
+  }
+
+  // Extend over the other nodes, keeping the current ones so that
+  // their memory is not migrated.
+  foreach (const numa::Node& node, spread(others)) {
+    pinned.push_back(node);
+    if (fits(pinned)) {
+      return pinned;
+    }
+  }
+
+  LOG(WARNING) << "Not enough free cpus or memory on the NUMA nodes for "
+               << cpus << " cpus and " << mem << " of memory of container "
+               << containerId << ", sharing all of the nodes";
+
+  return nodes;
+}
+
+
+void CgroupsCpusetIsolatorProcess::assign(
+    Info* info,
+    const ContainerID& containerId,
+    const vector<numa::Node>& pinned,
+    double cpus,
+    Bytes mem)
+{
+  info->cpus.clear();
+  info->mem.clear();
+
+  if (pinned.empty()) {
+    return;
+  }
+
+  // Fill the free CPUs and memory of the nodes in order, the rest (if
+  // any) overcommits the first node.
+  foreach (const numa::Node& node, pinned) {
+    const double share = std::min(freeCpus(node, containerId), cpus);
+    const Bytes memShare = std::min(freeMem(node, containerId), mem);
+
+    info->cpus[node.id] = share;
+    info->mem[node.id] = memShare;
+
+    cpus -= share;
+    mem -= memShare;
+  }
+
+  info->cpus[pinned.front().id] += cpus;
+  info->mem[pinned.front().id] += mem;
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,133 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __CGROUPS_CPUSET_ISOLATOR_HPP__
+#define __CGROUPS_CPUSET_ISOLATOR_HPP__
+
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <stout/bytes.hpp>
+#include <stout/hashmap.hpp>
+
+#include "linux/numa.hpp"
+
+#include "slave/containerizer/mesos/isolator.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Uses the Linux cpuset subsystem to pin containers to the CPUs and
+// memory of as few NUMA nodes as their cpus and mem allocation
+// allows, so that their memory accesses stay local. A container is
+// placed on the node which fits it best, or spread over the nodes
+// with the most free CPUs when no single node fits it. On update the
+// container stays on its current nodes whenever they still fit it, so
+// that its memory is migrated (see cpuset.memory_migrate) only when
+// needed. The nodes are not dedicated to the containers, i.e., when
+// the host is full the containers share them. See:
+// https://www.kernel.org/doc/Documentation/cgroups/cpusets.txt
+class CgroupsCpusetIsolatorProcess : public MesosIsolatorProcess
+{
+public:
+  static Try<mesos::slave::Isolator*> create(const Flags& flags);
+
+  virtual ~CgroupsCpusetIsolatorProcess();
+
+  virtual process::Future<Nothing> recover(
+      const std::list<mesos::slave::ContainerState>& states,
+      const hashset<ContainerID>& orphans);
+
+  virtual process::Future<Option<mesos::slave::ContainerLaunchInfo>> prepare(
+      const ContainerID& containerId,
+      const mesos::slave::ContainerConfig& containerConfig);
+
+  virtual process::Future<Nothing> isolate(
+      const ContainerID& containerId,
+      pid_t pid);
+
+  virtual process::Future<mesos::slave::ContainerLimitation> watch(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> update(
+      const ContainerID& containerId,
+      const Resources& resources);
+
+  virtual process::Future<ResourceStatistics> usage(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> cleanup(
+      const ContainerID& containerId);
+
+private:
+  CgroupsCpusetIsolatorProcess(
+      const Flags& flags,
+      const std::string& hierarchy,
+      const std::vector<numa::Node>& nodes);
+
+  struct Info
+  {
+    Info(const std::string& _cgroup)
+      : cgroup(_cgroup) {}
+
+    const std::string cgroup;
+
+    // The share of the allocation of the container on each of the
+    // nodes it is pinned to, keyed by node id.
+    hashmap<unsigned int, double> cpus;
+    hashmap<unsigned int, Bytes> mem;
+  };
+
+  // Returns the CPUs and memory of a node which are not allocated to
+  // the containers, ignoring the given container.
+  double freeCpus(const numa::Node& node, const ContainerID& ignore) const;
+  Bytes freeMem(const numa::Node& node, const ContainerID& ignore) const;
+
+  // Returns the nodes to pin the container to, preferring the given
+  // nodes the container is currently pinned to.
+  std::vector<numa::Node> place(
+      const ContainerID& containerId,
+      double cpus,
+      const Bytes& mem,
+      const std::set<unsigned int>& current) const;
+
+  // Splits the allocation of the container over the nodes.
+  void assign(
+      Info* info,
+      const ContainerID& containerId,
+      const std::vector<numa::Node>& nodes,
+      double cpus,
+      Bytes mem);
+
+  const Flags flags;
+
+  const std::string hierarchy;
+
+  // The nodes available to the containers, i.e., restricted to the
+  // CPUs and memory of the root cgroup.
+  const std::vector<numa::Node> nodes;
+
+  hashmap<ContainerID, Info> infos;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __CGROUPS_CPUSET_ISOLATOR_HPP__
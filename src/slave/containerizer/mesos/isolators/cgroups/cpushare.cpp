@@ -21,6 +21,7 @@
 
 #include <process/collect.hpp>
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/pid.hpp>
 
 #include <stout/bytes.hpp>
@@ -61,7 +62,15 @@ CgroupsCpushareIsolatorProcess::CgroupsCpushareIsolatorProcess(
     const vector<string>& _subsystems)
   : flags(_flags),
     hierarchies(_hierarchies),
-    subsystems(_subsystems) {}
+    subsystems(_subsystems)
+{
+  foreach (const string& subsystem, subsystems) {
+    pools[subsystem] = Owned<CgroupsPool>(new CgroupsPool(
+        hierarchies[subsystem],
+        flags.cgroups_root,
+        flags.cgroups_pool_size));
+  }
+}
 
 
 CgroupsCpushareIsolatorProcess::~CgroupsCpushareIsolatorProcess() {}
@@ -154,6 +163,25 @@ Try<Isolator*> CgroupsCpushareIsolatorProcess::create(const Flags& flags)
           "Failed to find 'cpu.cfs_quota_us'. Your kernel "
           "might be too old to use the CFS cgroups feature.");
     }
+
+    vector<Duration> periods = {flags.cgroups_cfs_period};
+    if (flags.cgroups_revocable_cfs_period.isSome()) {
+      periods.push_back(flags.cgroups_revocable_cfs_period.get());
+    }
+
+    foreach (const Duration& period, periods) {
+      if (period < MIN_CPU_CFS_PERIOD || period > MAX_CPU_CFS_PERIOD) {
+        return Error(
+            "Invalid CFS period " + stringify(period) + ": must be in [" +
+            stringify(MIN_CPU_CFS_PERIOD) + ", " +
+            stringify(MAX_CPU_CFS_PERIOD) + "]");
+      }
+    }
+
+    if (flags.cgroups_cfs_burst_factor.isSome() &&
+        flags.cgroups_cfs_burst_factor.get() < 1) {
+      return Error("Invalid CFS burst factor: must be at least 1");
+    }
   }
 
   process::Owned<MesosIsolatorProcess> process(
@@ -163,6 +191,16 @@ Try<Isolator*> CgroupsCpushareIsolatorProcess::create(const Flags& flags)
 }
 
 
+void CgroupsCpushareIsolatorProcess::initialize()
+{
+  if (flags.cgroups_enable_cfs && flags.cgroups_cfs_burst_factor.isSome()) {
+    delay(CPU_CFS_TUNE_INTERVAL,
+          PID<CgroupsCpushareIsolatorProcess>(this),
+          &CgroupsCpushareIsolatorProcess::tune);
+  }
+}
+
+
 Future<Nothing> CgroupsCpushareIsolatorProcess::recover(
     const list<ContainerState>& states,
     const hashset<ContainerID>& orphans)
@@ -190,7 +228,23 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::recover(
       continue;
     }
 
-    infos[containerId] = new Info(containerId, cgroup);
+    Info* info = new Info(containerId, cgroup);
+
+    // Keep the CFS period the container was given, which may have
+    // been selected by its task.
+    if (flags.cgroups_enable_cfs) {
+      Try<Duration> period =
+        cgroups::cpu::cfs_period_us(hierarchies["cpu"], cgroup);
+
+      if (period.isError()) {
+        LOG(WARNING) << "Failed to read 'cpu.cfs_period_us' for container "
+                     << containerId << ": " << period.error();
+      } else {
+        info->period = period.get();
+      }
+    }
+
+    infos[containerId] = info;
   }
 
   // Remove orphan cgroups.
@@ -215,6 +269,11 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::recover(
         continue;
       }
 
+      // The cgroups of the pool are recovered by the pool below.
+      if (CgroupsPool::pooled(cgroup)) {
+        continue;
+      }
+
       ContainerID containerId;
       containerId.set_value(Path(cgroup).basename());
 
@@ -238,6 +297,15 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::recover(
           cgroup,
           cgroups::DESTROY_TIMEOUT);
     }
+
+    Try<Nothing> recover = pools[subsystem]->recover();
+    if (recover.isError()) {
+      foreachvalue (Info* info, infos) {
+        delete info;
+      }
+      infos.clear();
+      return Failure("Failed to recover the cgroups pool: " + recover.error());
+    }
   }
 
   return Nothing();
@@ -261,6 +329,32 @@ Future<Option<ContainerLaunchInfo>> CgroupsCpushareIsolatorProcess::prepare(
 
   infos[containerId] = info;
 
+  if (containerConfig.has_taskinfo() &&
+      containerConfig.taskinfo().has_labels()) {
+    foreach (const Label& label,
+             containerConfig.taskinfo().labels().labels()) {
+      if (label.key() != CPU_CFS_PERIOD_LABEL || !label.has_value()) {
+        continue;
+      }
+
+      Try<Duration> period = Duration::parse(label.value());
+      if (period.isError()) {
+        return Failure(
+            "Failed to parse the '" + CPU_CFS_PERIOD_LABEL + "' label: " +
+            period.error());
+      } else if (period.get() < MIN_CPU_CFS_PERIOD ||
+                 period.get() > MAX_CPU_CFS_PERIOD) {
+        return Failure(
+            "Invalid '" + CPU_CFS_PERIOD_LABEL + "' label " +
+            stringify(period.get()) + ": must be in [" +
+            stringify(MIN_CPU_CFS_PERIOD) + ", " +
+            stringify(MAX_CPU_CFS_PERIOD) + "]");
+      }
+
+      info->period = period.get();
+    }
+  }
+
   foreach (const string& subsystem, subsystems) {
     Try<bool> exists = cgroups::exists(hierarchies[subsystem], info->cgroup);
     if (exists.isError()) {
@@ -269,7 +363,7 @@ Future<Option<ContainerLaunchInfo>> CgroupsCpushareIsolatorProcess::prepare(
       return Failure("Failed to prepare isolator: cgroup already exists");
     }
 
-    Try<Nothing> create = cgroups::create(hierarchies[subsystem], info->cgroup);
+    Try<Nothing> create = pools[subsystem]->create(info->cgroup);
     if (create.isError()) {
       return Failure("Failed to prepare isolator: " + create.error());
     }
@@ -392,23 +486,23 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::update(
 
   // Set cfs quota if enabled.
   if (flags.cgroups_enable_cfs) {
-    write = cgroups::cpu::cfs_period_us(
-        hierarchy.get(),
-        info->cgroup,
-        CPU_CFS_PERIOD);
+    const Duration period = this->period(info, resources);
 
+    write = cgroups::cpu::cfs_period_us(hierarchy.get(), info->cgroup, period);
     if (write.isError()) {
       return Failure("Failed to update 'cpu.cfs_period_us': " + write.error());
     }
 
-    Duration quota = std::max(CPU_CFS_PERIOD * cpus, MIN_CPU_CFS_QUOTA);
+    Duration quota = std::max(period * cpus, MIN_CPU_CFS_QUOTA);
 
     write = cgroups::cpu::cfs_quota_us(hierarchy.get(), info->cgroup, quota);
     if (write.isError()) {
       return Failure("Failed to update 'cpu.cfs_quota_us': " + write.error());
     }
 
-    LOG(INFO) << "Updated 'cpu.cfs_period_us' to " << CPU_CFS_PERIOD
+    info->quota = quota;
+
+    LOG(INFO) << "Updated 'cpu.cfs_period_us' to " << period
               << " and 'cpu.cfs_quota_us' to " << quota
               << " (cpus " << cpus << ")"
               << " for container " << containerId;
@@ -465,20 +559,19 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
   PCHECK(ticks > 0) << "Failed to get sysconf(_SC_CLK_TCK)";
 
   // Add the cpuacct.stat information.
-  Try<hashmap<string, uint64_t>> stat = cgroups::stat(
-      hierarchies["cpuacct"],
-      info->cgroup,
-      "cpuacct.stat");
+  // TODO(bmahler): Add namespacing to cgroups to enforce the expected
+  // structure, e.g., cgroups::cpuacct::stat.
+  Option<uint64_t> user;
+  Option<uint64_t> system;
+
+  Try<Nothing> stat = reader(info, "cpuacct", "cpuacct.stat")->stat({
+      {"user", &user},
+      {"system", &system}});
 
   if (stat.isError()) {
     return Failure("Failed to read cpuacct.stat: " + stat.error());
   }
 
-  // TODO(bmahler): Add namespacing to cgroups to enforce the expected
-  // structure, e.g., cgroups::cpuacct::stat.
-  Option<uint64_t> user = stat.get().get("user");
-  Option<uint64_t> system = stat.get().get("system");
-
   if (user.isSome() && system.isSome()) {
     result.set_cpus_user_time_secs((double) user.get() / (double) ticks);
     result.set_cpus_system_time_secs((double) system.get() / (double) ticks);
@@ -486,22 +579,27 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
 
   // Add the cpu.stat information only if CFS is enabled.
   if (flags.cgroups_enable_cfs) {
-    stat = cgroups::stat(hierarchies["cpu"], info->cgroup, "cpu.stat");
+    Option<uint64_t> nr_periods;
+    Option<uint64_t> nr_throttled;
+    Option<uint64_t> throttled_time;
+
+    stat = reader(info, "cpu", "cpu.stat")->stat({
+        {"nr_periods", &nr_periods},
+        {"nr_throttled", &nr_throttled},
+        {"throttled_time", &throttled_time}});
+
     if (stat.isError()) {
       return Failure("Failed to read cpu.stat: " + stat.error());
     }
 
-    Option<uint64_t> nr_periods = stat.get().get("nr_periods");
     if (nr_periods.isSome()) {
       result.set_cpus_nr_periods(nr_periods.get());
     }
 
-    Option<uint64_t> nr_throttled = stat.get().get("nr_throttled");
     if (nr_throttled.isSome()) {
       result.set_cpus_nr_throttled(nr_throttled.get());
     }
 
-    Option<uint64_t> throttled_time = stat.get().get("throttled_time");
     if (throttled_time.isSome()) {
       result.set_cpus_throttled_time_secs(
           Nanoseconds(throttled_time.get()).secs());
@@ -512,6 +610,130 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
 }
 
 
+Duration CgroupsCpushareIsolatorProcess::period(
+    const Info* info,
+    const Resources& resources) const
+{
+  if (info->period.isSome()) {
+    return info->period.get();
+  }
+
+  if (resources.revocable().cpus().isSome() &&
+      flags.cgroups_revocable_cfs_period.isSome()) {
+    return flags.cgroups_revocable_cfs_period.get();
+  }
+
+  return flags.cgroups_cfs_period;
+}
+
+
+void CgroupsCpushareIsolatorProcess::tune()
+{
+  const Option<string>& hierarchy = hierarchies.get("cpu");
+  CHECK_SOME(hierarchy);
+
+  foreachvalue (Info* info, infos) {
+    // Revocable containers are never widened so that they do not
+    // use more than they have been allocated.
+    if (info->resources.isNone() ||
+        info->resources.get().cpus().isNone() ||
+        info->quota.isNone() ||
+        info->resources.get().revocable().cpus().isSome()) {
+      continue;
+    }
+
+    Option<uint64_t> nr_periods;
+    Option<uint64_t> nr_throttled;
+
+    Try<Nothing> stat = reader(info, "cpu", "cpu.stat")->stat({
+        {"nr_periods", &nr_periods},
+        {"nr_throttled", &nr_throttled}});
+
+    if (stat.isError()) {
+      LOG(WARNING) << "Failed to read cpu.stat for container "
+                   << info->containerId << ": " << stat.error();
+      continue;
+    }
+
+    if (nr_periods.isNone() || nr_throttled.isNone()) {
+      continue;
+    }
+
+    Option<uint64_t> periods = info->periods;
+    Option<uint64_t> throttled = info->throttled;
+
+    info->periods = nr_periods;
+    info->throttled = nr_throttled;
+
+    if (periods.isNone() ||
+        throttled.isNone() ||
+        nr_periods.get() <= periods.get() ||
+        nr_throttled.get() < throttled.get()) {
+      continue;
+    }
+
+    const double ratio =
+      (double) (nr_throttled.get() - throttled.get()) /
+      (double) (nr_periods.get() - periods.get());
+
+    const Resources& resources = info->resources.get();
+    const double cpus = resources.cpus().get();
+
+    const Duration allocated =
+      std::max(period(info, resources) * cpus, MIN_CPU_CFS_QUOTA);
+
+    Duration quota = info->quota.get();
+
+    if (ratio > CPU_CFS_THROTTLED_RATIO) {
+      quota = std::min(
+          quota * 1.5,
+          allocated * flags.cgroups_cfs_burst_factor.get());
+    } else if (ratio == 0) {
+      quota = std::max(quota * 0.9, allocated);
+    }
+
+    if (quota == info->quota.get()) {
+      continue;
+    }
+
+    Try<Nothing> write =
+      cgroups::cpu::cfs_quota_us(hierarchy.get(), info->cgroup, quota);
+
+    if (write.isError()) {
+      LOG(WARNING) << "Failed to update 'cpu.cfs_quota_us' for container "
+                   << info->containerId << ": " << write.error();
+      continue;
+    }
+
+    LOG(INFO) << "Updated 'cpu.cfs_quota_us' to " << quota
+              << " (cpus " << cpus << ", throttled in "
+              << ratio * 100 << "% of the periods)"
+              << " for container " << info->containerId;
+
+    info->quota = quota;
+  }
+
+  delay(CPU_CFS_TUNE_INTERVAL,
+        PID<CgroupsCpushareIsolatorProcess>(this),
+        &CgroupsCpushareIsolatorProcess::tune);
+}
+
+
+cgroups::Reader* CgroupsCpushareIsolatorProcess::reader(
+    Info* info,
+    const string& subsystem,
+    const string& control)
+{
+  if (!info->readers.contains(control)) {
+    info->readers[control] =
+      Owned<cgroups::Reader>(
+          new cgroups::Reader(hierarchies[subsystem], info->cgroup, control));
+  }
+
+  return info->readers[control].get();
+}
+
+
 Future<Nothing> CgroupsCpushareIsolatorProcess::cleanup(
     const ContainerID& containerId)
 {
@@ -527,8 +749,7 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::cleanup(
 
   list<Future<Nothing>> futures;
   foreach (const string& subsystem, subsystems) {
-    futures.push_back(cgroups::destroy(
-        hierarchies[subsystem],
+    futures.push_back(pools[subsystem]->destroy(
         info->cgroup,
         cgroups::DESTROY_TIMEOUT));
   }
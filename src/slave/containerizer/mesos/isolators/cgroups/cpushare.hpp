@@ -23,15 +23,19 @@
 #include <vector>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
 
 #include <stout/hashmap.hpp>
 #include <stout/option.hpp>
 
+#include "linux/cgroups.hpp"
+
 #include "slave/flags.hpp"
 
 #include "slave/containerizer/mesos/isolator.hpp"
 
 #include "slave/containerizer/mesos/isolators/cgroups/constants.hpp"
+#include "slave/containerizer/mesos/isolators/cgroups/pool.hpp"
 
 namespace mesos {
 namespace internal {
@@ -40,7 +44,9 @@ namespace slave {
 // Use the Linux cpu cgroup controller for cpu isolation which uses the
 // Completely Fair Scheduler (CFS).
 // - cpushare implements proportionally weighted scheduling.
-// - cfs implements hard quota based scheduling.
+// - cfs implements hard quota based scheduling. The quota of regular
+//   containers can be widened while they are throttled (see the
+//   --cgroups_cfs_burst_factor flag).
 class CgroupsCpushareIsolatorProcess : public MesosIsolatorProcess
 {
 public:
@@ -73,6 +79,9 @@ public:
   virtual process::Future<Nothing> cleanup(
       const ContainerID& containerId);
 
+protected:
+  virtual void initialize();
+
 private:
   CgroupsCpushareIsolatorProcess(
       const Flags& flags,
@@ -93,9 +102,40 @@ private:
     Option<pid_t> pid;
     Option<Resources> resources;
 
+    // The CFS period selected by the task or recovered from the
+    // cgroup, if any, and the current CFS quota.
+    Option<Duration> period;
+    Option<Duration> quota;
+
+    // The 'nr_periods' and 'nr_throttled' counters of 'cpu.stat' at
+    // the last tuning of the quota.
+    Option<uint64_t> periods;
+    Option<uint64_t> throttled;
+
     process::Promise<mesos::slave::ContainerLimitation> limitation;
+
+    // Readers of the statistics controls of the cgroup, kept open
+    // across calls to 'usage'.
+    hashmap<std::string, process::Owned<cgroups::Reader>> readers;
   };
 
+  // Returns the CFS period of the container for the given resources:
+  // the one selected by its task or the one of its latency class,
+  // i.e., regular or revocable CPU.
+  Duration period(const Info* info, const Resources& resources) const;
+
+  // Widens the CFS quota of the throttled regular containers, up to
+  // the burst factor, and shrinks it back when they are not.
+  void tune();
+
+  // Returns the reader of the given control of the container's
+  // cgroup under the hierarchy of the subsystem, creating it on
+  // first use.
+  cgroups::Reader* reader(
+      Info* info,
+      const std::string& subsystem,
+      const std::string& control);
+
   const Flags flags;
 
   // Map from subsystem to hierarchy.
@@ -107,6 +147,9 @@ private:
   // will be only one element in the vector which is 'cpu,cpuacct'.
   std::vector<std::string> subsystems;
 
+  // Map from subsystem to the pool of cgroups in its hierarchy.
+  hashmap<std::string, process::Owned<CgroupsPool>> pools;
+
   // TODO(bmahler): Use Owned<Info>.
   hashmap<ContainerID, Info*> infos;
 };
@@ -0,0 +1,101 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __CGROUPS_HUGETLB_ISOLATOR_HPP__
+#define __CGROUPS_HUGETLB_ISOLATOR_HPP__
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <stout/bytes.hpp>
+#include <stout/hashmap.hpp>
+
+#include "slave/containerizer/mesos/isolator.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Uses the Linux hugetlb subsystem to limit the hugepages that a
+// container can allocate to its 'hugepages_<size>' resources, e.g.,
+// 'hugepages_2MB', which count pages of the given size. A container
+// without hugepages resources can not allocate hugepages. Note that
+// an allocation over the limit fails (e.g., mmap with MAP_HUGETLB),
+// or faults, rather than getting the container killed, hence no
+// limitation is reported. See:
+// https://www.kernel.org/doc/Documentation/cgroups/hugetlb.txt
+class CgroupsHugetlbIsolatorProcess : public MesosIsolatorProcess
+{
+public:
+  static Try<mesos::slave::Isolator*> create(const Flags& flags);
+
+  virtual ~CgroupsHugetlbIsolatorProcess();
+
+  virtual process::Future<Nothing> recover(
+      const std::list<mesos::slave::ContainerState>& states,
+      const hashset<ContainerID>& orphans);
+
+  virtual process::Future<Option<mesos::slave::ContainerLaunchInfo>> prepare(
+      const ContainerID& containerId,
+      const mesos::slave::ContainerConfig& containerConfig);
+
+  virtual process::Future<Nothing> isolate(
+      const ContainerID& containerId,
+      pid_t pid);
+
+  virtual process::Future<mesos::slave::ContainerLimitation> watch(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> update(
+      const ContainerID& containerId,
+      const Resources& resources);
+
+  virtual process::Future<ResourceStatistics> usage(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> cleanup(
+      const ContainerID& containerId);
+
+private:
+  CgroupsHugetlbIsolatorProcess(
+      const Flags& flags,
+      const std::string& hierarchy,
+      const std::vector<Bytes>& sizes);
+
+  struct Info
+  {
+    Info(const std::string& _cgroup)
+      : cgroup(_cgroup) {}
+
+    const std::string cgroup;
+  };
+
+  const Flags flags;
+
+  const std::string hierarchy;
+
+  // The hugepage sizes of the host.
+  const std::vector<Bytes> sizes;
+
+  hashmap<ContainerID, Info> infos;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __CGROUPS_HUGETLB_ISOLATOR_HPP__
@@ -24,8 +24,11 @@
 
 #include <process/collect.hpp>
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/pid.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <stout/bytes.hpp>
 #include <stout/check.hpp>
 #include <stout/error.hpp>
@@ -69,18 +72,78 @@ static const vector<Level> levels()
 }
 
 
+// The slave wide memory pressure levels which trigger reclaim.
+static const vector<Level> reclaimLevels()
+{
+  return {Level::MEDIUM, Level::CRITICAL};
+}
+
+
 CgroupsMemIsolatorProcess::CgroupsMemIsolatorProcess(
     const Flags& _flags,
     const string& _hierarchy,
     const bool _limitSwap)
   : flags(_flags),
     hierarchy(_hierarchy),
-    limitSwap(_limitSwap) {}
+    limitSwap(_limitSwap),
+    pool(_hierarchy, _flags.cgroups_root, _flags.cgroups_pool_size),
+    calm(0) {}
 
 
 CgroupsMemIsolatorProcess::~CgroupsMemIsolatorProcess() {}
 
 
+CgroupsMemIsolatorProcess::Metrics::Metrics()
+  : medium_pressure_rate(
+        "cgroups_mem/medium_pressure_rate",
+        MEMORY_PRESSURE_WINDOW),
+    critical_pressure_rate(
+        "cgroups_mem/critical_pressure_rate",
+        MEMORY_PRESSURE_WINDOW),
+    reclaimed_bytes("cgroups_mem/reclaimed_bytes")
+{
+  process::metrics::add(medium_pressure_rate);
+  process::metrics::add(critical_pressure_rate);
+  process::metrics::add(reclaimed_bytes);
+}
+
+
+CgroupsMemIsolatorProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(medium_pressure_rate);
+  process::metrics::remove(critical_pressure_rate);
+  process::metrics::remove(reclaimed_bytes);
+}
+
+
+void CgroupsMemIsolatorProcess::initialize()
+{
+  if (!flags.cgroups_enable_memory_reclaim) {
+    return;
+  }
+
+  // The pressure of the root cgroup covers all the containers.
+  foreach (Level level, reclaimLevels()) {
+    Try<Owned<Counter>> counter = Counter::create(
+        hierarchy,
+        flags.cgroups_root,
+        level);
+
+    if (counter.isError()) {
+      LOG(ERROR) << "Failed to listen on " << level << " memory pressure "
+                 << "events for the slave, memory reclaim is disabled: "
+                 << counter.error();
+      return;
+    }
+
+    pressureCounters[level] = counter.get();
+    pressureValues[level] = 0;
+  }
+
+  reclaim();
+}
+
+
 Try<Isolator*> CgroupsMemIsolatorProcess::create(const Flags& flags)
 {
   Try<string> hierarchy = cgroups::prepare(
@@ -183,7 +246,10 @@ Future<Nothing> CgroupsMemIsolatorProcess::recover(
       continue;
     }
 
-    infos[containerId] = new Info(containerId, cgroup);
+    Info* info = new Info(containerId, cgroup);
+    info->resources = state.executor_info().resources();
+
+    infos[containerId] = info;
 
     oomListen(containerId);
     pressureListen(containerId);
@@ -207,6 +273,11 @@ Future<Nothing> CgroupsMemIsolatorProcess::recover(
       continue;
     }
 
+    // The cgroups of the pool are recovered by the pool below.
+    if (CgroupsPool::pooled(cgroup)) {
+      continue;
+    }
+
     ContainerID containerId;
     containerId.set_value(Path(cgroup).basename());
 
@@ -227,6 +298,15 @@ Future<Nothing> CgroupsMemIsolatorProcess::recover(
     cgroups::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT);
   }
 
+  Try<Nothing> recover = pool.recover();
+  if (recover.isError()) {
+    foreachvalue (Info* info, infos) {
+      delete info;
+    }
+    infos.clear();
+    return Failure("Failed to recover the cgroups pool: " + recover.error());
+  }
+
   return Nothing();
 }
 
@@ -257,7 +337,7 @@ Future<Option<ContainerLaunchInfo>> CgroupsMemIsolatorProcess::prepare(
     return Failure("Failed to prepare isolator: cgroup already exists");
   }
 
-  Try<Nothing> create = cgroups::create(hierarchy, info->cgroup);
+  Try<Nothing> create = pool.create(info->cgroup);
   if (create.isError()) {
     return Failure("Failed to prepare isolator: " + create.error());
   }
@@ -336,6 +416,8 @@ Future<Nothing> CgroupsMemIsolatorProcess::update(
   }
 
   Info* info = CHECK_NOTNULL(infos[containerId]);
+  info->resources = resources;
+  info->reclaimed = false;
 
   // New limit.
   Bytes mem = resources.mem().get();
@@ -420,33 +502,43 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
   // The rss from memory.stat is wrong in two dimensions:
   //   1. It does not include child cgroups.
   //   2. It does not include any file backed pages.
-  Try<Bytes> usage = cgroups::memory::usage_in_bytes(hierarchy, info->cgroup);
+  Try<uint64_t> usage = reader(info, "memory.usage_in_bytes")->value();
   if (usage.isError()) {
     return Failure("Failed to parse memory.usage_in_bytes: " + usage.error());
   }
 
-  result.set_mem_total_bytes(usage.get().bytes());
+  result.set_mem_total_bytes(usage.get());
 
   if (limitSwap) {
-    Try<Bytes> usage =
-      cgroups::memory::memsw_usage_in_bytes(hierarchy, info->cgroup);
+    Try<uint64_t> usage =
+      reader(info, "memory.memsw.usage_in_bytes")->value();
     if (usage.isError()) {
       return Failure(
         "Failed to parse memory.memsw.usage_in_bytes: " + usage.error());
     }
 
-    result.set_mem_total_memsw_bytes(usage.get().bytes());
+    result.set_mem_total_memsw_bytes(usage.get());
   }
 
   // TODO(bmahler): Add namespacing to cgroups to enforce the expected
   // structure, e.g, cgroups::memory::stat.
-  Try<hashmap<string, uint64_t>> stat =
-    cgroups::stat(hierarchy, info->cgroup, "memory.stat");
+  Option<uint64_t> total_cache;
+  Option<uint64_t> total_rss;
+  Option<uint64_t> total_mapped_file;
+  Option<uint64_t> total_swap;
+  Option<uint64_t> total_unevictable;
+
+  Try<Nothing> stat = reader(info, "memory.stat")->stat({
+      {"total_cache", &total_cache},
+      {"total_rss", &total_rss},
+      {"total_mapped_file", &total_mapped_file},
+      {"total_swap", &total_swap},
+      {"total_unevictable", &total_unevictable}});
+
   if (stat.isError()) {
     return Failure("Failed to read memory.stat: " + stat.error());
   }
 
-  Option<uint64_t> total_cache = stat.get().get("total_cache");
   if (total_cache.isSome()) {
     // TODO(chzhcn): mem_file_bytes is deprecated in 0.23.0 and will
     // be removed in 0.24.0.
@@ -455,7 +547,6 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
     result.set_mem_cache_bytes(total_cache.get());
   }
 
-  Option<uint64_t> total_rss = stat.get().get("total_rss");
   if (total_rss.isSome()) {
     // TODO(chzhcn): mem_anon_bytes is deprecated in 0.23.0 and will
     // be removed in 0.24.0.
@@ -464,17 +555,14 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
     result.set_mem_rss_bytes(total_rss.get());
   }
 
-  Option<uint64_t> total_mapped_file = stat.get().get("total_mapped_file");
   if (total_mapped_file.isSome()) {
     result.set_mem_mapped_file_bytes(total_mapped_file.get());
   }
 
-  Option<uint64_t> total_swap = stat.get().get("total_swap");
   if (total_swap.isSome()) {
     result.set_mem_swap_bytes(total_swap.get());
   }
 
-  Option<uint64_t> total_unevictable = stat.get().get("total_unevictable");
   if (total_unevictable.isSome()) {
     result.set_mem_unevictable_bytes(total_unevictable.get());
   }
@@ -499,6 +587,20 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
 }
 
 
+cgroups::Reader* CgroupsMemIsolatorProcess::reader(
+    Info* info,
+    const string& control)
+{
+  if (!info->readers.contains(control)) {
+    info->readers[control] =
+      Owned<cgroups::Reader>(
+          new cgroups::Reader(hierarchy, info->cgroup, control));
+  }
+
+  return info->readers[control].get();
+}
+
+
 Future<ResourceStatistics> CgroupsMemIsolatorProcess::_usage(
     const ContainerID& containerId,
     ResourceStatistics result,
@@ -552,7 +654,7 @@ Future<Nothing> CgroupsMemIsolatorProcess::cleanup(
     info->oomNotifier.discard();
   }
 
-  return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
+  return pool.destroy(info->cgroup, cgroups::DESTROY_TIMEOUT)
     .onAny(defer(PID<CgroupsMemIsolatorProcess>(this),
                  &CgroupsMemIsolatorProcess::_cleanup,
                  containerId,
@@ -725,6 +827,184 @@ void CgroupsMemIsolatorProcess::pressureListen(
   }
 }
 
+
+
+void CgroupsMemIsolatorProcess::reclaim()
+{
+  list<Future<uint64_t>> values;
+  foreach (Level level, reclaimLevels()) {
+    values.push_back(pressureCounters[level]->value());
+  }
+
+  collect(values)
+    .onAny(defer(PID<CgroupsMemIsolatorProcess>(this),
+                 &CgroupsMemIsolatorProcess::_reclaim,
+                 lambda::_1));
+}
+
+
+void CgroupsMemIsolatorProcess::_reclaim(const Future<list<uint64_t>>& values)
+{
+  // Schedule the next check.
+  delay(MEMORY_RECLAIM_INTERVAL,
+        PID<CgroupsMemIsolatorProcess>(this),
+        &CgroupsMemIsolatorProcess::reclaim);
+
+  if (!values.isReady()) {
+    LOG(ERROR) << "Failed to read the memory pressure counters of the slave: "
+               << (values.isFailed() ? values.failure() : "discarded");
+    return;
+  }
+
+  CHECK_EQ(2u, values.get().size());
+
+  const uint64_t medium = values.get().front() - pressureValues[Level::MEDIUM];
+  const uint64_t critical =
+    values.get().back() - pressureValues[Level::CRITICAL];
+
+  pressureValues[Level::MEDIUM] = values.get().front();
+  pressureValues[Level::CRITICAL] = values.get().back();
+
+  const double perMinute = Minutes(1).secs() / MEMORY_RECLAIM_INTERVAL.secs();
+
+  metrics.medium_pressure_rate = (int64_t) (medium * perMinute);
+  metrics.critical_pressure_rate = (int64_t) (critical * perMinute);
+
+  if (medium == 0 && critical == 0) {
+    if (++calm < MEMORY_RECLAIM_RELEASE_INTERVALS) {
+      return;
+    }
+
+    // Restore the soft limits once the pressure is gone.
+    foreachvalue (Info* info, infos) {
+      if (!info->reclaimed || info->resources.isNone()) {
+        continue;
+      }
+
+      Option<Bytes> mem = info->resources.get().mem();
+      if (mem.isNone()) {
+        continue;
+      }
+
+      Bytes limit = std::max(mem.get(), MIN_MEMORY);
+
+      Try<Nothing> write =
+        cgroups::memory::soft_limit_in_bytes(hierarchy, info->cgroup, limit);
+
+      if (write.isError()) {
+        LOG(WARNING) << "Failed to restore 'memory.soft_limit_in_bytes' of "
+                     << "container " << info->containerId << ": "
+                     << write.error();
+        continue;
+      }
+
+      LOG(INFO) << "Restored 'memory.soft_limit_in_bytes' to " << limit
+                << " for container " << info->containerId;
+
+      info->reclaimed = false;
+    }
+
+    return;
+  }
+
+  calm = 0;
+
+  const Level level = critical > 0 ? Level::CRITICAL : Level::MEDIUM;
+
+  foreachvalue (Info* info, infos) {
+    // Only the containers with revocable resources are reclaimed so
+    // that the regular containers keep their page cache.
+    if (info->pid.isSome() &&
+        info->resources.isSome() &&
+        !info->resources.get().revocable().empty()) {
+      reclaim(info, level);
+    }
+  }
+}
+
+
+void CgroupsMemIsolatorProcess::reclaim(Info* info, Level level)
+{
+  Try<Bytes> usage = cgroups::memory::usage_in_bytes(hierarchy, info->cgroup);
+  if (usage.isError()) {
+    LOG(WARNING) << "Failed to read 'memory.usage_in_bytes' of container "
+                 << info->containerId << ": " << usage.error();
+    return;
+  }
+
+  // On medium pressure, the kernel reclaims the containers above their
+  // soft limits first; on critical pressure, their soft limits are
+  // dropped altogether.
+  Bytes softLimit = MIN_MEMORY;
+  if (level == Level::MEDIUM) {
+    softLimit = std::max(usage.get() / 2, MIN_MEMORY);
+  }
+
+  Try<Nothing> write =
+    cgroups::memory::soft_limit_in_bytes(hierarchy, info->cgroup, softLimit);
+
+  if (write.isError()) {
+    LOG(WARNING) << "Failed to lower 'memory.soft_limit_in_bytes' of "
+                 << "container " << info->containerId << ": "
+                 << write.error();
+    return;
+  }
+
+  if (!info->reclaimed) {
+    LOG(INFO) << "Lowered 'memory.soft_limit_in_bytes' to " << softLimit
+              << " for container " << info->containerId << " on "
+              << level << " memory pressure";
+  }
+
+  info->reclaimed = true;
+
+  if (level != Level::CRITICAL) {
+    return;
+  }
+
+  // Lowering the hard limit below the usage makes the kernel reclaim
+  // from the container, mostly its page cache. The write fails rather
+  // than invoking the OOM killer if not enough can be reclaimed, and
+  // the hard limit is restored right after.
+  Try<Bytes> limit = cgroups::memory::limit_in_bytes(hierarchy, info->cgroup);
+  if (limit.isError()) {
+    LOG(WARNING) << "Failed to read 'memory.limit_in_bytes' of container "
+                 << info->containerId << ": " << limit.error();
+    return;
+  }
+
+  Bytes target =
+    std::max(usage.get() * (1 - MEMORY_RECLAIM_FRACTION), MIN_MEMORY);
+
+  if (target >= limit.get()) {
+    return;
+  }
+
+  write = cgroups::memory::limit_in_bytes(hierarchy, info->cgroup, target);
+  if (write.isError()) {
+    VLOG(1) << "Failed to reclaim memory from container "
+            << info->containerId << ": " << write.error();
+  }
+
+  write = cgroups::memory::limit_in_bytes(hierarchy, info->cgroup, limit.get());
+  if (write.isError()) {
+    LOG(ERROR) << "Failed to restore 'memory.limit_in_bytes' to "
+               << limit.get() << " for container " << info->containerId
+               << ": " << write.error();
+    return;
+  }
+
+  Try<Bytes> reclaimed =
+    cgroups::memory::usage_in_bytes(hierarchy, info->cgroup);
+
+  if (reclaimed.isSome() && reclaimed.get() < usage.get()) {
+    metrics.reclaimed_bytes += (usage.get() - reclaimed.get()).bytes();
+
+    VLOG(1) << "Reclaimed " << usage.get() - reclaimed.get()
+            << " from container " << info->containerId;
+  }
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
@@ -19,9 +19,14 @@
 
 #include <sys/types.h>
 
+#include <list>
+
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/push_gauge.hpp>
+
 #include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
@@ -32,6 +37,8 @@
 
 #include "slave/containerizer/mesos/isolator.hpp"
 
+#include "slave/containerizer/mesos/isolators/cgroups/pool.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -68,6 +75,9 @@ public:
   virtual process::Future<Nothing> cleanup(
       const ContainerID& containerId);
 
+protected:
+  virtual void initialize();
+
 private:
   CgroupsMemIsolatorProcess(
       const Flags& flags,
@@ -87,11 +97,15 @@ private:
   struct Info
   {
     Info(const ContainerID& _containerId, const std::string& _cgroup)
-      : containerId(_containerId), cgroup(_cgroup) {}
+      : containerId(_containerId), cgroup(_cgroup), reclaimed(false) {}
 
     const ContainerID containerId;
     const std::string cgroup;
     Option<pid_t> pid;
+    Option<Resources> resources;
+
+    // Whether the soft limit has been lowered to reclaim memory.
+    bool reclaimed;
 
     process::Promise<mesos::slave::ContainerLimitation> limitation;
 
@@ -101,8 +115,16 @@ private:
     hashmap<cgroups::memory::pressure::Level,
             process::Owned<cgroups::memory::pressure::Counter>>
       pressureCounters;
+
+    // Readers of the statistics controls of the cgroup, kept open
+    // across calls to 'usage'.
+    hashmap<std::string, process::Owned<cgroups::Reader>> readers;
   };
 
+  // Returns the reader of the given control of the container's
+  // cgroup, creating it on first use.
+  cgroups::Reader* reader(Info* info, const std::string& control);
+
   // Start listening on OOM events. This function will create an
   // eventfd and start polling on it.
   void oomListen(const ContainerID& containerId);
@@ -119,6 +141,29 @@ private:
   // Start listening on memory pressure events.
   void pressureListen(const ContainerID& containerId);
 
+  // Reads the slave wide memory pressure counters and reclaims memory
+  // from the revocable containers, or restores their soft limits once
+  // the pressure is gone.
+  void reclaim();
+
+  void _reclaim(const process::Future<std::list<uint64_t>>& values);
+
+  // Lowers the soft limit of a revocable container and, on critical
+  // pressure, shrinks it by temporarily lowering its hard limit.
+  void reclaim(Info* info, cgroups::memory::pressure::Level level);
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    // Slave wide memory pressure events per minute.
+    process::metrics::PushGauge medium_pressure_rate;
+    process::metrics::PushGauge critical_pressure_rate;
+
+    process::metrics::Counter reclaimed_bytes;
+  } metrics;
+
   const Flags flags;
 
   // The path to the cgroups subsystem hierarchy root.
@@ -126,6 +171,20 @@ private:
 
   const bool limitSwap;
 
+  // The pool of cgroups in the hierarchy.
+  CgroupsPool pool;
+
+  // Counters of the slave wide memory pressure, i.e., of the root
+  // cgroup, and their values at the last check.
+  hashmap<cgroups::memory::pressure::Level,
+          process::Owned<cgroups::memory::pressure::Counter>>
+    pressureCounters;
+
+  hashmap<cgroups::memory::pressure::Level, uint64_t> pressureValues;
+
+  // Number of consecutive checks without memory pressure.
+  size_t calm;
+
   // TODO(bmahler): Use Owned<Info>.
   hashmap<ContainerID, Info*> infos;
 };
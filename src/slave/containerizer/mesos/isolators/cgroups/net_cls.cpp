@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iomanip>
 #include <list>
 #include <vector>
 
@@ -21,8 +22,13 @@
 #include <process/future.hpp>
 #include <process/pid.hpp>
 
+#include <process/metrics/metrics.hpp>
+
+#include <stout/numify.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "linux/cgroups.hpp"
@@ -36,6 +42,7 @@ using std::set;
 using std::string;
 using std::vector;
 
+using process::defer;
 using process::Failure;
 using process::Future;
 using process::Owned;
@@ -51,16 +58,201 @@ namespace mesos {
 namespace internal {
 namespace slave {
 
+std::ostream& operator<<(std::ostream& stream, const NetClsHandle& handle)
+{
+  std::ios_base::fmtflags format = stream.flags();
+
+  stream << std::hex << std::setfill('0')
+         << std::setw(4) << handle.primary << ":"
+         << std::setw(4) << handle.secondary;
+
+  stream.flags(format);
+
+  return stream;
+}
+
+
+NetClsHandleManager::NetClsHandleManager(
+    uint16_t _primary,
+    uint16_t _lower,
+    uint16_t _upper)
+  : primary(_primary),
+    lower(_lower),
+    upper(_upper),
+    count(0)
+{
+  CHECK_LE(lower, upper);
+
+  const size_t size = total();
+
+  bitmap.resize((size + 63) / 64, 0);
+  full.resize((bitmap.size() + 63) / 64, 0);
+
+  // Mark the bits past the end of the range as used, so they are
+  // never allocated.
+  if (size % 64 != 0) {
+    bitmap.back() = ~UINT64_C(0) << (size % 64);
+  }
+
+  if (bitmap.size() % 64 != 0) {
+    full.back() = ~UINT64_C(0) << (bitmap.size() % 64);
+  }
+}
+
+
+Try<NetClsHandle> NetClsHandleManager::alloc()
+{
+  for (size_t i = 0; i < full.size(); i++) {
+    if (~full[i] != 0) {
+      const size_t word = i * 64 + __builtin_ctzll(~full[i]);
+      const size_t bit = __builtin_ctzll(~bitmap[word]);
+
+      set(word * 64 + bit);
+
+      return NetClsHandle(primary, lower + word * 64 + bit);
+    }
+  }
+
+  return Error(
+      "All of the " + stringify(total()) + " net_cls handles are in use");
+}
+
+
+Try<Nothing> NetClsHandleManager::reserve(const NetClsHandle& handle)
+{
+  Try<size_t> _index = index(handle);
+  if (_index.isError()) {
+    return Error(_index.error());
+  }
+
+  if (isUsed(handle)) {
+    return Error("The net_cls handle " + stringify(handle) + " is in use");
+  }
+
+  set(_index.get());
+
+  return Nothing();
+}
+
+
+Try<Nothing> NetClsHandleManager::free(const NetClsHandle& handle)
+{
+  Try<size_t> _index = index(handle);
+  if (_index.isError()) {
+    return Error(_index.error());
+  }
+
+  if (!isUsed(handle)) {
+    return Error("The net_cls handle " + stringify(handle) + " is not in use");
+  }
+
+  clear(_index.get());
+
+  return Nothing();
+}
+
+
+bool NetClsHandleManager::isUsed(const NetClsHandle& handle) const
+{
+  Try<size_t> _index = index(handle);
+  if (_index.isError()) {
+    return false;
+  }
+
+  return (bitmap[_index.get() / 64] >> (_index.get() % 64)) & 1;
+}
+
+
+Try<size_t> NetClsHandleManager::index(const NetClsHandle& handle) const
+{
+  if (handle.primary != primary ||
+      handle.secondary < lower ||
+      handle.secondary > upper) {
+    return Error(
+        "The net_cls handle " + stringify(handle) + " is not in the range "
+        "of " + stringify(NetClsHandle(primary, lower)) + " to " +
+        stringify(NetClsHandle(primary, upper)));
+  }
+
+  return handle.secondary - lower;
+}
+
+
+void NetClsHandleManager::set(size_t index)
+{
+  const size_t word = index / 64;
+
+  bitmap[word] |= UINT64_C(1) << (index % 64);
+
+  if (~bitmap[word] == 0) {
+    full[word / 64] |= UINT64_C(1) << (word % 64);
+  }
+
+  count++;
+}
+
+
+void NetClsHandleManager::clear(size_t index)
+{
+  const size_t word = index / 64;
+
+  bitmap[word] &= ~(UINT64_C(1) << (index % 64));
+  full[word / 64] &= ~(UINT64_C(1) << (word % 64));
+
+  count--;
+}
+
+
 CgroupsNetClsIsolatorProcess::CgroupsNetClsIsolatorProcess(
     const Flags& _flags,
-    const string& _hierarchy)
+    const string& _hierarchy,
+    const Option<NetClsHandleManager>& _handleManager)
   : flags(_flags),
-    hierarchy(_hierarchy) {}
+    hierarchy(_hierarchy),
+    handleManager(_handleManager),
+    metrics(*this) {}
 
 
 CgroupsNetClsIsolatorProcess::~CgroupsNetClsIsolatorProcess() {}
 
 
+CgroupsNetClsIsolatorProcess::Metrics::Metrics(
+    const CgroupsNetClsIsolatorProcess& isolator)
+  : handles_total(
+        "containerizer/mesos/net_cls_handles_total",
+        defer(
+            PID<CgroupsNetClsIsolatorProcess>(isolator),
+            &CgroupsNetClsIsolatorProcess::_handles_total)),
+    handles_used(
+        "containerizer/mesos/net_cls_handles_used",
+        defer(
+            PID<CgroupsNetClsIsolatorProcess>(isolator),
+            &CgroupsNetClsIsolatorProcess::_handles_used))
+{
+  process::metrics::add(handles_total);
+  process::metrics::add(handles_used);
+}
+
+
+CgroupsNetClsIsolatorProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(handles_total);
+  process::metrics::remove(handles_used);
+}
+
+
+double CgroupsNetClsIsolatorProcess::_handles_total()
+{
+  return handleManager.isSome() ? handleManager.get().total() : 0;
+}
+
+
+double CgroupsNetClsIsolatorProcess::_handles_used()
+{
+  return handleManager.isSome() ? handleManager.get().used() : 0;
+}
+
+
 Try<Isolator*> CgroupsNetClsIsolatorProcess::create(const Flags& flags)
 {
   Try<string> hierarchy = cgroups::prepare(
@@ -84,8 +276,42 @@ Try<Isolator*> CgroupsNetClsIsolatorProcess::create(const Flags& flags)
         hierarchy.get());
   }
 
+  Option<NetClsHandleManager> handleManager;
+
+  if (flags.cgroups_net_cls_primary_handle.isSome()) {
+    Try<uint16_t> primary =
+      numify<uint16_t>(flags.cgroups_net_cls_primary_handle.get());
+
+    if (primary.isError() || primary.get() == 0) {
+      return Error(
+          "Invalid '--cgroups_net_cls_primary_handle': expecting a non-zero, "
+          "16-bit handle of the form '0xAAAA'");
+    }
+
+    const vector<string> range =
+      strings::tokenize(flags.cgroups_net_cls_secondary_handles, ",");
+
+    Try<uint16_t> lower = Error("Missing the lower bound");
+    Try<uint16_t> upper = Error("Missing the upper bound");
+
+    if (range.size() == 2) {
+      lower = numify<uint16_t>(strings::trim(range[0]));
+      upper = numify<uint16_t>(strings::trim(range[1]));
+    }
+
+    if (lower.isError() || upper.isError() ||
+        lower.get() == 0 || lower.get() > upper.get()) {
+      return Error(
+          "Invalid '--cgroups_net_cls_secondary_handles': expecting a range "
+          "of non-zero, 16-bit handles of the form '0xAAAA,0xBBBB'");
+    }
+
+    handleManager =
+      NetClsHandleManager(primary.get(), lower.get(), upper.get());
+  }
+
   process::Owned<MesosIsolatorProcess> process(
-      new CgroupsNetClsIsolatorProcess(flags, hierarchy.get()));
+      new CgroupsNetClsIsolatorProcess(flags, hierarchy.get(), handleManager));
 
   return new MesosIsolator(process);
 }
@@ -115,7 +341,17 @@ Future<Nothing> CgroupsNetClsIsolatorProcess::recover(
       continue;
     }
 
-    infos.emplace(containerId, Info(cgroup));
+    Info info(cgroup);
+
+    Try<Nothing> recovered = recoverHandle(&info);
+    if (recovered.isError()) {
+      infos.clear();
+      return Failure(
+          "Failed to recover the net_cls handle of container '" +
+          stringify(containerId) + "': " + recovered.error());
+    }
+
+    infos.emplace(containerId, info);
   }
 
   // Remove orphan cgroups.
@@ -143,7 +379,17 @@ Future<Nothing> CgroupsNetClsIsolatorProcess::recover(
     // Known orphan cgroups will be destroyed by the containerizer
     // using the normal cleanup path. See MESOS-2367 for details.
     if (orphans.contains(containerId)) {
-      infos.emplace(containerId, Info(cgroup));
+      Info info(cgroup);
+
+      // The handle of an orphan is reserved until it is cleaned up.
+      Try<Nothing> recovered = recoverHandle(&info);
+      if (recovered.isError()) {
+        LOG(WARNING) << "Failed to recover the net_cls handle of orphan "
+                     << "container '" << containerId << "': "
+                     << recovered.error();
+      }
+
+      infos.emplace(containerId, info);
       continue;
     }
 
@@ -157,6 +403,47 @@ Future<Nothing> CgroupsNetClsIsolatorProcess::recover(
 }
 
 
+Try<Nothing> CgroupsNetClsIsolatorProcess::recoverHandle(Info* info)
+{
+  if (handleManager.isNone()) {
+    return Nothing();
+  }
+
+  // NOTE: The handles are not checkpointed separately, the classid of
+  // the cgroup is the record of the handle (read once per recovered
+  // container, rather than for every cgroup of the hierarchy).
+  Try<string> read = cgroups::read(hierarchy, info->cgroup, "net_cls.classid");
+  if (read.isError()) {
+    return Error("Failed to read 'net_cls.classid': " + read.error());
+  }
+
+  Try<uint32_t> classid = numify<uint32_t>(strings::trim(read.get()));
+  if (classid.isError()) {
+    return Error("Failed to parse 'net_cls.classid': " + classid.error());
+  }
+
+  // A container which was launched before the handles were enabled
+  // (or with a different primary handle) keeps its classid.
+  if (classid.get() == 0) {
+    return Nothing();
+  }
+
+  const NetClsHandle handle(classid.get());
+
+  Try<Nothing> reserve = handleManager.get().reserve(handle);
+  if (reserve.isError()) {
+    LOG(WARNING) << "Not reserving the net_cls handle " << handle
+                 << " of cgroup '" << info->cgroup << "': "
+                 << reserve.error();
+    return Nothing();
+  }
+
+  info->handle = handle;
+
+  return Nothing();
+}
+
+
 // TODO(asridharan): Currently we haven't decided on the entity who will
 // allocate the net_cls handles, or the interfaces through which the net_cls
 // handles will be exposed to network isolators and frameworks. Once the
@@ -224,6 +511,32 @@ Future<Option<ContainerLaunchInfo>> CgroupsNetClsIsolatorProcess::prepare(
     }
   }
 
+  if (handleManager.isSome()) {
+    Try<NetClsHandle> handle = handleManager.get().alloc();
+    if (handle.isError()) {
+      cgroups::destroy(hierarchy, info.cgroup, cgroups::DESTROY_TIMEOUT);
+      return Failure("Failed to allocate a net_cls handle: " + handle.error());
+    }
+
+    Try<Nothing> write = cgroups::write(
+        hierarchy,
+        info.cgroup,
+        "net_cls.classid",
+        stringify(handle.get().get()));
+
+    if (write.isError()) {
+      handleManager.get().free(handle.get());
+      cgroups::destroy(hierarchy, info.cgroup, cgroups::DESTROY_TIMEOUT);
+      return Failure("Failed to assign the net_cls handle " +
+                     stringify(handle.get()) + ": " + write.error());
+    }
+
+    info.handle = handle.get();
+
+    VLOG(1) << "Allocated the net_cls handle " << handle.get()
+            << " to container " << containerId;
+  }
+
   infos.emplace(containerId, info);
 
   return update(containerId, containerConfig.executorinfo().resources())
@@ -283,6 +596,20 @@ Future<Nothing> CgroupsNetClsIsolatorProcess::cleanup(
 
   return cgroups::destroy(hierarchy, info.cgroup, cgroups::DESTROY_TIMEOUT)
     .then(defer(PID<CgroupsNetClsIsolatorProcess>(this), [=]() {
+      // The handle can only be reused once no process of the
+      // container is left in the cgroup.
+      const Info& info = infos.at(containerId);
+
+      if (info.handle.isSome()) {
+        CHECK_SOME(handleManager);
+
+        Try<Nothing> free = handleManager.get().free(info.handle.get());
+        if (free.isError()) {
+          LOG(WARNING) << "Failed to free the net_cls handle of container "
+                       << containerId << ": " << free.error();
+        }
+      }
+
       infos.erase(containerId);
       return Nothing();
     }));
@@ -17,9 +17,18 @@
 #ifndef __CGROUPS_NET_CLS_ISOLATOR_HPP__
 #define __CGROUPS_NET_CLS_ISOLATOR_HPP__
 
+#include <stdint.h>
+
+#include <ostream>
 #include <string>
+#include <vector>
+
+#include <process/metrics/gauge.hpp>
 
 #include <stout/hashmap.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
 
 #include "slave/containerizer/mesos/isolator.hpp"
 
@@ -27,6 +36,76 @@ namespace mesos {
 namespace internal {
 namespace slave {
 
+// A net_cls handle (i.e., the value of 'net_cls.classid') consists of
+// a 16-bit primary handle and a 16-bit secondary handle, which are the
+// major and the minor numbers of a traffic class (see tc(8)).
+struct NetClsHandle
+{
+  NetClsHandle(uint16_t _primary, uint16_t _secondary)
+    : primary(_primary), secondary(_secondary) {}
+
+  explicit NetClsHandle(uint32_t classid)
+    : primary(classid >> 16), secondary(classid & 0xffff) {}
+
+  // Returns the value of 'net_cls.classid' for this handle.
+  uint32_t get() const
+  {
+    return (static_cast<uint32_t>(primary) << 16) | secondary;
+  }
+
+  uint16_t primary;
+  uint16_t secondary;
+};
+
+
+std::ostream& operator<<(std::ostream& stream, const NetClsHandle& handle);
+
+
+// Allocates the secondary handles of a primary handle from a range.
+// The handles in use are kept in a bitmap, where a free handle is
+// found with 'find first zero' (i.e., counting the trailing zeros of
+// the inverted word). A second bitmap tracks which words of the first
+// one are full, so free handles are found without scanning the whole
+// range. Allocating and freeing a handle therefore take (almost)
+// constant time, even for the full range of 65535 handles.
+class NetClsHandleManager
+{
+public:
+  NetClsHandleManager(uint16_t primary, uint16_t lower, uint16_t upper);
+
+  // Allocates the lowest free handle.
+  Try<NetClsHandle> alloc();
+
+  // Marks a handle, e.g., of a recovered container, as used.
+  Try<Nothing> reserve(const NetClsHandle& handle);
+
+  Try<Nothing> free(const NetClsHandle& handle);
+
+  bool isUsed(const NetClsHandle& handle) const;
+
+  size_t total() const { return upper - lower + 1; }
+  size_t used() const { return count; }
+
+private:
+  Try<size_t> index(const NetClsHandle& handle) const;
+
+  void set(size_t index);
+  void clear(size_t index);
+
+  const uint16_t primary;
+  const uint16_t lower;
+  const uint16_t upper;
+
+  // Bit 'i' of 'bitmap' is set if handle 'lower + i' is used, bit 'i'
+  // of 'full' if word 'i' of 'bitmap' has no free handle left. The
+  // bits past the end of the range are always set.
+  std::vector<uint64_t> bitmap;
+  std::vector<uint64_t> full;
+
+  size_t count;
+};
+
+
 // Uses the Linux net_cls subsystem for allocating network handles to
 // containers. The network handles of a net_cls cgroup will be used for tagging
 // packets originating from containers belonging to that cgroup. The tags on the
@@ -69,7 +148,8 @@ public:
 private:
   CgroupsNetClsIsolatorProcess(
       const Flags& flags,
-      const std::string& hierarchy);
+      const std::string& hierarchy,
+      const Option<NetClsHandleManager>& handleManager);
 
   struct Info
   {
@@ -77,13 +157,37 @@ private:
       : cgroup(_cgroup) {}
 
     const std::string cgroup;
+
+    // The net_cls handle of the container, if handles are allocated
+    // (see '--cgroups_net_cls_primary_handle').
+    Option<NetClsHandle> handle;
+  };
+
+  struct Metrics
+  {
+    explicit Metrics(const CgroupsNetClsIsolatorProcess& isolator);
+    ~Metrics();
+
+    process::metrics::Gauge handles_total;
+    process::metrics::Gauge handles_used;
   };
 
+  // Reserves the handle of a recovered container, which is read from
+  // its cgroup.
+  Try<Nothing> recoverHandle(Info* info);
+
+  double _handles_total();
+  double _handles_used();
+
   const Flags flags;
 
   const std::string hierarchy;
 
+  Option<NetClsHandleManager> handleManager;
+
   hashmap<ContainerID, Info> infos;
+
+  Metrics metrics;
 };
 } // namespace slave {
 } // namespace internal {
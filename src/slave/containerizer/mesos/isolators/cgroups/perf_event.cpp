@@ -59,6 +59,7 @@ using std::vector;
 using process::Clock;
 using process::Failure;
 using process::Future;
+using process::Owned;
 using process::PID;
 using process::Time;
 
@@ -70,11 +71,13 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
 {
   LOG(INFO) << "Creating PerfEvent isolator";
 
-  if (!perf::supported()) {
+  // The 'perf' binary is only used when not counting the events
+  // directly, in which case samples last for the whole interval.
+  if (!flags.perf_counters && !perf::supported()) {
     return Error("Perf is not supported");
   }
 
-  if (flags.perf_duration > flags.perf_interval) {
+  if (!flags.perf_counters && flags.perf_duration > flags.perf_interval) {
     return Error("Sampling perf for duration (" +
                  stringify(flags.perf_duration) +
                  ") > interval (" +
@@ -92,7 +95,7 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     events.insert(event);
   }
 
-  if (!perf::valid(events)) {
+  if (!flags.perf_counters && !perf::valid(events)) {
     return Error("Failed to create PerfEvent isolator, invalid events: " +
                  stringify(events));
   }
@@ -106,9 +109,24 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     return Error("Failed to create perf_event cgroup: " + hierarchy.error());
   }
 
-  LOG(INFO) << "PerfEvent isolator will profile for " << flags.perf_duration
-            << " every " << flags.perf_interval
-            << " for events: " << stringify(events);
+  if (flags.perf_counters) {
+    // Check that the events can be counted by opening them for the
+    // root cgroup once.
+    Try<Owned<perf::Counters>> counters = perf::Counters::create(
+        events,
+        path::join(hierarchy.get(), flags.cgroups_root));
+
+    if (counters.isError()) {
+      return Error("Failed to create PerfEvent isolator: " + counters.error());
+    }
+
+    LOG(INFO) << "PerfEvent isolator will count every " << flags.perf_interval
+              << " the events: " << stringify(events);
+  } else {
+    LOG(INFO) << "PerfEvent isolator will profile for " << flags.perf_duration
+              << " every " << flags.perf_interval
+              << " for events: " << stringify(events);
+  }
 
   process::Owned<MesosIsolatorProcess> process(
       new CgroupsPerfEventIsolatorProcess(flags, hierarchy.get(), events));
@@ -123,7 +141,11 @@ CgroupsPerfEventIsolatorProcess::~CgroupsPerfEventIsolatorProcess() {}
 void CgroupsPerfEventIsolatorProcess::initialize()
 {
   // Start sampling.
-  sample();
+  if (flags.perf_counters) {
+    count();
+  } else {
+    sample();
+  }
 }
 
 
@@ -162,6 +184,10 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::recover(
     }
 
     infos[containerId] = new Info(containerId, cgroup);
+
+    // NOTE: The events that occurred while the agent was down are
+    // not counted.
+    open(containerId);
   }
 
   // Remove orphan cgroups.
@@ -275,6 +301,8 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::isolate(
                    "' : " + assign.error());
   }
 
+  open(containerId);
+
   return Nothing();
 }
 
@@ -329,6 +357,9 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::cleanup(
 
   info->destroying = true;
 
+  // Close the counters before destroying the cgroup they refer to.
+  info->counters.reset();
+
   return cgroups::destroy(hierarchy, info->cgroup)
     .then(defer(PID<CgroupsPerfEventIsolatorProcess>(this),
                 &CgroupsPerfEventIsolatorProcess::_cleanup,
@@ -427,6 +458,110 @@ void CgroupsPerfEventIsolatorProcess::_sample(
         &CgroupsPerfEventIsolatorProcess::sample);
 }
 
+void CgroupsPerfEventIsolatorProcess::open(const ContainerID& containerId)
+{
+  if (!flags.perf_counters) {
+    return;
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  Try<Owned<perf::Counters>> counters = perf::Counters::create(
+      events,
+      path::join(hierarchy, info->cgroup));
+
+  if (counters.isError()) {
+    LOG(WARNING) << "Failed to open perf counters for container "
+                 << containerId << ", perf statistics will not be available: "
+                 << counters.error();
+    return;
+  }
+
+  info->counters = counters.get();
+
+  // The first sample covers the events since now.
+  info->counts = PerfStatistics();
+  info->counts.set_timestamp(Clock::now().secs());
+  info->counts.set_duration(Seconds(0).secs());
+}
+
+
+// Returns the statistics of the events counted between the 'previous'
+// and the 'current' counts.
+static PerfStatistics subtract(
+    const PerfStatistics& current,
+    const PerfStatistics& previous)
+{
+  PerfStatistics statistics;
+  statistics.set_timestamp(previous.timestamp());
+  statistics.set_duration(current.timestamp() - previous.timestamp());
+
+  const google::protobuf::Reflection* reflection = current.GetReflection();
+
+  vector<const google::protobuf::FieldDescriptor*> fields;
+  reflection->ListFields(current, &fields);
+
+  foreach (const google::protobuf::FieldDescriptor* field, fields) {
+    if (field->name() == "timestamp" || field->name() == "duration") {
+      continue;
+    }
+
+    switch (field->type()) {
+      case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+        reflection->SetDouble(
+            &statistics,
+            field,
+            reflection->GetDouble(current, field) -
+            reflection->GetDouble(previous, field));
+        break;
+      case google::protobuf::FieldDescriptor::TYPE_UINT64: {
+        // NOTE: Scaled counts of multiplexed events are estimates,
+        // which might make the count appear to go backwards.
+        const uint64_t now = reflection->GetUInt64(current, field);
+        const uint64_t before = reflection->GetUInt64(previous, field);
+
+        reflection->SetUInt64(
+            &statistics, field, now > before ? now - before : 0);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  return statistics;
+}
+
+
+void CgroupsPerfEventIsolatorProcess::count()
+{
+  foreachvalue (Info* info, infos) {
+    CHECK_NOTNULL(info);
+
+    if (info->destroying || info->counters.get() == NULL) {
+      continue;
+    }
+
+    Try<PerfStatistics> counts = info->counters->read();
+    if (counts.isError()) {
+      LOG(ERROR) << "Failed to read perf counters for container "
+                 << info->containerId << ": " << counts.error();
+      continue;
+    }
+
+    counts->set_timestamp(Clock::now().secs());
+    counts->set_duration(Seconds(0).secs());
+
+    info->statistics = subtract(counts.get(), info->counts);
+    info->counts = counts.get();
+  }
+
+  // Schedule the next sample.
+  delay(flags.perf_interval,
+        PID<CgroupsPerfEventIsolatorProcess>(this),
+        &CgroupsPerfEventIsolatorProcess::count);
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
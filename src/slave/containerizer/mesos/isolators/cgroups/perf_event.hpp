@@ -19,11 +19,14 @@
 
 #include <set>
 
+#include <process/owned.hpp>
 #include <process/time.hpp>
 
 #include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 
+#include "linux/perf.hpp"
+
 #include "slave/flags.hpp"
 
 #include "slave/containerizer/mesos/isolator.hpp"
@@ -82,6 +85,12 @@ private:
       const process::Time& next,
       const process::Future<hashmap<std::string, PerfStatistics>>& statistics);
 
+  // Samples the counters of the containers, see `--perf_counters`.
+  void count();
+
+  // Opens the counters of a container, see `--perf_counters`.
+  void open(const ContainerID& containerId);
+
   virtual process::Future<Nothing> _cleanup(const ContainerID& containerId);
 
   struct Info
@@ -100,6 +109,11 @@ private:
     const ContainerID containerId;
     const std::string cgroup;
     PerfStatistics statistics;
+
+    // With `--perf_counters`, the counters of the container and their
+    // counts as of the last sample.
+    process::Owned<perf::Counters> counters;
+    PerfStatistics counts;
     // Mark a container when we start destruction so we stop sampling it.
     bool destroying;
   };
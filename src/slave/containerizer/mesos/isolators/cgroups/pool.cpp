@@ -0,0 +1,165 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+#include <stout/uuid.hpp>
+
+#include "linux/cgroups.hpp"
+
+#include "slave/containerizer/mesos/isolators/cgroups/pool.hpp"
+
+using process::Future;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+static const string POOLED_PREFIX = ".pool-";
+static const string DESTROYED_PREFIX = ".destroy-";
+
+
+CgroupsPool::CgroupsPool(
+    const string& _hierarchy,
+    const string& _root,
+    size_t _size)
+  : hierarchy(_hierarchy),
+    root(_root),
+    size(_size) {}
+
+
+Try<Nothing> CgroupsPool::create(const string& cgroup)
+{
+  while (!cgroups.empty()) {
+    const string pooled = cgroups.front();
+    cgroups.pop_front();
+
+    Try<Nothing> rename = os::rename(
+        path::join(hierarchy, pooled),
+        path::join(hierarchy, cgroup));
+
+    if (rename.isSome()) {
+      return Nothing();
+    }
+
+    LOG(WARNING) << "Failed to rename pre-created cgroup '"
+                 << path::join(hierarchy, pooled) << "' to '" << cgroup
+                 << "': " << rename.error();
+
+    cgroups::destroy(hierarchy, pooled, cgroups::DESTROY_TIMEOUT);
+  }
+
+  return cgroups::create(hierarchy, cgroup);
+}
+
+
+Future<Nothing> CgroupsPool::destroy(
+    const string& cgroup,
+    const Duration& timeout)
+{
+  if (size == 0) {
+    return cgroups::destroy(hierarchy, cgroup, timeout);
+  }
+
+  const string destroyed = path::join(
+      root, DESTROYED_PREFIX + UUID::random().toString());
+
+  Try<Nothing> rename = os::rename(
+      path::join(hierarchy, cgroup),
+      path::join(hierarchy, destroyed));
+
+  if (rename.isError()) {
+    return cgroups::destroy(hierarchy, cgroup, timeout);
+  }
+
+  const string path = path::join(hierarchy, destroyed);
+
+  cgroups::destroy(hierarchy, destroyed, timeout)
+    .onFailed([path](const string& failure) {
+      LOG(ERROR) << "Failed to destroy cgroup '" << path << "': "
+                 << failure;
+    });
+
+  refill();
+
+  return Nothing();
+}
+
+
+Try<Nothing> CgroupsPool::recover()
+{
+  Try<vector<string>> leftovers = cgroups::get(hierarchy, root);
+  if (leftovers.isError()) {
+    return Error(leftovers.error());
+  }
+
+  foreach (const string& cgroup, leftovers.get()) {
+    if (!pooled(cgroup)) {
+      continue;
+    }
+
+    LOG(INFO) << "Removing cgroup '" << path::join(hierarchy, cgroup)
+              << "' left over by the cgroups pool";
+
+    // We don't wait on the destroy as we don't want to block recovery.
+    cgroups::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT);
+  }
+
+  refill();
+
+  return Nothing();
+}
+
+
+bool CgroupsPool::pooled(const string& cgroup)
+{
+  const string basename = Path(cgroup).basename();
+
+  return strings::startsWith(basename, POOLED_PREFIX) ||
+         strings::startsWith(basename, DESTROYED_PREFIX);
+}
+
+
+void CgroupsPool::refill()
+{
+  while (cgroups.size() < size) {
+    const string cgroup =
+      path::join(root, POOLED_PREFIX + UUID::random().toString());
+
+    Try<Nothing> create = cgroups::create(hierarchy, cgroup);
+    if (create.isError()) {
+      LOG(WARNING) << "Failed to pre-create cgroup '"
+                   << path::join(hierarchy, cgroup) << "': "
+                   << create.error();
+      return;
+    }
+
+    cgroups.push_back(cgroup);
+  }
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __CGROUPS_ISOLATOR_POOL_HPP__
+#define __CGROUPS_ISOLATOR_POOL_HPP__
+
+#include <deque>
+#include <string>
+
+#include <process/future.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// A pool of pre-created cgroups in a hierarchy, for the cgroups
+// isolators. Creating the cgroup of a container renames one of the
+// pre-created cgroups (which are siblings of the cgroups of the
+// containers, named '.pool-<uuid>') rather than calling mkdir, and
+// destroying it renames it out of the way (to '.destroy-<uuid>') and
+// destroys it in the background, so that neither blocks the launch
+// or the cleanup of a container. The pool is refilled on 'destroy'
+// and 'recover', i.e., off the launch path.
+//
+// A pool of size 0 creates and destroys the cgroups directly.
+//
+// NOTE: The cgroups are never reused, since some of the statistics of
+// a cgroup (e.g., 'cpuacct.stat') can not be reset.
+class CgroupsPool
+{
+public:
+  CgroupsPool(
+      const std::string& hierarchy,
+      const std::string& root,
+      size_t size);
+
+  // Creates 'cgroup' (a child of the root), from a pre-created
+  // cgroup if there is one, or else with 'cgroups::create'.
+  Try<Nothing> create(const std::string& cgroup);
+
+  // Destroys 'cgroup' in the background if it can be renamed, or else
+  // with 'cgroups::destroy', and then refills the pool.
+  process::Future<Nothing> destroy(
+      const std::string& cgroup,
+      const Duration& timeout);
+
+  // Destroys the cgroups of the pool left over by a previous run of
+  // the slave (in the background), and fills the pool.
+  Try<Nothing> recover();
+
+  // Returns true if 'cgroup' is one of the cgroups of a pool
+  // (pre-created or being destroyed) rather than of a container, so
+  // that the isolators don't treat it as an orphan.
+  static bool pooled(const std::string& cgroup);
+
+private:
+  void refill();
+
+  const std::string hierarchy;
+  const std::string root;
+  const size_t size;
+
+  std::deque<std::string> cgroups;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __CGROUPS_ISOLATOR_POOL_HPP__
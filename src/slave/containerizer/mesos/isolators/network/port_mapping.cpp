@@ -18,6 +18,15 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <arpa/inet.h>
+
+#include <linux/if_ether.h>
+#include <linux/pkt_cls.h>
+
+#include <net/if.h>
+
+#include <netinet/in.h>
+
 #include <iostream>
 #include <vector>
 
@@ -25,6 +34,7 @@
 
 #include <mesos/mesos.hpp>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/io.hpp>
@@ -54,6 +64,7 @@
 
 #include "common/status_utils.hpp"
 
+#include "linux/ebpf.hpp"
 #include "linux/fs.hpp"
 #include "linux/ns.hpp"
 
@@ -63,6 +74,7 @@
 #include "linux/routing/diagnosis/diagnosis.hpp"
 
 #include "linux/routing/filter/basic.hpp"
+#include "linux/routing/filter/bpf.hpp"
 #include "linux/routing/filter/icmp.hpp"
 #include "linux/routing/filter/ip.hpp"
 
@@ -226,6 +238,28 @@ static const uint16_t ICMP_FLOWID = 2;
 static const uint16_t CONTAINER_MIN_FLOWID = 3;
 
 
+// The number of entries of the ports map of the BPF classifiers (see
+// the `--network_enable_bpf_classifier` flag), indexed by the
+// destination port of a packet. The value is the interface index of
+// the veth of the container which is assigned the port, or zero.
+static const uint32_t BPF_PORTS = 65536;
+
+
+// The maximum number of entries of the counters map of the BPF
+// classifiers, keyed by the interface index of the veth of a
+// container. Each container has at least MIN_EPHEMERAL_PORTS_SIZE
+// ports, which bounds the number of containers.
+static const uint32_t BPF_COUNTERS = BPF_PORTS / MIN_EPHEMERAL_PORTS_SIZE;
+
+
+// The value of the counters map of the BPF classifiers.
+struct BpfCounters
+{
+  uint64_t packets;
+  uint64_t bytes;
+};
+
+
 // The well known ports. Used for sanity check.
 static Interval<uint16_t> WELL_KNOWN_PORTS()
 {
@@ -992,7 +1026,11 @@ PortMappingIsolatorProcess::Metrics::Metrics()
     updating_eth0_arp_filters_do_not_exist(
         "port_mapping/updating_eth0_arp_filters_do_not_exist"),
     updating_container_ip_filters_errors(
-        "port_mapping/updating_container_ip_filters_errors")
+        "port_mapping/updating_container_ip_filters_errors"),
+    adding_ip_filters_ms(
+        "port_mapping/adding_ip_filters_ms"),
+    removing_ip_filters_ms(
+        "port_mapping/removing_ip_filters_ms")
 {
   process::metrics::add(adding_eth0_ip_filters_errors);
   process::metrics::add(adding_eth0_ip_filters_already_exist);
@@ -1025,6 +1063,8 @@ PortMappingIsolatorProcess::Metrics::Metrics()
   process::metrics::add(updating_eth0_arp_filters_already_exist);
   process::metrics::add(updating_eth0_arp_filters_do_not_exist);
   process::metrics::add(updating_container_ip_filters_errors);
+  process::metrics::add(adding_ip_filters_ms);
+  process::metrics::add(removing_ip_filters_ms);
 }
 
 
@@ -1061,6 +1101,8 @@ PortMappingIsolatorProcess::Metrics::~Metrics()
   process::metrics::remove(updating_eth0_arp_filters_already_exist);
   process::metrics::remove(updating_eth0_arp_filters_do_not_exist);
   process::metrics::remove(updating_container_ip_filters_errors);
+  process::metrics::remove(adding_ip_filters_ms);
+  process::metrics::remove(removing_ip_filters_ms);
 }
 
 
@@ -1458,6 +1500,66 @@ Try<Isolator*> PortMappingIsolatorProcess::create(const Flags& flags)
         ": " + createHostLoQdisc.error());
   }
 
+  // Create the maps of the BPF classifiers on host eth0 and host lo.
+  // The classifiers themselves are created (replacing the ones of a
+  // previous run) once the ports of the recovered containers are in
+  // the maps, see 'recover()'.
+  Owned<ebpf::Map> bpfPorts;
+  Owned<ebpf::Map> bpfCounters;
+
+  if (flags.network_enable_bpf_classifier) {
+    if (!ebpf::supported()) {
+      return Error(
+          "Using the BPF classifier requires eBPF support. "
+          "Make sure your kernel is newer than 4.4");
+    }
+
+    Try<Owned<ebpf::Map>> ports = ebpf::Map::create(
+        BPF_MAP_TYPE_ARRAY,
+        sizeof(uint32_t),
+        sizeof(uint32_t),
+        BPF_PORTS);
+
+    if (ports.isError()) {
+      return Error(
+          "Failed to create the ports map of the BPF classifier: " +
+          ports.error());
+    }
+
+    Try<Owned<ebpf::Map>> counters = ebpf::Map::create(
+        BPF_MAP_TYPE_HASH,
+        sizeof(uint32_t),
+        sizeof(BpfCounters),
+        BPF_COUNTERS);
+
+    if (counters.isError()) {
+      return Error(
+          "Failed to create the counters map of the BPF classifier: " +
+          counters.error());
+    }
+
+    bpfPorts = ports.get();
+    bpfCounters = counters.get();
+  } else {
+    // Remove the BPF classifiers of a previous run (if any), which
+    // would otherwise prevent the u32 filters with the same priority
+    // from being created.
+    const vector<string> links = {eth0.get(), lo.get()};
+
+    foreach (const string& link, links) {
+      Try<bool> remove = filter::bpf::remove(
+          link,
+          ingress::HANDLE,
+          Priority(IP_FILTER_PRIORITY, NORMAL));
+
+      if (remove.isError()) {
+        return Error(
+            "Failed to remove the BPF classifier on " + link +
+            ": " + remove.error());
+      }
+    }
+  }
+
   // Enable 'route_localnet' on host loopback interface (lo). This
   // enables the use of 127.0.0.1/8 for local routing purpose. This
   // feature only exists on kernel 3.6 or newer.
@@ -1658,7 +1760,9 @@ Try<Isolator*> PortMappingIsolatorProcess::create(const Flags& flags)
           egressRateLimitPerContainer,
           nonEphemeralPorts,
           ephemeralPortsAllocator,
-          freeFlowIds)));
+          freeFlowIds,
+          bpfPorts,
+          bpfCounters)));
 }
 
 
@@ -1913,6 +2017,49 @@ Future<Nothing> PortMappingIsolatorProcess::recover(
     unknownOrphans.push_back(recover.get());
   }
 
+  // Now that the ports of all the containers are known, create the
+  // BPF classifiers, which replace the ones of a previous run. The
+  // ports of the unknown orphans are included since they are removed
+  // when cleaning up the orphans below.
+  if (flags.network_enable_bpf_classifier) {
+    vector<Info*> recovered = unknownOrphans;
+    foreachvalue (Info* info, infos) {
+      recovered.push_back(info);
+    }
+
+    Option<string> error;
+
+    foreach (Info* info, recovered) {
+      CHECK_SOME(info->pid);
+
+      Try<Nothing> add = addBpfPorts(
+          getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts),
+          veth(info->pid.get()));
+
+      if (add.isError()) {
+        error = "Failed to add the ports of the container with pid " +
+                stringify(info->pid.get()) + " to the BPF classifiers: " +
+                add.error();
+        break;
+      }
+    }
+
+    if (error.isNone()) {
+      Try<Nothing> create = createBpfClassifiers();
+      if (create.isError()) {
+        error = "Failed to create the BPF classifiers: " + create.error();
+      }
+    }
+
+    if (error.isSome()) {
+      foreach (Info* info, recovered) {
+        delete info;
+      }
+
+      return Failure(error.get());
+    }
+  }
+
   foreach (Info* info, unknownOrphans) {
     CHECK_SOME(info->pid);
     pid_t pid = info->pid.get();
@@ -2292,24 +2439,24 @@ Future<Nothing> PortMappingIsolatorProcess::isolate(
 
   // For each port range, add a set of IP packet filters to properly
   // redirect IP traffic to/from containers.
-  foreach (const PortRange& range,
-           getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts)) {
-    if (info->flowId.isSome()) {
-      LOG(INFO) << "Adding IP packet filters with ports " << range
-                << " with flow ID " << info->flowId.get()
-                << " for container " << containerId;
-    } else {
-      LOG(INFO) << "Adding IP packet filters with ports " << range
-                << " for container " << containerId;
-    }
+  const vector<PortRange> ranges =
+    getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts);
 
-    Try<Nothing> add = addHostIPFilters(range, info->flowId, veth(pid));
-    if (add.isError()) {
-      return Failure(
-          "Failed to add IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + add.error());
-    }
+  if (info->flowId.isSome()) {
+    LOG(INFO) << "Adding IP packet filters with ports " << stringify(ranges)
+              << " with flow ID " << info->flowId.get()
+              << " for container " << containerId;
+  } else {
+    LOG(INFO) << "Adding IP packet filters with ports " << stringify(ranges)
+              << " for container " << containerId;
+  }
+
+  Try<Nothing> add = addHostIPFilters(ranges, info->flowId, veth(pid));
+  if (add.isError()) {
+    return Failure(
+        "Failed to add IP packet filters with ports " +
+        stringify(ranges) + " for container with pid " +
+        stringify(pid) + ": " + add.error());
   }
 
   // Relay ICMP packets from veth of the container to host eth0.
@@ -2676,36 +2823,40 @@ Future<Nothing> PortMappingIsolatorProcess::update(
   // We then decide what port ranges need to be added.
   vector<PortRange> portsToAdd = getPortRanges(nonEphemeralPorts - remaining);
 
-  foreach (const PortRange& range, portsToAdd) {
+  if (!portsToAdd.empty()) {
     if (info->flowId.isSome()) {
-      LOG(INFO) << "Adding IP packet filters with ports " << range
+      LOG(INFO) << "Adding IP packet filters with ports "
+                << stringify(portsToAdd)
                 << " with flow ID " << info->flowId.get()
                 << " for container " << containerId;
     } else {
-      LOG(INFO) << "Adding IP packet filters with ports " << range
+      LOG(INFO) << "Adding IP packet filters with ports "
+                << stringify(portsToAdd)
                 << " for container " << containerId;
     }
 
     // All IP packets from a container will be assigned a single flow
     // on host eth0.
-    Try<Nothing> add = addHostIPFilters(range, info->flowId, veth(pid));
+    Try<Nothing> add = addHostIPFilters(portsToAdd, info->flowId, veth(pid));
     if (add.isError()) {
       return Failure(
-          "Failed to add IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
+          "Failed to add IP packet filters with ports " +
+          stringify(portsToAdd) + " for container with pid " +
           stringify(pid) + ": " + add.error());
     }
   }
 
-  foreach (const PortRange& range, portsToRemove) {
-    LOG(INFO) << "Removing IP packet filters with ports " << range
+  if (!portsToRemove.empty()) {
+    const vector<PortRange> ranges(portsToRemove.begin(), portsToRemove.end());
+
+    LOG(INFO) << "Removing IP packet filters with ports " << stringify(ranges)
               << " for container with pid " << pid;
 
-    Try<Nothing> removing = removeHostIPFilters(range, veth(pid));
+    Try<Nothing> removing = removeHostIPFilters(ranges, veth(pid));
     if (removing.isError()) {
       return Failure(
-          "Failed to remove IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
+          "Failed to remove IP packet filters with ports " +
+          stringify(ranges) + " for container with pid " +
           stringify(pid) + ": " + removing.error());
     }
   }
@@ -2834,9 +2985,55 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
     result.set_net_tx_dropped(tx_dropped.get());
   }
 
+  // The packets redirected to the container by the BPF classifiers
+  // on host eth0 and host lo, which are counted in a map.
+  if (flags.network_enable_bpf_classifier) {
+    const uint32_t index = if_nametoindex(veth(info->pid.get()).c_str());
+
+    BpfCounters counters;
+    Try<bool> lookup = bpfCounters->lookup(&index, &counters);
+    if (lookup.isError()) {
+      return Failure(
+          "Failed to get the BPF classifier counters of " +
+          veth(info->pid.get()) + ": " + lookup.error());
+    } else if (lookup.get()) {
+      TrafficControlStatistics* statistics =
+        result.add_net_traffic_control_statistics();
+
+      statistics->set_id(NET_ISOLATOR_HOST_INGRESS);
+      statistics->set_packets(counters.packets);
+      statistics->set_bytes(counters.bytes);
+    }
+  }
+
+  // Collect the statistics from inside the network namespace of the
+  // container, unless ones collected recently enough can be reused.
+  const Option<Future<ResourceStatistics>>& cached = info->namespaceUsage;
+
+  if (cached.isNone() ||
+      (!cached->isPending() &&
+       (!cached->isReady() ||
+        Clock::now() - info->namespaceUsageTime.get() >=
+          flags.network_namespace_statistics_interval))) {
+    info->namespaceUsage = usageInNamespace(info->pid.get());
+    info->namespaceUsageTime = Clock::now();
+  }
+
+  return info->namespaceUsage.get()
+    .then([result](const ResourceStatistics& statistics) {
+      ResourceStatistics usage = result;
+      usage.MergeFrom(statistics);
+      return usage;
+    });
+}
+
+
+Future<ResourceStatistics> PortMappingIsolatorProcess::usageInNamespace(
+    pid_t pid)
+{
   // Retrieve the socket information from inside the container.
   PortMappingStatistics statistics;
-  statistics.flags.pid = info->pid.get();
+  statistics.flags.pid = pid;
   statistics.flags.eth0_name = eth0;
   statistics.flags.enable_socket_statistics_summary =
     flags.network_enable_socket_statistics_summary;
@@ -2869,7 +3066,7 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
     .then(defer(
         PID<PortMappingIsolatorProcess>(this),
         &PortMappingIsolatorProcess::_usage,
-        result,
+        ResourceStatistics(),
         s.get()));
 }
 
@@ -2997,19 +3194,32 @@ Try<Nothing> PortMappingIsolatorProcess::_cleanup(
 
   // Remove the IP filters on eth0 and lo for non-ephemeral port
   // ranges and the ephemeral port range.
-  foreach (const PortRange& range,
-           getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts)) {
-    LOG(INFO) << "Removing IP packet filters with ports " << range
-              << " for container with pid " << pid;
+  const vector<PortRange> ranges =
+    getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts);
 
-    // No need to remove filters on veth as they will be automatically
-    // removed by the kernel when we remove the link below.
-    Try<Nothing> removing = removeHostIPFilters(range, veth(pid), false);
-    if (removing.isError()) {
-      errors.push_back(
-          "Failed to remove IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + removing.error());
+  LOG(INFO) << "Removing IP packet filters with ports " << stringify(ranges)
+            << " for container with pid " << pid;
+
+  // No need to remove filters on veth as they will be automatically
+  // removed by the kernel when we remove the link below.
+  Try<Nothing> removing = removeHostIPFilters(ranges, veth(pid), false);
+  if (removing.isError()) {
+    errors.push_back(
+        "Failed to remove IP packet filters with ports " +
+        stringify(ranges) + " for container with pid " +
+        stringify(pid) + ": " + removing.error());
+  }
+
+  // Remove the counters of the container from the BPF classifiers.
+  if (flags.network_enable_bpf_classifier) {
+    const uint32_t index = if_nametoindex(veth(pid).c_str());
+    if (index != 0) {
+      Try<bool> remove = bpfCounters->remove(&index);
+      if (remove.isError()) {
+        errors.push_back(
+            "Failed to remove the BPF classifier counters for container "
+            "with pid " + stringify(pid) + ": " + remove.error());
+      }
     }
   }
 
@@ -3236,31 +3446,187 @@ Try<Nothing> PortMappingIsolatorProcess::_cleanup(
 }
 
 
-// Helper function to set up IP filters on the host side for a given
-// port range.
+// Loads the BPF classifier for host eth0 (or host lo if the MAC and
+// the IP are not specified). The classifier redirects TCP and UDP
+// packets over IPv4 whose destination port is assigned to a container
+// to the veth of the container, in the same way as the u32 filters
+// from host eth0 (lo) to veth do, and counts them. Other packets are
+// sent to the next filter.
+static Try<Owned<ebpf::Program>> loadBpfClassifier(
+    const ebpf::Map& ports,
+    const ebpf::Map& counters,
+    const Option<net::MAC>& mac,
+    const Option<net::IP>& ip)
+{
+  using namespace ebpf::insn;
+
+  const int16_t ETHERNET = 14;
+
+  vector<struct bpf_insn> program;
+
+  // The jumps to the end of the program (to send the packet to the
+  // next filter), whose offsets are set at the end.
+  vector<size_t> nexts;
+
+  auto next = [&](const struct bpf_insn& jump) {
+    nexts.push_back(program.size());
+    program.push_back(jump);
+  };
+
+  // The context (i.e., the __sk_buff) needs to be in r6 for loading
+  // the packet data. Offsets are from the Ethernet header.
+  program.push_back(mov(BPF_REG_6, BPF_REG_1));
+
+  if (mac.isSome()) {
+    const net::MAC& address = mac.get();
+
+    program.push_back(ldAbs(BPF_W, 0));
+    program.push_back(mov32(
+        BPF_REG_1,
+        ((uint32_t) address[0] << 24) | ((uint32_t) address[1] << 16) |
+        ((uint32_t) address[2] << 8) | (uint32_t) address[3]));
+    next(jumpX(BPF_JNE, BPF_REG_0, BPF_REG_1, 0));
+
+    program.push_back(ldAbs(BPF_H, 4));
+    next(jump(BPF_JNE, BPF_REG_0, (address[4] << 8) | address[5], 0));
+  }
+
+  // Ethernet type.
+  program.push_back(ldAbs(BPF_H, 12));
+  next(jump(BPF_JNE, BPF_REG_0, ETH_P_IP, 0));
+
+  // Destination IP. NOTE: The IP is compared with a register because
+  // immediates are sign extended.
+  if (ip.isSome()) {
+    program.push_back(ldAbs(BPF_W, ETHERNET + 16));
+    program.push_back(mov32(BPF_REG_1, ntohl(ip.get().in().get().s_addr)));
+    next(jumpX(BPF_JNE, BPF_REG_0, BPF_REG_1, 0));
+  }
+
+  // Protocol.
+  program.push_back(ldAbs(BPF_B, ETHERNET + 9));
+  program.push_back(jump(BPF_JEQ, BPF_REG_0, IPPROTO_TCP, 1));
+  next(jump(BPF_JNE, BPF_REG_0, IPPROTO_UDP, 0));
+
+  // Only the first fragment of a packet has the ports.
+  program.push_back(ldAbs(BPF_H, ETHERNET + 6));
+  program.push_back(alu(BPF_AND, BPF_REG_0, 0x1fff));
+  next(jump(BPF_JNE, BPF_REG_0, 0, 0));
+
+  // Destination port, which follows the IP header (whose length is
+  // in 32-bit words) and the source port.
+  program.push_back(ldAbs(BPF_B, ETHERNET));
+  program.push_back(alu(BPF_AND, BPF_REG_0, 0x0f));
+  program.push_back(alu(BPF_LSH, BPF_REG_0, 2));
+  program.push_back(mov(BPF_REG_7, BPF_REG_0));
+  program.push_back(ldInd(BPF_H, BPF_REG_7, ETHERNET + 2));
+
+  // r7 = ports[port].
+  program.push_back(store(BPF_W, BPF_REG_10, BPF_REG_0, -4));
+  loadMap(&program, BPF_REG_1, ports);
+  program.push_back(mov(BPF_REG_2, BPF_REG_10));
+  program.push_back(alu(BPF_ADD, BPF_REG_2, -4));
+  program.push_back(call(BPF_FUNC_map_lookup_elem));
+  next(jump(BPF_JEQ, BPF_REG_0, 0, 0));
+  program.push_back(load(BPF_W, BPF_REG_7, BPF_REG_0, 0));
+  next(jump(BPF_JEQ, BPF_REG_7, 0, 0));
+
+  // Count the packet (if the counters of the container exist).
+  program.push_back(store(BPF_W, BPF_REG_10, BPF_REG_7, -8));
+  loadMap(&program, BPF_REG_1, counters);
+  program.push_back(mov(BPF_REG_2, BPF_REG_10));
+  program.push_back(alu(BPF_ADD, BPF_REG_2, -8));
+  program.push_back(call(BPF_FUNC_map_lookup_elem));
+  program.push_back(jump(BPF_JEQ, BPF_REG_0, 0, 4));
+  program.push_back(mov64(BPF_REG_1, 1));
+  program.push_back(add(BPF_DW, BPF_REG_0, BPF_REG_1, 0));
+  program.push_back(load(BPF_W, BPF_REG_1, BPF_REG_6, 0));
+  program.push_back(add(BPF_DW, BPF_REG_0, BPF_REG_1, 8));
+
+  // Redirect the packet to the veth (i.e., TC_ACT_REDIRECT).
+  program.push_back(mov(BPF_REG_1, BPF_REG_7));
+  program.push_back(mov64(BPF_REG_2, 0));
+  program.push_back(call(BPF_FUNC_redirect));
+  program.push_back(ret());
+
+  foreach (size_t index, nexts) {
+    program[index].off = program.size() - index - 1;
+  }
+
+  program.push_back(mov64(BPF_REG_0, TC_ACT_UNSPEC));
+  program.push_back(ret());
+
+  return ebpf::Program::load(BPF_PROG_TYPE_SCHED_CLS, program);
+}
+
+
+// Returns the classifiers built for each of the port ranges.
+static vector<ip::Classifier> getClassifiers(
+    const vector<PortRange>& ranges,
+    const lambda::function<ip::Classifier(const PortRange&)>& classifier)
+{
+  vector<ip::Classifier> classifiers;
+  foreach (const PortRange& range, ranges) {
+    classifiers.push_back(classifier(range));
+  }
+
+  return classifiers;
+}
+
+
+// Returns the port ranges for which the filter was not created (or
+// not removed) according to the results of a batched operation.
+static vector<PortRange> getFailedRanges(
+    const vector<PortRange>& ranges,
+    const vector<bool>& results)
+{
+  CHECK_EQ(ranges.size(), results.size());
+
+  vector<PortRange> failed;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (!results[i]) {
+      failed.push_back(ranges[i]);
+    }
+  }
+
+  return failed;
+}
+
+
+// Helper function to set up IP filters on the host side for the given
+// port ranges. Filters of the same kind are created for all the port
+// ranges in batches.
 Try<Nothing> PortMappingIsolatorProcess::addHostIPFilters(
-    const PortRange& range,
+    const vector<PortRange>& ranges,
     const Option<uint16_t>& flowId,
     const string& veth)
 {
+  if (ranges.empty()) {
+    return Nothing();
+  }
+
+  metrics.adding_ip_filters_ms.start();
+
   // NOTE: The order in which these filters are added is important!
-  // For each port range, we need to make sure that we don't try to
-  // add filters on host eth0 and host lo until we have successfully
-  // added filters on veth. This is because the slave could crash
-  // while we are adding filters, we want to make sure we don't leak
-  // any filters on host eth0 and host lo.
+  // We need to make sure that we don't try to add filters on host
+  // eth0 and host lo until we have successfully added filters on
+  // veth for all the port ranges. This is because the slave could
+  // crash while we are adding filters, we want to make sure we don't
+  // leak any filters on host eth0 and host lo.
 
-  // Add an IP packet filter from veth of the container to host eth0
+  // Add IP packet filters from veth of the container to host eth0
   // to properly redirect IP packets sent from one container to
-  // external hosts. This filter has a lower priority compared to the
-  // 'vethToHostLo' filter because it does not check the destination
-  // IP. Notice that here we also check the source port of a packet.
-  // If the source port is not within the port ranges allocated for
-  // the container, the packet will get dropped.
-  Try<bool> vethToHostEth0 = filter::ip::create(
+  // external hosts. These filters have a lower priority compared to
+  // the 'vethToHostLo' filters because they do not check the
+  // destination IP. Notice that here we also check the source port
+  // of a packet. If the source port is not within the port ranges
+  // allocated for the container, the packet will get dropped.
+  Try<vector<bool>> vethToHostEth0 = filter::ip::create(
       veth,
       ingress::HANDLE,
-      ip::Classifier(None(), None(), range, None()),
+      getClassifiers(ranges, [](const PortRange& range) {
+        return ip::Classifier(None(), None(), range, None());
+      }),
       Priority(IP_FILTER_PRIORITY, LOW),
       action::Redirect(eth0));
 
@@ -3268,26 +3634,34 @@ Try<Nothing> PortMappingIsolatorProcess::addHostIPFilters(
     ++metrics.adding_veth_ip_filters_errors;
 
     return Error(
-        "Failed to create an IP packet filter from " + veth +
+        "Failed to create IP packet filters from " + veth +
         " to host " + eth0 + ": " + vethToHostEth0.error());
-  } else if (!vethToHostEth0.get()) {
+  }
+
+  vector<PortRange> failed = getFailedRanges(ranges, vethToHostEth0.get());
+  if (!failed.empty()) {
     ++metrics.adding_veth_ip_filters_already_exist;
 
     return Error(
-        "The IP packet filter from " + veth +
-        " to host " + eth0 + " already exists");
+        "The IP packet filters from " + veth + " to host " + eth0 +
+        " with ports " + stringify(failed) + " already exist");
   }
 
   // Add two IP packet filters (one for public IP and one for loopback
-  // IP) from veth of the container to host lo to properly redirect IP
-  // packets sent from one container to either the host or another
-  // container. Notice that here we also check the source port of a
-  // packet. If the source port is not within the port ranges
-  // allocated for the container, the packet will get dropped.
-  Try<bool> vethToHostLoPublic = filter::ip::create(
+  // IP) from veth of the container to host lo for each port range to
+  // properly redirect IP packets sent from one container to either
+  // the host or another container. Notice that here we also check
+  // the source port of a packet. If the source port is not within
+  // the port ranges allocated for the container, the packet will get
+  // dropped.
+  const net::IP publicIP = hostIPNetwork.address();
+
+  Try<vector<bool>> vethToHostLoPublic = filter::ip::create(
       veth,
       ingress::HANDLE,
-      ip::Classifier(None(), hostIPNetwork.address(), range, None()),
+      getClassifiers(ranges, [=](const PortRange& range) {
+        return ip::Classifier(None(), publicIP, range, None());
+      }),
       Priority(IP_FILTER_PRIORITY, NORMAL),
       action::Redirect(lo));
 
@@ -3295,24 +3669,30 @@ Try<Nothing> PortMappingIsolatorProcess::addHostIPFilters(
     ++metrics.adding_veth_ip_filters_errors;
 
     return Error(
-        "Failed to create an IP packet filter (for public IP) from " +
+        "Failed to create IP packet filters (for public IP) from " +
         veth + " to host " + lo + ": " + vethToHostLoPublic.error());
-  } else if (!vethToHostLoPublic.get()) {
+  }
+
+  failed = getFailedRanges(ranges, vethToHostLoPublic.get());
+  if (!failed.empty()) {
     ++metrics.adding_veth_ip_filters_already_exist;
 
     return Error(
-        "The IP packet filter (for public IP) from " +
-        veth + " to host " + lo + " already exists");
+        "The IP packet filters (for public IP) from " + veth +
+        " to host " + lo + " with ports " + stringify(failed) +
+        " already exist");
   }
 
-  Try<bool> vethToHostLoLoopback = filter::ip::create(
+  Try<vector<bool>> vethToHostLoLoopback = filter::ip::create(
       veth,
       ingress::HANDLE,
-      ip::Classifier(
-          None(),
-          net::IPNetwork::LOOPBACK_V4().address(),
-          range,
-          None()),
+      getClassifiers(ranges, [](const PortRange& range) {
+        return ip::Classifier(
+            None(),
+            net::IPNetwork::LOOPBACK_V4().address(),
+            range,
+            None());
+      }),
       Priority(IP_FILTER_PRIORITY, NORMAL),
       action::Redirect(lo));
 
@@ -3320,73 +3700,105 @@ Try<Nothing> PortMappingIsolatorProcess::addHostIPFilters(
     ++metrics.adding_veth_ip_filters_errors;
 
     return Error(
-        "Failed to create an IP packet filter (for loopback IP) from " +
+        "Failed to create IP packet filters (for loopback IP) from " +
         veth + " to host " + lo + ": " + vethToHostLoLoopback.error());
-  } else if (!vethToHostLoLoopback.get()) {
+  }
+
+  failed = getFailedRanges(ranges, vethToHostLoLoopback.get());
+  if (!failed.empty()) {
     ++metrics.adding_veth_ip_filters_already_exist;
 
     return Error(
-        "The IP packet filter (for loopback IP) from " +
-        veth + " to host " + lo + " already exists");
+        "The IP packet filters (for loopback IP) from " + veth +
+        " to host " + lo + " with ports " + stringify(failed) +
+        " already exist");
   }
 
-  // Add an IP packet filter from host eth0 to veth of the container
-  // such that any incoming IP packet will be properly redirected to
-  // the corresponding container based on its destination port.
-  Try<bool> hostEth0ToVeth = filter::ip::create(
-      eth0,
-      ingress::HANDLE,
-      ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(veth));
+  if (flags.network_enable_bpf_classifier) {
+    // The BPF classifiers on host eth0 and host lo redirect the IP
+    // packets whose destination port is assigned to the container to
+    // veth, instead of the IP packet filters below.
+    Try<Nothing> add = addBpfPorts(ranges, veth);
+    if (add.isError()) {
+      ++metrics.adding_eth0_ip_filters_errors;
 
-  if (hostEth0ToVeth.isError()) {
-    ++metrics.adding_eth0_ip_filters_errors;
+      return Error(
+          "Failed to add the ports of " + veth +
+          " to the BPF classifiers: " + add.error());
+    }
+  } else {
+    // Add IP packet filters from host eth0 to veth of the container
+    // such that any incoming IP packet will be properly redirected to
+    // the corresponding container based on its destination port.
+    const net::MAC mac = hostMAC;
 
-    return Error(
-        "Failed to create an IP packet filter from host " +
-        eth0 + " to " + veth + ": " + hostEth0ToVeth.error());
-  } else if (!hostEth0ToVeth.get()) {
-    ++metrics.adding_eth0_ip_filters_already_exist;
+    Try<vector<bool>> hostEth0ToVeth = filter::ip::create(
+        eth0,
+        ingress::HANDLE,
+        getClassifiers(ranges, [=](const PortRange& range) {
+          return ip::Classifier(mac, publicIP, None(), range);
+        }),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        action::Redirect(veth));
 
-    return Error(
-        "The IP packet filter from host " + eth0 + " to " +
-        veth + " already exists");
-  }
+    if (hostEth0ToVeth.isError()) {
+      ++metrics.adding_eth0_ip_filters_errors;
 
-  // Add an IP packet filter from host lo to veth of the container
-  // such that any internally generated IP packet will be properly
-  // redirected to the corresponding container based on its
-  // destination port.
-  Try<bool> hostLoToVeth = filter::ip::create(
-      lo,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), None(), range),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(veth));
+      return Error(
+          "Failed to create IP packet filters from host " +
+          eth0 + " to " + veth + ": " + hostEth0ToVeth.error());
+    }
 
-  if (hostLoToVeth.isError()) {
-    ++metrics.adding_lo_ip_filters_errors;
+    failed = getFailedRanges(ranges, hostEth0ToVeth.get());
+    if (!failed.empty()) {
+      ++metrics.adding_eth0_ip_filters_already_exist;
 
-    return Error(
-        "Failed to create an IP packet filter from host " +
-        lo + " to " + veth + ": " + hostLoToVeth.error());
-  } else if (!hostLoToVeth.get()) {
-    ++metrics.adding_lo_ip_filters_already_exist;
+      return Error(
+          "The IP packet filters from host " + eth0 + " to " + veth +
+          " with ports " + stringify(failed) + " already exist");
+    }
 
-    return Error(
-        "The IP packet filter from host " + lo + " to " +
-        veth + " already exists");
+    // Add IP packet filters from host lo to veth of the container such
+    // that any internally generated IP packet will be properly
+    // redirected to the corresponding container based on its
+    // destination port.
+    Try<vector<bool>> hostLoToVeth = filter::ip::create(
+        lo,
+        ingress::HANDLE,
+        getClassifiers(ranges, [](const PortRange& range) {
+          return ip::Classifier(None(), None(), None(), range);
+        }),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        action::Redirect(veth));
+
+    if (hostLoToVeth.isError()) {
+      ++metrics.adding_lo_ip_filters_errors;
+
+      return Error(
+          "Failed to create IP packet filters from host " +
+          lo + " to " + veth + ": " + hostLoToVeth.error());
+    }
+
+    failed = getFailedRanges(ranges, hostLoToVeth.get());
+    if (!failed.empty()) {
+      ++metrics.adding_lo_ip_filters_already_exist;
+
+      return Error(
+          "The IP packet filters from host " + lo + " to " + veth +
+          " with ports " + stringify(failed) + " already exist");
+    }
   }
 
   if (flowId.isSome()) {
     // Add IP packet filters to classify traffic sending to eth0
     // in the same way so that traffic of each container will be
     // classified to different flows defined by fq_codel.
-    Try<bool> hostEth0Egress = filter::ip::create(
+    Try<vector<bool>> hostEth0Egress = filter::ip::create(
         eth0,
         hostTxFqCodelHandle,
-        ip::Classifier(None(), None(), range, None()),
+        getClassifiers(ranges, [](const PortRange& range) {
+          return ip::Classifier(None(), None(), range, None());
+        }),
         Priority(IP_FILTER_PRIORITY, LOW),
         Handle(hostTxFqCodelHandle, flowId.get()));
 
@@ -3394,160 +3806,347 @@ Try<Nothing> PortMappingIsolatorProcess::addHostIPFilters(
       ++metrics.adding_eth0_egress_filters_errors;
 
       return Error(
-          "Failed to create a flow classifier for " + veth +
+          "Failed to create flow classifiers for " + veth +
           " on host " + eth0 + ": " + hostEth0Egress.error());
-    } else if (!hostEth0Egress.get()) {
+    }
+
+    failed = getFailedRanges(ranges, hostEth0Egress.get());
+    if (!failed.empty()) {
       ++metrics.adding_eth0_egress_filters_already_exist;
 
       return Error(
-          "The flow classifier for veth " + veth +
-          " on host " + eth0 + " already exists");
+          "The flow classifiers for veth " + veth + " on host " +
+          eth0 + " with ports " + stringify(failed) + " already exist");
     }
   }
 
+  metrics.adding_ip_filters_ms.stop();
+
   return Nothing();
 }
 
 
-// Helper function to remove IP filters from the host side for a given
-// port range. The boolean flag 'removeFiltersOnVeth' indicates if we
-// need to remove filters on veth.
+// Helper function to remove IP filters from the host side for the
+// given port ranges. Filters of the same kind are removed for all the
+// port ranges in batches. The boolean flag 'removeFiltersOnVeth'
+// indicates if we need to remove filters on veth.
 Try<Nothing> PortMappingIsolatorProcess::removeHostIPFilters(
-    const PortRange& range,
+    const vector<PortRange>& ranges,
     const string& veth,
     bool removeFiltersOnVeth)
 {
+  if (ranges.empty()) {
+    return Nothing();
+  }
+
+  metrics.removing_ip_filters_ms.start();
+
   // NOTE: Similar to above. The order in which these filters are
   // removed is important. We need to remove filters on host eth0 and
   // host lo first before we remove filters on veth.
 
-  // Remove the IP packet filter from host eth0 to veth of the container.
-  Try<bool> hostEth0ToVeth = filter::ip::remove(
-      eth0,
-      ingress::HANDLE,
-      ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range));
+  const net::MAC mac = hostMAC;
+  const net::IP publicIP = hostIPNetwork.address();
 
-  if (hostEth0ToVeth.isError()) {
-    ++metrics.removing_eth0_ip_filters_errors;
+  vector<PortRange> failed;
 
-    return Error(
-        "Failed to remove the IP packet filter from host " +
-        eth0 + " to " + veth + ": " + hostEth0ToVeth.error());
-  } else if (!hostEth0ToVeth.get()) {
-    ++metrics.removing_eth0_ip_filters_do_not_exist;
+  if (flags.network_enable_bpf_classifier) {
+    Try<Nothing> removing = removeBpfPorts(ranges);
+    if (removing.isError()) {
+      ++metrics.removing_eth0_ip_filters_errors;
 
-    LOG(ERROR) << "The IP packet filter from host " << eth0
-               << " to " << veth << " does not exist";
-  }
+      return Error(
+          "Failed to remove the ports of " + veth +
+          " from the BPF classifiers: " + removing.error());
+    }
+  } else {
+    // Remove the IP packet filters from host eth0 to veth of the
+    // container.
+    Try<vector<bool>> hostEth0ToVeth = filter::ip::remove(
+        eth0,
+        ingress::HANDLE,
+        getClassifiers(ranges, [=](const PortRange& range) {
+          return ip::Classifier(mac, publicIP, None(), range);
+        }));
 
-  // Remove the IP packet filter from host lo to veth of the container.
-  Try<bool> hostLoToVeth = filter::ip::remove(
-      lo,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), None(), range));
+    if (hostEth0ToVeth.isError()) {
+      ++metrics.removing_eth0_ip_filters_errors;
 
-  if (hostLoToVeth.isError()) {
-    ++metrics.removing_lo_ip_filters_errors;
+      return Error(
+          "Failed to remove the IP packet filters from host " +
+          eth0 + " to " + veth + ": " + hostEth0ToVeth.error());
+    }
 
-    return Error(
-        "Failed to remove the IP packet filter from host " +
-        lo + " to " + veth + ": " + hostLoToVeth.error());
-  } else if (!hostLoToVeth.get()) {
-    ++metrics.removing_lo_ip_filters_do_not_exist;
+    failed = getFailedRanges(ranges, hostEth0ToVeth.get());
+    if (!failed.empty()) {
+      ++metrics.removing_eth0_ip_filters_do_not_exist;
+
+      LOG(ERROR) << "The IP packet filters from host " << eth0
+                 << " to " << veth << " with ports " << stringify(failed)
+                 << " do not exist";
+    }
+
+    // Remove the IP packet filters from host lo to veth of the
+    // container.
+    Try<vector<bool>> hostLoToVeth = filter::ip::remove(
+        lo,
+        ingress::HANDLE,
+        getClassifiers(ranges, [](const PortRange& range) {
+          return ip::Classifier(None(), None(), None(), range);
+        }));
+
+    if (hostLoToVeth.isError()) {
+      ++metrics.removing_lo_ip_filters_errors;
 
-    LOG(ERROR) << "The IP packet filter from host " << lo
-               << " to " << veth << " does not exist";
+      return Error(
+          "Failed to remove the IP packet filters from host " +
+          lo + " to " + veth + ": " + hostLoToVeth.error());
+    }
+
+    failed = getFailedRanges(ranges, hostLoToVeth.get());
+    if (!failed.empty()) {
+      ++metrics.removing_lo_ip_filters_do_not_exist;
+
+      LOG(ERROR) << "The IP packet filters from host " << lo
+                 << " to " << veth << " with ports " << stringify(failed)
+                 << " do not exist";
+    }
   }
 
   if (flags.egress_unique_flow_per_container) {
-    // Remove the egress flow classifier on host eth0.
-    Try<bool> hostEth0Egress = filter::ip::remove(
+    // Remove the egress flow classifiers on host eth0.
+    Try<vector<bool>> hostEth0Egress = filter::ip::remove(
         eth0,
         hostTxFqCodelHandle,
-        ip::Classifier(None(), None(), range, None()));
+        getClassifiers(ranges, [](const PortRange& range) {
+          return ip::Classifier(None(), None(), range, None());
+        }));
 
     if (hostEth0Egress.isError()) {
       ++metrics.removing_eth0_egress_filters_errors;
 
       return Error(
-          "Failed to remove the flow classifier from host " +
+          "Failed to remove the flow classifiers from host " +
           eth0 + " for " + veth + ": " + hostEth0Egress.error());
-    } else if (!hostEth0Egress.get()) {
+    }
+
+    failed = getFailedRanges(ranges, hostEth0Egress.get());
+    if (!failed.empty()) {
       ++metrics.removing_eth0_egress_filters_do_not_exist;
 
-      LOG(ERROR) << "The flow classifier from host " << eth0
-                 << " for " << range << " does not exist";
+      LOG(ERROR) << "The flow classifiers from host " << eth0
+                 << " for " << stringify(failed) << " do not exist";
     }
   }
 
   // Now, we try to remove filters on veth. No need to proceed if the
   // user does not ask us to do so.
   if (!removeFiltersOnVeth) {
+    metrics.removing_ip_filters_ms.stop();
     return Nothing();
   }
 
-  // Remove the IP packet filter from veth of the container to
+  // Remove the IP packet filters from veth of the container to
   // host lo for the public IP.
-  Try<bool> vethToHostLoPublic = filter::ip::remove(
+  Try<vector<bool>> vethToHostLoPublic = filter::ip::remove(
       veth,
       ingress::HANDLE,
-      ip::Classifier(None(), hostIPNetwork.address(), range, None()));
+      getClassifiers(ranges, [=](const PortRange& range) {
+        return ip::Classifier(None(), publicIP, range, None());
+      }));
 
   if (vethToHostLoPublic.isError()) {
     ++metrics.removing_lo_ip_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter (for public IP) from " +
+        "Failed to remove the IP packet filters (for public IP) from " +
         veth + " to host " + lo + ": " + vethToHostLoPublic.error());
-  } else if (!vethToHostLoPublic.get()) {
+  }
+
+  failed = getFailedRanges(ranges, vethToHostLoPublic.get());
+  if (!failed.empty()) {
     ++metrics.removing_lo_ip_filters_do_not_exist;
 
-    LOG(ERROR) << "The IP packet filter (for public IP) from "
-               << veth << " to host " << lo << " does not exist";
+    LOG(ERROR) << "The IP packet filters (for public IP) from "
+               << veth << " to host " << lo << " with ports "
+               << stringify(failed) << " do not exist";
   }
 
-  // Remove the IP packet filter from veth of the container to
+  // Remove the IP packet filters from veth of the container to
   // host lo for the loopback IP.
-  Try<bool> vethToHostLoLoopback = filter::ip::remove(
+  Try<vector<bool>> vethToHostLoLoopback = filter::ip::remove(
       veth,
       ingress::HANDLE,
-      ip::Classifier(
-          None(),
-          net::IPNetwork::LOOPBACK_V4().address(),
-          range,
-          None()));
+      getClassifiers(ranges, [](const PortRange& range) {
+        return ip::Classifier(
+            None(),
+            net::IPNetwork::LOOPBACK_V4().address(),
+            range,
+            None());
+      }));
 
   if (vethToHostLoLoopback.isError()) {
     ++metrics.removing_veth_ip_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter (for loopback IP) from " +
+        "Failed to remove the IP packet filters (for loopback IP) from " +
         veth + " to host " + lo + ": " + vethToHostLoLoopback.error());
-  } else if (!vethToHostLoLoopback.get()) {
+  }
+
+  failed = getFailedRanges(ranges, vethToHostLoLoopback.get());
+  if (!failed.empty()) {
     ++metrics.removing_veth_ip_filters_do_not_exist;
 
-    LOG(ERROR) << "The IP packet filter (for loopback IP) from "
-               << veth << " to host " << lo << " does not exist";
+    LOG(ERROR) << "The IP packet filters (for loopback IP) from "
+               << veth << " to host " << lo << " with ports "
+               << stringify(failed) << " do not exist";
   }
 
-  // Remove the IP packet filter from veth of the container to
+  // Remove the IP packet filters from veth of the container to
   // host eth0.
-  Try<bool> vethToHostEth0 = filter::ip::remove(
+  Try<vector<bool>> vethToHostEth0 = filter::ip::remove(
       veth,
       ingress::HANDLE,
-      ip::Classifier(None(), None(), range, None()));
+      getClassifiers(ranges, [](const PortRange& range) {
+        return ip::Classifier(None(), None(), range, None());
+      }));
 
   if (vethToHostEth0.isError()) {
     ++metrics.removing_veth_ip_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter from " + veth +
+        "Failed to remove the IP packet filters from " + veth +
         " to host " + eth0 + ": " + vethToHostEth0.error());
-  } else if (!vethToHostEth0.get()) {
+  }
+
+  failed = getFailedRanges(ranges, vethToHostEth0.get());
+  if (!failed.empty()) {
     ++metrics.removing_veth_ip_filters_do_not_exist;
 
-    LOG(ERROR) << "The IP packet filter from " << veth
-               << " to host " << eth0 << " does not exist";
+    LOG(ERROR) << "The IP packet filters from " << veth
+               << " to host " << eth0 << " with ports "
+               << stringify(failed) << " do not exist";
+  }
+
+  metrics.removing_ip_filters_ms.stop();
+
+  return Nothing();
+}
+
+
+// Creates the BPF classifiers on host eth0 and host lo (or replaces
+// the ones of a previous run), which use the current maps.
+Try<Nothing> PortMappingIsolatorProcess::createBpfClassifiers()
+{
+  CHECK(flags.network_enable_bpf_classifier);
+
+  Try<Owned<ebpf::Program>> hostEth0Classifier = loadBpfClassifier(
+      *bpfPorts,
+      *bpfCounters,
+      hostMAC,
+      hostIPNetwork.address());
+
+  if (hostEth0Classifier.isError()) {
+    return Error(
+        "Failed to load the BPF classifier for host " + eth0 +
+        ": " + hostEth0Classifier.error());
+  }
+
+  Try<Nothing> create = filter::bpf::create(
+      eth0,
+      ingress::HANDLE,
+      Priority(IP_FILTER_PRIORITY, NORMAL),
+      hostEth0Classifier.get()->fd(),
+      "mesos-" + eth0);
+
+  if (create.isError()) {
+    return Error(
+        "Failed to create the BPF classifier on host " + eth0 +
+        ": " + create.error());
+  }
+
+  Try<Owned<ebpf::Program>> hostLoClassifier = loadBpfClassifier(
+      *bpfPorts,
+      *bpfCounters,
+      None(),
+      None());
+
+  if (hostLoClassifier.isError()) {
+    return Error(
+        "Failed to load the BPF classifier for host " + lo +
+        ": " + hostLoClassifier.error());
+  }
+
+  create = filter::bpf::create(
+      lo,
+      ingress::HANDLE,
+      Priority(IP_FILTER_PRIORITY, NORMAL),
+      hostLoClassifier.get()->fd(),
+      "mesos-" + lo);
+
+  if (create.isError()) {
+    return Error(
+        "Failed to create the BPF classifier on host " + lo +
+        ": " + create.error());
+  }
+
+  return Nothing();
+}
+
+
+// Assigns the ports to the veth in the maps of the BPF classifiers,
+// and creates the counters of the veth if they do not exist yet.
+Try<Nothing> PortMappingIsolatorProcess::addBpfPorts(
+    const vector<PortRange>& ranges,
+    const string& veth)
+{
+  CHECK(flags.network_enable_bpf_classifier);
+
+  const uint32_t index = if_nametoindex(veth.c_str());
+  if (index == 0) {
+    return ErrnoError("Failed to get the interface index of " + veth);
+  }
+
+  BpfCounters counters;
+  Try<bool> exists = bpfCounters->lookup(&index, &counters);
+  if (exists.isError()) {
+    return Error(exists.error());
+  } else if (!exists.get()) {
+    memset(&counters, 0, sizeof(counters));
+
+    Try<Nothing> update = bpfCounters->update(&index, &counters);
+    if (update.isError()) {
+      return Error(update.error());
+    }
+  }
+
+  foreach (const PortRange& range, ranges) {
+    for (uint32_t port = range.begin(); port <= range.end(); port++) {
+      Try<Nothing> update = bpfPorts->update(&port, &index);
+      if (update.isError()) {
+        return Error(update.error());
+      }
+    }
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> PortMappingIsolatorProcess::removeBpfPorts(
+    const vector<PortRange>& ranges)
+{
+  CHECK(flags.network_enable_bpf_classifier);
+
+  const uint32_t none = 0;
+
+  foreach (const PortRange& range, ranges) {
+    for (uint32_t port = range.begin(); port <= range.end(); port++) {
+      Try<Nothing> update = bpfPorts->update(&port, &none);
+      if (update.isError()) {
+        return Error(update.error());
+      }
+    }
   }
 
   return Nothing();
@@ -25,13 +25,17 @@
 #include <string>
 #include <vector>
 
+#include <process/future.hpp>
 #include <process/owned.hpp>
 #include <process/subprocess.hpp>
+#include <process/time.hpp>
 
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/counter.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/bytes.hpp>
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/ip.hpp>
@@ -41,6 +45,8 @@
 #include <stout/option.hpp>
 #include <stout/subcommand.hpp>
 
+#include "linux/ebpf.hpp"
+
 #include "linux/routing/filter/ip.hpp"
 
 #include "slave/flags.hpp"
@@ -77,6 +83,10 @@ inline std::string PORT_MAPPING_BIND_MOUNT_SYMLINK_ROOT()
 constexpr char NET_ISOLATOR_BW_LIMIT[] = "bw_limit";
 constexpr char NET_ISOLATOR_BLOAT_REDUCTION[] = "bloat_reduction";
 
+// The packets redirected to a container by the BPF classifiers on
+// host eth0 and host lo (see `--network_enable_bpf_classifier`).
+constexpr char NET_ISOLATOR_HOST_INGRESS[] = "host_ingress";
+
 
 // Responsible for allocating ephemeral ports for the port mapping
 // network isolator. This class is exposed mainly for unit testing.
@@ -200,6 +210,12 @@ private:
 
     Option<pid_t> pid;
     Option<uint16_t> flowId;
+
+    // The statistics collected from inside the network namespace of
+    // the container and when their collection started, see the
+    // `--network_namespace_statistics_interval` flag.
+    Option<process::Future<ResourceStatistics>> namespaceUsage;
+    Option<process::Time> namespaceUsageTime;
   };
 
   // Define the metrics used by the port mapping network isolator.
@@ -243,6 +259,11 @@ private:
     process::metrics::Counter updating_eth0_arp_filters_already_exist;
     process::metrics::Counter updating_eth0_arp_filters_do_not_exist;
     process::metrics::Counter updating_container_ip_filters_errors;
+
+    // Latencies of adding (removing) all the IP packet filters on the
+    // host side for a container's port ranges.
+    process::metrics::Timer<Milliseconds> adding_ip_filters_ms;
+    process::metrics::Timer<Milliseconds> removing_ip_filters_ms;
   } metrics;
 
   PortMappingIsolatorProcess(
@@ -258,7 +279,9 @@ private:
       const Option<Bytes>& _egressRateLimitPerContainer,
       const IntervalSet<uint16_t>& _managedNonEphemeralPorts,
       const process::Owned<EphemeralPortsAllocator>& _ephemeralPortsAllocator,
-      const std::set<uint16_t>& _flowIDs)
+      const std::set<uint16_t>& _flowIDs,
+      const process::Owned<ebpf::Map>& _bpfPorts,
+      const process::Owned<ebpf::Map>& _bpfCounters)
     : flags(_flags),
       eth0(_eth0),
       lo(_lo),
@@ -271,7 +294,9 @@ private:
       egressRateLimitPerContainer(_egressRateLimitPerContainer),
       managedNonEphemeralPorts(_managedNonEphemeralPorts),
       ephemeralPortsAllocator(_ephemeralPortsAllocator),
-      freeFlowIds(_flowIDs) {}
+      freeFlowIds(_flowIDs),
+      bpfPorts(_bpfPorts),
+      bpfCounters(_bpfCounters) {}
 
   // Continuations.
   Try<Nothing> _cleanup(Info* info, const Option<ContainerID>& containerId);
@@ -281,6 +306,8 @@ private:
       const ContainerID& containerId,
       const process::Future<Option<int>>& status);
 
+  process::Future<ResourceStatistics> usageInNamespace(pid_t pid);
+
   process::Future<ResourceStatistics> _usage(
       const ResourceStatistics& result,
       const process::Subprocess& s);
@@ -291,15 +318,26 @@ private:
 
   // Helper functions.
   Try<Nothing> addHostIPFilters(
-      const routing::filter::ip::PortRange& range,
+      const std::vector<routing::filter::ip::PortRange>& ranges,
       const Option<uint16_t>& flowId,
       const std::string& veth);
 
   Try<Nothing> removeHostIPFilters(
-      const routing::filter::ip::PortRange& range,
+      const std::vector<routing::filter::ip::PortRange>& ranges,
       const std::string& veth,
       bool removeFiltersOnVeth = true);
 
+  // Helper functions for the BPF classifiers on host eth0 and host lo
+  // (see the `--network_enable_bpf_classifier` flag).
+  Try<Nothing> createBpfClassifiers();
+
+  Try<Nothing> addBpfPorts(
+      const std::vector<routing::filter::ip::PortRange>& ranges,
+      const std::string& veth);
+
+  Try<Nothing> removeBpfPorts(
+      const std::vector<routing::filter::ip::PortRange>& ranges);
+
   // Return the scripts that will be executed in the child context.
   std::string scripts(Info* info);
 
@@ -332,6 +370,12 @@ private:
   // Store a set of unused flow ID's on this slave.
   std::set<uint16_t> freeFlowIds;
 
+  // The maps of the BPF classifiers, from ports to the veth of the
+  // containers and from the veth of the containers to their counters.
+  // These are null unless `--network_enable_bpf_classifier` is set.
+  process::Owned<ebpf::Map> bpfPorts;
+  process::Owned<ebpf::Map> bpfCounters;
+
   hashmap<ContainerID, Info*> infos;
 
   // Recovered containers from a previous run that weren't managed by
@@ -14,34 +14,36 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <signal.h>
-
-#ifdef __linux__
-#include <sys/prctl.h>
-#endif
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
 #include <sys/types.h>
 
 #include <deque>
-#include <tuple>
+#include <utility>
 
 #include <glog/logging.h>
 
+#include <process/async.hpp>
 #include <process/check.hpp>
-#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
-#include <process/io.hpp>
-#include <process/subprocess.hpp>
 
 #include <stout/check.hpp>
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
-#include <stout/numify.hpp>
 #include <stout/strings.hpp>
 #include <stout/path.hpp>
 
+#include <stout/os/close.hpp>
 #include <stout/os/exists.hpp>
-#include <stout/os/killtree.hpp>
 
 #include "common/protobuf_utils.hpp"
 
@@ -66,8 +68,6 @@ namespace slave {
 
 Try<Isolator*> PosixDiskIsolatorProcess::create(const Flags& flags)
 {
-  // TODO(jieyu): Check the availability of command 'du'.
-
   return new MesosIsolator(process::Owned<MesosIsolatorProcess>(
         new PosixDiskIsolatorProcess(flags)));
 }
@@ -180,8 +180,9 @@ Future<Nothing> PosixDiskIsolatorProcess::update(
       // relative to the working directory of the executor. We always store
       // the absolute path.
       if (!path::absolute(path)) {
-        // We prepend "/" at the end to make sure that 'du' runs on actual
-        // directory pointed by the symlink (and not the symlink itself).
+        // We prepend "/" at the end to make sure that the usage is
+        // collected for the actual directory pointed by the symlink
+        // (and not the symlink itself).
         path = path::join(info->directory, path, "");
       }
     }
@@ -293,8 +294,8 @@ Future<ResourceStatistics> PosixDiskIsolatorProcess::usage(
 
     result.set_disk_limit_bytes(quota.get().bytes());
 
-    // NOTE: There may be a large delay (# of containers * interval)
-    // until an initial cached value is returned here!
+    // NOTE: There may be a delay of up to one interval until an
+    // initial cached value is returned here.
     if (info->paths[info->directory].lastUsage.isSome()) {
       result.set_disk_used_bytes(
           info->paths[info->directory].lastUsage.get().bytes());
@@ -319,6 +320,192 @@ Future<Nothing> PosixDiskIsolatorProcess::cleanup(
 }
 
 
+// Computes the disk usage rooted at a path the way 'du -s' does,
+// i.e., the blocks allocated to the path and everything below it,
+// without following symbolic links and counting hard links once.
+//
+// The listing of each directory is kept from one scan to the next.
+// The mtime of a directory changes whenever an entry is added to,
+// removed from, or renamed in it, so if its inode and mtime did not
+// change the entries are not read again. The sizes of the entries can
+// change without touching the directory though, so each entry is
+// still stat'ed on every scan.
+//
+// NOTE: This is not thread-safe, scans must not run concurrently.
+class DiskUsageScanner
+{
+public:
+  Try<Bytes> scan(const string& path)
+  {
+    // Listings of directories modified in the last couple of seconds
+    // are not kept, since an entry could be added within the
+    // granularity of the mtime of the directory after it was read.
+    now = ::time(NULL);
+
+    blocks = 0;
+    links.clear();
+
+    hashmap<string, Directory> previous;
+    std::swap(previous, directories);
+
+    // Like 'du', a symbolic link is only followed if it is the path
+    // itself and it has a trailing '/'.
+    struct stat s;
+    if (strings::endsWith(path, "/")) {
+      if (::stat(path.c_str(), &s) < 0) {
+        return ErrnoError("Failed to stat '" + path + "'");
+      }
+    } else if (::lstat(path.c_str(), &s) < 0) {
+      return ErrnoError("Failed to stat '" + path + "'");
+    }
+
+    if (!S_ISDIR(s.st_mode)) {
+      account(s);
+      return Bytes(blocks * 512);
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+      return ErrnoError("Failed to open '" + path + "'");
+    }
+
+    Try<Nothing> result = scan(fd, path, ".", s, previous);
+    os::close(fd);
+
+    if (result.isError()) {
+      return Error(result.error());
+    }
+
+    return Bytes(blocks * 512);
+  }
+
+private:
+  struct Directory
+  {
+    ino_t inode;
+    struct timespec mtime;
+    vector<string> entries;
+  };
+
+  // Adds the blocks allocated to a file, unless they were already
+  // added through another hard link to it.
+  void account(const struct stat& s)
+  {
+    if (!S_ISDIR(s.st_mode) && s.st_nlink > 1 &&
+        !links[s.st_dev].insert(s.st_ino).second) {
+      return;
+    }
+
+    blocks += s.st_blocks;
+  }
+
+  // Scans the directory open at 'fd', which is at 'relative' below
+  // the root 'path'.
+  Try<Nothing> scan(
+      int fd,
+      const string& path,
+      const string& relative,
+      const struct stat& s,
+      const hashmap<string, Directory>& previous)
+  {
+    account(s);
+
+    Directory directory;
+    directory.inode = s.st_ino;
+    directory.mtime = s.st_mtim;
+
+    if (previous.contains(relative) &&
+        previous.at(relative).inode == s.st_ino &&
+        previous.at(relative).mtime.tv_sec == s.st_mtim.tv_sec &&
+        previous.at(relative).mtime.tv_nsec == s.st_mtim.tv_nsec) {
+      directory.entries = previous.at(relative).entries;
+    } else {
+      int dup = ::dup(fd);
+      if (dup < 0) {
+        return ErrnoError(
+            "Failed to read '" + path::join(path, relative) + "'");
+      }
+
+      DIR* dir = ::fdopendir(dup);
+      if (dir == NULL) {
+        ErrnoError error(
+            "Failed to read '" + path::join(path, relative) + "'");
+        os::close(dup);
+        return error;
+      }
+
+      struct dirent* entry;
+      while ((entry = ::readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 &&
+            strcmp(entry->d_name, "..") != 0) {
+          directory.entries.push_back(entry->d_name);
+        }
+      }
+
+      ::closedir(dir);
+    }
+
+    foreach (const string& name, directory.entries) {
+      struct stat child;
+      if (::fstatat(fd, name.c_str(), &child, AT_SYMLINK_NOFOLLOW) < 0) {
+        // The entry may have been removed after it was listed.
+        if (errno == ENOENT) {
+          continue;
+        }
+
+        return ErrnoError(
+            "Failed to stat '" + path::join(path, relative, name) + "'");
+      }
+
+      if (!S_ISDIR(child.st_mode)) {
+        account(child);
+        continue;
+      }
+
+      int subdirectory = ::openat(
+          fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+      if (subdirectory < 0) {
+        if (errno == ENOENT) {
+          continue;
+        }
+
+        return ErrnoError(
+            "Failed to open '" + path::join(path, relative, name) + "'");
+      }
+
+      Try<Nothing> result = scan(
+          subdirectory,
+          path,
+          path::join(relative, name),
+          child,
+          previous);
+
+      os::close(subdirectory);
+
+      if (result.isError()) {
+        return result;
+      }
+    }
+
+    if (now - s.st_mtime >= 2) {
+      directories[relative] = directory;
+    }
+
+    return Nothing();
+  }
+
+  // Listings as of the last scan, keyed by the path of the directory
+  // relative to the scanned path.
+  hashmap<string, Directory> directories;
+
+  // The state of the current scan.
+  time_t now;
+  uint64_t blocks;
+  hashmap<dev_t, hashset<ino_t>> links;
+};
+
+
 class DiskUsageCollectorProcess : public Process<DiskUsageCollectorProcess>
 {
 public:
@@ -350,11 +537,9 @@ protected:
 
   void finalize()
   {
+    // NOTE: A scan in progress can not be interrupted, its result is
+    // dropped once it completes.
     foreach (const Owned<Entry>& entry, entries) {
-      if (entry->du.isSome() && entry->du.get().status().isPending()) {
-        os::killtree(entry->du.get().pid(), SIGKILL);
-      }
-
       entry->promise.fail("DiskUsageCollector is destroyed");
     }
   }
@@ -363,32 +548,18 @@ private:
   // Describe a single pending check.
   struct Entry
   {
-    explicit Entry(const string& _path) : path(_path) {}
+    explicit Entry(const string& _path) : path(_path), scanning(false) {}
 
     string path;
-    Option<Subprocess> du;
+    bool scanning;
     Promise<Bytes> promise;
   };
 
-  // This function is invoked right before each 'du' is exec'ed. Note
-  // that this function needs to be async signal safe.
-  static int setupChild()
-  {
-#ifdef __linux__
-    // Kill the child process if the parent exits.
-    // NOTE: This function should never returns non-zero because we
-    // are passing in a valid signal.
-    return ::prctl(PR_SET_PDEATHSIG, SIGKILL);
-#else
-    return 0;
-#endif
-  }
-
   void discard(const string& path)
   {
     for (auto it = entries.begin(); it != entries.end(); ++it) {
-      // We only cancel those checks whose 'du' haven't been launched.
-      if ((*it)->path == path && (*it)->du.isNone()) {
+      // We only cancel those checks which are not being scanned.
+      if ((*it)->path == path && !(*it)->scanning) {
         (*it)->promise.discard();
         entries.erase(it);
         break;
@@ -396,10 +567,16 @@ private:
     }
   }
 
-  // Schedule a 'du' to be invoked. The current implementation does
-  // not allow multiple 'du's running concurrently. The minimal
-  // interval between two subsequent 'du's is controlled by 'interval'
-  // for throttling purpose.
+  // Schedule a round of checks. All pending checks are scanned in one
+  // round, one after another, outside of this process so that it is
+  // not blocked on the file system. The minimal interval between two
+  // subsequent rounds is controlled by 'interval' for throttling
+  // purpose.
+  //
+  // NOTE: The scans are run in the slave's cgroup and it will be that
+  // cgroup that is charged for (a) memory to cache the fs data
+  // structures, (b) disk I/O to read those structures, and (c) the
+  // cpu time to traverse.
   void schedule()
   {
     if (entries.empty()) {
@@ -407,98 +584,62 @@ private:
       return;
     }
 
-    const Owned<Entry>& entry = entries.front();
-
-    // Invoke 'du' and report number of 1K-byte blocks. We fix the
-    // block size here so that we can get consistent results on all
-    // platforms (e.g., OS X uses 512 byte blocks).
-    //
-    // NOTE: The 'du' processes are run in the slave's cgroup and it
-    // will be that cgroup that is charged for (a) memory to cache the
-    // fs data structures, (b) disk I/O to read those structures, and
-    // (c) the cpu time to traverse.
-    Try<Subprocess> s = subprocess(
-        "du",
-        vector<string>({"du", "-k", "-s", entry->path}),
-        Subprocess::PATH("/dev/null"),
-        Subprocess::PIPE(),
-        Subprocess::PIPE(),
-        None(),
-        None(),
-        setupChild);
-
-    if (s.isError()) {
-      entry->promise.fail("Failed to exec 'du': " + s.error());
+    // Only keep the scanners of the paths still being checked, since
+    // each path is checked again as soon as its check completes.
+    hashmap<string, Owned<DiskUsageScanner>> scanners;
 
-      entries.pop_front();
-      delay(interval, self(), &Self::schedule);
-      return;
+    vector<string> paths;
+    vector<Owned<DiskUsageScanner>> round;
+
+    foreach (const Owned<Entry>& entry, entries) {
+      if (this->scanners.contains(entry->path)) {
+        scanners[entry->path] = this->scanners[entry->path];
+      } else {
+        scanners[entry->path] =
+          Owned<DiskUsageScanner>(new DiskUsageScanner());
+      }
+
+      entry->scanning = true;
+
+      paths.push_back(entry->path);
+      round.push_back(scanners[entry->path]);
     }
 
-    entry->du = s.get();
+    this->scanners = scanners;
 
-    await(s.get().status(),
-          io::read(s.get().out().get()),
-          io::read(s.get().err().get()))
-      .onAny(defer(self(), &Self::_schedule, lambda::_1));
+    async([paths, round]() {
+      vector<Try<Bytes>> results;
+      for (size_t i = 0; i < paths.size(); i++) {
+        results.push_back(round[i]->scan(paths[i]));
+      }
+      return results;
+    })
+    .onAny(defer(self(), &Self::_schedule, lambda::_1));
   }
 
-  void _schedule(const Future<std::tuple<
-      Future<Option<int>>,
-      Future<string>,
-      Future<string>>>& future)
+  void _schedule(const Future<vector<Try<Bytes>>>& future)
   {
     CHECK_READY(future);
-    CHECK(!entries.empty());
-
-    const Owned<Entry>& entry = entries.front();
-    CHECK_SOME(entry->du);
-
-    Future<Option<int>> status = std::get<0>(future.get());
-
-    if (!status.isReady()) {
-      entry->promise.fail(
-          "Failed to perform 'du': " +
-          (status.isFailed() ? status.failure() : "discarded"));
-    } else if (status.get().isNone()) {
-      entry->promise.fail("Failed to reap the status of 'du'");
-    } else if (status.get().get() != 0) {
-      Future<string> error = std::get<2>(future.get());
-      if (!error.isReady()) {
-        entry->promise.fail(
-            "Failed to perform 'du'. Reading stderr failed: " +
-            (error.isFailed() ? error.failure() : "discarded"));
-      } else {
-        entry->promise.fail("Failed to perform 'du': " + error.get());
-      }
-    } else {
-      Future<string> output = std::get<1>(future.get());
-      if (!output.isReady()) {
-        entry->promise.fail(
-            "Failed to read stdout from 'du': " +
-            (output.isFailed() ? output.failure() : "discarded"));
+
+    // The checks of the round are at the front of the queue, in the
+    // order they were scanned.
+    size_t i = 0;
+    while (!entries.empty() && entries.front()->scanning) {
+      CHECK_LT(i, future.get().size());
+
+      const Try<Bytes>& usage = future.get()[i++];
+      const Owned<Entry>& entry = entries.front();
+
+      if (usage.isError()) {
+        entry->promise.fail("Failed to check disk usage: " + usage.error());
       } else {
-        // Parsing the output from 'du'. The following is a sample
-        // output. Tab is used as the delimiter between the number of
-        // blocks and the checked path.
-        // $ du /var/lib/mesos/.../runs/container_id
-        // 1024   /var/lib/mesos/.../runs/container_id
-        vector<string> tokens = strings::tokenize(output.get(), " \t");
-        if (tokens.empty()) {
-          entry->promise.fail("Unexpected output from 'du': " + output.get());
-        } else {
-          Try<size_t> value = numify<size_t>(tokens[0]);
-          if (value.isError()) {
-            entry->promise.fail("Unexpected output from 'du': " + output.get());
-          } else {
-            // Notify the callers.
-            entry->promise.set(Kilobytes(value.get()));
-          }
-        }
+        // Notify the callers.
+        entry->promise.set(usage.get());
       }
+
+      entries.pop_front();
     }
 
-    entries.pop_front();
     delay(interval, self(), &Self::schedule);
   }
 
@@ -506,6 +647,10 @@ private:
 
   // A queue of pending checks.
   deque<Owned<Entry>> entries;
+
+  // The scanner of each path, which keeps the directory listings of
+  // the last scan of the path.
+  hashmap<string, Owned<DiskUsageScanner>> scanners;
 };
 
 
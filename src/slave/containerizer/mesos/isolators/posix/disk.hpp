@@ -39,7 +39,10 @@ class DiskUsageCollectorProcess;
 
 
 // Responsible for collecting disk usage for paths, while ensuring
-// that an interval elapses between each collection.
+// that an interval elapses between each round of collection. The
+// paths are scanned in-process, keeping the directory listings from
+// the previous scan of a path so that unchanged directories are not
+// read again.
 class DiskUsageCollector
 {
 public:
@@ -58,17 +61,12 @@ private:
 // This isolator monitors the disk usage for containers, and reports
 // ContainerLimitation when a container exceeds its disk quota. This
 // leverages the DiskUsageCollector to ensure that we don't induce too
-// much CPU usage and disk caching effects from running 'du' too
+// much CPU usage and disk caching effects from scanning the disk too
 // often.
 //
-// NOTE: Currently all containers are processed in the same queue,
-// which means that when a container starts, it could take many disk
-// collection intervals until any data is available in the resource
-// usage statistics!
-//
-// TODO(jieyu): Consider handling each container independently, or
-// triggering an initial collection when the container starts, to
-// ensure that we have usage statistics without a large delay.
+// NOTE: All containers are checked in each collection round, so when
+// a container starts, it could take up to one interval until any
+// data is available in the resource usage statistics.
 class PosixDiskIsolatorProcess : public MesosIsolatorProcess
 {
 public:
@@ -0,0 +1,442 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <list>
+#include <string>
+
+#include <glog/logging.h>
+
+#include <mesos/values.hpp>
+
+#include <process/async.hpp>
+#include <process/defer.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+
+#include "slave/paths.hpp"
+
+#include "slave/containerizer/mesos/isolators/xfs/disk.hpp"
+
+using namespace process;
+
+using std::list;
+using std::string;
+
+using mesos::slave::ContainerConfig;
+using mesos::slave::ContainerLaunchInfo;
+using mesos::slave::ContainerLimitation;
+using mesos::slave::ContainerState;
+using mesos::slave::Isolator;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+Try<Isolator*> XfsDiskIsolatorProcess::create(const Flags& flags)
+{
+  Try<bool> enabled = xfs::isQuotaEnabled(flags.work_dir);
+  if (enabled.isError()) {
+    return Error(
+        "Failed to check the project quotas of the work directory: " +
+        enabled.error());
+  } else if (!enabled.get()) {
+    return Error(
+        "Project quotas are not enabled on the filesystem of the work "
+        "directory, it needs to be mounted with 'prjquota'");
+  }
+
+  Try<string> device = xfs::getDevice(flags.work_dir);
+  if (device.isError()) {
+    return Error(device.error());
+  }
+
+  Try<Value> value = internal::values::parse(flags.xfs_project_range);
+  if (value.isError() || value.get().type() != Value::RANGES) {
+    return Error(
+        "Invalid '--xfs_project_range' '" + flags.xfs_project_range + "'");
+  }
+
+  IntervalSet<xfs::prid_t> projectIds;
+
+  foreach (const Value::Range& range, value.get().ranges().range()) {
+    // Project ID 0 means no project.
+    if (range.begin() == 0 || range.end() > UINT32_MAX) {
+      return Error(
+          "Invalid project IDs " + stringify(range.begin()) + "-" +
+          stringify(range.end()) + " in '--xfs_project_range'");
+    }
+
+    projectIds += (Bound<xfs::prid_t>::closed(range.begin()),
+                   Bound<xfs::prid_t>::closed(range.end()));
+  }
+
+  return new MesosIsolator(Owned<MesosIsolatorProcess>(
+      new XfsDiskIsolatorProcess(flags, device.get(), projectIds)));
+}
+
+
+XfsDiskIsolatorProcess::XfsDiskIsolatorProcess(
+    const Flags& _flags,
+    const string& _device,
+    const IntervalSet<xfs::prid_t>& _projectIds)
+  : flags(_flags),
+    device(_device),
+    projectIds(_projectIds),
+    freeProjectIds(_projectIds) {}
+
+
+Future<Nothing> XfsDiskIsolatorProcess::recover(
+    const list<ContainerState>& states,
+    const hashset<ContainerID>& orphans)
+{
+  foreach (const ContainerState& state, states) {
+    Result<xfs::prid_t> projectId = xfs::getProjectId(state.directory());
+    if (projectId.isError()) {
+      return Failure(
+          "Failed to get the project ID of the sandbox of container " +
+          stringify(state.container_id()) + ": " + projectId.error());
+    }
+
+    Option<xfs::prid_t> id;
+    if (projectId.isSome() && projectIds.contains(projectId.get())) {
+      id = projectId.get();
+      freeProjectIds -= id.get();
+    }
+
+    infos.put(
+        state.container_id(),
+        Owned<Info>(new Info(state.directory(), id)));
+  }
+
+  // Recover the project IDs of the persistent volumes, whether they
+  // are used by a container or not.
+  const string roles = path::join(flags.work_dir, "volumes", "roles");
+
+  if (os::exists(roles)) {
+    Try<list<string>> entries = os::ls(roles);
+    if (entries.isError()) {
+      return Failure("Failed to list '" + roles + "': " + entries.error());
+    }
+
+    foreach (const string& role, entries.get()) {
+      Try<list<string>> ids = os::ls(path::join(roles, role));
+      if (ids.isError()) {
+        return Failure("Failed to list the volumes of role '" + role + "': " +
+                       ids.error());
+      }
+
+      foreach (const string& id, ids.get()) {
+        const string volume =
+          paths::getPersistentVolumePath(flags.work_dir, role, id);
+
+        Result<xfs::prid_t> projectId = xfs::getProjectId(volume);
+        if (projectId.isError()) {
+          LOG(WARNING) << "Failed to get the project ID of persistent volume "
+                       << "'" << volume << "': " << projectId.error();
+          continue;
+        }
+
+        if (projectId.isSome() && projectIds.contains(projectId.get())) {
+          volumes[volume] = projectId.get();
+          freeProjectIds -= projectId.get();
+        }
+      }
+    }
+  }
+
+  // NOTE: The sandboxes of the orphans keep their project IDs, which
+  // are skipped when allocating since blocks are still accounted to
+  // them (see 'allocate').
+
+  return Nothing();
+}
+
+
+Future<Option<ContainerLaunchInfo>> XfsDiskIsolatorProcess::prepare(
+    const ContainerID& containerId,
+    const ContainerConfig& containerConfig)
+{
+  if (infos.contains(containerId)) {
+    return Failure("Container has already been prepared");
+  }
+
+  Option<xfs::prid_t> projectId = allocate();
+  if (projectId.isNone()) {
+    return Failure("Failed to allocate a project ID for the sandbox");
+  }
+
+  Try<Nothing> set =
+    xfs::setProjectId(containerConfig.directory(), projectId.get());
+
+  if (set.isError()) {
+    freeProjectIds += projectId.get();
+
+    return Failure(
+        "Failed to set the project ID of the sandbox: " + set.error());
+  }
+
+  LOG(INFO) << "Assigned project " << projectId.get() << " to the sandbox "
+            << "of container " << containerId;
+
+  infos.put(
+      containerId,
+      Owned<Info>(new Info(containerConfig.directory(), projectId)));
+
+  return None();
+}
+
+
+Future<Nothing> XfsDiskIsolatorProcess::isolate(
+    const ContainerID& containerId,
+    pid_t pid)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  return Nothing();
+}
+
+
+Future<ContainerLimitation> XfsDiskIsolatorProcess::watch(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  // NOTE: The limitation is never set, since the writes beyond the
+  // quota fail instead.
+  return infos[containerId]->limitation.future();
+}
+
+
+Future<Nothing> XfsDiskIsolatorProcess::update(
+    const ContainerID& containerId,
+    const Resources& resources)
+{
+  if (!infos.contains(containerId)) {
+    LOG(WARNING) << "Ignoring update for unknown container " << containerId;
+    return Nothing();
+  }
+
+  const Owned<Info>& info = infos[containerId];
+
+  // The disk resources used by the sandbox.
+  Resources sandbox;
+
+  foreach (const Resource& resource, resources) {
+    if (resource.name() != "disk") {
+      continue;
+    }
+
+    // The disk resources without a volume are used by the sandbox
+    // (see the 'posix/disk' isolator).
+    if (!resource.has_disk() || !resource.disk().has_volume()) {
+      sandbox += resource;
+      continue;
+    }
+
+    // Only the persistent volumes on the root disk are in the work
+    // directory (on the same filesystem).
+    if (!resource.disk().has_persistence() || resource.disk().has_source()) {
+      continue;
+    }
+
+    const string volume =
+      paths::getPersistentVolumePath(flags.work_dir, resource);
+
+    Try<xfs::prid_t> projectId = project(volume);
+    if (projectId.isError()) {
+      return Failure(
+          "Failed to assign a project to persistent volume '" + volume +
+          "': " + projectId.error());
+    }
+
+    Try<Nothing> set = xfs::setProjectQuota(
+        device,
+        projectId.get(),
+        Resources(resource).disk().get());
+
+    if (set.isError()) {
+      return Failure(
+          "Failed to set the quota of persistent volume '" + volume + "': " +
+          set.error());
+    }
+  }
+
+  if (info->projectId.isNone()) {
+    LOG(WARNING) << "Not limiting the disk usage of container " << containerId
+                 << " as its sandbox is not a project";
+    return Nothing();
+  }
+
+  const Bytes quota = sandbox.disk().getOrElse(Bytes(0));
+
+  if (info->quota == quota) {
+    return Nothing();
+  }
+
+  Try<Nothing> set =
+    xfs::setProjectQuota(device, info->projectId.get(), quota);
+
+  if (set.isError()) {
+    return Failure("Failed to set the quota of the sandbox: " + set.error());
+  }
+
+  LOG(INFO) << "Set the quota of the sandbox of container " << containerId
+            << " to " << quota;
+
+  info->quota = quota;
+
+  return Nothing();
+}
+
+
+Future<ResourceStatistics> XfsDiskIsolatorProcess::usage(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  ResourceStatistics result;
+
+  const Owned<Info>& info = infos[containerId];
+
+  if (info->projectId.isNone()) {
+    return result;
+  }
+
+  Try<Bytes> usage = xfs::getProjectUsage(device, info->projectId.get());
+  if (usage.isError()) {
+    return Failure("Failed to get the disk usage: " + usage.error());
+  }
+
+  result.set_disk_used_bytes(usage.get().bytes());
+
+  if (info->quota.isSome()) {
+    result.set_disk_limit_bytes(info->quota.get().bytes());
+  }
+
+  return result;
+}
+
+
+Future<Nothing> XfsDiskIsolatorProcess::cleanup(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    LOG(WARNING) << "Ignoring cleanup for unknown container " << containerId;
+    return Nothing();
+  }
+
+  const Owned<Info>& info = infos[containerId];
+
+  if (info->projectId.isNone()) {
+    infos.erase(containerId);
+    return Nothing();
+  }
+
+  // The files of the sandbox are removed from the project so that it
+  // can be used by another sandbox, which walks the sandbox.
+  return async(&xfs::clearProjectId, info->directory)
+    .then(defer(
+        PID<XfsDiskIsolatorProcess>(this),
+        &XfsDiskIsolatorProcess::_cleanup,
+        containerId,
+        lambda::_1));
+}
+
+
+Future<Nothing> XfsDiskIsolatorProcess::_cleanup(
+    const ContainerID& containerId,
+    const Try<Nothing>& clear)
+{
+  CHECK(infos.contains(containerId));
+
+  const xfs::prid_t projectId = infos[containerId]->projectId.get();
+
+  infos.erase(containerId);
+
+  if (clear.isError()) {
+    // The project ID is not reused, since the blocks of the sandbox
+    // would be accounted to the next sandbox.
+    LOG(WARNING) << "Failed to remove the sandbox of container "
+                 << containerId << " from project " << projectId << ": "
+                 << clear.error();
+    return Nothing();
+  }
+
+  Try<Nothing> set = xfs::setProjectQuota(device, projectId, Bytes(0));
+  if (set.isError()) {
+    LOG(WARNING) << "Failed to clear the quota of project " << projectId
+                 << ": " << set.error();
+  }
+
+  freeProjectIds += projectId;
+
+  return Nothing();
+}
+
+
+Option<xfs::prid_t> XfsDiskIsolatorProcess::allocate()
+{
+  while (!freeProjectIds.empty()) {
+    const xfs::prid_t projectId = freeProjectIds.begin()->lower();
+    freeProjectIds -= projectId;
+
+    Try<Bytes> usage = xfs::getProjectUsage(device, projectId);
+    if (usage.isSome() && usage.get() == Bytes(0)) {
+      return projectId;
+    }
+
+    LOG(WARNING) << "Skipping project " << projectId << " since "
+                 << (usage.isError() ? usage.error()
+                                     : "it still has blocks accounted to it");
+  }
+
+  return None();
+}
+
+
+Try<xfs::prid_t> XfsDiskIsolatorProcess::project(const string& volume)
+{
+  if (volumes.contains(volume)) {
+    return volumes[volume];
+  }
+
+  Option<xfs::prid_t> projectId = allocate();
+  if (projectId.isNone()) {
+    return Error("No project ID is available");
+  }
+
+  Try<Nothing> set = xfs::setProjectId(volume, projectId.get());
+  if (set.isError()) {
+    freeProjectIds += projectId.get();
+    return Error(set.error());
+  }
+
+  volumes[volume] = projectId.get();
+
+  return projectId.get();
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,137 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __XFS_DISK_ISOLATOR_HPP__
+#define __XFS_DISK_ISOLATOR_HPP__
+
+#include <string>
+
+#include <process/owned.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/interval.hpp>
+
+#include "slave/flags.hpp"
+
+#include "slave/containerizer/mesos/isolator.hpp"
+
+#include "slave/containerizer/mesos/isolators/xfs/utils.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// This isolator limits the disk usage of the sandboxes and of the
+// persistent volumes (on the root disk) with XFS project quotas. Each
+// sandbox and each persistent volume is a project with a hard limit
+// equal to its disk resources, so the filesystem accounts the blocks
+// allocated by the container as they are written, and fails the
+// writes beyond the limit (with EDQUOT) rather than the container
+// being killed after exceeding it, as with the 'posix/disk' isolator.
+// The usage is read with a single 'quotactl' call rather than by
+// scanning the files.
+//
+// NOTE: The work directory must be on XFS mounted with project quotas
+// ('prjquota'). The project IDs are taken from '--xfs_project_range'.
+class XfsDiskIsolatorProcess : public MesosIsolatorProcess
+{
+public:
+  static Try<mesos::slave::Isolator*> create(const Flags& flags);
+
+  virtual ~XfsDiskIsolatorProcess() {}
+
+  virtual process::Future<Nothing> recover(
+      const std::list<mesos::slave::ContainerState>& states,
+      const hashset<ContainerID>& orphans);
+
+  virtual process::Future<Option<mesos::slave::ContainerLaunchInfo>> prepare(
+      const ContainerID& containerId,
+      const mesos::slave::ContainerConfig& containerConfig);
+
+  virtual process::Future<Nothing> isolate(
+      const ContainerID& containerId,
+      pid_t pid);
+
+  virtual process::Future<mesos::slave::ContainerLimitation> watch(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> update(
+      const ContainerID& containerId,
+      const Resources& resources);
+
+  virtual process::Future<ResourceStatistics> usage(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> cleanup(
+      const ContainerID& containerId);
+
+private:
+  XfsDiskIsolatorProcess(
+      const Flags& flags,
+      const std::string& device,
+      const IntervalSet<xfs::prid_t>& projectIds);
+
+  process::Future<Nothing> _cleanup(
+      const ContainerID& containerId,
+      const Try<Nothing>& clear);
+
+  // Returns an unused project ID. The IDs which still have blocks
+  // accounted to them (e.g., by the sandbox of a container which was
+  // not cleaned up) are skipped.
+  Option<xfs::prid_t> allocate();
+
+  // Returns the project ID of the persistent volume, allocating one
+  // if it does not have one yet.
+  Try<xfs::prid_t> project(const std::string& volume);
+
+  const Flags flags;
+
+  // The device of the filesystem of the work directory.
+  const std::string device;
+
+  const IntervalSet<xfs::prid_t> projectIds;
+  IntervalSet<xfs::prid_t> freeProjectIds;
+
+  struct Info
+  {
+    Info(const std::string& _directory, const Option<xfs::prid_t>& _projectId)
+      : directory(_directory), projectId(_projectId) {}
+
+    const std::string directory;
+
+    // This is none for the containers which were launched before the
+    // isolator was enabled.
+    const Option<xfs::prid_t> projectId;
+
+    Option<Bytes> quota;
+
+    process::Promise<mesos::slave::ContainerLimitation> limitation;
+  };
+
+  hashmap<ContainerID, process::Owned<Info>> infos;
+
+  // The project IDs of the persistent volumes, which are kept when
+  // the containers using them terminate.
+  hashmap<std::string, xfs::prid_t> volumes;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __XFS_DISK_ISOLATOR_HPP__
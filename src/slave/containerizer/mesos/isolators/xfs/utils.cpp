@@ -0,0 +1,272 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <fts.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/dqblk_xfs.h>
+#include <linux/fs.h>
+
+#include <sys/ioctl.h>
+#include <sys/quota.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <string>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+
+#include "linux/fs.hpp"
+
+#include "slave/containerizer/mesos/isolators/xfs/utils.hpp"
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace xfs {
+
+// The quotas are in basic blocks of 512 bytes.
+static const uint64_t BASIC_BLOCK_SIZE = 512;
+
+
+Try<string> getDevice(const string& path)
+{
+  struct stat s;
+  if (::stat(path.c_str(), &s) != 0) {
+    return ErrnoError("Failed to stat '" + path + "'");
+  }
+
+  Try<fs::MountInfoTable> table = fs::MountInfoTable::read();
+  if (table.isError()) {
+    return Error("Failed to read the mount table: " + table.error());
+  }
+
+  foreach (const fs::MountInfoTable::Entry& entry, table.get().entries) {
+    if (entry.devno == s.st_dev) {
+      if (entry.type != "xfs") {
+        return Error(
+            "'" + path + "' is on a '" + entry.type + "' filesystem, not "
+            "on XFS");
+      }
+
+      return entry.source;
+    }
+  }
+
+  return Error("Failed to find the filesystem containing '" + path + "'");
+}
+
+
+// Sets the project ID of an open file, and whether the files created
+// in it inherit the project ID if it is a directory.
+static Try<Nothing> setProjectId(
+    int fd,
+    const string& path,
+    prid_t projectId,
+    bool directory)
+{
+  struct fsxattr attr;
+  if (::ioctl(fd, FS_IOC_FSGETXATTR, &attr) != 0) {
+    return ErrnoError("Failed to get the attributes of '" + path + "'");
+  }
+
+  attr.fsx_projid = projectId;
+
+  if (directory && projectId != 0) {
+    attr.fsx_xflags |= FS_XFLAG_PROJINHERIT;
+  } else {
+    attr.fsx_xflags &= ~FS_XFLAG_PROJINHERIT;
+  }
+
+  if (::ioctl(fd, FS_IOC_FSSETXATTR, &attr) != 0) {
+    return ErrnoError("Failed to set the attributes of '" + path + "'");
+  }
+
+  return Nothing();
+}
+
+
+Try<bool> isQuotaEnabled(const string& path)
+{
+  Try<string> device = getDevice(path);
+  if (device.isError()) {
+    return Error(device.error());
+  }
+
+  struct fs_quota_stat status;
+  if (::quotactl(
+          QCMD(Q_XGETQSTAT, XQM_PRJQUOTA),
+          device.get().c_str(),
+          0,
+          reinterpret_cast<caddr_t>(&status)) != 0) {
+    return ErrnoError(
+        "Failed to get the quota status of '" + device.get() + "'");
+  }
+
+  return (status.qs_flags & FS_QUOTA_PDQ_ACCT) &&
+         (status.qs_flags & FS_QUOTA_PDQ_ENFD);
+}
+
+
+Result<prid_t> getProjectId(const string& directory)
+{
+  int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1) {
+    return ErrnoError("Failed to open '" + directory + "'");
+  }
+
+  struct fsxattr attr;
+  if (::ioctl(fd, FS_IOC_FSGETXATTR, &attr) != 0) {
+    ErrnoError error("Failed to get the attributes of '" + directory + "'");
+    os::close(fd);
+    return error;
+  }
+
+  os::close(fd);
+
+  if (attr.fsx_projid == 0) {
+    return None();
+  }
+
+  return attr.fsx_projid;
+}
+
+
+Try<Nothing> setProjectId(const string& directory, prid_t projectId)
+{
+  char* paths[] = {const_cast<char*>(directory.c_str()), NULL};
+
+  FTS* tree = ::fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+  if (tree == NULL) {
+    return ErrnoError("Failed to open '" + directory + "'");
+  }
+
+  FTSENT* node;
+  while ((node = ::fts_read(tree)) != NULL) {
+    // Only the directories and the regular files are opened, since
+    // opening the other files (e.g., devices) may have side effects.
+    // The blocks used by the others (e.g., symbolic links) are
+    // negligible.
+    if (node->fts_info != FTS_D && node->fts_info != FTS_F) {
+      continue;
+    }
+
+    const bool isDirectory = node->fts_info == FTS_D;
+
+    int fd = ::open(
+        node->fts_path,
+        O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC |
+          (isDirectory ? O_DIRECTORY : 0));
+
+    if (fd == -1) {
+      ErrnoError error("Failed to open '" + string(node->fts_path) + "'");
+      ::fts_close(tree);
+      return error;
+    }
+
+    Try<Nothing> set = setProjectId(fd, node->fts_path, projectId, isDirectory);
+    os::close(fd);
+
+    if (set.isError()) {
+      ::fts_close(tree);
+      return set;
+    }
+  }
+
+  // 'fts_read' returns NULL with errno set to 0 at the end.
+  if (errno != 0) {
+    ErrnoError error("Failed to walk '" + directory + "'");
+    ::fts_close(tree);
+    return error;
+  }
+
+  ::fts_close(tree);
+
+  return Nothing();
+}
+
+
+Try<Nothing> clearProjectId(const string& directory)
+{
+  return setProjectId(directory, 0);
+}
+
+
+Try<Nothing> setProjectQuota(
+    const string& device,
+    prid_t projectId,
+    const Bytes& limit)
+{
+  struct fs_disk_quota quota;
+  memset(&quota, 0, sizeof(quota));
+
+  quota.d_version = FS_DQUOT_VERSION;
+  quota.d_flags = FS_PROJ_QUOTA;
+  quota.d_fieldmask = FS_DQ_BHARD;
+  quota.d_id = projectId;
+
+  // Round up, so that the limit is never lower than requested.
+  quota.d_blk_hardlimit =
+    (limit.bytes() + BASIC_BLOCK_SIZE - 1) / BASIC_BLOCK_SIZE;
+
+  if (::quotactl(
+          QCMD(Q_XSETQLIM, XQM_PRJQUOTA),
+          device.c_str(),
+          projectId,
+          reinterpret_cast<caddr_t>(&quota)) != 0) {
+    return ErrnoError(
+        "Failed to set the quota of project " + stringify(projectId) +
+        " on '" + device + "'");
+  }
+
+  return Nothing();
+}
+
+
+Try<Bytes> getProjectUsage(const string& device, prid_t projectId)
+{
+  struct fs_disk_quota quota;
+  memset(&quota, 0, sizeof(quota));
+
+  if (::quotactl(
+          QCMD(Q_XGETQUOTA, XQM_PRJQUOTA),
+          device.c_str(),
+          projectId,
+          reinterpret_cast<caddr_t>(&quota)) != 0) {
+    // There is no quota information until the project uses blocks
+    // or has a limit.
+    if (errno == ENOENT) {
+      return Bytes(0);
+    }
+
+    return ErrnoError(
+        "Failed to get the quota of project " + stringify(projectId) +
+        " on '" + device + "'");
+  }
+
+  return Bytes(quota.d_bcount * BASIC_BLOCK_SIZE);
+}
+
+} // namespace xfs {
+} // namespace internal {
+} // namespace mesos {
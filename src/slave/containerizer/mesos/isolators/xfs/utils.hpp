@@ -0,0 +1,88 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __XFS_UTILS_HPP__
+#define __XFS_UTILS_HPP__
+
+#include <stdint.h>
+
+#include <string>
+
+#include <stout/bytes.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/result.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace xfs {
+
+// Helpers for XFS project quotas. A project is a set of files (e.g.,
+// everything under a sandbox) tagged with the same project ID, and
+// the blocks used by all the files of a project are accounted by the
+// filesystem as they are allocated. Reading the usage of a project is
+// thus a single 'quotactl' call, and the filesystem makes the writes
+// fail with EDQUOT once the hard limit of the project is reached.
+//
+// NOTE: The filesystem needs to be mounted with the 'prjquota' (or
+// 'pquota') option.
+
+typedef uint32_t prid_t;
+
+
+// Returns the device of the XFS filesystem containing 'path', which
+// is needed for the quotas.
+Try<std::string> getDevice(const std::string& path);
+
+
+// Returns whether project quotas are accounted and enforced on the
+// XFS filesystem containing 'path'.
+Try<bool> isQuotaEnabled(const std::string& path);
+
+
+// Returns the project ID of the directory, or none if it does not
+// belong to a project.
+Result<prid_t> getProjectId(const std::string& directory);
+
+
+// Sets the project ID of the directory and of everything under it.
+// The directories are also marked so that the files created in them
+// later inherit the project ID.
+Try<Nothing> setProjectId(const std::string& directory, prid_t projectId);
+
+
+// Removes the directory and everything under it from its project.
+Try<Nothing> clearProjectId(const std::string& directory);
+
+
+// Sets the hard limit of the blocks used by the project on the
+// filesystem of the device. A limit of zero means no limit.
+Try<Nothing> setProjectQuota(
+    const std::string& device,
+    prid_t projectId,
+    const Bytes& limit);
+
+
+// Returns the blocks used by the project on the filesystem of the
+// device.
+Try<Bytes> getProjectUsage(const std::string& device, prid_t projectId);
+
+} // namespace xfs {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __XFS_UTILS_HPP__
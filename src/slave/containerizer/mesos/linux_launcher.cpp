@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fcntl.h>
 #include <sched.h>
 #include <unistd.h>
 
@@ -321,6 +322,40 @@ static int childSetup(
 }
 
 
+// Moves the child into the cgroups of its container, from within the
+// child, by writing 0 (i.e., the writing process) to the 'cgroup.procs'
+// of each of them. Since the parent does not have to wait for the
+// child to exec (or contain it afterwards), the child can share the
+// address space of the parent until then, which avoids copying the
+// page tables of the slave (which is slow for a large slave). Note
+// that this function has to be async signal safe.
+static int childJoin(const vector<string>& procs)
+{
+  for (size_t i = 0; i < procs.size(); i++) {
+    int fd = ::open(procs[i].c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
+      return 1;
+    }
+
+    ssize_t length;
+    while ((length = ::write(fd, "0", 1)) == -1 && errno == EINTR);
+
+    ::close(fd);
+
+    if (length != 1) {
+      return 1;
+    }
+  }
+
+  // See the comment in 'childSetup' above.
+  if (::setsid() == -1) {
+    return 1;
+  }
+
+  return 0;
+}
+
+
 Try<pid_t> LinuxLauncher::fork(
     const ContainerID& containerId,
     const string& path,
@@ -349,6 +384,52 @@ Try<pid_t> LinuxLauncher::fork(
     }
   }
 
+  int cloneFlags = namespaces.isSome() ? namespaces.get() : 0;
+  cloneFlags |= SIGCHLD; // Specify SIGCHLD as child termination signal.
+
+  // Without a 'setup' function, all the child does before exec'ing is
+  // async signal safe, so it is cloned with CLONE_VM | CLONE_VFORK
+  // (like 'posix_spawn' does) and joins its cgroups itself. If it
+  // fails to do so, it exits before exec'ing.
+  if (setup.isNone()) {
+    vector<string> procs;
+    procs.push_back(
+        path::join(freezerHierarchy, cgroup(containerId), "cgroup.procs"));
+
+    if (systemdHierarchy.isSome()) {
+      procs.push_back(path::join(
+          systemdHierarchy.get(),
+          SYSTEMD_MESOS_EXECUTORS_SLICE,
+          "cgroup.procs"));
+    }
+
+    cloneFlags |= CLONE_VM | CLONE_VFORK;
+
+    LOG(INFO) << "Cloning child process with flags = "
+              << ns::stringify(cloneFlags);
+
+    Try<Subprocess> child = subprocess(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        lambda::bind(&childJoin, procs),
+        lambda::bind(&os::clone, lambda::_1, cloneFlags));
+
+    if (child.isError()) {
+      return Error("Failed to clone child process: " + child.error());
+    }
+
+    if (!pids.contains(containerId)) {
+      pids.put(containerId, child.get().pid());
+    }
+
+    return child.get().pid();
+  }
+
   // Use a pipe to block the child until it's been moved into the
   // freezer cgroup.
   int pipes[2];
@@ -357,9 +438,6 @@ Try<pid_t> LinuxLauncher::fork(
   // use CHECK.
   CHECK_EQ(0, ::pipe(pipes));
 
-  int cloneFlags = namespaces.isSome() ? namespaces.get() : 0;
-  cloneFlags |= SIGCHLD; // Specify SIGCHLD as child termination signal.
-
   LOG(INFO) << "Cloning child process with flags = "
             << ns::stringify(cloneFlags);
 
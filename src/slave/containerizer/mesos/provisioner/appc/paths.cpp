@@ -37,6 +37,12 @@ string getStagingDir(const string& storeDir)
 }
 
 
+string getIndexPath(const string& storeDir)
+{
+  return path::join(storeDir, "index");
+}
+
+
 string getImagesDir(const string& storeDir)
 {
   return path::join(storeDir, "images");
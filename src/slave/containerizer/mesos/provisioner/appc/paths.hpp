@@ -34,21 +34,24 @@ namespace paths {
 //
 // <store_dir> ('--appc_store_dir' flag)
 // |--staging (contains temp directories for staging downloads)
+// |  |--<temp_dir>
+// |     |--<image_file> (the fetched image archive)
+// |     |--<image_id> (the extracted image, moved to 'images')
 // |
 // |--images (stores validated images)
-//    |--<image_id> (in the form of "sha512-<128_character_hash_sum>")
-//       |--manifest
-//       |--rootfs
-//          |--... (according to the ACI spec)
-//
-// TODO(xujyan): The staging directory is unused for now (it's
-// externally managed) but implemented to illustrate the need for a
-// separate 'images' directory. Complete the layout diagram when the
-// staging directory is utilized by the provisioner.
+// |  |--<image_id> (in the form of "sha512-<128_character_hash_sum>")
+// |     |--manifest
+// |     |--rootfs
+// |        |--... (according to the ACI spec)
+// |
+// |--index (the ids and manifests of the images in 'images')
 
 std::string getStagingDir(const std::string& storeDir);
 
 
+std::string getIndexPath(const std::string& storeDir);
+
+
 std::string getImagesDir(const std::string& storeDir);
 
 
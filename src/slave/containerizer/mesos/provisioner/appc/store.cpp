@@ -14,26 +14,49 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <deque>
+#include <functional>
 #include <list>
+#include <tuple>
 
 #include <glog/logging.h>
 
+#include <mesos/uri/fetcher.hpp>
+
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
+#include <process/http.hpp>
+#include <process/io.hpp>
+#include <process/subprocess.hpp>
 
 #include <stout/check.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/strings.hpp>
+
+#include "common/status_utils.hpp"
+
+#include "slave/state.hpp"
 
 #include "slave/containerizer/mesos/provisioner/appc/paths.hpp"
 #include "slave/containerizer/mesos/provisioner/appc/spec.hpp"
 #include "slave/containerizer/mesos/provisioner/appc/store.hpp"
 
+#include "uri/fetcher.hpp"
+
+#include "uri/utils.hpp"
+
 using namespace process;
 
+using std::deque;
+using std::function;
 using std::list;
 using std::string;
+using std::tuple;
 using std::vector;
 
 namespace mesos {
@@ -46,6 +69,12 @@ struct CachedImage
 {
   static Try<CachedImage> create(const string& imagePath);
 
+  // Creates the image with the given manifest rather than the one in
+  // the image, e.g., when it has been read from the index.
+  static Try<CachedImage> create(
+      const string& imagePath,
+      const AppcImageManifest& manifest);
+
   CachedImage(
       const AppcImageManifest& _manifest,
       const string& _id,
@@ -70,6 +99,24 @@ struct CachedImage
 
 
 Try<CachedImage> CachedImage::create(const string& imagePath)
+{
+  Try<string> read = os::read(paths::getImageManifestPath(imagePath));
+  if (read.isError()) {
+    return Error("Failed to read manifest: " + read.error());
+  }
+
+  Try<AppcImageManifest> manifest = spec::parse(read.get());
+  if (manifest.isError()) {
+    return Error("Failed to parse manifest: " + manifest.error());
+  }
+
+  return create(imagePath, manifest.get());
+}
+
+
+Try<CachedImage> CachedImage::create(
+    const string& imagePath,
+    const AppcImageManifest& manifest)
 {
   Option<Error> error = spec::validateLayout(imagePath);
   if (error.isSome()) {
@@ -83,17 +130,7 @@ Try<CachedImage> CachedImage::create(const string& imagePath)
     return Error("Invalid image ID: " + error.get().message);
   }
 
-  Try<string> read = os::read(paths::getImageManifestPath(imagePath));
-  if (read.isError()) {
-    return Error("Failed to read manifest: " + read.error());
-  }
-
-  Try<AppcImageManifest> manifest = spec::parse(read.get());
-  if (manifest.isError()) {
-    return Error("Failed to parse manifest: " + manifest.error());
-  }
-
-  return CachedImage(manifest.get(), imageId, imagePath);
+  return CachedImage(manifest, imageId, imagePath);
 }
 
 
@@ -139,10 +176,191 @@ static bool matches(Image::Appc requirements, const CachedImage& candidate)
 }
 
 
+// Returns the URI of the image using the simple discovery of the
+// App Container spec, i.e., '<prefix><name>-<version>-<os>-<arch>.aci'.
+static Try<URI> discover(const string& prefix, const Image::Appc& appc)
+{
+  hashmap<string, string> labels;
+  labels["version"] = "latest";
+  labels["os"] = "linux";
+  labels["arch"] = "amd64";
+
+  foreach (const Label& label, appc.labels().labels()) {
+    labels[label.key()] = label.value();
+  }
+
+  const string url =
+    prefix + appc.name() + "-" + labels["version"] + "-" +
+    labels["os"] + "-" + labels["arch"] + ".aci";
+
+  Try<http::URL> parse = http::URL::parse(url);
+  if (parse.isError()) {
+    return Error("Failed to parse URL '" + url + "': " + parse.error());
+  }
+
+  const http::URL& _url = parse.get();
+
+  CHECK_SOME(_url.scheme);
+
+  return uri::construct(
+      _url.scheme.get(),
+      _url.path,
+      _url.domain.isSome() ? _url.domain.get() : stringify(_url.ip.get()),
+      _url.port.isSome() ? Option<int>(_url.port.get()) : None());
+}
+
+
+// Returns the standard output of the subprocess, or a failure with
+// its standard error if it does not exit successfully.
+static Future<string> execute(const string& command, const Try<Subprocess>& s)
+{
+  if (s.isError()) {
+    return Failure("Failed to exec '" + command + "': " + s.error());
+  }
+
+  return await(
+      s.get().status(),
+      io::read(s.get().out().get()),
+      io::read(s.get().err().get()))
+    .then([command](const tuple<
+        Future<Option<int>>,
+        Future<string>,
+        Future<string>>& t) -> Future<string> {
+      Future<Option<int>> status = std::get<0>(t);
+      if (!status.isReady()) {
+        return Failure(
+            "Failed to get the exit status of '" + command + "': " +
+            (status.isFailed() ? status.failure() : "discarded"));
+      }
+
+      if (status->isNone()) {
+        return Failure("Failed to reap '" + command + "'");
+      }
+
+      if (status->get() != 0) {
+        Future<string> error = std::get<2>(t);
+        return Failure(
+            "Failed to run '" + command + "': " +
+            WSTRINGIFY(status->get()) +
+            (error.isReady() ? ": " + error.get() : ""));
+      }
+
+      Future<string> output = std::get<1>(t);
+      if (!output.isReady()) {
+        return Failure(
+            "Failed to read the output of '" + command + "': " +
+            (output.isFailed() ? output.failure() : "discarded"));
+      }
+
+      return output.get();
+    });
+}
+
+
+// Returns the image ID of the image archive, i.e., the sha512 digest
+// of the uncompressed tarball.
+static Future<string> digest(const string& file)
+{
+  const string command = "gzip -dcf | sha512sum";
+
+  Try<Subprocess> s = subprocess(
+      command,
+      Subprocess::PATH(file),
+      Subprocess::PIPE(),
+      Subprocess::PIPE());
+
+  return execute(command, s)
+    .then([file](const string& output) -> Future<string> {
+      vector<string> tokens = strings::tokenize(output, " ");
+      if (tokens.empty()) {
+        return Failure("Failed to compute the digest of '" + file + "'");
+      }
+
+      const string imageId = "sha512-" + tokens[0];
+
+      Option<Error> error = spec::validateImageID(imageId);
+      if (error.isSome()) {
+        return Failure("Invalid image ID: " + error.get().message);
+      }
+
+      return imageId;
+    });
+}
+
+
+static Future<Nothing> extract(const string& file, const string& directory)
+{
+  const vector<string> argv = {"tar", "-C", directory, "-x", "-f", file};
+
+  Try<Subprocess> s = subprocess(
+      "tar",
+      argv,
+      Subprocess::PATH("/dev/null"),
+      Subprocess::PIPE(),
+      Subprocess::PIPE());
+
+  return execute(strings::join(" ", argv), s)
+    .then([]() { return Nothing(); });
+}
+
+
+// Reads the index of the store, mapping image IDs to the manifests
+// of the images.
+static Try<hashmap<string, AppcImageManifest>> readIndex(const string& path)
+{
+  Try<string> read = os::read(path);
+  if (read.isError()) {
+    return Error("Failed to read '" + path + "': " + read.error());
+  }
+
+  Try<JSON::Object> json = JSON::parse<JSON::Object>(read.get());
+  if (json.isError()) {
+    return Error("Failed to parse '" + path + "': " + json.error());
+  }
+
+  Result<JSON::Array> images = json.get().find<JSON::Array>("images");
+  if (!images.isSome()) {
+    return Error("Failed to find the images in '" + path + "'");
+  }
+
+  hashmap<string, AppcImageManifest> index;
+
+  foreach (const JSON::Value& value, images.get().values) {
+    if (!value.is<JSON::Object>()) {
+      return Error("Unexpected image in '" + path + "'");
+    }
+
+    const JSON::Object& image = value.as<JSON::Object>();
+
+    Result<JSON::String> id = image.find<JSON::String>("id");
+    Result<JSON::Object> manifest = image.find<JSON::Object>("manifest");
+
+    if (!id.isSome() || !manifest.isSome()) {
+      return Error("Malformed image in '" + path + "'");
+    }
+
+    Try<AppcImageManifest> parse = spec::parse(stringify(manifest.get()));
+    if (parse.isError()) {
+      return Error(
+          "Failed to parse the manifest of image '" + id.get().value +
+          "': " + parse.error());
+    }
+
+    index.put(id.get().value, parse.get());
+  }
+
+  return index;
+}
+
+
 class StoreProcess : public Process<StoreProcess>
 {
 public:
-  StoreProcess(const string& rootDir);
+  StoreProcess(
+      const string& rootDir,
+      const Option<string>& discoveryUriPrefix,
+      const Owned<uri::Fetcher>& fetcher,
+      size_t maxFetches);
 
   ~StoreProcess() {}
 
@@ -151,12 +369,47 @@ public:
   Future<ImageInfo> get(const Image& image);
 
 private:
+  // Returns the first image in the store matching the requirements.
+  Option<CachedImage> find(const Image::Appc& appc);
+
+  // Fetches the image at the discovered URI into the store unless it
+  // is being fetched already, and returns its image ID.
+  Future<string> fetch(const Image::Appc& appc);
+
+  Future<string> _fetch(const URI& uri, const Image::Appc& appc);
+
+  // Extracts, validates and moves the fetched image into the store.
+  Future<string> __fetch(
+      const string& staging,
+      const string& file,
+      const string& imageId,
+      const Image::Appc& appc);
+
+  // Starts queued fetches as long as fewer than the maximum number of
+  // fetches are in progress.
+  void startFetches();
+
+  // Writes out the index of the images in the store.
+  Try<Nothing> persist();
+
   // Absolute path to the root directory of the store as defined by
   // --appc_store_dir.
   const string rootDir;
 
+  const Option<string> discoveryUriPrefix;
+  Owned<uri::Fetcher> fetcher;
+  const size_t maxFetches;
+
   // Mappings: name -> id -> image.
   hashmap<string, hashmap<string, CachedImage>> images;
+
+  // Fetches in progress, keyed by URI.
+  hashmap<string, Owned<Promise<string>>> fetching;
+
+  // Fetches waiting for one of the fetches in progress to complete,
+  // and the number of fetches in progress.
+  deque<function<void()>> queuedFetches;
+  size_t fetches;
 };
 
 
@@ -167,6 +420,25 @@ Try<Owned<slave::Store>> Store::create(const Flags& flags)
     return Error("Failed to create the images directory: " + mkdir.error());
   }
 
+  mkdir = os::mkdir(paths::getStagingDir(flags.appc_store_dir));
+  if (mkdir.isError()) {
+    return Error("Failed to create the staging directory: " + mkdir.error());
+  }
+
+  if (flags.appc_store_max_fetches == 0) {
+    return Error("The maximum number of fetches must be positive");
+  }
+
+  Owned<uri::Fetcher> fetcher;
+  if (flags.appc_simple_discovery_uri_prefix.isSome()) {
+    Try<Owned<uri::Fetcher>> create = uri::fetcher::create();
+    if (create.isError()) {
+      return Error("Failed to create the URI fetcher: " + create.error());
+    }
+
+    fetcher = create.get();
+  }
+
   // Make sure the root path is canonical so all image paths derived
   // from it are canonical too.
   Result<string> rootDir = os::realpath(flags.appc_store_dir);
@@ -181,7 +453,11 @@ Try<Owned<slave::Store>> Store::create(const Flags& flags)
   }
 
   return Owned<slave::Store>(new Store(
-      Owned<StoreProcess>(new StoreProcess(rootDir.get()))));
+      Owned<StoreProcess>(new StoreProcess(
+          rootDir.get(),
+          flags.appc_simple_discovery_uri_prefix,
+          fetcher,
+          flags.appc_store_max_fetches))));
 }
 
 
@@ -211,11 +487,37 @@ Future<ImageInfo> Store::get(const Image& image)
 }
 
 
-StoreProcess::StoreProcess(const string& _rootDir) : rootDir(_rootDir) {}
+StoreProcess::StoreProcess(
+    const string& _rootDir,
+    const Option<string>& _discoveryUriPrefix,
+    const Owned<uri::Fetcher>& _fetcher,
+    size_t _maxFetches)
+  : rootDir(_rootDir),
+    discoveryUriPrefix(_discoveryUriPrefix),
+    fetcher(_fetcher),
+    maxFetches(_maxFetches),
+    fetches(0) {}
 
 
 Future<Nothing> StoreProcess::recover()
 {
+  // The index holds the manifests of the images in the store so that
+  // they do not have to be read and parsed again. Images not in the
+  // index, e.g., because it is missing, are recovered from their
+  // manifests and added to the index.
+  hashmap<string, AppcImageManifest> index;
+
+  const string indexPath = paths::getIndexPath(rootDir);
+  if (os::exists(indexPath)) {
+    Try<hashmap<string, AppcImageManifest>> read = readIndex(indexPath);
+    if (read.isError()) {
+      LOG(WARNING) << "Failed to read the index of the store, recovering "
+                   << "images from their manifests: " << read.error();
+    } else {
+      index = read.get();
+    }
+  }
+
   // Recover everything in the store.
   Try<list<string>> imageIds = os::ls(paths::getImagesDir(rootDir));
   if (imageIds.isError()) {
@@ -225,6 +527,8 @@ Future<Nothing> StoreProcess::recover()
         imageIds.error());
   }
 
+  size_t indexed = 0;
+
   foreach (const string& imageId, imageIds.get()) {
     string path = paths::getImagePath(rootDir, imageId);
     if (!os::stat::isdir(path)) {
@@ -232,17 +536,37 @@ Future<Nothing> StoreProcess::recover()
       continue;
     }
 
-    Try<CachedImage> image = CachedImage::create(path);
+    Try<CachedImage> image = index.contains(imageId)
+      ? CachedImage::create(path, index.at(imageId))
+      : CachedImage::create(path);
+
     if (image.isError()) {
       LOG(WARNING) << "Unexpected entry in storage: " << image.error();
       continue;
     }
 
+    if (index.contains(imageId)) {
+      indexed++;
+    }
+
     LOG(INFO) << "Restored image '" << image.get().manifest.name() << "'";
 
     images[image.get().manifest.name()].put(image.get().id, image.get());
   }
 
+  size_t restored = 0;
+  foreachvalue (const auto& ids, images) {
+    restored += ids.size();
+  }
+
+  if (indexed != restored || indexed != index.size()) {
+    Try<Nothing> persist = this->persist();
+    if (persist.isError()) {
+      LOG(WARNING) << "Failed to write the index of the store: "
+                   << persist.error();
+    }
+  }
+
   return Nothing();
 }
 
@@ -253,35 +577,228 @@ Future<ImageInfo> StoreProcess::get(const Image& image)
     return Failure("Not an Appc image: " + stringify(image.type()));
   }
 
-  const Image::Appc& appc = image.appc();
+  const Image::Appc appc = image.appc();
 
+  // TODO(gilbert): Get Appc runtime config from manifest.
+
+  // The Appc store current doesn't support dependencies and this
+  // is enforced by manifest validation: if the image's manifest
+  // contains dependencies it would fail the validation and
+  // wouldn't be stored in the store.
+  Option<CachedImage> candidate = find(appc);
+  if (candidate.isSome()) {
+    LOG(INFO) << "Found match for Appc image '" << appc.name()
+              << "' in the store";
+
+    return ImageInfo{vector<string>({candidate.get().rootfs()}), None()};
+  }
+
+  if (discoveryUriPrefix.isNone()) {
+    if (!images.contains(appc.name())) {
+      return Failure("No Appc image named '" + appc.name() + "' can be found");
+    }
+
+    return Failure("No Appc image named '" + appc.name() +
+                   "' can match the requirements");
+  }
+
+  return fetch(appc)
+    .then(defer(self(), [=](const string& imageId) -> Future<ImageInfo> {
+      Option<CachedImage> candidate = find(appc);
+      if (candidate.isNone()) {
+        return Failure(
+            "Fetched Appc image '" + imageId + "' does not match the "
+            "requirements of image '" + appc.name() + "'");
+      }
+
+      return ImageInfo{vector<string>({candidate.get().rootfs()}), None()};
+    }));
+}
+
+
+Option<CachedImage> StoreProcess::find(const Image::Appc& appc)
+{
   if (!images.contains(appc.name())) {
-    return Failure("No Appc image named '" + appc.name() + "' can be found");
+    return None();
   }
 
-  // Get local candidates.
-  vector<CachedImage> candidates;
   foreach (const CachedImage& candidate, images[appc.name()].values()) {
     // The first match is returned.
     // TODO(xujyan): Some tie-breaking rules are necessary.
     if (matches(appc, candidate)) {
-      LOG(INFO) << "Found match for Appc image '" << appc.name()
-                << "' in the store";
-
-      // TODO(gilbert): Get Appc runtime config from manifest.
-
-      // The Appc store current doesn't support dependencies and this
-      // is enforced by manifest validation: if the image's manifest
-      // contains dependencies it would fail the validation and
-      // wouldn't be stored in the store.
-      return ImageInfo{
-          vector<string>({candidate.rootfs()}),
-          None()};
+      return candidate;
+    }
+  }
+
+  return None();
+}
+
+
+Future<string> StoreProcess::fetch(const Image::Appc& appc)
+{
+  CHECK_SOME(discoveryUriPrefix);
+
+  Try<URI> uri = discover(discoveryUriPrefix.get(), appc);
+  if (uri.isError()) {
+    return Failure(
+        "Failed to discover Appc image '" + appc.name() + "': " +
+        uri.error());
+  }
+
+  const string key = stringify(uri.get());
+
+  if (fetching.contains(key)) {
+    VLOG(1) << "Fetch already in progress for Appc image '" << appc.name()
+            << "' from '" << key << "'";
+
+    return fetching[key]->future();
+  }
+
+  LOG(INFO) << "Fetching Appc image '" << appc.name() << "' from '"
+            << key << "'";
+
+  Owned<Promise<string>> promise(new Promise<string>());
+  fetching[key] = promise;
+
+  const URI _uri = uri.get();
+
+  queuedFetches.push_back([this, _uri, appc, key, promise]() {
+    promise->associate(
+        _fetch(_uri, appc)
+          .onAny(defer(self(), [this, key](const Future<string>&) {
+            fetching.erase(key);
+
+            --fetches;
+            startFetches();
+          })));
+  });
+
+  startFetches();
+
+  return promise->future();
+}
+
+
+void StoreProcess::startFetches()
+{
+  while (fetches < maxFetches && !queuedFetches.empty()) {
+    const function<void()> fetch = queuedFetches.front();
+    queuedFetches.pop_front();
+
+    ++fetches;
+    fetch();
+  }
+}
+
+
+Future<string> StoreProcess::_fetch(const URI& uri, const Image::Appc& appc)
+{
+  Try<string> staging =
+    os::mkdtemp(path::join(paths::getStagingDir(rootDir), "XXXXXX"));
+
+  if (staging.isError()) {
+    return Failure(
+        "Failed to create a staging directory: " + staging.error());
+  }
+
+  const string file = path::join(staging.get(), Path(uri.path()).basename());
+
+  return fetcher->fetch(uri, staging.get())
+    .then([file]() { return digest(file); })
+    .then(defer(self(), &Self::__fetch, staging.get(), file, lambda::_1, appc))
+    .onAny([staging]() {
+      Try<Nothing> rmdir = os::rmdir(staging.get());
+      if (rmdir.isError()) {
+        LOG(WARNING) << "Failed to remove staging directory: "
+                     << rmdir.error();
+      }
+    });
+}
+
+
+Future<string> StoreProcess::__fetch(
+    const string& staging,
+    const string& file,
+    const string& imageId,
+    const Image::Appc& appc)
+{
+  // The image ID is the checksum of the image.
+  if (appc.has_id() && appc.id() != imageId) {
+    return Failure(
+        "The checksum of Appc image '" + appc.name() + "' is '" + imageId +
+        "' rather than '" + appc.id() + "'");
+  }
+
+  // The image may have been fetched for other requirements already.
+  if (os::exists(paths::getImagePath(rootDir, imageId))) {
+    return imageId;
+  }
+
+  const string directory = path::join(staging, imageId);
+
+  Try<Nothing> mkdir = os::mkdir(directory);
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create directory '" + directory + "': " + mkdir.error());
+  }
+
+  return extract(file, directory)
+    .then(defer(self(), [=](const Nothing&) -> Future<string> {
+      Try<CachedImage> image = CachedImage::create(directory);
+      if (image.isError()) {
+        return Failure(
+            "Invalid Appc image '" + appc.name() + "': " + image.error());
+      }
+
+      const string path = paths::getImagePath(rootDir, imageId);
+
+      if (os::exists(path)) {
+        return imageId;
+      }
+
+      Try<Nothing> rename = os::rename(directory, path);
+      if (rename.isError()) {
+        return Failure(
+            "Failed to move Appc image '" + imageId + "' into the store: " +
+            rename.error());
+      }
+
+      const AppcImageManifest& manifest = image.get().manifest;
+      images[manifest.name()].put(
+          imageId,
+          CachedImage(manifest, imageId, path));
+
+      Try<Nothing> persist = this->persist();
+      if (persist.isError()) {
+        LOG(WARNING) << "Failed to write the index of the store: "
+                     << persist.error();
+      }
+
+      LOG(INFO) << "Stored Appc image '" << manifest.name() << "' as '"
+                << imageId << "'";
+
+      return imageId;
+    }));
+}
+
+
+Try<Nothing> StoreProcess::persist()
+{
+  JSON::Array array;
+
+  foreachvalue (const auto& ids, images) {
+    foreachvalue (const CachedImage& image, ids) {
+      JSON::Object object;
+      object.values["id"] = image.id;
+      object.values["manifest"] = JSON::protobuf(image.manifest);
+      array.values.push_back(object);
     }
   }
 
-  return Failure("No Appc image named '" + appc.name() +
-                 "' can match the requirements");
+  JSON::Object index;
+  index.values["images"] = array;
+
+  return state::checkpoint(paths::getIndexPath(rootDir), stringify(index));
 }
 
 } // namespace appc {
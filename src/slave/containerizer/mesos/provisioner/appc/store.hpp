@@ -37,9 +37,9 @@ public:
 
   virtual process::Future<Nothing> recover();
 
-  // TODO(xujyan): Fetching remotely is not implemented for now and
-  // until then the future fails directly if the image is not in the
-  // local cache.
+  // Images that are not in the store are fetched if
+  // '--appc_simple_discovery_uri_prefix' is set, otherwise the future
+  // fails directly.
   // TODO(xujyan): The store currently doesn't support images that
   // have dependencies and we should add it later.
   virtual process::Future<ImageInfo> get(const Image& image);
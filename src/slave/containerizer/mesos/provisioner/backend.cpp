@@ -22,6 +22,7 @@
 
 #include "slave/containerizer/mesos/provisioner/backends/bind.hpp"
 #include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
+#include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
 
 using namespace process;
 
@@ -37,6 +38,7 @@ hashmap<string, Owned<Backend>> Backend::create(const Flags& flags)
 
 #ifdef __linux__
   creators.put("bind", &BindBackend::create);
+  creators.put("overlay", &OverlayBackend::create);
 #endif // __linux__
   creators.put("copy", &CopyBackend::create);
 
@@ -0,0 +1,297 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <process/dispatch.hpp>
+#include <process/process.hpp>
+
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+
+#include "linux/fs.hpp"
+
+#include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
+
+using namespace process;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+class OverlayBackendProcess : public Process<OverlayBackendProcess>
+{
+public:
+  Future<Nothing> provision(const vector<string>& layers, const string& rootfs);
+
+  Future<bool> destroy(const string& rootfs);
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    process::metrics::Counter remove_rootfs_errors;
+  } metrics;
+};
+
+
+// Returns the directory holding the upper and work directories of
+// the given rootfs, i.e., '<backend>/scratch/<rootfs_id>' for the
+// rootfs '<backend>/rootfses/<rootfs_id>'.
+static string getScratchDir(const string& rootfs)
+{
+  return path::join(
+      Path(Path(rootfs).dirname()).dirname(),
+      "scratch",
+      Path(rootfs).basename());
+}
+
+
+Try<Owned<Backend>> OverlayBackend::create(const Flags&)
+{
+  Result<string> user = os::user();
+  if (!user.isSome()) {
+    return Error("Failed to determine user: " +
+                 (user.isError() ? user.error() : "username not found"));
+  }
+
+  if (user.get() != "root") {
+    return Error("OverlayBackend requires root privileges");
+  }
+
+  Try<string> filesystems = os::read("/proc/filesystems");
+  if (filesystems.isError()) {
+    return Error("Failed to read '/proc/filesystems': " + filesystems.error());
+  }
+
+  bool supported = false;
+  foreach (const string& line, strings::tokenize(filesystems.get(), "\n")) {
+    // Each line is the file system type, optionally preceded by
+    // 'nodev', e.g., "nodev\toverlay".
+    const vector<string> tokens = strings::tokenize(line, " \t");
+    if (!tokens.empty() && tokens.back() == "overlay") {
+      supported = true;
+      break;
+    }
+  }
+
+  if (!supported) {
+    return Error("Overlay filesystem is not supported by the kernel");
+  }
+
+  return Owned<Backend>(new OverlayBackend(
+      Owned<OverlayBackendProcess>(new OverlayBackendProcess())));
+}
+
+
+OverlayBackend::~OverlayBackend()
+{
+  terminate(process.get());
+  wait(process.get());
+}
+
+
+OverlayBackend::OverlayBackend(Owned<OverlayBackendProcess> _process)
+  : process(_process)
+{
+  spawn(CHECK_NOTNULL(process.get()));
+}
+
+
+Future<Nothing> OverlayBackend::provision(
+    const vector<string>& layers,
+    const string& rootfs)
+{
+  return dispatch(
+      process.get(), &OverlayBackendProcess::provision, layers, rootfs);
+}
+
+
+Future<bool> OverlayBackend::destroy(const string& rootfs)
+{
+  return dispatch(process.get(), &OverlayBackendProcess::destroy, rootfs);
+}
+
+
+Future<Nothing> OverlayBackendProcess::provision(
+    const vector<string>& layers,
+    const string& rootfs)
+{
+  if (layers.size() == 0) {
+    return Failure("No filesystem layer provided");
+  }
+
+  Try<Nothing> mkdir = os::mkdir(rootfs);
+  if (mkdir.isError()) {
+    return Failure("Failed to create container rootfs at " + rootfs);
+  }
+
+  const string scratchDir = getScratchDir(rootfs);
+  const string upperDir = path::join(scratchDir, "upperdir");
+  const string workDir = path::join(scratchDir, "workdir");
+
+  mkdir = os::mkdir(upperDir);
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create upper directory at '" + upperDir + "': " +
+        mkdir.error());
+  }
+
+  mkdir = os::mkdir(workDir);
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create work directory at '" + workDir + "': " +
+        mkdir.error());
+  }
+
+  // Later layers overwrite earlier ones, while overlayfs expects the
+  // topmost lower directory first.
+  const string options =
+    "lowerdir=" + strings::join(":", vector<string>(
+        layers.rbegin(), layers.rend())) +
+    ",upperdir=" + upperDir +
+    ",workdir=" + workDir;
+
+  // The kernel silently truncates mount options to a page.
+  if (options.size() >= (size_t) getpagesize()) {
+    return Failure(
+        "Too many layers (" + stringify(layers.size()) + ") to mount "
+        "them with overlayfs at '" + rootfs + "'");
+  }
+
+  Try<Nothing> mount = fs::mount(
+      "overlay",
+      rootfs,
+      "overlay",
+      0,
+      options);
+
+  if (mount.isError()) {
+    return Failure(
+        "Failed to mount rootfs '" + rootfs + "' with overlayfs: " +
+        mount.error());
+  }
+
+  // Mark the mount as shared+slave.
+  mount = fs::mount(
+      None(),
+      rootfs,
+      None(),
+      MS_SLAVE,
+      NULL);
+
+  if (mount.isError()) {
+    return Failure(
+        "Failed to mark mount '" + rootfs +
+        "' as a slave mount: " + mount.error());
+  }
+
+  mount = fs::mount(
+      None(),
+      rootfs,
+      None(),
+      MS_SHARED,
+      NULL);
+
+  if (mount.isError()) {
+    return Failure(
+        "Failed to mark mount '" + rootfs +
+        "' as a shared mount: " + mount.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<bool> OverlayBackendProcess::destroy(const string& rootfs)
+{
+  Try<fs::MountInfoTable> mountTable = fs::MountInfoTable::read();
+
+  if (mountTable.isError()) {
+    return Failure("Failed to read mount table: " + mountTable.error());
+  }
+
+  foreach (const fs::MountInfoTable::Entry& entry, mountTable.get().entries) {
+    if (entry.target == rootfs) {
+      // NOTE: This would fail if the rootfs is still in use.
+      Try<Nothing> unmount = fs::unmount(entry.target);
+      if (unmount.isError()) {
+        return Failure(
+            "Failed to destroy overlay-mounted rootfs '" + rootfs + "': " +
+            unmount.error());
+      }
+
+      // See the comment in BindBackendProcess::destroy() for why
+      // EBUSY is tolerated here.
+      if (::rmdir(rootfs.c_str()) != 0) {
+        string message =
+          "Failed to remove rootfs mount point '" + rootfs + "':" +
+          os::strerror(errno);
+
+        if (errno == EBUSY) {
+          LOG(ERROR) << message;
+          ++metrics.remove_rootfs_errors;
+        } else {
+          return Failure(message);
+        }
+      }
+
+      // The upper directory holds everything the container wrote
+      // into its rootfs.
+      const string scratchDir = getScratchDir(rootfs);
+      if (os::exists(scratchDir)) {
+        Try<Nothing> rmdir = os::rmdir(scratchDir);
+        if (rmdir.isError()) {
+          return Failure(
+              "Failed to remove scratch directory '" + scratchDir + "': " +
+              rmdir.error());
+        }
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+OverlayBackendProcess::Metrics::Metrics()
+  : remove_rootfs_errors(
+      "containerizer/mesos/provisioner/overlay/remove_rootfs_errors")
+{
+  process::metrics::add(remove_rootfs_errors);
+}
+
+
+OverlayBackendProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(remove_rootfs_errors);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
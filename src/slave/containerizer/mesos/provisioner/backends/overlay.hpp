@@ -0,0 +1,69 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __PROVISIONER_BACKENDS_OVERLAY_HPP__
+#define __PROVISIONER_BACKENDS_OVERLAY_HPP__
+
+#include "slave/containerizer/mesos/provisioner/backend.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class OverlayBackendProcess;
+
+
+// This backend uses overlayfs to stack all layers of the image (in
+// place, as they are kept by the store) as read-only lower
+// directories beneath a writable upper directory per rootfs. Thus
+// provisioning takes constant time, regardless of the image size,
+// and the layers' disk space is shared by all containers. NOTE:
+// 1) The kernel must support overlayfs with multiple lower
+//    directories (Linux 4.0 or later).
+// 2) The upper and work directories of a rootfs are kept outside the
+//    rootfs, in a 'scratch' directory next to the backend's
+//    'rootfses' directory, see 'provisioner/paths.hpp'.
+// 3) The number of layers is limited by the length of the mount
+//    options, which must fit into a page.
+class OverlayBackend : public Backend
+{
+public:
+  virtual ~OverlayBackend();
+
+  // OverlayBackend doesn't use any flag.
+  static Try<process::Owned<Backend>> create(const Flags&);
+
+  virtual process::Future<Nothing> provision(
+      const std::vector<std::string>& layers,
+      const std::string& rootfs);
+
+  virtual process::Future<bool> destroy(const std::string& rootfs);
+
+private:
+  explicit OverlayBackend(process::Owned<OverlayBackendProcess> process);
+
+  OverlayBackend(const OverlayBackend&); // Not copyable.
+  OverlayBackend& operator=(const OverlayBackend&); // Not assignable.
+
+  process::Owned<OverlayBackendProcess> process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __PROVISIONER_BACKENDS_OVERLAY_HPP__
@@ -62,7 +62,9 @@ public:
 
   Future<Option<Image>> get(const Image::Name& name);
 
-  // TODO(chenlily): Implement removal of unreferenced images.
+  Future<vector<Image>> images();
+
+  Future<Nothing> remove(const Image::Name& name);
 
 private:
   // Write out metadata manager state to persistent store.
@@ -123,6 +125,18 @@ Future<Option<Image>> MetadataManager::get(const Image::Name& name)
 }
 
 
+Future<vector<Image>> MetadataManager::images()
+{
+  return dispatch(process.get(), &MetadataManagerProcess::images);
+}
+
+
+Future<Nothing> MetadataManager::remove(const Image::Name& name)
+{
+  return dispatch(process.get(), &MetadataManagerProcess::remove, name);
+}
+
+
 Future<Image> MetadataManagerProcess::put(
     const Image::Name& name,
     const vector<string>& layerIds)
@@ -159,6 +173,32 @@ Future<Option<Image>> MetadataManagerProcess::get(
 }
 
 
+Future<vector<Image>> MetadataManagerProcess::images()
+{
+  vector<Image> images;
+  foreachvalue (const Image& image, storedImages) {
+    images.push_back(image);
+  }
+
+  return images;
+}
+
+
+Future<Nothing> MetadataManagerProcess::remove(const Image::Name& name)
+{
+  if (storedImages.erase(stringify(name)) == 0) {
+    return Nothing();
+  }
+
+  Try<Nothing> status = persist();
+  if (status.isError()) {
+    return Failure("Failed to save state of Docker images: " + status.error());
+  }
+
+  return Nothing();
+}
+
+
 Try<Nothing> MetadataManagerProcess::persist()
 {
   Images images;
@@ -49,8 +49,7 @@ class MetadataManagerProcess;
  * provisioner that are stored on disk. It keeps track of the layers
  * that Docker images are composed of and recovers Image objects
  * upon initialization by checking for dependent layers stored on disk.
- * Currently, image layers are stored indefinitely, with no garbage
- * collection of unreferenced image layers.
+ * Images are removed by the store when it garbage collects layers.
  */
 class MetadataManager
 {
@@ -86,6 +85,19 @@ public:
    */
   process::Future<Option<Image>> get(const Image::Name& name);
 
+  /**
+   * Retrieve all Images stored in memory.
+   */
+  process::Future<std::vector<Image>> images();
+
+  /**
+   * Remove an Image and persist the reference store state to disk.
+   * The layers of the Docker image are not removed.
+   *
+   * @param name  the name of the Docker image to remove
+   */
+  process::Future<Nothing> remove(const Image::Name& name);
+
 private:
   explicit MetadataManager(process::Owned<MetadataManagerProcess> process);
 
@@ -81,6 +81,9 @@ std::string getImageArchiveLayerRootfsPath(
   const std::string& layerId);
 
 
+std::string getImageLayersDir(const std::string& storeDir);
+
+
 std::string getImageLayerPath(
     const std::string& storeDir,
     const std::string& layerId);
@@ -69,7 +69,10 @@ Try<Owned<Puller>> Puller::create(const Flags& flags)
 }
 
 
-Future<Nothing> untar(const string& file, const string& directory)
+static Future<Nothing> _untar(
+    const string& file,
+    const string& directory,
+    const Subprocess::IO& in)
 {
   const vector<string> argv = {
     "tar",
@@ -83,7 +86,7 @@ Future<Nothing> untar(const string& file, const string& directory)
   Try<Subprocess> s = subprocess(
       "tar",
       argv,
-      Subprocess::PATH("/dev/null"),
+      in,
       Subprocess::PATH("/dev/null"),
       Subprocess::PIPE());
 
@@ -127,14 +130,20 @@ Future<Nothing> untar(const string& file, const string& directory)
 }
 
 
-Future<pair<string, string>> untarLayer(
-    const string& file,
-    const string& directory,
-    const string& layerId)
+Future<Nothing> untar(const string& file, const string& directory)
+{
+  return _untar(file, directory, Subprocess::PATH("/dev/null"));
+}
+
+
+Future<Nothing> untar(int fd, const string& directory)
+{
+  return _untar("-", directory, Subprocess::FD(fd));
+}
+
+
+Try<string> prepareLayerRootfs(const string& directory, const string& layerId)
 {
-  // We untar the layer from source into a directory, then move the layer
-  // into store. We do this instead of untarring directly to store to make
-  // sure we don't end up with partially untarred layer rootfs.
   const string localRootfsPath =
     paths::getImageArchiveLayerRootfsPath(directory, layerId);
 
@@ -147,7 +156,7 @@ Future<pair<string, string>> untarLayer(
 
     Try<Nothing> rmdir = os::rmdir(localRootfsPath);
     if (rmdir.isError()) {
-      return Failure(
+      return Error(
           "Failed to remove incomplete staged rootfs for layer "
           "'" + layerId + "': " + rmdir.error());
     }
@@ -155,13 +164,30 @@ Future<pair<string, string>> untarLayer(
 
   Try<Nothing> mkdir = os::mkdir(localRootfsPath);
   if (mkdir.isError()) {
-    return Failure(
+    return Error(
         "Failed to create rootfs path '" + localRootfsPath + "'"
         ": " + mkdir.error());
   }
 
+  return localRootfsPath;
+}
+
+
+Future<pair<string, string>> untarLayer(
+    const string& file,
+    const string& directory,
+    const string& layerId)
+{
+  // We untar the layer from source into a directory, then move the layer
+  // into store. We do this instead of untarring directly to store to make
+  // sure we don't end up with partially untarred layer rootfs.
+  Try<string> localRootfsPath = prepareLayerRootfs(directory, layerId);
+  if (localRootfsPath.isError()) {
+    return Failure(localRootfsPath.error());
+  }
+
   // The tar file will be removed when the staging directory is removed.
-  return untar(file, localRootfsPath)
+  return untar(file, localRootfsPath.get())
     .then([directory, layerId]() -> Future<pair<string, string>> {
       const string layerPath =
         paths::getImageArchiveLayerPath(directory, layerId);
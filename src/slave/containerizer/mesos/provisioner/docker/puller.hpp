@@ -58,6 +58,23 @@ public:
   virtual process::Future<std::list<std::pair<std::string, std::string>>> pull(
       const docker::Image::Name& name,
       const Path& directory) = 0;
+
+  /**
+   * Pulls a Docker image ahead of it being needed, like 'pull' does.
+   * Pullers may give such pulls a lower priority than other pulls.
+   *
+   * @param name The name of the image.
+   * @param directory The target directory to store the layers.
+   * @return list of layers maped to its local directory ordered by its
+   *         dependency.
+   */
+  virtual process::Future<std::list<std::pair<std::string, std::string>>>
+  prefetch(
+      const docker::Image::Name& name,
+      const Path& directory)
+  {
+    return pull(name, directory);
+  }
 };
 
 
@@ -72,6 +89,31 @@ process::Future<Nothing> untar(
     const std::string& directory);
 
 
+/**
+ * Untars(extracts) the tar stream read from the file descriptor
+ * (input param) to the given output directory, until the end of the
+ * stream. The file descriptor is duplicated, i.e., the caller keeps
+ * ownership of it.
+ *
+ * @param fd file descriptor to read the tar stream from.
+ * @param directory target directory for extracting the tar stream.
+ */
+process::Future<Nothing> untar(int fd, const std::string& directory);
+
+
+/**
+ * Prepares an empty rootfs directory for a layer in the staging
+ * directory, see 'untarLayer' below.
+ *
+ * @param directory staging directory.
+ * @param layerId the id of the layer.
+ * @return path of the rootfs directory of the layer.
+ */
+Try<std::string> prepareLayerRootfs(
+    const std::string& directory,
+    const std::string& layerId);
+
+
 /**
  * Untars a tarred layer changeset into staging directory with the
  * directory structure:
@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <list>
 #include <vector>
 #include <ostream>
 
@@ -27,6 +28,7 @@
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/numify.hpp>
 #include <stout/option.hpp>
@@ -75,6 +77,11 @@ public:
       const Option<string>& digest,
       const Path& filePath);
 
+  Future<size_t> streamBlob(
+      const Image::Name& imageName,
+      const Option<string>& digest,
+      int fd);
+
 private:
   RegistryClientProcess(
       const http::URL& registryServer,
@@ -86,7 +93,33 @@ private:
       const Option<http::Headers>& headers,
       bool isStreaming,
       bool resend,
-      const Option<string>& lastResponse) const;
+      const Option<string>& lastResponse);
+
+  // Sends a GET request over a connection to the server that is kept
+  // alive. An idle connection is reused if there is one, otherwise a
+  // new connection is opened.
+  Future<http::Response> send(
+      const http::URL& url,
+      const Option<http::Headers>& headers,
+      bool isStreaming);
+
+  Future<http::Response> _send(
+      uint64_t connectionId,
+      const string& server,
+      const http::Request& request,
+      bool isStreaming);
+
+  Future<uint64_t> connect(const http::URL& url);
+
+  // Marks the connection as idle once a response has been received
+  // completely, so that it can be reused for subsequent requests.
+  void release(uint64_t connectionId, const string& server);
+
+  // Returns the authorization headers for requests to the repository
+  // of the image, if a token was obtained for the registry already.
+  // This saves the '401 Unauthorized' round trip for every request.
+  Future<Option<http::Headers>> getAuthorizationHeaders(
+      const Image::Name& imageName);
 
   Try<http::Headers> getAuthenticationAttributes(
       const http::Response& httpResponse) const;
@@ -98,12 +131,12 @@ private:
   Future<http::Response> handleHttpUnauthResponse(
       const http::Response& httpResponse,
       const http::URL& url,
-      bool isStreaming) const;
+      bool isStreaming);
 
   Future<http::Response> handleHttpRedirect(
       const http::Response& httpResponse,
       const Option<http::Headers>& headers,
-      bool isStreaming) const;
+      bool isStreaming);
 
   Future<size_t> saveBlob(
       int fd,
@@ -117,6 +150,19 @@ private:
   Owned<TokenManager> tokenManager_;
   const Option<Credentials> credentials_;
 
+  // Open connections to the registry and blob servers, keyed by a
+  // connection id. Only ids are captured in callbacks so that the
+  // connections are never destroyed from their own execution context.
+  hashmap<uint64_t, http::Connection> connections_;
+  uint64_t nextConnectionId_;
+
+  // Ids of the idle connections, keyed by server ("scheme://host:port").
+  hashmap<string, std::list<uint64_t>> idleConnections_;
+
+  // The service the registry asks tokens to be requested for. It is
+  // learned from the first '401 Unauthorized' response.
+  Option<string> service_;
+
   RegistryClientProcess(const RegistryClientProcess&) = delete;
   RegistryClientProcess& operator = (const RegistryClientProcess&) = delete;
 };
@@ -191,6 +237,20 @@ Future<size_t> RegistryClient::getBlob(
 }
 
 
+Future<size_t> RegistryClient::getBlob(
+    const Image::Name& imageName,
+    const Option<string>& digest,
+    int fd)
+{
+  return dispatch(
+        process_.get(),
+        &RegistryClientProcess::streamBlob,
+        imageName,
+        digest,
+        fd);
+}
+
+
 Try<Owned<RegistryClientProcess>> RegistryClientProcess::create(
     const http::URL& registryServer,
     const http::URL& authorizationServer,
@@ -212,7 +272,8 @@ RegistryClientProcess::RegistryClientProcess(
     const Option<Credentials>& credentials)
   : registryServer_(registryServer),
     tokenManager_(tokenMgr),
-    credentials_(credentials) {}
+    credentials_(credentials),
+    nextConnectionId_(0) {}
 
 
 // RFC6750, section 3.
@@ -257,7 +318,7 @@ Try<http::Headers> RegistryClientProcess::getAuthenticationAttributes(
 Future<http::Response> RegistryClientProcess::handleHttpUnauthResponse(
     const http::Response& httpResponse,
     const http::URL& url,
-    bool isStreaming) const
+    bool isStreaming)
 {
   Try<http::Headers> authenticationAttributes =
     getAuthenticationAttributes(httpResponse);
@@ -280,6 +341,8 @@ Future<http::Response> RegistryClientProcess::handleHttpUnauthResponse(
         "from authorization server");
   }
 
+  service_ = authenticationAttributes.get().at("service");
+
   // TODO(jojy): Currently only handling TLS/cert authentication.
   Future<Token> tokenResponse = tokenManager_->getToken(
       authenticationAttributes.get().at("service"),
@@ -420,7 +483,7 @@ Future<string> RegistryClientProcess::handleHttpBadResponse(
 Future<http::Response> RegistryClientProcess::handleHttpRedirect(
     const http::Response& httpResponse,
     const Option<http::Headers>& headers,
-    bool isStreaming) const
+    bool isStreaming)
 {
   if (httpResponse.headers.find("Location") ==
       httpResponse.headers.end()) {
@@ -457,17 +520,9 @@ Future<http::Response> RegistryClientProcess::doHttpGet(
     const Option<http::Headers>& headers,
     bool isStreaming,
     bool resend,
-    const Option<string>& lastResponseStatus) const
+    const Option<string>& lastResponseStatus)
 {
-  Future<http::Response> response;
-
-  if (isStreaming) {
-    response = process::http::streaming::get(url, headers);
-  } else {
-    response = process::http::get(url, headers);
-  }
-
-  return response
+  return send(url, headers, isStreaming)
     .then(defer(self(), [=](const http::Response& httpResponse)
         -> Future<http::Response> {
       VLOG(1) << "Response status for url '" << url << "': "
@@ -514,6 +569,209 @@ Future<http::Response> RegistryClientProcess::doHttpGet(
 }
 
 
+// Forwards the data read from 'reader' to 'writer' until EOF, which
+// is left to the caller to forward. The data is read even if nobody
+// reads from 'writer' anymore.
+static Future<Nothing> forward(Pipe::Reader reader, Pipe::Writer writer)
+{
+  return reader.read()
+    .then([reader, writer](const string& data) mutable -> Future<Nothing> {
+      if (data.empty()) {
+        return Nothing();
+      }
+
+      writer.write(data);
+
+      return forward(reader, writer);
+    });
+}
+
+
+// Returns the "scheme://host:port" of the server at the URL.
+static string getServer(const http::URL& url)
+{
+  string host;
+  if (url.domain.isSome()) {
+    host = url.domain.get();
+  } else if (url.ip.isSome()) {
+    host = stringify(url.ip.get());
+  }
+
+  return url.scheme.getOrElse("http") + "://" + host + ":" +
+         stringify(url.port.getOrElse(0));
+}
+
+
+Future<http::Response> RegistryClientProcess::send(
+    const http::URL& url,
+    const Option<http::Headers>& headers,
+    bool isStreaming)
+{
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
+  request.keepAlive = true;
+
+  if (headers.isSome()) {
+    request.headers = headers.get();
+  }
+
+  const string server = getServer(url);
+
+  // Requests are not pipelined over an idle connection, so that
+  // concurrent blob downloads use separate connections.
+  while (idleConnections_.contains(server) &&
+         !idleConnections_[server].empty()) {
+    const uint64_t connectionId = idleConnections_[server].front();
+    idleConnections_[server].pop_front();
+
+    if (!connections_.contains(connectionId)) {
+      continue;
+    }
+
+    // The server may have closed the connection since it became
+    // idle, in which case the request is sent over a new connection.
+    return _send(connectionId, server, request, isStreaming)
+      .repair(defer(self(), [=](const Future<http::Response>& response) {
+        VLOG(1) << "Failed to reuse connection to '" << server << "': "
+                << response.failure();
+
+        return connect(url)
+          .then(defer(self(),
+                      &Self::_send,
+                      lambda::_1,
+                      server,
+                      request,
+                      isStreaming));
+      }));
+  }
+
+  return connect(url)
+    .then(defer(self(),
+                &Self::_send,
+                lambda::_1,
+                server,
+                request,
+                isStreaming));
+}
+
+
+Future<uint64_t> RegistryClientProcess::connect(const http::URL& url)
+{
+  const string server = getServer(url);
+
+  return http::connect(url)
+    .then(defer(self(), [=](http::Connection connection) -> uint64_t {
+      const uint64_t connectionId = nextConnectionId_++;
+
+      connection.disconnected()
+        .onAny(defer(self(), [=](const Future<Nothing>&) {
+          connections_.erase(connectionId);
+
+          if (idleConnections_.contains(server)) {
+            idleConnections_[server].remove(connectionId);
+          }
+        }));
+
+      connections_.put(connectionId, connection);
+
+      return connectionId;
+    }));
+}
+
+
+Future<http::Response> RegistryClientProcess::_send(
+    uint64_t connectionId,
+    const string& server,
+    const http::Request& request,
+    bool isStreaming)
+{
+  if (!connections_.contains(connectionId)) {
+    return Failure("Disconnected from '" + server + "'");
+  }
+
+  return connections_.at(connectionId).send(request, isStreaming)
+    .then(defer(self(), [=](const http::Response& response)
+        -> Future<http::Response> {
+      if (!isStreaming) {
+        release(connectionId, server);
+        return response;
+      }
+
+      if (response.reader.isNone()) {
+        return Failure("Failed to get streaming reader from response");
+      }
+
+      // The body of a streamed response is handed out through another
+      // pipe, to learn when it has been received and the connection
+      // can be reused.
+      Pipe pipe;
+      Pipe::Writer writer = pipe.writer();
+
+      http::Response streamed = response;
+      streamed.reader = pipe.reader();
+
+      forward(response.reader.get(), writer)
+        .onAny(defer(self(), [=](const Future<Nothing>& future) {
+          Pipe::Writer _writer = writer;
+
+          // The connection is released before EOF is forwarded, so
+          // that it is reused by requests following this one.
+          if (future.isReady()) {
+            release(connectionId, server);
+            _writer.close();
+          } else {
+            _writer.fail(future.isFailed() ? future.failure() : "discarded");
+          }
+        }));
+
+      return streamed;
+    }));
+}
+
+
+void RegistryClientProcess::release(
+    uint64_t connectionId,
+    const string& server)
+{
+  if (connections_.contains(connectionId)) {
+    idleConnections_[server].push_back(connectionId);
+  }
+}
+
+
+Future<Option<http::Headers>> RegistryClientProcess::getAuthorizationHeaders(
+    const Image::Name& imageName)
+{
+  if (service_.isNone()) {
+    return None();
+  }
+
+  // This is the scope the registry asks for pulls from a repository.
+  const string scope = "repository:" +
+    strings::remove(
+        getRepositoryPath(imageName),
+        getAPIVersion() + "/",
+        strings::PREFIX) +
+    ":pull";
+
+  return tokenManager_->getToken(service_.get(), scope, None())
+    .then([](const Token& token) -> Option<http::Headers> {
+      http::Headers headers = {{"Authorization", "Bearer " + token.raw}};
+      return headers;
+    })
+    .repair([](const Future<Option<http::Headers>>& headers)
+        -> Future<Option<http::Headers>> {
+      // The request is sent without a token, which is obtained once
+      // the registry responds with '401 Unauthorized'.
+      LOG(WARNING) << "Failed to get a token for the registry: "
+                   << headers.failure();
+
+      return Option<http::Headers>::none();
+    });
+}
+
+
 // TODO(tnachen): Support other Docker registry API versions.
 string RegistryClientProcess::getAPIVersion() const
 {
@@ -541,7 +799,10 @@ Future<spec::v2::ImageManifest> RegistryClientProcess::getManifest(
   manifestURL.path =
     getRepositoryPath(imageName) + "/manifests/" + imageName.tag();
 
-  return doHttpGet(manifestURL, None(), false, true, None())
+  return getAuthorizationHeaders(imageName)
+    .then(defer(self(), [=](const Option<http::Headers>& headers) {
+      return doHttpGet(manifestURL, headers, false, true, None());
+    }))
     .then(defer(self(), [this] (
         const http::Response& response) -> Future<spec::v2::ImageManifest> {
       // TODO(jojy): We dont use the digest that is returned in header.
@@ -620,7 +881,10 @@ Future<size_t> RegistryClientProcess::getBlob(
   http::URL blobURL(registryServer_);
   blobURL.path = blobURLPath;
 
-  return doHttpGet(blobURL, None(), true, true, None())
+  return getAuthorizationHeaders(imageName)
+    .then(defer(self(), [=](const Option<http::Headers>& headers) {
+      return doHttpGet(blobURL, headers, true, true, None());
+    }))
     .then(defer(self(), [this, blobURLPath, digest, filePath](
         const http::Response& response) -> Future<size_t> {
       Try<int> fd = os::open(
@@ -684,6 +948,38 @@ Future<size_t> RegistryClientProcess::getBlob(
     }));
 }
 
+
+Future<size_t> RegistryClientProcess::streamBlob(
+    const Image::Name& imageName,
+    const Option<string>& digest,
+    int fd)
+{
+  const string blobURLPath = getRepositoryPath(imageName) + "/blobs/" +
+                             digest.getOrElse("");
+
+  http::URL blobURL(registryServer_);
+  blobURL.path = blobURLPath;
+
+  return getAuthorizationHeaders(imageName)
+    .then(defer(self(), [=](const Option<http::Headers>& headers) {
+      return doHttpGet(blobURL, headers, true, true, None());
+    }))
+    .then(defer(self(), [this, fd](
+        const http::Response& response) -> Future<size_t> {
+      Option<Pipe::Reader> reader = response.reader;
+      if (reader.isNone()) {
+        return Failure("Failed to get streaming reader from blob response");
+      }
+
+      // TODO(jojy): Add blob validation.
+      return saveBlob(fd, reader.get());
+    }))
+    .onFailed([blobURLPath](const string& failure) {
+      LOG(WARNING) << "Failed to stream blob requested from '"
+                   << blobURLPath << "': " << failure;
+    });
+}
+
 } // namespace registry {
 } // namespace docker {
 } // namespace slave {
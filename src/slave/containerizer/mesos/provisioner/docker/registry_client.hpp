@@ -99,6 +99,23 @@ public:
       const Option<std::string>& digest,
       const Path& filePath);
 
+  /**
+   * Fetches blob for a repository from the client's remote registry
+   * server and streams it into the given file descriptor, e.g., a
+   * pipe to an extracting process, as it is being received.
+   *
+   * @param imageName the Docker image to download.
+   * @param digest digest of the blob (from manifest).
+   * @param fd non-blocking file descriptor to write the blob to. It is
+   *     not closed.
+   * @return size of downloaded blob on success.
+   *         Failure in case of any errors.
+   */
+  process::Future<size_t> getBlob(
+      const Image::Name& imageName,
+      const Option<std::string>& digest,
+      int fd);
+
   ~RegistryClient();
 
 private:
@@ -16,21 +16,32 @@
 
 #include "slave/containerizer/mesos/provisioner/docker/registry_puller.hpp"
 
+#include <errno.h>
+#include <unistd.h>
+
+#include <deque>
+#include <functional>
 #include <list>
 
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
-#include <process/subprocess.hpp>
 
-#include "common/status_utils.hpp"
+#include <stout/linkedhashmap.hpp>
+#include <stout/os.hpp>
+
+#include <stout/os/close.hpp>
+#include <stout/os/strerror.hpp>
 
 #include "slave/containerizer/mesos/provisioner/docker/paths.hpp"
+#include "slave/containerizer/mesos/provisioner/docker/puller.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/registry_client.hpp"
 
 namespace http = process::http;
 namespace spec = docker::spec;
 
+using std::deque;
+using std::function;
 using std::list;
 using std::pair;
 using std::string;
@@ -41,7 +52,6 @@ using process::Future;
 using process::Owned;
 using process::Process;
 using process::Promise;
-using process::Subprocess;
 
 namespace mesos {
 namespace internal {
@@ -58,36 +68,58 @@ public:
 
   process::Future<list<pair<string, string>>> pull(
       const Image::Name& imageName,
-      const Path& directory);
+      const Path& directory,
+      bool prefetch);
 
 private:
   explicit RegistryPullerProcess(
       const Owned<RegistryClient>& registry,
-      const Duration& timeout);
+      const Duration& timeout,
+      const string& storeDir,
+      size_t maxDownloads);
 
   Future<pair<string, string>> downloadLayer(
+      const Image::Name& imageName,
+      const Path& directory,
+      const string& blobSum,
+      const string& id,
+      bool prefetch);
+
+  // Downloads the layer and extracts it while it is being received.
+  Future<pair<string, string>> _downloadLayer(
       const Image::Name& imageName,
       const Path& directory,
       const string& blobSum,
       const string& id);
 
+  // Starts queued layer downloads as long as fewer than the maximum
+  // number of downloads are in progress.
+  void startDownloads();
+
   Future<list<pair<string, string>>> downloadLayers(
       const spec::v2::ImageManifest& manifest,
       const Image::Name& imageName,
-      const Path& downloadDir);
+      const Path& downloadDir,
+      bool prefetch);
 
   process::Future<list<pair<string, string>>> _pull(
       const Image::Name& imageName,
       const Path& downloadDir);
 
-  Future<list<pair<string, string>>> untarLayers(
-    const Future<list<pair<string, string>>>& layerFutures,
-    const Path& downloadDir);
-
   Owned<RegistryClient> registryClient_;
   const Duration pullTimeout_;
+  const string storeDir_;
+  const size_t maxDownloads_;
   hashmap<string, Owned<Promise<pair<string, string>>>> downloadTracker_;
 
+  // Layer downloads waiting for one of the downloads in progress to
+  // complete, and the number of downloads in progress. Downloads of
+  // layers only needed by prefetched images are keyed by layer id so
+  // that they can be moved ahead once a pulled image needs them.
+  deque<function<void()>> queuedDownloads_;
+  LinkedHashMap<string, function<void()>> queuedPrefetches_;
+  size_t downloads_;
+
   RegistryPullerProcess(const RegistryPullerProcess&) = delete;
   RegistryPullerProcess& operator=(const RegistryPullerProcess&) = delete;
 };
@@ -128,7 +160,21 @@ Future<list<pair<string, string>>> RegistryPuller::pull(
       process_.get(),
       &RegistryPullerProcess::pull,
       imageName,
-      downloadDir);
+      downloadDir,
+      false);
+}
+
+
+Future<list<pair<string, string>>> RegistryPuller::prefetch(
+    const Image::Name& imageName,
+    const Path& downloadDir)
+{
+  return dispatch(
+      process_.get(),
+      &RegistryPullerProcess::pull,
+      imageName,
+      downloadDir,
+      true);
 }
 
 
@@ -160,84 +206,207 @@ Try<Owned<RegistryPullerProcess>> RegistryPullerProcess::create(
     return Error("Failed to create registry client: " + registry.error());
   }
 
+  if (flags.docker_puller_max_downloads == 0) {
+    return Error(
+        "Failed to create registry puller - the maximum number of "
+        "downloads must be positive");
+  }
+
   return Owned<RegistryPullerProcess>(new RegistryPullerProcess(
       registry.get(),
-      Seconds(timeoutSecs.get())));
+      Seconds(timeoutSecs.get()),
+      flags.docker_store_dir,
+      flags.docker_puller_max_downloads));
 }
 
 
 RegistryPullerProcess::RegistryPullerProcess(
     const Owned<RegistryClient>& registry,
-    const Duration& timeout)
+    const Duration& timeout,
+    const string& storeDir,
+    size_t maxDownloads)
   : registryClient_(registry),
-    pullTimeout_(timeout) {}
+    pullTimeout_(timeout),
+    storeDir_(storeDir),
+    maxDownloads_(maxDownloads),
+    downloads_(0) {}
 
 
 Future<pair<string, string>> RegistryPullerProcess::downloadLayer(
     const Image::Name& imageName,
     const Path& directory,
     const string& blobSum,
-    const string& layerId)
+    const string& layerId,
+    bool prefetch)
 {
-  VLOG(1) << "Downloading layer '"  << layerId
-          << "' for image '" << stringify(imageName) << "'";
+  // Layers are shared by images, so a layer may have been stored
+  // already when pulling another image. The store keeps such layers.
+  const string storedLayerPath =
+    paths::getImageLayerPath(storeDir_, layerId);
+
+  if (os::exists(paths::getImageLayerRootfsPath(storeDir_, layerId))) {
+    VLOG(1) << "Layer '" << layerId << "' for image '"
+            << stringify(imageName) << "' is already in the store";
+
+    return pair<string, string>(layerId, storedLayerPath);
+  }
 
+  // NOTE: A concurrent pull of a different image may be downloading
+  // this layer into its own staging directory. Whichever pull
+  // completes first moves the layer into the store, and the store
+  // then skips it for the other one.
   if (downloadTracker_.contains(layerId)) {
     VLOG(1) << "Download already in progress for image '"
             << stringify(imageName) << "', layer '" << layerId << "'";
 
+    if (!prefetch && queuedPrefetches_.contains(layerId)) {
+      queuedDownloads_.push_back(queuedPrefetches_[layerId]);
+      queuedPrefetches_.erase(layerId);
+    }
+
     return downloadTracker_.at(layerId)->future();
   }
 
+  VLOG(1) << "Downloading layer '"  << layerId
+          << "' for image '" << stringify(imageName) << "'";
+
   Owned<Promise<pair<string, string>>> downloadPromise(
       new Promise<pair<string, string>>());
 
   downloadTracker_.insert({layerId, downloadPromise});
 
-  const Path downloadFile(path::join(directory, layerId + ".tar"));
+  const function<void()> download =
+    [this, imageName, directory, blobSum, layerId, downloadPromise]() {
+      downloadPromise->associate(
+          _downloadLayer(imageName, directory, blobSum, layerId)
+            .onAny(process::defer(self(), [this, layerId](
+                const Future<pair<string, string>>&) {
+              downloadTracker_.erase(layerId);
+
+              --downloads_;
+              startDownloads();
+            })));
+    };
+
+  if (prefetch) {
+    queuedPrefetches_[layerId] = download;
+  } else {
+    queuedDownloads_.push_back(download);
+  }
 
-  registryClient_->getBlob(
-      imageName,
-      blobSum,
-      downloadFile)
-    .onAny(process::defer(
-        self(),
-        [this, layerId, downloadPromise, downloadFile](
-            const Future<size_t>& future) {
-          downloadTracker_.erase(layerId);
-
-          if (!future.isReady()) {
-              downloadPromise->fail(
-                  "Failed to download layer '" + layerId + "': " +
-                  (future.isFailed() ? future.failure() : "future discarded"));
-          } else if (future.get() == 0) {
-            // We don't expect Docker registry to return empty response
-            // even with empty layers.
-            downloadPromise->fail(
-                "Failed to download layer '" + layerId + "': no content");
-          } else {
-            downloadPromise->set({layerId, downloadFile});
-          }
-        }));
+  startDownloads();
 
   return downloadPromise->future();
 }
 
 
+void RegistryPullerProcess::startDownloads()
+{
+  while (downloads_ < maxDownloads_) {
+    function<void()> download;
+
+    if (!queuedDownloads_.empty()) {
+      download = queuedDownloads_.front();
+      queuedDownloads_.pop_front();
+    } else if (!queuedPrefetches_.empty()) {
+      const string layerId = queuedPrefetches_.keys().front();
+      download = queuedPrefetches_[layerId];
+      queuedPrefetches_.erase(layerId);
+    } else {
+      break;
+    }
+
+    ++downloads_;
+    download();
+  }
+}
+
+
+Future<pair<string, string>> RegistryPullerProcess::_downloadLayer(
+    const Image::Name& imageName,
+    const Path& directory,
+    const string& blobSum,
+    const string& layerId)
+{
+  Try<string> rootfs = prepareLayerRootfs(directory, layerId);
+  if (rootfs.isError()) {
+    return Failure(rootfs.error());
+  }
+
+  // The blob is piped into 'tar' as it is being received, rather
+  // than extracting it only after it has been downloaded in full.
+  int pipes[2];
+  if (::pipe(pipes) < 0) {
+    return Failure(
+        "Failed to create pipe for layer '" + layerId + "': " +
+        os::strerror(errno));
+  }
+
+  foreach (int fd, pipes) {
+    Try<Nothing> cloexec = os::cloexec(fd);
+    if (cloexec.isError()) {
+      os::close(pipes[0]);
+      os::close(pipes[1]);
+      return Failure("Failed to cloexec pipe: " + cloexec.error());
+    }
+  }
+
+  Try<Nothing> nonblock = os::nonblock(pipes[1]);
+  if (nonblock.isError()) {
+    os::close(pipes[0]);
+    os::close(pipes[1]);
+    return Failure("Failed to set pipe to non-blocking: " + nonblock.error());
+  }
+
+  // NOTE: 'untar' duplicates the read end for the subprocess, hence
+  // we close ours right away so that 'tar' sees the end of the stream
+  // once we close the write end.
+  Future<Nothing> untarred = untar(pipes[0], rootfs.get());
+  os::close(pipes[0]);
+
+  const int fd = pipes[1];
+
+  return registryClient_->getBlob(imageName, blobSum, fd)
+    .onAny([fd]() { os::close(fd); })
+    .then([untarred](size_t size) -> Future<Nothing> {
+      // We don't expect Docker registry to return empty response
+      // even with empty layers.
+      if (size == 0) {
+        return Failure("no content");
+      }
+
+      return untarred;
+    })
+    .then([directory, layerId]() -> Future<pair<string, string>> {
+      const string layerPath =
+        paths::getImageArchiveLayerPath(directory, layerId);
+
+      if (!os::exists(layerPath)) {
+        return Failure(
+            "Failed to find the rootfs path after extracting layer"
+            " '" + layerId + "'");
+      }
+
+      return pair<string, string>(layerId, layerPath);
+    })
+    .repair([layerId](const Future<pair<string, string>>& future) {
+      return Failure(
+          "Failed to download layer '" + layerId + "': " +
+          (future.isFailed() ? future.failure() : "future discarded"));
+    });
+}
+
+
 Future<list<pair<string, string>>> RegistryPullerProcess::pull(
     const Image::Name& imageName,
-    const Path& directory)
+    const Path& directory,
+    bool prefetch)
 {
   // TODO(jojy): Have one outgoing manifest request per image.
   return registryClient_->getManifest(imageName)
-    .then(process::defer(self(), [this, directory, imageName](
+    .then(process::defer(self(), [this, directory, imageName, prefetch](
         const spec::v2::ImageManifest& manifest) {
-      return downloadLayers(manifest, imageName, directory);
-    }))
-    .then(process::defer(self(), [this, directory](
-        const Future<list<pair<string, string>>>& layerFutures)
-        -> Future<list<pair<string, string>>> {
-      return untarLayers(layerFutures, directory);
+      return downloadLayers(manifest, imageName, directory, prefetch);
     }))
     .after(pullTimeout_, [imageName](
         Future<list<pair<string, string>>> future) {
@@ -251,7 +420,8 @@ Future<list<pair<string, string>>> RegistryPullerProcess::pull(
 Future<list<pair<string, string>>> RegistryPullerProcess::downloadLayers(
     const spec::v2::ImageManifest& manifest,
     const Image::Name& imageName,
-    const Path& directory)
+    const Path& directory,
+    bool prefetch)
 {
   list<Future<pair<string, string>>> downloadFutures;
 
@@ -264,7 +434,8 @@ Future<list<pair<string, string>>> RegistryPullerProcess::downloadLayers(
         downloadLayer(imageName,
                       directory,
                       manifest.fslayers(i).blobsum(),
-                      manifest.history(i).v1().id()));
+                      manifest.history(i).v1().id(),
+                      prefetch));
   }
 
   // TODO(jojy): Delete downloaded files in the directory on discard and
@@ -273,24 +444,6 @@ Future<list<pair<string, string>>> RegistryPullerProcess::downloadLayers(
   return collect(downloadFutures);
 }
 
-
-Future<list<pair<string, string>>> RegistryPullerProcess::untarLayers(
-    const Future<list<pair<string, string>>>& layerFutures,
-    const Path& directory)
-{
-  list<Future<pair<string, string>>> untarFutures;
-
-  pair<string, string> layerInfo;
-  foreach (layerInfo, layerFutures.get()) {
-    VLOG(1) << "Untarring layer '" << layerInfo.first
-            << "' downloaded from registry to directory '" << directory << "'";
-    untarFutures.emplace_back(
-        untarLayer(layerInfo.second, directory, layerInfo.first));
-  }
-
-  return collect(untarFutures);
-}
-
 } // namespace docker {
 } // namespace slave {
 } // namespace internal {
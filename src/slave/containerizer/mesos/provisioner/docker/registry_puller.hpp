@@ -63,6 +63,18 @@ public:
       const Image::Name& imageName,
       const Path& downloadDir);
 
+  /**
+   * Pulls an image like 'pull' does, but only downloads its layers
+   * while no layers of pulled images are waiting to be downloaded.
+   * A layer is downloaded right away once a pulled image needs it.
+   *
+   * @param imageName local name of the image.
+   * @param downloadDir path to which the layers should be downloaded.
+   */
+  process::Future<std::list<std::pair<std::string, std::string>>> prefetch(
+      const Image::Name& imageName,
+      const Path& downloadDir);
+
 private:
   RegistryPuller(const process::Owned<RegistryPullerProcess>& process);
 
@@ -14,14 +14,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fts.h>
+
 #include <list>
 #include <vector>
 
 #include <glog/logging.h>
 
+#include <stout/bytes.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
+#include <stout/linkedhashmap.hpp>
 #include <stout/os.hpp>
+#include <stout/strings.hpp>
 
 #include <process/collect.hpp>
 #include <process/defer.hpp>
@@ -64,10 +70,18 @@ public:
 
   Future<ImageInfo> get(const mesos::Image& image);
 
+  Future<Nothing> prune(const hashset<string>& activeLayers);
+
 private:
+  Future<Nothing> _recover(const vector<Image>& images);
+
   Future<Image> _get(const Image::Name& name, const Option<Image>& image);
   Future<ImageInfo> __get(const Image& image);
 
+  // Pulls the image into the store unless it is being pulled already.
+  // Prefetches may be given a lower priority by the puller.
+  Future<Image> pull(const Image::Name& name, bool prefetch);
+
   Future<vector<string>> moveLayers(
       const std::list<pair<string, string>>& layerPaths);
 
@@ -78,13 +92,103 @@ private:
   Future<Nothing> moveLayer(
       const pair<string, string>& layerPath);
 
+  // Add a layer in the store to the layer index.
+  void addLayer(const string& layerId);
+
+  // Remove a layer from the store and return the space it used.
+  Bytes removeLayer(const string& layerId);
+
+  // Add a stored image to the index, referencing its layers.
+  void addImage(const Image& image);
+
   const Flags flags;
   Owned<MetadataManager> metadataManager;
   Owned<Puller> puller;
   hashmap<std::string, Owned<Promise<Image>>> pulling;
+
+  struct Layer
+  {
+    Layer() : references(0) {}
+
+    // Number of stored images composed of this layer.
+    size_t references;
+
+    // Disk space used by the layer. It is only computed if the size
+    // of the store is bounded.
+    Bytes size;
+  };
+
+  // Index of the layers in the store, keyed by layer id. Layers are
+  // shared by the images composed of them.
+  hashmap<string, Layer> layers;
+
+  // Stored images keyed by image name, from the least recently used
+  // to the most recently used one.
+  LinkedHashMap<string, Image> images;
 };
 
 
+// Returns the disk space used by the files under 'path', counting
+// hard links once, like 'du -s' does.
+static Try<Bytes> diskUsage(const string& path)
+{
+  char* paths[] = {const_cast<char*>(path.c_str()), NULL};
+
+  FTS* tree = fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+  if (tree == NULL) {
+    return ErrnoError();
+  }
+
+  Bytes usage;
+  hashset<ino_t> links;
+
+  FTSENT* node;
+  while ((node = fts_read(tree)) != NULL) {
+    switch (node->fts_info) {
+      case FTS_D:
+      case FTS_F:
+      case FTS_SL:
+      case FTS_SLNONE:
+      case FTS_DEFAULT:
+        if (node->fts_info != FTS_D && node->fts_statp->st_nlink > 1) {
+          if (links.contains(node->fts_statp->st_ino)) {
+            break;
+          }
+
+          links.insert(node->fts_statp->st_ino);
+        }
+
+        usage += Bytes(node->fts_statp->st_blocks * 512);
+        break;
+      case FTS_DNR:
+      case FTS_ERR:
+      case FTS_NS: {
+        Error error = Error(
+            "Failed to stat '" + string(node->fts_path) + "': " +
+            os::strerror(node->fts_errno));
+
+        fts_close(tree);
+        return error;
+      }
+      default:
+        break;
+    }
+  }
+
+  if (errno != 0) {
+    Error error = ErrnoError();
+    fts_close(tree);
+    return error;
+  }
+
+  if (fts_close(tree) < 0) {
+    return ErrnoError();
+  }
+
+  return usage;
+}
+
+
 Try<Owned<slave::Store>> Store::create(const Flags& flags)
 {
   Try<Owned<Puller>> puller = Puller::create(flags);
@@ -154,6 +258,12 @@ Future<ImageInfo> Store::get(const mesos::Image& image)
 }
 
 
+Future<Nothing> Store::prune(const hashset<string>& activeLayers)
+{
+  return dispatch(process.get(), &StoreProcess::prune, activeLayers);
+}
+
+
 Future<ImageInfo> StoreProcess::get(const mesos::Image& image)
 {
   if (image.type() != mesos::Image::DOCKER) {
@@ -176,6 +286,20 @@ Future<Image> StoreProcess::_get(
     return image.get();
   }
 
+  return pull(name, false);
+}
+
+
+Future<Image> StoreProcess::pull(const Image::Name& name, bool prefetch)
+{
+  const string imageName = stringify(name);
+
+  // NOTE: If the image is being prefetched, its layers keep the
+  // lower priority of the prefetch.
+  if (pulling.contains(imageName)) {
+    return pulling[imageName]->future();
+  }
+
   Try<string> staging =
     os::mkdtemp(paths::getStagingTempDir(flags.docker_store_dir));
 
@@ -183,37 +307,40 @@ Future<Image> StoreProcess::_get(
     return Failure("Failed to create a staging directory");
   }
 
-  const string imageName = stringify(name);
-
-  if (!pulling.contains(imageName)) {
-    Owned<Promise<Image>> promise(new Promise<Image>());
-
-    Future<Image> future = puller->pull(name, Path(staging.get()))
-      .then(defer(self(), &Self::moveLayers, lambda::_1))
-      .then(defer(self(), &Self::storeImage, name, lambda::_1))
-      .onAny(defer(self(), [this, imageName](const Future<Image>&) {
-        pulling.erase(imageName);
-      }))
-      .onAny([staging, imageName]() {
-        Try<Nothing> rmdir = os::rmdir(staging.get());
-        if (rmdir.isError()) {
-          LOG(WARNING) << "Failed to remove staging directory: "
-                       << rmdir.error();
-        }
-      });
-
-    promise->associate(future);
-    pulling[imageName] = promise;
+  Owned<Promise<Image>> promise(new Promise<Image>());
+
+  Future<Image> future = (prefetch
+      ? puller->prefetch(name, Path(staging.get()))
+      : puller->pull(name, Path(staging.get())))
+    .then(defer(self(), &Self::moveLayers, lambda::_1))
+    .then(defer(self(), &Self::storeImage, name, lambda::_1))
+    .onAny(defer(self(), [this, imageName](const Future<Image>&) {
+      pulling.erase(imageName);
+    }))
+    .onAny([staging, imageName]() {
+      Try<Nothing> rmdir = os::rmdir(staging.get());
+      if (rmdir.isError()) {
+        LOG(WARNING) << "Failed to remove staging directory: "
+                     << rmdir.error();
+      }
+    });
 
-    return promise->future();
-  }
+  promise->associate(future);
+  pulling[imageName] = promise;
 
-  return pulling[imageName]->future();
+  return promise->future();
 }
 
 
 Future<ImageInfo> StoreProcess::__get(const Image& image)
 {
+  // Mark the image as the most recently used one.
+  const string imageName = stringify(image.name());
+  if (images.contains(imageName)) {
+    images.erase(imageName);
+    images[imageName] = image;
+  }
+
   vector<string> layerDirectories;
   foreach (const string& layer, image.layer_ids()) {
     layerDirectories.push_back(
@@ -232,7 +359,150 @@ Future<ImageInfo> StoreProcess::__get(const Image& image)
 
 Future<Nothing> StoreProcess::recover()
 {
-  return metadataManager->recover();
+  return metadataManager->recover()
+    .then(defer(self(), [this]() { return metadataManager->images(); }))
+    .then(defer(self(), &Self::_recover, lambda::_1));
+}
+
+
+Future<Nothing> StoreProcess::_recover(const vector<Image>& _images)
+{
+  // Layers that no stored image is composed of, e.g., because the
+  // agent failed before the image was stored, are indexed as well so
+  // that they are garbage collected.
+  const string layersDir = paths::getImageLayersDir(flags.docker_store_dir);
+
+  if (os::exists(layersDir)) {
+    Try<list<string>> layerIds = os::ls(layersDir);
+    if (layerIds.isError()) {
+      return Failure(
+          "Failed to list the layers directory '" + layersDir + "': " +
+          layerIds.error());
+    }
+
+    foreach (const string& layerId, layerIds.get()) {
+      addLayer(layerId);
+    }
+  }
+
+  foreach (const Image& image, _images) {
+    addImage(image);
+  }
+
+  LOG(INFO) << "Indexed " << layers.size() << " layers of "
+            << images.size() << " Docker images";
+
+  // Pull the images to prefetch in the background so that containers
+  // using them do not have to wait for them to be pulled.
+  if (flags.docker_store_prefetch_images.isSome()) {
+    foreach (const string& name,
+             strings::tokenize(flags.docker_store_prefetch_images.get(), ",")) {
+      const Image::Name imageName = parseImageName(strings::trim(name));
+
+      if (images.contains(stringify(imageName))) {
+        continue;
+      }
+
+      LOG(INFO) << "Prefetching Docker image '" << imageName << "'";
+
+      pull(imageName, true)
+        .onFailed([imageName](const string& failure) {
+          LOG(WARNING) << "Failed to prefetch Docker image '" << imageName
+                       << "': " << failure;
+        });
+    }
+  }
+
+  return Nothing();
+}
+
+
+Future<Nothing> StoreProcess::prune(const hashset<string>& activeLayers)
+{
+  if (flags.docker_store_max_size.isNone()) {
+    return Nothing();
+  }
+
+  // The layers of images being pulled are moved into the store
+  // before the image is stored, so they are not referenced yet.
+  if (!pulling.empty()) {
+    VLOG(1) << "Not pruning the Docker store while images are being pulled";
+    return Nothing();
+  }
+
+  const Bytes maxSize = flags.docker_store_max_size.get();
+
+  Bytes size;
+  foreachvalue (const Layer& layer, layers) {
+    size += layer.size;
+  }
+
+  if (size <= maxSize) {
+    return Nothing();
+  }
+
+  auto active = [&](const string& layerId) {
+    return activeLayers.contains(
+        paths::getImageLayerRootfsPath(flags.docker_store_dir, layerId));
+  };
+
+  // Remove the layers that no image is composed of first.
+  vector<string> unreferenced;
+  foreachpair (const string& layerId, const Layer& layer, layers) {
+    if (layer.references == 0 && !active(layerId)) {
+      unreferenced.push_back(layerId);
+    }
+  }
+
+  foreach (const string& layerId, unreferenced) {
+    size -= removeLayer(layerId);
+  }
+
+  // Then remove the least recently used images, along with the
+  // layers that are not shared with the remaining images, until the
+  // store fits. An image is kept if that would not free any space,
+  // e.g., because all its layers are used by containers.
+  list<Future<Nothing>> removals;
+  foreach (const string& imageName, images.keys()) {
+    if (size <= maxSize) {
+      break;
+    }
+
+    const Image image = images[imageName];
+
+    Bytes freed;
+    foreach (const string& layerId, image.layer_ids()) {
+      if (layers[layerId].references == 1 && !active(layerId)) {
+        freed += layers[layerId].size;
+      }
+    }
+
+    if (freed == 0) {
+      continue;
+    }
+
+    LOG(INFO) << "Removing Docker image '" << imageName << "' from the store";
+
+    // The image is removed from the metadata before its layers so
+    // that it is not returned by 'get' anymore.
+    images.erase(imageName);
+    removals.push_back(metadataManager->remove(image.name()));
+
+    foreach (const string& layerId, image.layer_ids()) {
+      if (--layers[layerId].references == 0 && !active(layerId)) {
+        size -= removeLayer(layerId);
+      }
+    }
+  }
+
+  if (size > maxSize) {
+    LOG(WARNING) << "The Docker store uses " << size << " which exceeds "
+                 << "the maximum size of " << maxSize << " because the "
+                 << "remaining layers are used by containers";
+  }
+
+  return collect(removals)
+    .then([]() -> Future<Nothing> { return Nothing(); });
 }
 
 
@@ -260,21 +530,36 @@ Future<Image> StoreProcess::storeImage(
     const Image::Name& name,
     const vector<string>& layerIds)
 {
-  return metadataManager->put(name, layerIds);
+  return metadataManager->put(name, layerIds)
+    .then(defer(self(), [this](const Image& image) -> Future<Image> {
+      addImage(image);
+      return image;
+    }));
 }
 
 
 Future<Nothing> StoreProcess::moveLayer(
     const pair<string, string>& layerPath)
 {
+  const string imageLayerPath =
+    paths::getImageLayerPath(flags.docker_store_dir, layerPath.first);
+
+  // Layers are shared by images. A layer that is in the store
+  // already, e.g., because it has been pulled for another image
+  // concurrently, is kept as is since it may be in use by containers.
+  if (os::exists(
+          paths::getImageLayerRootfsPath(
+              flags.docker_store_dir, layerPath.first))) {
+    VLOG(1) << "Layer '" << layerPath.first << "' is already in the store";
+    addLayer(layerPath.first);
+    return Nothing();
+  }
+
   if (!os::exists(layerPath.second)) {
     return Failure("Unable to find layer '" + layerPath.first + "' in '" +
                    layerPath.second + "'");
   }
 
-  const string imageLayerPath =
-    paths::getImageLayerPath(flags.docker_store_dir, layerPath.first);
-
   // If image layer path exists, we should remove it and make an empty
   // directory, because os::rename can only have empty or non-existed
   // directory as destination.
@@ -300,9 +585,78 @@ Future<Nothing> StoreProcess::moveLayer(
                    "' to store directory: " + status.error());
   }
 
+  addLayer(layerPath.first);
+
   return Nothing();
 }
 
+
+void StoreProcess::addLayer(const string& layerId)
+{
+  if (layers.contains(layerId)) {
+    return;
+  }
+
+  Layer layer;
+
+  if (flags.docker_store_max_size.isSome()) {
+    const string layerPath =
+      paths::getImageLayerPath(flags.docker_store_dir, layerId);
+
+    Try<Bytes> usage = diskUsage(layerPath);
+    if (usage.isError()) {
+      LOG(WARNING) << "Failed to compute the size of layer '" << layerId
+                   << "': " << usage.error();
+    } else {
+      layer.size = usage.get();
+    }
+  }
+
+  layers[layerId] = layer;
+}
+
+
+Bytes StoreProcess::removeLayer(const string& layerId)
+{
+  CHECK(layers.contains(layerId));
+
+  const Bytes size = layers[layerId].size;
+  layers.erase(layerId);
+
+  const string layerPath =
+    paths::getImageLayerPath(flags.docker_store_dir, layerId);
+
+  VLOG(1) << "Removing layer '" << layerId << "' from the store";
+
+  Try<Nothing> rmdir = os::rmdir(layerPath);
+  if (rmdir.isError()) {
+    LOG(WARNING) << "Failed to remove layer '" << layerId << "' at '"
+                 << layerPath << "': " << rmdir.error();
+  }
+
+  return size;
+}
+
+
+void StoreProcess::addImage(const Image& image)
+{
+  const string imageName = stringify(image.name());
+
+  if (images.contains(imageName)) {
+    foreach (const string& layerId, images[imageName].layer_ids()) {
+      --layers[layerId].references;
+    }
+
+    images.erase(imageName);
+  }
+
+  foreach (const string& layerId, image.layer_ids()) {
+    ++layers[layerId].references;
+  }
+
+  images[imageName] = image;
+}
+
 } // namespace docker {
 } // namespace slave {
 } // namespace internal {
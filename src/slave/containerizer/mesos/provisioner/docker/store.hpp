@@ -52,6 +52,9 @@ public:
 
   virtual process::Future<ImageInfo> get(const mesos::Image& image);
 
+  virtual process::Future<Nothing> prune(
+      const hashset<std::string>& activeLayers);
+
 private:
   explicit Store(const process::Owned<StoreProcess>& process);
 
@@ -17,6 +17,8 @@
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 
+#include <stout/sharded_cache.hpp>
+
 #include "slave/containerizer/mesos/provisioner/docker/token_manager.hpp"
 
 using std::hash;
@@ -55,7 +57,8 @@ private:
   static const Duration RESPONSE_TIMEOUT;
 
   TokenManagerProcess(const URL& realm)
-    : realm_(realm) {}
+    : realm_(realm),
+      tokenCache_(MAX_TOKENS, 1) {}
 
   Try<Token> getTokenFromResponse(const Response& response) const;
 
@@ -90,8 +93,15 @@ private:
     }
   };
 
-  typedef hashmap<
-    const TokenCacheKey,
+  // The maximum number of tokens cached, there is one per service and
+  // scope (i.e., repository) the images are pulled from. The least
+  // recently used tokens are evicted once the cache is full.
+  static const size_t MAX_TOKENS = 1024;
+
+  // NOTE: The tokens are only used by this process, hence a single
+  // shard, which keeps the eviction strictly least recently used.
+  typedef ShardedCache<
+    TokenCacheKey,
     Token,
     TokenCacheKeyHash,
     TokenCacheKeyEqual> TokenCacheType;
@@ -99,6 +109,14 @@ private:
   const URL realm_;
   TokenCacheType tokenCache_;
 
+  // Tokens being requested from the authorization server, so that
+  // concurrent requests for the same token share one request.
+  hashmap<
+    const TokenCacheKey,
+    Future<Token>,
+    TokenCacheKeyHash,
+    TokenCacheKeyEqual> pendingTokens_;
+
   TokenManagerProcess(const TokenManagerProcess&) = delete;
   TokenManagerProcess& operator=(const TokenManagerProcess&) = delete;
 };
@@ -309,16 +327,21 @@ Future<Token> TokenManagerProcess::getToken(
 {
   const TokenCacheKey tokenKey = {service, scope};
 
-  if (tokenCache_.contains(tokenKey)) {
-    Token token = tokenCache_.at(tokenKey);
+  Option<Token> cached = tokenCache_.get(tokenKey);
 
-    if (token.isValid()) {
-      return token;
+  if (cached.isSome()) {
+    if (cached.get().isValid()) {
+      return cached.get();
     } else {
       LOG(WARNING) << "Cached token was invalid. Will fetch once again";
+      tokenCache_.erase(tokenKey);
     }
   }
 
+  if (pendingTokens_.contains(tokenKey)) {
+    return pendingTokens_.at(tokenKey);
+  }
+
   URL tokenUrl = realm_;
   tokenUrl.path = TOKEN_PATH_PREFIX;
 
@@ -331,7 +354,7 @@ Future<Token> TokenManagerProcess::getToken(
     tokenUrl.query.insert({"account", account.get()});
   }
 
-  return process::http::get(tokenUrl, None())
+  Future<Token> token = process::http::get(tokenUrl, None())
     .after(RESPONSE_TIMEOUT, [] (Future<Response> resp) -> Future<Response> {
       resp.discard();
       return Failure("Timeout waiting for response to token request");
@@ -345,10 +368,18 @@ Future<Token> TokenManagerProcess::getToken(
             token.error());
       }
 
-      tokenCache_.insert({tokenKey, token.get()});
+      tokenCache_.put(tokenKey, token.get());
 
       return token.get();
     }));
+
+  pendingTokens_.insert({tokenKey, token});
+
+  token.onAny(defer(self(), [this, tokenKey](const Future<Token>&) {
+    pendingTokens_.erase(tokenKey);
+  }));
+
+  return token;
 }
 
 // TODO(jojy): Add implementation for basic authentication based getToken API.
@@ -102,10 +102,9 @@ class TokenManagerProcess;
 
 /**
  *  Acquires and manages docker registry tokens. It keeps the tokens in its
- *  cache to server any future request for the same token.
- *  The cache grows unbounded.
- *  TODO(jojy): The cache can be optimized to prune based on the expiry time of
- *  the token and server's issue time.
+ *  cache, keyed by service and scope, to serve any future request for the
+ *  same token until the token expires. Concurrent requests for a token
+ *  that is not cached share a single request to the authorization server.
  */
 class TokenManager
 {
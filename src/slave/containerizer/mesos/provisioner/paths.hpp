@@ -39,7 +39,9 @@ namespace paths {
 //             |-- backends
 //                 |-- <backend> (copy, bind, etc.)
 //                     |-- rootfses
-//                         |-- <rootfs_id> (the rootfs)
+//                     |   |-- <rootfs_id> (the rootfs)
+//                     |-- layers
+//                         |-- <rootfs_id> (image layers of the rootfs)
 //
 // There can be multiple backends due to the change of backend flags.
 // Under each backend a rootfs is identified by the 'rootfs_id' which
@@ -57,6 +59,16 @@ std::string getContainerRootfsDir(
     const std::string& rootfsId);
 
 
+// The file that records the image layers a rootfs was provisioned
+// from, one layer path per line. The stores use it to know which
+// layers are still referenced by containers.
+std::string getContainerRootfsLayersPath(
+    const std::string& provisionerDir,
+    const ContainerID& containerId,
+    const std::string& backend,
+    const std::string& rootfsId);
+
+
 // Recursively "ls" the container directory and return a map of
 // backend -> {rootfsId, ...}
 Try<hashmap<std::string, hashset<std::string>>>
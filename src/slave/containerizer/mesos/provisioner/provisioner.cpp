@@ -25,7 +25,9 @@
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
 #include "slave/paths.hpp"
@@ -149,7 +151,8 @@ ProvisionerProcess::ProvisionerProcess(
   : flags(_flags),
     rootDir(_rootDir),
     stores(_stores),
-    backends(_backends) {}
+    backends(_backends),
+    pending(0) {}
 
 
 Future<Nothing> ProvisionerProcess::recover(
@@ -199,6 +202,31 @@ Future<Nothing> ProvisionerProcess::recover(
       }
 
       info->rootfses.put(backend, rootfses.get()[backend]);
+
+      foreach (const string& rootfsId, rootfses.get()[backend]) {
+        const string layersPath =
+          provisioner::paths::getContainerRootfsLayersPath(
+              rootDir,
+              containerId,
+              backend,
+              rootfsId);
+
+        // The layers are not recorded for rootfses provisioned by an
+        // older agent. The stores are not pruned until they are gone.
+        if (!os::exists(layersPath)) {
+          continue;
+        }
+
+        Try<string> read = os::read(layersPath);
+        if (read.isError()) {
+          LOG(WARNING) << "Failed to read the layers of rootfs '" << rootfsId
+                       << "' for container " << containerId << ": "
+                       << read.error();
+          continue;
+        }
+
+        info->layers.put(rootfsId, strings::tokenize(read.get(), "\n"));
+      }
     }
 
     infos.put(containerId, info);
@@ -241,10 +269,13 @@ Future<Nothing> ProvisionerProcess::recover(
   // in 'store', which might fail if there still exist unknown orphans
   // holding references to them.
   return collect(cleanup, recover)
-    .then([=]() -> Future<Nothing> {
+    .then(defer(self(), [=]() -> Future<Nothing> {
       LOG(INFO) << "Provisioner recovery complete";
+
+      prune();
+
       return Nothing();
-    });
+    }));
 }
 
 
@@ -258,9 +289,15 @@ Future<ProvisionInfo> ProvisionerProcess::provision(
         stringify(image.type()));
   }
 
+  ++pending;
+
   // Get and then provision image layers from the store.
   return stores.get(image.type()).get()->get(image)
-    .then(defer(self(), &Self::_provision, containerId, lambda::_1));
+    .then(defer(self(), &Self::_provision, containerId, lambda::_1))
+    .onAny(defer(self(), [this](const Future<ProvisionInfo>&) {
+      --pending;
+      prune();
+    }));
 }
 
 
@@ -291,7 +328,32 @@ Future<ProvisionInfo> ProvisionerProcess::_provision(
     infos.put(containerId, Owned<Info>(new Info()));
   }
 
+  // Record the layers before the rootfs is provisioned so that they
+  // are known to be referenced by the rootfs after agent restarts.
+  const string layersPath = provisioner::paths::getContainerRootfsLayersPath(
+      rootDir,
+      containerId,
+      backend,
+      rootfsId);
+
+  Try<Nothing> mkdir = os::mkdir(Path(layersPath).dirname());
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create the layers directory for rootfs '" + rootfs +
+        "': " + mkdir.error());
+  }
+
+  Try<Nothing> write =
+    os::write(layersPath, strings::join("\n", ImageInfo.layers));
+
+  if (write.isError()) {
+    return Failure(
+        "Failed to record the layers of rootfs '" + rootfs + "': " +
+        write.error());
+  }
+
   infos[containerId]->rootfses[backend].insert(rootfsId);
+  infos[containerId]->layers.put(rootfsId, ImageInfo.layers);
 
   return backends.get(backend).get()->provision(ImageInfo.layers, rootfs)
     .then([rootfs, ImageInfo]() -> Future<ProvisionInfo> {
@@ -334,9 +396,15 @@ Future<bool> ProvisionerProcess::destroy(const ContainerID& containerId)
     }
   }
 
+  ++pending;
+
   // TODO(xujyan): Revisit the usefulness of this return value.
   return collect(futures)
-    .then(defer(self(), &ProvisionerProcess::_destroy, containerId));
+    .then(defer(self(), &ProvisionerProcess::_destroy, containerId))
+    .onAny(defer(self(), [this](const Future<bool>&) {
+      --pending;
+      prune();
+    }));
 }
 
 
@@ -365,6 +433,42 @@ Future<bool> ProvisionerProcess::_destroy(const ContainerID& containerId)
 }
 
 
+void ProvisionerProcess::prune()
+{
+  if (pending > 0) {
+    return;
+  }
+
+  hashset<string> layers;
+  foreachpair (const ContainerID& containerId,
+               const Owned<Info>& info,
+               infos) {
+    foreachvalue (const hashset<string>& rootfsIds, info->rootfses) {
+      foreach (const string& rootfsId, rootfsIds) {
+        if (!info->layers.contains(rootfsId)) {
+          VLOG(1) << "Not pruning the image stores because the layers of "
+                  << "rootfs '" << rootfsId << "' for container "
+                  << containerId << " are unknown";
+          return;
+        }
+
+        foreach (const string& layer, info->layers[rootfsId]) {
+          layers.insert(layer);
+        }
+      }
+    }
+  }
+
+  foreachpair (const Image::Type& type, const Owned<Store>& store, stores) {
+    store->prune(layers)
+      .onFailed([type](const string& failure) {
+        LOG(WARNING) << "Failed to prune the " << type << " image store: "
+                     << failure;
+      });
+  }
+}
+
+
 ProvisionerProcess::Metrics::Metrics()
   : remove_container_errors(
       "containerizer/mesos/provisioner/remove_container_errors")
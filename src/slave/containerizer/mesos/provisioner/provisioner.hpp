@@ -18,6 +18,8 @@
 #define __PROVISIONER_HPP__
 
 #include <list>
+#include <string>
+#include <vector>
 
 #include <mesos/resources.hpp>
 
@@ -128,6 +130,10 @@ private:
 
   process::Future<bool> _destroy(const ContainerID& containerId);
 
+  // Ask the stores to prune the images that are not used by any of
+  // the provisioned rootfses.
+  void prune();
+
   const Flags flags;
 
   // Absolute path to the provisioner root directory. It can be
@@ -144,10 +150,19 @@ private:
   {
     // Mappings: backend -> {rootfsId, ...}
     hashmap<std::string, hashset<std::string>> rootfses;
+
+    // Mappings: rootfsId -> image layers the rootfs is provisioned
+    // from. A rootfs is missing here if its layers were not recorded.
+    hashmap<std::string, std::vector<std::string>> layers;
   };
 
   hashmap<ContainerID, process::Owned<Info>> infos;
 
+  // Number of provisions and destroys in progress. The stores are
+  // not pruned while there are any, because the layers they use are
+  // not (or no longer) accounted for in 'infos'.
+  size_t pending;
+
   struct Metrics
   {
     Metrics();
@@ -25,6 +25,8 @@
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
 #include <stout/try.hpp>
 
 #include "slave/flags.hpp"
@@ -83,6 +85,16 @@ public:
   // The returned future fails if the requested image or any of its
   // dependencies cannot be found or failed to be fetched.
   virtual process::Future<ImageInfo> get(const Image& image) = 0;
+
+  // Remove cached images and layers to keep the store within its
+  // configured size. Layers in 'activeLayers' (as returned by 'get')
+  // are used by provisioned rootfses and are never removed. Stores
+  // that do not garbage collect their images ignore this.
+  virtual process::Future<Nothing> prune(
+      const hashset<std::string>& activeLayers)
+  {
+    return Nothing();
+  }
 };
 
 } // namespace slave {
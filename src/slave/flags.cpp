@@ -91,7 +91,13 @@ mesos::internal::slave::Flags::Flags()
       "(configure with flag: --with-network-isolator to enable),\n"
       "or 'external', or load an alternate isolator module using\n"
       "the --modules flag. Note that this flag is only relevant\n"
-      "for the Mesos Containerizer.",
+      "for the Mesos Containerizer.\n"
+      "The 'cgroups/cpuset' isolator pins containers to the CPUs and\n"
+      "memory of NUMA nodes and exposes the topology as the\n"
+      "'numa_nodes', 'numa_node_cpus' and 'numa_node_mem' (in MB)\n"
+      "attributes, unless they are set with --attributes.\n"
+      "The 'cgroups/hugetlb' isolator limits the hugepages of the\n"
+      "containers to their 'hugepages_<size>' resources.",
       "posix/cpu,posix/mem");
 
   add(&Flags::launcher,
@@ -102,6 +108,15 @@ mesos::internal::slave::Flags::Flags()
       "network, pid, etc. If unspecified, the slave will choose the Linux\n"
       "launcher if it's running as root on Linux.");
 
+  add(&Flags::max_concurrent_container_destroys,
+      "max_concurrent_container_destroys",
+      "Maximum number of containers of the Mesos containerizer being\n"
+      "destroyed (i.e., having their processes killed and their isolators\n"
+      "cleaned up) at the same time. The other destroys wait in the order\n"
+      "they were requested. Removing the provisioned root filesystems of\n"
+      "the containers is not limited. If unspecified, all the containers\n"
+      "are destroyed at the same time.");
+
   add(&Flags::image_providers,
       "image_providers",
       "Comma-separated list of supported image providers,\n"
@@ -110,7 +125,7 @@ mesos::internal::slave::Flags::Flags()
   add(&Flags::image_provisioner_backend,
       "image_provisioner_backend",
       "Strategy for provisioning container rootfs from images,\n"
-      "e.g., 'bind', 'copy'.",
+      "e.g., 'bind', 'copy', 'overlay'.",
       "copy");
 
   add(&Flags::appc_store_dir,
@@ -118,6 +133,20 @@ mesos::internal::slave::Flags::Flags()
       "Directory the appc provisioner will store images in.",
       "/tmp/mesos/store/appc");
 
+  add(&Flags::appc_simple_discovery_uri_prefix,
+      "appc_simple_discovery_uri_prefix",
+      "URI prefix used for simple discovery of appc images that are not\n"
+      "in the store, e.g., `http://images.example.com/`. An image is then\n"
+      "fetched from `<prefix><name>-<version>-<os>-<arch>.aci`, where the\n"
+      "version, os and arch are the labels of the image, defaulting to\n"
+      "`latest`, `linux` and `amd64`. If not set, appc images are not\n"
+      "fetched.");
+
+  add(&Flags::appc_store_max_fetches,
+      "appc_store_max_fetches",
+      "Maximum number of appc images fetched at the same time.",
+      4);
+
   add(&Flags::docker_auth_server,
       "docker_auth_server",
       "Docker authentication server used to authenticate with Docker registry",
@@ -128,6 +157,12 @@ mesos::internal::slave::Flags::Flags()
       "Timeout in seconds for pulling images from the Docker registry",
       "60");
 
+  add(&Flags::docker_puller_max_downloads,
+      "docker_puller_max_downloads",
+      "Maximum number of image layers downloaded from the Docker registry\n"
+      "at the same time, across all images being pulled",
+      4);
+
   add(&Flags::docker_registry,
       "docker_registry",
       "The default url for pulling Docker images. It could either be a Docker\n"
@@ -141,6 +176,22 @@ mesos::internal::slave::Flags::Flags()
       "Directory the Docker provisioner will store images in",
       "/tmp/mesos/store/docker");
 
+  add(&Flags::docker_store_max_size,
+      "docker_store_max_size",
+      "Maximum size of the Docker provisioner store. When it is exceeded,\n"
+      "the least recently used images, and the layers no other image is\n"
+      "composed of, are removed from the store unless they are used by a\n"
+      "container. Layers are shared between images. If not set, images\n"
+      "are kept in the store indefinitely.");
+
+  add(&Flags::docker_store_prefetch_images,
+      "docker_store_prefetch_images",
+      "Comma separated list of Docker images to pull into the Docker\n"
+      "provisioner store in the background once the agent has recovered,\n"
+      "so that containers using them start without waiting for a pull.\n"
+      "The registry puller only downloads their layers while no layers\n"
+      "needed by containers are waiting to be downloaded.");
+
   add(&Flags::default_role,
       "default_role",
       "Any resources in the --resources flag that\n"
@@ -174,10 +225,48 @@ mesos::internal::slave::Flags::Flags()
       "(one subdirectory per slave).",
       "/tmp/mesos/fetch");
 
+  add(&Flags::fetcher_cache_hardlinks,
+      "fetcher_cache_hardlinks",
+      "Whether to hard link files from the fetcher cache into sandboxes\n"
+      "when the file system does not support cloning them (reflinks),\n"
+      "instead of copying them. Hard linked files are read-only and\n"
+      "remain owned by the user the slave runs as.",
+      false);
+
+  add(&Flags::fetcher_download_parts,
+      "fetcher_download_parts",
+      "The number of concurrent range requests the fetcher downloads an\n"
+      "HTTP(S) URI with, if the server supports range requests. Files\n"
+      "smaller than 8MB per part are downloaded with fewer parts. Parts\n"
+      "of a failed download are kept and only the missing ranges are\n"
+      "requested again. More than one part requires the 'curl' command.",
+      1);
+
+  add(&Flags::fetcher_peers,
+      "fetcher_peers",
+      "A comma-separated list of peer agents ('host:port') from whose\n"
+      "fetcher caches the URIs with a checksum are downloaded before\n"
+      "downloading them from their origin, rather than every agent\n"
+      "downloading a popular artifact from the same origin. A few\n"
+      "peers are tried in a random order, and the content is verified\n"
+      "against the checksum. If set, the agent also serves its own\n"
+      "cache files with a checksum to its peers through '/files'.");
+
   add(&Flags::work_dir,
       "work_dir",
       "Directory path to place framework work directories\n", "/tmp/mesos");
 
+  add(&Flags::persistent_volume_backend,
+      "persistent_volume_backend",
+      "How to create persistent volumes, either 'copy' or 'btrfs'.\n"
+      "With 'copy', volumes are directories, and a volume created with a\n"
+      "parent is copied from it with reflinks where the filesystem\n"
+      "supports them (e.g., btrfs, or XFS formatted with 'reflink=1') and\n"
+      "with a regular copy otherwise. With 'btrfs', volumes are btrfs\n"
+      "subvolumes, and a volume created with a parent is a snapshot of it;\n"
+      "this requires the volumes to be on btrfs and the 'btrfs' command.",
+      "copy");
+
   add(&Flags::launcher_dir, // TODO(benh): This needs a better name.
       "launcher_dir",
       "Directory path of Mesos binaries. Mesos would find health-check,\n"
@@ -193,6 +282,14 @@ mesos::internal::slave::Flags::Flags()
       "environment or find hadoop on PATH)",
       "");
 
+  add(&Flags::webhdfs_address,
+      "webhdfs_address",
+      "Address of the WebHDFS REST API of the HDFS namenode, e.g.,\n"
+      "`http://namenode:50070`. If set, the fetcher reads HDFS URIs\n"
+      "through WebHDFS instead of running the hadoop client, which\n"
+      "starts a JVM for every operation. The files are read with\n"
+      "several range requests to the datanodes in parallel.");
+
 #ifndef __WINDOWS__
   add(&Flags::switch_user,
       "switch_user",
@@ -208,6 +305,16 @@ mesos::internal::slave::Flags::Flags()
       true);
 #endif // __WINDOWS__
 
+  add(&Flags::shared_command_executor,
+      "shared_command_executor",
+      "If set to `true`, the command tasks of a framework that neither\n"
+      "specify a `ContainerInfo` nor URIs to fetch are run by a single\n"
+      "command executor per framework (and user) rather than by a command\n"
+      "executor per task. This saves the memory and the registration of\n"
+      "an executor per task, but the tasks share the sandbox and the\n"
+      "container (i.e., the cgroups) of the executor.",
+      false);
+
   add(&Flags::frameworks_home,
       "frameworks_home",
       "Directory path prepended to relative executor URIs", "");
@@ -282,7 +389,10 @@ mesos::internal::slave::Flags::Flags()
       "Periodic time interval (e.g., 10secs, 2mins, etc)\n"
       "to check the overall disk usage managed by the slave.\n"
       "This drives the garbage collection of archived\n"
-      "information and sandboxes.",
+      "information and sandboxes. The disk usage is checked\n"
+      "more often (up to every second) as it gets within\n"
+      "--gc_disk_headroom of the point where all of them are\n"
+      "garbage collected.",
       DISK_WATCH_INTERVAL);
 
   add(&Flags::container_logger,
@@ -318,6 +428,24 @@ mesos::internal::slave::Flags::Flags()
       "state as possible is recovered.\n",
       true);
 
+  add(&Flags::status_update_journal,
+      "status_update_journal",
+      "If status_update_journal=true, the status updates and acknowledgements\n"
+      "of all the tasks are checkpointed to a single journal which is synced\n"
+      "once for each batch of updates, rather than to a (synchronously\n"
+      "written) file per task. The journal is moved into the files of the\n"
+      "tasks whenever it grows large and during recovery.\n",
+      false);
+
+  add(&Flags::status_update_batch_interval,
+      "status_update_batch_interval",
+      "Amount of time to wait for more status updates before forwarding\n"
+      "the pending ones to the master in a single message. With the\n"
+      "default of zero, only the updates that are ready to be forwarded\n"
+      "at the same time are batched. A batch is sent as soon as it\n"
+      "grows large, regardless of this interval.\n",
+      Duration::zero());
+
 #ifdef __linux__
   add(&Flags::cgroups_hierarchy,
       "cgroups_hierarchy",
@@ -334,6 +462,27 @@ mesos::internal::slave::Flags::Flags()
       "via the CFS bandwidth limiting subfeature.\n",
       false);
 
+  add(&Flags::cgroups_cfs_period,
+      "cgroups_cfs_period",
+      "The CFS bandwidth period of the containers when CFS is enabled.\n"
+      "A task can select the period of its container with the\n"
+      "'cfs_period' label, e.g., a shorter period for latency\n"
+      "critical tasks, to bound the time they are throttled.\n"
+      "Periods must be in [1ms, 1secs].",
+      Milliseconds(100));
+
+  add(&Flags::cgroups_revocable_cfs_period,
+      "cgroups_revocable_cfs_period",
+      "The CFS bandwidth period of the containers with revocable CPU\n"
+      "when CFS is enabled. Defaults to '--cgroups_cfs_period'.");
+
+  add(&Flags::cgroups_cfs_burst_factor,
+      "cgroups_cfs_burst_factor",
+      "Enables widening the CFS quota of the containers with regular\n"
+      "(non-revocable) CPU which are throttled while CFS is enabled,\n"
+      "up to this multiple of their allocated CPU. The quota shrinks\n"
+      "back to the allocation once they are no longer throttled.");
+
   // TODO(antonl): Set default to true in future releases.
   add(&Flags::cgroups_limit_swap,
       "cgroups_limit_swap",
@@ -341,12 +490,44 @@ mesos::internal::slave::Flags::Flags()
       "swap instead of just memory.\n",
       false);
 
+  add(&Flags::cgroups_pool_size,
+      "cgroups_pool_size",
+      "The number of cgroups pre-created in each hierarchy of the\n"
+      "'cgroups/cpu' and 'cgroups/mem' isolators, which are renamed to\n"
+      "the cgroups of the containers launched. The cgroups of the\n"
+      "terminated containers are then destroyed in the background\n"
+      "rather than before the containers are cleaned up. 0 disables\n"
+      "the pool.",
+      0);
+
+  add(&Flags::cgroups_enable_memory_reclaim,
+      "cgroups_enable_memory_reclaim",
+      "Cgroups feature flag to reclaim memory from the containers with\n"
+      "revocable resources when the slave is under medium or critical\n"
+      "memory pressure, by lowering their soft limits and, on critical\n"
+      "pressure, shrinking their page cache. This keeps the page cache\n"
+      "of the other containers and avoids OOM kills.\n",
+      false);
+
   add(&Flags::cgroups_cpu_enable_pids_and_tids_count,
       "cgroups_cpu_enable_pids_and_tids_count",
       "Cgroups feature flag to enable counting of processes and threads\n"
       "inside a container.\n",
       false);
 
+  add(&Flags::cgroups_net_cls_primary_handle,
+      "cgroups_net_cls_primary_handle",
+      "A non-zero, 16-bit handle of the form '0xAAAA'. If set, the\n"
+      "'cgroups/net_cls' isolator gives each container a unique net_cls\n"
+      "handle with this primary handle and a secondary handle from\n"
+      "'--cgroups_net_cls_secondary_handles'.");
+
+  add(&Flags::cgroups_net_cls_secondary_handles,
+      "cgroups_net_cls_secondary_handles",
+      "A range of the form '0xAAAA,0xBBBB' of the secondary handles used\n"
+      "with '--cgroups_net_cls_primary_handle'.",
+      "0x0001,0xffff");
+
   add(&Flags::slave_subsystems,
       "slave_subsystems",
       "List of comma-separated cgroup subsystems to run the slave binary\n"
@@ -379,6 +560,16 @@ mesos::internal::slave::Flags::Flags()
       "than the perf_interval.",
       Seconds(10));
 
+  add(&Flags::perf_counters,
+      "perf_counters",
+      "If true, the perf_event isolator opens the perf events of each\n"
+      "container with perf_event_open(2) once, and reads them every\n"
+      "perf_interval, rather than running 'perf stat' for perf_duration.\n"
+      "The samples then cover the whole perf_interval (perf_duration is\n"
+      "ignored) and the 'perf' binary is not needed. Only the events of\n"
+      "the PerfStatistics protobuf are supported.",
+      false);
+
   add(&Flags::revocable_cpu_low_priority,
       "revocable_cpu_low_priority",
       "Run containers with revocable CPU at a lower priority than\n"
@@ -431,6 +622,14 @@ mesos::internal::slave::Flags::Flags()
       "The path to the external containerizer executable used when\n"
       "external isolation is activated (--isolation=external).");
 
+  add(&Flags::containerizer_daemon,
+      "containerizer_daemon",
+      "Whether to keep the external containerizer executable running\n"
+      "(invoked once with the 'daemon' command) and to send it the\n"
+      "'usage' and 'update' commands over its stdin, rather than to\n"
+      "execute it for each of these commands.",
+      false);
+
   add(&Flags::containerizers,
       "containerizers",
       "Comma-separated list of containerizer implementations\n"
@@ -482,6 +681,16 @@ mesos::internal::slave::Flags::Flags()
       "path used by the slave's docker image.\n",
       "/var/run/docker.sock");
 
+  add(&Flags::docker_engine_api,
+      "docker_engine_api",
+      "Whether to talk to the docker daemon through the Docker Engine API\n"
+      "on `--docker_socket` to inspect, list, stop and remove containers,\n"
+      "rather than forking the docker CLI for each of them. This also\n"
+      "waits for containers to start by subscribing to docker events\n"
+      "instead of polling. Containers are still run and images still\n"
+      "pulled with the docker CLI.",
+      false);
+
   add(&Flags::sandbox_directory,
       "sandbox_directory",
       "The absolute path for the directory in the container where the\n"
@@ -571,8 +780,41 @@ mesos::internal::slave::Flags::Flags()
       "isolator.",
       false);
 
+  add(&Flags::network_namespace_statistics_interval,
+      "network_namespace_statistics_interval",
+      "Amount of time the statistics collected from inside the network\n"
+      "namespace of a container (i.e., the socket and traffic control\n"
+      "statistics) are reused for. Collecting them requires running a\n"
+      "helper process in the namespace, while the link statistics are\n"
+      "always collected from the host. Concurrent requests share a\n"
+      "collection that is in progress. This flag is used for the\n"
+      "'network/port_mapping' isolator.",
+      Duration::zero());
+
+  add(&Flags::network_enable_bpf_classifier,
+      "network_enable_bpf_classifier",
+      "Whether to redirect the IP packets received by host eth0 and host\n"
+      "lo to containers using one eBPF classifier on each of them, which\n"
+      "looks up the destination port in a map, rather than one u32\n"
+      "filter per port range of each container. The classifiers also\n"
+      "count the packets and bytes redirected to each container. This\n"
+      "requires kernel 4.4 or newer. The agent needs to be drained of\n"
+      "containers before changing this flag. This flag is used for the\n"
+      "'network/port_mapping' isolator.",
+      false);
+
 #endif // WITH_NETWORK_ISOLATOR
 
+#ifdef ENABLE_XFS_DISK_ISOLATOR
+  add(&Flags::xfs_project_range,
+      "xfs_project_range",
+      "The ranges of XFS project IDs to use for the sandboxes and the\n"
+      "persistent volumes of the containers. The IDs must not be used by\n"
+      "anything else on the filesystem. This flag is used for the\n"
+      "'xfs/disk' isolator.",
+      "[5000-10000]");
+#endif // ENABLE_XFS_DISK_ISOLATOR
+
   add(&Flags::container_disk_watch_interval,
       "container_disk_watch_interval",
       "The interval between disk quota checks for containers. This flag is\n"
@@ -670,4 +912,32 @@ mesos::internal::slave::Flags::Flags()
       "about the total amount of oversubscribed resources that are allocated\n"
       "and available. The interval between updates is controlled by this flag.",
       Seconds(15));
+
+  add(&Flags::oversubscribed_resources_delta,
+      "oversubscribed_resources_delta",
+      "The slave only updates the master with an estimation of the\n"
+      "oversubscribed resources whose amount of some (scalar) resource\n"
+      "differs from the last update by more than this fraction of it\n"
+      "(e.g., 0.1 for 10%), or which has different resources. This saves\n"
+      "the master (and its allocator) from handling the updates of small\n"
+      "fluctuations of the estimations. The default (0) forwards every\n"
+      "change of the estimation.",
+      0.0);
+
+  add(&Flags::resource_usage_cache_interval,
+      "resource_usage_cache_interval",
+      "Amount of time the resource statistics collected from a container\n"
+      "are reused for. The resource monitor, the resource estimator and the\n"
+      "QoS controller share the statistics collected within this interval\n"
+      "instead of each collecting them from the containerizer. Concurrent\n"
+      "requests always share a collection that is in progress.",
+      Duration::zero());
+
+  add(&Flags::statistics_feed_interval,
+      "statistics_feed_interval",
+      "If specified, the slave samples the resource statistics of its\n"
+      "containers at this interval and writes them into a ring buffer in\n"
+      "the memory-mapped file 'statistics' under the work directory. Local\n"
+      "processes (e.g., monitoring agents) can read the statistics from it\n"
+      "as often as they want without any requests to the slave.");
 }
@@ -46,26 +46,38 @@ public:
   Option<std::string> resources;
   std::string isolation;
   Option<std::string> launcher;
+  Option<size_t> max_concurrent_container_destroys;
 
   Option<std::string> image_providers;
   std::string image_provisioner_backend;
   std::string appc_store_dir;
+  Option<std::string> appc_simple_discovery_uri_prefix;
+  size_t appc_store_max_fetches;
 
   std::string docker_auth_server;
   std::string docker_puller_timeout_secs;
+  size_t docker_puller_max_downloads;
   std::string docker_registry;
   std::string docker_store_dir;
+  Option<Bytes> docker_store_max_size;
+  Option<std::string> docker_store_prefetch_images;
 
   std::string default_role;
   Option<std::string> attributes;
   Bytes fetcher_cache_size;
   std::string fetcher_cache_dir;
+  bool fetcher_cache_hardlinks;
+  size_t fetcher_download_parts;
+  Option<std::string> fetcher_peers;
   std::string work_dir;
+  std::string persistent_volume_backend;
   std::string launcher_dir;
   std::string hadoop_home; // TODO(benh): Make an Option.
+  Option<std::string> webhdfs_address;
 #ifndef __WINDOWS__
   bool switch_user;
 #endif // __WINDOWS__
+  bool shared_command_executor;
   std::string frameworks_home;  // TODO(benh): Make an Option.
   Duration registration_backoff_factor;
   Option<JSON::Object> executor_environment_variables;
@@ -80,23 +92,34 @@ public:
   std::string recover;
   Duration recovery_timeout;
   bool strict;
+  bool status_update_journal;
+  Duration status_update_batch_interval;
   Duration register_retry_interval_min;
 #ifdef __linux__
   std::string cgroups_hierarchy;
   std::string cgroups_root;
   bool cgroups_enable_cfs;
+  Duration cgroups_cfs_period;
+  Option<Duration> cgroups_revocable_cfs_period;
+  Option<double> cgroups_cfs_burst_factor;
   bool cgroups_limit_swap;
+  size_t cgroups_pool_size;
+  bool cgroups_enable_memory_reclaim;
   bool cgroups_cpu_enable_pids_and_tids_count;
+  Option<std::string> cgroups_net_cls_primary_handle;
+  std::string cgroups_net_cls_secondary_handles;
   Option<std::string> slave_subsystems;
   Option<std::string> perf_events;
   Duration perf_interval;
   Duration perf_duration;
+  bool perf_counters;
   bool revocable_cpu_low_priority;
   std::string systemd_runtime_directory;
 #endif
   Option<Firewall> firewall_rules;
   Option<Path> credential;
   Option<std::string> containerizer_path;
+  bool containerizer_daemon;
   std::string containerizers;
   Option<std::string> default_container_image;
   std::string docker;
@@ -107,6 +130,7 @@ public:
   Duration docker_stop_timeout;
   bool docker_kill_orphans;
   std::string docker_socket;
+  bool docker_engine_api;
 #ifdef WITH_NETWORK_ISOLATOR
   uint16_t ephemeral_ports_per_container;
   Option<std::string> eth0_name;
@@ -116,6 +140,11 @@ public:
   std::string egress_flow_classifier_parent;
   bool network_enable_socket_statistics_summary;
   bool network_enable_socket_statistics_details;
+  Duration network_namespace_statistics_interval;
+  bool network_enable_bpf_classifier;
+#endif
+#ifdef ENABLE_XFS_DISK_ISOLATOR
+  std::string xfs_project_range;
 #endif
   Duration container_disk_watch_interval;
   bool enforce_container_disk_quota;
@@ -126,6 +155,9 @@ public:
   Option<std::string> qos_controller;
   Duration qos_correction_interval_min;
   Duration oversubscribed_resources_interval;
+  double oversubscribed_resources_delta;
+  Duration resource_usage_cache_interval;
+  Option<Duration> statistics_feed_interval;
 };
 
 } // namespace slave {
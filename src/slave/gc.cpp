@@ -14,13 +14,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+
 #include <list>
 
+#include <process/async.hpp>
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
+#include <process/id.hpp>
+
+#include <process/metrics/metrics.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/uuid.hpp>
 
 #include "logging/logging.hpp"
 
@@ -38,12 +49,62 @@ namespace mesos {
 namespace internal {
 namespace slave {
 
+#ifdef __linux__
+// See 'linux/ioprio.h'.
+constexpr int IOPRIO_WHO_PROCESS = 1;
+constexpr int IOPRIO_CLASS_BE = 2;
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+
+// The lowest priority of the best effort class, which (unlike the
+// idle class) still makes progress on a busy disk.
+constexpr int IOPRIO_LOWEST = (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | 7;
+#endif // __linux__
+
+
+// Removes the path, with the lowest I/O priority (where supported)
+// so that the removal does not compete with the running tasks for
+// the disk. This is run in its own (libprocess) thread by 'async'.
+static Try<Nothing> removePath(const string& path)
+{
+#ifdef __linux__
+  // NOTE: The I/O priority applies to the calling thread, so it is
+  // restored once done as the thread is shared with other processes.
+  const long priority = ::syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+  if (priority >= 0) {
+    ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_LOWEST);
+  }
+#endif // __linux__
+
+  Try<Nothing> rmdir = os::rmdir(path);
+
+#ifdef __linux__
+  if (priority >= 0) {
+    ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, priority);
+  }
+#endif // __linux__
+
+  return rmdir;
+}
+
+
+GarbageCollectorProcess::GarbageCollectorProcess()
+  : ProcessBase(process::ID::generate("gc")),
+    metrics(*this) {}
+
 
 GarbageCollectorProcess::~GarbageCollectorProcess()
 {
   foreachvalue (const PathInfo& info, paths) {
     info.promise->discard();
   }
+
+  foreach (const Removal& removal, queued) {
+    removal.info.promise->discard();
+  }
+
+  foreachvalue (const Removal& removal, active) {
+    removal.info.promise->discard();
+  }
 }
 
 
@@ -124,28 +185,37 @@ void GarbageCollectorProcess::reset()
 
 void GarbageCollectorProcess::remove(const Timeout& removalTime)
 {
-  // TODO(bmahler): Other dispatches can block waiting for a removal
-  // operation. To fix this, the removal operation can be done
-  // asynchronously in another thread.
   if (paths.count(removalTime) > 0) {
     foreach (const PathInfo& info, paths.get(removalTime)) {
-      LOG(INFO) << "Deleting " << info.path;
-
-      Try<Nothing> rmdir = os::rmdir(info.path);
-
-      if (rmdir.isError()) {
-        LOG(WARNING) << "Failed to delete '" << info.path << "': "
-                     << rmdir.error();
-        info.promise->fail(rmdir.error());
+      // The path is renamed aside right away, so that it is free to
+      // be used again while the removal (which may take long for a
+      // large directory) is queued or in progress. The path is kept
+      // in its parent directory, i.e., in the same filesystem, under
+      // a hidden name so that it is not taken for a sandbox or the
+      // like while the slave recovers.
+      const Path original(info.path);
+      const string target = path::join(
+          original.dirname(),
+          "." + original.basename() + ".gc-" + UUID::random().toString());
+
+      Try<Nothing> rename = os::rename(info.path, target);
+      if (rename.isError()) {
+        // Remove the path in place, e.g., if it does not exist (so
+        // that the removal fails as expected) or is a mount point.
+        VLOG(1) << "Failed to rename '" << info.path << "' for gc: "
+                << rename.error();
+
+        queued.push_back(Removal(info, info.path));
       } else {
-        LOG(INFO) << "Deleted '" << info.path << "'";
-        info.promise->set(rmdir.get());
+        queued.push_back(Removal(info, target));
       }
 
       timeouts.erase(info.path);
     }
 
     paths.remove(removalTime);
+
+    _remove();
   } else {
     // This occurs when either:
     //   1. The path(s) has already been removed (e.g. by prune()).
@@ -158,6 +228,54 @@ void GarbageCollectorProcess::remove(const Timeout& removalTime)
 }
 
 
+void GarbageCollectorProcess::_remove()
+{
+  // The paths are removed in other (libprocess) threads rather than
+  // here, so that removing a large directory does not hold up the
+  // other dispatches to this process.
+  while (active.size() < MAX_REMOVALS && !queued.empty()) {
+    const Removal removal = queued.front();
+    queued.pop_front();
+
+    LOG(INFO) << "Deleting " << removal.info.path;
+
+    active.put(removal.target, removal);
+
+    async(&removePath, removal.target)
+      .onAny(defer(self(), &Self::__remove, removal.target, lambda::_1));
+  }
+}
+
+
+void GarbageCollectorProcess::__remove(
+    const string& target,
+    const Future<Try<Nothing>>& rmdir)
+{
+  CHECK(active.contains(target));
+
+  const PathInfo info = active.at(target).info;
+  active.erase(target);
+
+  if (!rmdir.isReady() || rmdir.get().isError()) {
+    const string error = rmdir.isReady()
+      ? rmdir.get().error()
+      : (rmdir.isFailed() ? rmdir.failure() : "discarded");
+
+    LOG(WARNING) << "Failed to delete '" << info.path << "': " << error;
+    info.promise->fail(error);
+
+    ++metrics.path_removals_failed;
+  } else {
+    LOG(INFO) << "Deleted '" << info.path << "'";
+    info.promise->set(Nothing());
+
+    ++metrics.path_removals_succeeded;
+  }
+
+  _remove();
+}
+
+
 void GarbageCollectorProcess::prune(const Duration& d)
 {
   foreach (const Timeout& removalTime, paths.keys()) {
@@ -170,6 +288,33 @@ void GarbageCollectorProcess::prune(const Duration& d)
 }
 
 
+GarbageCollectorProcess::Metrics::Metrics(
+    const GarbageCollectorProcess& gc)
+  : path_removals_pending(
+        "gc/path_removals_pending",
+        defer(gc, &GarbageCollectorProcess::_path_removals_pending)),
+    path_removals_active(
+        "gc/path_removals_active",
+        defer(gc, &GarbageCollectorProcess::_path_removals_active)),
+    path_removals_succeeded("gc/path_removals_succeeded"),
+    path_removals_failed("gc/path_removals_failed")
+{
+  process::metrics::add(path_removals_pending);
+  process::metrics::add(path_removals_active);
+  process::metrics::add(path_removals_succeeded);
+  process::metrics::add(path_removals_failed);
+}
+
+
+GarbageCollectorProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(path_removals_pending);
+  process::metrics::remove(path_removals_active);
+  process::metrics::remove(path_removals_succeeded);
+  process::metrics::remove(path_removals_failed);
+}
+
+
 GarbageCollector::GarbageCollector()
 {
   process = new GarbageCollectorProcess();
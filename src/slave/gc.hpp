@@ -17,6 +17,7 @@
 #ifndef __SLAVE_GC_HPP__
 #define __SLAVE_GC_HPP__
 
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,9 @@
 #include <process/timeout.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/multimap.hpp>
@@ -86,6 +90,11 @@ class GarbageCollectorProcess :
     public process::Process<GarbageCollectorProcess>
 {
 public:
+  // The maximum number of paths which are removed at the same time.
+  static const size_t MAX_REMOVALS = 4;
+
+  GarbageCollectorProcess();
+
   virtual ~GarbageCollectorProcess();
 
   process::Future<Nothing> schedule(
@@ -101,6 +110,17 @@ private:
 
   void remove(const process::Timeout& removalTime);
 
+  // Starts the removal of the queued paths, as long as there are
+  // less than MAX_REMOVALS in progress.
+  void _remove();
+
+  void __remove(
+      const std::string& target,
+      const process::Future<Try<Nothing>>& rmdir);
+
+  double _path_removals_pending() { return timeouts.size(); }
+  double _path_removals_active() { return queued.size() + active.size(); }
+
   struct PathInfo
   {
     PathInfo(const std::string& _path,
@@ -125,7 +145,35 @@ private:
   // it exists in our paths mapping.
   hashmap<std::string, process::Timeout> timeouts;
 
+  // A path which is due for removal, along with the path it has
+  // been renamed to (see 'remove').
+  struct Removal
+  {
+    Removal(const PathInfo& _info, const std::string& _target)
+      : info(_info), target(_target) {}
+
+    PathInfo info;
+    std::string target;
+  };
+
+  // The paths which are due for removal but wait for one of the
+  // MAX_REMOVALS removals in progress to complete, and the removals
+  // in progress keyed by the path being removed.
+  std::deque<Removal> queued;
+  hashmap<std::string, Removal> active;
+
   process::Timer timer;
+
+  struct Metrics
+  {
+    explicit Metrics(const GarbageCollectorProcess& gc);
+    ~Metrics();
+
+    process::metrics::Gauge path_removals_pending;
+    process::metrics::Gauge path_removals_active;
+    process::metrics::Counter path_removals_succeeded;
+    process::metrics::Counter path_removals_failed;
+  } metrics;
 };
 
 } // namespace slave {
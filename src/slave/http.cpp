@@ -34,9 +34,11 @@
 
 #include <stout/foreach.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
+#include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
@@ -84,101 +86,96 @@ namespace internal {
 namespace slave {
 
 
-// Pull in defnitions from common.
-using mesos::internal::model;
-
 // Pull in the process definitions.
 using process::http::Response;
 using process::http::Request;
 
 
-JSON::Object model(const TaskInfo& task)
+// Writes a queued task. This is a function rather than a 'json'
+// overload since 'TaskInfo' would otherwise pick up the (generic)
+// protobuf one through argument dependent lookup.
+static void json(JSON::ObjectWriter* writer, const TaskInfo& task)
 {
-  JSON::Object object;
-  object.values["id"] = task.task_id().value();
-  object.values["name"] = task.name();
-  object.values["slave_id"] = task.slave_id().value();
-  object.values["resources"] = model(task.resources());
+  writer->field("id", task.task_id().value());
+  writer->field("name", task.name());
+  writer->field("slave_id", task.slave_id().value());
+  writer->field("resources", Resources(task.resources()));
 
   if (task.has_command()) {
-    object.values["command"] = model(task.command());
+    writer->field("command", task.command());
   }
   if (task.has_executor()) {
-    object.values["executor_id"] = task.executor().executor_id().value();
+    writer->field("executor_id", task.executor().executor_id().value());
   }
   if (task.has_discovery()) {
-    object.values["discovery"] = JSON::protobuf(task.discovery());
+    writer->field("discovery", task.discovery());
   }
-
-  return object;
 }
 
 
-JSON::Object model(const Executor& executor)
+void json(JSON::ObjectWriter* writer, const Executor& executor)
 {
-  JSON::Object object;
-  object.values["id"] = executor.id.value();
-  object.values["name"] = executor.info.name();
-  object.values["source"] = executor.info.source();
-  object.values["container"] = executor.containerId.value();
-  object.values["directory"] = executor.directory;
-  object.values["resources"] = model(executor.resources);
-
-  JSON::Array tasks;
-  foreach (Task* task, executor.launchedTasks.values()) {
-    tasks.values.push_back(model(*task));
-  }
-  object.values["tasks"] = tasks;
-
-  JSON::Array queued;
-  foreach (const TaskInfo& task, executor.queuedTasks.values()) {
-    queued.values.push_back(model(task));
-  }
-  object.values["queued_tasks"] = queued;
+  writer->field("id", executor.id.value());
+  writer->field("name", executor.info.name());
+  writer->field("source", executor.info.source());
+  writer->field("container", executor.containerId.value());
+  writer->field("directory", executor.directory);
+  writer->field("resources", executor.resources);
+
+  writer->field("tasks", [&executor](JSON::ArrayWriter* writer) {
+    foreach (Task* task, executor.launchedTasks.values()) {
+      writer->element(*task);
+    }
+  });
 
-  JSON::Array completed;
-  foreach (const std::shared_ptr<Task>& task, executor.completedTasks) {
-    completed.values.push_back(model(*task));
-  }
+  writer->field("queued_tasks", [&executor](JSON::ArrayWriter* writer) {
+    foreach (const TaskInfo& task, executor.queuedTasks.values()) {
+      writer->element([&task](JSON::ObjectWriter* writer) {
+        json(writer, task);
+      });
+    }
+  });
 
-  // NOTE: We add 'terminatedTasks' to 'completed_tasks' for
-  // simplicity.
-  // TODO(vinod): Use foreachvalue instead once LinkedHashmap
-  // supports it.
-  foreach (Task* task, executor.terminatedTasks.values()) {
-    completed.values.push_back(model(*task));
-  }
-  object.values["completed_tasks"] = completed;
+  writer->field("completed_tasks", [&executor](JSON::ArrayWriter* writer) {
+    foreach (const std::shared_ptr<Task>& task, executor.completedTasks) {
+      writer->element(*task);
+    }
 
-  return object;
+    // NOTE: We add 'terminatedTasks' to 'completed_tasks' for
+    // simplicity.
+    // TODO(vinod): Use foreachvalue instead once LinkedHashmap
+    // supports it.
+    foreach (Task* task, executor.terminatedTasks.values()) {
+      writer->element(*task);
+    }
+  });
 }
 
 
-// Returns a JSON object modeled after a Framework.
-JSON::Object model(const Framework& framework)
+void json(JSON::ObjectWriter* writer, const Framework& framework)
 {
-  JSON::Object object;
-  object.values["id"] = framework.id().value();
-  object.values["name"] = framework.info.name();
-  object.values["user"] = framework.info.user();
-  object.values["failover_timeout"] = framework.info.failover_timeout();
-  object.values["checkpoint"] = framework.info.checkpoint();
-  object.values["role"] = framework.info.role();
-  object.values["hostname"] = framework.info.hostname();
-
-  JSON::Array executors;
-  foreachvalue (Executor* executor, framework.executors) {
-    executors.values.push_back(model(*executor));
-  }
-  object.values["executors"] = executors;
-
-  JSON::Array completedExecutors;
-  foreach (const Owned<Executor>& executor, framework.completedExecutors) {
-    completedExecutors.values.push_back(model(*executor));
-  }
-  object.values["completed_executors"] = completedExecutors;
-
-  return object;
+  writer->field("id", framework.id().value());
+  writer->field("name", framework.info.name());
+  writer->field("user", framework.info.user());
+  writer->field("failover_timeout", framework.info.failover_timeout());
+  writer->field("checkpoint", framework.info.checkpoint());
+  writer->field("role", framework.info.role());
+  writer->field("hostname", framework.info.hostname());
+
+  writer->field("executors", [&framework](JSON::ArrayWriter* writer) {
+    foreachvalue (Executor* executor, framework.executors) {
+      writer->element(*executor);
+    }
+  });
+
+  writer->field(
+      "completed_executors",
+      [&framework](JSON::ArrayWriter* writer) {
+        foreach (const Owned<Executor>& executor,
+                 framework.completedExecutors) {
+          writer->element(*executor);
+        }
+      });
 }
 
 
@@ -326,6 +323,19 @@ Future<Response> Slave::Http::executor(const Request& request) const
       return Accepted();
     }
 
+    case executor::Call::UPDATES: {
+      foreach (const executor::Call::Update& update,
+               call.updates().updates()) {
+        slave->statusUpdate(protobuf::createStatusUpdate(
+            call.framework_id(),
+            update.status(),
+            slave->info.id()),
+            None());
+      }
+
+      return Accepted();
+    }
+
     case executor::Call::MESSAGE: {
       slave->executorMessage(
           slave->info.id(),
@@ -353,20 +363,18 @@ string Slave::Http::FLAGS_HELP()
 
 Future<Response> Slave::Http::flags(const Request& request) const
 {
-  JSON::Object object;
-
-  {
-    JSON::Object flags;
-    foreachpair (const string& name, const flags::Flag& flag, slave->flags) {
-      Option<string> value = flag.stringify(slave->flags);
-      if (value.isSome()) {
-        flags.values[name] = value.get();
+  auto object = [this](JSON::ObjectWriter* writer) {
+    writer->field("flags", [this](JSON::ObjectWriter* writer) {
+      foreachpair (const string& name, const flags::Flag& flag, slave->flags) {
+        Option<string> value = flag.stringify(slave->flags);
+        if (value.isSome()) {
+          writer->field(name, value.get());
+        }
       }
-    }
-    object.values["flags"] = std::move(flags);
-  }
+    });
+  };
 
-  return OK(object, request.url.query.get("jsonp"));
+  return OK(jsonify(object), request.url.query.get("jsonp"));
 }
 
 
@@ -393,74 +401,82 @@ string Slave::Http::STATE_HELP() {
         "Information about state of the Slave."),
     DESCRIPTION(
         "This endpoint shows information about the frameworks, executors",
-        "and the slave's master as a JSON object."));
+        "and the slave's master as a JSON object.",
+        "",
+        "The response carries an 'ETag' header. Requests that pass it",
+        "back in an 'If-None-Match' header get a '304 Not Modified'",
+        "response (without a body) as long as the state is unchanged."));
 }
 
 
 Future<Response> Slave::Http::state(const Request& request) const
 {
-  JSON::Object object;
-  object.values["version"] = MESOS_VERSION;
-
-  if (build::GIT_SHA.isSome()) {
-    object.values["git_sha"] = build::GIT_SHA.get();
-  }
+  auto state = [this](JSON::ObjectWriter* writer) {
+    writer->field("version", MESOS_VERSION);
 
-  if (build::GIT_BRANCH.isSome()) {
-    object.values["git_branch"] = build::GIT_BRANCH.get();
-  }
+    if (build::GIT_SHA.isSome()) {
+      writer->field("git_sha", build::GIT_SHA.get());
+    }
 
-  if (build::GIT_TAG.isSome()) {
-    object.values["git_tag"] = build::GIT_TAG.get();
-  }
+    if (build::GIT_BRANCH.isSome()) {
+      writer->field("git_branch", build::GIT_BRANCH.get());
+    }
 
-  object.values["build_date"] = build::DATE;
-  object.values["build_time"] = build::TIME;
-  object.values["build_user"] = build::USER;
-  object.values["start_time"] = slave->startTime.secs();
-  object.values["id"] = slave->info.id().value();
-  object.values["pid"] = string(slave->self());
-  object.values["hostname"] = slave->info.hostname();
-  object.values["resources"] = model(slave->info.resources());
-  object.values["attributes"] = model(slave->info.attributes());
-
-  if (slave->master.isSome()) {
-    Try<string> hostname = net::getHostname(slave->master.get().address.ip);
-    if (hostname.isSome()) {
-      object.values["master_hostname"] = hostname.get();
+    if (build::GIT_TAG.isSome()) {
+      writer->field("git_tag", build::GIT_TAG.get());
     }
-  }
 
-  if (slave->flags.log_dir.isSome()) {
-    object.values["log_dir"] = slave->flags.log_dir.get();
-  }
+    writer->field("build_date", build::DATE);
+    writer->field("build_time", build::TIME);
+    writer->field("build_user", build::USER);
+    writer->field("start_time", slave->startTime.secs());
+    writer->field("id", slave->info.id().value());
+    writer->field("pid", string(slave->self()));
+    writer->field("hostname", slave->info.hostname());
+    writer->field("resources", Resources(slave->info.resources()));
+    writer->field("attributes", Attributes(slave->info.attributes()));
+
+    if (slave->master.isSome()) {
+      Try<string> hostname = net::getHostname(slave->master.get().address.ip);
+      if (hostname.isSome()) {
+        writer->field("master_hostname", hostname.get());
+      }
+    }
 
-  if (slave->flags.external_log_file.isSome()) {
-    object.values["external_log_file"] = slave->flags.external_log_file.get();
-  }
+    if (slave->flags.log_dir.isSome()) {
+      writer->field("log_dir", slave->flags.log_dir.get());
+    }
 
-  JSON::Array frameworks;
-  foreachvalue (Framework* framework, slave->frameworks) {
-    frameworks.values.push_back(model(*framework));
-  }
-  object.values["frameworks"] = frameworks;
+    if (slave->flags.external_log_file.isSome()) {
+      writer->field("external_log_file", slave->flags.external_log_file.get());
+    }
 
-  JSON::Array completedFrameworks;
-  foreach (const Owned<Framework>& framework, slave->completedFrameworks) {
-    completedFrameworks.values.push_back(model(*framework));
-  }
-  object.values["completed_frameworks"] = completedFrameworks;
+    writer->field("frameworks", [this](JSON::ArrayWriter* writer) {
+      foreachvalue (Framework* framework, slave->frameworks) {
+        writer->element(*framework);
+      }
+    });
 
-  JSON::Object flags;
-  foreachpair (const string& name, const flags::Flag& flag, slave->flags) {
-    Option<string> value = flag.stringify(slave->flags);
-    if (value.isSome()) {
-      flags.values[name] = value.get();
-    }
-  }
-  object.values["flags"] = flags;
+    writer->field("completed_frameworks", [this](JSON::ArrayWriter* writer) {
+      foreach (const Owned<Framework>& framework, slave->completedFrameworks) {
+        writer->element(*framework);
+      }
+    });
+
+    writer->field("flags", [this](JSON::ObjectWriter* writer) {
+      foreachpair (const string& name, const flags::Flag& flag, slave->flags) {
+        Option<string> value = flag.stringify(slave->flags);
+        if (value.isSome()) {
+          writer->field(name, value.get());
+        }
+      }
+    });
+  };
 
-  return OK(object, request.url.query.get("jsonp"));
+  // NOTE: The state is rendered in full rather than streamed (see
+  // 'stream') since its entity tag is sent before the body. Pollers
+  // passing the tag back then get no body while the state is unchanged.
+  return tagged(request, jsonify(state), request.url.query.get("jsonp"));
 }
 
 } // namespace slave {
@@ -27,11 +27,16 @@
 
 #include <process/owned.hpp>
 
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
 #include <stout/check.hpp>
+#include <stout/duration.hpp>
 #include <stout/flags.hpp>
 #include <stout/hashset.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
@@ -157,6 +162,12 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  // NOTE: The modules and the hooks are loaded before libprocess is
+  // initialized, hence they are timed with a 'Stopwatch' rather than
+  // with a metric (which uses the libprocess clock).
+  Stopwatch stopwatch;
+  stopwatch.start();
+
   // Initialize modules. Note that since other subsystems may depend
   // upon modules, we should initialize modules before anything else.
   if (flags.modules.isSome()) {
@@ -174,6 +185,8 @@ int main(int argc, char** argv)
     }
   }
 
+  stopwatch.stop();
+
   // Initialize libprocess.
   if (ip_discovery_command.isSome() && ip.isSome()) {
     EXIT(EXIT_FAILURE) << flags.usage(
@@ -220,8 +233,20 @@ int main(int argc, char** argv)
     LOG(INFO) << "Git SHA: " << build::GIT_SHA.get();
   }
 
+  LOG(INFO) << "Loaded the modules and hooks in " << stopwatch.elapsed();
+
+  // Time the creation of the containerizer (i.e., of the isolators,
+  // the launcher and the provisioner) which is usually the slowest
+  // part of the startup before the recovery.
+  process::metrics::Timer<Milliseconds> startupContainerizer(
+      "slave/startup_containerizer");
+
+  process::metrics::add(startupContainerizer);
+
   Fetcher fetcher;
 
+  startupContainerizer.start();
+
   Try<Containerizer*> containerizer =
     Containerizer::create(flags, false, &fetcher);
 
@@ -230,6 +255,9 @@ int main(int argc, char** argv)
       << "Failed to create a containerizer: " << containerizer.error();
   }
 
+  LOG(INFO) << "Created the containerizer in "
+            << startupContainerizer.stop();
+
   Try<MasterDetector*> detector = MasterDetector::create(master.get());
 
   if (detector.isError()) {
@@ -320,5 +348,7 @@ int main(int argc, char** argv)
 
   delete containerizer.get();
 
+  process::metrics::remove(startupContainerizer);
+
   return EXIT_SUCCESS;
 }
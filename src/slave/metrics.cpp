@@ -41,6 +41,16 @@ Metrics::Metrics(const Slave& slave)
         defer(slave, &Slave::_registered)),
     recovery_errors(
         "slave/recovery_errors"),
+    recovery_state(
+        "slave/recovery_state"),
+    recovery_status_update_manager(
+        "slave/recovery_status_update_manager"),
+    recovery_containerizer(
+        "slave/recovery_containerizer"),
+    recovery_executors(
+        "slave/recovery_executors"),
+    recovery(
+        "slave/recovery"),
     frameworks_active(
         "slave/frameworks_active",
         defer(slave, &Slave::_frameworks_active)),
@@ -93,6 +103,11 @@ Metrics::Metrics(const Slave& slave)
   process::metrics::add(registered);
 
   process::metrics::add(recovery_errors);
+  process::metrics::add(recovery_state);
+  process::metrics::add(recovery_status_update_manager);
+  process::metrics::add(recovery_containerizer);
+  process::metrics::add(recovery_executors);
+  process::metrics::add(recovery);
 
   process::metrics::add(frameworks_active);
 
@@ -178,6 +193,11 @@ Metrics::~Metrics()
   process::metrics::remove(registered);
 
   process::metrics::remove(recovery_errors);
+  process::metrics::remove(recovery_state);
+  process::metrics::remove(recovery_status_update_manager);
+  process::metrics::remove(recovery_containerizer);
+  process::metrics::remove(recovery_executors);
+  process::metrics::remove(recovery);
 
   process::metrics::remove(frameworks_active);
 
@@ -21,6 +21,9 @@
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
 
 
 namespace mesos {
@@ -40,6 +43,16 @@ struct Metrics
 
   process::metrics::Counter recovery_errors;
 
+  // Time spent in each phase of the recovery, i.e., reading the
+  // checkpointed state, recovering the status update manager and the
+  // containerizer (which happen concurrently) and waiting for the
+  // executors to reregister, as well as the recovery in total.
+  process::metrics::Timer<Milliseconds> recovery_state;
+  process::metrics::Timer<Milliseconds> recovery_status_update_manager;
+  process::metrics::Timer<Milliseconds> recovery_containerizer;
+  process::metrics::Timer<Milliseconds> recovery_executors;
+  process::metrics::Timer<Milliseconds> recovery;
+
   process::metrics::Gauge frameworks_active;
 
   process::metrics::Gauge tasks_staging;
@@ -18,19 +18,27 @@
 
 #include <glog/logging.h>
 
+#include <mesos/type_utils.hpp>
+
 #include <process/collect.hpp>
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/help.hpp>
 #include <process/http.hpp>
 #include <process/limiter.hpp>
 #include <process/process.hpp>
+#include <process/time.hpp>
 
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/lambda.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/protobuf.hpp>
 
 #include "slave/monitor.hpp"
+#include "slave/statistics_feed.hpp"
 
 using namespace process;
 
@@ -80,11 +88,15 @@ static const string STATISTICS_HELP()
 class ResourceMonitorProcess : public Process<ResourceMonitorProcess>
 {
 public:
-  explicit ResourceMonitorProcess(
-      const lambda::function<Future<ResourceUsage>()>& _usage)
+  ResourceMonitorProcess(
+      const lambda::function<Future<ResourceUsage>()>& _usage,
+      const Option<string>& _feedPath,
+      const Duration& _interval)
     : ProcessBase("monitor"),
       usage(_usage),
-      limiter(2, Seconds(1)) {} // 2 permits per second.
+      limiter(2, Seconds(1)), // 2 permits per second.
+      feedPath(_feedPath),
+      interval(_interval) {}
 
   virtual ~ResourceMonitorProcess() {}
 
@@ -100,6 +112,31 @@ protected:
     route("/statistics",
           STATISTICS_HELP(),
           &ResourceMonitorProcess::statistics);
+
+    if (feedPath.isSome()) {
+      Try<Nothing> mkdir = os::mkdir(Path(feedPath.get()).dirname());
+      if (mkdir.isError()) {
+        LOG(ERROR) << "Failed to create the directory of the statistics feed: "
+                   << mkdir.error();
+        return;
+      }
+
+      Try<Owned<StatisticsFeed>> create =
+        StatisticsFeed::create(feedPath.get());
+
+      if (create.isError()) {
+        LOG(ERROR) << "Failed to create the statistics feed: "
+                   << create.error();
+        return;
+      }
+
+      feed = create.get();
+
+      LOG(INFO) << "Writing the resource statistics into '" << feedPath.get()
+                << "' every " << interval;
+
+      sample();
+    }
   }
 
 private:
@@ -112,7 +149,7 @@ private:
 
   Future<http::Response> _statistics(const http::Request& request)
   {
-    return usage()
+    return collect()
       .then(defer(self(), &Self::__statistics, lambda::_1, request));
   }
 
@@ -127,25 +164,91 @@ private:
       return http::InternalServerError();
     }
 
-    JSON::Array result;
+    const ResourceUsage& usage = future.get();
 
-    foreach (const ResourceUsage::Executor& executor,
-             future.get().executors()) {
-      if (executor.has_statistics()) {
-        const ExecutorInfo info = executor.executor_info();
+    auto statistics = [&usage](JSON::ArrayWriter* writer) {
+      foreach (const ResourceUsage::Executor& executor, usage.executors()) {
+        if (!executor.has_statistics()) {
+          continue;
+        }
 
-        JSON::Object entry;
-        entry.values["framework_id"] = info.framework_id().value();
-        entry.values["executor_id"] = info.executor_id().value();
-        entry.values["executor_name"] = info.name();
-        entry.values["source"] = info.source();
-        entry.values["statistics"] = JSON::protobuf(executor.statistics());
+        writer->element([&executor](JSON::ObjectWriter* writer) {
+          const ExecutorInfo& info = executor.executor_info();
 
-        result.values.push_back(entry);
+          writer->field("framework_id", info.framework_id().value());
+          writer->field("executor_id", info.executor_id().value());
+          writer->field("executor_name", info.name());
+          writer->field("source", info.source());
+          writer->field("statistics", executor.statistics());
+        });
       }
+    };
+
+    return http::OK(jsonify(statistics), request.url.query.get("jsonp"));
+  }
+
+  // Returns the latest resource usage if it is still fresh, i.e., if
+  // it is being collected, or if it was collected by the sampling loop
+  // (which keeps it fresh) or within the last 'interval'. This way the
+  // requests of frequent (or concurrent) scrapers share collections.
+  Future<ResourceUsage> collect()
+  {
+    if (latest.isNone() ||
+        latest.get().isFailed() ||
+        latest.get().isDiscarded() ||
+        (feed.get() == NULL &&
+         latest.get().isReady() &&
+         Clock::now() - collected >= interval)) {
+      latest = usage();
+      collected = Clock::now();
     }
 
-    return http::OK(result, request.url.query.get("jsonp"));
+    return latest.get();
+  }
+
+  void sample()
+  {
+    latest = usage();
+    collected = Clock::now();
+
+    latest.get()
+      .onAny(defer(self(), &Self::_sample, lambda::_1));
+  }
+
+  void _sample(const Future<ResourceUsage>& future)
+  {
+    if (!future.isReady()) {
+      LOG(WARNING) << "Could not collect resource usage: "
+                   << (future.isFailed() ? future.failure() : "discarded");
+    } else {
+      foreach (const ResourceUsage::Executor& executor,
+               future.get().executors()) {
+        if (!executor.has_statistics()) {
+          continue;
+        }
+
+        // Only the IDs are kept from the executor info so that the
+        // records are small.
+        ResourceUsage::Executor record;
+        ExecutorInfo* info = record.mutable_executor_info();
+        info->mutable_executor_id()->CopyFrom(
+            executor.executor_info().executor_id());
+        info->mutable_framework_id()->CopyFrom(
+            executor.executor_info().framework_id());
+        info->mutable_command();
+        record.mutable_container_id()->CopyFrom(executor.container_id());
+        record.mutable_statistics()->CopyFrom(executor.statistics());
+
+        Try<Nothing> write = feed->write(record);
+        if (write.isError()) {
+          VLOG(1) << "Failed to write the statistics of container '"
+                  << executor.container_id() << "' into the feed: "
+                  << write.error();
+        }
+      }
+    }
+
+    delay(interval, self(), &Self::sample);
   }
 
   // Callback used to retrieve resource usage information from slave.
@@ -153,12 +256,23 @@ private:
 
   // Used to rate limit the statistics endpoint.
   RateLimiter limiter;
+
+  const Option<string> feedPath;
+  const Duration interval;
+  Owned<StatisticsFeed> feed;
+
+  // The latest resource usage, which is shared by the requests and
+  // the sampling loop, see 'collect'.
+  Option<Future<ResourceUsage>> latest;
+  Time collected;
 };
 
 
 ResourceMonitor::ResourceMonitor(
-    const lambda::function<Future<ResourceUsage>()>& usage)
-  : process(new ResourceMonitorProcess(usage))
+    const lambda::function<Future<ResourceUsage>()>& usage,
+    const Option<string>& feed,
+    const Duration& interval)
+  : process(new ResourceMonitorProcess(usage, feed, interval))
 {
   spawn(process.get());
 }
@@ -17,12 +17,16 @@
 #ifndef __SLAVE_MONITOR_HPP__
 #define __SLAVE_MONITOR_HPP__
 
+#include <string>
+
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/lambda.hpp>
+#include <stout/option.hpp>
 
 namespace mesos {
 namespace internal {
@@ -32,12 +36,18 @@ namespace slave {
 class ResourceMonitorProcess;
 
 
-// Exposes resources usage information via a JSON endpoint.
+// Exposes resources usage information via a JSON endpoint. If 'feed'
+// is specified, the statistics are also sampled every 'interval' and
+// written into the 'StatisticsFeed' at that path. The endpoint serves
+// the latest sample, or else the usage collected for a request within
+// the last 'interval'.
 class ResourceMonitor
 {
 public:
   explicit ResourceMonitor(
-      const lambda::function<process::Future<ResourceUsage>()>& usage);
+      const lambda::function<process::Future<ResourceUsage>()>& usage,
+      const Option<std::string>& feed = None(),
+      const Duration& interval = Seconds(1));
 
   ~ResourceMonitor();
 
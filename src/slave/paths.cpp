@@ -43,6 +43,7 @@ namespace paths {
 // File names.
 const char BOOT_ID_FILE[] = "boot_id";
 const char SLAVE_INFO_FILE[] = "slave.info";
+const char STATUS_UPDATE_JOURNAL_FILE[] = "status.updates";
 const char FRAMEWORK_PID_FILE[] = "framework.pid";
 const char FRAMEWORK_INFO_FILE[] = "framework.info";
 const char LIBPROCESS_PID_FILE[] = "libprocess.pid";
@@ -50,6 +51,7 @@ const char EXECUTOR_INFO_FILE[] = "executor.info";
 const char EXECUTOR_SENTINEL_FILE[] = "executor.sentinel";
 const char HTTP_MARKER_FILE[] = "http.marker";
 const char FORKED_PID_FILE[] = "forked.pid";
+const char TASKS_INFO_FILE[] = "tasks.info";
 const char TASK_INFO_FILE[] = "task.info";
 const char TASK_UPDATES_FILE[] = "task.updates";
 const char RESOURCES_INFO_FILE[] = "resources.info";
@@ -79,6 +81,12 @@ string getArchiveDir(const string& rootDir)
 }
 
 
+string getStatisticsFeedPath(const string& rootDir)
+{
+  return path::join(rootDir, "statistics");
+}
+
+
 string getBootIdPath(const string& rootDir)
 {
   return path::join(rootDir, BOOT_ID_FILE);
@@ -107,6 +115,15 @@ string getSlaveInfoPath(
 }
 
 
+string getStatusUpdateJournalPath(
+    const string& rootDir,
+    const SlaveID& slaveId)
+{
+  return path::join(
+      getSlavePath(rootDir, slaveId), STATUS_UPDATE_JOURNAL_FILE);
+}
+
+
 Try<list<string>> getFrameworkPaths(
     const string& rootDir,
     const SlaveID& slaveId)
@@ -297,6 +314,24 @@ string getForkedPidPath(
 }
 
 
+string getTasksInfoPath(
+    const string& rootDir,
+    const SlaveID& slaveId,
+    const FrameworkID& frameworkId,
+    const ExecutorID& executorId,
+    const ContainerID& containerId)
+{
+  return path::join(
+      getExecutorRunPath(
+          rootDir,
+          slaveId,
+          frameworkId,
+          executorId,
+          containerId),
+      TASKS_INFO_FILE);
+}
+
+
 Try<list<string>> getTaskPaths(
     const string& rootDir,
     const SlaveID& slaveId,
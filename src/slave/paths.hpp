@@ -63,6 +63,7 @@ namespace paths {
 //   |       |-- latest (symlink)
 //   |       |-- <slave_id>
 //   |           |-- slave.info
+//   |           |-- status.updates (if '--status_update_journal')
 //   |           |-- frameworks
 //   |               |-- <framework_id>
 //   |                   |-- framework.info
@@ -77,9 +78,10 @@ namespace paths {
 //   |                                   |-- pids
 //   |                                   |   |-- forked.pid
 //   |                                   |   |-- libprocess.pid
+//   |                                   |-- tasks.info
 //   |                                   |-- tasks
 //   |                                       |-- <task_id>
-//   |                                           |-- task.info
+//   |                                           |-- task.info (old slaves)
 //   |                                           |-- task.updates
 //   |-- boot_id
 //   |-- resources
@@ -89,6 +91,7 @@ namespace paths {
 //   |       |-- <role>
 //   |           |-- <persistence_id> (persistent volume)
 //   |-- provisioner
+//   |-- statistics (if '--statistics_feed_interval')
 
 const char LATEST_SYMLINK[] = "latest";
 
@@ -106,6 +109,9 @@ std::string getProvisionerDir(const std::string& rootDir);
 std::string getArchiveDir(const std::string& rootDir);
 
 
+std::string getStatisticsFeedPath(const std::string& rootDir);
+
+
 std::string getLatestSlavePath(const std::string& rootDir);
 
 
@@ -122,6 +128,11 @@ std::string getSlavePath(
     const SlaveID& slaveId);
 
 
+std::string getStatusUpdateJournalPath(
+    const std::string& rootDir,
+    const SlaveID& slaveId);
+
+
 Try<std::list<std::string>> getFrameworkPaths(
     const std::string& rootDir,
     const SlaveID& slaveId);
@@ -219,6 +230,16 @@ std::string getForkedPidPath(
     const ContainerID& containerId);
 
 
+// The tasks of an executor run are checkpointed into a single file,
+// one record per task, rather than into a file per task.
+std::string getTasksInfoPath(
+    const std::string& rootDir,
+    const SlaveID& slaveId,
+    const FrameworkID& frameworkId,
+    const ExecutorID& executorId,
+    const ContainerID& containerId);
+
+
 std::string getContainerRootfsPath(
     const std::string& rootDir,
     const SlaveID& slaveId,
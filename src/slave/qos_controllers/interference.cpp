@@ -0,0 +1,506 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <list>
+#include <string>
+#include <utility>
+
+#include <mesos/resources.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <mesos/module/qos_controller.hpp>
+
+#include <mesos/slave/qos_controller.hpp>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/linkedhashmap.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+
+#include "slave/qos_controllers/interference.hpp"
+
+using namespace mesos;
+using namespace process;
+
+using std::list;
+using std::pair;
+using std::string;
+
+using mesos::modules::Module;
+
+using mesos::slave::QoSController;
+using mesos::slave::QoSCorrection;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The minimum CPU share a best-effort executor is throttled to.
+constexpr double MIN_THROTTLED_CPUS = 0.01;
+
+
+// Returns the cycles per instruction of a perf sample.
+static Option<double> cpi(const ResourceStatistics& statistics)
+{
+  if (!statistics.has_perf() ||
+      !statistics.perf().has_cycles() ||
+      !statistics.perf().has_instructions() ||
+      statistics.perf().instructions() == 0) {
+    return None();
+  }
+
+  return (double) statistics.perf().cycles() /
+         statistics.perf().instructions();
+}
+
+
+// Returns the number of last level cache misses of a perf sample,
+// falling back to the generic cache misses event.
+static Option<double> misses(const ResourceStatistics& statistics)
+{
+  if (!statistics.has_perf()) {
+    return None();
+  } else if (statistics.perf().has_llc_load_misses()) {
+    return (double) statistics.perf().llc_load_misses();
+  } else if (statistics.perf().has_cache_misses()) {
+    return (double) statistics.perf().cache_misses();
+  }
+
+  return None();
+}
+
+
+// Returns the cache misses per thousand instructions of a perf sample.
+static Option<double> mpki(const ResourceStatistics& statistics)
+{
+  Option<double> _misses = misses(statistics);
+  if (_misses.isNone() ||
+      !statistics.perf().has_instructions() ||
+      statistics.perf().instructions() == 0) {
+    return None();
+  }
+
+  return _misses.get() * 1000 / statistics.perf().instructions();
+}
+
+
+// Returns the CPU usage (in CPUs) between two samples.
+static Option<double> cpuUsage(
+    const ResourceStatistics& previous,
+    const ResourceStatistics& current)
+{
+  const double interval = current.timestamp() - previous.timestamp();
+  if (interval <= 0) {
+    return None();
+  }
+
+  const double time =
+    (current.cpus_user_time_secs() + current.cpus_system_time_secs()) -
+    (previous.cpus_user_time_secs() + previous.cpus_system_time_secs());
+
+  return std::max(time, 0.0) / interval;
+}
+
+
+class InterferenceQoSControllerProcess
+  : public Process<InterferenceQoSControllerProcess>
+{
+public:
+  InterferenceQoSControllerProcess(
+      const lambda::function<Future<ResourceUsage>()>& _usage,
+      const InterferenceQoSController::Thresholds& _thresholds)
+    : usage(_usage),
+      thresholds(_thresholds),
+      interfered(0),
+      released(0) {}
+
+  Future<list<QoSCorrection>> corrections()
+  {
+    return usage().then(defer(self(), &Self::_corrections, lambda::_1));
+  }
+
+  Future<list<QoSCorrection>> _corrections(const ResourceUsage& usage)
+  {
+    hashmap<ContainerID, ResourceStatistics> current;
+    hashmap<ContainerID, ResourceUsage::Executor> bestEffort;
+
+    bool interference = false;
+
+    foreach (const ResourceUsage::Executor& executor, usage.executors()) {
+      if (!executor.has_container_id() || !executor.has_statistics()) {
+        continue;
+      }
+
+      const ContainerID& containerId = executor.container_id();
+      const ResourceStatistics& statistics = executor.statistics();
+
+      current[containerId] = statistics;
+
+      if (!Resources(executor.allocated()).revocable().empty()) {
+        bestEffort[containerId] = executor;
+        continue;
+      }
+
+      if (interfering(executor, previous.get(containerId))) {
+        interference = true;
+      }
+    }
+
+    // Forget the executors which have terminated.
+    foreach (const ContainerID& containerId, throttled.keys()) {
+      if (!bestEffort.contains(containerId)) {
+        throttled.erase(containerId);
+      }
+    }
+
+    list<QoSCorrection> corrections;
+
+    if (interference) {
+      released = 0;
+      interfered++;
+
+      // Evict the throttled executors which did not relieve the
+      // interference.
+      foreach (const ContainerID& containerId, throttled.keys()) {
+        Throttled& entry = throttled[containerId];
+
+        if (++entry.samples >= thresholds.evictSamples) {
+          const ResourceUsage::Executor& executor = bestEffort[containerId];
+
+          LOG(INFO) << "Evicting container '" << containerId
+                    << "' of executor '"
+                    << executor.executor_info().executor_id()
+                    << "' which still interferes after being throttled";
+
+          corrections.push_back(kill(executor));
+          throttled.erase(containerId);
+          bestEffort.erase(containerId);
+        }
+      }
+
+      if (interfered >= thresholds.triggerSamples) {
+        Option<ContainerID> target = None();
+        pair<double, double> highest(-1, -1);
+
+        foreachpair (const ContainerID& containerId,
+                     const ResourceUsage::Executor& executor,
+                     bestEffort) {
+          if (throttled.contains(containerId)) {
+            continue;
+          }
+
+          Option<double> _cpuUsage = None();
+          if (previous.contains(containerId)) {
+            _cpuUsage =
+              cpuUsage(previous[containerId], executor.statistics());
+          }
+
+          // Prefer the cache miss rate and use the CPU usage for
+          // executors without perf statistics.
+          const ResourceStatistics& statistics = executor.statistics();
+          Option<double> _misses = misses(statistics);
+
+          pair<double, double> score(
+              _misses.isSome() && statistics.perf().duration() > 0
+                ? _misses.get() / statistics.perf().duration()
+                : 0,
+              _cpuUsage.getOrElse(0));
+
+          if (score > highest) {
+            target = containerId;
+            highest = score;
+          }
+        }
+
+        if (target.isSome()) {
+          const ResourceUsage::Executor& executor = bestEffort[target.get()];
+
+          Option<double> cpus = Resources(executor.allocated()).cpus();
+
+          Throttled entry;
+          entry.cpus = std::max(
+              cpus.getOrElse(0) * thresholds.throttleFactor,
+              MIN_THROTTLED_CPUS);
+          entry.samples = 0;
+
+          LOG(INFO) << "Throttling container '" << target.get()
+                    << "' of executor '"
+                    << executor.executor_info().executor_id()
+                    << "' to " << entry.cpus << " cpus after "
+                    << interfered << " samples with interference";
+
+          throttled[target.get()] = entry;
+        }
+
+        interfered = 0;
+      }
+    } else {
+      interfered = 0;
+      released++;
+
+      if (!throttled.empty() && released >= thresholds.releaseSamples) {
+        // Lift the most recent throttle first.
+        const ContainerID containerId = throttled.keys().back();
+
+        LOG(INFO) << "Lifting the throttle on container '" << containerId
+                  << "' after " << released << " samples without "
+                  << "interference";
+
+        corrections.push_back(throttle(bestEffort[containerId], None()));
+        throttled.erase(containerId);
+
+        released = 0;
+      }
+    }
+
+    // The throttles are sent on every interval as they are undone
+    // whenever the resources of an executor change.
+    foreach (const ContainerID& containerId, throttled.keys()) {
+      corrections.push_back(
+          throttle(bestEffort[containerId], throttled[containerId].cpus));
+    }
+
+    previous = current;
+
+    return corrections;
+  }
+
+private:
+  struct Throttled
+  {
+    double cpus;
+
+    // Number of samples with interference since being throttled.
+    size_t samples;
+  };
+
+  bool interfering(
+      const ResourceUsage::Executor& executor,
+      const Option<ResourceStatistics>& previous)
+  {
+    const ResourceStatistics& statistics = executor.statistics();
+    const ExecutorID& executorId = executor.executor_info().executor_id();
+
+    Option<double> _cpi = cpi(statistics);
+    if (thresholds.cpi.isSome() && _cpi.isSome() &&
+        _cpi.get() > thresholds.cpi.get()) {
+      LOG(INFO) << "Cycles per instruction " << _cpi.get()
+                << " of executor '" << executorId
+                << "' exceeds threshold " << thresholds.cpi.get();
+      return true;
+    }
+
+    Option<double> _mpki = mpki(statistics);
+    if (thresholds.mpki.isSome() && _mpki.isSome() &&
+        _mpki.get() > thresholds.mpki.get()) {
+      LOG(INFO) << "Cache misses per thousand instructions " << _mpki.get()
+                << " of executor '" << executorId
+                << "' exceeds threshold " << thresholds.mpki.get();
+      return true;
+    }
+
+    if (thresholds.memoryPressure &&
+        previous.isSome() &&
+        statistics.mem_critical_pressure_counter() >
+          previous.get().mem_critical_pressure_counter()) {
+      LOG(INFO) << "Executor '" << executorId
+                << "' is under critical memory pressure";
+      return true;
+    }
+
+    return false;
+  }
+
+  static QoSCorrection kill(const ResourceUsage::Executor& executor)
+  {
+    QoSCorrection correction;
+    correction.set_type(QoSCorrection::KILL);
+
+    QoSCorrection::Kill* kill = correction.mutable_kill();
+    kill->mutable_framework_id()->CopyFrom(
+        executor.executor_info().framework_id());
+    kill->mutable_executor_id()->CopyFrom(
+        executor.executor_info().executor_id());
+    kill->mutable_container_id()->CopyFrom(executor.container_id());
+
+    return correction;
+  }
+
+  static QoSCorrection throttle(
+      const ResourceUsage::Executor& executor,
+      const Option<double>& cpus)
+  {
+    QoSCorrection correction;
+    correction.set_type(QoSCorrection::THROTTLE);
+
+    QoSCorrection::Throttle* throttle = correction.mutable_throttle();
+    throttle->mutable_framework_id()->CopyFrom(
+        executor.executor_info().framework_id());
+    throttle->mutable_executor_id()->CopyFrom(
+        executor.executor_info().executor_id());
+    throttle->mutable_container_id()->CopyFrom(executor.container_id());
+
+    if (cpus.isSome()) {
+      throttle->set_cpus(cpus.get());
+    }
+
+    return correction;
+  }
+
+  const lambda::function<Future<ResourceUsage>()> usage;
+  const InterferenceQoSController::Thresholds thresholds;
+
+  // The samples of the previous interval, used for the counters
+  // which are cumulative.
+  hashmap<ContainerID, ResourceStatistics> previous;
+
+  // The throttled best-effort executors in throttling order.
+  LinkedHashMap<ContainerID, Throttled> throttled;
+
+  // Number of consecutive samples with interference since the last
+  // throttle.
+  size_t interfered;
+
+  // Number of consecutive samples without interference since the
+  // last throttle was lifted.
+  size_t released;
+};
+
+
+InterferenceQoSController::~InterferenceQoSController()
+{
+  if (process.get() != NULL) {
+    terminate(process.get());
+    wait(process.get());
+  }
+}
+
+
+Try<Nothing> InterferenceQoSController::initialize(
+  const lambda::function<Future<ResourceUsage>()>& usage)
+{
+  if (process.get() != NULL) {
+    return Error("Interference QoS Controller has already been initialized");
+  }
+
+  process.reset(new InterferenceQoSControllerProcess(usage, thresholds));
+
+  spawn(process.get());
+
+  return Nothing();
+}
+
+
+Future<list<QoSCorrection>> InterferenceQoSController::corrections()
+{
+  if (process.get() == NULL) {
+    return Failure("Interference QoS Controller is not initialized");
+  }
+
+  return dispatch(
+      process.get(),
+      &InterferenceQoSControllerProcess::corrections);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+
+static QoSController* create(const Parameters& parameters)
+{
+  using mesos::internal::slave::InterferenceQoSController;
+
+  InterferenceQoSController::Thresholds thresholds;
+
+  for (const Parameter& parameter : parameters.parameter()) {
+    const string& key = parameter.key();
+
+    if (key == "cpi_threshold" ||
+        key == "mpki_threshold" ||
+        key == "throttle_factor") {
+      Try<double> value = numify<double>(parameter.value());
+      if (value.isError() || value.get() <= 0) {
+        LOG(ERROR) << "Failed to parse '" << key << "': "
+                   << (value.isError() ? value.error() : "must be positive");
+        return NULL;
+      }
+
+      if (key == "cpi_threshold") {
+        thresholds.cpi = value.get();
+      } else if (key == "mpki_threshold") {
+        thresholds.mpki = value.get();
+      } else if (value.get() > 1) {
+        LOG(ERROR) << "Failed to parse '" << key << "': must not exceed 1";
+        return NULL;
+      } else {
+        thresholds.throttleFactor = value.get();
+      }
+    } else if (key == "trigger_samples" ||
+               key == "release_samples" ||
+               key == "evict_samples") {
+      Try<size_t> value = numify<size_t>(parameter.value());
+      if (value.isError() || value.get() == 0) {
+        LOG(ERROR) << "Failed to parse '" << key << "': "
+                   << (value.isError() ? value.error() : "must be positive");
+        return NULL;
+      }
+
+      if (key == "trigger_samples") {
+        thresholds.triggerSamples = value.get();
+      } else if (key == "release_samples") {
+        thresholds.releaseSamples = value.get();
+      } else {
+        thresholds.evictSamples = value.get();
+      }
+    } else if (key == "memory_pressure") {
+      if (parameter.value() != "true" && parameter.value() != "false") {
+        LOG(ERROR) << "Failed to parse '" << key << "': expecting a boolean";
+        return NULL;
+      }
+
+      thresholds.memoryPressure = parameter.value() == "true";
+    }
+  }
+
+  if (thresholds.cpi.isNone() &&
+      thresholds.mpki.isNone() &&
+      !thresholds.memoryPressure) {
+    LOG(ERROR) << "No interference signals are enabled for "
+               << "InterferenceQoSController";
+    return NULL;
+  }
+
+  return new InterferenceQoSController(thresholds);
+}
+
+
+Module<QoSController> org_apache_mesos_InterferenceQoSController(
+    MESOS_MODULE_API_VERSION,
+    MESOS_VERSION,
+    "Apache Mesos",
+    "modules@mesos.apache.org",
+    "Interference QoS Controller Module.",
+    NULL,
+    create);
@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SLAVE_QOS_CONTROLLERS_INTERFERENCE_HPP__
+#define __SLAVE_QOS_CONTROLLERS_INTERFERENCE_HPP__
+
+#include <list>
+
+#include <mesos/slave/qos_controller.hpp>
+
+#include <stout/lambda.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class InterferenceQoSControllerProcess;
+
+
+// The `InterferenceQoSController` protects latency critical executors
+// (i.e., those with no revocable resources) from best-effort ones
+// (i.e., those with revocable resources). On every correction
+// interval it looks at the samples of the latency critical executors
+// and considers them interfered with when:
+//   - cycles per instruction is above `cpi_threshold`, or
+//   - last level cache misses per thousand instructions is above
+//     `mpki_threshold`, or
+//   - the critical memory pressure counter has increased.
+// The perf based signals require the perf statistics to be sampled
+// (see `--perf_events`).
+//
+// Once interference has been observed for `trigger_samples`
+// consecutive intervals, the best-effort executor with the highest
+// cache miss rate (or CPU usage, without perf statistics) is
+// throttled to `throttle_factor` of its allocated CPUs. A throttled
+// executor is evicted if interference persists for `evict_samples`
+// more intervals, and the throttles are lifted, one per
+// `release_samples` consecutive intervals without interference.
+class InterferenceQoSController : public mesos::slave::QoSController
+{
+public:
+  struct Thresholds
+  {
+    Thresholds()
+      : memoryPressure(true),
+        triggerSamples(3),
+        releaseSamples(5),
+        evictSamples(3),
+        throttleFactor(0.1) {}
+
+    Option<double> cpi;
+    Option<double> mpki;
+    bool memoryPressure;
+
+    size_t triggerSamples;
+    size_t releaseSamples;
+    size_t evictSamples;
+    double throttleFactor;
+  };
+
+  explicit InterferenceQoSController(const Thresholds& _thresholds)
+    : thresholds(_thresholds) {}
+
+  virtual ~InterferenceQoSController();
+
+  virtual Try<Nothing> initialize(
+    const lambda::function<process::Future<ResourceUsage>()>& usage);
+
+  virtual process::Future<std::list<mesos::slave::QoSCorrection>> corrections();
+
+private:
+  const Thresholds thresholds;
+  process::Owned<InterferenceQoSControllerProcess> process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_QOS_CONTROLLERS_INTERFERENCE_HPP__
@@ -0,0 +1,369 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <mesos/resources.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <mesos/module/resource_estimator.hpp>
+
+#include <mesos/slave/resource_estimator.hpp>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+#include <process/timeseries.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/strings.hpp>
+
+#include "slave/resource_estimators/usage.hpp"
+
+using namespace mesos;
+using namespace process;
+
+using std::string;
+using std::vector;
+
+using mesos::modules::Module;
+
+using mesos::slave::ResourceEstimator;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Returns the CPU usage (in CPUs) between two samples.
+static Option<double> cpuUsage(
+    const ResourceStatistics& previous,
+    const ResourceStatistics& current)
+{
+  const double interval = current.timestamp() - previous.timestamp();
+  if (interval <= 0) {
+    return None();
+  }
+
+  const double time =
+    (current.cpus_user_time_secs() + current.cpus_system_time_secs()) -
+    (previous.cpus_user_time_secs() + previous.cpus_system_time_secs());
+
+  return std::max(time, 0.0) / interval;
+}
+
+
+// Returns a revocable scalar resource, rounded down to two decimals
+// so that tiny amounts of slack are not offered.
+static Option<Resource> revocable(const string& name, double value)
+{
+  value = floor(value * 100) / 100;
+  if (value <= 0) {
+    return None();
+  }
+
+  Resource resource = Resources::parse(name, stringify(value), "*").get();
+  resource.mutable_revocable();
+
+  return resource;
+}
+
+
+class UsageResourceEstimatorProcess
+  : public Process<UsageResourceEstimatorProcess>
+{
+public:
+  UsageResourceEstimatorProcess(
+      const lambda::function<Future<ResourceUsage>()>& _usage,
+      const UsageResourceEstimator::Options& _options)
+    : usage(_usage),
+      options(_options) {}
+
+  Future<Resources> oversubscribable()
+  {
+    return usage().then(defer(self(), &Self::_oversubscribable, lambda::_1));
+  }
+
+  Future<Resources> _oversubscribable(const ResourceUsage& usage)
+  {
+    Resources allocatedRevocable;
+    hashset<ContainerID> running;
+
+    double slackCpus = 0;
+    double slackMem = 0;
+
+    foreach (const ResourceUsage::Executor& executor, usage.executors()) {
+      const Resources allocated = executor.allocated();
+
+      // Revocable executors, including the ones with regular
+      // resources, are never a source of slack.
+      if (!allocated.revocable().empty()) {
+        allocatedRevocable += allocated.revocable();
+        continue;
+      }
+
+      if (!executor.has_statistics()) {
+        continue;
+      }
+
+      const ContainerID& containerId = executor.container_id();
+      const ResourceStatistics& statistics = executor.statistics();
+
+      running.insert(containerId);
+
+      if (!containers.contains(containerId)) {
+        containers.put(containerId, Container(options.window));
+      }
+
+      Container& container = containers.at(containerId);
+
+      if (container.previous.isSome()) {
+        Option<double> cpus = cpuUsage(container.previous.get(), statistics);
+        if (cpus.isSome()) {
+          container.cpus.set(cpus.get());
+        }
+      }
+
+      if (statistics.has_mem_rss_bytes()) {
+        container.mem.set(
+            Bytes(statistics.mem_rss_bytes()).megabytes());
+      }
+
+      container.previous = statistics;
+
+      Option<double> cpus = allocated.cpus();
+      Option<double> usedCpus = percentile(container.cpus);
+      if (cpus.isSome() && usedCpus.isSome()) {
+        slackCpus += std::max(
+            cpus.get() * (1 - options.headroom) - usedCpus.get(), 0.0);
+      }
+
+      Option<Bytes> mem = allocated.mem();
+      Option<double> usedMem = percentile(container.mem);
+      if (mem.isSome() && usedMem.isSome()) {
+        slackMem += std::max(
+            mem.get().megabytes() * (1 - options.headroom) - usedMem.get(),
+            0.0);
+      }
+    }
+
+    // Forget the containers which have terminated.
+    foreach (const ContainerID& containerId, containers.keys()) {
+      if (!running.contains(containerId)) {
+        containers.erase(containerId);
+      }
+    }
+
+    Resources totalRevocable;
+
+    Option<Resource> cpus = revocable("cpus", slackCpus);
+    if (options.resources.contains("cpus") && cpus.isSome()) {
+      totalRevocable += cpus.get();
+    }
+
+    Option<Resource> mem = revocable("mem", slackMem);
+    if (options.resources.contains("mem") && mem.isSome()) {
+      totalRevocable += mem.get();
+    }
+
+    VLOG(1) << "Estimated " << totalRevocable << " of unused resources "
+            << "over the last " << options.window;
+
+    return totalRevocable - allocatedRevocable;
+  }
+
+private:
+  struct Container
+  {
+    explicit Container(const Duration& window)
+      : cpus(window),
+        mem(window) {}
+
+    // The previous sample, for the cumulative CPU times.
+    Option<ResourceStatistics> previous;
+
+    // CPU usage in CPUs.
+    TimeSeries<double> cpus;
+
+    // Memory usage in megabytes.
+    TimeSeries<double> mem;
+  };
+
+  // Returns the configured percentile of the values of a time series
+  // within the window, or None if there are not enough samples.
+  Option<double> percentile(const TimeSeries<double>& series) const
+  {
+    const Time start = Clock::now() - options.window;
+
+    vector<double> values;
+    foreach (const TimeSeries<double>::Value& value, series.get(start)) {
+      values.push_back(value.data);
+    }
+
+    if (values.empty() || values.size() < options.minSamples) {
+      return None();
+    }
+
+    std::sort(values.begin(), values.end());
+
+    size_t index = (size_t) ceil(options.percentile / 100 * values.size());
+
+    return values[std::min(std::max(index, (size_t) 1), values.size()) - 1];
+  }
+
+  const lambda::function<Future<ResourceUsage>()> usage;
+  const UsageResourceEstimator::Options options;
+
+  hashmap<ContainerID, Container> containers;
+};
+
+
+UsageResourceEstimator::~UsageResourceEstimator()
+{
+  if (process.get() != NULL) {
+    terminate(process.get());
+    wait(process.get());
+  }
+}
+
+
+Try<Nothing> UsageResourceEstimator::initialize(
+    const lambda::function<Future<ResourceUsage>()>& usage)
+{
+  if (process.get() != NULL) {
+    return Error("Usage resource estimator has already been initialized");
+  }
+
+  process.reset(new UsageResourceEstimatorProcess(usage, options));
+  spawn(process.get());
+
+  return Nothing();
+}
+
+
+Future<Resources> UsageResourceEstimator::oversubscribable()
+{
+  if (process.get() == NULL) {
+    return Failure("Usage resource estimator is not initialized");
+  }
+
+  return dispatch(
+      process.get(),
+      &UsageResourceEstimatorProcess::oversubscribable);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+
+static bool compatible()
+{
+  return true;
+}
+
+
+static ResourceEstimator* create(const Parameters& parameters)
+{
+  using mesos::internal::slave::UsageResourceEstimator;
+
+  UsageResourceEstimator::Options options;
+
+  foreach (const Parameter& parameter, parameters.parameter()) {
+    const string& key = parameter.key();
+
+    if (key == "resources") {
+      options.resources.clear();
+
+      foreach (const string& name, strings::tokenize(parameter.value(), ",")) {
+        if (name != "cpus" && name != "mem") {
+          LOG(ERROR) << "Unsupported resource '" << name << "' for "
+                     << "UsageResourceEstimator";
+          return NULL;
+        }
+
+        options.resources.insert(name);
+      }
+    } else if (key == "window") {
+      Try<Duration> window = Duration::parse(parameter.value());
+      if (window.isError()) {
+        LOG(ERROR) << "Failed to parse '" << key << "': " << window.error();
+        return NULL;
+      }
+
+      options.window = window.get();
+    } else if (key == "percentile" || key == "headroom") {
+      Try<double> value = numify<double>(parameter.value());
+      if (value.isError()) {
+        LOG(ERROR) << "Failed to parse '" << key << "': " << value.error();
+        return NULL;
+      }
+
+      if (key == "percentile") {
+        if (value.get() <= 0 || value.get() > 100) {
+          LOG(ERROR) << "Failed to parse '" << key << "': "
+                     << "must be in (0, 100]";
+          return NULL;
+        }
+
+        options.percentile = value.get();
+      } else {
+        if (value.get() < 0 || value.get() >= 1) {
+          LOG(ERROR) << "Failed to parse '" << key << "': "
+                     << "must be in [0, 1)";
+          return NULL;
+        }
+
+        options.headroom = value.get();
+      }
+    } else if (key == "min_samples") {
+      Try<size_t> value = numify<size_t>(parameter.value());
+      if (value.isError()) {
+        LOG(ERROR) << "Failed to parse '" << key << "': " << value.error();
+        return NULL;
+      }
+
+      options.minSamples = value.get();
+    }
+  }
+
+  if (options.resources.empty()) {
+    LOG(ERROR) << "No resources are configured for UsageResourceEstimator";
+    return NULL;
+  }
+
+  return new UsageResourceEstimator(options);
+}
+
+
+Module<ResourceEstimator> org_apache_mesos_UsageResourceEstimator(
+    MESOS_MODULE_API_VERSION,
+    MESOS_VERSION,
+    "Apache Mesos",
+    "modules@mesos.apache.org",
+    "Usage Resource Estimator Module.",
+    compatible,
+    create);
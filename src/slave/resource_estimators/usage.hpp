@@ -0,0 +1,89 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SLAVE_RESOURCE_ESTIMATORS_USAGE_HPP__
+#define __SLAVE_RESOURCE_ESTIMATORS_USAGE_HPP__
+
+#include <string>
+
+#include <mesos/slave/resource_estimator.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
+
+#include <process/owned.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class UsageResourceEstimatorProcess;
+
+
+// A resource estimator which oversubscribes the resources that the
+// regular (i.e., non revocable) executors are allocated but do not
+// use. The usage of each container is recorded in a time series and
+// the slack of a container is its allocation, less a headroom, minus
+// the given percentile of its usage over the window. Containers with
+// fewer than `minSamples` samples in the window are not considered.
+class UsageResourceEstimator : public mesos::slave::ResourceEstimator
+{
+public:
+  struct Options
+  {
+    Options()
+      : window(Minutes(5)),
+        percentile(95),
+        headroom(0.1),
+        minSamples(3)
+    {
+      resources.insert("cpus");
+    }
+
+    // The resources to oversubscribe, among `cpus` and `mem`.
+    hashset<std::string> resources;
+
+    Duration window;
+    double percentile;
+
+    // Fraction of the allocation which is never oversubscribed.
+    double headroom;
+
+    size_t minSamples;
+  };
+
+  explicit UsageResourceEstimator(const Options& _options)
+    : options(_options) {}
+
+  virtual ~UsageResourceEstimator();
+
+  virtual Try<Nothing> initialize(
+      const lambda::function<process::Future<ResourceUsage>()>& usage);
+
+  virtual process::Future<Resources> oversubscribable();
+
+private:
+  const Options options;
+  process::Owned<UsageResourceEstimatorProcess> process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_RESOURCE_ESTIMATORS_USAGE_HPP__
@@ -19,6 +19,7 @@
 #include <stdlib.h> // For random().
 
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <list>
 #include <map>
@@ -65,6 +66,7 @@
 #ifdef __linux__
 #include "linux/cgroups.hpp"
 #include "linux/fs.hpp"
+#include "linux/numa.hpp"
 #endif // __linux__
 
 #include "authentication/cram_md5/authenticatee.hpp"
@@ -87,6 +89,7 @@
 #include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/status_update_manager.hpp"
+#include "slave/volumes.hpp"
 
 using mesos::executor::Call;
 
@@ -133,7 +136,12 @@ Slave::Slave(const slave::Flags& _flags,
     files(_files),
     metrics(*this),
     gc(_gc),
-    monitor(defer(self(), &Self::usage)),
+    monitor(
+        defer(self(), &Self::usage),
+        flags.statistics_feed_interval.isSome()
+          ? Option<string>(paths::getStatisticsFeedPath(flags.work_dir))
+          : None(),
+        flags.statistics_feed_interval.getOrElse(Seconds(1))),
     statusUpdateManager(_statusUpdateManager),
     masterPingTimeout(DEFAULT_MASTER_PING_TIMEOUT()),
     metaDir(paths::getMetaRootDir(flags.work_dir)),
@@ -302,6 +310,11 @@ void Slave::initialize()
   }
 #endif // __linux__
 
+  Try<Nothing> backend = volumes::validate(flags.persistent_volume_backend);
+  if (backend.isError()) {
+    EXIT(1) << backend.error() << " (see --persistent_volume_backend flag)";
+  }
+
   if (flags.registration_backoff_factor > REGISTER_RETRY_INTERVAL_MAX) {
     EXIT(1) << "Invalid value '" << flags.registration_backoff_factor << "' "
             << "for --registration_backoff_factor: "
@@ -354,6 +367,12 @@ void Slave::initialize()
     EXIT(1) << "Failed to determine slave resources: " << resources.error();
   }
 
+#ifdef __linux__
+  // The mount table is read (at most) once for all of the `MOUNT`
+  // disk sources, and only if there is one.
+  Option<fs::MountTable> mountTable;
+#endif // __linux__
+
   // Ensure disk `source`s are accessible.
   foreach (
       const Resource& resource,
@@ -394,11 +413,14 @@ void Slave::initialize()
           << (realpath.isError() ? realpath.error() : "no such path");
       }
 
-      // TODO(jmlvanre): Consider moving this out of the for loop.
-      Try<fs::MountTable> mountTable = fs::MountTable::read("/proc/mounts");
-      if (mountTable.isError()) {
-        EXIT(1) << "Failed to open mount table to verify mounts: "
-                << mountTable.error();
+      if (mountTable.isNone()) {
+        Try<fs::MountTable> read = fs::MountTable::read("/proc/mounts");
+        if (read.isError()) {
+          EXIT(1) << "Failed to open mount table to verify mounts: "
+                  << read.error();
+        }
+
+        mountTable = read.get();
       }
 
       bool foundEntry = false;
@@ -429,6 +451,45 @@ void Slave::initialize()
     attributes = Attributes::parse(flags.attributes.get());
   }
 
+#ifdef __linux__
+  // Expose the NUMA topology when containers are pinned to NUMA
+  // nodes, so that frameworks can choose the slaves on which their
+  // tasks fit in a single node. The attributes set by the operator
+  // take precedence.
+  if (strings::contains(flags.isolation, "cgroups/cpuset")) {
+    Try<vector<numa::Node>> nodes = numa::nodes();
+    if (nodes.isError()) {
+      LOG(WARNING) << "Failed to get the NUMA topology: " << nodes.error();
+    } else {
+      size_t cpus = nodes.get().front().cpus.size();
+      Bytes memory = nodes.get().front().memory;
+      foreach (const numa::Node& node, nodes.get()) {
+        cpus = std::min(cpus, node.cpus.size());
+        memory = std::min(memory, node.memory);
+      }
+
+      hashmap<string, string> topology;
+      topology["numa_nodes"] = stringify(nodes.get().size());
+      topology["numa_node_cpus"] = stringify(cpus);
+      topology["numa_node_mem"] = stringify(memory.megabytes());
+
+      foreachpair (const string& name, const string& value, topology) {
+        bool found = false;
+        foreach (const Attribute& attribute, attributes) {
+          if (attribute.name() == name) {
+            found = true;
+            break;
+          }
+        }
+
+        if (!found) {
+          attributes.add(Attributes::parse(name, value));
+        }
+      }
+    }
+  }
+#endif // __linux__
+
   // Determine our hostname or use the hostname provided.
   string hostname;
 
@@ -504,6 +565,9 @@ void Slave::initialize()
       &RunTaskMessage::pid,
       &RunTaskMessage::task);
 
+  install<RunTasksMessage>(
+      &Slave::runTaskBatch);
+
   install<KillTaskMessage>(
       &Slave::killTask,
       &KillTaskMessage::framework_id,
@@ -541,6 +605,9 @@ void Slave::initialize()
       &StatusUpdateAcknowledgementMessage::task_id,
       &StatusUpdateAcknowledgementMessage::uuid);
 
+  install<StatusUpdateAcknowledgementsMessage>(
+      &Slave::statusUpdateAcknowledgements);
+
   install<RegisterExecutorMessage>(
       &Slave::registerExecutor,
       &RegisterExecutorMessage::framework_id,
@@ -558,6 +625,9 @@ void Slave::initialize()
       &StatusUpdateMessage::update,
       &StatusUpdateMessage::pid);
 
+  install<StatusUpdatesMessage>(
+      &Slave::statusUpdates);
+
   install<ExecutorToFrameworkMessage>(
       &Slave::executorMessage,
       &ExecutorToFrameworkMessage::slave_id,
@@ -655,9 +725,10 @@ void Slave::initialize()
   }
 
   // Do recovery.
-  async(&state::recover, metaDir, flags.strict)
-    .then(defer(self(), &Slave::recover, lambda::_1))
-    .then(defer(self(), &Slave::_recover))
+  metrics.recovery.time(
+      metrics.recovery_state.time(async(&state::recover, metaDir, flags.strict))
+        .then(defer(self(), &Slave::recover, lambda::_1))
+        .then(defer(self(), &Slave::_recover)))
     .onAny(defer(self(), &Slave::__recover, lambda::_1));
 }
 
@@ -753,6 +824,28 @@ void Slave::fileAttached(const Future<Nothing>& result, const string& path)
 }
 
 
+void Slave::attachFetcherCache(const SlaveID& slaveId)
+{
+  if (flags.fetcher_peers.isNone()) {
+    return;
+  }
+
+  // The directory is (re)created by the fetcher as needed, but it
+  // has to exist to be attached.
+  const string directory = Fetcher::getSharedCacheDirectory(slaveId, flags);
+
+  Try<Nothing> mkdir = os::mkdir(directory);
+  if (mkdir.isError()) {
+    LOG(ERROR) << "Failed to create fetcher cache directory '" << directory
+               << "': " << mkdir.error();
+    return;
+  }
+
+  files->attach(directory, FETCHER_CACHE_VIRTUAL_PATH)
+    .onAny(defer(self(), &Self::fileAttached, lambda::_1, directory));
+}
+
+
 // TODO(vinod/bmahler): Get rid of this helper.
 Nothing Slave::detachFile(const string& path)
 {
@@ -784,13 +877,16 @@ void Slave::detected(const Future<Option<MasterInfo>>& _master)
     LOG(INFO) << "Re-detecting master";
     latest = None();
     master = None();
+    masterId = None();
   } else if (_master.get().isNone()) {
     LOG(INFO) << "Lost leading master";
     latest = None();
     master = None();
+    masterId = None();
   } else {
     latest = _master.get();
     master = UPID(_master.get().get().pid());
+    masterId = _master.get().get().id();
 
     LOG(INFO) << "New master detected at " << master.get();
     link(master.get());
@@ -978,7 +1074,10 @@ void Slave::registered(
                    << recovered.error();
       }
 
+      attachFetcherCache(slaveId);
+
       state = RUNNING;
+      registeredMasterId = masterId;
 
       statusUpdateManager->resume(); // Resume status updates.
 
@@ -1035,6 +1134,8 @@ void Slave::registered(
         oversubscribedResources.get());
 
     send(master.get(), message);
+
+    forwardedOversubscribedResources = oversubscribedResources;
   }
 }
 
@@ -1069,6 +1170,7 @@ void Slave::reregistered(
     case DISCONNECTED:
       LOG(INFO) << "Re-registered with master " << master.get();
       state = RUNNING;
+      registeredMasterId = masterId;
       statusUpdateManager->resume(); // Resume status updates.
 
       // If we don't get a ping from the master, trigger a
@@ -1112,6 +1214,8 @@ void Slave::reregistered(
         oversubscribedResources.get());
 
     send(master.get(), message);
+
+    forwardedOversubscribedResources = oversubscribedResources;
   }
 
   // Reconcile any tasks per the master's request.
@@ -1153,7 +1257,7 @@ void Slave::reregistered(
             taskId,
             TASK_LOST,
             TaskStatus::SOURCE_SLAVE,
-            UUID::random(),
+            UUID::sequential(),
             "Reconciliation: task unknown to the slave",
             TaskStatus::REASON_RECONCILIATION);
 
@@ -1171,6 +1275,41 @@ void Slave::reregistered(
 }
 
 
+// Adds the task to the re-registration message. An abbreviated task
+// only has what a master which already knows it needs to reconcile it
+// (see `Master::reconcile()`), e.g., no statuses or resources.
+static void addTask(
+    ReregisterSlaveMessage* message,
+    const Task& task,
+    bool abbreviated)
+{
+  Task* task_ = message->add_tasks();
+
+  if (!abbreviated) {
+    task_->CopyFrom(task);
+    return;
+  }
+
+  task_->set_name(task.name());
+  task_->mutable_task_id()->CopyFrom(task.task_id());
+  task_->mutable_framework_id()->CopyFrom(task.framework_id());
+  task_->mutable_slave_id()->CopyFrom(task.slave_id());
+  task_->set_state(task.state());
+
+  if (task.has_executor_id()) {
+    task_->mutable_executor_id()->CopyFrom(task.executor_id());
+  }
+
+  if (task.has_status_update_state()) {
+    task_->set_status_update_state(task.status_update_state());
+  }
+
+  if (task.has_status_update_uuid()) {
+    task_->set_status_update_uuid(task.status_update_uuid());
+  }
+}
+
+
 void Slave::doReliableRegistration(Duration maxBackoff)
 {
   if (master.isNone()) {
@@ -1211,6 +1350,21 @@ void Slave::doReliableRegistration(Duration maxBackoff)
     ReregisterSlaveMessage message;
     message.set_version(MESOS_VERSION);
 
+    // When re-registering with the master which (re-)registered the
+    // slave last (e.g., after a network partition), the master still
+    // knows the slave, so the tasks only need to be identified for
+    // reconciliation and the completed frameworks are not needed at
+    // all. This only applies to the first attempt: the master ignores
+    // an abbreviated re-registration of a slave it doesn't know, and
+    // the retries below send everything.
+    const bool abbreviated =
+      masterId.isSome() && registeredMasterId == masterId;
+
+    if (abbreviated) {
+      message.set_master_id(masterId.get());
+      registeredMasterId = None();
+    }
+
     // Include checkpointed resources.
     message.mutable_checkpointed_resources()->CopyFrom(checkpointedResources);
 
@@ -1224,8 +1378,10 @@ void Slave::doReliableRegistration(Duration maxBackoff)
       typedef hashmap<TaskID, TaskInfo> TaskMap;
       foreachvalue (const TaskMap& tasks, framework->pending) {
         foreachvalue (const TaskInfo& task, tasks) {
-          message.add_tasks()->CopyFrom(protobuf::createTask(
-              task, TASK_STAGING, framework->id()));
+          addTask(
+              &message,
+              protobuf::createTask(task, TASK_STAGING, framework->id()),
+              abbreviated);
         }
       }
 
@@ -1236,16 +1392,18 @@ void Slave::doReliableRegistration(Duration maxBackoff)
         // Note that for each task the latest state and status update
         // state (if any) is also included.
         foreach (Task* task, executor->launchedTasks.values()) {
-          message.add_tasks()->CopyFrom(*task);
+          addTask(&message, *task, abbreviated);
         }
 
         foreach (Task* task, executor->terminatedTasks.values()) {
-          message.add_tasks()->CopyFrom(*task);
+          addTask(&message, *task, abbreviated);
         }
 
         foreach (const TaskInfo& task, executor->queuedTasks.values()) {
-          message.add_tasks()->CopyFrom(protobuf::createTask(
-              task, TASK_STAGING, framework->id()));
+          addTask(
+              &message,
+              protobuf::createTask(task, TASK_STAGING, framework->id()),
+              abbreviated);
         }
 
         // Do not re-register with Command Executors because the
@@ -1272,36 +1430,40 @@ void Slave::doReliableRegistration(Duration maxBackoff)
       }
     }
 
-    // Add completed frameworks.
-    foreach (const Owned<Framework>& completedFramework, completedFrameworks) {
-      VLOG(1) << "Reregistering completed framework "
+    // Add completed frameworks (see above).
+    if (!abbreviated) {
+      foreach (const Owned<Framework>& completedFramework,
+               completedFrameworks) {
+        VLOG(1) << "Reregistering completed framework "
                 << completedFramework->id();
 
-      Archive::Framework* completedFramework_ =
-        message.add_completed_frameworks();
+        Archive::Framework* completedFramework_ =
+          message.add_completed_frameworks();
 
-      completedFramework_->mutable_framework_info()->CopyFrom(
-          completedFramework->info);
+        completedFramework_->mutable_framework_info()->CopyFrom(
+            completedFramework->info);
 
-      if (completedFramework->pid.isSome()) {
-        completedFramework_->set_pid(completedFramework->pid.get());
-      }
+        if (completedFramework->pid.isSome()) {
+          completedFramework_->set_pid(completedFramework->pid.get());
+        }
 
-      foreach (const Owned<Executor>& executor,
-               completedFramework->completedExecutors) {
-        VLOG(2) << "Reregistering completed executor '" << executor->id
-                << "' with " << executor->terminatedTasks.size()
-                << " terminated tasks, " << executor->completedTasks.size()
-                << " completed tasks";
+        foreach (const Owned<Executor>& executor,
+                 completedFramework->completedExecutors) {
+          VLOG(2) << "Reregistering completed executor '" << executor->id
+                  << "' with " << executor->terminatedTasks.size()
+                  << " terminated tasks, "
+                  << executor->completedTasks.size() << " completed tasks";
 
-        foreach (const Task* task, executor->terminatedTasks.values()) {
-          VLOG(2) << "Reregistering terminated task " << task->task_id();
-          completedFramework_->add_tasks()->CopyFrom(*task);
-        }
+          foreach (const Task* task, executor->terminatedTasks.values()) {
+            VLOG(2) << "Reregistering terminated task " << task->task_id();
+            completedFramework_->add_tasks()->CopyFrom(*task);
+          }
 
-        foreach (const std::shared_ptr<Task>& task, executor->completedTasks) {
-          VLOG(2) << "Reregistering completed task " << task->task_id();
-          completedFramework_->add_tasks()->CopyFrom(*task);
+          foreach (const std::shared_ptr<Task>& task,
+                   executor->completedTasks) {
+            VLOG(2) << "Reregistering completed task " << task->task_id();
+            completedFramework_->add_tasks()->CopyFrom(*task);
+          }
         }
       }
     }
@@ -1332,6 +1494,96 @@ Future<bool> Slave::unschedule(const string& path)
 }
 
 
+// Returns the framework of a task to run, which is created if it
+// does not exist yet. The work and meta directories of a new
+// framework are unscheduled from gc by chaining onto 'unschedule'.
+Framework* Slave::prepareFramework(
+    const FrameworkInfo& frameworkInfo,
+    const UPID& pid,
+    Future<bool>* unschedule)
+{
+  const FrameworkID frameworkId = frameworkInfo.id();
+
+  Framework* framework = getFramework(frameworkId);
+  if (framework != NULL) {
+    return framework;
+  }
+
+  // Unschedule framework work directory.
+  string path = paths::getFrameworkPath(
+      flags.work_dir, info.id(), frameworkId);
+
+  if (os::exists(path)) {
+    *unschedule = unschedule->then(defer(self(), &Self::unschedule, path));
+  }
+
+  // Unschedule framework meta directory.
+  path = paths::getFrameworkPath(metaDir, info.id(), frameworkId);
+  if (os::exists(path)) {
+    *unschedule = unschedule->then(defer(self(), &Self::unschedule, path));
+  }
+
+  Option<UPID> frameworkPid = None();
+
+  if (pid != UPID()) {
+    frameworkPid = pid;
+  }
+
+  framework = new Framework(this, frameworkInfo, frameworkPid);
+  frameworks[frameworkId] = framework;
+  if (frameworkInfo.checkpoint()) {
+    framework->checkpointFramework();
+  }
+
+  // Is this same framework in completedFrameworks? If so, move the completed
+  // executors to this framework and remove it from that list.
+  // TODO(brenden): Consider using stout/cache.hpp instead of boost
+  // circular_buffer.
+  for (auto it = completedFrameworks.begin(), end = completedFrameworks.end();
+       it != end;
+       ++it) {
+    if ((*it)->id() == frameworkId) {
+      framework->completedExecutors = (*it)->completedExecutors;
+      completedFrameworks.erase(it);
+      break;
+    }
+  }
+
+  return framework;
+}
+
+
+// If we are about to create a new executor, unschedule the top level
+// work and meta directories from getting gc'ed by chaining onto
+// 'unschedule'.
+void Slave::prepareExecutor(
+    Framework* framework,
+    const ExecutorID& executorId,
+    Future<bool>* unschedule)
+{
+  if (framework->getExecutor(executorId) != NULL) {
+    return;
+  }
+
+  const FrameworkID& frameworkId = framework->id();
+
+  // Unschedule executor work directory.
+  string path = paths::getExecutorPath(
+      flags.work_dir, info.id(), frameworkId, executorId);
+
+  if (os::exists(path)) {
+    *unschedule = unschedule->then(defer(self(), &Self::unschedule, path));
+  }
+
+  // Unschedule executor meta directory.
+  path = paths::getExecutorPath(metaDir, info.id(), frameworkId, executorId);
+
+  if (os::exists(path)) {
+    *unschedule = unschedule->then(defer(self(), &Self::unschedule, path));
+  }
+}
+
+
 // TODO(vinod): Instead of crashing the slave on checkpoint errors,
 // send TASK_LOST to the framework.
 void Slave::runTask(
@@ -1383,50 +1635,7 @@ void Slave::runTask(
 
   Future<bool> unschedule = true;
 
-  // If we are about to create a new framework, unschedule the work
-  // and meta directories from getting gc'ed.
-  Framework* framework = getFramework(frameworkId);
-  if (framework == NULL) {
-    // Unschedule framework work directory.
-    string path = paths::getFrameworkPath(
-        flags.work_dir, info.id(), frameworkId);
-
-    if (os::exists(path)) {
-      unschedule = unschedule.then(defer(self(), &Self::unschedule, path));
-    }
-
-    // Unschedule framework meta directory.
-    path = paths::getFrameworkPath(metaDir, info.id(), frameworkId);
-    if (os::exists(path)) {
-      unschedule = unschedule.then(defer(self(), &Self::unschedule, path));
-    }
-
-    Option<UPID> frameworkPid = None();
-
-    if (pid != UPID()) {
-      frameworkPid = pid;
-    }
-
-    framework = new Framework(this, frameworkInfo, frameworkPid);
-    frameworks[frameworkId] = framework;
-    if (frameworkInfo.checkpoint()) {
-      framework->checkpointFramework();
-    }
-
-    // Is this same framework in completedFrameworks? If so, move the completed
-    // executors to this framework and remove it from that list.
-    // TODO(brenden): Consider using stout/cache.hpp instead of boost
-    // circular_buffer.
-    for (auto it = completedFrameworks.begin(), end = completedFrameworks.end();
-         it != end;
-         ++it) {
-      if ((*it)->id() == frameworkId) {
-        framework->completedExecutors = (*it)->completedExecutors;
-        completedFrameworks.erase(it);
-        break;
-      }
-    }
-  }
+  Framework* framework = prepareFramework(frameworkInfo, pid, &unschedule);
 
   const ExecutorInfo executorInfo = getExecutorInfo(frameworkInfo, task);
   const ExecutorID& executorId = executorInfo.executor_id();
@@ -1443,25 +1652,7 @@ void Slave::runTask(
   CHECK_NOTNULL(framework);
   framework->pending[executorId][task.task_id()] = task;
 
-  // If we are about to create a new executor, unschedule the top
-  // level work and meta directories from getting gc'ed.
-  Executor* executor = framework->getExecutor(executorId);
-  if (executor == NULL) {
-    // Unschedule executor work directory.
-    string path = paths::getExecutorPath(
-        flags.work_dir, info.id(), frameworkId, executorId);
-
-    if (os::exists(path)) {
-      unschedule = unschedule.then(defer(self(), &Self::unschedule, path));
-    }
-
-    // Unschedule executor meta directory.
-    path = paths::getExecutorPath(metaDir, info.id(), frameworkId, executorId);
-
-    if (os::exists(path)) {
-      unschedule = unschedule.then(defer(self(), &Self::unschedule, path));
-    }
-  }
+  prepareExecutor(framework, executorId, &unschedule);
 
   // Run the task after the unschedules are done.
   unschedule.onAny(
@@ -1539,7 +1730,7 @@ void Slave::_runTask(
         task.task_id(),
         TASK_LOST,
         TaskStatus::SOURCE_SLAVE,
-        UUID::random(),
+        UUID::sequential(),
         "Could not launch the task because we failed to unschedule directories"
         " scheduled for gc",
         TaskStatus::REASON_GC_ERROR);
@@ -1581,7 +1772,7 @@ void Slave::_runTask(
           task.task_id(),
           TASK_LOST,
           TaskStatus::SOURCE_SLAVE,
-          UUID::random(),
+          UUID::sequential(),
           "The checkpointed resources being used by the task are unknown to "
           "the slave",
           TaskStatus::REASON_RESOURCES_UNKNOWN);
@@ -1614,7 +1805,7 @@ void Slave::_runTask(
             task.task_id(),
             TASK_LOST,
             TaskStatus::SOURCE_SLAVE,
-            UUID::random(),
+            UUID::sequential(),
             "The checkpointed resources being used by the executor are unknown "
             "to the slave",
             TaskStatus::REASON_RESOURCES_UNKNOWN,
@@ -1680,7 +1871,7 @@ void Slave::_runTask(
           task.task_id(),
           TASK_LOST,
           TaskStatus::SOURCE_SLAVE,
-          UUID::random(),
+          UUID::sequential(),
           "Executor terminating/terminated",
           TaskStatus::REASON_EXECUTOR_TERMINATED);
 
@@ -1747,6 +1938,105 @@ void Slave::_runTask(
 }
 
 
+// Handles the tasks of a batch as if each was sent in its own
+// 'RunTaskMessage', except that the framework is set up, the gc'ed
+// directories of the framework and of the new executors are
+// unscheduled and the continuation is deferred once per batch.
+void Slave::runTaskBatch(
+    const UPID& from,
+    const RunTasksMessage& message)
+{
+  if (master != from) {
+    LOG(WARNING) << "Ignoring run tasks message from " << from
+                 << " because it is not the expected master: "
+                 << (master.isSome() ? stringify(master.get()) : "None");
+    return;
+  }
+
+  const FrameworkInfo& frameworkInfo = message.framework();
+
+  if (!frameworkInfo.has_id()) {
+    LOG(ERROR) << "Ignoring run tasks message from " << from
+               << " because it does not have a framework ID";
+    return;
+  }
+
+  const FrameworkID frameworkId = frameworkInfo.id();
+
+  LOG(INFO) << "Got assigned " << message.tasks().size()
+            << " tasks for framework " << frameworkId;
+
+  CHECK(state == RECOVERING || state == DISCONNECTED ||
+        state == RUNNING || state == TERMINATING)
+    << state;
+
+  // TODO(bmahler): Also ignore if we're DISCONNECTED.
+  if (state == RECOVERING || state == TERMINATING) {
+    LOG(WARNING) << "Ignoring " << message.tasks().size()
+                 << " tasks because the slave is " << state;
+    return;
+  }
+
+  list<TaskInfo> tasks;
+  foreach (const TaskInfo& task, message.tasks()) {
+    if (!(task.slave_id() == info.id())) {
+      LOG(WARNING)
+        << "Slave " << info.id() << " ignoring task " << task.task_id()
+        << " because it was intended for old slave " << task.slave_id();
+      continue;
+    }
+
+    tasks.push_back(task);
+  }
+
+  if (tasks.empty()) {
+    return;
+  }
+
+  Future<bool> unschedule = true;
+
+  Framework* framework =
+    prepareFramework(frameworkInfo, UPID(message.pid()), &unschedule);
+
+  CHECK_NOTNULL(framework);
+
+  hashset<ExecutorID> executorIds;
+  foreach (TaskInfo& task, tasks) {
+    const ExecutorInfo executorInfo = getExecutorInfo(frameworkInfo, task);
+    const ExecutorID& executorId = executorInfo.executor_id();
+
+    if (HookManager::hooksAvailable()) {
+      // Set task labels from run task label decorator.
+      task.mutable_labels()->CopyFrom(HookManager::slaveRunTaskLabelDecorator(
+          task, executorInfo, frameworkInfo, info));
+    }
+
+    // See 'runTask()' for why the task is added to 'pending'.
+    framework->pending[executorId][task.task_id()] = task;
+
+    if (!executorIds.contains(executorId)) {
+      prepareExecutor(framework, executorId, &unschedule);
+      executorIds.insert(executorId);
+    }
+  }
+
+  // Run the tasks after the unschedules are done.
+  unschedule.onAny(
+      defer(self(), &Self::_runTaskBatch, lambda::_1, frameworkInfo, tasks));
+}
+
+
+void Slave::_runTaskBatch(
+    const Future<bool>& future,
+    const FrameworkInfo& frameworkInfo,
+    const list<TaskInfo>& tasks)
+{
+  foreach (const TaskInfo& task, tasks) {
+    _runTask(future, frameworkInfo, task);
+  }
+}
+
+
 void Slave::runTasks(
     const Future<Nothing>& future,
     const FrameworkID& frameworkId,
@@ -1938,7 +2228,7 @@ void Slave::killTask(
           taskId,
           TASK_KILLED,
           TaskStatus::SOURCE_SLAVE,
-          UUID::random(),
+          UUID::sequential(),
           "Task killed before it was launched");
       statusUpdate(update, UPID());
 
@@ -1966,7 +2256,7 @@ void Slave::killTask(
         taskId,
         TASK_LOST,
         TaskStatus::SOURCE_SLAVE,
-        UUID::random(),
+        UUID::sequential(),
         "Cannot find executor",
         TaskStatus::REASON_EXECUTOR_TERMINATED);
 
@@ -1983,7 +2273,7 @@ void Slave::killTask(
           taskId,
           TASK_KILLED,
           TaskStatus::SOURCE_SLAVE,
-          UUID::random(),
+          UUID::sequential(),
           "Unregistered executor",
           TaskStatus::REASON_EXECUTOR_UNREGISTERED,
           executor->id);
@@ -2029,7 +2319,7 @@ void Slave::killTask(
             taskId,
             TASK_KILLED,
             TaskStatus::SOURCE_SLAVE,
-            UUID::random(),
+            UUID::sequential(),
             "Task killed when it was queued",
             None(),
             executor->id);
@@ -2326,10 +2616,34 @@ void Slave::checkpointResources(const vector<Resource>& _checkpointedResources)
 
     string path = paths::getPersistentVolumePath(flags.work_dir, volume);
 
-    if (!os::exists(path)) {
-      CHECK_SOME(os::mkdir(path, true))
-        << "Failed to create persistent volume at '" << path << "'";
+    if (os::exists(path)) {
+      continue;
+    }
+
+    // A volume with a parent is created as a copy of it. The parent
+    // is on the same disk, which is validated in master.
+    Option<string> parent;
+    if (volume.disk().persistence().has_parent()) {
+      Resource _parent = volume;
+      _parent.mutable_disk()->mutable_persistence()->set_id(
+          volume.disk().persistence().parent());
+
+      parent = paths::getPersistentVolumePath(flags.work_dir, _parent);
+
+      // The parent may have been destroyed already if this volume
+      // was removed from the slave but not from the master (e.g., the
+      // work directory was wiped), in which case the volume is
+      // created empty.
+      if (!os::exists(parent.get())) {
+        LOG(WARNING) << "Creating persistent volume at '" << path << "'"
+                     << " empty as its parent '" << parent.get() << "'"
+                     << " does not exist";
+        parent = None();
+      }
     }
+
+    CHECK_SOME(volumes::create(flags.persistent_volume_backend, path, parent))
+      << "Failed to create persistent volume at '" << path << "'";
   }
 
   // TODO(jieyu): Schedule gc for released persistent volumes. We need
@@ -2393,6 +2707,22 @@ void Slave::statusUpdateAcknowledgement(
 }
 
 
+void Slave::statusUpdateAcknowledgements(
+    const UPID& from,
+    const StatusUpdateAcknowledgementsMessage& message)
+{
+  foreach (const StatusUpdateAcknowledgementMessage& acknowledgement,
+           message.acknowledgements()) {
+    statusUpdateAcknowledgement(
+        from,
+        acknowledgement.slave_id(),
+        acknowledgement.framework_id(),
+        acknowledgement.task_id(),
+        acknowledgement.uuid());
+  }
+}
+
+
 void Slave::_statusUpdateAcknowledgement(
     const Future<bool>& future,
     const TaskID& taskId,
@@ -2615,7 +2945,7 @@ void Slave::subscribe(
               task->task_id(),
               TASK_LOST,
               TaskStatus::SOURCE_SLAVE,
-              UUID::random(),
+              UUID::sequential(),
               "Task launched during slave restart",
               TaskStatus::REASON_SLAVE_RESTARTED,
               executor->id);
@@ -2884,7 +3214,7 @@ void Slave::reregisterExecutor(
               task->task_id(),
               TASK_LOST,
               TaskStatus::SOURCE_SLAVE,
-              UUID::random(),
+              UUID::sequential(),
               "Task launched during slave restart",
               TaskStatus::REASON_SLAVE_RESTARTED,
               executorId);
@@ -3193,6 +3523,19 @@ void Slave::statusUpdate(StatusUpdate update, const Option<UPID>& pid)
 }
 
 
+void Slave::statusUpdates(
+    const UPID& from,
+    const StatusUpdatesMessage& message)
+{
+  VLOG(1) << "Handling " << message.updates().size()
+          << " status updates from " << from;
+
+  foreach (const StatusUpdateMessage& update, message.updates()) {
+    statusUpdate(update.update(), UPID(update.pid()));
+  }
+}
+
+
 void Slave::_statusUpdate(
     const Option<Future<Nothing>>& future,
     const StatusUpdate& update,
@@ -3366,10 +3709,74 @@ void Slave::forward(StatusUpdate update)
   message.mutable_update()->MergeFrom(update);
   message.set_pid(self()); // The ACK will be first received by the slave.
 
+  // The update is batched with the ones forwarded before the batch
+  // is sent, either after '--status_update_batch_interval' or, by
+  // default, once the updates that are already enqueued have been
+  // processed. Large batches are sent right away.
+  if (pendingUpdates.empty()) {
+    if (flags.status_update_batch_interval > Duration::zero()) {
+      delay(flags.status_update_batch_interval, self(), &Self::_forward);
+    } else {
+      dispatch(self(), &Self::_forward);
+    }
+  }
+
+  pendingUpdates.push_back(message);
+  pendingUpdatesSize += Bytes(message.ByteSize());
+
+  if (pendingUpdatesSize >= STATUS_UPDATE_BATCH_MAX_SIZE) {
+    _forward();
+  }
+}
+
+
+void Slave::_forward()
+{
+  // NOTE: A batch that was sent early because of its size leaves its
+  // timer behind, in which case we might have nothing to send.
+  if (pendingUpdates.empty()) {
+    return;
+  }
+
+  vector<StatusUpdateMessage> messages;
+  messages.swap(pendingUpdates);
+  pendingUpdatesSize = Bytes(0);
+
+  // It is safe to drop the updates if the slave got disconnected in
+  // the mean time, the status update manager will retry them.
+  if (state != RUNNING) {
+    LOG(WARNING) << "Dropping " << messages.size() << " status update(s)"
+                 << " because the slave is in " << state << " state";
+    return;
+  }
+
+  CHECK_SOME(master);
+
+  if (messages.size() == 1) {
+    send(master.get(), messages.front());
+    return;
+  }
+
+  StatusUpdatesMessage message;
+  foreach (const StatusUpdateMessage& update, messages) {
+    message.add_updates()->CopyFrom(update);
+  }
+
   send(master.get(), message);
 }
 
 
+void Slave::flush(const FrameworkID& frameworkId, const ExecutorID& executorId)
+{
+  // The executor might have been removed since, in which case it has
+  // already written its pending events when closing its connection.
+  Executor* executor = getExecutor(frameworkId, executorId);
+  if (executor != NULL) {
+    executor->flush();
+  }
+}
+
+
 void Slave::executorMessage(
     const SlaveID& slaveId,
     const FrameworkID& frameworkId,
@@ -3522,6 +3929,54 @@ ExecutorInfo Slave::getExecutorInfo(
   if (task.has_command()) {
     ExecutorInfo executor;
 
+    // The command tasks which need neither a container nor URIs to be
+    // fetched can be run by a shared command executor, since its
+    // ExecutorInfo does not depend on the task (the environment of
+    // the task is set by the command executor when it forks it).
+    const bool shared =
+      flags.shared_command_executor &&
+      !task.has_container() &&
+      task.command().uris().size() == 0;
+
+    if (shared) {
+      // The tasks of different users can not share an executor as it
+      // runs as the user of the tasks.
+      string id = SHARED_COMMAND_EXECUTOR_ID_PREFIX;
+      if (task.command().has_user()) {
+        id += "-" + task.command().user();
+      }
+
+      executor.mutable_executor_id()->set_value(id);
+      executor.mutable_framework_id()->CopyFrom(frameworkInfo.id());
+      executor.set_name("Command Executor (Shared)");
+      executor.set_source(id);
+
+      if (task.command().has_user()) {
+        executor.mutable_command()->set_user(task.command().user());
+      }
+
+      Result<string> path =
+        os::realpath(path::join(flags.launcher_dir, "mesos-executor"));
+
+      executor.mutable_command()->set_shell(true);
+
+      if (path.isSome()) {
+        executor.mutable_command()->set_value(path.get() + " --shared");
+      } else {
+        executor.mutable_command()->set_value(
+            "echo '" +
+            (path.isError() ? path.error() : "No such file or directory") +
+            "'; exit 1");
+      }
+
+      executor.mutable_resources()->MergeFrom(
+          Resources::parse(
+            "cpus:" + stringify(DEFAULT_EXECUTOR_CPUS) + ";" +
+            "mem:" + stringify(DEFAULT_EXECUTOR_MEM.megabytes())).get());
+
+      return executor;
+    }
+
     // Command executors share the same id as the task.
     executor.mutable_executor_id()->set_value(task.task_id().value());
     executor.mutable_framework_id()->CopyFrom(frameworkInfo.id());
@@ -3926,6 +4381,8 @@ void Slave::removeExecutor(Framework* framework, Executor* executor)
   // Check that this executor has terminated.
   CHECK(executor->state == Executor::TERMINATED) << executor->state;
 
+  usages.erase(executor->containerId);
+
   // Check that either 1) the executor has no tasks with pending
   // updates or 2) the slave/framework is terminating, because no
   // acknowledgements might be received.
@@ -4296,6 +4753,8 @@ void Slave::checkDiskUsage()
 
 void Slave::_checkDiskUsage(const Future<double>& usage)
 {
+  Duration interval = flags.disk_watch_interval;
+
   if (!usage.isReady()) {
     LOG(ERROR) << "Failed to get disk usage: "
                << (usage.isFailed() ? usage.failure() : "future discarded");
@@ -4310,8 +4769,27 @@ void Slave::_checkDiskUsage(const Future<double>& usage)
     // scheduled for deletion 'gc_delay' into the future, only directories
     // that are at least 'age' old are deleted.
     gc->prune(flags.gc_delay - executorDirectoryMaxAllowedAge);
+
+    // Check the disk usage sooner when it gets within 'headroom' of
+    // the point where all directories are deleted (and right after
+    // deleting them beyond that point), so that a burst of writes
+    // does not fill up the disk before the next check. Getting the
+    // disk usage is only a 'statvfs' call.
+    const double headroom = flags.gc_disk_headroom;
+    const double remaining = 1.0 - headroom - usage.get();
+
+    if (remaining < headroom) {
+      interval = headroom > 0.0
+        ? flags.disk_watch_interval * (std::max(0.0, remaining) / headroom)
+        : Duration::zero();
+
+      interval = std::min(
+          flags.disk_watch_interval,
+          std::max(interval, MIN_DISK_WATCH_INTERVAL));
+    }
   }
-  delay(flags.disk_watch_interval, self(), &Slave::checkDiskUsage);
+
+  delay(interval, self(), &Slave::checkDiskUsage);
 }
 
 
@@ -4393,6 +4871,8 @@ Future<Nothing> Slave::recover(const Result<state::State>& state)
       return Failure(recovered.error());
     }
 
+    attachFetcherCache(slaveState.get().id);
+
     // Recover the frameworks.
     foreachvalue (const FrameworkState& frameworkState,
                   slaveState.get().frameworks) {
@@ -4400,15 +4880,18 @@ Future<Nothing> Slave::recover(const Result<state::State>& state)
     }
   }
 
-  return statusUpdateManager->recover(metaDir, slaveState)
-    .then(defer(self(), &Slave::_recoverContainerizer, slaveState));
-}
+  // The status update manager and the containerizer do not depend on
+  // each other's recovery, so we recover them concurrently.
+  list<Future<Nothing>> futures;
 
+  futures.push_back(metrics.recovery_status_update_manager.time(
+      statusUpdateManager->recover(metaDir, slaveState)));
 
-Future<Nothing> Slave::_recoverContainerizer(
-    const Option<state::SlaveState>& state)
-{
-  return containerizer->recover(state);
+  futures.push_back(metrics.recovery_containerizer.time(
+      containerizer->recover(slaveState)));
+
+  return collect(futures)
+    .then([]() { return Nothing(); });
 }
 
 
@@ -4473,7 +4956,7 @@ Future<Nothing> Slave::_recover()
     // We set 'recovered' flag inside reregisterExecutorTimeout(),
     // so that when the slave re-registers with master it can
     // correctly inform the master about the launched tasks.
-    return recovered.future();
+    return metrics.recovery_executors.time(recovered.future());
   }
 
   return Nothing();
@@ -4662,6 +5145,43 @@ Future<Nothing> Slave::garbageCollect(const string& path)
 }
 
 
+// Returns whether an estimate of the oversubscribed resources differs
+// from the previous one by more than 'delta' (a fraction of the
+// previous amount) for some scalar resource, or has other resources.
+static bool changed(
+    const Resources& previous,
+    const Resources& current,
+    double delta)
+{
+  if (previous == current) {
+    return false;
+  }
+
+  if (delta <= 0.0 ||
+      previous.names() != current.names() ||
+      previous.types() != current.types() ||
+      previous - previous.scalars() != current - current.scalars()) {
+    return true;
+  }
+
+  foreach (const string& name, current.names()) {
+    Option<Value::Scalar> before = previous.get<Value::Scalar>(name);
+    Option<Value::Scalar> after = current.get<Value::Scalar>(name);
+
+    if (before.isNone() || after.isNone()) {
+      continue;
+    }
+
+    if (std::abs(after.get().value() - before.get().value()) >
+        delta * before.get().value()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 void Slave::forwardOversubscribed()
 {
   VLOG(1) << "Querying resource estimator for oversubscribable resources";
@@ -4697,10 +5217,15 @@ void Slave::_forwardOversubscribed(const Future<Resources>& oversubscribable)
     // Add oversubscribable resources to the total.
     oversubscribed += oversubscribable.get();
 
-    // Only forward the estimate if it's different from the previous
-    // estimate. We also send this whenever we get (re-)registered
-    // (i.e. whenever we transition into the RUNNING state).
-    if (state == RUNNING && oversubscribedResources != oversubscribed) {
+    // Only forward the estimate if it's different enough from the
+    // previously forwarded estimate. We also send this whenever we
+    // get (re-)registered (i.e. whenever we transition into the
+    // RUNNING state).
+    if (state == RUNNING &&
+        (forwardedOversubscribedResources.isNone() ||
+         changed(forwardedOversubscribedResources.get(),
+                 oversubscribed,
+                 flags.oversubscribed_resources_delta))) {
       LOG(INFO) << "Forwarding total oversubscribed resources "
                 << oversubscribed;
 
@@ -4710,6 +5235,8 @@ void Slave::_forwardOversubscribed(const Future<Resources>& oversubscribable)
 
       CHECK_SOME(master);
       send(master.get(), message);
+
+      forwardedOversubscribedResources = oversubscribed;
     }
 
     // Update the estimate.
@@ -4853,6 +5380,86 @@ void Slave::_qosCorrections(const Future<list<QoSCorrection>>& future)
                      << executor->state;
           break;
       }
+    } else if (correction.type() == QoSCorrection::THROTTLE) {
+      const QoSCorrection::Throttle& throttle = correction.throttle();
+
+      if (!throttle.has_framework_id() || !throttle.has_executor_id()) {
+        LOG(WARNING) << "Ignoring QoS correction THROTTLE: "
+                     << "framework id or executor id not specified.";
+        continue;
+      }
+
+      const FrameworkID& frameworkId = throttle.framework_id();
+      const ExecutorID& executorId = throttle.executor_id();
+
+      Framework* framework = getFramework(frameworkId);
+      if (framework == NULL || framework->state == Framework::TERMINATING) {
+        LOG(WARNING) << "Ignoring QoS correction THROTTLE on framework "
+                     << frameworkId << ": framework cannot be found or "
+                     << "is terminating";
+        continue;
+      }
+
+      Executor* executor = framework->getExecutor(executorId);
+      if (executor == NULL) {
+        LOG(WARNING) << "Ignoring QoS correction THROTTLE on executor '"
+                     << executorId << "' of framework " << frameworkId
+                     << ": executor cannot be found";
+        continue;
+      }
+
+      const ContainerID containerId = throttle.has_container_id()
+        ? throttle.container_id()
+        : executor->containerId;
+
+      if (containerId != executor->containerId) {
+        LOG(WARNING) << "Ignoring QoS correction THROTTLE on container '"
+                     << containerId << "' for executor " << *executor
+                     << ": container cannot be found";
+        continue;
+      }
+
+      if (executor->state != Executor::REGISTERING &&
+          executor->state != Executor::RUNNING) {
+        LOG(WARNING) << "Ignoring QoS correction THROTTLE on executor "
+                     << *executor << " because the executor is in "
+                     << executor->state << " state";
+        continue;
+      }
+
+      if (throttle.has_cpus() && throttle.cpus() <= 0) {
+        LOG(WARNING) << "Ignoring QoS correction THROTTLE on executor "
+                     << *executor << ": invalid cpus " << throttle.cpus();
+        continue;
+      }
+
+      // Only the CPU share is changed; the other resources (e.g.,
+      // memory and ports) are left as allocated.
+      Resources resources = executor->resources;
+
+      Option<double> cpus = resources.cpus();
+      if (throttle.has_cpus() && cpus.isSome() &&
+          throttle.cpus() < cpus.get()) {
+        resources = resources.filter([](const Resource& resource) {
+          return resource.name() != "cpus";
+        });
+
+        resources += Resources::parse(
+            "cpus", stringify(throttle.cpus()), "*").get();
+
+        LOG(INFO) << "Throttling container '" << containerId
+                  << "' for executor " << *executor << " to "
+                  << throttle.cpus() << " cpus as QoS correction";
+      } else {
+        LOG(INFO) << "Restoring the resources of container '" << containerId
+                  << "' for executor " << *executor << " as QoS correction";
+      }
+
+      containerizer->update(containerId, resources)
+        .onFailed([=](const string& failure) {
+          LOG(ERROR) << "Failed to throttle container '" << containerId
+                     << "' as QoS correction: " << failure;
+        });
     } else {
       LOG(WARNING) << "QoS correction type " << correction.type()
                    << " is not supported";
@@ -4877,7 +5484,7 @@ Future<ResourceUsage> Slave::usage()
       entry->mutable_allocated()->CopyFrom(executor->resources);
       entry->mutable_container_id()->CopyFrom(executor->containerId);
 
-      futures.push_back(containerizer->usage(executor->containerId));
+      futures.push_back(statistics(executor->containerId));
     }
   }
 
@@ -4920,6 +5527,26 @@ Future<ResourceUsage> Slave::usage()
 }
 
 
+Future<ResourceStatistics> Slave::statistics(const ContainerID& containerId)
+{
+  if (usages.contains(containerId)) {
+    const Time& time = usages[containerId].first;
+    const Future<ResourceStatistics>& future = usages[containerId].second;
+
+    if (future.isPending() ||
+        (future.isReady() &&
+         Clock::now() - time < flags.resource_usage_cache_interval)) {
+      return future;
+    }
+  }
+
+  Future<ResourceStatistics> future = containerizer->usage(containerId);
+  usages[containerId] = std::make_pair(Clock::now(), future);
+
+  return future;
+}
+
+
 // TODO(dhamon): Move these to their own metrics.hpp|cpp.
 double Slave::_tasks_staging()
 {
@@ -5083,7 +5710,7 @@ void Slave::sendExecutorTerminatedStatusUpdate(
       taskId,
       state,
       TaskStatus::SOURCE_SLAVE,
-      UUID::random(),
+      UUID::sequential(),
       message,
       reason,
       executor->id),
@@ -5665,16 +6292,20 @@ void Executor::checkpointTask(const TaskInfo& task)
   CHECK(checkpoint);
 
   const Task t = protobuf::createTask(task, TASK_STAGING, frameworkId);
-  const string path = paths::getTaskInfoPath(
+
+  // NOTE: The tasks of an executor run share a single checkpoint to
+  // which they are appended, this avoids creating (and renaming) a
+  // file per task when an executor runs many tasks.
+  const string path = paths::getTasksInfoPath(
       slave->metaDir,
       slave->info.id(),
       frameworkId,
       id,
-      containerId,
-      t.task_id());
+      containerId);
 
-  VLOG(1) << "Checkpointing TaskInfo to '" << path << "'";
-  CHECK_SOME(state::checkpoint(path, t));
+  VLOG(1) << "Checkpointing TaskInfo of task " << t.task_id()
+          << " to '" << path << "'";
+  CHECK_SOME(state::append(path, t));
 }
 
 
@@ -5749,10 +6380,27 @@ bool Executor::isCommandExecutor() const
 }
 
 
+void Executor::flush()
+{
+  if (pendingEvents.empty()) {
+    return;
+  }
+
+  if (http.isNone() || !http->writer.write(pendingEvents)) {
+    LOG(WARNING) << "Unable to send events to executor " << *this
+                 << ": connection closed";
+  }
+
+  pendingEvents.clear();
+}
+
+
 void Executor::closeHttpConnection()
 {
   CHECK_SOME(http);
 
+  flush();
+
   if (!http.get().close()) {
     LOG(WARNING) << "Failed to close HTTP pipe for " << *this;
   }
@@ -22,6 +22,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/circular_buffer.hpp>
@@ -133,6 +134,17 @@ public:
       const FrameworkInfo& frameworkInfo,
       const TaskInfo& task);
 
+  // Handles a batch of tasks launched by the master (see
+  // 'RunTasksMessage'), each as if it was sent on its own.
+  void runTaskBatch(
+      const process::UPID& from,
+      const RunTasksMessage& message);
+
+  void _runTaskBatch(
+      const process::Future<bool>& future,
+      const FrameworkInfo& frameworkInfo,
+      const std::list<TaskInfo>& tasks);
+
   process::Future<bool> unschedule(const std::string& path);
 
   // Made 'virtual' for Slave mocking.
@@ -208,6 +220,12 @@ public:
   // to ensure source field is set.
   void statusUpdate(StatusUpdate update, const Option<process::UPID>& pid);
 
+  // Handles a batch of status updates from an executor, each as if
+  // it was sent in its own `StatusUpdateMessage`.
+  void statusUpdates(
+      const process::UPID& from,
+      const StatusUpdatesMessage& message);
+
   // Continue handling the status update after optionally updating the
   // container's resources.
   void _statusUpdate(
@@ -231,6 +249,13 @@ public:
   // added to the update before forwarding.
   void forward(StatusUpdate update);
 
+  // Sends the updates batched up by 'forward()' to the master.
+  void _forward();
+
+  // Writes the events batched up by 'Executor::send()' to the HTTP
+  // connection of the executor, see 'Executor::flush()'.
+  void flush(const FrameworkID& frameworkId, const ExecutorID& executorId);
+
   void statusUpdateAcknowledgement(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -238,6 +263,10 @@ public:
       const TaskID& taskId,
       const std::string& uuid);
 
+  void statusUpdateAcknowledgements(
+      const process::UPID& from,
+      const StatusUpdateAcknowledgementsMessage& message);
+
   void _statusUpdateAcknowledgement(
       const process::Future<bool>& future,
       const TaskID& taskId,
@@ -297,9 +326,24 @@ public:
       const ContainerID& containerId,
       const std::list<TaskInfo>& tasks);
 
+  // Helpers for running tasks, see 'runTask()'.
+  Framework* prepareFramework(
+      const FrameworkInfo& frameworkInfo,
+      const process::UPID& pid,
+      process::Future<bool>* unschedule);
+
+  void prepareExecutor(
+      Framework* framework,
+      const ExecutorID& executorId,
+      process::Future<bool>* unschedule);
+
   void fileAttached(const process::Future<Nothing>& result,
                     const std::string& path);
 
+  // Serves the shared fetcher cache files to peer agents through
+  // '/files', see '--fetcher_peers'.
+  void attachFetcherCache(const SlaveID& slaveId);
+
   Nothing detachFile(const std::string& path);
 
   // Triggers a re-detection of the master when the slave does
@@ -345,12 +389,6 @@ public:
   // executors. Otherwise, the slave attempts to shutdown/kill them.
   process::Future<Nothing> _recover();
 
-  // This is a helper to call recover() on the containerizer at the end of
-  // recover() and before __recover().
-  // TODO(idownes): Remove this when we support defers to objects.
-  process::Future<Nothing> _recoverContainerizer(
-      const Option<state::SlaveState>& state);
-
   // This is called when recovery finishes.
   // Made 'virtual' for Slave mocking.
   virtual void __recover(const process::Future<Nothing>& future);
@@ -383,6 +421,12 @@ public:
   process::Future<ResourceUsage> usage();
 
 private:
+  // Returns the resource statistics of the container, reusing the
+  // latest collection if it is still in progress or was collected
+  // within 'flags.resource_usage_cache_interval'.
+  process::Future<ResourceStatistics> statistics(
+      const ContainerID& containerId);
+
   void _authenticate();
   void authenticationTimeout(process::Future<bool> future);
 
@@ -489,6 +533,13 @@ private:
 
   Option<process::UPID> master;
 
+  // The ID (see `MasterInfo.id`) of the detected master, and of the
+  // master which (re-)registered the slave last. When they are the
+  // same, the slave only needs to send what that master does not
+  // know yet when it re-registers after a transient disconnection.
+  Option<std::string> masterId;
+  Option<std::string> registeredMasterId;
+
   hashmap<FrameworkID, Framework*> frameworks;
 
   boost::circular_buffer<process::Owned<Framework>> completedFrameworks;
@@ -515,6 +566,12 @@ private:
 
   ResourceMonitor monitor;
 
+  // The latest collection of the resource statistics of each
+  // container, along with the time it was started.
+  hashmap<ContainerID,
+          std::pair<process::Time, process::Future<ResourceStatistics>>>
+    usages;
+
   StatusUpdateManager* statusUpdateManager;
 
   // Master detection future.
@@ -564,6 +621,15 @@ private:
   // The most recent estimate of the total amount of oversubscribed
   // (allocated and oversubscribable) resources.
   Option<Resources> oversubscribedResources;
+
+  // The estimate of the oversubscribed resources which was last
+  // forwarded to the master, see '--oversubscribed_resources_delta'.
+  Option<Resources> forwardedOversubscribedResources;
+
+  // Status updates waiting to be forwarded to the master and their
+  // total size, see 'forward()'.
+  std::vector<StatusUpdateMessage> pendingUpdates;
+  Bytes pendingUpdatesSize;
 };
 
 
@@ -579,10 +645,17 @@ struct HttpConnection
   // Converts the message to an Event before sending.
   template <typename Message>
   bool send(const Message& message)
+  {
+    return writer.write(encode(message));
+  }
+
+  // Converts the message to an Event and encodes it as a record.
+  template <typename Message>
+  std::string encode(const Message& message)
   {
     // We need to evolve the internal 'message' into a
     // 'v1::executor::Event'.
-    return writer.write(encoder.encode(evolve(message)));
+    return encoder.encode(evolve(message));
   }
 
   bool close()
@@ -638,10 +711,14 @@ struct Executor
     }
 
     if (http.isSome()) {
-      if (!http->send(message)) {
-        LOG(WARNING) << "Unable to send event to executor " << *this
-                     << ": connection closed";
+      // The events are written with a single write to the pipe once
+      // the events sent before the dispatch below have been batched
+      // up, rather than with a write (and an HTTP chunk) per event.
+      if (pendingEvents.empty()) {
+        process::dispatch(slave, &Slave::flush, frameworkId, id);
       }
+
+      pendingEvents += http->encode(message);
     } else if (pid.isSome()) {
       slave->send(pid.get(), message);
     } else {
@@ -653,7 +730,10 @@ struct Executor
   // Returns true if this is a command executor.
   bool isCommandExecutor() const;
 
-  // Closes the HTTP connection.
+  // Writes the events batched up by 'send()' to the HTTP connection.
+  void flush();
+
+  // Closes the HTTP connection (after writing the pending events).
   void closeHttpConnection();
 
   friend std::ostream& operator<<(
@@ -699,6 +779,10 @@ struct Executor
   Option<HttpConnection> http;
   Option<process::UPID> pid;
 
+  // The (encoded) events waiting to be written to the HTTP connection,
+  // see 'send()'.
+  std::string pendingEvents;
+
   // Currently consumed resources.
   Resources resources;
 
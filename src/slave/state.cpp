@@ -17,6 +17,7 @@
 #include <glog/logging.h>
 
 #include <iostream>
+#include <vector>
 
 #include <process/pid.hpp>
 
@@ -24,6 +25,8 @@
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/format.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/numify.hpp>
@@ -35,6 +38,7 @@
 #include <stout/os/close.hpp>
 #include <stout/os/exists.hpp>
 #include <stout/os/ftruncate.hpp>
+#include <stout/os/open.hpp>
 #include <stout/os/read.hpp>
 #include <stout/os/realpath.hpp>
 
@@ -51,6 +55,7 @@ namespace state {
 using std::list;
 using std::string;
 using std::max;
+using std::vector;
 
 
 Result<State> recover(const string& rootDir, bool strict)
@@ -125,6 +130,196 @@ Result<State> recover(const string& rootDir, bool strict)
 }
 
 
+// Appends the records to the updates file at 'path', unless they are
+// already in it. Any partially written record at the end of the file
+// is truncated first.
+static Try<Nothing> append(
+    const string& path,
+    const vector<StatusUpdateRecord>& records)
+{
+  if (!os::exists(Path(path).dirname())) {
+    VLOG(1) << "Skipping status update records for '" << path
+            << "' because its task directory no longer exists";
+    return Nothing();
+  }
+
+  Try<int> fd = os::open(
+      path,
+      O_CREAT | O_RDWR | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error(
+        "Failed to open status updates file '" + path + "': " + fd.error());
+  }
+
+  // The UUIDs of the updates and the acknowledgements in the file.
+  hashset<string> updates;
+  hashset<string> acks;
+
+  ::protobuf::Reader<StatusUpdateRecord> reader(fd.get());
+
+  Result<StatusUpdateRecord> record = None();
+  while (true) {
+    record = reader.read(true);
+
+    if (!record.isSome()) {
+      break;
+    }
+
+    if (record.get().type() == StatusUpdateRecord::UPDATE) {
+      updates.insert(record.get().update().uuid());
+    } else {
+      acks.insert(record.get().uuid());
+    }
+  }
+
+  if (record.isError()) {
+    LOG(WARNING) << "Failed to read status updates file '" << path
+                 << "': " << record.error();
+  }
+
+  off_t offset = lseek(fd.get(), 0, SEEK_CUR);
+
+  if (offset < 0) {
+    os::close(fd.get());
+    return ErrnoError("Failed to lseek status updates file '" + path + "'");
+  }
+
+  Try<Nothing> truncated = os::ftruncate(fd.get(), offset);
+
+  if (truncated.isError()) {
+    os::close(fd.get());
+    return Error(
+        "Failed to truncate status updates file '" + path +
+        "': " + truncated.error());
+  }
+
+  ::protobuf::Writer writer(fd.get());
+
+  foreach (const StatusUpdateRecord& journaled, records) {
+    if (journaled.type() == StatusUpdateRecord::UPDATE
+        ? updates.contains(journaled.update().uuid())
+        : acks.contains(journaled.uuid())) {
+      continue;
+    }
+
+    Try<Nothing> write = writer.write(journaled);
+
+    if (write.isError()) {
+      os::close(fd.get());
+      return Error(
+          "Failed to write status updates file '" + path +
+          "': " + write.error());
+    }
+  }
+
+  Try<Nothing> flush = writer.flush();
+
+  if (flush.isError()) {
+    os::close(fd.get());
+    return Error(
+        "Failed to write status updates file '" + path +
+        "': " + flush.error());
+  }
+
+  if (::fsync(fd.get()) < 0) {
+    ErrnoError error("Failed to sync status updates file '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  os::close(fd.get());
+
+  return Nothing();
+}
+
+
+Try<Nothing> flushStatusUpdateJournal(
+    const string& rootDir,
+    const SlaveID& slaveId)
+{
+  const string journal = paths::getStatusUpdateJournalPath(rootDir, slaveId);
+
+  if (!os::exists(journal)) {
+    return Nothing();
+  }
+
+  Try<int> fd = os::open(journal, O_RDWR | O_CLOEXEC);
+
+  if (fd.isError()) {
+    return Error(
+        "Failed to open status update journal '" + journal + "': " +
+        fd.error());
+  }
+
+  // Group the records by the updates file of their task, keeping the
+  // order in which they were journaled.
+  hashmap<string, vector<StatusUpdateRecord> > files;
+
+  ::protobuf::Reader<StatusUpdateJournalRecord> reader(fd.get());
+
+  Result<StatusUpdateJournalRecord> record = None();
+  while (true) {
+    // Ignore errors due to a partially written record at the end of
+    // the journal, such a record was never synced.
+    record = reader.read(true);
+
+    if (!record.isSome()) {
+      break;
+    }
+
+    const string& path = paths::getTaskUpdatesPath(
+        rootDir,
+        slaveId,
+        record.get().framework_id(),
+        record.get().executor_id(),
+        record.get().container_id(),
+        record.get().task_id());
+
+    files[path].push_back(record.get().record());
+  }
+
+  if (record.isError()) {
+    os::close(fd.get());
+    return Error(
+        "Failed to read status update journal '" + journal +
+        "': " + record.error());
+  }
+
+  foreachpair (const string& path,
+               const vector<StatusUpdateRecord>& records,
+               files) {
+    Try<Nothing> appended = append(path, records);
+
+    if (appended.isError()) {
+      os::close(fd.get());
+      return Error(appended.error());
+    }
+  }
+
+  // All the records are synced to the updates files now.
+  Try<Nothing> truncated = os::ftruncate(fd.get(), 0);
+
+  if (truncated.isError()) {
+    os::close(fd.get());
+    return Error(
+        "Failed to truncate status update journal '" + journal +
+        "': " + truncated.error());
+  }
+
+  if (::fsync(fd.get()) < 0) {
+    ErrnoError error("Failed to sync status update journal '" + journal + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  os::close(fd.get());
+
+  return Nothing();
+}
+
+
 Try<SlaveState> SlaveState::recover(
     const string& rootDir,
     const SlaveID& slaveId,
@@ -165,6 +360,23 @@ Try<SlaveState> SlaveState::recover(
 
   state.info = slaveInfo.get();
 
+  // Move the status updates left in the journal, if any, into the
+  // updates files of their tasks so they are recovered along with
+  // the tasks below.
+  Try<Nothing> flushed = flushStatusUpdateJournal(rootDir, slaveId);
+
+  if (flushed.isError()) {
+    const string& message =
+      "Failed to flush the status update journal: " + flushed.error();
+
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state.errors++;
+    }
+  }
+
   // Find the frameworks.
   Try<list<string> > frameworks = paths::getFrameworkPaths(rootDir, slaveId);
 
@@ -410,6 +622,78 @@ Try<ExecutorState> ExecutorState::recover(
 }
 
 
+// Reads the tasks info of an executor run, i.e., the 'Task' records
+// appended by the slave (see 'append()'), in a single pass. The last
+// record of a task wins. A partially written last record is truncated
+// and, if the file holds more records than tasks, it is compacted.
+static Try<hashmap<TaskID, Task>> readTasksInfo(const string& path)
+{
+  // Open the file for reading and writing (for truncating).
+  Try<int> fd = os::open(path, O_RDWR | O_CLOEXEC);
+
+  if (fd.isError()) {
+    return Error("Failed to open file: " + fd.error());
+  }
+
+  hashmap<TaskID, Task> infos;
+  size_t records = 0;
+
+  // The reader reverts to the end of the last valid record when it
+  // fails, or hits a partially written record.
+  ::protobuf::Reader<Task> reader(fd.get());
+
+  Result<Task> task = None();
+  while (true) {
+    // Ignore errors due to partial protobuf read.
+    task = reader.read(true);
+
+    if (!task.isSome()) {
+      break;
+    }
+
+    infos[task.get().task_id()] = task.get();
+    records++;
+  }
+
+  off_t offset = lseek(fd.get(), 0, SEEK_CUR);
+
+  if (offset < 0) {
+    os::close(fd.get());
+    return ErrnoError("Failed to lseek file");
+  }
+
+  // Truncate the file to contain only valid records, see the
+  // truncation of the status updates file in 'TaskState::recover()'.
+  Try<Nothing> truncated = os::ftruncate(fd.get(), offset);
+
+  os::close(fd.get());
+
+  if (truncated.isError()) {
+    return Error("Failed to truncate file: " + truncated.error());
+  }
+
+  if (task.isError()) {
+    return Error(task.error());
+  }
+
+  if (records > infos.size()) {
+    google::protobuf::RepeatedPtrField<Task> tasks;
+    foreachvalue (const Task& info, infos) {
+      tasks.Add()->CopyFrom(info);
+    }
+
+    // Failing to compact is not fatal, the records are still valid.
+    Try<Nothing> checkpoint = state::checkpoint(path, tasks);
+    if (checkpoint.isError()) {
+      LOG(WARNING) << "Failed to compact '" << path << "': "
+                   << checkpoint.error();
+    }
+  }
+
+  return infos;
+}
+
+
 Try<RunState> RunState::recover(
     const string& rootDir,
     const SlaveID& slaveId,
@@ -431,6 +715,29 @@ Try<RunState> RunState::recover(
 
   state.completed = os::exists(path);
 
+  // Read the infos of the tasks, see 'readTasksInfo()'.
+  path = paths::getTasksInfoPath(
+      rootDir, slaveId, frameworkId, executorId, containerId);
+
+  hashmap<TaskID, Task> infos;
+  if (os::exists(path)) {
+    Try<hashmap<TaskID, Task>> read = readTasksInfo(path);
+
+    if (read.isError()) {
+      message = "Failed to read tasks info from '" + path + "': " +
+                read.error();
+
+      if (strict) {
+        return Error(message);
+      } else {
+        LOG(WARNING) << message;
+        state.errors++;
+      }
+    } else {
+      infos = read.get();
+    }
+  }
+
   // Find the tasks.
   Try<list<string> > tasks = paths::getTaskPaths(
       rootDir,
@@ -445,13 +752,28 @@ Try<RunState> RunState::recover(
         ": " + tasks.error());
   }
 
-  // Recover tasks.
+  // The tasks are those with a directory (which holds their status
+  // updates) and those that are in the tasks info, which might not
+  // have a directory yet if the slave died before any status update
+  // was checkpointed for them.
+  hashset<TaskID> taskIds = infos.keys();
   foreach (const string& path, tasks.get()) {
     TaskID taskId;
     taskId.set_value(Path(path).basename());
+    taskIds.insert(taskId);
+  }
 
+  // Recover tasks.
+  foreach (const TaskID& taskId, taskIds) {
     Try<TaskState> task = TaskState::recover(
-        rootDir, slaveId, frameworkId, executorId, containerId, taskId, strict);
+        rootDir,
+        slaveId,
+        frameworkId,
+        executorId,
+        containerId,
+        taskId,
+        infos.get(taskId),
+        strict);
 
     if (task.isError()) {
       return Error(
@@ -559,45 +881,52 @@ Try<TaskState> TaskState::recover(
     const ExecutorID& executorId,
     const ContainerID& containerId,
     const TaskID& taskId,
+    const Option<Task>& info,
     bool strict)
 {
   TaskState state;
   state.id = taskId;
   string message;
 
-  // Read the task info.
+  // Read the task info, unless it was recovered from the tasks info
+  // of the executor run. Slaves that did not checkpoint the tasks
+  // info have checkpointed the task info into the task directory.
   string path = paths::getTaskInfoPath(
       rootDir, slaveId, frameworkId, executorId, containerId, taskId);
-  if (!os::exists(path)) {
-    // This could happen if the slave died after creating the task
-    // directory but before it checkpointed the task info.
-    LOG(WARNING) << "Failed to find task info file '" << path << "'";
-    return state;
-  }
+  if (info.isSome()) {
+    state.info = info.get();
+  } else {
+    if (!os::exists(path)) {
+      // This could happen if the slave died after creating the task
+      // directory but before it checkpointed the task info.
+      LOG(WARNING) << "Failed to find task info file '" << path << "'";
+      return state;
+    }
 
-  const Result<Task>& task = ::protobuf::read<Task>(path);
+    const Result<Task>& task = ::protobuf::read<Task>(path);
 
-  if (task.isError()) {
-    message = "Failed to read task info from '" + path + "': " + task.error();
+    if (task.isError()) {
+      message = "Failed to read task info from '" + path + "': " + task.error();
 
-    if (strict) {
-      return Error(message);
-    } else {
-      LOG(WARNING) << message;
-      state.errors++;
+      if (strict) {
+        return Error(message);
+      } else {
+        LOG(WARNING) << message;
+        state.errors++;
+        return state;
+      }
+    }
+
+    if (task.isNone()) {
+      // This could happen if the slave died after opening the file for
+      // writing but before it checkpointed anything.
+      LOG(WARNING) << "Found empty task info file '" << path << "'";
       return state;
     }
-  }
 
-  if (task.isNone()) {
-    // This could happen if the slave died after opening the file for
-    // writing but before it checkpointed anything.
-    LOG(WARNING) << "Found empty task info file '" << path << "'";
-    return state;
+    state.info = task.get();
   }
 
-  state.info = task.get();
-
   // Read the status updates.
   path = paths::getTaskUpdatesPath(
       rootDir, slaveId, frameworkId, executorId, containerId, taskId);
@@ -625,12 +954,14 @@ Try<TaskState> TaskState::recover(
     }
   }
 
-  // Now, read the updates.
+  // Now, read the updates. The reader reverts to the end of the last
+  // valid update when it fails, or hits a partially written update.
+  ::protobuf::Reader<StatusUpdateRecord> reader(fd.get());
+
   Result<StatusUpdateRecord> record = None();
   while (true) {
-    // Ignore errors due to partial protobuf read and enable undoing
-    // failed reads by reverting to the previous seek position.
-    record = ::protobuf::read<StatusUpdateRecord>(fd.get(), true, true);
+    // Ignore errors due to partial protobuf read.
+    record = reader.read(true);
 
     if (!record.isSome()) {
       break;
@@ -653,7 +984,7 @@ Try<TaskState> TaskState::recover(
   // Always truncate the file to contain only valid updates.
   // NOTE: This is safe even though we ignore partial protobuf read
   // errors above, because the 'fd' is properly set to the end of the
-  // last valid update by 'protobuf::read()'.
+  // last valid update by the reader.
   Try<Nothing> truncated = os::ftruncate(fd.get(), offset);
 
   if (truncated.isError()) {
@@ -713,11 +1044,14 @@ Try<ResourcesState> ResourcesState::recover(
     }
   }
 
+  // The reader reverts to the end of the last valid resource when it
+  // fails, or hits a partially written resource.
+  ::protobuf::Reader<Resource> reader(fd.get());
+
   Result<Resource> resource = None();
   while (true) {
-    // Ignore errors due to partial protobuf read and enable undoing
-    // failed reads by reverting to the previous seek position.
-    resource = ::protobuf::read<Resource>(fd.get(), true, true);
+    // Ignore errors due to partial protobuf read.
+    resource = reader.read(true);
     if (!resource.isSome()) {
       break;
     }
@@ -734,7 +1068,7 @@ Try<ResourcesState> ResourcesState::recover(
   // Always truncate the file to contain only valid resources.
   // NOTE: This is safe even though we ignore partial protobuf read
   // errors above, because the 'fd' is properly set to the end of the
-  // last valid resource by 'protobuf::read()'.
+  // last valid resource by the reader.
   Try<Nothing> truncated = os::ftruncate(fd.get(), offset);
 
   if (truncated.isError()) {
@@ -37,8 +37,10 @@
 #include <stout/utils.hpp>
 #include <stout/uuid.hpp>
 
+#include <stout/os/close.hpp>
 #include <stout/os/mkdir.hpp>
 #include <stout/os/mktemp.hpp>
+#include <stout/os/open.hpp>
 #include <stout/os/rename.hpp>
 #include <stout/os/rm.hpp>
 #include <stout/os/write.hpp>
@@ -74,6 +76,17 @@ struct TaskState;
 Result<State> recover(const std::string& rootDir, bool strict);
 
 
+// Moves the records in the status update journal of the slave (see
+// the '--status_update_journal' flag) into the updates files of
+// their tasks and empties the journal. Records of tasks whose
+// directories no longer exist (e.g., garbage collected) are dropped.
+// Records that are already in the updates files are skipped, so the
+// journal can be flushed again if this fails halfway through.
+Try<Nothing> flushStatusUpdateJournal(
+    const std::string& rootDir,
+    const SlaveID& slaveId);
+
+
 namespace internal {
 
 inline Try<Nothing> checkpoint(
@@ -170,6 +183,44 @@ Try<Nothing> checkpoint(const std::string& path, const T& t)
 }
 
 
+// Appends the message as a record to the checkpoint at the given
+// path, which is created if it does not exist. This is much cheaper
+// than 'checkpoint()' as no file is created and renamed for each
+// message, but it is not atomic: whoever reads the records back is
+// expected to ignore (and truncate) a partially written last record.
+inline Try<Nothing> append(
+    const std::string& path,
+    const google::protobuf::Message& message)
+{
+  // Create the base directory.
+  std::string base = Path(path).dirname();
+
+  Try<Nothing> mkdir = os::mkdir(base);
+  if (mkdir.isError()) {
+    return Error("Failed to create directory '" + base + "': " + mkdir.error());
+  }
+
+  Try<int> fd = os::open(
+      path,
+      O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  Try<Nothing> write = ::protobuf::write(fd.get(), message);
+
+  os::close(fd.get());
+
+  if (write.isError()) {
+    return Error("Failed to append to '" + path + "': " + write.error());
+  }
+
+  return Nothing();
+}
+
+
 // NOTE: The *State structs (e.g., TaskState, RunState, etc) are
 // defined in reverse dependency order because many of them have
 // Option<*State> dependencies which means we need them declared in
@@ -187,6 +238,7 @@ struct TaskState
       const ExecutorID& executorId,
       const ContainerID& containerId,
       const TaskID& taskId,
+      const Option<Task>& info,
       bool strict);
 
   TaskID id;
@@ -0,0 +1,313 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <stout/error.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+
+#include "slave/statistics_feed.hpp"
+
+using process::Owned;
+
+using std::atomic;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// "MESOSSTA" in little endian.
+static const uint64_t MAGIC = 0x4154535345534f4dULL;
+
+static const uint32_t FORMAT_VERSION = 1;
+
+
+// The layout of the file is the header followed by the slots, each
+// of which starts with its sequence number (see 'write') and the
+// length of its record.
+struct StatisticsFeed::Header
+{
+  uint64_t magic;
+  uint32_t version;
+  uint32_t slotSize;
+  uint64_t capacity;
+
+  // The number of records written so far.
+  atomic<uint64_t> head;
+};
+
+
+// The offset of the first slot, which keeps the slots aligned.
+static const size_t SLOTS_OFFSET = 64;
+
+static_assert(
+    sizeof(atomic<uint64_t>) == sizeof(uint64_t),
+    "Expected atomics to be lock free");
+
+// The offset of the record in a slot.
+static const size_t RECORD_OFFSET = sizeof(uint64_t) + sizeof(uint32_t);
+
+
+Try<Owned<StatisticsFeed>> StatisticsFeed::create(
+    const string& path,
+    uint64_t capacity)
+{
+  if (capacity == 0) {
+    return Error("The capacity must be positive");
+  }
+
+  const size_t length = SLOTS_OFFSET + capacity * SLOT_SIZE;
+
+  // The feed is initialized in a temporary file which is then renamed,
+  // so that a reader never sees a partially initialized header.
+  const string temporary = path + ".tmp";
+
+  int fd = ::open(
+      temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd == -1) {
+    return ErrnoError("Failed to open '" + temporary + "'");
+  }
+
+  if (::ftruncate(fd, length) != 0) {
+    ErrnoError error("Failed to resize '" + temporary + "'");
+    os::close(fd);
+    return error;
+  }
+
+  void* data = ::mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    ErrnoError error("Failed to map '" + temporary + "'");
+    os::close(fd);
+    return error;
+  }
+
+  // NOTE: The file is zero filled, so all the slots are empty.
+  Header* header = new (data) Header();
+  header->magic = MAGIC;
+  header->version = FORMAT_VERSION;
+  header->slotSize = SLOT_SIZE;
+  header->capacity = capacity;
+  header->head.store(0);
+
+  Try<Nothing> rename = os::rename(temporary, path);
+  if (rename.isError()) {
+    ::munmap(data, length);
+    os::close(fd);
+    return Error("Failed to rename '" + temporary + "': " + rename.error());
+  }
+
+  return Owned<StatisticsFeed>(
+      new StatisticsFeed(fd, static_cast<char*>(data), length, true));
+}
+
+
+Try<Owned<StatisticsFeed>> StatisticsFeed::open(const string& path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return ErrnoError("Failed to open '" + path + "'");
+  }
+
+  struct stat s;
+  if (::fstat(fd, &s) != 0) {
+    ErrnoError error("Failed to stat '" + path + "'");
+    os::close(fd);
+    return error;
+  }
+
+  const size_t length = s.st_size;
+
+  if (length < SLOTS_OFFSET) {
+    os::close(fd);
+    return Error("'" + path + "' is not a statistics feed");
+  }
+
+  void* data = ::mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    ErrnoError error("Failed to map '" + path + "'");
+    os::close(fd);
+    return error;
+  }
+
+  const Header* header = static_cast<const Header*>(data);
+
+  Option<Error> error;
+  if (header->magic != MAGIC) {
+    error = Error("'" + path + "' is not a statistics feed");
+  } else if (header->version != FORMAT_VERSION) {
+    error = Error("Unsupported version " + stringify(header->version));
+  } else if (header->slotSize != SLOT_SIZE ||
+             SLOTS_OFFSET + header->capacity * SLOT_SIZE != length) {
+    error = Error("'" + path + "' is truncated or corrupted");
+  }
+
+  if (error.isSome()) {
+    ::munmap(data, length);
+    os::close(fd);
+    return error.get();
+  }
+
+  return Owned<StatisticsFeed>(
+      new StatisticsFeed(fd, static_cast<char*>(data), length, false));
+}
+
+
+StatisticsFeed::StatisticsFeed(
+    int _fd,
+    char* _data,
+    size_t _length,
+    bool _writable)
+  : fd(_fd),
+    data(_data),
+    length(_length),
+    writable(_writable) {}
+
+
+StatisticsFeed::~StatisticsFeed()
+{
+  ::munmap(data, length);
+  os::close(fd);
+}
+
+
+StatisticsFeed::Header* StatisticsFeed::header() const
+{
+  return reinterpret_cast<Header*>(data);
+}
+
+
+char* StatisticsFeed::slot(uint64_t record) const
+{
+  return data + SLOTS_OFFSET + (record % header()->capacity) * SLOT_SIZE;
+}
+
+
+Try<Nothing> StatisticsFeed::write(const ResourceUsage::Executor& executor)
+{
+  CHECK(writable);
+
+  string record;
+  if (!executor.SerializeToString(&record)) {
+    return Error("Failed to serialize the record");
+  }
+
+  if (record.size() > SLOT_SIZE - RECORD_OFFSET) {
+    return Error(
+        "The record of " + stringify(record.size()) + " bytes does not "
+        "fit into a slot");
+  }
+
+  const uint64_t head = header()->head.load(std::memory_order_relaxed);
+
+  char* slot = this->slot(head);
+  atomic<uint64_t>* sequence = reinterpret_cast<atomic<uint64_t>*>(slot);
+
+  // The sequence number of a slot is odd while its record is written
+  // and then becomes even, so that the readers can detect that they
+  // read a partially written record. It is derived from the number of
+  // the record, so that the readers can also detect that the record
+  // they want has been overwritten.
+  sequence->store(2 * head + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const uint32_t size = record.size();
+  memcpy(slot + sizeof(uint64_t), &size, sizeof(size));
+  memcpy(slot + RECORD_OFFSET, record.data(), record.size());
+
+  sequence->store(2 * head + 2, std::memory_order_release);
+  header()->head.store(head + 1, std::memory_order_release);
+
+  return Nothing();
+}
+
+
+uint64_t StatisticsFeed::position() const
+{
+  return header()->head.load(std::memory_order_acquire);
+}
+
+
+vector<ResourceUsage::Executor> StatisticsFeed::read(uint64_t* position) const
+{
+  CHECK_NOTNULL(position);
+
+  const uint64_t head = this->position();
+  const uint64_t capacity = header()->capacity;
+
+  // Skip the records which have already been overwritten.
+  if (head - *position > capacity) {
+    *position = head - capacity;
+  }
+
+  vector<ResourceUsage::Executor> result;
+
+  char buffer[SLOT_SIZE];
+
+  for (; *position < head; (*position)++) {
+    const char* slot = this->slot(*position);
+    const atomic<uint64_t>* sequence =
+      reinterpret_cast<const atomic<uint64_t>*>(slot);
+
+    const uint64_t expected = 2 * *position + 2;
+
+    if (sequence->load(std::memory_order_acquire) != expected) {
+      continue;
+    }
+
+    uint32_t size;
+    memcpy(&size, slot + sizeof(uint64_t), sizeof(size));
+
+    if (size <= SLOT_SIZE - RECORD_OFFSET) {
+      memcpy(buffer, slot + RECORD_OFFSET, size);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // The record was overwritten while it was copied.
+    if (sequence->load(std::memory_order_relaxed) != expected ||
+        size > SLOT_SIZE - RECORD_OFFSET) {
+      continue;
+    }
+
+    ResourceUsage::Executor executor;
+    if (executor.ParseFromArray(buffer, size)) {
+      result.push_back(executor);
+    }
+  }
+
+  return result;
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SLAVE_STATISTICS_FEED_HPP__
+#define __SLAVE_STATISTICS_FEED_HPP__
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+
+#include <process/owned.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// A ring buffer of the resource statistics of the containers in a
+// memory-mapped file, which the slave writes into when sampling the
+// statistics (see the '--statistics_feed_interval' flag). Processes
+// on the same host (e.g., monitoring agents) can then read the
+// statistics as often as they want without any work done by the
+// slave, unlike with the '/monitor/statistics' endpoint.
+//
+// Each record is a 'ResourceUsage::Executor' with the IDs of the
+// executor and of its framework, the ID of the container and the
+// statistics (but not the allocated resources). The records are in
+// fixed size slots, each of which is protected by a sequence lock:
+// the readers never block the writer and simply skip the records
+// which have been overwritten while being read.
+//
+// NOTE: There must only be a single writer. The slave recreates the
+// file when it starts, so the readers should reopen it when they
+// notice that the slave restarted.
+class StatisticsFeed
+{
+public:
+  // The default number of records in the ring buffer.
+  static const uint64_t DEFAULT_CAPACITY = 4096;
+
+  // The size of the slots, which bounds the size of a record.
+  static const uint32_t SLOT_SIZE = 4096;
+
+  // Creates (or recreates) the feed at 'path' for writing.
+  static Try<process::Owned<StatisticsFeed>> create(
+      const std::string& path,
+      uint64_t capacity = DEFAULT_CAPACITY);
+
+  // Opens the existing feed at 'path' for reading.
+  static Try<process::Owned<StatisticsFeed>> open(const std::string& path);
+
+  ~StatisticsFeed();
+
+  // Appends a record, overwriting the oldest one if the ring buffer
+  // is full. Fails if the record does not fit into a slot.
+  Try<Nothing> write(const ResourceUsage::Executor& executor);
+
+  // Returns the records written since 'position', i.e., since the
+  // given number of records had been written, and advances it. The
+  // records which have been overwritten are skipped. A reader starts
+  // at position 0 to get all the records in the ring buffer, or at
+  // 'position()' to only get the new ones.
+  std::vector<ResourceUsage::Executor> read(uint64_t* position) const;
+
+  // Returns the number of records written so far.
+  uint64_t position() const;
+
+private:
+  struct Header;
+
+  StatisticsFeed(int fd, char* data, size_t length, bool writable);
+
+  // Returns the slot of the given record.
+  char* slot(uint64_t record) const;
+
+  Header* header() const;
+
+  const int fd;
+  char* const data;
+  const size_t length;
+  const bool writable;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_STATISTICS_FEED_HPP__
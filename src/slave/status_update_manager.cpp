@@ -14,11 +14,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <stdlib.h> // For random().
+
+#include <vector>
+
+#include <process/clock.hpp>
 #include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/check.hpp>
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -37,6 +45,7 @@
 
 #include "slave/constants.hpp"
 #include "slave/flags.hpp"
+#include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/state.hpp"
 #include "slave/status_update_manager.hpp"
@@ -46,10 +55,12 @@ using lambda::function;
 using std::string;
 
 using process::wait; // Necessary on some OS's to disambiguate.
+using process::Clock;
 using process::Failure;
 using process::Future;
 using process::PID;
 using process::Timeout;
+using process::Timer;
 using process::UPID;
 
 namespace mesos {
@@ -109,14 +120,23 @@ private:
       const Option<ExecutorID>& executorId,
       const Option<ContainerID>& containerId);
 
-  // Status update timeout.
-  void timeout(const Duration& duration);
+  // Resends the pending updates of the streams whose timeout expired
+  // (see 'forward').
+  void retry();
 
-  // Forwards the status update to the master and starts a timer based
-  // on the 'duration' to check for ACK from the scheduler.
+  // Forwards the status update of the stream to the master and sets
+  // the timeout of the stream to retry it if no ACK is received from
+  // the scheduler within (a jittered) 'interval'. The retries of all
+  // the streams share a single timer, see 'schedule'.
   // NOTE: This should only be used for those messages that expect an
   // ACK (e.g updates from the executor).
-  Timeout forward(const StatusUpdate& update, const Duration& duration);
+  void forward(
+      StatusUpdateStream* stream,
+      const StatusUpdate& update,
+      const Duration& interval);
+
+  // Makes sure that 'retry' is called once 'timeout' expires.
+  void schedule(const Timeout& timeout);
 
   // Helper functions.
 
@@ -138,12 +158,37 @@ private:
       const TaskID& taskId,
       const FrameworkID& frameworkId);
 
+  // Returns a future that is satisfied once the status update journal
+  // has been synced, which includes all the records appended to it so
+  // far. The sync is done once for all the commits in a batch.
+  Future<Nothing> commit();
+
+  // Syncs the status update journal and satisfies the pending commits.
+  // Flushes the journal into the updates files of the tasks if it has
+  // grown too large.
+  void sync();
+
   const Flags flags;
   bool paused;
 
+  // The status update journal (see the '--status_update_journal'
+  // flag), opened when the first checkpointed stream is created.
+  Option<SlaveID> slaveId;
+  Option<int> journal;
+  Option<string> error; // Potential non-retryable journal error.
+
+  // Commits waiting for the next sync of the journal.
+  std::vector<process::Promise<Nothing>*> commits;
+
   function<void(StatusUpdate)> forward_;
 
   hashmap<FrameworkID, hashmap<TaskID, StatusUpdateStream*> > streams;
+
+  // The timer for the earliest timeout of the streams, rather than a
+  // timer per forwarded update, so that the updates which are due
+  // around the same time are retried (and batched by the slave)
+  // together.
+  Option<Timer> retries;
 };
 
 
@@ -153,12 +198,22 @@ StatusUpdateManagerProcess::StatusUpdateManagerProcess(const Flags& _flags)
 
 StatusUpdateManagerProcess::~StatusUpdateManagerProcess()
 {
+  foreach (process::Promise<Nothing>* promise, commits) {
+    promise->discard();
+    delete promise;
+  }
+  commits.clear();
+
   foreachkey (const FrameworkID& frameworkId, streams) {
     foreachvalue (StatusUpdateStream* stream, streams[frameworkId]) {
       delete stream;
     }
   }
   streams.clear();
+
+  if (journal.isSome()) {
+    os::close(journal.get());
+  }
 }
 
 
@@ -186,7 +241,7 @@ void StatusUpdateManagerProcess::resume()
       if (!stream->pending.empty()) {
         const StatusUpdate& update = stream->pending.front();
         LOG(WARNING) << "Resending status update " << update;
-        stream->timeout = forward(update, STATUS_UPDATE_RETRY_INTERVAL_MIN);
+        forward(stream, update, STATUS_UPDATE_RETRY_INTERVAL_MIN);
       }
     }
   }
@@ -348,6 +403,16 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
     return Nothing();
   }
 
+  // NOTE: If the update was appended to the journal, the update is
+  // forwarded below before it is synced. This is safe because the
+  // executor will retry the update until the returned future (i.e.,
+  // the sync) is satisfied, in which case the update might be
+  // forwarded to the master again, as with any other retried update.
+  Future<Nothing> committed = Nothing();
+  if (stream->checkpoint && journal.isSome()) {
+    committed = commit();
+  }
+
   // Forward the status update to the master if this is the first in the stream.
   // Subsequent status updates will get sent in 'acknowledgement()'.
   if (!paused && stream->pending.size() == 1) {
@@ -358,16 +423,17 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
     }
 
     CHECK_SOME(next);
-    stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
+    forward(stream, next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
   }
 
-  return Nothing();
+  return committed;
 }
 
 
-Timeout StatusUpdateManagerProcess::forward(
+void StatusUpdateManagerProcess::forward(
+    StatusUpdateStream* stream,
     const StatusUpdate& update,
-    const Duration& duration)
+    const Duration& interval)
 {
   CHECK(!paused);
 
@@ -376,11 +442,30 @@ Timeout StatusUpdateManagerProcess::forward(
   // Forward the update.
   forward_(update);
 
-  // Send a message to self to resend after some delay if no ACK is received.
-  return delay(duration,
-               self(),
-               &StatusUpdateManagerProcess::timeout,
-               duration).timeout();
+  // Resend after some delay if no ACK is received. The delay is drawn
+  // from the second half of the interval, so that the updates which
+  // were forwarded together (e.g., to a master which failed over) are
+  // spread out when they are retried.
+  const double jitter = 0.5 + 0.5 * ((double) ::random() / RAND_MAX);
+
+  stream->interval = interval;
+  stream->timeout = Timeout::in(interval * jitter);
+
+  schedule(stream->timeout.get());
+}
+
+
+void StatusUpdateManagerProcess::schedule(const Timeout& timeout)
+{
+  if (retries.isSome()) {
+    if (retries.get().timeout() <= timeout) {
+      return;
+    }
+
+    Clock::cancel(retries.get());
+  }
+
+  retries = delay(timeout.remaining(), self(), &Self::retry);
 }
 
 
@@ -433,6 +518,11 @@ Future<bool> StatusUpdateManagerProcess::acknowledgement(
   // Reset the timeout.
   stream->timeout = None();
 
+  Future<Nothing> committed = Nothing();
+  if (stream->checkpoint && journal.isSome()) {
+    committed = commit();
+  }
+
   // Get the next update in the queue.
   const Result<StatusUpdate>& next = stream->next();
   if (next.isError()) {
@@ -450,39 +540,66 @@ Future<bool> StatusUpdateManagerProcess::acknowledgement(
     cleanupStatusUpdateStream(taskId, frameworkId);
   } else if (!paused && next.isSome()) {
     // Forward the next queued status update.
-    stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
+    forward(stream, next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
   }
 
-  return !terminated;
+  return committed
+    .then([terminated]() { return !terminated; });
 }
 
 
 // TODO(vinod): There should be a limit on the retries.
-void StatusUpdateManagerProcess::timeout(const Duration& duration)
+void StatusUpdateManagerProcess::retry()
 {
+  retries = None();
+
+  // The updates are forwarded again once resumed.
   if (paused) {
     return;
   }
 
-  // Check and see if we should resend any status updates.
+  // Check and see if we should resend any status updates. At most
+  // STATUS_UPDATE_RETRIES_MAX updates are resent at once, the others
+  // are postponed by STATUS_UPDATE_RETRIES_INTERVAL so that a master
+  // which is recovering is not flooded with the retries.
+  size_t retried = 0;
+  Option<Timeout> next;
+
   foreachkey (const FrameworkID& frameworkId, streams) {
     foreachvalue (StatusUpdateStream* stream, streams[frameworkId]) {
       CHECK_NOTNULL(stream);
-      if (!stream->pending.empty()) {
-        CHECK_SOME(stream->timeout);
-        if (stream->timeout.get().expired()) {
+      if (stream->pending.empty()) {
+        continue;
+      }
+
+      CHECK_SOME(stream->timeout);
+
+      if (stream->timeout.get().expired()) {
+        if (retried >= STATUS_UPDATE_RETRIES_MAX) {
+          stream->timeout = Timeout::in(STATUS_UPDATE_RETRIES_INTERVAL);
+        } else {
           const StatusUpdate& update = stream->pending.front();
           LOG(WARNING) << "Resending status update " << update;
 
           // Bounded exponential backoff.
-          Duration duration_ =
-            std::min(duration * 2, STATUS_UPDATE_RETRY_INTERVAL_MAX);
+          forward(
+              stream,
+              update,
+              std::min(stream->interval * 2, STATUS_UPDATE_RETRY_INTERVAL_MAX));
 
-          stream->timeout = forward(update, duration_);
+          retried++;
         }
       }
+
+      if (next.isNone() || stream->timeout.get() < next.get()) {
+        next = stream->timeout.get();
+      }
     }
   }
+
+  if (next.isSome()) {
+    schedule(next.get());
+  }
 }
 
 
@@ -497,8 +614,39 @@ StatusUpdateStream* StatusUpdateManagerProcess::createStatusUpdateStream(
   VLOG(1) << "Creating StatusUpdate stream for task " << taskId
           << " of framework " << frameworkId;
 
+  // Open the journal along with the first checkpointed stream, since
+  // it lives in the directory of the slave.
+  if (checkpoint &&
+      flags.status_update_journal &&
+      journal.isNone() &&
+      error.isNone()) {
+    const string path = paths::getStatusUpdateJournalPath(
+        paths::getMetaRootDir(flags.work_dir), slaveId);
+
+    Try<int> fd = os::open(
+        path,
+        O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    if (fd.isError()) {
+      // NOTE: The stream falls back to the updates file of the task.
+      LOG(ERROR) << "Failed to open status update journal '" << path
+                 << "': " << fd.error();
+    } else {
+      this->slaveId = slaveId;
+      journal = fd.get();
+    }
+  }
+
   StatusUpdateStream* stream = new StatusUpdateStream(
-      taskId, frameworkId, slaveId, flags, checkpoint, executorId, containerId);
+      taskId,
+      frameworkId,
+      slaveId,
+      flags,
+      checkpoint,
+      executorId,
+      containerId,
+      checkpoint && this->slaveId == slaveId ? journal : None());
 
   streams[frameworkId][taskId] = stream;
   return stream;
@@ -546,6 +694,78 @@ void StatusUpdateManagerProcess::cleanupStatusUpdateStream(
 }
 
 
+Future<Nothing> StatusUpdateManagerProcess::commit()
+{
+  CHECK_SOME(journal);
+
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  // Sync once all the updates and acknowledgements that have already
+  // been queued up have been appended to the journal.
+  if (commits.empty()) {
+    dispatch(self(), &StatusUpdateManagerProcess::sync);
+  }
+
+  process::Promise<Nothing>* promise = new process::Promise<Nothing>();
+  commits.push_back(promise);
+  return promise->future();
+}
+
+
+void StatusUpdateManagerProcess::sync()
+{
+  CHECK_SOME(journal);
+  CHECK_SOME(slaveId);
+
+  VLOG(1) << "Syncing status update journal for " << commits.size()
+          << " status updates and acknowledgements";
+
+  if (error.isNone() && ::fsync(journal.get()) < 0) {
+    error = ErrnoError("Failed to sync status update journal").message;
+  }
+
+  foreach (process::Promise<Nothing>* promise, commits) {
+    if (error.isSome()) {
+      promise->fail(error.get());
+    } else {
+      promise->set(Nothing());
+    }
+    delete promise;
+  }
+  commits.clear();
+
+  if (error.isSome()) {
+    return;
+  }
+
+  const string path = paths::getStatusUpdateJournalPath(
+      paths::getMetaRootDir(flags.work_dir), slaveId.get());
+
+  Try<Bytes> size = os::stat::size(path);
+  if (size.isError()) {
+    LOG(WARNING) << "Failed to get the size of status update journal '"
+                 << path << "': " << size.error();
+  } else if (size.get() >= STATUS_UPDATE_JOURNAL_MAX_SIZE) {
+    LOG(INFO) << "Flushing status update journal '" << path << "' ("
+              << size.get() << ")";
+
+    // NOTE: The journal is opened with O_APPEND so records appended
+    // after it gets truncated go to its (new) end.
+    Try<Nothing> flushed = state::flushStatusUpdateJournal(
+        paths::getMetaRootDir(flags.work_dir), slaveId.get());
+
+    if (flushed.isError()) {
+      // The journal is still intact and will be flushed when it is
+      // synced next, or during recovery.
+      LOG(ERROR) << "Failed to flush status update journal: "
+                 << flushed.error();
+    }
+  }
+}
+
+
 StatusUpdateManager::StatusUpdateManager(const Flags& flags)
 {
   process = new StatusUpdateManagerProcess(flags);
@@ -643,14 +863,19 @@ StatusUpdateStream::StatusUpdateStream(
     const SlaveID& _slaveId,
     const Flags& _flags,
     bool _checkpoint,
-    const Option<ExecutorID>& executorId,
-    const Option<ContainerID>& containerId)
+    const Option<ExecutorID>& _executorId,
+    const Option<ContainerID>& _containerId,
+    const Option<int>& _journal)
     : checkpoint(_checkpoint),
       terminated(false),
+      interval(STATUS_UPDATE_RETRY_INTERVAL_MIN),
       taskId(_taskId),
       frameworkId(_frameworkId),
       slaveId(_slaveId),
+      executorId(_executorId),
+      containerId(_containerId),
       flags(_flags),
+      journal(_journal),
       error(None())
 {
   if (checkpoint) {
@@ -672,6 +897,12 @@ StatusUpdateStream::StatusUpdateStream(
       return;
     }
 
+    // The records are moved from the journal into the updates file
+    // (in the directory created above) later on.
+    if (journal.isSome()) {
+      return;
+    }
+
     // Open the updates file.
     Try<int> result = os::open(
         path.get(),
@@ -823,8 +1054,6 @@ Try<Nothing> StatusUpdateStream::handle(
   if (checkpoint) {
     LOG(INFO) << "Checkpointing " << type << " for status update " << update;
 
-    CHECK_SOME(fd);
-
     StatusUpdateRecord record;
     record.set_type(type);
 
@@ -834,11 +1063,32 @@ Try<Nothing> StatusUpdateStream::handle(
       record.set_uuid(update.uuid());
     }
 
-    Try<Nothing> write = ::protobuf::write(fd.get(), record);
-    if (write.isError()) {
-      error = "Failed to write status update " + stringify(update) +
-              " to '" + path.get() + "': " + write.error();
-      return Error(error.get());
+    if (journal.isSome()) {
+      CHECK_SOME(executorId);
+      CHECK_SOME(containerId);
+
+      StatusUpdateJournalRecord journaled;
+      journaled.mutable_framework_id()->CopyFrom(frameworkId);
+      journaled.mutable_executor_id()->CopyFrom(executorId.get());
+      journaled.mutable_container_id()->CopyFrom(containerId.get());
+      journaled.mutable_task_id()->CopyFrom(taskId);
+      journaled.mutable_record()->CopyFrom(record);
+
+      Try<Nothing> write = ::protobuf::write(journal.get(), journaled);
+      if (write.isError()) {
+        error = "Failed to write status update " + stringify(update) +
+                " to the status update journal: " + write.error();
+        return Error(error.get());
+      }
+    } else {
+      CHECK_SOME(fd);
+
+      Try<Nothing> write = ::protobuf::write(fd.get(), record);
+      if (write.isError()) {
+        error = "Failed to write status update " + stringify(update) +
+                " to '" + path.get() + "': " + write.error();
+        return Error(error.get());
+      }
     }
   }
 
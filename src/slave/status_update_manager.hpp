@@ -26,6 +26,7 @@
 #include <process/pid.hpp>
 #include <process/timeout.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
@@ -126,6 +127,8 @@ private:
 // StatusUpdateStream handles the status updates and acknowledgements
 // of a task, checkpointing them if necessary. It also holds the information
 // about received, acknowledged and pending status updates.
+// If a 'journal' is given, the checkpointed records are appended to
+// it (without syncing it) instead of to the updates file of the task.
 // NOTE: A task is expected to have a globally unique ID across the lifetime
 // of a framework. In other words the tuple (taskId, frameworkId) should be
 // always unique.
@@ -136,8 +139,9 @@ struct StatusUpdateStream
                      const SlaveID& _slaveId,
                      const Flags& _flags,
                      bool _checkpoint,
-                     const Option<ExecutorID>& executorId,
-                     const Option<ContainerID>& containerId);
+                     const Option<ExecutorID>& _executorId,
+                     const Option<ContainerID>& _containerId,
+                     const Option<int>& _journal);
 
   ~StatusUpdateStream();
 
@@ -170,6 +174,7 @@ struct StatusUpdateStream
   const bool checkpoint;
   bool terminated;
   Option<process::Timeout> timeout; // Timeout for resending status update.
+  Duration interval; // The (backed off) interval between the resends.
   std::queue<StatusUpdate> pending;
 
 private:
@@ -190,6 +195,8 @@ private:
   const TaskID taskId;
   const FrameworkID frameworkId;
   const SlaveID slaveId;
+  const Option<ExecutorID> executorId;
+  const Option<ContainerID> containerId;
 
   const Flags flags;
 
@@ -199,6 +206,10 @@ private:
   Option<std::string> path; // File path of the update stream.
   Option<int> fd; // File descriptor to the update stream.
 
+  // File descriptor to the status update journal of the slave, owned
+  // by the status update manager.
+  const Option<int> journal;
+
   Option<std::string> error; // Potential non-retryable error.
 };
 
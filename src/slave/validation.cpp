@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <stout/foreach.hpp>
+
 #include "slave/validation.hpp"
 
 namespace mesos {
@@ -23,6 +25,47 @@ namespace validation {
 namespace executor {
 namespace call {
 
+// Validates a status update sent with the call.
+static Option<Error> validate(
+    const mesos::executor::Call& call,
+    const TaskStatus& status)
+{
+  if (!status.has_uuid()) {
+    return Error("Expecting 'uuid' to be present");
+  }
+
+  if (status.has_executor_id() &&
+      status.executor_id().value()
+      != call.executor_id().value()) {
+    return Error("ExecutorID in Call: " +
+                 call.executor_id().value() +
+                 " does not match ExecutorID in TaskStatus: " +
+                 status.executor_id().value()
+                 );
+  }
+
+  if (status.source() != TaskStatus::SOURCE_EXECUTOR) {
+    return Error("Received Call from executor " +
+                 call.executor_id().value() +
+                 " of framework " +
+                 call.framework_id().value() +
+                 " with invalid source, expecting 'SOURCE_EXECUTOR'"
+                 );
+  }
+
+  if (status.state() == TASK_STAGING) {
+    return Error("Received TASK_STAGING from executor " +
+                 call.executor_id().value() +
+                 " of framework " +
+                 call.framework_id().value() +
+                 " which is not allowed"
+                 );
+  }
+
+  return None();
+}
+
+
 Option<Error> validate(const mesos::executor::Call& call)
 {
   if (!call.IsInitialized()) {
@@ -52,38 +95,20 @@ Option<Error> validate(const mesos::executor::Call& call)
         return Error("Expecting 'update' to be present");
       }
 
-      const TaskStatus& status = call.update().status();
-
-      if (!status.has_uuid()) {
-        return Error("Expecting 'uuid' to be present");
-      }
-
-      if (status.has_executor_id() &&
-          status.executor_id().value()
-          != call.executor_id().value()) {
-        return Error("ExecutorID in Call: " +
-                     call.executor_id().value() +
-                     " does not match ExecutorID in TaskStatus: " +
-                     call.update().status().executor_id().value()
-                     );
-      }
+      return validate(call, call.update().status());
+    }
 
-      if (status.source() != TaskStatus::SOURCE_EXECUTOR) {
-        return Error("Received Call from executor " +
-                     call.executor_id().value() +
-                     " of framework " +
-                     call.framework_id().value() +
-                     " with invalid source, expecting 'SOURCE_EXECUTOR'"
-                     );
+    case mesos::executor::Call::UPDATES: {
+      if (!call.has_updates()) {
+        return Error("Expecting 'updates' to be present");
       }
 
-      if (status.state() == TASK_STAGING) {
-        return Error("Received TASK_STAGING from executor " +
-                     call.executor_id().value() +
-                     " of framework " +
-                     call.framework_id().value() +
-                     " which is not allowed"
-                     );
+      foreach (const mesos::executor::Call::Update& update,
+               call.updates().updates()) {
+        Option<Error> error = validate(call, update.status());
+        if (error.isSome()) {
+          return error;
+        }
       }
 
       return None();
@@ -0,0 +1,124 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/stat.h>
+
+#include <string>
+
+#include <stout/error.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+
+#include "slave/volumes.hpp"
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+namespace volumes {
+
+// Returns whether the directory at 'path' is the root of a btrfs
+// subvolume, which always has the inode number 256 (i.e.,
+// BTRFS_FIRST_FREE_OBJECTID).
+static bool subvolume(const string& path)
+{
+  struct stat s;
+  return ::stat(path.c_str(), &s) == 0 && S_ISDIR(s.st_mode) && s.st_ino == 256;
+}
+
+
+// Quotes a path for the shell.
+static string quote(const string& path)
+{
+  return "'" + strings::replace(path, "'", "'\\''") + "'";
+}
+
+
+Try<Nothing> validate(const string& backend)
+{
+  if (backend != COPY && backend != BTRFS) {
+    return Error("Unknown persistent volume backend '" + backend + "'");
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> create(
+    const string& backend,
+    const string& path,
+    const Option<string>& parent)
+{
+  // The parent directory of the volume (i.e., the directory of its
+  // role) may not exist yet.
+  Try<Nothing> mkdir = os::mkdir(Path(path).dirname());
+  if (mkdir.isError()) {
+    return Error(
+        "Failed to create the directory of the volume: " + mkdir.error());
+  }
+
+  Try<string> create = Error("Unknown backend '" + backend + "'");
+
+  if (backend == BTRFS) {
+    // Only a subvolume can be snapshotted, so the parents which are
+    // plain directories (e.g., created before the backend was
+    // changed) are copied with reflinks into a new subvolume instead.
+    if (parent.isSome() && subvolume(parent.get())) {
+      create = os::shell(
+          "btrfs subvolume snapshot %s %s 2>&1",
+          quote(parent.get()).c_str(),
+          quote(path).c_str());
+    } else {
+      create = os::shell(
+          "btrfs subvolume create %s 2>&1",
+          quote(path).c_str());
+
+      if (create.isSome() && parent.isSome()) {
+        create = os::shell(
+            "cp -a --reflink=auto %s/. %s 2>&1",
+            quote(parent.get()).c_str(),
+            quote(path).c_str());
+      }
+    }
+  } else if (backend == COPY) {
+    if (parent.isSome()) {
+      create = os::shell(
+          "cp -a --reflink=auto %s %s 2>&1",
+          quote(parent.get()).c_str(),
+          quote(path).c_str());
+    } else {
+      Try<Nothing> mkdir = os::mkdir(path);
+      if (mkdir.isError()) {
+        return Error(mkdir.error());
+      }
+
+      return Nothing();
+    }
+  }
+
+  if (create.isError()) {
+    return Error(create.error());
+  }
+
+  return Nothing();
+}
+
+} // namespace volumes {
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
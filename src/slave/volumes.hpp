@@ -0,0 +1,67 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SLAVE_VOLUMES_HPP__
+#define __SLAVE_VOLUMES_HPP__
+
+#include <string>
+
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+namespace volumes {
+
+// The backends for creating persistent volumes (see the
+// '--persistent_volume_backend' flag):
+//   'copy':  Volumes are created as directories, and the volumes with
+//            a parent are copied from it with 'cp --reflink=auto',
+//            which shares the blocks of the files with the parent on
+//            filesystems supporting reflinks (e.g., btrfs, or XFS
+//            formatted with 'reflink=1') and falls back to a regular
+//            copy on the others.
+//   'btrfs': Volumes are created as btrfs subvolumes, and the volumes
+//            with a parent are created as (writable) snapshots of it,
+//            which takes constant time. Requires the volumes to be on
+//            btrfs and the 'btrfs' command.
+const char COPY[] = "copy";
+const char BTRFS[] = "btrfs";
+
+
+// Validates the name of a backend.
+Try<Nothing> validate(const std::string& backend);
+
+
+// Creates the persistent volume at 'path' with the given backend,
+// as a copy of the persistent volume at 'parent' if it is specified.
+//
+// NOTE: Copying a volume blocks the caller. It is fast with reflinks
+// or snapshots, but takes time proportional to the size of the
+// parent otherwise.
+Try<Nothing> create(
+    const std::string& backend,
+    const std::string& path,
+    const Option<std::string>& parent = None());
+
+} // namespace volumes {
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_VOLUMES_HPP__
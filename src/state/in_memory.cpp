@@ -16,11 +16,14 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/option.hpp>
 #include <stout/uuid.hpp>
@@ -34,7 +37,9 @@ using namespace process;
 
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -61,6 +66,26 @@ public:
     return true;
   }
 
+  bool setAll(const vector<pair<Entry, UUID>>& _entries)
+  {
+    // Check all the versions before setting any of the entries.
+    typedef pair<Entry, UUID> Pair;
+    foreach (const Pair& pair, _entries) {
+      const Option<Entry>& option = entries.get(pair.first.name());
+
+      if (option.isSome() &&
+          UUID::fromBytes(option.get().uuid()) != pair.second) {
+        return false;
+      }
+    }
+
+    foreach (const Pair& pair, _entries) {
+      entries.put(pair.first.name(), pair.first);
+    }
+
+    return true;
+  }
+
   bool expunge(const Entry& entry)
   {
     const Option<Entry>& option = entries.get(entry.name());
@@ -116,6 +141,12 @@ Future<bool> InMemoryStorage::set(const Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> InMemoryStorage::set(const vector<pair<Entry, UUID>>& entries)
+{
+  return dispatch(process, &InMemoryStorageProcess::setAll, entries);
+}
+
+
 Future<bool> InMemoryStorage::expunge(const Entry& entry)
 {
   return dispatch(process, &InMemoryStorageProcess::expunge, entry);
@@ -15,6 +15,7 @@
 // limitations under the License
 
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 #include <google/protobuf/message.h>
 
@@ -22,12 +23,15 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/process.hpp>
 
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/some.hpp>
@@ -45,7 +49,9 @@ using namespace process;
 
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -63,6 +69,7 @@ public:
   // Storage implementation.
   Future<Option<Entry> > get(const string& name);
   Future<bool> set(const Entry& entry, const UUID& uuid);
+  Future<bool> setAll(const vector<pair<Entry, UUID>>& entries);
   Future<bool> expunge(const Entry& entry);
   Future<std::set<string> > names();
 
@@ -179,6 +186,56 @@ Future<bool> LevelDBStorageProcess::set(const Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> LevelDBStorageProcess::setAll(
+    const vector<pair<Entry, UUID>>& entries)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  leveldb::WriteBatch batch;
+
+  typedef pair<Entry, UUID> Pair;
+  foreach (const Pair& pair, entries) {
+    const Entry& entry = pair.first;
+
+    // Like in 'set', read first to make sure the version has not
+    // changed.
+    Try<Option<Entry> > option = read(entry.name());
+
+    if (option.isError()) {
+      return Failure(option.error());
+    }
+
+    if (option.get().isSome()) {
+      if (UUID::fromBytes(option.get().get().uuid()) != pair.second) {
+        return false;
+      }
+    }
+
+    string value;
+
+    if (!entry.SerializeToString(&value)) {
+      return Failure("Failed to serialize Entry");
+    }
+
+    batch.Put(entry.name(), value);
+  }
+
+  // All the entries are written atomically by a single DB::Write.
+  leveldb::WriteOptions options;
+  options.sync = true;
+
+  leveldb::Status status = db->Write(options, &batch);
+
+  if (!status.ok()) {
+    return Failure(status.ToString());
+  }
+
+  return true;
+}
+
+
 Future<bool> LevelDBStorageProcess::expunge(const Entry& entry)
 {
   if (error.isSome()) {
@@ -298,6 +355,12 @@ Future<bool> LevelDBStorage::set(const Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> LevelDBStorage::set(const vector<pair<Entry, UUID>>& entries)
+{
+  return dispatch(process, &LevelDBStorageProcess::setAll, entries);
+}
+
+
 Future<bool> LevelDBStorage::expunge(const Entry& entry)
 {
   return dispatch(process, &LevelDBStorageProcess::expunge, entry);
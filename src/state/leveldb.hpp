@@ -19,6 +19,8 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/future.hpp>
 
@@ -47,6 +49,8 @@ public:
   // Storage implementation.
   virtual process::Future<Option<Entry> > get(const std::string& name);
   virtual process::Future<bool> set(const Entry& entry, const UUID& uuid);
+  virtual process::Future<bool> set(
+      const std::vector<std::pair<Entry, UUID> >& entries);
   virtual process::Future<bool> expunge(const Entry& entry);
   virtual process::Future<std::set<std::string> > names();
 
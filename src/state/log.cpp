@@ -18,14 +18,20 @@
 
 #include <google/protobuf/io/zero_copy_stream_impl.h> // For ArrayInputStream.
 
+#include <algorithm>
+#include <deque>
 #include <list>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/mutex.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
 #include <process/metrics/metrics.hpp>
@@ -36,6 +42,7 @@
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/svn.hpp>
@@ -51,12 +58,41 @@ using namespace process;
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
 using std::list;
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 namespace state {
 
+// Returns the number of log entries from one position up to (and
+// including) another, computed from the identities of the positions
+// (see Log::position).
+static uint64_t entries(const Log::Position& from, const Log::Position& to)
+{
+  const string identities[] = { from.identity(), to.identity() };
+
+  uint64_t values[2] = { 0, 0 };
+  for (size_t i = 0; i < 2; i++) {
+    CHECK_EQ(8u, identities[i].size());
+    for (size_t j = 0; j < 8; j++) {
+      values[i] = (values[i] << 8) | (identities[i][j] & 0xff);
+    }
+  }
+
+  CHECK_LE(values[0], values[1]);
+  return values[1] - values[0] + 1;
+}
+
+
+// The log is compacted (see 'LogStorageProcess::_truncate') once it
+// holds more than COMPACTION_FACTOR times the entries needed for the
+// current state, and at least COMPACTION_MINIMUM entries.
+static const uint64_t COMPACTION_FACTOR = 4;
+static const uint64_t COMPACTION_MINIMUM = 1000;
+
+
 // A storage implementation for State that uses the replicated
 // log. The log is made up of appended operations. Each state entry is
 // mapped to a log "snapshot".
@@ -69,6 +105,12 @@ namespace state {
 // implying the operation was not atomic and subsequent operations
 // will re-'start()' which will again read all positions to make sure
 // operations are consistent.
+//
+// When batching, the 'set' operations that are requested while
+// another operation holds the mutex are written together with a
+// single append of an Operation::BATCH (as long as their entries have
+// distinct names), rather than one append each.
+//
 // TODO(benh): Log demotion does not necessarily imply a non-atomic
 // read/modify/write. An alternative strategy might be to retry after
 // restarting via 'start' (and holding on to the mutex so no other
@@ -76,16 +118,20 @@ namespace state {
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
-  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots);
+  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots, bool batch);
 
   virtual ~LogStorageProcess();
 
   // Storage implementation.
   Future<Option<state::Entry> > get(const string& name);
   Future<bool> set(const state::Entry& entry, const UUID& uuid);
+  Future<bool> setAll(const vector<pair<state::Entry, UUID>>& entries);
   Future<bool> expunge(const state::Entry& entry);
   Future<std::set<string> > names();
 
+  // See 'LogStorage::tail'.
+  void tail(const Duration& interval);
+
 protected:
   virtual void finalize();
 
@@ -96,9 +142,24 @@ private:
       const Log::Position& beginning,
       const Log::Position& position);
 
+  // Reads and applies the entries of the log (which were learned by
+  // the local replica) without starting the writer.
+  Future<Nothing> catchup();
+  Future<Nothing> _catchup(const Log::Position& beginning);
+  Future<Nothing> __catchup(
+      const Log::Position& from,
+      const Log::Position& ending);
+
+  void _tail(const Duration& interval, const Future<Nothing>& catchup);
+
   // Helper for applying log entries.
   Future<Nothing> apply(const list<Log::Entry>& entries);
 
+  // Helper for applying a single operation read at a position.
+  Try<Nothing> replay(
+      const Operation& operation,
+      const Log::Position& position);
+
   // Helper for performing truncation.
   void truncate();
   Future<Nothing> _truncate();
@@ -106,6 +167,12 @@ private:
       const Log::Position& minimum,
       const Option<Log::Position>& position);
 
+  // Helper for moving the snapshot of an entry to the end of the log.
+  Future<Nothing> compact(const state::Entry& entry);
+  Future<Nothing> _compact(
+      const state::Entry& entry,
+      const Option<Log::Position>& position);
+
   // Continuations.
   Future<Option<state::Entry> > _get(const string& name);
 
@@ -116,6 +183,40 @@ private:
       size_t diff,
       Option<Log::Position> position);
 
+  Future<bool> _setAll(const vector<pair<state::Entry, UUID>>& entries);
+  Future<bool> __setAll(const vector<pair<state::Entry, UUID>>& entries);
+  Future<bool> ___setAll(
+      const vector<pair<state::Entry, UUID>>& entries,
+      const vector<size_t>& diffs,
+      const Option<Log::Position>& position);
+
+  // A 'set' waiting to be written with the next batch.
+  struct Pending
+  {
+    Pending(const state::Entry& _entry, const UUID& _uuid)
+      : entry(_entry), uuid(_uuid), diffs(0) {}
+
+    const state::Entry entry;
+    const UUID uuid;
+
+    // The number of diffs making up the snapshot once written.
+    size_t diffs;
+
+    process::Promise<bool> promise;
+  };
+
+  // Helpers for writing the pending 'set' operations in a batch.
+  void flush();
+  Future<Nothing> _flush();
+  Future<Nothing> __flush(const std::deque<Owned<Pending>>& sets);
+  Future<Nothing> ___flush(
+      const std::deque<Owned<Pending>>& sets,
+      const Option<Log::Position>& position);
+
+  static void flushed(
+      const std::deque<Owned<Pending>>& sets,
+      const Future<Nothing>& future);
+
   Future<bool> _expunge(const state::Entry& entry);
   Future<bool> __expunge(const state::Entry& entry);
   Future<bool> ___expunge(
@@ -128,6 +229,7 @@ private:
   Log::Writer writer;
 
   const size_t diffsBetweenSnapshots;
+  const bool batch;
 
   // Used to serialize Log::Writer::append/truncate operations.
   Mutex mutex;
@@ -196,6 +298,19 @@ private:
   // a default/empty constructor.
   hashmap<string, Snapshot> snapshots;
 
+  // Serializes a BATCH operation to be appended to the log. A batch
+  // of a single operation is written as just that operation.
+  static Try<string> serialize(const Operation& batch);
+
+  // Returns the operation to write an entry: a DIFF against the
+  // current snapshot if possible and smaller, a SNAPSHOT otherwise.
+  Try<Operation> prepare(
+      const state::Entry& entry,
+      const Option<Snapshot>& snapshot);
+
+  // The 'set' operations waiting for the next batch.
+  std::deque<Owned<Pending>> pending;
+
   struct Metrics
   {
     Metrics()
@@ -214,10 +329,14 @@ private:
 };
 
 
-LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
+LogStorageProcess::LogStorageProcess(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    bool batch)
   : reader(log),
     writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+    diffsBetweenSnapshots(diffsBetweenSnapshots),
+    batch(batch) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -298,6 +417,72 @@ Future<Nothing> LogStorageProcess::__start(
 }
 
 
+void LogStorageProcess::tail(const Duration& interval)
+{
+  // Once the writer is started the entries are read by 'start' (and
+  // the ones appended by this storage are already known).
+  if (starting.isSome()) {
+    return;
+  }
+
+  catchup()
+    .onAny(defer(self(), &Self::_tail, interval, lambda::_1));
+}
+
+
+void LogStorageProcess::_tail(
+    const Duration& interval,
+    const Future<Nothing>& catchup)
+{
+  // NOTE: The local replica might not have learned all of the entries
+  // yet (e.g., if it missed some of the writes), in which case the
+  // read fails and is retried with the next catch-up.
+  if (!catchup.isReady()) {
+    VLOG(1) << "Failed to catch up with the log: "
+            << (catchup.isFailed() ? catchup.failure() : "discarded");
+  }
+
+  delay(interval, self(), &Self::tail, interval);
+}
+
+
+Future<Nothing> LogStorageProcess::catchup()
+{
+  return reader.beginning()
+    .then(defer(self(), &Self::_catchup, lambda::_1));
+}
+
+
+Future<Nothing> LogStorageProcess::_catchup(const Log::Position& beginning)
+{
+  // Cache for future truncations, like in '__start'.
+  if (truncated.isNone()) {
+    truncated = beginning;
+  }
+
+  // Only read the entries past our index, unless the log has been
+  // truncated since.
+  const Log::Position from =
+    index.isSome() && index.get() > beginning ? index.get() : beginning;
+
+  return reader.ending()
+    .then(defer(self(), &Self::__catchup, from, lambda::_1));
+}
+
+
+Future<Nothing> LogStorageProcess::__catchup(
+    const Log::Position& from,
+    const Log::Position& ending)
+{
+  if (index.isSome() && index.get() >= ending) {
+    return Nothing();
+  }
+
+  return reader.read(from, ending)
+    .then(defer(self(), &Self::apply, lambda::_1));
+}
+
+
 Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
 {
   VLOG(2) << "Applying operations (" << entries.size() << " entries)";
@@ -316,47 +501,79 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
         return Failure("Failed to deserialize Operation");
       }
 
-      switch (operation.type()) {
-        case Operation::SNAPSHOT: {
-          CHECK(operation.has_snapshot());
+      Try<Nothing> replayed = replay(operation, entry.position);
 
-          // Add or update (override) the snapshot.
-          Snapshot snapshot(entry.position, operation.snapshot().entry());
-          snapshots.put(snapshot.entry.name(), snapshot);
-          break;
-        }
+      if (replayed.isError()) {
+        return Failure(replayed.error());
+      }
+
+      index = entry.position;
+    }
+  }
+
+  return Nothing();
+}
 
-        case Operation::DIFF: {
-          CHECK(operation.has_diff());
 
-          Option<Snapshot> snapshot =
-            snapshots.get(operation.diff().entry().name());
+Try<Nothing> LogStorageProcess::replay(
+    const Operation& operation,
+    const Log::Position& position)
+{
+  switch (operation.type()) {
+    case Operation::SNAPSHOT: {
+      CHECK(operation.has_snapshot());
+
+      // Add or update (override) the snapshot.
+      Snapshot snapshot(position, operation.snapshot().entry());
+      snapshots.put(snapshot.entry.name(), snapshot);
+      break;
+    }
 
-          CHECK_SOME(snapshot);
+    case Operation::DIFF: {
+      CHECK(operation.has_diff());
 
-          Try<Snapshot> patched = snapshot.get().patch(operation.diff());
+      Option<Snapshot> snapshot =
+        snapshots.get(operation.diff().entry().name());
 
-          if (patched.isError()) {
-            return Failure("Failed to apply the diff: " + patched.error());
-          }
+      CHECK_SOME(snapshot);
 
-          // Replace the snapshot with the patched snapshot.
-          snapshots.put(patched.get().entry.name(), patched.get());
-          break;
-        }
+      Try<Snapshot> patched = snapshot.get().patch(operation.diff());
+
+      if (patched.isError()) {
+        return Error("Failed to apply the diff: " + patched.error());
+      }
+
+      // Replace the snapshot with the patched snapshot.
+      snapshots.put(patched.get().entry.name(), patched.get());
+      break;
+    }
+
+    case Operation::EXPUNGE: {
+      CHECK(operation.has_expunge());
+      snapshots.erase(operation.expunge().name());
+      break;
+    }
 
-        case Operation::EXPUNGE: {
-          CHECK(operation.has_expunge());
-          snapshots.erase(operation.expunge().name());
-          break;
+    case Operation::BATCH: {
+      CHECK(operation.has_batch());
+
+      // All the operations of a batch are at the same position.
+      foreach (const Operation& batched, operation.batch().operations()) {
+        if (batched.type() == Operation::BATCH) {
+          return Error("Nested BATCH operation");
         }
 
-        default:
-          return Failure("Unknown operation: " + stringify(operation.type()));
-      }
+        Try<Nothing> replayed = replay(batched, position);
 
-      index = entry.position;
+        if (replayed.isError()) {
+          return replayed;
+        }
+      }
+      break;
     }
+
+    default:
+      return Error("Unknown operation: " + stringify(operation.type()));
   }
 
   return Nothing();
@@ -366,11 +583,6 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
 // TODO(benh): Truncation could be optimized by saving the "oldest"
 // snapshot and only doing a truncation if/when we update that
 // snapshot.
-// TODO(benh): Truncation is not enough to keep the log size small as
-// the log could get very fragmented. We'll need a way to defragment
-// the log as some state entries might not get set over a long period
-// of time and their associated snapshots are causing the log to grow
-// very big.
 void LogStorageProcess::truncate()
 {
   // We lock the truncation since it includes a call to
@@ -384,22 +596,39 @@ void LogStorageProcess::truncate()
 
 Future<Nothing> LogStorageProcess::_truncate()
 {
-  // Determine the minimum necessary position for all the snapshots.
+  // Determine the minimum necessary position for all the snapshots,
+  // the entry whose snapshot is at that position, and the number of
+  // log entries that make up the current state.
   Option<Log::Position> minimum = None();
+  Option<string> oldest = None();
+  uint64_t live = 0;
 
   foreachvalue (const Snapshot& snapshot, snapshots) {
-    minimum = min(minimum, snapshot.position);
+    if (minimum.isNone() || snapshot.position < minimum.get()) {
+      minimum = snapshot.position;
+      oldest = snapshot.entry.name();
+    }
+    live += 1 + snapshot.diffs;
   }
 
-  // TODO(benh): It's possible that the minimum position we've found
-  // will leave a lot of "unnecessary" entries in the log (e.g., a
-  // snapshot that has been overwritten at a later position). In this
-  // circumstance we should "compact/defrag" the log by writing/moving
-  // snapshots to the end of the log first applying any diffs as
-  // necessary.
-
   CHECK_SOME(truncated);
 
+  // The minimum position might leave a lot of "unnecessary" entries
+  // in the log (e.g., snapshots that have been overwritten at later
+  // positions) if some entry has not been set for a long time. Since
+  // every one of those would be read when recovering, we move the
+  // oldest snapshot to the end of the log (with any diffs applied)
+  // once the log holds many more entries than are needed for the
+  // current state. This is repeated until enough snapshots have been
+  // moved, so recovery takes time proportional to the current state
+  // rather than to the history of the log.
+  if (minimum.isSome() && index.isSome() &&
+      entries(minimum.get(), index.get()) >
+        std::max(COMPACTION_FACTOR * live, COMPACTION_MINIMUM)) {
+    CHECK_SOME(oldest);
+    return compact(snapshots.get(oldest.get()).get().entry);
+  }
+
   if (minimum.isSome() && minimum.get() > truncated.get()) {
     return writer.truncate(minimum.get())
       .then(defer(self(), &Self::__truncate, minimum.get(), lambda::_1));
@@ -431,6 +660,48 @@ Future<Nothing> LogStorageProcess::__truncate(
 }
 
 
+Future<Nothing> LogStorageProcess::compact(const state::Entry& entry)
+{
+  VLOG(1) << "Moving the snapshot of '" << entry.name()
+          << "' to the end of the log";
+
+  Operation operation;
+  operation.set_type(Operation::SNAPSHOT);
+  operation.mutable_snapshot()->mutable_entry()->CopyFrom(entry);
+
+  string value;
+  if (!operation.SerializeToString(&value)) {
+    return Failure("Failed to serialize SNAPSHOT Operation");
+  }
+
+  return writer.append(value)
+    .then(defer(self(), &Self::_compact, entry, lambda::_1));
+}
+
+
+Future<Nothing> LogStorageProcess::_compact(
+    const state::Entry& entry,
+    const Option<Log::Position>& position)
+{
+  // Like with truncation, don't bother retrying if we're demoted.
+  if (position.isNone()) {
+    starting = None(); // Reset 'starting' so we try again.
+    return Nothing();
+  }
+
+  index = max(index, position);
+
+  // The entry can't have changed since we hold the mutex.
+  CHECK(snapshots.contains(entry.name()));
+
+  Snapshot snapshot(position.get(), entry);
+  snapshots.put(snapshot.entry.name(), snapshot);
+
+  // Continue with the next oldest snapshot, or the truncation.
+  return _truncate();
+}
+
+
 Future<Option<state::Entry> > LogStorageProcess::get(const string& name)
 {
   return start()
@@ -454,6 +725,20 @@ Future<bool> LogStorageProcess::set(
     const state::Entry& entry,
     const UUID& uuid)
 {
+  if (batch) {
+    Owned<Pending> set(new Pending(entry, uuid));
+    pending.push_back(set);
+
+    // Only the first pending 'set' needs to wait for the mutex, the
+    // ones that come in until the mutex is acquired are written in
+    // the same batch.
+    if (pending.size() == 1) {
+      flush();
+    }
+
+    return set->promise.future();
+  }
+
   return mutex.lock()
     .then(defer(self(), &Self::_set, entry, uuid))
     .onAny(lambda::bind(&Mutex::unlock, mutex));
@@ -481,6 +766,34 @@ Future<bool> LogStorageProcess::__set(
     return false;
   }
 
+  Try<Operation> operation = prepare(entry, snapshot);
+
+  if (operation.isError()) {
+    return Failure(operation.error());
+  }
+
+  string value;
+  if (!operation.get().SerializeToString(&value)) {
+    return Failure("Failed to serialize " +
+                   stringify(operation.get().type()) + " Operation");
+  }
+
+  size_t diffs = 0;
+  if (operation.get().type() == Operation::DIFF) {
+    diffs = snapshot.get().diffs + 1;
+  }
+
+  return writer.append(value)
+    .then(defer(self(), &Self::___set, entry, diffs, lambda::_1));
+}
+
+
+Try<Operation> LogStorageProcess::prepare(
+    const state::Entry& entry,
+    const Option<Snapshot>& snapshot)
+{
+  Operation operation;
+
   // Check if we should try to compute a diff.
   if (snapshot.isSome() && snapshot.get().diffs < diffsBetweenSnapshots) {
     // Keep metrics for the time to calculate diffs.
@@ -495,7 +808,7 @@ Future<bool> LogStorageProcess::__set(
 
     if (diff.isError()) {
       // TODO(benh): Fallback and try and write a whole snapshot?
-      return Failure("Failed to construct diff: " + diff.error());
+      return Error("Failed to construct diff: " + diff.error());
     }
 
     VLOG(1) << "Created an SVN diff in " << elapsed
@@ -505,38 +818,17 @@ Future<bool> LogStorageProcess::__set(
 
     // Only write the diff if it provides a reduction in size.
     if (diff.get().data.size() < entry.value().size()) {
-      // Append a diff operation.
-      Operation operation;
       operation.set_type(Operation::DIFF);
       operation.mutable_diff()->mutable_entry()->CopyFrom(entry);
       operation.mutable_diff()->mutable_entry()->set_value(diff.get().data);
-
-      string value;
-      if (!operation.SerializeToString(&value)) {
-        return Failure("Failed to serialize DIFF Operation");
-      }
-
-      return writer.append(value)
-        .then(defer(self(),
-                    &Self::___set,
-                    entry,
-                    snapshot.get().diffs + 1,
-                    lambda::_1));
+      return operation;
     }
   }
 
   // Write the full snapshot.
-  Operation operation;
   operation.set_type(Operation::SNAPSHOT);
   operation.mutable_snapshot()->mutable_entry()->CopyFrom(entry);
-
-  string value;
-  if (!operation.SerializeToString(&value)) {
-    return Failure("Failed to serialize SNAPSHOT Operation");
-  }
-
-  return writer.append(value)
-    .then(defer(self(), &Self::___set, entry, 0, lambda::_1));
+  return operation;
 }
 
 
@@ -573,6 +865,275 @@ Future<bool> LogStorageProcess::___set(
 }
 
 
+void LogStorageProcess::flush()
+{
+  mutex.lock()
+    .then(defer(self(), &Self::_flush))
+    .onAny(lambda::bind(&Mutex::unlock, mutex));
+}
+
+
+Future<Nothing> LogStorageProcess::_flush()
+{
+  // Take all the pending 'set' operations, the ones requested from
+  // now on wait for the next batch.
+  std::deque<Owned<Pending>> sets;
+  std::swap(sets, pending);
+
+  return start()
+    .then(defer(self(), &Self::__flush, sets))
+    .onAny(lambda::bind(&Self::flushed, sets, lambda::_1));
+}
+
+
+Future<Nothing> LogStorageProcess::__flush(
+    const std::deque<Owned<Pending>>& sets)
+{
+  Operation operation;
+  operation.set_type(Operation::BATCH);
+
+  std::deque<Owned<Pending>> batched;
+  std::deque<Owned<Pending>> deferred;
+  hashset<string> names;
+
+  foreach (const Owned<Pending>& set, sets) {
+    const state::Entry& entry = set->entry;
+
+    // A 'set' of an entry that is already in the batch has to be
+    // checked against the version written by the batch, so it is
+    // left for the next batch.
+    if (names.contains(entry.name())) {
+      deferred.push_back(set);
+      continue;
+    }
+
+    Option<Snapshot> snapshot = snapshots.get(entry.name());
+
+    // Check the version first (if we've already got a snapshot).
+    if (snapshot.isSome() &&
+        UUID::fromBytes(snapshot.get().entry.uuid()) != set->uuid) {
+      set->promise.set(false);
+      continue;
+    }
+
+    Try<Operation> prepared = prepare(entry, snapshot);
+
+    if (prepared.isError()) {
+      set->promise.fail(prepared.error());
+      continue;
+    }
+
+    if (prepared.get().type() == Operation::DIFF) {
+      set->diffs = snapshot.get().diffs + 1;
+    }
+
+    operation.mutable_batch()->add_operations()->CopyFrom(prepared.get());
+
+    names.insert(entry.name());
+    batched.push_back(set);
+  }
+
+  if (!deferred.empty()) {
+    pending.insert(pending.begin(), deferred.begin(), deferred.end());
+
+    if (pending.size() == deferred.size()) {
+      flush();
+    }
+  }
+
+  if (batched.empty()) {
+    return Nothing();
+  }
+
+  VLOG(1) << "Writing " << batched.size() << " entries in a batch";
+
+  Try<string> value = serialize(operation);
+
+  if (value.isError()) {
+    return Failure(value.error());
+  }
+
+  return writer.append(value.get())
+    .then(defer(self(), &Self::___flush, batched, lambda::_1));
+}
+
+
+Future<Nothing> LogStorageProcess::___flush(
+    const std::deque<Owned<Pending>>& sets,
+    const Option<Log::Position>& position)
+{
+  if (position.isNone()) {
+    starting = None(); // Reset 'starting' so we try again.
+
+    foreach (const Owned<Pending>& set, sets) {
+      set->promise.set(false);
+    }
+
+    return Nothing();
+  }
+
+  // See the comments in '___set'.
+  index = max(index, position);
+
+  foreach (const Owned<Pending>& set, sets) {
+    const state::Entry& entry = set->entry;
+
+    Log::Position snapshot = position.get();
+    if (set->diffs > 0) {
+      CHECK(snapshots.contains(entry.name()));
+      snapshot = snapshots.get(entry.name()).get().position;
+    }
+
+    snapshots.put(entry.name(), Snapshot(snapshot, entry, set->diffs));
+
+    set->promise.set(true);
+  }
+
+  // And truncate the log if necessary.
+  truncate();
+
+  return Nothing();
+}
+
+
+void LogStorageProcess::flushed(
+    const std::deque<Owned<Pending>>& sets,
+    const Future<Nothing>& future)
+{
+  // Fail the 'set' operations that didn't complete because the batch
+  // couldn't be written, e.g., because the writer couldn't start.
+  foreach (const Owned<Pending>& set, sets) {
+    if (set->promise.future().isPending()) {
+      if (future.isFailed()) {
+        set->promise.fail(future.failure());
+      } else {
+        set->promise.discard();
+      }
+    }
+  }
+}
+
+
+Future<bool> LogStorageProcess::setAll(
+    const vector<pair<state::Entry, UUID>>& entries)
+{
+  return mutex.lock()
+    .then(defer(self(), &Self::_setAll, entries))
+    .onAny(lambda::bind(&Mutex::unlock, mutex));
+}
+
+
+Future<bool> LogStorageProcess::_setAll(
+    const vector<pair<state::Entry, UUID>>& entries)
+{
+  return start()
+    .then(defer(self(), &Self::__setAll, entries));
+}
+
+
+Future<bool> LogStorageProcess::__setAll(
+    const vector<pair<state::Entry, UUID>>& entries)
+{
+  if (entries.empty()) {
+    return true;
+  }
+
+  // All the entries are written atomically with a single append.
+  Operation operation;
+  operation.set_type(Operation::BATCH);
+
+  vector<size_t> diffs;
+
+  typedef pair<state::Entry, UUID> Pair;
+  foreach (const Pair& pair, entries) {
+    const state::Entry& entry = pair.first;
+
+    Option<Snapshot> snapshot = snapshots.get(entry.name());
+
+    // Check the version first (if we've already got a snapshot).
+    if (snapshot.isSome() &&
+        UUID::fromBytes(snapshot.get().entry.uuid()) != pair.second) {
+      return false;
+    }
+
+    Try<Operation> prepared = prepare(entry, snapshot);
+
+    if (prepared.isError()) {
+      return Failure(prepared.error());
+    }
+
+    if (prepared.get().type() == Operation::DIFF) {
+      diffs.push_back(snapshot.get().diffs + 1);
+    } else {
+      diffs.push_back(0);
+    }
+
+    operation.mutable_batch()->add_operations()->CopyFrom(prepared.get());
+  }
+
+  Try<string> value = serialize(operation);
+
+  if (value.isError()) {
+    return Failure(value.error());
+  }
+
+  return writer.append(value.get())
+    .then(defer(self(), &Self::___setAll, entries, diffs, lambda::_1));
+}
+
+
+Future<bool> LogStorageProcess::___setAll(
+    const vector<pair<state::Entry, UUID>>& entries,
+    const vector<size_t>& diffs,
+    const Option<Log::Position>& position)
+{
+  if (position.isNone()) {
+    starting = None(); // Reset 'starting' so we try again.
+    return false;
+  }
+
+  // See the comments in '___set'.
+  index = max(index, position);
+
+  CHECK_EQ(entries.size(), diffs.size());
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    const state::Entry& entry = entries[i].first;
+
+    Log::Position snapshot = position.get();
+    if (diffs[i] > 0) {
+      CHECK(snapshots.contains(entry.name()));
+      snapshot = snapshots.get(entry.name()).get().position;
+    }
+
+    snapshots.put(entry.name(), Snapshot(snapshot, entry, diffs[i]));
+  }
+
+  // And truncate the log if necessary.
+  truncate();
+
+  return true;
+}
+
+
+Try<string> LogStorageProcess::serialize(const Operation& batch)
+{
+  CHECK_EQ(Operation::BATCH, batch.type());
+
+  string value;
+
+  if (batch.batch().operations_size() == 1) {
+    if (!batch.batch().operations(0).SerializeToString(&value)) {
+      return Error("Failed to serialize Operation");
+    }
+  } else if (!batch.SerializeToString(&value)) {
+    return Error("Failed to serialize BATCH Operation");
+  }
+
+  return value;
+}
+
+
 Future<bool> LogStorageProcess::expunge(const state::Entry& entry)
 {
   return mutex.lock()
@@ -649,9 +1210,9 @@ Future<std::set<string> > LogStorageProcess::_names()
 }
 
 
-LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots)
+LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots, bool batch)
 {
-  process = new LogStorageProcess(log, diffsBetweenSnapshots);
+  process = new LogStorageProcess(log, diffsBetweenSnapshots, batch);
   spawn(process);
 }
 
@@ -676,6 +1237,12 @@ Future<bool> LogStorage::set(const state::Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> LogStorage::set(const vector<pair<state::Entry, UUID>>& entries)
+{
+  return dispatch(process, &LogStorageProcess::setAll, entries);
+}
+
+
 Future<bool> LogStorage::expunge(const state::Entry& entry)
 {
   return dispatch(process, &LogStorageProcess::expunge, entry);
@@ -687,6 +1254,12 @@ Future<std::set<string> > LogStorage::names()
   return dispatch(process, &LogStorageProcess::names);
 }
 
+
+void LogStorage::tail(const Duration& interval)
+{
+  dispatch(process, &LogStorageProcess::tail, interval);
+}
+
 } // namespace state {
 } // namespace internal {
 } // namespace mesos {
@@ -19,9 +19,12 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/future.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/uuid.hpp>
 
@@ -42,16 +45,32 @@ class LogStorageProcess;
 class LogStorage : public Storage
 {
 public:
-  LogStorage(log::Log* log, size_t diffsBetweenSnapshots = 0);
+  // If 'batch' is true, concurrent 'set' operations of distinct
+  // entries are written to the log with a single append. NOTE: Such
+  // a log can't be read by versions that don't support batching.
+  LogStorage(
+      log::Log* log,
+      size_t diffsBetweenSnapshots = 0,
+      bool batch = false);
 
   virtual ~LogStorage();
 
   // Storage implementation.
   virtual process::Future<Option<Entry> > get(const std::string& name);
   virtual process::Future<bool> set(const Entry& entry, const UUID& uuid);
+  virtual process::Future<bool> set(
+      const std::vector<std::pair<Entry, UUID> >& entries);
   virtual process::Future<bool> expunge(const Entry& entry);
   virtual process::Future<std::set<std::string> > names();
 
+  // Reads the entries appended to the log by other writers (e.g., by
+  // the leading master) every 'interval', until this storage starts
+  // its own writer. This keeps the entries cached in memory up to
+  // date, so the first operation (e.g., the recovery of the registrar
+  // of a standby master which got elected) only needs to read the
+  // entries appended since the last read, rather than the whole log.
+  void tail(const Duration& interval);
+
 private:
   LogStorageProcess* process;
 };
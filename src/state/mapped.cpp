@@ -0,0 +1,659 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <process/dispatch.hpp>
+#include <process/future.hpp>
+#include <process/process.hpp>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/try.hpp>
+#include <stout/uuid.hpp>
+
+#include "logging/logging.hpp"
+
+#include "messages/state.hpp"
+
+#include "state/mapped.hpp"
+#include "state/storage.hpp"
+
+using namespace process;
+
+// Note that we don't add 'using std::set' here because we need
+// 'std::' to disambiguate the 'set' member.
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace state {
+
+// Every record of the log starts with the length and the CRC32 of the
+// serialized operation that follows, so that a record which was only
+// partially written when the process (or the machine) crashed is
+// detected when the log is replayed.
+struct Header
+{
+  uint32_t length;
+  uint32_t checksum;
+};
+
+
+static const size_t HEADER_SIZE = sizeof(Header);
+
+// The file is grown by doubling it, starting with this size.
+static const size_t MIN_CAPACITY = 64 * 1024;
+
+// The log is compacted once it is larger than this and than
+// COMPACTION_FACTOR times the size of its live records, i.e., of the
+// records of the current entries.
+static const size_t COMPACTION_MIN_SIZE = 1024 * 1024;
+static const size_t COMPACTION_FACTOR = 2;
+
+
+static uint32_t checksum(const char* data, size_t length)
+{
+  return ::crc32(
+      ::crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data), length);
+}
+
+
+// Returns the size of the SNAPSHOT record of the entry, i.e., the
+// space it takes in a compacted log.
+static size_t size(const Entry& entry)
+{
+  Operation operation;
+  operation.set_type(Operation::SNAPSHOT);
+  operation.mutable_snapshot()->mutable_entry()->CopyFrom(entry);
+
+  return HEADER_SIZE + operation.ByteSize();
+}
+
+
+class MappedStorageProcess : public Process<MappedStorageProcess>
+{
+public:
+  MappedStorageProcess(const string& path, bool sync);
+  virtual ~MappedStorageProcess();
+
+  virtual void initialize();
+
+  // Storage implementation.
+  Future<Option<Entry>> get(const string& name);
+  Future<bool> set(const Entry& entry, const UUID& uuid);
+  Future<bool> setAll(const vector<pair<Entry, UUID>>& entries);
+  Future<bool> expunge(const Entry& entry);
+  Future<std::set<string>> names();
+
+private:
+  // Maps the log and replays its records.
+  Try<Nothing> open();
+  void close();
+
+  // Appends the operation to the log and applies it to the entries,
+  // compacting the log if most of it has been superseded.
+  Try<Nothing> write(const Operation& operation);
+
+  Try<Nothing> append(const Operation& operation);
+  Try<Nothing> apply(const Operation& operation);
+
+  // Grows the file (and the mapping) to fit 'length' more bytes.
+  Try<Nothing> reserve(size_t length);
+
+  // Replaces the log with one holding a SNAPSHOT per entry.
+  Try<Nothing> compact();
+
+  const string path;
+  const bool sync;
+
+  int fd;
+  char* data;
+
+  // The size of the file, which is also the length of the mapping.
+  size_t capacity;
+
+  // The offset of the end of the last record.
+  size_t end;
+
+  // The size of the live records, see 'size'.
+  size_t live;
+
+  hashmap<string, Entry> entries;
+
+  Option<string> error;
+};
+
+
+MappedStorageProcess::MappedStorageProcess(const string& _path, bool _sync)
+  : path(_path),
+    sync(_sync),
+    fd(-1),
+    data(NULL),
+    capacity(0),
+    end(0),
+    live(0) {}
+
+
+MappedStorageProcess::~MappedStorageProcess()
+{
+  close();
+}
+
+
+void MappedStorageProcess::initialize()
+{
+  Try<Nothing> open = this->open();
+
+  if (open.isError()) {
+    error = "Failed to recover '" + path + "': " + open.error();
+    close();
+  }
+}
+
+
+Future<std::set<string>> MappedStorageProcess::names()
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  std::set<string> results;
+  foreachkey (const string& name, entries) {
+    results.insert(name);
+  }
+
+  return results;
+}
+
+
+Future<Option<Entry>> MappedStorageProcess::get(const string& name)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  return entries.get(name);
+}
+
+
+Future<bool> MappedStorageProcess::set(const Entry& entry, const UUID& uuid)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  Option<Entry> option = entries.get(entry.name());
+
+  if (option.isSome() && UUID::fromBytes(option.get().uuid()) != uuid) {
+    return false;
+  }
+
+  Operation operation;
+  operation.set_type(Operation::SNAPSHOT);
+  operation.mutable_snapshot()->mutable_entry()->CopyFrom(entry);
+
+  Try<Nothing> write = this->write(operation);
+
+  if (write.isError()) {
+    return Failure(write.error());
+  }
+
+  return true;
+}
+
+
+Future<bool> MappedStorageProcess::setAll(
+    const vector<pair<Entry, UUID>>& entries)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  // All the entries are written atomically as a single BATCH record.
+  Operation operation;
+  operation.set_type(Operation::BATCH);
+
+  typedef pair<Entry, UUID> Pair;
+  foreach (const Pair& pair, entries) {
+    const Entry& entry = pair.first;
+
+    // Like in 'set', make sure the version has not changed.
+    Option<Entry> option = this->entries.get(entry.name());
+
+    if (option.isSome() &&
+        UUID::fromBytes(option.get().uuid()) != pair.second) {
+      return false;
+    }
+
+    Operation* snapshot = operation.mutable_batch()->add_operations();
+    snapshot->set_type(Operation::SNAPSHOT);
+    snapshot->mutable_snapshot()->mutable_entry()->CopyFrom(entry);
+  }
+
+  Try<Nothing> write = this->write(operation);
+
+  if (write.isError()) {
+    return Failure(write.error());
+  }
+
+  return true;
+}
+
+
+Future<bool> MappedStorageProcess::expunge(const Entry& entry)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  Option<Entry> option = entries.get(entry.name());
+
+  if (option.isNone()) {
+    return false;
+  }
+
+  if (UUID::fromBytes(option.get().uuid()) != UUID::fromBytes(entry.uuid())) {
+    return false;
+  }
+
+  Operation operation;
+  operation.set_type(Operation::EXPUNGE);
+  operation.mutable_expunge()->set_name(entry.name());
+
+  Try<Nothing> write = this->write(operation);
+
+  if (write.isError()) {
+    return Failure(write.error());
+  }
+
+  return true;
+}
+
+
+Try<Nothing> MappedStorageProcess::open()
+{
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd == -1) {
+    return ErrnoError("Failed to open '" + path + "'");
+  }
+
+  struct stat s;
+  if (::fstat(fd, &s) != 0) {
+    return ErrnoError("Failed to stat '" + path + "'");
+  }
+
+  capacity = std::max(static_cast<size_t>(s.st_size), MIN_CAPACITY);
+
+  if (capacity != static_cast<size_t>(s.st_size) &&
+      ::ftruncate(fd, capacity) != 0) {
+    return ErrnoError("Failed to resize '" + path + "'");
+  }
+
+  void* mapped =
+    ::mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    return ErrnoError("Failed to map '" + path + "'");
+  }
+
+  data = static_cast<char*>(mapped);
+
+  entries.clear();
+  live = 0;
+  end = 0;
+
+  // Replay the records up to the end of the log (where the file is
+  // zero filled) or up to a record which was torn by a crash.
+  while (capacity - end >= HEADER_SIZE) {
+    Header header;
+    memcpy(&header, data + end, HEADER_SIZE);
+
+    const char* record = data + end + HEADER_SIZE;
+
+    if (header.length == 0 ||
+        header.length > capacity - end - HEADER_SIZE ||
+        header.checksum != checksum(record, header.length)) {
+      break;
+    }
+
+    Operation operation;
+    if (!operation.ParseFromArray(record, header.length)) {
+      return Error("Failed to deserialize Operation");
+    }
+
+    Try<Nothing> apply = this->apply(operation);
+    if (apply.isError()) {
+      return Error(apply.error());
+    }
+
+    end += HEADER_SIZE + header.length;
+  }
+
+  if (end < capacity) {
+    if (data[end] != 0) {
+      LOG(WARNING) << "Discarding the torn tail of '" << path
+                   << "' after " << end << " bytes";
+    }
+
+    // Clear the torn record (if any), so that its remains can not be
+    // taken for a record once a shorter one is appended in its place.
+    memset(data + end, 0, capacity - end);
+  }
+
+  return Nothing();
+}
+
+
+void MappedStorageProcess::close()
+{
+  if (data != NULL) {
+    ::munmap(data, capacity);
+    data = NULL;
+  }
+
+  if (fd != -1) {
+    os::close(fd);
+    fd = -1;
+  }
+}
+
+
+Try<Nothing> MappedStorageProcess::write(const Operation& operation)
+{
+  CHECK_NONE(error);
+
+  Try<Nothing> append = this->append(operation);
+
+  if (append.isError()) {
+    // The record might have been partially written (or written but
+    // not synced), so the log might not match the entries anymore.
+    error = "Failed to write to '" + path + "': " + append.error();
+    return Error(error.get());
+  }
+
+  Try<Nothing> apply = this->apply(operation);
+  CHECK_SOME(apply);
+
+  if (end >= COMPACTION_MIN_SIZE && end > COMPACTION_FACTOR * live) {
+    Try<Nothing> compact = this->compact();
+
+    if (compact.isError()) {
+      // The log is still intact, so compacting is simply retried
+      // after the next change.
+      LOG(WARNING) << "Failed to compact '" << path << "': "
+                   << compact.error();
+    }
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> MappedStorageProcess::append(const Operation& operation)
+{
+  string record;
+
+  if (!operation.SerializeToString(&record)) {
+    return Error("Failed to serialize Operation");
+  }
+
+  Try<Nothing> reserve = this->reserve(HEADER_SIZE + record.size());
+  if (reserve.isError()) {
+    return reserve;
+  }
+
+  Header header;
+  header.length = record.size();
+  header.checksum = checksum(record.data(), record.size());
+
+  memcpy(data + end, &header, HEADER_SIZE);
+  memcpy(data + end + HEADER_SIZE, record.data(), record.size());
+
+  if (sync) {
+    // NOTE: msync(2) expects a page aligned address.
+    const size_t page = ::sysconf(_SC_PAGESIZE);
+    const size_t start = end - end % page;
+
+    if (::msync(data + start,
+                end + HEADER_SIZE + record.size() - start,
+                MS_SYNC) != 0) {
+      return ErrnoError("Failed to sync '" + path + "'");
+    }
+  }
+
+  end += HEADER_SIZE + record.size();
+
+  return Nothing();
+}
+
+
+Try<Nothing> MappedStorageProcess::apply(const Operation& operation)
+{
+  switch (operation.type()) {
+    case Operation::SNAPSHOT: {
+      const Entry& entry = operation.snapshot().entry();
+
+      if (entries.contains(entry.name())) {
+        live -= size(entries[entry.name()]);
+      }
+
+      entries[entry.name()] = entry;
+      live += size(entry);
+      return Nothing();
+    }
+
+    case Operation::EXPUNGE: {
+      const string& name = operation.expunge().name();
+
+      if (entries.contains(name)) {
+        live -= size(entries[name]);
+        entries.erase(name);
+      }
+      return Nothing();
+    }
+
+    case Operation::BATCH: {
+      foreach (const Operation& batched, operation.batch().operations()) {
+        Try<Nothing> apply = this->apply(batched);
+        if (apply.isError()) {
+          return apply;
+        }
+      }
+      return Nothing();
+    }
+
+    default:
+      return Error("Unexpected operation type " +
+                   Operation::Type_Name(operation.type()));
+  }
+}
+
+
+Try<Nothing> MappedStorageProcess::reserve(size_t length)
+{
+  if (capacity - end >= length) {
+    return Nothing();
+  }
+
+  size_t capacity_ = capacity;
+  while (capacity_ - end < length) {
+    capacity_ *= 2;
+  }
+
+  if (::ftruncate(fd, capacity_) != 0) {
+    return ErrnoError("Failed to resize '" + path + "'");
+  }
+
+  // NOTE: The file is mapped again rather than by mremap(2), which
+  // is Linux specific. The records are not copied since both of the
+  // mappings share the page cache.
+  void* mapped =
+    ::mmap(NULL, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    return ErrnoError("Failed to map '" + path + "'");
+  }
+
+  ::munmap(data, capacity);
+
+  data = static_cast<char*>(mapped);
+  capacity = capacity_;
+
+  return Nothing();
+}
+
+
+Try<Nothing> MappedStorageProcess::compact()
+{
+  VLOG(1) << "Compacting '" << path << "' from " << end << " to "
+          << live << " bytes";
+
+  string contents;
+  contents.reserve(live);
+
+  foreachvalue (const Entry& entry, entries) {
+    Operation operation;
+    operation.set_type(Operation::SNAPSHOT);
+    operation.mutable_snapshot()->mutable_entry()->CopyFrom(entry);
+
+    string record;
+
+    if (!operation.SerializeToString(&record)) {
+      return Error("Failed to serialize Operation");
+    }
+
+    Header header;
+    header.length = record.size();
+    header.checksum = checksum(record.data(), record.size());
+
+    contents.append(reinterpret_cast<const char*>(&header), HEADER_SIZE);
+    contents.append(record);
+  }
+
+  // The compacted log is written to a temporary file which then
+  // replaces the log, so that a crash leaves one of them intact.
+  const string temporary = path + ".compact";
+
+  int fd_ = ::open(
+      temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ == -1) {
+    return ErrnoError("Failed to open '" + temporary + "'");
+  }
+
+  Try<Nothing> write = os::write(fd_, contents);
+
+  if (write.isError()) {
+    os::close(fd_);
+    os::rm(temporary);
+    return Error("Failed to write '" + temporary + "': " + write.error());
+  }
+
+  if (::fsync(fd_) != 0) {
+    ErrnoError error("Failed to sync '" + temporary + "'");
+    os::close(fd_);
+    os::rm(temporary);
+    return error;
+  }
+
+  os::close(fd_);
+
+  Try<Nothing> rename = os::rename(temporary, path);
+
+  if (rename.isError()) {
+    os::rm(temporary);
+    return Error("Failed to rename '" + temporary + "': " + rename.error());
+  }
+
+  // Switch over to the compacted log, which is replayed like on
+  // recovery.
+  close();
+
+  Try<Nothing> open = this->open();
+
+  if (open.isError()) {
+    error = "Failed to reopen '" + path + "': " + open.error();
+    close();
+  }
+
+  return Nothing();
+}
+
+
+MappedStorage::MappedStorage(const string& path, bool sync)
+{
+  process = new MappedStorageProcess(path, sync);
+  spawn(process);
+}
+
+
+MappedStorage::~MappedStorage()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+Future<Option<Entry>> MappedStorage::get(const string& name)
+{
+  return dispatch(process, &MappedStorageProcess::get, name);
+}
+
+
+Future<bool> MappedStorage::set(const Entry& entry, const UUID& uuid)
+{
+  return dispatch(process, &MappedStorageProcess::set, entry, uuid);
+}
+
+
+Future<bool> MappedStorage::set(const vector<pair<Entry, UUID>>& entries)
+{
+  return dispatch(process, &MappedStorageProcess::setAll, entries);
+}
+
+
+Future<bool> MappedStorage::expunge(const Entry& entry)
+{
+  return dispatch(process, &MappedStorageProcess::expunge, entry);
+}
+
+
+Future<std::set<string>> MappedStorage::names()
+{
+  return dispatch(process, &MappedStorageProcess::names);
+}
+
+} // namespace state {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,76 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __STATE_MAPPED_HPP__
+#define __STATE_MAPPED_HPP__
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <process/future.hpp>
+
+#include <stout/option.hpp>
+#include <stout/uuid.hpp>
+
+#include "messages/state.hpp"
+
+#include "state/storage.hpp"
+
+namespace mesos {
+namespace internal {
+namespace state {
+
+// More forward declarations.
+class MappedStorageProcess;
+
+
+// Keeps the entries in memory like the 'InMemoryStorage', but also
+// appends every change to a memory mapped file so that the entries
+// survive restarts, without paying for a database. The file is a log
+// of checksummed records which is replayed when the storage is
+// created (up to the first torn or corrupted record), and which is
+// compacted into a record per entry once most of its records have
+// been superseded.
+//
+// NOTE: Unless 'sync' is true, a change is durable once it is in the
+// page cache, i.e., it survives a crash of the process but not one of
+// the machine. With 'sync' every change is written back to disk
+// before its future is satisfied.
+class MappedStorage : public Storage
+{
+public:
+  explicit MappedStorage(const std::string& path, bool sync = false);
+  virtual ~MappedStorage();
+
+  // Storage implementation.
+  virtual process::Future<Option<Entry>> get(const std::string& name);
+  virtual process::Future<bool> set(const Entry& entry, const UUID& uuid);
+  virtual process::Future<bool> set(
+      const std::vector<std::pair<Entry, UUID>>& entries);
+  virtual process::Future<bool> expunge(const Entry& entry);
+  virtual process::Future<std::set<std::string>> names();
+
+private:
+  MappedStorageProcess* process;
+};
+
+} // namespace state {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __STATE_MAPPED_HPP__
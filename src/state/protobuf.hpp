@@ -18,9 +18,11 @@
 #define __STATE_PROTOBUF_HPP__
 
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
 #include <stout/some.hpp>
@@ -86,6 +88,11 @@ public:
   template <typename T>
   process::Future<Option<Variable<T> > > store(const Variable<T>& variable);
 
+  // Stores all the variables atomically, see 'state::State::store'.
+  template <typename T>
+  process::Future<Option<std::vector<Variable<T> > > > store(
+      const std::vector<Variable<T> >& variables);
+
   // Expunges the variable from the state.
   template <typename T>
   process::Future<bool> expunge(const Variable<T>& variable);
@@ -102,6 +109,11 @@ private:
   static process::Future<Option<Variable<T> > > _store(
       const T& t,
       const Option<state::Variable>& variable);
+
+  template <typename T>
+  static process::Future<Option<std::vector<Variable<T> > > > _storeAll(
+      const std::vector<T>& ts,
+      const Option<std::vector<state::Variable> >& variables);
 };
 
 
@@ -154,6 +166,47 @@ process::Future<Option<Variable<T> > > State::_store(
 }
 
 
+template <typename T>
+process::Future<Option<std::vector<Variable<T> > > > State::store(
+    const std::vector<Variable<T> >& variables)
+{
+  std::vector<state::Variable> mutated;
+  std::vector<T> ts;
+
+  foreach (const Variable<T>& variable, variables) {
+    Try<std::string> value = messages::serialize(variable.t);
+
+    if (value.isError()) {
+      return process::Failure(value.error());
+    }
+
+    mutated.push_back(variable.variable.mutate(value.get()));
+    ts.push_back(variable.t);
+  }
+
+  return state::State::store(mutated)
+    .then(lambda::bind(&State::template _storeAll<T>, ts, lambda::_1));
+}
+
+
+template <typename T>
+process::Future<Option<std::vector<Variable<T> > > > State::_storeAll(
+    const std::vector<T>& ts,
+    const Option<std::vector<state::Variable> >& variables)
+{
+  if (variables.isNone()) {
+    return None();
+  }
+
+  std::vector<Variable<T> > stored;
+  for (size_t i = 0; i < ts.size(); i++) {
+    stored.push_back(Variable<T>(variables.get()[i], ts[i]));
+  }
+
+  return Some(stored);
+}
+
+
 template <typename T>
 process::Future<bool> State::expunge(const Variable<T>& variable)
 {
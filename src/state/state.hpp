@@ -19,10 +19,13 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
 #include <process/future.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
@@ -105,6 +108,14 @@ public:
   // was no longer valid, or an error if one occurs.
   process::Future<Option<Variable> > store(const Variable& variable);
 
+  // Stores all the variables atomically. Returns the variables if
+  // all of them were successfully stored in the state, otherwise
+  // returns none if the version of any of the variables was no longer
+  // valid (in which case none of them was stored), or an error if one
+  // occurs. The names of the variables must be distinct.
+  process::Future<Option<std::vector<Variable> > > store(
+      const std::vector<Variable>& variables);
+
   // Returns true if successfully expunged the variable from the state.
   process::Future<bool> expunge(const Variable& variable);
 
@@ -123,6 +134,10 @@ private:
       const Entry& entry,
       const bool& b); // TODO(benh): Remove 'const &' after fixing libprocess.
 
+  static process::Future<Option<std::vector<Variable> > > _storeAll(
+      const std::vector<Entry>& entries,
+      const bool& b); // TODO(benh): Remove 'const &' after fixing libprocess.
+
   Storage* storage;
 };
 
@@ -181,6 +196,54 @@ inline process::Future<Option<Variable > > State::_store(
 }
 
 
+inline process::Future<Option<std::vector<Variable> > > State::store(
+    const std::vector<Variable>& variables)
+{
+  std::vector<std::pair<Entry, UUID> > entries;
+  std::vector<Entry> stored;
+  std::set<std::string> names;
+
+  foreach (const Variable& variable, variables) {
+    if (names.count(variable.entry.name()) > 0) {
+      return process::Failure(
+          "Variable '" + variable.entry.name() + "' is stored more than once");
+    }
+
+    names.insert(variable.entry.name());
+
+    // See the comments in 'store' above.
+    Entry entry;
+    entry.set_name(variable.entry.name());
+    entry.set_uuid(UUID::random().toBytes());
+    entry.set_value(variable.entry.value());
+
+    entries.push_back(
+        std::make_pair(entry, UUID::fromBytes(variable.entry.uuid())));
+
+    stored.push_back(entry);
+  }
+
+  return storage->set(entries)
+    .then(lambda::bind(&State::_storeAll, stored, lambda::_1));
+}
+
+
+inline process::Future<Option<std::vector<Variable> > > State::_storeAll(
+    const std::vector<Entry>& entries,
+    const bool& b) // TODO(benh): Remove 'const &' after fixing libprocess.
+{
+  if (b) {
+    std::vector<Variable> variables;
+    foreach (const Entry& entry, entries) {
+      variables.push_back(Variable(entry));
+    }
+    return Some(variables);
+  }
+
+  return None();
+}
+
+
 inline process::Future<bool> State::expunge(const Variable& variable)
 {
   return storage->expunge(variable.entry);
@@ -19,6 +19,8 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/future.hpp>
 
@@ -44,6 +46,13 @@ public:
   virtual process::Future<Option<Entry> > get(const std::string& name) = 0;
   virtual process::Future<bool> set(const Entry& entry, const UUID& uuid) = 0;
 
+  // Sets multiple state entries atomically, i.e., either all of the
+  // entries are set or none of them is (false is returned). Like for
+  // a single entry, each existing entry is required to have the
+  // specified UUID. The names of the entries must be distinct.
+  virtual process::Future<bool> set(
+      const std::vector<std::pair<Entry, UUID> >& entries) = 0;
+
   // Returns true if successfully expunged the variable from the state.
   virtual process::Future<bool> expunge(const Entry& entry) = 0;
 
@@ -21,6 +21,7 @@
 #include <queue>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/dispatch.hpp>
@@ -29,10 +30,12 @@
 
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/result.hpp>
 #include <stout/some.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/uuid.hpp>
@@ -52,6 +55,7 @@ using namespace process;
 
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
+using std::pair;
 using std::queue;
 using std::string;
 using std::vector;
@@ -78,6 +82,7 @@ public:
   // Storage implementation.
   Future<Option<Entry> > get(const string& name);
   Future<bool> set(const Entry& entry, const UUID& uuid);
+  Future<bool> setAll(const vector<pair<Entry, UUID>>& entries);
   virtual Future<bool> expunge(const Entry& entry);
   Future<std::set<string> > names();
 
@@ -95,6 +100,7 @@ private:
   Result<std::set<string> > doNames();
   Result<Option<Entry> > doGet(const string& name);
   Result<bool> doSet(const Entry& entry, const UUID& uuid);
+  Result<bool> doSetAll(const vector<pair<Entry, UUID>>& entries);
   Result<bool> doExpunge(const Entry& entry);
 
   const string servers;
@@ -141,6 +147,15 @@ private:
     Promise<bool> promise;
   };
 
+  struct SetAll
+  {
+    explicit SetAll(const vector<pair<Entry, UUID>>& _entries)
+      : entries(_entries) {}
+
+    vector<pair<Entry, UUID>> entries;
+    Promise<bool> promise;
+  };
+
   struct Expunge
   {
     explicit Expunge(const Entry& _entry) : entry(_entry) {}
@@ -155,6 +170,7 @@ private:
     queue<Names*> names;
     queue<Get*> gets;
     queue<Set*> sets;
+    queue<SetAll*> setAlls;
     queue<Expunge*> expunges;
   } pending;
 
@@ -198,6 +214,7 @@ ZooKeeperStorageProcess::~ZooKeeperStorageProcess()
   fail(&pending.names, "No longer managing storage");
   fail(&pending.gets, "No longer managing storage");
   fail(&pending.sets, "No longer managing storage");
+  fail(&pending.setAlls, "No longer managing storage");
 
   delete zk;
   delete watcher;
@@ -285,6 +302,31 @@ Future<bool> ZooKeeperStorageProcess::set(const Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> ZooKeeperStorageProcess::setAll(
+    const vector<pair<Entry, UUID>>& entries)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  } else if (state != CONNECTED) {
+    SetAll* setAll = new SetAll(entries);
+    pending.setAlls.push(setAll);
+    return setAll->promise.future();
+  }
+
+  Result<bool> result = doSetAll(entries);
+
+  if (result.isNone()) { // Try again later.
+    SetAll* setAll = new SetAll(entries);
+    pending.setAlls.push(setAll);
+    return setAll->promise.future();
+  } else if (result.isError()) {
+    return Failure(result.error());
+  }
+
+  return result.get();
+}
+
+
 Future<bool> ZooKeeperStorageProcess::expunge(const Entry& entry)
 {
   if (error.isSome()) {
@@ -373,6 +415,20 @@ void ZooKeeperStorageProcess::connected(int64_t sessionId, bool reconnect)
     pending.sets.pop();
     delete set;
   }
+
+  while (!pending.setAlls.empty()) {
+    SetAll* setAll = pending.setAlls.front();
+    Result<bool> result = doSetAll(setAll->entries);
+    if (result.isNone()) {
+      return; // Try again later.
+    } else if (result.isError()) {
+      setAll->promise.fail(result.error());
+    } else {
+      setAll->promise.set(result.get());
+    }
+    pending.setAlls.pop();
+    delete setAll;
+  }
 }
 
 
@@ -574,6 +630,144 @@ Result<bool> ZooKeeperStorageProcess::doSet(const Entry& entry,
 }
 
 
+Result<bool> ZooKeeperStorageProcess::doSetAll(
+    const vector<pair<Entry, UUID>>& entries)
+{
+  CHECK_NONE(error) << ": " << error.get();
+  CHECK(state == CONNECTED);
+
+  if (entries.empty()) {
+    return true;
+  }
+
+  // The paths and data of the znodes, which the operations of the
+  // transaction refer to.
+  vector<string> paths;
+  vector<string> datas;
+  vector<Option<int>> versions; // None if the znode has to be created.
+  bool create = false;
+
+  typedef pair<Entry, UUID> Pair;
+  foreach (const Pair& pair, entries) {
+    const Entry& entry = pair.first;
+
+    // Serialize to make sure we're under the 1 MB limit.
+    string data;
+
+    if (!entry.SerializeToString(&data)) {
+      return Error("Failed to serialize Entry");
+    }
+
+    if (data.size() > 1024 * 1024) { // 1 MB
+      return Error("Serialized data is too big (> 1 MB)");
+    }
+
+    const string path = znode + "/" + entry.name();
+
+    string result;
+    Stat stat;
+
+    int code = zk->get(path, false, &result, &stat);
+
+    if (code == ZNONODE) {
+      versions.push_back(None());
+      create = true;
+    } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK) {
+      return Error(
+          "Failed to get '" + path + "' in ZooKeeper: " + zk->message(code));
+    } else {
+      google::protobuf::io::ArrayInputStream stream(
+          result.data(),
+          result.size());
+
+      Entry current;
+
+      if (!current.ParseFromZeroCopyStream(&stream)) {
+        return Error("Failed to deserialize Entry");
+      }
+
+      if (UUID::fromBytes(current.uuid()) != pair.second) {
+        return false;
+      }
+
+      versions.push_back(stat.version);
+    }
+
+    paths.push_back(path);
+    datas.push_back(data);
+  }
+
+  // Create directory path znodes as necessary (see 'doSet'). This is
+  // done up front since the transaction only creates the entries.
+  if (create) {
+    CHECK(znode.size() == 0 || znode.at(znode.size() - 1) != '/');
+    size_t index = znode.find("/", 0);
+
+    while (index < string::npos) {
+      index = znode.find("/", index + 1);
+      string prefix = znode.substr(0, index);
+
+      int code = zk->create(prefix, "", acl, 0, NULL);
+
+      if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+        CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+        return None(); // Try again later.
+      } else if (code != ZOK && code != ZNODEEXISTS) {
+        return Error(
+            "Failed to create '" + prefix +
+            "' in ZooKeeper: " + zk->message(code));
+      }
+    }
+  }
+
+  // Okay, do the transaction, we get atomicity by requiring the
+  // version of each existing znode, and by creating the others.
+  vector<zoo_op_t> ops(paths.size());
+
+  for (size_t i = 0; i < paths.size(); i++) {
+    if (versions[i].isNone()) {
+      zoo_create_op_init(
+          &ops[i],
+          paths[i].c_str(),
+          datas[i].data(),
+          datas[i].size(),
+          &acl,
+          0,
+          NULL,
+          0);
+    } else {
+      zoo_set_op_init(
+          &ops[i],
+          paths[i].c_str(),
+          datas[i].data(),
+          datas[i].size(),
+          versions[i].get(),
+          NULL);
+    }
+  }
+
+  vector<zoo_op_result_t> results;
+
+  int code = zk->multi(ops, &results);
+
+  if (code == ZBADVERSION || code == ZNODEEXISTS || code == ZNONODE) {
+    return false; // Lost a race with someone else.
+  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+    CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+    return None(); // Try again later.
+  } else if (code != ZOK) {
+    return Error(
+        "Failed to set " + stringify(entries.size()) +
+        " entries in ZooKeeper: " + zk->message(code));
+  }
+
+  return true;
+}
+
+
 Result<bool> ZooKeeperStorageProcess::doExpunge(const Entry& entry)
 {
   CHECK_NONE(error) << ": " << error.get();
@@ -656,6 +850,12 @@ Future<bool> ZooKeeperStorage::set(const Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> ZooKeeperStorage::set(const vector<pair<Entry, UUID>>& entries)
+{
+  return dispatch(process, &ZooKeeperStorageProcess::setAll, entries);
+}
+
+
 Future<bool> ZooKeeperStorage::expunge(const Entry& entry)
 {
   return dispatch(process, &ZooKeeperStorageProcess::expunge, entry);
@@ -21,6 +21,8 @@
 
 #include <mesos/attributes.hpp>
 
+#include <stout/foreach.hpp>
+
 using std::string;
 
 namespace mesos {
@@ -73,6 +75,37 @@ TEST(AttributesTest, Equality)
   EXPECT_NE(Attributes::parse(""), a);
 }
 
+
+TEST(AttributesTest, Lookup)
+{
+  Attributes a = Attributes::parse("rack:rack1;zone:1;zone:east");
+
+  Value::Text text;
+  text.set_value("none");
+
+  Value::Scalar scalar;
+  scalar.set_value(0);
+
+  EXPECT_EQ("rack1", a.get("rack", text).value());
+  EXPECT_EQ("east", a.get("zone", text).value());
+  EXPECT_EQ(1, a.get("zone", scalar).value());
+  EXPECT_EQ("none", a.get("host", text).value());
+
+  // Attributes added after a lookup are found as well.
+  a.add(Attributes::parse("host", "host1"));
+  EXPECT_EQ("host1", a.get("host", text).value());
+
+  // So are attributes modified through the iterators.
+  foreach (Attribute& attribute, a) {
+    if (attribute.name() == "rack") {
+      attribute.set_name("row");
+    }
+  }
+
+  EXPECT_EQ("none", a.get("rack", text).value());
+  EXPECT_EQ("rack1", a.get("row", text).value());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
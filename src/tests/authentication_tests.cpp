@@ -437,6 +437,67 @@ TEST_F(AuthenticationTest, DropIntermediateSASLMessage)
 }
 
 
+// This test verifies that the master defers authentications beyond
+// --max_concurrent_authentications, and that the deferred slave
+// authenticates once it retries.
+TEST_F(AuthenticationTest, MaxConcurrentAuthentications)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.max_concurrent_authentications = 1;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  // Drop the AuthenticationStepMessage from authenticator, so that
+  // the authentication of the framework stays in progress.
+  Future<AuthenticationStepMessage> authenticationStepMessage =
+    DROP_PROTOBUF(AuthenticationStepMessage(), _, _);
+
+  driver.start();
+
+  AWAIT_READY(authenticationStepMessage);
+
+  Future<AuthenticateMessage> authenticateMessage =
+    FUTURE_PROTOBUF(AuthenticateMessage(), _, master.get());
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(authenticateMessage);
+
+  Clock::pause();
+  Clock::settle();
+
+  JSON::Object metrics = Metrics();
+  EXPECT_EQ(1, metrics.values["master/authentications_deferred"]);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  // Advance the clock for the scheduler and the slave to retry.
+  Clock::advance(Seconds(5));
+  Clock::settle();
+  Clock::resume();
+
+  // Both should be able to get registered.
+  AWAIT_READY(registered);
+  AWAIT_READY(slaveRegisteredMessage);
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // This test verifies that the slave properly retries
 // authentication when an intermediate message in SASL protocol
 // is lost.
@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <list>
+
 #include <gtest/gtest.h>
 
 #include <mesos/authorizer/authorizer.hpp>
@@ -833,6 +835,119 @@ TYPED_TEST(AuthorizationTest, RemoveQuota)
   AWAIT_EXPECT_FALSE(authorizer.get()->authorize(request6));
 }
 
+
+// This tests that repeated requests (whose decisions are cached by
+// the `LocalAuthorizer`) are decided by both their principals and
+// their objects, separately for every action.
+TYPED_TEST(AuthorizationTest, RepeatedRequests)
+{
+  ACLs acls;
+  acls.set_permissive(false);
+
+  // "foo" principal can register frameworks with the "analytics" role.
+  mesos::ACL::RegisterFramework* acl1 = acls.add_register_frameworks();
+  acl1->mutable_principals()->add_values("foo");
+  acl1->mutable_roles()->add_values("analytics");
+
+  // "foo" principal can run tasks as the "guest" user.
+  mesos::ACL::RunTask* acl2 = acls.add_run_tasks();
+  acl2->mutable_principals()->add_values("foo");
+  acl2->mutable_users()->add_values("guest");
+
+  // Create an `Authorizer` with the ACLs.
+  Try<Authorizer*> create = TypeParam::create();
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  Try<Nothing> initialized = authorizer.get()->initialize(acls);
+  ASSERT_SOME(initialized);
+
+  mesos::ACL::RegisterFramework request1;
+  request1.mutable_principals()->add_values("foo");
+  request1.mutable_roles()->add_values("analytics");
+
+  mesos::ACL::RegisterFramework request2;
+  request2.mutable_principals()->add_values("foo");
+  request2.mutable_roles()->add_values("production");
+
+  // A quota request with the same principals and roles as 'request1',
+  // which no ACL allows.
+  mesos::ACL::SetQuota request3;
+  request3.mutable_principals()->add_values("foo");
+  request3.mutable_roles()->add_values("analytics");
+
+  mesos::ACL::RunTask request4;
+  request4.mutable_principals()->add_values("foo");
+  request4.mutable_users()->add_values("guest");
+
+  for (int i = 0; i < 3; i++) {
+    AWAIT_EXPECT_TRUE(authorizer.get()->authorize(request1));
+    AWAIT_EXPECT_FALSE(authorizer.get()->authorize(request2));
+    AWAIT_EXPECT_FALSE(authorizer.get()->authorize(request3));
+    AWAIT_EXPECT_TRUE(authorizer.get()->authorize(request4));
+  }
+}
+
+
+// This tests the authorization of a batch of requests, which are
+// decided in the order of the batch.
+TYPED_TEST(AuthorizationTest, Batch)
+{
+  ACLs acls;
+  acls.set_permissive(false);
+
+  // "foo" principal can run tasks as the "guest" user.
+  mesos::ACL::RunTask* acl1 = acls.add_run_tasks();
+  acl1->mutable_principals()->add_values("foo");
+  acl1->mutable_users()->add_values("guest");
+
+  // "foo" principal can reserve any resources.
+  mesos::ACL::ReserveResources* acl2 = acls.add_reserve_resources();
+  acl2->mutable_principals()->add_values("foo");
+  acl2->mutable_resources()->set_type(mesos::ACL::Entity::ANY);
+
+  // Create an `Authorizer` with the ACLs.
+  Try<Authorizer*> create = TypeParam::create();
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  Try<Nothing> initialized = authorizer.get()->initialize(acls);
+  ASSERT_SOME(initialized);
+
+  mesos::ACL::Batch batch;
+
+  // Principal "foo" can run as "guest".
+  mesos::ACL::RunTask* request1 = batch.add_requests()->mutable_run_task();
+  request1->mutable_principals()->add_values("foo");
+  request1->mutable_users()->add_values("guest");
+
+  // Principal "foo" cannot run as "root".
+  mesos::ACL::RunTask* request2 = batch.add_requests()->mutable_run_task();
+  request2->mutable_principals()->add_values("foo");
+  request2->mutable_users()->add_values("root");
+
+  // Principal "foo" can reserve resources.
+  mesos::ACL::ReserveResources* request3 =
+    batch.add_requests()->mutable_reserve_resources();
+  request3->mutable_principals()->add_values("foo");
+  request3->mutable_resources()->set_type(mesos::ACL::Entity::ANY);
+
+  // Principal "foo" cannot create volumes.
+  mesos::ACL::CreateVolume* request4 =
+    batch.add_requests()->mutable_create_volume();
+  request4->mutable_principals()->add_values("foo");
+  request4->mutable_volume_types()->set_type(mesos::ACL::Entity::ANY);
+
+  Future<std::list<bool>> authorized = authorizer.get()->authorize(batch);
+  AWAIT_READY(authorized);
+
+  EXPECT_EQ(std::list<bool>({true, false, true, false}), authorized.get());
+
+  // A request without any field set fails the whole batch.
+  batch.add_requests();
+  AWAIT_FAILED(authorizer.get()->authorize(batch));
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -131,7 +131,9 @@ Try<process::PID<master::Master>> Cluster::Masters::start(
           flags.log_auto_initialize));
     }
 
-    master.storage.reset(new state::LogStorage(master.log.get()));
+    master.storage.reset(new state::LogStorage(
+        master.log.get(),
+        flags.registry_diffs_between_snapshots));
   } else {
     return Error("'" + flags.registry + "' is not a supported option for"
                  " registry persistence");
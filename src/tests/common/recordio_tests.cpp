@@ -19,8 +19,12 @@
 
 #include <gtest/gtest.h>
 
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
 #include <process/gtest.hpp>
 
+#include <stout/gtest.hpp>
 #include <stout/recordio.hpp>
 #include <stout/result.hpp>
 #include <stout/strings.hpp>
@@ -159,3 +163,65 @@ TEST(RecordIOReaderTest, PipeFailure)
   // Subsequent reads should return a failure.
   AWAIT_EXPECT_FAILED(reader.read());
 }
+
+
+TEST(RecordIOReaderTest, ProtobufDecoder)
+{
+  ::recordio::Encoder<TaskID> encoder(
+      [](const TaskID& taskId) { return taskId.SerializeAsString(); });
+
+  TaskID taskId1;
+  taskId1.set_value("hello");
+
+  TaskID taskId2;
+  taskId2.set_value(string(1024, 'x'));
+
+  process::http::Pipe pipe;
+
+  internal::recordio::Reader<TaskID> reader(
+      internal::recordio::ProtobufDecoder<TaskID>(),
+      pipe.reader());
+
+  // A record contained within a single chunk.
+  pipe.writer().write(encoder.encode(taskId1));
+
+  Future<Result<TaskID>> read = reader.read();
+  AWAIT_READY(read);
+  ASSERT_SOME(read.get());
+  EXPECT_EQ(taskId1, read.get().get());
+
+  // A record split across many chunks, which shares its first
+  // chunk with the end of another record.
+  string data = encoder.encode(taskId1) + encoder.encode(taskId2);
+  for (size_t i = 0; i < data.size(); i += 100) {
+    pipe.writer().write(data.substr(i, 100));
+  }
+
+  read = reader.read();
+  AWAIT_READY(read);
+  ASSERT_SOME(read.get());
+  EXPECT_EQ(taskId1, read.get().get());
+
+  read = reader.read();
+  AWAIT_READY(read);
+  ASSERT_SOME(read.get());
+  EXPECT_EQ(taskId2, read.get().get());
+
+  // A record which is not a valid protobuf message yields an error
+  // but does not fail the reader.
+  pipe.writer().write("1\n\xff");
+  pipe.writer().write(encoder.encode(taskId1));
+
+  read = reader.read();
+  AWAIT_READY(read);
+  EXPECT_ERROR(read.get());
+
+  read = reader.read();
+  AWAIT_READY(read);
+  ASSERT_SOME(read.get());
+  EXPECT_EQ(taskId1, read.get().get());
+
+  pipe.writer().close();
+
+  AWAIT_EXPECT_EQ(Result<TaskID>::none(), reader.read());
+}
@@ -51,6 +51,8 @@
 #include "linux/cgroups.hpp"
 #include "linux/perf.hpp"
 
+#include "slave/containerizer/mesos/isolators/cgroups/pool.hpp"
+
 #include "tests/mesos.hpp" // For TEST_CGROUPS_(HIERARCHY|ROOT).
 #include "tests/utils.hpp"
 
@@ -61,6 +63,8 @@ using namespace process;
 using cgroups::memory::pressure::Level;
 using cgroups::memory::pressure::Counter;
 
+using mesos::internal::slave::CgroupsPool;
+
 using std::set;
 using std::string;
 
@@ -417,6 +421,48 @@ TEST_F(CgroupsAnyHierarchyTest, ROOT_CGROUPS_NestedCgroups)
 }
 
 
+// Tests that the cgroups of the containers are created from the
+// pre-created cgroups of the pool, which is refilled when they are
+// destroyed.
+TEST_F(CgroupsAnyHierarchyTest, ROOT_CGROUPS_Pool)
+{
+  string hierarchy = path::join(baseHierarchy, "cpu");
+  ASSERT_SOME(cgroups::create(hierarchy, TEST_CGROUPS_ROOT));
+
+  CgroupsPool pool(hierarchy, TEST_CGROUPS_ROOT, 2);
+  ASSERT_SOME(pool.recover());
+
+  Try<std::vector<string>> cgroups =
+    cgroups::get(hierarchy, TEST_CGROUPS_ROOT);
+  ASSERT_SOME(cgroups);
+  ASSERT_EQ(2u, cgroups->size());
+
+  foreach (const string& cgroup, cgroups.get()) {
+    EXPECT_TRUE(CgroupsPool::pooled(cgroup));
+  }
+
+  string cgroup = path::join(TEST_CGROUPS_ROOT, "container");
+  ASSERT_SOME(pool.create(cgroup));
+
+  // A pre-created cgroup was renamed.
+  cgroups = cgroups::get(hierarchy, TEST_CGROUPS_ROOT);
+  ASSERT_SOME(cgroups);
+  ASSERT_EQ(2u, cgroups->size());
+  EXPECT_NE(cgroups->end(),
+            find(cgroups->begin(), cgroups->end(), cgroup));
+  EXPECT_FALSE(CgroupsPool::pooled(cgroup));
+
+  AWAIT_READY(pool.destroy(cgroup, Seconds(10)));
+
+  // The cgroup can be created again right away.
+  EXPECT_SOME_FALSE(cgroups::exists(hierarchy, cgroup));
+
+  cgroups = cgroups::get(hierarchy, TEST_CGROUPS_ROOT);
+  ASSERT_SOME(cgroups);
+  EXPECT_LE(2u, cgroups->size());
+}
+
+
 TEST_F(CgroupsAnyHierarchyTest, ROOT_CGROUPS_Tasks)
 {
   pid_t pid = ::getpid();
@@ -542,6 +588,48 @@ TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_Stat)
 }
 
 
+TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_Reader)
+{
+  cgroups::Reader invalid(baseHierarchy, TEST_CGROUPS_ROOT, "invalid");
+  EXPECT_ERROR(invalid.value());
+
+  cgroups::Reader cpuacct(
+      path::join(baseHierarchy, "cpuacct"), "/", "cpuacct.stat");
+
+  Option<uint64_t> user;
+  Option<uint64_t> system;
+  Option<uint64_t> unknown;
+
+  ASSERT_SOME(cpuacct.stat(
+      {{"user", &user}, {"system", &system}, {"unknown", &unknown}}));
+
+  ASSERT_SOME(user);
+  ASSERT_SOME(system);
+  EXPECT_NONE(unknown);
+
+  // Reading again starts over from the beginning of the control.
+  Option<uint64_t> user2;
+  ASSERT_SOME(cpuacct.stat({{"user", &user2}}));
+  ASSERT_SOME(user2);
+  EXPECT_GE(user2.get(), user.get());
+
+  cgroups::Reader memory(
+      path::join(baseHierarchy, "memory"), "/", "memory.stat");
+
+  Option<uint64_t> rss;
+  ASSERT_SOME(memory.stat({{"rss", &rss}}));
+  ASSERT_SOME(rss);
+  EXPECT_GT(rss.get(), 0llu);
+
+  cgroups::Reader usage(
+      path::join(baseHierarchy, "memory"), "/", "memory.usage_in_bytes");
+
+  Try<uint64_t> value = usage.value();
+  ASSERT_SOME(value);
+  EXPECT_GT(value.get(), 0llu);
+}
+
+
 TEST_F(CgroupsAnyHierarchyWithCpuMemoryTest, ROOT_CGROUPS_Listen)
 {
   string hierarchy = path::join(baseHierarchy, "memory");
@@ -39,6 +39,7 @@ using namespace process;
 using std::vector;
 
 using testing::_;
+using testing::DoDefault;
 using testing::Return;
 
 namespace mesos {
@@ -51,6 +52,18 @@ class ComposingContainerizerTest : public MesosTest {};
 class MockContainerizer : public slave::Containerizer
 {
 public:
+  MockContainerizer()
+  {
+    ON_CALL(*this, supports(_))
+      .WillByDefault(Return(true));
+    EXPECT_CALL(*this, supports(_))
+      .WillRepeatedly(DoDefault());
+  }
+
+  MOCK_CONST_METHOD1(
+      supports,
+      bool(const Option<ContainerInfo::Type>&));
+
   MOCK_METHOD1(
       recover,
       process::Future<Nothing>(
@@ -165,6 +178,51 @@ TEST_F(ComposingContainerizerTest, DestroyWhileLaunching)
   AWAIT_FAILED(launch);
 }
 
+
+// This test checks that a launch goes directly to the containerizer
+// which supports the type of the container, skipping the others.
+TEST_F(ComposingContainerizerTest, LaunchBySupportedType)
+{
+  vector<Containerizer*> containerizers;
+
+  MockContainerizer* mockContainerizer = new MockContainerizer();
+  MockContainerizer* mockContainerizer2 = new MockContainerizer();
+
+  containerizers.push_back(mockContainerizer);
+  containerizers.push_back(mockContainerizer2);
+
+  ComposingContainerizer containerizer(containerizers);
+  ContainerID containerId;
+  containerId.set_value("container");
+  TaskInfo taskInfo;
+  taskInfo.mutable_container()->set_type(ContainerInfo::DOCKER);
+  ExecutorInfo executorInfo;
+  SlaveID slaveId;
+  PID<Slave> slavePid;
+
+  EXPECT_CALL(*mockContainerizer, supports(Option<ContainerInfo::Type>(
+      ContainerInfo::DOCKER)))
+    .WillRepeatedly(Return(false));
+
+  EXPECT_CALL(*mockContainerizer, launch(_, _, _, _, _, _, _, _))
+    .Times(0);
+
+  EXPECT_CALL(*mockContainerizer2, launch(_, _, _, _, _, _, _, _))
+    .WillOnce(Return(true));
+
+  Future<bool> launch = containerizer.launch(
+      containerId,
+      taskInfo,
+      executorInfo,
+      "dir",
+      "user",
+      slaveId,
+      slavePid,
+      false);
+
+  AWAIT_EXPECT_TRUE(launch);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -0,0 +1,212 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+
+#include "slave/flags.hpp"
+#include "slave/slave.hpp"
+
+#include "slave/containerizer/fetcher.hpp"
+
+#include "slave/containerizer/mesos/containerizer.hpp"
+
+#include "tests/mesos.hpp"
+
+using namespace process;
+
+using mesos::internal::slave::Fetcher;
+using mesos::internal::slave::MesosContainerizer;
+using mesos::internal::slave::Slave;
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+// Measures how long the MesosContainerizer takes to launch and to
+// destroy containers with a given set of isolators, which covers the
+// 'prepare()', 'isolate()' and 'cleanup()' of the isolators.
+class Containerizer_BENCHMARK_Test
+  : public ContainerizerTest<MesosContainerizer>
+{
+protected:
+  // Launches 'count' containers one after the other, then destroys
+  // them one after the other, and prints the latency percentiles of
+  // both.
+  void benchmark(const slave::Flags& flags, size_t count)
+  {
+    cout << "Launching and destroying " << count << " containers with '"
+         << flags.isolation << "'" << endl;
+
+    Fetcher fetcher;
+
+    Try<MesosContainerizer*> create =
+      MesosContainerizer::create(flags, false, &fetcher);
+
+    ASSERT_SOME(create);
+
+    Owned<MesosContainerizer> containerizer(create.get());
+
+    ExecutorInfo executorInfo = CREATE_EXECUTOR_INFO("executor", "sleep 1000");
+    executorInfo.mutable_resources()->CopyFrom(
+        Resources::parse("cpus:0.1;mem:32").get());
+
+    vector<ContainerID> containerIds;
+    vector<Duration> launches;
+
+    Stopwatch total;
+    total.start();
+
+    for (size_t i = 0; i < count; i++) {
+      ContainerID containerId;
+      containerId.set_value("container-" + stringify(i));
+
+      const string directory = path::join(os::getcwd(), containerId.value());
+      ASSERT_SOME(os::mkdir(directory));
+
+      Stopwatch watch;
+      watch.start();
+
+      Future<bool> launch = containerizer->launch(
+          containerId,
+          executorInfo,
+          directory,
+          None(),
+          SlaveID(),
+          PID<Slave>(),
+          false);
+
+      AWAIT_READY_FOR(launch, Seconds(60));
+      ASSERT_TRUE(launch.get());
+
+      launches.push_back(watch.elapsed());
+      containerIds.push_back(containerId);
+    }
+
+    print("Launch", launches, total.elapsed());
+
+    vector<Duration> destroys;
+
+    total.start();
+
+    foreach (const ContainerID& containerId, containerIds) {
+      Stopwatch watch;
+      watch.start();
+
+      Future<containerizer::Termination> wait =
+        containerizer->wait(containerId);
+
+      containerizer->destroy(containerId);
+
+      AWAIT_READY_FOR(wait, Seconds(60));
+
+      destroys.push_back(watch.elapsed());
+    }
+
+    print("Destroy", destroys, total.elapsed());
+  }
+
+  static void print(
+      const string& operation,
+      vector<Duration> latencies,
+      const Duration& elapsed)
+  {
+    if (latencies.empty()) {
+      return;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    cout << operation << " latency: "
+         << "median " << latencies[latencies.size() / 2]
+         << ", 90th percentile " << latencies[latencies.size() * 90 / 100]
+         << ", 99th percentile " << latencies[latencies.size() * 99 / 100]
+         << ", max " << latencies.back()
+         << " (" << latencies.size() / elapsed.secs()
+         << " containers per second)" << endl;
+  }
+};
+
+
+TEST_F(Containerizer_BENCHMARK_Test, PosixIsolators)
+{
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "posix/cpu,posix/mem";
+
+  benchmark(flags, 100);
+}
+
+
+#ifdef __linux__
+TEST_F(Containerizer_BENCHMARK_Test, ROOT_CGROUPS_CgroupsIsolators)
+{
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "cgroups/cpu,cgroups/mem";
+
+  benchmark(flags, 100);
+}
+
+
+TEST_F(Containerizer_BENCHMARK_Test, ROOT_CGROUPS_LinuxFilesystemIsolator)
+{
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "cgroups/cpu,cgroups/mem,filesystem/linux";
+
+  benchmark(flags, 100);
+}
+#endif // __linux__
+
+
+#ifdef WITH_NETWORK_ISOLATOR
+TEST_F(Containerizer_BENCHMARK_Test, ROOT_CGROUPS_PortMappingIsolator)
+{
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "cgroups/cpu,cgroups/mem,network/port_mapping";
+  flags.resources =
+    "cpus:16;mem:8192;disk:16384;"
+    "ports:[31000-32000];ephemeral_ports:[30001-30999]";
+  flags.ephemeral_ports_per_container = 8;
+
+  benchmark(flags, 100);
+}
+#endif // WITH_NETWORK_ISOLATOR
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
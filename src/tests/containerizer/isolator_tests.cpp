@@ -39,7 +39,9 @@
 #include <stout/path.hpp>
 
 #ifdef __linux__
+#include "linux/hugepages.hpp"
 #include "linux/ns.hpp"
+#include "linux/numa.hpp"
 #endif // __linux__
 
 #include "master/master.hpp"
@@ -52,6 +54,8 @@
 #ifdef __linux__
 #include "slave/containerizer/mesos/isolators/cgroups/constants.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/cpushare.hpp"
+#include "slave/containerizer/mesos/isolators/cgroups/cpuset.hpp"
+#include "slave/containerizer/mesos/isolators/cgroups/hugetlb.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/mem.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/net_cls.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/perf_event.hpp"
@@ -79,12 +83,17 @@ using namespace process;
 using mesos::internal::master::Master;
 #ifdef __linux__
 using mesos::internal::slave::CgroupsCpushareIsolatorProcess;
+using mesos::internal::slave::CgroupsCpusetIsolatorProcess;
+using mesos::internal::slave::CgroupsHugetlbIsolatorProcess;
 using mesos::internal::slave::CgroupsMemIsolatorProcess;
 using mesos::internal::slave::CgroupsNetClsIsolatorProcess;
 using mesos::internal::slave::CgroupsPerfEventIsolatorProcess;
+using mesos::internal::slave::CPU_CFS_PERIOD_LABEL;
 using mesos::internal::slave::CPU_SHARES_PER_CPU_REVOCABLE;
 using mesos::internal::slave::Fetcher;
 using mesos::internal::slave::LinuxLauncher;
+using mesos::internal::slave::NetClsHandle;
+using mesos::internal::slave::NetClsHandleManager;
 using mesos::internal::slave::SharedFilesystemIsolatorProcess;
 #endif // __linux__
 using mesos::internal::slave::Launcher;
@@ -652,6 +661,88 @@ TEST_F(LimitedCpuIsolatorTest, ROOT_CGROUPS_CFS_Big_Quota)
 }
 
 
+// This test verifies that the CFS period of a container follows its
+// latency class and can be selected by the label of its task.
+TEST_F(LimitedCpuIsolatorTest, ROOT_CGROUPS_CFS_Period)
+{
+  slave::Flags flags;
+  flags.cgroups_enable_cfs = true;
+  flags.cgroups_cfs_period = Milliseconds(50);
+  flags.cgroups_revocable_cfs_period = Milliseconds(200);
+
+  Try<Isolator*> isolator = CgroupsCpushareIsolatorProcess::create(flags);
+  CHECK_SOME(isolator);
+
+  Result<string> hierarchy = cgroups::hierarchy("cpu");
+  ASSERT_SOME(hierarchy);
+
+  Resource revocable = Resources::parse("cpus", "1", "*").get();
+  revocable.mutable_revocable();
+
+  ContainerID containerId1;
+  containerId1.set_value(UUID::random().toString());
+
+  ContainerID containerId2;
+  containerId2.set_value(UUID::random().toString());
+
+  ContainerID containerId3;
+  containerId3.set_value(UUID::random().toString());
+
+  // A regular container.
+  ContainerConfig containerConfig;
+  containerConfig.mutable_executorinfo()->mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1").get());
+  containerConfig.set_directory(os::getcwd());
+
+  AWAIT_READY(isolator.get()->prepare(containerId1, containerConfig));
+
+  // A regular container whose task selects its period.
+  Label* label = containerConfig.mutable_taskinfo()->mutable_labels()
+    ->add_labels();
+  label->set_key(CPU_CFS_PERIOD_LABEL);
+  label->set_value("10ms");
+
+  AWAIT_READY(isolator.get()->prepare(containerId2, containerConfig));
+
+  // A revocable container.
+  containerConfig.clear_taskinfo();
+  containerConfig.mutable_executorinfo()->clear_resources();
+  containerConfig.mutable_executorinfo()->add_resources()->CopyFrom(revocable);
+
+  AWAIT_READY(isolator.get()->prepare(containerId3, containerConfig));
+
+  const string cgroup1 = path::join(flags.cgroups_root, containerId1.value());
+  const string cgroup2 = path::join(flags.cgroups_root, containerId2.value());
+  const string cgroup3 = path::join(flags.cgroups_root, containerId3.value());
+
+  EXPECT_SOME_EQ(
+      Milliseconds(50),
+      cgroups::cpu::cfs_period_us(hierarchy.get(), cgroup1));
+
+  EXPECT_SOME_EQ(
+      Milliseconds(50),
+      cgroups::cpu::cfs_quota_us(hierarchy.get(), cgroup1));
+
+  EXPECT_SOME_EQ(
+      Milliseconds(10),
+      cgroups::cpu::cfs_period_us(hierarchy.get(), cgroup2));
+
+  EXPECT_SOME_EQ(
+      Milliseconds(10),
+      cgroups::cpu::cfs_quota_us(hierarchy.get(), cgroup2));
+
+  EXPECT_SOME_EQ(
+      Milliseconds(200),
+      cgroups::cpu::cfs_period_us(hierarchy.get(), cgroup3));
+
+  AWAIT_READY(isolator.get()->cleanup(containerId1));
+  AWAIT_READY(isolator.get()->cleanup(containerId2));
+  AWAIT_READY(isolator.get()->cleanup(containerId3));
+
+  delete isolator.get();
+}
+
+
 // A test to verify the number of processes and threads in a
 // container.
 TEST_F(LimitedCpuIsolatorTest, ROOT_CGROUPS_Pids_and_Tids)
@@ -770,6 +861,65 @@ TEST_F(LimitedCpuIsolatorTest, ROOT_CGROUPS_Pids_and_Tids)
 #endif // __linux__
 
 
+#ifdef __linux__
+class LinuxLauncherTest : public MesosTest {};
+
+
+// Tests that a child forked without a setup function (which is done
+// with CLONE_VFORK) has joined the freezer cgroup of its container by
+// the time 'fork' returns.
+TEST_F(LinuxLauncherTest, ROOT_CGROUPS_ForkWithoutSetup)
+{
+  slave::Flags flags;
+
+  Try<Launcher*> launcher = LinuxLauncher::create(flags);
+  ASSERT_SOME(launcher);
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  vector<string> argv(3);
+  argv[0] = "sh";
+  argv[1] = "-c";
+  argv[2] = "sleep 1000";
+
+  Try<pid_t> pid = launcher.get()->fork(
+      containerId,
+      "sh",
+      argv,
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO),
+      None(),
+      None(),
+      None(),
+      None());
+
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  Result<string> hierarchy = cgroups::hierarchy("freezer");
+  ASSERT_SOME(hierarchy);
+
+  Try<set<pid_t>> pids = cgroups::processes(
+      hierarchy.get(),
+      path::join(flags.cgroups_root, containerId.value()));
+
+  ASSERT_SOME(pids);
+  EXPECT_EQ(1u, pids.get().count(pid.get()));
+
+  // The child is in a new session, like with a setup function.
+  EXPECT_EQ(pid.get(), ::getsid(pid.get()));
+
+  AWAIT_READY(launcher.get()->destroy(containerId));
+  AWAIT_READY(status);
+
+  delete launcher.get();
+}
+#endif // __linux__
+
+
 template <typename T>
 class MemIsolatorTest : public MesosTest {};
 
@@ -844,6 +994,53 @@ TYPED_TEST(MemIsolatorTest, MemUsage)
 
 
 #ifdef __linux__
+class NetClsHandleManagerTest : public ::testing::Test {};
+
+
+// Checks that the handles are allocated from the lowest free one,
+// that freed handles are reused and that reserved (i.e., recovered)
+// handles are not allocated again.
+TEST_F(NetClsHandleManagerTest, AllocFreeReserve)
+{
+  NetClsHandleManager manager(0x0012, 0x0001, 0x0082);
+
+  EXPECT_EQ(0x82u, manager.total());
+  EXPECT_EQ(0u, manager.used());
+
+  ASSERT_SOME(manager.reserve(NetClsHandle(0x0012, 0x0002)));
+  EXPECT_ERROR(manager.reserve(NetClsHandle(0x0012, 0x0002)));
+
+  // Handles outside of the range can not be reserved.
+  EXPECT_ERROR(manager.reserve(NetClsHandle(0x0013, 0x0003)));
+  EXPECT_ERROR(manager.reserve(NetClsHandle(0x0012, 0x0083)));
+
+  Try<NetClsHandle> handle = manager.alloc();
+  ASSERT_SOME(handle);
+  EXPECT_EQ(0x00120001u, handle.get().get());
+
+  handle = manager.alloc();
+  ASSERT_SOME(handle);
+  EXPECT_EQ(0x00120003u, handle.get().get());
+
+  // Allocate the rest of the handles (spanning several words).
+  for (size_t i = manager.used(); i < manager.total(); i++) {
+    ASSERT_SOME(manager.alloc());
+  }
+
+  EXPECT_EQ(manager.total(), manager.used());
+  EXPECT_ERROR(manager.alloc());
+
+  ASSERT_SOME(manager.free(NetClsHandle(0x0012, 0x0042)));
+  EXPECT_FALSE(manager.isUsed(NetClsHandle(0x0012, 0x0042)));
+  EXPECT_ERROR(manager.free(NetClsHandle(0x0012, 0x0042)));
+
+  handle = manager.alloc();
+  ASSERT_SOME(handle);
+  EXPECT_EQ(0x00120042u, handle.get().get());
+  EXPECT_TRUE(manager.isUsed(handle.get()));
+}
+
+
 class NetClsIsolatorTest : public MesosTest {};
 
 
@@ -958,6 +1155,153 @@ TEST_F(NetClsIsolatorTest, ROOT_CGROUPS_NetClsIsolate)
 
 
 #ifdef __linux__
+class CpusetIsolatorTest : public MesosTest {};
+
+
+// This tests that a container is pinned to the CPUs and memory of a
+// single NUMA node when it fits in one, and to all of the nodes when
+// it is updated to more CPUs than any node has.
+TEST_F(CpusetIsolatorTest, ROOT_CGROUPS_Pin)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  Try<Isolator*> isolator = CgroupsCpusetIsolatorProcess::create(flags);
+  ASSERT_SOME(isolator);
+
+  Try<vector<numa::Node>> nodes = numa::nodes();
+  ASSERT_SOME(nodes);
+
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1;mem:64").get());
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  // Use a relative temporary directory so it gets cleaned up
+  // automatically with the test.
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  ContainerConfig containerConfig;
+  containerConfig.mutable_executorinfo()->CopyFrom(executorInfo);
+  containerConfig.set_directory(dir.get());
+
+  AWAIT_READY(isolator.get()->prepare(
+      containerId,
+      containerConfig));
+
+  const string hierarchy = path::join(flags.cgroups_hierarchy, "cpuset");
+  const string cgroup = path::join(flags.cgroups_root, containerId.value());
+
+  Try<string> mems = cgroups::cpuset::mems(hierarchy, cgroup);
+  ASSERT_SOME(mems);
+
+  Try<set<unsigned int>> ids = numa::parse(mems.get());
+  ASSERT_SOME(ids);
+  ASSERT_EQ(1u, ids.get().size());
+
+  Try<string> cpus = cgroups::cpuset::cpus(hierarchy, cgroup);
+  ASSERT_SOME(cpus);
+
+  foreach (const numa::Node& node, nodes.get()) {
+    if (node.id == *ids.get().begin()) {
+      EXPECT_EQ(numa::format(node.cpus), cpus.get());
+    }
+  }
+
+  // Ask for more CPUs than the host has.
+  size_t total = 0;
+  foreach (const numa::Node& node, nodes.get()) {
+    total += node.cpus.size();
+  }
+
+  AWAIT_READY(isolator.get()->update(
+      containerId,
+      Resources::parse("cpus:" + stringify(total + 1) + ";mem:64").get()));
+
+  mems = cgroups::cpuset::mems(hierarchy, cgroup);
+  ASSERT_SOME(mems);
+
+  ids = numa::parse(mems.get());
+  ASSERT_SOME(ids);
+  EXPECT_EQ(nodes.get().size(), ids.get().size());
+
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  delete isolator.get();
+}
+
+
+class HugetlbIsolatorTest : public MesosTest {};
+
+
+// This tests that the hugepages of a container are limited to its
+// hugepages resources, and that the limits are reported in the
+// usage of the container.
+TEST_F(HugetlbIsolatorTest, ROOT_CGROUPS_Limit)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  Try<Isolator*> isolator = CgroupsHugetlbIsolatorProcess::create(flags);
+  ASSERT_SOME(isolator);
+
+  Try<vector<hugepages::Pool>> pools = hugepages::pools();
+  ASSERT_SOME(pools);
+  ASSERT_FALSE(pools.get().empty());
+
+  const Bytes size = pools.get().front().size;
+
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1;mem:64;hugepages_" + stringify(size) + ":2")
+        .get());
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  // Use a relative temporary directory so it gets cleaned up
+  // automatically with the test.
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  ContainerConfig containerConfig;
+  containerConfig.mutable_executorinfo()->CopyFrom(executorInfo);
+  containerConfig.set_directory(dir.get());
+
+  AWAIT_READY(isolator.get()->prepare(
+      containerId,
+      containerConfig));
+
+  Future<ResourceStatistics> usage = isolator.get()->usage(containerId);
+  AWAIT_READY(usage);
+
+  ASSERT_EQ(pools.get().size(),
+            (size_t) usage.get().mem_hugepage_statistics_size());
+
+  const HugepageStatistics& statistics =
+    usage.get().mem_hugepage_statistics(0);
+
+  EXPECT_EQ(size.bytes(), statistics.page_size_bytes());
+  EXPECT_EQ((size * 2).bytes(), statistics.limit_bytes());
+  EXPECT_EQ(0u, statistics.usage_bytes());
+
+  // Without hugepages resources no hugepages can be allocated.
+  AWAIT_READY(isolator.get()->update(
+      containerId,
+      Resources::parse("cpus:1;mem:64").get()));
+
+  usage = isolator.get()->usage(containerId);
+  AWAIT_READY(usage);
+
+  EXPECT_EQ(0u, usage.get().mem_hugepage_statistics(0).limit_bytes());
+
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  delete isolator.get();
+}
+
+
 class PerfEventIsolatorTest : public MesosTest {};
 
 
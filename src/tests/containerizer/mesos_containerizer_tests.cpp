@@ -804,6 +804,210 @@ TEST_F(MesosContainerizerDestroyTest, LauncherDestroyFailure)
 }
 
 
+// This test verifies that no more containers than allowed by
+// '--max_concurrent_container_destroys' are destroyed at a time, and
+// that the other destroys continue once they are done.
+TEST_F(MesosContainerizerDestroyTest, MaxConcurrentDestroys)
+{
+  slave::Flags flags = CreateSlaveFlags();
+  flags.max_concurrent_container_destroys = 1;
+
+  Try<Launcher*> launcher_ = PosixLauncher::create(flags);
+  ASSERT_SOME(launcher_);
+
+  TestLauncher* launcher = new TestLauncher(Owned<Launcher>(launcher_.get()));
+
+  Fetcher fetcher;
+
+  Try<ContainerLogger*> logger =
+    ContainerLogger::create(flags.container_logger);
+
+  ASSERT_SOME(logger);
+
+  Try<Owned<Provisioner>> provisioner = Provisioner::create(flags);
+  ASSERT_SOME(provisioner);
+
+  MesosContainerizerProcess* process = new MesosContainerizerProcess(
+      flags,
+      true,
+      &fetcher,
+      Owned<ContainerLogger>(logger.get()),
+      Owned<Launcher>(launcher),
+      provisioner.get(),
+      vector<Owned<Isolator>>());
+
+  MesosContainerizer containerizer((Owned<MesosContainerizerProcess>(process)));
+
+  ContainerID containerId1;
+  containerId1.set_value("test_container1");
+
+  ContainerID containerId2;
+  containerId2.set_value("test_container2");
+
+  TaskInfo taskInfo;
+  CommandInfo commandInfo;
+  taskInfo.mutable_command()->MergeFrom(commandInfo);
+
+  // Hold the destroy of the first container.
+  Promise<Nothing> promise;
+  Future<Nothing> destroy1;
+  EXPECT_CALL(*launcher, destroy(containerId1))
+    .WillOnce(DoAll(InvokeDestroyAndWait(launcher),
+                    FutureSatisfy(&destroy1),
+                    Return(promise.future())));
+
+  Future<Nothing> destroy2;
+  EXPECT_CALL(*launcher, destroy(containerId2))
+    .WillOnce(DoAll(InvokeDestroyAndWait(launcher),
+                    FutureSatisfy(&destroy2),
+                    Return(Nothing())));
+
+  vector<ContainerID> containerIds = {containerId1, containerId2};
+
+  foreach (const ContainerID& containerId, containerIds) {
+    Future<bool> launch = containerizer.launch(
+        containerId,
+        taskInfo,
+        CREATE_EXECUTOR_INFO("executor", "sleep 1000"),
+        os::getcwd(),
+        None(),
+        SlaveID(),
+        PID<Slave>(),
+        false);
+
+    AWAIT_READY(launch);
+  }
+
+  Future<containerizer::Termination> wait1 = containerizer.wait(containerId1);
+  Future<containerizer::Termination> wait2 = containerizer.wait(containerId2);
+
+  containerizer.destroy(containerId1);
+  containerizer.destroy(containerId2);
+
+  AWAIT_READY(destroy1);
+
+  // The second container waits for the first one to be destroyed.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  EXPECT_TRUE(destroy2.isPending());
+
+  promise.set(Nothing());
+
+  AWAIT_READY(destroy2);
+
+  AWAIT_READY(wait1);
+  AWAIT_READY(wait2);
+}
+
+
+class MesosContainerizerPrepareTest : public MesosTest {};
+
+
+// This test verifies that the first (filesystem) isolator is prepared
+// before the other isolators, which are prepared concurrently.
+TEST_F(MesosContainerizerPrepareTest, PrepareIsolatorsConcurrently)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  Try<Launcher*> launcher = PosixLauncher::create(flags);
+  ASSERT_SOME(launcher);
+
+  MockIsolator* filesystem = new MockIsolator();
+  MockIsolator* isolator1 = new MockIsolator();
+  MockIsolator* isolator2 = new MockIsolator();
+
+  Future<Nothing> prepare;
+  Promise<Option<ContainerLaunchInfo>> promise;
+
+  EXPECT_CALL(*filesystem, prepare(_, _))
+    .WillOnce(DoAll(FutureSatisfy(&prepare),
+                    Return(promise.future())));
+
+  Future<Nothing> prepare1;
+  Promise<Option<ContainerLaunchInfo>> promise1;
+
+  EXPECT_CALL(*isolator1, prepare(_, _))
+    .WillOnce(DoAll(FutureSatisfy(&prepare1),
+                    Return(promise1.future())));
+
+  Future<Nothing> prepare2;
+  Promise<Option<ContainerLaunchInfo>> promise2;
+
+  EXPECT_CALL(*isolator2, prepare(_, _))
+    .WillOnce(DoAll(FutureSatisfy(&prepare2),
+                    Return(promise2.future())));
+
+  Fetcher fetcher;
+
+  Try<ContainerLogger*> logger =
+    ContainerLogger::create(flags.container_logger);
+
+  ASSERT_SOME(logger);
+
+  Try<Owned<Provisioner>> provisioner = Provisioner::create(flags);
+  ASSERT_SOME(provisioner);
+
+  MesosContainerizerProcess* process = new MesosContainerizerProcess(
+      flags,
+      true,
+      &fetcher,
+      Owned<ContainerLogger>(logger.get()),
+      Owned<Launcher>(launcher.get()),
+      provisioner.get(),
+      {Owned<Isolator>(filesystem),
+       Owned<Isolator>(isolator1),
+       Owned<Isolator>(isolator2)});
+
+  MesosContainerizer containerizer((Owned<MesosContainerizerProcess>(process)));
+
+  ContainerID containerId;
+  containerId.set_value("test_container");
+
+  TaskInfo taskInfo;
+  CommandInfo commandInfo;
+  taskInfo.mutable_command()->MergeFrom(commandInfo);
+
+  Future<bool> launch = containerizer.launch(
+      containerId,
+      taskInfo,
+      CREATE_EXECUTOR_INFO("executor", "exit 0"),
+      os::getcwd(),
+      None(),
+      SlaveID(),
+      PID<Slave>(),
+      false);
+
+  AWAIT_READY(prepare);
+
+  // The other isolators wait for the filesystem isolator.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  EXPECT_TRUE(prepare1.isPending());
+  EXPECT_TRUE(prepare2.isPending());
+
+  // Need to help the compiler to disambiguate between overloads.
+  Option<ContainerLaunchInfo> none = None();
+  promise.set(none);
+
+  // Both isolators are preparing at the same time.
+  AWAIT_READY(prepare1);
+  AWAIT_READY(prepare2);
+
+  promise2.set(none);
+  promise1.set(none);
+
+  AWAIT_READY(launch);
+
+  Future<containerizer::Termination> wait = containerizer.wait(containerId);
+
+  AWAIT_READY(wait);
+}
+
+
 class MesosContainerizerRecoverTest : public MesosTest {};
 
 
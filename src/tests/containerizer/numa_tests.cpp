@@ -0,0 +1,80 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <set>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+
+#include "linux/numa.hpp"
+
+using std::set;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+class NumaTest : public ::testing::Test {};
+
+
+TEST_F(NumaTest, Nodes)
+{
+  Try<vector<numa::Node>> nodes = numa::nodes();
+  ASSERT_SOME(nodes);
+  ASSERT_FALSE(nodes.get().empty());
+
+  // The nodes are ordered and do not share CPUs.
+  set<unsigned int> cpus;
+  for (size_t i = 0; i < nodes.get().size(); i++) {
+    if (i > 0) {
+      EXPECT_LT(nodes.get()[i - 1].id, nodes.get()[i].id);
+    }
+
+    foreach (unsigned int cpu, nodes.get()[i].cpus) {
+      EXPECT_TRUE(cpus.insert(cpu).second);
+    }
+  }
+}
+
+
+TEST_F(NumaTest, Parse)
+{
+  EXPECT_SOME_EQ(set<unsigned int>(), numa::parse(""));
+  EXPECT_SOME_EQ(set<unsigned int>({0}), numa::parse("0\n"));
+  EXPECT_SOME_EQ(
+      set<unsigned int>({0, 1, 2, 3, 8, 10, 11}),
+      numa::parse("0-3,8,10-11"));
+
+  EXPECT_ERROR(numa::parse("3-1"));
+  EXPECT_ERROR(numa::parse("0-1-2"));
+  EXPECT_ERROR(numa::parse("a"));
+}
+
+
+TEST_F(NumaTest, Format)
+{
+  EXPECT_EQ("", numa::format(set<unsigned int>()));
+  EXPECT_EQ("4", numa::format({4}));
+  EXPECT_EQ("0-3,8,10-11", numa::format({0, 1, 2, 3, 8, 10, 11}));
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
@@ -62,6 +62,15 @@ TEST_F(PerfTest, ROOT_Sample)
 }
 
 
+TEST_F(PerfTest, UnsupportedCounters)
+{
+  // Only the events of the PerfStatistics protobuf can be counted.
+  EXPECT_ERROR(perf::Counters::create({"cycles", "invalid-event"}, "/"));
+  EXPECT_ERROR(perf::Counters::create({"l1-dcache-invalid"}, "/"));
+  EXPECT_ERROR(perf::Counters::create({}, "/"));
+}
+
+
 TEST_F(PerfTest, Parse)
 {
   // Parse multiple cgroups with uint64 and floats.
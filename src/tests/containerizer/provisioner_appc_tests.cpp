@@ -16,9 +16,13 @@
 
 #include <string>
 
+#include <gmock/gmock.h>
+
 #include <mesos/slave/isolator.hpp>
 
 #include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/process.hpp>
 
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
@@ -45,6 +49,9 @@ using namespace process;
 
 using namespace mesos::internal::slave::appc;
 
+using testing::_;
+using testing::Return;
+
 using mesos::internal::slave::Fetcher;
 using mesos::internal::slave::Provisioner;
 
@@ -197,6 +204,136 @@ TEST_F(AppcStoreTest, Recover)
 }
 
 
+// This test verifies that the store recovers the images in its index
+// without reading their manifests again.
+TEST_F(AppcStoreTest, RecoverFromIndex)
+{
+  slave::Flags flags;
+  flags.appc_store_dir = path::join(os::getcwd(), "store");
+  Try<Owned<slave::Store>> store = Store::create(flags);
+  ASSERT_SOME(store);
+
+  JSON::Value manifest = JSON::parse(
+      "{"
+      "  \"acKind\": \"ImageManifest\","
+      "  \"acVersion\": \"0.6.1\","
+      "  \"name\": \"foo.com/bar\""
+      "}").get();
+
+  string imageId =
+    "sha512-e77d96aa0240eedf134b8c90baeaf76dca8e78691836301d7498c84020446042e"
+    "797b296d6ab296e0954c2626bfb264322ebeb8f447dac4fac6511ea06bc61f0";
+
+  string imagePath = path::join(flags.appc_store_dir, "images", imageId);
+
+  ASSERT_SOME(os::mkdir(path::join(imagePath, "rootfs", "tmp")));
+  ASSERT_SOME(
+      os::write(path::join(imagePath, "manifest"), stringify(manifest)));
+
+  // Recovering the image adds it to the index.
+  AWAIT_READY(store.get()->recover());
+  EXPECT_TRUE(os::exists(path::join(flags.appc_store_dir, "index")));
+
+  // Make the manifest unreadable for the store, which is fine as long
+  // as the image is recovered from the index.
+  ASSERT_SOME(os::write(path::join(imagePath, "manifest"), "{}"));
+
+  store = Store::create(flags);
+  ASSERT_SOME(store);
+
+  AWAIT_READY(store.get()->recover());
+
+  Image image;
+  image.mutable_appc()->set_name("foo.com/bar");
+  AWAIT_READY(store.get()->get(image));
+}
+
+
+class TestAppcImageServer : public Process<TestAppcImageServer>
+{
+public:
+  TestAppcImageServer() : ProcessBase("TestAppcImageServer")
+  {
+    route("/bar-1.0.0-linux-amd64.aci", None(), &TestAppcImageServer::image);
+  }
+
+  MOCK_METHOD1(image, Future<http::Response>(const http::Request&));
+};
+
+
+// This test verifies that the store fetches an image that is not in
+// the store using simple discovery, and fetches it only once.
+TEST_F(AppcStoreTest, CURL_Fetch)
+{
+  TestAppcImageServer server;
+  spawn(server);
+
+  // Create the image archive.
+  const string image = path::join(os::getcwd(), "image");
+
+  JSON::Value manifest = JSON::parse(
+      "{"
+      "  \"acKind\": \"ImageManifest\","
+      "  \"acVersion\": \"0.6.1\","
+      "  \"name\": \"bar\","
+      "  \"labels\": ["
+      "    {"
+      "      \"name\": \"version\","
+      "      \"value\": \"1.0.0\""
+      "    }"
+      "  ]"
+      "}").get();
+
+  ASSERT_SOME(os::mkdir(path::join(image, "rootfs", "tmp")));
+  ASSERT_SOME(os::write(path::join(image, "rootfs", "tmp", "test"), "test"));
+  ASSERT_SOME(os::write(path::join(image, "manifest"), stringify(manifest)));
+
+  const string archive = path::join(os::getcwd(), "image.aci");
+  ASSERT_SOME(os::shell("tar -C " + image + " -czf " + archive + " ."));
+
+  Try<string> contents = os::read(archive);
+  ASSERT_SOME(contents);
+
+  EXPECT_CALL(server, image(_))
+    .WillOnce(Return(http::OK(contents.get())));
+
+  slave::Flags flags;
+  flags.appc_store_dir = path::join(os::getcwd(), "store");
+  flags.appc_simple_discovery_uri_prefix =
+    "http://" + stringify(server.self().address) + "/TestAppcImageServer/";
+
+  Try<Owned<slave::Store>> store = Store::create(flags);
+  ASSERT_SOME(store);
+
+  AWAIT_READY(store.get()->recover());
+
+  Image appc;
+  appc.set_type(Image::APPC);
+  appc.mutable_appc()->set_name("bar");
+
+  Label* label = appc.mutable_appc()->mutable_labels()->add_labels();
+  label->set_key("version");
+  label->set_value("1.0.0");
+
+  Future<slave::ImageInfo> imageInfo1 = store.get()->get(appc);
+  Future<slave::ImageInfo> imageInfo2 = store.get()->get(appc);
+
+  AWAIT_READY(imageInfo1);
+  AWAIT_READY(imageInfo2);
+
+  ASSERT_EQ(1u, imageInfo1.get().layers.size());
+  EXPECT_EQ(imageInfo1.get().layers, imageInfo2.get().layers);
+
+  Try<string> test =
+    os::read(path::join(imageInfo1.get().layers.front(), "tmp", "test"));
+
+  EXPECT_SOME_EQ("test", test);
+
+  terminate(server);
+  wait(server);
+}
+
+
 class ProvisionerAppcTest : public TemporaryDirectoryTest {};
 
 
@@ -32,6 +32,10 @@
 #include "slave/containerizer/mesos/provisioner/backends/bind.hpp"
 #include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
 
+#ifdef __linux__
+#include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
+#endif // __linux__
+
 #include "tests/flags.hpp"
 
 using namespace process;
@@ -97,6 +101,54 @@ TEST_F(BindBackendTest, ROOT_BindBackend)
 
   EXPECT_FALSE(os::exists(target));
 }
+
+
+class OverlayBackendTest : public BindBackendTest {};
+
+
+// Provision a rootfs using multiple layers with the overlay backend
+// and verify that writes only go to the rootfs' upper directory.
+TEST_F(OverlayBackendTest, ROOT_OVERLAYFS_OverlayBackend)
+{
+  string layer1 = path::join(os::getcwd(), "source1");
+  ASSERT_SOME(os::mkdir(layer1));
+  ASSERT_SOME(os::mkdir(path::join(layer1, "dir1")));
+  ASSERT_SOME(os::write(path::join(layer1, "dir1", "1"), "1"));
+  ASSERT_SOME(os::write(path::join(layer1, "file"), "test1"));
+
+  string layer2 = path::join(os::getcwd(), "source2");
+  ASSERT_SOME(os::mkdir(layer2));
+  ASSERT_SOME(os::mkdir(path::join(layer2, "dir2")));
+  ASSERT_SOME(os::write(path::join(layer2, "dir2", "2"), "2"));
+  ASSERT_SOME(os::write(path::join(layer2, "file"), "test2"));
+
+  string rootfs = path::join(os::getcwd(), "rootfses", "rootfs");
+
+  hashmap<string, Owned<Backend>> backends = Backend::create(slave::Flags());
+  ASSERT_TRUE(backends.contains("overlay"));
+
+  AWAIT_READY(backends["overlay"]->provision({layer1, layer2}, rootfs));
+
+  EXPECT_SOME_EQ("1", os::read(path::join(rootfs, "dir1", "1")));
+  EXPECT_SOME_EQ("2", os::read(path::join(rootfs, "dir2", "2")));
+
+  // Last layer should overwrite existing file.
+  EXPECT_SOME_EQ("test2", os::read(path::join(rootfs, "file")));
+
+  ASSERT_SOME(os::write(path::join(rootfs, "file"), "test3"));
+  EXPECT_SOME_EQ("test3", os::read(path::join(rootfs, "file")));
+
+  EXPECT_SOME_EQ("test1", os::read(path::join(layer1, "file")));
+  EXPECT_SOME_EQ("test2", os::read(path::join(layer2, "file")));
+
+  string scratch = path::join(os::getcwd(), "scratch", "rootfs");
+  EXPECT_TRUE(os::exists(scratch));
+
+  AWAIT_EXPECT_TRUE(backends["overlay"]->destroy(rootfs));
+
+  EXPECT_FALSE(os::exists(rootfs));
+  EXPECT_FALSE(os::exists(scratch));
+}
 #endif // __linux__
 
 
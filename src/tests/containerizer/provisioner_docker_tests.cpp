@@ -20,9 +20,11 @@
 
 #include <gtest/gtest.h>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
@@ -63,6 +65,7 @@ using std::string;
 using std::vector;
 
 using process::Clock;
+using process::Failure;
 using process::Future;
 using process::Owned;
 using process::Promise;
@@ -736,6 +739,65 @@ TEST_F(RegistryClientTest, SimpleGetBlob)
 }
 
 
+// Tests that the registry client keeps the connection to the registry
+// alive and reuses it for subsequent requests.
+TEST_F(RegistryClientTest, ReuseConnection)
+{
+  Try<Socket> server = getServer();
+
+  ASSERT_SOME(server);
+  ASSERT_SOME(server.get().address());
+  ASSERT_SOME(server.get().address().get().hostname());
+
+  Future<Socket> socket = server.get().accept();
+
+  const process::http::URL url(
+      "https",
+      server.get().address().get().hostname().get(),
+      server.get().address().get().port);
+
+  Try<Owned<RegistryClient>> registryClient =
+    RegistryClient::create(url, url, None());
+
+  ASSERT_SOME(registryClient);
+
+  const Path blobPath1(path::join(os::getcwd(), "blob1"));
+  const Path blobPath2(path::join(os::getcwd(), "blob2"));
+
+  Future<size_t> result1 =
+    registryClient.get()->getBlob(parseImageName("blob"), "1", blobPath1);
+
+  AWAIT_ASSERT_READY(socket);
+
+  const string blobResponse = "blob";
+  const string blobHttpResponse =
+    string("HTTP/1.1 200 OK\r\n") +
+    "Content-Length : " + stringify(blobResponse.length()) + "\r\n" +
+    "\r\n" +
+    blobResponse;
+
+  Future<string> blobHttpRequest = Socket(socket.get()).recv();
+  AWAIT_ASSERT_READY(blobHttpRequest);
+  EXPECT_FALSE(strings::contains(blobHttpRequest.get(), "close"));
+  AWAIT_ASSERT_READY(Socket(socket.get()).send(blobHttpResponse));
+
+  AWAIT_ASSERT_READY(result1);
+
+  // The second request is received over the same connection.
+  Future<size_t> result2 =
+    registryClient.get()->getBlob(parseImageName("blob"), "2", blobPath2);
+
+  blobHttpRequest = Socket(socket.get()).recv();
+  AWAIT_ASSERT_READY(blobHttpRequest);
+  AWAIT_ASSERT_READY(Socket(socket.get()).send(blobHttpResponse));
+
+  AWAIT_ASSERT_READY(result2);
+
+  EXPECT_SOME_EQ(blobResponse, os::read(blobPath1));
+  EXPECT_SOME_EQ(blobResponse, os::read(blobPath2));
+}
+
+
 TEST_F(RegistryClientTest, BadRequest)
 {
   Try<Socket> server = getServer();
@@ -1276,6 +1338,110 @@ TEST_F(ProvisionerDockerLocalStoreTest, PullingSameImageSimutanuously)
   EXPECT_EQ(imageInfo1.get().layers, imageInfo2.get().layers);
 }
 
+
+// This test verifies that pruning the store removes the least
+// recently used images first, and that layers shared with remaining
+// images or used by containers are kept.
+TEST_F(ProvisionerDockerLocalStoreTest, PruneLeastRecentlyUsedImages)
+{
+  slave::Flags flags;
+  flags.docker_registry = "file://" + path::join(os::getcwd(), "images");
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+  flags.docker_store_max_size = Bytes(1);
+
+  // Stage the layers the puller returns in a fresh directory for
+  // every pull, since the store moves them.
+  auto layers = [](const vector<string>& layerIds) {
+    return [layerIds](
+        const slave::docker::Image::Name& name,
+        const Path& directory) -> Future<list<pair<string, string>>> {
+      list<pair<string, string>> result;
+      foreach (const string& layerId, layerIds) {
+        const string layerPath = path::join(directory, layerId);
+        Try<Nothing> mkdir = os::mkdir(path::join(layerPath, "rootfs"));
+        if (mkdir.isError()) {
+          return Failure(mkdir.error());
+        }
+
+        Try<Nothing> write =
+          os::write(path::join(layerPath, "rootfs", "temp"), layerId);
+        if (write.isError()) {
+          return Failure(write.error());
+        }
+
+        result.push_back(std::make_pair(layerId, layerPath));
+      }
+
+      return result;
+    };
+  };
+
+  MockPuller* puller = new MockPuller();
+
+  EXPECT_CALL(*puller, pull(_, _))
+    .WillOnce(Invoke(layers({"123", "456"})))
+    .WillOnce(Invoke(layers({"123", "789"})));
+
+  Try<Owned<slave::Store>> store =
+      slave::docker::Store::create(flags, Owned<Puller>(puller));
+  ASSERT_SOME(store);
+
+  AWAIT_READY(store.get()->recover());
+
+  Image abc;
+  abc.set_type(Image::DOCKER);
+  abc.mutable_docker()->set_name("abc");
+
+  Image def;
+  def.set_type(Image::DOCKER);
+  def.mutable_docker()->set_name("def");
+
+  AWAIT_READY(store.get()->get(abc));
+
+  Future<slave::ImageInfo> imageInfo = store.get()->get(def);
+  AWAIT_READY(imageInfo);
+
+  // Use 'abc' again so that 'def' is the least recently used image.
+  AWAIT_READY(store.get()->get(abc));
+
+  const string layer123 =
+    getImageLayerRootfsPath(flags.docker_store_dir, "123");
+  const string layer456 =
+    getImageLayerRootfsPath(flags.docker_store_dir, "456");
+  const string layer789 =
+    getImageLayerRootfsPath(flags.docker_store_dir, "789");
+
+  // 'def' is used by a container, so only 'abc' can be removed. Layer
+  // '123' is shared with 'def' and must be kept.
+  hashset<string> activeLayers;
+  foreach (const string& layer, imageInfo.get().layers) {
+    activeLayers.insert(layer);
+  }
+
+  AWAIT_READY(store.get()->prune(activeLayers));
+
+  EXPECT_TRUE(os::exists(layer123));
+  EXPECT_FALSE(os::exists(layer456));
+  EXPECT_TRUE(os::exists(layer789));
+
+  // Once 'def' is not used anymore it is removed as well.
+  AWAIT_READY(store.get()->prune(hashset<string>()));
+
+  EXPECT_FALSE(os::exists(layer123));
+  EXPECT_FALSE(os::exists(layer789));
+
+  // Both images have been removed from the metadata and are pulled
+  // again on the next request.
+  EXPECT_CALL(*puller, pull(_, _))
+    .WillOnce(Invoke(layers({"123", "456"})));
+
+  imageInfo = store.get()->get(abc);
+  AWAIT_READY(imageInfo);
+
+  EXPECT_TRUE(os::exists(layer123));
+  EXPECT_TRUE(os::exists(layer456));
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
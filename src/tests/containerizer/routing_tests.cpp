@@ -17,6 +17,7 @@
 #include <signal.h>
 #include <unistd.h>
 
+#include <linux/pkt_cls.h>
 #include <linux/version.h>
 
 #include <sys/types.h>
@@ -35,6 +36,8 @@
 #include <stout/net.hpp>
 #include <stout/stringify.hpp>
 
+#include "linux/ebpf.hpp"
+
 #include "linux/routing/handle.hpp"
 #include "linux/routing/route.hpp"
 #include "linux/routing/utils.hpp"
@@ -42,6 +45,7 @@
 #include "linux/routing/diagnosis/diagnosis.hpp"
 
 #include "linux/routing/filter/basic.hpp"
+#include "linux/routing/filter/bpf.hpp"
 #include "linux/routing/filter/handle.hpp"
 #include "linux/routing/filter/icmp.hpp"
 #include "linux/routing/filter/ip.hpp"
@@ -1336,6 +1340,132 @@ TEST_F(RoutingVethTest, ROOT_IPFilterRemove)
 }
 
 
+// Tests that IP packet filters can be created and removed in batches,
+// including more filters than fit into a single netlink batch.
+TEST_F(RoutingVethTest, ROOT_IPFilterBatch)
+{
+  ASSERT_SOME(link::create(TEST_VETH_LINK, TEST_PEER_LINK, None()));
+
+  EXPECT_SOME_TRUE(link::exists(TEST_VETH_LINK));
+  EXPECT_SOME_TRUE(link::exists(TEST_PEER_LINK));
+
+  ASSERT_SOME_TRUE(ingress::create(TEST_VETH_LINK));
+
+  vector<ip::Classifier> classifiers;
+  for (uint16_t port = 1024; port < 1024 + 100; port++) {
+    Try<ip::PortRange> sourcePorts = ip::PortRange::fromBeginEnd(port, port);
+    ASSERT_SOME(sourcePorts);
+
+    classifiers.push_back(
+        ip::Classifier(None(), None(), sourcePorts.get(), None()));
+  }
+
+  // The first filter is created before hand, hence it already exists.
+  EXPECT_SOME_TRUE(ip::create(
+      TEST_VETH_LINK,
+      ingress::HANDLE,
+      classifiers.front(),
+      Priority(1, 1),
+      action::Redirect(TEST_PEER_LINK)));
+
+  Try<vector<bool>> created = ip::create(
+      TEST_VETH_LINK,
+      ingress::HANDLE,
+      classifiers,
+      Priority(1, 1),
+      action::Redirect(TEST_PEER_LINK));
+
+  ASSERT_SOME(created);
+  ASSERT_EQ(classifiers.size(), created.get().size());
+  EXPECT_FALSE(created.get().front());
+
+  for (size_t i = 1; i < classifiers.size(); i++) {
+    EXPECT_TRUE(created.get()[i]);
+    EXPECT_SOME_TRUE(
+        ip::exists(TEST_VETH_LINK, ingress::HANDLE, classifiers[i]));
+  }
+
+  Result<vector<ip::Classifier>> existing =
+    ip::classifiers(TEST_VETH_LINK, ingress::HANDLE);
+
+  ASSERT_SOME(existing);
+  EXPECT_EQ(classifiers.size(), existing.get().size());
+
+  // The last filter is removed before hand, hence it does not exist.
+  EXPECT_SOME_TRUE(
+      ip::remove(TEST_VETH_LINK, ingress::HANDLE, classifiers.back()));
+
+  Try<vector<bool>> removed =
+    ip::remove(TEST_VETH_LINK, ingress::HANDLE, classifiers);
+
+  ASSERT_SOME(removed);
+  ASSERT_EQ(classifiers.size(), removed.get().size());
+  EXPECT_FALSE(removed.get().back());
+
+  for (size_t i = 0; i < classifiers.size() - 1; i++) {
+    EXPECT_TRUE(removed.get()[i]);
+  }
+
+  existing = ip::classifiers(TEST_VETH_LINK, ingress::HANDLE);
+
+  ASSERT_SOME(existing);
+  EXPECT_EQ(0u, existing.get().size());
+}
+
+
+// Tests that a BPF filter running an eBPF program in direct-action
+// mode can be created, replaced and removed.
+TEST_F(RoutingVethTest, ROOT_BPFFilterCreate)
+{
+  if (!ebpf::supported()) {
+    LOG(WARNING) << "Skipping the test as eBPF is not supported";
+    return;
+  }
+
+  ASSERT_SOME(link::create(TEST_VETH_LINK, TEST_PEER_LINK, None()));
+
+  EXPECT_SOME_TRUE(link::exists(TEST_VETH_LINK));
+  EXPECT_SOME_TRUE(link::exists(TEST_PEER_LINK));
+
+  ASSERT_SOME_TRUE(ingress::create(TEST_VETH_LINK));
+
+  // A program which sends all the packets to the next filter.
+  vector<struct bpf_insn> instructions;
+  instructions.push_back(ebpf::insn::mov64(BPF_REG_0, TC_ACT_UNSPEC));
+  instructions.push_back(ebpf::insn::ret());
+
+  Try<Owned<ebpf::Program>> program =
+    ebpf::Program::load(BPF_PROG_TYPE_SCHED_CLS, instructions);
+
+  ASSERT_SOME(program);
+
+  EXPECT_SOME(bpf::create(
+      TEST_VETH_LINK,
+      ingress::HANDLE,
+      Priority(1, 1),
+      program.get()->fd(),
+      "test"));
+
+  // The program of the filter can be replaced.
+  EXPECT_SOME(bpf::create(
+      TEST_VETH_LINK,
+      ingress::HANDLE,
+      Priority(1, 1),
+      program.get()->fd(),
+      "test"));
+
+  EXPECT_SOME_TRUE(bpf::remove(
+      TEST_VETH_LINK,
+      ingress::HANDLE,
+      Priority(1, 1)));
+
+  EXPECT_SOME_FALSE(bpf::remove(
+      TEST_VETH_LINK,
+      ingress::HANDLE,
+      Priority(1, 1)));
+}
+
+
 // Test the workaround introduced for MESOS-1617.
 TEST_F(RoutingVethTest, ROOT_HandleGeneration)
 {
@@ -0,0 +1,116 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <stout/bytes.hpp>
+#include <stout/gtest.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+
+#include <stout/tests/utils.hpp>
+
+#include "linux/fs.hpp"
+
+#include "slave/containerizer/mesos/isolators/xfs/utils.hpp"
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+// Mounts an XFS filesystem with project quotas from an image in the
+// temporary directory of the test.
+class ROOT_XFS_QuotaTest : public TemporaryDirectoryTest
+{
+public:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    // NOTE: Recent versions of 'mkfs.xfs' refuse to create
+    // filesystems smaller than 300MB. The image is sparse.
+    const string image = path::join(sandbox.get(), "image");
+    ASSERT_EQ(0, os::system("truncate -s 320M " + image));
+    ASSERT_EQ(0, os::system("mkfs.xfs -q " + image));
+
+    const string target = path::join(sandbox.get(), "mnt");
+    ASSERT_SOME(os::mkdir(target));
+    ASSERT_EQ(0, os::system(
+        "mount -o loop,prjquota " + image + " " + target));
+
+    mountPoint = target;
+
+    Try<string> _device = xfs::getDevice(target);
+    ASSERT_SOME(_device);
+    device = _device.get();
+  }
+
+  virtual void TearDown()
+  {
+    if (mountPoint.isSome()) {
+      fs::unmount(mountPoint.get());
+    }
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+protected:
+  Option<string> mountPoint;
+  string device;
+};
+
+
+// This test verifies that the files of a project can not use more
+// blocks than the limit of the project, and that their usage is
+// accounted to the project.
+TEST_F(ROOT_XFS_QuotaTest, ProjectQuota)
+{
+  EXPECT_SOME_TRUE(xfs::isQuotaEnabled(mountPoint.get()));
+
+  const string directory = path::join(mountPoint.get(), "sandbox");
+  ASSERT_SOME(os::mkdir(directory));
+
+  EXPECT_NONE(xfs::getProjectId(directory));
+
+  ASSERT_SOME(xfs::setProjectId(directory, 5000));
+  EXPECT_SOME_EQ(5000u, xfs::getProjectId(directory));
+
+  ASSERT_SOME(xfs::setProjectQuota(device, 5000, Megabytes(1)));
+
+  // The files created in the directory inherit its project.
+  EXPECT_NE(0, os::system(
+      "dd if=/dev/zero of=" + path::join(directory, "file") +
+      " bs=1M count=2 conv=fsync 2>/dev/null"));
+
+  Try<Bytes> usage = xfs::getProjectUsage(device, 5000);
+  ASSERT_SOME(usage);
+  EXPECT_LT(Bytes(0), usage.get());
+  EXPECT_GE(Megabytes(1), usage.get());
+
+  // Removing the files from the project releases their blocks.
+  ASSERT_SOME(xfs::clearProjectId(directory));
+  EXPECT_NONE(xfs::getProjectId(directory));
+  EXPECT_SOME_EQ(Bytes(0), xfs::getProjectUsage(device, 5000));
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unistd.h>
+
 #include <string>
 #include <vector>
 
@@ -141,6 +143,57 @@ TEST_F(DiskUsageCollectorTest, SymbolicLink)
 }
 
 
+// This test verifies that a file with multiple hard links is only
+// counted once.
+TEST_F(DiskUsageCollectorTest, HardLink)
+{
+  string file = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(file, string(Kilobytes(64).bytes(), 'x')));
+
+  string link = path::join(os::getcwd(), "link");
+  ASSERT_EQ(0, ::link(file.c_str(), link.c_str()));
+
+  DiskUsageCollector collector(Milliseconds(1));
+
+  Future<Bytes> usage = collector.usage(os::getcwd());
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(64));
+  EXPECT_LT(usage.get(), Kilobytes(128));
+}
+
+
+// This test verifies that the usage reflects files which are added
+// or grow between two checks.
+TEST_F(DiskUsageCollectorTest, Changes)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  ASSERT_SOME(os::mkdir(dir));
+
+  string file1 = path::join(dir, "file1");
+  ASSERT_SOME(os::write(file1, string(Kilobytes(64).bytes(), 'x')));
+
+  DiskUsageCollector collector(Milliseconds(1));
+
+  Future<Bytes> usage = collector.usage(os::getcwd());
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(64));
+  EXPECT_LT(usage.get(), Kilobytes(128));
+
+  // Grow the existing file and add another one.
+  ASSERT_SOME(os::write(file1, string(Kilobytes(128).bytes(), 'x')));
+
+  string file2 = path::join(dir, "file2");
+  ASSERT_SOME(os::write(file2, string(Kilobytes(64).bytes(), 'y')));
+
+  usage = collector.usage(os::getcwd());
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(192));
+}
+
+
 class DiskQuotaTest : public MesosTest {};
 
 
@@ -458,6 +458,32 @@ private:
 };
 
 
+class OverlayFSFilter : public TestFilter
+{
+public:
+  OverlayFSFilter()
+  {
+    overlayfsError = os::system("grep -qw overlay /proc/filesystems") != 0;
+    if (overlayfsError) {
+      std::cerr
+        << "-------------------------------------------------------------\n"
+        << "The overlay filesystem is not supported so no 'overlayfs'\n"
+        << "tests will be run\n"
+        << "-------------------------------------------------------------"
+        << std::endl;
+    }
+  }
+
+  bool disable(const ::testing::TestInfo* test) const
+  {
+    return matches(test, "OVERLAYFS_") && overlayfsError;
+  }
+
+private:
+  bool overlayfsError;
+};
+
+
 class PerfCPUCyclesFilter : public TestFilter
 {
 public:
@@ -564,6 +590,31 @@ public:
 };
 
 
+class XfsFilter : public TestFilter
+{
+public:
+  XfsFilter()
+  {
+    xfsError = os::system("which mkfs.xfs") != 0;
+    if (xfsError) {
+      std::cerr
+        << "-------------------------------------------------------------\n"
+        << "No 'mkfs.xfs' command found so no XFS tests will be run\n"
+        << "-------------------------------------------------------------"
+        << std::endl;
+    }
+  }
+
+  bool disable(const ::testing::TestInfo* test) const
+  {
+    return matches(test, "XFS_") && xfsError;
+  }
+
+private:
+  bool xfsError;
+};
+
+
 // Return list of disabled tests based on test name based filters.
 static vector<string> disabled(
     const ::testing::UnitTest* unitTest,
@@ -640,9 +691,11 @@ Environment::Environment(const Flags& _flags) : flags(_flags)
   filters.push_back(Owned<TestFilter>(new NetcatFilter()));
   filters.push_back(Owned<TestFilter>(new NetClsCgroupsFilter()));
   filters.push_back(Owned<TestFilter>(new NetworkIsolatorTestFilter()));
+  filters.push_back(Owned<TestFilter>(new OverlayFSFilter()));
   filters.push_back(Owned<TestFilter>(new PerfCPUCyclesFilter()));
   filters.push_back(Owned<TestFilter>(new PerfFilter()));
   filters.push_back(Owned<TestFilter>(new RootFilter()));
+  filters.push_back(Owned<TestFilter>(new XfsFilter()));
 
   // Construct the filter string to handle system or platform specific tests.
   ::testing::UnitTest* unitTest = ::testing::UnitTest::GetInstance();
@@ -28,6 +28,8 @@
 #include <process/message.hpp>
 #include <process/pid.hpp>
 
+#include <stout/uuid.hpp>
+
 #include "common/http.hpp"
 #include "common/recordio.hpp"
 
@@ -701,6 +703,44 @@ TEST_P(ExecutorHttpApiTest, StatusUpdateCallFailedValidation)
     AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, responseStatusUpdate);
   }
 
+  // We send a Call Updates message in which the second status update
+  // is a TASK_STAGING one. This should fail validation.
+  {
+    Call call;
+    call.set_type(Call::UPDATES);
+    call.mutable_framework_id()->set_value("dummy_framework_id");
+    call.mutable_executor_id()->set_value("call_level_executor_id");
+
+    v1::TaskStatus* status =
+      call.mutable_updates()->add_updates()->mutable_status();
+
+    status->mutable_executor_id()->set_value("call_level_executor_id");
+    status->mutable_task_id()->set_value("dummy_task_id1");
+    status->set_state(mesos::v1::TaskState::TASK_RUNNING);
+    status->set_source(mesos::v1::TaskStatus::SOURCE_EXECUTOR);
+    status->set_uuid(UUID::random().toBytes());
+
+    status = call.mutable_updates()->add_updates()->mutable_status();
+
+    status->mutable_executor_id()->set_value("call_level_executor_id");
+    status->mutable_task_id()->set_value("dummy_task_id2");
+    status->set_state(mesos::v1::TaskState::TASK_STAGING);
+    status->set_source(mesos::v1::TaskStatus::SOURCE_EXECUTOR);
+    status->set_uuid(UUID::random().toBytes());
+
+    process::http::Headers headers;
+    headers["Accept"] = APPLICATION_JSON;
+
+    Future<Response> responseStatusUpdate = process::http::post(
+        slave.get(),
+        "api/v1/executor",
+        headers,
+        serialize(ContentType::PROTOBUF, call),
+        APPLICATION_PROTOBUF);
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, responseStatusUpdate);
+  }
+
   Shutdown();
 }
 
@@ -16,6 +16,8 @@
 
 #include <unistd.h>
 
+#include <sys/stat.h>
+
 #include <list>
 #include <string>
 #include <vector>
@@ -655,6 +657,106 @@ TEST_F(FetcherCacheTest, LocalCached)
 }
 
 
+// Tests that identical content fetched from different URIs is only
+// cached once if the URIs carry the content's checksum.
+TEST_F(FetcherCacheTest, LocalCachedChecksum)
+{
+  const string copyDirectory = path::join(assetsDirectory, "copy");
+  ASSERT_SOME(os::mkdir(copyDirectory));
+
+  const string copyPath = path::join(copyDirectory, COMMAND_NAME);
+  ASSERT_SOME(os::write(copyPath, COMMAND_SCRIPT));
+  ASSERT_SOME(os::chmod(copyPath, S_IRWXU));
+
+  Try<string> checksum = os::shell("sha256sum '%s'", commandPath.c_str());
+  ASSERT_SOME(checksum);
+
+  startSlave();
+  driver->start();
+
+  const vector<string> paths = {commandPath, copyPath};
+
+  for (size_t i = 0; i < paths.size(); i++) {
+    CommandInfo::URI uri;
+    uri.set_value(paths[i]);
+    uri.set_executable(true);
+    uri.set_cache(true);
+    uri.set_checksum(strings::tokenize(checksum.get(), " ")[0]);
+
+    CommandInfo commandInfo;
+    commandInfo.set_value("./" + COMMAND_NAME + " " + taskName(i));
+    commandInfo.add_uris()->CopyFrom(uri);
+
+    const Try<Task> task = launchTask(commandInfo, i);
+    ASSERT_SOME(task);
+
+    AWAIT_READY(awaitFinished(task.get()));
+
+    const string path = path::join(task.get().runDirectory.value, COMMAND_NAME);
+    EXPECT_TRUE(isExecutable(path));
+    EXPECT_TRUE(os::exists(path + taskName(i)));
+
+    EXPECT_EQ(1u, fetcherProcess->cacheSize());
+    ASSERT_SOME(fetcherProcess->cacheFiles(slaveId, flags));
+    EXPECT_EQ(1u, fetcherProcess->cacheFiles(slaveId, flags).get().size());
+
+    // The cache file is named after the checksum, so that peer agents
+    // can find it (see '--fetcher_peers').
+    const Path cacheFile = fetcherProcess->cacheFiles(slaveId, flags)->front();
+    EXPECT_TRUE(strings::startsWith(
+        cacheFile.basename(),
+        "c" + strings::tokenize(checksum.get(), " ")[0]));
+  }
+}
+
+
+// Tests that cache files get hard linked into the sandboxes when
+// this is enabled (and the file system does not support reflinks).
+TEST_F(FetcherCacheTest, LocalCachedHardlinks)
+{
+  flags.fetcher_cache_hardlinks = true;
+
+  startSlave();
+  driver->start();
+
+  for (size_t i = 0; i < 2; i++) {
+    CommandInfo::URI uri;
+    uri.set_value(commandPath);
+    uri.set_executable(true);
+    uri.set_cache(true);
+
+    CommandInfo commandInfo;
+    commandInfo.set_value("./" + COMMAND_NAME + " " + taskName(i));
+    commandInfo.add_uris()->CopyFrom(uri);
+
+    const Try<Task> task = launchTask(commandInfo, i);
+    ASSERT_SOME(task);
+
+    AWAIT_READY(awaitFinished(task.get()));
+
+    const string path = path::join(task.get().runDirectory.value, COMMAND_NAME);
+    EXPECT_TRUE(isExecutable(path));
+    EXPECT_TRUE(os::exists(path + taskName(i)));
+
+    Try<list<Path>> cacheFiles = fetcherProcess->cacheFiles(slaveId, flags);
+    ASSERT_SOME(cacheFiles);
+    ASSERT_EQ(1u, cacheFiles.get().size());
+
+    struct stat sandboxFile;
+    ASSERT_EQ(0, ::stat(path.c_str(), &sandboxFile));
+
+    struct stat cacheFile;
+    ASSERT_EQ(0, ::stat(cacheFiles.get().front().value.c_str(), &cacheFile));
+
+    // A file that has been cloned instead has its own inode.
+    if (sandboxFile.st_nlink > 1) {
+      EXPECT_EQ(cacheFile.st_ino, sandboxFile.st_ino);
+      EXPECT_EQ(0u, sandboxFile.st_mode & (S_IWUSR | S_IWGRP | S_IWOTH));
+    }
+  }
+}
+
+
 // Tests falling back on bypassing the cache when fetching the download
 // size of a URI that is supposed to be cached fails.
 TEST_F(FetcherCacheTest, CachedFallback)
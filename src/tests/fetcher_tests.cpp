@@ -101,6 +101,40 @@ TEST_F(FetcherTest, FileURI)
 }
 
 
+// This test verifies that local files are fetched without running
+// the mesos-fetcher, here by pointing to a launcher directory which
+// does not contain it.
+TEST_F(FetcherTest, FileURIInProcess)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+  string testFile = path::join(fromDir, "test");
+  EXPECT_SOME(os::write(testFile, "data"));
+
+  string localFile = path::join(os::getcwd(), "test");
+  EXPECT_FALSE(os::exists(localFile));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(os::getcwd(), "nonexistent");
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("file://" + testFile);
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+  AWAIT_READY(fetch);
+
+  EXPECT_SOME_EQ("data", os::read(localFile));
+}
+
+
 // Negative test: invalid user name. Copied from FileTest, so this
 // normally would succeed, but here a bogus user name is specified.
 // So we check for fetch failure.
@@ -394,6 +428,59 @@ TEST_F(FetcherTest, OSNetUriSpaceTest)
 }
 
 
+// Tests that a tar archive which is fetched over HTTP is extracted
+// while it is being downloaded, i.e., without writing the archive
+// into the sandbox.
+TEST_F(FetcherTest, OSNetUriExtractTar)
+{
+  // Construct a compressed archive to be served over HTTP.
+  ASSERT_SOME(os::mkdir("source"));
+  ASSERT_SOME(os::write(path::join("source", "hello"), "hello tar"));
+  ASSERT_SOME(os::shell("tar czf archive.tar.gz -C source hello 2>&1"));
+
+  Try<string> archive = os::read("archive.tar.gz");
+  ASSERT_SOME(archive);
+
+  ASSERT_SOME(os::rm("archive.tar.gz"));
+  ASSERT_SOME(os::rmdir("source"));
+
+  Http http;
+
+  const network::Address& address = http.process->self().address;
+
+  process::http::URL url(
+      "http",
+      address.ip,
+      address.port,
+      path::join(http.process->self().id, "test", "archive.tar.gz"));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value(stringify(url));
+  uri->set_extract(true);
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  EXPECT_CALL(*http.process, test(_))
+    .WillOnce(Return(http::OK(archive.get())));
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+
+  AWAIT_READY(fetch);
+
+  EXPECT_SOME_EQ("hello tar", os::read(path::join(os::getcwd(), "hello")));
+  EXPECT_FALSE(os::exists(path::join(os::getcwd(), "archive.tar.gz")));
+}
+
+
 TEST_F(FetcherTest, FileLocalhostURI)
 {
   string fromDir = path::join(os::getcwd(), "from");
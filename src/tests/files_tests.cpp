@@ -31,6 +31,7 @@
 
 #include <stout/tests/utils.hpp>
 
+#include "files/compressed.hpp"
 #include "files/files.hpp"
 
 using process::Future;
@@ -134,6 +135,88 @@ TEST_F(FilesTest, ReadTest)
 }
 
 
+// This test verifies that a 'follow' read waits for data to be
+// appended to the file rather than returning no data right away.
+TEST_F(FilesTest, ReadFollowTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "body"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  Future<Response> response = process::http::get(
+      upid,
+      "read",
+      "path=myname&offset=4&follow=true&timeout=1mins");
+
+  Try<int> fd = os::open("file", O_WRONLY | O_APPEND | O_CLOEXEC);
+  ASSERT_SOME(fd);
+  ASSERT_SOME(os::write(fd.get(), "more"));
+  ASSERT_SOME(os::close(fd.get()));
+
+  JSON::Object expected;
+  expected.values["offset"] = 4;
+  expected.values["data"] = "more";
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  // Without new data, the read returns no data once it times out.
+  response = process::http::get(
+      upid,
+      "read",
+      "path=myname&offset=8&follow=true&timeout=10ms");
+
+  expected.values["offset"] = 8;
+  expected.values["data"] = "";
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+}
+
+
+// Tests that compressed files are read at their uncompressed offsets.
+TEST_F(FilesTest, ReadCompressedTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  // Write a file spanning a few frames.
+  string data;
+  while (data.size() < 3 * files::FRAME_SIZE.bytes()) {
+    data += stringify(data.size()) + "\n";
+  }
+
+  ASSERT_SOME(files::write("file.gz", data));
+  AWAIT_EXPECT_READY(files.attach("file.gz", "file.gz"));
+
+  // Read across the boundary of the first two frames.
+  const size_t offset = files::FRAME_SIZE.bytes() - 10;
+
+  JSON::Object expected;
+  expected.values["offset"] = offset;
+  expected.values["data"] = data.substr(offset, 20);
+
+  Future<Response> response = process::http::get(
+      upid,
+      "read",
+      "path=file.gz&offset=" + stringify(offset) + "&length=20");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  // Without an offset, the uncompressed size is returned.
+  expected.values["offset"] = data.size();
+  expected.values["data"] = "";
+
+  response = process::http::get(upid, "read", "path=file.gz");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+}
+
+
 TEST_F(FilesTest, ResolveTest)
 {
   Files files;
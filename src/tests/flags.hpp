@@ -149,6 +149,12 @@ public:
         "Use the default '" + master::DEFAULT_AUTHENTICATOR + "', or\n"
         "load an alternate authenticator module using --modules.",
         master::DEFAULT_AUTHENTICATOR);
+
+    add(&Flags::allocator_replay_file,
+        "allocator_replay_file",
+        "Recording of the allocator (see the --allocator_record_file flag\n"
+        "of the master) to be replayed by the\n"
+        "'HierarchicalAllocator_BENCHMARK_Test.Replay' benchmark.");
   }
 
   bool verbose;
@@ -160,6 +166,7 @@ public:
   Option<Modules> modules;
   Option<std::string> isolation;
   std::string authenticators;
+  Option<std::string> allocator_replay_file;
 };
 
 // Global flags for running the tests.
@@ -35,7 +35,9 @@
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/nothing.hpp>
+#include <stout/json.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 
 #include "logging/logging.hpp"
 
@@ -244,6 +246,50 @@ TEST_F(GarbageCollectorTest, Prune)
 }
 
 
+// This test verifies that a directory is removed along with its
+// contents, without leaving the directory it was renamed to behind.
+TEST_F(GarbageCollectorTest, RemoveDirectory)
+{
+  GarbageCollector gc;
+
+  const string& directory = "directory";
+
+  ASSERT_SOME(os::mkdir(path::join(directory, "nested")));
+  ASSERT_SOME(os::touch(path::join(directory, "file")));
+  ASSERT_SOME(os::touch(path::join(directory, "nested", "file")));
+
+  Clock::pause();
+
+  Future<Nothing> schedule = gc.schedule(Seconds(10), directory);
+
+  Clock::settle();
+
+  JSON::Object metrics = Metrics();
+  EXPECT_EQ(1u, metrics.values["gc/path_removals_pending"]);
+  EXPECT_EQ(0u, metrics.values["gc/path_removals_active"]);
+
+  Clock::advance(Seconds(10));
+  Clock::settle();
+
+  AWAIT_READY(schedule);
+
+  EXPECT_FALSE(os::exists(directory));
+
+  // Nothing is left in the parent directory.
+  Try<list<string>> entries = os::ls(".");
+  ASSERT_SOME(entries);
+  EXPECT_TRUE(entries.get().empty());
+
+  metrics = Metrics();
+  EXPECT_EQ(0u, metrics.values["gc/path_removals_pending"]);
+  EXPECT_EQ(0u, metrics.values["gc/path_removals_active"]);
+  EXPECT_EQ(1u, metrics.values["gc/path_removals_succeeded"]);
+  EXPECT_EQ(0u, metrics.values["gc/path_removals_failed"]);
+
+  Clock::resume();
+}
+
+
 class GarbageCollectorIntegrationTest : public MesosTest {};
 
 
@@ -694,6 +740,45 @@ TEST_F(GarbageCollectorIntegrationTest, DiskUsage)
 }
 
 
+// This test verifies that the slave checks the disk usage sooner than
+// every --disk_watch_interval when the disk is (almost) full.
+TEST_F(GarbageCollectorIntegrationTest, DiskUsageCheckInterval)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave> > slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Clock::pause();
+
+  Future<Nothing> checkDiskUsage =
+    FUTURE_DISPATCH(_, &Slave::checkDiskUsage);
+
+  // Simulate a disk full message to the slave.
+  process::dispatch(
+      slave.get(),
+      &Slave::_checkDiskUsage,
+      Try<double>(1.0 - slave::GC_DISK_HEADROOM));
+
+  Clock::settle();
+
+  // The disk usage is checked again after the minimum interval.
+  Clock::advance(slave::MIN_DISK_WATCH_INTERVAL);
+
+  AWAIT_READY(checkDiskUsage);
+
+  Clock::resume();
+
+  Shutdown();
+}
+
+
 // This test verifies that the launch of new executor will result in
 // an unschedule of the framework work directory created by an old
 // executor.
@@ -18,6 +18,7 @@
 
 #include <gmock/gmock.h>
 
+#include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -34,6 +35,7 @@
 using zookeeper::Group;
 using zookeeper::GroupProcess;
 
+using process::Clock;
 using process::Future;
 
 using std::string;
@@ -433,6 +435,61 @@ TEST_F(GroupTest, LabelledGroup)
   ASSERT_TRUE(membership.get().cancelled().get());
 }
 
+
+// Verifies that a watch on a group with a debounce is only updated
+// once the debounce has elapsed after a change and that the data of
+// a membership can still be read after ZooKeeper is disconnected
+// once it has been cached.
+TEST_F(GroupTest, DebouncedWatch)
+{
+  Group group(
+      server->connectString(), NO_TIMEOUT, "/test/", None(), Seconds(10));
+
+  Future<std::set<Group::Membership> > memberships = group.watch();
+
+  AWAIT_READY(memberships);
+  EXPECT_TRUE(memberships.get().empty());
+
+  memberships = group.watch(memberships.get());
+
+  Clock::pause();
+
+  Future<Nothing> updated = FUTURE_DISPATCH(_, &GroupProcess::updated);
+
+  // Join through another group so the change is only learned about
+  // through the ZooKeeper watch.
+  Group group2(server->connectString(), NO_TIMEOUT, "/test/");
+
+  Future<Group::Membership> membership = group2.join("hello world");
+
+  AWAIT_READY(membership);
+  AWAIT_READY(updated);
+
+  Clock::settle();
+  EXPECT_TRUE(memberships.isPending());
+
+  Clock::advance(Seconds(10));
+
+  AWAIT_READY(memberships);
+  EXPECT_EQ(1u, memberships.get().size());
+  EXPECT_EQ(1u, memberships.get().count(membership.get()));
+
+  Clock::resume();
+
+  Future<Option<string> > data = group.data(membership.get());
+
+  AWAIT_READY(data);
+  EXPECT_SOME_EQ("hello world", data.get());
+
+  server->shutdownNetwork();
+
+  // The data is served from the cache.
+  data = group.data(membership.get());
+
+  AWAIT_READY(data);
+  EXPECT_SOME_EQ("hello world", data.get());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -19,11 +19,15 @@
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/owned.hpp>
 #include <process/pid.hpp>
+#include <process/process.hpp>
 
 #include "docker/docker.hpp"
 
+#include "health-check/health_checker.hpp"
+
 #include "slave/slave.hpp"
 
 #include "slave/containerizer/docker.hpp"
@@ -1073,6 +1077,74 @@ TEST_F(HealthCheckTest, CheckCommandTimeout)
   Shutdown();
 }
 
+
+// Serves the endpoint checked by the HTTP health checks below.
+class HealthEndpointProcess : public process::Process<HealthEndpointProcess>
+{
+public:
+  HealthEndpointProcess() : ProcessBase("health-endpoint") {}
+
+protected:
+  virtual void initialize()
+  {
+    route("/health", None(), [](const http::Request&) {
+      return http::OK();
+    });
+  }
+};
+
+
+// Testing that an HTTP health check is done (by the checker itself,
+// without a subprocess), and that an unexpected status is unhealthy.
+TEST_F(HealthCheckTest, HTTPCheck)
+{
+  HealthEndpointProcess process;
+  PID<HealthEndpointProcess> pid = spawn(process);
+
+  HealthCheck check;
+  check.mutable_http()->set_port(pid.address.port);
+  check.mutable_http()->set_path("/" + pid.id + "/health");
+  check.set_delay_seconds(0);
+  check.set_interval_seconds(0);
+  check.set_consecutive_failures(1);
+
+  TaskID taskId;
+  taskId.set_value("1");
+
+  Future<TaskHealthStatus> healthy =
+    FUTURE_PROTOBUF(TaskHealthStatus(), _, pid);
+
+  Try<Owned<HealthChecker>> checker =
+    HealthChecker::create(check, pid, taskId);
+  ASSERT_SOME(checker);
+
+  checker.get()->healthCheck();
+
+  AWAIT_READY(healthy);
+  EXPECT_EQ(taskId, healthy.get().task_id());
+  EXPECT_TRUE(healthy.get().healthy());
+
+  // The endpoint returns '200 OK', which is not expected now.
+  check.mutable_http()->add_statuses(503);
+
+  Future<TaskHealthStatus> unhealthy =
+    FUTURE_PROTOBUF(TaskHealthStatus(), _, pid);
+
+  checker = HealthChecker::create(check, pid, taskId);
+  ASSERT_SOME(checker);
+
+  Future<Nothing> checking = checker.get()->healthCheck();
+
+  AWAIT_READY(unhealthy);
+  EXPECT_FALSE(unhealthy.get().healthy());
+  EXPECT_TRUE(unhealthy.get().kill_task());
+
+  AWAIT_FAILED(checking);
+
+  terminate(process);
+  wait(process);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -40,15 +40,19 @@
 #include "master/constants.hpp"
 #include "master/flags.hpp"
 
+#include "master/allocator/recorder.hpp"
+
 #include "master/allocator/mesos/hierarchical.hpp"
 
 #include "tests/allocator.hpp"
+#include "tests/flags.hpp"
 #include "tests/mesos.hpp"
 
 using mesos::internal::master::MIN_CPUS;
 using mesos::internal::master::MIN_MEM;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::RecordingAllocator;
 
 using mesos::master::allocator::Allocator;
 
@@ -521,6 +525,93 @@ TEST_F(HierarchicalAllocatorTest, OfferFilter)
 }
 
 
+// This test ensures that offer filters expire in the order of their
+// timeouts, even when a filter with a shorter timeout is installed
+// after a filter with a longer one.
+TEST_F(HierarchicalAllocatorTest, OfferFilterExpiryOrder)
+{
+  Clock::pause();
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  initialize();
+
+  FrameworkInfo framework = createFrameworkInfo("role");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  SlaveInfo agent1 = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(agent1.id(), agent1, None(), agent1.resources(), EMPTY);
+
+  Future<Allocation> allocation1 = allocations.get();
+  AWAIT_READY(allocation1);
+  EXPECT_EQ(framework.id(), allocation1.get().frameworkId);
+  EXPECT_EQ(agent1.resources(), Resources::sum(allocation1.get().resources));
+
+  SlaveInfo agent2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(agent2.id(), agent2, None(), agent2.resources(), EMPTY);
+
+  Future<Allocation> allocation2 = allocations.get();
+  AWAIT_READY(allocation2);
+  EXPECT_EQ(framework.id(), allocation2.get().frameworkId);
+  EXPECT_EQ(agent2.resources(), Resources::sum(allocation2.get().resources));
+
+  // Decline `agent1` for four and then `agent2` for two allocation
+  // intervals.
+  Filters longFilter;
+  longFilter.set_refuse_seconds((flags.allocation_interval * 4).secs());
+
+  Filters shortFilter;
+  shortFilter.set_refuse_seconds((flags.allocation_interval * 2).secs());
+
+  allocator->recoverResources(
+      framework.id(),
+      agent1.id(),
+      allocation1.get().resources.get(agent1.id()).get(),
+      longFilter);
+
+  allocator->recoverResources(
+      framework.id(),
+      agent2.id(),
+      allocation2.get().resources.get(agent2.id()).get(),
+      shortFilter);
+
+  // Ensure the offer filter timeouts are set before advancing the clock.
+  Clock::settle();
+
+  // Both agents are filtered during the first batch allocation.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  Future<Allocation> allocation = allocations.get();
+  ASSERT_TRUE(allocation.isPending());
+
+  // After two allocation intervals only the filter for `agent2` has
+  // expired.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(agent2.resources(), Resources::sum(allocation.get().resources));
+
+  allocation = allocations.get();
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  ASSERT_TRUE(allocation.isPending());
+
+  // The filter for `agent1` expires after four allocation intervals.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(agent1.resources(), Resources::sum(allocation.get().resources));
+}
+
+
 // This test ensures that an offer filter is not removed earlier than
 // the next batch allocation. See MESOS-4302 for more information.
 //
@@ -978,6 +1069,122 @@ TEST_F(HierarchicalAllocatorTest, RecoverResources)
 }
 
 
+// Checks that the resources recovered on many slaves at once are
+// re-allocated correctly.
+TEST_F(HierarchicalAllocatorTest, BatchRecoverResources)
+{
+  Clock::pause();
+
+  initialize();
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave1 = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(slave1.id(), slave1, None(), slave1.resources(), EMPTY);
+
+  SlaveInfo slave2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave2.id(), slave2, None(), slave2.resources(), EMPTY);
+
+  // Initially, all the resources are allocated.
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(2u, allocation.get().resources.size());
+  EXPECT_EQ(slave1.resources() + slave2.resources(),
+            Resources::sum(allocation.get().resources));
+
+  // Recover the resources on both slaves, expect them to be
+  // re-offered together.
+  hashmap<SlaveID, hashmap<FrameworkID, Resources>> recovered;
+  recovered[slave1.id()][framework.id()] = slave1.resources();
+  recovered[slave2.id()][framework.id()] = slave2.resources();
+
+  allocator->batchRecoverResources(recovered);
+
+  Clock::advance(flags.allocation_interval);
+
+  allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(2u, allocation.get().resources.size());
+  EXPECT_EQ(slave1.resources(), allocation.get().resources.at(slave1.id()));
+  EXPECT_EQ(slave2.resources(), allocation.get().resources.at(slave2.id()));
+}
+
+
+// Checks that the calls made to a recording allocator, and the offers
+// it makes, are recorded in order.
+TEST_F(HierarchicalAllocatorTest, Record)
+{
+  Clock::pause();
+
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+
+  Try<RecordingAllocator*> recorder =
+    RecordingAllocator::create(allocator, path.get());
+
+  ASSERT_SOME(recorder);
+
+  // The recorder now owns the allocator under test.
+  allocator = recorder.get();
+
+  initialize();
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(slave.id(), slave, None(), slave.resources(), EMPTY);
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+
+  Filters filters;
+  filters.set_refuse_seconds(10);
+
+  allocator->recoverResources(
+      framework.id(), slave.id(), slave.resources(), filters);
+
+  // Wait for the recorded events to be written out.
+  Clock::advance(Seconds(1));
+  Clock::settle();
+
+  Try<vector<AllocatorEvent>> events = RecordingAllocator::read(path.get());
+  ASSERT_SOME(events);
+  ASSERT_EQ(4u, events.get().size());
+
+  EXPECT_EQ(AllocatorEvent::ADD_SLAVE, events.get()[0].type());
+  EXPECT_EQ(slave.id(), events.get()[0].slave_id());
+  EXPECT_EQ(Resources(slave.resources()),
+            Resources(events.get()[0].resources()));
+
+  EXPECT_EQ(AllocatorEvent::ADD_FRAMEWORK, events.get()[1].type());
+  EXPECT_EQ(framework.id(), events.get()[1].framework_id());
+
+  EXPECT_EQ(AllocatorEvent::OFFER, events.get()[2].type());
+  ASSERT_EQ(1, events.get()[2].allocations_size());
+  EXPECT_EQ(framework.id(), events.get()[2].allocations(0).framework_id());
+  EXPECT_EQ(slave.id(), events.get()[2].allocations(0).slave_id());
+  EXPECT_EQ(Resources(slave.resources()),
+            Resources(events.get()[2].allocations(0).resources()));
+
+  EXPECT_EQ(AllocatorEvent::RECOVER_RESOURCES, events.get()[3].type());
+  ASSERT_EQ(1, events.get()[3].allocations_size());
+  EXPECT_EQ(slave.id(), events.get()[3].allocations(0).slave_id());
+  EXPECT_EQ(10, events.get()[3].filters().refuse_seconds());
+
+  ASSERT_SOME(os::rm(path.get()));
+}
+
+
 TEST_F(HierarchicalAllocatorTest, Allocatable)
 {
   // Pausing the clock is not necessary, but ensures that the test
@@ -1295,6 +1502,58 @@ TEST_F(HierarchicalAllocatorTest, OversubscribedNotAllocated)
 }
 
 
+// This test ensures that the batch allocation considers all slaves
+// again once a framework opts in for revocable resources, even though
+// the resources on the slaves have not changed.
+TEST_F(HierarchicalAllocatorTest, UpdateFrameworkRevocable)
+{
+  // Pause clock to disable periodic allocation.
+  Clock::pause();
+
+  initialize();
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave = createSlaveInfo("cpus:100;mem:100;disk:100");
+  allocator->addSlave(slave.id(), slave, None(), slave.resources(), EMPTY);
+
+  // Add a framework that does *not* accept revocable resources.
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  // Initially, all the resources are allocated.
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+
+  // Update the slave with 10 oversubscribed cpus, which are not
+  // allocated because the framework has not opted in for them.
+  Resources oversubscribed = createRevocableResources("cpus", "10");
+  allocator->updateSlave(slave.id(), oversubscribed);
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  allocation = allocations.get();
+  ASSERT_TRUE(allocation.isPending());
+
+  // Now the framework opts in for revocable resources.
+  framework.add_capabilities()->set_type(
+      FrameworkInfo::Capability::REVOCABLE_RESOURCES);
+
+  allocator->updateFramework(framework.id(), framework);
+
+  // The next batch allocation should offer the oversubscribed resources.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(oversubscribed, Resources::sum(allocation.get().resources));
+}
+
+
 // This test verifies that when oversubscribed resources are partially
 // recovered subsequent allocation properly accounts for that.
 TEST_F(HierarchicalAllocatorTest, RecoverOversubscribedResources)
@@ -2308,6 +2567,64 @@ TEST_F(HierarchicalAllocatorTest, DeactivateAndReactivateFramework)
 }
 
 
+// This test ensures that the allocation metrics are exported and
+// reflect the allocations performed by the allocator.
+TEST_F(HierarchicalAllocatorTest, AllocationMetrics)
+{
+  Clock::pause();
+
+  initialize();
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  // Adding the framework triggers an allocation run, but there are no
+  // slaves yet.
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  SlaveInfo agent = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(agent.id(), agent, None(), agent.resources(), EMPTY);
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(2, metrics.values["allocator/mesos/allocation_runs"]);
+  EXPECT_EQ(1, metrics.values["allocator/mesos/slaves_visited"]);
+  EXPECT_EQ(1, metrics.values["allocator/mesos/offers"]);
+  EXPECT_EQ(0, metrics.values["allocator/mesos/offers_filtered"]);
+
+  EXPECT_EQ(1u, metrics.values.count("allocator/mesos/allocation_run_ms"));
+  EXPECT_EQ(1u, metrics.values.count(
+      "allocator/mesos/allocation_run_quota_ms"));
+  EXPECT_EQ(1u, metrics.values.count(
+      "allocator/mesos/allocation_run_sort_ms"));
+
+  // Decline the offer with a filter, the next batch allocation then
+  // filters the resources.
+  Filters filter;
+  filter.set_refuse_seconds((flags.allocation_interval * 2).secs());
+
+  allocator->recoverResources(
+      framework.id(),
+      agent.id(),
+      allocation.get().resources.get(agent.id()).get(),
+      filter);
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  metrics = Metrics();
+
+  EXPECT_EQ(3, metrics.values["allocator/mesos/allocation_runs"]);
+  EXPECT_EQ(2, metrics.values["allocator/mesos/slaves_visited"]);
+  EXPECT_EQ(1, metrics.values["allocator/mesos/offers"]);
+  EXPECT_EQ(1, metrics.values["allocator/mesos/offers_filtered"]);
+}
+
+
 class HierarchicalAllocator_BENCHMARK_Test
   : public HierarchicalAllocatorTestBase,
     public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
@@ -2534,6 +2851,382 @@ TEST_F(HierarchicalAllocator_BENCHMARK_Test, DeclineOffers)
   Clock::resume();
 }
 
+// Returns the resources of the frameworks on the given agents.
+static Resources allocated(
+    const hashmap<FrameworkID, hashmap<SlaveID, Resources>>& offered,
+    const hashmap<SlaveID, Resources>& agents)
+{
+  Resources result;
+
+  foreachvalue (const auto& allocation, offered) {
+    foreachpair (const SlaveID& slaveId,
+                 const Resources& resources,
+                 allocation) {
+      if (agents.contains(slaveId)) {
+        result += resources.nonRevocable();
+      }
+    }
+  }
+
+  return result;
+}
+
+
+// Returns Jain's fairness index of the dominant shares (of the cpus
+// and the memory) of the frameworks, which is 1 if the shares are
+// the same and 1 / n if a single framework out of n holds resources.
+static Option<double> fairness(
+    const hashset<FrameworkID>& frameworks,
+    const hashmap<FrameworkID, hashmap<SlaveID, Resources>>& offered,
+    const hashmap<SlaveID, Resources>& agents)
+{
+  const Resources total = Resources::sum(agents);
+  const double cpus = total.cpus().getOrElse(0.0);
+  const double mem = total.mem().getOrElse(Bytes(0)).megabytes();
+
+  double sum = 0.0;
+  double squares = 0.0;
+
+  foreach (const FrameworkID& frameworkId, frameworks) {
+    Resources resources;
+    if (offered.contains(frameworkId)) {
+      resources = allocated({{frameworkId, offered.at(frameworkId)}}, agents);
+    }
+
+    double share = 0.0;
+
+    if (cpus > 0.0) {
+      share = std::max(share, resources.cpus().getOrElse(0.0) / cpus);
+    }
+
+    if (mem > 0.0) {
+      share = std::max(
+          share,
+          resources.mem().getOrElse(Bytes(0)).megabytes() / mem);
+    }
+
+    sum += share;
+    squares += share * share;
+  }
+
+  if (squares == 0.0) {
+    return None();
+  }
+
+  return (sum * sum) / (frameworks.size() * squares);
+}
+
+
+// This benchmark replays a recording of the allocator (see the
+// --allocator_record_file flag of the master), given with the
+// --allocator_replay_file flag, with the clock paused, i.e., the time
+// between the events passes instantly. It reports how long the
+// allocations took, and samples the fairness and the utilization of
+// the cluster once per allocation interval of the recording.
+//
+// The recorded recoveries (e.g., declined offers) are applied to the
+// resources that the replayed allocator allocated to the framework on
+// the agent, so that a recording can be replayed against other
+// allocators or options (e.g., the allocation interval).
+//
+// NOTE: The frameworks only respond to the offers the way they did in
+// the recording, i.e., the resources are only recovered from a
+// framework on an agent if they were recovered in the recording.
+TEST_F(HierarchicalAllocator_BENCHMARK_Test, Replay)
+{
+  if (tests::flags.allocator_replay_file.isNone()) {
+    cout << "No recording to replay, see --allocator_replay_file" << endl;
+    return;
+  }
+
+  Try<vector<AllocatorEvent>> events =
+    RecordingAllocator::read(tests::flags.allocator_replay_file.get());
+
+  ASSERT_SOME(events);
+
+  cout << "Replaying " << events.get().size() << " events" << endl;
+
+  master::Flags flags;
+
+  Clock::pause();
+
+  // The resources allocated to the frameworks on the agents, i.e.,
+  // offered by the allocator or used when added, and not recovered.
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> offered;
+
+  // NOTE: The offer callback is invoked by the allocator, but only
+  // while the clock is settled after an event.
+  size_t offers = 0;
+
+  auto offerCallback = [&offered, &offers](
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, Resources>& resources) {
+    foreachpair (const SlaveID& slaveId, const Resources& offered_, resources) {
+      offered[frameworkId][slaveId] += offered_;
+    }
+
+    offers++;
+  };
+
+  initialize(flags, offerCallback);
+
+  hashset<FrameworkID> frameworks;
+  hashmap<SlaveID, Resources> agents;
+  hashset<string> quotas;
+
+  size_t recordedOffers = 0;
+
+  Option<double> timestamp = None();
+  Option<double> sampled = None();
+
+  vector<double> utilizations;
+  vector<double> fairnesses;
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const AllocatorEvent& event, events.get()) {
+    if (timestamp.isSome() && event.timestamp() > timestamp.get()) {
+      Try<Duration> elapsed =
+        Duration::create(event.timestamp() - timestamp.get());
+
+      ASSERT_SOME(elapsed);
+
+      Clock::advance(elapsed.get());
+      Clock::settle();
+    }
+
+    if (timestamp.isNone() || event.timestamp() > timestamp.get()) {
+      timestamp = event.timestamp();
+    }
+
+    switch (event.type()) {
+      case AllocatorEvent::ADD_FRAMEWORK: {
+        hashmap<SlaveID, Resources> used;
+
+        foreach (const AllocatorEvent::Allocation& allocation,
+                 event.allocations()) {
+          used[allocation.slave_id()] += allocation.resources();
+          offered[event.framework_id()][allocation.slave_id()] +=
+            allocation.resources();
+        }
+
+        frameworks.insert(event.framework_id());
+        allocator->addFramework(
+            event.framework_id(), event.framework_info(), used);
+        break;
+      }
+
+      case AllocatorEvent::REMOVE_FRAMEWORK:
+        if (frameworks.contains(event.framework_id())) {
+          frameworks.erase(event.framework_id());
+          offered.erase(event.framework_id());
+          allocator->removeFramework(event.framework_id());
+        }
+        break;
+
+      case AllocatorEvent::ACTIVATE_FRAMEWORK:
+        if (frameworks.contains(event.framework_id())) {
+          allocator->activateFramework(event.framework_id());
+        }
+        break;
+
+      case AllocatorEvent::DEACTIVATE_FRAMEWORK:
+        if (frameworks.contains(event.framework_id())) {
+          allocator->deactivateFramework(event.framework_id());
+        }
+        break;
+
+      case AllocatorEvent::UPDATE_FRAMEWORK:
+        if (frameworks.contains(event.framework_id())) {
+          allocator->updateFramework(
+              event.framework_id(), event.framework_info());
+        }
+        break;
+
+      case AllocatorEvent::ADD_SLAVE: {
+        hashmap<FrameworkID, Resources> used;
+
+        foreach (const AllocatorEvent::Allocation& allocation,
+                 event.allocations()) {
+          used[allocation.framework_id()] += allocation.resources();
+          offered[allocation.framework_id()][event.slave_id()] +=
+            allocation.resources();
+        }
+
+        agents[event.slave_id()] = Resources(event.resources()).nonRevocable();
+        allocator->addSlave(
+            event.slave_id(),
+            event.slave_info(),
+            None(),
+            event.resources(),
+            used);
+        break;
+      }
+
+      case AllocatorEvent::REMOVE_SLAVE:
+        if (agents.contains(event.slave_id())) {
+          agents.erase(event.slave_id());
+
+          foreachkey (const FrameworkID& frameworkId, offered) {
+            offered[frameworkId].erase(event.slave_id());
+          }
+
+          allocator->removeSlave(event.slave_id());
+        }
+        break;
+
+      case AllocatorEvent::UPDATE_SLAVE:
+        if (agents.contains(event.slave_id())) {
+          allocator->updateSlave(event.slave_id(), event.resources());
+        }
+        break;
+
+      case AllocatorEvent::ACTIVATE_SLAVE:
+        if (agents.contains(event.slave_id())) {
+          allocator->activateSlave(event.slave_id());
+        }
+        break;
+
+      case AllocatorEvent::DEACTIVATE_SLAVE:
+        if (agents.contains(event.slave_id())) {
+          allocator->deactivateSlave(event.slave_id());
+        }
+        break;
+
+      case AllocatorEvent::RECOVER_RESOURCES: {
+        Option<Filters> filters = None();
+        if (event.has_filters()) {
+          filters = event.filters();
+        }
+
+        foreach (const AllocatorEvent::Allocation& allocation,
+                 event.allocations()) {
+          const FrameworkID& frameworkId = allocation.framework_id();
+          const SlaveID& slaveId = allocation.slave_id();
+
+          if (!offered.contains(frameworkId) ||
+              !offered[frameworkId].contains(slaveId)) {
+            continue;
+          }
+
+          // Recover at most what is allocated in this replay.
+          Resources recovered = allocation.resources();
+          if (!offered[frameworkId][slaveId].contains(recovered)) {
+            recovered = offered[frameworkId][slaveId];
+          }
+
+          offered[frameworkId][slaveId] -= recovered;
+
+          if (offered[frameworkId][slaveId].empty()) {
+            offered[frameworkId].erase(slaveId);
+          }
+
+          allocator->recoverResources(
+              frameworkId, slaveId, recovered, filters);
+        }
+        break;
+      }
+
+      case AllocatorEvent::SUPPRESS_OFFERS:
+        if (frameworks.contains(event.framework_id())) {
+          allocator->suppressOffers(event.framework_id());
+        }
+        break;
+
+      case AllocatorEvent::REVIVE_OFFERS:
+        if (frameworks.contains(event.framework_id())) {
+          allocator->reviveOffers(event.framework_id());
+        }
+        break;
+
+      case AllocatorEvent::SET_QUOTA:
+        if (!quotas.contains(event.role())) {
+          Quota quota;
+          quota.info.set_role(event.role());
+          quota.info.mutable_guarantee()->CopyFrom(event.resources());
+
+          quotas.insert(event.role());
+          allocator->setQuota(event.role(), quota);
+        }
+        break;
+
+      case AllocatorEvent::REMOVE_QUOTA:
+        if (quotas.contains(event.role())) {
+          quotas.erase(event.role());
+          allocator->removeQuota(event.role());
+        }
+        break;
+
+      case AllocatorEvent::OFFER:
+        recordedOffers++;
+        break;
+    }
+
+    // Wait for the allocator, so that the offers are made before
+    // the next event is replayed.
+    Clock::settle();
+
+    if (sampled.isNone() ||
+        timestamp.get() - sampled.get() >= flags.allocation_interval.secs()) {
+      const Resources total = Resources::sum(agents);
+      const Resources used = allocated(offered, agents);
+
+      if (total.cpus().getOrElse(0.0) > 0.0) {
+        utilizations.push_back(
+            used.cpus().getOrElse(0.0) / total.cpus().get());
+      }
+
+      Option<double> index = fairness(frameworks, offered, agents);
+      if (index.isSome()) {
+        fairnesses.push_back(index.get());
+      }
+
+      sampled = timestamp;
+    }
+  }
+
+  cout << "Replayed " << events.get().size() << " events"
+       << " in " << watch.elapsed() << endl;
+
+  cout << "Made " << offers << " offers"
+       << " (" << recordedOffers << " in the recording)" << endl;
+
+  if (!utilizations.empty()) {
+    double sum = 0.0;
+    foreach (double utilization, utilizations) {
+      sum += utilization;
+    }
+
+    cout << "Mean utilization of the cpus: "
+         << sum / utilizations.size() << endl;
+  }
+
+  if (!fairnesses.empty()) {
+    double sum = 0.0;
+    foreach (double fairness, fairnesses) {
+      sum += fairness;
+    }
+
+    cout << "Mean fairness (Jain's index of the dominant shares): "
+         << sum / fairnesses.size() << endl;
+  }
+
+  // NOTE: The allocator keeps the timings of the allocations of the
+  // last hour (of the replay).
+  JSON::Object metrics = Metrics();
+
+  const vector<string> statistics = {"p50", "p99", "max"};
+
+  foreach (const string& statistic, statistics) {
+    cout << "Allocation run time (" << statistic << "): "
+         << metrics.values["allocator/mesos/allocation_run_ms/" + statistic]
+         << "ms" << endl;
+  }
+
+  Clock::resume();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
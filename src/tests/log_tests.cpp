@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 
+#include <iostream>
 #include <list>
 #include <set>
 #include <string>
@@ -23,6 +24,7 @@
 #include <gmock/gmock.h>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -32,6 +34,7 @@
 #include <process/protobuf.hpp>
 #include <process/shared.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
@@ -62,6 +65,8 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
@@ -560,6 +565,60 @@ TEST_F(ReplicaTest, NonVoting)
 }
 
 
+// Measures the write throughput of a replica when many write
+// requests are outstanding at once, which lets the replica commit
+// them to storage together.
+TEST_F(ReplicaTest, BENCHMARK_ConcurrentWrites)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  initializer.execute();
+
+  Replica replica(path);
+
+  const uint64_t proposal = 1;
+
+  PromiseRequest promiseRequest;
+  promiseRequest.set_proposal(proposal);
+
+  Future<PromiseResponse> promiseResponse =
+    protocol::promise(replica.pid(), promiseRequest);
+
+  AWAIT_READY(promiseResponse);
+  ASSERT_TRUE(promiseResponse.get().okay());
+
+  const uint64_t writes = 1000;
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  list<Future<WriteResponse>> writeResponses;
+
+  for (uint64_t position = 1; position <= writes; position++) {
+    WriteRequest writeRequest;
+    writeRequest.set_proposal(proposal);
+    writeRequest.set_position(position);
+    writeRequest.set_type(Action::APPEND);
+    writeRequest.mutable_append()->set_bytes(string(1024, 'x'));
+
+    writeResponses.push_back(protocol::write(replica.pid(), writeRequest));
+  }
+
+  AWAIT_READY_FOR(collect(writeResponses), Minutes(5));
+
+  Duration elapsed = stopwatch.elapsed();
+
+  foreach (const Future<WriteResponse>& writeResponse, writeResponses) {
+    EXPECT_TRUE(writeResponse.get().okay());
+  }
+
+  cout << "Persisted " << writes << " writes in " << elapsed
+       << " (" << writes / elapsed.secs() << " writes / sec)" << endl;
+
+  AWAIT_EXPECT_EQ(writes, replica.ending());
+}
+
+
 class CoordinatorTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1193,6 +1252,64 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // Issue more appends than the coordinator runs concurrently,
+  // without waiting for any of them to finish.
+  list<Future<Option<uint64_t> > > appendings;
+  for (uint64_t position = 1; position <= 100; position++) {
+    appendings.push_back(coord.append(stringify(position)));
+  }
+
+  uint64_t position = 1;
+  foreach (const Future<Option<uint64_t> >& appending, appendings) {
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position++, appending.get());
+  }
+
+  {
+    Future<list<Action> > actions = replica1->read(1, 100);
+    AWAIT_READY(actions);
+    EXPECT_EQ(100u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+
+  {
+    Future<uint64_t> demoting = coord.demote();
+    AWAIT_EXPECT_EQ(100u, demoting);
+  }
+}
+
+
 TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1806,10 +1923,18 @@ TEST_F(RecoverTest, CatchupRetry)
   // promise phase even if replica1 reemerges later.
   DROP_MESSAGE(Eq(PromiseRequest().GetTypeName()), _, Eq(replica1->pid()));
 
+  // Drop the read requests so that the catch-up process has to fill
+  // the positions rather than read them from replica1.
+  DROP_MESSAGES(Eq(ReadRequest().GetTypeName()), _, _);
+
+  Clock::pause();
+
   Future<Nothing> catching =
     catchup(2, replica3, network2, None(), positions, Seconds(10));
 
-  Clock::pause();
+  // Wait for the read requests to time out.
+  Clock::settle();
+  Clock::advance(Seconds(10));
 
   // Wait for the retry timer in 'catchup' to be setup.
   Clock::settle();
@@ -1832,6 +1957,75 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// Verifies that the positions learned by another replica are read in
+// bulk rather than filled one at a time.
+TEST_F(RecoverTest, CatchupRead)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  // Make sure replica2 does not receive learned messages.
+  DROP_MESSAGES(Eq(LearnedMessage().GetTypeName()), _, Eq(replica2->pid()));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 100; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // All the positions are learned by replica1, hence no Paxos round
+  // is needed to catch them up.
+  EXPECT_NO_FUTURE_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<list<Action> > actions = replica3->read(1, 100);
+  AWAIT_READY(actions);
+  ASSERT_EQ(100u, actions.get().size());
+  foreach (const Action& action, actions.get()) {
+    EXPECT_TRUE(action.learned());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
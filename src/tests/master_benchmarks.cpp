@@ -0,0 +1,465 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <mesos/resources.hpp>
+#include <mesos/scheduler.hpp>
+#include <mesos/version.hpp>
+
+#include <process/clock.hpp>
+#include <process/collect.hpp>
+#include <process/delay.hpp>
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+#include <process/process.hpp>
+#include <process/protobuf.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+#include <stout/uuid.hpp>
+
+#include "common/protobuf_utils.hpp"
+
+#include "master/flags.hpp"
+#include "master/master.hpp"
+
+#include "messages/messages.hpp"
+
+#include "tests/mesos.hpp"
+
+using mesos::internal::master::Master;
+
+using process::Clock;
+using process::Future;
+using process::Owned;
+using process::PID;
+using process::Promise;
+using process::Time;
+using process::UPID;
+
+using std::cout;
+using std::endl;
+using std::list;
+using std::string;
+using std::vector;
+
+using testing::WithParamInterface;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+// An agent which speaks the agent protocol to the master but does not
+// run anything: the launched tasks are reported as TASK_RUNNING right
+// away and the killed tasks as TASK_KILLED. Thousands of these can be
+// started in a single process to load a master.
+class FakeSlaveProcess : public ProtobufProcess<FakeSlaveProcess>
+{
+public:
+  FakeSlaveProcess(const UPID& _master, const SlaveInfo& _info)
+    : ProcessBase(process::ID::generate("fake-slave")),
+      master(_master),
+      info(_info) {}
+
+  virtual ~FakeSlaveProcess() {}
+
+  Future<Nothing> registered()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install<SlaveRegisteredMessage>(
+        &FakeSlaveProcess::_registered,
+        &SlaveRegisteredMessage::slave_id);
+
+    install<RunTaskMessage>(
+        &FakeSlaveProcess::runTask);
+
+    install<KillTaskMessage>(
+        &FakeSlaveProcess::killTask,
+        &KillTaskMessage::framework_id,
+        &KillTaskMessage::task_id);
+
+    install<ShutdownFrameworkMessage>(
+        &FakeSlaveProcess::shutdownFramework,
+        &ShutdownFrameworkMessage::framework_id);
+
+    install<PingSlaveMessage>(
+        &FakeSlaveProcess::ping);
+
+    doRegister();
+  }
+
+private:
+  void doRegister()
+  {
+    if (info.has_id()) {
+      return;
+    }
+
+    RegisterSlaveMessage message;
+    message.mutable_slave()->CopyFrom(info);
+    message.set_version(MESOS_VERSION);
+    send(master, message);
+
+    // The master drops the registration while it recovers, retry
+    // until it is registered.
+    process::delay(Seconds(1), self(), &FakeSlaveProcess::doRegister);
+  }
+
+  void _registered(const UPID& from, const SlaveID& slaveId)
+  {
+    if (info.has_id()) {
+      return;
+    }
+
+    info.mutable_id()->CopyFrom(slaveId);
+    promise.set(Nothing());
+  }
+
+  void runTask(const UPID& from, const RunTaskMessage& message)
+  {
+    const FrameworkID& frameworkId = message.framework().id();
+    const TaskID& taskId = message.task().task_id();
+
+    tasks[frameworkId].insert(taskId);
+    update(frameworkId, taskId, TASK_RUNNING);
+  }
+
+  void killTask(
+      const UPID& from,
+      const FrameworkID& frameworkId,
+      const TaskID& taskId)
+  {
+    if (tasks.contains(frameworkId) && tasks[frameworkId].erase(taskId) > 0) {
+      update(frameworkId, taskId, TASK_KILLED);
+    }
+  }
+
+  void shutdownFramework(const UPID& from, const FrameworkID& frameworkId)
+  {
+    tasks.erase(frameworkId);
+  }
+
+  void ping(const UPID& from, const PingSlaveMessage& message)
+  {
+    send(from, PongSlaveMessage());
+  }
+
+  void update(
+      const FrameworkID& frameworkId,
+      const TaskID& taskId,
+      const TaskState& state)
+  {
+    StatusUpdateMessage message;
+    message.mutable_update()->CopyFrom(protobuf::createStatusUpdate(
+        frameworkId,
+        info.id(),
+        taskId,
+        state,
+        TaskStatus::SOURCE_SLAVE,
+        UUID::random()));
+    message.set_pid(self());
+
+    send(master, message);
+  }
+
+  const UPID master;
+  SlaveInfo info;
+  hashmap<FrameworkID, hashset<TaskID>> tasks;
+  Promise<Nothing> promise;
+};
+
+
+// A scheduler which launches a given number of tasks, one per offer
+// using all of its resources, and kills each of them once it is
+// running. It records the offer latency, i.e. the time from the
+// resources of the framework being freed (at registration or when
+// one of its tasks is killed) to its next offer.
+//
+// NOTE: The driver invokes the callbacks serially, and the results
+// are only read once the future returned by 'done' is ready.
+class BenchmarkScheduler : public Scheduler
+{
+public:
+  explicit BenchmarkScheduler(size_t _tasks)
+    : tasks(_tasks), launched(0), killed(0) {}
+
+  virtual ~BenchmarkScheduler() {}
+
+  Future<Nothing> done()
+  {
+    return promise.future();
+  }
+
+  const vector<Duration>& latencies() const
+  {
+    return offerLatencies;
+  }
+
+  virtual void registered(
+      SchedulerDriver* driver,
+      const FrameworkID& frameworkId,
+      const MasterInfo& masterInfo)
+  {
+    waiting = Clock::now();
+  }
+
+  virtual void reregistered(SchedulerDriver*, const MasterInfo&) {}
+
+  virtual void disconnected(SchedulerDriver*) {}
+
+  virtual void resourceOffers(
+      SchedulerDriver* driver,
+      const vector<Offer>& offers)
+  {
+    if (waiting.isSome()) {
+      offerLatencies.push_back(Clock::now() - waiting.get());
+      waiting = None();
+    }
+
+    foreach (const Offer& offer, offers) {
+      if (launched == tasks) {
+        driver->declineOffer(offer.id());
+        continue;
+      }
+
+      TaskInfo task;
+      task.set_name("benchmark");
+      task.mutable_task_id()->set_value(stringify(launched++));
+      task.mutable_slave_id()->CopyFrom(offer.slave_id());
+      task.mutable_resources()->CopyFrom(offer.resources());
+      task.mutable_command()->set_value("exit 0");
+
+      driver->launchTasks(offer.id(), {task});
+    }
+  }
+
+  virtual void offerRescinded(SchedulerDriver*, const OfferID&) {}
+
+  virtual void statusUpdate(SchedulerDriver* driver, const TaskStatus& status)
+  {
+    switch (status.state()) {
+      case TASK_RUNNING:
+        driver->killTask(status.task_id());
+        break;
+      case TASK_KILLED:
+        if (waiting.isNone()) {
+          waiting = Clock::now();
+        }
+
+        if (++killed == tasks) {
+          promise.set(Nothing());
+        }
+        break;
+      default:
+        promise.fail(
+            "Unexpected status update " + stringify(status.state()) +
+            " for task " + stringify(status.task_id()));
+        break;
+    }
+  }
+
+  virtual void frameworkMessage(
+      SchedulerDriver*,
+      const ExecutorID&,
+      const SlaveID&,
+      const string&) {}
+
+  virtual void slaveLost(SchedulerDriver*, const SlaveID&) {}
+
+  virtual void executorLost(
+      SchedulerDriver*,
+      const ExecutorID&,
+      const SlaveID&,
+      int) {}
+
+  virtual void error(SchedulerDriver*, const string& message)
+  {
+    promise.fail(message);
+  }
+
+private:
+  const size_t tasks;
+  size_t launched;
+  size_t killed;
+  Option<Time> waiting;
+  vector<Duration> offerLatencies;
+  Promise<Nothing> promise;
+};
+
+
+class MasterFakeAgents_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
+
+
+// The end-to-end master benchmarks are parameterized by the number
+// of (fake) agents and the number of frameworks.
+INSTANTIATE_TEST_CASE_P(
+    AgentAndFrameworkCount,
+    MasterFakeAgents_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 5000U, 10000U),
+      ::testing::Values(10U, 50U, 100U))
+    );
+
+
+// Runs a real master with fake agents and frameworks which launch
+// and kill tasks, and reports the offer latency, the launch throughput
+// and the CPU and memory used.
+//
+// NOTE: The master shares the process with the fake agents and the
+// scheduler drivers, so the CPU and RSS include theirs. They do
+// little work compared with the master, though.
+TEST_P(MasterFakeAgents_BENCHMARK_Test, LaunchAndKillTasks)
+{
+  const size_t agentCount = std::tr1::get<0>(GetParam());
+  const size_t frameworkCount = std::tr1::get<1>(GetParam());
+  const size_t tasksPerFramework = 100;
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_frameworks = false;
+  masterFlags.authenticate_slaves = false;
+  masterFlags.registry = "in_memory";
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  cout << "Using " << agentCount << " agents and "
+       << frameworkCount << " frameworks" << endl;
+
+  Stopwatch watch;
+  watch.start();
+
+  vector<Owned<FakeSlaveProcess>> agents;
+  list<Future<Nothing>> registered;
+
+  for (size_t i = 0; i < agentCount; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_resources()->CopyFrom(
+        Resources::parse("cpus:8;mem:16384;disk:65536").get());
+
+    agents.push_back(
+        Owned<FakeSlaveProcess>(new FakeSlaveProcess(master.get(), info)));
+
+    process::spawn(agents.back().get());
+    registered.push_back(agents.back()->registered());
+  }
+
+  AWAIT_READY_FOR(process::collect(registered), Minutes(10));
+
+  cout << "Registered the agents in " << watch.elapsed() << endl;
+
+  Result<os::Process> before = os::process(getpid());
+  ASSERT_SOME(before);
+
+  vector<Owned<BenchmarkScheduler>> schedulers;
+  vector<Owned<MesosSchedulerDriver>> drivers;
+  list<Future<Nothing>> done;
+
+  watch.start();
+
+  for (size_t i = 0; i < frameworkCount; i++) {
+    schedulers.push_back(
+        Owned<BenchmarkScheduler>(new BenchmarkScheduler(tasksPerFramework)));
+
+    drivers.push_back(Owned<MesosSchedulerDriver>(new MesosSchedulerDriver(
+        schedulers.back().get(), DEFAULT_FRAMEWORK_INFO, master.get())));
+
+    drivers.back()->start();
+    done.push_back(schedulers.back()->done());
+  }
+
+  AWAIT_READY_FOR(process::collect(done), Minutes(10));
+
+  const Duration elapsed = watch.elapsed();
+
+  Result<os::Process> after = os::process(getpid());
+  ASSERT_SOME(after);
+
+  const size_t taskCount = frameworkCount * tasksPerFramework;
+
+  cout << "Launched and killed " << taskCount << " tasks in " << elapsed
+       << " (" << taskCount / elapsed.secs() << " tasks per second)" << endl;
+
+  vector<Duration> latencies;
+  foreach (const Owned<BenchmarkScheduler>& scheduler, schedulers) {
+    latencies.insert(
+        latencies.end(),
+        scheduler->latencies().begin(),
+        scheduler->latencies().end());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  if (!latencies.empty()) {
+    cout << "Offer latency: median " << latencies[latencies.size() / 2]
+         << ", 99th percentile " << latencies[latencies.size() * 99 / 100]
+         << ", max " << latencies.back()
+         << " (over " << latencies.size() << " offers)" << endl;
+  }
+
+  if (before.get().utime.isSome() && before.get().stime.isSome() &&
+      after.get().utime.isSome() && after.get().stime.isSome()) {
+    const Duration cpu =
+      (after.get().utime.get() + after.get().stime.get()) -
+      (before.get().utime.get() + before.get().stime.get());
+
+    cout << "Used " << cpu << " of CPU ("
+         << cpu.secs() / elapsed.secs() << " cores)" << endl;
+  }
+
+  if (after.get().rss.isSome()) {
+    cout << "RSS: " << after.get().rss.get() << endl;
+  }
+
+  foreach (const Owned<MesosSchedulerDriver>& driver, drivers) {
+    driver->stop();
+    driver->join();
+  }
+
+  foreach (const Owned<FakeSlaveProcess>& agent, agents) {
+    process::terminate(agent.get());
+    process::wait(agent.get());
+  }
+
+  Shutdown();
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
@@ -267,6 +267,67 @@ TEST_F(ZooKeeperMasterContenderDetectorTest, MasterContender)
 }
 
 
+// Verifies that the detectors of the same ZooKeeper URL (which share
+// their detection) all detect the leader, and keep detecting it when
+// one of them is destroyed.
+TEST_F(ZooKeeperMasterContenderDetectorTest, MasterDetectorsShared)
+{
+  Try<zookeeper::URL> url = zookeeper::URL::parse(
+      "zk://" + server->connectString() + "/mesos");
+
+  ASSERT_SOME(url);
+
+  Owned<zookeeper::Group> group(
+      new Group(url.get(), MASTER_CONTENDER_ZK_SESSION_TIMEOUT));
+
+  ZooKeeperMasterContender contender(group);
+
+  PID<Master> pid;
+  pid.address.ip = net::IP(10000000);
+  pid.address.port = 10000;
+
+  MasterInfo master = internal::protobuf::createMasterInfo(pid);
+
+  contender.initialize(master);
+  Future<Future<Nothing> > contended = contender.contend();
+  AWAIT_READY(contended);
+
+  Owned<ZooKeeperMasterDetector> detector1(
+      new ZooKeeperMasterDetector(url.get()));
+
+  ZooKeeperMasterDetector detector2(url.get());
+
+  Future<Option<MasterInfo> > leader1 = detector1->detect();
+  Future<Option<MasterInfo> > leader2 = detector2.detect();
+
+  AWAIT_READY(leader1);
+  EXPECT_SOME_EQ(master, leader1.get());
+
+  AWAIT_READY(leader2);
+  EXPECT_SOME_EQ(master, leader2.get());
+
+  leader1 = detector1->detect(leader1.get());
+  leader2 = detector2.detect(leader2.get());
+
+  // Destroying a detector only discards its own detection.
+  detector1.reset();
+
+  AWAIT_DISCARDED(leader1);
+  ASSERT_TRUE(leader2.isPending());
+
+  // The leader is lost once the session of the contender expires.
+  Future<Nothing> lostCandidacy = contended.get();
+
+  Future<Option<int64_t> > sessionId = group.get()->session();
+  AWAIT_READY(sessionId);
+  server->expireSession(sessionId.get().get());
+
+  AWAIT_READY(lostCandidacy);
+  AWAIT_READY(leader2);
+  EXPECT_NONE(leader2.get());
+}
+
+
 // Verifies that contender does not recontend if the current election
 // is still pending.
 TEST_F(ZooKeeperMasterContenderDetectorTest, ContenderPendingElection)
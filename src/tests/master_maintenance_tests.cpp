@@ -493,6 +493,124 @@ TEST_F(MasterMaintenanceTest, PendingUnavailabilityTest)
 }
 
 
+// Updates the maintenance schedule without changing the unavailability
+// of the scheduled slave, and ensures that its offers and inverse
+// offers are not rescinded.
+TEST_F(MasterMaintenanceTest, UnchangedUnavailability)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave>> slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  Callbacks callbacks;
+
+  Future<Nothing> connected;
+  EXPECT_CALL(callbacks, connected())
+    .WillOnce(FutureSatisfy(&connected));
+
+  Mesos mesos(
+      master.get(),
+      ContentType::PROTOBUF,
+      lambda::bind(&Callbacks::connected, lambda::ref(callbacks)),
+      lambda::bind(&Callbacks::disconnected, lambda::ref(callbacks)),
+      lambda::bind(&Callbacks::received, lambda::ref(callbacks), lambda::_1));
+
+  AWAIT_READY(connected);
+
+  Queue<Event> events;
+
+  EXPECT_CALL(callbacks, received(_))
+    .WillRepeatedly(Enqueue(&events));
+
+  {
+    Call call;
+    call.set_type(Call::SUBSCRIBE);
+
+    Call::Subscribe* subscribe = call.mutable_subscribe();
+    subscribe->mutable_framework_info()->CopyFrom(DEFAULT_V1_FRAMEWORK_INFO);
+
+    mesos.send(call);
+  }
+
+  Future<Event> event = events.get();
+  AWAIT_READY(event);
+  EXPECT_EQ(Event::SUBSCRIBED, event.get().type());
+
+  event = events.get();
+  AWAIT_READY(event);
+  EXPECT_EQ(Event::OFFERS, event.get().type());
+  const size_t numberOfOffers = event.get().offers().offers().size();
+
+  // Schedule this slave for maintenance.
+  MachineID machine;
+  machine.set_hostname(maintenanceHostname);
+  machine.set_ip(stringify(slave.get().address.ip));
+
+  const Unavailability unavailability =
+    createUnavailability(Clock::now() + Seconds(60), Seconds(120));
+
+  maintenance::Schedule schedule = createSchedule(
+      {createWindow({machine}, unavailability)});
+
+  Future<Response> response = process::http::post(
+      master.get(),
+      "maintenance/schedule",
+      headers,
+      stringify(JSON::protobuf(schedule)));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  for (size_t offerNumber = 0; offerNumber < numberOfOffers; ++offerNumber) {
+    event = events.get();
+    AWAIT_READY(event);
+    EXPECT_EQ(Event::RESCIND, event.get().type());
+  }
+
+  event = events.get();
+  AWAIT_READY(event);
+  EXPECT_EQ(Event::OFFERS, event.get().type());
+  EXPECT_NE(0, event.get().offers().offers().size());
+
+  event = events.get();
+  AWAIT_READY(event);
+  EXPECT_EQ(Event::OFFERS, event.get().type());
+  EXPECT_NE(0, event.get().offers().inverse_offers().size());
+
+  // Add a window for another machine, the window of the slave is
+  // unchanged.
+  schedule = createSchedule({
+      createWindow({machine}, unavailability),
+      createWindow({machine1}, createUnavailability(Clock::now()))});
+
+  response = process::http::post(
+      master.get(),
+      "maintenance/schedule",
+      headers,
+      stringify(JSON::protobuf(schedule)));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  // Neither the offers nor the inverse offers of the slave should be
+  // rescinded (or sent again).
+  Clock::pause();
+  Clock::settle();
+
+  event = events.get();
+  EXPECT_TRUE(event.isPending());
+
+  Clock::resume();
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 // Test ensures that old schedulers gracefully handle inverse offers, even if
 // they aren't passed up to the top level API yet.
 TEST_F(MasterMaintenanceTest, PreV1SchedulerSupport)
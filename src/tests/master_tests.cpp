@@ -16,6 +16,8 @@
 
 #include <unistd.h>
 
+#include <iostream>
+#include <list>
 #include <memory>
 #include <string>
 #include <vector>
@@ -30,6 +32,7 @@
 #include <mesos/scheduler/scheduler.hpp>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/http.hpp>
@@ -42,11 +45,13 @@
 #include <stout/net.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "common/build.hpp"
 #include "common/protobuf_utils.hpp"
+#include "common/recordio.hpp"
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
@@ -71,6 +76,8 @@ using mesos::internal::master::allocator::MesosAllocatorProcess;
 
 using mesos::internal::protobuf::createLabel;
 
+using mesos::internal::recordio::Reader;
+
 using mesos::internal::slave::GarbageCollectorProcess;
 using mesos::internal::slave::Slave;
 using mesos::internal::slave::Containerizer;
@@ -81,9 +88,16 @@ using process::Future;
 using process::PID;
 using process::Promise;
 
+using process::http::BadRequest;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
 
+using recordio::Decoder;
+
+using std::cout;
+using std::endl;
+using std::list;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -92,9 +106,11 @@ using testing::_;
 using testing::AtMost;
 using testing::DoAll;
 using testing::Eq;
+using testing::InvokeWithoutArgs;
 using testing::Not;
 using testing::Return;
 using testing::SaveArg;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -190,6 +206,87 @@ TEST_F(MasterTest, TaskRunning)
 }
 
 
+// This test ensures that the tasks launched on a slave by one accept
+// call are sent to the slave in one 'RunTasksMessage'.
+TEST_F(MasterTest, LaunchTaskBatch)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.resources = "cpus:2;mem:1024";
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  vector<TaskInfo> tasks;
+  for (int i = 1; i <= 2; i++) {
+    TaskInfo task;
+    task.set_name("");
+    task.mutable_task_id()->set_value(stringify(i));
+    task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+    task.mutable_resources()->MergeFrom(
+        Resources::parse("cpus:1;mem:512").get());
+    task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+    tasks.push_back(task);
+  }
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<RunTasksMessage> runTasksMessage =
+    FUTURE_PROTOBUF(RunTasksMessage(), master.get(), slave.get());
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(runTasksMessage);
+  EXPECT_EQ(2, runTasksMessage.get().tasks().size());
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2.get().state());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 // This test ensures that stopping a scheduler driver triggers
 // executor's shutdown callback and all still running tasks are
 // marked as killed.
@@ -1592,6 +1689,12 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
       "master/invalid_status_update_acknowledgements"));
 
   EXPECT_EQ(1u, snapshot.values.count("master/recovery_slave_removals"));
+  EXPECT_EQ(1u, snapshot.values.count("master/recovery_slaves_pending"));
+  EXPECT_EQ(1u, snapshot.values.count("master/slaves_reregistering"));
+  EXPECT_EQ(1u, snapshot.values.count(
+      "master/slave_reregistrations_deferred"));
+
+  EXPECT_EQ(1u, snapshot.values.count("master/authentications_deferred"));
 
   EXPECT_EQ(1u, snapshot.values.count("master/event_queue_messages"));
   EXPECT_EQ(1u, snapshot.values.count("master/event_queue_dispatches"));
@@ -1618,6 +1721,12 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
 
   // Allocator Metrics.
   EXPECT_EQ(1u, snapshot.values.count("allocator/event_queue_dispatches"));
+  EXPECT_EQ(1u, snapshot.values.count("allocator/mesos/allocation_runs"));
+  EXPECT_EQ(1u, snapshot.values.count(
+      "allocator/mesos/allocation_run_sort_ms"));
+  EXPECT_EQ(1u, snapshot.values.count("allocator/mesos/slaves_visited"));
+  EXPECT_EQ(1u, snapshot.values.count("allocator/mesos/offers"));
+  EXPECT_EQ(1u, snapshot.values.count("allocator/mesos/offers_filtered"));
 
   Shutdown();
 }
@@ -1696,6 +1805,47 @@ TEST_F(MasterTest, SlavesEndpointTwoSlaves)
 }
 
 
+// Ensures that /master/slaves is streamed with chunked encoding
+// and is wrapped into a call to the 'jsonp' function if one is given.
+TEST_F(MasterTest, SlavesEndpointStreamed)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Future<Response> response =
+    process::http::get(master.get(), "slaves", "jsonp=callback");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("chunked", "Transfer-Encoding", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("text/javascript", "Content-Type", response);
+
+  string body = response.get().body;
+  ASSERT_TRUE(strings::startsWith(body, "callback("));
+  ASSERT_TRUE(strings::endsWith(body, ");"));
+
+  body = strings::remove(body, "callback(", strings::PREFIX);
+  body = strings::remove(body, ");", strings::SUFFIX);
+
+  const Try<JSON::Object> parse = JSON::parse<JSON::Object>(body);
+
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> array = parse.get().find<JSON::Array>("slaves");
+  ASSERT_SOME(array);
+  EXPECT_EQ(1u, array.get().values.size());
+
+  Shutdown();
+}
+
+
 // This test ensures that when a slave is recovered from the registry
 // but does not re-register with the master, it is removed from the
 // registry and the framework is informed that the slave is lost, and
@@ -2432,6 +2582,53 @@ TEST_F(MasterTest, IgnoreEphemeralPortsResource)
 }
 
 
+// This test verifies that the master compresses the offers to a
+// framework with the COMPRESSED_OFFERS capability and that the
+// driver decompresses them.
+TEST_F(MasterTest, CompressedOffers)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.add_capabilities()->set_type(
+      FrameworkInfo::Capability::COMPRESSED_OFFERS);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, frameworkInfo, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<ResourceOffersMessage> message =
+    FUTURE_PROTOBUF(ResourceOffersMessage(), _, _);
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers));
+
+  driver.start();
+
+  AWAIT_READY(message);
+  EXPECT_EQ(0, message.get().offers_size());
+  EXPECT_TRUE(message.get().has_compressed_offers());
+  EXPECT_EQ(1, message.get().pids_size());
+
+  AWAIT_READY(offers);
+  ASSERT_EQ(1u, offers.get().size());
+
+  EXPECT_FALSE(Resources(offers.get()[0].resources()).empty());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 #ifdef WITH_NETWORK_ISOLATOR
 TEST_F(MasterTest, MaxExecutorsPerSlave)
 {
@@ -2957,6 +3154,17 @@ TEST_F(MasterTest, StateSummaryEndpoint)
   AWAIT_READY(status);
   EXPECT_EQ(TASK_RUNNING, status.get().state());
 
+  // The task is counted as running until it is killed.
+  const string frameworkPrefix =
+    "master/frameworks/" + stringify(offers.get()[0].framework_id());
+  const string slavePrefix =
+    "master/slaves/" + stringify(offers.get()[0].slave_id());
+
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(1u, stats.values["master/tasks_running"]);
+  EXPECT_EQ(1u, stats.values[frameworkPrefix + "/tasks_running"]);
+  EXPECT_EQ(1u, stats.values[slavePrefix + "/tasks_running"]);
+
   EXPECT_CALL(exec, killTask(_, _))
     .WillOnce(SendStatusUpdateFromTaskID(TASK_KILLED));
 
@@ -2968,6 +3176,11 @@ TEST_F(MasterTest, StateSummaryEndpoint)
   AWAIT_READY(status);
   EXPECT_EQ(TASK_KILLED, status.get().state());
 
+  stats = Metrics();
+  EXPECT_EQ(0u, stats.values["master/tasks_running"]);
+  EXPECT_EQ(0u, stats.values[frameworkPrefix + "/tasks_running"]);
+  EXPECT_EQ(0u, stats.values[slavePrefix + "/tasks_running"]);
+
   EXPECT_CALL(exec, shutdown(_))
     .Times(AtMost(1));
 
@@ -3444,6 +3657,240 @@ TEST_F(MasterTest, SlaveActiveEndpoint)
 }
 
 
+// This tests that the master's state endpoint responds with
+// 'Not Modified' to requests carrying the 'ETag' of the current state
+// in 'If-None-Match', and that the state (and its 'ETag') changes
+// once a slave changes.
+TEST_F(MasterTest, StateEndpointNotModified)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<process::Message> slaveRegisteredMessage =
+    FUTURE_MESSAGE(Eq(SlaveRegisteredMessage().GetTypeName()), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Future<Response> response = process::http::get(master.get(), "state");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_TRUE(response.get().headers.contains("ETag"));
+
+  const string tag = response.get().headers.get("ETag").get();
+
+  process::http::Headers headers;
+  headers["If-None-Match"] = tag;
+
+  response = process::http::get(master.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::NotModified().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(tag, "ETag", response);
+  EXPECT_TRUE(response.get().body.empty());
+
+  Future<Nothing> deactivateSlave =
+    FUTURE_DISPATCH(_, &MesosAllocatorProcess::deactivateSlave);
+
+  // Inject a slave exited event at the master causing the master
+  // to mark the slave as disconnected.
+  process::inject::exited(slaveRegisteredMessage.get().to, master.get());
+
+  AWAIT_READY(deactivateSlave);
+
+  response = process::http::get(master.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_TRUE(response.get().headers.contains("ETag"));
+  EXPECT_NE(tag, response.get().headers.get("ETag").get());
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Boolean> status = parse.get().find<JSON::Boolean>(
+      "slaves[0].active");
+
+  ASSERT_SOME_EQ(JSON::Boolean(false), status);
+
+  Shutdown();
+}
+
+
+// This tests that the tasks endpoint of the master filters tasks by
+// state and framework and only includes the requested fields.
+TEST_F(MasterTest, TasksEndpointFilters)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "sleep 100", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  Future<Response> response = process::http::get(
+      master.get(),
+      "tasks",
+      "state=TASK_RUNNING&framework_id=" + frameworkId.get().value() +
+      "&fields=id,state");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> tasks = parse.get().find<JSON::Array>("tasks");
+  ASSERT_SOME(tasks);
+  ASSERT_EQ(1u, tasks.get().values.size());
+
+  JSON::Object object = tasks.get().values[0].as<JSON::Object>();
+  EXPECT_EQ(2u, object.values.size());
+  EXPECT_SOME_EQ(
+      JSON::String(task.task_id().value()),
+      object.find<JSON::String>("id"));
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_RUNNING"),
+      object.find<JSON::String>("state"));
+
+  // No tasks are finished.
+  response = process::http::get(master.get(), "tasks", "state=TASK_FINISHED");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  tasks = parse.get().find<JSON::Array>("tasks");
+  ASSERT_SOME(tasks);
+  EXPECT_TRUE(tasks.get().values.empty());
+
+  // An unknown framework has no tasks.
+  response = process::http::get(master.get(), "tasks", "framework_id=1234");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  tasks = parse.get().find<JSON::Array>("tasks");
+  ASSERT_SOME(tasks);
+  EXPECT_TRUE(tasks.get().values.empty());
+
+  // An invalid task state is rejected.
+  response = process::http::get(master.get(), "tasks", "state=TASK_SLEEPING");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// This tests that the events endpoint of the master streams a
+// snapshot of the state followed by the changes to it.
+TEST_F(MasterTest, EventsEndpoint)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<Response> response =
+    process::http::streaming::get(master.get(), "events");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(APPLICATION_JSON, "Content-Type", response);
+  ASSERT_EQ(Response::PIPE, response.get().type);
+
+  Option<Pipe::Reader> reader = response.get().reader;
+  ASSERT_SOME(reader);
+
+  Reader<JSON::Object> decoder(
+      Decoder<JSON::Object>([](const string& data) {
+        return JSON::parse<JSON::Object>(data);
+      }),
+      reader.get());
+
+  Future<Result<JSON::Object>> event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("SNAPSHOT"),
+      event.get().get().find<JSON::String>("type"));
+
+  Result<JSON::Array> slaves =
+    event.get().get().find<JSON::Array>("state.slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_TRUE(slaves.get().values.empty());
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("SLAVE_ADDED"),
+      event.get().get().find<JSON::String>("type"));
+  EXPECT_SOME_EQ(
+      JSON::String(slaveRegisteredMessage.get().slave_id().value()),
+      event.get().get().find<JSON::String>("slave.id"));
+
+  reader.get().close();
+
+  Shutdown();
+}
+
+
 // This test verifies that service info for tasks is exposed over the
 // master's state endpoint.
 TEST_F(MasterTest, TaskDiscoveryInfo)
@@ -4088,6 +4535,277 @@ TEST_F(MasterTest, MaxCompletedTasksPerFrameworkFlag)
   }
 }
 
+
+// This test verifies that the completed tasks which are evicted from
+// memory are kept in '--completed_tasks_dir' and that '/tasks' still
+// finds them by framework and task ID.
+TEST_F(MasterTest, CompletedTasksDir)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.max_completed_tasks_per_framework = 0;
+  masterFlags.completed_tasks_dir = path::join(os::getcwd(), "tasks");
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  Try<PID<Slave>> slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return());
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers);
+  ASSERT_NE(0u, offers->size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_FINISHED));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  // The master removes the task once its update is acknowledged,
+  // before forwarding the acknowledgement to the slave.
+  Future<StatusUpdateAcknowledgementMessage> acknowledgement =
+    FUTURE_PROTOBUF(
+        StatusUpdateAcknowledgementMessage(), master.get(), slave.get());
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_FINISHED, status->state());
+
+  AWAIT_READY(acknowledgement);
+
+  Future<process::http::Response> response = process::http::get(
+      master.get(),
+      "tasks",
+      "framework_id=" + frameworkId->value() +
+      "&task_id=" + task.task_id().value());
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> tasks = parse->find<JSON::Array>("tasks");
+  ASSERT_SOME(tasks);
+  ASSERT_EQ(1u, tasks->values.size());
+
+  JSON::Object object = tasks->values[0].as<JSON::Object>();
+  EXPECT_SOME_EQ(
+      JSON::String(task.task_id().value()),
+      object.find<JSON::String>("id"));
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_FINISHED"),
+      object.find<JSON::String>("state"));
+
+  // Without the task ID, only the tasks in memory are listed.
+  response = process::http::get(
+      master.get(),
+      "tasks",
+      "framework_id=" + frameworkId->value());
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  tasks = parse->find<JSON::Array>("tasks");
+  ASSERT_SOME(tasks);
+  EXPECT_TRUE(tasks->values.empty());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies that the master periodically exports the agents
+// to '--state_export_dir'.
+TEST_F(MasterTest, StateExportDir)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.state_export_dir = path::join(os::getcwd(), "export");
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Clock::pause();
+  Clock::advance(masterFlags.state_export_interval);
+  Clock::settle();
+
+  Try<string> snapshot =
+    os::read(path::join(masterFlags.state_export_dir.get(), "snapshot.tsv"));
+  ASSERT_SOME(snapshot);
+  EXPECT_TRUE(strings::startsWith(snapshot.get(), "version\ttimestamp\n1\t"));
+
+  Try<string> agents =
+    os::read(path::join(masterFlags.state_export_dir.get(), "agents.tsv"));
+  ASSERT_SOME(agents);
+
+  vector<string> lines = strings::split(agents.get(), "\n");
+  ASSERT_EQ(3u, lines.size());
+  EXPECT_TRUE(strings::startsWith(lines[0], "agent_id\thostname\t"));
+  EXPECT_TRUE(strings::startsWith(
+      lines[1], slaveRegisteredMessage->slave_id().value() + "\t"));
+  EXPECT_EQ("", lines[2]);
+
+  Shutdown();
+}
+
+
+class MasterStateEndpoint_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The '/state' benchmark tests are parameterized by the number of
+// running tasks.
+INSTANTIATE_TEST_CASE_P(
+    TaskCount,
+    MasterStateEndpoint_BENCHMARK_Test,
+    ::testing::Values(1000U, 10000U));
+
+
+// Measures how long it takes the master to make an offer (after the
+// framework revived offers) while it is flooded with '/state' requests.
+TEST_P(MasterStateEndpoint_BENCHMARK_Test, OfferLatency)
+{
+  const size_t taskCount = GetParam();
+  const size_t iterations = 10;
+  const size_t requests = 20;
+
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  // Leave room for one more task, which is what is offered below.
+  slave::Flags flags = CreateSlaveFlags();
+  flags.resources = "cpus:" + stringify(taskCount + 1) +
+                    ";mem:" + stringify(taskCount + 1);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers));
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_EQ(1u, offers.get().size());
+
+  vector<TaskInfo> tasks;
+  for (size_t i = 0; i < taskCount; i++) {
+    tasks.push_back(createTask(
+        offers.get()[0].slave_id(),
+        Resources::parse("cpus:1;mem:1").get(),
+        "",
+        DEFAULT_EXECUTOR_ID));
+  }
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  // The scheduler driver invokes the callbacks serially.
+  size_t updates = 0;
+  Promise<Nothing> running;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillRepeatedly(InvokeWithoutArgs([&]() {
+      if (++updates == taskCount) {
+        running.set(Nothing());
+      }
+    }));
+
+  // Only offer the remaining resources when the framework revives.
+  Filters filters;
+  filters.set_refuse_seconds(Weeks(1).secs());
+
+  driver.launchTasks(offers.get()[0].id(), tasks, filters);
+
+  AWAIT_READY_FOR(running.future(), Minutes(5));
+
+  Duration total = Duration::zero();
+
+  for (size_t i = 0; i < iterations; i++) {
+    EXPECT_CALL(sched, resourceOffers(&driver, _))
+      .WillOnce(FutureArg<1>(&offers));
+
+    list<Future<Response>> responses;
+    for (size_t j = 0; j < requests; j++) {
+      responses.push_back(process::http::get(master.get(), "state"));
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    driver.reviveOffers();
+
+    AWAIT_READY_FOR(offers, Minutes(1));
+    total += watch.elapsed();
+
+    ASSERT_EQ(1u, offers.get().size());
+    driver.declineOffer(offers.get()[0].id(), filters);
+
+    AWAIT_READY_FOR(process::collect(responses), Minutes(5));
+  }
+
+  cout << "Made an offer in " << total / iterations << " on average while "
+       << "serving " << requests << " '/state' requests with " << taskCount
+       << " tasks" << endl;
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -484,6 +484,46 @@ TEST_F(CreateOperationValidationTest, DuplicatedPersistenceID)
 }
 
 
+// This test verifies that the parent of a persistent volume must be
+// an existing persistent volume of the same role on the same disk.
+TEST_F(CreateOperationValidationTest, PersistenceParent)
+{
+  Resource parent = Resources::parse("disk", "128", "role1").get();
+  parent.mutable_disk()->CopyFrom(createDiskInfo("id1", "path1"));
+
+  Resource volume = Resources::parse("disk", "64", "role1").get();
+  volume.mutable_disk()->CopyFrom(createDiskInfo("id2", "path2"));
+  volume.mutable_disk()->mutable_persistence()->set_parent("id1");
+
+  Offer::Operation::Create create;
+  create.add_volumes()->CopyFrom(volume);
+
+  EXPECT_NONE(operation::validate(create, parent));
+
+  // The parent does not exist.
+  EXPECT_SOME(operation::validate(create, Resources()));
+
+  // The parent is of another role.
+  Resource other = Resources::parse("disk", "128", "role2").get();
+  other.mutable_disk()->CopyFrom(createDiskInfo("id1", "path1"));
+
+  EXPECT_SOME(operation::validate(create, other));
+
+  // The parent is on another disk.
+  Resource path = Resources::parse("disk", "128", "role1").get();
+  path.mutable_disk()->CopyFrom(createDiskInfo(
+      "id1", "path1", None(), None(), createDiskSourcePath("/mnt/data")));
+
+  EXPECT_SOME(operation::validate(create, path));
+
+  // A volume can not be its own parent.
+  create.mutable_volumes(0)->mutable_disk()->mutable_persistence()
+    ->set_parent("id2");
+
+  EXPECT_SOME(operation::validate(create, parent));
+}
+
+
 // This test verifies that creating a persistent volume that is larger
 // than the offered disk resource results won't succeed.
 TEST_F(CreateOperationValidationTest, InsufficientDiskResource)
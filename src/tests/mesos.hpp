@@ -1332,6 +1332,10 @@ public:
       authorize, process::Future<bool>(const ACL::SetQuota& request));
   MOCK_METHOD1(
       authorize, process::Future<bool>(const ACL::RemoveQuota& request));
+
+  // Batches are authorized request by request (see `Authorizer`), so
+  // that the expectations on the requests above apply to them too.
+  using Authorizer::authorize;
 };
 
 
@@ -121,6 +121,12 @@ TEST_F(MetricsTest, Master)
       "master/invalid_status_update_acknowledgements"));
 
   EXPECT_EQ(1u, stats.values.count("master/recovery_slave_removals"));
+  EXPECT_EQ(1u, stats.values.count("master/recovery_slaves_pending"));
+  EXPECT_EQ(1u, stats.values.count("master/slaves_reregistering"));
+  EXPECT_EQ(1u, stats.values.count(
+      "master/slave_reregistrations_deferred"));
+
+  EXPECT_EQ(1u, stats.values.count("master/authentications_deferred"));
 
   EXPECT_EQ(1u, stats.values.count("master/event_queue_messages"));
   EXPECT_EQ(1u, stats.values.count("master/event_queue_dispatches"));
@@ -33,8 +33,11 @@
 #include <stout/json.hpp>
 #include <stout/nothing.hpp>
 
+#include <stout/tests/utils.hpp>
+
 #include "slave/constants.hpp"
 #include "slave/monitor.hpp"
+#include "slave/statistics_feed.hpp"
 
 #include "tests/mesos.hpp"
 
@@ -44,6 +47,7 @@ using mesos::internal::master::Master;
 
 using mesos::internal::slave::ResourceMonitor;
 using mesos::internal::slave::Slave;
+using mesos::internal::slave::StatisticsFeed;
 
 using std::numeric_limits;
 using std::string;
@@ -170,6 +174,106 @@ TEST(MonitorTest, MissingStatistics)
 }
 
 
+// This test verifies that the requests to the statistics endpoint
+// within the sampling interval share a single resource usage
+// collection.
+TEST(MonitorTest, CachedStatistics)
+{
+  int collections = 0;
+
+  ResourceMonitor monitor(
+      [&collections]() -> Future<ResourceUsage> {
+        collections++;
+        return ResourceUsage();
+      },
+      None(),
+      Seconds(10));
+
+  UPID upid("monitor", process::address());
+
+  Clock::pause();
+
+  Future<http::Response> response = http::get(upid, "statistics");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  // Let the rate limiter of the endpoint hand out the next permit.
+  Clock::advance(Seconds(1));
+
+  response = http::get(upid, "statistics");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  EXPECT_EQ(1, collections);
+
+  // Once the interval has elapsed, the resource usage is collected
+  // again.
+  Clock::advance(Seconds(10));
+
+  response = http::get(upid, "statistics");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  EXPECT_EQ(2, collections);
+
+  Clock::resume();
+}
+
+
+class StatisticsFeedTest : public TemporaryDirectoryTest {};
+
+
+// This test verifies that the records written into the statistics
+// feed are read back in order, and that the records which have been
+// overwritten are skipped.
+TEST_F(StatisticsFeedTest, ReadWrite)
+{
+  Try<process::Owned<StatisticsFeed>> writer =
+    StatisticsFeed::create("statistics", 2);
+
+  ASSERT_SOME(writer);
+
+  Try<process::Owned<StatisticsFeed>> reader =
+    StatisticsFeed::open("statistics");
+
+  ASSERT_SOME(reader);
+
+  uint64_t position = 0;
+  EXPECT_TRUE(reader.get()->read(&position).empty());
+  EXPECT_EQ(0u, position);
+
+  vector<ResourceUsage::Executor> records;
+
+  for (int i = 0; i < 3; i++) {
+    ResourceUsage::Executor record;
+    record.mutable_executor_info()->mutable_executor_id()->set_value(
+        "executor" + stringify(i));
+    record.mutable_executor_info()->mutable_command();
+    record.mutable_container_id()->set_value("container" + stringify(i));
+    record.mutable_statistics()->set_timestamp(i);
+    record.mutable_statistics()->set_mem_rss_bytes(1024 * i);
+
+    ASSERT_SOME(writer.get()->write(record));
+
+    records.push_back(record);
+  }
+
+  // The first record has been overwritten.
+  vector<ResourceUsage::Executor> read = reader.get()->read(&position);
+  EXPECT_EQ(3u, position);
+  ASSERT_EQ(2u, read.size());
+  EXPECT_EQ(records[1].SerializeAsString(), read[0].SerializeAsString());
+  EXPECT_EQ(records[2].SerializeAsString(), read[1].SerializeAsString());
+
+  EXPECT_TRUE(reader.get()->read(&position).empty());
+
+  // A record which does not fit into a slot is not written.
+  ResourceUsage::Executor record = records[0];
+  record.mutable_executor_info()->set_name(
+      string(StatisticsFeed::SLOT_SIZE, 'x'));
+
+  EXPECT_ERROR(writer.get()->write(record));
+  EXPECT_EQ(3u, reader.get()->position());
+}
+
+
 class MonitorIntegrationTest : public MesosTest {};
 
 
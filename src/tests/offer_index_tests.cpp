@@ -0,0 +1,249 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mesos/attributes.hpp>
+#include <mesos/offers.hpp>
+#include <mesos/resources.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+using testing::WithParamInterface;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+static Offer createOffer(
+    const string& id,
+    const string& resources,
+    const string& attributes = "")
+{
+  Offer offer;
+  offer.mutable_id()->set_value(id);
+  offer.mutable_framework_id()->set_value("framework");
+  offer.mutable_slave_id()->set_value("slave-" + id);
+  offer.set_hostname("host-" + id);
+  offer.mutable_resources()->CopyFrom(Resources::parse(resources).get());
+  offer.mutable_attributes()->CopyFrom(Attributes::parse(attributes));
+
+  return offer;
+}
+
+
+TEST(OfferIndexTest, BinPacking)
+{
+  OfferIndex index(OfferIndex::BIN_PACKING);
+
+  index.add(createOffer("o1", "cpus:8;mem:8192"));
+  index.add(createOffer("o2", "cpus:2;mem:512"));
+  index.add(createOffer("o3", "cpus:4;mem:4096"));
+
+  EXPECT_EQ(3u, index.size());
+
+  // The offer with the fewest CPUs which fits the task wins, even if
+  // another offer has fewer CPUs but not enough memory.
+  Option<Offer> offer = index.match(Resources::parse("cpus:1;mem:1024").get());
+  ASSERT_SOME(offer);
+  EXPECT_EQ("o3", offer.get().id().value());
+
+  offer = index.match(Resources::parse("cpus:1;mem:256").get());
+  ASSERT_SOME(offer);
+  EXPECT_EQ("o2", offer.get().id().value());
+
+  EXPECT_NONE(index.match(Resources::parse("cpus:16").get()));
+}
+
+
+TEST(OfferIndexTest, Spread)
+{
+  OfferIndex index(OfferIndex::SPREAD);
+
+  index.add(createOffer("o1", "cpus:8;mem:512"));
+  index.add(createOffer("o2", "cpus:2;mem:512"));
+  index.add(createOffer("o3", "cpus:4;mem:4096"));
+
+  Option<Offer> offer = index.match(Resources::parse("cpus:1;mem:256").get());
+  ASSERT_SOME(offer);
+  EXPECT_EQ("o1", offer.get().id().value());
+
+  offer = index.match(Resources::parse("cpus:1;mem:1024").get());
+  ASSERT_SOME(offer);
+  EXPECT_EQ("o3", offer.get().id().value());
+
+  index.remove(offer.get().id());
+  EXPECT_EQ(2u, index.size());
+  EXPECT_NONE(index.match(Resources::parse("cpus:1;mem:1024").get()));
+}
+
+
+TEST(OfferIndexTest, Attributes)
+{
+  OfferIndex index;
+
+  index.add(createOffer("o1", "cpus:2;mem:512", "rack:r1;zone:z1"));
+  index.add(createOffer("o2", "cpus:4;mem:512", "rack:r2;zone:z1"));
+  index.add(createOffer("o3", "cpus:1;mem:512", "rack:r3;zone:z2"));
+
+  const Resources resources = Resources::parse("cpus:1;mem:256").get();
+
+  Option<Offer> offer =
+    index.match(resources, Attributes::parse("zone:z1"));
+  ASSERT_SOME(offer);
+  EXPECT_EQ("o1", offer.get().id().value());
+
+  offer = index.match(resources, Attributes::parse("zone:z1;rack:r2"));
+  ASSERT_SOME(offer);
+  EXPECT_EQ("o2", offer.get().id().value());
+
+  EXPECT_NONE(index.match(resources, Attributes::parse("zone:z3")));
+  EXPECT_NONE(index.match(resources, Attributes::parse("zone:z2;rack:r1")));
+}
+
+
+TEST(OfferIndexTest, Consume)
+{
+  OfferIndex index;
+
+  const Offer offer = createOffer("o1", "cpus:2;mem:1024");
+  index.add(offer);
+
+  const Resources task = Resources::parse("cpus:1;mem:512").get();
+
+  EXPECT_SOME(index.consume(offer.id(), task));
+
+  Option<Offer> match = index.match(task);
+  ASSERT_SOME(match);
+  EXPECT_EQ(Resources(offer.resources()) - task,
+            Resources(match.get().resources()));
+
+  EXPECT_SOME(index.consume(offer.id(), task));
+  EXPECT_NONE(index.match(task));
+
+  EXPECT_ERROR(index.consume(offer.id(), task));
+
+  OfferID unknown;
+  unknown.set_value("unknown");
+  EXPECT_ERROR(index.consume(unknown, task));
+}
+
+
+class OfferIndex_BENCHMARK_Test
+  : public ::testing::Test,
+    public WithParamInterface<size_t> {};
+
+
+// The offer index benchmark is parameterized by the number of offers.
+INSTANTIATE_TEST_CASE_P(
+    OfferCount,
+    OfferIndex_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 10000U, 50000U));
+
+
+// Places tasks of various sizes onto the offers, once through the
+// index and once by scanning all the offers, as frameworks commonly
+// do, and compares the time taken.
+TEST_P(OfferIndex_BENCHMARK_Test, Match)
+{
+  const size_t offerCount = GetParam();
+  const size_t taskCount = 1000;
+
+  vector<Offer> offers;
+  for (size_t i = 0; i < offerCount; i++) {
+    offers.push_back(createOffer(
+        "o" + stringify(i),
+        "cpus:" + stringify(1 + i % 32) + ";" +
+        "mem:" + stringify(1024 * (1 + i % 8)),
+        "rack:r" + stringify(i % 100)));
+  }
+
+  vector<Resources> tasks;
+  for (size_t i = 0; i < taskCount; i++) {
+    tasks.push_back(Resources::parse(
+        "cpus:" + stringify(1 + i % 16) + ";" +
+        "mem:" + stringify(512 * (1 + i % 8))).get());
+  }
+
+  OfferIndex index;
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const Offer& offer, offers) {
+    index.add(offer);
+  }
+
+  cout << "Indexed " << offerCount << " offers in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  size_t matched = 0;
+  foreach (const Resources& task, tasks) {
+    if (index.match(task).isSome()) {
+      matched++;
+    }
+  }
+
+  cout << "Matched " << matched << " of " << taskCount << " tasks against "
+       << offerCount << " offers through the index in " << watch.elapsed()
+       << endl;
+
+  watch.start();
+
+  size_t scanned = 0;
+  foreach (const Resources& task, tasks) {
+    Option<Offer> best;
+    foreach (const Offer& offer, offers) {
+      const Resources resources = offer.resources();
+      if (!resources.contains(task)) {
+        continue;
+      }
+
+      if (best.isNone() ||
+          resources.cpus().get() <
+            Resources(best.get().resources()).cpus().get()) {
+        best = offer;
+      }
+    }
+
+    if (best.isSome()) {
+      scanned++;
+    }
+  }
+
+  cout << "Matched " << scanned << " of " << taskCount << " tasks against "
+       << offerCount << " offers by scanning in " << watch.elapsed() << endl;
+
+  EXPECT_EQ(scanned, matched);
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
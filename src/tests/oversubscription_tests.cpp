@@ -43,7 +43,9 @@
 #include "slave/flags.hpp"
 #include "slave/monitor.hpp"
 #include "slave/slave.hpp"
+#include "slave/qos_controllers/interference.hpp"
 #include "slave/qos_controllers/load.hpp"
+#include "slave/resource_estimators/usage.hpp"
 
 #include "tests/flags.hpp"
 #include "tests/containerizer.hpp"
@@ -54,9 +56,11 @@ using namespace process;
 
 using mesos::internal::master::Master;
 
+using mesos::internal::slave::InterferenceQoSController;
 using mesos::internal::slave::LoadQoSController;
 using mesos::internal::slave::ResourceMonitor;
 using mesos::internal::slave::Slave;
+using mesos::internal::slave::UsageResourceEstimator;
 
 using mesos::slave::QoSCorrection;
 
@@ -330,6 +334,72 @@ TEST_F(OversubscriptionTest, ForwardUpdateSlaveMessage)
 }
 
 
+// This test verifies that the slave does not forward the estimations
+// which differ from the last forwarded one by less than the
+// '--oversubscribed_resources_delta'.
+TEST_F(OversubscriptionTest, ForwardUpdateSlaveMessageDelta)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegistered =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  MockResourceEstimator resourceEstimator;
+
+  EXPECT_CALL(resourceEstimator, initialize(_));
+
+  Queue<Resources> estimations;
+  EXPECT_CALL(resourceEstimator, oversubscribable())
+    .WillRepeatedly(InvokeWithoutArgs(&estimations, &Queue<Resources>::get));
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.oversubscribed_resources_delta = 0.5;
+
+  Try<PID<Slave>> slave = StartSlave(&resourceEstimator, flags);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegistered);
+
+  Future<UpdateSlaveMessage> update =
+    FUTURE_PROTOBUF(UpdateSlaveMessage(), _, _);
+
+  Clock::pause();
+
+  // The first estimation is always forwarded.
+  Resources resources = createRevocableResources("cpus", "2");
+  estimations.put(resources);
+
+  AWAIT_READY(update);
+  EXPECT_EQ(update.get().oversubscribed_resources(), resources);
+
+  update = FUTURE_PROTOBUF(UpdateSlaveMessage(), _, _);
+
+  // A change of less than half of the estimation is not forwarded.
+  Clock::advance(flags.oversubscribed_resources_interval);
+  Clock::settle();
+
+  estimations.put(createRevocableResources("cpus", "2.5"));
+  Clock::settle();
+
+  ASSERT_FALSE(update.isReady());
+
+  // But a larger one is.
+  Clock::advance(flags.oversubscribed_resources_interval);
+  Clock::settle();
+
+  resources = createRevocableResources("cpus", "4");
+  estimations.put(resources);
+
+  AWAIT_READY(update);
+  EXPECT_EQ(update.get().oversubscribed_resources(), resources);
+
+  Clock::resume();
+
+  Shutdown();
+}
+
+
 // This test verifies that a framework that accepts revocable
 // resources can launch a task with revocable resources.
 TEST_F(OversubscriptionTest, RevocableOffer)
@@ -1131,6 +1201,82 @@ TEST_F(OversubscriptionTest, RemoveCapabilitiesOnSchedulerFailover)
 }
 
 
+// This test verifies that the usage resource estimator oversubscribes
+// the allocated but unused CPUs of regular executors, once there are
+// enough samples in the window, minus the allocated revocable CPUs.
+TEST_F(OversubscriptionTest, UsageResourceEstimator)
+{
+  UsageResourceEstimator::Options options;
+  options.window = Minutes(1);
+
+  UsageResourceEstimator estimator(options);
+
+  int round = 0;
+
+  estimator.initialize([&]() -> Future<ResourceUsage> {
+    round++;
+
+    ResourceUsage usage;
+
+    // Prepare a regular executor using one of its four CPUs.
+    ResourceStatistics statistics = createResourceStatistics();
+    statistics.set_timestamp(round);
+    statistics.set_cpus_user_time_secs(round);
+    statistics.set_cpus_system_time_secs(0);
+
+    ResourceUsage::Executor* executor = usage.add_executors();
+    executor->mutable_executor_info()->CopyFrom(
+        createExecutorInfo("framework", "executor1"));
+    executor->mutable_allocated()->CopyFrom(
+        Resources::parse("cpus:4;mem:1024").get());
+    executor->mutable_statistics()->CopyFrom(statistics);
+    executor->mutable_container_id()->set_value("container1");
+
+    // Prepare a revocable executor.
+    Resources resources = Resources::parse("mem:128").get();
+    resources += createRevocableResources("cpus", "1");
+
+    executor = usage.add_executors();
+    executor->mutable_executor_info()->CopyFrom(
+        createExecutorInfo("framework", "executor2"));
+    executor->mutable_allocated()->CopyFrom(resources);
+    executor->mutable_statistics()->CopyFrom(createResourceStatistics());
+    executor->mutable_container_id()->set_value("container2");
+
+    return usage;
+  });
+
+  Clock::pause();
+
+  // There are not enough CPU usage samples in the first three rounds.
+  for (int i = 0; i < 3; i++) {
+    Future<Resources> estimate = estimator.oversubscribable();
+    AWAIT_READY(estimate);
+    EXPECT_TRUE(estimate.get().empty());
+
+    Clock::advance(Seconds(10));
+  }
+
+  // 90% of the 4 CPUs minus the 1 CPU used minus the 1 revocable CPU
+  // allocated.
+  Future<Resources> estimate = estimator.oversubscribable();
+  AWAIT_READY(estimate);
+
+  EXPECT_EQ(estimate.get(), estimate.get().revocable());
+  EXPECT_SOME_EQ(1.6, estimate.get().cpus());
+  EXPECT_NONE(estimate.get().mem());
+
+  // The samples expire once they are out of the window.
+  Clock::advance(Minutes(2));
+
+  estimate = estimator.oversubscribable();
+  AWAIT_READY(estimate);
+  EXPECT_TRUE(estimate.get().empty());
+
+  Clock::resume();
+}
+
+
 // This test verifies the functionality of the Load QoS Controller.
 // If the total system load on the agent exceeds the configured threshold then
 // it should evict all revocable executors.
@@ -1207,6 +1353,135 @@ TEST_F(OversubscriptionTest, LoadQoSController)
 }
 
 
+// This test verifies the functionality of the Interference QoS
+// Controller. A latency critical executor reports a high cycles per
+// instruction next to two revocable executors:
+// 1. The busiest revocable executor is throttled after the trigger
+//    samples and the throttle is sent on every correction.
+// 2. It is evicted when the interference persists and the next
+//    revocable executor is throttled.
+// 3. Once the interference is gone, the throttle is lifted after the
+//    release samples.
+TEST_F(OversubscriptionTest, InterferenceQoSController)
+{
+  InterferenceQoSController::Thresholds thresholds;
+  thresholds.cpi = 2;
+  thresholds.triggerSamples = 2;
+  thresholds.evictSamples = 2;
+  thresholds.releaseSamples = 2;
+  thresholds.throttleFactor = 0.1;
+
+  InterferenceQoSController controller(thresholds);
+
+  double cpi = 3;
+  int round = 0;
+
+  controller.initialize([&]() -> Future<ResourceUsage> {
+    round++;
+
+    ResourceUsage usage;
+
+    // Prepare the latency critical executor.
+    ResourceStatistics statistics = createResourceStatistics();
+    statistics.set_timestamp(round);
+    statistics.mutable_perf()->set_timestamp(round);
+    statistics.mutable_perf()->set_duration(1);
+    statistics.mutable_perf()->set_cycles(cpi * 1000);
+    statistics.mutable_perf()->set_instructions(1000);
+
+    ResourceUsage::Executor* executor = usage.add_executors();
+    executor->mutable_executor_info()->CopyFrom(
+        createExecutorInfo("framework", "executor"));
+    executor->mutable_allocated()->CopyFrom(
+        Resources::parse("cpus:1;mem:128").get());
+    executor->mutable_statistics()->CopyFrom(statistics);
+    executor->mutable_container_id()->set_value("container");
+
+    // Prepare the revocable executors, the second one uses more CPU.
+    for (int i = 1; i <= 2; i++) {
+      statistics = createResourceStatistics();
+      statistics.set_timestamp(round);
+      statistics.set_cpus_user_time_secs(round * i * 0.5);
+      statistics.set_cpus_system_time_secs(0);
+
+      Resources resources = Resources::parse("mem:128").get();
+      resources += createRevocableResources("cpus", stringify(i * 2));
+
+      executor = usage.add_executors();
+      executor->mutable_executor_info()->CopyFrom(
+          createExecutorInfo("framework", "executor" + stringify(i)));
+      executor->mutable_allocated()->CopyFrom(resources);
+      executor->mutable_statistics()->CopyFrom(statistics);
+      executor->mutable_container_id()->set_value("container" + stringify(i));
+    }
+
+    return usage;
+  });
+
+  // First correction iteration. Interference is below the trigger
+  // samples.
+  Future<list<QoSCorrection>> qosCorrections = controller.corrections();
+  AWAIT_READY(qosCorrections);
+  EXPECT_EQ(0u, qosCorrections.get().size());
+
+  // Second correction iteration. The busiest executor is throttled.
+  qosCorrections = controller.corrections();
+  AWAIT_READY(qosCorrections);
+  ASSERT_EQ(1u, qosCorrections.get().size());
+
+  QoSCorrection correction = qosCorrections.get().front();
+  EXPECT_EQ(QoSCorrection::THROTTLE, correction.type());
+  EXPECT_EQ("executor2", correction.throttle().executor_id().value());
+  EXPECT_EQ("container2", correction.throttle().container_id().value());
+  EXPECT_DOUBLE_EQ(0.4, correction.throttle().cpus());
+
+  // Third correction iteration. The throttle is sent again.
+  qosCorrections = controller.corrections();
+  AWAIT_READY(qosCorrections);
+  ASSERT_EQ(1u, qosCorrections.get().size());
+  EXPECT_EQ(QoSCorrection::THROTTLE, qosCorrections.get().front().type());
+
+  // Fourth correction iteration. The throttled executor is evicted
+  // and the other revocable executor is throttled.
+  qosCorrections = controller.corrections();
+  AWAIT_READY(qosCorrections);
+  ASSERT_EQ(2u, qosCorrections.get().size());
+
+  correction = qosCorrections.get().front();
+  EXPECT_EQ(QoSCorrection::KILL, correction.type());
+  EXPECT_EQ("executor2", correction.kill().executor_id().value());
+
+  correction = qosCorrections.get().back();
+  EXPECT_EQ(QoSCorrection::THROTTLE, correction.type());
+  EXPECT_EQ("executor1", correction.throttle().executor_id().value());
+  EXPECT_DOUBLE_EQ(0.2, correction.throttle().cpus());
+
+  // Fifth correction iteration. The interference is gone but the
+  // throttle stays until the release samples.
+  cpi = 1;
+
+  qosCorrections = controller.corrections();
+  AWAIT_READY(qosCorrections);
+  ASSERT_EQ(1u, qosCorrections.get().size());
+  EXPECT_TRUE(qosCorrections.get().front().throttle().has_cpus());
+
+  // Sixth correction iteration. The throttle is lifted.
+  qosCorrections = controller.corrections();
+  AWAIT_READY(qosCorrections);
+  ASSERT_EQ(1u, qosCorrections.get().size());
+
+  correction = qosCorrections.get().front();
+  EXPECT_EQ(QoSCorrection::THROTTLE, correction.type());
+  EXPECT_EQ("executor1", correction.throttle().executor_id().value());
+  EXPECT_FALSE(correction.throttle().has_cpus());
+
+  // No more corrections without interference.
+  qosCorrections = controller.corrections();
+  AWAIT_READY(qosCorrections);
+  EXPECT_EQ(0u, qosCorrections.get().size());
+}
+
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -82,6 +82,11 @@ TEST_F(PartitionTest, PartitionedSlave)
   // Drop all the PONGs to simulate slave partition.
   DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
 
+  // Any message from the slave counts as a pong, so also drop the
+  // update of its oversubscribed resources, which it sends after the
+  // first 'oversubscribed_resources_interval'.
+  DROP_MESSAGES(Eq(UpdateSlaveMessage().GetTypeName()), _, _);
+
   Try<PID<Slave>> slave = StartSlave();
   ASSERT_SOME(slave);
 
@@ -142,6 +147,62 @@ TEST_F(PartitionTest, PartitionedSlave)
 }
 
 
+// The purpose of this test is to ensure that the master considers
+// any message from a slave as a sign of life, so that a slave whose
+// pongs are lost (or delayed) is not removed while it keeps talking
+// to the master.
+TEST_F(PartitionTest, SlaveMessagesCountAsPongs)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Future<Message> ping = FUTURE_MESSAGE(
+      Eq(PingSlaveMessage().GetTypeName()), _, _);
+
+  DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
+
+  // No shutdown should occur during the test!
+  EXPECT_NO_FUTURE_PROTOBUFS(ShutdownMessage(), _, _);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Clock::pause();
+
+  // Go through twice as many pings as it takes to remove the slave,
+  // while the slave sends a message to the master before each of
+  // the timeouts.
+  for (size_t pings = 0;
+       pings < 2 * masterFlags.max_slave_ping_timeouts;
+       pings++) {
+    AWAIT_READY(ping);
+    ping = FUTURE_MESSAGE(Eq(PingSlaveMessage().GetTypeName()), _, _);
+
+    process::post(slave.get(), master.get(), std::string("unknown"));
+    Clock::settle();
+
+    Clock::advance(masterFlags.slave_ping_timeout);
+  }
+
+  AWAIT_READY(ping);
+  Clock::settle();
+
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(0, stats.values["master/slave_shutdowns_scheduled"]);
+  EXPECT_EQ(0, stats.values["master/slave_removals"]);
+
+  Clock::resume();
+
+  Shutdown();
+}
+
+
 // The purpose of this test is to ensure that when slaves are removed
 // from the master, and then attempt to re-register, we deny the
 // re-registration by sending a ShutdownMessage to the slave.
@@ -159,13 +220,18 @@ TEST_F(PartitionTest, PartitionedSlaveReregistration)
 
   // Allow the master to PING the slave, but drop all PONG messages
   // from the slave. Note that we don't match on the master / slave
-  // PIDs because it's actually the SlaveObserver Process that sends
+  // PIDs because it's actually the SlaveHealthChecker Process that sends
   // the pings.
   Future<Message> ping = FUTURE_MESSAGE(
       Eq(PingSlaveMessage().GetTypeName()), _, _);
 
   DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
 
+  // Any message from the slave counts as a pong, so also drop the
+  // update of its oversubscribed resources, which it sends after the
+  // first 'oversubscribed_resources_interval'.
+  DROP_MESSAGES(Eq(UpdateSlaveMessage().GetTypeName()), _, _);
+
   MockExecutor exec(DEFAULT_EXECUTOR_ID);
 
   StandaloneMasterDetector detector(master.get());
@@ -310,13 +376,18 @@ TEST_F(PartitionTest, PartitionedSlaveStatusUpdates)
 
   // Allow the master to PING the slave, but drop all PONG messages
   // from the slave. Note that we don't match on the master / slave
-  // PIDs because it's actually the SlaveObserver Process that sends
+  // PIDs because it's actually the SlaveHealthChecker Process that sends
   // the pings.
   Future<Message> ping = FUTURE_MESSAGE(
       Eq(PingSlaveMessage().GetTypeName()), _, _);
 
   DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
 
+  // Any message from the slave counts as a pong, so also drop the
+  // update of its oversubscribed resources, which it sends after the
+  // first 'oversubscribed_resources_interval'.
+  DROP_MESSAGES(Eq(UpdateSlaveMessage().GetTypeName()), _, _);
+
   Future<SlaveRegisteredMessage> slaveRegisteredMessage =
     FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
 
@@ -430,13 +501,18 @@ TEST_F(PartitionTest, PartitionedSlaveExitedExecutor)
 
   // Allow the master to PING the slave, but drop all PONG messages
   // from the slave. Note that we don't match on the master / slave
-  // PIDs because it's actually the SlaveObserver Process that sends
+  // PIDs because it's actually the SlaveHealthChecker Process that sends
   // the pings.
   Future<Message> ping = FUTURE_MESSAGE(
       Eq(PingSlaveMessage().GetTypeName()), _, _);
 
   DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
 
+  // Any message from the slave counts as a pong, so also drop the
+  // update of its oversubscribed resources, which it sends after the
+  // first 'oversubscribed_resources_interval'.
+  DROP_MESSAGES(Eq(UpdateSlaveMessage().GetTypeName()), _, _);
+
   MockExecutor exec(DEFAULT_EXECUTOR_ID);
   TestContainerizer containerizer(&exec);
 
@@ -284,6 +284,17 @@ TEST_F(RateLimitingTest, RateLimitingEnabled)
     EXPECT_EQ(
         1,
         metrics.values[messages_processed].as<JSON::Number>().as<int64_t>());
+
+    // The message got a permit right away, but it is still recorded
+    // as throttled (for no time).
+    const string& messages_throttled_ms =
+      "frameworks/" + DEFAULT_CREDENTIAL.principal() +
+      "/messages_throttled_ms";
+    EXPECT_EQ(1u, metrics.values.count(messages_throttled_ms));
+    EXPECT_EQ(
+        1,
+        metrics.values[messages_throttled_ms].as<JSON::Number>()
+          .as<int64_t>());
   }
 
   // The 2nd message is throttled for a second.
@@ -65,6 +65,7 @@ using mesos::internal::log::Replica;
 using std::cout;
 using std::endl;
 using std::map;
+using std::pair;
 using std::set;
 using std::string;
 using std::vector;
@@ -919,6 +920,7 @@ class MockStorage : public Storage
 public:
   MOCK_METHOD1(get, Future<Option<Entry> >(const string&));
   MOCK_METHOD2(set, Future<bool>(const Entry&, const UUID&));
+  MOCK_METHOD1(set, Future<bool>(const vector<pair<Entry, UUID>>&));
   MOCK_METHOD1(expunge, Future<bool>(const Entry&));
   MOCK_METHOD0(names, Future<std::set<string>>());
 };
@@ -1010,16 +1012,92 @@ TEST_P(RegistrarTest, Abort)
 }
 
 
+// Tests that the registrar keeps waiting for more operations while
+// they keep arriving and then stores all of them at once.
+TEST_P(RegistrarTest, Batch)
+{
+  Clock::pause();
+
+  flags.registry_batch_delay = Milliseconds(10);
+  flags.registry_max_batch_delay = Milliseconds(100);
+
+  MockStorage storage;
+  State state(&storage);
+
+  Registrar registrar(flags, &state);
+
+  EXPECT_CALL(storage, get(_))
+    .WillOnce(Return(None()));
+
+  Future<Nothing> set;
+  EXPECT_CALL(storage, set(_, _))
+    .WillOnce(Return(Future<bool>(true)))  // Recovery.
+    .WillOnce(DoAll(FutureSatisfy(&set),
+                    Return(Future<bool>(true))));
+
+  AWAIT_READY(registrar.recover(master));
+
+  SlaveInfo slave2 = slave;
+  slave2.mutable_id()->set_value("2");
+
+  Future<bool> admit1 =
+    registrar.apply(Owned<Operation>(new AdmitSlave(slave)));
+
+  Clock::settle();
+
+  Future<bool> admit2 =
+    registrar.apply(Owned<Operation>(new AdmitSlave(slave2)));
+
+  // The queue grew during the first step so the registrar waits for
+  // another step before storing.
+  Clock::advance(flags.registry_batch_delay);
+  Clock::settle();
+
+  EXPECT_TRUE(set.isPending());
+  EXPECT_TRUE(admit1.isPending());
+  EXPECT_TRUE(admit2.isPending());
+
+  Clock::advance(flags.registry_batch_delay);
+
+  AWAIT_READY(set);
+
+  AWAIT_EQ(true, admit1);
+  AWAIT_EQ(true, admit2);
+
+  Clock::resume();
+}
+
+
 class Registrar_BENCHMARK_Test
   : public RegistrarTestBase,
-    public WithParamInterface<size_t> {};
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>>
+{
+protected:
+  virtual void SetUp()
+  {
+    RegistrarTestBase::SetUp();
+
+    // Store the registry through a storage that writes diffs.
+    flags.registry_diffs_between_snapshots = std::tr1::get<1>(GetParam());
+
+    delete state;
+    delete storage;
+
+    storage = new LogStorage(log, flags.registry_diffs_between_snapshots);
+    state = new State(storage);
+  }
+};
 
 
-// The Registrar benchmark tests are parameterized by the number of slaves.
+// The Registrar benchmark tests are parameterized by the number of
+// slaves and the number of registry diffs stored between snapshots.
 INSTANTIATE_TEST_CASE_P(
-    SlaveCount,
+    SlaveCountAndDiffs,
     Registrar_BENCHMARK_Test,
-    ::testing::Values(10000U, 20000U, 30000U, 50000U));
+    ::testing::Combine(
+      ::testing::Values(10000U, 20000U, 30000U, 50000U),
+      ::testing::Values(0U, 100U))
+    );
 
 
 TEST_P(Registrar_BENCHMARK_Test, Performance)
@@ -1033,7 +1111,7 @@ TEST_P(Registrar_BENCHMARK_Test, Performance)
   Resources resources =
     Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
 
-  size_t slaveCount = GetParam();
+  size_t slaveCount = std::tr1::get<0>(GetParam());
 
   // Create slaves.
   for (size_t i = 0; i < slaveCount; ++i) {
@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <iostream>
 #include <set>
 #include <sstream>
 #include <string>
@@ -24,6 +25,8 @@
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
 #include "master/master.hpp"
 
@@ -31,6 +34,8 @@
 
 using namespace mesos::internal::master;
 
+using std::cout;
+using std::endl;
 using std::map;
 using std::ostringstream;
 using std::pair;
@@ -39,6 +44,9 @@ using std::string;
 
 using google::protobuf::RepeatedPtrField;
 
+using testing::Values;
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -2132,6 +2140,98 @@ TEST(RevocableResourceTest, Filter)
   EXPECT_EQ(r2, (r1 + r2).nonRevocable());
 }
 
+
+class Resources_BENCHMARK_Test
+  : public ::testing::Test,
+    public WithParamInterface<size_t> {};
+
+
+// The Resources benchmark tests are parameterized by the number of
+// roles that an agent's resources are reserved for, i.e., the number
+// of Resource objects (four per role) that need to be scanned.
+INSTANTIATE_TEST_CASE_P(
+    RoleCount,
+    Resources_BENCHMARK_Test,
+    Values(1U, 10U, 50U, 100U));
+
+
+// Measures the arithmetic that the allocator performs on the resources
+// of an agent, i.e., adding and subtracting task sized chunks and
+// checking whether they are contained.
+TEST_P(Resources_BENCHMARK_Test, Arithmetic)
+{
+  const size_t roleCount = GetParam();
+
+  Resources total;
+  for (size_t i = 0; i < roleCount; i++) {
+    total += Resources::parse(
+        "cpus:8;mem:4096;disk:8192;ports:[31000-32000]",
+        "role" + stringify(i)).get();
+  }
+
+  // Use the last role so that the whole agent has to be scanned.
+  const Resources task = Resources::parse(
+      "cpus:1;mem:128;disk:256;ports:[31000-31000]",
+      "role" + stringify(roleCount - 1)).get();
+
+  const size_t iterations = 10000;
+
+  cout << "Using " << roleCount << " roles" << endl;
+
+  Resources resources = total;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    resources += task;
+  }
+
+  cout << "Took " << watch.elapsed() << " to perform "
+       << iterations << " 'resources += task' operations" << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    resources -= task;
+  }
+
+  cout << "Took " << watch.elapsed() << " to perform "
+       << iterations << " 'resources -= task' operations" << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    resources = total + task;
+  }
+
+  cout << "Took " << watch.elapsed() << " to perform "
+       << iterations << " 'total + task' operations" << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    resources = total - task;
+  }
+
+  cout << "Took " << watch.elapsed() << " to perform "
+       << iterations << " 'total - task' operations" << endl;
+
+  watch.start();
+
+  size_t contained = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    if (total.contains(task)) {
+      contained++;
+    }
+  }
+
+  cout << "Took " << watch.elapsed() << " to perform "
+       << iterations << " 'total.contains(task)' operations" << endl;
+
+  EXPECT_EQ(iterations, contained);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -36,6 +36,7 @@
 
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
+#include <stout/os.hpp>
 #include <stout/try.hpp>
 #include <stout/uuid.hpp>
 
@@ -45,6 +46,7 @@
 
 #include "tests/containerizer.hpp"
 #include "tests/mesos.hpp"
+#include "tests/utils.hpp"
 
 using mesos::internal::master::allocator::MesosAllocatorProcess;
 
@@ -115,6 +117,58 @@ TEST_F(MesosSchedulerDriverTest, MetricsEndpoint)
 }
 
 
+// This test verifies that the driver publishes the metrics about
+// offers and callbacks with --driver_metrics.
+TEST_F(MesosSchedulerDriverTest, DriverMetrics)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  // The driver loads its flags from the environment.
+  os::setenv("MESOS_DRIVER_METRICS", "true");
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  os::unsetenv("MESOS_DRIVER_METRICS");
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  ASSERT_EQ(DRIVER_RUNNING, driver.start());
+
+  AWAIT_READY(offers);
+  EXPECT_EQ(1u, offers.get().size());
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(1u, metrics.values.count("scheduler/offers_received"));
+  EXPECT_EQ(1u, metrics.values["scheduler/offers_received"]);
+
+  EXPECT_EQ(1u, metrics.values.count("scheduler/offers_rescinded"));
+  EXPECT_EQ(0u, metrics.values["scheduler/offers_rescinded"]);
+
+  EXPECT_EQ(1u, metrics.values.count("scheduler/outstanding_offers"));
+  EXPECT_EQ(1u, metrics.values["scheduler/outstanding_offers"]);
+
+  EXPECT_EQ(
+      1u, metrics.values.count("scheduler/callbacks/resource_offers_ms"));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // This action calls driver stop() followed by abort().
 ACTION(StopAndAbort)
 {
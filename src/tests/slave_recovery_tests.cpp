@@ -2478,6 +2478,11 @@ TYPED_TEST(SlaveRecoveryTest, PartitionedSlave)
   // Drop all the PONGs to simulate slave partition.
   DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
 
+  // Any message from the slave counts as a pong, so also drop the
+  // update of its oversubscribed resources, which it sends after the
+  // first 'oversubscribed_resources_interval'.
+  DROP_MESSAGES(Eq(UpdateSlaveMessage().GetTypeName()), _, _);
+
   slave::Flags flags = this->CreateSlaveFlags();
 
   Fetcher fetcher;
@@ -576,6 +576,65 @@ TEST_F(SlaveTest, GetExecutorInfo)
 }
 
 
+// Ensures that with '--shared_command_executor' the command tasks of
+// a framework get the same executor, unless they need a container.
+TEST_F(SlaveTest, GetExecutorInfoForSharedCommandExecutor)
+{
+  TestContainerizer containerizer;
+  StandaloneMasterDetector detector;
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.shared_command_executor = true;
+
+  MockSlave slave(flags, &detector, &containerizer);
+
+  FrameworkInfo frameworkInfo;
+  frameworkInfo.mutable_id()->set_value(
+      "20141010-221431-251662764-60288-12345-0000");
+
+  TaskInfo task1;
+  task1.set_name("task1");
+  task1.mutable_task_id()->set_value("1");
+  task1.mutable_slave_id()->set_value(
+      "20141010-221431-251662764-60288-12345-0001");
+  task1.mutable_resources()->MergeFrom(
+      Resources::parse("cpus:0.1;mem:32").get());
+  task1.mutable_command()->set_value("sleep 1");
+
+  TaskInfo task2 = task1;
+  task2.set_name("task2");
+  task2.mutable_task_id()->set_value("2");
+  task2.mutable_command()->set_value("sleep 2");
+
+  const ExecutorInfo executor1 = slave.getExecutorInfo(frameworkInfo, task1);
+  const ExecutorInfo executor2 = slave.getExecutorInfo(frameworkInfo, task2);
+
+  EXPECT_EQ(executor1, executor2);
+  EXPECT_NE(
+      string::npos,
+      executor1.command().value().find("mesos-executor --shared"));
+
+  // The tasks of another user are run by another executor.
+  TaskInfo task3 = task1;
+  task3.mutable_task_id()->set_value("3");
+  task3.mutable_command()->set_user("nobody");
+
+  const ExecutorInfo executor3 = slave.getExecutorInfo(frameworkInfo, task3);
+
+  EXPECT_NE(executor1.executor_id(), executor3.executor_id());
+  EXPECT_EQ("nobody", executor3.command().user());
+
+  // A task with a container gets its own command executor.
+  TaskInfo task4 = task1;
+  task4.mutable_task_id()->set_value("4");
+  task4.mutable_container()->set_type(ContainerInfo::MESOS);
+
+  const ExecutorInfo executor4 = slave.getExecutorInfo(frameworkInfo, task4);
+
+  EXPECT_EQ("4", executor4.executor_id().value());
+}
+
+
 // Ensure getExecutorInfo for mesos-executor gets the ContainerInfo,
 // if present. This ensures the MesosContainerizer can get the
 // NetworkInfo even when using the command executor.
@@ -1041,6 +1100,35 @@ TEST_F(SlaveTest, IgnoreNonLeaderStatusUpdateAcknowledgement)
 }
 
 
+// This test verifies that the time spent in the phases of the slave
+// recovery is exposed in the metrics.
+TEST_F(SlaveTest, RecoveryMetrics)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<Nothing> __recover = FUTURE_DISPATCH(_, &Slave::__recover);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(__recover);
+
+  JSON::Object snapshot = Metrics();
+
+  EXPECT_EQ(1u, snapshot.values.count("slave/recovery_state_ms"));
+  EXPECT_EQ(
+      1u, snapshot.values.count("slave/recovery_status_update_manager_ms"));
+  EXPECT_EQ(1u, snapshot.values.count("slave/recovery_containerizer_ms"));
+  EXPECT_EQ(1u, snapshot.values.count("slave/recovery_ms"));
+
+  // There were no executors to wait for.
+  EXPECT_EQ(0u, snapshot.values.count("slave/recovery_executors_ms"));
+
+  Shutdown();
+}
+
+
 TEST_F(SlaveTest, MetricsInMetricsEndpoint)
 {
   Try<PID<Master>> master = StartMaster();
@@ -1317,6 +1405,61 @@ TEST_F(SlaveTest, StateEndpoint)
 }
 
 
+// This tests that the slave's state endpoint responds with
+// 'Not Modified' to requests carrying the 'ETag' of the current state
+// in 'If-None-Match', and that the state (and its 'ETag') changes
+// once the slave registers.
+TEST_F(SlaveTest, StateEndpointNotModified)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  // The slave does not register until the master is appointed.
+  StandaloneMasterDetector detector;
+
+  Try<PID<Slave>> slave = StartSlave(&detector);
+  ASSERT_SOME(slave);
+
+  Future<Response> response = process::http::get(slave.get(), "state");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_TRUE(response.get().headers.contains("ETag"));
+
+  const string tag = response.get().headers.get("ETag").get();
+
+  process::http::Headers headers;
+  headers["If-None-Match"] = tag;
+
+  response = process::http::get(slave.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::NotModified().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(tag, "ETag", response);
+  EXPECT_TRUE(response.get().body.empty());
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  detector.appoint(master.get());
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  response = process::http::get(slave.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_TRUE(response.get().headers.contains("ETag"));
+  EXPECT_NE(tag, response.get().headers.get("ETag").get());
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ(JSON::String(slaveRegisteredMessage.get().slave_id().value()),
+            parse.get().values["id"]);
+
+  Shutdown();
+}
+
+
 // This test ensures that when a slave is shutting down, it will not
 // try to re-register with the master.
 TEST_F(SlaveTest, DISABLED_TerminatingSlaveDoesNotReregister)
@@ -1754,6 +1897,11 @@ TEST_F(SlaveTest, RateLimitSlaveShutdown)
   // Drop all the PONGs to simulate health check timeout.
   DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
 
+  // Any message from the slave counts as a pong, so also drop the
+  // update of its oversubscribed resources, which it sends after the
+  // first 'oversubscribed_resources_interval'.
+  DROP_MESSAGES(Eq(UpdateSlaveMessage().GetTypeName()), _, _);
+
   Future<SlaveRegisteredMessage> slaveRegisteredMessage =
     FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
 
@@ -1819,6 +1967,11 @@ TEST_F(SlaveTest, CancelSlaveShutdown)
   // Drop all the PONGs to simulate health check timeout.
   DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
 
+  // Any message from the slave counts as a pong, so also drop the
+  // update of its oversubscribed resources, which it sends after the
+  // first 'oversubscribed_resources_interval'.
+  DROP_MESSAGES(Eq(UpdateSlaveMessage().GetTypeName()), _, _);
+
   // No shutdown should occur during the test!
   EXPECT_NO_FUTURE_PROTOBUFS(ShutdownMessage(), _, _);
 
@@ -2085,6 +2238,80 @@ TEST_F(SlaveTest, ReregisterWithStatusUpdateTaskState)
 }
 
 
+// This test verifies that the slave abbreviates its re-registration
+// with the master it was registered with, i.e., that it only sends
+// the identity and the state of its tasks.
+TEST_F(SlaveTest, AbbreviatedReregistration)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  StandaloneMasterDetector detector(master.get());
+
+  Try<PID<Slave>> slave = StartSlave(&exec, &detector);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 2, 1024, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.start();
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  Future<ReregisterSlaveMessage> reregisterSlaveMessage =
+    FUTURE_PROTOBUF(ReregisterSlaveMessage(), _, _);
+
+  Future<SlaveReregisteredMessage> slaveReregisteredMessage =
+    FUTURE_PROTOBUF(SlaveReregisteredMessage(), _, _);
+
+  // Simulate a new master detected event on the slave, with the same
+  // master, so that the slave re-registers with it.
+  detector.appoint(master.get());
+
+  AWAIT_READY(reregisterSlaveMessage);
+
+  // The master is known to have all of the information of the slave.
+  EXPECT_TRUE(reregisterSlaveMessage.get().has_master_id());
+  EXPECT_EQ(0, reregisterSlaveMessage.get().completed_frameworks_size());
+
+  ASSERT_EQ(1, reregisterSlaveMessage.get().tasks_size());
+
+  const Task& task = reregisterSlaveMessage.get().tasks(0);
+  EXPECT_EQ(TASK_RUNNING, task.state());
+  EXPECT_EQ(0, task.resources_size());
+  EXPECT_EQ(0, task.statuses_size());
+
+  AWAIT_READY(slaveReregisteredMessage);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // This test verifies that the slave should properly handle the case
 // where the containerizer usage call fails when getting the usage
 // information.
@@ -3011,6 +3238,266 @@ TEST_F(SlaveTest, HTTPSchedulerSlaveRestart)
   delete containerizer.get();
 }
 
+
+// This test verifies that status updates that are forwarded within
+// the batch interval are sent to the master in a single message.
+TEST_F(SlaveTest, BatchedStatusUpdates)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.resources = "cpus:2;mem:1024";
+
+  // NOTE: This needs to be shorter than the status update retry
+  // interval, so that advancing the clock does not retry the updates.
+  flags.status_update_batch_interval = Seconds(1);
+
+  Try<PID<Slave>> slave = StartSlave(&exec, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task1;
+  task1.set_name("test-task");
+  task1.mutable_task_id()->set_value("1");
+  task1.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task1.mutable_resources()->MergeFrom(
+      Resources::parse("cpus:1;mem:512").get());
+  task1.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+  TaskInfo task2 = task1;
+  task2.mutable_task_id()->set_value("2");
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task1);
+  tasks.push_back(task2);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(_, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  Future<Nothing> forward1 = FUTURE_DISPATCH(_, &Slave::forward);
+  Future<Nothing> forward2 = FUTURE_DISPATCH(_, &Slave::forward);
+
+  Future<StatusUpdatesMessage> statusUpdatesMessage =
+    FUTURE_PROTOBUF(StatusUpdatesMessage(), slave.get(), master.get());
+
+  Clock::pause();
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(forward1);
+  AWAIT_READY(forward2);
+
+  // Both updates are held back until the batch interval elapses.
+  Clock::settle();
+  EXPECT_TRUE(statusUpdatesMessage.isPending());
+
+  Clock::advance(flags.status_update_batch_interval);
+
+  AWAIT_READY(statusUpdatesMessage);
+  EXPECT_EQ(2, statusUpdatesMessage.get().updates_size());
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2.get().state());
+
+  Clock::resume();
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Sends two status updates for the task in a single message.
+ACTION_P2(SendStatusUpdatesFromTask, state1, state2)
+{
+  vector<TaskStatus> statuses(2);
+  statuses[0].mutable_task_id()->MergeFrom(arg1.task_id());
+  statuses[0].set_state(state1);
+  statuses[1].mutable_task_id()->MergeFrom(arg1.task_id());
+  statuses[1].set_state(state2);
+
+  arg0->sendStatusUpdates(statuses);
+}
+
+
+// This test verifies that the status updates sent by an executor in
+// a single message are all handled by the slave and forwarded to the
+// scheduler in order.
+TEST_F(SlaveTest, ExecutorStatusUpdates)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave>> slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdatesFromTask(TASK_RUNNING, TASK_FINISHED));
+
+  Future<StatusUpdatesMessage> statusUpdatesMessage =
+    FUTURE_PROTOBUF(StatusUpdatesMessage(), _, slave.get());
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(_, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(statusUpdatesMessage);
+  EXPECT_EQ(2, statusUpdatesMessage.get().updates_size());
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+  EXPECT_EQ(TaskStatus::SOURCE_EXECUTOR, status1.get().source());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_FINISHED, status2.get().state());
+  EXPECT_EQ(TaskStatus::SOURCE_EXECUTOR, status2.get().source());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies that the resource statistics of a container are
+// collected once and reused by subsequent requests within the
+// resource usage cache interval.
+TEST_F(SlaveTest, ResourceUsageCache)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.resource_usage_cache_interval = Minutes(1);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(_, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  ResourceStatistics statistics;
+  statistics.set_timestamp(1);
+  statistics.set_cpus_limit(2.0);
+
+  EXPECT_CALL(containerizer, usage(_))
+    .WillOnce(Return(statistics));
+
+  UPID upid("monitor", process::address());
+
+  Future<Response> response = process::http::get(upid, "statistics");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  // The second request is served from the statistics collected for
+  // the first one.
+  Future<Response> response2 = process::http::get(upid, "statistics");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response2);
+
+  EXPECT_EQ(response.get().body, response2.get().body);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
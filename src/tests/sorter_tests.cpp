@@ -19,6 +19,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
@@ -34,6 +35,7 @@ using mesos::internal::master::allocator::DRFSorter;
 
 using std::list;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -447,6 +449,101 @@ TEST(SorterTest, RevocableResources)
   EXPECT_EQ("b", sorted.back());
 }
 
+
+// This test verifies that the sorted view of the clients matches
+// 'sort' and is not affected by allocations made while iterating it.
+TEST(SorterTest, Sorted)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  sorter.add(slaveId, Resources::parse("cpus:10;mem:100").get());
+
+  sorter.add("a");
+  sorter.add("b");
+  sorter.add("c");
+
+  // Dominant share of "a" is 0.3 (cpus).
+  sorter.allocated("a", slaveId, Resources::parse("cpus:3;mem:1").get());
+
+  // Dominant share of "b" is 0.2 (mem).
+  sorter.allocated("b", slaveId, Resources::parse("cpus:1;mem:20").get());
+
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorter.sorted());
+  EXPECT_EQ(list<string>({"c", "b", "a"}), sorter.sort());
+
+  vector<string> visited;
+  foreach (const string& client, sorter.sorted()) {
+    visited.push_back(client);
+
+    // Each allocation makes the client the one with the largest share.
+    sorter.allocated(client, slaveId, Resources::parse("cpus:4").get());
+  }
+
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), visited);
+
+  // The shares of "a", "b" and "c" are now 0.7, 0.5 and 0.4 (cpus).
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorter.sorted());
+
+  sorter.unallocated("a", slaveId, Resources::parse("cpus:4").get());
+  EXPECT_EQ(vector<string>({"a", "c", "b"}), sorter.sorted());
+
+  sorter.deactivate("c");
+  EXPECT_EQ(vector<string>({"a", "b"}), sorter.sorted());
+
+  sorter.activate("c");
+  EXPECT_EQ(vector<string>({"a", "c", "b"}), sorter.sorted());
+
+  sorter.remove("a");
+  EXPECT_EQ(vector<string>({"c", "b"}), sorter.sorted());
+}
+
+
+// Checks that the order is updated once a change of the total
+// resources changes the dominant shares of the clients.
+TEST(SorterTest, SortedUpdateTotal)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  sorter.add(slaveId, Resources::parse("cpus:10;mem:100").get());
+
+  sorter.add("a");
+  sorter.add("b");
+
+  // Dominant share of "a" is 0.5 (cpus).
+  sorter.allocated("a", slaveId, Resources::parse("cpus:5").get());
+
+  // Dominant share of "b" is 0.4 (mem).
+  sorter.allocated("b", slaveId, Resources::parse("mem:40").get());
+
+  EXPECT_EQ(vector<string>({"b", "a"}), sorter.sorted());
+
+  // Doubling the total keeps the order of the clients.
+  sorter.update(slaveId, Resources::parse("cpus:20;mem:200").get());
+  EXPECT_EQ(vector<string>({"b", "a"}), sorter.sorted());
+
+  // The dominant share of "a" is now 0.05 (cpus), the one of "b" is
+  // still 0.2 (mem).
+  sorter.update(slaveId, Resources::parse("cpus:100;mem:200").get());
+  EXPECT_EQ(vector<string>({"a", "b"}), sorter.sorted());
+
+  SlaveID slaveId2;
+  slaveId2.set_value("slaveId2");
+
+  // The dominant share of "b" is now 0.1 (mem), i.e., larger than the
+  // one of "a" which is still 0.05 (cpus).
+  sorter.add(slaveId2, Resources::parse("mem:200").get());
+  EXPECT_EQ(vector<string>({"a", "b"}), sorter.sorted());
+
+  sorter.remove(slaveId, Resources::parse("cpus:90").get());
+  EXPECT_EQ(vector<string>({"b", "a"}), sorter.sorted());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
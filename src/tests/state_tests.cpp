@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <iostream>
 #include <list>
 #include <set>
 #include <string>
@@ -26,13 +28,19 @@
 
 #include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/owned.hpp>
 #include <process/protobuf.hpp>
 #include <process/pid.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
+#include <stout/lambda.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -49,6 +57,7 @@
 #include "state/in_memory.hpp"
 #include "state/leveldb.hpp"
 #include "state/log.hpp"
+#include "state/mapped.hpp"
 #include "state/protobuf.hpp"
 #include "state/storage.hpp"
 #include "state/zookeeper.hpp"
@@ -61,11 +70,15 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
 using std::vector;
 
+using ::testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -324,6 +337,192 @@ void Names(State* state)
 }
 
 
+void FetchAndStoreMultipleAndFetch(State* state)
+{
+  Future<Variable<Slaves> > future1 = state->fetch<Slaves>("slaves1");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable1 = future1.get();
+
+  future1 = state->fetch<Slaves>("slaves2");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable2 = future1.get();
+
+  Slaves slaves1;
+  slaves1.add_slaves()->mutable_info()->set_hostname("localhost1");
+
+  Slaves slaves2;
+  slaves2.add_slaves()->mutable_info()->set_hostname("localhost2");
+
+  vector<Variable<Slaves> > variables;
+  variables.push_back(variable1.mutate(slaves1));
+  variables.push_back(variable2.mutate(slaves2));
+
+  Future<Option<vector<Variable<Slaves> > > > future2 =
+    state->store(variables);
+
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+  ASSERT_EQ(2u, future2.get().get().size());
+
+  // Storing the now stale 'variable1' along with the latest version
+  // of "slaves2" must not store either of them.
+  variables.clear();
+  variables.push_back(variable1.mutate(slaves2));
+  variables.push_back(future2.get().get()[1].mutate(slaves1));
+
+  future2 = state->store(variables);
+  AWAIT_READY(future2);
+  EXPECT_NONE(future2.get());
+
+  future1 = state->fetch<Slaves>("slaves1");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("localhost1", future1.get().get().slaves(0).info().hostname());
+
+  future1 = state->fetch<Slaves>("slaves2");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("localhost2", future1.get().get().slaves(0).info().hostname());
+}
+
+
+// Issues 'count' operations through 'f', at most 'concurrency' of
+// them at a time, and prints their throughput (operations per
+// second) and latency percentiles (in microseconds) as a single line
+// of space separated 'key=value' pairs, so that the results can be
+// parsed and compared across releases. The results of the operations
+// are stored in 'results' in the order the operations were issued.
+template <typename T>
+void Measure(
+    const string& backend,
+    const string& operation,
+    const Bytes& size,
+    size_t concurrency,
+    size_t count,
+    const lambda::function<Future<T>(size_t)>& f,
+    vector<T>* results)
+{
+  vector<Duration> latencies;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < count; i += concurrency) {
+    list<Future<T> > futures;
+    list<Future<Duration> > durations;
+
+    for (size_t j = i; j < std::min(i + concurrency, count); j++) {
+      Stopwatch stopwatch;
+      stopwatch.start();
+
+      Future<T> future = f(j);
+
+      futures.push_back(future);
+      durations.push_back(future.then([stopwatch](const T&) -> Duration {
+        return stopwatch.elapsed();
+      }));
+    }
+
+    foreach (const Future<Duration>& duration, durations) {
+      AWAIT_READY_FOR(duration, Minutes(5));
+      latencies.push_back(duration.get());
+    }
+
+    foreach (const Future<T>& future, futures) {
+      results->push_back(future.get());
+    }
+  }
+
+  const Duration elapsed = watch.elapsed();
+
+  std::sort(latencies.begin(), latencies.end());
+
+  cout << "backend=" << backend
+       << " operation=" << operation
+       << " value_size=" << size.bytes()
+       << " concurrency=" << concurrency
+       << " operations=" << count
+       << " throughput=" << count / elapsed.secs()
+       << " p50_us=" << latencies[latencies.size() / 2].us()
+       << " p99_us=" << latencies[latencies.size() * 99 / 100].us()
+       << endl;
+}
+
+
+// Benchmarks storing, fetching and expunging a number of variables
+// holding values of the given size with the given concurrency.
+void Benchmark(
+    State* state,
+    const string& backend,
+    const Bytes& size,
+    size_t concurrency)
+{
+  const size_t count = 1000;
+
+  // The values are stored as is, i.e., without the (protobuf)
+  // serialization of the typed variables.
+  state::State* base = state;
+
+  const string value(size.bytes(), 'x');
+
+  // Create the variables before measuring anything.
+  vector<state::Variable> variables;
+  for (size_t i = 0; i < count; i++) {
+    Future<state::Variable> variable =
+      base->fetch("benchmark" + stringify(i));
+
+    AWAIT_READY(variable);
+    variables.push_back(variable.get());
+  }
+
+  vector<Option<state::Variable> > stored;
+  Measure<Option<state::Variable> >(
+      backend,
+      "set",
+      size,
+      concurrency,
+      count,
+      [&](size_t i) { return base->store(variables[i].mutate(value)); },
+      &stored);
+
+  foreach (const Option<state::Variable>& variable, stored) {
+    ASSERT_SOME(variable);
+  }
+
+  vector<state::Variable> fetched;
+  Measure<state::Variable>(
+      backend,
+      "get",
+      size,
+      concurrency,
+      count,
+      [&](size_t i) { return base->fetch("benchmark" + stringify(i)); },
+      &fetched);
+
+  foreach (const state::Variable& variable, fetched) {
+    ASSERT_EQ(value.size(), variable.value().size());
+  }
+
+  vector<bool> expunged;
+  Measure<bool>(
+      backend,
+      "expunge",
+      size,
+      concurrency,
+      count,
+      [&](size_t i) { return base->expunge(stored[i].get()); },
+      &expunged);
+
+  foreach (bool expunge, expunged) {
+    ASSERT_TRUE(expunge);
+  }
+}
+
+
 class InMemoryStateTest : public ::testing::Test
 {
 public:
@@ -391,6 +590,12 @@ TEST_F(InMemoryStateTest, Names)
 }
 
 
+TEST_F(InMemoryStateTest, FetchAndStoreMultipleAndFetch)
+{
+  FetchAndStoreMultipleAndFetch(state);
+}
+
+
 class LevelDBStateTest : public ::testing::Test
 {
 public:
@@ -464,6 +669,220 @@ TEST_F(LevelDBStateTest, Names)
 }
 
 
+TEST_F(LevelDBStateTest, FetchAndStoreMultipleAndFetch)
+{
+  FetchAndStoreMultipleAndFetch(state);
+}
+
+
+class LevelDBState_BENCHMARK_Test
+  : public LevelDBStateTest,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
+
+
+// The LevelDB state benchmark tests are parameterized by the size
+// of the values and the number of concurrent operations.
+INSTANTIATE_TEST_CASE_P(
+    ValueSizeAndConcurrency,
+    LevelDBState_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(128U, 4096U, 65536U),
+      ::testing::Values(1U, 10U, 100U))
+    );
+
+
+TEST_P(LevelDBState_BENCHMARK_Test, Performance)
+{
+  Benchmark(
+      state,
+      "leveldb",
+      Bytes(std::tr1::get<0>(GetParam())),
+      std::tr1::get<1>(GetParam()));
+}
+
+
+class MappedStateTest : public TemporaryDirectoryTest
+{
+public:
+  MappedStateTest()
+    : storage(NULL),
+      state(NULL) {}
+
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    path = os::getcwd() + "/.state";
+    storage = new state::MappedStorage(path);
+    state = new State(storage);
+  }
+
+  virtual void TearDown()
+  {
+    delete state;
+    delete storage;
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+  // Closes the storage, which is then recovered from its file.
+  void reopen()
+  {
+    delete state;
+    delete storage;
+
+    storage = new state::MappedStorage(path);
+    state = new State(storage);
+  }
+
+  state::Storage* storage;
+  State* state;
+  string path;
+};
+
+
+TEST_F(MappedStateTest, FetchAndStoreAndFetch)
+{
+  FetchAndStoreAndFetch(state);
+}
+
+
+TEST_F(MappedStateTest, FetchAndStoreAndStoreAndFetch)
+{
+  FetchAndStoreAndStoreAndFetch(state);
+}
+
+
+TEST_F(MappedStateTest, FetchAndStoreAndStoreFailAndFetch)
+{
+  FetchAndStoreAndStoreFailAndFetch(state);
+}
+
+
+TEST_F(MappedStateTest, FetchAndStoreAndExpungeAndFetch)
+{
+  FetchAndStoreAndExpungeAndFetch(state);
+}
+
+
+TEST_F(MappedStateTest, FetchAndStoreAndExpungeAndExpunge)
+{
+  FetchAndStoreAndExpungeAndExpunge(state);
+}
+
+
+TEST_F(MappedStateTest, FetchAndStoreAndExpungeAndStoreAndFetch)
+{
+  FetchAndStoreAndExpungeAndStoreAndFetch(state);
+}
+
+
+TEST_F(MappedStateTest, Names)
+{
+  Names(state);
+}
+
+
+TEST_F(MappedStateTest, FetchAndStoreMultipleAndFetch)
+{
+  FetchAndStoreMultipleAndFetch(state);
+}
+
+
+// Tests that the entries are recovered from the file, and that a
+// record which was torn (e.g., by a crash) is discarded.
+TEST_F(MappedStateTest, Recover)
+{
+  FetchAndStoreAndFetch(state);
+
+  Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable = future1.get();
+
+  Slaves slaves = variable.get();
+  slaves.mutable_slaves(0)->mutable_info()->set_hostname("torn");
+
+  Future<Option<Variable<Slaves>>> future2 =
+    state->store(variable.mutate(slaves));
+
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  reopen();
+
+  future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("torn", future1.get().get().slaves(0).info().hostname());
+
+  delete state;
+  delete storage;
+
+  // Corrupt the last record, which makes its checksum mismatch.
+  Try<string> contents = os::read(path);
+  ASSERT_SOME(contents);
+
+  string data = contents.get();
+
+  size_t position = data.rfind("torn");
+  ASSERT_NE(string::npos, position);
+
+  data[position] = 'T';
+
+  ASSERT_SOME(os::write(path, data));
+
+  storage = new state::MappedStorage(path);
+  state = new State(storage);
+
+  future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("localhost", future1.get().get().slaves(0).info().hostname());
+}
+
+
+// Tests that the superseded records are compacted away.
+TEST_F(MappedStateTest, Compact)
+{
+  Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable = future1.get();
+
+  // About 4MB of records for an entry of 1KB.
+  for (size_t i = 0; i < 4000; i++) {
+    Slaves slaves;
+    slaves.add_slaves()->mutable_info()->set_hostname(
+        string(1024, 'x') + stringify(i));
+
+    Future<Option<Variable<Slaves>>> future2 =
+      state->store(variable.mutate(slaves));
+
+    AWAIT_READY(future2);
+    ASSERT_SOME(future2.get());
+
+    variable = future2.get().get();
+  }
+
+  Try<Bytes> size = os::stat::size(path);
+  ASSERT_SOME(size);
+  EXPECT_GE(Megabytes(2), size.get());
+
+  reopen();
+
+  future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ(string(1024, 'x') + "3999",
+            future1.get().get().slaves(0).info().hostname());
+}
+
+
 class LogStateTest : public TemporaryDirectoryTest
 {
 public:
@@ -571,6 +990,12 @@ Future<Option<Variable<Slaves> > > timeout(
 }
 
 
+TEST_F(LogStateTest, FetchAndStoreMultipleAndFetch)
+{
+  FetchAndStoreMultipleAndFetch(state);
+}
+
+
 TEST_F(LogStateTest, Timeout)
 {
   Clock::pause();
@@ -684,6 +1109,203 @@ TEST_F(LogStateTest, Diff)
 }
 
 
+// Tests that the snapshot of an entry that is not set anymore is
+// moved to the end of the log so the log can still be truncated.
+TEST_F(LogStateTest, Compact)
+{
+  Future<Variable<Slaves>> future1 = state->fetch<Slaves>("cold");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> cold = future1.get();
+
+  Slaves slaves = cold.get();
+  slaves.add_slaves()->mutable_info()->set_hostname("cold");
+
+  Future<Option<Variable<Slaves>>> future2 =
+    state->store(cold.mutate(slaves));
+
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  future1 = state->fetch<Slaves>("hot");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> hot = future1.get();
+
+  for (size_t i = 0; i < 1100; i++) {
+    Slaves slaves;
+    slaves.add_slaves()->mutable_info()->set_hostname(stringify(i));
+
+    future2 = state->store(hot.mutate(slaves));
+    AWAIT_READY(future2);
+    ASSERT_SOME(future2.get());
+
+    hot = future2.get().get();
+  }
+
+  // See the comment in the 'Diff' test above.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Log::Reader reader(log);
+
+  Future<Log::Position> beginning = reader.beginning();
+  Future<Log::Position> ending = reader.ending();
+
+  AWAIT_READY(beginning);
+  AWAIT_READY(ending);
+
+  Future<list<Log::Entry>> entries = reader.read(beginning.get(), ending.get());
+
+  AWAIT_READY(entries);
+
+  // Without moving the snapshot of "cold", every snapshot of "hot"
+  // would have been kept in the log.
+  EXPECT_GT(1100u, entries.get().size());
+
+  future1 = state->fetch<Slaves>("cold");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("cold", future1.get().get().slaves(0).info().hostname());
+}
+
+
+// Tests that concurrent stores of distinct entries are written with
+// fewer log entries when batching.
+TEST_F(LogStateTest, Batch)
+{
+  // NOTE: We use a separate storage which does the batching. The
+  // one of the fixture doesn't start a writer until it gets used.
+  Owned<state::Storage> batchingStorage(new state::LogStorage(log, 0, true));
+  Owned<State> batchingState(new State(batchingStorage.get()));
+
+  list<Future<Option<Variable<Slaves>>>> futures;
+
+  for (size_t i = 0; i < 10; i++) {
+    Future<Variable<Slaves>> future =
+      batchingState->fetch<Slaves>(stringify(i));
+    AWAIT_READY(future);
+
+    Slaves slaves;
+    slaves.add_slaves()->mutable_info()->set_hostname(stringify(i));
+
+    futures.push_back(batchingState->store(future.get().mutate(slaves)));
+  }
+
+  foreach (const Future<Option<Variable<Slaves>>>& future, futures) {
+    AWAIT_READY(future);
+    ASSERT_SOME(future.get());
+  }
+
+  // See the comment in the 'Diff' test above.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Log::Reader reader(log);
+
+  Future<Log::Position> beginning = reader.beginning();
+  Future<Log::Position> ending = reader.ending();
+
+  AWAIT_READY(beginning);
+  AWAIT_READY(ending);
+
+  Future<list<Log::Entry>> entries = reader.read(beginning.get(), ending.get());
+
+  AWAIT_READY(entries);
+
+  EXPECT_GT(10u, entries.get().size());
+
+  batchingState.reset();
+  batchingStorage.reset();
+
+  // The entries are read back from the log by the storage of the
+  // fixture, which doesn't do the batching.
+  for (size_t i = 0; i < 10; i++) {
+    Future<Variable<Slaves>> future = state->fetch<Slaves>(stringify(i));
+    AWAIT_READY(future);
+
+    ASSERT_EQ(1, future.get().get().slaves().size());
+    EXPECT_EQ(stringify(i), future.get().get().slaves(0).info().hostname());
+  }
+}
+
+
+// This test verifies that a storage tailing the log (e.g., the one of
+// a standby master) does not start a writer, i.e., it doesn't demote
+// the writer of the storage which is writing to the log.
+TEST_F(LogStateTest, Tail)
+{
+  Future<Variable<Slaves>> variable = state->fetch<Slaves>("slaves");
+  AWAIT_READY(variable);
+
+  Slaves slaves;
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost1");
+
+  Future<Option<Variable<Slaves>>> stored =
+    state->store(variable.get().mutate(slaves));
+
+  AWAIT_READY(stored);
+  ASSERT_SOME(stored.get());
+
+  Owned<state::LogStorage> standby(new state::LogStorage(log, 1024));
+  standby->tail(Milliseconds(10));
+
+  // Let the standby catch up with the log a few times.
+  Clock::pause();
+
+  for (int i = 0; i < 3; i++) {
+    Clock::advance(Milliseconds(10));
+    Clock::settle();
+  }
+
+  Clock::resume();
+
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost2");
+
+  stored = state->store(stored.get().get().mutate(slaves));
+
+  AWAIT_READY(stored);
+  ASSERT_SOME(stored.get());
+
+  standby.reset();
+
+  variable = state->fetch<Slaves>("slaves");
+  AWAIT_READY(variable);
+
+  ASSERT_EQ(2, variable.get().get().slaves().size());
+  EXPECT_EQ("localhost2", variable.get().get().slaves(1).info().hostname());
+}
+
+
+class LogState_BENCHMARK_Test
+  : public LogStateTest,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
+
+
+// The Log state benchmark tests are parameterized by the size
+// of the values and the number of concurrent operations.
+INSTANTIATE_TEST_CASE_P(
+    ValueSizeAndConcurrency,
+    LogState_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(128U, 4096U, 65536U),
+      ::testing::Values(1U, 10U, 100U))
+    );
+
+
+TEST_P(LogState_BENCHMARK_Test, Performance)
+{
+  Benchmark(
+      state,
+      "log",
+      Bytes(std::tr1::get<0>(GetParam())),
+      std::tr1::get<1>(GetParam()));
+}
+
+
 #ifdef MESOS_HAS_JAVA
 class ZooKeeperStateTest : public tests::ZooKeeperTest
 {
@@ -755,6 +1377,38 @@ TEST_F(ZooKeeperStateTest, Names)
 {
   Names(state);
 }
+
+
+TEST_F(ZooKeeperStateTest, FetchAndStoreMultipleAndFetch)
+{
+  FetchAndStoreMultipleAndFetch(state);
+}
+
+
+class ZooKeeperState_BENCHMARK_Test
+  : public ZooKeeperStateTest,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
+
+
+// The ZooKeeper state benchmark tests are parameterized by the size
+// of the values and the number of concurrent operations.
+INSTANTIATE_TEST_CASE_P(
+    ValueSizeAndConcurrency,
+    ZooKeeperState_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(128U, 4096U, 65536U),
+      ::testing::Values(1U, 10U, 100U))
+    );
+
+
+TEST_P(ZooKeeperState_BENCHMARK_Test, Performance)
+{
+  Benchmark(
+      state,
+      "zookeeper",
+      Bytes(std::tr1::get<0>(GetParam())),
+      std::tr1::get<1>(GetParam()));
+}
 #endif // MESOS_HAS_JAVA
 
 } // namespace tests {
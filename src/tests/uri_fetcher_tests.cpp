@@ -98,8 +98,9 @@ TEST_F(CurlFetcherPluginTest, CURL_ValidUri)
       "/TestHttpServer/test",
       server.self().address.port);
 
+  // The file is requested after a HEAD request.
   EXPECT_CALL(server, test(_))
-    .WillOnce(Return(http::OK("test")));
+    .WillRepeatedly(Return(http::OK("test")));
 
   Try<Owned<uri::Fetcher>> fetcher = uri::fetcher::create();
   ASSERT_SOME(fetcher);
@@ -118,7 +119,7 @@ TEST_F(CurlFetcherPluginTest, CURL_InvalidUri)
       server.self().address.port);
 
   EXPECT_CALL(server, test(_))
-    .WillOnce(Return(http::NotFound()));
+    .WillRepeatedly(Return(http::NotFound()));
 
   Try<Owned<uri::Fetcher>> fetcher = uri::fetcher::create();
   ASSERT_SOME(fetcher);
@@ -127,6 +128,52 @@ TEST_F(CurlFetcherPluginTest, CURL_InvalidUri)
 }
 
 
+TEST_F(CurlFetcherPluginTest, CURL_Checksum)
+{
+  URI uri = uri::http(
+      stringify(server.self().address.ip),
+      "/TestHttpServer/test",
+      server.self().address.port);
+
+  // The SHA-256 digest of "test".
+  uri.set_fragment(
+      "sha256="
+      "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08");
+
+  EXPECT_CALL(server, test(_))
+    .WillRepeatedly(Return(http::OK("test")));
+
+  Try<Owned<uri::Fetcher>> fetcher = uri::fetcher::create();
+  ASSERT_SOME(fetcher);
+
+  AWAIT_READY(fetcher.get()->fetch(uri, os::getcwd()));
+
+  EXPECT_SOME_EQ("test", os::read(path::join(os::getcwd(), "test")));
+}
+
+
+TEST_F(CurlFetcherPluginTest, CURL_ChecksumMismatch)
+{
+  URI uri = uri::http(
+      stringify(server.self().address.ip),
+      "/TestHttpServer/test",
+      server.self().address.port);
+
+  uri.set_fragment("sha256=" + string(64, '0'));
+
+  EXPECT_CALL(server, test(_))
+    .WillRepeatedly(Return(http::OK("test")));
+
+  Try<Owned<uri::Fetcher>> fetcher = uri::fetcher::create();
+  ASSERT_SOME(fetcher);
+
+  AWAIT_FAILED(fetcher.get()->fetch(uri, os::getcwd()));
+
+  // The file is removed if it does not match the checksum.
+  EXPECT_FALSE(os::exists(path::join(os::getcwd(), "test")));
+}
+
+
 class HadoopFetcherPluginTest : public TemporaryDirectoryTest
 {
 public:
@@ -408,6 +408,46 @@ TEST(ValuesTest, RangesSubtraction)
   ranges2 = parse("[1-2]").get().ranges();
 
   EXPECT_EQ(parse("[3-8]").get().ranges(), ranges1 - ranges2);
+
+  // Removals spanning multiple ranges.
+  ranges1 = parse("[1-10, 20-30, 40-50]").get().ranges();
+  ranges2 = parse("[5-25, 28-28, 45-60]").get().ranges();
+
+  EXPECT_EQ(parse("[1-4, 26-27, 29-30, 40-44]").get().ranges(),
+            ranges1 - ranges2);
+}
+
+
+// Tests the operations on ranges which are not sorted and coalesced,
+// e.g., if they are constructed by a framework.
+TEST(ValuesTest, RangesUncoalesced)
+{
+  Value::Ranges ranges;
+
+  Value::Range* range = ranges.add_range();
+  range->set_begin(20);
+  range->set_end(30);
+
+  range = ranges.add_range();
+  range->set_begin(1);
+  range->set_end(10);
+
+  range = ranges.add_range();
+  range->set_begin(5);
+  range->set_end(12);
+
+  EXPECT_EQ(parse("[1-12, 20-30]").get().ranges(), ranges);
+
+  EXPECT_TRUE(parse("[2-3, 11-12, 25-30]").get().ranges() <= ranges);
+  EXPECT_FALSE(parse("[12-20]").get().ranges() <= ranges);
+
+  EXPECT_EQ(parse("[1-7, 23-30]").get().ranges(),
+            ranges - parse("[8-22]").get().ranges());
+
+  ranges += parse("[13-19]").get().ranges();
+
+  EXPECT_EQ(1, ranges.range_size());
+  EXPECT_EQ(parse("[1-30]").get().ranges(), ranges);
 }
 
 } // namespace tests {
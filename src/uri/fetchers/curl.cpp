@@ -16,6 +16,8 @@
 
 #include <sys/wait.h>
 
+#include <algorithm>
+#include <list>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -25,22 +27,32 @@
 #include <process/io.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
 #include <stout/path.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
+#include <stout/os/exists.hpp>
 #include <stout/os/mkdir.hpp>
+#include <stout/os/rename.hpp>
+#include <stout/os/rm.hpp>
+#include <stout/os/stat.hpp>
 
 #include "uri/fetchers/curl.hpp"
 
 namespace http = process::http;
 namespace io = process::io;
 
+using std::list;
 using std::set;
 using std::string;
 using std::tuple;
 using std::vector;
 
 using process::await;
+using process::collect;
 using process::subprocess;
 
 using process::Failure;
@@ -51,108 +63,496 @@ using process::Subprocess;
 namespace mesos {
 namespace uri {
 
-Try<Owned<Fetcher::Plugin>> CurlFetcherPlugin::create(const Flags& flags)
-{
-  // TODO(jieyu): Make sure curl is available.
+// A file is split into fewer parts if the parts would be smaller
+// than this, since the extra requests are not worth it then.
+static const Bytes MIN_PART_SIZE = Megabytes(8);
 
-  return Owned<Fetcher::Plugin>(new CurlFetcherPlugin());
-}
 
-
-set<string> CurlFetcherPlugin::schemes()
+// What a HEAD request tells about a file.
+struct Head
 {
-  return {"http", "https", "ftp", "ftps"};
-}
-
-
-Future<Nothing> CurlFetcherPlugin::fetch(
-    const URI& uri,
-    const string& directory)
+  int code;
+  Option<Bytes> length;
+  bool ranges; // Whether the server accepts byte range requests.
+};
+
+
+// Runs the given command and returns its standard output, or fails
+// with its standard error if it does not exit with 0. The returned
+// output is empty if the standard output is redirected by 'out'.
+static Future<string> execute(
+    const vector<string>& argv,
+    const Subprocess::IO& out = Subprocess::PIPE())
 {
-  // TODO(jieyu): Validate the given URI.
-
-  if (!uri.has_path()) {
-    return Failure("URI path is not specified");
-  }
-
-  Try<Nothing> mkdir = os::mkdir(directory);
-  if (mkdir.isError()) {
-    return Failure(
-        "Failed to create directory '" +
-        directory + "': " + mkdir.error());
-  }
-
-  // TODO(jieyu): Allow user to specify the name of the output file.
-  const string output = path::join(directory, Path(uri.path()).basename());
-
-  const vector<string> argv = {
-    "curl",
-    "-s",                 // Don’t show progress meter or error messages.
-    "-S",                 // Makes curl show an error message if it fails.
-    "-L",                 // Follow HTTP 3xx redirects.
-    "-w", "%{http_code}", // Display HTTP response code on stdout.
-    "-o", output,         // Write output to the file.
-    strings::trim(stringify(uri))
-  };
+  const string command = argv[0];
 
+  // TODO(jieyu): Kill the process if discard is called.
   Try<Subprocess> s = subprocess(
-      "curl",
+      command,
       argv,
       Subprocess::PATH("/dev/null"),
-      Subprocess::PIPE(),
+      out,
       Subprocess::PIPE());
 
   if (s.isError()) {
-    return Failure("Failed to exec the curl subprocess: " + s.error());
+    return Failure(
+        "Failed to exec the " + command + " subprocess: " + s.error());
   }
 
   return await(
       s.get().status(),
-      io::read(s.get().out().get()),
+      s.get().out().isSome()
+        ? io::read(s.get().out().get())
+        : Future<string>(string()),
       io::read(s.get().err().get()))
-    .then([](const std::tuple<
+    .then([command](const tuple<
         Future<Option<int>>,
         Future<string>,
-        Future<string>>& t) -> Future<Nothing> {
+        Future<string>>& t) -> Future<string> {
       Future<Option<int>> status = std::get<0>(t);
       if (!status.isReady()) {
         return Failure(
-            "Failed to get the exit status of the curl subprocess: " +
+            "Failed to get the exit status of the " + command +
+            " subprocess: " +
             (status.isFailed() ? status.failure() : "discarded"));
       }
 
       if (status->isNone()) {
-        return Failure("Failed to reap the curl subprocess");
+        return Failure("Failed to reap the " + command + " subprocess");
       }
 
       if (status->get() != 0) {
         Future<string> error = std::get<2>(t);
         if (!error.isReady()) {
           return Failure(
-              "Failed to perform 'curl'. Reading stderr failed: " +
+              "Failed to perform '" + command + "'. Reading stderr failed: " +
               (error.isFailed() ? error.failure() : "discarded"));
         }
 
-        return Failure("Failed to perform 'curl': " + error.get());
+        return Failure("Failed to perform '" + command + "': " + error.get());
       }
 
       Future<string> output = std::get<1>(t);
       if (!output.isReady()) {
         return Failure(
-            "Failed to read stdout from 'curl': " +
+            "Failed to read stdout from '" + command + "': " +
             (output.isFailed() ? output.failure() : "discarded"));
       }
 
+      return output.get();
+    });
+}
+
+
+static void append(vector<string>* argv, const http::Headers& headers)
+{
+  foreachpair (const string& key, const string& value, headers) {
+    argv->push_back("-H");
+    argv->push_back(key + ": " + value);
+  }
+}
+
+
+static Future<Head> head(const string& url, const http::Headers& headers)
+{
+  vector<string> argv = {
+    "curl",
+    "-s", // Don’t show progress meter or error messages.
+    "-S", // Makes curl show an error message if it fails.
+    "-L", // Follow HTTP 3xx redirects.
+    "-I"  // Send a HEAD request and show the response headers.
+  };
+
+  append(&argv, headers);
+  argv.push_back(url);
+
+  return execute(argv)
+    .then([](const string& output) -> Future<Head> {
+      // NOTE: The code remains 0 if there is no status line, e.g.,
+      // for FTP, which then gets the file with a single request.
+      Head head = {0, None(), false};
+
+      // With '-L' the headers of every response in the chain of
+      // redirects are shown, the last response is the one we want.
+      foreach (const string& line, strings::tokenize(output, "\r\n")) {
+        if (strings::startsWith(line, "HTTP/")) {
+          const vector<string> tokens = strings::tokenize(line, " ");
+          if (tokens.size() < 2) {
+            return Failure("Unexpected status line from 'curl': " + line);
+          }
+
+          Try<int> code = numify<int>(tokens[1]);
+          if (code.isError()) {
+            return Failure("Unexpected status line from 'curl': " + line);
+          }
+
+          head = {code.get(), None(), false};
+          continue;
+        }
+
+        const size_t colon = line.find(':');
+        if (colon == string::npos) {
+          continue;
+        }
+
+        const string name =
+          strings::lower(strings::trim(line.substr(0, colon)));
+
+        const string value = strings::trim(line.substr(colon + 1));
+
+        if (name == "content-length") {
+          Try<uint64_t> length = numify<uint64_t>(value);
+          if (length.isSome()) {
+            head.length = Bytes(length.get());
+          }
+        } else if (name == "accept-ranges") {
+          head.ranges = strings::lower(value) == "bytes";
+        }
+      }
+
+      return head;
+    });
+}
+
+
+// Downloads the file with a single request, into a partial file
+// which is moved to 'output' once complete. If 'length' is given
+// (i.e., the server accepts range requests), a partial file which
+// is left behind by an earlier download is continued.
+static Future<int> fetchFile(
+    const string& url,
+    const string& output,
+    const http::Headers& headers,
+    const Option<Bytes>& length)
+{
+  const string partial = output + ".part";
+
+  bool resume = false;
+
+  if (os::exists(partial)) {
+    Try<Bytes> size = os::stat::size(partial);
+    if (length.isSome() && size.isSome() && size.get() < length.get()) {
+      resume = true;
+    } else if (length.isSome() && size.isSome() && size.get() == length.get()) {
+      Try<Nothing> rename = os::rename(partial, output);
+      if (rename.isError()) {
+        return Failure(
+            "Failed to move '" + partial + "' to '" + output + "': " +
+            rename.error());
+      }
+
+      return http::Status::OK;
+    } else {
+      os::rm(partial);
+    }
+  }
+
+  vector<string> argv = {
+    "curl",
+    "-s",                 // Don’t show progress meter or error messages.
+    "-S",                 // Makes curl show an error message if it fails.
+    "-L",                 // Follow HTTP 3xx redirects.
+    "-w", "%{http_code}", // Display HTTP response code on stdout.
+    "-o", partial         // Write output to the file.
+  };
+
+  if (resume) {
+    VLOG(1) << "Resuming the download of '" << url << "' into '"
+            << partial << "'";
+
+    argv.push_back("-C"); // Continue at the end of the file.
+    argv.push_back("-");
+  }
+
+  append(&argv, headers);
+  argv.push_back(url);
+
+  return execute(argv)
+    .then([=](const string& out) -> Future<int> {
       // Parse the output and get the HTTP response code.
-      Try<int> code = numify<int>(output.get());
+      Try<int> code = numify<int>(out);
       if (code.isError()) {
-        return Failure("Unexpected output from 'curl': " + output.get());
+        return Failure("Unexpected output from 'curl': " + out);
+      }
+
+      if (code.get() != http::Status::OK &&
+          !(resume && code.get() == http::Status::PARTIAL_CONTENT)) {
+        // The file contains the body of the error response, if any.
+        os::rm(partial);
+        return code.get();
+      }
+
+      Try<Nothing> rename = os::rename(partial, output);
+      if (rename.isError()) {
+        return Failure(
+            "Failed to move '" + partial + "' to '" + output + "': " +
+            rename.error());
+      }
+
+      return http::Status::OK;
+    });
+}
+
+
+// Downloads the bytes 'first' to 'last' (inclusive) of the file into
+// the part file at 'path', continuing after the bytes that the part
+// file already has.
+static Future<Nothing> fetchRange(
+    const string& url,
+    const string& path,
+    const http::Headers& headers,
+    uint64_t first,
+    uint64_t last)
+{
+  const uint64_t length = last - first + 1;
+
+  uint64_t existing = 0;
+
+  if (os::exists(path)) {
+    Try<Bytes> size = os::stat::size(path);
+    if (size.isSome() && size->bytes() <= length) {
+      existing = size->bytes();
+    } else {
+      os::rm(path);
+    }
+  }
+
+  if (existing == length) {
+    return Nothing();
+  }
+
+  vector<string> argv = {
+    "curl",
+    "-s", // Don’t show progress meter or error messages.
+    "-S", // Makes curl show an error message if it fails.
+    "-L", // Follow HTTP 3xx redirects.
+    "-f", // Fail on HTTP errors rather than output the error page.
+    "-r", stringify(first + existing) + "-" + stringify(last)
+  };
+
+  append(&argv, headers);
+  argv.push_back(url);
+
+  // The range is written to the standard output, which is appended
+  // to the part file.
+  return execute(argv, Subprocess::PATH(path))
+    .then([=]() -> Future<Nothing> {
+      Try<Bytes> size = os::stat::size(path);
+      if (size.isError()) {
+        return Failure(
+            "Failed to get the size of '" + path + "': " + size.error());
+      }
+
+      // E.g., the server ignored the range and sent the whole file.
+      if (size->bytes() != length) {
+        os::rm(path);
+        return Failure(
+            "Expected " + stringify(length) + " bytes in '" + path +
+            "' but got " + stringify(size->bytes()));
+      }
+
+      return Nothing();
+    });
+}
+
+
+// Appends the other part files to the first one and moves it to
+// 'output'. This is done by 'cat' so that a large file does not
+// block a libprocess worker thread while it is being copied.
+static Future<Nothing> join(const string& output, const vector<string>& paths)
+{
+  CHECK(!paths.empty());
+
+  Future<string> appended = string();
+
+  if (paths.size() > 1) {
+    vector<string> argv = {"cat"};
+    argv.insert(argv.end(), paths.begin() + 1, paths.end());
+
+    appended = execute(argv, Subprocess::PATH(paths[0]));
+  }
+
+  return appended
+    .then([=]() -> Future<Nothing> {
+      Try<Nothing> rename = os::rename(paths[0], output);
+      if (rename.isError()) {
+        return Failure(
+            "Failed to move '" + paths[0] + "' to '" + output + "': " +
+            rename.error());
+      }
+
+      for (size_t i = 1; i < paths.size(); i++) {
+        os::rm(paths[i]);
+      }
+
+      return Nothing();
+    });
+}
+
+
+// Downloads the file with concurrent range requests, one per part.
+static Future<int> fetchParts(
+    const string& url,
+    const string& output,
+    const http::Headers& headers,
+    const Bytes& length,
+    size_t parts)
+{
+  const uint64_t size = length.bytes();
+  const uint64_t partSize = (size + parts - 1) / parts;
+
+  VLOG(1) << "Downloading '" << url << "' (" << length << ") in "
+          << parts << " parts";
+
+  vector<string> paths;
+  list<Future<Nothing>> futures;
+
+  for (uint64_t first = 0; first < size; first += partSize) {
+    const uint64_t last = std::min(first + partSize, size) - 1;
+    const string path = output + ".part" + stringify(paths.size());
+
+    paths.push_back(path);
+    futures.push_back(fetchRange(url, path, headers, first, last));
+  }
+
+  return collect(futures)
+    .then([=]() { return join(output, paths); })
+    .then([]() -> int { return http::Status::OK; });
+}
+
+
+static Future<Nothing> verify(const string& path, const string& checksum)
+{
+  return execute({"sha256sum", path})
+    .then([=](const string& output) -> Future<Nothing> {
+      const vector<string> tokens = strings::tokenize(output, " ");
+      if (tokens.empty() || tokens[0] != strings::lower(checksum)) {
+        os::rm(path);
+        return Failure(
+            "The checksum of '" + path + "' is '" +
+            (tokens.empty() ? "" : tokens[0]) + "' instead of '" +
+            checksum + "'");
+      }
+
+      return Nothing();
+    });
+}
+
+
+Future<int> download(
+    const string& url,
+    const string& output,
+    const http::Headers& headers,
+    size_t parts,
+    const Option<string>& checksum)
+{
+  return head(url, headers)
+    .then([=](const Head& head) -> Future<int> {
+      // Not every server answers HEAD requests, hence we still get
+      // the file as usual then. This also yields the response code
+      // that the caller may expect (e.g., '401 Unauthorized').
+      if (head.code != http::Status::OK) {
+        return fetchFile(url, output, headers, None());
+      }
+
+      Option<Bytes> length = None();
+      if (head.ranges) {
+        length = head.length;
+      }
+
+      if (length.isSome() && parts > 1) {
+        const uint64_t count = std::min<uint64_t>(
+            parts,
+            length->bytes() / MIN_PART_SIZE.bytes());
+
+        if (count > 1) {
+          return fetchParts(url, output, headers, length.get(), count);
+        }
       }
 
-      if (code.get() != http::Status::OK) {
+      return fetchFile(url, output, headers, length);
+    })
+    .then([=](int code) -> Future<int> {
+      if (code != http::Status::OK || checksum.isNone()) {
+        return code;
+      }
+
+      return verify(output, checksum.get())
+        .then([code]() { return code; });
+    });
+}
+
+
+CurlFetcherPlugin::Flags::Flags()
+{
+  add(&Flags::curl_download_parts,
+      "curl_download_parts",
+      "The number of concurrent range requests to download a file with,\n"
+      "if the server supports range requests. The files smaller than\n"
+      "8MB per part are downloaded with fewer parts.\n",
+      1);
+}
+
+
+Try<Owned<Fetcher::Plugin>> CurlFetcherPlugin::create(const Flags& flags)
+{
+  // TODO(jieyu): Make sure curl is available.
+
+  if (flags.curl_download_parts == 0) {
+    return Error("Expecting 'curl_download_parts' to be positive");
+  }
+
+  return Owned<Fetcher::Plugin>(
+      new CurlFetcherPlugin(flags.curl_download_parts));
+}
+
+
+set<string> CurlFetcherPlugin::schemes()
+{
+  return {"http", "https", "ftp", "ftps"};
+}
+
+
+Future<Nothing> CurlFetcherPlugin::fetch(
+    const URI& uri,
+    const string& directory)
+{
+  // TODO(jieyu): Validate the given URI.
+
+  if (!uri.has_path()) {
+    return Failure("URI path is not specified");
+  }
+
+  Try<Nothing> mkdir = os::mkdir(directory);
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create directory '" +
+        directory + "': " + mkdir.error());
+  }
+
+  // TODO(jieyu): Allow user to specify the name of the output file.
+  const string output = path::join(directory, Path(uri.path()).basename());
+
+  // The fragment is not sent to the server.
+  URI source = uri;
+  source.clear_fragment();
+
+  Option<string> checksum;
+  if (strings::startsWith(uri.fragment(), "sha256=")) {
+    checksum = uri.fragment().substr(strlen("sha256="));
+  }
+
+  return download(
+      strings::trim(stringify(source)),
+      output,
+      http::Headers(),
+      parts,
+      checksum)
+    .then([](int code) -> Future<Nothing> {
+      if (code != http::Status::OK) {
         return Failure(
             "Unexpected HTTP response code: " +
-            http::Status::string(code.get()));
+            http::Status::string(code));
       }
 
       return Nothing();
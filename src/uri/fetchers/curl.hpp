@@ -17,9 +17,16 @@
 #ifndef __URI_FETCHERS_CURL_HPP__
 #define __URI_FETCHERS_CURL_HPP__
 
+#include <set>
+#include <string>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/owned.hpp>
 
 #include <stout/flags.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
 #include <stout/try.hpp>
 
 #include <mesos/uri/fetcher.hpp>
@@ -27,10 +34,35 @@
 namespace mesos {
 namespace uri {
 
+// Downloads the given URL into the file at 'output' using the curl
+// command, and returns the HTTP response code. If the server supports
+// range requests, a file of a known size is downloaded with up to
+// 'parts' concurrent range requests, each into a part file next to
+// 'output', which are then joined. The part files are kept if the
+// download fails, so that a later download of the same URL into the
+// same file only requests the missing ranges. If 'checksum' (a hex
+// encoded SHA-256 digest) is given, the file is verified against it
+// and removed if it does not match.
+process::Future<int> download(
+    const std::string& url,
+    const std::string& output,
+    const process::http::Headers& headers = process::http::Headers(),
+    size_t parts = 1,
+    const Option<std::string>& checksum = None());
+
+
+// Fetches 'http', 'https', 'ftp' and 'ftps' URIs with 'download'. The
+// file is verified if the URI has a fragment 'sha256=<digest>'.
 class CurlFetcherPlugin : public Fetcher::Plugin
 {
 public:
-  class Flags : public virtual flags::FlagsBase {};
+  class Flags : public virtual flags::FlagsBase
+  {
+  public:
+    Flags();
+
+    size_t curl_download_parts;
+  };
 
   static Try<process::Owned<Fetcher::Plugin>> create(const Flags& flags);
 
@@ -43,7 +75,9 @@ public:
       const std::string& directory);
 
 private:
-  CurlFetcherPlugin() {}
+  explicit CurlFetcherPlugin(size_t _parts) : parts(_parts) {}
+
+  const size_t parts;
 };
 
 } // namespace uri {
@@ -38,6 +38,7 @@
 
 #include "uri/utils.hpp"
 
+#include "uri/fetchers/curl.hpp"
 #include "uri/fetchers/docker.hpp"
 
 #include "uri/schemes/docker.hpp"
@@ -184,90 +185,6 @@ static Future<http::Response> curl(
 }
 
 
-// TODO(jieyu): Add a comment here.
-static Future<int> download(
-    const URI& uri,
-    const string& directory,
-    const http::Headers& headers = http::Headers())
-{
-  const string output = path::join(directory, Path(uri.path()).basename());
-
-  vector<string> argv = {
-    "curl",
-    "-s",                 // Don’t show progress meter or error messages.
-    "-S",                 // Make curl show an error message if it fails.
-    "-L",                 // Follow HTTP 3xx redirects.
-    "-w", "%{http_code}", // Display HTTP response code on stdout.
-    "-o", output          // Write output to the file.
-  };
-
-  // Add additional headers.
-  foreachpair (const string& key, const string& value, headers) {
-    argv.push_back("-H");
-    argv.push_back(key + ": " + value);
-  }
-
-  argv.push_back(strings::trim(stringify(uri)));
-
-  // TODO(jieyu): Kill the process if discard is called.
-  Try<Subprocess> s = subprocess(
-      "curl",
-      argv,
-      Subprocess::PATH("/dev/null"),
-      Subprocess::PIPE(),
-      Subprocess::PIPE());
-
-  if (s.isError()) {
-    return Failure("Failed to exec the curl subprocess: " + s.error());
-  }
-
-  return await(
-      s.get().status(),
-      io::read(s.get().out().get()),
-      io::read(s.get().err().get()))
-    .then([](const tuple<
-        Future<Option<int>>,
-        Future<string>,
-        Future<string>>& t) -> Future<int> {
-      Future<Option<int>> status = std::get<0>(t);
-      if (!status.isReady()) {
-        return Failure(
-            "Failed to get the exit status of the curl subprocess: " +
-            (status.isFailed() ? status.failure() : "discarded"));
-      }
-
-      if (status->isNone()) {
-        return Failure("Failed to reap the curl subprocess");
-      }
-
-      if (status->get() != 0) {
-        Future<string> error = std::get<2>(t);
-        if (!error.isReady()) {
-          return Failure(
-              "Failed to perform 'curl'. Reading stderr failed: " +
-              (error.isFailed() ? error.failure() : "discarded"));
-        }
-
-        return Failure("Failed to perform 'curl': " + error.get());
-      }
-
-      Future<string> output = std::get<1>(t);
-      if (!output.isReady()) {
-        return Failure(
-            "Failed to read stdout from 'curl': " +
-            (output.isFailed() ? output.failure() : "discarded"));
-      }
-
-      // Parse the output and get the HTTP response code.
-      Try<int> code = numify<int>(output.get());
-      if (code.isError()) {
-        return Failure("Unexpected output from 'curl': " + output.get());
-      }
-
-      return code.get();
-    });
-}
-
 //-------------------------------------------------------------------
 // DockerFetcherPlugin implementation.
 //-------------------------------------------------------------------
@@ -275,7 +192,7 @@ static Future<int> download(
 class DockerFetcherPluginProcess : public Process<DockerFetcherPluginProcess>
 {
 public:
-  DockerFetcherPluginProcess() {}
+  explicit DockerFetcherPluginProcess(size_t _parts) : parts(_parts) {}
 
   Future<Nothing> fetch(const URI& uri, const string& directory);
 
@@ -307,15 +224,32 @@ private:
 
   URI getManifestUri(const URI& uri);
   URI getBlobUri(const URI& uri);
+
+  // The number of concurrent range requests to download a blob with.
+  const size_t parts;
 };
 
 
+DockerFetcherPlugin::Flags::Flags()
+{
+  add(&Flags::docker_download_parts,
+      "docker_download_parts",
+      "The number of concurrent range requests to download an image\n"
+      "blob with, if the registry supports range requests.\n",
+      1);
+}
+
+
 Try<Owned<Fetcher::Plugin>> DockerFetcherPlugin::create(const Flags& flags)
 {
   // TODO(jieyu): Make sure curl is available.
 
+  if (flags.docker_download_parts == 0) {
+    return Error("Expecting 'docker_download_parts' to be positive");
+  }
+
   Owned<DockerFetcherPluginProcess> process(
-      new DockerFetcherPluginProcess());
+      new DockerFetcherPluginProcess(flags.docker_download_parts));
 
   return Owned<Fetcher::Plugin>(new DockerFetcherPlugin(process));
 }
@@ -486,7 +420,22 @@ Future<Nothing> DockerFetcherPluginProcess::fetchBlob(
 {
   URI blobUri = getBlobUri(uri);
 
-  return download(blobUri, directory, getAuthHeader(authToken))
+  const string output =
+    path::join(directory, Path(blobUri.path()).basename());
+
+  // The digest of a blob is the checksum of its content, the
+  // registries only use SHA-256 digests so far.
+  Option<string> checksum;
+  if (strings::startsWith(uri.query(), "sha256:")) {
+    checksum = uri.query().substr(strlen("sha256:"));
+  }
+
+  return download(
+      strings::trim(stringify(blobUri)),
+      output,
+      getAuthHeader(authToken),
+      parts,
+      checksum)
     .then(defer(self(), [=](int code) -> Future<Nothing> {
       if (code == http::Status::OK) {
         return Nothing();
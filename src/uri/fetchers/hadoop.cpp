@@ -38,6 +38,11 @@ HadoopFetcherPlugin::Flags::Flags()
       "hadoop_client",
       "The path to the hadoop client\n");
 
+  add(&Flags::webhdfs_address,
+      "webhdfs_address",
+      "The address of the WebHDFS REST API of the namenode (e.g.,\n"
+      "'http://namenode:50070') to use instead of the hadoop client\n");
+
   add(&Flags::hadoop_client_supported_schemes,
       "hadoop_client_supported_schemes",
       "A comma-separated list of the schemes supported by the hadoop client.\n",
@@ -47,7 +52,8 @@ HadoopFetcherPlugin::Flags::Flags()
 
 Try<Owned<Fetcher::Plugin>> HadoopFetcherPlugin::create(const Flags& flags)
 {
-  Try<Owned<HDFS>> hdfs = HDFS::create(flags.hadoop_client);
+  Try<Owned<HDFS>> hdfs =
+    HDFS::create(flags.hadoop_client, flags.webhdfs_address);
   if (hdfs.isError()) {
     return Error("Failed to create HDFS client: " + hdfs.error());
   }
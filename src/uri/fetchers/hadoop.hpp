@@ -42,6 +42,7 @@ public:
     Flags();
 
     Option<std::string> hadoop_client;
+    Option<std::string> webhdfs_address;
     std::string hadoop_client_supported_schemes;
   };
 
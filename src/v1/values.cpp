@@ -14,10 +14,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <ctype.h>
 #include <stdint.h>
 
 #include <algorithm>
 #include <initializer_list>
+#include <iterator>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -99,39 +101,23 @@ struct Range
 };
 
 
-// Coalesces the vector of ranges provided and modifies `result` to contain the
-// solution.
-// The algorithm first sorts all the individual intervals so that we can iterate
-// over them sequentially.
-// The algorithm does a single pass, after the sort, and builds up the solution
-// in place. It then modifies the `result` with as few steps as possible. The
-// expensive part of this operation is modification of the protobuf, which is
-// why we prefer to build up the solution in a temporary vector.
-void coalesce(Value::Ranges* result, vector<Range> ranges)
+// Merges the overlapping and adjacent ranges of the sorted vector of
+// ranges in place, in a single pass, leaving the vector canonical.
+static void merge(vector<Range>* ranges)
 {
   // Exit early if empty.
-  if (ranges.empty()) {
-    result->clear_range();
+  if (ranges->empty()) {
     return;
   }
 
-  std::sort(
-      ranges.begin(),
-      ranges.end(),
-      [](const Range& left, const Range& right) {
-        return std::tie(left.start, left.end) <
-               std::tie(right.start, right.end);
-      });
-
   // We build up initial state of the current range.
-  CHECK(!ranges.empty());
-  int count = 1;
-  Range current = ranges.front();
+  size_t count = 1;
+  Range current = ranges->front();
 
   // In a single pass, we compute the size of the end result, as well as modify
   // in place the intermediate data structure to build up result as we
   // solve it.
-  foreach (const Range& range, ranges) {
+  foreach (const Range& range, *ranges) {
     // Skip if this range is equivalent to the current range.
     if (range.start == current.start && range.end == current.end) {
       continue;
@@ -147,7 +133,7 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
         current.end = max(current.end, range.end);
       } else {
         // 2. No overlap and we are adding a new range.
-        ranges[count - 1] = current;
+        (*ranges)[count - 1] = current;
         ++count;
         current = range;
       }
@@ -155,9 +141,21 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
   }
 
   // Record the state of the last range into of ranges vector.
-  ranges[count - 1] = current;
+  (*ranges)[count - 1] = current;
+
+  CHECK(count <= ranges->size());
+
+  ranges->resize(count);
+}
+
 
-  CHECK(count <= static_cast<int>(ranges.size()));
+// Replaces the ranges of `result` with the canonical vector of ranges
+// with as few steps as possible. The expensive part is modification of
+// the protobuf, which is why the operations below build up their
+// solution in a temporary vector.
+static void assign(Value::Ranges* result, const vector<Range>& ranges)
+{
+  const int count = ranges.size();
 
   // Shrink result if it is too large by deleting trailing subrange.
   if (count < result->range_size()) {
@@ -183,6 +181,130 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
   CHECK_EQ(result->range_size(), count);
 }
 
+
+// Coalesces the vector of ranges provided and modifies `result` to contain the
+// solution.
+// The algorithm first sorts all the individual intervals so that we can iterate
+// over them sequentially.
+// The algorithm does a single pass, after the sort, and builds up the solution
+// in place. It then modifies the `result` with as few steps as possible.
+void coalesce(Value::Ranges* result, vector<Range> ranges)
+{
+  std::sort(
+      ranges.begin(),
+      ranges.end(),
+      [](const Range& left, const Range& right) {
+        return std::tie(left.start, left.end) <
+               std::tie(right.start, right.end);
+      });
+
+  merge(&ranges);
+  assign(result, ranges);
+}
+
+
+// Returns the ranges as a canonical vector, i.e., sorted, with
+// neither overlapping nor adjacent ranges. The result of every
+// operation on ranges is canonical, hence they are usually just
+// copied rather than sorted and coalesced again.
+static vector<Range> canonicalize(const Value::Ranges& ranges)
+{
+  vector<Range> result;
+  result.reserve(ranges.range_size());
+
+  bool canonical = true;
+
+  foreach (const Value::Range& range, ranges.range()) {
+    if (range.begin() > range.end() ||
+        (!result.empty() && range.begin() <= result.back().end + 1)) {
+      canonical = false;
+    }
+
+    result.push_back({range.begin(), range.end()});
+  }
+
+  if (!canonical) {
+    Value::Ranges coalesced;
+    coalesce(&coalesced, std::move(result));
+
+    result.clear();
+    foreach (const Value::Range& range, coalesced.range()) {
+      result.push_back({range.begin(), range.end()});
+    }
+  }
+
+  return result;
+}
+
+
+// Returns the union of the canonical vectors of ranges by a linear
+// merge, as a canonical vector.
+static vector<Range> add(const vector<Range>& left, const vector<Range>& right)
+{
+  vector<Range> result;
+  result.reserve(left.size() + right.size());
+
+  std::merge(
+      left.begin(),
+      left.end(),
+      right.begin(),
+      right.end(),
+      std::back_inserter(result),
+      [](const Range& left, const Range& right) {
+        return std::tie(left.start, left.end) <
+               std::tie(right.start, right.end);
+      });
+
+  merge(&result);
+
+  return result;
+}
+
+
+// Returns the difference of the canonical vectors of ranges in a
+// single pass over both, as a canonical vector.
+static vector<Range> subtract(
+    const vector<Range>& left,
+    const vector<Range>& right)
+{
+  vector<Range> result;
+  result.reserve(left.size());
+
+  size_t j = 0;
+
+  foreach (const Range& range, left) {
+    // Skip the removals ending before this range. Since the ranges
+    // are sorted, they also end before all the following ones.
+    while (j < right.size() && right[j].end < range.start) {
+      ++j;
+    }
+
+    uint64_t start = range.start;
+    bool subsumed = false;
+
+    // NOTE: A removal may also intersect the following range, hence
+    // 'j' is not advanced past the removals intersecting this one.
+    for (size_t k = j; k < right.size() && right[k].start <= range.end; ++k) {
+      if (right[k].start > start) {
+        result.push_back({start, right[k].start - 1});
+      }
+
+      if (right[k].end >= range.end) {
+        subsumed = true;
+        break;
+      }
+
+      start = max(start, right[k].end + 1);
+    }
+
+    if (!subsumed) {
+      result.push_back({start, range.end});
+    }
+  }
+
+  return result;
+}
+
 } // namespace internal {
 
 
@@ -233,49 +355,6 @@ void coalesce(Value::Ranges* result, const Value::Range& addedRange)
 }
 
 
-// Removes a range from already coalesced ranges.
-// The algorithms constructs a new vector of ranges which is then
-// coalesced into a Value::Ranges instance.
-static void remove(Value::Ranges* _ranges, const Value::Range& removal)
-{
-  vector<internal::Range> ranges;
-  ranges.reserve(_ranges->range_size());
-
-  foreach (const Value::Range& range, _ranges->range()) {
-    // Skip if the entire range is subsumed by `removal`.
-    if (range.begin() >= removal.begin() && range.end() <= removal.end()) {
-      continue;
-    }
-
-    // Divide if the range subsumes the `removal`.
-    if (range.begin() < removal.begin() && range.end() > removal.end()) {
-      // Front.
-      ranges.emplace_back(internal::Range{range.begin(), removal.begin() - 1});
-      // Back.
-      ranges.emplace_back(internal::Range{removal.end() + 1, range.end()});
-    }
-
-    // Fully Emplace if the range doesn't intersect.
-    if (range.end() < removal.begin() || range.begin() > removal.end()) {
-      ranges.emplace_back(internal::Range{range.begin(), range.end()});
-    } else {
-      // Trim if the range does intersect.
-      if (range.end() > removal.end()) {
-        // Trim front.
-        ranges.emplace_back(internal::Range{removal.end() + 1, range.end()});
-      } else {
-        // Trim back.
-        CHECK(range.begin() < removal.begin());
-        ranges.emplace_back(
-            internal::Range{range.begin(), removal.begin() - 1});
-      }
-    }
-  }
-
-  internal::coalesce(_ranges, std::move(ranges));
-}
-
-
 ostream& operator<<(ostream& stream, const Value::Ranges& ranges)
 {
   stream << "[";
@@ -292,55 +371,40 @@ ostream& operator<<(ostream& stream, const Value::Ranges& ranges)
 
 bool operator==(const Value::Ranges& _left, const Value::Ranges& _right)
 {
-  Value::Ranges left;
-  coalesce(&left, {_left});
+  const vector<internal::Range> left = internal::canonicalize(_left);
+  const vector<internal::Range> right = internal::canonicalize(_right);
 
-  Value::Ranges right;
-  coalesce(&right, {_right});
-
-  if (left.range_size() == right.range_size()) {
-    for (int i = 0; i < left.range_size(); i++) {
-      // Make sure this range is equal to a range in the right.
-      bool found = false;
-      for (int j = 0; j < right.range_size(); j++) {
-        if (left.range(i).begin() == right.range(j).begin() &&
-            left.range(i).end() == right.range(j).end()) {
-          found = true;
-          break;
-        }
-      }
+  if (left.size() != right.size()) {
+    return false;
+  }
 
-      if (!found) {
-        return false;
-      }
+  for (size_t i = 0; i < left.size(); i++) {
+    if (left[i].start != right[i].start || left[i].end != right[i].end) {
+      return false;
     }
-
-    return true;
   }
 
-  return false;
+  return true;
 }
 
 
 bool operator<=(const Value::Ranges& _left, const Value::Ranges& _right)
 {
-  Value::Ranges left;
-  coalesce(&left, {_left});
+  const vector<internal::Range> left = internal::canonicalize(_left);
+  const vector<internal::Range> right = internal::canonicalize(_right);
 
-  Value::Ranges right;
-  coalesce(&right, {_right});
+  // Since the right ranges are neither overlapping nor adjacent, each
+  // left range must be a subset of a single right range.
+  size_t j = 0;
 
-  for (int i = 0; i < left.range_size(); i++) {
-    // Make sure this range is a subset of a range in right.
-    bool matched = false;
-    for (int j = 0; j < right.range_size(); j++) {
-      if (left.range(i).begin() >= right.range(j).begin() &&
-          left.range(i).end() <= right.range(j).end()) {
-        matched = true;
-        break;
-      }
+  foreach (const internal::Range& range, left) {
+    while (j < right.size() && right[j].end < range.start) {
+      ++j;
     }
-    if (!matched) {
+
+    if (j == right.size() ||
+        range.start < right[j].start ||
+        range.end > right[j].end) {
       return false;
     }
   }
@@ -352,32 +416,41 @@ bool operator<=(const Value::Ranges& _left, const Value::Ranges& _right)
 Value::Ranges operator+(const Value::Ranges& left, const Value::Ranges& right)
 {
   Value::Ranges result;
-  coalesce(&result, {left, right});
-  return result;
+  result += left;
+  return result += right;
 }
 
 
 Value::Ranges operator-(const Value::Ranges& left, const Value::Ranges& right)
 {
   Value::Ranges result;
-  coalesce(&result, {left});
-  return result -= right;
+  internal::assign(
+      &result,
+      internal::subtract(
+          internal::canonicalize(left),
+          internal::canonicalize(right)));
+  return result;
 }
 
 
 Value::Ranges& operator+=(Value::Ranges& left, const Value::Ranges& right)
 {
-  coalesce(&left, {right});
+  internal::assign(
+      &left,
+      internal::add(
+          internal::canonicalize(left),
+          internal::canonicalize(right)));
   return left;
 }
 
 
 Value::Ranges& operator-=(Value::Ranges& left, const Value::Ranges& right)
 {
-  coalesce(&left);
-  for (int i = 0; i < right.range_size(); ++i) {
-    remove(&left, right.range(i));
-  }
+  internal::assign(
+      &left,
+      internal::subtract(
+          internal::canonicalize(left),
+          internal::canonicalize(right)));
   return left;
 }
 
@@ -554,6 +627,7 @@ Try<Value> parse(const string& text)
 
   // Remove any spaces from the text.
   string temp;
+  temp.reserve(text.size());
   foreach (const char c, text) {
     if (c != ' ') {
       temp += c;
@@ -609,6 +683,16 @@ Try<Value> parse(const string& text)
       }
       return value;
     } else if (index == string::npos) {
+      // Most texts (e.g., the names of racks or zones) start with a
+      // letter which no scalar can start with ('inf' or 'nan' aside),
+      // hence we avoid the cost of the failing (throwing) conversion.
+      const char first = temp[0];
+      if (isalpha(first) && tolower(first) != 'i' && tolower(first) != 'n') {
+        value.set_type(Value::TEXT);
+        value.mutable_text()->set_value(temp);
+        return value;
+      }
+
       try {
         // This is a scalar.
         value.set_type(Value::SCALAR);
@@ -98,6 +98,15 @@
 
     $scope.data = data;
 
+    updateScope($scope);
+
+    return true; // Continue polling.
+  }
+
+
+  // Update the outermost scope from the current state, which is either
+  // fetched from the master or updated by the master's events.
+  function updateScope($scope) {
     // Pass this pollTime to all relativeDate calls to make them all relative to
     // the same moment in time.
     //
@@ -208,8 +217,145 @@
 
     $scope.time_since_update = 0;
     $scope.$broadcast('state_updated');
+  }
 
-    return true; // Continue polling.
+
+  var TERMINAL_TASK_STATES =
+    ['TASK_FINISHED', 'TASK_FAILED', 'TASK_KILLED', 'TASK_LOST', 'TASK_ERROR'];
+
+  // Apply an event of the master's event stream (see '/master/events')
+  // to the state, which saves fetching the whole state for every
+  // change. The offers are only updated by fetching the state.
+  function applyEvent(state, event) {
+    var byId = function(id) {
+      return function(object) { return object.id == id; };
+    };
+
+    switch (event.type) {
+      case 'SNAPSHOT':
+        state.slaves = event.state.slaves;
+        state.frameworks = event.state.frameworks;
+        break;
+
+      case 'TASK_ADDED':
+      case 'TASK_UPDATED':
+        var task = event.task;
+        var framework = _.find(state.frameworks, byId(task.framework_id));
+        if (!framework) {
+          break;
+        }
+
+        var previous = _.find(framework.tasks, byId(task.id));
+        framework.tasks = _.reject(framework.tasks, byId(task.id));
+
+        if (!_.contains(TERMINAL_TASK_STATES, task.state)) {
+          framework.tasks.push(task);
+        } else {
+          framework.completed_tasks.push(task);
+
+          // The resources of a terminated task are no longer used.
+          if (previous) {
+            _.each(['cpus', 'mem', 'disk'], function(name) {
+              framework.resources[name] -= previous.resources[name] || 0;
+            });
+          }
+        }
+        break;
+
+      case 'SLAVE_ADDED':
+        state.slaves = _.reject(state.slaves, byId(event.slave.id));
+        state.slaves.push(event.slave);
+        break;
+
+      case 'SLAVE_REMOVED':
+        state.slaves = _.reject(state.slaves, byId(event.slave.id));
+        break;
+
+      case 'FRAMEWORK_ADDED':
+        // The event only has a summary of the framework, i.e., no tasks.
+        var existing = _.find(state.frameworks, byId(event.framework.id));
+        state.frameworks = _.reject(state.frameworks, byId(event.framework.id));
+        state.frameworks.push(_.extend(
+            existing || {tasks: [], completed_tasks: [], offers: [],
+                         executors: [], resources: event.framework.used_resources},
+            event.framework));
+        break;
+
+      case 'FRAMEWORK_REMOVED':
+        var removed = _.find(state.frameworks, byId(event.framework.id));
+        state.frameworks = _.reject(state.frameworks, byId(event.framework.id));
+        if (removed) {
+          removed.completed_tasks = removed.completed_tasks.concat(removed.tasks);
+          removed.tasks = [];
+          state.completed_frameworks.push(removed);
+        }
+        break;
+    }
+  }
+
+
+  // Returns the length of a string in UTF-8, which is the unit of the
+  // lengths of the 'recordio' records.
+  function utf8Length(string) {
+    return unescape(encodeURIComponent(string)).length;
+  }
+
+
+  // Read the 'recordio' encoded events of a streaming endpoint as they
+  // arrive, calling 'onEvent' for each event and 'onEnd' once the
+  // stream is closed or failed (with whether any event was received).
+  // The stream is closed after 'limit' characters, since the browser
+  // keeps all of the response around.
+  function streamEvents(url, limit, onEvent, onEnd) {
+    var xhr = new XMLHttpRequest();
+    var offset = 0;
+    var received = false;
+
+    var end = function() {
+      onEnd(received);
+    };
+
+    xhr.onprogress = function() {
+      var text = xhr.responseText;
+
+      while (true) {
+        var newline = text.indexOf('\n', offset);
+        if (newline < 0) {
+          break;
+        }
+
+        var length = parseInt(text.substring(offset, newline), 10);
+        var record = text.substr(newline + 1, length);
+
+        // A record has at least as many bytes as characters, so drop
+        // characters until it has the expected length in bytes.
+        var bytes = utf8Length(record);
+        if (bytes < length) {
+          break; // The record is incomplete.
+        }
+
+        while (bytes > length) {
+          record = record.substr(
+              0, record.length - Math.max(1, Math.floor((bytes - length) / 3)));
+          bytes = utf8Length(record);
+        }
+
+        offset = newline + 1 + record.length;
+        received = true;
+        onEvent(JSON.parse(record));
+      }
+
+      if (offset > limit) {
+        xhr.abort();
+        end();
+      }
+    };
+
+    xhr.onload = end;
+    xhr.onerror = end;
+
+    xhr.open('GET', url);
+    xhr.send();
   }
 
   // Add a filter to convert small float number to decimal string
@@ -340,7 +486,8 @@
         // Start polling again, but do it asynchronously (and wait at
         // least a second because otherwise the error-modal won't get
         // properly shown).
-        $timeout(pollState, 1000);
+        $timeout.cancel($scope.statePoll);
+        $scope.statePoll = $timeout(pollState, 1000);
         $timeout(pollMetrics, 1000);
       });
 
@@ -356,13 +503,83 @@
       countdown();
     };
 
+    // While the master's events are streamed, the whole state is only
+    // fetched this much less often (to update the offers, resources
+    // and statistics which are not covered by events).
+    var STREAMING_POLL_FACTOR = 6;
+
+    // The number of characters after which the event stream is
+    // reopened (which starts with a snapshot of the state again).
+    var STREAMING_LIMIT = 64 * 1024 * 1024;
+
+    $scope.streaming = false;
+
+    // Set if the master does not stream its events (e.g., an older
+    // master), in which case the whole state is polled.
+    var streamingUnsupported = false;
+
+    var pendingUpdate = null;
+
+    // Update the scope after a batch of events, at most once a second.
+    var scheduleUpdate = function() {
+      if (pendingUpdate != null) {
+        return;
+      }
+
+      pendingUpdate = $timeout(function() {
+        pendingUpdate = null;
+
+        // See 'updateState' for why the selected text is kept.
+        $scope.time_since_update += 1000;
+        if (hasSelectedText() && $scope.time_since_update < 20000) {
+          scheduleUpdate();
+          return;
+        }
+
+        updateScope($scope);
+      }, 1000);
+    };
+
+    var subscribe = function() {
+      $scope.streaming = true;
+
+      streamEvents(
+          'master/events',
+          STREAMING_LIMIT,
+          function(event) {
+            applyEvent($scope.state, event);
+            scheduleUpdate();
+          },
+          function(received) {
+            $scope.streaming = false;
+
+            // Fetch the whole state again soon, which subscribes again
+            // unless no event was received at all.
+            streamingUnsupported = !received;
+
+            $timeout.cancel($scope.statePoll);
+            $scope.statePoll =
+              $timeout(pollState, received ? 1000 : $scope.delay);
+          });
+    };
+
     var pollState = function() {
       $http.get('master/state.json',
                 {transformResponse: function(data) { return data; }})
         .success(function(data) {
           if (updateState($scope, $timeout, data)) {
             $scope.delay = updateInterval(_.size($scope.slaves));
-            $timeout(pollState, $scope.delay);
+
+            if (!$scope.streaming && !streamingUnsupported) {
+              subscribe();
+            }
+
+            $timeout.cancel($scope.statePoll);
+            $scope.statePoll = $timeout(
+                pollState,
+                streamingUnsupported
+                  ? $scope.delay
+                  : $scope.delay * STREAMING_POLL_FACTOR);
           }
         })
         .error(function() {
@@ -15,6 +15,8 @@
 // limitations under the License
 
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <utility>
 #include <vector>
@@ -33,7 +35,9 @@
 #include <stout/path.hpp>
 #include <stout/result.hpp>
 #include <stout/some.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/utils.hpp>
 
 #include "logging/logging.hpp"
@@ -89,11 +93,13 @@ GroupProcess::GroupProcess(
     const string& _servers,
     const Duration& _timeout,
     const string& _znode,
-    const Option<Authentication>& _auth)
+    const Option<Authentication>& _auth,
+    const Duration& _debounce)
   : ProcessBase(ID::generate("group")),
     servers(_servers),
     timeout(_timeout),
     znode(strings::remove(_znode, "/", strings::SUFFIX)),
+    debounce(_debounce),
     auth(_auth),
     acl(_auth.isSome()
         ? EVERYONE_READ_CREATOR_ALL
@@ -101,7 +107,9 @@ GroupProcess::GroupProcess(
     watcher(NULL),
     zk(NULL),
     state(DISCONNECTED),
-    retrying(false)
+    retrying(false),
+    refreshing(false),
+    version(0)
 {}
 
 
@@ -109,11 +117,13 @@ GroupProcess::GroupProcess(
 // C++ 11.
 GroupProcess::GroupProcess(
     const URL& url,
-    const Duration& _timeout)
+    const Duration& _timeout,
+    const Duration& _debounce)
   : ProcessBase(ID::generate("group")),
     servers(url.servers),
     timeout(_timeout),
     znode(strings::remove(url.path, "/", strings::SUFFIX)),
+    debounce(_debounce),
     auth(url.authentication),
     acl(url.authentication.isSome()
         ? EVERYONE_READ_CREATOR_ALL
@@ -121,7 +131,9 @@ GroupProcess::GroupProcess(
     watcher(NULL),
     zk(NULL),
     state(DISCONNECTED),
-    retrying(false)
+    retrying(false),
+    refreshing(false),
+    version(0)
 {}
 
 
@@ -230,6 +242,8 @@ Future<Option<string> > GroupProcess::data(const Group::Membership& membership)
 {
   if (error.isSome()) {
     return Failure(error.get());
+  } else if (contents.contains(membership.id())) {
+    return Some(contents[membership.id()]);
   } else if (state != READY) {
     Data* data = new Data(membership);
     pending.datas.push(data);
@@ -490,6 +504,10 @@ void GroupProcess::expired(int64_t sessionId)
   // Cancel the retries. Group will sync() after it reconnects to ZK.
   retrying = false;
 
+  // Cancel any debounced refresh, we'll sync() the whole group after
+  // reconnection anyway.
+  refreshing = false;
+
   // Cancel and cleanup the reconnect timer (if necessary).
   if (timer.isSome()) {
     Clock::cancel(timer.get());
@@ -505,6 +523,7 @@ void GroupProcess::expired(int64_t sessionId)
   // entire ZK cluster goes down. The outage can last for a long time
   // but the clients watching the group should be informed sooner.
   memberships = set<Group::Membership>();
+  version++;
   update();
 
   // Invalidate the cache so that we'll sync with ZK after
@@ -515,6 +534,7 @@ void GroupProcess::expired(int64_t sessionId)
   foreachpair (int32_t sequence, Promise<bool>* cancelled, utils::copy(owned)) {
     cancelled->set(false); // Since this was not requested.
     owned.erase(sequence); // Okay since iterating over a copy.
+    contents.erase(sequence);
     delete cancelled;
   }
 
@@ -544,6 +564,31 @@ void GroupProcess::updated(int64_t sessionId, const string& path)
 
   CHECK_EQ(znode, path);
 
+  if (debounce > Duration::zero()) {
+    // Wait for the group to settle before reading it again. Note
+    // that ZooKeeper won't notify us of further changes until we
+    // set a new watch when refreshing, so all the changes made in
+    // the meantime are picked up by that single refresh.
+    if (!refreshing) {
+      delay(debounce, self(), &GroupProcess::refresh, sessionId);
+      refreshing = true;
+    }
+    return;
+  }
+
+  refresh(sessionId);
+}
+
+
+void GroupProcess::refresh(int64_t sessionId)
+{
+  // This also serves any debounced refresh that is still pending.
+  refreshing = false;
+
+  if (error.isSome() || sessionId != zk->getSessionId()) {
+    return;
+  }
+
   Try<bool> cached = cache(); // Update cache (will invalidate first).
 
   if (cached.isError()) {
@@ -618,6 +663,7 @@ Result<Group::Membership> GroupProcess::doJoin(
 
   Promise<bool>* cancelled = new Promise<bool>();
   owned[sequence.get()] = cancelled;
+  version++;
 
   return Group::Membership(sequence.get(), label, cancelled->future());
 }
@@ -656,8 +702,11 @@ Result<bool> GroupProcess::doCancel(const Group::Membership& membership)
   Promise<bool>* cancelled = owned[membership.id()];
   cancelled->set(true);
   owned.erase(membership.id());
+  contents.erase(membership.id());
   delete cancelled;
 
+  version++;
+
   return true;
 }
 
@@ -687,6 +736,12 @@ Result<Option<string> > GroupProcess::doData(
         "' in ZooKeeper: " + zk->message(code));
   }
 
+  // Only cache the data of memberships we know about, the cache
+  // entries are removed when we learn that they are cancelled.
+  if (owned.count(membership.id()) > 0 || unowned.count(membership.id()) > 0) {
+    contents[membership.id()] = result;
+  }
+
   return Some(result);
 }
 
@@ -738,11 +793,15 @@ Try<bool> GroupProcess::cache()
   // Cache current memberships, cancelling those that are now missing.
   set<Group::Membership> current;
 
+  bool changed = false;
+
   foreachpair (int32_t sequence, Promise<bool>* cancelled, utils::copy(owned)) {
     if (!sequences.contains(sequence)) {
       cancelled->set(false);
       owned.erase(sequence); // Okay since iterating over a copy.
+      contents.erase(sequence);
       delete cancelled;
+      changed = true;
     } else {
       current.insert(Group::Membership(
           sequence, sequences[sequence], cancelled->future()));
@@ -757,7 +816,9 @@ Try<bool> GroupProcess::cache()
     if (!sequences.contains(sequence)) {
       cancelled->set(false);
       unowned.erase(sequence); // Okay since iterating over a copy.
+      contents.erase(sequence);
       delete cancelled;
+      changed = true;
     } else {
       current.insert(Group::Membership(
           sequence, sequences[sequence], cancelled->future()));
@@ -771,10 +832,17 @@ Try<bool> GroupProcess::cache()
     Promise<bool>* cancelled = new Promise<bool>();
     unowned[sequence] = cancelled;
     current.insert(Group::Membership(sequence, label, cancelled->future()));
+    changed = true;
   }
 
   memberships = current;
 
+  if (changed) {
+    version++;
+    VLOG(1) << "Group '" << znode << "' has " << current.size()
+            << " memberships (version " << version << ")";
+  }
+
   return true;
 }
 
@@ -934,6 +1002,7 @@ void GroupProcess::abort(const string& message)
 
   // Cancel the retries.
   retrying = false;
+  refreshing = false;
 
   fail(&pending.joins, message);
   fail(&pending.cancels, message);
@@ -947,6 +1016,7 @@ void GroupProcess::abort(const string& message)
   }
 
   owned.clear();
+  contents.clear();
 
   // Since we decided to abort, we expire the session to clean up
   // ephemeral ZNodes as necessary.
@@ -971,17 +1041,19 @@ string GroupProcess::zkBasename(const Group::Membership& membership)
 Group::Group(const string& servers,
              const Duration& timeout,
              const string& znode,
-             const Option<Authentication>& auth)
+             const Option<Authentication>& auth,
+             const Duration& debounce)
 {
-  process = new GroupProcess(servers, timeout, znode, auth);
+  process = new GroupProcess(servers, timeout, znode, auth, debounce);
   spawn(process);
 }
 
 
 Group::Group(const URL& url,
-             const Duration& timeout)
+             const Duration& timeout,
+             const Duration& debounce)
 {
-  process = new GroupProcess(url, timeout);
+  process = new GroupProcess(url, timeout, debounce);
   spawn(process);
 }
 
@@ -994,6 +1066,33 @@ Group::~Group()
 }
 
 
+std::shared_ptr<Group> Group::share(const URL& url, const Duration& timeout)
+{
+  // NOTE: These are intentionally leaked, groups can be released
+  // during static destruction.
+  static std::mutex* mutex = new std::mutex();
+  static hashmap<string, std::weak_ptr<Group>>* groups =
+    new hashmap<string, std::weak_ptr<Group>>();
+
+  const string key = stringify(url) + " " + stringify(timeout);
+
+  synchronized (mutex) {
+    std::shared_ptr<Group> group;
+
+    if (groups->contains(key)) {
+      group = groups->at(key).lock();
+    }
+
+    if (!group) {
+      group.reset(new Group(url, timeout));
+      (*groups)[key] = group;
+    }
+
+    return group;
+  }
+}
+
+
 Future<Group::Membership> Group::join(
     const string& data,
     const Option<string>& label)
@@ -18,6 +18,7 @@
 #define __ZOOKEEPER_GROUP_HPP__
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 
@@ -27,6 +28,7 @@
 
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
@@ -121,16 +123,33 @@ public:
   };
 
   // Constructs this group using the specified ZooKeeper servers (list
-  // of host:port) with the given timeout at the specified znode.
+  // of host:port) with the given timeout at the specified znode. A
+  // non-zero "debounce" delays refreshing the cached memberships
+  // after ZooKeeper notifies us of a change, so that a burst of
+  // changes (e.g., during a leader election) results in a single
+  // reading of the group rather than one for each change.
   Group(const std::string& servers,
         const Duration& timeout,
         const std::string& znode,
-        const Option<Authentication>& auth = None());
+        const Option<Authentication>& auth = None(),
+        const Duration& debounce = Duration::zero());
   Group(const URL& url,
-        const Duration& timeout);
+        const Duration& timeout,
+        const Duration& debounce = Duration::zero());
 
   ~Group();
 
+  // Returns the group used by everyone in this (OS) process watching
+  // the group at 'url' with the given session timeout, creating it if
+  // necessary. This way they all share a single ZooKeeper session and
+  // a single cache of the memberships (and their data), so a change
+  // of the group results in one watch firing and one reading of the
+  // group for the whole process. The group is destroyed along with
+  // the last reference to it.
+  static std::shared_ptr<Group> share(
+      const URL& url,
+      const Duration& timeout);
+
   // Returns the result of trying to join a "group" in ZooKeeper.
   // If "label" is provided the newly created znode contains "label_"
   // as the prefix. If join is successful, an "owned" membership will
@@ -150,6 +169,9 @@ public:
   // group membership.
   // A None is returned if the specified membership doesn't exist,
   // e.g., it can be removed before this call can read it content.
+  // Since the data of a membership never changes, it is only read
+  // from ZooKeeper once and then served from a cache for as long as
+  // the membership is part of the group.
   process::Future<Option<std::string> > data(const Membership& membership);
 
   // Returns a future that gets set when the group memberships differ
@@ -172,10 +194,12 @@ public:
   GroupProcess(const std::string& servers,
                const Duration& timeout,
                const std::string& znode,
-               const Option<Authentication>& auth);
+               const Option<Authentication>& auth,
+               const Duration& debounce = Duration::zero());
 
   GroupProcess(const URL& url,
-               const Duration& timeout);
+               const Duration& timeout,
+               const Duration& debounce = Duration::zero());
 
   virtual ~GroupProcess();
 
@@ -237,6 +261,10 @@ private:
   // Updates any pending watches.
   void update();
 
+  // Refreshes the cached memberships after a (debounced) change
+  // notification from ZooKeeper.
+  void refresh(int64_t sessionId);
+
   // Generic retry method. This mechanism is "generic" in the sense
   // that it is not specific to any particular operation, but rather
   // attempts to perform all pending operations (including caching
@@ -260,6 +288,10 @@ private:
 
   const std::string znode;
 
+  // How long to wait after a change notification before refreshing
+  // the cached memberships.
+  const Duration debounce;
+
   Option<Authentication> auth; // ZooKeeper authentication.
 
   const ACL_vector acl; // Default ACL to use.
@@ -329,6 +361,9 @@ private:
   // Indicates there is a pending delayed retry.
   bool retrying;
 
+  // Indicates there is a pending debounced refresh.
+  bool refreshing;
+
   // Expected ZooKeeper sequence numbers (either owned/created by this
   // group instance or not) and the promise we associate with their
   // "cancellation" (i.e., no longer part of the group).
@@ -339,6 +374,15 @@ private:
   // cache and 'Some' represents a valid cache.
   Option<std::set<Group::Membership> > memberships;
 
+  // Incremented every time the cached memberships differ from the
+  // ones cached before, i.e., the version of the group as observed
+  // by this group instance.
+  uint64_t version;
+
+  // Cache of the data of the current memberships, keyed by sequence
+  // number. Entries are removed once the membership is cancelled.
+  hashmap<int32_t, std::string> contents;
+
   // The timer that determines whether we should quit waiting for the
   // connection to be restored.
   Option<process::Timer> timer;
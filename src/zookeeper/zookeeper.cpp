@@ -382,6 +382,38 @@ public:
     return future;
   }
 
+  Future<int> multi(
+      const vector<zoo_op_t>& ops,
+      vector<zoo_op_result_t>* results)
+  {
+    CHECK_NOTNULL(results);
+    CHECK_EQ(ops.size(), results->size());
+
+    Promise<int>* promise = new Promise<int>();
+
+    Future<int> future = promise->future();
+
+    tuple<Promise<int>*>* args = new tuple<Promise<int>*>(promise);
+
+    // NOTE: The operations are marshalled by the call, the results
+    // are filled in when completing.
+    int ret = zoo_amulti(
+        zh,
+        ops.size(),
+        ops.data(),
+        results->data(),
+        voidCompletion,
+        args);
+
+    if (ret != ZOK) {
+      delete promise;
+      delete args;
+      return ret;
+    }
+
+    return future;
+  }
+
 private:
   // This method is registered as a watcher callback function and is
   // invoked by a single ZooKeeper event thread.
@@ -641,6 +673,22 @@ int ZooKeeper::set(const string& path, const string& data, int version)
 }
 
 
+int ZooKeeper::multi(
+    const vector<zoo_op_t>& ops,
+    vector<zoo_op_result_t>* results)
+{
+  CHECK_NOTNULL(results);
+
+  results->resize(ops.size());
+
+  return dispatch(
+      process,
+      &ZooKeeperProcess::multi,
+      ops,
+      results).get();
+}
+
+
 string ZooKeeper::message(int code) const
 {
   return string(zerror(code));
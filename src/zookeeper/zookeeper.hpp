@@ -302,6 +302,27 @@ public:
    */
   int set(const std::string& path, const std::string& data, int version);
 
+  /**
+   * \brief atomically executes a sequence of operations, i.e., either
+   * all of the operations are applied or none of them is.
+   *
+   * \param ops the operations, initialized with zoo_create_op_init,
+   * zoo_delete_op_init, zoo_set_op_init or zoo_check_op_init. The
+   * memory they refer to must stay valid until the call returns.
+   * \param results the results of the operations, one for each of the
+   * operations. Must not be NULL.
+   * \return the return code for the function call.
+   * ZOK all the operations completed succesfully.
+   * ZBADVERSION, ZNONODE, ZNODEEXISTS, ... the return code of the
+   * first operation that failed (see the result of each operation).
+   * ZBADARGUMENTS - invalid input parameters
+   * ZINVALIDSTATE - zhandle state is either ZOO_SESSION_EXPIRED_STATE or ZOO_AUTH_FAILED_STATE
+   * ZMARSHALLINGERROR - failed to marshall a request; possibly, out of memory
+   */
+  int multi(
+      const std::vector<zoo_op_t>& ops,
+      std::vector<zoo_op_result_t>* results);
+
   /**
    * \brief return a message describing the return code.
    *